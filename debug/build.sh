@@ -10,7 +10,7 @@ export CXXFLAGS="-fvisibility-inlines-hidden -std=c++17 -fmessage-length=0 -marc
 mkdir -p $THIS_DIR/build
 cd $THIS_DIR/build
 
-cmake $PROJECT_ROOT -DCMAKE_INSTALL_PREFIX=$THIS_DIR -DCMAKE_CXX_COMPILER=$CXX -DCMAKE_CXX_FLAGS="${CXX_FLAGS}"
+cmake $PROJECT_ROOT -DCMAKE_BUILD_TYPE=Debug -DCMAKE_INSTALL_PREFIX=$THIS_DIR -DCMAKE_CXX_COMPILER=$CXX -DCMAKE_CXX_FLAGS="${CXX_FLAGS}"
 make VERBOSE=1
 make install
 ln -s $THIS_DIR/bin/messpf $THIS_DIR/bin/partition_function
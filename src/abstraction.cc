@@ -22,6 +22,125 @@
 #include "libmess/key.hh"
 #include "libmess/units.hh"
 #include "libmess/io.hh"
+#include "libmess/batch.hh"
+
+namespace {
+  //
+  const double bru = Phys_const::cm * Phys_const::cm * Phys_const::cm * Phys_const::herz;
+
+  // abstraction rate coefficients from each of the two bimolecular sides, in cm^3/sec,
+  // on the temperature grid; the dummy side gets no rate
+  std::vector<std::vector<double> > abstraction_rate (const Model::Species& barrier,
+						      const std::vector<SharedPointer<Model::Bimolecular> >& product,
+						      const std::vector<double>& temperature)
+  {
+    const std::vector<double> barrier_weight = barrier.weight(temperature);
+
+    std::vector<std::vector<double> > res(2);
+    
+    std::vector<double> product_weight(temperature.size());
+    for(int p = 0; p < 2; ++p) {
+      if(product[p]->dummy())
+	continue;
+
+      product[p]->weight(&temperature[0], temperature.size(), &product_weight[0]);
+
+      res[p].resize(temperature.size());
+      for(int t = 0; t < temperature.size(); ++t)
+	res[p][t] = temperature[t] / 2. / M_PI * barrier_weight[t] / product_weight[t]
+	  * std::exp((product[p]->ground() - barrier.ground()) / temperature[t]) / bru;
+    }
+    return res;
+  }
+
+  // batch input: one barrier and two bimolecular blocks per file
+  class AbstractionJob : public Batch::Job {
+    //
+    const std::vector<double>& _temperature;
+
+  public:
+    //
+    explicit AbstractionJob (const std::vector<double>& t) : _temperature(t) {}
+    
+    void run (const std::string& input, std::ostream& to) const;
+  };
+
+  void AbstractionJob::run (const std::string& input, std::ostream& to) const
+  {
+    const char funame [] = "AbstractionJob::run: ";
+
+    KeyGroup AbstractionJobGroup;
+
+    Key bar_key("Barrier"    );
+    Key bim_key("Bimolecular");
+
+    IO::KeyBufferStream from(input.c_str());
+    if(!from) {
+      std::cerr << funame << "input file " << input << " is not found\n";
+      throw Error::Input();
+    }
+
+    SharedPointer<Model::Species> barrier;
+    std::vector<SharedPointer<Model::Bimolecular> > product;
+
+    std::string token, comment, name;
+    while(from >> token) {
+      // barrier
+      if(bar_key == token) {
+	if(!(from >> name)) {
+	  std::cerr << funame << input << ": " << token << ": corrupted\n";
+	  throw Error::Input();
+	}
+	std::getline(from, comment);
+	barrier = Model::new_species(from, name, Model::NOSTATES);
+      }
+      // bimolecular
+      else if(bim_key == token) {
+	if(!(from >> name)) {
+	  std::cerr << funame << input << ": " << token << ": corrupted\n";
+	  throw Error::Input();
+	}
+	std::getline(from, comment);
+	product.push_back(Model::new_bimolecular(from, name));
+      }
+      else if(IO::skip_comment(token, from)) {
+	std::cerr << funame << input << ": unknown keyword " << token << "\n";
+	throw Error::Init();
+      }
+    }
+
+    if(!barrier) {
+      std::cerr << funame << input << ": no barrier\n";
+      throw Error::Init();
+    }
+
+    if(product.size() != 2) {
+      std::cerr << funame << input << ": no products\n";
+      throw Error::Init();
+    }
+
+    const std::vector<std::vector<double> > rate = abstraction_rate(*barrier, product, _temperature);
+    
+    to << "{\"input\": " << Batch::json_string(input) << ", \"barrier\": " << Batch::json_string(barrier->name())
+       << ", \"temperature[K]\": [";
+    for(int t = 0; t < _temperature.size(); ++t)
+      to << (t ? ", " : "") << Batch::json_number(_temperature[t] / Phys_const::kelv);
+    to << "], \"rate_coefficients[cm^3/sec]\": {";
+
+    for(int p = 0; p < 2; ++p) {
+      to << (p ? ", " : "") << Batch::json_string(product[p]->name() + "->" + product[1-p]->name()) << ": ";
+      if(product[p]->dummy()) {
+	to << "null";
+	continue;
+      }
+      to << "[";
+      for(int t = 0; t < _temperature.size(); ++t)
+	to << (t ? ", " : "") << Batch::json_number(rate[p][t]);
+      to << "]";
+    }
+    to << "}}";
+  }
+}
 
 int main (int argc, char* argv [])
 {
@@ -52,10 +171,19 @@ int main (int argc, char* argv [])
   Key  adm_bor_key("AtomDistanceMin[bohr]"      );
   Key  adm_ang_key("AtomDistanceMin[angstrom]"  );
 
+  Key  bman_key("BatchManifest"               );
+  Key  bwork_key("BatchWorkerNumber"          );
+  Key  bout_key("BatchOutput"                 );
+
   std::vector<double> temperature;
   SharedPointer<Model::Species> barrier;
   std::vector<SharedPointer<Model::Bimolecular> > product;
 
+  // batch mode: reaction files listed in the manifest
+  std::vector<std::string> batch_input;
+  int batch_worker_size = 1;
+  std::string batch_output;
+
   // base name
   std::string base_name = argv[1];
   if(base_name.size() >= 4 && !base_name.compare(base_name.size() - 4, 4, ".inp", 4))
@@ -94,6 +222,41 @@ int main (int argc, char* argv [])
 
       product.push_back(Model::new_bimolecular(from, name));
     }
+    // batch manifest
+    else if(bman_key == token) {
+      if(batch_input.size()) {
+	std::cerr << funame << token << ": already defined\n";
+	throw Error::Input();
+      }
+      if(!(from >> stemp)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      batch_input = Batch::read_manifest(stemp);
+    }
+    // number of worker processes for the batch
+    else if(bwork_key == token) {
+      if(!(from >> batch_worker_size)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(batch_worker_size <= 0) {
+	std::cerr << funame << token << ": should be positive\n";
+	throw Error::Range();
+      }
+    }
+    // batch output
+    else if(bout_key == token) {
+      if(!(from >> batch_output)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+    }
     // rate output    
     else if(rate_key == token) {
       if(IO::out.is_open()) {
@@ -190,14 +353,17 @@ int main (int argc, char* argv [])
     throw Error::Init();
   }
 
-  if(!barrier) {
-    std::cerr << funame << "no barrier\n";
-    throw Error::Init();
-  }
+  if(!batch_input.size() || barrier || product.size()) {
+    //
+    if(!barrier) {
+      std::cerr << funame << "no barrier\n";
+      throw Error::Init();
+    }
 
-  if(product.size() != 2) {
-    std::cerr << funame << "no products\n";
-    throw Error::Init();
+    if(product.size() != 2) {
+      std::cerr << funame << "no products\n";
+      throw Error::Init();
+    }
   }
 
   // default log output	
@@ -220,10 +386,28 @@ int main (int argc, char* argv [])
     }
   }
 
+  // batch output: one JSON object per reaction file
+  if(batch_input.size()) {
+    //
+    if(!batch_output.size())
+      batch_output = base_name + ".json";
+
+    std::ofstream to(batch_output.c_str());
+    if(!to) {
+      std::cerr << funame << "cannot open " << batch_output << " file\n";
+      throw Error::Input();
+    }
+
+    Batch::run(AbstractionJob(temperature), batch_input, batch_worker_size, base_name, to);
+
+    if(!barrier)
+      return 0;
+  }
+
   // rate calculation and output
 
-  typedef std::vector<double>::const_iterator It;
-  const double bru = Phys_const::cm * Phys_const::cm * Phys_const::cm * Phys_const::herz;
+  const std::vector<std::vector<double> > rate = abstraction_rate(*barrier, product, temperature);
+
   IO::out << "Rate Units: cm^3/sec\n\n";
   IO::out << std::setw(5) << "T, K";
   for(int p = 0; p < 2; ++p) {
@@ -232,14 +416,11 @@ int main (int argc, char* argv [])
   }
   IO::out << "\n";
   
-  for(It t = temperature.begin(); t != temperature.end(); ++t) {
-    IO::out << std::setw(5) << *t / Phys_const::kelv;;
+  for(int t = 0; t < temperature.size(); ++t) {
+    IO::out << std::setw(5) << temperature[t] / Phys_const::kelv;;
     for(int p = 0; p < 2; ++p)
-      if(!product[p]->dummy()) {
-	dtemp = *t / 2. / M_PI * barrier->weight(*t) / product[p]->weight(*t)
-	  * std::exp((product[p]->ground() - barrier->ground()) / *t) / bru;
-	IO::out << std::setw(13) << dtemp;
-      }
+      if(!product[p]->dummy())
+	IO::out << std::setw(13) << rate[p][t];
       else 
 	IO::out << std::setw(13) << "***";
     IO::out << "\n";
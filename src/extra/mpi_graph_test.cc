@@ -15,6 +15,10 @@
 
 #include<mpi.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include<iostream>
 #include<fstream>
 #include<sstream>
@@ -33,7 +37,14 @@ int main (int argc, char* argv [])
   double      dtemp;
   std::string stemp;
   
-  MPI::Init(argc, argv);
+  // the work processes evaluate their chunks with thread teams; only the main thread calls MPI
+  //
+  if(MPI::Init_thread(argc, argv, MPI::THREAD_FUNNELED) < MPI::THREAD_FUNNELED) {
+    //
+    std::cerr << funame << "MPI library does not support threads\n";
+
+    MPI::COMM_WORLD.Abort(1);
+  }
 
   const int mpi_size = MPI::COMM_WORLD.Get_size();
   const int mpi_rank = MPI::COMM_WORLD.Get_rank();
@@ -71,6 +82,9 @@ int main (int argc, char* argv [])
   Key      redt_key("ReductionThreshold"              );
   Key      ftol_key("FrequencyTolerance"              );
   Key      lowf_key("LowFrequencyThreshold"           );
+  Key     share_key("NodeSharedPotentialExpansion"    );
+  Key     dbmem_key("GraphDatabaseMemory[MB]"         );
+  Key     spill_key("GraphDatabaseSpillDirectory"     );
   
   //Key       drv_key("DriversNumber"                   );
 
@@ -325,6 +339,49 @@ int main (int argc, char* argv [])
 
       std::getline(from, comment);
     }	
+    // one potential expansion table per node
+    //
+    else if(share_key == token) {
+      //
+      Graph::Expansion::potex_share = true;
+
+      std::getline(from, comment);
+    }	
+    // graph databases memory budget per work process
+    //
+    else if(dbmem_key == token) {
+      //
+      if(!(from >> dtemp)) {
+	//
+	ErrOut err_out;
+
+	err_out << funame << token << ": corrupted";
+      }
+
+      if(dtemp <= 0.) {
+	//
+	ErrOut err_out;
+
+	err_out << funame << token << ": should be positive: " << dtemp;
+      }
+
+      Graph::Expansion::db_mem_max = (long)(dtemp * 1024. * 1024.);
+
+      std::getline(from, comment);
+    }
+    // graph databases spill directory
+    //
+    else if(spill_key == token) {
+      //
+      if(!(from >> Graph::Expansion::spill_dir)) {
+	//
+	ErrOut err_out;
+
+	err_out << funame << token << ": corrupted";
+      }
+
+      std::getline(from, comment);
+    }
     // number of drivers
     /*
     else if(drv_key == token) {
@@ -364,6 +421,10 @@ int main (int argc, char* argv [])
     //
     IO::log << IO::log_offset << "Number of working nodes = " << mpi_size - 1 << std::endl;
 
+#ifdef _OPENMP
+    IO::log << IO::log_offset << "Threads per working node = " << omp_get_max_threads() << std::endl;
+#endif
+
     if(temperature.size()) {
       //
       IO::log << IO::log_offset << "Temperatures[K]:";
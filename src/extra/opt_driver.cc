@@ -616,24 +616,22 @@ int main (int argc, char* argv [])
     //
     IO::out << "Gradient";
 
+    const Coord::Cartesian grad = opt.pot()->gradient(x);
+
     for(int i = 0; i < x.size(); ++i) {
       //
       if(!(i % 3))
 	//
 	IO::out << "\n";
 
-      IO::out << std::setw(13) << opt.pot()->grad(x, i);
+      IO::out << std::setw(13) << grad[i];
     }
 
     IO::out << "\n";
 
     // hessian
     //
-    for(int i = 0; i < x.size(); ++i)
-      //
-      for(int j = i; j < x.size(); ++j)
-	//
-	hess(i, j) = opt.pot()->hess(x, i, j);
+    hess = opt.pot()->hessian(x);
 
     IO::out << "Hessian\n";
 
@@ -684,11 +682,13 @@ int main (int argc, char* argv [])
 
   // hessian
   //
+  hess = opt.pot()->hessian(xmin);
+
   for(int i = 0; i < hess.size(); ++i)
     //
     for(int j = i; j < hess.size(); ++j)
       //
-      hess(i, j) = opt.pot()->hess(xmin, i, j) / std::sqrt(zmat[i / 3].atom().mass() * zmat[j / 3].atom().mass());
+      hess(i, j) /= std::sqrt(zmat[i / 3].atom().mass() * zmat[j / 3].atom().mass());
 
   // frequencies
   //
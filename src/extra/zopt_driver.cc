@@ -134,6 +134,7 @@ int main (int argc, char* argv [])
   Key  opt_step_key("OptimizationStep"      );
   Key   opt_num_key("OptimizationIteration" );
   Key  grad_tol_key("GradientTolerance"     );
+  Key  samp_tol_key("SamplingTolerance"     );
   Key      diff_key("DifferentiationStep"   );
   Key    ground_key("GroundEnergy[kcal/mol]");
   
@@ -307,6 +308,26 @@ int main (int argc, char* argv [])
       
       std::getline(from, comment);
     }
+    // anharmonic correction sampling relative error tolerance
+    //
+    else if(samp_tol_key == token) {
+      //
+      if(!(from >> ZOpt::sampling_tol)) {
+	//
+	std::cerr << funame << token << ": corrupted\n";
+
+	throw Error::Input();
+      }
+
+      if(ZOpt::sampling_tol <= 0.) {
+	//
+	std::cerr << funame << token << ": out of range: " << ZOpt::sampling_tol << "\n";
+
+	throw Error::Range();
+      }
+      
+      std::getline(from, comment);
+    }
     // maximal optimization step
     //
     else if(opt_step_key == token) {
@@ -804,17 +825,22 @@ int main (int argc, char* argv [])
 	      << std::setw(13) << "Err, %"
 	      << "\n";
     
-      double relerr; // anharmonic correction relative error
+      // the conserved modes are sampled once for all temperatures
+      //
+      std::vector<double> relerr; // anharmonic correction relative error
+
+      const std::vector<double> ahc_table = zopt.anharmonic_correction(std::vector<double>(temperature.begin(), temperature.end()),
+								       spec_num, &relerr);
 
       itemp = 0;
 
       for(temp_t::const_iterator t = temperature.begin(); t != temperature.end(); ++t, ++itemp) {
 	//
-	double ahc =  zopt.anharmonic_correction(*t, spec_num, &relerr);
+	double ahc = ahc_table[itemp];
 
 	IO::out << std::setw(5) << *t / Phys_const::kelv
 		<< std::setw(13) << ahc
-		<< std::setw(13) << relerr * 100.
+		<< std::setw(13) << relerr[itemp] * 100.
 		<< "\n";
       
 	dtemp = std::exp(-(zopt.ener_min() - ground_ener) / *t) * zopt.mass_factor() / zopt.fc_factor();
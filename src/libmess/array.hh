@@ -20,6 +20,12 @@
 #include <iomanip>
 #include <cstdlib>
 #include <vector>
+#include <map>
+#include <string>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "error.hh"
 
@@ -479,10 +485,233 @@ void ArrayWithDefault<T>::apply (const F& f)
     *it = f(*it);
 }
 
+/**************************************************************************
+ ************************ WORKSPACE BUFFER POOL ***************************
+ **************************************************************************/
+
+// while a workspace scope is active, the freed large double buffers are kept
+// and reused for the later allocations of (nearly) the same size, so that the
+// solver temporaries of the next temperature-pressure point do not go back to
+// the system; fresh large buffers are first touched in parallel so that the
+// pages are placed next to the threads working on them
+//
+// while a spill scope is active and the scratch directory is set, the fresh
+// large buffers are instead mapped onto unlinked scratch files there, so that
+// the kernel may write the idle pages out and evict them rather than hold them
+// in memory; they are never pooled
+
+namespace Workspace {
+  //
+  const int pool_threshold = 1 << 15; // smallest pooled buffer size
+
+  struct _Pool {
+    int                          level;  // active scopes
+    long                         cached; // pooled size
+    long                         limit;  // maximal pooled size
+    std::multimap<int, double*>  block;
+
+    int                          spill;  // active spill scopes
+    std::string                  scratch;// scratch directory, no spilling if empty
+    std::map<double*, int>       mapped; // scratch mapped buffers
+
+    _Pool () : level(0), cached(0), limit(1L << 28), spill(0) {}
+  };
+
+  // scratch file mapping of n doubles; zero on failure (io.cc)
+  double* scratch_map   (const std::string& dir, int n);
+  void    scratch_unmap (double*, int n);
+
+  // never destroyed: the arrays with static storage may be released at exit
+  inline _Pool& _pool () { static _Pool* p = new _Pool; return *p; }
+
+  inline void _clear (_Pool& pool)
+  {
+    for(std::multimap<int, double*>::iterator it = pool.block.begin(); it != pool.block.end(); ++it)
+      delete[] it->second;
+
+    pool.block.clear();
+    pool.cached = 0;
+  }
+
+  // maximal number of pooled doubles
+  inline void set_limit (long l)
+  {
+#pragma omp critical(workspace_pool)
+    {
+      _Pool& pool = _pool();
+      pool.limit = l;
+      if(pool.cached > l)
+	_clear(pool);
+    }
+  }
+
+  inline void set_scratch (const std::string& dir)
+  {
+#pragma omp critical(workspace_pool)
+    _pool().scratch = dir;
+  }
+
+  inline long cached_size ()
+  {
+    long res;
+
+#pragma omp critical(workspace_pool)
+    res = _pool().cached;
+
+    return res;
+  }
+
+  // the buffer size on return may be larger than requested
+  inline double* allocate (int& n)
+  {
+    if(n < pool_threshold)
+      return new double[n];
+
+    double* res = 0;
+
+    std::string scratch;
+
+#pragma omp critical(workspace_pool)
+    {
+      _Pool& pool = _pool();
+
+      if(pool.spill)
+	scratch = pool.scratch;
+
+      if(pool.level && !scratch.size()) {
+	std::multimap<int, double*>::iterator it = pool.block.lower_bound(n);
+
+	if(it != pool.block.end() && it->first - n <= n / 8) {
+	  n   = it->first;
+	  res = it->second;
+	  pool.cached -= n;
+	  pool.block.erase(it);
+	}
+      }
+    }
+
+    if(res)
+      return res;
+
+    // fresh scratch pages are zero already
+    if(scratch.size()) {
+      //
+      res = scratch_map(scratch, n);
+
+      if(res) {
+#pragma omp critical(workspace_pool)
+	_pool().mapped[res] = n;
+
+	return res;
+      }
+    }
+
+    res = new double[n];
+
+#ifdef _OPENMP
+    if(!omp_in_parallel()) {
+      //
+#pragma omp parallel for default(shared) schedule(static)
+
+      for(int i = 0; i < n; ++i)
+	res[i] = 0.;
+    }
+#endif
+
+    return res;
+  }
+
+  inline void release (double* p, int n)
+  {
+    bool kept   = false;
+    bool mapped = false;
+
+    if(n >= pool_threshold) {
+      //
+#pragma omp critical(workspace_pool)
+      {
+	_Pool& pool = _pool();
+
+	std::map<double*, int>::iterator mit = pool.mapped.find(p);
+
+	if(mit != pool.mapped.end()) {
+	  pool.mapped.erase(mit);
+	  mapped = true;
+	}
+	else if(pool.level && pool.cached + n <= pool.limit) {
+	  pool.block.insert(std::make_pair(n, p));
+	  pool.cached += n;
+	  kept = true;
+	}
+      }
+    }
+
+    if(mapped)
+      scratch_unmap(p, n);
+    else if(!kept)
+      delete[] p;
+  }
+
+  // the pooled buffers are freed when the outermost scope closes
+  class Scope {
+    Scope (const Scope&);
+    Scope& operator= (const Scope&);
+
+  public:
+    Scope () 
+    {
+#pragma omp critical(workspace_pool)
+      ++_pool().level;
+    }
+
+    ~Scope ()
+    {
+#pragma omp critical(workspace_pool)
+      {
+	_Pool& pool = _pool();
+	if(!--pool.level)
+	  _clear(pool);
+      }
+    }
+  };
+
+  // the large buffers allocated in the scope go to the scratch files
+  class Spill {
+    Spill (const Spill&);
+    Spill& operator= (const Spill&);
+
+  public:
+    Spill () 
+    {
+#pragma omp critical(workspace_pool)
+      ++_pool().spill;
+    }
+
+    ~Spill ()
+    {
+#pragma omp critical(workspace_pool)
+      --_pool().spill;
+    }
+  };
+}
+
 /**************************************************************************
  ******************************* ARRAY ************************************
  **************************************************************************/
 
+// array storage allocation; the double buffers go through the workspace pool
+template <typename T>
+struct ArrayStorage {
+  static T*   allocate (int& n)     { return new T[n]; }
+  static void release  (T* p, int)  { delete[] p;      }
+};
+
+template <>
+struct ArrayStorage<double> {
+  static double* allocate (int& n)        { return Workspace::allocate(n); }
+  static void    release  (double* p, int n) { Workspace::release(p, n);  }
+};
+
 template <typename T>
 class Array
 {
@@ -508,7 +737,7 @@ public:
   template <typename V>
   explicit Array (const V&);
 
-  ~Array () { if(_begin) delete[] _begin; }
+  ~Array () { if(_begin) ArrayStorage<T>::release(_begin, _capacity); }
 
   T*       begin ()       { return _begin; }
   T*       end   ()       { return _end; }
@@ -594,7 +823,7 @@ Array<T>::Array (const Array& v)
     return;
   }
   
-  _begin = new T[_size];
+  _begin = ArrayStorage<T>::allocate(_capacity);
   _end = _begin + _size;
 
   const_iterator vit = v.begin();
@@ -616,10 +845,10 @@ Array<T>& Array<T>::operator= (const Array& v)
 
 
   if(v.size() > _capacity) {
-    _capacity = v.size();
     if(_begin)
-      delete[] _begin;
-    _begin = new T[_size];
+      ArrayStorage<T>::release(_begin, _capacity);
+    _capacity = v.size();
+    _begin = ArrayStorage<T>::allocate(_capacity);
   }
 
   _end  = _begin + _size;
@@ -647,7 +876,7 @@ Array<T>::Array (int s)
     return;
   }
 
-  _begin = new T[_size];
+  _begin = ArrayStorage<T>::allocate(_capacity);
   _end = _begin + _size;
 }
 
@@ -667,7 +896,7 @@ Array<T>::Array (int s, const T& t)
     return;
   }
 
-  _begin = new T[_size];
+  _begin = ArrayStorage<T>::allocate(_capacity);
   _end = _begin + _size;
 
   for(T* it = begin(); it != end(); ++it)
@@ -684,7 +913,7 @@ Array<T>::Array (const V& v)
     return;
   }
   
-  _begin = new T[_size];
+  _begin = ArrayStorage<T>::allocate(_capacity);
   _end = _begin + _size;
 
   typename V::const_iterator vit = v.begin();
@@ -699,23 +928,24 @@ void Array<T>::compact ()
 	return;
 
     if(!_size) {
-	delete[] _begin;
+	ArrayStorage<T>::release(_begin, _capacity);
 	_end = _begin = 0;
 	_capacity = 0;
 	return;
     }
 
-    T* old_begin = _begin;
+    T*  old_begin    = _begin;
+    int old_capacity = _capacity;
 
-    _begin = new T[_size];
-    _end = _begin + _size;
     _capacity = _size;
+    _begin = ArrayStorage<T>::allocate(_capacity);
+    _end = _begin + _size;
 
     const T* vit = old_begin;
     for(T* it = begin(); it != end(); ++it, ++vit)
 	*it = *vit;
 
-    delete[] old_begin;
+    ArrayStorage<T>::release(old_begin, old_capacity);
 }
 
 template <typename T>
@@ -734,16 +964,18 @@ void Array<T>::resize (int s)
     return;
   }
 
-  T* new_begin = new T[s];
+  int new_capacity = s;
+  T*  new_begin    = ArrayStorage<T>::allocate(new_capacity);
 
   if(_begin) {
     T* vit = new_begin;
     for(const T* it = begin(); it != end(); ++it, ++vit)
       *vit = *it;
-    delete[] _begin;
+    ArrayStorage<T>::release(_begin, _capacity);
   }
 
-  _capacity = _size = s;
+  _capacity = new_capacity;
+  _size     = s;
   _begin = new_begin;
   _end = _begin + _size;
 }
@@ -756,17 +988,18 @@ void Array<T>::reserve (int s)
   if(s <= _capacity)
       return;
 
-  _capacity  = s;
+  T*  old_begin    = _begin;
+  int old_capacity = _capacity;
 
-  T* old_begin = _begin;
-  _begin = new T[s];
+  _capacity = s;
+  _begin = ArrayStorage<T>::allocate(_capacity);
   _end = _begin + _size;
 
   if(old_begin) {
     const T* vit = old_begin;
     for(T* it = begin(); it != end(); ++it, ++vit)
       *it = *vit;
-    delete[] old_begin;
+    ArrayStorage<T>::release(old_begin, old_capacity);
   }
 }
 
@@ -1668,22 +1901,41 @@ void Slice<T>::apply (const F& f)
  *************************** ARRAY BY REFERENCE  **************************
  **************************************************************************/
 
+// the array, the reference count, and the extents used by the derived
+// matrix classes share one allocation; the reference count is updated
+// atomically, so that the references can be copied and destroyed in
+// different threads
+
 template <typename T>
 class RefArr {
 
-  Array<T>* _data;
-  int*      _count;  // number of references
+  struct _Body : public Array<T> {
+    int count;      // number of references
+    int extent [2];
+
+    explicit _Body (int s)     : Array<T>(s),    count(1) { extent[0] = extent[1] = 0; }
+    _Body (int s, const T& t)  : Array<T>(s, t), count(1) { extent[0] = extent[1] = 0; }
+
+    using Array<T>::operator=;
+  };
+
+  _Body* _data;
 
   void delete_ref ();
   void create_ref (const RefArr&);
 
+protected:
+  // extents shared by all references
+  int  extent     (int i) const  { return _data->extent[i]; }
+  void set_extent (int i, int e) { _data->extent[i] = e;    }
+
 public:
 
   bool isinit () const { return _data; }
 
-  RefArr ()                      : _data(0), _count(0) {}
-  explicit RefArr (int s)        : _data(new Array<T>(s)),    _count(new int(1)) {}
-  RefArr (int s, const T& t)     : _data(new Array<T>(s, t)), _count(new int(1)) {}
+  RefArr ()                      : _data(0)                {}
+  explicit RefArr (int s)        : _data(new _Body(s))    {}
+  RefArr (int s, const T& t)     : _data(new _Body(s, t)) {}
  
   RefArr (const RefArr& a) { create_ref(a); }
   ~RefArr () { delete_ref(); }
@@ -1740,24 +1992,25 @@ public:
 template <typename T>
 inline void RefArr<T>::create_ref (const RefArr& a)
 {
-    _data = a._data;
-    _count =  a._count;
-    if(_count)
-      ++(*_count);
+  _data = a._data;
+  if(_data)
+#pragma omp atomic
+    ++_data->count;
 }
 
 template <typename T>
 inline void RefArr<T>::delete_ref ()
 {
-  if(!_count)
+  if(!_data)
     return;
 
-  if(*_count > 1)
-      --(*_count);
-  else {
-      delete _data;
-      delete _count;
-  }
+  int left;
+
+#pragma omp atomic capture
+  left = --_data->count;
+
+  if(!left)
+    delete _data;
 }
 
 template <typename T>
@@ -1791,10 +2044,8 @@ inline int  RefArr<T>::size ()  const
 template <typename T>
 inline void RefArr<T>::resize  (int s) 
 { 
-  if(!_data) {
-    _data = new Array<T>(s);
-    _count= new int(1);
-  }
+  if(!_data)
+    _data = new _Body(s);
   else
     _data->resize(s);  
 }
@@ -1802,10 +2053,9 @@ inline void RefArr<T>::resize  (int s)
 template <typename T>
 inline void RefArr<T>::reserve (int s) 
 { 
-  if(!_data) {
-    _data = new Array<T>(0);
-    _count= new int(1);
-  }
+  if(!_data)
+    _data = new _Body(0);
+
   _data->reserve(s); 
 }
 
@@ -1838,8 +2088,8 @@ inline int  RefArr<T>::ref_count () const
 { 
   const char funame [] = "RefArr<T>::ref_count: ";
 
-  if(_count) 
-    return *_count;
+  if(_data) 
+    return _data->count;
 
   std::cerr << funame << "not initialized\n";
   throw Error::Init();
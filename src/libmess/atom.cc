@@ -20,6 +20,8 @@
 #include <sstream>
 #include <cstdlib>
 #include <vector>
+#include <map>
+#include <algorithm>
 
 /************************** Atom description ****************************/
 
@@ -372,17 +374,30 @@ Permutation is_symmetric (const std::vector<Atom>& mol, const Symmetry::SpaceEle
   std::vector<Atom> test = mol;
   symmel.apply(mol, test);
   
+  // the symmetry element is orthogonal and preserves the distance to the origin: the image
+  // candidates are only looked for in the distance window of the atom
+  std::vector<std::pair<double, int> > radius(test.size());
+  for(int t = 0; t < test.size(); ++t)
+    radius[t] = std::make_pair(test[t].vlength(), t);
+  std::sort(radius.begin(), radius.end());
+
   std::vector<int> perm(mol.size());
   for(std::vector<Atom>::const_iterator mat = mol.begin(); mat != mol.end(); ++mat) {
     btemp = false;
-    for(std::vector<Atom>::const_iterator tat = test.begin(); tat != test.end(); ++tat) 
-      if(are_equal(*mat, *tat, tolerance, flags)) {
+
+    const double r = mat->vlength();
+
+    std::vector<std::pair<double, int> >::const_iterator rit =
+      std::lower_bound(radius.begin(), radius.end(), std::make_pair(r - tolerance, -1));
+
+    for(; rit != radius.end() && rit->first <= r + tolerance; ++rit)
+      if(are_equal(*mat, test[rit->second], tolerance, flags)) {
 	if(btemp) {
 	  std::cerr << funame << "identical atoms\n";
 	  throw Error::Logic();
 	}
 	btemp = true;
-	perm[mat - mol.begin()]  = tat - test.begin();	
+	perm[mat - mol.begin()]  = rit->second;	
       }
     if(!btemp) {
       return Permutation();
@@ -392,72 +407,320 @@ Permutation is_symmetric (const std::vector<Atom>& mol, const Symmetry::SpaceEle
   return Permutation(perm);
 }
 
-std::set<Permutation> identical_atoms_permutation_symmetry_group (const Lapack::SymmetricMatrix& dist, double tol) 
-{
-  const char funame [] = "identical_atoms_permutation_symmetry_group: ";
+namespace {
+  //
+  // distance preserving permutations of the colored atoms; the atoms are first refined into
+  // cells by their distance profiles, then the group is found as a strong generating set
+  // relative to the base of atoms (Schreier-Sims representation), level by level starting
+  // from the deepest one: at each level only the base point images outside the already
+  // known orbit are searched for
+  //
+  class DistanceAutomorphism {
+    //
+    typedef std::vector<int> perm_t; // perm[a] is the image of the atom a
+
+    const Lapack::SymmetricMatrix& _dist;
+    const double                   _tol;
+    const int                      _size;
+
+    std::vector<int>                _cell;     // atom cell index
+    std::vector<std::vector<int> >  _cell_atom;// atoms in the cell
+    std::vector<int>                _base;     // base atoms, smaller cells first
+
+    std::vector<perm_t>             _gen;      // strong generators
+    std::vector<int>                _gen_level;// the generator fixes the base points before its level
+
+    std::vector<std::map<int, perm_t> > _trans; // level transversal: orbit point -> coset representative
+
+    void _refine    (const std::vector<int>& color);
+    bool _extend    (perm_t&, std::vector<bool>&, int) const;
+    void _set_orbit (int);
+    void _elements  (int, const perm_t&, std::set<Permutation>&) const;
+
+  public:
+    //
+    DistanceAutomorphism (const Lapack::SymmetricMatrix& dist, const std::vector<int>& color, double tol);
+
+    std::set<Permutation> group () const;
+  };
+
+  DistanceAutomorphism::DistanceAutomorphism (const Lapack::SymmetricMatrix& dist, const std::vector<int>& color, double tol)
+    : _dist(dist), _tol(tol), _size(dist.size())
+  {
+    _refine(color);
+
+    // base
+    std::vector<std::pair<int, int> > order;
+    for(int a = 0; a < _size; ++a)
+      order.push_back(std::make_pair(_cell_atom[_cell[a]].size(), a));
+    std::sort(order.begin(), order.end());
+
+    for(int i = 0; i < _size; ++i)
+      _base.push_back(order[i].second);
+
+    // generators search
+    _trans.resize(_size);
+
+    perm_t img(_size);
+    std::vector<bool> used(_size);
+    
+    for(int k = _size - 1; k >= 0; --k) {
+      //
+      _set_orbit(k);
 
-  bool btemp;
+      const int b = _base[k];
+      
+      const std::vector<int>& cand = _cell_atom[_cell[b]];
 
-  std::set<Permutation> res;
-  if(!dist.size())
-    return res;
+      for(int i = 0; i < cand.size(); ++i) {
+	//
+	const int c = cand[i];
 
-  if(dist.size() == 1) {
-    res.insert(Permutation(1));
-    return res;
-  }
+	if(_trans[k].find(c) != _trans[k].end())
+	  continue;
+
+	// the base points before the level are fixed
+	std::fill(used.begin(), used.end(), false);
+	for(int l = 0; l < k; ++l) {
+	  img[_base[l]] = _base[l];
+	  used[_base[l]] = true;
+	}
 
-  std::vector<std::vector<int> > perm(1);
+	if(used[c])
+	  continue;
 
-  for(int n = 0; n < dist.size(); ++n) {
-    std::vector<std::vector<int> > new_perm;
-    for(int p = 0; p < perm.size(); ++p) {
-      std::set<int> used;
-      for(int i = 0; i < n; ++i)
-	used.insert(perm[p][i]);
+	bool btemp = true;
+	for(int l = 0; l < k && btemp; ++l)
+	  if(!are_equal(_dist(_base[l], b), _dist(_base[l], c), _tol))
+	    btemp = false;
 
-      for(int ii = 0; ii < dist.size(); ++ii) {
-	if(used.find(ii) != used.end())
+	if(!btemp)
 	  continue;
 
-	btemp = false;
-	for(int i = 0; i < n; ++i)
-	  if(!are_equal(dist(i, n), dist(perm[p][i], ii), tol)) {
-	    btemp = true;
-	    break;
-	  }
-	if(btemp)
+	img[b]  = c;
+	used[c] = true;
+
+	if(!_extend(img, used, k + 1))
 	  continue;
 
-	new_perm.push_back(perm[p]);
-	new_perm.back().push_back(ii);
+	_gen.push_back(img);
+	_gen_level.push_back(k);
+
+	_set_orbit(k);
       }
     }
-    perm = new_perm;
   }
 
-  for(int i = 0; i < perm.size(); ++i)
-    res.insert(Permutation(perm[i], Permutation::NOCHECK));
+  // cells of the atoms with the same color and the same sorted distances
+  // to the atoms of each cell, refined until stable
+  //
+  void DistanceAutomorphism::_refine (const std::vector<int>& color)
+  {
+    _cell = color;
+
+    int cell_size = 0;
+    
+    while(1) {
+      //
+      std::vector<std::vector<std::pair<int, double> > > profile(_size);
+
+      for(int a = 0; a < _size; ++a) {
+	for(int b = 0; b < _size; ++b)
+	  if(b != a)
+	    profile[a].push_back(std::make_pair(_cell[b], _dist(a, b)));
+
+	std::sort(profile[a].begin(), profile[a].end());
+      }
+      
+      std::vector<int> new_cell(_size, -1);
+      std::vector<int> rep; // cell representatives
+      
+      for(int a = 0; a < _size; ++a) {
+	//
+	for(int r = 0; r < rep.size() && new_cell[a] < 0; ++r) {
+	  //
+	  const int b = rep[r];
+
+	  if(_cell[a] != _cell[b])
+	    continue;
+
+	  bool btemp = true;
+	  for(int i = 0; i < profile[a].size() && btemp; ++i)
+	    if(profile[a][i].first != profile[b][i].first || !are_equal(profile[a][i].second, profile[b][i].second, _tol))
+	      btemp = false;
+
+	  if(btemp)
+	    new_cell[a] = r;
+	}
 
-  // check that the result is the group
-  for(std::set<Permutation>::const_iterator i = res.begin(); i != res.end(); ++i)
-    for(std::set<Permutation>::const_iterator j = res.begin(); j != res.end(); ++j)
-      if(res.find(*i * *j) == res.end()) {
-	std::cerr << funame << "not a group\n";
-	throw Error::Logic();
+	if(new_cell[a] < 0) {
+	  new_cell[a] = rep.size();
+	  rep.push_back(a);
+	}
       }
 
-  return res;
+      _cell = new_cell;
+
+      if(rep.size() == cell_size)
+	break;
+
+      cell_size = rep.size();
+    }
+
+    _cell_atom.clear();
+    _cell_atom.resize(cell_size);
+    for(int a = 0; a < _size; ++a)
+      _cell_atom[_cell[a]].push_back(a);
+  }
+
+  // depth-first completion of the base images from the k-th level on
+  //
+  bool DistanceAutomorphism::_extend (perm_t& img, std::vector<bool>& used, int k) const
+  {
+    if(k == _size)
+      return true;
+
+    const int b = _base[k];
+    
+    const std::vector<int>& cand = _cell_atom[_cell[b]];
+
+    for(int i = 0; i < cand.size(); ++i) {
+      //
+      const int c = cand[i];
+
+      if(used[c])
+	continue;
+
+      bool btemp = true;
+      for(int l = 0; l < k && btemp; ++l)
+	if(!are_equal(_dist(_base[l], b), _dist(img[_base[l]], c), _tol))
+	  btemp = false;
+
+      if(!btemp)
+	continue;
+
+      img[b]  = c;
+      used[c] = true;
+
+      if(_extend(img, used, k + 1))
+	return true;
+
+      used[c] = false;
+    }
+
+    return false;
+  }
+
+  // orbit of the k-th base point under the generators of the k-th level and deeper
+  //
+  void DistanceAutomorphism::_set_orbit (int k)
+  {
+    const int b = _base[k];
+
+    std::map<int, perm_t>& orb = _trans[k];
+
+    orb.clear();
+
+    perm_t id(_size);
+    for(int a = 0; a < _size; ++a)
+      id[a] = a;
+
+    orb[b] = id;
+
+    std::vector<int> queue(1, b);
+    for(int q = 0; q < queue.size(); ++q) {
+      //
+      const perm_t& u = orb[queue[q]];
+
+      for(int g = 0; g < _gen.size(); ++g) {
+	//
+	if(_gen_level[g] < k)
+	  continue;
+
+	const perm_t& s = _gen[g];
+
+	const int y = s[queue[q]];
+
+	if(orb.find(y) != orb.end())
+	  continue;
+
+	perm_t v(_size);
+	for(int a = 0; a < _size; ++a)
+	  v[a] = s[u[a]];
+
+	orb[y] = v;
+	
+	queue.push_back(y);
+      }
+    }
+  }
+
+  // group elements as the products of the coset representatives, u_0 * u_1 * ...
+  //
+  void DistanceAutomorphism::_elements (int k, const perm_t& g, std::set<Permutation>& res) const
+  {
+    // trivial levels
+    while(k < _size && _trans[k].size() == 1)
+      ++k;
+
+    if(k == _size) {
+      res.insert(Permutation(g, Permutation::NOCHECK));
+      return;
+    }
+
+    perm_t h(_size);
+    for(std::map<int, perm_t>::const_iterator it = _trans[k].begin(); it != _trans[k].end(); ++it) {
+      //
+      for(int a = 0; a < _size; ++a)
+	h[a] = g[it->second[a]];
+
+      _elements(k + 1, h, res);
+    }
+  }
+
+  std::set<Permutation> DistanceAutomorphism::group () const
+  {
+    const char funame [] = "DistanceAutomorphism::group: ";
+
+    std::set<Permutation> res;
+
+    perm_t id(_size);
+    for(int a = 0; a < _size; ++a)
+      id[a] = a;
+
+    _elements(0, id, res);
+
+    // the generated group elements should preserve the distances within the tolerance
+    for(std::set<Permutation>::const_iterator p = res.begin(); p != res.end(); ++p)
+      for(int a = 0; a < _size; ++a)
+	for(int b = 0; b < a; ++b)
+	  if(!are_equal(_dist(a, b), _dist((*p)[a], (*p)[b]), _tol)) {
+	    std::cerr << funame << "not a group\n";
+	    throw Error::Logic();
+	  }
+
+    return res;
+  }
+}
+
+std::set<Permutation> identical_atoms_permutation_symmetry_group (const Lapack::SymmetricMatrix& dist, double tol) 
+{
+  std::set<Permutation> res;
+  if(!dist.size())
+    return res;
+
+  if(dist.size() == 1) {
+    res.insert(Permutation(1));
+    return res;
+  }
+
+  return DistanceAutomorphism(dist, std::vector<int>(dist.size()), tol).group();
 }
 
 std::set<Permutation> permutation_symmetry_group (const std::vector<Atom>& molecule, double tolerance, int flags) 
 {
   const char funame [] = "permutation_symmetry_group: ";
   
-  int    itemp;
-  double dtemp;
-  bool   btemp;
-
   if(tolerance <= 0. || tolerance >= 1.) {
     std::cerr << funame << "tolerance out of range\n";
     throw Error::Range();
@@ -483,76 +746,23 @@ std::set<Permutation> permutation_symmetry_group (const std::vector<Atom>& molec
       dist(i, j) = vdistance(molecule[i], molecule[j]);
 
   // identical atoms groups
-  std::vector<std::vector<int> > atom_group;
+  std::vector<int> color(molecule.size());
   if(flags & IGNORE_ISOTOPE) {
-    std::map<int, std::vector<int> > ag;
     for(int i = 0; i < molecule.size(); ++i)
-      ag[molecule[i].number()].push_back(i);
-
-    for(std::map<int, std::vector<int> >::const_iterator it = ag.begin(); it != ag.end(); ++it)
-      atom_group.push_back(it->second);
+      color[i] = molecule[i].number();
   }
   else {
-    std::map<AtomBase, std::vector<int> > ag;
-    for(int i = 0; i < molecule.size(); ++i)
-      ag[molecule[i]].push_back(i);
-    
-    for(std::map<AtomBase, std::vector<int> >::const_iterator it = ag.begin(); it != ag.end(); ++it)
-      atom_group.push_back(it->second);
-  }
-
-  // identical atoms permutation symmetry groups
-  std::vector<std::set<Permutation> > atom_group_perm(atom_group.size());
-  for(int g = 0; g < atom_group.size(); ++g) {
-    Lapack::SymmetricMatrix group_dist(atom_group[g].size());
-    for(int i = 0; i < atom_group[g].size(); ++i)
-      for(int j = 0; j < i; ++j)
-	group_dist(i, j) = dist(atom_group[g][i], atom_group[g][j]);
-    
-    atom_group_perm[g] = identical_atoms_permutation_symmetry_group(group_dist, tolerance);
-  }
-
-  // all atoms permutation symmetry group
-  std::vector<std::vector<Permutation> > perm(1);
-  for(int g = 0; g < atom_group.size(); ++g) {
-    std::vector<std::vector<Permutation> > new_perm;
-    for(int p = 0; p < perm.size(); ++p)
-      for(std::set<Permutation>::const_iterator q = atom_group_perm[g].begin(); q != atom_group_perm[g].end(); ++q) {
-	btemp = false;
-	for(int i = 0; i < atom_group[g].size(); ++i)
-	  for(int f = 0; f < g; ++f)
-	    for(int j = 0; j < atom_group[f].size(); ++j)
-	      if(!are_equal(dist(atom_group[f][j], atom_group[g][i]), dist(atom_group[f][perm[p][f][j]],atom_group[g][(*q)[i]]), tolerance)) {
-		btemp = true;
-		break;
-	      }
-	if(btemp)
-	  continue;
-	new_perm.push_back(perm[p]);
-	new_perm.back().push_back(*q);
+    std::map<AtomBase, int> ag;
+    for(int i = 0; i < molecule.size(); ++i) {
+      if(ag.find(molecule[i]) == ag.end()) {
+	const int c = ag.size();
+	ag[molecule[i]] = c;
       }
-    perm = new_perm;
-  }
-
-  std::set<Permutation> res;
-  for(int p = 0; p < perm.size(); ++p) {
-    std::vector<int> gp(dist.size());
-    for(int g = 0; g < atom_group.size(); ++g)
-      for(int a = 0; a < atom_group[g].size(); ++a)
-	gp[atom_group[g][a]] = atom_group[g][perm[p][g][a]];
-    
-    res.insert(Permutation(gp, Permutation::NOCHECK));
+      color[i] = ag[molecule[i]];
+    }
   }
 
-  // check that the result is the group
-  for(std::set<Permutation>::const_iterator i = res.begin(); i != res.end(); ++i)
-    for(std::set<Permutation>::const_iterator j = res.begin(); j != res.end(); ++j)
-      if(res.find(*i * *j) == res.end()) {
-	std::cerr << funame << "not a group\n";
-	throw Error::Logic();
-      }
-
-  return res;
+  return DistanceAutomorphism(dist, color, tolerance).group();
 }
 
 std::pair<int, int> symmetry_number (const std::vector<Atom>& molecule, double tolerance, int flags) 
@@ -0,0 +1,201 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#include "batch.hh"
+#include "io.hh"
+#include "threads.hh"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace Batch {
+  //
+  std::string file_name (const std::string& base_name, int worker, const std::string& tag)
+  {
+    std::ostringstream to;
+    to << base_name << ".batch." << worker << "." << tag;
+    return to.str();
+  }
+
+  // inputs [ibeg, iend) of the worker
+  void run_block (const Job& job, const std::vector<std::string>& input, int ibeg, int iend, std::ostream& to)
+  {
+    for(int i = ibeg; i < iend; ++i) {
+      std::ostringstream res;
+      try {
+	job.run(input[i], res);
+	to << res.str() << "\n";
+      }
+      catch(...) {
+	to << "{\"input\": " << json_string(input[i]) << ", \"error\": \"evaluation failed\"}\n";
+      }
+      to.flush();
+    }
+  }
+}
+
+std::string Batch::json_string (const std::string& s)
+{
+  std::string res = "\"";
+  for(int i = 0; i < s.size(); ++i) {
+    if(s[i] == '"' || s[i] == '\\')
+      res += '\\';
+    res += s[i];
+  }
+  res += '"';
+  return res;
+}
+
+std::string Batch::json_number (double x)
+{
+  if(x != x || x - x != 0.)
+    return "null";
+
+  std::ostringstream to;
+  to << std::setprecision(10) << x;
+  return to.str();
+}
+
+std::vector<std::string> Batch::read_manifest (const std::string& manifest)
+{
+  const char funame [] = "Batch::read_manifest: ";
+
+  std::ifstream from(manifest.c_str());
+  if(!from) {
+    std::cerr << funame << "cannot open " << manifest << " file\n";
+    throw Error::Input();
+  }
+
+  std::vector<std::string> res;
+  std::string line, name;
+  while(std::getline(from, line)) {
+    std::istringstream lin(line);
+    if(lin >> name && name[0] != '#')
+      res.push_back(name);
+  }
+
+  if(!res.size()) {
+    std::cerr << funame << manifest << ": no inputs\n";
+    throw Error::Input();
+  }
+
+  return res;
+}
+
+void Batch::run (const Job& job, const std::vector<std::string>& input, int worker_size,
+		 const std::string& base_name, std::ostream& to)
+{
+  const char funame [] = "Batch::run: ";
+
+  if(worker_size > input.size())
+    worker_size = input.size();
+
+  if(worker_size <= 1) {
+    run_block(job, input, 0, input.size(), to);
+    return;
+  }
+
+  // the buffered output should not be duplicated in the child processes
+  IO::log.flush();
+  IO::out.flush();
+  std::cout.flush();
+  to.flush();
+
+  std::vector<pid_t> worker_pid(worker_size);
+
+  for(int k = 0; k < worker_size; ++k) {
+    const int ibeg = input.size() *  k      / worker_size;
+    const int iend = input.size() * (k + 1) / worker_size;
+
+    worker_pid[k] = fork();
+
+    if(worker_pid[k] < 0) {
+      std::cerr << funame << "fork failed\n";
+      throw Error::Run();
+    }
+
+    // worker
+    if(!worker_pid[k]) {
+      int status = 0;
+      try {
+	// share the cores, the OpenMP and the BLAS threads, between the workers
+	int itemp = Threads::total() / worker_size;
+	Threads::init(itemp > 0 ? itemp : 1);
+	if(IO::log.is_open()) {
+	  IO::log.close();
+	  IO::log.open(file_name(base_name, k, "log").c_str());
+	}
+
+	std::ofstream res(file_name(base_name, k, "res").c_str());
+	run_block(job, input, ibeg, iend, res);
+	res.close();
+
+	if(!res)
+	  status = 1;
+      }
+      catch(...) {
+	status = 1;
+      }
+
+      if(IO::log.is_open())
+	IO::log.close();
+
+      _exit(status);
+    }
+  }
+
+  // wait for the workers
+  bool isfail = false;
+  for(int k = 0; k < worker_size; ++k) {
+    int status;
+    if(waitpid(worker_pid[k], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) {
+      std::cerr << funame << "worker " << k << " failed\n";
+      isfail = true;
+    }
+  }
+
+  // collect the results and the log in the block order
+  for(int k = 0; k < worker_size; ++k) {
+    std::string name = file_name(base_name, k, "res");
+    if(!isfail) {
+      std::ifstream from(name.c_str());
+      if(from && from.peek() != std::ifstream::traits_type::eof())
+	to << from.rdbuf();
+    }
+    std::remove(name.c_str());
+
+    if(IO::log.is_open()) {
+      name = file_name(base_name, k, "log");
+      std::ifstream from(name.c_str());
+      if(from && from.peek() != std::ifstream::traits_type::eof())
+	(std::ostream&)IO::log << from.rdbuf();
+      from.close();
+      std::remove(name.c_str());
+    }
+  }
+
+  if(isfail) {
+    IO::log << std::flush;
+    throw Error::Run();
+  }
+}
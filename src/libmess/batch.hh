@@ -0,0 +1,57 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#ifndef BATCH_HH
+#define BATCH_HH
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "error.hh"
+
+/********************************************************************************************
+ ***************** BATCH EVALUATION OF INDEPENDENT INPUTS IN WORKER PROCESSES ***************
+ ********************************************************************************************/
+
+// the model is global, so the inputs are read and evaluated in forked worker processes,
+// each process handling a contiguous block of inputs; the structured output of each input
+// is one JSON object per line, collected in the input order
+
+namespace Batch {
+  //
+  // evaluation of one input
+  //
+  class Job {
+  public:
+    virtual ~Job () {}
+
+    // reads the input and writes its JSON object (without the trailing newline)
+    virtual void run (const std::string& input, std::ostream& to) const =0;
+  };
+
+  // input file names, one per line, blank lines and # comments skipped
+  std::vector<std::string> read_manifest (const std::string& manifest);
+
+  // the input which failed is reported by the {"input": ..., "error": ...} object;
+  // IO::log of the workers is appended to the parent one
+  void run (const Job&, const std::vector<std::string>& input, int worker_size,
+	    const std::string& base_name, std::ostream& to);
+
+  std::string json_string (const std::string&);
+  std::string json_number (double);
+}
+
+#endif
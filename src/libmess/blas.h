@@ -280,12 +280,13 @@ stpsv_(char* uplo, char* trans, char* diag, Lapack::int_t* N,
        float* X, Lapack::int_t* incX);
 
 int 
-dgbmv_(char *trans, Lapack::int_t *M, Lapack::int_t *N, Lapack::int_t *KL, Lapack::int_t *KU, 
-       double *alpha, 
-       double *A, Lapack::int_t *lda, 
-       double *X, Lapack::int_t *incX, 
-       double *beta, 
-       double *Y, Lapack::int_t *incY);
+dgbmv_(const char& trans, const Lapack::int_t& M, const Lapack::int_t& N, 
+       const Lapack::int_t& KL, const Lapack::int_t& KU, 
+       const double& alpha, 
+       const double* A, const Lapack::int_t& lda, 
+       const double* X, const Lapack::int_t& incX, 
+       const double& beta, 
+       double* Y, const Lapack::int_t& incY);
 
 int 
 dtrmv_(char* uplo, char *trans, char* diag, Lapack::int_t *N,  
@@ -475,12 +476,12 @@ dsymv_(char* uplo, Lapack::int_t* N,
        double* Y, Lapack::int_t* incY);
 
 int 
-dsbmv_(char* uplo, Lapack::int_t* N, Lapack::int_t* K,
-       double* alpha,
-       double* A, Lapack::int_t* lda,
-       double* X, Lapack::int_t* incX,
-       double* beta,
-       double* Y, Lapack::int_t* incY);
+dsbmv_(const char& uplo, const Lapack::int_t& N, const Lapack::int_t& K,
+       const double& alpha,
+       const double* A, const Lapack::int_t& lda,
+       const double* X, const Lapack::int_t& incX,
+       const double& beta,
+       double* Y, const Lapack::int_t& incY);
 
 int
 dger_(Lapack::int_t* M, Lapack::int_t* N,
@@ -690,12 +691,12 @@ strsm_(char* side, char* uplo, char* trans, char* diag,
 
 
 int
-dsymm_(char* side, char* uplo, Lapack::int_t* M, Lapack::int_t* N,
-       double* alpha,
-       double* A, Lapack::int_t* lda,
-       double* B, Lapack::int_t* ldb,
-       double* beta,
-       double* C, Lapack::int_t* ldc);
+dsymm_(const char& side, const char& uplo, const Lapack::int_t& M, const Lapack::int_t& N,
+       const double& alpha,
+       const double* A, const Lapack::int_t& lda,
+       const double* B, const Lapack::int_t& ldb,
+       const double& beta,
+       double* C, const Lapack::int_t& ldc);
 
 int
 dsyrk_(char* uplo, char* trans, Lapack::int_t* N, Lapack::int_t* K,
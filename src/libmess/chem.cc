@@ -3,6 +3,7 @@
 
 #include <map>
 #include <set>
+#include <cmath>
 
 /*************************************************************************
  ************************* TOLERANCES AND LIMITS *************************
@@ -46,6 +47,45 @@ double Chem::max_bond_length(const AtomBase& a1, const AtomBase& a2)
 }
 
 
+/**********************************************************************************
+ ******************************* VERTEX MASK **************************************
+ **********************************************************************************/
+
+int Chem::VertexMask::count () const
+{
+  int res = 0;
+
+  for(int i = 0; i < _word.size(); ++i)
+    //
+    res += __builtin_popcountll(_word[i]);
+
+  return res;
+}
+
+int Chem::VertexMask::first () const
+{
+  for(int i = 0; i < _word.size(); ++i)
+    //
+    if(_word[i])
+      //
+      return i * WORD_SIZE + __builtin_ctzll(_word[i]);
+
+  return -1;
+}
+
+Chem::VertexMask::operator std::set<int> () const
+{
+  std::set<int> res;
+
+  for(int i = 0; i < _word.size(); ++i)
+    //
+    for(_word_t w = _word[i]; w; w &= w - 1)
+      //
+      res.insert(i * WORD_SIZE + __builtin_ctzll(w));
+
+  return res;
+}
+
 /**********************************************************************************
  *********************************** GRAPH ****************************************
  **********************************************************************************/
@@ -116,24 +156,21 @@ std::set<Permutation> Chem::Graph::_default_symmetry_group () const
       //
     }// valence map cycle
 
-    // check if the permutation belongs to the symmetry group
+    // check if the permutation belongs to the symmetry group: the permutation
+    // is one-to-one, so it is enough that every bond goes into a bond
     //
-    std::set<std::set<int> > test;
+    btemp = true;
     
-    std::set<std::set<int> >::const_iterator git;
-
-    for(git = begin(); git != end(); ++git) {
+    for(std::set<std::set<int> >::const_iterator git = begin(); git != end(); ++git)
       //
-      std::set<int> edge;
-
-      for(std::set<int>::const_iterator sit = git->begin(); sit != git->end(); ++sit)
+      if(!_adj[perm[*git->begin()]].test(perm[*git->rbegin()])) {
 	//
-	edge.insert(perm[*sit]);
+	btemp = false;
 
-      test.insert(edge);
-    }
+	break;
+      }
 
-    if(test == *this)
+    if(btemp)
       //
       res.insert(Permutation(perm));
     //
@@ -154,9 +191,7 @@ Chem::Graph Chem::Graph::_projection (const std::vector<int>& vset) const
 
   _isinit();
   
-  std::map<int, int> back;
-
-  std::set<int> vpool;
+  VertexMask vpool(_vsize);
   
   for(int i = 0; i < vset.size(); ++i) {
     //
@@ -164,38 +199,32 @@ Chem::Graph Chem::Graph::_projection (const std::vector<int>& vset) const
 
     _assert(itemp);
     
-    if(!vpool.insert(itemp).second) {
+    if(vpool.test(itemp)) {
       //
       ErrOut err_out;
 
       err_out << funame << "identical vertices in the subset: " << itemp;
     }
     
-    back[itemp] = i;
+    vpool.set(itemp);
   }
 
   std::set<std::set<int> > res;
   
-  std::set<std::set<int> >::const_iterator git;
-
-  for(git = begin(); git != end(); ++git) {
+  for(int i = 0; i < vset.size(); ++i)
     //
-    std::set<int> edge;
-    
-    for(std::set<int>::const_iterator sit = git->begin(); sit != git->end(); ++sit) {
+    for(int j = i + 1; j < vset.size(); ++j)
       //
-      std::map<int, int>::const_iterator mit = back.find(*sit);
-
-      if(mit != back.end())
+      if(_adj[vset[i]].test(vset[j])) {
 	//
-	edge.insert(mit->second);
-      //
-    }//
+	std::set<int> edge;
 
-    if(edge.size() == 2)
-      //
-      res.insert(edge);
-  }
+	edge.insert(i);
+
+	edge.insert(j);
+	
+	res.insert(edge);
+      }
 
   return Graph(vset.size(), res);
 }
@@ -212,30 +241,78 @@ std::set<int> Chem::Graph::_find_neighbor (int v) const
 
   _isinit();
   
-  std::set<int> res;
-
   _assert(v);
 
-  std::set<std::set<int> >::const_iterator git;
+  return _adj[v];
+}
 
-  for(git = begin(); git != end(); ++git) {
+// bond check
+//
+bool Chem::Graph::is_bond (int v0, int v1) const
+{
+  _isinit();
+
+  _assert(v0);
+
+  _assert(v1);
+
+  return _adj[v0].test(v1);
+}
+
+// connected component of the vertex: the breadth-first search over the adjacency masks
+//
+Chem::VertexMask Chem::Graph::_component (int v) const
+{
+  VertexMask res(_vsize);
+
+  res.set(v);
+
+  VertexMask layer = res;
+
+  while(!layer.none()) {
     //
-    std::set<int>::const_iterator sit = git->find(v);
-    
-    if(sit != git->end()) {
-      //
-      if(sit != git->begin()) {
-	//
-	res.insert(*git->begin());
-      }
-      else
-	//
-	res.insert(*git->rbegin());
+    VertexMask next(_vsize);
+
+    for(int w = layer.first(); w >= 0; w = layer.first()) {
       //
-    }//
+      next |= _adj[w];
+
+      layer.reset(w);
+    }
+
+    next -= res;
+
+    res |= next;
+
+    layer = next;
+  }
+
+  return res;
+}
+
+// connected subsets of vertices
+//
+std::vector<std::set<int> > Chem::Graph::connected_components () const
+{
+  _isinit();
+
+  std::vector<std::set<int> > res;
+
+  VertexMask vpool(_vsize);
+
+  for(int v = 0; v < _vsize; ++v)
     //
-  }//
-    
+    vpool.set(v);
+
+  for(int v = vpool.first(); v >= 0; v = vpool.first()) {
+    //
+    VertexMask comp = _component(v);
+
+    res.push_back(comp);
+
+    vpool -= comp;
+  }
+
   return res;
 }
 
@@ -264,42 +341,7 @@ bool Chem::Graph::is_connected () const
 
   _isinit();
   
-  std::set<int> test;
-
-  test.insert(0);
-
-  while(1) {
-    //
-    std::set<int> next;// next connected layer
-    
-    for(std::set<int>::const_iterator sit = test.begin(); sit != test.end(); ++sit) {
-      //
-      std::set<int> near = _find_neighbor(*sit);
-
-      for(std::set<int>::const_iterator nit = near.begin(); nit != near.end(); ++nit)
-	//
-	if(test.find(*nit) == test.end())
-	  //
-	  next.insert(*nit);
-    }
-
-    if(!next.size()) {
-      //
-      if(test.size() < _vsize) {
-	//
-	return false;
-      }
-      else
-	//
-	return true;
-    }
-
-    // merge with the rest
-    //
-    for(std::set<int>::const_iterator sit = next.begin(); sit != next.end(); ++sit)
-      //
-      test.insert(*sit);
-  }
+  return _component(0).count() == _vsize;
 }
 
 // bond distance between two vertices
@@ -318,52 +360,43 @@ int Chem::Graph::distance (int v0, int v1) const
 
   _assert(v1);
   
-  std::set<int> test;
+  VertexMask test(_vsize);
+
+  test.set(v0);
 
-  test.insert(v0);
+  VertexMask layer = test;
 
   int res = 0;
   
   while(1) {
     //
-    if(test.find(v1) != test.end())
+    if(test.test(v1))
       //
       return res;
     
-    std::set<int> next;// next connected layer
+    VertexMask next(_vsize);// next connected layer
     
-    for(std::set<int>::const_iterator sit = test.begin(); sit != test.end(); ++sit) {
+    for(int w = layer.first(); w >= 0; w = layer.first()) {
       //
-      std::set<int> near = _find_neighbor(*sit);
+      next |= _adj[w];
 
-      for(std::set<int>::const_iterator nit = near.begin(); nit != near.end(); ++nit)
-	//
-	if(test.find(*nit) == test.end())
-	  //
-	  next.insert(*nit);
+      layer.reset(w);
     }
 
-    if(!next.size()) {
-      //
-      if(test.size() < _vsize) {
-	//
-	IO::log << IO::log_offset << funame << "WARNING: graph is not connected";
+    next -= test;
 
-	return -1;
-      }
-      else {
-	//
-	ErrOut err_out;
+    if(next.none()) {
+      //
+      IO::log << IO::log_offset << funame << "WARNING: graph is not connected";
 
-	err_out << funame << "logical error";
-      }
+      return -1;
     }
     
     // merge with the rest
     //
-    for(std::set<int>::const_iterator sit = next.begin(); sit != next.end(); ++sit)
-      //
-      test.insert(*sit);
+    test |= next;
+
+    layer = next;
 
     ++res;
   }
@@ -431,6 +464,48 @@ void Chem::Graph::init (int v, const std::set<std::set<int> >& base)
   (std::set<std::set<int> >&)*this = base;
   
   _assert();
+
+  _adj.assign(_vsize, VertexMask(_vsize));
+
+  for(const_iterator git = begin(); git != end(); ++git) {
+    //
+    _adj[*git->begin()].set(*git->rbegin());
+
+    _adj[*git->rbegin()].set(*git->begin());
+  }
+}
+
+// bonds from the interatomic distances
+//
+void Chem::Graph::init (const std::vector<Atom>& atom)
+{
+  double dtemp;
+
+  std::set<std::set<int> > bond;
+
+  for(int i = 0; i < atom.size(); ++i)
+    //
+    for(int j = i + 1; j < atom.size(); ++j) {
+      //
+      dtemp = 0.;
+
+      for(int k = 0; k < 3; ++k)
+	//
+	dtemp += (atom[i][k] - atom[j][k]) * (atom[i][k] - atom[j][k]);
+
+      if(std::sqrt(dtemp) < max_bond_length(atom[i], atom[j])) {
+	//
+	std::set<int> edge;
+
+	edge.insert(i);
+
+	edge.insert(j);
+
+	bond.insert(edge);
+      }
+    }
+
+  init(atom.size(), bond);
 }
 
  void Chem::Graph::_assert () const
@@ -2,6 +2,7 @@
 #define CHEM_HH
 
 #include <set>
+#include <vector>
 
 #include "permutation.hh"
 #include "atom.hh"
@@ -27,10 +28,86 @@ namespace Chem {
    *********************************** GRAPH ****************************************
    **********************************************************************************/
 
+  // vertex subset bit mask
+  //
+  class VertexMask {
+    //
+    typedef unsigned long long _word_t;
+
+    enum { WORD_SIZE = 64 };
+
+    std::vector<_word_t> _word;
+
+  public:
+    //
+    VertexMask () {}
+
+    explicit VertexMask (int s) : _word((s + WORD_SIZE - 1) / WORD_SIZE, 0) {}
+
+    void   set (int v)       { _word[v / WORD_SIZE] |=  ((_word_t)1 << (v % WORD_SIZE)); }
+    void reset (int v)       { _word[v / WORD_SIZE] &= ~((_word_t)1 << (v % WORD_SIZE)); }
+    bool  test (int v) const { return _word[v / WORD_SIZE] & ((_word_t)1 << (v % WORD_SIZE)); }
+
+    int  count () const;
+    bool  none () const;
+    int  first () const; // the lowest vertex in the subset, -1 if empty
+
+    VertexMask& operator|= (const VertexMask&);
+    VertexMask& operator&= (const VertexMask&);
+    VertexMask& operator-= (const VertexMask&); // subset difference
+
+    bool operator== (const VertexMask& m) const { return _word == m._word; }
+    bool operator!= (const VertexMask& m) const { return _word != m._word; }
+
+    operator std::set<int> () const;
+  };
+
+  inline VertexMask& VertexMask::operator|= (const VertexMask& m)
+  {
+    for(int i = 0; i < _word.size(); ++i)
+      //
+      _word[i] |= m._word[i];
+
+    return *this;
+  }
+
+  inline VertexMask& VertexMask::operator&= (const VertexMask& m)
+  {
+    for(int i = 0; i < _word.size(); ++i)
+      //
+      _word[i] &= m._word[i];
+
+    return *this;
+  }
+
+  inline VertexMask& VertexMask::operator-= (const VertexMask& m)
+  {
+    for(int i = 0; i < _word.size(); ++i)
+      //
+      _word[i] &= ~m._word[i];
+
+    return *this;
+  }
+
+  inline bool VertexMask::none () const
+  {
+    for(int i = 0; i < _word.size(); ++i)
+      //
+      if(_word[i])
+	//
+	return false;
+
+    return true;
+  }
+
+  // the bonds are kept both as the set of vertex pairs and as the adjacency masks
+  //
   class Graph: private std::set<std::set<int> > {
 
     int _vsize;// vertex size
 
+    std::vector<VertexMask> _adj;// adjacency masks
+
     void _assert (int) const;
 
     void _assert ()    const;
@@ -41,7 +118,9 @@ namespace Chem {
 
     std::set<int> _find_neighbor (int)               const; // subset of nearest neigbors
 
-    int _valence (int v) const { return _find_neighbor(v).size(); }  
+    int _valence (int v) const { return _adj[v].count(); }  
+
+    VertexMask _component (int) const; // connected component of the vertex
 
     Graph _projection (const std::vector<int>&)      const; // graph projection on the subset of vertices
 
@@ -51,6 +130,10 @@ namespace Chem {
 
     void init (int, const std::set<std::set<int> >&);
 
+    // bonds from the interatomic distances
+    //
+    void init (const std::vector<Atom>&);
+
     Graph () : _vsize(0) {}
 
     explicit Graph (int s, const std::set<std::set<int> >& g) : _vsize(0) { init(s, g); }
@@ -62,8 +145,14 @@ namespace Chem {
 
     bool is_connected ()    const; // is graph connected
 
+    // connected subsets of vertices, e.g., the fragments of the molecule
+    //
+    std::vector<std::set<int> > connected_components () const;
+    
     bool is_bond (int, int) const;
 
+    const VertexMask& neighbor (int v) const { _assert(v); return _adj[v]; }
+
     int distance (int, int) const;
     
     std::set<Permutation> symmetry_group () const;
@@ -18,6 +18,14 @@
 #include "lapack.hh"
 #include "io.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <exception>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace Configuration {
   
   Layout State::layout;
@@ -70,6 +78,117 @@ void Configuration::Layout::set (const std::vector<int>& lt)
   }
 }
 
+/***************************************************************************************************************************
+ ************************************** COMPILED SYMMETRY OPERATIONS ON THE STATE VECTOR ***********************************
+ ***************************************************************************************************************************/
+
+// matrix columns are the images of the unit state vectors
+void Configuration::GroupBase::compile () const 
+{
+  const int dim = State::layout.linear_size();
+
+  if(_dim == dim)
+    return;
+
+  _matrix.resize(size() * dim * dim);
+  _linear.resize(size());
+
+  State unit, image;
+  for(int g = 0; g < size(); ++g) {
+    _linear[g] = _is_linear(g);
+
+    if(!_linear[g])
+      continue;
+
+    double* m = &_matrix[g * dim * dim];
+    for(int j = 0; j < dim; ++j) {
+      unit    = 0.;
+      unit[j] = 1.;
+
+      apply(g, unit, image);
+
+      for(int i = 0; i < dim; ++i)
+	m[i * dim + j] = image[i];
+    }
+  }
+
+  _dim = dim;
+}
+
+void Configuration::GroupBase::batch (int g, int n, const double* v, double* res) const 
+{
+  const char funame [] = "Configuration::GroupBase::batch: ";
+
+  double dtemp;
+
+  if(g < 0 || g >= size() || n < 0) {
+    std::cerr << funame << "out of range\n";
+    throw Error::Range();
+  }
+
+  compile();
+
+  const int dim = _dim;
+
+  // nonlinear operation
+  if(!_linear[g]) {
+    State vtemp, rtemp;
+    for(int k = 0; k < n; ++k, v += dim, res += dim) {
+      for(int i = 0; i < dim; ++i)
+	vtemp[i] = v[i];
+
+      apply(g, vtemp, rtemp);
+
+      for(int i = 0; i < dim; ++i)
+	res[i] = rtemp[i];
+    }
+    return;
+  }
+
+  const double* m = &_matrix[g * dim * dim];
+
+  for(int k = 0; k < n; ++k, v += dim, res += dim)
+    for(int i = 0; i < dim; ++i) {
+      dtemp = 0.;
+      
+#pragma omp simd reduction(+: dtemp)
+
+      for(int j = 0; j < dim; ++j)
+	dtemp += m[i * dim + j] * v[j];
+
+      res[i] = dtemp;
+    }
+}
+
+void Configuration::GroupBase::orbit (const State& v, std::vector<State>& res) const 
+{
+  res.resize(size());
+
+  res[0] = v;
+
+  for(int g = 1; g < size(); ++g)
+    batch(g, 1, v.begin(), res[g].begin());
+}
+
+int Configuration::GroupBase::canonical (const State& v, State& res) const 
+{
+  State vtemp;
+
+  res = v;
+
+  int g_min = 0;
+  for(int g = 1; g < size(); ++g) {
+    batch(g, 1, v.begin(), vtemp.begin());
+
+    if(std::lexicographical_compare(vtemp.begin(), vtemp.end(), res.begin(), res.end())) {
+      res   = vtemp;
+      g_min = g;
+    }
+  }
+
+  return g_min;
+}
+
 /***************************************************************************************************************************
  ***************************** SYMMETRY GROUP FOR NONLINEAR + LINEAR AND/OR ATOMIC FRAGMENTS *******************************
  ***************************************************************************************************************************/
@@ -667,12 +786,194 @@ int Configuration::Simplexation::_iterate_simplex_center (const std::set<int>& s
   return 0;
 }
 
+/********************************************************************************************
+ ************************************* VERTEX K-D TREE **************************************
+ ********************************************************************************************/
+
+void Configuration::Simplexation::_VertexTree::init (int dim) 
+{
+  const char funame [] = "Configuration::Simplexation::_VertexTree::init: ";
+
+  if(dim <= 0) {
+    std::cerr << funame << "out of range\n";
+    throw Error::Range();
+  }
+
+  _dim = dim;
+  _coord.clear();
+  _node.clear();
+}
+
+double Configuration::Simplexation::_VertexTree::_distance (const double* x, int v) const
+{
+  double dtemp;
+
+  const double* c = vertex(v);
+
+  double res = 0.;
+  for(int i = 0; i < _dim; ++i) {
+    dtemp = x[i] - c[i];
+    res += dtemp * dtemp;
+  }
+
+  return res;
+}
+
+// the splitting axis cycles with the tree depth
+void Configuration::Simplexation::_VertexTree::insert (const double* x)
+{
+  const int v = _node.size();
+
+  _coord.insert(_coord.end(), x, x + _dim);
+  _node.push_back(_Node());
+
+  if(!v)
+    return;
+
+  int n = 0;
+  for(int axis = 0; ; axis = (axis + 1) % _dim) {
+    int& next = x[axis] < vertex(n)[axis] ? _node[n].left : _node[n].right;
+
+    if(next < 0) {
+      next = v;
+      return;
+    }
+
+    n = next;
+  }
+}
+
+bool Configuration::Simplexation::_VertexTree::find (const double* x, double r) const
+{
+  if(!_node.size())
+    return false;
+
+  const double r2 = r * r;
+
+  std::vector<std::pair<int, int> > stack(1, std::make_pair(0, 0));
+
+  while(stack.size()) {
+    const int n    = stack.back().first;
+    const int axis = stack.back().second;
+    stack.pop_back();
+
+    if(_distance(x, n) < r2)
+      return true;
+
+    const double dx = x[axis] - vertex(n)[axis];
+    const int near  = dx < 0. ? _node[n].left  : _node[n].right;
+    const int far   = dx < 0. ? _node[n].right : _node[n].left;
+    const int next  = (axis + 1) % _dim;
+
+    if(far >= 0 && dx * dx < r2)
+      stack.push_back(std::make_pair(far, next));
+
+    if(near >= 0)
+      stack.push_back(std::make_pair(near, next));
+  }
+
+  return false;
+}
+
+int Configuration::Simplexation::_VertexTree::nearest (const double* x, double& dist) const
+{
+  const char funame [] = "Configuration::Simplexation::_VertexTree::nearest: ";
+
+  double dtemp;
+
+  if(!_node.size()) {
+    std::cerr << funame << "no vertices\n";
+    throw Error::Init();
+  }
+
+  int    res = -1;
+  double dmin;
+
+  // node, axis, and the squared distance to the splitting plane of the parent
+  struct _Entry {
+    int    node;
+    int    axis;
+    double plane;
+  };
+
+  std::vector<_Entry> stack;
+  _Entry entry = {0, 0, 0.};
+  stack.push_back(entry);
+
+  while(stack.size()) {
+    entry = stack.back();
+    stack.pop_back();
+
+    if(res >= 0 && entry.plane >= dmin)
+      continue;
+
+    const int n = entry.node;
+
+    dtemp = _distance(x, n);
+    if(res < 0 || dtemp < dmin) {
+      dmin = dtemp;
+      res  = n;
+    }
+
+    const double dx = x[entry.axis] - vertex(n)[entry.axis];
+    const int near  = dx < 0. ? _node[n].left  : _node[n].right;
+    const int far   = dx < 0. ? _node[n].right : _node[n].left;
+    const int next  = (entry.axis + 1) % _dim;
+
+    if(far >= 0) {
+      _Entry e = {far, next, dx * dx};
+      stack.push_back(e);
+    }
+
+    if(near >= 0) {
+      _Entry e = {near, next, 0.};
+      stack.push_back(e);
+    }
+  }
+
+  dist = std::sqrt(dmin);
+
+  return res;
+}
+
+/********************************************************************************************
+ ************************************* RANDOM VERTICES **************************************
+ ********************************************************************************************/
+
+void Configuration::Simplexation::_random_guess (State& guess, double rmax, double rmin) const 
+{
+  const char funame [] = "Configuration::Simplexation::_random_guess: ";
+
+  // linear subspace
+  switch(State::layout.size(0)) {
+  case 0:
+    // do nothing
+    break;
+  case 1:
+    guess[0] = Random::flat() * rmax;
+    break;
+  case 3:
+    Random::spherical_layer(guess.begin(), 3, rmin, rmax);
+    break;
+  default:
+    std::cerr << funame << "unknown linear subspace dimension: " << State::layout.size(0) << "\n";
+    throw Error::Logic();
+  }
+
+  // spherical subspaces
+  for(int s = 1;  s < State::layout.size(); ++s)
+    Random::orient(guess.begin() + State::layout.shift(s), State::layout.size(s));
+}
+
+// random guesses are generated in batches; the batch is checked against the
+// vertex tree in parallel and then accepted sequentially so that the guesses
+// accepted earlier in the batch are also taken into account
 void Configuration::Simplexation::random_init (double dist_min, double rmax, double rmin) 
 {
   const char funame [] = "Configuration::Simplexation::random_init: ";
 
   int    itemp;
-  double dtemp, dmin, dmax;
+  double dtemp;
 
   switch(State::layout.size(0)) {
   case 0:
@@ -695,89 +996,106 @@ void Configuration::Simplexation::random_init (double dist_min, double rmax, dou
     throw Error::Logic();
   }
 
+  // set up the vertex tree
+  if(!_vertex.size() || _vertex_tree.size() != _vertex.size()) {
+    _vertex_tree.init(State::layout.linear_size());
+    for(int v = 0; v < _vertex.size(); ++v)
+      _vertex_tree.insert(_vertex[v].begin());
+  }
+
+  const int group_size = _symm_group->size();
+
+  // compiled before the parallel use
+  _symm_group->compile();
+
+  int batch_size = 64;
+#ifdef _OPENMP
+  batch_size *= omp_get_max_threads();
+#endif
+
+  std::vector<std::vector<State> > orbit_pool(batch_size, std::vector<State>(group_size));
+  std::vector<double>              orbit_dist(batch_size);
+  std::vector<int>                 batch_miss(batch_size);
+
   int miss_count = 0;
 
   // vertex best separated from its symmetric images
   double vertex_dist_max = 0.;
   int    vertex_indx_max = -1;
 
-  // random guess
-  State guess;
-  std::vector<State> guess_orbit(_symm_group->size(), guess);
-    
   while(miss_count < _miss_count_max) {
 
-    
-    // linear subspace
-    switch(State::layout.size(0)) {
-    case 0:
-      // do nothing
-      break;
-    case 1:
-      guess[0] = Random::flat() * rmax;
-      break;
-    case 3:
-      Random::spherical_layer(guess.begin(), 3, rmin, rmax);
-      break;
-    default:
-      std::cerr << funame << "unknown linear subspace dimension: " << State::layout.size(0) << "\n";
-      throw Error::Logic();
-    }
+    for(int c = 0; c < batch_size; ++c)
+      _random_guess(orbit_pool[c][0], rmax, rmin);
 
-    // spherical subspaces
-    for(int s = 1;  s < State::layout.size(); ++s)
-      Random::orient(guess.begin() + State::layout.shift(s), State::layout.size(s));
+    const int tree_size = _vertex_tree.size();
 
-    bool miss = false;
+    // check the distances to the existing vertices and to the symmetric images
+    std::exception_ptr error;
 
-    // check the distances to vertices
-#pragma omp parallel for default(shared) schedule(static)	
+#pragma omp parallel for default(shared) schedule(dynamic, 4)
 
-    for(int v = 0;  v < _vertex.size(); ++v)
-      if(!miss && vdistance(guess, _vertex[v]) < dist_min)
-	miss = true;
- 
-    if(miss) {
-      miss_count++;
-      continue;
-    }
+    for(int c = 0; c < batch_size; ++c) {
+      try {
+	std::vector<State>& guess_orbit = orbit_pool[c];
 
-    // generate guess orbit and check the distances to symmetric configurations
-    for(int g = 1; g < _symm_group->size(); ++g) {
+	batch_miss[c] = _vertex_tree.find(guess_orbit[0].begin(), dist_min);
+	if(batch_miss[c])
+	  continue;
 
-      _symm_group->apply(g, guess, guess_orbit[g]);
+	_symm_group->orbit(guess_orbit[0], guess_orbit);
 
-      dtemp = vdistance(guess, guess_orbit[g]);
-      if(dtemp < dist_min) {
-	  miss = true;
-	  break;
+	double dmin = -1.;
+	for(int g = 1; g < group_size; ++g) {
+
+	  const double d = vdistance(guess_orbit[0], guess_orbit[g]);
+	  if(d < dist_min) {
+	    batch_miss[c] = 1;
+	    break;
+	  }
+	  if(g == 1 || d < dmin)
+	    dmin = d;
+	}
+	orbit_dist[c] = dmin;
+      }
+      catch(...) {
+#pragma omp critical(random_init_error)
+	if(!error)
+	  error = std::current_exception();
       }
-      if(g == 1 || dtemp < dmin)
-	dmin = dtemp;
     }
 
-    if(miss) {
-      miss_count++;
-      continue;
-    }
+    if(error)
+      std::rethrow_exception(error);
 
-    if(dmin > vertex_dist_max) {
-      vertex_dist_max  = dmin;
-      vertex_indx_max = _vertex.size();
-    }
+    for(int c = 0; c < batch_size && miss_count < _miss_count_max; ++c) {
+      const std::vector<State>& guess_orbit = orbit_pool[c];
+
+      // vertices accepted earlier in the batch
+      if(batch_miss[c] || _vertex_tree.size() != tree_size && _vertex_tree.find(guess_orbit[0].begin(), dist_min)) {
+	miss_count++;
+	continue;
+      }
+
+      if(orbit_dist[c] > vertex_dist_max) {
+	vertex_dist_max = orbit_dist[c];
+	vertex_indx_max = _vertex.size();
+      }
     
-    // update vertex and vertex orbit arrays and vertex-orbit map;
-    std::vector<int> orbit(_symm_group->size());
-    for(int v = 0; v < _symm_group->size(); ++v) {
-      orbit[v] = _vertex.size();
-      _vertex_orbit_map.push_back(std::make_pair(_vertex_orbit.size(), v));
-      _vertex.push_back(guess_orbit[v]);
-    }
-    // add orbit 
-    _vertex_orbit.push_back(orbit);
+      // update vertex and vertex orbit arrays and vertex-orbit map;
+      std::vector<int> orbit(group_size);
+      for(int v = 0; v < group_size; ++v) {
+	orbit[v] = _vertex.size();
+	_vertex_orbit_map.push_back(std::make_pair(_vertex_orbit.size(), v));
+	_vertex.push_back(guess_orbit[v]);
+	_vertex_tree.insert(guess_orbit[v].begin());
+      }
+      // add orbit 
+      _vertex_orbit.push_back(orbit);
 
-    miss_count = 0;
+      miss_count = 0;
+    }
   }
 
+  IO::log << IO::log_offset << funame << "number of vertices = " << _vertex.size() << "\n";
 }
-
@@ -145,13 +145,35 @@ namespace Configuration {
  ************ ABSTRACT CLASS FOR SYMMETRY OPERATIONS IN THE CONFIGURATIONAL SPACE **********
  *******************************************************************************************/
 
+  // symmetry operations which are linear in the state vector are compiled on first use
+  // into dense matrices; call compile() before using the group from several threads
+
   class GroupBase : public Symmetry::GroupBase {
-    
+    //
+    mutable int                 _dim;    // state vector dimension the matrices were compiled for
+    mutable std::vector<double> _matrix; // symmetry operation matrices, row-major
+    mutable std::vector<int>    _linear; // symmetry operation is compiled
+
+  protected:
+    // symmetry operation is linear in the state vector
+    virtual bool _is_linear (int) const { return true; }
+
   public:
-    GroupBase () {}
-    GroupBase (const std::vector<Permutation>& p) : Symmetry::GroupBase(p) {}
+    GroupBase () : _dim(0) {}
+    GroupBase (const std::vector<Permutation>& p) : Symmetry::GroupBase(p), _dim(0) {}
 
     virtual void apply (int, const State&, State&) const = 0;
+
+    void compile () const ;
+
+    // symmetry operation applied to the array of states stored contiguously
+    void batch (int g, int n, const double* v, double* res) const ;
+
+    // all symmetry images of the state, the state itself being the first one
+    void orbit (const State&, std::vector<State>&) const ;
+
+    // lexicographically smallest symmetry image; returns the symmetry operation index
+    int canonical (const State&, State&) const ;
   };
 
 /*******************************************************************************************
@@ -197,6 +219,9 @@ namespace Configuration {
       EXCHANGE  = 3  // fragment exchange map index
    };
 
+    // the fragment exchange operation is nonlinear in the state vector
+    bool _is_linear (int g) const { return !_identical || !_index_multi_map[g][EXCHANGE]; }
+
   public:
     DoubleSpaceGroup (const std::vector<Symmetry::SpaceGroup>&, int =0) ;
 
@@ -242,6 +267,38 @@ namespace Configuration {
       _Double         data;
     };
 
+    // k-d tree of the vertices for point location; vertex coordinates are
+    // kept in a flat array and node v holds vertex v
+    class _VertexTree {
+      struct _Node {
+	int left, right;
+	_Node () : left(-1), right(-1) {}
+      };
+
+      int                 _dim;
+      std::vector<double> _coord;
+      std::vector<_Node>  _node;
+
+      double _distance (const double*, int) const;
+
+    public:
+      _VertexTree () : _dim(0) {}
+
+      void init (int);
+
+      int size () const { return _node.size(); }
+      const double* vertex (int v) const { return &_coord[v * _dim]; }
+
+      void insert (const double*);
+
+      bool    find (const double*, double)  const; // is there a vertex closer than the given distance
+      int  nearest (const double*, double&) const; // nearest vertex and the distance to it
+    };
+
+    _VertexTree _vertex_tree;
+
+    void _random_guess (State&, double, double) const ;
+
     std::vector<State>       _vertex;
     std::vector<std::vector<int> >    _vertex_orbit;     // symmetry related vertices
     std::vector<std::pair<int, int> > _vertex_orbit_map; // vertex-to-vertex-orbit map
@@ -249,8 +306,6 @@ namespace Configuration {
     std::vector<_Simplex>          _simplex;
     std::vector<std::vector<int> > _simplex_orbit; // symmetry related simplices
 
-    std::map<std::set<int>, double> _vertex_vertex_distance;
-
     std::map<std::set<int>, std::set<int> > _facet_simplex_map;
     
     
@@ -1,6 +1,8 @@
 #include "coord.hh"
 #include "io.hh"
 
+#include <exception>
+
 /******************************************************************************************
  ********** INTERNAL COORDINATE: INTERATOMIC DISTANCE, PLANE, OR DIHEDRAL ANGLES **********
  ******************************************************************************************/
@@ -631,20 +633,189 @@ double Coord::CartFun::step = 1.e-2;
 //
 double Coord::CartFun::grad_length (const Cartesian& x) const
 {
-  double dtemp;
-  
-  int    itemp;
-  
+  const Cartesian g = gradient(x);
+
   double res = 0.;
 
-  for(int i = 0; i < x.size(); ++i) {
+  for(int i = 0; i < g.size(); ++i)
+    //
+    res += g[i] * g[i];
+
+  return std::sqrt(res);
+}
+
+namespace {
+  //
+  // displaced geometry, x[i] += di, x[j] += dj, no second displacement if j < 0
+  //
+  struct Shift {
+    int    i, j;
+    double di, dj;
+
+    Shift (int ii, double d1, int jj = -1, double d2 = 0.) : i(ii), j(jj), di(d1), dj(d2) {}
+  };
+
+  // function values at the displaced geometries
+  //
+  void evaluate_stencil (const Coord::CartFun& f, const Coord::Cartesian& x, const std::vector<Shift>& stencil,
+			 std::vector<double>& res)
+  {
+    res.resize(stencil.size());
+
+    std::exception_ptr error;
+
+#pragma omp parallel for default(shared) schedule(dynamic)
+
+    for(int s = 0; s < stencil.size(); ++s) {
+      //
+      try {
+	//
+	Coord::Cartesian y = x;
+
+	if(stencil[s].i >= 0)
+	  //
+	  y[stencil[s].i] += stencil[s].di;
+
+	if(stencil[s].j >= 0)
+	  //
+	  y[stencil[s].j] += stencil[s].dj;
+
+	res[s] = f.evaluate(y);
+      }
+      catch(...) {
+	//
+#pragma omp critical(cartfun_error)
+
+	if(!error)
+	  //
+	  error = std::current_exception();
+      }
+    }
+
+    if(error)
+      //
+      std::rethrow_exception(error);
+  }
+}
+
+// gradient
+//
+Coord::Cartesian Coord::CartFun::gradient (const Cartesian& x) const
+{
+  std::vector<int> dep;
+
+  for(int i = 0; i < x.size(); ++i)
+    //
+    if(_depend(i))
+      //
+      dep.push_back(i);
+
+  std::vector<Shift> stencil;
+
+  for(int d = 0; d < dep.size(); ++d) {
     //
-    dtemp = grad(x, i);
+    stencil.push_back(Shift(dep[d],  step));
 
-    res += dtemp * dtemp;
+    stencil.push_back(Shift(dep[d], -step));
   }
 
-  return std::sqrt(res);
+  std::vector<double> fval;
+
+  evaluate_stencil(*this, x, stencil, fval);
+
+  Cartesian res(x.size());
+
+  for(int i = 0; i < res.size(); ++i)
+    //
+    res[i] = 0.;
+
+  for(int d = 0; d < dep.size(); ++d) {
+    //
+    double dtemp = fval[2 * d] - fval[2 * d + 1];
+
+    _adjust_dihedral(dtemp);
+
+    res[dep[d]] = dtemp / 2. / step;
+  }
+
+  return res;
+}
+
+// hessian: the diagonal elements share the reference and single displacement values
+//
+Lapack::SymmetricMatrix Coord::CartFun::hessian (const Cartesian& x) const
+{
+  std::vector<int> dep;
+
+  for(int i = 0; i < x.size(); ++i)
+    //
+    if(_depend(i))
+      //
+      dep.push_back(i);
+
+  const int dsize = dep.size();
+
+  std::vector<Shift> stencil;
+
+  // reference
+  //
+  stencil.push_back(Shift(-1, 0.));
+
+  for(int d = 0; d < dsize; ++d) {
+    //
+    stencil.push_back(Shift(dep[d],  step));
+
+    stencil.push_back(Shift(dep[d], -step));
+  }
+
+  for(int d = 0; d < dsize; ++d)
+    //
+    for(int e = d + 1; e < dsize; ++e) {
+      //
+      stencil.push_back(Shift(dep[d],  step, dep[e],  step));
+
+      stencil.push_back(Shift(dep[d], -step, dep[e],  step));
+
+      stencil.push_back(Shift(dep[d], -step, dep[e], -step));
+
+      stencil.push_back(Shift(dep[d],  step, dep[e], -step));
+    }
+
+  std::vector<double> fval;
+
+  evaluate_stencil(*this, x, stencil, fval);
+
+  Lapack::SymmetricMatrix res(x.size());
+
+  res = 0.;
+
+  const double two = step + step;
+
+  double dtemp;
+
+  for(int d = 0; d < dsize; ++d) {
+    //
+    dtemp = fval[1 + 2 * d] + fval[2 + 2 * d] - 2. * fval[0];
+
+    _adjust_dihedral(dtemp);
+
+    res(dep[d], dep[d]) = dtemp / step / step;
+  }
+
+  int s = 1 + 2 * dsize;
+
+  for(int d = 0; d < dsize; ++d)
+    //
+    for(int e = d + 1; e < dsize; ++e, s += 4) {
+      //
+      dtemp = fval[s] - fval[s + 1] + fval[s + 2] - fval[s + 3];
+
+      _adjust_dihedral(dtemp);
+
+      res(dep[d], dep[e]) = dtemp / two / two;
+    }
+
+  return res;
 }
 
 // gradient component
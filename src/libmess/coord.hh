@@ -226,6 +226,13 @@ namespace Coord {
     //
     double hess (const Cartesian&, int, int) const;
     
+    // full gradient and hessian: the finite difference stencil is shared by the components
+    // and evaluated concurrently; the functions with the analytic derivatives override them
+    //
+    virtual Cartesian               gradient (const Cartesian&) const;
+
+    virtual Lapack::SymmetricMatrix hessian  (const Cartesian&) const;
+
     double grad_length (const Cartesian&) const;
     
     static double step;
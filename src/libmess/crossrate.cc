@@ -22,6 +22,9 @@
 #include <iomanip>
 #include <cmath>
 #include <set>
+#include <exception>
+#include <ctime>
+#include <cstdio>
 
 namespace CrossRate {
 
@@ -31,6 +34,22 @@ namespace CrossRate {
   // random potential error flag; opposite assumes that potential error corresponds to large positive potential
   int rand_pot_err_flag = 0;
 
+  // number of threads propagating the facet trajectories
+  int traj_thread_num = 1;
+
+  // facet trajectories propagated in lockstep
+  int traj_batch_size = 1;
+
+  // parallel facet samplings
+  int smp_thread_num = 1;
+  int smp_batch_size = 100;
+
+  // checkpoints
+  std::string checkpoint_file;
+  int         checkpoint_interval = 3600;
+  std::string restart_file;
+  std::string pool_file;
+
   // output
   int         raden_flag;
   std::string raden_file;
@@ -53,6 +72,7 @@ namespace CrossRate {
   double MultiArray::spec_rel_tol;  // species statistical flux relative tolerance
   double MultiArray::reac_rel_tol;  // species    reactive flux relative tolerance
   double MultiArray::tran_rel_tol;  // reactive transition flux relative tolerance
+  double MultiArray::adapt_rel_tol; // species statistical flux relative error of the adaptive allocation
 
   // reactive transition
   std::vector<int> MultiArray::reactive_transition;
@@ -117,7 +137,7 @@ void CrossRate::init (std::istream& from)
     std::map<std::string, Read>::iterator idit;
 
     double trt;
-    std::string calc_mode, job_type;
+    std::string calc_mode, job_type, traj_solver;
     input ["JobType"                    ] = Read(job_type, "dynamical");
     input ["CalculationMode"            ] = Read(calc_mode, "canonical");
     input ["Reactant"                   ] = Read(_reactant, -1);
@@ -133,9 +153,20 @@ void CrossRate::init (std::istream& from)
     input ["SpeciesStatisticalTolerance"] = Read(MultiArray::spec_rel_tol, 0.1);
     input ["SpeciesReactiveTolerance"   ] = Read(MultiArray::reac_rel_tol, 0.1);
     input ["ReactiveTransitionTolerance"] = Read(MultiArray::tran_rel_tol, 0.1);
+    input ["AdaptiveStatisticalTolerance"] = Read(MultiArray::adapt_rel_tol, 0.);
     input ["ReactiveTransition"         ] = Read(MultiArray::reactive_transition, std::vector<int>());
     input ["TrajectRelativeTolerance"   ] = Read(trt, 1.e-5);
     input ["RandomPotentialErrorFlag"   ] = Read(rand_pot_err_flag, 0);
+    input ["TrajectoryThreadNumber"     ] = Read(traj_thread_num, 1);
+    input ["TrajectoryBatchSize"        ] = Read(traj_batch_size, 1);
+    input ["TrajectorySolver"           ] = Read(traj_solver, "adams");
+    input ["TrajectorySplittingStep[au]"] = Read(Trajectory::Propagator::split_step, 10.);
+    input ["SamplingThreadNumber"       ] = Read(smp_thread_num, 1);
+    input ["SamplingBatchSize"          ] = Read(smp_batch_size, 100);
+    input ["CheckpointFile"             ] = Read(checkpoint_file, "");
+    input ["CheckpointInterval[sec]"    ] = Read(checkpoint_interval, 3600);
+    input ["RestartFile"                ] = Read(restart_file, "");
+    input ["SamplingPoolFile"           ] = Read(pool_file, "");
     input ["RadialEnergyFlag"           ] = Read(raden_flag, 0);
     input ["RadialEnergyFile"           ] = Read(raden_file, "raden.out");
     input ["AngularMomentumProjectFlag" ] = Read(amproj_flag, 0);
@@ -203,6 +234,23 @@ void CrossRate::init (std::istream& from)
       throw Error::Init();
     }
 
+    if(traj_solver == "adams")
+      Trajectory::Propagator::solver = Trajectory::Propagator::ADAMS;
+    else if(traj_solver == "runge-kutta")
+      Trajectory::Propagator::solver = Trajectory::Propagator::RUNGE_KUTTA;
+    else if(traj_solver == "splitting")
+      Trajectory::Propagator::solver = Trajectory::Propagator::SPLITTING;
+    else {
+      std::cerr << funame << "unknown trajectory solver: " << traj_solver
+		<< "; possible solvers: adams, runge-kutta, and splitting\n";
+      throw Error::Init();
+    }
+
+    if(traj_batch_size > 1 && Trajectory::Propagator::solver != Trajectory::Propagator::RUNGE_KUTTA) {
+      std::cerr << funame << "TrajectoryBatchSize, " << traj_batch_size << ", needs the runge-kutta trajectory solver\n";
+      throw Error::Init();
+    }
+
     switch(mode()) {
     case T_MODE:
       if(temperature() <= 0.) {
@@ -287,16 +335,18 @@ void CrossRate::init (std::istream& from)
 
 
 CrossRate::DynSmp::DynSmp (Potential::Wrap pot, const DivSur::MultiSur& surface, int prim, const Dynamic::Coordinates& dc)
-  : Dynamic::Vars(dc)
+  : DynSmp(pot, surface, prim, dc, pot(dc))
+{}
+
+CrossRate::DynSmp::DynSmp (Potential::Wrap pot, const DivSur::MultiSur& surface, int prim, const Dynamic::Coordinates& dc,
+			   double ener)
+  : Dynamic::Vars(dc), _energy(ener)
 {
   const char funame [] = "CrossRate::DynSmp::DynSmp: ";
   
   static const double max_exp = 100.;
 
   double dtemp;
-
-  // potential energy
-  _energy = pot(dc);
   
   // random variable
   _ranval = Random::flat();
@@ -335,24 +385,10 @@ CrossRate::DynSmp::DynSmp (Potential::Wrap pot, const DivSur::MultiSur& surface,
   forw.init(new DynRes(pot, *this,  FORWARD));
 }
 
-// propagate trajectory both forward and backward
-void CrossRate::DynSmp::run_traj (const DivSur::MultiSur& ms, const DivSur::face_t& face, Dynamic::CCP stop)
+// trajectory tolerances: the absolute tolerances of the velocities are scaled
+// with the kinetic energy in the microcanonical case
+void CrossRate::DynSmp::set_traj_tol ()
 {
-  const char funame [] = "CrossRate::DynSmp::run_traj: ";
-
-  if(!isinit()) {
-    std::cerr << funame << "crossrate environment has not yet been initialized\n";
-    throw Error::Init();
-  }
-
-  if(is_run()) {
-    std::cerr << funame << "trajectory has been run already\n";
-    throw Error::Init();
-  }
-
-  if(reactant() >= 0 && face.first != reactant() && face.second != reactant())
-    return;
-
   int    itemp;
   double dtemp;
 
@@ -375,6 +411,27 @@ void CrossRate::DynSmp::run_traj (const DivSur::MultiSur& ms, const DivSur::face
 	forw->abs_tol[itemp] *= dtemp / Structure::fragment(frag).imom_sqrt(i);
       }
   }
+}
+
+// propagate trajectory both forward and backward
+void CrossRate::DynSmp::run_traj (const DivSur::MultiSur& ms, const DivSur::face_t& face, Dynamic::CCP stop)
+{
+  const char funame [] = "CrossRate::DynSmp::run_traj: ";
+
+  if(!isinit()) {
+    std::cerr << funame << "crossrate environment has not yet been initialized\n";
+    throw Error::Init();
+  }
+
+  if(is_run()) {
+    std::cerr << funame << "trajectory has been run already\n";
+    throw Error::Init();
+  }
+
+  if(reactant() >= 0 && face.first != reactant() && face.second != reactant())
+    return;
+
+  set_traj_tol();
 
   if(reactant() >= 0) {
     if(reactant() == face.first){
@@ -545,6 +602,129 @@ void CrossRate::DynSmp::run_traj (const DivSur::MultiSur& ms, const DivSur::face
     }
 }
 
+// the stages of the single sampling run are kept: the trajectories of every stage are
+// propagated in one batch, and the samplings which are done drop out of the next stages
+void CrossRate::DynSmp::run_traj (const std::vector<DynSmp*>& smp, const DivSur::MultiSur& ms, const DivSur::face_t& face, 
+				  Dynamic::CCP stop)
+{
+  const char funame [] = "CrossRate::DynSmp::run_traj: ";
+
+  if(!isinit()) {
+    std::cerr << funame << "crossrate environment has not yet been initialized\n";
+    throw Error::Init();
+  }
+
+  for(int i = 0; i < smp.size(); ++i)
+    if(smp[i]->is_run()) {
+      std::cerr << funame << i << "-th trajectory has been run already\n";
+      throw Error::Init();
+    }
+
+  if(reactant() >= 0 && face.first != reactant() && face.second != reactant())
+    return;
+
+  for(int i = 0; i < smp.size(); ++i)
+    smp[i]->set_traj_tol();
+
+  // propagates the trajectories to the stop condition: the failed ones get the status,
+  // and the successful ones are flagged
+  auto propagate = [&ms] (const std::vector<DynRes*>& dr, Dynamic::CCP cond, std::vector<int>& ok) {
+    std::vector<Trajectory::Propagator*> prop(dr.begin(), dr.end());
+    std::vector<Dynamic::CCP>            stop(dr.size(), cond);
+    std::vector<int>                     outcome;
+
+    Trajectory::Propagator::run(prop, stop, ms, outcome);
+
+    ok.resize(dr.size());
+    for(int i = 0; i < dr.size(); ++i) {
+      ok[i] = 0;
+      switch(outcome[i]) {
+      case Trajectory::Propagator::DONE:
+	ok[i] = 1;
+	break;
+      case Trajectory::Propagator::POT_FAIL:
+	dr[i]->stat = DynRes::POT_FAIL;
+	break;
+      case Trajectory::Propagator::RUN_FAIL:
+	dr[i]->stat = DynRes::RUN_FAIL;
+	break;
+      case Trajectory::Propagator::EXCLUDE:
+	dr[i]->stat = DynRes::EXCLUDE;
+	break;
+      }
+    }
+  };
+
+  std::vector<DynSmp*> work, next;
+  std::vector<DynRes*> dr;
+  std::vector<int>     ok;
+
+  if(reactant() >= 0) {
+    // the trajectory toward the reactant first, then the one away from it
+    const bool back_first = reactant() == face.first;
+
+    for(int i = 0; i < smp.size(); ++i)
+      dr.push_back(back_first ? smp[i]->back : smp[i]->forw);
+
+    propagate(dr, stop | Dynamic::negate(Dynamic::CCP(new SpecCondition(ms, reactant()))), ok);
+
+    for(int i = 0; i < smp.size(); ++i)
+      if(ok[i]) {
+	if(dr[i]->species() == reactant()) {
+	  dr[i]->stat = DynRes::DIRECT;
+	  work.push_back(smp[i]);
+	}
+	else
+	  dr[i]->stat = DynRes::RECROSS;
+      }
+
+    dr.clear();
+    for(int i = 0; i < work.size(); ++i)
+      dr.push_back(back_first ? work[i]->forw : work[i]->back);
+
+    propagate(dr, stop, ok);
+
+    for(int i = 0; i < work.size(); ++i)
+      if(ok[i])
+	dr[i]->stat = DynRes::PASS;
+
+    return;
+  }// reactant
+
+  // backward trajectories
+  for(int i = 0; i < smp.size(); ++i)
+    dr.push_back(smp[i]->back);
+
+  propagate(dr, stop | Dynamic::negate(Dynamic::CCP(new SpecCondition(ms, face.first))), ok);
+
+  for(int i = 0; i < smp.size(); ++i)
+    if(ok[i]) {
+      dr[i]->stat = dr[i]->species() == face.first ? DynRes::DIRECT : DynRes::RECROSS;
+      work.push_back(smp[i]);
+    }
+
+  // forward trajectories
+  dr.clear();
+  for(int i = 0; i < work.size(); ++i)
+    dr.push_back(work[i]->forw);
+
+  propagate(dr, stop | Dynamic::negate(Dynamic::CCP(new SpecCondition(ms, face.second))), ok);
+
+  for(int i = 0; i < work.size(); ++i)
+    if(ok[i]) {
+      dr[i]->stat = dr[i]->species() == face.second ? DynRes::DIRECT : DynRes::RECROSS;
+      next.push_back(work[i]);
+    }
+
+  // the recrossed trajectory is run to the end, if the other one is not recrossed
+  dr.clear();
+  for(int i = 0; i < next.size(); ++i)
+    if(next[i]->forw->stat != next[i]->back->stat)
+      dr.push_back(next[i]->back->stat == DynRes::RECROSS ? next[i]->back : next[i]->forw);
+
+  propagate(dr, stop, ok);
+}
+
 /************************************************************************
  *               Facet sampling data methods: FacetArray                *
  ************************************************************************/
@@ -663,6 +843,18 @@ void CrossRate::FacetArray::run_traj (const DivSur::MultiSur& ms, const DivSur::
   if(!new_traj_num)
     return;
 
+  if(traj_batch_size > 1) {
+    _run_traj_batch(ms, face, stop, new_traj_num);
+    _check_traj(face);
+    return;
+  }
+
+  if(traj_thread_num > 1) {
+    _run_traj_threads(ms, face, stop, new_traj_num);
+    _check_traj(face);
+    return;
+  }
+
 #ifndef DEBUG
 
   int new_share, old_share = 0;
@@ -732,6 +924,13 @@ void CrossRate::FacetArray::run_traj (const DivSur::MultiSur& ms, const DivSur::
 
   //IO::log << "\n";
 
+  _check_traj(face);
+}
+
+void CrossRate::FacetArray::_check_traj (const DivSur::face_t& face) const
+{
+  const char funame [] = "CrossRate::FacetArray::_check_traj: ";
+
   // checking
   for(const_iterator fit = begin(); fit != end(); ++fit) { // sampling cycle
     if(fit->is_run_fail() || fit->is_pot_fail() || fit->is_exclude() || !fit->is_run())
@@ -747,12 +946,115 @@ void CrossRate::FacetArray::run_traj (const DivSur::MultiSur& ms, const DivSur::
   }// sampling cycle
 }
 
+// the trajectories are independent: each sampling keeps its own propagators,
+// and the statistics is collected afterwards in the samplings order
+void CrossRate::FacetArray::_run_traj_threads (const DivSur::MultiSur& ms, const DivSur::face_t& face, Dynamic::CCP stop, int new_traj_num)
+{
+  std::vector<iterator> work;
+  for(iterator fit = begin(); fit != end(); ++fit)
+    if(!fit->is_run())
+      work.push_back(fit);
+
+  std::exception_ptr error;
+
+  int new_share, old_share = 0;
+
+  int count = 0;
+
+#pragma omp parallel for default(shared) private(new_share) schedule(dynamic) num_threads(traj_thread_num)
+
+  for(int i = 0; i < work.size(); ++i) {
+    try {
+      work[i]->run_traj(ms, face, stop);
+    }
+    catch(...) {
+#pragma omp critical(traj_error)
+
+      if(!error)
+	error = std::current_exception();
+    }
+
+#pragma omp critical(traj_progress)
+    {
+      ++count;
+      new_share =(int)((double)count / (double)new_traj_num * 100.);
+      print_progress(old_share, new_share);
+    }
+  }
+
+  if(error)
+    std::rethrow_exception(error);
+}
+
+// the samplings are split into the batches of the trajectory batch size, and
+// the batches are propagated on the host by the trajectory threads
+void CrossRate::FacetArray::_run_traj_batch (const DivSur::MultiSur& ms, const DivSur::face_t& face, Dynamic::CCP stop, int new_traj_num)
+{
+  std::vector<DynSmp*> work;
+  for(iterator fit = begin(); fit != end(); ++fit)
+    if(!fit->is_run())
+      work.push_back(&*fit);
+
+  const int batch_num = (work.size() + traj_batch_size - 1) / traj_batch_size;
+
+  std::exception_ptr error;
+
+  int new_share, old_share = 0;
+
+  int count = 0;
+
+#pragma omp parallel for default(shared) private(new_share) schedule(dynamic) num_threads(traj_thread_num)
+
+  for(int b = 0; b < batch_num; ++b) {
+    const int b0 = b * traj_batch_size;
+    const int b1 = b0 + traj_batch_size < work.size() ? b0 + traj_batch_size : work.size();
+
+    std::vector<DynSmp*> batch(work.begin() + b0, work.begin() + b1);
+
+    try {
+      DynSmp::run_traj(batch, ms, face, stop);
+    }
+    catch(...) {
+#pragma omp critical(traj_error)
+
+      if(!error)
+	error = std::current_exception();
+    }
+
+#pragma omp critical(traj_progress)
+    {
+      count += batch.size();
+      new_share =(int)((double)count / (double)new_traj_num * 100.);
+      print_progress(old_share, new_share);
+    }
+  }
+
+  if(error)
+    std::rethrow_exception(error);
+}
+
 bool CrossRate::FacetArray::add_smp (Potential::Wrap pot, const DivSur::MultiSur& surface, int prim, const Dynamic::Coordinates& dc)
+{
+  double ener;
+
+  try {
+    ener = pot(dc);
+  }
+  catch(Error::General) {
+    ++_fail_num;
+    return false;
+  }
+
+  return add_smp(pot, surface, prim, dc, ener);
+}
+
+bool CrossRate::FacetArray::add_smp (Potential::Wrap pot, const DivSur::MultiSur& surface, int prim, const Dynamic::Coordinates& dc,
+				     double ener)
 {
   const char funame [] = "CrossRate::FacetArray::add_smp: ";
 
   try {
-    DynSmp smp(pot, surface, prim, dc);
+    DynSmp smp(pot, surface, prim, dc, ener);
 
     // update minimal energy
     if(!flux_num() || smp.potential_energy() < _min_ener) {
@@ -912,6 +1214,7 @@ void CrossRate::MultiArray::run_traj (Dynamic::CCP stop)
       if(sit->second.init_traj_num()) {// facet cycle
 	IO::log <<  "      " << sit->first << " facet:\n";
 	sit->second.run_traj(_ms, sit->first, stop);
+	_checkpoint();
       }// facet cycle
   }// primitives cycle
 }
@@ -924,12 +1227,17 @@ int CrossRate::MultiArray::_sample (iterator mit, const std::set<DivSur::face_t
   static int  imp_warn = 1;
   static int samp_warn = 1;
 
+  _checkpoint();
+
+  if(smp_thread_num > 1 && smp_batch_size > 1)
+    return _sample_batch(mit, face_work);
+
   Dynamic::Coordinates new_conf;
   SurArray::iterator sit;
 
   const int sur = mit - begin();
 
-  _ms.random_orient(sur, new_conf);
+  const int rec = _draw(sur, new_conf);
   DivSur::MultiSur::SmpRes smp_res = _ms.facet_test(sur, new_conf);
 
   switch(smp_res.stat) {
@@ -956,7 +1264,7 @@ int CrossRate::MultiArray::_sample (iterator mit, const std::set<DivSur::face_t
     // new facet
     if(sit == mit->end() || !sit->second.face_num()) {
       IO::log << "      " << sur << "-th surface: new " << smp_res.face << " facet\n";
-      (*mit)[smp_res.face].add_smp(_pot, _ms, sur, new_conf);
+      _add_smp((*mit)[smp_res.face], sur, new_conf, rec);
       return 1;
     }
 
@@ -979,7 +1287,7 @@ int CrossRate::MultiArray::_sample (iterator mit, const std::set<DivSur::face_t
       sit->second.add_fake();
     // add facet samping
     else
-      sit->second.add_smp(_pot, _ms, sur, new_conf);
+      _add_smp(sit->second, sur, new_conf, rec);
 
     return 0;
   default:
@@ -988,88 +1296,300 @@ int CrossRate::MultiArray::_sample (iterator mit, const std::set<DivSur::face_t
   }
 }
 
-void CrossRate::MultiArray::_get_stat_flux(std::vector<double>& flux_mean, 
-					   std::vector<double>& flux_rmsd, 
-					   std::vector<double>& flux_variance) const
+// the configurations are drawn and classified serially, their potential energies are
+// calculated in parallel, and the samplings are added in the order they were drawn, 
+// so that the results do not depend on the number of threads
+int CrossRate::MultiArray::_sample_batch (iterator mit, const std::set<DivSur::face_t >& face_work)
 {
-  flux_mean.clear();
-  flux_mean.resize(_ms.species_size());
-  flux_rmsd.clear();
-  flux_rmsd.resize(_ms.species_size());
-  flux_variance.clear();
-  flux_variance.resize(_ms.species_size());
-
-  double face_flux, face_rmsd, face_var;
-  for(const_iterator mit = begin(); mit != end(); ++mit) {// surface cycle
-    for(SurArray::const_iterator sit = mit->begin(); sit != mit->end(); ++sit) {// facet cycle
-      if(reactant() >= 0 && reactant() != sit->first.first && reactant() != sit->first.second)
-	continue;
+  const char funame [] = "CrossRate::MultiArray::_sample_batch: ";
 
-      if(sit->second.size()) {
-	face_flux = mit->face_flux(sit);
-	face_rmsd = mit->vol_frac(sit) * std::sqrt(sit->second.flux_var());
-	face_var  = face_flux * face_flux * (sit->second.flux_rel_var() + mit->vol_rel_var(sit));
-
-	if(reactant() >= 0) {
-	  flux_mean[reactant()]      += face_flux;
-	  flux_rmsd[reactant()]      += face_rmsd;
-	  flux_variance[reactant()]  += face_var;
-	}
-	else {
-	  flux_mean[sit->first.first]      += face_flux;
-	  flux_rmsd[sit->first.first]      += face_rmsd;
-	  flux_variance[sit->first.first]  += face_var;
+  static int  imp_warn = 1;
+  static int samp_warn = 1;
 
-	  flux_mean[sit->first.second]      += face_flux;
-	  flux_rmsd[sit->first.second]      += face_rmsd;
-	  flux_variance[sit->first.second]  += face_var;
-	}
-      } 
-    }// facet cycle
-  }// surface cycle
-}
+  Dynamic::Coordinates new_conf;
+  SurArray::iterator sit;
 
-void CrossRate::MultiArray::_get_reac_flux (std::map<DivSur::face_t, double>& flux_mean, 
-					    std::map<DivSur::face_t, double>& flux_rmsd, 
-					    std::map<DivSur::face_t, double>& flux_variance) const
-{
-  const char funame [] = "CrossRate::MultiArray::_get_reac_flux: ";
+  const int sur = mit - begin();
 
-  flux_mean.clear();
-  flux_rmsd.clear();
-  flux_variance.clear();
+  // configurations which need the potential energy calculation
+  std::vector<Dynamic::Coordinates> conf;
+  std::vector<DivSur::face_t>       conf_face;
+  std::vector<int>                  conf_rec;
 
-  double dtemp;
+  int res = 0;
+  for(int smp = 0; !res && smp < smp_batch_size; ++smp) {// sampling cycle
+    const int rec = _draw(sur, new_conf);
+    DivSur::MultiSur::SmpRes smp_res = _ms.facet_test(sur, new_conf);
 
-  for(const_iterator mit = begin(); mit != end(); ++mit) {// surface cycle
-    for(SurArray::const_iterator sit = mit->begin(); sit != mit->end(); ++sit)// facet cycle
-      if(sit->second.run_traj_num()) {
-	double face_flux = mit->face_flux(sit);
-	for (int ward = 0; ward < 2; ++ward) {// ward cycle
-	  int react;
-	  switch(ward) {
-	  case BACKWARD:
-	    react = sit->first.second;
-	    break;
-	  case FORWARD:
-	    react = sit->first.first;
-	    break;
-	  }
-	  if(reactant() >= 0 && react != reactant())
-	    continue;
+    switch(smp_res.stat) {
+    case DivSur::MultiSur::SmpRes::CLOSE:
+      mit->add_close();
+      break;
+    case DivSur::MultiSur::SmpRes::EXCLUDE:
+      mit->add_excl();
+      break;
+    case DivSur::MultiSur::SmpRes::INNER:
+      mit->add_inner();
+      break;
+    case DivSur::MultiSur::SmpRes::FAIL:
+      mit->add_fail();
+      break;
+    case DivSur::MultiSur::SmpRes::FACET:
+      // skip non-reactant facets
+      if(reactant() >= 0 && smp_res.face.first != reactant() && smp_res.face.second != reactant()) {
+	mit->add_skip();
+	break;
+      }
 
-	  for(int spec = 0; spec < _ms.species_size(); ++spec) {//product cycle
-	    if(spec != react && sit->second.reac_traj_num(ward, spec)) {
-	      // dynamical correction factor
-	      double dyn_fac = (double)sit->second.reac_traj_num(ward, spec) / (double)sit->second.run_traj_num();
-	      double dyn_var = dyn_fac * (1. - dyn_fac);
+      sit = mit->find(smp_res.face);
+      // new facet
+      if(sit == mit->end() || !sit->second.face_num()) {
+	conf.push_back(new_conf);
+	conf_face.push_back(smp_res.face);
+	conf_rec.push_back(rec);
+	res = 1;
+	break;
+      }
 
-	      DivSur::face_t tran(react, spec);
+      // maximum facet sampling number warning
+      if(samp_warn && sit->second.samp_num() >= max_pot_size) {
+	std::cerr << funame << sur << "-th surface, " << sit->first << " facet: "
+		  << "WARNING: maximal facet samplings number has been reached\n";
+	samp_warn = 0;
+      } 
 
-	      // reactive flux
-	      flux_mean[tran] += dyn_fac * face_flux;
+      // maximum importance sampling number warning
+      if(imp_warn && sit->second.size() >= max_imp_size) {
+	std::cerr << funame << sur << "-th surface, " << sit->first << " facet: "
+		  << "WARNING: maximal importance samplings number has been reached\n";
+	imp_warn = 0;
+      } 
 
-	      // reactive flux standard deviation
+      // no potential calculation is needed
+      if(face_work.find(smp_res.face) == face_work.end())
+	sit->second.add_fake();
+      else {
+	conf.push_back(new_conf);
+	conf_face.push_back(smp_res.face);
+	conf_rec.push_back(rec);
+      }
+      break;
+    default:
+      std::cerr << funame << "wrong case\n";
+      throw Error::Logic();
+    }
+  }// sampling cycle
+
+  // potential energies
+  std::vector<double> ener(conf.size());
+  std::vector<int>    fail(conf.size(), 0);
+
+  // pooled potential energies
+  std::vector<int> known(conf.size(), 0);
+  for(int i = 0; i < conf.size(); ++i)
+    if(conf_rec[i] >= 0) {
+      const _PoolRec& pr = _pool[_pool_sig[sur]][conf_rec[i]];
+      if(pr.stat == _PoolRec::POT) {
+	ener[i]  = pr.ener;
+	known[i] = 1;
+	++_pool_reuse;
+      }
+      else if(pr.stat == _PoolRec::FAIL) {
+	fail[i]  = 1;
+	known[i] = 1;
+      }
+    }
+
+  std::exception_ptr error;
+
+#pragma omp parallel for default(shared) schedule(dynamic) num_threads(smp_thread_num)
+
+  for(int i = 0; i < conf.size(); ++i) {
+    if(known[i])
+      continue;
+    try {
+      ener[i] = _pot(conf[i]);
+    }
+    catch(Error::General) {
+      fail[i] = 1;
+    }
+    catch(...) {
+#pragma omp critical(smp_error)
+
+      if(!error)
+	error = std::current_exception();
+    }
+  }
+
+  if(error)
+    std::rethrow_exception(error);
+
+  for(int i = 0; i < conf.size(); ++i)
+    if(conf_rec[i] >= 0 && !known[i]) {
+      _PoolRec& pr = _pool[_pool_sig[sur]][conf_rec[i]];
+      pr.stat = fail[i] ? _PoolRec::FAIL : _PoolRec::POT;
+      pr.ener = ener[i];
+    }
+
+  // add facet samplings
+  for(int i = 0; i < conf.size(); ++i) {
+    if(res && i == conf.size() - 1)
+      IO::log << "      " << sur << "-th surface: new " << conf_face[i] << " facet\n";
+
+    FacetArray& facet = (*mit)[conf_face[i]];
+
+    if(fail[i])
+      facet.add_pot_fail();
+    else
+      facet.add_smp(_pot, _ms, sur, conf[i], ener[i]);
+  }
+
+  return res;
+}
+
+int CrossRate::MultiArray::_draw (int sur, Dynamic::Coordinates& dc)
+{
+  if(!pool_file.size()) {
+    _ms.random_orient(sur, dc);
+    return -1;
+  }
+
+  std::vector<_PoolRec>& pool = _pool[_pool_sig[sur]];
+
+  const int res = _pool_next[sur]++;
+
+  // pooled configuration
+  if(res < pool.size()) {
+    dc.get(&pool[res].pos[0]);
+    return res;
+  }
+
+  // new configuration
+  _ms.random_orient(sur, dc);
+
+  _PoolRec pr;
+  pr.pos.resize(Dynamic::Coordinates::size());
+  dc.put(&pr.pos[0]);
+  pr.stat = _PoolRec::NOPOT;
+  pr.ener = 0.;
+  pool.push_back(pr);
+
+  return res;
+}
+
+void CrossRate::MultiArray::_add_smp (FacetArray& facet, int sur, const Dynamic::Coordinates& dc, int rec)
+{
+  if(rec < 0) {
+    facet.add_smp(_pot, _ms, sur, dc);
+    return;
+  }
+
+  _PoolRec& pr = _pool[_pool_sig[sur]][rec];
+
+  switch(pr.stat) {
+  case _PoolRec::POT:
+    ++_pool_reuse;
+    facet.add_smp(_pot, _ms, sur, dc, pr.ener);
+    return;
+  case _PoolRec::FAIL:
+    facet.add_pot_fail();
+    return;
+  default:
+    try {
+      pr.ener = _pot(dc);
+    }
+    catch(Error::General) {
+      pr.stat = _PoolRec::FAIL;
+      facet.add_pot_fail();
+      return;
+    }
+    pr.stat = _PoolRec::POT;
+    facet.add_smp(_pot, _ms, sur, dc, pr.ener);
+  }
+}
+
+void CrossRate::MultiArray::_get_stat_flux(std::vector<double>& flux_mean, 
+					   std::vector<double>& flux_rmsd, 
+					   std::vector<double>& flux_variance) const
+{
+  flux_mean.clear();
+  flux_mean.resize(_ms.species_size());
+  flux_rmsd.clear();
+  flux_rmsd.resize(_ms.species_size());
+  flux_variance.clear();
+  flux_variance.resize(_ms.species_size());
+
+  double face_flux, face_rmsd, face_var;
+  for(const_iterator mit = begin(); mit != end(); ++mit) {// surface cycle
+    for(SurArray::const_iterator sit = mit->begin(); sit != mit->end(); ++sit) {// facet cycle
+      if(reactant() >= 0 && reactant() != sit->first.first && reactant() != sit->first.second)
+	continue;
+
+      if(sit->second.size()) {
+	face_flux = mit->face_flux(sit);
+	face_rmsd = mit->vol_frac(sit) * std::sqrt(sit->second.flux_var());
+	face_var  = face_flux * face_flux * (sit->second.flux_rel_var() + mit->vol_rel_var(sit));
+
+	if(reactant() >= 0) {
+	  flux_mean[reactant()]      += face_flux;
+	  flux_rmsd[reactant()]      += face_rmsd;
+	  flux_variance[reactant()]  += face_var;
+	}
+	else {
+	  flux_mean[sit->first.first]      += face_flux;
+	  flux_rmsd[sit->first.first]      += face_rmsd;
+	  flux_variance[sit->first.first]  += face_var;
+
+	  flux_mean[sit->first.second]      += face_flux;
+	  flux_rmsd[sit->first.second]      += face_rmsd;
+	  flux_variance[sit->first.second]  += face_var;
+	}
+      } 
+    }// facet cycle
+  }// surface cycle
+}
+
+void CrossRate::MultiArray::_get_reac_flux (std::map<DivSur::face_t, double>& flux_mean, 
+					    std::map<DivSur::face_t, double>& flux_rmsd, 
+					    std::map<DivSur::face_t, double>& flux_variance) const
+{
+  const char funame [] = "CrossRate::MultiArray::_get_reac_flux: ";
+
+  flux_mean.clear();
+  flux_rmsd.clear();
+  flux_variance.clear();
+
+  double dtemp;
+
+  for(const_iterator mit = begin(); mit != end(); ++mit) {// surface cycle
+    for(SurArray::const_iterator sit = mit->begin(); sit != mit->end(); ++sit)// facet cycle
+      if(sit->second.run_traj_num()) {
+	double face_flux = mit->face_flux(sit);
+	for (int ward = 0; ward < 2; ++ward) {// ward cycle
+	  int react;
+	  switch(ward) {
+	  case BACKWARD:
+	    react = sit->first.second;
+	    break;
+	  case FORWARD:
+	    react = sit->first.first;
+	    break;
+	  }
+	  if(reactant() >= 0 && react != reactant())
+	    continue;
+
+	  for(int spec = 0; spec < _ms.species_size(); ++spec) {//product cycle
+	    if(spec != react && sit->second.reac_traj_num(ward, spec)) {
+	      // dynamical correction factor
+	      double dyn_fac = (double)sit->second.reac_traj_num(ward, spec) / (double)sit->second.run_traj_num();
+	      double dyn_var = dyn_fac * (1. - dyn_fac);
+
+	      DivSur::face_t tran(react, spec);
+
+	      // reactive flux
+	      flux_mean[tran] += dyn_fac * face_flux;
+
+	      // reactive flux standard deviation
 	      flux_rmsd[tran] += std::sqrt(dyn_var) * face_flux;
 
 	      // reactive flux variance
@@ -1630,6 +2150,153 @@ void CrossRate::print_progress (int& old_share, int new_share)
   }
 }
 
+// sequential allocation of the flux samplings: each round goes to the facets whose
+// next samplings reduce the species statistical flux relative variances the most,
+// until the largest species relative error is below the tolerance; the volume
+// fraction variance is reduced by the surface samplings themselves
+bool CrossRate::MultiArray::_adaptive_sampling ()
+{
+  const char funame [] = "CrossRate::MultiArray::_adaptive_sampling: ";
+
+  static const double work_share = 0.5; // facets within this share of the best gain are sampled
+
+  double dtemp;
+  SurArray::iterator sit;
+
+  IO::log << "Adaptive sampling to satisfy species statistical flux relative tolerance (flux samplings counted) ...\n"
+	  << std::setw(10) << "Round"
+	  << std::setw(15) << "Samplings"
+	  << std::setw(15) << "Facets"
+	  << std::setw(15) << "MaxRelErr"
+	  << std::setw(15) << "Tolerance"
+	  << "\n";
+
+  for(int round = 0;; ++round) {// round cycle
+    std::vector<double> flux_mean, flux_rmsd, flux_var;
+    _get_stat_flux(flux_mean, flux_rmsd, flux_var);
+
+    double err_max = 0.;
+    for(int s = 0; s < flux_mean.size(); ++s)
+      if(flux_mean[s] > 0. && (dtemp = std::sqrt(flux_var[s]) / flux_mean[s]) > err_max)
+	err_max = dtemp;
+
+    // expected species relative variance reduction per facet flux sampling
+    std::vector<std::map<DivSur::face_t, double> > gain(size());
+    double gain_max = 0.;
+    int samp_tot = 0;
+    for(iterator mit = begin(); mit != end(); ++mit)
+      for(sit = mit->begin(); sit != mit->end(); ++sit) {
+	samp_tot += sit->second.samp_num();
+
+	if(reactant() >= 0 && reactant() != sit->first.first && reactant() != sit->first.second)
+	  continue;
+
+	if(!sit->second.size() || sit->second.samp_num() >= max_pot_size)
+	  continue;
+
+	const double face_flux = mit->face_flux(sit);
+	const double face_var  = face_flux * face_flux * sit->second.flux_rel_var();
+
+	dtemp = 0.;
+	for(int ward = 0; ward < 2; ++ward) {
+	  const int react = ward == FORWARD ? sit->first.first : sit->first.second;
+	  if(reactant() >= 0 && reactant() != react)
+	    continue;
+	  if(flux_mean[react] > 0.)
+	    dtemp += face_var / flux_mean[react] / flux_mean[react];
+	}
+	dtemp /= (double)sit->second.samp_num();
+
+	if(dtemp > 0.) {
+	  gain[mit - begin()][sit->first] = dtemp;
+	  if(dtemp > gain_max)
+	    gain_max = dtemp;
+	}
+      }
+
+    IO::log << std::setw(10) << round
+	    << std::setw(15) << samp_tot;
+
+    // exit conditions
+    if(err_max <= adapt_rel_tol) {
+      IO::log << std::setw(15) << 0
+	      << std::setw(15) << err_max
+	      << std::setw(15) << adapt_rel_tol
+	      << "\n";
+      break;
+    }
+
+    if(gain_max == 0.) {
+      IO::log << "\n";
+      std::cerr << funame << "WARNING: relative error " << err_max << " is above the tolerance, "
+		<< "but no facet can be sampled further: maximal facet samplings number has been reached\n";
+      break;
+    }
+
+    // the round size grows with the samplings made, so that the rounds number is logarithmic
+    const int round_size = min_pot_size > samp_tot / 10 ? min_pot_size : samp_tot / 10;
+
+    int face_num = 0;
+    for(iterator mit = begin(); mit != end(); ++mit) {// surface cycle
+      std::set<DivSur::face_t> face_work;
+      for(std::map<DivSur::face_t, double>::const_iterator git = gain[mit - begin()].begin();
+	  git != gain[mit - begin()].end(); ++git)
+	if(git->second >= work_share * gain_max)
+	  face_work.insert(git->first);
+
+      if(!face_work.size())
+	continue;
+
+      face_num += face_work.size();
+
+      // this surface share of the round, in proportion to its facets gains
+      double surf_gain = 0., tot_gain = 0.;
+      for(int m = 0; m < size(); ++m)
+	for(std::map<DivSur::face_t, double>::const_iterator git = gain[m].begin(); git != gain[m].end(); ++git)
+	  if(git->second >= work_share * gain_max) {
+	    tot_gain += git->second;
+	    if(m == mit - begin())
+	      surf_gain += git->second;
+	  }
+
+      const int count_max = (int)std::ceil((double)round_size * surf_gain / tot_gain);
+
+      int count = 0;
+      while(count < count_max) {// sampling loop
+	std::set<DivSur::face_t> face_left;
+	int old_num = 0;
+	for(std::set<DivSur::face_t>::const_iterator fit = face_work.begin(); fit != face_work.end(); ++fit) {
+	  sit = mit->find(*fit);
+	  old_num += sit->second.samp_num();
+	  if(sit->second.samp_num() < max_pot_size)
+	    face_left.insert(*fit);
+	}
+
+	if(!face_left.size())
+	  break;
+
+	if(_sample(mit, face_left)) {
+	  IO::log << "\n";
+	  return false;
+	}
+
+	for(std::set<DivSur::face_t>::const_iterator fit = face_left.begin(); fit != face_left.end(); ++fit)
+	  old_num -= mit->find(*fit)->second.samp_num();
+
+	count -= old_num;
+      }// sampling loop
+    }// surface cycle
+
+    IO::log << std::setw(15) << face_num
+	    << std::setw(15) << err_max
+	    << std::setw(15) << adapt_rel_tol
+	    << "\n";
+  }// round cycle
+  IO::log << "done\n\n";
+
+  return true;
+}
+
 bool CrossRate::MultiArray::_work (Dynamic::CCP stop) 
 {
   const char funame [] = "CrossRate::MultiArray::_work: ";
@@ -1691,163 +2358,175 @@ bool CrossRate::MultiArray::_work (Dynamic::CCP stop)
   IO::log << "done\n\n";
 
   /**********************************************************************
-   ********** SATISFY FACET STATISTICAL FLUX RELATIVE TOLERANCE *********
+   ********* ADAPTIVE ALLOCATION OF THE FACET FLUX SAMPLINGS ************
    *********************************************************************/
 
-  IO::log << "Sampling to satisfy facet statistical flux relative tolerance (flux samplings counted) ...\n";
-  for(iterator mit = begin(); mit != end(); ++mit) {// primitive cycle
-    proj_samp_num.clear();
+  if(adapt_rel_tol > 0.) {
+    if(!_adaptive_sampling())
+      return false;
+  }
+  else {
 
-    for(sit = mit->begin(); sit != mit->end(); ++sit) {
-      dtemp = face_rel_tol * sit->second.flux_val();
-      if(dtemp != 0.)
-	proj_samp_num[sit->first] = int(sit->second.flux_var() / dtemp / dtemp);
-    }
+    /**********************************************************************
+     ********** SATISFY FACET STATISTICAL FLUX RELATIVE TOLERANCE *********
+     *********************************************************************/
 
-    if(proj_samp_num.size()) {
-      IO::log << "   " << mit - begin() << "-th surface:\n"
-	      << std::setw(15) << "Facet" 
-	      << std::setw(15) << "Projected" 
-	      << std::setw(15) << "Current"  
-	      << "\n";
+    IO::log << "Sampling to satisfy facet statistical flux relative tolerance (flux samplings counted) ...\n";
+    for(iterator mit = begin(); mit != end(); ++mit) {// primitive cycle
+      proj_samp_num.clear();
+
+      for(sit = mit->begin(); sit != mit->end(); ++sit) {
+	dtemp = face_rel_tol * sit->second.flux_val();
+	if(dtemp != 0.)
+	  proj_samp_num[sit->first] = int(sit->second.flux_var() / dtemp / dtemp);
+      }
 
-      for(nit = proj_samp_num.begin(); nit != proj_samp_num.end(); ++nit)
-	IO::log << std::setw(15) << nit->first 
-		<< std::setw(15) << nit->second 
-		<< std::setw(15) << mit->find(nit->first)->second.samp_num() 
+      if(proj_samp_num.size()) {
+	IO::log << "   " << mit - begin() << "-th surface:\n"
+		<< std::setw(15) << "Facet" 
+		<< std::setw(15) << "Projected" 
+		<< std::setw(15) << "Current"  
 		<< "\n";
-    }
 
-    count_max = 0;
-    for(nit = proj_samp_num.begin(); nit != proj_samp_num.end(); ++nit) {
-      sit = mit->find(nit->first);
-      itemp =  nit->second - sit->second.samp_num();
-      if(itemp > 0) {
-	count_max += itemp; 
+	for(nit = proj_samp_num.begin(); nit != proj_samp_num.end(); ++nit)
+	  IO::log << std::setw(15) << nit->first 
+		  << std::setw(15) << nit->second 
+		  << std::setw(15) << mit->find(nit->first)->second.samp_num() 
+		  << "\n";
       }
-    }
-    
-    if(!count_max)
-      continue;
-
-    old_share = 0;
-    while(1) {// sampling loop
-      std::set<DivSur::face_t > face_work;
 
-      count = 0;
+      count_max = 0;
       for(nit = proj_samp_num.begin(); nit != proj_samp_num.end(); ++nit) {
 	sit = mit->find(nit->first);
 	itemp =  nit->second - sit->second.samp_num();
 	if(itemp > 0) {
-	  count += itemp; 
-	  if(sit->second.samp_num() < max_pot_size)
-	    face_work.insert(nit->first);
+	  count_max += itemp; 
 	}
       }
+    
+      if(!count_max)
+	continue;
 
-      new_share = int((double)(count_max - count) / (double)count_max * 100.);
-      print_progress(old_share, new_share);
+      old_share = 0;
+      while(1) {// sampling loop
+	std::set<DivSur::face_t > face_work;
 
-      // exit condition
-      if(!face_work.size())
-	break;
+	count = 0;
+	for(nit = proj_samp_num.begin(); nit != proj_samp_num.end(); ++nit) {
+	  sit = mit->find(nit->first);
+	  itemp =  nit->second - sit->second.samp_num();
+	  if(itemp > 0) {
+	    count += itemp; 
+	    if(sit->second.samp_num() < max_pot_size)
+	      face_work.insert(nit->first);
+	  }
+	}
 
-      if(_sample(mit, face_work))
-	return false;
-    }// sampling loop
-  }// primitive cycle
-  IO::log << "done\n\n";
+	new_share = int((double)(count_max - count) / (double)count_max * 100.);
+	print_progress(old_share, new_share);
 
-  /**********************************************************************
-   ******** SATISFY SPECIES STATISTICAL FLUX RELATIVE TOLERANCE *********
-   *********************************************************************/
+	// exit condition
+	if(!face_work.size())
+	  break;
 
-  std::vector<double> stat_flux_mean, stat_flux_rmsd, stat_flux_variance;
-  _get_stat_flux(stat_flux_mean, stat_flux_rmsd, stat_flux_variance);
+	if(_sample(mit, face_work))
+	  return false;
+      }// sampling loop
+    }// primitive cycle
+    IO::log << "done\n\n";
 
-  IO::log << "Sampling to satisfy species statistical flux relative tolerance (flux samplings counted) ... \n";
+    /**********************************************************************
+     ******** SATISFY SPECIES STATISTICAL FLUX RELATIVE TOLERANCE *********
+     *********************************************************************/
 
-  for(iterator mit = begin(); mit != end(); ++mit) {// surface cycle
-    proj_samp_num.clear();
-    for(sit = mit->begin(); sit != mit->end(); ++sit) {
-      int react;
-      for(int ward = 0; ward < 2; ++ward) {// ward cycle
-	switch(ward) {
-	case BACKWARD:
-	  react = sit->first.second;
-	  break;
-	case FORWARD:
-	  react = sit->first.first;
-	  break;
-	}
+    std::vector<double> stat_flux_mean, stat_flux_rmsd, stat_flux_variance;
+    _get_stat_flux(stat_flux_mean, stat_flux_rmsd, stat_flux_variance);
 
-	if(reactant() >= 0 && reactant() != react) 
-	  continue;
+    IO::log << "Sampling to satisfy species statistical flux relative tolerance (flux samplings counted) ... \n";
+
+    for(iterator mit = begin(); mit != end(); ++mit) {// surface cycle
+      proj_samp_num.clear();
+      for(sit = mit->begin(); sit != mit->end(); ++sit) {
+	int react;
+	for(int ward = 0; ward < 2; ++ward) {// ward cycle
+	  switch(ward) {
+	  case BACKWARD:
+	    react = sit->first.second;
+	    break;
+	  case FORWARD:
+	    react = sit->first.first;
+	    break;
+	  }
 
-	// projected number of samplings
-	dtemp = spec_rel_tol * stat_flux_mean[react];
-	if(dtemp != 0.) {
-	  double face_rmsd = mit->vol_frac(sit) * std::sqrt(sit->second.flux_var());
-	  itemp = (int)(face_rmsd * stat_flux_rmsd[react] / dtemp / dtemp);
+	  if(reactant() >= 0 && reactant() != react) 
+	    continue;
 
-	  nit = proj_samp_num.find(sit->first);
-	  if(nit == proj_samp_num.end() || itemp > nit->second)
-	    proj_samp_num[sit->first] = itemp;
-	}
-      }// ward cycle
-    }// facet cycle
-    
-    if(proj_samp_num.size()) {
-      IO::log << "   " << mit - begin() << "-th surface:\n"
-	      << std::setw(15) << "Facet" 
-	      << std::setw(15) << "Projected" 
-	      << std::setw(15) << "Current"  
-	      << "\n";
+	  // projected number of samplings
+	  dtemp = spec_rel_tol * stat_flux_mean[react];
+	  if(dtemp != 0.) {
+	    double face_rmsd = mit->vol_frac(sit) * std::sqrt(sit->second.flux_var());
+	    itemp = (int)(face_rmsd * stat_flux_rmsd[react] / dtemp / dtemp);
 
-      for(nit = proj_samp_num.begin(); nit != proj_samp_num.end(); ++nit)
-	IO::log << std::setw(15) << nit->first
-		<< std::setw(15) << nit->second 
-		<< std::setw(15) << mit->find(nit->first)->second.samp_num() 
+	    nit = proj_samp_num.find(sit->first);
+	    if(nit == proj_samp_num.end() || itemp > nit->second)
+	      proj_samp_num[sit->first] = itemp;
+	  }
+	}// ward cycle
+      }// facet cycle
+    
+      if(proj_samp_num.size()) {
+	IO::log << "   " << mit - begin() << "-th surface:\n"
+		<< std::setw(15) << "Facet" 
+		<< std::setw(15) << "Projected" 
+		<< std::setw(15) << "Current"  
 		<< "\n";
-    }
 
-    count_max = 0;
-    for(nit = proj_samp_num.begin(); nit != proj_samp_num.end(); ++nit) {
-      sit = mit->find(nit->first);
-      itemp =  nit->second - sit->second.samp_num();
-      if(itemp > 0) {
-	count_max += itemp; 
+	for(nit = proj_samp_num.begin(); nit != proj_samp_num.end(); ++nit)
+	  IO::log << std::setw(15) << nit->first
+		  << std::setw(15) << nit->second 
+		  << std::setw(15) << mit->find(nit->first)->second.samp_num() 
+		  << "\n";
       }
-    }
 
-    if(!count_max)
-      continue;
-
-    old_share = 0;
-    while(1) {// sampling loop
-      std::set<DivSur::face_t > face_work;
-      count = 0;
+      count_max = 0;
       for(nit = proj_samp_num.begin(); nit != proj_samp_num.end(); ++nit) {
 	sit = mit->find(nit->first);
 	itemp =  nit->second - sit->second.samp_num();
 	if(itemp > 0) {
-	  count += itemp; 
-	  if(sit->second.samp_num() < max_pot_size)
-	    face_work.insert(nit->first);
+	  count_max += itemp; 
 	}
       }
+
+      if(!count_max)
+	continue;
+
+      old_share = 0;
+      while(1) {// sampling loop
+	std::set<DivSur::face_t > face_work;
+	count = 0;
+	for(nit = proj_samp_num.begin(); nit != proj_samp_num.end(); ++nit) {
+	  sit = mit->find(nit->first);
+	  itemp =  nit->second - sit->second.samp_num();
+	  if(itemp > 0) {
+	    count += itemp; 
+	    if(sit->second.samp_num() < max_pot_size)
+	      face_work.insert(nit->first);
+	  }
+	}
       
-      new_share = int((double)(count_max - count) / (double)count_max * 100.);
-      print_progress(old_share, new_share);
+	new_share = int((double)(count_max - count) / (double)count_max * 100.);
+	print_progress(old_share, new_share);
 
-      if(!face_work.size())
-	break;
+	if(!face_work.size())
+	  break;
 
-      if(_sample(mit, face_work))
-	return false;
-    }// sampling loop
-  }// surface cycle
-  IO::log << "done\n\n";
+	if(_sample(mit, face_work))
+	  return false;
+      }// sampling loop
+    }// surface cycle
+    IO::log << "done\n\n";
+
+  }// fixed schedule
 
   if(job() == DYN_JOB) {
 
@@ -2164,7 +2843,7 @@ bool CrossRate::MultiArray::_work (Dynamic::CCP stop)
 } 
 
 CrossRate::MultiArray::MultiArray(const DivSur::MultiSur& ms, Potential::Wrap pot, Dynamic::CCP stop)
-   : std::vector<SurArray>(ms.primitive_size()), _ms(ms), _pot(pot)
+   : std::vector<SurArray>(ms.primitive_size()), _ms(ms), _pot(pot), _pool_reuse(0)
 {
   const char funame [] = "CrossRate::MultiArray::MultiArray: ";
  
@@ -2172,6 +2851,30 @@ CrossRate::MultiArray::MultiArray(const DivSur::MultiSur& ms, Potential::Wrap po
 
   SurArray::iterator sit;
 
+  if(pool_file.size()) {
+    // the checkpoint samplings may have been made with the pooled configurations
+    if(restart_file.size()) {
+      std::cerr << funame << "the configurations pool cannot be used with the restart\n";
+      throw Error::Init();
+    }
+    _load_pool();
+  }
+
+  // restart from the checkpoints
+  if(restart_file.size()) {
+    std::istringstream names(restart_file);
+    std::string name;
+    for(int count = 0; std::getline(names, name, ','); ++count)
+      _load_checkpoint(name, count);
+
+    while(!_work(stop)) {}
+
+    if(checkpoint_file.size())
+      _save_checkpoint();
+
+    return;
+  }
+
   // initial sampling to check which facets are actually present
   IO::log << "Preliminary sampling with " << min_sur_size 
 	  << " samplings per primitive surface ...\n";
@@ -2203,4 +2906,403 @@ CrossRate::MultiArray::MultiArray(const DivSur::MultiSur& ms, Potential::Wrap po
 
   // sample the surface and run trajectories to satisfy predefined tolerances
   while(!_work(stop)) {}
+
+  if(checkpoint_file.size())
+    _save_checkpoint();
+
+  if(pool_file.size())
+    _save_pool();
+}
+
+/****************************************************************************************
+ ************************************** CHECKPOINTS *************************************
+ ****************************************************************************************/
+
+namespace {
+  //
+  template <typename T>
+  void bin_put (std::ostream& to, const T& v) { to.write((const char*)&v, sizeof(T)); }
+
+  template <typename T>
+  void bin_get (std::istream& from, T& v) { from.read((char*)&v, sizeof(T)); }
+
+  // file header: signature, version, dynamical variables and primitive surfaces numbers
+  const int checkpoint_signature = 0x4b434352; // "RCCK"
+  const int checkpoint_version   = 1;
+
+  // configurations pool file header: signature, version, coordinates and signatures numbers
+  const int pool_signature = 0x4c4f4f50; // "POOL"
+  const int pool_version   = 1;
+}
+
+void CrossRate::MultiArray::_load_pool ()
+{
+  const char funame [] = "CrossRate::MultiArray::_load_pool: ";
+
+  int itemp;
+
+  _pool_sig.resize(size());
+  _pool_next.assign(size(), 0);
+  for(int sur = 0; sur < size(); ++sur)
+    _pool_sig[sur] = _ms.primitive_signature(sur);
+
+  std::ifstream from(pool_file.c_str(), std::ios::binary);
+  if(!from) {
+    IO::log << "configurations pool " << pool_file << " is not found: starting a new one\n\n";
+    return;
+  }
+
+  bin_get(from, itemp);
+  if(!from || itemp != pool_signature) {
+    std::cerr << funame << pool_file << ": not a configurations pool file\n";
+    throw Error::Input();
+  }
+
+  bin_get(from, itemp);
+  if(itemp != pool_version) {
+    std::cerr << funame << pool_file << ": unsupported version: " << itemp << "\n";
+    throw Error::Input();
+  }
+
+  bin_get(from, itemp);
+  if(itemp != Dynamic::Coordinates::size()) {
+    std::cerr << funame << pool_file << ": coordinates number mismatch: " << itemp 
+	      << " vs. " << Dynamic::Coordinates::size() << "\n";
+    throw Error::Input();
+  }
+
+  int sig_size;
+  bin_get(from, sig_size);
+  for(int s = 0; from && s < sig_size; ++s) {
+    bin_get(from, itemp);
+    std::string sig(itemp, ' ');
+    from.read(&sig[0], itemp);
+
+    int rec_size;
+    bin_get(from, rec_size);
+    if(!from || rec_size < 0)
+      break;
+
+    std::vector<_PoolRec>& pool = _pool[sig];
+    pool.resize(rec_size);
+    for(int r = 0; r < rec_size; ++r) {
+      pool[r].pos.resize(Dynamic::Coordinates::size());
+      from.read((char*)&pool[r].pos[0], sizeof(double) * pool[r].pos.size());
+      bin_get(from, itemp);
+      pool[r].stat = (_PoolRec::Stat)itemp;
+      bin_get(from, pool[r].ener);
+    }
+  }
+
+  if(!from) {
+    std::cerr << funame << pool_file << ": input stream is corrupted\n";
+    throw Error::Input();
+  }
+
+  IO::log << "configurations pool " << pool_file << ":\n";
+  for(int sur = 0; sur < size(); ++sur) {
+    std::map<std::string, std::vector<_PoolRec> >::const_iterator pit = _pool.find(_pool_sig[sur]);
+    IO::log << "   " << sur << "-th surface: " << (pit == _pool.end() ? 0 : pit->second.size()) 
+	    << " pooled configurations\n";
+  }
+  IO::log << "\n";
+}
+
+void CrossRate::MultiArray::_save_pool () const
+{
+  const char funame [] = "CrossRate::MultiArray::_save_pool: ";
+
+  IO::log << "potential energies taken from the configurations pool: " << _pool_reuse << "\n\n";
+
+  IO::AtomicFile to(pool_file);
+  if(!to) {
+    std::cerr << funame << "cannot open " << to.tmp_name() << "\n";
+    throw Error::File();
+  }
+
+  bin_put(to, pool_signature);
+  bin_put(to, pool_version);
+  bin_put(to, Dynamic::Coordinates::size());
+  bin_put(to, (int)_pool.size());
+
+  for(std::map<std::string, std::vector<_PoolRec> >::const_iterator pit = _pool.begin(); pit != _pool.end(); ++pit) {
+    bin_put(to, (int)pit->first.size());
+    to.write(pit->first.data(), pit->first.size());
+    bin_put(to, (int)pit->second.size());
+    for(std::vector<_PoolRec>::const_iterator rit = pit->second.begin(); rit != pit->second.end(); ++rit) {
+      to.write((const char*)&rit->pos[0], sizeof(double) * rit->pos.size());
+      bin_put(to, (int)rit->stat);
+      bin_put(to, rit->ener);
+    }
+  }
+
+  if(!to.commit()) {
+    std::cerr << funame << "cannot write " << pool_file << "\n";
+    throw Error::File();
+  }
+}
+
+CrossRate::DynSmp::DynSmp (Potential::Wrap pot, std::istream& from)
+{
+  const char funame [] = "CrossRate::DynSmp::DynSmp: ";
+
+  ::Array<double> dv(Dynamic::Vars::size());
+  from.read((char*)(double*)dv, sizeof(double) * dv.size());
+  get(dv);
+
+  bin_get(from, _ranval);
+  bin_get(from, _weight);
+  bin_get(from, _energy);
+
+  int itemp;
+
+  back.init(new DynRes(pot, *this, BACKWARD));
+  bin_get(from, itemp);
+  back->stat = (DynRes::Stat)itemp;
+  back->load(from);
+
+  forw.init(new DynRes(pot, *this,  FORWARD));
+  bin_get(from, itemp);
+  forw->stat = (DynRes::Stat)itemp;
+  forw->load(from);
+
+  if(!from) {
+    std::cerr << funame << "input stream is corrupted\n";
+    throw Error::Input();
+  }
+}
+
+void CrossRate::DynSmp::save (std::ostream& to) const
+{
+  ::Array<double> dv(Dynamic::Vars::size());
+  put(dv);
+  to.write((const char*)(const double*)dv, sizeof(double) * dv.size());
+
+  bin_put(to, _ranval);
+  bin_put(to, _weight);
+  bin_put(to, _energy);
+
+  bin_put(to, (int)back->stat);
+  back->save(to);
+
+  bin_put(to, (int)forw->stat);
+  forw->save(to);
+}
+
+void CrossRate::FacetArray::save (std::ostream& to) const
+{
+  bin_put(to, _flux_num);
+  bin_put(to, _fail_num);
+  bin_put(to, _fake_num);
+  bin_put(to, _max_weight);
+  bin_put(to, _min_ener);
+  bin_put(to, _flux);
+  bin_put(to, _fvar);
+
+  ::Array<double> dc(Dynamic::Coordinates::size());
+  _min_geom.put(dc);
+  to.write((const char*)(const double*)dc, sizeof(double) * dc.size());
+
+  bin_put(to, size());
+  for(const_iterator fit = begin(); fit != end(); ++fit)
+    fit->save(to);
+}
+
+void CrossRate::FacetArray::load (Potential::Wrap pot, std::istream& from) 
+{
+  const char funame [] = "CrossRate::FacetArray::load: ";
+
+  bin_get(from, _flux_num);
+  bin_get(from, _fail_num);
+  bin_get(from, _fake_num);
+  bin_get(from, _max_weight);
+  bin_get(from, _min_ener);
+  bin_get(from, _flux);
+  bin_get(from, _fvar);
+
+  ::Array<double> dc(Dynamic::Coordinates::size());
+  from.read((char*)(double*)dc, sizeof(double) * dc.size());
+  _min_geom.get(dc);
+
+  int itemp;
+  bin_get(from, itemp);
+
+  if(!from || itemp < 0) {
+    std::cerr << funame << "input stream is corrupted\n";
+    throw Error::Input();
+  }
+
+  clear();
+  for(int i = 0; i < itemp; ++i)
+    push_back(DynSmp(pot, from));
+}
+
+// the importance samplings of both arrays are filtered with the common reference weight
+void CrossRate::FacetArray::merge (const FacetArray& fa)
+{
+  if(fa.flux_num() && (!flux_num() || fa._min_ener < _min_ener)) {
+    _min_ener = fa._min_ener;
+    _min_geom = fa._min_geom;
+  }
+
+  _flux_num += fa._flux_num;
+  _fail_num += fa._fail_num;
+  _fake_num += fa._fake_num;
+  _flux     += fa._flux;
+  _fvar     += fa._fvar;
+
+  if(!fa.size())
+    return;
+
+  if(!size())
+    _max_weight = fa._max_weight;
+
+  if(fa._max_weight > _max_weight) {
+    _max_weight = fa._max_weight;
+
+    iterator it = begin();
+    while(it != end())
+      if(it->ranval() * _max_weight >= it->weight())
+	it = erase(it);
+      else
+	++it;
+  }
+
+  for(const_iterator fit = fa.begin(); fit != fa.end(); ++fit)
+    if(fit->ranval() * _max_weight < fit->weight())
+      push_back(*fit);
+}
+
+void CrossRate::SurArray::save (std::ostream& to) const
+{
+  bin_put(to, _fail);
+  bin_put(to, _inner);
+  bin_put(to, _exclude);
+  bin_put(to, _close);
+  bin_put(to, _skip);
+
+  bin_put(to, size());
+  for(const_iterator sit = begin(); sit != end(); ++sit) {
+    bin_put(to, sit->first.first);
+    bin_put(to, sit->first.second);
+    sit->second.save(to);
+  }
+}
+
+void CrossRate::SurArray::load (Potential::Wrap pot, std::istream& from) 
+{
+  const char funame [] = "CrossRate::SurArray::load: ";
+
+  bin_get(from, _fail);
+  bin_get(from, _inner);
+  bin_get(from, _exclude);
+  bin_get(from, _close);
+  bin_get(from, _skip);
+
+  int itemp;
+  bin_get(from, itemp);
+
+  if(!from || itemp < 0) {
+    std::cerr << funame << "input stream is corrupted\n";
+    throw Error::Input();
+  }
+
+  clear();
+  for(int i = 0; i < itemp; ++i) {
+    DivSur::face_t face;
+    bin_get(from, face.first);
+    bin_get(from, face.second);
+    (*this)[face].load(pot, from);
+  }
+}
+
+void CrossRate::SurArray::merge (const SurArray& sa)
+{
+  _fail    += sa._fail;
+  _inner   += sa._inner;
+  _exclude += sa._exclude;
+  _close   += sa._close;
+  _skip    += sa._skip;
+
+  for(const_iterator sit = sa.begin(); sit != sa.end(); ++sit)
+    (*this)[sit->first].merge(sit->second);
+}
+
+void CrossRate::MultiArray::_checkpoint ()
+{
+  static std::time_t last = std::time(0);
+
+  if(!checkpoint_file.size() || std::time(0) - last < checkpoint_interval)
+    return;
+
+  _save_checkpoint();
+  last = std::time(0);
+}
+
+// the previous checkpoint survives an interruption in the middle of the writing
+void CrossRate::MultiArray::_save_checkpoint () const
+{
+  const char funame [] = "CrossRate::MultiArray::_save_checkpoint: ";
+
+  IO::AtomicFile to(checkpoint_file);
+  if(!to) {
+    std::cerr << funame << "cannot open " << to.tmp_name() << " file\n";
+    throw Error::File();
+  }
+
+  bin_put(to, checkpoint_signature);
+  bin_put(to, checkpoint_version);
+  bin_put(to, Dynamic::Vars::size());
+  bin_put(to, (int)size());
+
+  Random::stream().save(to);
+
+  for(const_iterator mit = begin(); mit != end(); ++mit)
+    mit->save(to);
+
+  if(!to.commit()) {
+    std::cerr << funame << "cannot write " << checkpoint_file << " file\n";
+    throw Error::File();
+  }
+
+  IO::log << "      checkpoint saved to " << checkpoint_file << "\n";
+}
+
+// the first checkpoint sets the state, including the random numbers stream, and the 
+// others, which should come from the independent runs, are added to it
+void CrossRate::MultiArray::_load_checkpoint (const std::string& name, bool merge) 
+{
+  const char funame [] = "CrossRate::MultiArray::_load_checkpoint: ";
+
+  std::ifstream from(name.c_str(), std::ios::binary);
+  if(!from) {
+    std::cerr << funame << "cannot open " << name << " file\n";
+    throw Error::File();
+  }
+
+  int head [4];
+  from.read((char*)head, sizeof(head));
+
+  if(!from || head[0] != checkpoint_signature || head[1] != checkpoint_version 
+     || head[2] != Dynamic::Vars::size() || head[3] != size()) {
+    std::cerr << funame << name << ": not a checkpoint file or the checkpoint does not match the surface\n";
+    throw Error::Input();
+  }
+
+  Random::Stream rs;
+  rs.load(from);
+
+  if(!merge)
+    Random::stream() = rs;
+
+  for(iterator mit = begin(); mit != end(); ++mit)
+    if(merge) {
+      SurArray sa;
+      sa.load(_pot, from);
+      mit->merge(sa);
+    }
+    else
+      mit->load(_pot, from);
+
+  IO::log << "Sampling state " << (merge ? "merged from " : "restored from ") << name << "\n";
 }
@@ -83,6 +83,33 @@ namespace CrossRate {
   
   void print_progress (int&, int);
 
+  // number of threads propagating the facet trajectories
+  extern int traj_thread_num;
+
+  // number of the facet trajectories propagated in lockstep by one host thread (the Runge-Kutta
+  // solver only): the equations of motion and the classification stay per member, and only the
+  // members' potential energies and forces are calculated at once by the potential batch methods
+  extern int traj_batch_size;
+
+  // number of threads calculating the facet samplings potential energies
+  // and the number of samplings drawn for them at once
+  extern int smp_thread_num;
+  extern int smp_batch_size;
+
+  // sampling state checkpoints: the file, the minimal time between the checkpoints, 
+  // and the checkpoint files, comma separated, to restart from and to merge
+  extern std::string checkpoint_file;
+  extern int         checkpoint_interval; // seconds
+  extern std::string restart_file;
+
+  // configurations pool shared by the runs on the candidate dividing surfaces: the
+  // configurations drawn on a primitive surface, with their potential energies if
+  // calculated, are taken again, in the same order, by the runs having a primitive of
+  // the same signature, before any new configuration is drawn; the pool is read from
+  // the file, if it exists, and rewritten with the new configurations at the end;
+  // the fragments and the potential are assumed the same
+  extern std::string pool_file;
+
   extern std::ofstream xout;
 
   // test if the configuration is in a given species region
@@ -114,6 +141,12 @@ namespace CrossRate {
 
   public:
     DynSmp (Potential::Wrap, const DivSur::MultiSur&, int, const Dynamic::Coordinates&) ;
+    // potential energy has been already calculated
+    DynSmp (Potential::Wrap, const DivSur::MultiSur&, int, const Dynamic::Coordinates&, double) ;
+    // from the checkpoint
+    DynSmp (Potential::Wrap, std::istream&) ;
+
+    void save (std::ostream&) const;
 
     // statistical methods
     double ranval           () const { return _ranval; }
@@ -127,6 +160,12 @@ namespace CrossRate {
 
     void run_traj (const DivSur::MultiSur&, const DivSur::face_t&, Dynamic::CCP);
 
+    // the same for the batch of samplings: the trajectories of every stage are propagated together
+    static void run_traj (const std::vector<DynSmp*>&, const DivSur::MultiSur&, const DivSur::face_t&, Dynamic::CCP);
+
+    // trajectory tolerances scaled for the sampling
+    void set_traj_tol ();
+
     bool is_run      () const;
     bool is_pot_fail () const;
     bool is_run_fail () const;
@@ -184,6 +223,10 @@ namespace CrossRate {
     double _flux; // cumulative flux value 
     double _fvar; // cumulative flax variation
 
+    void _run_traj_threads (const DivSur::MultiSur&, const DivSur::face_t&, Dynamic::CCP, int);
+    void _run_traj_batch   (const DivSur::MultiSur&, const DivSur::face_t&, Dynamic::CCP, int);
+    void _check_traj       (const DivSur::face_t&) const;
+
   public:
     FacetArray () : _flux_num(0), _fail_num(0), _fake_num(0), _flux(0.), _fvar(0.), _min_ener(-100.) {}
 
@@ -197,7 +240,9 @@ namespace CrossRate {
     const Dynamic::Coordinates& min_geom () const { return _min_geom; }
 
     void add_fake () { ++_fake_num; }
+    void add_pot_fail () { ++_fail_num; }
     bool add_smp  (Potential::Wrap, const DivSur::MultiSur&, int, const Dynamic::Coordinates&);
+    bool add_smp  (Potential::Wrap, const DivSur::MultiSur&, int, const Dynamic::Coordinates&, double);
 
     // flux value
     double flux_val () const;
@@ -235,6 +280,11 @@ namespace CrossRate {
     double dyn_dev (int ward, int spec) const; // recrossing factor standard deviation
     double dyn_var (int ward, int spec) const; // recrossing factor variance
 
+    // checkpoints
+    void save  (std::ostream&) const;
+    void load  (Potential::Wrap, std::istream&) ;
+    void merge (const FacetArray&);
+
   };// FacetArray
 
   inline double FacetArray::min_ener () const 
@@ -302,6 +352,11 @@ namespace CrossRate {
     double vol_rel_var (const_iterator sit) const;
 
     double face_flux (const_iterator sit) const { return vol_frac(sit) * sit->second.flux_val(); }
+
+    // checkpoints
+    void save  (std::ostream&) const;
+    void load  (Potential::Wrap, std::istream&) ;
+    void merge (const SurArray&);
   };// SurArray
 
   inline int SurArray::tot_smp_num() const
@@ -347,9 +402,38 @@ namespace CrossRate {
       Potential::Wrap _pot;
 
     int _sample (iterator, const std::set<DivSur::face_t>&);
+    int _sample_batch (iterator, const std::set<DivSur::face_t>&);
+
+    // configurations pool
+    struct _PoolRec {
+      enum Stat {NOPOT, POT, FAIL};
+      std::vector<double> pos;
+      Stat                stat;
+      double              ener;
+    };
+    std::map<std::string, std::vector<_PoolRec> > _pool; // by the primitive signature
+    std::vector<std::string>                      _pool_sig;  // primitive signatures
+    std::vector<int>                              _pool_next; // next pooled configuration
+    int                                           _pool_reuse;// potential energies reused
+
+    // configuration on the primitive surface, pooled or new; returns the pool record or -1
+    int  _draw    (int sur, Dynamic::Coordinates&);
+    // add the facet sampling, with the pooled potential energy if available
+    void _add_smp (FacetArray&, int sur, const Dynamic::Coordinates&, int rec);
+
+    void _load_pool ();
+    void _save_pool () const;
+
+    // checkpoints
+    void _checkpoint      ();       // save if the checkpoint interval has passed
+    void _save_checkpoint () const;
+    void _load_checkpoint (const std::string&, bool merge) ;
 
     bool _work (Dynamic::CCP) ;
 
+    // variance driven allocation of the flux samplings; false if a new facet is found
+    bool _adaptive_sampling ();
+
     // print samplings results
     void _print_sampling_results () const;
 
@@ -378,6 +462,10 @@ namespace CrossRate {
     static double reac_rel_tol;  // relative tolerance for a species reactive flux
     static double tran_rel_tol;  // relative tolerance for the reactive transition flux
 
+    // species statistical flux relative error at which the adaptive allocation of the
+    // flux samplings stops; it replaces the facet and species tolerance stages if positive
+    static double adapt_rel_tol;
+
     static std::vector<int> reactive_transition; // reactive transition for tolerance evaluation
 
     MultiArray(const DivSur::MultiSur&, Potential::Wrap, Dynamic::CCP) ;
@@ -0,0 +1,172 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2016, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#include "cusolver.hh"
+#include "error.hh"
+#include "io.hh"
+
+#include <cuda_runtime.h>
+#include <cusolverDn.h>
+
+#include <iostream>
+
+namespace Cusolver {
+  //
+  int size_min = 2000;
+
+  cusolverDnHandle_t _handle;
+
+  int _device_count = -1;
+
+  void _check (cudaError_t, const char*);
+  void _check (cusolverStatus_t, const char*);
+
+  // device buffer
+  //
+  template <typename T>
+  class _Buffer {
+    T* _data;
+    
+    _Buffer (const _Buffer&);
+    _Buffer& operator= (const _Buffer&);
+
+  public:
+    explicit _Buffer (size_t s) : _data(0) { _check(cudaMalloc((void**)&_data, s * sizeof(T)), "cudaMalloc"); }
+    ~_Buffer () { cudaFree(_data); }
+
+    operator T* () { return _data; }
+  };
+}
+
+void Cusolver::_check (cudaError_t stat, const char* name)
+{
+  if(stat == cudaSuccess)
+    return;
+
+  std::cerr << "Cusolver: " << name << ": " << cudaGetErrorString(stat) << "\n";
+  throw Error::Run();
+}
+
+void Cusolver::_check (cusolverStatus_t stat, const char* name)
+{
+  if(stat == CUSOLVER_STATUS_SUCCESS)
+    return;
+
+  std::cerr << "Cusolver: " << name << ": failed with the status " << (int)stat << "\n";
+  throw Error::Run();
+}
+
+bool Cusolver::use (int size)
+{
+  if(size < size_min)
+    return false;
+
+  // the device and the handle are set up once by the first caller, the other threads wait;
+  // if the handle cannot be created, the solvers stay on the CPU
+  bool res;
+
+#pragma omp critical(cusolver_init)
+  {
+    if(_device_count < 0) {
+      if(cudaGetDeviceCount(&_device_count) != cudaSuccess)
+	_device_count = 0;
+
+      if(_device_count) {
+	const cusolverStatus_t stat = cusolverDnCreate(&_handle);
+
+	if(stat != CUSOLVER_STATUS_SUCCESS) {
+	  IO::log << IO::log_offset << "WARNING: Cusolver: cusolverDnCreate failed with the status "
+		  << (int)stat << ", the CPU solvers are used\n";
+
+	  _device_count = 0;
+	}
+      }
+    }
+
+    res = _device_count > 0;
+  }
+
+  return res;
+}
+
+void Cusolver::eigenvalues (int size, double* a, double* eval, bool evec)
+{
+  const char funame [] = "Cusolver::eigenvalues: ";
+
+  const cusolverEigMode_t job = evec ? CUSOLVER_EIG_MODE_VECTOR : CUSOLVER_EIG_MODE_NOVECTOR;
+
+  _Buffer<double> dev_a((size_t)size * size), dev_w(size);
+  _Buffer<int> dev_info(1);
+
+  _check(cudaMemcpy(dev_a, a, (size_t)size * size * sizeof(double), cudaMemcpyHostToDevice), "cudaMemcpy");
+
+  int lwork;
+  _check(cusolverDnDsyevd_bufferSize(_handle, job, CUBLAS_FILL_MODE_UPPER, size, dev_a, size, dev_w, &lwork),
+	 "cusolverDnDsyevd_bufferSize");
+
+  _Buffer<double> work(lwork);
+  _check(cusolverDnDsyevd(_handle, job, CUBLAS_FILL_MODE_UPPER, size, dev_a, size, dev_w, work, lwork, dev_info),
+	 "cusolverDnDsyevd");
+
+  int info;
+  _check(cudaMemcpy(&info, dev_info, sizeof(int), cudaMemcpyDeviceToHost), "cudaMemcpy");
+
+  if(info < 0) {
+    std::cerr << funame << "syevd: " << -info << "-th argument has an illegal value\n";
+    throw Error::Range();
+  }
+  else if(info) {
+    std::cerr << funame << "syevd: " << info << " off-diagonal elements did not converge to zero\n";
+    throw Error::Math();
+  }
+
+  _check(cudaMemcpy(eval, dev_w, size * sizeof(double), cudaMemcpyDeviceToHost), "cudaMemcpy");
+
+  if(evec)
+    _check(cudaMemcpy(a, dev_a, (size_t)size * size * sizeof(double), cudaMemcpyDeviceToHost), "cudaMemcpy");
+}
+
+void Cusolver::cholesky (int size, double* a)
+{
+  const char funame [] = "Cusolver::cholesky: ";
+
+  _Buffer<double> dev_a((size_t)size * size);
+  _Buffer<int> dev_info(1);
+
+  _check(cudaMemcpy(dev_a, a, (size_t)size * size * sizeof(double), cudaMemcpyHostToDevice), "cudaMemcpy");
+
+  int lwork;
+  _check(cusolverDnDpotrf_bufferSize(_handle, CUBLAS_FILL_MODE_UPPER, size, dev_a, size, &lwork),
+	 "cusolverDnDpotrf_bufferSize");
+
+  _Buffer<double> work(lwork);
+  _check(cusolverDnDpotrf(_handle, CUBLAS_FILL_MODE_UPPER, size, dev_a, size, work, lwork, dev_info),
+	 "cusolverDnDpotrf");
+
+  int info;
+  _check(cudaMemcpy(&info, dev_info, sizeof(int), cudaMemcpyDeviceToHost), "cudaMemcpy");
+
+  if(info < 0) {
+    std::cerr << funame << "potrf: " << -info << "-th argument had an illegal value\n";
+    throw Error::Range();
+  }
+  else if(info) {
+    std::cerr << funame << "potrf: the leading minor of the " << info <<  "-th order of  A is not\n"
+      "\tpositive definite, and the factorization could not be completed.\n";
+    throw Error::Math();
+  }
+
+  _check(cudaMemcpy(a, dev_a, (size_t)size * size * sizeof(double), cudaMemcpyDeviceToHost), "cudaMemcpy");
+}
@@ -0,0 +1,36 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2016, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#ifndef CUSOLVER_HH
+#define CUSOLVER_HH
+
+// dense symmetric solvers on the GPU
+//
+namespace Cusolver {
+  //
+  extern int size_min; // smaller matrices stay on the CPU
+
+  // the device is available and the matrix is big enough
+  bool use (int size);
+
+  // eigenvalues of the symmetric matrix in the full storage (upper triangle referenced);
+  // the matrix is overwritten with the eigenvectors if requested
+  void eigenvalues (int size, double* a, double* eval, bool evec);
+
+  // Cholesky factorization in the full storage: the upper triangle is overwritten with the factor
+  void cholesky (int size, double* a);
+}
+
+#endif
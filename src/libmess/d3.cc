@@ -292,96 +292,6 @@ void D3::Matrix::chirality_check () const
  ************ 3-D Real Vector *************
  ******************************************/
 
-D3::Vector::Vector () 
-{
-  _end = _begin + 3;
-
-  for(iterator it = begin(); it != end(); ++it)
-    *it = 0.;
-}
-
-D3::Vector::Vector(const Vector& v)
-{
-  _end = _begin + 3;
-
-  const_iterator vit = v.begin();
-  for(iterator it = begin(); it != end(); ++it, ++vit)
-    *it = *vit;
-}
-
-D3::Vector& D3::Vector::operator= (const Vector& v)
-{
-  const_iterator vit = v.begin();
-  for(iterator it = begin(); it != end(); ++it, ++vit)
-    *it = *vit;
-
-  return *this;
-}
-
-D3::Vector::Vector (double a)
-{
-  _end = _begin + 3;
-
-  for(iterator it = begin(); it != end(); ++it)
-    *it = a;
-}
-
-D3::Vector::Vector (const double* p)
-{
-  _end = _begin + 3;
-
-  for(iterator it = begin(); it != end(); ++it)
-    *it = *p++;
-}
-
-D3::Vector& D3::Vector::operator= (const double* p)
-{
-  for(iterator it = begin(); it != end(); ++it)
-    *it = *p++;
-
-  return *this;
-}
-
-D3::Vector& D3::Vector::operator+= (const double* p)
-{
-  for(iterator it = begin(); it != end(); ++it)
-    *it += *p++;
-
-  return *this;
-}
-
-D3::Vector& D3::Vector::operator-= (const double* p)
-{
-  for(iterator it = begin(); it != end(); ++it)
-    *it -= *p++;
-
-  return *this;
-}
-
-D3::Vector& D3::Vector::operator= (double val)
-{
-  for(iterator it = begin(); it != end(); ++it)
-    *it = val;
-
-  return *this;
-}
-
-D3::Vector& D3::Vector::operator*= (double val)
-{
-  for(iterator it = begin(); it != end(); ++it)
-    *it *= val;
-
-  return *this;
-}
-
-D3::Vector& D3::Vector::operator/= (double val)
-{
-  for(iterator it = begin(); it != end(); ++it)
-    *it /= val;
-
-  return *this;
-}
-
 D3::Vector& D3::Vector::operator*= (const Matrix& m) //rotation
 {
   *this = m * (*this);
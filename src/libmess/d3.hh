@@ -28,22 +28,21 @@ class Quaternion;
 namespace D3 {
   class Matrix;
 
+  // trivially copyable: the temporaries stay in registers
+  //
   class Vector
   {
     double _begin [3];
-    double* _end;
 
   public:
     typedef       double*       iterator;
     typedef const double* const_iterator;
     typedef       double      value_type;
     
-    Vector ();
-    Vector (const Vector&);
-    Vector& operator= (const Vector&);
+    Vector () { for(int i = 0; i < 3; ++i) _begin[i] = 0.; }
 
-    explicit Vector (double);
-    explicit Vector (const double*);
+    explicit Vector (double a)        { for(int i = 0; i < 3; ++i) _begin[i] = a; }
+    explicit Vector (const double* p) { for(int i = 0; i < 3; ++i) _begin[i] = p[i]; }
     template <typename V>
     explicit Vector (const V&) ;
 
@@ -55,8 +54,8 @@ namespace D3 {
 
     const double* begin () const { return _begin; }
     double*       begin ()       { return _begin; }
-    const double*   end () const { return _end; }
-    double*         end ()       { return _end; }
+    const double*   end () const { return _begin + 3; }
+    double*         end ()       { return _begin + 3; }
     
     int size () const { return 3; }
 
@@ -65,9 +64,9 @@ namespace D3 {
     template <typename V> Vector& operator+= (const V&) ;
     template <typename V> Vector& operator-= (const V&) ;
 
-    Vector& operator=  (const double*);
-    Vector& operator+= (const double*);
-    Vector& operator-= (const double*);
+    Vector& operator=  (const double* p) { for(int i = 0; i < 3; ++i) _begin[i]  = p[i]; return *this; }
+    Vector& operator+= (const double* p) { for(int i = 0; i < 3; ++i) _begin[i] += p[i]; return *this; }
+    Vector& operator-= (const double* p) { for(int i = 0; i < 3; ++i) _begin[i] -= p[i]; return *this; }
 
     Vector operator+ (const double*)   const;
     Vector operator+ (const Vector& v) const { return *this + (const double*)v; }
@@ -76,9 +75,9 @@ namespace D3 {
     Vector operator* (double)          const;
     Vector operator* (const Matrix&)   const;
 
-    Vector& operator=  (double);
-    Vector& operator*= (double);
-    Vector& operator/= (double);
+    Vector& operator=  (double a) { for(int i = 0; i < 3; ++i) _begin[i]  = a; return *this; }
+    Vector& operator*= (double a) { for(int i = 0; i < 3; ++i) _begin[i] *= a; return *this; }
+    Vector& operator/= (double a) { for(int i = 0; i < 3; ++i) _begin[i] /= a; return *this; }
 
     Vector& operator*= (const Matrix&); // orthogonal transformation M*v
 
@@ -98,8 +97,6 @@ namespace D3 {
       throw Error::Range();
     }
 
-    _end = _begin + 3;
-
     typename V::const_iterator vit = v.begin();
     for(iterator it = begin(); it != end(); ++it, ++vit)
       *it = *vit;
@@ -312,7 +309,10 @@ namespace D3 {
  *************************** QUATERNION **********************************
  *************************************************************************/
 
-class Quaternion : private Array<double> {
+// fixed-size quaternion with the in-place storage
+//
+class Quaternion {
+  double _begin [4];
 
 public:
 
@@ -323,41 +323,41 @@ public:
   typedef       double*       iterator;
   typedef       double      value_type;
 
-  Quaternion () : Array<double>(4, 0.) {}
+  Quaternion () { for(int i = 0; i < 4; ++i) _begin[i] = 0.; }
 
-  explicit Quaternion (double d)        : Array<double>(4, 0.) { *begin() = d; }
-  explicit Quaternion (const double* p) : Array<double>(4) { Array<double>::operator=(p); }
+  explicit Quaternion (double d)        { _begin[0] = d; for(int i = 1; i < 4; ++i) _begin[i] = 0.; }
+  explicit Quaternion (const double* p) { for(int i = 0; i < 4; ++i) _begin[i] = p[i]; }
   explicit Quaternion (const D3::Matrix&, int =0) ;
 
   template<class V>
   explicit Quaternion (const V&) ;
 
-  int size () const { return Array<double>::size(); }
+  int size () const { return 4; }
 
-  operator       double* ()       { return Array<double>::begin(); }
-  operator const double* () const { return Array<double>::begin(); }
+  operator       double* ()       { return _begin; }
+  operator const double* () const { return _begin; }
 
   operator D3::Matrix () const ;
 
-  double*       begin ()       { return Array<double>::begin(); }
-  const double* begin () const { return Array<double>::begin(); }
-  double*         end ()       { return Array<double>::end(); }
-  const double*   end () const { return Array<double>::end(); }
+  double*       begin ()       { return _begin; }
+  const double* begin () const { return _begin; }
+  double*         end ()       { return _begin + 4; }
+  const double*   end () const { return _begin + 4; }
 
-  double&       operator[] (int i)       { return Array<double>::operator[](i); }
-  const double& operator[] (int i) const { return Array<double>::operator[](i); }
+  double&       operator[] (int i)       { return _begin[i]; }
+  const double& operator[] (int i) const { return _begin[i]; }
 
   //vector operations
   template<class V> Quaternion& operator=  (const V&) ;
-  template<class V> Quaternion& operator+= (const V& v) { Array<double>::operator+=(v); return *this; }
-  template<class V> Quaternion& operator-= (const V& v) { Array<double>::operator-=(v); return *this; }
+  template<class V> Quaternion& operator+= (const V&) ;
+  template<class V> Quaternion& operator-= (const V&) ;
   
-  Quaternion& operator=   (const double* p) { Array<double>::operator= (p); return *this; } 
-  Quaternion& operator+=  (const double* p) { Array<double>::operator+=(p); return *this; } 
-  Quaternion& operator-=  (const double* p) { Array<double>::operator-=(p); return *this; } 
+  Quaternion& operator=   (const double* p) { for(int i = 0; i < 4; ++i) _begin[i]  = p[i]; return *this; } 
+  Quaternion& operator+=  (const double* p) { for(int i = 0; i < 4; ++i) _begin[i] += p[i]; return *this; } 
+  Quaternion& operator-=  (const double* p) { for(int i = 0; i < 4; ++i) _begin[i] -= p[i]; return *this; } 
   
-  Quaternion& operator*=  (double d) { Array<double>::operator*=(d); return *this; } 
-  Quaternion& operator/=  (double d) { Array<double>::operator/=(d); return *this; } 
+  Quaternion& operator*=  (double d) { for(int i = 0; i < 4; ++i) _begin[i] *= d; return *this; } 
+  Quaternion& operator/=  (double d) { for(int i = 0; i < 4; ++i) _begin[i] /= d; return *this; } 
 
   //quaternion operations
   Quaternion operator* (const double*) const;
@@ -366,7 +366,7 @@ public:
   Quaternion operator+ (const Quaternion& q) const { Quaternion res(*this); res += q; return res; }
   Quaternion operator- (const Quaternion& q) const { Quaternion res(*this); res -= q; return res; }
 
-  void normalize ();
+  void normalize () { ::normalize(_begin, 4); }
 
   static void qprod (const double*, const double*, double*);
 };
@@ -398,7 +398,6 @@ inline Quaternion::operator D3::Matrix () const
 }
 
 inline Quaternion::Quaternion (const D3::Matrix& m, int flags) 
-  : Array<double>(4)
 { 
   mat2quat(m, *this, flags);
 }
@@ -426,7 +425,7 @@ inline Quaternion Quaternion::operator/ (const double* q) const
 }
 
 template<class V>
-Quaternion::Quaternion (const V& v)  : Array<double>(v)
+Quaternion::Quaternion (const V& v) 
 {
   const char funame [] = "Quaternion::Quaternion: ";
 
@@ -434,6 +433,10 @@ Quaternion::Quaternion (const V& v)  : Array<double>(v)
     std::cerr << funame << "wrong initializer dimension (" << v.size() << ")/n";
     throw Error::Range();
   }  
+
+  typename V::const_iterator vit = v.begin();
+  for(iterator it = begin(); it != end(); ++it, ++vit)
+    *it = *vit;
 }
 
 template<class V>
@@ -446,7 +449,43 @@ Quaternion& Quaternion::operator= (const V& v)
     throw Error::Range();
   } 
 
-  Array<double>::operator=(v);
+  typename V::const_iterator vit = v.begin();
+  for(iterator it = begin(); it != end(); ++it, ++vit)
+    *it = *vit;
+
+  return *this;
+}
+
+template<class V>
+Quaternion& Quaternion::operator+= (const V& v) 
+{
+  const char funame [] = "Quaternion::operator+=: ";
+
+  if(v.size() != 4) {
+    std::cerr << funame << "dimensions mismatch\n";
+    throw Error::Range();
+  } 
+
+  typename V::const_iterator vit = v.begin();
+  for(iterator it = begin(); it != end(); ++it, ++vit)
+    *it += *vit;
+
+  return *this;
+}
+
+template<class V>
+Quaternion& Quaternion::operator-= (const V& v) 
+{
+  const char funame [] = "Quaternion::operator-=: ";
+
+  if(v.size() != 4) {
+    std::cerr << funame << "dimensions mismatch\n";
+    throw Error::Range();
+  } 
+
+  typename V::const_iterator vit = v.begin();
+  for(iterator it = begin(); it != end(); ++it, ++vit)
+    *it -= *vit;
 
   return *this;
 }
@@ -20,6 +20,7 @@
 
 #include <cmath>
 #include <sstream>
+#include <iomanip>
 
 /********************************************************************************
  *                                    Input/Output                              *
@@ -635,6 +636,29 @@ void DivSur::Sphere::random_orient (Dynamic::Coordinates& dv) const
     }
 }
 
+bool DivSur::Sphere::test (const Dynamic::Coordinates& dv) const
+{
+  static const double tol = 1.e-10;
+
+  // pivot point to pivot point distance is within the pivots lengths sum from the
+  // center of mass distance
+  double pivot_sum = 0.;
+  for(int frag = 0; frag < 2; ++frag)
+    if(Structure::fragment(frag).type() != Molecule::MONOATOMIC)
+      pivot_sum += _pivot_len[frag];
+
+  const double cm_dist = vlength(dv.orb_pos(), 3);
+  const double margin  = tol * (_dist + cm_dist + pivot_sum);
+
+  if(cm_dist - pivot_sum > _dist + margin)
+    return false;
+
+  if(cm_dist + pivot_sum < _dist - margin)
+    return true;
+
+  return Primitive::test(dv);
+}
+
 D3::Vector DivSur::Sphere::_lf_pp_12 (const Dynamic::Coordinates& dv) const
 {
   // temporary variables
@@ -960,6 +984,7 @@ void DivSur::OneSur::read (std::istream& from)
       IO::LineInput lin(from);
       _prod = Logical::read_expr(lin);
       _prod->init(_fmap);
+      _prod_prog = Logical::Program(*_prod);
     }
     else {
       std::cerr << funame << "unknown keyword: " << token << "\n";
@@ -998,10 +1023,8 @@ bool DivSur::OneSur::test (const Dynamic::Coordinates& dc) const
     throw Error::Init();
   }
 
-    std::vector<bool> facet_test(size());
-    for(int i = 0; i < size(); ++i)
-      facet_test[i] = PrimSet::test(i, dc);
-    return _prod->evaluate(facet_test);
+    LazyTest facet_test(*this, dc);
+    return _prod_prog.lazy_evaluate(facet_test);
 }
 
 DivSur::OneSur::SmpRes DivSur::OneSur::facet_test (int face, const Dynamic::Coordinates& dc) const
@@ -1026,20 +1049,17 @@ DivSur::OneSur::SmpRes DivSur::OneSur::facet_test (int face, const Dynamic::Coor
     return res;
   }
 
-  std::vector<bool> facet_test(size());
-  for(int i = 0; i < size(); ++i)
-    if(i != face)
-      facet_test[i] = PrimSet::test(i, dc);
+  LazyTest facet_test(*this, dc);
 
   // Boundary test:
   // configuration is in the inner part of the configurational 
   // space in relation to the facet
-  facet_test[face] = true;
-  res.inner = _prod->evaluate(facet_test);
+  facet_test.set(face, true);
+  res.inner = _prod_prog.lazy_evaluate(facet_test);
   // configuration is in the outer part of the configurational 
   // space in relation to the facet
-  facet_test[face] = false;
-  bool outer = _prod->evaluate(facet_test);
+  facet_test.set(face, false);
+  bool outer = _prod_prog.lazy_evaluate(facet_test);
 
   if(res.inner == outer)
     res.stat = SmpRes::INNER;
@@ -1125,11 +1145,13 @@ void DivSur::MultiSur::read (std::istream& from)
 	throw Error::Range();
       }
       _species.resize(itemp);
+      _species_prog.resize(itemp);
 
       for(int s = 0; s < _species.size(); ++s) {
 	IO::LineInput lin(from);
 	_species[s] = Logical::read_expr(lin);
 	_species[s]->init(_fmap);
+	_species_prog[s] = Logical::Program(*_species[s]);
       }
     }// species
     else {
@@ -1197,13 +1219,11 @@ int DivSur::MultiSur::classify  (const Dynamic::Coordinates& dc) const
 {
   const char funame [] = "DivSur::MultiSur::classify: ";
 
-  std::vector<bool> surface_test(primitive_size());
-  for(int i = 0; i < primitive_size(); ++i)
-    surface_test[i] = DivSur::PrimSet::test(i, dc);
+  LazyTest surface_test(*this, dc);
 
   std::vector<int> res;
   for(int s = 0; s < _species.size(); ++s)
-    if(_species[s]->evaluate(surface_test))
+    if(_species_prog[s].lazy_evaluate(surface_test))
       res.push_back(s);
   
   if(!res.size())
@@ -1228,6 +1248,17 @@ bool DivSur::MultiSur::species_test (int spec, const Dynamic::Coordinates& dc) c
   return false;   
 }
 
+std::string DivSur::MultiSur::primitive_signature (int sur) const
+{
+  std::ostringstream to;
+
+  to << std::setprecision(17);
+
+  PrimSet::signature(sur, to);
+
+  return to.str();
+}
+
 DivSur::MultiSur::SmpRes DivSur::MultiSur::facet_test (int sur, const Dynamic::Coordinates& dc) const 
   
 {
@@ -1253,21 +1284,18 @@ DivSur::MultiSur::SmpRes DivSur::MultiSur::facet_test (int sur, const Dynamic::C
   }
 
   // to which actual facet does the configuration belong 
-  std::vector<bool> surface_test(primitive_size());
-  for(int i = 0; i < primitive_size(); ++i)
-    if(i != sur)
-      surface_test[i] = DivSur::PrimSet::test(i, dc);
+  LazyTest surface_test(*this, dc);
 
   // species tests
   std::vector<bool> negative_test(_species.size());
-  surface_test[sur] = false;
+  surface_test.set(sur, false);
   for(int s = 0; s < _species.size(); ++s)
-    negative_test[s] = _species[s]->evaluate(surface_test);
+    negative_test[s] = _species_prog[s].lazy_evaluate(surface_test);
 
   std::vector<bool> positive_test(_species.size());
-  surface_test[sur] = true;
+  surface_test.set(sur, true);
   for(int s = 0; s < _species.size(); ++s)
-    positive_test[s] = _species[s]->evaluate(surface_test);
+    positive_test[s] = _species_prog[s].lazy_evaluate(surface_test);
 
   // analyze the results
   std::set<int> inner, from, to;
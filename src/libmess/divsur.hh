@@ -89,9 +89,13 @@ namespace DivSur {
     // should be redefined for each real surface
     virtual void print (std::ostream&) const = 0;
 
+    // everything the random orientation depends on: the configurations sampled on
+    // the surfaces of the same signature are equally distributed
+    virtual void signature (std::ostream& to) const { print(to); }
+
     // Test if the configuration is inside of the surface
     // Inside corresponds to the positive distance
-    bool test (const Dynamic::Coordinates& dv) const;
+    virtual bool test (const Dynamic::Coordinates& dv) const;
 
     // The statistical weight of the configuration on the surface
     double weight (const Dynamic::Coordinates& dv) const;
@@ -122,6 +126,7 @@ namespace DivSur {
 
   class Sphere : public Primitive {
     D3::Vector _pivot[2];
+    double _pivot_len[2];
     double _dist;
 
     // lab frame pp2pp vector, 1->2
@@ -135,6 +140,9 @@ namespace DivSur {
     { return _dist - _lf_pp_12(dv).vlength(); } 
     void   random_orient   (Dynamic::Coordinates& dv) const;
 
+    // the center of mass distance bounds decide most of the tests
+    bool test (const Dynamic::Coordinates& dv) const;
+
     ~Sphere () {}
 
     void print (std::ostream&) const;
@@ -158,6 +166,7 @@ namespace DivSur {
 	throw Error::Form();
       }
       _pivot[frag] = *pvt;
+      _pivot_len[frag] = _pivot[frag].vlength();
     }
   }
 
@@ -186,6 +195,8 @@ namespace DivSur {
 
     void print (std::ostream&) const;
 
+    void signature (std::ostream& to) const { print(to); to << ", sampling circle radius = " << _radius; }
+
     // specific functions
     void set_circle (double r) {_radius = r + _pivot.vlength() ; }
   };
@@ -238,6 +249,8 @@ namespace DivSur {
     double weight   (int face, const Dynamic::Coordinates& dc) const { return _sur[face]->weight(dc); }
     double distance (int face, const Dynamic::Coordinates& dc) const { return _sur[face]->distance(dc); }
 
+    void signature (int face, std::ostream& to) const { _sur[face]->signature(to); }
+
     int size () const { return _sur.size(); }
 
     void read (std::istream&) ;
@@ -245,6 +258,25 @@ namespace DivSur {
     void print (std::ostream&, const std::string&) const;
 
     virtual ~PrimSet () {}
+
+    // primitive tests done on request and remembered, for the logical programs
+    class LazyTest {
+      const PrimSet&              _set;
+      const Dynamic::Coordinates& _dc;
+      std::vector<signed char>    _val;
+
+    public:
+      LazyTest (const PrimSet& s, const Dynamic::Coordinates& dc) : _set(s), _dc(dc), _val(s.size(), -1) {}
+
+      void set (int i, bool v) { _val[i] = v; }
+
+      bool operator() (int i) 
+      { 
+	if(_val[i] < 0) 
+	  _val[i] = _set.test(i, _dc); 
+	return _val[i]; 
+      }
+    };
   };
     
   /********************************************************************************
@@ -258,6 +290,7 @@ namespace DivSur {
 
     // product definition
     SharedPointer<Logical::Expr> _prod;
+    Logical::Program             _prod_prog;
 
   public:
     OneSur ()                   : _isinit(false) {}
@@ -300,6 +333,7 @@ namespace DivSur {
 
     // definitions of bound species 
     std::vector<SharedPointer<Logical::Expr> > _species;
+    std::vector<Logical::Program>              _species_prog;
 
   public:
     MultiSur ()                   : _isinit(false) {}
@@ -354,6 +388,9 @@ namespace DivSur {
     // distance to the primitive surface
     double primitive_distance (int sur, const Dynamic::Coordinates& dc) const { return PrimSet::distance(sur, dc); }
 
+    // the primitive surface signature, in full precision
+    std::string primitive_signature (int sur) const ;
+
     // read the surface from the input stream
     void read (std::istream&) ;
 
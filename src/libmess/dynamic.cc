@@ -83,43 +83,18 @@ void Dynamic::set_dvd (const D3::Vector* torque,
  ***************************************************************************************/
 
 void Dynamic::CartData::init (int frag) {
-  _delete();
+  const char funame [] = "Dynamic::CartData::init: ";
 
-  _frag = frag;
-  _rel_pos.resize(Structure::fragment(frag).size()); 
-  _mfo = 0;
-  _ang = 0;
-
-  switch(Structure::fragment(frag).type()) {
-  case Molecule::MONOATOMIC:
-    _rel_pos[0] = 0.;
-    break;
-  case Molecule::LINEAR:
-    _ang = new double[3];
-    break;
-  case Molecule::NONLINEAR:
-    _mfo = new D3::Matrix;
-    break;
+  if(Structure::fragment(frag).size() > ATOM_SIZE_MAX) {
+    std::cerr << funame << frag << "-th fragment: number of atoms, " << Structure::fragment(frag).size()
+	      << ", exceeds the maximum, " << ATOM_SIZE_MAX << "\n";
+    throw Error::Range();
   }
-}
-
-void Dynamic::CartData::_copy (const CartData& c)
-{
-  _frag = c._frag;
-  _rel_pos = c._rel_pos;
 
-  if(c._mfo)
-    _mfo = new D3::Matrix(*c._mfo);
-  else
-    _mfo = 0;
+  _frag = frag;
 
-  if(c._ang) {
-    _ang = new double[3];
-    for(int i = 0; i < 3; ++i)
-      _ang[i] = c._ang[i];
-  }
-  else
-    _ang = 0;
+  if(Structure::fragment(frag).type() == Molecule::MONOATOMIC)
+    _rel_pos[0] = 0.;
 }
     
 void Dynamic::CartData::mf2lf (const double* mf, double* lf) const 
@@ -143,7 +118,7 @@ void Dynamic::CartData::mf2lf (const double* mf, double* lf) const
     break;
 
   case Molecule::NONLINEAR:
-    D3::vprod(mf, *_mfo, lf);
+    D3::vprod(mf, _mfo, lf);
     break;
   }
 }
@@ -166,7 +141,7 @@ double Dynamic::CartData::imm (int i, int j) const
   case Molecule::NONLINEAR:
     dtemp = 0.;
     for(int k = 0; k < 3; ++k)
-      dtemp += Structure::fragment(_frag).imom(k) * (*_mfo)(k, i) * (*_mfo)(k, j);
+      dtemp += Structure::fragment(_frag).imom(k) * _mfo(k, i) * _mfo(k, j);
     return dtemp;
   default:
     std::cerr << funame << "wrong case\n";
@@ -203,7 +178,7 @@ void Dynamic::CartData::lf2mf (const double* lf, double* mf) const
     break;
 
   case Molecule::NONLINEAR:
-    D3::vprod(*_mfo, lf, mf);
+    D3::vprod(_mfo, lf, mf);
     break;
   }
 }
@@ -223,7 +198,7 @@ void Dynamic::CartData::update_mfo(const double* ang)
     break;
 
   case Molecule::NONLINEAR:
-    quat2mat(ang, *_mfo);
+    quat2mat(ang, _mfo);
     break;
   }
 }
@@ -260,9 +235,16 @@ bool Dynamic::Coordinates::are_atoms_close () const
 
 void Dynamic::Coordinates::_init ()
 {
-  _orb_pos = begin() + Structure::orb_pos();
+  const char funame [] = "Dynamic::Coordinates::_init: ";
+
+  if(size() > POS_SIZE_MAX) {
+    std::cerr << funame << "coordinates dimension out of range: " << size() << "\n";
+    throw Error::Logic();
+  }
+
+  _orb_shift = Structure::orb_pos();
   for(int frag = 0; frag < 2; ++frag) {
-    _ang_pos[frag] = begin() + Structure::ang_pos(frag);
+    _ang_shift[frag] = Structure::ang_pos(frag);
 
     // initialize fragments cartesian data
     _fragment[frag].init(frag);
@@ -271,7 +253,8 @@ void Dynamic::Coordinates::_init ()
 
 void Dynamic::Coordinates::get (const double* dv) 
 {
-  Array<double>::operator=(dv);
+  for(int i = 0; i < size(); ++i)
+    _pos[i] = dv[i];
 
   for(int frag = 0; frag < 2; ++frag)
     _normalize(frag);
@@ -282,59 +265,37 @@ void Dynamic::Coordinates::get (const double* dv)
 void Dynamic::Coordinates::put (double* dv) const
 {
   for(int i = 0; i < size(); ++i)
-    dv[i] = (*this)[i];
+    dv[i] = _pos[i];
 }
 
 void Dynamic::Coordinates::_normalize (int frag) 
 {
   if(Structure::fragment(frag).type() != Molecule::MONOATOMIC)
-    _length[frag] = normalize(_ang_pos[frag], Structure::fragment(frag).pos_size());
+    _length[frag] = normalize(ang_pos(frag), Structure::fragment(frag).pos_size());
   else
     _length[frag] = 0.;
 }
 
-Dynamic::Coordinates::Coordinates () : Array<double>(size())
+Dynamic::Coordinates::Coordinates ()
 {
   const char funame [] = "Dynamic::Coordinates::Coordinates (): ";
 	
-  //set pointers and initialize cartesian data
+  //set offsets and initialize cartesian data
   _init();
 
   // some simple initialization
-  *(Array<double>*)this = 0.;
+  for(int i = 0; i < POS_SIZE_MAX; ++i)
+    _pos[i] = 0.;
+
   for(int frag = 0; frag < 2; ++frag)
     if(Structure::fragment(frag).type() != Molecule::MONOATOMIC)
-      _ang_pos[frag][0] = 1.;
+      ang_pos(frag)[0] = 1.;
 
   // initialize update info
   _init_update();
 
 }
 
-Dynamic::Coordinates::Coordinates(const Coordinates& c) : Array<double>((const Array<double>&)c)
-{
-  _init();
-
-  for(int frag = 0; frag < 2; ++frag)
-    _fragment[frag] = c._fragment[frag];
-
-  for(int i = 0; i < SIZE; ++i)
-    _update[i] = c._update[i];
-}
-
-Dynamic::Coordinates& Dynamic::Coordinates::operator= (const Coordinates& c)
-{
-  Array<double>::operator=((const Array<double>&)c);
-
-  for(int frag = 0; frag < 2; ++frag)
-    _fragment[frag] = c._fragment[frag];
-
-  for(int i = 0; i < SIZE; ++i)
-    _update[i] = c._update[i];
-
-  return *this;
-}
-
 void Dynamic::Coordinates::_init_update () const
 {
   for(int frag = 0; frag < 2; ++frag)
@@ -386,7 +347,7 @@ void Dynamic::Coordinates::write_ang_pos (int frag, const double* pos)
   _update[REL + frag] = _update[MFO + frag] = true;
 
   for(int i = 0; i < Structure::fragment(frag).pos_size(); ++i)
-    _ang_pos[frag][i] = pos[i];
+    ang_pos(frag)[i] = pos[i];
 	
   _normalize(frag);
 }
@@ -398,7 +359,7 @@ void Dynamic::Coordinates::print_geom (std::ostream& to, const std::string& inde
   
   to << indent << "Geometry, Angstrom:\n";
   for(int frag = 0; frag < 2; ++frag)
-    for(int at = 0; at < rel_pos(frag).size(); ++at) {
+    for(int at = 0; at < Structure::fragment(frag).size(); ++at) {
       to << indent << "   " << std::setw(3) << Structure::fragment(frag)[at].name();
       for(int i = 0; i < 3; ++i)
 		if(!frag)
@@ -437,9 +398,9 @@ void Dynamic::Coordinates::print_geom (std::ostream& to, const std::string& inde
     to << std::setw(15) << Structure::fragment(1)[at1].name();
   to << "\n";
 
-  for(int at0 = 0; at0 < rel_pos(0).size(); ++at0) {
+  for(int at0 = 0; at0 < Structure::fragment(0).size(); ++at0) {
     to << indent << "   " << std::setw(3) << Structure::fragment(0)[at0].name();
-    for(int at1 = 0; at1 < rel_pos(1).size(); ++at1) {
+    for(int at1 = 0; at1 < Structure::fragment(1).size(); ++at1) {
       dist = 0.;
       for(int i = 0; i < 3; ++i) {
 	dtemp = rel_pos(1)[at1][i] + orb_pos(i) - rel_pos(0)[at0][i];
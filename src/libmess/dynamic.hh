@@ -37,28 +37,28 @@ namespace Dynamic {
    *                 Cartesian data for Coordinates class              *
    ********************************************************************/
 
+  // fixed layout: copied by value, no heap storage
+  //
   class CartData 
   {
+  public:
+    enum { ATOM_SIZE_MAX = 64 }; // maximal number of atoms in the fragment
+
+  private:
     int _frag;
-    std::vector<D3::Vector> _rel_pos; // relative positions of the fragment atoms in lab frame
-    D3::Matrix* _mfo; // rotational matrix for a nonlinear fragment
-    double* _ang;     // angular vector for a linear fragment    
-    void _delete ();
-    void _copy (const CartData&);
+    D3::Vector _rel_pos [ATOM_SIZE_MAX]; // relative positions of the fragment atoms in lab frame
+    D3::Matrix _mfo; // rotational matrix for a nonlinear fragment
+    double _ang [3]; // angular vector for a linear fragment    
 
   public:
-    CartData () : _mfo(0), _ang(0), _frag(-1) {}
+    CartData () : _frag(-1) {}
     void init (int frag);
-    CartData (int frag) : _mfo(0), _ang(0) { init(frag); }
-
-    ~CartData () { _delete(); }
-    CartData (const CartData& c) { _copy(c); }
-    CartData& operator= (const CartData& c) { _delete(); _copy(c); return *this; }
+    CartData (int frag) { init(frag); }
 
     void mf2lf (const double* mf, double* lf) const ;
     void lf2mf (const double* lf, double* mf) const ;
 
-    const std::vector<D3::Vector>& rel_pos () const { return _rel_pos; }
+    const D3::Vector* rel_pos () const { return _rel_pos; }
 
     void update_mfo(const double* ang) ;
     void update_rel()  ;
@@ -68,27 +68,27 @@ namespace Dynamic {
 
   };
 
-  inline void CartData::_delete ()
-  {
-    if(_mfo) 
-      delete _mfo; 
-    if(_ang)
-      delete[] _ang;
-  }
-
   /*********************************************************************
    *                       Orientational coordinates                   *
    *********************************************************************/
 
-  class Coordinates : private Array<double>
+  // fixed layout: copied by value and stored contiguously
+  //
+  class Coordinates
   {
+    enum { POS_SIZE_MAX = 11 }; // orbital and two nonlinear fragments coordinates
+
+    double _pos [POS_SIZE_MAX];
+
+    // offsets rather than pointers: the default copy is valid
+    int _orb_shift;
+    int _ang_shift [2];
+
     mutable CartData _fragment [2];
-    double* _orb_pos;
-    double* _ang_pos [2];
 
     double _length [2];
 
-    void _init (); // set pointers
+    void _init (); // set offsets
 
     void _normalize (int frag); // normalize fragment angular vector
 
@@ -103,8 +103,6 @@ namespace Dynamic {
   public:
     Coordinates ();
     Coordinates (const double* dv);
-    Coordinates (const Coordinates& c);
-    Coordinates& operator= (const Coordinates& c);
 
     static int size () { return Structure::pos_size(); }
 
@@ -113,13 +111,13 @@ namespace Dynamic {
     double length (int frag) const { return _length[frag]; } // the length of original angular vector
 
     // cm-to-cm vector, 1->2
-    double*       orb_pos  ()            { return _orb_pos; }
-    const double* orb_pos  ()      const { return _orb_pos; }
+    double*       orb_pos  ()            { return _pos + _orb_shift; }
+    const double* orb_pos  ()      const { return _pos + _orb_shift; }
 
-    double&       orb_pos  (int i)       { return _orb_pos[i]; }
-    double        orb_pos  (int i) const { return _orb_pos[i]; }
+    double&       orb_pos  (int i)       { return _pos[_orb_shift + i]; }
+    double        orb_pos  (int i) const { return _pos[_orb_shift + i]; }
 
-    double interfragment_distance () const { return vlength(_orb_pos, 3); }
+    double interfragment_distance () const { return vlength(orb_pos(), 3); }
 
     // orientational variables
     void    write_ang_pos (int frag, const double* pos) ;
@@ -130,7 +128,7 @@ namespace Dynamic {
     double        ang_pos (int frag, int i)       const ;
     double&       ang_pos (int frag, int i)             ;
 
-    const std::vector<D3::Vector>& rel_pos (int frag)    const;
+    const D3::Vector* rel_pos (int frag)    const;
     void mf2lf (int frag, const double* mf, double* lf)  const;
     void lf2mf (int frag, const double* lf, double* mf)  const;
     Lapack::SymmetricMatrix imm () const;
@@ -146,9 +144,9 @@ namespace Dynamic {
 
   };
 
-  inline Coordinates::Coordinates (const double* dv) : Array<double>(size())
+  inline Coordinates::Coordinates (const double* dv)
   {
-    // set pointers and initialize cartesian data
+    // set offsets and initialize cartesian data
     _init();
 
     // copy data and normalize angular vectors
@@ -171,7 +169,7 @@ namespace Dynamic {
 
 #endif
 
-    return _ang_pos[frag]; 
+    return _pos + _ang_shift[frag]; 
   }
 
   inline double* Coordinates::ang_pos  (int frag) 
@@ -187,7 +185,7 @@ namespace Dynamic {
 
 #endif
 
-    return _ang_pos[frag]; 
+    return _pos + _ang_shift[frag]; 
   }
 
   inline double Coordinates::ang_pos  (int frag, int i) const 
@@ -203,7 +201,7 @@ namespace Dynamic {
 
 #endif
 
-    return _ang_pos[frag][i]; 
+    return _pos[_ang_shift[frag] + i]; 
   }
 
   inline double& Coordinates::ang_pos  (int frag, int i) 
@@ -219,7 +217,7 @@ namespace Dynamic {
 
 #endif
 
-    return _ang_pos[frag][i]; 
+    return _pos[_ang_shift[frag] + i]; 
   }
 
   inline void Coordinates::mf2lf(int frag, const double* mf, double* lf) const
@@ -243,7 +241,7 @@ namespace Dynamic {
     _update[MFO + frag] = false;
   }
 
-  inline const std::vector<D3::Vector>& Coordinates::rel_pos (int frag) const
+  inline const D3::Vector* Coordinates::rel_pos (int frag) const
   {
     if(_update[REL + frag]) _update_rel(frag);
 
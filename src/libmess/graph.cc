@@ -3956,9 +3956,9 @@ double GraphExpansion::_fg_t::fourier_sum (const std::vector<double>& freq, doub
 
   MultiIndexConvert harmonic_index(index_range);
 
-  for(long ml = 0; ml < harmonic_index.size(); ++ml) {
+  for(MultiIndexConvert::Iterator hit(harmonic_index); !hit.end(); ++hit) {
     //
-    std::vector<int> mi = harmonic_index(ml);
+    std::vector<int> mi = hit.index();
 
     for(int i = 0; i < mi.size(); ++i)
       //
@@ -6,6 +6,15 @@
 #include "units.hh"
 
 #include <list>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <algorithm>
 #include <cmath>
 #include <complex>
 
@@ -42,6 +51,20 @@ namespace Graph {
   const_iterator begin () { _check_init(); return _sorted_graph.begin(); }  
 
   std::set<GenGraph> _raw_graph_generator (std::vector<int> vertex_order, int root = -1);
+
+  std::string cache_dir;
+
+  // generic graphs cache file format version
+  //
+  const int _graph_cache_version = 1;
+
+  std::string _graph_cache_file ();
+
+  bool _load_graphs ();
+
+  void _save_graphs ();
+
+  void _print_graphs ();
 }
 
 void Graph::_check_init () 
@@ -80,6 +103,15 @@ void Graph::init ()
     //
     potex_rank[i] = i + 3;
 
+  // generic graphs depend on the maximal number of bonds and the potential expansion order only
+  //
+  if(cache_dir.size() && _load_graphs()) {
+    //
+    _print_graphs();
+
+    return;
+  }
+
   std::vector<int> glimit(potex_rank.size());
   //
   for(int i = 0; i < potex_rank.size(); ++i)
@@ -276,7 +308,21 @@ void Graph::init ()
     IO::log << IO::log_offset << "number of unconnected graphs = " << unconnected << "\n";
 
     IO::log << IO::log_offset << "number of permutationally distinct graphs = " << graph_count << "\n\n";
+  }
+
+  _print_graphs();
 
+  if(cache_dir.size())
+    //
+    _save_graphs();
+}
+
+void Graph::_print_graphs ()
+{
+  int itemp;
+
+  if(!IO::mpi_rank) {
+    //
     IO::log << IO::log_offset << "permutationally distinct graphs(" << _sorted_graph.size() << "):\n";
 
     IO::log << IO::log_offset
@@ -303,6 +349,144 @@ void Graph::init ()
   }
 }
 
+/*************************************************************************************
+ ********************************* GRAPH CACHE FILES *********************************
+ *************************************************************************************/
+
+std::string Graph::cache_file (const std::string& key, const std::string& suffix)
+{
+  return cache_dir + "/" + IO::hash_name(key) + suffix;
+}
+
+std::string Graph::_graph_cache_file ()
+{
+  std::ostringstream key;
+
+  key << "GenGraph " << _graph_cache_version << " " << bond_max << " " << potex_max;
+
+  return cache_file(key.str(), ".graph");
+}
+
+// file structure: version, maximal number of bonds, potential expansion order, number of graphs,
+// and then for each graph the number of bonds followed by the bonds, each as the number of its vertices and the vertices
+//
+bool Graph::_load_graphs ()
+{
+  const std::string name = _graph_cache_file();
+
+  std::ifstream from(name.c_str(), std::ios::binary);
+
+  if(!from)
+    //
+    return false;
+
+  int head [4];
+
+  if(!from.read((char*)head, sizeof(head)) || head[0] != _graph_cache_version || head[1] != bond_max || head[2] != potex_max || head[3] <= 0) {
+    //
+    IO::log << IO::log_offset << "WARNING: generic graphs cache " << name << " does not match, ignoring\n";
+
+    return false;
+  }
+
+  std::vector<GenGraph> graph(head[3]);
+
+  int bsize, vsize, v;
+
+  for(int g = 0; g < graph.size(); ++g) {
+    //
+    if(!from.read((char*)&bsize, sizeof(bsize)) || bsize <= 0)
+      //
+      break;
+
+    for(int b = 0; b < bsize && from; ++b) {
+      //
+      if(!from.read((char*)&vsize, sizeof(vsize)) || vsize != 2) {
+	//
+	from.setstate(std::ios::failbit);
+
+	break;
+      }
+
+      std::multiset<int> bond;
+
+      for(int i = 0; i < vsize && from.read((char*)&v, sizeof(v)); ++i)
+	//
+	bond.insert(v);
+
+      graph[g].insert(bond);
+    }
+
+    if(!from)
+      //
+      break;
+  }
+
+  if(!from) {
+    //
+    IO::log << IO::log_offset << "WARNING: cannot read generic graphs cache " << name << ", ignoring\n";
+
+    return false;
+  }
+
+  _sorted_graph = graph;
+
+  if(!IO::mpi_rank)
+    //
+    IO::log << IO::log_offset << "generic graphs read from " << name << "\n\n";
+
+  return true;
+}
+
+void Graph::_save_graphs ()
+{
+  if(IO::mpi_rank)
+    //
+    return;
+
+  const std::string name = _graph_cache_file();
+
+  IO::AtomicFile to(name);
+
+  if(!to) {
+    //
+    IO::log << IO::log_offset << "WARNING: cannot open generic graphs cache file " << to.tmp_name() << "\n";
+
+    return;
+  }
+
+  int head [4] = {_graph_cache_version, bond_max, potex_max, (int)_sorted_graph.size()};
+
+  to.write((const char*)head, sizeof(head));
+
+  int itemp;
+
+  for(std::vector<GenGraph>::const_iterator git = _sorted_graph.begin(); git != _sorted_graph.end(); ++git) {
+    //
+    itemp = git->size();
+
+    to.write((const char*)&itemp, sizeof(itemp));
+
+    for(GenGraph::const_iterator bit = git->begin(); bit != git->end(); ++bit) {
+      //
+      itemp = bit->size();
+
+      to.write((const char*)&itemp, sizeof(itemp));
+
+      for(std::multiset<int>::const_iterator it = bit->begin(); it != bit->end(); ++it) {
+	//
+	itemp = *it;
+
+	to.write((const char*)&itemp, sizeof(itemp));
+      }
+    }
+  }
+
+  if(!to.commit())
+    //
+    IO::log << IO::log_offset << "WARNING: cannot write generic graphs cache file " << name << "\n";
+}
+
 /*************************************************************************************
  ************************ GENERIC PERTURBATION THEORY GRAPH **************************
  *************************************************************************************/
@@ -786,6 +970,171 @@ std::set<Graph::FreqGraph> Graph::FreqGraph::perm_pool (int* symm, int flag) con
   return res;
 }
 
+// refines the vertex coloring until it is stable: the vertices of the same color are
+// split by their loops and by the colors and frequencies of their bonds; the new colors
+// are the ranks of the vertex signatures, so the coloring does not depend on the vertex labels
+//
+void Graph::FreqGraph::_refine_color (std::vector<int>& color) const
+{
+  typedef std::pair<int, std::multiset<int> >                    _bond_t;
+  typedef std::pair<std::pair<int, std::multiset<int> >, std::vector<_bond_t> > _sig_t;
+
+  const int vsize = color.size();
+
+  int csize = std::set<int>(color.begin(), color.end()).size();
+
+  while(csize < vsize) {
+    //
+    std::vector<_sig_t> sig(vsize);
+
+    for(int v = 0; v < vsize; ++v)
+      //
+      sig[v].first.first = color[v];
+
+    for(const_iterator git = begin(); git != end(); ++git) {
+      //
+      if(git->first.size() == 1) {
+	//
+	sig[*git->first.begin()].first.second = git->second;
+
+	continue;
+      }
+
+      const int v = *git->first.begin();
+      const int u = *git->first.rbegin();
+
+      sig[v].second.push_back(_bond_t(color[u], git->second));
+      sig[u].second.push_back(_bond_t(color[v], git->second));
+    }
+
+    for(int v = 0; v < vsize; ++v)
+      //
+      std::sort(sig[v].second.begin(), sig[v].second.end());
+
+    std::vector<_sig_t> rank = sig;
+
+    std::sort(rank.begin(), rank.end());
+
+    rank.erase(std::unique(rank.begin(), rank.end()), rank.end());
+
+    if(rank.size() == csize)
+      //
+      return;
+
+    csize = rank.size();
+
+    for(int v = 0; v < vsize; ++v)
+      //
+      color[v] = std::lower_bound(rank.begin(), rank.end(), sig[v]) - rank.begin();
+  }
+}
+
+// the first vertex of the smallest non-trivial color class is individualized in turn;
+// the canonical graph is the minimal graph over the leaves of the search tree
+//
+void Graph::FreqGraph::_canonical_search (const std::vector<int>& color, FreqGraph& res, bool& isinit) const
+{
+  const int vsize = color.size();
+
+  std::vector<int> csize(vsize);
+
+  for(int v = 0; v < vsize; ++v)
+    //
+    ++csize[color[v]];
+
+  int cell = -1;
+
+  for(int c = 0; c < vsize; ++c)
+    //
+    if(csize[c] > 1 && (cell < 0 || csize[c] < csize[cell]))
+      //
+      cell = c;
+
+  // discrete coloring: the colors are the new vertex labels
+  //
+  if(cell < 0) {
+    //
+    FreqGraph perm_graph;
+
+    for(const_iterator git = begin(); git != end(); ++git) {
+      //
+      std::set<int> bond;
+
+      for(std::set<int>::const_iterator bit = git->first.begin(); bit != git->first.end(); ++bit)
+	//
+	bond.insert(color[*bit]);
+
+      perm_graph[bond] = git->second;
+    }
+
+    if(!isinit || perm_graph < res) {
+      //
+      isinit = true;
+
+      res = perm_graph;
+    }
+
+    return;
+  }
+
+  for(int v = 0; v < vsize; ++v) {
+    //
+    if(color[v] != cell)
+      //
+      continue;
+
+    std::vector<int> new_color = color;
+
+    for(int u = 0; u < vsize; ++u)
+      //
+      if(color[u] > cell || color[u] == cell && u != v)
+	//
+	++new_color[u];
+
+    _refine_color(new_color);
+
+    _canonical_search(new_color, res, isinit);
+  }
+}
+
+Graph::FreqGraph Graph::FreqGraph::canonical () const
+{
+  const char funame [] = "Graph::FreqGraph::canonical: ";
+
+  _check_integrity();
+
+  if(!size())
+    //
+    return *this;
+  
+  std::set<int> vertex_pool;
+  //
+  for(const_iterator git = begin(); git != end(); ++git)
+    //
+    for(std::set<int>::const_iterator it = git->first.begin(); it != git->first.end(); ++it)
+      //
+      vertex_pool.insert(*it);
+
+  if(*vertex_pool.begin() || *vertex_pool.rbegin() >= vertex_pool.size()) {
+    //
+    ErrOut err_out;
+
+    err_out << funame << "graph not in the standard form";
+  }
+
+  std::vector<int> color(vertex_pool.size());
+
+  _refine_color(color);
+
+  FreqGraph res;
+
+  bool isinit = false;
+
+  _canonical_search(color, res, isinit);
+
+  return res;
+}
+
 void Graph::FreqGraph::_check_order () const
 {
   const char funame [] = "Graph::FreqGraph::_check_order: ";
@@ -1676,37 +2025,31 @@ double Graph::FreqGraph::_four_term (int                        mi,
   }
 }
 
-double Graph::FreqGraph::fourier_sum (const std::vector<double>& freq, double temperature) const
+// edge frequencies and the ring structure; returns false if the fourier sum vanishes
+//
+bool Graph::FreqGraph::_four_setup (const std::vector<double>& freq, _FourData& data) const
 {
-  const char funame [] = "Graph::FreqGraph::fourier_sum: ";
+  const char funame [] = "Graph::FreqGraph::_four_setup: ";
 
   int    itemp;
   double dtemp;
   bool   btemp;
 
-  if(!size())
-    //
-    return 1. / temperature;
-
   _check_integrity(freq.size());
   //
   _check_order();
 
-  const int vsize = vertex_size();
+  std::vector<std::vector<double> >& rfreq = data.rfreq;
+  std::vector<std::vector<double> >& ifreq = data.ifreq;
+  std::vector<int>&                  nfreq = data.nfreq;
 
-  // real frequencies
-  //
-  std::vector<std::vector<double> > rfreq(size());
-  
-  //imaginary frequencies
-  //
-  std::vector<std::vector<double> > ifreq(size());
+  rfreq.clear();
+  ifreq.clear();
+  nfreq.clear();
 
-  // low frequencies
-  //
-  std::vector<int>                  nfreq(size());
-
-  bool debug = false;
+  rfreq.resize(size());
+  ifreq.resize(size());
+  nfreq.resize(size());
 
   int gi = 0;
   //
@@ -1740,8 +2083,6 @@ double Graph::FreqGraph::fourier_sum (const std::vector<double>& freq, double te
     }
   }
   
-  double res = 0.;
-  
   std::set<std::set<int> > edge_pool;
 
   for(const_iterator git = begin(); git != end(); ++git)
@@ -1777,7 +2118,7 @@ double Graph::FreqGraph::fourier_sum (const std::vector<double>& freq, double te
 
       if(git->second.size() == 1 && *git->second.begin() < 0)
 	//
-	return 0.;
+	return false;
 
       edge_pool.erase(edge_pool.begin());
     }
@@ -1815,7 +2156,7 @@ double Graph::FreqGraph::fourier_sum (const std::vector<double>& freq, double te
       rit0 = ring_set.erase(rit0);
   }
 
-  std::vector<std::map<int, int> > index_map;
+  data.index_map.clear();
 
   for(const_iterator git = begin(); git != end(); ++git) {
     //
@@ -1832,10 +2173,29 @@ double Graph::FreqGraph::fourier_sum (const std::vector<double>& freq, double te
 	im[itemp] = s;
     }
 
-    index_map.push_back(im);
+    data.index_map.push_back(im);
   }
 
-  itemp = ring_set.size();
+  data.ring_size = ring_set.size();
+
+  return true;
+}
+
+// every term of the fourier sum is evaluated for all temperatures in turn; the edge terms
+// depend on the summation indices only through the bounded edge index, so they are
+// tabulated once, and the summation reduces to the products of the table entries
+//
+void Graph::FreqGraph::_four_eval (const _FourData& data, const double* temperature, int tsize, double* res) const
+{
+  int itemp;
+
+  const std::vector<std::vector<double> >& rfreq = data.rfreq;
+  const std::vector<std::vector<double> >& ifreq = data.ifreq;
+  const std::vector<int>&                  nfreq = data.nfreq;
+
+  const int vsize = vertex_size();
+
+  itemp = data.ring_size;
 
   for(int i = 0; i < size(); ++i) {
     //
@@ -1850,67 +2210,186 @@ double Graph::FreqGraph::fourier_sum (const std::vector<double>& freq, double te
     
   if(!idim) {
     //
-    res = 1.;
-    
-    for(int i = 0; i < size(); ++i)
+    for(int t = 0; t < tsize; ++t) {
       //
-      res *= _four_term(0, temperature, rfreq[i], ifreq[i]);
+      res[t] = 1.;
+    
+      for(int i = 0; i < size(); ++i)
+	//
+	res[t] *= _four_term(0, temperature[t], rfreq[i], ifreq[i]);
+    }
   }
   else {
     //
+    for(int t = 0; t < tsize; ++t)
+      //
+      res[t] = 0.;
+
+    // zero frequency terms: index x temperature
+    //
+    std::vector<double> zero_term((four_cut + 1) * tsize);
+
+    for(int m = 0; m <= four_cut; ++m)
+      //
+      for(int t = 0; t < tsize; ++t)
+	//
+	zero_term[m * tsize + t] = _four_term(m, temperature[t]);
+
+    // flattened ring index maps, the number of the zero frequency indices, and
+    // the edge terms tables (absolute edge index x temperature)
+    //
+    std::vector<std::vector<std::pair<int, int> > > ring_index(size());
+
+    std::vector<int> zero_size(size());
+
+    std::vector<std::vector<double> > edge_term(size());
+
+    for(int i = 0; i < size(); ++i) {
+      //
+      int mmax = 0;
+
+      for(std::map<int, int>::const_iterator mit = data.index_map[i].begin(); mit != data.index_map[i].end(); ++mit) {
+	//
+	ring_index[i].push_back(*mit);
+
+	mmax += mit->second < 0 ? -mit->second : mit->second;
+      }
+
+      itemp = -1;
+	  
+      if(rfreq[i].size() || ifreq[i].size())
+	//
+	++itemp;
+
+      itemp += nfreq[i];
+
+      zero_size[i] = itemp;
+
+      mmax = (mmax + itemp) * four_cut;
+
+      edge_term[i].resize((mmax + 1) * tsize);
+
+      for(int m = 0; m <= mmax; ++m)
+	//
+	for(int t = 0; t < tsize; ++t)
+	  //
+	  edge_term[i][m * tsize + t] = _four_term(m, temperature[t], rfreq[i], ifreq[i]);
+    }
+
+    std::vector<double> gvalue(tsize);
+
     for(MultiIndex multi(idim, 2 * four_cut); !multi.end(); ++multi) {
       //
-      double gvalue = 1.;
+      for(int t = 0; t < tsize; ++t)
+	//
+	gvalue[t] = 1.;
 
-      int ci = ring_set.size();
+      int ci = data.ring_size;
 	
       for(int i = 0; i < size(); ++i) {
 	//
 	int mindex = 0;
 	
-	for(std::map<int, int>::const_iterator mit = index_map[i].begin(); mit != index_map[i].end(); ++mit)
-	  //
-	  mindex += mit->second * (multi[mit->first] - four_cut);
-
-	itemp = -1;
-	  
-	if(rfreq[i].size() || ifreq[i].size())
+	for(int r = 0; r < ring_index[i].size(); ++r)
 	  //
-	  ++itemp;
-
-	itemp += nfreq[i];
+	  mindex += ring_index[i][r].second * (multi[ring_index[i][r].first] - four_cut);
 
-	const int nf = itemp;
-	  
-	for(int j = 0; j < nf; ++j, ++ci) {
+	for(int j = 0; j < zero_size[i]; ++j, ++ci) {
 	  //
 	  itemp = multi[ci] - four_cut;
 	    
 	  mindex -= itemp ;
 
-	  gvalue *= _four_term(itemp, temperature);
+	  const double* zp = &zero_term[(itemp < 0 ? -itemp : itemp) * tsize];
+
+	  for(int t = 0; t < tsize; ++t)
+	    //
+	    gvalue[t] *= zp[t];
 	}
 
-	gvalue *= _four_term(mindex, temperature, rfreq[i], ifreq[i]);
+	const double* ep = &edge_term[i][(mindex < 0 ? -mindex : mindex) * tsize];
+
+	for(int t = 0; t < tsize; ++t)
+	  //
+	  gvalue[t] *= ep[t];
       }
 
-      res += gvalue;
+      for(int t = 0; t < tsize; ++t)
+	//
+	res[t] += gvalue[t];
     }
   }
+
   // normalization
   //
-  for(int i = 0; i < size(); ++i) {
+  for(int t = 0; t < tsize; ++t) {
     //
-    for(int f = 0; f < rfreq[i].size(); ++f)
+    for(int i = 0; i < size(); ++i) {
       //
-      res /= 2. * rfreq[i][f] * std::sinh(rfreq[i][f] / 2. / temperature);
+      for(int f = 0; f < rfreq[i].size(); ++f)
+	//
+	res[t] /= 2. * rfreq[i][f] * std::sinh(rfreq[i][f] / 2. / temperature[t]);
 
-    for(int f = 0; f < ifreq[i].size(); ++f)
+      for(int f = 0; f < ifreq[i].size(); ++f)
+	//
+	res[t] /= -2. * ifreq[i][f] * std::sin(ifreq[i][f] / 2. / temperature[t]);
+    }
+
+    res[t] /= std::pow(temperature[t], (double)vsize);
+  }
+}
+
+void Graph::FreqGraph::fourier_sum (const std::vector<double>& freq, const double* temperature, int tsize, double* res) const
+{
+  if(!size()) {
+    //
+    for(int t = 0; t < tsize; ++t)
       //
-      res /= -2. * ifreq[i][f] * std::sin(ifreq[i][f] / 2. / temperature);
+      res[t] = 1. / temperature[t];
+
+    return;
   }
 
-  res /= std::pow(temperature, (double)vsize);
+  _FourData data;
+
+  if(!_four_setup(freq, data)) {
+    //
+    for(int t = 0; t < tsize; ++t)
+      //
+      res[t] = 0.;
+
+    return;
+  }
+
+  _four_eval(data, temperature, tsize, res);
+}
+
+double Graph::FreqGraph::fourier_sum (const std::vector<double>& freq, double temperature) const
+{
+  const char funame [] = "Graph::FreqGraph::fourier_sum: ";
+
+  int    itemp;
+  double dtemp;
+
+  if(!size())
+    //
+    return 1. / temperature;
+
+  const int vsize = vertex_size();
+
+  _FourData data;
+
+  if(!_four_setup(freq, data))
+    //
+    return 0.;
+
+  double res;
+
+  _four_eval(data, &temperature, 1, &res);
+
+  bool debug = false;
+
+  int gi = 0;
 
   /*****************************************************************************
    * OLD WAY TO CALCULATE FOURIER TRANSFORMED GREEN FUNCTIONS SUM BY DIRECTLY  *
@@ -1992,9 +2471,9 @@ double Graph::FreqGraph::fourier_sum (const std::vector<double>& freq, double te
 
     MultiIndexConvert harmonic_index(index_range);
 
-    for(long ml = 0; ml < harmonic_index.size(); ++ml) {
+    for(MultiIndexConvert::Iterator hit(harmonic_index); !hit.end(); ++hit) {
       //
-      std::vector<int> mi = harmonic_index(ml);
+      std::vector<int> mi = hit.index();
 
       for(int i = 0; i < mi.size(); ++i)
 	//
@@ -2070,7 +2549,7 @@ double Graph::FreqGraph::fourier_sum (const std::vector<double>& freq, double te
   
     old_res /= std::pow(temperature, vsize) * std::pow(4. * M_PI * M_PI * temperature, freq_map.size());
 
-    std::cout << funame << *this << " >>> rings # = " << ring_set.size() << std::endl;
+    std::cout << funame << *this << " >>> rings # = " << data.ring_size << std::endl;
   
     std::cout << funame
 	      << "old fourier sum = " << std::left << std::setw(13) << old_res
@@ -2318,3 +2797,226 @@ std::set<Graph::GenGraph> Graph::_raw_graph_generator (std::vector<int> vertex_o
   return res;
 }
   
+
+/********************************************************************************************
+ ********************************* POTENTIAL EXPANSION TABLE ********************************
+ ********************************************************************************************/
+
+void Graph::PotexTable::init (const potex_t& potex)
+{
+  const char funame [] = "Graph::PotexTable::init: ";
+
+  _shared = SharedPointer<SharedRegion>();
+
+  _term_size.clear();
+
+  // the map order is the lexicographic order of the sorted tuples
+  //
+  for(potex_t::const_iterator pit = potex.begin(); pit != potex.end(); ++pit) {
+    //
+    const int rank = pit->first.size();
+
+    if(rank > RANK_MAX) {
+      //
+      ErrOut err_out;
+
+      err_out << funame << "potential expansion rank out of range: " << rank;
+    }
+
+    if(rank >= _term_size.size())
+      //
+      _term_size.resize(rank + 1, 0);
+
+    ++_term_size[rank];
+  }
+
+  // the values first, then the index tuples
+  //
+  _index_start.resize(_term_size.size());
+  _value_start.resize(_term_size.size());
+
+  long count = 0;
+  
+  for(int r = 0; r < _term_size.size(); ++r) {
+    //
+    _value_start[r] = count * sizeof(double);
+
+    count += _term_size[r];
+  }
+
+  long index_count = 0;
+  
+  for(int r = 0; r < _term_size.size(); ++r) {
+    //
+    _index_start[r] = count * sizeof(double) + index_count * sizeof(int);
+
+    index_count += _term_size[r] * r;
+  }
+
+  _store_size = count * sizeof(double) + index_count * sizeof(int);
+
+  _store.resize(_store_size / sizeof(double) + 1);
+
+  char* base = (char*)&_store[0];
+
+  std::vector<long> term_count(_term_size.size(), 0);
+
+  for(potex_t::const_iterator pit = potex.begin(); pit != potex.end(); ++pit) {
+    //
+    const int rank = pit->first.size();
+
+    const long t = term_count[rank]++;
+
+    ((double*)(base + _value_start[rank]))[t] = pit->second;
+
+    int* ip = (int*)(base + _index_start[rank]) + t * rank;
+
+    for(std::multiset<int>::const_iterator it = pit->first.begin(); it != pit->first.end(); ++it)
+      //
+      *ip++ = *it;
+  }
+}
+
+bool Graph::PotexTable::find (int* index, int rank, double& value) const
+{
+  if(rank >= _term_size.size() || !_term_size[rank])
+    //
+    return false;
+
+  // insertion sort
+  //
+  for(int i = 1; i < rank; ++i) {
+    //
+    const int itemp = index[i];
+
+    int j = i;
+
+    for(; j > 0 && index[j - 1] > itemp; --j)
+      //
+      index[j] = index[j - 1];
+
+    index[j] = itemp;
+  }
+
+  const int* base = (const int*)(_data() + _index_start[rank]);
+
+  long lo = 0, hi = _term_size[rank];
+
+  while(lo < hi) {
+    //
+    const long mid = (lo + hi) / 2;
+
+    const int* tp = base + mid * rank;
+
+    int comp = 0;
+
+    for(int i = 0; i < rank && !comp; ++i)
+      //
+      if(tp[i] < index[i]) {
+	//
+	comp = -1;
+      }
+      else if(tp[i] > index[i])
+	//
+	comp = 1;
+
+    if(comp < 0) {
+      //
+      lo = mid + 1;
+    }
+    else if(comp > 0) {
+      //
+      hi = mid;
+    }
+    else {
+      //
+      value = ((const double*)(_data() + _value_start[rank]))[mid];
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void Graph::PotexTable::share (const std::string& name, bool create)
+{
+  const char funame [] = "Graph::PotexTable::share: ";
+
+  if(_shared) {
+    //
+    ErrOut err_out;
+
+    err_out << funame << "already shared";
+  }
+
+  if(!_store_size)
+    //
+    return;
+
+  _shared = SharedPointer<SharedRegion>(new SharedRegion(name, _store_size, create ? &_store[0] : 0));
+
+  std::vector<double>().swap(_store);
+}
+
+/********************************************************************************************
+ ************************************ SHARED MEMORY REGION **********************************
+ ********************************************************************************************/
+
+Graph::SharedRegion::SharedRegion (const std::string& name, std::size_t size, const void* data)
+  : _data(0), _size(size)
+{
+  const char funame [] = "Graph::SharedRegion::SharedRegion: ";
+
+  const int fd = data ? shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600) : shm_open(name.c_str(), O_RDONLY, 0);
+
+  if(fd < 0) {
+    //
+    ErrOut err_out;
+
+    err_out << funame << name << ": shm_open failed: " << std::strerror(errno);
+  }
+
+  if(data && ftruncate(fd, _size)) {
+    //
+    close(fd);
+
+    ErrOut err_out;
+
+    err_out << funame << name << ": ftruncate failed: " << std::strerror(errno);
+  }
+
+  _data = mmap(0, _size, data ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+
+  close(fd);
+
+  if(_data == MAP_FAILED) {
+    //
+    _data = 0;
+
+    ErrOut err_out;
+
+    err_out << funame << name << ": mmap failed: " << std::strerror(errno);
+  }
+
+  if(data) {
+    //
+    std::memcpy(_data, data, _size);
+
+    // the creating process reads it as the others do
+    //
+    mprotect(_data, _size, PROT_READ);
+  }
+}
+
+Graph::SharedRegion::~SharedRegion ()
+{
+  if(_data)
+    //
+    munmap(_data, _size);
+}
+
+void Graph::SharedRegion::unlink (const std::string& name)
+{
+  shm_unlink(name.c_str());
+}
@@ -20,6 +20,9 @@
 #include<set>
 #include<map>
 #include<iostream>
+#include<string>
+
+#include "shared.hh"
 
 namespace Graph {
 
@@ -47,6 +50,14 @@ namespace Graph {
 
   bool isinit ();
 
+  // directory for the generic graphs and the graph integrals cache files, no cache if empty
+  //
+  extern std::string cache_dir;
+
+  // cache file name made from the hash of the cache entry key
+  //
+  std::string cache_file (const std::string& key, const std::string& suffix);
+
   /*******************************************************************************
    ********************** GENERIC PERTURBATION THEORY GRAPH **********************
    *******************************************************************************/
@@ -112,11 +123,34 @@ namespace Graph {
     
     _Ring _min_ring (const std::set<int>&) const;
 
+    // vertex coloring refinement and the canonical form search
+    //
+    void _refine_color (std::vector<int>&) const;
+
+    void _canonical_search (const std::vector<int>&, FreqGraph&, bool&) const;
+
     double _four_term (int                        mi,
 		       double                     temperature,
 		       const std::vector<double>& rfreq = std::vector<double>(),
 		       const std::vector<double>& ifreq = std::vector<double>()) const;
 
+    // temperature independent part of the fourier sum: edge frequencies and the ring structure
+    //
+    struct _FourData {
+      //
+      std::vector<std::vector<double> > rfreq; // real frequencies
+      std::vector<std::vector<double> > ifreq; // imaginary frequencies
+      std::vector<int>                  nfreq; // number of low frequencies
+
+      std::vector<std::map<int, int> >  index_map;
+
+      int ring_size;
+    };
+
+    bool _four_setup (const std::vector<double>& freq, _FourData&) const;
+
+    void _four_eval  (const _FourData&, const double* temperature, int size, double* res) const;
+
   public:
     //
     int vertex_size () const;
@@ -135,6 +169,11 @@ namespace Graph {
     //
     std::set<FreqGraph> perm_pool   (int* =0, int =0) const;
 
+    // canonical representative of the permutationally equivalent graphs
+    // (vertex color refinement with individualization), standard vertex form only
+    //
+    FreqGraph canonical () const;
+
     // reduce graph with strongly coupled vertices
     //
     FreqGraph reduce (const std::vector<double>& freq,
@@ -161,6 +200,10 @@ namespace Graph {
     //
     double fourier_sum (const std::vector<double>& freq, double temperature) const;
 
+    // the same for several temperatures: the ring structure is found once
+    //
+    void   fourier_sum (const std::vector<double>& freq, const double* temperature, int size, double* res) const;
+
     // fourier sum cutoff
     //
     static int    four_cut;
@@ -175,6 +218,76 @@ namespace Graph {
   inline std::ostream& operator<< (std::ostream& to, const FreqGraph& g) { g.print(to); return to; }
 
   void read_potex (const std::vector<double>& freq, std::istream& from, std::map<std::multiset<int>, double>& potex);
+
+  // read-only POSIX shared memory object: created and filled by one process, mapped by the others
+  //
+  class SharedRegion {
+    //
+    void*       _data;
+    std::size_t _size;
+
+    SharedRegion (const SharedRegion&);
+    SharedRegion& operator= (const SharedRegion&);
+
+  public:
+    //
+    // the object is created from the data if given, mapped otherwise
+    //
+    SharedRegion (const std::string& name, std::size_t size, const void* data = 0);
+    ~SharedRegion ();
+
+    const void* data () const { return _data; }
+
+    // the name is removed, the mapping stays: called after all the processes are mapped
+    //
+    static void unlink (const std::string& name);
+  };
+
+  // read-only flat form of the potential expansion: for each rank the sorted index tuples
+  // are kept in one contiguous array and searched by bisection, without allocations; the
+  // storage may be shared by the processes of the node
+  //
+  class PotexTable {
+    //
+    // the index tuples and the values of all ranks in one 8-byte aligned block
+    //
+    std::vector<double> _store;
+
+    // the block mapped from the shared memory, if any
+    //
+    SharedPointer<SharedRegion> _shared;
+
+    const char* _data () const { return _shared ? (const char*)_shared->data() : (const char*)&_store[0]; }
+
+    // number of terms, index and value offsets (bytes) by rank
+    //
+    std::vector<long> _term_size;
+    std::vector<long> _index_start;
+    std::vector<long> _value_start;
+
+    long _store_size;// bytes
+
+  public:
+    //
+    enum { RANK_MAX = 32 };
+
+    PotexTable () : _store_size(0) {}
+
+    explicit PotexTable (const potex_t& potex) { init(potex); }
+
+    void init (const potex_t&);
+
+    // index is sorted in place; returns false if the term does not exist
+    //
+    bool find (int* index, int rank, double& value) const;
+
+    // the terms storage is moved to (create) or read from the shared memory object, the
+    // tables set with the same potential expansion having the same layout
+    //
+    void share (const std::string& name, bool create);
+
+    long byte_size () const { return _store_size; }
+  };
 }
 
 #endif  
@@ -173,3 +173,616 @@ void Graph::Expansion::_set_frequencies (std::vector<double> freq)
     IO::log << "\n\n";
   }
 }
+
+// the force constant of the term in the dimensionless normal coordinates is the bound
+// on its magnitude; the modes which are left out of all terms are not enumerated
+//
+void Graph::Expansion::_screen_potex (const std::vector<double>& freq, const potex_t& pex)
+{
+  const char funame [] = "Graph::Expansion::_screen_potex: ";
+
+  double dtemp;
+
+  _potex.clear();
+
+  std::set<int> active_pool;
+
+  int drop_size = 0;
+
+  for(potex_t::const_iterator pit = pex.begin(); pit != pex.end(); ++pit) {
+    //
+    dtemp = std::fabs(pit->second);
+
+    for(std::multiset<int>::const_iterator it = pit->first.begin(); it != pit->first.end(); ++it) {
+      //
+      if(*it < 0 || *it >= freq.size()) {
+	//
+	ErrOut err_out;
+
+	err_out << funame << "normal mode index out of range: " << *it;
+      }
+
+      dtemp /= std::sqrt(std::fabs(freq[*it]));
+    }
+
+    if(potex_tol > 0. && dtemp < potex_tol) {
+      //
+      ++drop_size;
+
+      continue;
+    }
+
+    _potex.insert(*pit);
+
+    active_pool.insert(pit->first.begin(), pit->first.end());
+  }
+
+  _potex_table.init(_potex);
+
+  _active_mode.assign(active_pool.begin(), active_pool.end());
+
+  if(!IO::mpi_rank && (drop_size || _active_mode.size() < freq.size())) {
+    //
+    IO::log << IO::log_offset << "potential expansion screening: " << drop_size << " terms dropped out of " << pex.size()
+	    << ", " << _active_mode.size() << " normal modes out of " << freq.size() << " are enumerated\n\n";
+  }
+}
+
+/*************************************************************************************************
+ ****************************** FREQUENCY ADAPTED GRAPH CONVERTER ********************************
+ *************************************************************************************************/
+
+void Graph::Expansion::_Convert::init (int v, int f)
+{
+  const char funame [] = "Graph::Expansion::_Convert::init: ";
+
+  int itemp;
+  
+  _vertex_size_max = v;
+
+  _freq_size       = f;
+
+  if(v <= 0 || f <= 0) {
+    //
+    ErrOut err_out;
+
+    err_out << funame << "maximum number of vertices and/or number of frequencies out of range: " << v << ", " << f;
+  }
+
+  // check if the used integer type can accommodate the graph data
+  //
+  if(sizeof(int_t) < sizeof(int)) {
+    //
+    itemp = 1;
+
+    itemp <<= sizeof(int_t) * 8 - 1;
+    
+    if(itemp < f * v * (v - 1) / 2) {
+      //
+      ErrOut err_out;
+
+      err_out << funame << "integer type is too small to accommodate graph data";
+    }
+  }
+
+  _index_map.resize(v * (v - 1) / 2);
+
+  itemp = 0;
+  //
+  for(int i = 1; i < v; ++i) {
+    //
+    for(int j = 0; j < i; ++j, ++itemp) {
+      //
+      _index_map[itemp].insert(i);
+   
+      _index_map[itemp].insert(j);
+    }
+  }
+}
+
+Graph::FreqGraph Graph::Expansion::_Convert::operator() (const vec_t& gconv) const
+{
+  const char funame [] = "Graph::Expansion::_Convert::operator(): ";
+  
+  int itemp;
+
+  if(!_vertex_size_max) {
+    //
+    ErrOut err_out;
+
+    err_out << funame << "frequency graph data converter not initialized";
+  }
+
+  FreqGraph res;
+
+  if(!gconv.size())
+    return res;
+
+  for(int i = 0; i < gconv.size(); ++i) {
+    //
+    if(gconv[i] < 0) {
+      //
+      ErrOut err_out;
+
+      err_out << funame << "negative index";
+    }
+
+    itemp = gconv[i] / _freq_size;
+    
+    if(itemp >= _vertex_size_max * (_vertex_size_max - 1) / 2) {
+      //
+      ErrOut err_out;
+      //
+      err_out << funame << "vertex index convert out of range";
+    }
+    
+    res[_index_map[itemp]].insert(gconv[i] % _freq_size - 1);
+  }
+
+  return res;
+}
+  
+Graph::Expansion::_Convert::vec_t Graph::Expansion::_Convert::operator() (const FreqGraph& freq_graph) const
+{
+  const char funame [] = "Graph::Expansion::_Convert::operator(): ";
+  
+  int itemp;
+
+  if(!_vertex_size_max) {
+    //
+    ErrOut err_out;
+
+    err_out << funame << "frequency graph converter not initialized";
+  }
+  
+  if(!freq_graph.size())
+    //
+    return vec_t();
+  
+  if(freq_graph.vertex_size() > _vertex_size_max) {
+    //
+    ErrOut err_out;
+
+    err_out << funame << "number of vertices exceeds the maximum: " << freq_graph.vertex_size();
+  }
+  
+  vec_t res(freq_graph.bond_size());
+  
+  int bond_index = 0;
+  //
+  for(FreqGraph::const_iterator git = freq_graph.begin(); git != freq_graph.end(); ++git) {
+    //
+    itemp  = *git->first.rbegin();
+    //
+    itemp  = *git->first.begin() + itemp * (itemp - 1) / 2;
+    //
+    itemp *= _freq_size;
+    
+    for(std::multiset<int>::const_iterator fit = git->second.begin(); fit != git->second.end(); ++fit, ++bond_index) {
+      //
+      if(*fit < -1 || *fit >= _freq_size - 1) {
+	//
+	ErrOut err_out;
+
+	err_out << funame << "frequency index out of range: " << *fit;
+      }
+
+      res[bond_index] = itemp + *fit + 1;
+    }
+  }
+  return res;  
+}
+
+Graph::Expansion::_gmap_t::_gmap_t () : _mem_max(0), _evict_size(0), _spill_size(0)
+{
+#ifdef _OPENMP
+  for(int i = 0; i < SHARD_SIZE; ++i)
+    omp_init_lock(_lock + i);
+
+  omp_init_lock(&_spill_lock);
+#endif
+
+  for(int i = 0; i < SHARD_SIZE; ++i)
+    _mem[i] = 0;
+
+  // the budget is shared by the zpe, the integral, and the fourier sum databases
+  //
+  if(db_mem_max > 0)
+    //
+    _mem_max = db_mem_max / 3 / SHARD_SIZE;
+
+  if(_mem_max && spill_dir.size()) {
+    //
+    static int count = 0;
+
+    std::ostringstream name;
+
+#pragma omp critical(graph_spill_count)
+    name << spill_dir << "/graph_db." << getpid() << "." << count++;
+
+    _spill_name = name.str();
+
+    _spill.open(_spill_name.c_str(), std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+
+    if(!_spill) {
+      //
+      IO::log << IO::log_offset << "WARNING: cannot open graph database spill file " << _spill_name << ", no spilling\n";
+
+      _spill_name.clear();
+    }
+  }
+}
+
+Graph::Expansion::_gmap_t::~_gmap_t ()
+{
+#ifdef _OPENMP
+  for(int i = 0; i < SHARD_SIZE; ++i)
+    omp_destroy_lock(_lock + i);
+
+  omp_destroy_lock(&_spill_lock);
+#endif
+
+  if(_spill_name.size()) {
+    //
+    _spill.close();
+
+    std::remove(_spill_name.c_str());
+  }
+}
+
+// FNV-1a hash of the compact graph encoding
+//
+int Graph::Expansion::_gmap_t::_shard_index (const _Convert::vec_t& key)
+{
+  unsigned res = 2166136261u;
+
+  const _Convert::int_t* p = key;
+
+  for(int i = 0; i < key.size(); ++i) {
+    res ^= (unsigned char)p[i];
+    res *= 16777619u;
+  }
+
+  return res % SHARD_SIZE;
+}
+
+// map node: key array header and data, three pointers, color, the value, and the hit count
+//
+long Graph::Expansion::_gmap_t::_entry_mem (const _Convert::vec_t& key)
+{
+  return (long)_Convert::mem_size(key) + long(sizeof(_Convert::vec_t) + sizeof(_entry_t)) + 32;
+}
+
+bool Graph::Expansion::_gmap_t::find (const _Convert::vec_t& key, double& value) const
+{
+  const int s = _shard_index(key);
+
+#ifdef _OPENMP
+  omp_set_lock(_lock + s);
+#endif
+
+  std::map<_Convert::vec_t, _entry_t>::iterator dit = _shard[s].find(key);
+
+  bool res = dit != _shard[s].end();
+
+  if(res) {
+    //
+    value = dit->second.value;
+
+    ++dit->second.hits;
+  }
+
+  const bool spilled = !res && _spill_run[s].size();
+
+#ifdef _OPENMP
+  omp_unset_lock(_lock + s);
+#endif
+
+  if(spilled)
+    //
+    res = _spill_find(s, key, value);
+
+  return res;
+}
+
+bool Graph::Expansion::_gmap_t::insert (const _Convert::vec_t& key, double value)
+{
+  const int s = _shard_index(key);
+
+#ifdef _OPENMP
+  omp_set_lock(_lock + s);
+#endif
+
+  _entry_t entry = {value, 0};
+
+  const bool res = _shard[s].insert(std::make_pair(key, entry)).second;
+
+  if(res) {
+    //
+    _mem[s] += _entry_mem(key);
+
+    if(_mem_max && _mem[s] > _mem_max)
+      //
+      _evict(s);
+  }
+
+#ifdef _OPENMP
+  omp_unset_lock(_lock + s);
+#endif
+
+  return res;
+}
+
+// the least reused half of the shard is removed (or spilled to the disk), and
+// the hit counts of the rest are halved, so that the old hits fade away
+//
+void Graph::Expansion::_gmap_t::_evict (int s)
+{
+  std::map<_Convert::vec_t, _entry_t>& shard = _shard[s];
+
+  std::vector<unsigned> hits;
+
+  hits.reserve(shard.size());
+
+  for(std::map<_Convert::vec_t, _entry_t>::const_iterator dit = shard.begin(); dit != shard.end(); ++dit)
+    //
+    hits.push_back(dit->second.hits);
+
+  std::vector<unsigned>::iterator mid = hits.begin() + hits.size() / 2;
+
+  std::nth_element(hits.begin(), mid, hits.end());
+
+  const unsigned hit_min = *mid;
+
+  std::vector<std::pair<_Convert::vec_t, double> > cold;
+
+  long count = 0;
+
+  for(std::map<_Convert::vec_t, _entry_t>::iterator dit = shard.begin(); dit != shard.end();) {
+    //
+    if(dit->second.hits < hit_min || dit->second.hits == hit_min && _mem[s] > _mem_max / 2) {
+      //
+      _mem[s] -= _entry_mem(dit->first);
+
+      if(_spill_name.size())
+	//
+	cold.push_back(std::make_pair(dit->first, dit->second.value));
+
+      shard.erase(dit++);
+
+      ++count;
+    }
+    else {
+      //
+      dit->second.hits /= 2;
+
+      ++dit;
+    }
+  }
+
+#pragma omp atomic
+  _evict_size += count;
+
+  if(cold.size())
+    //
+    _spill_write(s, cold);
+}
+
+int Graph::Expansion::_gmap_t::_record_size () { return 1 + SPILL_KEY_MAX * sizeof(_Convert::int_t) + sizeof(double); }
+
+// spilled entries: each eviction appends a sorted run of fixed size records
+//
+void Graph::Expansion::_gmap_t::_spill_write (int s, const std::vector<std::pair<_Convert::vec_t, double> >& cold)
+{
+  std::vector<char> buff(_record_size() * cold.size());
+
+  int count = 0;
+
+  for(int i = 0; i < cold.size(); ++i) {
+    //
+    const int ksize = cold[i].first.size();
+
+    if(ksize > SPILL_KEY_MAX)
+      //
+      continue;
+
+    char* rec = &buff[_record_size() * count++];
+
+    std::memset(rec, 0, _record_size());
+
+    rec[0] = ksize;
+
+    if(ksize)
+      //
+      std::memcpy(rec + 1, (const _Convert::int_t*)cold[i].first, ksize * sizeof(_Convert::int_t));
+
+    std::memcpy(rec + 1 + SPILL_KEY_MAX * sizeof(_Convert::int_t), &cold[i].second, sizeof(double));
+  }
+
+  if(!count)
+    //
+    return;
+
+#ifdef _OPENMP
+  omp_set_lock(&_spill_lock);
+#endif
+
+  _spill.seekp(0, std::ios::end);
+
+  const long pos = _spill.tellp();
+
+  _spill.write(&buff[0], _record_size() * count);
+
+  if(_spill) {
+    //
+    _spill_run[s].push_back(std::make_pair(pos, (long)count));
+
+    _spill_size += count;
+  }
+  else
+    //
+    _spill.clear();
+
+#ifdef _OPENMP
+  omp_unset_lock(&_spill_lock);
+#endif
+}
+
+// binary search through the runs of the shard, the latest runs first
+//
+bool Graph::Expansion::_gmap_t::_spill_find (int s, const _Convert::vec_t& key, double& value) const
+{
+  if(key.size() > SPILL_KEY_MAX)
+    //
+    return false;
+
+  bool res = false;
+
+  std::vector<char> rec(_record_size());
+
+#ifdef _OPENMP
+  omp_set_lock(&_spill_lock);
+#endif
+
+  for(int r = (int)_spill_run[s].size() - 1; r >= 0 && !res; --r) {
+    //
+    long lo = 0, hi = _spill_run[s][r].second;
+
+    while(lo < hi) {
+      //
+      const long mid = (lo + hi) / 2;
+
+      _spill.seekg(_spill_run[s][r].first + mid * _record_size());
+
+      if(!_spill.read(&rec[0], _record_size())) {
+	//
+	_spill.clear();
+
+	break;
+      }
+
+      _Convert::vec_t rec_key((int)rec[0]);
+
+      if(rec_key.size())
+	//
+	std::memcpy((_Convert::int_t*)rec_key, &rec[1], rec_key.size() * sizeof(_Convert::int_t));
+
+      if(rec_key < key) {
+	//
+	lo = mid + 1;
+      }
+      else if(key < rec_key) {
+	//
+	hi = mid;
+      }
+      else {
+	//
+	std::memcpy(&value, &rec[1 + SPILL_KEY_MAX * sizeof(_Convert::int_t)], sizeof(double));
+
+	res = true;
+
+	break;
+      }
+    }
+  }
+
+#ifdef _OPENMP
+  omp_unset_lock(&_spill_lock);
+#endif
+
+  return res;
+}
+
+long Graph::Expansion::_gmap_t::size () const
+{
+  long res = 0;
+
+  for(int s = 0; s < SHARD_SIZE; ++s)
+    res += _shard[s].size();
+
+  return res;
+}
+
+void Graph::Expansion::_gmap_t::report (const char* name) const
+{
+  if(!_evict_size)
+    //
+    return;
+
+  IO::log << IO::log_offset << name << " database: " << _evict_size << " entries evicted";
+
+  if(_spill_name.size())
+    //
+    IO::log << ", " << _spill_size << " spilled";
+
+  IO::log << "\n\n";
+}
+
+long Graph::Expansion::_gmap_t::mem_size () const
+{
+  long res = 0;
+  //
+  for(int s = 0; s < SHARD_SIZE; ++s)
+    //
+    res += _mem[s];
+
+  return res;
+}
+
+void Graph::Expansion::_gmap_t::save (std::ostream& to) const
+{
+  long ltemp = size();
+
+  to.write((const char*)&ltemp, sizeof(ltemp));
+
+  int itemp;
+
+  for(int s = 0; s < SHARD_SIZE; ++s)
+    //
+    for(std::map<_Convert::vec_t, _entry_t>::const_iterator dit = _shard[s].begin(); dit != _shard[s].end(); ++dit) {
+      //
+      itemp = dit->first.size();
+
+      to.write((const char*)&itemp, sizeof(itemp));
+
+      if(itemp)
+	//
+	to.write((const char*)(const _Convert::int_t*)dit->first, itemp * sizeof(_Convert::int_t));
+
+      to.write((const char*)&dit->second.value, sizeof(double));
+    }
+}
+
+bool Graph::Expansion::_gmap_t::load (std::istream& from)
+{
+  long ltemp;
+
+  if(!from.read((char*)&ltemp, sizeof(ltemp)) || ltemp < 0)
+    //
+    return false;
+
+  int itemp;
+
+  double dtemp;
+
+  for(long i = 0; i < ltemp; ++i) {
+    //
+    if(!from.read((char*)&itemp, sizeof(itemp)) || itemp < 0)
+      //
+      return false;
+
+    _Convert::vec_t key(itemp);
+
+    if(itemp && !from.read((char*)(_Convert::int_t*)key, itemp * sizeof(_Convert::int_t)))
+      //
+      return false;
+
+    if(!from.read((char*)&dtemp, sizeof(dtemp)))
+      //
+      return false;
+
+    insert(key, dtemp);
+  }
+
+  return true;
+}
@@ -8,6 +8,12 @@
 
 #include <mpi.h>
 #include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <unistd.h>
 
 #ifndef __MPI
 #define __MPI
@@ -21,6 +27,18 @@ double Graph::Expansion::freq_tol = 0.1;
 //
 double Graph::Expansion::low_freq_thresh = 0.2;
 
+// potential expansion terms with smaller force constants are dropped (none if not positive)
+//
+double Graph::Expansion::potex_tol = -1.;
+
+// graph databases memory budget per work process, bytes (no limit if not positive)
+//
+long Graph::Expansion::db_mem_max = 0;
+
+// graph databases spill directory (no spilling if empty)
+//
+std::string Graph::Expansion::spill_dir;
+
 /********************************************************************************************
  ************************ PERTURBATION THEORY GRAPH EXPANSION *******************************
  ********************************************************************************************/
@@ -141,9 +159,39 @@ void Graph::Expansion::_master (const int mode, const double temperature, const
       }
     }
 
-    std::map<int, double> graph_value;
+    if(mpi_size < 2) {
+      //
+      ErrOut err_out;
+
+      err_out << funame << "at least one work process is needed";
+    }
+
+    // chunks of the normal mode indices: a chunk costs roughly 1 / chunk_factor
+    // of the whole work of one process
+    //
+    std::vector<long> graph_work(Graph::size());
+
+    double total_cost = 0.;
+
+    for(int gi = 0; gi < Graph::size(); ++gi) {
+      //
+      MultiIndexConvert multi;
+      
+      if(CENTROID == mode && mmat.size()) {
+	//
+	multi.resize((Graph::begin() + gi)->size() * 2, _red_freq_index.size());
+      }
+      else {
+	//
+	multi.resize((Graph::begin() + gi)->size(),     _active_mode.size());
+      }
+
+      graph_work[gi] = multi.size();
+
+      total_cost += _term_cost(*(Graph::begin() + gi)) * (double)graph_work[gi];
+    }
 
-    std::map<int, std::map<int, double> > graphex_value; // low temperature expansion
+    const double chunk_cost = total_cost / double(chunk_factor * (mpi_size - 1));
 
     int work_node = 1;
 
@@ -161,112 +209,60 @@ void Graph::Expansion::_master (const int mode, const double temperature, const
 	      << "   elapsed time[s] = " << std::setw(8) << std::time(0) - start_time
 	      << std::endl;
 
-      MultiIndexConvert multi;
-      
-      if(CENTROID == mode && mmat.size()) {
-	//
-	multi.resize((Graph::begin() + gi)->size() * 2, _red_freq_index.size());
-      }
-      else {
+      long chunk_size = long(chunk_cost / _term_cost(*(Graph::begin() + gi)));
+
+      if(chunk_size < 1)
 	//
-	multi.resize((Graph::begin() + gi)->size(),     _red_freq_index.size());
-      }
+	chunk_size = 1;
 
       //
-      // normal mode indices cycle
+      // normal mode indices chunks cycle
       //
-      for(long li = 0; li < multi.size(); ++li) {
+      for(long li = 0; li < graph_work[gi]; li += chunk_size) {
 	//
-	if(work_node < mpi_size) {
+	long chunk [3] = {gi, li, li + chunk_size};
+
+	if(chunk[2] > graph_work[gi])
 	  //
-	  MPI::COMM_WORLD.Send(&gi, 1, MPI::INT,  work_node, WORK_TAG);
+	  chunk[2] = graph_work[gi];
+
+	int node = work_node;
 
-	  MPI::COMM_WORLD.Send(&li, 1, MPI::LONG, work_node, WORK_TAG);
+	if(work_node < mpi_size) {
+	  //
 	  ++work_node;
 	}
+	// wait for a process to finish its chunk
+	//
 	else {
 	  //
-	  int gindex;
-
-	  MPI::COMM_WORLD.Recv(&gindex, 1, MPI::INT,  MPI::ANY_SOURCE, MPI::ANY_TAG, stat);
+	  MPI::COMM_WORLD.Recv(&itemp, 1, MPI::INT, MPI::ANY_SOURCE, MPI::ANY_TAG, stat);
 	  
-	  const int tag  = stat.Get_tag();
-	  const int from = stat.Get_source();
-
-	  if(tag != WORK_TAG) {
+	  if(stat.Get_tag() != WORK_TAG) {
 	    //
 	    ErrOut err_out;
 
-	    err_out << funame << "wrong tag: " << tag;
-	  }
-	  
-	  if(temperature > 0. || GLOBAL == mode) {
-	    //
-	    // graph value
-	    //
-	    MPI::COMM_WORLD.Recv(&dtemp, 1, MPI::DOUBLE, from, tag);
-
-	    graph_value[gindex] += dtemp;
+	    err_out << funame << "wrong tag: " << stat.Get_tag();
 	  }
-	  else {
-	    //
-	    // graph expansion value
-	    //
-	    _gmap_t gmap(from, tag);
 
-	    for(_gmap_t::const_iterator gmit = gmap.begin(); gmit != gmap.end(); ++gmit) {
-	      //
-	      graphex_value[gindex][gmit->first] += gmit->second;
-	    }
-	  }
-	  
-	  MPI::COMM_WORLD.Send(&gi, 1, MPI::INT,  from, WORK_TAG);
-	  MPI::COMM_WORLD.Send(&li, 1, MPI::LONG, from, WORK_TAG);
+	  node = stat.Get_source();
 	}
-	//
-	//
-      } // normal mode indices cycle
-      
-      //
-      //
-    } // main loop
 
-    // finish with the rest of receives
+	MPI::COMM_WORLD.Send(chunk, 3, MPI::LONG, node, WORK_TAG);
+      }
+    }
+
+    // finish with the rest of the chunks
     //
     for(int node = 1; node < work_node; ++node) {
       //
-      int gindex;
-
-      MPI::COMM_WORLD.Recv(&gindex, 1, MPI::INT,  MPI::ANY_SOURCE, MPI::ANY_TAG, stat);
+      MPI::COMM_WORLD.Recv(&itemp, 1, MPI::INT, MPI::ANY_SOURCE, MPI::ANY_TAG, stat);
 	  
-      const int tag  = stat.Get_tag();
-      const int from = stat.Get_source();
-
-      if(tag != WORK_TAG) {
+      if(stat.Get_tag() != WORK_TAG) {
 	//
 	ErrOut err_out;
 
-	err_out << funame << "wrong tag: " << tag;
-      }
-      
-      // graph value
-      //
-      if(temperature > 0. || GLOBAL == mode) {
-	//
-	MPI::COMM_WORLD.Recv(&dtemp, 1, MPI::DOUBLE, from, tag);
-
-	graph_value[gindex] += dtemp;
-      }
-      // low temperature expansion graph value
-      //
-      else {
-	//
-	_gmap_t gmap(from, tag);
-
-	for(_gmap_t::const_iterator gmit = gmap.begin(); gmit != gmap.end(); ++gmit) {
-	  //
-	  graphex_value[gindex][gmit->first] += gmit->second;
-	}
+	err_out << funame << "wrong tag: " << stat.Get_tag();
       }
     }
 
@@ -274,9 +270,17 @@ void Graph::Expansion::_master (const int mode, const double temperature, const
     //
     for(int node = 1; node < mpi_size; ++node) {
       //
-      MPI::COMM_WORLD.Send(0, 0, MPI::INT, node, END_TAG);
+      MPI::COMM_WORLD.Send(0, 0, MPI::LONG, node, END_TAG);
     }
 
+    // per-order values summed over the work processes, reduced while the statistics is received
+    //
+    std::vector<double> order_value(_value_size(mode, temperature)), zero_value(order_value.size());
+
+    MPI_Request reduce_request;
+
+    MPI_Ireduce(&zero_value[0], &order_value[0], order_value.size(), MPI_DOUBLE, MPI_SUM, MASTER, MPI_COMM_WORLD, &reduce_request);
+
     double calc_time = 0.;
 
     long zpe_count = 0; // zpe calculation #
@@ -315,6 +319,8 @@ void Graph::Expansion::_master (const int mode, const double temperature, const
       }
     }
 
+    MPI_Wait(&reduce_request, MPI_STATUS_IGNORE);
+
     IO::log << "\n";
 
     IO::log << IO::log_offset
@@ -367,7 +373,9 @@ void Graph::Expansion::_master (const int mode, const double temperature, const
       //
       for(int i = 0; i < Graph::size(); ++i) {
 	//
-	corr[(Graph::begin() + i)->size()] += graph_value[i];
+	itemp = (Graph::begin() + i)->size();
+
+	corr[itemp] = order_value[itemp];
       }
 
       if(GLOBAL == mode) {
@@ -408,7 +416,9 @@ void Graph::Expansion::_master (const int mode, const double temperature, const
 	//
 	for(int i = 0; i < Graph::size(); ++i) {
 	  //
-	  zpe[(Graph::begin() + i)->size()] += graph_value[i];
+	  itemp = (Graph::begin() + i)->size();
+
+	  zpe[itemp] = order_value[itemp];
 	}
 
 	IO::log << IO::log_offset << "zero-point energy correction, 1/cm:\n";
@@ -441,9 +451,17 @@ void Graph::Expansion::_master (const int mode, const double temperature, const
 
 	for(int i = 0; i < Graph::size(); ++i) {
 	  //
-	  for(std::map<int, double>::const_iterator gxit = graphex_value[i].begin(); gxit != graphex_value[i].end(); ++gxit) {
+	  itemp = (Graph::begin() + i)->size();
+
+	  std::map<int, double>& gx = graphex[itemp];
+
+	  for(int p = -_power_max(); p <= _power_max(); ++p) {
 	    //
-	    graphex[(Graph::begin() + i)->size()][gxit->first] += gxit->second;
+	    dtemp = order_value[itemp * _power_size() + p + _power_max()];
+
+	    if(dtemp != 0.)
+	      //
+	      gx[p] = dtemp;
 	  }
 	}
 	
@@ -541,219 +559,195 @@ void Graph::Expansion::_global_work (const double temperature) const
     long red_count = 0;
     long sum_count = 0;
 
+    // graph integral databases shared by the thread team
     //
-    // main loop
+    _db_t db;
+
+    // per-order values accumulated over all the chunks and reduced over the processes at the end
     //
-    while(1) {
-      // graph index
-      int gindex;
-      MPI::COMM_WORLD.Recv(&gindex, 1, MPI::INT, MASTER, MPI::ANY_TAG, stat);
+    std::vector<double> order_value(_value_size(GLOBAL, temperature));
 
-      const int tag = stat.Get_tag();
- 
-      if(END_TAG == tag) {
-	//
-	break;
-      }
-      else if(WORK_TAG != tag) {
-	ErrOut err_out;
-	err_out << funame << "wrong tag: " << tag;
-      }
+    double* value = &order_value[0];
 
-      Graph::const_iterator graphit = Graph::begin() + gindex;
+    const int value_size = order_value.size();
 
-      // normal mode indices converted to a single linear index
-      //
-      long li;
-      MPI::COMM_WORLD.Recv(&li, 1, MPI::LONG, MASTER, WORK_TAG);
-      
-      std::vector<int> corrin = MultiIndexConvert(graphit->size(), _red_freq_index.size())(li);
+    int  gindex;
+    long li_begin, li_end;
+
+    //
+    // main loop: chunks of the normal mode indices of the same graph
+    //
+    while(_recv_chunk(gindex, li_begin, li_end)) {
       //
+      Graph::const_iterator graphit = Graph::begin() + gindex;
+
+      const int order = graphit->size();
+
+      const MultiIndexConvert corr_index(graphit->size(), _active_mode.size());
+
       const std::vector<std::multiset<int> > vertex_map = graphit->vertex_bond_map();
       //
       const int vertex_size = vertex_map.size();
-      //
-      double gfactor = 1.;
 
-      btemp = false;
-      //
-      for(std::vector<std::multiset<int> >::const_iterator mit = vertex_map.begin(); mit != vertex_map.end(); ++mit) {
+#pragma omp parallel for default(shared) reduction(+: value[:value_size], zpe_count, fac_count, red_count, sum_count) private(itemp, dtemp, btemp) schedule(dynamic)
+
+      for(long li = li_begin; li < li_end; ++li) {
 	//
-	std::multiset<int> potex_sign;
+	std::vector<int> corrin = corr_index(li);
 	//
-	for(std::multiset<int>::const_iterator it = mit->begin(); it != mit->end(); ++it)
+	for(int i = 0; i < corrin.size(); ++i)
 	  //
-	  potex_sign.insert(corrin[*it]);
-	      
-	potex_t::const_iterator pexit = _potex.find(potex_sign);
-	
-	if(pexit != _potex.end()) {
+	  corrin[i] = _active_mode[corrin[i]];
+	//
+	double gfactor = 1.;
+
+	btemp = false;
+	//
+	for(std::vector<std::multiset<int> >::const_iterator mit = vertex_map.begin(); mit != vertex_map.end(); ++mit) {
 	  //
-	  gfactor *= pexit->second;
-	}
-	else {
+	  int potex_sign [PotexTable::RANK_MAX];
 	  //
-	  btemp = true;
+	  const int rank = mit->size();
 	  //
-	  break;
+	  int si = 0;
+	  //
+	  for(std::multiset<int>::const_iterator it = mit->begin(); it != mit->end() && si < PotexTable::RANK_MAX; ++it, ++si)
+	    //
+	    potex_sign[si] = corrin[*it];
+
+	  if(rank <= PotexTable::RANK_MAX && _potex_table.find(potex_sign, rank, dtemp)) {
+	    //
+	    gfactor *= dtemp;
+	  }
+	  else {
+	    //
+	    btemp = true;
+	    //
+	    break;
+	  }
 	}
-      }
 
-      if(btemp) {
-	//
-	dtemp = 0.;
-	MPI::COMM_WORLD.Send(&gindex, 1, MPI::INT,    MASTER, WORK_TAG);
-	MPI::COMM_WORLD.Send(&dtemp,  1, MPI::DOUBLE, MASTER, WORK_TAG);
+	if(btemp)
+	  //
+	  continue;
 
-	continue;
-      }
+	gfactor /= (double)graphit->symmetry_factor();
 
-      gfactor /= (double)graphit->symmetry_factor();
+	if(vertex_size % 2)
+	  //
+	  gfactor = -gfactor;
 
-      if(vertex_size % 2)
+	// frequency adapted graph
 	//
-	gfactor = -gfactor;
-
-      // frequency adapted graph
-      //
-      FreqGraph mod_graph;
+	FreqGraph mod_graph;
       
-      itemp = 0;
-      for(GenGraph::const_iterator mit = graphit->begin(); mit != graphit->end(); ++mit, ++itemp) {
-	//
-	int ci = corrin[itemp]; // correlator index
-	//
-	int fi = _red_freq_index[ci]; // reduced frequency index
+	itemp = 0;
+	for(GenGraph::const_iterator mit = graphit->begin(); mit != graphit->end(); ++mit, ++itemp) {
+	  //
+	  int ci = corrin[itemp]; // correlator index
+	  //
+	  int fi = _red_freq_index[ci]; // reduced frequency index
 
-	// low frequency correlator is a constant
-	//
-	if(low_freq.find(fi) != low_freq.end()) {
+	  // low frequency correlator is a constant
 	  //
-	  if(_red_freq[fi] > 0.) {
-	    //
-	    gfactor *=  temperature / _red_freq[fi] / _red_freq[fi];
-	  }
-	  else {
+	  if(low_freq.find(fi) != low_freq.end()) {
 	    //
-	    gfactor *= -temperature / _red_freq[fi] / _red_freq[fi];
-	  }
+	    if(_red_freq[fi] > 0.) {
+	      //
+	      gfactor *=  temperature / _red_freq[fi] / _red_freq[fi];
+	    }
+	    else {
+	      //
+	      gfactor *= -temperature / _red_freq[fi] / _red_freq[fi];
+	    }
 
-	  continue;
-	}
+	    continue;
+	  }
 
-	std::set<int> bond;
-	//
-	for(std::multiset<int>::const_iterator it = mit->begin(); it != mit->end(); ++it)
+	  std::set<int> bond;
 	  //
-	  bond.insert(*it);
+	  for(std::multiset<int>::const_iterator it = mit->begin(); it != mit->end(); ++it)
+	    //
+	    bond.insert(*it);
 
-	// bond loop
-	//
-	if(bond.size() == 1) {
-	  //
-	  // positive temperature correlator value
+	  // bond loop
 	  //
-	  if(temperature > 0.) {
+	  if(bond.size() == 1) {
+	    //
+	    // positive temperature correlator value
 	    //
-	    gfactor /= 2. * _red_freq[fi] * tanh_factor[fi];
+	    if(temperature > 0.) {
+	      //
+	      gfactor /= 2. * _red_freq[fi] * tanh_factor[fi];
+	    }
+	    // zero temperature correlator value
+	    //
+	    else {
+	      //
+	      gfactor /= 2. * _red_freq[fi];
+	    }
 	  }
-	  // zero temperature correlator value
+	  // insert frequency index into the frequency adapted graph
 	  //
 	  else {
 	    //
-	    gfactor /= 2. * _red_freq[fi];
+	    mod_graph[bond].insert(fi);
 	  }
 	}
-	// insert frequency index into the frequency adapted graph
-	//
-	else {
-	  //
-	  mod_graph[bond].insert(fi);
-	}
-      }
 
-      // zero temperature integral (zpe factor) calculation
-      //
-      if(temperature <= 0.) {
+	// zero temperature integral (zpe factor)
 	//
-	if(mod_graph.size()) {
+	if(temperature <= 0.) {
 	  //
-	  ++zpe_count;
-	
-	  gfactor *= mod_graph.zpe_factor(_red_freq);
+	  if(mod_graph.size())
+	    //
+	    gfactor *= _zpe_value(mod_graph, db, zpe_count);
 	}
-      }
-      // thermal whole integral evaluation
-      //
-      else {
+	// thermal whole integral evaluation
 	//
-	itemp = vertex_size - mod_graph.vertex_size();
-	//
-	if(itemp)
-	  //
-	  gfactor /= std::pow(temperature, (double)itemp);
-	
-	if(mod_graph.size()) {
+	else {
 	  //
-	  ++fac_count;
-
-	  // factorize frequency adapted graph into several connected graphs
+	  itemp = vertex_size - mod_graph.vertex_size();
 	  //
-	  _mg_t fac_graph = mod_graph.factorize();
-
-	  for(_mg_t::const_iterator fgit = fac_graph.begin(); fgit != fac_graph.end(); ++fgit) {
+	  if(itemp)
 	    //
-	    ++red_count;
-
-	    // graph reduction
-	    //
-	    _mg_t zpe_graph;
+	    gfactor /= std::pow(temperature, (double)itemp);
+	
+	  if(mod_graph.size()) {
 	    //
-	    FreqGraph red_graph = fgit->first.reduce(_red_freq, temperature, tanh_factor, zpe_graph);
-	  
-	    double gf = 1.;
+	    ++fac_count;
 
-	    if(!red_graph.size()) {
-	      //
-	      gf /= temperature;
-	    }
-	    // reduced graph fourier sum calculation
+	    // factorize frequency adapted graph into several connected graphs
 	    //
-	    else {
-	      //
-	      ++sum_count;
-
-	      gf *= red_graph.fourier_sum(_red_freq, temperature);
-	    }
+	    _mg_t fac_graph = mod_graph.factorize();
 
-	    // zpe graph cycle
-	    //
-	    for(_mg_t::const_iterator zgit = zpe_graph.begin(); zgit != zpe_graph.end(); ++zgit) {
+	    for(_mg_t::const_iterator fgit = fac_graph.begin(); fgit != fac_graph.end(); ++fgit) {
 	      //
-	      // low temperature integral (zpe factor) calculation
-	      //
-	      ++zpe_count;
+	      dtemp = _int_value(fgit->first, temperature, tanh_factor, db, zpe_count, red_count, sum_count);
 
-	      dtemp = zgit->first.zpe_factor(_red_freq, temperature, tanh_factor);
-	      
-	      for(int i = 0; i < zgit->second; ++i)
+	      for(int i = 0; i < fgit->second; ++i)
 		//
-		gf *= dtemp;
+		gfactor *= dtemp;
 	    }
-	    
-	    for(int i = 0; i < fgit->second; ++i)
-	      //
-	      gfactor *= gf;
 	  }
 	}
-      }
-      
-      MPI::COMM_WORLD.Send(&gindex,  1, MPI::INT,    MASTER, WORK_TAG);
-      MPI::COMM_WORLD.Send(&gfactor, 1, MPI::DOUBLE, MASTER, WORK_TAG);
+
+	value[order] += gfactor;
+      } // normal mode indices cycle
+
+      // ready for the next chunk
+      //
+      MPI::COMM_WORLD.Send(&gindex, 1, MPI::INT, MASTER, WORK_TAG);
       //
       //
     } // main loop
 
+    // per-order values, reduced while the statistics is sent
+    //
+    MPI_Request reduce_request;
+
+    MPI_Ireduce(value, 0, value_size, MPI_DOUBLE, MPI_SUM, MASTER, MPI_COMM_WORLD, &reduce_request);
+
     calc_time = std::clock() - calc_time;
 
     dtemp = calc_time / CLOCKS_PER_SEC;
@@ -766,6 +760,8 @@ void Graph::Expansion::_global_work (const double temperature) const
       MPI::COMM_WORLD.Send(&red_count, 1, MPI::LONG, MASTER, STAT_TAG);
       MPI::COMM_WORLD.Send(&sum_count, 1, MPI::LONG, MASTER, STAT_TAG);
     }
+
+    MPI_Wait(&reduce_request, MPI_STATUS_IGNORE);
   }
   catch(Error::General) {
     std::cerr << funame << "Oops\n";
@@ -797,305 +793,270 @@ void Graph::Expansion::_centroid_work (const double temperature) const
     long red_count = 0;
     long sum_count = 0;
 
+    // graph integral databases shared by the thread team
     //
-    // main loop
+    _db_t db;
+
+    // per-order values accumulated over all the chunks and reduced over the processes at the end
     //
-    while(1) {
-      //
-      int gindex;
-      MPI::COMM_WORLD.Recv(&gindex, 1, MPI::INT, MASTER, MPI::ANY_TAG, stat);
+    std::vector<double> order_value(_value_size(CENTROID, temperature));
 
-      const int tag = stat.Get_tag();
+    double* value = &order_value[0];
 
-      if(END_TAG == tag) {
-	//
-	break;
-      }
-      else if(WORK_TAG != tag) {
-	ErrOut err_out;
-	err_out << funame << "wrong tag: " << tag;
-      }
+    const int value_size = order_value.size();
 
-      long li;
-      MPI::COMM_WORLD.Recv(&li, 1, MPI::LONG, MASTER, WORK_TAG);
+    int  gindex;
+    long li_begin, li_end;
+
+    //
+    // main loop: chunks of the normal mode indices of the same graph
+    //
+    while(_recv_chunk(gindex, li_begin, li_end)) {
       //
       Graph::const_iterator graphit = Graph::begin() + gindex;
-      //
-      std::vector<int> corrin = MultiIndexConvert(graphit->size(), _red_freq_index.size())(li);
-      //
-      const std::vector<std::multiset<int> > vertex_map = graphit->vertex_bond_map();
-      //
-      const int vertex_size = vertex_map.size();
-      //
-      double gvalue = 0.;
-      //
-      _gmap_t gmap;
-      //
-      double potfac = 1.;
 
-      btemp = false;
-      //
-      for(std::vector<std::multiset<int> >::const_iterator mit = vertex_map.begin(); mit != vertex_map.end(); ++mit) {
+      const int order = graphit->size();
+
+      const MultiIndexConvert corr_index(graphit->size(), _active_mode.size());
+
+#pragma omp parallel for default(shared) reduction(+: value[:value_size], zpe_count, fac_count, red_count, sum_count) private(itemp, dtemp, btemp) schedule(dynamic)
+
+      for(long li = li_begin; li < li_end; ++li) {
 	//
-	std::multiset<int> potex_sign;
+	std::vector<int> corrin = corr_index(li);
 	//
-	for(std::multiset<int>::const_iterator it = mit->begin(); it != mit->end(); ++it)
+	for(int i = 0; i < corrin.size(); ++i)
 	  //
-	  potex_sign.insert(corrin[*it]);
-	  
-	potex_t::const_iterator pexit = _potex.find(potex_sign);
-	
-	if(pexit != _potex.end()) {
+	  corrin[i] = _active_mode[corrin[i]];
+	//
+	const std::vector<std::multiset<int> > vertex_map = graphit->vertex_bond_map();
+	//
+	const int vertex_size = vertex_map.size();
+	//
+	double potfac = 1.;
+
+	btemp = false;
+	//
+	for(std::vector<std::multiset<int> >::const_iterator mit = vertex_map.begin(); mit != vertex_map.end(); ++mit) {
 	  //
-	  potfac *= pexit->second;
-	}
-	else {
+	  int potex_sign [PotexTable::RANK_MAX];
 	  //
-	  btemp = true;
+	  const int rank = mit->size();
 	  //
-	  break;
-	}
-      }
-
-      if(btemp) {
-
-	MPI::COMM_WORLD.Send(&gindex, 1, MPI::INT, MASTER, WORK_TAG);
-	
-	if(temperature > 0.) {
-	  //
-	  MPI::COMM_WORLD.Send(&gvalue, 1, MPI::DOUBLE, MASTER, WORK_TAG);
-	}
-	else {
+	  int si = 0;
 	  //
-	  gmap.send(MASTER, WORK_TAG);
+	  for(std::multiset<int>::const_iterator it = mit->begin(); it != mit->end() && si < PotexTable::RANK_MAX; ++it, ++si)
+	    //
+	    potex_sign[si] = corrin[*it];
+
+	  if(rank <= PotexTable::RANK_MAX && _potex_table.find(potex_sign, rank, dtemp)) {
+	    //
+	    potfac *= dtemp;
+	  }
+	  else {
+	    //
+	    btemp = true;
+	    //
+	    break;
+	  }
 	}
 
-	continue;
-      }
+	if(btemp)
+	  //
+	  continue;
 
-      potfac /= (double)graphit->symmetry_factor();
-      //
-      if(vertex_size % 2)
-	potfac = -potfac;
+	potfac /= (double)graphit->symmetry_factor();
+	//
+	if(vertex_size % 2)
+	  potfac = -potfac;
 
-      //
-      // centroid correction mask cycle
-      //
-      for(MultiIndex cmask(graphit->size(), 1); !cmask.end(); ++cmask) {
 	//
-	double gfactor = potfac;
+	// centroid correction mask cycle
+	//
+	for(MultiIndex cmask(graphit->size(), 1); !cmask.end(); ++cmask) {
+	  //
+	  double gfactor = potfac;
 
-	int    t_count = 0;
+	  int    t_count = 0;
 	
-	FreqGraph mod_graph;
+	  FreqGraph mod_graph;
 
-	itemp = 0;
+	  itemp = 0;
 
-	btemp = false;
-	//
-	for(GenGraph::const_iterator mit = graphit->begin(); mit != graphit->end(); ++mit, ++itemp) {
+	  btemp = false;
 	  //
-	  int ci = corrin[itemp]; // normal mode index
-
-	  int fi = _red_freq_index[ci];  // reduced frequency index
-
-	  if(cmask[itemp]) {
+	  for(GenGraph::const_iterator mit = graphit->begin(); mit != graphit->end(); ++mit, ++itemp) {
 	    //
-	    std::set<int> bond;
+	    int ci = corrin[itemp]; // normal mode index
 
-	    for(std::multiset<int>::const_iterator it = mit->begin(); it != mit->end(); ++it)
+	    int fi = _red_freq_index[ci];  // reduced frequency index
+
+	    if(cmask[itemp]) {
 	      //
-	      bond.insert(*it);
+	      std::set<int> bond;
+
+	      for(std::multiset<int>::const_iterator it = mit->begin(); it != mit->end(); ++it)
+		//
+		bond.insert(*it);
 	
-	    // bond loop
-	    //
-	    if(bond.size() == 1) {
+	      // bond loop
 	      //
-	      // low frequency correlator incorporates centroid correction
-	      //
-	      if(low_freq.find(fi) != low_freq.end()) {
+	      if(bond.size() == 1) {
 		//
-		gfactor /= 12. * temperature;
-	      }
-	      // thermal correlator value
-	      //
-	      else if(temperature > 0.) {
+		// low frequency correlator incorporates centroid correction
+		//
+		if(low_freq.find(fi) != low_freq.end()) {
+		  //
+		  gfactor /= 12. * temperature;
+		}
+		// thermal correlator value
+		//
+		else if(temperature > 0.) {
+		  //
+		  gfactor /= 2. * _red_freq[fi] * tanh_factor[fi];
+		}
+		// zero temperature correlator value
 		//
-		gfactor /= 2. * _red_freq[fi] * tanh_factor[fi];
+		else {
+		  //
+		  gfactor /= 2. * _red_freq[fi];
+		}
 	      }
-	      // zero temperature correlator value
+	      // include frequency index into the graph
 	      //
 	      else {
 		//
-		gfactor /= 2. * _red_freq[fi];
+		if(low_freq.find(fi) != low_freq.end()) {
+		  //
+		  mod_graph[bond].insert(-1);
+		}
+		else {
+		  //
+		  mod_graph[bond].insert(fi);
+		}
 	      }
 	    }
-	    // include frequency index into the graph
+	    // centroid correction for low frequency correlator incorporated into it
+	    //
+	    else if(low_freq.find(fi) != low_freq.end()) {
+	      //
+	      btemp = true;
+
+	      break;
+	    }
+	    // centroid correction
 	    //
 	    else {
 	      //
-	      if(low_freq.find(fi) != low_freq.end()) {
+	      if(temperature > 0.) {
+		//
+		gfactor *= temperature;
+	      }
+	      else
 		//
-		mod_graph[bond].insert(-1);
+		++t_count;
+
+	      if(_red_freq[fi] > 0.) {
+		//
+		gfactor /= -_red_freq[fi] * _red_freq[fi];
 	      }
 	      else {
 		//
-		mod_graph[bond].insert(fi);
+		gfactor /=  _red_freq[fi] * _red_freq[fi];
 	      }
 	    }
 	  }
-	  // centroid correction for low frequency correlator incorporated into it
-	  //
-	  else if(low_freq.find(fi) != low_freq.end()) {
-	    //
-	    btemp = true;
 
-	    break;
-	  }
-	  // centroid correction
+	  if(btemp)
+	    //
+	    continue;
+	
+	  itemp = vertex_size - mod_graph.vertex_size();
 	  //
-	  else {
+	  if(itemp) {
 	    //
 	    if(temperature > 0.) {
 	      //
-	      gfactor *= temperature;
+	      gfactor /= std::pow(temperature, (double)itemp);
 	    }
 	    else
-	      //
-	      ++t_count;
-
-	    if(_red_freq[fi] > 0.) {
-	      //
-	      gfactor /= -_red_freq[fi] * _red_freq[fi];
-	    }
-	    else {
-	      //
-	      gfactor /=  _red_freq[fi] * _red_freq[fi];
-	    }
+	      t_count -= itemp;
 	  }
-	}
 
-	if(btemp)
-	  //
-	  continue;
-	
-	itemp = vertex_size - mod_graph.vertex_size();
-	//
-	if(itemp) {
+	  // frequency adapted graph calculation
 	  //
-	  if(temperature > 0.) {
+	  if(mod_graph.size()) {
 	    //
-	    gfactor /= std::pow(temperature, (double)itemp);
-	  }
-	  else
-	    t_count -= itemp;
-	}
-
-	// frequency adapted graph calculation
-	//
-	if(mod_graph.size()) {
-	  //
-	  ++fac_count;
-
-	  // graph factorization into the set of connected graphs
-	  //
-	  _mg_t fac_graph = mod_graph.factorize();
+	    ++fac_count;
 
-	  // factorized graph cycle
-	  //
-	  for(_mg_t::const_iterator fgit = fac_graph.begin(); fgit != fac_graph.end(); ++fgit) {
+	    // graph factorization into the set of connected graphs
 	    //
-	    // zero temperature integral (zpe factor) calculation
-	    //
-	    if(temperature <= 0.) {
-	      //
-	      ++zpe_count;
+	    _mg_t fac_graph = mod_graph.factorize();
 
-	      dtemp = fgit->first.zpe_factor(_red_freq);
-
-	      for(int i = 0; i < fgit->second; ++i)
-		//
-		gfactor *= dtemp;
-	    
-	      t_count -= fgit->second;
-	    }
-	    // thermal whole integral calculation
+	    // factorized graph cycle
 	    //
-	    else {
+	    for(_mg_t::const_iterator fgit = fac_graph.begin(); fgit != fac_graph.end(); ++fgit) {
 	      //
-	      ++red_count;
-	    
-	      _mg_t zpe_graph;
+	      // zero temperature integral (zpe factor)
 	      //
-	      FreqGraph red_graph = fgit->first.reduce(_red_freq, temperature, tanh_factor, zpe_graph);
-	  
-	      double gf = 1.;
-
-	      if(!red_graph.size()) {
+	      if(temperature <= 0.) {
 		//
-		gf /= temperature;
-	      }
-	      else {
-		//
-		++sum_count;
+		dtemp = _zpe_value(fgit->first, db, zpe_count);
 
-		gf *= red_graph.fourier_sum(_red_freq, temperature);
+		for(int i = 0; i < fgit->second; ++i)
+		  //
+		  gfactor *= dtemp;
+	    
+		t_count -= fgit->second;
 	      }
-
-	      // zpe graph cycle
+	      // thermal whole integral
 	      //
-	      for(_mg_t::const_iterator zgit = zpe_graph.begin(); zgit != zpe_graph.end(); ++zgit) {
+	      else {
 		//
-		++zpe_count;
-
-		dtemp = zgit->first.zpe_factor(_red_freq, temperature, tanh_factor);
+		dtemp = _int_value(fgit->first, temperature, tanh_factor, db, zpe_count, red_count, sum_count);
 
-		for(int i = 0; i < zgit->second; ++i)
+		for(int i = 0; i < fgit->second; ++i)
 		  //
-		  gf *= dtemp;
-		//
-		//
-	      } // zpe graph cycle
-
-	      for(int i = 0; i < fgit->second; ++i)
-		//
-		gfactor *= gf;
-	      //
-	      //
-	    } // whole integral calculation
+		  gfactor *= dtemp;
+	      }
+	    } // factorized graph cycle
 	    //
 	    //
-	  } // factorized graph cycle
-	  //
-	  //
-	} // frequency adapted graph evaluation
+	  } // frequency adapted graph evaluation
 	  
-	if(temperature > 0.) {
+	  if(temperature > 0.) {
+	    //
+	    value[order] += gfactor;
+	  }
+	  else {
+	    //
+	    if(t_count < -_power_max() || t_count > _power_max()) {
+	      //
+	      ErrOut err_out;
+
+	      err_out << funame << "temperature power out of range: " << t_count;
+	    }
+
+	    value[order * _power_size() + t_count + _power_max()] += gfactor;
+	  }
 	  //
-	  gvalue += gfactor;
-	}
-	else {
 	  //
-	  gmap[t_count] += gfactor;
-	}
-	//
-	//
-      } // centroid correction mask cycle
-	
-      MPI::COMM_WORLD.Send(&gindex, 1, MPI::INT, MASTER, WORK_TAG);
+	} // centroid correction mask cycle
+      } // normal mode indices cycle
 
-      if(temperature > 0.) {
-	//
-	MPI::COMM_WORLD.Send(&gvalue, 1, MPI::DOUBLE, MASTER, WORK_TAG);
-      }
-      else {
-	//
-	gmap.send(MASTER, WORK_TAG);
-      }
+      // ready for the next chunk
+      //
+      MPI::COMM_WORLD.Send(&gindex, 1, MPI::INT, MASTER, WORK_TAG);
       //
       //
     } // main loop
 
+    // per-order values, reduced while the statistics is sent
+    //
+    MPI_Request reduce_request;
+
+    MPI_Ireduce(value, 0, value_size, MPI_DOUBLE, MPI_SUM, MASTER, MPI_COMM_WORLD, &reduce_request);
+
     calc_time = std::clock() - calc_time;
 
     dtemp = calc_time / CLOCKS_PER_SEC;
@@ -1111,6 +1072,8 @@ void Graph::Expansion::_centroid_work (const double temperature) const
 
       MPI::COMM_WORLD.Send(&sum_count, 1, MPI::LONG, MASTER, STAT_TAG);
     }
+
+    MPI_Wait(&reduce_request, MPI_STATUS_IGNORE);
   }
   catch(Error::General) {
     //
@@ -1145,413 +1108,367 @@ void Graph::Expansion::_centroid_work_with_constrain (const double temperature,
     long red_count = 0;
     long sum_count = 0;
 
+    // graph integral databases shared by the thread team
     //
-    // main loop
+    _db_t db;
+
+    // per-order values accumulated over all the chunks and reduced over the processes at the end
     //
-    while(1) {
-      int gindex;
-      MPI::COMM_WORLD.Recv(&gindex, 1, MPI::INT, MASTER, MPI::ANY_TAG, stat);
+    std::vector<double> order_value(_value_size(CENTROID, temperature));
 
-      const int tag = stat.Get_tag();
+    double* value = &order_value[0];
 
-      if(END_TAG == tag) {
-	//
-	break;
-      }
-      else if(WORK_TAG != tag) {
-	ErrOut err_out;
-	err_out << funame << "wrong tag: " << tag;
-      }
+    const int value_size = order_value.size();
 
-      Graph::const_iterator graphit = Graph::begin() + gindex;
+    int  gindex;
+    long li_begin, li_end;
 
-      long li;
-      MPI::COMM_WORLD.Recv(&li, 1, MPI::LONG, MASTER, WORK_TAG);
-      //
-      std::vector<int> corrin = MultiIndexConvert(graphit->size() * 2, _red_freq_index.size())(li);
-      //
-      const int vertex_size = graphit->vertex_size();
-      //
-      std::vector<std::set<int> > vertex_map(vertex_size);
+    //
+    // main loop: chunks of the normal mode indices of the same graph
+    //
+    while(_recv_chunk(gindex, li_begin, li_end)) {
       //
-      itemp = 0;
-      for(GenGraph::const_iterator git = graphit->begin(); git != graphit->end(); ++git, ++itemp) {
+      Graph::const_iterator graphit = Graph::begin() + gindex;
+
+      const int order = graphit->size();
+
+      const MultiIndexConvert corr_index(graphit->size() * 2, _red_freq_index.size());
+
+#pragma omp parallel for default(shared) reduction(+: value[:value_size], zpe_count, fac_count, red_count, sum_count) private(itemp, dtemp, btemp) schedule(dynamic)
+
+      for(long li = li_begin; li < li_end; ++li) {
 	//
-	if(git->size() != 2) {
-	  ErrOut err_out;
-	  err_out << funame << "bond should connect exactly two vertices: " << git->size();
-	}
-      
-	int v = 0;
-	for(std::multiset<int>::const_iterator bit = git->begin(); bit != git->end(); ++bit, ++v) {
+	std::vector<int> corrin = corr_index(li);
+	//
+	const int vertex_size = graphit->vertex_size();
+	//
+	std::vector<std::set<int> > vertex_map(vertex_size);
+	//
+	itemp = 0;
+	for(GenGraph::const_iterator git = graphit->begin(); git != graphit->end(); ++git, ++itemp) {
 	  //
-	  if(!vertex_map[*bit].insert(2 * itemp + v).second) {
+	  if(git->size() != 2) {
 	    ErrOut err_out;
-	    err_out << funame << "duplicated frequency index: " << 2 * itemp + v;
+	    err_out << funame << "bond should connect exactly two vertices: " << git->size();
+	  }
+      
+	  int v = 0;
+	  for(std::multiset<int>::const_iterator bit = git->begin(); bit != git->end(); ++bit, ++v) {
+	    //
+	    if(!vertex_map[*bit].insert(2 * itemp + v).second) {
+	      ErrOut err_out;
+	      err_out << funame << "duplicated frequency index: " << 2 * itemp + v;
+	    }
 	  }
 	}
-      }
-      //
-      double gvalue = 0.;
-      //
-      _gmap_t gmap;
-      //
-      double potfac = 1.;
-
-      btemp = false;
-      //
-      for(std::vector<std::set<int> >::const_iterator mit = vertex_map.begin(); mit != vertex_map.end(); ++mit) {
 	//
-	std::multiset<int> potex_sign;
+	double potfac = 1.;
+
+	btemp = false;
 	//
-	for(std::set<int>::const_iterator it = mit->begin(); it != mit->end(); ++it) {
+	for(std::vector<std::set<int> >::const_iterator mit = vertex_map.begin(); mit != vertex_map.end(); ++mit) {
 	  //
-	  potex_sign.insert(corrin[*it]);
-	}
-	  
-	potex_t::const_iterator pexit = _potex.find(potex_sign);
-	
-	if(pexit != _potex.end()) {
+	  int potex_sign [PotexTable::RANK_MAX];
 	  //
-	  potfac *= pexit->second;
-	}
-	else {
+	  const int rank = mit->size();
 	  //
-	  btemp = true;
+	  int si = 0;
 	  //
-	  break;
-	}
-      }
+	  for(std::set<int>::const_iterator it = mit->begin(); it != mit->end() && si < PotexTable::RANK_MAX; ++it, ++si)
+	    //
+	    potex_sign[si] = corrin[*it];
 
-      if(btemp) {
-	//
-	MPI::COMM_WORLD.Send(&gindex, 1, MPI::INT, MASTER, WORK_TAG);
-	
-	if(temperature > 0.) {
-	  //
-	  MPI::COMM_WORLD.Send(&gvalue, 1, MPI::DOUBLE, MASTER, WORK_TAG);
+	  if(rank <= PotexTable::RANK_MAX && _potex_table.find(potex_sign, rank, dtemp)) {
+	    //
+	    potfac *= dtemp;
+	  }
+	  else {
+	    //
+	    btemp = true;
+	    //
+	    break;
+	  }
 	}
-	else {
+
+	if(btemp)
 	  //
-	  gmap.send(MASTER, WORK_TAG);
-	}
-	
-	continue;
-      }
+	  continue;
 
-      potfac /= (double)graphit->symmetry_factor();
-      //
-      if(vertex_size % 2)
+	potfac /= (double)graphit->symmetry_factor();
 	//
-	potfac = -potfac;
+	if(vertex_size % 2)
+	  //
+	  potfac = -potfac;
 
-      // centroid correction mask cycle
-      //
-      for(MultiIndex cmask(graphit->size(), 1); !cmask.end(); ++cmask) {
+	// centroid correction mask cycle
 	//
-	double gfactor = potfac;
+	for(MultiIndex cmask(graphit->size(), 1); !cmask.end(); ++cmask) {
+	  //
+	  double gfactor = potfac;
 	
-	int    t_count = 0;
+	  int    t_count = 0;
 
-	// frequency adapted graph
-	//
-	FreqGraph mod_graph;
+	  // frequency adapted graph
+	  //
+	  FreqGraph mod_graph;
 
-	itemp = 0;
+	  itemp = 0;
 
-	btemp = false;
-	//
-	for(GenGraph::const_iterator git = graphit->begin(); git != graphit->end(); ++git, ++itemp) {
-	  //
-	  // individual bond normal mode indices
+	  btemp = false;
 	  //
-	  int ci[2];
-	  //
-	  for(int i = 0; i < 2; ++i)
-	    //
-	    ci[i] = corrin[2 * itemp + i];
-	
-	  // quantum correlator
-	  if(cmask[itemp]) {
+	  for(GenGraph::const_iterator git = graphit->begin(); git != graphit->end(); ++git, ++itemp) {
 	    //
-	    // cross term contribution comes from centroid correction only
+	    // individual bond normal mode indices
 	    //
-	    if(ci[0] != ci[1]) {
-	      //
-	      btemp = true;
-
-	      break;
-	    }
-
-	    const int fi = _red_freq_index[ci[0]];
-	    
-	    std::set<int> bond;
+	    int ci[2];
 	    //
-	    for(std::multiset<int>::const_iterator bit = git->begin(); bit != git->end(); ++bit)
+	    for(int i = 0; i < 2; ++i)
 	      //
-	      bond.insert(*bit);
+	      ci[i] = corrin[2 * itemp + i];
 	
-	    // bond loop
-	    //
-	    if(bond.size() == 1) {
+	    // quantum correlator
+	    if(cmask[itemp]) {
 	      //
-	      // second order expansion term in low frequency correlator; zero order constant term included into centroid correction
+	      // cross term contribution comes from centroid correction only
 	      //
-	      if(low_freq.find(fi) != low_freq.end()) {
+	      if(ci[0] != ci[1]) {
 		//
-		gfactor /= 12. * temperature;
+		btemp = true;
+
+		break;
 	      }
-	      // thermal correlator value
+
+	      const int fi = _red_freq_index[ci[0]];
+	    
+	      std::set<int> bond;
 	      //
-	      else if(temperature > 0.) {
+	      for(std::multiset<int>::const_iterator bit = git->begin(); bit != git->end(); ++bit)
 		//
-		gfactor /= 2. * _red_freq[fi] * tanh_factor[fi];
-	      }
-	      // zero temperature correlator value
+		bond.insert(*bit);
+	
+	      // bond loop
 	      //
-	      else {
+	      if(bond.size() == 1) {
 		//
-		gfactor /= 2. * _red_freq[fi];
-	      }
-	    }
-	    // add frequency index to frequency adapted graph
-	    //
-	    else {
-	      //
-	      if(low_freq.find(fi) != low_freq.end()) {
+		// second order expansion term in low frequency correlator; zero order constant term included into centroid correction
 		//
-		mod_graph[bond].insert(-1);
-	      }
-	      else {
+		if(low_freq.find(fi) != low_freq.end()) {
+		  //
+		  gfactor /= 12. * temperature;
+		}
+		// thermal correlator value
 		//
-		mod_graph[bond].insert(fi);
+		else if(temperature > 0.) {
+		  //
+		  gfactor /= 2. * _red_freq[fi] * tanh_factor[fi];
+		}
+		// zero temperature correlator value
+		//
+		else {
+		  //
+		  gfactor /= 2. * _red_freq[fi];
+		}
 	      }
-	    }
-	  }
-	  // centroid correction
-	  //
-	  else {
-	    //
-	    std::multiset<int> mi;
-	    //
-	    for(int i = 0; i < 2; ++i)
-	      //
-	      mi.insert(ci[i]);
-
-	    std::map<std::multiset<int>, double>::const_iterator mit = mmat.find(mi);
-
-	    // centroid cross-term contribution
-	    //
-	    if(ci[0] != ci[1]) {
+	      // add frequency index to frequency adapted graph
 	      //
-	      if(mmat.end() != mit) {
-		//
-		gfactor *= -mit->second;
-	      } 
 	      else {
 		//
-		btemp = true;
-
-		break;
-	      }
-	      
-	      for(int i = 0; i < 2; ++i) {
-		//
-		const int fi = _red_freq_index[ci[i]]; // reduced frequency index
-	      
-		if(_red_freq[fi] > 0.) {
+		if(low_freq.find(fi) != low_freq.end()) {
 		  //
-		  gfactor /= _red_freq[fi] * _red_freq[fi];
+		  mod_graph[bond].insert(-1);
 		}
 		else {
 		  //
-		  gfactor /= -_red_freq[fi] * _red_freq[fi];
+		  mod_graph[bond].insert(fi);
 		}
 	      }
 	    }
-	    // diagonal centroid correction
+	    // centroid correction
 	    //
 	    else {
 	      //
-	      const int fi = _red_freq_index[ci[0]]; // reduced frequency index
-
-	      if(_red_freq[fi] > 0.) {
-		//
-		dtemp = _red_freq[fi] * _red_freq[fi];
-	      }
-	      else {
+	      std::multiset<int> mi;
+	      //
+	      for(int i = 0; i < 2; ++i)
 		//
-		dtemp = -_red_freq[fi] * _red_freq[fi];
-	      }
+		mi.insert(ci[i]);
 
-	      // low frequency zero order expansion term included into centroid correction
+	      std::map<std::multiset<int>, double>::const_iterator mit = mmat.find(mi);
+
+	      // centroid cross-term contribution
 	      //
-	      if(low_freq.find(fi) != low_freq.end()) {
+	      if(ci[0] != ci[1]) {
 		//
 		if(mmat.end() != mit) {
 		  //
-		  gfactor *= (1. - mit->second / dtemp) / dtemp;
-		}
+		  gfactor *= -mit->second;
+		} 
 		else {
 		  //
-		  ErrOut err_out;
+		  btemp = true;
 
-		  err_out << funame << "low frequency " << fi << " does not have corresponding value in M matrix";
+		  break;
+		}
+	      
+		for(int i = 0; i < 2; ++i) {
+		  //
+		  const int fi = _red_freq_index[ci[i]]; // reduced frequency index
+	      
+		  if(_red_freq[fi] > 0.) {
+		    //
+		    gfactor /= _red_freq[fi] * _red_freq[fi];
+		  }
+		  else {
+		    //
+		    gfactor /= -_red_freq[fi] * _red_freq[fi];
+		  }
 		}
 	      }
-	      // centroid correction value
+	      // diagonal centroid correction
 	      //
-	      else if(mmat.end() != mit) {
-		//
-		gfactor *= - mit->second / dtemp / dtemp;
-	      }
 	      else {
 		//
-		btemp = true;
+		const int fi = _red_freq_index[ci[0]]; // reduced frequency index
 
-		break;
-	      }
+		if(_red_freq[fi] > 0.) {
+		  //
+		  dtemp = _red_freq[fi] * _red_freq[fi];
+		}
+		else {
+		  //
+		  dtemp = -_red_freq[fi] * _red_freq[fi];
+		}
 
-	      if(temperature > 0.) {
+		// low frequency zero order expansion term included into centroid correction
 		//
-		gfactor *= temperature;
-	      }
-	      else
+		if(low_freq.find(fi) != low_freq.end()) {
+		  //
+		  if(mmat.end() != mit) {
+		    //
+		    gfactor *= (1. - mit->second / dtemp) / dtemp;
+		  }
+		  else {
+		    //
+		    ErrOut err_out;
+
+		    err_out << funame << "low frequency " << fi << " does not have corresponding value in M matrix";
+		  }
+		}
+		// centroid correction value
 		//
-		++t_count;
+		else if(mmat.end() != mit) {
+		  //
+		  gfactor *= - mit->second / dtemp / dtemp;
+		}
+		else {
+		  //
+		  btemp = true;
+
+		  break;
+		}
+
+		if(temperature > 0.) {
+		  //
+		  gfactor *= temperature;
+		}
+		else
+		  //
+		  ++t_count;
+	      }
 	    }
 	  }
-	}
 
-	if(btemp)
-	  //
-	  continue;
+	  if(btemp)
+	    //
+	    continue;
 	
-	itemp = vertex_size - mod_graph.vertex_size();
-	//
-	if(itemp) {
+	  itemp = vertex_size - mod_graph.vertex_size();
 	  //
-	  if(temperature > 0.) {
+	  if(itemp) {
 	    //
-	    gfactor /= std::pow(temperature, (double)itemp);
+	    if(temperature > 0.) {
+	      //
+	      gfactor /= std::pow(temperature, (double)itemp);
+	    }
+	    else
+	      //
+	      t_count -= itemp;
 	  }
-	  else
-	    //
-	    t_count -= itemp;
-	}
-
-	// frequency adapted graph evaluation
-	//
-	if(mod_graph.size()) {
-	  //
-	  ++fac_count;
 
-	  // graph factorization into connected ones
+	  // frequency adapted graph evaluation
 	  //
-	  _mg_t fac_graph = mod_graph.factorize();
-
-	  // factorized graph cycle
-	  //
-	  for(_mg_t::const_iterator fgit = fac_graph.begin(); fgit != fac_graph.end(); ++fgit) {
+	  if(mod_graph.size()) {
 	    //
-	    // zero temperature integral (zpe factor) calculation
-	    //
-	    if(temperature <= 0.) {
-	      //
-	      ++zpe_count;
+	    ++fac_count;
 
-	      dtemp = fgit->first.zpe_factor(_red_freq);
-
-	      for(int i = 0; i < fgit->second; ++i)
-		//
-		gfactor *= dtemp;
-	    
-	      t_count -= fgit->second;
-	    }
-	    // thermal whole integral calculation
+	    // graph factorization into connected ones
 	    //
-	    else {
-	      //
-	      ++red_count;
+	    _mg_t fac_graph = mod_graph.factorize();
 
-	      // graph reduction
-	      //
-	      _mg_t zpe_graph;
+	    // factorized graph cycle
+	    //
+	    for(_mg_t::const_iterator fgit = fac_graph.begin(); fgit != fac_graph.end(); ++fgit) {
 	      //
-	      FreqGraph red_graph = fgit->first.reduce(_red_freq, temperature, tanh_factor, zpe_graph);
-	  
-	      double gf = 1.;
-
-	      if(!red_graph.size()) {
-		//
-		gf /= temperature;
-	      }
-	      // reduced graph fourier sum calculation
+	      // zero temperature integral (zpe factor)
 	      //
-	      else {
+	      if(temperature <= 0.) {
 		//
-		++sum_count;
+		dtemp = _zpe_value(fgit->first, db, zpe_count);
 
-		gf *= red_graph.fourier_sum(_red_freq, temperature);
+		for(int i = 0; i < fgit->second; ++i)
+		  //
+		  gfactor *= dtemp;
+	    
+		t_count -= fgit->second;
 	      }
-
-	      // zpe graph cycle
+	      // thermal whole integral
 	      //
-	      for(_mg_t::const_iterator zgit = zpe_graph.begin(); zgit != zpe_graph.end(); ++zgit) {
-		//
-		// low temperature / high frequency integral (zpe factor) calculation
+	      else {
 		//
-		++zpe_count;
+		dtemp = _int_value(fgit->first, temperature, tanh_factor, db, zpe_count, red_count, sum_count);
 
-		dtemp = zgit->first.zpe_factor(_red_freq, temperature, tanh_factor);
-
-		for(int i = 0; i < zgit->second; ++i)
+		for(int i = 0; i < fgit->second; ++i)
 		  //
-		  gf *= dtemp;
-
-		//
-		//
-	      } // zpe graph cycle
-
-	      for(int i = 0; i < fgit->second; ++i)
-		//
-		gfactor *= gf;
-	      //
-	      //
-	    } // thermal whole integral calculation
+		  gfactor *= dtemp;
+	      }
+	    } // factorized graph cycle
 	    //
 	    //
-	  } // factorized graph cycle
-	  //
-	  //
-	} // frequency adapted graph evaluation
+	  } // frequency adapted graph evaluation
 	  
-	if(temperature > 0.) {
+	  if(temperature > 0.) {
+	    //
+	    value[order] += gfactor;
+	  }
+	  else {
+	    //
+	    if(t_count < -_power_max() || t_count > _power_max()) {
+	      //
+	      ErrOut err_out;
+
+	      err_out << funame << "temperature power out of range: " << t_count;
+	    }
+
+	    value[order * _power_size() + t_count + _power_max()] += gfactor;
+	  }
 	  //
-	  gvalue += gfactor;
-	}
-	else {
 	  //
-	  gmap[t_count] += gfactor;
-	}
-	//
-	//
-      } // centroid correction mask cycle
-	
+	} // centroid correction mask cycle
+      } // normal mode indices cycle
+
+      // ready for the next chunk
+      //
       MPI::COMM_WORLD.Send(&gindex, 1, MPI::INT, MASTER, WORK_TAG);
-	
-      if(temperature > 0.) {
-	//
-	MPI::COMM_WORLD.Send(&gvalue, 1, MPI::DOUBLE, MASTER, WORK_TAG);
-      }
-      else {
-	//
-	gmap.send(MASTER, WORK_TAG);
-      }
       //
       //
     } // main loop
 
+    // per-order values, reduced while the statistics is sent
+    //
+    MPI_Request reduce_request;
+
+    MPI_Ireduce(value, 0, value_size, MPI_DOUBLE, MPI_SUM, MASTER, MPI_COMM_WORLD, &reduce_request);
+
     calc_time = std::clock() - calc_time;
 
     dtemp = calc_time / CLOCKS_PER_SEC;
@@ -1567,6 +1484,8 @@ void Graph::Expansion::_centroid_work_with_constrain (const double temperature,
 
       MPI::COMM_WORLD.Send(&sum_count, 1, MPI::LONG, MASTER, STAT_TAG);
     }
+
+    MPI_Wait(&reduce_request, MPI_STATUS_IGNORE);
   }
   catch(Error::General) {
     //
@@ -1595,100 +1514,225 @@ void Graph::Expansion::init (const std::vector<double>& freq, const potex_t& pex
 
   // initialize potential expansion
   //
-  _potex = pex;
+  _screen_potex(freq, pex);
 
-}
+  // initialize frequency adapted graph converter
+  //
+  _convert.init(2 * Graph::bond_max / 3, _red_freq.size() + 1);
 
-#include "graph_include.cc"
+  if(potex_share)
+    //
+    _share_potex();
+}
 
 /*******************************************************************************************
- ******************************** COMMUNICAIION CLASS BASE *********************************
+ ******************************** NODE SHARED POTENTIAL EXPANSION **************************
  *******************************************************************************************/
 
-void Graph::Expansion::_gbase_t::send (int node, int tag) const
+bool Graph::Expansion::potex_share = false;
+
+// the node leader process creates the shared memory object, the other processes of the node
+// map it; the name is removed once all of them are mapped
+//
+void Graph::Expansion::_share_potex ()
 {
-  Array<char> buff;
-  
-  int pack_size = _pack(buff);
+  const char funame [] = "Graph::Expansion::_share_potex: ";
 
-  MPI::COMM_WORLD.Send(&pack_size, 1,         MPI::INT,    node, tag);
+  static int count = 0;
 
-  MPI::COMM_WORLD.Send(buff,       pack_size, MPI::PACKED, node, tag);
-}
+  MPI_Comm node_comm;
 
-void Graph::Expansion::_gbase_t::recv (int node, int tag)
-{
-  int pack_size;
+  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node_comm);
 
-  MPI::COMM_WORLD.Recv(&pack_size, 1,   MPI::INT,    node, tag);
-  
-  Array<char> buff(pack_size);
+  int node_rank, node_size;
+
+  MPI_Comm_rank(node_comm, &node_rank);
+  MPI_Comm_size(node_comm, &node_size);
+
+  long leader = getpid();
+
+  MPI_Bcast(&leader, 1, MPI_LONG, 0, node_comm);
+
+  std::ostringstream name;
+
+  name << "/mess_potex." << leader << "." << count++;
+
+  if(!node_rank)
+    //
+    _potex_table.share(name.str(), true);
+
+  MPI_Barrier(node_comm);
+
+  if(node_rank)
+    //
+    _potex_table.share(name.str(), false);
+
+  MPI_Barrier(node_comm);
+
+  if(!node_rank)
+    //
+    SharedRegion::unlink(name.str());
+
+  MPI_Comm_free(&node_comm);
+
+  // only the flat form is used by the work processes
   //
-  MPI::COMM_WORLD.Recv(buff, pack_size, MPI::PACKED, node, tag);
+  potex_t().swap(_potex);
 
-  _unpack(buff);
+  if(!IO::mpi_rank)
+    //
+    IO::log << IO::log_offset << "potential expansion table of " << _potex_table.byte_size()
+	    << " bytes is shared by " << node_size << " processes of the node\n\n";
 }
 
+#include "graph_include.cc"
 
 /*******************************************************************************************
- ************************* COMMUNICAIION CLASS FOR MAP<INT, DOUBLE> ************************
+ ******************************** PROCESS GRAPH INTEGRAL DATABASES *************************
  *******************************************************************************************/
 
-int Graph::Expansion::_gmap_t::_pack (Array<char>& buff) const
+double Graph::Expansion::_zpe_value (const FreqGraph& graph, _db_t& db, long& zpe_count) const
 {
-  int itemp;
+  _Convert::vec_t graph_conv = _convert(graph.canonical());
 
-  itemp = (size() + 1) * MPI::INT.Pack_size(1, MPI::COMM_WORLD) + size() * MPI::DOUBLE.Pack_size(1, MPI::COMM_WORLD);
+  double res;
 
-  buff.resize(itemp);
-  
-  int pos = 0;
+  if(db.zpe_data.find(graph_conv, res))
+    //
+    return res;
 
-  itemp = size();
+  ++zpe_count;
 
-  MPI::INT.Pack(&itemp, 1, buff, buff.size(), pos, MPI::COMM_WORLD);
+  res = graph.zpe_factor(_red_freq);
 
-  for(std::map<int, double>::const_iterator mit = this->begin(); mit != this->end(); ++mit) {
-    //
-    MPI::INT.Pack(&mit->first, 1, buff, buff.size(), pos, MPI::COMM_WORLD);
-    
-    MPI::DOUBLE.Pack(&mit->second, 1, buff, buff.size(), pos, MPI::COMM_WORLD);
-  }
-  
-  return pos;
+  db.zpe_data.insert(graph_conv, res);
+
+  return res;
 }
 
-void Graph::Expansion::_gmap_t::_unpack (const Array<char>& buff)
+double Graph::Expansion::_int_value (const FreqGraph& graph, double temperature, const std::vector<double>& tanh_factor,
+				     _db_t& db, long& zpe_count, long& red_count, long& sum_count) const
 {
-  const char funame [] = "Graph::Expansion::_gmap_t::_unpack: ";
-  
-  int    itemp;
   double dtemp;
 
-  int pos = 0;
+  _Convert::vec_t graph_conv = _convert(graph.canonical());
+
+  double res;
+
+  if(db.int_data.find(graph_conv, res))
+    //
+    return res;
+
+  ++red_count;
 
-  int map_size;
+  // graph reduction
   //
-  MPI::INT.Unpack(buff, buff.size(), &map_size, 1, pos, MPI::COMM_WORLD);
-  
-  for(int i = 0; i < map_size; ++i) {
+  _mg_t zpe_graph;
+  //
+  FreqGraph red_graph = graph.reduce(_red_freq, temperature, tanh_factor, zpe_graph);
+
+  res = 1.;
+
+  // reduced graph fourier sum
+  //
+  if(!red_graph.size()) {
     //
-    MPI::INT.Unpack(buff, buff.size(), &itemp, 1, pos, MPI::COMM_WORLD);
-    
-    MPI::DOUBLE.Unpack(buff, buff.size(), &dtemp, 1, pos, MPI::COMM_WORLD);
+    res /= temperature;
+  }
+  else {
+    //
+    _Convert::vec_t red_graph_conv = _convert(red_graph.canonical());
 
-    if(!this->insert(std::make_pair(itemp, dtemp)).second) {
+    if(!db.sum_data.find(red_graph_conv, dtemp)) {
       //
-      ErrOut err_out;
-      
-      err_out << funame << "cannot insert int-double pair: " << itemp << ", " << dtemp << ": map values:\n";
-      
-      for(std::map<int, double>::const_iterator mit = this->begin(); mit != this->end(); ++mit)
-	//
-	err_out << mit->first << "  " << mit->second << "\n";
-      
-      err_out << "\n";
+      ++sum_count;
+
+      dtemp = red_graph.fourier_sum(_red_freq, temperature);
+
+      db.sum_data.insert(red_graph_conv, dtemp);
+    }
+
+    res *= dtemp;
+  }
+
+  // low temperature / high frequency integrals (zpe factors)
+  //
+  for(_mg_t::const_iterator zgit = zpe_graph.begin(); zgit != zpe_graph.end(); ++zgit) {
+    //
+    _Convert::vec_t zpe_graph_conv = _convert(zgit->first.canonical());
+
+    if(!db.zpe_data.find(zpe_graph_conv, dtemp)) {
+      //
+      ++zpe_count;
+
+      dtemp = zgit->first.zpe_factor(_red_freq, temperature, tanh_factor);
+
+      db.zpe_data.insert(zpe_graph_conv, dtemp);
     }
+
+    for(int i = 0; i < zgit->second; ++i)
+      //
+      res *= dtemp;
   }
+
+  db.int_data.insert(graph_conv, res);
+
+  return res;
+}
+
+/*******************************************************************************************
+ ************************************* WORK DISTRIBUTION ***********************************
+ *******************************************************************************************/
+
+// number of chunks per work process
+//
+int Graph::Expansion::chunk_factor = 16;
+
+// relative cost of one normal mode indices term: the fourier sums grow
+// exponentially with the number of vertices and the reductions with the number of bonds
+//
+double Graph::Expansion::_term_cost (const GenGraph& g)
+{
+  return std::pow(2., (double)g.vertex_size()) * (double)g.size();
+}
+
+int Graph::Expansion::_value_size (int mode, double temperature)
+{
+  if(CENTROID == mode && temperature <= 0.)
+    //
+    return (Graph::bond_max + 1) * _power_size();
+
+  return Graph::bond_max + 1;
 }
 
+// receives the graph index and the normal mode indices range; false at the end of work
+//
+bool Graph::Expansion::_recv_chunk (int& gindex, long& li_begin, long& li_end) const
+{
+  const char funame [] = "Graph::Expansion::_recv_chunk: ";
+
+  long chunk [3];
+
+  MPI::Status stat;
+
+  MPI::COMM_WORLD.Recv(chunk, 3, MPI::LONG, MASTER, MPI::ANY_TAG, stat);
+
+  const int tag = stat.Get_tag();
+ 
+  if(END_TAG == tag)
+    //
+    return false;
+
+  if(WORK_TAG != tag) {
+    //
+    ErrOut err_out;
+
+    err_out << funame << "wrong tag: " << tag;
+  }
+
+  gindex   = chunk[0];
+  li_begin = chunk[1];
+  li_end   = chunk[2];
+
+  return true;
+}
@@ -19,6 +19,14 @@
 #include "graph_common.hh"
 #include "array.hh"
 
+#include <fstream>
+
+#ifdef _OPENMP
+
+#include <omp.h>
+
+#endif
+
 namespace Graph {
 
   /******************************************************************************************
@@ -29,38 +37,154 @@ namespace Graph {
     //
     typedef std::map<FreqGraph, int> _mg_t;
 
-    // base class for mpi communications
+    // frequency adapted graph converter (to save memory)
     //
-    class _gbase_t {
+    class _Convert {
       //
-      virtual int  _pack   (Array<char>&)  const = 0;
+      int _vertex_size_max;
+    
+      int _freq_size;
 
-      virtual void _unpack (const Array<char>&)  = 0;
+      std::vector<std::set<int> > _index_map;
 
     public:
       //
-      virtual ~_gbase_t () {}
+      typedef char         int_t;
+    
+      typedef Array<int_t> vec_t;
 
-      void send (int node, int tag) const;
+      static int mem_size (const vec_t& v) { return v.size() * sizeof(int_t); }
+      
+      _Convert () : _vertex_size_max(0), _freq_size(0) {}
+      
+      void init (int vertex_size_max, int freq_size);
+      
+      vec_t operator() (const FreqGraph&) const;
 
-      void recv (int node, int tag);
+      FreqGraph operator() (const vec_t&) const;
     };
+      
+    _Convert _convert;
     
-    class _gmap_t : public std::map<int, double>, public _gbase_t {
+    // database format: the values are kept in shards selected by the key hash, each shard
+    // with its own lock, so that a lookup or an insertion locks one shard only; with the
+    // memory budget set the least reused entries are evicted, and, with the spill directory
+    // set, moved to the disk as sorted runs of fixed size records; the budget is per
+    // temperature
+    //
+    class _gmap_t {
       //
-      int  _pack   (Array<char>&)  const;
+      enum { SHARD_SIZE = 64, SPILL_KEY_MAX = 32 };
+
+      struct _entry_t {
+	double   value;
+	unsigned hits;
+      };
+
+      mutable std::map<_Convert::vec_t, _entry_t> _shard [SHARD_SIZE];
+
+      // memory per shard
+      //
+      long _mem [SHARD_SIZE];
+
+      long _mem_max;
+
+      long _evict_size;
+
+      long _spill_size;
+
+      std::string _spill_name;
+
+      mutable std::fstream _spill;
+
+      // spilled runs per shard: file position, records number
+      //
+      std::vector<std::pair<long, long> > _spill_run [SHARD_SIZE];
+
+#ifdef _OPENMP
+      mutable omp_lock_t _lock [SHARD_SIZE];
+
+      mutable omp_lock_t _spill_lock;
+#endif
+
+      static int _shard_index (const _Convert::vec_t&);
+
+      static long _entry_mem (const _Convert::vec_t&);
+
+      static int _record_size ();
+
+      void _evict (int);
+
+      void _spill_write (int, const std::vector<std::pair<_Convert::vec_t, double> >&);
+
+      bool _spill_find  (int, const _Convert::vec_t&, double&) const;
+
+      _gmap_t (const _gmap_t&);
+      _gmap_t& operator= (const _gmap_t&);
 
-      void _unpack (const Array<char>&);
-      
     public:
       //
-      _gmap_t () {}
+      _gmap_t ();
+      ~_gmap_t ();
 
-      _gmap_t (const std::map<int, double>& m) : std::map<int, double>(m) {}
+      bool find (const _Convert::vec_t& key, double& value) const;
+
+      // does not overwrite the existing value; returns false if the key is already in the database
+      //
+      bool insert (const _Convert::vec_t& key, double value);
+
+      long size () const;
+
+      long mem_size() const;
+
+      // evicted and spilled entries numbers
+      //
+      long evict_size () const { return _evict_size; }
+      long spill_size () const { return _spill_size; }
 
-      _gmap_t (int from, int tag) { recv(from, tag); }
+      // logs the eviction statistics, if any
+      //
+      void report (const char* name) const;
+
+      // binary input/output for the cross-run graph integrals store
+      //
+      void save (std::ostream&) const;
+
+      bool load (std::istream&);
     };
-    
+
+    // a work process evaluates its chunks with the thread team which shares the process
+    // graph integral databases; the databases live for one correction call
+    //
+    struct _db_t {
+      _gmap_t int_data;
+      _gmap_t sum_data;
+      _gmap_t zpe_data;
+    };
+
+    // zero temperature integral of the frequency adapted graph
+    //
+    double _zpe_value (const FreqGraph&, _db_t&, long& zpe_count) const;
+
+    // positive temperature integral of the connected frequency adapted graph
+    //
+    double _int_value (const FreqGraph&, double temperature, const std::vector<double>& tanh_factor,
+		       _db_t&, long& zpe_count, long& red_count, long& sum_count) const;
+
+    // the normal mode indices are handed to the work processes in chunks and the results
+    // are summed over the processes for each graph order at the end
+    //
+    static double _term_cost (const GenGraph&);
+
+    // low temperature expansion powers of temperature
+    //
+    static int _power_max  () { return 3 * Graph::bond_max; }
+    static int _power_size () { return 2 * _power_max() + 1; }
+
+    static int _value_size (int mode, double temperature);
+
+    bool _recv_chunk (int& gindex, long& li_begin, long& li_end) const;
+
     void   _global_work                (double temperature)                                                   const;
     void _centroid_work                (double temperature)                                                   const;
     void _centroid_work_with_constrain (double temperature, const std::map<std::multiset<int>, double>& mmat) const;
@@ -72,6 +196,22 @@ namespace Graph {
     //
     potex_t  _potex;
 
+    // its flat form for the lookups
+    //
+    PotexTable _potex_table;
+
+    // moves the flat form to the memory shared by the processes of the node
+    //
+    void _share_potex ();
+
+    // normal modes which enter the potential expansion: only these are enumerated
+    //
+    std::vector<int> _active_mode;
+
+    // drops the potential expansion terms below the screening tolerance
+    //
+    void _screen_potex (const std::vector<double>& freq, const potex_t&);
+
     // reduced frequencies
     //
     std::vector<double> _red_freq;
@@ -118,6 +258,26 @@ namespace Graph {
     // low frequency threshold
     //
     static double low_freq_thresh;
+
+    // potential expansion screening tolerance
+    //
+    static double potex_tol;
+
+    // number of chunks per work process
+    //
+    static int chunk_factor;
+
+    // one copy of the potential expansion table per node, mapped by all its processes
+    //
+    static bool potex_share;
+
+    // graph databases memory budget per work process, bytes
+    //
+    static long db_mem_max;
+
+    // graph databases spill directory
+    //
+    static std::string spill_dir;
   };
 }
 
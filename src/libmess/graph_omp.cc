@@ -6,6 +6,12 @@
 #include "units.hh"
 
 #include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <unistd.h>
 
 // different modification flags
 //
@@ -19,6 +25,22 @@ double Graph::Expansion::freq_tol = 0.1;
 //
 double Graph::Expansion::low_freq_thresh = 0.2;
 
+// potential expansion terms with smaller force constants are dropped (none if not positive)
+//
+double Graph::Expansion::potex_tol = -1.;
+
+// graph databases memory budget, bytes (no limit if not positive)
+//
+long Graph::Expansion::db_mem_max = 0;
+
+// directory for the spilled graph database entries (no spilling if empty)
+//
+std::string Graph::Expansion::spill_dir;
+
+// bond order relative contribution below which the expansion is stopped (never if not positive)
+//
+double Graph::Expansion::conv_thresh = -1.;
+
 /********************************************************************************************
  ************************ PERTURBATION THEORY GRAPH EXPANSION *******************************
  ********************************************************************************************/
@@ -88,498 +110,464 @@ std::map<int, double> Graph::Expansion::correction (double temperature) const
   _gmap_t sum_data;
   _gmap_t zpe_data;
 
+  // graph integrals from the previous runs
+  //
+  std::string store_key;
+
+  if(Graph::cache_dir.size()) {
+    //
+    store_key = _store_key("correction", temperature);
+
+    _load_store(store_key, int_data, sum_data, zpe_data);
+  }
+
   std::map<int, double> corr;
 
+  // graphs by bond order: the orders are evaluated in turn, so that the expansion can
+  // be stopped once it converges
+  //
+  std::map<int, std::vector<int> > order_graph;
+
+  for(int gindex = 0; gindex < Graph::size(); ++gindex)
+    //
+    order_graph[(Graph::begin() + gindex)->size()].push_back(gindex);
+
+  std::map<int, std::time_t> order_time;
+
+  std::map<int, double> order_rel;
+
+  int conv_order = 0;
+
+  double curr_corr = 0.;
+
+  for(std::map<int, std::vector<int> >::const_iterator oit = order_graph.begin(); oit != order_graph.end(); ++oit) {
+    //
+    const std::vector<int>& order_index = oit->second;
+
+    const std::time_t order_start = std::time(0);
+
 #ifndef INNER_CYCLE_PARALLEL
 #pragma omp parallel for default(shared) reduction(+: sum_calc_tot, zpe_calc_tot, int_calc_tot, sum_read_tot, zpe_read_tot, int_read_tot, sum_miss_tot, zpe_miss_tot, int_miss_tot) private(itemp, dtemp, btemp) schedule(dynamic)
 #endif
         
-  for(int gindex = 0; gindex < Graph::size(); ++gindex) {
-    //
-    Graph::const_iterator graphit = Graph::begin() + gindex;
+    for(int oi = 0; oi < order_index.size(); ++oi) {
+      //
+      const int gindex = order_index[oi];
 
-    std::time_t  start_time = std::time(0);
+      Graph::const_iterator graphit = Graph::begin() + gindex;
 
-    const std::vector<std::multiset<int> > vertex_map = graphit->vertex_bond_map();
-    const int vertex_size = vertex_map.size();
+      std::time_t  start_time = std::time(0);
 
-    double gvalue = 0.;
+      const std::vector<std::multiset<int> > vertex_map = graphit->vertex_bond_map();
+      const int vertex_size = vertex_map.size();
 
-    int sum_calc = 0;
-    int zpe_calc = 0;
-    int int_calc = 0;
+      double gvalue = 0.;
+
+      int sum_calc = 0;
+      int zpe_calc = 0;
+      int int_calc = 0;
     
-    long sum_read = 0;
-    long zpe_read = 0;
-    long int_read = 0;
+      long sum_read = 0;
+      long zpe_read = 0;
+      long int_read = 0;
     
-    int sum_miss = 0;
-    int zpe_miss = 0;
-    int int_miss = 0;
+      int sum_miss = 0;
+      int zpe_miss = 0;
+      int int_miss = 0;
     
-    MultiIndexConvert corr_multi_index(graphit->size(), _red_freq_index.size());
+      MultiIndexConvert corr_multi_index(graphit->size(), _active_mode.size());
 
 #ifdef INNER_CYCLE_PARALLEL
 #pragma omp parallel for default(shared) reduction(+: sum_calc, zpe_calc, int_calc, sum_read, zpe_read, int_read, sum_miss, zpe_miss, int_miss, gvalue) private(itemp, dtemp, btemp) schedule(dynamic)
 #endif
 
-    for(long corr_lin = 0; corr_lin < corr_multi_index.size(); ++corr_lin) {
-      //
-      std::vector<int> corrin = corr_multi_index(corr_lin);
+      for(long corr_lin = 0; corr_lin < corr_multi_index.size(); ++corr_lin) {
+	//
+	std::vector<int> corrin = corr_multi_index(corr_lin);
+	//
+	for(int i = 0; i < corrin.size(); ++i)
+	  //
+	  corrin[i] = _active_mode[corrin[i]];
 
-      double gfactor = 1.;
+	double gfactor = 1.;
 
-      btemp = false;
-      //
-      for(std::vector<std::multiset<int> >::const_iterator mit = vertex_map.begin(); mit != vertex_map.end(); ++mit) {
-	//
-	std::multiset<int> potex_sign;
+	btemp = false;
 	//
-	for(std::multiset<int>::const_iterator it = mit->begin(); it != mit->end(); ++it) {
+	for(std::vector<std::multiset<int> >::const_iterator mit = vertex_map.begin(); mit != vertex_map.end(); ++mit) {
 	  //
-	  potex_sign.insert(corrin[*it]);
-	}
-	
-	potex_t::const_iterator pexit = _potex.find(potex_sign);
-	
-	if(pexit != _potex.end()) {
+	  int potex_sign [PotexTable::RANK_MAX];
 	  //
-	  gfactor *= pexit->second;
-	}
-	else {
+	  const int rank = mit->size();
 	  //
-	  btemp = true;
+	  int si = 0;
 	  //
-	  break;
+	  for(std::multiset<int>::const_iterator it = mit->begin(); it != mit->end() && si < PotexTable::RANK_MAX; ++it, ++si)
+	    //
+	    potex_sign[si] = corrin[*it];
+
+	  if(rank <= PotexTable::RANK_MAX && _potex_table.find(potex_sign, rank, dtemp)) {
+	    //
+	    gfactor *= dtemp;
+	  }
+	  else {
+	    //
+	    btemp = true;
+	    //
+	    break;
+	  }
 	}
-      }
       
-      if(btemp) {
-	//
-	continue;
-      }
+	if(btemp) {
+	  //
+	  continue;
+	}
 
-      // frequency adapted graph
-      //
-      FreqGraph mod_graph;
+	// frequency adapted graph
+	//
+	FreqGraph mod_graph;
       
-      itemp = 0;
-      //
-      for(GenGraph::const_iterator mit = graphit->begin(); mit != graphit->end(); ++mit, ++itemp) {
+	itemp = 0;
 	//
-	int ci = corrin[itemp]; // correlator (normal mode) index
+	for(GenGraph::const_iterator mit = graphit->begin(); mit != graphit->end(); ++mit, ++itemp) {
+	  //
+	  int ci = corrin[itemp]; // correlator (normal mode) index
 	
-	int fi = _red_freq_index[ci]; // reduced frequency index
+	  int fi = _red_freq_index[ci]; // reduced frequency index
 
-	// low frequency correlator is a constant
-	//
-	if(low_freq.find(fi) != low_freq.end()) {
+	  // low frequency correlator is a constant
 	  //
-	  if(_red_freq[fi] > 0.) {
-	    //
-	    gfactor *=  temperature / _red_freq[fi] / _red_freq[fi];
-	  }
-	  else {
+	  if(low_freq.find(fi) != low_freq.end()) {
 	    //
-	    gfactor *= -temperature / _red_freq[fi] / _red_freq[fi];
-	  }
+	    if(_red_freq[fi] > 0.) {
+	      //
+	      gfactor *=  temperature / _red_freq[fi] / _red_freq[fi];
+	    }
+	    else {
+	      //
+	      gfactor *= -temperature / _red_freq[fi] / _red_freq[fi];
+	    }
 
-	  continue;
-	}
+	    continue;
+	  }
 
-	std::set<int> bond;
-	//
-	for(std::multiset<int>::const_iterator it = mit->begin(); it != mit->end(); ++it)
+	  std::set<int> bond;
 	  //
-	  bond.insert(*it);
+	  for(std::multiset<int>::const_iterator it = mit->begin(); it != mit->end(); ++it)
+	    //
+	    bond.insert(*it);
 
-	// bond loop
-	//
-	if(bond.size() == 1) {
+	  // bond loop
 	  //
-	  if(temperature > 0.) {
+	  if(bond.size() == 1) {
 	    //
-	    gfactor /= 2. * _red_freq[fi] * tanh_factor[fi];
+	    if(temperature > 0.) {
+	      //
+	      gfactor /= 2. * _red_freq[fi] * tanh_factor[fi];
+	    }
+	    else {
+	      //
+	      gfactor /= 2. * _red_freq[fi];
+	    }
 	  }
+	  // add frequency index to the graph
+	  //
 	  else {
 	    //
-	    gfactor /= 2. * _red_freq[fi];
+	    mod_graph[bond].insert(fi);
 	  }
 	}
-	// add frequency index to the graph
+
+	itemp = vertex_size - mod_graph.vertex_size();
 	//
-	else {
+	if(itemp && temperature > 0.) {
 	  //
-	  mod_graph[bond].insert(fi);
+	  gfactor /= std::pow(temperature, (double)itemp);
 	}
-      }
-
-      itemp = vertex_size - mod_graph.vertex_size();
-      //
-      if(itemp && temperature > 0.) {
-	//
-	gfactor /= std::pow(temperature, (double)itemp);
-      }
 
-      // frequency adapted graph avaluation
-      //
-      if(mod_graph.size()) {
+	// frequency adapted graph avaluation
 	//
-	// zero temperature integral (zpe factor) evaluation
-	//
-	if(temperature <= 0.) {
+	if(mod_graph.size()) {
 	  //
-	  _Convert::vec_t mod_graph_conv;
-
-	  if(mod_flag & KEEP_PERM) {
-	    //
-	    mod_graph_conv = _convert(mod_graph);
-	  }
-	  else {
+	  // zero temperature integral (zpe factor) evaluation
+	  //
+	  if(temperature <= 0.) {
 	    //
-	    mod_graph_conv = _convert(*mod_graph.perm_pool().begin());
-	  }
+	    _Convert::vec_t mod_graph_conv = _convert(mod_graph.canonical());
 
-#pragma omp critical(zpe_critical)
-	  {
-	    itemp = zpe_data.find(mod_graph_conv) != zpe_data.end();
-	  }
+	    double db_value;
+
+	    itemp = zpe_data.find(mod_graph_conv, db_value);
 	
-	  // read graph value from the database
-	  //
-	  if(itemp) {
+	    // read graph value from the database
 	    //
-	    ++zpe_read;
+	    if(itemp) {
+	      //
+	      ++zpe_read;
 	  
-#pragma omp critical(zpe_critical)
-	    {
-	      gfactor *= zpe_data[mod_graph_conv];
+	      gfactor *= db_value;
 	    }
-	  }
-	  // zero temperature integral (zpe factor) calculation
-	  //
-	  else {
+	    // zero temperature integral (zpe factor) calculation
 	    //
-	    ++zpe_calc;
+	    else {
+	      //
+	      ++zpe_calc;
 
-	    dtemp = mod_graph.zpe_factor(_red_freq);
-	    //
-	    gfactor *= dtemp;
+	      dtemp = mod_graph.zpe_factor(_red_freq);
+	      //
+	      gfactor *= dtemp;
 
-	    // save zero temperature integral value in the database
-	    //
-#pragma omp critical(zpe_critical)
-	    {
-	      if(zpe_data.find(mod_graph_conv) != zpe_data.end()) {
+	      // save zero temperature integral value in the database
+	      //
+	      if(!zpe_data.insert(mod_graph_conv, dtemp)) {
 		//
 		++zpe_miss;
 	      }
-	      else if(mod_flag & KEEP_PERM) {
-		//
-		std::set<FreqGraph> pool = mod_graph.perm_pool();
-
-		for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-		  //
-		  zpe_data[_convert(*pit)] = dtemp;
-	      }
-	      else {
-		//
-		zpe_data[mod_graph_conv] = dtemp;
-	      }
-	    }
+	      //
+	      //
+	    } // zero temperature integral (zpe factor) calculation
 	    //
 	    //
-	  } // zero temperature integral (zpe factor) calculation
-	  //
-	  //
-	} // zero temperature integral (zpe factor) evaluation
-	//
-	// positive temperature
-	//
-	else {
+	  } // zero temperature integral (zpe factor) evaluation
 	  //
-	  // graph factorization into connected graphs
-	  //
-	  _mg_t fac_graph = mod_graph.factorize();
-
-	  // factorized graph cycle
+	  // positive temperature
 	  //
-	  for(_mg_t::const_iterator fgit = fac_graph.begin(); fgit != fac_graph.end(); ++fgit) {
+	  else {
 	    //
-	    // whole integral evaluation
+	    // graph factorization into connected graphs
 	    //
-	    _Convert::vec_t fac_graph_conv;
+	    _mg_t fac_graph = mod_graph.factorize();
 
-	    if(mod_flag & KEEP_PERM) {
+	    // factorized graph cycle
+	    //
+	    for(_mg_t::const_iterator fgit = fac_graph.begin(); fgit != fac_graph.end(); ++fgit) {
 	      //
-	      fac_graph_conv = _convert(fgit->first);
-	    }
-	    else {
+	      // whole integral evaluation
 	      //
-	      fac_graph_conv = _convert(*fgit->first.perm_pool().begin());
-	    }
+	      _Convert::vec_t fac_graph_conv = _convert(fgit->first.canonical());
 
-#pragma omp critical(int_critical)
-	    {
-	      itemp = int_data.find(fac_graph_conv) != int_data.end();
-	    }
+	      double db_value;
 
-	    // read whole integral value from the database
-	    //
-	    if(itemp) {
+	      itemp = int_data.find(fac_graph_conv, db_value);
+
+	      // read whole integral value from the database
 	      //
-	      ++int_read;
+	      if(itemp) {
+		//
+		++int_read;
 
-#pragma omp critical(int_critical)
-	      {
-		dtemp = int_data[fac_graph_conv];
-	      }
+		dtemp = db_value;
 	      
-	      for(int i = 0; i < fgit->second; ++i)
-		gfactor *= dtemp;
-	    }
-	    //
-	    // whole integral calculation
-	    //
-	    else {
+		for(int i = 0; i < fgit->second; ++i)
+		  gfactor *= dtemp;
+	      }
 	      //
-	      ++int_calc;
-	      
-	      double int_val = 1.;
-
-	      // graph reduction
+	      // whole integral calculation
 	      //
-	      _mg_t zpe_graph;
-	      FreqGraph red_graph = fgit->first.reduce(_red_freq, temperature, tanh_factor, zpe_graph);
+	      else {
+		//
+		++int_calc;
+	      
+		double int_val = 1.;
 
-	      // zpe graph cycle
-	      //
-	      for(_mg_t::const_iterator zgit = zpe_graph.begin(); zgit != zpe_graph.end(); ++zgit) {
+		// graph reduction
 		//
-		// low temperature integral (zpe factor) evaluation
+		_mg_t zpe_graph;
+		FreqGraph red_graph = fgit->first.reduce(_red_freq, temperature, tanh_factor, zpe_graph);
+
+		// zpe graph cycle
 		//
-		_Convert::vec_t zpe_graph_conv;
-	      
-		if(mod_flag & KEEP_PERM) {
+		for(_mg_t::const_iterator zgit = zpe_graph.begin(); zgit != zpe_graph.end(); ++zgit) {
 		  //
-		  zpe_graph_conv = _convert(zgit->first);
-		}
-		else {
+		  // low temperature integral (zpe factor) evaluation
 		  //
-		  zpe_graph_conv = _convert(*zgit->first.perm_pool().begin());
-		}
+		  _Convert::vec_t zpe_graph_conv = _convert(zgit->first.canonical());
 		  
-#pragma omp critical(zpe_critical)
-		{
-		  itemp = zpe_data.find(zpe_graph_conv) != zpe_data.end();
-		}
+		  double db_value;
 
-		// read low temperature integral value from the database
-		//
-		if(itemp) {
-		  ++zpe_read;
+		  itemp = zpe_data.find(zpe_graph_conv, db_value);
+
+		  // read low temperature integral value from the database
+		  //
+		  if(itemp) {
+		    ++zpe_read;
 		  
-#pragma omp critical(zpe_critical)
-		  {
-		    dtemp = zpe_data[zpe_graph_conv];
-		  }
+		    dtemp = db_value;
 		
-		  for(int i = 0; i < zgit->second; ++i)
-		    int_val *= dtemp;
-		}
-		// low temperature integral (zpe factor) calculation
-		//
-		else {
-		  ++zpe_calc;
+		    for(int i = 0; i < zgit->second; ++i)
+		      int_val *= dtemp;
+		  }
+		  // low temperature integral (zpe factor) calculation
+		  //
+		  else {
+		    ++zpe_calc;
 		  
-		  dtemp = zgit->first.zpe_factor(_red_freq, temperature, tanh_factor);
+		    dtemp = zgit->first.zpe_factor(_red_freq, temperature, tanh_factor);
 
-		  for(int i = 0; i < zgit->second; ++i)
-		    int_val *= dtemp;
+		    for(int i = 0; i < zgit->second; ++i)
+		      int_val *= dtemp;
 
-		  // save low temperature integral value in the database
-		  //
-#pragma omp critical(zpe_critical)
-		  {
-		    if(zpe_data.find(zpe_graph_conv) != zpe_data.end()) {
-		      ++zpe_miss;
-		    }
-		    else if(mod_flag & KEEP_PERM) {
-		      //
-		      // permutationally equivalent configurations
+		    // save low temperature integral value in the database
+		    //
+		    if(!zpe_data.insert(zpe_graph_conv, dtemp)) {
 		      //
-		      std::set<FreqGraph> pool = zgit->first.perm_pool();
-
-		      for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-			zpe_data[_convert(*pit)] = dtemp;
-		    }
-		    else {
-		      zpe_data[zpe_graph_conv] = dtemp;
+		      ++zpe_miss;
 		    }
-		  }
+		    //
+		    //
+		  } // low temperature integral (zpe factor) calculation
 		  //
 		  //
-		} // low temperature integral (zpe factor) calculation
-		//
-		//
-	      } // zpe graph cycle
+		} // zpe graph cycle
 
-	      // reduced graph fourier sum evaluation
-	      //
-	      if(red_graph.size()) {
+		// reduced graph fourier sum evaluation
 		//
-		_Convert::vec_t red_graph_conv;
-
-		if(mod_flag & KEEP_PERM) {
-		  //
-		  red_graph_conv = _convert(red_graph);
-		}
-		else {
+		if(red_graph.size()) {
 		  //
-		  red_graph_conv = _convert(*red_graph.perm_pool().begin());
-		}
+		  _Convert::vec_t red_graph_conv = _convert(red_graph.canonical());
 		
-#pragma omp critical(sum_critical)
-		{
-		  itemp = sum_data.find(red_graph_conv) != sum_data.end();
-		}
+		  double db_value;
 
-		// read reduced graph fourier sum value from the database
-		//
-		if(itemp) {
-		  ++sum_read;
+		  itemp = sum_data.find(red_graph_conv, db_value);
+
+		  // read reduced graph fourier sum value from the database
+		  //
+		  if(itemp) {
+		    ++sum_read;
 		
-#pragma omp critical(sum_critical)
-		  {
-		    int_val *= sum_data[red_graph_conv];
+		    int_val *= db_value;
 		  }
-		}
-		// reduced graph fourier sum calculation
-		//
-		else {
+		  // reduced graph fourier sum calculation
 		  //
-		  ++sum_calc;
+		  else {
+		    //
+		    ++sum_calc;
 		
-		  dtemp = red_graph.fourier_sum(_red_freq, temperature);
-		  int_val *= dtemp;
+		    dtemp = red_graph.fourier_sum(_red_freq, temperature);
+		    int_val *= dtemp;
 
-		  // save fourier sum calculation result in the database
-		  //
-#pragma omp critical(sum_critical)
-		  {
-		    if(sum_data.find(red_graph_conv) != sum_data.end()) {
+		    // save fourier sum calculation result in the database
+		    //
+		    if(!sum_data.insert(red_graph_conv, dtemp)) {
+		      //
 		      ++sum_miss;
 		    }
-		    else if(mod_flag & KEEP_PERM) {
-		      std::set<FreqGraph> pool = red_graph.perm_pool();
-		  
-		      for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-			sum_data[_convert(*pit)] = dtemp;
-		    }
-		    else {
-		      sum_data[red_graph_conv] = dtemp;
-		    }
-		  }
+		    //
+		    //
+		  } // reduced graph fourier sum calculation
 		  //
 		  //
-		} // reduced graph fourier sum calculation
-		//
+		} // reduced graph fourier sum evaluation
 		//
-	      } // reduced graph fourier sum evaluation
-	      //
-	      else {
-		int_val /= temperature;
-	      }
+		else {
+		  int_val /= temperature;
+		}
 
-	      for(int i = 0; i < fgit->second; ++i)
-		gfactor *= int_val;
+		for(int i = 0; i < fgit->second; ++i)
+		  gfactor *= int_val;
 
-	      // save whole integral calculation result in the database
-	      //
-#pragma omp critical(int_critical)
-	      {
-		if(int_data.find(fac_graph_conv) != int_data.end())
+		// save whole integral calculation result in the database
+		//
+		if(!int_data.insert(fac_graph_conv, int_val)) {
+		  //
 		  ++int_miss;
-		else if(mod_flag & KEEP_PERM) {
-		  std::set<FreqGraph> pool = fgit->first.perm_pool();
-
-		  for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-		    int_data[_convert(*pit)] = int_val;
-		}
-		else {
-		  int_data[fac_graph_conv] = int_val;
 		}
-	      }
+		//
+		//
+	      } // whole integral calculation
 	      //
 	      //
-	    } // whole integral calculation
+	    } // factorized graph cycle
 	    //
 	    //
-	  } // factorized graph cycle
+	  } // positive temperature
 	  //
 	  //
-	} // positive temperature
+	} // frequency adapted graph evaluation
+
+	gvalue += gfactor;
 	//
 	//
-      } // frequency adapted graph evaluation
-
-      gvalue += gfactor;
-      //
-      //
-    } // normal mode indices cycle
+      } // normal mode indices cycle
     
-    zpe_calc_tot += zpe_calc;
-    int_calc_tot += int_calc;
-    sum_calc_tot += sum_calc;
+      zpe_calc_tot += zpe_calc;
+      int_calc_tot += int_calc;
+      sum_calc_tot += sum_calc;
     
-    zpe_read_tot += zpe_read;
-    int_read_tot += int_read;
-    sum_read_tot += sum_read;
+      zpe_read_tot += zpe_read;
+      int_read_tot += int_read;
+      sum_read_tot += sum_read;
     
-    zpe_miss_tot += zpe_miss;
-    int_miss_tot += int_miss;
-    sum_miss_tot += sum_miss;
+      zpe_miss_tot += zpe_miss;
+      int_miss_tot += int_miss;
+      sum_miss_tot += sum_miss;
     
-    gvalue /= (double)graphit->symmetry_factor();
+      gvalue /= (double)graphit->symmetry_factor();
    
-    // odd number of vertices has minus sign
-    //
-    if(vertex_size % 2)
-      gvalue = -gvalue;
+      // odd number of vertices has minus sign
+      //
+      if(vertex_size % 2)
+	gvalue = -gvalue;
      
-    // zero-point energy has an opposite sign
-    //
-    if(temperature < 0.)
-      gvalue = -gvalue;
+      // zero-point energy has an opposite sign
+      //
+      if(temperature < 0.)
+	gvalue = -gvalue;
 
 #ifndef INNER_CYCLE_PARALLEL
 #pragma omp critical
 #endif
-    {
-      corr[graphit->size()] += gvalue;
+      {
+	corr[graphit->size()] += gvalue;
 
-      IO::log << IO::log_offset << std::setw(5) << gindex;
+	IO::log << IO::log_offset << std::setw(5) << gindex;
+
+	if(temperature > 0.) {
+	  //
+	  IO::log << std::setw(15) << gvalue;
+	}
+	else {
+	  //
+	  IO::log << std::setw(15) << gvalue / Phys_const::incm;
+	}
+
+	IO::log << std::setw(5) << graphit->vertex_size()
+		<< std::setw(5) << graphit->bond_size()
+		<< std::setw(5) << graphit->loop_size()
+		<< std::setw(7) << std::time(0) - start_time 
+		<< "   "        << *graphit 
+		<< std::endl;
 
-      if(temperature > 0.) {
-	//
-	IO::log << std::setw(15) << gvalue;
-      }
-      else {
-	//
-	IO::log << std::setw(15) << gvalue / Phys_const::incm;
       }
+      //
+      //
+    } // graph cycle
 
-      IO::log << std::setw(5) << graphit->vertex_size()
-	      << std::setw(5) << graphit->bond_size()
-	      << std::setw(5) << graphit->loop_size()
-	      << std::setw(7) << std::time(0) - start_time 
-	      << "   "        << *graphit 
-	      << std::endl;
+    order_time[oit->first] = std::time(0) - order_start;
+
+    curr_corr += corr[oit->first];
+
+    order_rel[oit->first] = _order_relative(corr[oit->first], curr_corr, temperature);
 
+    if(conv_thresh > 0. && order_rel[oit->first] < conv_thresh && oit->first != order_graph.rbegin()->first) {
+      //
+      conv_order = oit->first;
+
+      break;
     }
     //
     //
-  } // graph cycle
+  } // bond order cycle
+
+  _print_orders(order_graph, corr, order_rel, order_time, temperature);
+
+  if(conv_order)
+    //
+    IO::log << IO::log_offset << "the expansion converged at " << conv_order
+	    << " bond order, the higher orders are skipped\n\n";
+
+  if(Graph::cache_dir.size())
+    //
+    _save_store(store_key, int_data, sum_data, zpe_data);
   
   IO::log << "\n";
 
@@ -692,6 +680,10 @@ std::map<int, double> Graph::Expansion::correction (double temperature) const
       IO::log << std::setw(15) << sum_data.size();
   }
   IO::log << "\n\n";
+
+  zpe_data.report("ZPE");
+  int_data.report("Int");
+  sum_data.report("Sum");
   
   if(temperature > 0.) {
     //
@@ -724,17 +716,464 @@ std::map<int, double> Graph::Expansion::correction (double temperature) const
       res[mit->first] = curr_val;
     }
 
-    dtemp = curr_val;
+    dtemp = curr_val;
+    //
+    if(temperature < 0.) {
+      //
+      dtemp /= Phys_const::incm;
+    }
+
+    IO::log << IO::log_offset 
+	    << std::setw(2) << mit->first 
+	    << std::setw(15) << dtemp 
+	    << "\n";
+  }
+
+  IO::log << "\n";
+
+  return res;
+}
+
+// several temperatures at once: the potential expansion products, the graph factorization, and
+// the canonical graph forms are found once for all temperatures, and the fourier sums of the
+// reduced graphs shared by several temperatures are evaluated in one pass
+//
+std::vector<std::map<int, double> > Graph::Expansion::correction (const std::vector<double>& temperature) const
+{
+  const char funame [] = "Graph::Expansion::correction: ";
+
+  IO::Marker funame_marker(funame);
+
+  int    itemp;
+  double dtemp;
+  bool   btemp;
+
+  const int tsize = temperature.size();
+
+  std::vector<std::map<int, double> > res(tsize);
+
+  if(!tsize)
+    //
+    return res;
+
+  for(int t = 0; t < tsize; ++t)
+    //
+    if(temperature[t] <= 0.) {
+      //
+      ErrOut err_out;
+
+      err_out << funame << "temperature out of range: " << temperature[t] / Phys_const::kelv;
+    }
+
+  IO::log << IO::log_offset << "temperatures(K):";
+
+  for(int t = 0; t < tsize; ++t)
+    //
+    IO::log << " " << temperature[t] / Phys_const::kelv;
+
+  IO::log << "\n\n";
+
+  IO::log << IO::log_offset << std::setw(5) << "#";
+
+  for(int t = 0; t < tsize; ++t)
+    //
+    IO::log << std::setw(15) << "Value";
+
+  IO::log << std::setw(5) << "V#"
+	  << std::setw(5) << "B#"
+	  << std::setw(5) << "L#" 
+	  << std::setw(7) << "Time"
+	  << "   "        << "Graph"   
+	  << std::endl;
+  
+  std::vector<std::vector<double> > tanh_factor(tsize);
+  //
+  std::vector<std::set<int> > low_freq(tsize);
+
+  for(int t = 0; t < tsize; ++t)
+    //
+    low_freq[t] = _low_freq_set(temperature[t], tanh_factor[t]);
+  
+  int sum_calc_tot = 0;
+  int zpe_calc_tot = 0;
+  int int_calc_tot = 0;
+    
+  long sum_read_tot = 0;
+  long zpe_read_tot = 0;
+  long int_read_tot = 0;
+
+  std::vector<_gmap_t> int_data(tsize);
+  std::vector<_gmap_t> sum_data(tsize);
+  std::vector<_gmap_t> zpe_data(tsize);
+
+  // graph integrals from the previous runs, shared with the single temperature evaluation
+  //
+  std::vector<std::string> store_key(tsize);
+
+  if(Graph::cache_dir.size())
+    //
+    for(int t = 0; t < tsize; ++t) {
+      //
+      store_key[t] = _store_key("correction", temperature[t]);
+
+      _load_store(store_key[t], int_data[t], sum_data[t], zpe_data[t]);
+    }
+
+  std::vector<std::map<int, double> > corr(tsize);
+
+#pragma omp parallel for default(shared) reduction(+: sum_calc_tot, zpe_calc_tot, int_calc_tot, sum_read_tot, zpe_read_tot, int_read_tot) private(itemp, dtemp, btemp) schedule(dynamic)
+        
+  for(int gindex = 0; gindex < Graph::size(); ++gindex) {
+    //
+    Graph::const_iterator graphit = Graph::begin() + gindex;
+
+    std::time_t  start_time = std::time(0);
+
+    const std::vector<std::multiset<int> > vertex_map = graphit->vertex_bond_map();
+    const int vertex_size = vertex_map.size();
+
+    std::vector<double> gvalue(tsize);
+
+    MultiIndexConvert corr_multi_index(graphit->size(), _active_mode.size());
+
+    for(long corr_lin = 0; corr_lin < corr_multi_index.size(); ++corr_lin) {
+      //
+      std::vector<int> corrin = corr_multi_index(corr_lin);
+      //
+      for(int i = 0; i < corrin.size(); ++i)
+	//
+	corrin[i] = _active_mode[corrin[i]];
+
+      double potex_factor = 1.;
+
+      btemp = false;
+      //
+      for(std::vector<std::multiset<int> >::const_iterator mit = vertex_map.begin(); mit != vertex_map.end(); ++mit) {
+	//
+	int potex_sign [PotexTable::RANK_MAX];
+	//
+	const int rank = mit->size();
+	//
+	int si = 0;
+	//
+	for(std::multiset<int>::const_iterator it = mit->begin(); it != mit->end() && si < PotexTable::RANK_MAX; ++it, ++si)
+	  //
+	  potex_sign[si] = corrin[*it];
+
+	if(rank <= PotexTable::RANK_MAX && _potex_table.find(potex_sign, rank, dtemp)) {
+	  //
+	  potex_factor *= dtemp;
+	}
+	else {
+	  //
+	  btemp = true;
+	  //
+	  break;
+	}
+      }
+      
+      if(btemp)
+	//
+	continue;
+
+      std::vector<double> gfactor(tsize, potex_factor);
+
+      // frequency adapted graphs, the same for the temperatures with the same low frequencies
+      //
+      std::map<FreqGraph, std::vector<int> > mod_graph_pool;
+
+      for(int t = 0; t < tsize; ++t) {
+	//
+	FreqGraph mod_graph;
+      
+	itemp = 0;
+	//
+	for(GenGraph::const_iterator mit = graphit->begin(); mit != graphit->end(); ++mit, ++itemp) {
+	  //
+	  int fi = _red_freq_index[corrin[itemp]]; // reduced frequency index
+
+	  // low frequency correlator is a constant
+	  //
+	  if(low_freq[t].find(fi) != low_freq[t].end()) {
+	    //
+	    if(_red_freq[fi] > 0.) {
+	      //
+	      gfactor[t] *=  temperature[t] / _red_freq[fi] / _red_freq[fi];
+	    }
+	    else {
+	      //
+	      gfactor[t] *= -temperature[t] / _red_freq[fi] / _red_freq[fi];
+	    }
+
+	    continue;
+	  }
+
+	  std::set<int> bond;
+	  //
+	  for(std::multiset<int>::const_iterator it = mit->begin(); it != mit->end(); ++it)
+	    //
+	    bond.insert(*it);
+
+	  // bond loop
+	  //
+	  if(bond.size() == 1) {
+	    //
+	    gfactor[t] /= 2. * _red_freq[fi] * tanh_factor[t][fi];
+	  }
+	  // add frequency index to the graph
+	  //
+	  else {
+	    //
+	    mod_graph[bond].insert(fi);
+	  }
+	}
+
+	itemp = vertex_size - mod_graph.vertex_size();
+	//
+	if(itemp)
+	  //
+	  gfactor[t] /= std::pow(temperature[t], (double)itemp);
+
+	mod_graph_pool[mod_graph].push_back(t);
+      }
+
+      for(std::map<FreqGraph, std::vector<int> >::const_iterator mgit = mod_graph_pool.begin(); mgit != mod_graph_pool.end(); ++mgit) {
+	//
+	if(!mgit->first.size())
+	  //
+	  continue;
+
+	const std::vector<int>& tpool = mgit->second;
+
+	// graph factorization into connected graphs
+	//
+	_mg_t fac_graph = mgit->first.factorize();
+
+	// factorized graph cycle
+	//
+	for(_mg_t::const_iterator fgit = fac_graph.begin(); fgit != fac_graph.end(); ++fgit) {
+	  //
+	  _Convert::vec_t fac_graph_conv = _convert(fgit->first.canonical());
+
+	  // reduced graphs with the temperatures at which their fourier sums are needed
+	  //
+	  std::map<FreqGraph, std::vector<int> > red_graph_pool;
+
+	  std::map<int, double> int_val;
+
+	  for(std::vector<int>::const_iterator tit = tpool.begin(); tit != tpool.end(); ++tit) {
+	    //
+	    const int t = *tit;
+
+	    double db_value;
+
+	    // read whole integral value from the database
+	    //
+	    if(int_data[t].find(fac_graph_conv, db_value)) {
+	      //
+	      ++int_read_tot;
+
+	      for(int i = 0; i < fgit->second; ++i)
+		gfactor[t] *= db_value;
+
+	      continue;
+	    }
+
+	    ++int_calc_tot;
+
+	    int_val[t] = 1.;
+
+	    // graph reduction
+	    //
+	    _mg_t zpe_graph;
+	    FreqGraph red_graph = fgit->first.reduce(_red_freq, temperature[t], tanh_factor[t], zpe_graph);
+
+	    // zpe graph cycle
+	    //
+	    for(_mg_t::const_iterator zgit = zpe_graph.begin(); zgit != zpe_graph.end(); ++zgit) {
+	      //
+	      _Convert::vec_t zpe_graph_conv = _convert(zgit->first.canonical());
+
+	      if(zpe_data[t].find(zpe_graph_conv, db_value)) {
+		//
+		++zpe_read_tot;
+	      }
+	      else {
+		//
+		++zpe_calc_tot;
+		
+		db_value = zgit->first.zpe_factor(_red_freq, temperature[t], tanh_factor[t]);
+
+		zpe_data[t].insert(zpe_graph_conv, db_value);
+	      }
+
+	      for(int i = 0; i < zgit->second; ++i)
+		int_val[t] *= db_value;
+	    }
+
+	    if(red_graph.size()) {
+	      //
+	      red_graph_pool[red_graph].push_back(t);
+	    }
+	    else
+	      //
+	      int_val[t] /= temperature[t];
+	  }
+
+	  // reduced graph fourier sums
+	  //
+	  for(std::map<FreqGraph, std::vector<int> >::const_iterator rgit = red_graph_pool.begin(); rgit != red_graph_pool.end(); ++rgit) {
+	    //
+	    _Convert::vec_t red_graph_conv = _convert(rgit->first.canonical());
+
+	    std::vector<int>    calc_index;
+	    std::vector<double> calc_temp;
+
+	    for(std::vector<int>::const_iterator tit = rgit->second.begin(); tit != rgit->second.end(); ++tit) {
+	      //
+	      double db_value;
+
+	      if(sum_data[*tit].find(red_graph_conv, db_value)) {
+		//
+		++sum_read_tot;
+
+		int_val[*tit] *= db_value;
+	      }
+	      else {
+		//
+		calc_index.push_back(*tit);
+
+		calc_temp.push_back(temperature[*tit]);
+	      }
+	    }
+
+	    if(!calc_index.size())
+	      //
+	      continue;
+
+	    sum_calc_tot += calc_index.size();
+
+	    std::vector<double> sum_val(calc_index.size());
+
+	    rgit->first.fourier_sum(_red_freq, &calc_temp[0], calc_temp.size(), &sum_val[0]);
+
+	    for(int i = 0; i < calc_index.size(); ++i) {
+	      //
+	      int_val[calc_index[i]] *= sum_val[i];
+
+	      sum_data[calc_index[i]].insert(red_graph_conv, sum_val[i]);
+	    }
+	  }
+
+	  // save whole integral calculation results in the database
+	  //
+	  for(std::map<int, double>::const_iterator iit = int_val.begin(); iit != int_val.end(); ++iit) {
+	    //
+	    for(int i = 0; i < fgit->second; ++i)
+	      gfactor[iit->first] *= iit->second;
+
+	    int_data[iit->first].insert(fac_graph_conv, iit->second);
+	  }
+	  //
+	  //
+	} // factorized graph cycle
+	//
+	//
+      } // frequency adapted graph cycle
+
+      for(int t = 0; t < tsize; ++t)
+	//
+	gvalue[t] += gfactor[t];
+      //
+      //
+    } // normal mode indices cycle
+
+    for(int t = 0; t < tsize; ++t) {
+      //
+      gvalue[t] /= (double)graphit->symmetry_factor();
+   
+      // odd number of vertices has minus sign
+      //
+      if(vertex_size % 2)
+	gvalue[t] = -gvalue[t];
+    }
+
+#pragma omp critical
+    {
+      IO::log << IO::log_offset << std::setw(5) << gindex;
+
+      for(int t = 0; t < tsize; ++t) {
+	//
+	corr[t][graphit->size()] += gvalue[t];
+
+	IO::log << std::setw(15) << gvalue[t];
+      }
+
+      IO::log << std::setw(5) << graphit->vertex_size()
+	      << std::setw(5) << graphit->bond_size()
+	      << std::setw(5) << graphit->loop_size()
+	      << std::setw(7) << std::time(0) - start_time 
+	      << "   "        << *graphit 
+	      << std::endl;
+    }
+    //
+    //
+  } // graph cycle
+
+  if(Graph::cache_dir.size())
+    //
+    for(int t = 0; t < tsize; ++t)
+      //
+      _save_store(store_key[t], int_data[t], sum_data[t], zpe_data[t]);
+
+  IO::log << "\n";
+
+  IO::log << IO::log_offset << "Statistics:\n\n";
+
+  IO::log << IO::log_offset
+	  << std::setw(10) << "ZPE Calc" << std::setw(15) << "ZPE Read"
+	  << std::setw(10) << "Int Calc" << std::setw(15) << "Int Read"
+	  << std::setw(10) << "Sum Calc" << std::setw(15) << "Sum Read"
+	  << "\n";
+
+  IO::log << IO::log_offset
+	  << std::setw(10) << zpe_calc_tot << std::setw(15) << zpe_read_tot
+	  << std::setw(10) << int_calc_tot << std::setw(15) << int_read_tot
+	  << std::setw(10) << sum_calc_tot << std::setw(15) << sum_read_tot
+	  << "\n\n";
+
+  for(int t = 0; t < tsize; ++t) {
+    //
+    int_data[t].report("Int");
+    sum_data[t].report("Sum");
+  }
+  
+  IO::log << IO::log_offset << "anharmonic correction:\n";
+
+  IO::log << IO::log_offset << std::setw(2) << "BO";
+
+  for(int t = 0; t < tsize; ++t)
+    //
+    IO::log << std::setw(15) << "Value";
+
+  IO::log << "\n";
+
+  std::vector<double> curr_val(tsize);
+
+  for(std::map<int, double>::const_iterator mit = corr[0].begin(); mit != corr[0].end(); ++mit) {
     //
-    if(temperature < 0.) {
+    IO::log << IO::log_offset << std::setw(2) << mit->first;
+
+    for(int t = 0; t < tsize; ++t) {
       //
-      dtemp /= Phys_const::incm;
+      curr_val[t] += corr[t][mit->first];
+
+      res[t][mit->first] = std::exp(curr_val[t]);
+
+      IO::log << std::setw(15) << curr_val[t];
     }
 
-    IO::log << IO::log_offset 
-	    << std::setw(2) << mit->first 
-	    << std::setw(15) << dtemp 
-	    << "\n";
+    IO::log << "\n";
   }
 
   IO::log << "\n";
@@ -802,6 +1241,17 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
   _gmap_t zpe_data;
   _gmap_t int_data;
 
+  // graph integrals from the previous runs
+  //
+  std::string store_key;
+
+  if(Graph::cache_dir.size()) {
+    //
+    store_key = _store_key("centroid_correction", temperature);
+
+    _load_store(store_key, int_data, sum_data, zpe_data);
+  }
+
   std::map<int, double> corr;
   std::map<int, std::map<int, double> > zpe;
 
@@ -833,7 +1283,7 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
     long zpe_read = 0;
     long int_read = 0;
     
-    MultiIndexConvert corr_multi_index(graphit->size(), _red_freq_index.size());
+    MultiIndexConvert corr_multi_index(graphit->size(), _active_mode.size());
 
 #ifdef INNER_CYCLE_PARALLEL
 #pragma omp parallel for default(shared) reduction(+: sum_calc, zpe_calc, int_calc, sum_read, zpe_read, int_read, sum_miss, zpe_miss, int_miss, gvalue) private(itemp, dtemp, btemp) schedule(dynamic)
@@ -842,6 +1292,10 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
     for(long corr_li = 0; corr_li < corr_multi_index.size(); ++corr_li) {
 
       std::vector<int> corrin = corr_multi_index(corr_li);
+      //
+      for(int i = 0; i < corrin.size(); ++i)
+	//
+	corrin[i] = _active_mode[corrin[i]];
 
       double potfac = 1.;
 
@@ -849,17 +1303,19 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
       //
       for(std::vector<std::multiset<int> >::const_iterator mit = vertex_map.begin(); mit != vertex_map.end(); ++mit) {
 	//
-	std::multiset<int> potex_sign;
+	int potex_sign [PotexTable::RANK_MAX];
+	//
+	const int rank = mit->size();
+	//
+	int si = 0;
+	//
+	for(std::multiset<int>::const_iterator it = mit->begin(); it != mit->end() && si < PotexTable::RANK_MAX; ++it, ++si)
 	  //
-	for(std::multiset<int>::const_iterator it = mit->begin(); it != mit->end(); ++it)
-	    //
-	  potex_sign.insert(corrin[*it]);
+	  potex_sign[si] = corrin[*it];
 
-	potex_t::const_iterator pexit = _potex.find(potex_sign);
-	
-	if(pexit != _potex.end()) {
+	if(rank <= PotexTable::RANK_MAX && _potex_table.find(potex_sign, rank, dtemp)) {
 	  //
-	  potfac *= pexit->second;
+	  potfac *= dtemp;
 	}
 	else {
 	  //
@@ -1021,16 +1477,7 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 	  //
 	  for(_mg_t::const_iterator fgit = fac_graph.begin(); fgit != fac_graph.end(); ++fgit) {
 	    //
-	    _Convert::vec_t fac_graph_conv;
-
-	    if(mod_flag & KEEP_PERM) {
-	      //
-	      fac_graph_conv = _convert(fgit->first);
-	    }
-	    else {
-	      //
-	      fac_graph_conv = _convert(*fgit->first.perm_pool().begin());
-	    }
+	    _Convert::vec_t fac_graph_conv = _convert(fgit->first.canonical());
 
 	    // zero temperature integral evaluation
 	    //
@@ -1038,10 +1485,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 	      //
 	      t_count -= fgit->second;
 
-#pragma omp critical(zpe_critical)
-	      {
-		itemp = zpe_data.find(fac_graph_conv) != zpe_data.end();
-	      }
+	      double db_value;
+
+	      itemp = zpe_data.find(fac_graph_conv, db_value);
 
 	      // read zero temperature integral value from the database
 	      //
@@ -1049,10 +1495,7 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 		//
 		++zpe_read;
 		  
-#pragma omp critical(zpe_critical)
-		{
-		  dtemp = zpe_data[fac_graph_conv];
-		}
+		dtemp = db_value;
 		
 		for(int i = 0; i < fgit->second; ++i)
 		  //
@@ -1072,25 +1515,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 
 		// save zero temperature integral calculation result in the database
 		//
-#pragma omp critical(zpe_critical)
-		{
-		  if(zpe_data.find(fac_graph_conv) != zpe_data.end()) {
-		    //
-		    ++zpe_miss;
-		  }
-		  else if(mod_flag & KEEP_PERM) {
-		    //
-		    // permutationally equivalent configurations
-		    //
-		    std::set<FreqGraph> pool = fgit->first.perm_pool();
-		    
-		    for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-		      zpe_data[_convert(*pit)] = dtemp;
-		  }
-		  else {
-		    //
-		    zpe_data[fac_graph_conv] = dtemp;
-		  }
+		if(!zpe_data.insert(fac_graph_conv, dtemp)) {
+		  //
+		  ++zpe_miss;
 		}
 		//
 		//
@@ -1104,10 +1531,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 	    //
 	    else {
 	      //
-#pragma omp critical(int_critical)
-	      {
-		itemp = int_data.find(fac_graph_conv) != int_data.end();
-	      }
+	      double db_value;
+
+	      itemp = int_data.find(fac_graph_conv, db_value);
 
 	      // read whole integral value from the database
 	      //
@@ -1115,10 +1541,7 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 		//
 		++int_read;
 
-#pragma omp critical(int_critical)
-		{
-		  dtemp = int_data[fac_graph_conv];
-		}
+		dtemp = db_value;
 	      
 		for(int i = 0; i < fgit->second; ++i)
 		  //
@@ -1145,31 +1568,18 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 		  //
 		  // low temperature integral (zpe factor) evaluation
 	      
-		  _Convert::vec_t zpe_graph_conv;
-	      
-		  if(mod_flag & KEEP_PERM) {
-		    //
-		    zpe_graph_conv = _convert(zgit->first);
-		  }
-		  else {
-		    //
-		    zpe_graph_conv = _convert(*zgit->first.perm_pool().begin());
-		  }
+		  _Convert::vec_t zpe_graph_conv = _convert(zgit->first.canonical());
 		  
-#pragma omp critical(zpe_critical)
-		  {
-		    itemp = zpe_data.find(zpe_graph_conv) != zpe_data.end();
-		  }
+		  double db_value;
+
+		  itemp = zpe_data.find(zpe_graph_conv, db_value);
 
 		  // read low temperature integral value from the database
 		  if(itemp) {
 		    //
 		    ++zpe_read;
 		  
-#pragma omp critical(zpe_critical)
-		    {
-		      dtemp = zpe_data[zpe_graph_conv];
-		    }
+		    dtemp = db_value;
 		
 		    for(int i = 0; i < zgit->second; ++i)
 		      //
@@ -1189,24 +1599,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 
 		    // save calculation result in the database
 		    //
-#pragma omp critical(zpe_critical)
-		    {
-		      if(zpe_data.find(zpe_graph_conv) != zpe_data.end()) {
-			//
-			++zpe_miss;
-		      }
-		      else if(mod_flag & KEEP_PERM) {
-			//
-			std::set<FreqGraph> pool = zgit->first.perm_pool();
-
-			for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-			  //
-			  zpe_data[_convert(*pit)] = dtemp;
-		      }
-		      else {
-			//
-			zpe_data[zpe_graph_conv] = dtemp;
-		      }
+		    if(!zpe_data.insert(zpe_graph_conv, dtemp)) {
+		      //
+		      ++zpe_miss;
 		    }
 		    //
 		    //
@@ -1219,21 +1614,11 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 		//
 		if(red_graph.size()) {
 		  //
-		  _Convert::vec_t red_graph_conv;
+		  _Convert::vec_t red_graph_conv = _convert(red_graph.canonical());
 
-		  if(mod_flag & KEEP_PERM) {
-		    //
-		    red_graph_conv = _convert(red_graph);
-		  }
-		  else {
-		    //
-		    red_graph_conv = _convert(*red_graph.perm_pool().begin());
-		  }
+		  double db_value;
 
-#pragma omp critical(sum_critical)
-		  {
-		    itemp = sum_data.find(red_graph_conv) != sum_data.end();
-		  }
+		  itemp = sum_data.find(red_graph_conv, db_value);
 
 		  // read reduced graph fourier sum from the database
 		  //
@@ -1241,10 +1626,7 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 		    //
 		    ++sum_read;
 		
-#pragma omp critical(sum_critical)
-		    {
-		      int_val *= sum_data[red_graph_conv];
-		    }
+		    int_val *= db_value;
 		  }
 		  // reduced graph fourier sum calculation
 		  //
@@ -1258,24 +1640,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 
 		    // save calculation result in the database
 		    //
-#pragma omp critical(sum_critical)
-		    {
-		      if(sum_data.find(red_graph_conv) != sum_data.end()) {
-			//
-			++sum_miss;
-		      }
-		      else if(mod_flag & KEEP_PERM) {
-			//
-			std::set<FreqGraph> pool = red_graph.perm_pool();
-
-			for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-			  //
-			  sum_data[_convert(*pit)] = dtemp;
-		      }
-		      else {
-			//
-			sum_data[red_graph_conv] = dtemp;
-		      }
+		    if(!sum_data.insert(red_graph_conv, dtemp)) {
+		      //
+		      ++sum_miss;
 		    }
 		    //
 		    //
@@ -1295,24 +1662,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
 
 		// save whole integral value in the database
 		//
-#pragma omp critical(int_critical)
-		{
-		  if(int_data.find(fac_graph_conv) != int_data.end()) {
-		    //
-		    ++int_miss;
-		  }
-		  else if(mod_flag & KEEP_PERM) {
-		    //
-		    std::set<FreqGraph> pool = fgit->first.perm_pool();
-	      
-		    for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-		      //
-		      int_data[_convert(*pit)] = int_val;
-		  }
-		  else {
-		    //
-		    int_data[fac_graph_conv] = int_val;
-		  }
+		if(!int_data.insert(fac_graph_conv, int_val)) {
+		  //
+		  ++int_miss;
 		}
 		//
 		//
@@ -1396,6 +1748,10 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
     }
   } // graph cycle
 
+  if(Graph::cache_dir.size())
+    //
+    _save_store(store_key, int_data, sum_data, zpe_data);
+
   IO::log << "\n";
 
   if(temperature <= 0.) {
@@ -1519,6 +1875,10 @@ std::map<int, double> Graph::Expansion::centroid_correction (double temperature)
       IO::log << std::setw(15) << sum_data.size();
   }
   IO::log << "\n\n";
+
+  zpe_data.report("ZPE");
+  int_data.report("Int");
+  sum_data.report("Sum");
   
   std::map<int, double> res;
  
@@ -1665,6 +2025,33 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
   _gmap_t zpe_data;
   _gmap_t int_data;
 
+  // graph integrals from the previous runs
+  //
+  std::string store_key;
+
+  if(Graph::cache_dir.size()) {
+    //
+    store_key = _store_key("centroid_correction", temperature);
+
+    std::ostringstream mmat_key;
+
+    mmat_key << std::setprecision(17);
+
+    for(std::map<std::multiset<int>, double>::const_iterator mit = mmat.begin(); mit != mmat.end(); ++mit) {
+      //
+      mmat_key << "\n";
+
+      for(std::multiset<int>::const_iterator it = mit->first.begin(); it != mit->first.end(); ++it)
+	mmat_key << *it << " ";
+
+      mmat_key << mit->second;
+    }
+
+    store_key += mmat_key.str();
+
+    _load_store(store_key, int_data, sum_data, zpe_data);
+  }
+
   std::map<int, double> corr;
   //
   std::map<int, std::map<int, double> > zpe;
@@ -1734,18 +2121,19 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
       //
       for(std::vector<std::set<int> >::const_iterator mit = vertex_map.begin(); mit != vertex_map.end(); ++mit) {
 	//
-	std::multiset<int> potex_sign;
+	int potex_sign [PotexTable::RANK_MAX];
 	//
-	for(std::set<int>::const_iterator it = mit->begin(); it != mit->end(); ++it) {
-	    //
-	  potex_sign.insert(corrin[*it]);
-	}
-	      
-	potex_t::const_iterator pexit = _potex.find(potex_sign);
-	
-	if(pexit != _potex.end()) {
+	const int rank = mit->size();
+	//
+	int si = 0;
+	//
+	for(std::set<int>::const_iterator it = mit->begin(); it != mit->end() && si < PotexTable::RANK_MAX; ++it, ++si)
 	  //
-	  potfac *= pexit->second;
+	  potex_sign[si] = corrin[*it];
+
+	if(rank <= PotexTable::RANK_MAX && _potex_table.find(potex_sign, rank, dtemp)) {
+	  //
+	  potfac *= dtemp;
 	}
 	else {
 	  //
@@ -1989,16 +2377,7 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 	  //
 	  for(_mg_t::const_iterator fgit = fac_graph.begin(); fgit != fac_graph.end(); ++fgit) {
 	    //
-	    _Convert::vec_t fac_graph_conv;
-
-	    if(mod_flag & KEEP_PERM) {
-	      //
-	      fac_graph_conv = _convert(fgit->first);
-	    }
-	    else {
-	      //
-	      fac_graph_conv = _convert(*fgit->first.perm_pool().begin());
-	    }
+	    _Convert::vec_t fac_graph_conv = _convert(fgit->first.canonical());
 	    
 	    // zero temperature integral (zpe factor) evaluation
 	    //
@@ -2006,10 +2385,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 	      //
 	      t_count -= fgit->second;
 
-#pragma omp critical(zpe_critical)
-	      {	      
-		itemp = zpe_data.find(fac_graph_conv) != zpe_data.end();
-	      }
+	      double db_value;
+
+	      itemp = zpe_data.find(fac_graph_conv, db_value);
 
 	      // read zero temperature integral (zpe factor) value from the database
 	      //
@@ -2017,10 +2395,7 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 		//
 		++zpe_read;
 		  
-#pragma omp critical(zpe_critical)
-		{
-		  dtemp = zpe_data[fac_graph_conv];
-		}
+		dtemp = db_value;
 		
 		for(int i = 0; i < fgit->second; ++i)
 		  //
@@ -2041,24 +2416,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 
 		// save zero temperature integral (zpe factor) value in the database
 		//
-#pragma omp critical(zpe_critical)
-		{	      
-		  if(zpe_data.find(fac_graph_conv) != zpe_data.end()) {
-		    //
-		    ++zpe_miss;
-		  }
-		  else if(mod_flag & KEEP_PERM) {
-		    //
-		    std::set<FreqGraph> pool = fgit->first.perm_pool();
-		  
-		    for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-		      //
-		      zpe_data[_convert(*pit)] = dtemp;
-		  }
-		  else {
-		    //
-		    zpe_data[fac_graph_conv] = dtemp;
-		  }
+		if(!zpe_data.insert(fac_graph_conv, dtemp)) {
+		  //
+		  ++zpe_miss;
 		}
 		//
 		//
@@ -2071,10 +2431,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 	    //
 	    else {
 	      //
-#pragma omp critical(int_critical)
-	      {	      
-		itemp = int_data.find(fac_graph_conv) != int_data.end();
-	      }
+	      double db_value;
+
+	      itemp = int_data.find(fac_graph_conv, db_value);
 
 	      // read whole integral value from the database
 	      //
@@ -2082,10 +2441,7 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 		//
 		++int_read;
 	      
-#pragma omp critical(int_critical)
-		{	      
-		  dtemp = int_data[fac_graph_conv];
-		}
+		dtemp = db_value;
 
 		for(int i = 0; i < fgit->second; ++i)
 		  //
@@ -2112,21 +2468,11 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 		  //
 		  // low temperature integral (zpe factor) evaluation
 		  //
-		  _Convert::vec_t zpe_graph_conv;
-
-		  if(mod_flag & KEEP_PERM) {
-		    //
-		    zpe_graph_conv = _convert(zgit->first);
-		  }
-		  else {
-		    //
-		    zpe_graph_conv = _convert(*zgit->first.perm_pool().begin());
-		  }
+		  _Convert::vec_t zpe_graph_conv = _convert(zgit->first.canonical());
 	      
-#pragma omp critical(zpe_critical)
-		  {	      
-		    itemp = zpe_data.find(zpe_graph_conv) != zpe_data.end();
-		  }
+		  double db_value;
+
+		  itemp = zpe_data.find(zpe_graph_conv, db_value);
 
 		  // read low temperature integral (zpe factor) value from the database
 		  //
@@ -2134,10 +2480,7 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 		    //
 		    ++zpe_read;
 		  
-#pragma omp critical(zpe_critical)
-		    {	      
-		      dtemp = zpe_data[zpe_graph_conv];
-		    }
+		    dtemp = db_value;
 		
 		    for(int i = 0; i < zgit->second; ++i)
 		      //
@@ -2157,24 +2500,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 
 		    // save low temperature integral (zpe factor) value in the database
 		    //
-#pragma omp critical(zpe_critical)
-		    {	      
-		      if(zpe_data.find(zpe_graph_conv) != zpe_data.end()) {
-			//
-			++zpe_miss;
-		      }
-		      else if(mod_flag & KEEP_PERM) {
-			//
-			std::set<FreqGraph> pool = zgit->first.perm_pool();
-	  
-			for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-			  //
-			  zpe_data[_convert(*pit)] = dtemp;
-		      }
-		      else {
-			//
-			zpe_data[zpe_graph_conv] = dtemp;
-		      }
+		    if(!zpe_data.insert(zpe_graph_conv, dtemp)) {
+		      //
+		      ++zpe_miss;
 		    }
 		    //
 		    //
@@ -2187,21 +2515,11 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 		//
 		if(red_graph.size()) {
 		  //
-		  _Convert::vec_t red_graph_conv;
+		  _Convert::vec_t red_graph_conv = _convert(red_graph.canonical());
 
-		  if(mod_flag & KEEP_PERM) {
-		    //
-		    red_graph_conv = _convert(red_graph);
-		  }
-		  else {
-		    //
-		    red_graph_conv = _convert(*red_graph.perm_pool().begin());
-		  }
+		  double db_value;
 
-#pragma omp critical(sum_critical)
-		  {	      
-		    itemp = sum_data.find(red_graph_conv) != sum_data.end();
-		  }
+		  itemp = sum_data.find(red_graph_conv, db_value);
 
 		  // read reduced graph fourier sum from the database
 		  //
@@ -2209,10 +2527,7 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 		    //
 		    ++sum_read;
 		
-#pragma omp critical(sum_critical)
-		    {	      
-		      int_val *= sum_data[red_graph_conv];
-		    }
+		    int_val *= db_value;
 		  }
 		  // reduced graph fourier sum calculation
 		  //
@@ -2226,24 +2541,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 
 		    // save reduced graph fourier sum in the database
 		    //
-#pragma omp critical(sum_critical)
-		    {	      
-		      if(sum_data.find(red_graph_conv) != sum_data.end()) {
-			//
-			++sum_miss;
-		      }
-		      else if(mod_flag & KEEP_PERM) {
-			//
-			std::set<FreqGraph> pool = red_graph.perm_pool();
-		
-			for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-			  //
-			  sum_data[_convert(*pit)] = dtemp;
-		      }
-		      else {
-			//
-			sum_data[red_graph_conv] = dtemp;
-		      }
+		    if(!sum_data.insert(red_graph_conv, dtemp)) {
+		      //
+		      ++sum_miss;
 		    }
 		    //
 		    //
@@ -2263,24 +2563,9 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
 
 		// save whole integral value in the database
 		//
-#pragma omp critical(int_critical)
-		{	      
-		  if(int_data.find(fac_graph_conv) != int_data.end()) {
-		    //
-		    ++int_miss;
-		  }
-		  else if(mod_flag & KEEP_PERM) {
-		    //
-		    std::set<FreqGraph> pool = fgit->first.perm_pool();
-
-		    for(std::set<FreqGraph>::const_iterator pit = pool.begin(); pit != pool.end(); ++pit)
-		      //
-		      int_data[_convert(*pit)] = int_val;
-		  }
-		  else {
-		    //
-		    int_data[fac_graph_conv] = int_val;
-		  }
+		if(!int_data.insert(fac_graph_conv, int_val)) {
+		  //
+		  ++int_miss;
 		}
 		//
 		//
@@ -2371,6 +2656,10 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
     //
   } // graph cycle
 
+  if(Graph::cache_dir.size())
+    //
+    _save_store(store_key, int_data, sum_data, zpe_data);
+
   IO::log << "\n";
 
   if(temperature <= 0) {
@@ -2496,6 +2785,10 @@ std::map<int, double> Graph::Expansion::centroid_correction (const std::map<std:
   }
   IO::log << "\n\n";
 
+  zpe_data.report("ZPE");
+  int_data.report("Int");
+  sum_data.report("Sum");
+
   std::map<int, double> res;
 
   if(temperature > 0.) {
@@ -2607,7 +2900,7 @@ void Graph::Expansion::init (const std::vector<double>& freq, const potex_t& pex
 
   // initialize potential expansion
   //
-  _potex = pex;
+  _screen_potex(freq, pex);
 
   // maximal number of vertices
   //
@@ -2620,161 +2913,154 @@ void Graph::Expansion::init (const std::vector<double>& freq, const potex_t& pex
 
 #include "graph_include.cc"
 
-/*************************************************************************************************
- ****************************** FREQUENCY ADAPTED GRAPH CONVERTER ********************************
- *************************************************************************************************/
-
-void Graph::Expansion::_Convert::init (int v, int f)
+// relative contribution of the bond order: to the correction factor at positive
+// temperature, and to the zero-point energy correction otherwise
+//
+double Graph::Expansion::_order_relative (double order_corr, double total_corr, double temperature)
 {
-  const char funame [] = "Graph::Expansion::_Convert::init: ";
+  if(temperature > 0.)
+    //
+    return std::fabs(order_corr);
 
-  int itemp;
-  
-  _vertex_size_max = v;
+  if(total_corr == 0.)
+    //
+    return order_corr == 0. ? 0. : 1.;
 
-  _freq_size       = f;
+  return std::fabs(order_corr / total_corr);
+}
 
-  if(v <= 0 || f <= 0) {
-    //
-    ErrOut err_out;
+// per bond order contributions and timing
+//
+void Graph::Expansion::_print_orders (const std::map<int, std::vector<int> >& order_graph,
+				      const std::map<int, double>&            order_corr,
+				      const std::map<int, double>&            order_rel,
+				      const std::map<int, std::time_t>&       order_time,
+				      double                                  temperature)
+{
+  IO::log << IO::log_offset << "bond order convergence:\n";
 
-    err_out << funame << "maximum number of vertices and/or number of frequencies out of range: " << v << ", " << f;
-  }
+  IO::log << IO::log_offset
+	  << std::setw(2)  << "BO"
+	  << std::setw(8)  << "Graphs"
+	  << std::setw(15) << (temperature > 0. ? "Contribution" : "Contr., 1/cm")
+	  << std::setw(15) << "Relative"
+	  << std::setw(7)  << "Time"
+	  << "\n";
 
-  // check if the used integer type can accommodate the graph data
-  //
-  if(sizeof(int_t) < sizeof(int)) {
+  for(std::map<int, double>::const_iterator rit = order_rel.begin(); rit != order_rel.end(); ++rit) {
     //
-    itemp = 1;
+    double dtemp = order_corr.find(rit->first)->second;
 
-    itemp <<= sizeof(int_t) * 8 - 1;
-    
-    if(itemp < f * v * (v - 1) / 2) {
+    if(temperature <= 0.)
       //
-      ErrOut err_out;
+      dtemp /= Phys_const::incm;
 
-      err_out << funame << "integer type is too small to accommodate graph data";
-    }
+    IO::log << IO::log_offset
+	    << std::setw(2)  << rit->first
+	    << std::setw(8)  << order_graph.find(rit->first)->second.size()
+	    << std::setw(15) << dtemp
+	    << std::setw(15) << rit->second
+	    << std::setw(7)  << order_time.find(rit->first)->second
+	    << "\n";
   }
 
-  _index_map.resize(v * (v - 1) / 2);
+  IO::log << "\n";
+}
+
+/*************************************************************************************************
+ ********************************* CROSS-RUN GRAPH INTEGRALS STORE *******************************
+ *************************************************************************************************/
+
+std::string Graph::Expansion::_store_key (const std::string& name, double temperature) const
+{
+  std::ostringstream key;
+
+  key << std::setprecision(17)
+      << "GraphIntegrals 1 " << name
+      << " " << Graph::bond_max
+      << " " << temperature
+      << " " << low_freq_thresh
+      << " " << FreqGraph::red_thresh
+      << " " << FreqGraph::four_cut
+      << " " << FreqGraph::four_par;
 
-  itemp = 0;
-  //
-  for(int i = 1; i < v; ++i) {
+  for(int f = 0; f < _red_freq.size(); ++f)
     //
-    for(int j = 0; j < i; ++j, ++itemp) {
-      //
-      _index_map[itemp].insert(i);
-   
-      _index_map[itemp].insert(j);
-    }
-  }
+    key << " " << _red_freq[f];
+
+  return key.str();
 }
 
-Graph::FreqGraph Graph::Expansion::_Convert::operator() (const vec_t& gconv) const
+bool Graph::Expansion::_load_store (const std::string& key, _gmap_t& int_data, _gmap_t& sum_data, _gmap_t& zpe_data) const
 {
-  const char funame [] = "Graph::Expansion::_Convert::operator(): ";
-  
+  const std::string name = Graph::cache_file(key, ".gint");
+
+  std::ifstream from(name.c_str(), std::ios::binary);
+
+  if(!from)
+    //
+    return false;
+
   int itemp;
 
-  if(!_vertex_size_max) {
+  std::string stemp;
+
+  if(from.read((char*)&itemp, sizeof(itemp)) && itemp == key.size()) {
     //
-    ErrOut err_out;
+    stemp.resize(itemp);
 
-    err_out << funame << "frequency graph data converter not initialized";
+    from.read(&stemp[0], itemp);
   }
 
-  FreqGraph res;
+  if(!from || stemp != key) {
+    //
+    IO::log << IO::log_offset << "WARNING: graph integrals store " << name << " does not match, ignoring\n";
 
-  if(!gconv.size())
-    return res;
+    return false;
+  }
 
-  for(int i = 0; i < gconv.size(); ++i) {
+  if(!int_data.load(from) || !sum_data.load(from) || !zpe_data.load(from)) {
     //
-    if(gconv[i] < 0) {
-      //
-      ErrOut err_out;
-
-      err_out << funame << "negative index";
-    }
+    IO::log << IO::log_offset << "WARNING: cannot read graph integrals store " << name << "\n";
 
-    itemp = gconv[i] / _freq_size;
-    
-    if(itemp >= _vertex_size_max * (_vertex_size_max - 1) / 2) {
-      //
-      ErrOut err_out;
-      //
-      err_out << funame << "vertex index convert out of range";
-    }
-    
-    res[_index_map[itemp]].insert(gconv[i] % _freq_size - 1);
+    return false;
   }
 
-  return res;
+  IO::log << IO::log_offset << int_data.size() + sum_data.size() + zpe_data.size() << " graph integrals read from " << name << "\n\n";
+
+  return true;
 }
-  
-Graph::Expansion::_Convert::vec_t Graph::Expansion::_Convert::operator() (const FreqGraph& freq_graph) const
-{
-  const char funame [] = "Graph::Expansion::_Convert::operator(): ";
-  
-  int itemp;
 
-  if(!_vertex_size_max) {
+void Graph::Expansion::_save_store (const std::string& key, const _gmap_t& int_data, const _gmap_t& sum_data, const _gmap_t& zpe_data) const
+{
+  if(IO::mpi_rank)
     //
-    ErrOut err_out;
+    return;
 
-    err_out << funame << "frequency graph converter not initialized";
-  }
-  
-  if(!freq_graph.size())
-    //
-    return vec_t();
-  
-  if(freq_graph.vertex_size() > _vertex_size_max) {
+  const std::string name = Graph::cache_file(key, ".gint");
+
+  IO::AtomicFile to(name);
+
+  if(!to) {
     //
-    ErrOut err_out;
+    IO::log << IO::log_offset << "WARNING: cannot open graph integrals store file " << to.tmp_name() << "\n";
 
-    err_out << funame << "number of vertices exceeds the maximum: " << freq_graph.vertex_size();
+    return;
   }
-  
-  vec_t res(freq_graph.bond_size());
-  
-  int bond_index = 0;
-  //
-  for(FreqGraph::const_iterator git = freq_graph.begin(); git != freq_graph.end(); ++git) {
-    //
-    itemp  = *git->first.rbegin();
-    //
-    itemp  = *git->first.begin() + itemp * (itemp - 1) / 2;
-    //
-    itemp *= _freq_size;
-    
-    for(std::multiset<int>::const_iterator fit = git->second.begin(); fit != git->second.end(); ++fit, ++bond_index) {
-      //
-      if(*fit < -1 || *fit >= _freq_size - 1) {
-	//
-	ErrOut err_out;
 
-	err_out << funame << "frequency index out of range: " << *fit;
-      }
+  int itemp = key.size();
 
-      res[bond_index] = itemp + *fit + 1;
-    }
-  }
-  return res;  
-}
+  to.write((const char*)&itemp, sizeof(itemp));
 
-long Graph::Expansion::_gmap_t::mem_size () const
-{
-  long res = 0;
-  //
-  for(const_iterator dit = begin(); dit != end(); ++dit)
-    //
-    res += (long)_Convert::mem_size(dit->first);
+  to.write(key.data(), key.size());
 
-  res += (long)size() * long(sizeof(_Convert::vec_t) + 32); // 32 stands for three pointers and the double
-  
-  return res;
-}
+  int_data.save(to);
 
+  sum_data.save(to);
+
+  zpe_data.save(to);
+
+  if(!to.commit())
+    //
+    IO::log << IO::log_offset << "WARNING: cannot write graph integrals store file " << name << "\n";
+}
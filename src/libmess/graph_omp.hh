@@ -19,6 +19,15 @@
 #include "graph_common.hh"
 #include "array.hh"
 
+#include <fstream>
+#include <ctime>
+
+#ifdef _OPENMP
+
+#include <omp.h>
+
+#endif
+
   /******************************************************************************************
    ********************** PARTITION FUNCTION GRAPH PERTURBATION THEORY **********************
    ******************************************************************************************/
@@ -58,17 +67,128 @@ namespace Graph {
       
     _Convert _convert;
     
-    // database format
+    // database format: the values are kept in shards selected by the key hash, each shard
+    // with its own lock, so that a lookup or an insertion locks one shard only; with the
+    // memory budget set the least reused entries are evicted, and, with the spill directory
+    // set, moved to the disk as sorted runs of fixed size records; the budget is per
+    // temperature
     //
-    struct _gmap_t : public std::map<_Convert::vec_t, double> {
+    class _gmap_t {
+      //
+      enum { SHARD_SIZE = 64, SPILL_KEY_MAX = 32 };
+
+      struct _entry_t {
+	double   value;
+	unsigned hits;
+      };
+
+      mutable std::map<_Convert::vec_t, _entry_t> _shard [SHARD_SIZE];
+
+      // memory per shard
       //
+      long _mem [SHARD_SIZE];
+
+      long _mem_max;
+
+      long _evict_size;
+
+      long _spill_size;
+
+      std::string _spill_name;
+
+      mutable std::fstream _spill;
+
+      // spilled runs per shard: file position, records number
+      //
+      std::vector<std::pair<long, long> > _spill_run [SHARD_SIZE];
+
+#ifdef _OPENMP
+      mutable omp_lock_t _lock [SHARD_SIZE];
+
+      mutable omp_lock_t _spill_lock;
+#endif
+
+      static int _shard_index (const _Convert::vec_t&);
+
+      static long _entry_mem (const _Convert::vec_t&);
+
+      static int _record_size ();
+
+      void _evict (int);
+
+      void _spill_write (int, const std::vector<std::pair<_Convert::vec_t, double> >&);
+
+      bool _spill_find  (int, const _Convert::vec_t&, double&) const;
+
+      _gmap_t (const _gmap_t&);
+      _gmap_t& operator= (const _gmap_t&);
+
+    public:
+      //
+      _gmap_t ();
+      ~_gmap_t ();
+
+      bool find (const _Convert::vec_t& key, double& value) const;
+
+      // does not overwrite the existing value; returns false if the key is already in the database
+      //
+      bool insert (const _Convert::vec_t& key, double value);
+
+      long size () const;
+
       long mem_size() const;
+
+      // evicted and spilled entries numbers
+      //
+      long evict_size () const { return _evict_size; }
+      long spill_size () const { return _spill_size; }
+
+      // logs the eviction statistics, if any
+      //
+      void report (const char* name) const;
+
+      // binary input/output for the cross-run graph integrals store
+      //
+      void save (std::ostream&) const;
+
+      bool load (std::istream&);
     };
 
+    // cross-run graph integrals store: the integrals depend on the reduced frequencies,
+    // the temperature, and the evaluation parameters, but not on the potential expansion
+    //
+    std::string _store_key (const std::string& name, double temperature) const;
+
+    bool _load_store (const std::string& key, _gmap_t& int_data, _gmap_t& sum_data, _gmap_t& zpe_data) const;
+
+    void _save_store (const std::string& key, const _gmap_t& int_data, const _gmap_t& sum_data, const _gmap_t& zpe_data) const;
+
+    // bond order convergence
+    //
+    static double _order_relative (double order_corr, double total_corr, double temperature);
+
+    static void _print_orders (const std::map<int, std::vector<int> >& order_graph,
+			       const std::map<int, double>&            order_corr,
+			       const std::map<int, double>&            order_rel,
+			       const std::map<int, std::time_t>&       order_time,
+			       double                                  temperature);
+
     // potential expansion
     //
     potex_t _potex;
 
+    // its flat form for the lookups
+    //
+    PotexTable _potex_table;
+
+    // normal modes which enter the potential expansion: only these are enumerated
+    //
+    std::vector<int> _active_mode;
+
+    // drops the potential expansion terms below the screening tolerance
+    //
+    void _screen_potex (const std::vector<double>& freq, const potex_t&);
+
     // reduced frequencies
     //
     std::vector<double> _red_freq;
@@ -86,6 +206,9 @@ namespace Graph {
     std::set<int> _low_freq_set (double temperature, std::vector<double>& tanh_factor) const;
 
   public:
+    //
+    // the graph values are stored under the canonical graph labeling;
+    // KEEP_PERM is kept for the input compatibility only
     //
     enum { KEEP_PERM = 1};
 
@@ -97,6 +220,8 @@ namespace Graph {
 
     std::map<int, double>           correction (double temperature = -1.) const;
     //
+    std::vector<std::map<int, double> > correction (const std::vector<double>& temperature) const;
+    //
     std::map<int, double>  centroid_correction (double temperature = -1.) const;
     //
     std::map<int, double>  centroid_correction (const std::map<std::multiset<int>, double>&, double temperature = -1.)  const;
@@ -112,6 +237,22 @@ namespace Graph {
     // low frequency threshold
     //
     static double low_freq_thresh;
+
+    // potential expansion screening tolerance
+    //
+    static double potex_tol;
+
+    // graph databases memory budget, bytes
+    //
+    static long db_mem_max;
+
+    // graph databases spill directory
+    //
+    static std::string spill_dir;
+
+    // bond order convergence threshold
+    //
+    static double conv_thresh;
   };
 }
 
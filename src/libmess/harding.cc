@@ -33,6 +33,17 @@
 
 Harding harding_global;
 
+namespace {
+  //
+  // evaluation scratch buffers, one set per thread
+  //
+  thread_local std::vector<double> scratch_dist, scratch_power, scratch_term, scratch_adj;
+
+  // number of geometries evaluated together in the batched potential
+  //
+  const int lane_size = 8;
+}
+
 void Harding::init (std::istream& from)
 {
   Exception::Base funame = "Harding::init: ";
@@ -334,6 +345,8 @@ void Harding::init (std::istream& from)
 	throw funame << coef_file << ": number of coefficients more than expected?";
     }
 
+    _set_plan();
+
     // output
     //
     IO::log << IO::log_offset << "maximal polynomial power        = " << poly_order_max    << "\n"
@@ -370,54 +383,120 @@ void Harding::init (std::istream& from)
   }
 }
 
-void Harding::update_poly_val (const double* r, double* poly_val) const
+// flat evaluation plan from the term maps
+//
+void Harding::_set_plan ()
 {
-  const char funame [] = "Harding::update_poly_val: ";
+  _term_parent.assign(term_val_map_size, 0);
+  _term_dist.assign(term_val_map_size, 0);
+  _term_pow.assign(term_val_map_size, 0);
 
-  int    itemp;
-  
-  double dtemp;
+  for(int d = 0; d < _dist_size; ++d) {
+    //
+    const int term_max = term_max_map[d];
 
-  // updating term value map
-  std::vector<double> term_val_map(term_val_map_size);
-  term_val_map[0] = 1.;
+    for(int term = 0; term < term_max; ++term) {
+      //
+      const int base = term_term_map[term] + term_max;
 
+      for(int i = 0; i < term_pow_map[term]; ++i) {
+	//
+	_term_parent[base + i] = term;
+	_term_dist  [base + i] = d;
+	_term_pow   [base + i] = i + 1;
+      }
+    }
+  }
 
-  for(int d = 0; d < _dist_size; ++d) {
-    const int term_max = term_max_map[d];
+  _term_coef.assign(term_val_map_size, 0.);
 
-    std::vector<double> power_term(term_order_max);
-    dtemp = r[d];
-    for(int i = 0; i < term_order_max; ++i, dtemp *= r[d])
-      power_term[i] = dtemp;
+  _bond_dist.clear();
+  _bond_pow.clear();
+  _bond_coef.clear();
 
-    int pow_max, base;
+  if(!coef.size())
+    //
+    return;
 
-#ifdef OPENMP
-    
-#pragma omp parallel for default(shared) private(pow_max, base, dtemp) schedule(static)
-    
-#endif
+  for(int p = 0; p < poly_map.size(); ++p)
+    //
+    for(std::vector<int>::const_iterator t = poly_map[p].begin(); t != poly_map[p].end(); ++t)
+      //
+      _term_coef[*t] = coef[p];
 
-    for(int term = 0; term < term_max; ++term) {
-      // updating terms values for d-th dimension
-      pow_max = term_pow_map[term];
-      base    = term_term_map[term] + term_max;
-      dtemp   = term_val_map[term];
+  int bindex = poly_map.size();
+
+  for(std::map<std::set<int>, int>::const_iterator bit=bond.begin(); bit != bond.end(); ++bit)
+    //
+    for(int i = term_order_max + 1; i <= bit->second; ++i, ++bindex)
+      //
+      for(std::set<int>::const_iterator dit = bit->first.begin(); dit != bit->first.end(); ++dit) {
+	//
+	_bond_dist.push_back(*dit);
+	_bond_pow.push_back(i);
+	_bond_coef.push_back(coef[bindex]);
+      }
+}
+
+// interatomic distances in angstrom
+//
+void Harding::_set_dist (const double* coord, double* dist) const
+{
+  double dtemp;
+
+  int count = 0;
+
+  for(int a1 = 1; a1 < _atom_size; ++a1) {
+    //
+    for(int a0 = 0; a0 < a1; ++a0, ++count) {
+      //
+      double rr = 0.;
+
+      for(int i = 0; i < 3; ++i) {
+	//
+	dtemp = coord[a0 * 3 + i] - coord[a1 * 3 + i];
 
-      for(int i = 0; i < pow_max; ++i)
-	term_val_map[base + i] = dtemp * power_term[i];
+	rr += dtemp * dtemp;
+      }
+
+      dist[count] = std::sqrt(rr) / Phys_const::angstrom;
     }
   }
+}
 
-#ifdef OPENMP
-#pragma omp parallel for default(shared) private(dtemp) schedule(static)
-#endif
+void Harding::update_poly_val (const double* r, double* poly_val) const
+{
+  const char funame [] = "Harding::update_poly_val: ";
+
+  double dtemp;
+
+  const int pow_size = term_order_max + 1;
+
+  // distance powers
+  std::vector<double>& power = scratch_power;
+  power.resize(_dist_size * pow_size);
+
+  for(int d = 0; d < _dist_size; ++d) {
+    //
+    dtemp = 1.;
+    for(int i = 0; i < pow_size; ++i, dtemp *= r[d])
+      power[d * pow_size + i] = dtemp;
+  }
+
+  // monomial terms values
+  std::vector<double>& term_val = scratch_term;
+  term_val.resize(term_val_map_size);
+
+  term_val[0] = 1.;
+
+  for(int t = 1; t < term_val_map_size; ++t)
+    //
+    term_val[t] = term_val[_term_parent[t]] * power[_term_dist[t] * pow_size + _term_pow[t]];
 
   for(int p = 0; p < poly_map.size(); ++p) {
     dtemp = 0.;
     for(std::vector<int>::const_iterator t = poly_map[p].begin(); t != poly_map[p].end(); ++t)
-      dtemp += term_val_map[*t];
+      dtemp += term_val[*t];
     poly_val[p] = dtemp;
   }
 
@@ -436,6 +515,61 @@ double Harding::potential (const double* coord) const
 {
   Exception::Base funame = "Harding::potential: ";
 
+  try {
+    //
+    if(!coef.size())
+      //
+      throw funame << "expansion coefficients have not been initialized";
+
+    std::vector<double>& dist = scratch_dist;
+    dist.resize(_dist_size);
+
+    _set_dist(coord, &dist[0]);
+
+    const int pow_size = term_order_max + 1;
+
+    std::vector<double>& power = scratch_power;
+    power.resize(_dist_size * pow_size);
+
+    for(int d = 0; d < _dist_size; ++d) {
+      //
+      double dtemp = 1.;
+      for(int i = 0; i < pow_size; ++i, dtemp *= dist[d])
+	power[d * pow_size + i] = dtemp;
+    }
+
+    std::vector<double>& term_val = scratch_term;
+    term_val.resize(term_val_map_size);
+
+    term_val[0] = 1.;
+
+    double res = _term_coef[0];
+
+    for(int t = 1; t < term_val_map_size; ++t) {
+      //
+      term_val[t] = term_val[_term_parent[t]] * power[_term_dist[t] * pow_size + _term_pow[t]];
+
+      res += _term_coef[t] * term_val[t];
+    }
+
+    for(int b = 0; b < _bond_coef.size(); ++b)
+      //
+      res += _bond_coef[b] * std::pow(dist[_bond_dist[b]], (double)_bond_pow[b]);
+
+    return res * Phys_const::kcal;
+  }
+  catch(Exception::Base x) {
+    //
+    x.print();
+    
+    std::exit(1);
+  }
+}
+
+double Harding::potential (const double* coord, double* grad) const
+{
+  Exception::Base funame = "Harding::potential: ";
+
   double dtemp;
 
   try {
@@ -444,7 +578,76 @@ double Harding::potential (const double* coord) const
       //
       throw funame << "expansion coefficients have not been initialized";
 
-    Array<double> dist(_dist_size);
+    std::vector<double>& dist = scratch_dist;
+    dist.resize(2 * _dist_size);
+
+    _set_dist(coord, &dist[0]);
+
+    // distance derivatives
+    double* dist_adj = &dist[_dist_size];
+
+    for(int d = 0; d < _dist_size; ++d)
+      //
+      dist_adj[d] = 0.;
+
+    const int pow_size = term_order_max + 1;
+
+    std::vector<double>& power = scratch_power;
+    power.resize(_dist_size * pow_size);
+
+    for(int d = 0; d < _dist_size; ++d) {
+      //
+      dtemp = 1.;
+      for(int i = 0; i < pow_size; ++i, dtemp *= dist[d])
+	power[d * pow_size + i] = dtemp;
+    }
+
+    // forward pass
+    std::vector<double>& term_val = scratch_term;
+    term_val.resize(term_val_map_size);
+
+    term_val[0] = 1.;
+
+    double res = _term_coef[0];
+
+    for(int t = 1; t < term_val_map_size; ++t) {
+      //
+      term_val[t] = term_val[_term_parent[t]] * power[_term_dist[t] * pow_size + _term_pow[t]];
+
+      res += _term_coef[t] * term_val[t];
+    }
+
+    // reverse pass: the term adjoints accumulate the coefficients of the descendant terms
+    std::vector<double>& adj = scratch_adj;
+    adj.assign(_term_coef.begin(), _term_coef.end());
+
+    for(int t = term_val_map_size - 1; t > 0; --t) {
+      //
+      const int parent = _term_parent[t];
+      const int   base = _term_dist[t] * pow_size;
+      const int      n = _term_pow[t];
+
+      adj[parent] += adj[t] * power[base + n];
+
+      dist_adj[_term_dist[t]] += adj[t] * term_val[parent] * (double)n * power[base + n - 1];
+    }
+
+    for(int b = 0; b < _bond_coef.size(); ++b) {
+      //
+      const double r = dist[_bond_dist[b]];
+      const int    n = _bond_pow[b];
+
+      dtemp = _bond_coef[b] * std::pow(r, (double)(n - 1));
+
+      res += dtemp * r;
+
+      dist_adj[_bond_dist[b]] += dtemp * (double)n;
+    }
+
+    // cartesian gradient
+    for(int i = 0; i < 3 * _atom_size; ++i)
+      //
+      grad[i] = 0.;
 
     int count = 0;
 
@@ -452,41 +655,139 @@ double Harding::potential (const double* coord) const
       //
       for(int a0 = 0; a0 < a1; ++a0, ++count) {
 	//
-	double rr = 0.;
-	
+	if(dist[count] <= 0.)
+	  //
+	  continue;
+
+	const double fac = dist_adj[count] * Phys_const::kcal / dist[count] / Phys_const::angstrom / Phys_const::angstrom;
+
 	for(int i = 0; i < 3; ++i) {
 	  //
-	  dtemp = coord[a0 * 3 + i] - coord[a1 * 3 + i];
-	  
-	  rr += dtemp * dtemp;
+	  dtemp = (coord[a0 * 3 + i] - coord[a1 * 3 + i]) * fac;
+
+	  grad[a0 * 3 + i] += dtemp;
+	  grad[a1 * 3 + i] -= dtemp;
 	}
-	
-	dist[count] = std::sqrt(rr) / Phys_const::angstrom;
       }
     }
 
-    Array<double> poly_val(_poly_size);
-    
-    update_poly_val(dist, poly_val);
+    return res * Phys_const::kcal;
+  }
+  catch(Exception::Base x) {
+    //
+    x.print();
 
-    double res = 0.;
+    std::exit(1);
+  }
+}
 
-#ifdef OPENMP
-#pragma omp parallel for default(shared) reduction(+: res) schedule(static)
-#endif
+// the geometries are evaluated in groups of lane_size, the plan loops running across
+// the group (the last group is padded with its last geometry)
+//
+void Harding::potential (const double* coord, int size, double* res) const
+{
+  Exception::Base funame = "Harding::potential: ";
 
-    for(int i = 0; i < _poly_size; ++i)
+  try {
+    //
+    if(!coef.size())
       //
-      res += poly_val[i] * coef[i];
-    
-    return res * Phys_const::kcal;
+      throw funame << "expansion coefficients have not been initialized";
+
+    if(size < 0)
+      //
+      throw funame << "number of geometries out of range: " << size;
   }
   catch(Exception::Base x) {
     //
     x.print();
-    
+
     std::exit(1);
   }
+
+  const int pow_size   = term_order_max + 1;
+  const int coord_size = 3 * _atom_size;
+  const int group_size = (size + lane_size - 1) / lane_size;
+
+#pragma omp parallel for default(shared) schedule(static)
+
+  for(int g = 0; g < group_size; ++g) {
+    //
+    const int start = g * lane_size;
+    const int  stop = start + lane_size < size ? start + lane_size : size;
+
+    // distances, lane index running fastest 
+    std::vector<double>& dist = scratch_dist;
+    dist.resize((_dist_size + 1) * lane_size);
+
+    double* r = &dist[_dist_size * lane_size];
+
+    for(int l = 0; l < lane_size; ++l) {
+      //
+      const int s = start + l < stop ? start + l : stop - 1;
+
+      _set_dist(coord + s * coord_size, r);
+
+      for(int d = 0; d < _dist_size; ++d)
+	//
+	dist[d * lane_size + l] = r[d];
+    }
+
+    std::vector<double>& power = scratch_power;
+    power.resize(_dist_size * pow_size * lane_size);
+
+    for(int d = 0; d < _dist_size; ++d) {
+      //
+      double* pw = &power[d * pow_size * lane_size];
+
+      for(int l = 0; l < lane_size; ++l)
+	pw[l] = 1.;
+
+      for(int i = 1; i < pow_size; ++i)
+	//
+#pragma omp simd
+	for(int l = 0; l < lane_size; ++l)
+	  pw[i * lane_size + l] = pw[(i - 1) * lane_size + l] * dist[d * lane_size + l];
+    }
+
+    std::vector<double>& term_val = scratch_term;
+    term_val.resize(term_val_map_size * lane_size);
+
+    double val [lane_size];
+
+    for(int l = 0; l < lane_size; ++l) {
+      //
+      term_val[l] = 1.;
+
+      val[l] = _term_coef[0];
+    }
+
+    for(int t = 1; t < term_val_map_size; ++t) {
+      //
+      const double* parent = &term_val[_term_parent[t] * lane_size];
+      const double*     pw = &power[(_term_dist[t] * pow_size + _term_pow[t]) * lane_size];
+      double*         curr = &term_val[t * lane_size];
+      const double       c = _term_coef[t];
+
+#pragma omp simd
+      for(int l = 0; l < lane_size; ++l) {
+	//
+	curr[l] = parent[l] * pw[l];
+
+	val[l] += c * curr[l];
+      }
+    }
+
+    for(int b = 0; b < _bond_coef.size(); ++b)
+      //
+      for(int l = 0; l < lane_size; ++l)
+	//
+	val[l] += _bond_coef[b] * std::pow(dist[_bond_dist[b] * lane_size + l], (double)_bond_pow[b]);
+
+    for(int s = start; s < stop; ++s)
+      //
+      res[s] = val[s - start] * Phys_const::kcal;
+  }
 }
 
 extern "C" void harding_poly_size_ (int& s)
@@ -518,3 +819,13 @@ extern "C" void harding_pot_ (const double* coord, double& res)
 {
   res = harding_global.potential(coord);
 }
+
+extern "C" void harding_pot_grad_ (const double* coord, double& res, double* grad)
+{
+  res = harding_global.potential(coord, grad);
+}
+
+extern "C" void harding_pot_batch_ (const double* coord, const int& size, double* res)
+{
+  harding_global.potential(coord, size, res);
+}
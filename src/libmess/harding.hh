@@ -39,6 +39,24 @@ class Harding {
 
   int _poly_size; // number of symmetric polynomials
 
+  // evaluation plan: each monomial term (but the first, unity) is the parent term times
+  // the distance power; the terms are ordered so that the parent comes first
+  //
+  std::vector<int>    _term_parent;
+  std::vector<int>    _term_dist;
+  std::vector<int>    _term_pow;
+  std::vector<double> _term_coef; // expansion coefficient of the polynomial owning the term
+
+  // additional bond expansion terms: distance, power, and coefficient
+  //
+  std::vector<int>    _bond_dist;
+  std::vector<int>    _bond_pow;
+  std::vector<double> _bond_coef;
+
+  void _set_plan ();
+
+  void _set_dist (const double* coord, double* dist) const;
+
 public:
 
   Harding () : term_order_max(0), poly_order_max(0), _atom_size(0) {}
@@ -53,6 +71,14 @@ public:
 
   double potential (const double*) const;
 
+  // potential and its cartesian gradient (reverse pass over the evaluation plan)
+  //
+  double potential (const double* coord, double* grad) const;
+
+  // potential for many geometries, atom_size() * 3 coordinates each
+  //
+  void potential (const double* coord, int size, double* res) const;
+
   int poly_size () const { return _poly_size; }
 
   int dist_size () const { return _dist_size; }
@@ -63,6 +89,8 @@ public:
 extern "C" void harding_init_        (std::istream&);
 extern "C" void harding_update_      (const double*, double*);
 extern "C" void harding_pot_         (const double*, double&); 
+extern "C" void harding_pot_grad_    (const double*, double&, double*);
+extern "C" void harding_pot_batch_   (const double*, const int&, double*);
 extern "C" void harding_poly_size_   (int&);
 extern "C" void harding_dist_size_   (int&);
 extern "C" void harding_atom_size_   (int&);
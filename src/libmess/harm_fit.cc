@@ -21,6 +21,24 @@
 
 #include <fstream>
 
+namespace {
+  // symmetric matrix 1-norm
+  double sym_norm (const Lapack::SymmetricMatrix& m)
+  {
+    double res = 0.;
+    for(int j = 0; j < m.size(); ++j) {
+      double dtemp = 0.;
+      for(int i = 0; i < m.size(); ++i)
+	dtemp += m(i, j) >= 0. ? m(i, j) : -m(i, j);
+
+      if(dtemp > res)
+	res = dtemp;
+    }
+
+    return res;
+  }
+}
+
 int main (int argc, char* argv [])
 {
   const char funame [] = "main: ";
@@ -407,37 +425,80 @@ int main (int argc, char* argv [])
 
   Lapack::Matrix hex_coef(xsize, dist_grid.size());
 
-  // distance cycle
-  IO::log << std::setprecision(3);
-  for(int dist = 0; dist < dist_grid.size(); ++dist) {
+  // least squares fit: the distances with the same vertex set share the normal equations,
+  // assembled by the matrix products, and are solved together; the ill-conditioned
+  // equations are solved by the svd-decomposition of the expansion matrix instead
+  static const double cond_max = 1.e8;
 
-    // right-hand-side (energy) vector
-    Lapack::Vector rhs_vec(xsize);
-    rhs_vec = 0.;
+  for(int dist_begin = 0, dist_end; dist_begin < dist_grid.size(); dist_begin = dist_end) {
+    // vertices with the energy data at the distance
+    std::vector<int> vset;
+    for(int v = 0; v < vertex.size(); ++v)
+      if(ener_data[v].size() > dist_begin)
+	vset.push_back(v);
+
+    for(dist_end = dist_begin + 1; dist_end < dist_grid.size(); ++dist_end) {
+      itemp = 0;
+      for(int v = 0; v < vertex.size(); ++v)
+	if(ener_data[v].size() > dist_end)
+	  ++itemp;
+
+      if(itemp != vset.size())
+	break;
+    }
+
+    Lapack::Matrix lsq_mat(vset.size(), xsize);
+    Lapack::Matrix ener_mat(vset.size(), dist_end - dist_begin);
+
+    for(int i = 0; i < vset.size(); ++i) {
+      for(int x = 0; x < xsize; ++x)
+	lsq_mat(i, x) = vx_mat(vset[i], x);
+
+      for(int dist = dist_begin; dist < dist_end; ++dist)
+	ener_mat(i, dist - dist_begin) = convert(ener_data[vset[i]][dist]);
+    }
 
     // left-hand-side (correlation) matrix
-    Lapack::SymmetricMatrix lhs_mat(xsize);
-    lhs_mat = 0.;
+    Lapack::SymmetricMatrix lhs_mat = lsq_mat.symmetric_transpose_product(lsq_mat);
 
-    // vertex cycle
-    for(int v = 0; v < vertex.size(); ++v)
-      if(ener_data[v].size() > dist) {
-	// energy transformed
-	dtemp = convert(ener_data[v][dist]);
+    // right-hand-side (energy) vectors
+    Lapack::Matrix rhs_mat = lsq_mat.transpose_product(ener_mat);
 
-	// harmonic expansion cycle	
-#pragma omp parallel for default(shared) schedule(dynamic)      
+    Lapack::Matrix coef;
 
-	for(int x = 0; x < xsize; ++x) {
-	  rhs_vec[x] +=  dtemp * vx_mat(v, x);
+    try {
+      Lapack::Cholesky chol(lhs_mat);
 
-	  for(int y = x; y < xsize; ++y)
-	    lhs_mat(x, y) += vx_mat(v, x) * vx_mat(v, y);
-	}// harmonic expansion cycle
-      }// vertex cycle
+      // 1-norm condition number
+      dtemp = sym_norm(lhs_mat) * sym_norm(chol.invert());
+
+      if(dtemp < cond_max)
+	coef = chol.invert(rhs_mat);
+      else
+	IO::log << "distances " << dist_begin << "-" << dist_end - 1 
+		<< ": normal equations condition number = " << dtemp << ", using svd-decomposition\n";
+    }
+    catch(Error::Math) {
+      IO::log << "distances " << dist_begin << "-" << dist_end - 1 
+	      << ": normal equations are not positive definite, using svd-decomposition\n";
+    }
+
+    if(!coef.isinit())
+      coef = Lapack::svd_solve(lsq_mat, ener_mat);
+
+    for(int dist = dist_begin; dist < dist_end; ++dist)
+      for(int x = 0; x < xsize; ++x)
+	hex_coef(x, dist) = coef(x, dist - dist_begin);
+  }
+
+  // distance cycle
+  IO::log << std::setprecision(3);
+  for(int dist = 0; dist < dist_grid.size(); ++dist) {
+
+    Lapack::Vector vtemp(xsize);
+    for(int x = 0; x < xsize; ++x)
+      vtemp[x] = hex_coef(x, dist);
 
-    Lapack::Vector vtemp = Lapack::Cholesky(lhs_mat).invert(rhs_vec);
-    hex_coef.column(dist) = vtemp;
     Lapack::Vector fit_ener  = vx_mat * vtemp;
 
     double rms_dev = 0.;
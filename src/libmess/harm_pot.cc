@@ -152,6 +152,43 @@ double harm_fit (double dist, const Configuration::State& stat)
   return convert_energy(res, 1);
 }
 
+std::vector<double> harm_fit (const std::vector<double>& dist, const std::vector<Configuration::State>& stat)
+{
+  const char funame [] = "harm_fit: ";
+
+  int    itemp;
+
+  if(dist.size() != stat.size()) {
+    std::cerr << funame << "distances and states numbers mismatch\n";
+    std::exit(1);
+  }
+
+  for(int s = 0; s < dist.size(); ++s)
+    if(dist[s] < expansion_coefficient[0].arg_min() || dist[s] > expansion_coefficient[0].arg_max()) {
+      std::cerr << funame << "distance out of range\n";
+      std::exit(1);
+    }
+
+  std::vector<double> res(stat.size(), 0.);
+  if(!stat.size())
+    return res;
+
+  itemp = 0;
+  for(int  pack = 0; pack < 2; ++pack) {
+    //
+    const Lapack::Matrix term = (*harmonic_expansion[pack])(stat);
+
+    for(int x = 0; x < harmonic_expansion[pack]->size(); ++x, ++itemp)
+      for(int s = 0; s < stat.size(); ++s)
+	res[s] += term(s, x) * expansion_coefficient[itemp](dist[s]);
+  }
+
+  for(int s = 0; s < stat.size(); ++s)
+    res[s] = convert_energy(res[s], 1);
+
+  return res;
+}
+
 extern "C" void no2_ch3_pot_ (const double& nc_dist, const double& ang, double& res)
 {
   const char funame [] = "no2_ch3_pot_: ";
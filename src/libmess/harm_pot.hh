@@ -27,6 +27,9 @@ struct EnergyConverter {
 
 double harm_fit (double, const Configuration::State&);
 
+// batch of configurations: the expansion terms of all the states are evaluated at once
+std::vector<double> harm_fit (const std::vector<double>&, const std::vector<Configuration::State>&);
+
 extern "C" void   harm_init_ (const char*);
 extern "C" void no2_ch3_pot_ (const double&, const double&, double&);
 
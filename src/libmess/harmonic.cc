@@ -57,6 +57,8 @@ HarmonicExpansion::HarmonicExpansion (std::istream& from, int rdim, int qdim)
     std::cerr << funame << "corrupted\n";
     throw Error::Input();
   }
+
+  _set_coef();
 }
 
 HarmonicExpansion::HarmonicExpansion (const Configuration::DoubleSpaceGroup& symm_group, int rdim, int qdim) 
@@ -152,6 +154,8 @@ HarmonicExpansion::HarmonicExpansion (const Configuration::DoubleSpaceGroup& sym
   for(int x = 0; x < _expansion.size(); ++x)
     itemp += _expansion[x].size();
 
+  _set_coef();
+
   IO::log << IO::log_offset << "symmetric monomials number = "   << _expansion.size()
 	  << ";  total number of non-zero terms = " << itemp 
 	  << std::endl;
@@ -211,3 +215,87 @@ double HarmonicExpansion::operator() (int term, const Configuration::State& stat
   return res;
 }
 
+
+void HarmonicExpansion::_set_coef ()
+{
+  std::map<int, int> monom_map;
+  for(int x = 0; x < _expansion.size(); ++x)
+    for(std::map<int, double>::const_iterator it = _expansion[x].begin(); it != _expansion[x].end(); ++it)
+      monom_map.insert(std::make_pair(it->first, 0));
+
+  _monom_index.clear();
+  for(std::map<int, int>::iterator mit = monom_map.begin(); mit != monom_map.end(); ++mit) {
+    mit->second = _monom_index.size();
+    _monom_index.push_back(mit->first);
+  }
+
+  if(!_monom_index.size() || !size())
+    return;
+
+  _coef.resize(_monom_index.size(), size());
+  _coef = 0.;
+  for(int x = 0; x < _expansion.size(); ++x)
+    for(std::map<int, double>::const_iterator it = _expansion[x].begin(); it != _expansion[x].end(); ++it)
+      _coef(monom_map[it->first], x) = it->second;
+}
+
+Lapack::Matrix HarmonicExpansion::operator() (const std::vector<Configuration::State>& state) const 
+{
+  const char funame [] = "HarmonicExpansion::operator(): ";
+
+  if(!state.size() || !_coef.isinit()) {
+    std::cerr << funame << "empty batch or expansion\n";
+    throw Error::Range();
+  }
+
+  //check layout
+  for(int s = 0; s < state.size(); ++s)
+    if(state[s].size() != 7) {
+      std::cerr << funame << "wrong layout\n";
+      throw Error::Logic();
+    }
+
+  // monomials values
+  Lapack::Matrix mval(state.size(), _monom_index.size());
+
+#pragma omp parallel for default(shared) schedule(static)
+
+  for(int s = 0; s < state.size(); ++s) {
+    //
+    // powers of the coordinates, starting from zero
+    const int rstep = _rmonom.rank() + 1;
+    const int qstep = _qmonom.rank() + 1;
+
+    std::vector<double> rfactor(3 * rstep);
+    std::vector<double> qfactor(4 * qstep);
+
+    for(int i = 0; i < 3; ++i) {
+      rfactor[i * rstep] = 1.;
+      for(int j = 0; j < _rmonom.rank(); ++j)
+	rfactor[i * rstep + j + 1] = rfactor[i * rstep + j] * state[s].radius_vector()[i];
+    }
+
+    for(int i = 0; i < 4; ++i) {
+      qfactor[i * qstep] = 1.;
+      for(int j = 0; j < _qmonom.rank(); ++j)
+	qfactor[i * qstep + j + 1] = qfactor[i * qstep + j] * state[s].orientation()[i];
+    }
+
+    for(int m = 0; m < _monom_index.size(); ++m) {
+      //
+      double dtemp = 1.;
+
+      const std::vector<int>& rmulti = _rmonom(_monom_index[m] / _qmonom.linear_size());
+      for(int i = 0; i < 3; ++i)
+	dtemp *= rfactor[i * rstep + rmulti[i]];
+
+      const std::vector<int>& qmulti = _qmonom(_monom_index[m] % _qmonom.linear_size());
+      for(int i = 0; i < 4; ++i)
+	dtemp *= qfactor[i * qstep + qmulti[i]];
+
+      mval(s, m) = dtemp;
+    }
+  }
+
+  return mval * _coef;
+}
@@ -28,6 +28,12 @@ class HarmonicExpansion {
   Monom  _qmonom;
   std::vector<std::map<int, double> > _expansion;
 
+  // monomials present in the expansion and the dense (monomial, term) coefficients matrix
+  std::vector<int> _monom_index;
+  Lapack::Matrix   _coef;
+
+  void _set_coef ();
+
 public:
   HarmonicExpansion (const Configuration::DoubleSpaceGroup&, int, int) ;
   HarmonicExpansion (std::istream&,                          int, int) ;
@@ -35,6 +41,9 @@ public:
   int size () const { return _expansion.size(); }
 
   double operator () (int, const Configuration::State&) const ;
+
+  // all terms for the batch of states: the (state, term) matrix
+  Lapack::Matrix operator () (const std::vector<Configuration::State>&) const ;
     
   friend std::ostream& operator<< (std::ostream&, const HarmonicExpansion&); 
 };
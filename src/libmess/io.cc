@@ -14,12 +14,29 @@
 */
 
 #include "io.hh"
+#include "array.hh"
 
 #include <sstream>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <cctype>
+#include <algorithm>
 #include <map>
+#include <atomic>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace IO {
   //
@@ -45,6 +62,223 @@ namespace IO {
   std::string second_offset = "         ";
 }
 
+/************************************************************************
+ ************************** BUFFERED LOG OUTPUT *************************
+ ************************************************************************/
+
+namespace {
+  //
+  // line buffers of the calling thread, one per log buffer
+  //
+  thread_local std::vector<std::pair<const IO::LogBuffer*, std::string*> > thread_line;
+}
+
+// the writer threads do not survive the fork: they are stopped before it and restarted
+// in both processes after it
+//
+struct IO::LogFork {
+  //
+  static std::vector<LogBuffer*>& list    () { static std::vector<LogBuffer*> res; return res; }
+  static std::vector<LogBuffer*>& running () { static std::vector<LogBuffer*> res; return res; }
+
+  static void prepare ()
+  {
+    running().clear();
+    for(int i = 0; i < list().size(); ++i)
+      if(list()[i]->is_running()) {
+	running().push_back(list()[i]);
+	list()[i]->stop();
+      }
+  }
+
+  static void restart ()
+  {
+    for(int i = 0; i < running().size(); ++i)
+      running()[i]->start(running()[i]->_to);
+    running().clear();
+  }
+};
+
+IO::LogBuffer::LogBuffer () : _to(0), _stop(false)
+{
+  static bool isfork = false;
+
+  if(!isfork) {
+    pthread_atfork(LogFork::prepare, LogFork::restart, LogFork::restart);
+    isfork = true;
+  }
+
+  LogFork::list().push_back(this);
+}
+
+IO::LogBuffer::~LogBuffer ()
+{
+  stop();
+
+  std::vector<LogBuffer*>& l = LogFork::list();
+  l.erase(std::remove(l.begin(), l.end(), this), l.end());
+
+  for(int i = 0; i < _local.size(); ++i)
+    delete _local[i];
+}
+
+std::string& IO::LogBuffer::_line ()
+{
+  for(int i = 0; i < thread_line.size(); ++i)
+    if(thread_line[i].first == this)
+      return *thread_line[i].second;
+
+  std::string* res = new std::string;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _local.push_back(res);
+  }
+  thread_line.push_back(std::make_pair(this, res));
+
+  return *res;
+}
+
+// complete lines (all the text if partial) are passed to the writer
+//
+void IO::LogBuffer::_commit (std::string& line, bool partial)
+{
+  std::string::size_type n = line.rfind('\n');
+
+  if(partial)
+    n = line.size();
+  else if(n == std::string::npos)
+    return;
+  else
+    ++n;
+
+  if(!n)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _queue.append(line, 0, n);
+  }
+  _ready.notify_one();
+
+  line.erase(0, n);
+}
+
+IO::LogBuffer::int_type IO::LogBuffer::overflow (int_type c)
+{
+  if(traits_type::eq_int_type(c, traits_type::eof()))
+    return traits_type::not_eof(c);
+
+  std::string& line = _line();
+  line.push_back(traits_type::to_char_type(c));
+
+  if(c == '\n')
+    _commit(line, false);
+
+  return c;
+}
+
+std::streamsize IO::LogBuffer::xsputn (const char* s, std::streamsize n)
+{
+  std::string& line = _line();
+  line.append(s, n);
+
+  if(std::memchr(s, '\n', n))
+    _commit(line, false);
+
+  return n;
+}
+
+int IO::LogBuffer::sync ()
+{
+  _commit(_line(), true);
+
+  return 0;
+}
+
+void IO::LogBuffer::_write ()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+
+  while(true) {
+    //
+    while(!_queue.size() && !_stop)
+      _ready.wait(lock);
+
+    if(!_queue.size())
+      break;
+
+    std::string text;
+    text.swap(_queue);
+
+    lock.unlock();
+    _to->sputn(text.data(), text.size());
+    _to->pubsync();
+    lock.lock();
+  }
+}
+
+void IO::LogBuffer::start (std::streambuf* to)
+{
+  const char funame [] = "IO::LogBuffer::start: ";
+
+  if(is_running()) {
+    std::cerr << funame << "already running\n";
+    throw Error::Logic();
+  }
+
+  _to   = to;
+  _stop = false;
+
+  _writer = std::thread(&LogBuffer::_write, this);
+}
+
+void IO::LogBuffer::stop ()
+{
+  if(!is_running())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    for(int i = 0; i < _local.size(); ++i) {
+      _queue += *_local[i];
+      _local[i]->clear();
+    }
+
+    _stop = true;
+  }
+  _ready.notify_one();
+
+  _writer.join();
+}
+
+void IO::LogOut::open (const char* name, std::ios_base::openmode mode)
+{
+  close();
+
+  std::ofstream::open(name, mode);
+
+  if(!is_open())
+    return;
+
+  _buffer.start(std::ofstream::rdbuf());
+
+  std::ios::rdbuf(&_buffer);
+}
+
+void IO::LogOut::close ()
+{
+  if(_buffer.is_running()) {
+    //
+    _buffer.stop();
+
+    std::ios::rdbuf(std::ofstream::rdbuf());
+  }
+
+  if(is_open())
+    std::ofstream::close();
+}
+
 std::string IO::white_space (int n) {
   std::ostringstream res;
   res << std::setw(n) << "";
@@ -147,6 +381,497 @@ char IO::skip_space(std::istream& from)
   return next;
 }
 
+/***********************************************************************************
+ ********************************* MAPPED FILE INPUT *******************************
+ ***********************************************************************************/
+
+bool IO::MappedBuffer::open (const char* name)
+{
+  if(_open)
+    return false;
+
+  const int fd = ::open(name, O_RDONLY);
+
+  if(fd < 0)
+    return false;
+
+  struct stat st;
+  if(fstat(fd, &st) || !S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return false;
+  }
+
+  _size = st.st_size;
+
+  if(_size) {
+    //
+    // private writable mapping: a different character may be put back
+    void* p = mmap(0, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+    if(p != MAP_FAILED) {
+      //
+      _data   = (char*)p;
+      _mapped = true;
+
+      madvise(p, _size, MADV_SEQUENTIAL);
+    }
+    // heap copy fallback
+    else {
+      //
+      _data = new char [_size];
+
+      std::size_t n = 0;
+      while(n < _size) {
+	const ssize_t r = ::read(fd, _data + n, _size - n);
+	if(r <= 0)
+	  break;
+	n += r;
+      }
+      _size = n;
+    }
+  }
+
+  ::close(fd);
+
+  setg(_data, _data, _data + _size);
+
+  _open = true;
+
+  return true;
+}
+
+void IO::MappedBuffer::close ()
+{
+  if(_mapped)
+    munmap(_data, _size);
+  else
+    delete [] _data;
+
+  _data   = 0;
+  _size   = 0;
+  _mapped = false;
+  _open   = false;
+
+  setg(0, 0, 0);
+}
+
+bool IO::MappedFile::open (const char* name)
+{
+  if(_data)
+    return false;
+
+  const int fd = ::open(name, O_RDONLY);
+
+  if(fd < 0)
+    return false;
+
+  struct stat st;
+  if(fstat(fd, &st) || !S_ISREG(st.st_mode) || !st.st_size) {
+    ::close(fd);
+    return false;
+  }
+
+  void* p = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+  ::close(fd);
+
+  if(p == MAP_FAILED)
+    return false;
+
+  _data = (const char*)p;
+  _size = st.st_size;
+
+  return true;
+}
+
+void IO::MappedFile::close ()
+{
+  if(_data)
+    munmap((void*)_data, _size);
+
+  _data = 0;
+  _size = 0;
+}
+
+double* Workspace::scratch_map (const std::string& dir, int n)
+{
+  const char funame [] = "Workspace::scratch_map: ";
+
+  std::string name = dir + "/mess_scratch_XXXXXX";
+
+  const int fd = mkstemp(&name[0]);
+
+  if(fd < 0) {
+    std::cerr << funame << "cannot create the scratch file in " << dir << ": " << strerror(errno) << "\n";
+    return 0;
+  }
+
+  // the space is released with the last mapping
+  unlink(name.c_str());
+
+  const std::size_t size = (std::size_t)n * sizeof(double);
+
+  void* p = MAP_FAILED;
+
+  if(!ftruncate(fd, size))
+    p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+  ::close(fd);
+
+  if(p == MAP_FAILED) {
+    std::cerr << funame << "cannot map " << size << " bytes of the scratch file in " << dir << ": " << strerror(errno) << "\n";
+    return 0;
+  }
+
+  return (double*)p;
+}
+
+void Workspace::scratch_unmap (double* p, int n)
+{
+  munmap(p, (std::size_t)n * sizeof(double));
+}
+
+IO::MappedBuffer::int_type IO::MappedBuffer::underflow ()
+{
+  if(gptr() < egptr())
+    return traits_type::to_int_type(*gptr());
+
+  return traits_type::eof();
+}
+
+IO::MappedBuffer::int_type IO::MappedBuffer::pbackfail (int_type c)
+{
+  if(gptr() == eback())
+    return traits_type::eof();
+
+  gbump(-1);
+
+  if(!traits_type::eq_int_type(c, traits_type::eof()))
+    *gptr() = traits_type::to_char_type(c);
+
+  return traits_type::not_eof(c);
+}
+
+std::streamsize IO::MappedBuffer::showmanyc ()
+{
+  if(gptr() < egptr())
+    return egptr() - gptr();
+
+  return -1;
+}
+
+IO::MappedBuffer::pos_type IO::MappedBuffer::seekoff (off_type off, std::ios_base::seekdir dir, std::ios_base::openmode mode)
+{
+  if(!(mode & std::ios_base::in))
+    return pos_type(off_type(-1));
+
+  off_type pos;
+  switch(dir) {
+  case std::ios_base::beg:
+    pos = off;
+    break;
+  case std::ios_base::cur:
+    pos = gptr() - eback() + off;
+    break;
+  default:
+    pos = _size + off;
+  }
+
+  if(pos < 0 || pos > (off_type)_size)
+    return pos_type(off_type(-1));
+
+  setg(eback(), eback() + pos, egptr());
+
+  return pos_type(pos);
+}
+
+IO::MappedBuffer::pos_type IO::MappedBuffer::seekpos (pos_type pos, std::ios_base::openmode mode)
+{
+  return seekoff(off_type(pos), std::ios_base::beg, mode);
+}
+
+namespace {
+  //
+  // collects the number characters; the floating point syntax is
+  // [sign] digits [. digits] [(e|E) [sign] digits]
+  //
+  template <typename I, typename S>
+  bool scan_number (I& it, I end, bool is_float, S& res)
+  {
+    if(it != end && (*it == '+' || *it == '-'))
+      res.push_back(*it++);
+
+    int digits = 0;
+    for(; it != end && std::isdigit((unsigned char)*it); ++it, ++digits)
+      res.push_back(*it);
+
+    if(!is_float)
+      return digits;
+
+    if(it != end && *it == '.') {
+      res.push_back(*it++);
+      for(; it != end && std::isdigit((unsigned char)*it); ++it, ++digits)
+	res.push_back(*it);
+    }
+
+    if(!digits)
+      return false;
+
+    if(it != end && (*it == 'e' || *it == 'E')) {
+      res.push_back(*it++);
+      if(it != end && (*it == '+' || *it == '-'))
+	res.push_back(*it++);
+
+      // the exponent digits are mandatory
+      digits = 0;
+      for(; it != end && std::isdigit((unsigned char)*it); ++it, ++digits)
+	res.push_back(*it);
+
+      return digits;
+    }
+
+    return true;
+  }
+}
+
+namespace {
+  //
+  // exact conversion when the mantissa and the power of ten are both exactly
+  // representable (Clinger's fast path), the rest is left to strtod
+  //
+  double to_double (const char* p)
+  {
+    static const double pow10 [] = {1.e0,  1.e1,  1.e2,  1.e3,  1.e4,  1.e5,  1.e6,  1.e7,
+				    1.e8,  1.e9,  1.e10, 1.e11, 1.e12, 1.e13, 1.e14, 1.e15,
+				    1.e16, 1.e17, 1.e18, 1.e19, 1.e20, 1.e21, 1.e22};
+
+    const char* const start = p;
+
+    bool neg = false;
+    if(*p == '+' || *p == '-')
+      neg = *p++ == '-';
+
+    unsigned long long m = 0;
+    int digits = 0, exp10 = 0;
+    
+    for(; std::isdigit((unsigned char)*p); ++p)
+      if(m || *p != '0') {
+	m = 10 * m + (*p - '0');
+	++digits;
+      }
+
+    if(*p == '.')
+      for(++p; std::isdigit((unsigned char)*p); ++p) {
+	if(m || *p != '0') {
+	  m = 10 * m + (*p - '0');
+	  ++digits;
+	}
+	--exp10;
+	
+	if(digits > 15)
+	  break;
+      }
+
+    if(digits > 15)
+      return std::strtod(start, 0);
+
+    if(*p == 'e' || *p == 'E')
+      exp10 += (int)std::max(-1000L, std::min(1000L, std::strtol(p + 1, 0, 10)));
+
+    double res = (double)m;
+
+    if(m && exp10 > 0) {
+      if(exp10 > 22)
+	return std::strtod(start, 0);
+      res *= pow10[exp10];
+    }
+    else if(m && exp10 < 0) {
+      if(exp10 < -22)
+	return std::strtod(start, 0);
+      res /= pow10[-exp10];
+    }
+
+    return neg ? -res : res;
+  }
+}
+
+// the mapped buffer is scanned in place, other buffers through the iterator; 
+// the number text is returned in the null terminated buffer
+//
+bool IO::FastNumGet::_scan (iter_type& it, iter_type end, const std::ios_base& io, bool is_float, Text& res)
+{
+  res.clear();
+
+  const std::istream* is = dynamic_cast<const std::istream*>(&io);
+
+  MappedBuffer* buf = is ? dynamic_cast<MappedBuffer*>(is->rdbuf()) : 0;
+
+  if(!buf) {
+    //
+    const bool ok = scan_number(it, end, is_float, res);
+
+    res.push_back(0);
+
+    return ok;
+  }
+
+  const char* p = buf->gptr();
+
+  const bool ok = scan_number(p, (const char*)buf->egptr(), is_float, res);
+
+  res.push_back(0);
+
+  buf->gbump(p - buf->gptr());
+
+  it = iter_type(buf);
+
+  return ok;
+}
+
+IO::FastNumGet::iter_type IO::FastNumGet::do_get (iter_type it, iter_type end, std::ios_base& io, 
+						  std::ios_base::iostate& err, long& v) const
+{
+  // non-decimal input is left to the standard facet
+  if((io.flags() & std::ios_base::basefield) != std::ios_base::dec)
+    return std::num_get<char>::do_get(it, end, io, err, v);
+
+  Text buf;
+
+  err = std::ios_base::goodbit;
+
+  if(!_scan(it, end, io, false, buf) || buf.overflow()) {
+    v = 0;
+    err |= std::ios_base::failbit;
+  }
+  else {
+    errno = 0;
+    v = std::strtol(buf, 0, 10);
+    if(errno == ERANGE)
+      err |= std::ios_base::failbit;
+  }
+
+  if(it == end)
+    err |= std::ios_base::eofbit;
+
+  return it;
+}
+
+IO::FastNumGet::iter_type IO::FastNumGet::do_get (iter_type it, iter_type end, std::ios_base& io, 
+						  std::ios_base::iostate& err, double& v) const
+{
+  Text buf;
+
+  err = std::ios_base::goodbit;
+
+  if(!_scan(it, end, io, true, buf) || buf.overflow()) {
+    v = 0.;
+    err |= std::ios_base::failbit;
+  }
+  else {
+    errno = 0;
+    v = to_double(buf);
+    if(errno == ERANGE && (v == HUGE_VAL || v == -HUGE_VAL))
+      err |= std::ios_base::failbit;
+  }
+
+  if(it == end)
+    err |= std::ios_base::eofbit;
+
+  return it;
+}
+
+IO::FileStream::FileStream () : std::istream(&_buf)
+{
+  imbue(std::locale(std::locale::classic(), new FastNumGet));
+}
+
+IO::FileStream::FileStream (const char* name) : std::istream(&_buf)
+{
+  imbue(std::locale(std::locale::classic(), new FastNumGet));
+  open(name);
+}
+
+void IO::FileStream::open (const char* name)
+{
+  if(_buf.open(name))
+    clear();
+  else
+    setstate(std::ios_base::failbit);
+}
+
+void IO::FileStream::close ()
+{
+  if(!_buf.is_open()) {
+    setstate(std::ios_base::failbit);
+    return;
+  }
+  
+  _buf.close();
+}
+
+/***********************************************************************************
+ ******************************** ATOMIC FILE OUTPUT *******************************
+ ***********************************************************************************/
+
+std::string IO::hash_name (const std::string& key)
+{
+  unsigned long long h = 14695981039346656037ULL;
+
+  for(int i = 0; i < key.size(); ++i) {
+    //
+    h ^= (unsigned char)key[i];
+    h *= 1099511628211ULL;
+  }
+
+  std::ostringstream res;
+
+  res << std::hex << std::setfill('0') << std::setw(16) << h;
+
+  return res.str();
+}
+
+// the temporary name is unique over the processes and over the threads of the process
+//
+IO::AtomicFile::AtomicFile (const std::string& name, std::ios_base::openmode mode) : _name(name), _done(false)
+{
+  static std::atomic<unsigned> serial(0);
+
+  std::ostringstream tmp_name;
+
+  tmp_name << name << "." << getpid() << "." << serial++;
+
+  _tmp_name = tmp_name.str();
+
+  open(_tmp_name.c_str(), mode | std::ios_base::out);
+}
+
+IO::AtomicFile::~AtomicFile ()
+{
+  if(_done)
+    //
+    return;
+
+  close();
+
+  std::remove(_tmp_name.c_str());
+}
+
+bool IO::AtomicFile::commit ()
+{
+  _done = true;
+
+  close();
+
+  if(!*this || std::rename(_tmp_name.c_str(), _name.c_str())) {
+    //
+    std::remove(_tmp_name.c_str());
+
+    return false;
+  }
+
+  return true;
+}
+
 /***********************************************************************************
  ****************************** KEY BUFFER STREAM **********************************
  ***********************************************************************************/
@@ -184,7 +909,7 @@ IO::KeyBufferStream& IO::operator>> (KeyBufferStream& from, std::string& s)
   }
   else
     //
-    (std::ifstream&)from >> s;
+    (std::istream&)from >> s;
   
   return from;
 }
@@ -220,9 +945,283 @@ void IO::LineInput::read_line(std::istream& from)
  ************************************ INPUT MARKER **********************************
  ************************************************************************************/
 
+bool                   IO::stage_record = false;
+std::vector<IO::Stage> IO::stage_list;
+
+int IO::Marker::_level_size = 0;
+
+bool IO::profile_record = false;
+
+namespace {
+  //
+  struct ProfileEntry {
+    int    level;
+    long   count;
+    double wall_time;
+    double cpu_time;
+    double thread_cpu_time;
+    double wall_max;
+    long   rss_max; // kB
+
+    ProfileEntry () : level(0), count(0), wall_time(0.), cpu_time(0.), thread_cpu_time(0.), wall_max(0.), rss_max(0) {}
+  };
+
+  struct TraceEvent {
+    std::string name;
+    int         track;
+    double      start;   // microseconds from the profile start
+    double      duration;// microseconds
+  };
+
+  const char profile_separator [] = " / ";
+
+  std::map<std::string, ProfileEntry> profile_entry;// by the marker path
+  std::vector<std::string>            profile_order;// in the order of the first entry
+  std::vector<std::string>            marker_path;
+
+  // the timeline is truncated beyond this number of events
+  const int               trace_event_max = 1000000;
+  std::vector<TraceEvent> trace_event;
+  long                    trace_event_lost = 0;
+
+  std::chrono::steady_clock::time_point profile_start;
+
+  std::string profile_base;
+
+  bool in_parallel ()
+  {
+#ifdef _OPENMP
+    return omp_in_parallel();
+#else
+    return false;
+#endif
+  }
+
+  double thread_cpu_time ()
+  {
+    timespec ts;
+    if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+      return 0.;
+
+    return (double)ts.tv_sec + 1.e-9 * (double)ts.tv_nsec;
+  }
+
+  long peak_rss ()
+  {
+    rusage ru;
+    if(getrusage(RUSAGE_SELF, &ru))
+      return 0;
+
+    return ru.ru_maxrss;
+  }
+
+  std::string marker_key ()
+  {
+    std::string res;
+    for(int i = 0; i < marker_path.size(); ++i) {
+      if(i)
+	res += profile_separator;
+      res += marker_path[i];
+    }
+    return res;
+  }
+
+  // without the trailing separator of the function name headers
+  std::string stage_name (std::string s)
+  {
+    while(s.size() && (s[s.size() - 1] == ' ' || s[s.size() - 1] == ':'))
+      s.erase(s.size() - 1);
+    return s;
+  }
+
+  std::string json_text (const std::string& s)
+  {
+    std::string res = "\"";
+    for(int i = 0; i < s.size(); ++i) {
+      if(s[i] == '"' || s[i] == '\\')
+	res += '\\';
+      res += s[i];
+    }
+    res += '"';
+    return res;
+  }
+
+  void profile_write ()
+  {
+    std::ofstream to((profile_base + ".prof").c_str());
+
+    to << "Profile of the marked stages (times in sec, peak RSS in MB):\n"
+       << std::setw(9)  << "calls"
+       << std::setw(12) << "wall"
+       << std::setw(12) << "wall/call"
+       << std::setw(12) << "wall max"
+       << std::setw(12) << "cpu"
+       << std::setw(12) << "thread cpu"
+       << std::setw(10) << "RSS"
+       << "   stage\n";
+
+    for(int i = 0; i < profile_order.size(); ++i) {
+      //
+      const ProfileEntry& e = profile_entry[profile_order[i]];
+
+      std::string name = profile_order[i];
+      std::string::size_type pos = name.rfind(profile_separator);
+      if(pos != std::string::npos)
+	name = name.substr(pos + sizeof(profile_separator) - 1);
+
+      to << std::setw(9)  << e.count
+	 << std::setw(12) << e.wall_time
+	 << std::setw(12) << e.wall_time / (double)(e.count ? e.count : 1)
+	 << std::setw(12) << e.wall_max
+	 << std::setw(12) << e.cpu_time
+	 << std::setw(12) << e.thread_cpu_time
+	 << std::setw(10) << (double)e.rss_max / 1024.
+	 << "   " << std::string(2 * e.level, ' ') << stage_name(name) << "\n";
+    }
+
+    if(trace_event_lost)
+      to << "\n" << trace_event_lost << " timeline events beyond " << trace_event_max << " were not recorded\n";
+
+    std::ofstream trace((profile_base + ".trace.json").c_str());
+
+    trace << "{\"traceEvents\": [\n";
+    for(int i = 0; i < trace_event.size(); ++i)
+      trace << (i ? ",\n" : "")
+	    << "{\"name\": " << json_text(stage_name(trace_event[i].name))
+	    << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << trace_event[i].track
+	    << std::fixed << std::setprecision(1)
+	    << ", \"ts\": " << trace_event[i].start
+	    << ", \"dur\": " << trace_event[i].duration << "}"
+	    << std::defaultfloat;
+    trace << "\n], \"displayTimeUnit\": \"ms\"}\n";
+  }
+}
+
+void IO::profile_open (const std::string& base)
+{
+  const char funame [] = "IO::profile_open: ";
+
+  if(profile_record) {
+    std::cerr << funame << "allready opened\n";
+    throw Error::Init();
+  }
+
+  profile_record = true;
+  profile_base   = base;
+  profile_start  = std::chrono::steady_clock::now();
+
+  // the output streams of the library are destroyed after the exit handlers
+  if(std::atexit(profile_write)) {
+    std::cerr << funame << "cannot register the exit handler\n";
+    throw Error::Init();
+  }
+}
+
+// the open markers stay on the path
+//
+void IO::profile_reset ()
+{
+  for(std::map<std::string, ProfileEntry>::iterator it = profile_entry.begin(); it != profile_entry.end(); ++it) {
+    const int level = it->second.level;
+    it->second = ProfileEntry();
+    it->second.level = level;
+  }
+
+  trace_event.clear();
+  trace_event_lost = 0;
+}
+
+void IO::profile_save (std::ostream& to)
+{
+  to << std::setprecision(17);
+
+  to << profile_order.size() << "\n";
+  for(int i = 0; i < profile_order.size(); ++i) {
+    const ProfileEntry& e = profile_entry[profile_order[i]];
+    to << profile_order[i] << "\n"
+       << e.level << " " << e.count << " " << e.wall_time << " " << e.cpu_time << " "
+       << e.thread_cpu_time << " " << e.wall_max << " " << e.rss_max << "\n";
+  }
+
+  to << trace_event.size() << "\n";
+  for(int i = 0; i < trace_event.size(); ++i)
+    to << trace_event[i].name << "\n" << trace_event[i].start << " " << trace_event[i].duration << "\n";
+}
+
+void IO::profile_merge (std::istream& from, int track)
+{
+  const char funame [] = "IO::profile_merge: ";
+
+  int size;
+  std::string key, line;
+
+  from >> size;
+  std::getline(from, line);
+  for(int i = 0; i < size && from; ++i) {
+    std::getline(from, key);
+
+    ProfileEntry e;
+    from >> e.level >> e.count >> e.wall_time >> e.cpu_time >> e.thread_cpu_time >> e.wall_max >> e.rss_max;
+    std::getline(from, line);
+
+    std::map<std::string, ProfileEntry>::iterator it = profile_entry.find(key);
+    if(it == profile_entry.end()) {
+      profile_order.push_back(key);
+      profile_entry[key] = e;
+      continue;
+    }
+
+    ProfileEntry& p = it->second;
+    p.count           += e.count;
+    p.wall_time       += e.wall_time;
+    p.cpu_time        += e.cpu_time;
+    p.thread_cpu_time += e.thread_cpu_time;
+    if(e.wall_max > p.wall_max)
+      p.wall_max = e.wall_max;
+    if(e.rss_max > p.rss_max)
+      p.rss_max = e.rss_max;
+  }
+
+  from >> size;
+  std::getline(from, line);
+  for(int i = 0; i < size && from; ++i) {
+    TraceEvent t;
+    std::getline(from, t.name);
+    from >> t.start >> t.duration;
+    std::getline(from, line);
+
+    t.track = track;
+    if(trace_event.size() < trace_event_max)
+      trace_event.push_back(t);
+    else
+      ++trace_event_lost;
+  }
+
+  if(!from) {
+    std::cerr << funame << "corrupted\n";
+    throw Error::Input();
+  }
+}
+
 IO::Marker::Marker(const char* h, int f, std::ostream* out) 
-  : _header(h), _start_time(std::time(0)),_start_cpu(std::clock()), _flags(f)
+  : _header(h), _start_time(std::time(0)),_start_cpu(std::clock()), _start_wall(std::chrono::steady_clock::now()),
+    _start_thread_cpu(-1.), _flags(f), _level(_level_size++)
 {
+  // the markers inside the parallel regions are not profiled
+  //
+  if(profile_record && !in_parallel()) {
+    //
+    _start_thread_cpu = thread_cpu_time();
+
+    marker_path.push_back(_header);
+
+    std::string key = marker_key();
+    if(profile_entry.find(key) == profile_entry.end()) {
+      profile_order.push_back(key);
+      profile_entry[key].level = _level;
+    }
+  }
+
   // only master node can print
   //
   if(mpi_rank)
@@ -252,6 +1251,50 @@ IO::Marker::Marker(const char* h, int f, std::ostream* out)
 
 IO::Marker::~Marker ()
 {
+  --_level_size;
+
+  if(stage_record) {
+    //
+    Stage s;
+    s.name      = _header;
+    s.level     = _level;
+    s.cpu_time  = double(std::clock() - _start_cpu) / CLOCKS_PER_SEC;
+    s.wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start_wall).count();
+    stage_list.push_back(s);
+  }
+
+  if(_start_thread_cpu >= 0. && marker_path.size()) {
+    //
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    const double wall_time = std::chrono::duration<double>(now - _start_wall).count();
+
+    ProfileEntry& e = profile_entry[marker_key()];
+    ++e.count;
+    e.wall_time       += wall_time;
+    e.cpu_time        += double(std::clock() - _start_cpu) / CLOCKS_PER_SEC;
+    e.thread_cpu_time += thread_cpu_time() - _start_thread_cpu;
+    if(wall_time > e.wall_max)
+      e.wall_max = wall_time;
+
+    long rss = peak_rss();
+    if(rss > e.rss_max)
+      e.rss_max = rss;
+
+    if(trace_event.size() < trace_event_max) {
+      TraceEvent t;
+      t.name     = _header;
+      t.track    = 0;
+      t.start    = 1.e6 * std::chrono::duration<double>(_start_wall - profile_start).count();
+      t.duration = 1.e6 * wall_time;
+      trace_event.push_back(t);
+    }
+    else
+      ++trace_event_lost;
+
+    marker_path.pop_back();
+  }
+
   // only master node can print
   //
   if(mpi_rank)
@@ -279,6 +1322,177 @@ IO::Marker::~Marker ()
   }
 }
 
+/**************************************************************************************************
+ ******************************************* TABLE RECORDS ****************************************
+ **************************************************************************************************/
+
+bool IO::binary_record = false;
+
+namespace {
+  //
+  const char record_signature [] = "MESSREC1";
+
+  void record_put (std::ostream& to, int i) { to.write((const char*)&i, sizeof(i)); }
+
+  void record_put (std::ostream& to, const std::string& s)
+  {
+    record_put(to, (int)s.size());
+    to.write(s.data(), s.size());
+  }
+
+  bool record_get (std::istream& from, int& i) { return !from.read((char*)&i, sizeof(i)).fail(); }
+
+  bool record_get (std::istream& from, std::string& s)
+  {
+    int n;
+    if(!record_get(from, n) || n < 0)
+      return false;
+
+    s.resize(n);
+    if(n)
+      from.read(&s[0], n);
+    
+    return !from.fail();
+  }
+
+  // the signature is written at the start of each output file
+  void record_start (std::ostream& to)
+  {
+    if(to.tellp() != std::streampos(0))
+      return;
+
+    record_put(to, (int)IO::SIGNATURE_RECORD);
+    to.write(record_signature, 8);
+    record_put(to, 0x01020304);
+    const double one = 1.;
+    to.write((const char*)&one, sizeof(one));
+  }
+
+  // rendering as text
+  void text_table (std::ostream& to, const std::string& label, const double* data, int rows, int cols, int width)
+  {
+    for(int i = 0; i < rows; ++i) {
+      if(label.size())
+	to << std::setw(width) << label;
+      for(int j = 0; j < cols; ++j)
+	to << std::setw(width) << data[i * cols + j];
+      to << "\n";
+    }
+  }
+}
+
+void IO::put_text (std::ostream& to, const std::string& s)
+{
+  if(!binary_record) {
+    to << s;
+    return;
+  }
+
+  record_start(to);
+  record_put(to, (int)TEXT_RECORD);
+  record_put(to, s);
+}
+
+void IO::put_header (std::ostream& to, const std::vector<std::string>& title, int width)
+{
+  if(!binary_record) {
+    for(int i = 0; i < title.size(); ++i)
+      to << std::setw(width) << title[i];
+    to << "\n";
+    return;
+  }
+
+  record_start(to);
+  record_put(to, (int)HEADER_RECORD);
+  record_put(to, width);
+  record_put(to, (int)title.size());
+  for(int i = 0; i < title.size(); ++i)
+    record_put(to, title[i]);
+}
+
+void IO::put_table (std::ostream& to, const std::string& label, const double* data, int rows, int cols, int width)
+{
+  if(!binary_record) {
+    text_table(to, label, data, rows, cols, width);
+    return;
+  }
+
+  record_start(to);
+  record_put(to, (int)TABLE_RECORD);
+  record_put(to, width);
+  record_put(to, label);
+  record_put(to, rows);
+  record_put(to, cols);
+  if(rows && cols)
+    to.write((const char*)data, (std::streamsize)rows * cols * sizeof(double));
+}
+
+bool IO::convert_record (std::istream& from, std::ostream& to)
+{
+  const char funame [] = "IO::convert_record: ";
+
+  int type, width, rows, cols, n;
+
+  std::string label;
+
+  if(!record_get(from, type))
+    return false;
+
+  switch(type) {
+  case SIGNATURE_RECORD: {
+    char sig [8];
+    int  order;
+    double one;
+    from.read(sig, 8);
+    record_get(from, order);
+    from.read((char*)&one, sizeof(one));
+
+    if(!from || std::strncmp(sig, record_signature, 8) || order != 0x01020304 || one != 1.) {
+      std::cerr << funame << "wrong signature or byte order\n";
+      throw Error::Form();
+    }
+    return true;
+  }
+  case TEXT_RECORD:
+    if(!record_get(from, label))
+      break;
+    to << label;
+    return true;
+
+  case HEADER_RECORD:
+    if(!record_get(from, width) || !record_get(from, n))
+      break;
+    for(int i = 0; i < n; ++i) {
+      if(!record_get(from, label))
+	break;
+      to << std::setw(width) << label;
+    }
+    if(!from)
+      break;
+    to << "\n";
+    return true;
+
+  case TABLE_RECORD: {
+    if(!record_get(from, width) || !record_get(from, label) || !record_get(from, rows) || !record_get(from, cols)
+       || rows < 0 || cols < 0)
+      break;
+    std::vector<double> data((long)rows * cols);
+    if(data.size())
+      from.read((char*)&data[0], data.size() * sizeof(double));
+    if(!from)
+      break;
+    text_table(to, label, data.size() ? &data[0] : 0, rows, cols, width);
+    return true;
+  }
+  default:
+    std::cerr << funame << "unknown record type: " << type << "\n";
+    throw Error::Form();
+  }
+
+  std::cerr << funame << "truncated record\n";
+  throw Error::Form();
+}
+
 /**************************************************************************************************
  ************************************ STRING-TO-NUMBER CONVERTER **********************************
  **************************************************************************************************/
@@ -18,12 +18,18 @@
 
 #include <iostream>
 #include <fstream>
+#include <streambuf>
+#include <locale>
 #include <sstream>
 #include <set>
 #include <string>
 #include <iomanip>
 #include <vector>
 #include <ctime>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "error.hh"
 
@@ -57,7 +63,59 @@ namespace IO {
    ****************************** OUTPUT **********************************
    ************************************************************************/
 
-  class LogOut : public std::ofstream {};
+  // the log text is formatted by the calling threads into their own line buffers; the complete
+  // lines are passed to the background thread which writes them to the file, so neither the
+  // formatting threads nor the flushes wait for the disk
+  //
+  struct LogFork;
+
+  class LogBuffer : public std::streambuf {
+    //
+    std::streambuf*           _to;     // file buffer
+    std::string               _queue;  // lines waiting for the writer
+    std::vector<std::string*> _local;  // line buffers of the threads
+    std::mutex                _mutex;
+    std::condition_variable   _ready;
+    std::thread               _writer;
+    bool                      _stop;
+
+    LogBuffer (const LogBuffer&);
+    LogBuffer& operator= (const LogBuffer&);
+
+    std::string& _line ();              // line buffer of the calling thread
+    void         _commit (std::string&, bool partial);
+    void         _write  ();            // writer thread loop
+
+    friend struct LogFork;
+
+  protected:
+    //
+    int_type        overflow (int_type);
+    std::streamsize xsputn   (const char*, std::streamsize);
+    int             sync     ();
+
+  public:
+    //
+    LogBuffer ();
+    ~LogBuffer ();
+
+    void start (std::streambuf*);
+    void stop  (); // all the text is written; no concurrent output is assumed
+    bool is_running () const { return _writer.joinable(); }
+  };
+
+  class LogOut : public std::ofstream {
+    //
+    LogBuffer _buffer;
+
+  public:
+    //
+    ~LogOut () { close(); }
+
+    void open  (const char*, std::ios_base::openmode =std::ios_base::out);
+    void open  (const std::string& s, std::ios_base::openmode m =std::ios_base::out) { open(s.c_str(), m); }
+    void close ();
+  };
 
   template <typename T>
   //
@@ -156,24 +214,166 @@ namespace IO {
 
   extern Offset log_offset;
 
+  /***********************************************************************************
+   ********************************* MAPPED FILE INPUT *******************************
+   ***********************************************************************************/
+
+  // the whole file is mapped into memory and is read in a single pass
+  //
+  class MappedBuffer : public std::streambuf {
+    //
+    char*       _data;
+    std::size_t _size;
+    bool        _mapped; // mmap or heap copy
+    bool        _open;
+
+    MappedBuffer (const MappedBuffer&);
+    MappedBuffer& operator= (const MappedBuffer&);
+
+    friend class FastNumGet; // reads the numbers directly from the buffer
+
+  protected:
+    //
+    int_type        underflow ();
+    int_type        pbackfail (int_type);
+    std::streamsize showmanyc ();
+    pos_type        seekoff   (off_type, std::ios_base::seekdir, std::ios_base::openmode);
+    pos_type        seekpos   (pos_type, std::ios_base::openmode);
+
+  public:
+    //
+    MappedBuffer () : _data(0), _size(0), _mapped(false), _open(false) {}
+    ~MappedBuffer () { close(); }
+
+    bool open    (const char*);
+    void close   ();
+    bool is_open () const { return _open; }
+  };
+
+  // read-only shared mapping of the whole file: the concurrent processes mapping
+  // the same file share one page cache copy of it
+  //
+  class MappedFile {
+    //
+    const char* _data;
+    std::size_t _size;
+
+    MappedFile (const MappedFile&);
+    MappedFile& operator= (const MappedFile&);
+
+  public:
+    //
+    MappedFile () : _data(0), _size(0) {}
+    ~MappedFile () { close(); }
+
+    bool open  (const char*);
+    void close ();
+
+    const char* data () const { return _data; }
+    std::size_t size () const { return _size; }
+  };
+
+  // numbers are converted by strtod/strtol from the buffered text, the accepted
+  // syntax is that of the standard facet
+  //
+  class FastNumGet : public std::num_get<char> {
+    //
+    // fixed size number text, longer numbers are rejected
+    class Text {
+      //
+      char _data [128];
+      int  _size;
+
+    public:
+      //
+      Text () : _size(0) {}
+
+      void clear     ()       { _size = 0; }
+      void push_back (char c) { if(_size < sizeof(_data)) _data[_size] = c; ++_size; }
+      bool overflow  () const { return _size > sizeof(_data); }
+
+      operator const char* () const { return _data; }
+    };
+
+    // the number text at the current position
+    static bool _scan (iter_type&, iter_type, const std::ios_base&, bool, Text&);
+
+  protected:
+    //
+    iter_type do_get (iter_type, iter_type, std::ios_base&, std::ios_base::iostate&, long&)   const;
+    iter_type do_get (iter_type, iter_type, std::ios_base&, std::ios_base::iostate&, double&) const;
+  };
+
+  // input file stream over the mapped buffer with the fast numeric input
+  //
+  class FileStream : public std::istream {
+    //
+    MappedBuffer _buf;
+
+  public:
+    //
+    FileStream () ;
+    explicit FileStream (const char*) ;
+
+    void open    (const char*);
+    void close   ();
+    bool is_open () const { return _buf.is_open(); }
+  };
+
+  /***********************************************************************************
+   ******************************** ATOMIC FILE OUTPUT *******************************
+   ***********************************************************************************/
+
+  // FNV-1a hash of the key as 16 hexadecimal digits, the cache files names
+  //
+  std::string hash_name (const std::string&);
+
+  // the file is written under a temporary name and renamed by commit, so that the concurrent
+  // runs never see a partial file and the previous one survives an interrupted writing;
+  // the temporary file is removed if the writing fails or is not committed
+  //
+  class AtomicFile : public std::ofstream {
+    //
+    std::string _name;
+    std::string _tmp_name;
+    bool        _done;
+
+    AtomicFile (const AtomicFile&);
+    AtomicFile& operator= (const AtomicFile&);
+
+  public:
+    //
+    explicit AtomicFile (const std::string&, std::ios_base::openmode = std::ios_base::binary);
+    ~AtomicFile ();
+
+    const std::string& tmp_name () const { return _tmp_name; }
+
+    // false if the file cannot be written or renamed
+    bool commit ();
+  };
+
   /***********************************************************************************
    ****************************** KEY BUFFER STREAM **********************************
    ***********************************************************************************/
 
   // facility to put keyword back to the input stream
   //
-  class KeyBufferStream : public std::ifstream {
+  class KeyBufferStream : public FileStream {
     //
     std::vector<std::string> _buffer;
 
   public:
     //
-    KeyBufferStream (const char* f) : std::ifstream(f) {}
+    KeyBufferStream (const char* f) : FileStream(f) {}
     
     KeyBufferStream () {}
 
     void put_back (const std::string&) ;
 
+    // is there a keyword put back
+    //
+    bool isbuffer () const { return _buffer.size(); }
+
     template <typename T>
     //
     friend KeyBufferStream& operator>> (KeyBufferStream& from, T& t);
@@ -181,7 +381,7 @@ namespace IO {
 
   template <typename T>
   //
-  KeyBufferStream& operator>> (KeyBufferStream& from, T&  t) { (std::ifstream&)from >> t; return from; }
+  KeyBufferStream& operator>> (KeyBufferStream& from, T&  t) { (std::istream&)from >> t; return from; }
 
   template <>
   //
@@ -192,6 +392,33 @@ namespace IO {
    ************************************ INPUT MARKER **********************************
    ************************************************************************************/
 
+  // stage timing: the markers record their stages while stage_record is set
+  //
+  struct Stage {
+    std::string name;
+    int         level;    // nesting level
+    double      cpu_time; // sec
+    double      wall_time;// sec
+  };
+
+  extern bool               stage_record;
+  extern std::vector<Stage> stage_list;// in the order of completion
+
+  // profiling: the marker scopes are aggregated over the run by their nesting path (call
+  // counts, wall time by the monotonic clock, process and calling thread cpu times, peak RSS)
+  // and recorded as the timeline events; at exit the summary table is written to
+  // the <base>.prof file and the timeline to the <base>.trace.json file (Chrome trace format)
+  //
+  extern bool profile_record;
+
+  void profile_open (const std::string& base);
+
+  // transfer of the profile of the forked worker process to the parent one;
+  // the worker events are placed on the separate timeline track
+  void profile_reset ();              // in the worker after the fork
+  void profile_save  (std::ostream&);
+  void profile_merge (std::istream&, int track);
+
   class Marker {
     //
     std::string    _header;
@@ -200,10 +427,18 @@ namespace IO {
 
     std::time_t   _start_time;
 
+    std::chrono::steady_clock::time_point _start_wall;
+
+    double        _start_thread_cpu; // profiling
+
     int           _flags;
 
+    int           _level;
+
     std::ostream* _to;
 
+    static int    _level_size;
+
   public:
     //
     Marker(const char*, int =0, std::ostream* =0);
@@ -216,6 +451,32 @@ namespace IO {
     };
   };
 
+  /****************************************************************************************
+   ************************************* TABLE RECORDS ************************************
+   ****************************************************************************************/
+
+  // tabulated output either as formatted text or as the binary records written as they are
+  // produced; the binary record is the int type followed by the data (strings are the int length
+  // and the characters; integers are 32 bit and doubles are 64 bit, in the native byte order,
+  // which is checked by the signature record starting each output file); the messrec utility
+  // converts the binary records back to the same text
+  //
+  enum {
+    SIGNATURE_RECORD = 0, // char[8], int 0x01020304, double 1.
+    TEXT_RECORD      = 1, // string: verbatim text
+    HEADER_RECORD    = 2, // int width, int n, n strings: one line of the right-aligned column titles
+    TABLE_RECORD     = 3  // int width, string label, int rows, int columns, doubles row by row:
+  };                      // the right-aligned label (if not empty) and the numbers, one line per row
+
+  extern bool binary_record;// binary records instead of text
+
+  void put_text   (std::ostream&, const std::string&) ;
+  void put_header (std::ostream&, const std::vector<std::string>&, int =13) ;
+  void put_table  (std::ostream&, const std::string&, const double*, int, int, int =13) ;
+
+  // converts the next binary record to text; returns false at the end of the input
+  bool convert_record (std::istream&, std::ostream&) ;
+
   /****************************************************************************************
    ************************************ STRING CONVERTER **********************************
    ****************************************************************************************/
@@ -20,7 +20,15 @@
 #include "lapack.h"
 #include "linpack.hh"
 
+#ifdef WITH_CUSOLVER
+
+#include "cusolver.hh"
+
+#endif
+
 #include <iostream>
+#include <vector>
+#include <cmath>
 
 /****************************************************************
  ************************** Vector ******************************
@@ -199,6 +207,135 @@ Lapack::Matrix Lapack::Matrix::operator* (const Matrix& m) const
   return res;
 }
 
+Lapack::Matrix Lapack::Matrix::transpose_product (const Matrix& m) const 
+{
+  const char funame [] = "Lapack::Matrix::transpose_product: ";
+
+  if(!isinit() || !m.isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(size1() != m.size1()) {
+    std::cerr << funame << "dimensions mismatch\n";
+    throw Error::Range();
+  }
+
+  Matrix res(size2(), m.size2());
+  dgemm_('T', 'N', size2(), m.size2(), size1(), 1., 
+	 *this, size1(), m, m.size1(), 0., res, size2());
+
+  return res;
+}
+
+Lapack::Matrix& Lapack::Matrix::add_transpose_product (const Matrix& a, const Matrix& b, double factor)
+{
+  const char funame [] = "Lapack::Matrix::add_transpose_product: ";
+
+  if(!isinit() || !a.isinit() || !b.isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(a.size1() != b.size1() || size1() != a.size2() || size2() != b.size2()) {
+    std::cerr << funame << "dimensions mismatch\n";
+    throw Error::Range();
+  }
+
+  if(!size1() || !size2())
+    return *this;
+
+  dgemm_('T', 'N', a.size2(), b.size2(), a.size1(), factor, 
+	 a, a.size1(), b, b.size1(), 1., *this, size1());
+
+  return *this;
+}
+
+Lapack::SymmetricMatrix Lapack::Matrix::symmetric_transpose_product (const Matrix& m) const
+{
+  const char funame [] = "Lapack::Matrix::symmetric_transpose_product: ";
+
+  if(!isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  SymmetricMatrix res(size2());
+  res = 0.;
+
+  return res.add_transpose_product(*this, m);
+}
+
+// cycle-following permutation for the rectangular matrix
+//
+Lapack::Matrix& Lapack::Matrix::transpose_in_place ()
+{
+  const char funame [] = "Lapack::Matrix::transpose_in_place: ";
+
+  double dtemp;
+
+  if(!isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  const int_t s1 = size1();
+  const int_t s2 = size2();
+
+  double* p = *this;
+
+  if(s1 == s2) {
+    for(int_t j = 1; j < s2; ++j)
+      for(int_t i = 0; i < j; ++i)
+	std::swap(p[i + j * s1], p[j + i * s1]);
+
+    return *this;
+  }
+
+  // element at i + j * s1 goes to j + i * s2, i.e., k -> k * s2 mod (size - 1)
+  const long last = (long)s1 * s2 - 1;
+
+  std::vector<bool> done(last + 1);
+
+  for(long start = 1; start < last; ++start) {
+    if(done[start])
+      continue;
+
+    long k = start;
+    dtemp = p[k];
+    do {
+      const long next = k * s2 % last;
+      std::swap(dtemp, p[next]);
+      done[next] = true;
+      k = next;
+    } while(k != start);
+  }
+
+  set_extent(0, s2);
+  set_extent(1, s1);
+
+  return *this;
+}
+
+Lapack::Matrix::Matrix (const SymmetricMatrix& m)
+{
+  const char funame [] = "Lapack::Matrix::Matrix: ";
+
+  if(!m.isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  resize(m.size());
+
+  const double* p = m;
+  for(int_t j = 0; j < size(); ++j)
+    for(int_t i = 0; i <= j; ++i, ++p)
+      (*this)(i, j) = (*this)(j, i) = *p;
+}
+
+// the packed matrix is unpacked to use the level-3 BLAS
+//
 Lapack::Matrix Lapack::Matrix::operator* (const SymmetricMatrix& m)
   const 
 {
@@ -217,9 +354,9 @@ Lapack::Matrix Lapack::Matrix::operator* (const SymmetricMatrix& m)
     throw Error::Range();
   }
 
+  Matrix full(m);
   Matrix res(size1(), size2());
-  for(int_t i = 0; i < size1(); ++i)
-    dspmv_('U', size2(),  1., m, *this + i, size1(), 0., res + i, size1());
+  dsymm_('R', 'U', size1(), size2(), 1., full, size2(), *this, size1(), 0., res, size1());
   return res;
 }
 
@@ -617,16 +754,263 @@ Lapack::Vector Lapack::BandMatrix::eigenvalues (Matrix* evec)
   }
 }
 
+Lapack::Vector Lapack::BandMatrix::operator* (const Vector& v) const
+{
+  const char funame [] = "Lapack::BandMatrix::operator*: ";
+
+  if(!isinit() || !v.isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(size() != v.size()) {
+    std::cerr << funame << "dimensions mismatch\n";
+    throw Error::Range();
+  }
+
+  Vector res(size());
+  dsbmv_('U', size(), band_size() - 1, 1., *this, band_size(), v, 1, 0., res, 1);
+
+  return res;
+}
+
+// Lanczos iterations with the full reorthogonalization on the inverse of the shifted matrix;
+// the eigenvalues are the Rayleigh quotients of the converged Ritz vectors
+//
+Lapack::Vector Lapack::BandMatrix::lowest_eigenvalues (int_t num, const BandCholesky& shifted, Matrix* evec,
+						     const double* start) const
+{
+  const char funame [] = "Lapack::BandMatrix::lowest_eigenvalues: ";
+
+  static const double tol = 1.e-12;
+
+  if(!isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(num <= 0 || num > size()) {
+    std::cerr << funame << "requested number of eigenvalues out of range: " << num << "\n";
+    throw Error::Range();
+  }
+
+  if(shifted.size() != size()) {
+    std::cerr << funame << "factorized matrix dimension mismatch\n";
+    throw Error::Range();
+  }
+
+  const int_t n = size();
+
+  // maximal Krylov subspace dimension
+  int_t kmax = 10 * num + 100;
+  if(kmax > n)
+    kmax = n;
+
+  Matrix basis(n, kmax);
+  std::vector<double> alpha, beta;
+
+  // pseudorandom starting vector
+  unsigned long seed = 12345;
+  Vector q(n);
+  for(int_t i = 0; i < n; ++i) {
+    seed = (seed * 1103515245UL + 12345UL) % 2147483648UL;
+    q[i] = (double)seed / 2147483648. - 0.5;
+  }
+  ::normalize(q, n);
+
+  // the supplied starting vector with a small random admixture to keep all the directions
+  if(start) {
+    const double norm = vlength(start, n);
+
+    if(norm > 0.) {
+      for(int_t i = 0; i < n; ++i)
+	q[i] = start[i] / norm + 1.e-3 * q[i];
+      ::normalize(q, n);
+    }
+  }
+
+  Vector coef(kmax);
+  Vector ritz_val;
+  Matrix ritz_vec;
+
+  int_t k = 0;
+  while(1) {
+    for(int_t i = 0; i < n; ++i)
+      basis(i, k) = q[i];
+
+    Vector w = shifted.invert(q);
+
+    // full reorthogonalization, applied twice
+    for(int it = 0; it < 2; ++it) {
+      dgemv_('T', n, k + 1, 1., basis, n, w, 1, 0., coef, 1);
+      if(!it)
+	alpha.push_back(coef[k]);
+      else
+	alpha.back() += coef[k];
+      dgemv_('N', n, k + 1, -1., basis, n, coef, 1, 1., w, 1);
+    }
+
+    double b = ::normalize(w, n);
+
+    ++k;
+
+    // Ritz pairs of the tridiagonal matrix
+    if(k >= num) {
+      SymmetricMatrix tri(k);
+      tri = 0.;
+      for(int_t i = 0; i < k; ++i) {
+	tri(i, i) = alpha[i];
+	if(i)
+	  tri(i - 1, i) = beta[i - 1];
+      }
+      ritz_val = tri.eigenvalues(&ritz_vec);
+
+      // residual norms of the largest Ritz values of the inverse of the shifted matrix
+      bool conv = true;
+      for(int_t l = 0; l < num; ++l)
+	if(b * std::fabs(ritz_vec(k - 1, k - 1 - l)) > tol * ritz_val[k - 1]) {
+	  conv = false;
+	  break;
+	}
+
+      if(conv || k == n)
+	break;
+
+      if(k == kmax) {
+	std::cerr << funame << "Lanczos iterations did not converge in " << kmax << " steps\n";
+	throw Error::Math();
+      }
+    }
+
+    // invariant subspace found: restart with a new random vector orthogonal to the basis
+    if(b < tol * std::fabs(alpha.back())) {
+      for(int_t i = 0; i < n; ++i) {
+	seed = (seed * 1103515245UL + 12345UL) % 2147483648UL;
+	w[i] = (double)seed / 2147483648. - 0.5;
+      }
+      for(int it = 0; it < 2; ++it) {
+	dgemv_('T', n, k, 1., basis, n, w, 1, 0., coef, 1);
+	dgemv_('N', n, k, -1., basis, n, coef, 1, 1., w, 1);
+      }
+      ::normalize(w, n);
+      b = 0.;
+    }
+
+    beta.push_back(b);
+    q = w;
+  }
+
+  // Ritz vectors and Rayleigh quotients
+  Vector res(num);
+  if(evec)
+    evec->resize(n, num);
+
+  Vector x(n);
+  for(int_t l = 0; l < num; ++l) {
+    dgemv_('N', n, k, 1., basis, n, &ritz_vec(0, k - 1 - l), 1, 0., x, 1);
+    ::normalize(x, n);
+
+    res[l] = x * (*this * x);
+
+    if(evec)
+      for(int_t i = 0; i < n; ++i)
+	(*evec)(i, l) = x[i];
+  }
+
+  return res;
+}
+
+/****************************************************************
+ ********************* General Band Matrix **********************
+ ****************************************************************/
+
+double  Lapack::GeneralBandMatrix::operator() (int_t i, int_t j) const
+{
+  const char funame [] = "Lapack::GeneralBandMatrix::operator(): ";
+
+  if(!isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(i - j < band_size() && j - i < band_size())
+    return Matrix::operator()(band_size() - 1 + i - j, j);
+
+  return 0.;
+}
+
+double& Lapack::GeneralBandMatrix::operator() (int_t i, int_t j) 
+{
+  const char funame [] = "Lapack::GeneralBandMatrix::operator(): ";
+
+  if(!isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(i - j < band_size() && j - i < band_size())
+    return Matrix::operator()(band_size() - 1 + i - j, j);
+
+  std::cerr << funame << "out of range\n";
+  throw Error::Range();
+}
+
+Lapack::Vector Lapack::GeneralBandMatrix::operator* (const Vector& v) const
+{
+  const char funame [] = "Lapack::GeneralBandMatrix::operator*: ";
+
+  if(!isinit() || !v.isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(size() != v.size()) {
+    std::cerr << funame << "dimensions mismatch\n";
+    throw Error::Range();
+  }
+
+  Vector res(size());
+  dgbmv_('N', size(), size(), band_size() - 1, band_size() - 1, 1., *this, size1(), v, 1, 0., res, 1);
+
+  return res;
+}
+
+Lapack::Matrix Lapack::GeneralBandMatrix::operator* (const Matrix& m) const
+{
+  const char funame [] = "Lapack::GeneralBandMatrix::operator*: ";
+
+  if(!isinit() || !m.isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(size() != m.size1()) {
+    std::cerr << funame << "dimensions mismatch\n";
+    throw Error::Range();
+  }
+
+  Matrix res(size(), m.size2());
+
+  for(int_t i = 0; i < m.size2(); ++i)
+    //
+    dgbmv_('N', size(), size(), band_size() - 1, band_size() - 1, 1., *this, size1(), 
+	   &m(0, i), 1, 0., &res(0, i), 1);
+
+  return res;
+}
+
 /****************************************************************
  ********************* Symmetric Matrix *************************
  ****************************************************************/
 
 Lapack::SymmetricMatrix::SymmetricMatrix 
 (const Lapack::Matrix& m, char uplo) 
-  : RefArr<double>(m.size1() * (m.size1() + 1) / 2), _size(new int_t(m.size1()))
+  : RefArr<double>(m.size1() * (m.size1() + 1) / 2)
 {
   const char funame [] = "Lapack::SymmetricMatrix::SymmetricMatrix: ";
 
+  set_extent(0, m.size1());
+
   if(!m.isinit()) {
     std::cerr << funame << "not initialized\n";
     throw Error::Init();
@@ -662,6 +1046,48 @@ Lapack::SymmetricMatrix::SymmetricMatrix
   }
 }
 
+Lapack::SymmetricMatrix& Lapack::SymmetricMatrix::add_transpose_product (const Matrix& a, const Matrix& b, double factor)
+{
+  const char funame [] = "Lapack::SymmetricMatrix::add_transpose_product: ";
+
+  if(!isinit() || !a.isinit() || !b.isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(a.size1() != b.size1() || size() != a.size2() || size() != b.size2()) {
+    std::cerr << funame << "dimensions mismatch\n";
+    throw Error::Range();
+  }
+
+  const int_t n = size();
+
+  if(!n)
+    return *this;
+
+  // column panel: rows 0 to j0 + jb of columns j0 to j0 + jb
+  const int_t panel_size = 256;
+
+  Matrix panel(n, panel_size < n ? panel_size : n);
+
+  for(int_t j0 = 0; j0 < n; j0 += panel_size) {
+    const int_t jb = j0 + panel_size < n ? panel_size : n - j0;
+    const int_t rb = j0 + jb;
+
+    dgemm_('T', 'N', rb, jb, a.size1(), factor, 
+	   a, a.size1(), (const double*)b + j0 * b.size1(), b.size1(), 0., panel, rb);
+
+    const double* pp = panel;
+    for(int_t j = 0; j < jb; ++j) {
+      double* col = *this + (j0 + j) * (j0 + j + 1) / 2;
+      for(int_t i = 0; i <= j0 + j; ++i)
+	col[i] += pp[i + j * rb];
+    }
+  }
+
+  return *this;
+}
+
 Lapack::Vector Lapack::SymmetricMatrix::operator* (const Vector& v) const 
 {
   const char funame [] = "Lapack::SymmetricMatrix::operator*: ";
@@ -740,9 +1166,9 @@ Lapack::Matrix Lapack::SymmetricMatrix::operator* (const Matrix& m)
     throw Error::Range();
   }
 
+  Matrix full(*this);
   Matrix res(size(), m.size2());
-  for(int_t j = 0; j < m.size2(); ++j)
-    dspmv_('U', size(),  1.,  *this, m + j * size(), 1, 0., res + j * size(), 1);  
+  dsymm_('L', 'U', size(), m.size2(), 1., full, size(), m, size(), 0., res, size());
   return res;
 }
 
@@ -763,28 +1189,9 @@ Lapack::Matrix Lapack::SymmetricMatrix::operator* (const SymmetricMatrix& m) con
     throw Error::Range();
   }
 
+  Matrix full(*this);
   Matrix res(size());
-  for(int_t i = 0; i < size(); ++i)
-    for(int_t j = 0; j < size(); ++j) {
-      double dtemp = 0.;
-      const double* dp1 = *this + i * (i + 1) / 2;
-      const double* dp2 = m     + j * (j + 1) / 2;
-
-      for(int_t k = 0; k < size(); ++k) {
-	dtemp += *dp1 * *dp2;
-	// next first multiplier element
-	if(k < i)
-	  dp1++;
-	else
-	  dp1 += k + 1;
-	// next second multiplier element
-	if(k < j)
-	  dp2++;
-	else
-	  dp2 += k + 1;
-      }
-      res(i,j) = dtemp;
-    }
+  dsymm_('L', 'U', size(), size(), 1., full, size(), Matrix(m), size(), 0., res, size());
   return res;
 }
 
@@ -798,6 +1205,28 @@ Lapack::Vector Lapack::SymmetricMatrix::eigenvalues (Matrix* evec)
     throw Error::Init();
   }
 
+#ifdef WITH_CUSOLVER
+
+  if(Cusolver::use(size())) {
+    //
+    // full storage, upper triangle
+    Matrix a(size());
+    const double* p = *this;
+    for(int_t j = 0; j < size(); ++j)
+      for(int_t i = 0; i <= j; ++i, ++p)
+	a(i, j) = *p;
+
+    Vector res(size());
+    Cusolver::eigenvalues(size(), a, res, evec);
+
+    if(evec)
+      *evec = a;
+
+    return res;
+  }
+
+#endif
+
   SymmetricMatrix sm = copy();
   Vector res(size());
   Vector work(3 * size());
@@ -824,6 +1253,435 @@ Lapack::Vector Lapack::SymmetricMatrix::eigenvalues (Matrix* evec)
   }
 }
 
+namespace {
+  //
+  // double-double accumulator: error-free transformations of the sum and the product
+  struct DoubleDouble {
+    double hi, lo;
+
+    DoubleDouble () : hi(0.), lo(0.) {}
+
+    void add (double a) {
+      const double s = hi + a;
+      const double v = s - hi;
+      lo += (hi - (s - v)) + (a - v);
+      hi = s + lo;
+      lo -= hi - s;
+    }
+
+    void add_product (double a, double b) {
+      const double p = a * b;
+      add(p);
+      lo += std::fma(a, b, -p);
+    }
+
+    double value () const { return hi + lo; }
+  };
+}
+
+Lapack::Vector Lapack::SymmetricMatrix::refined_eigenvalues (Matrix* evec)
+  const 
+{
+  const char funame [] = "Lapack::SymmetricMatrix::refined_eigenvalues: ";
+
+  if(!isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  const int_t n = size();
+
+  Matrix x;
+  Vector res = eigenvalues(&x);
+
+  std::vector<DoubleDouble> lambda(n), s(n * n), r(n * n), ax(n * n);
+
+  Matrix e(n);
+
+  const int iter_max = 10;
+  
+  for(int iter = 0; iter < iter_max; ++iter) {
+    //
+    // A * X
+    for(int_t j = 0; j < n; ++j)
+      for(int_t k = 0; k < n; ++k) {
+	ax[k + j * n] = DoubleDouble();
+	for(int_t l = 0; l < n; ++l)
+	  ax[k + j * n].add_product((*this)(k, l), x(l, j));
+      }
+
+    // S = X^T * A * X, R = I - X^T * X
+    for(int_t i = 0; i < n; ++i)
+      for(int_t j = 0; j < n; ++j) {
+	DoubleDouble& sij = s[i + j * n];
+	DoubleDouble& rij = r[i + j * n];
+
+	sij = DoubleDouble();
+	rij = DoubleDouble();
+	if(i == j)
+	  rij.add(1.);
+
+	for(int_t k = 0; k < n; ++k) {
+	  sij.add_product(x(k, i), ax[k + j * n].hi);
+	  sij.add(x(k, i) * ax[k + j * n].lo);
+	  rij.add_product(-x(k, i), x(k, j));
+	}
+      }
+
+    // refined eigenvalues
+    double anorm = 0.;
+    for(int_t i = 0; i < n; ++i) {
+      lambda[i] = s[i + i * n];
+      lambda[i].add(s[i + i * n].hi * r[i + i * n].value());
+      res[i] = lambda[i].value();
+      if(std::fabs(res[i]) > anorm)
+	anorm = std::fabs(res[i]);
+    }
+
+    // clustered eigenvalues threshold
+    double snorm = 0., rnorm = 0.;
+    for(int_t i = 0; i < n; ++i)
+      for(int_t j = 0; j < n; ++j) {
+	rnorm += r[i + j * n].value() * r[i + j * n].value();
+	if(i != j)
+	  snorm += s[i + j * n].value() * s[i + j * n].value();
+      }
+    const double delta = 2. * (std::sqrt(snorm) + anorm * std::sqrt(rnorm));
+    
+    // correction
+    double emax = 0.;
+    for(int_t i = 0; i < n; ++i)
+      for(int_t j = 0; j < n; ++j) {
+	if(i == j) {
+	  e(i, j) = r[i + j * n].value() / 2.;
+	}
+	else {
+	  DoubleDouble gap = lambda[j];
+	  gap.add(-lambda[i].hi);
+	  gap.add(-lambda[i].lo);
+
+	  if(std::fabs(gap.value()) > delta) {
+	    DoubleDouble num = s[i + j * n];
+	    num.add_product(lambda[j].hi, r[i + j * n].hi);
+	    e(i, j) = num.value() / gap.value();
+	  }
+	  else
+	    e(i, j) = r[i + j * n].value() / 2.;
+	}
+
+	if(std::fabs(e(i, j)) > emax)
+	  emax = std::fabs(e(i, j));
+      }
+
+    if(emax < 1.e-15)
+      break;
+
+    x += x * e;
+  }
+
+  if(evec)
+    *evec = x;
+
+  return res;
+}
+
+// range: 'I' - eigenvalues with indices from il to iu (zero-based, iu not included), 'V' - eigenvalues in (vl, vu]
+//
+Lapack::Vector Lapack::SymmetricMatrix::_partial_eigenvalues (char range, double vl, double vu, int_t il, int_t iu,
+							      Matrix* evec) const 
+{
+  const char funame [] = "Lapack::SymmetricMatrix::_partial_eigenvalues: ";
+
+  if(!isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  const int_t n = size();
+
+  // full storage, upper triangle
+  Matrix a(n);
+  const double* p = *this;
+  for(int_t j = 0; j < n; ++j)
+    for(int_t i = 0; i <= j; ++i, ++p)
+      a(i, j) = *p;
+
+  const char job = evec ? 'V' : 'N';
+
+  int_t ecount = range == 'I' ? iu - il : n;
+
+  Vector res(n);
+  Matrix z;
+  if(evec)
+    z.resize(n, ecount > 0 ? ecount : 1);
+
+  std::vector<int_t> isuppz(2 * n);
+
+  int_t m, info = 0;
+
+  // workspace query
+  double work_size;
+  int_t iwork_size;
+  dsyevr_(job, range, 'U', n, a, n, vl, vu, il + 1, iu, 0., m, res, evec ? (double*)z : (double*)res, n,
+	  &isuppz[0], &work_size, -1, &iwork_size, -1, info);
+
+  if(!info) {
+    Vector work((int_t)work_size);
+    std::vector<int_t> iwork(iwork_size);
+    dsyevr_(job, range, 'U', n, a, n, vl, vu, il + 1, iu, 0., m, res, evec ? (double*)z : (double*)res, n,
+	    &isuppz[0], work, work.size(), &iwork[0], iwork.size(), info);
+  }
+
+  if(info < 0) {
+    std::cerr << funame << "dsyevr: " << -info << "-th argument has an illegal value\n";
+    throw Error::Range();
+  }
+  else if(info) {
+    std::cerr << funame << "dsyevr: internal error\n";
+    throw Error::Math();
+  }
+
+  Vector eval(m);
+  for(int_t i = 0; i < m; ++i)
+    eval[i] = res[i];
+
+  if(evec) {
+    evec->resize(n, m);
+    for(int_t l = 0; l < m; ++l)
+      for(int_t i = 0; i < n; ++i)
+	(*evec)(i, l) = z(i, l);
+  }
+
+  return eval;
+}
+
+// lowest eigenvalues and eigenvectors
+//
+Lapack::Vector Lapack::SymmetricMatrix::lowest_eigenvalues (int_t num, Matrix* evec) const 
+{
+  const char funame [] = "Lapack::SymmetricMatrix::lowest_eigenvalues: ";
+
+  if(num <= 0 || num > size()) {
+    std::cerr << funame << "requested number of eigenvalues out of range: " << num << "\n";
+    throw Error::Range();
+  }
+
+  return _partial_eigenvalues('I', 0., 0., 0, num, evec);
+}
+
+// eigenvalues and eigenvectors in the (vmin, vmax] interval
+//
+Lapack::Vector Lapack::SymmetricMatrix::interval_eigenvalues (double vmin, double vmax, Matrix* evec) const 
+{
+  const char funame [] = "Lapack::SymmetricMatrix::interval_eigenvalues: ";
+
+  if(vmin >= vmax) {
+    std::cerr << funame << "wrong interval: " << vmin << ", " << vmax << "\n";
+    throw Error::Range();
+  }
+
+  return _partial_eigenvalues('V', vmin, vmax, 0, 0, evec);
+}
+
+Lapack::Vector Lapack::SymmetricMatrix::subspace_eigenvalues (int_t num, const Matrix& start, double shift, Matrix* evec) const
+{
+  const char funame [] = "Lapack::SymmetricMatrix::subspace_eigenvalues: ";
+
+  // residual norm relative to the largest Ritz value of the subspace
+  static const double tol = 1.e-10;
+
+  static const int iter_max = 50;
+
+  if(!isinit() || !start.isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  const int_t n = size();
+  const int_t m = start.size2();
+
+  if(start.size1() != n) {
+    std::cerr << funame << "starting subspace dimension mismatch\n";
+    throw Error::Range();
+  }
+
+  if(num <= 0 || num > m || m > n) {
+    std::cerr << funame << "requested number of eigenvalues out of range: " << num << "\n";
+    throw Error::Range();
+  }
+
+  if(shift <= 0.) {
+    std::cerr << funame << "shift should be positive\n";
+    throw Error::Range();
+  }
+
+  SymmetricMatrix shifted = copy();
+  for(int_t i = 0; i < n; ++i)
+    shifted(i, i) += shift;
+
+  const Cholesky fac(shifted);
+
+  Matrix full(*this);
+
+  Matrix x = start.copy();
+  x.orthogonalize();
+
+  Matrix ax(n, m);
+
+  for(int iter = 0; iter < iter_max; ++iter) {
+    //
+    Matrix y = fac.invert(x);
+    y.orthogonalize();
+
+    // Rayleigh-Ritz projection
+    Matrix ay(n, m);
+    dsymm_('L', 'U', n, m, 1., full, n, y, n, 0., ay, n);
+
+    Matrix ritz_vec;
+    Vector ritz_val = y.symmetric_transpose_product(ay).eigenvalues(&ritz_vec);
+
+    x  = y  * ritz_vec;
+    ax = ay * ritz_vec;
+
+    bool conv = true;
+    for(int_t l = 0; l < num && conv; ++l) {
+      double r = 0.;
+      for(int_t i = 0; i < n; ++i) {
+	const double dtemp = ax(i, l) - ritz_val[l] * x(i, l);
+	r += dtemp * dtemp;
+      }
+
+      if(std::sqrt(r) > tol * std::fabs(ritz_val[m - 1]))
+	conv = false;
+    }
+
+    if(!conv)
+      continue;
+
+    Vector res(num);
+    for(int_t l = 0; l < num; ++l)
+      res[l] = ritz_val[l];
+
+    if(evec) {
+      evec->resize(n, num);
+      for(int_t l = 0; l < num; ++l)
+	for(int_t i = 0; i < n; ++i)
+	  (*evec)(i, l) = x(i, l);
+    }
+
+    return res;
+  }
+
+  std::cerr << funame << "subspace iterations did not converge in " << iter_max << " steps\n";
+  throw Error::Math();
+}
+
+Lapack::Vector Lapack::SymmetricMatrix::projected_eigenvalues (int_t num, const Matrix& basis, double tol, Matrix* evec) const
+{
+  const char funame [] = "Lapack::SymmetricMatrix::projected_eigenvalues: ";
+
+  // relative norm of the orthogonalized basis vector below which it is dropped
+  static const double drop_tol = 1.e-8;
+
+  double dtemp;
+
+  if(!isinit() || !basis.isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  const int_t n = size();
+
+  if(basis.size1() != n) {
+    std::cerr << funame << "basis dimension mismatch\n";
+    throw Error::Range();
+  }
+
+  // orthonormal basis: Gram-Schmidt, twice
+  Matrix y(n, basis.size2());
+
+  int_t m = 0;
+  for(int_t v = 0; v < basis.size2(); ++v) {
+    double* col = &y(0, m);
+
+    double norm = 0.;
+    for(int_t i = 0; i < n; ++i) {
+      col[i] = basis(i, v);
+      norm  += col[i] * col[i];
+    }
+
+    if(norm == 0.)
+      continue;
+
+    for(int pass = 0; pass < 2; ++pass)
+      for(int_t u = 0; u < m; ++u) {
+	dtemp = 0.;
+	for(int_t i = 0; i < n; ++i)
+	  dtemp += y(i, u) * col[i];
+	for(int_t i = 0; i < n; ++i)
+	  col[i] -= dtemp * y(i, u);
+      }
+
+    dtemp = 0.;
+    for(int_t i = 0; i < n; ++i)
+      dtemp += col[i] * col[i];
+
+    if(dtemp < drop_tol * drop_tol * norm)
+      continue;
+
+    dtemp = std::sqrt(dtemp);
+    for(int_t i = 0; i < n; ++i)
+      col[i] /= dtemp;
+
+    ++m;
+  }
+
+  if(num <= 0 || num > m) {
+    std::cerr << funame << "requested number of eigenvalues, " << num << ", out of the basis rank, " << m << ", range\n";
+    throw Error::Range();
+  }
+
+  Matrix x(n, m);
+  for(int_t l = 0; l < m; ++l)
+    for(int_t i = 0; i < n; ++i)
+      x(i, l) = y(i, l);
+
+  Matrix full(*this);
+
+  Matrix ax(n, m);
+  dsymm_('L', 'U', n, m, 1., full, n, x, n, 0., ax, n);
+
+  Matrix ritz_vec;
+  Vector ritz_val = x.symmetric_transpose_product(ax).eigenvalues(&ritz_vec);
+
+  x  = x  * ritz_vec;
+  ax = ax * ritz_vec;
+
+  for(int_t l = 0; l < num; ++l) {
+    double r = 0.;
+    for(int_t i = 0; i < n; ++i) {
+      dtemp = ax(i, l) - ritz_val[l] * x(i, l);
+      r += dtemp * dtemp;
+    }
+
+    if(std::sqrt(r) > tol * std::fabs(ritz_val[num - 1]))
+      return Vector();
+  }
+
+  Vector res(num);
+  for(int_t l = 0; l < num; ++l)
+    res[l] = ritz_val[l];
+
+  if(evec) {
+    evec->resize(n, num);
+    for(int_t l = 0; l < num; ++l)
+      for(int_t i = 0; i < n; ++i)
+	(*evec)(i, l) = x(i, l);
+  }
+
+  return res;
+}
+
 Lapack::SymmetricMatrix Lapack::SymmetricMatrix::invert () const 
 {
   const char funame [] = "Lapack::SymmetricMatrix::invert: ";
@@ -894,10 +1752,79 @@ Lapack::SymmetricMatrix Lapack::SymmetricMatrix::positive_invert ()
   }
 }
 
-Lapack::Vector Lapack::diagonalize(SymmetricMatrix a0, SymmetricMatrix b0, Matrix* evec) 
+Lapack::Vector Lapack::diagonalize(SymmetricMatrix a0, SymmetricMatrix b0, Matrix* evec) 
+{
+  const char funame [] = "Lapack::diagonalize: ";
+  const char lapack_funame [] = "DSPGVD: ";
+
+  if(!a0.isinit() || !b0.isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(a0.size() != b0.size()) {
+    std::cerr << funame << "dimensions mismatch\n";
+    throw Error::Range();
+  }
+
+  SymmetricMatrix a = a0.copy();
+  SymmetricMatrix b = b0.copy();
+  Vector res(a.size());
+
+  char job = 'N';
+  int_t lwork = 2 * a.size();
+  int_t liwork = 1;
+  double* z = 0;
+  if(evec) {
+    evec->resize(a.size());
+    z = *evec;
+    job = 'V';
+    lwork = 1 + 6 * a.size() + 2 * a.size() * a.size();
+    liwork = 3 + 5 * a.size();
+  }
+
+  Array<double> work(lwork);
+  Array<int_t> iwork(liwork);
+  int_t info = 0;
+
+  dspgvd_(1, job, 'U', a.size(), a, b , res, z, a.size(), work, lwork, iwork, liwork, info);
+
+  if(!info)
+    return res;
+
+  if(info < 0) {
+    std::cerr << funame << lapack_funame << -info 
+	      << "-th argument has an illegal value\n";
+    throw Error::Range();
+  }
+
+  if(info <= a.size() ){
+    std::cerr << funame << lapack_funame << info 
+	      << " off-diagonal  elements  of an intermediate tridiagonal form did not converge to zero\n";
+    throw Error::Math();
+  }
+
+  if(info <= 2 * a.size() ){
+    std::cerr << funame << lapack_funame << " the leading minor of order " << info - a.size()
+	      << " of B is not positively definite\n";
+    throw Error::Range();
+  }
+
+  std::cerr << funame << lapack_funame <<  "unknown error\n";
+  throw Error::Run();
+}
+
+template <>
+Lapack::Vector Lapack::diagonalize<double> (const SymmetricMatrix& a0, const SymmetricMatrix& b0, Matrix* evec) 
 {
-  const char funame [] = "Lapack::diagonalize: ";
-  const char lapack_funame [] = "DSPGVD: ";
+  return diagonalize(a0, b0, evec);
+}
+
+template <>
+Lapack::Vector Lapack::diagonalize<float> (const SymmetricMatrix& a0, const SymmetricMatrix& b0, Matrix* evec) 
+{
+  const char funame [] = "Lapack::diagonalize<float>: ";
+  const char lapack_funame [] = "SSPGVD: ";
 
   if(!a0.isinit() || !b0.isinit()) {
     std::cerr << funame << "not initialized\n";
@@ -909,30 +1836,36 @@ Lapack::Vector Lapack::diagonalize(SymmetricMatrix a0, SymmetricMatrix b0, Matri
     throw Error::Range();
   }
 
-  SymmetricMatrix a = a0.copy();
-  SymmetricMatrix b = b0.copy();
-  Vector res(a.size());
+  const int_t n = a0.size();
+  const long packed_size = (long)n * (n + 1) / 2;
+
+  // single precision copies
+  std::vector<float> a(packed_size), b(packed_size);
+  const double* ap = a0;
+  const double* bp = b0;
+  for(long i = 0; i < packed_size; ++i) {
+    a[i] = ap[i];
+    b[i] = bp[i];
+  }
+
+  std::vector<float> w(n);
+  std::vector<float> z;
 
   char job = 'N';
-  int_t lwork = 2 * a.size();
+  int_t lwork = 2 * n;
   int_t liwork = 1;
-  double* z = 0;
   if(evec) {
-    evec->resize(a.size());
-    z = *evec;
+    z.resize((long)n * n);
     job = 'V';
-    lwork = 1 + 6 * a.size() + 2 * a.size() * a.size();
-    liwork = 3 + 5 * a.size();
+    lwork = 1 + 6 * n + 2 * n * n;
+    liwork = 3 + 5 * n;
   }
 
-  Array<double> work(lwork);
+  std::vector<float> work(lwork);
   Array<int_t> iwork(liwork);
   int_t info = 0;
 
-  dspgvd_(1, job, 'U', a.size(), a, b , res, z, a.size(), work, lwork, iwork, liwork, info);
-
-  if(!info)
-    return res;
+  sspgvd_(1, job, 'U', n, &a[0], &b[0], &w[0], evec ? &z[0] : 0, n, &work[0], lwork, iwork, liwork, info);
 
   if(info < 0) {
     std::cerr << funame << lapack_funame << -info 
@@ -940,20 +1873,35 @@ Lapack::Vector Lapack::diagonalize(SymmetricMatrix a0, SymmetricMatrix b0, Matri
     throw Error::Range();
   }
 
-  if(info <= a.size() ){
+  if(info && info <= n) {
     std::cerr << funame << lapack_funame << info 
 	      << " off-diagonal  elements  of an intermediate tridiagonal form did not converge to zero\n";
     throw Error::Math();
   }
 
-  if(info <= 2 * a.size() ){
-    std::cerr << funame << lapack_funame << " the leading minor of order " << info - a.size()
+  if(info && info <= 2 * n) {
+    std::cerr << funame << lapack_funame << " the leading minor of order " << info - n
 	      << " of B is not positively definite\n";
     throw Error::Range();
   }
 
-  std::cerr << funame << lapack_funame <<  "unknown error\n";
-  throw Error::Run();
+  if(info) {
+    std::cerr << funame << lapack_funame <<  "unknown error\n";
+    throw Error::Run();
+  }
+
+  Vector res(n);
+  for(int_t i = 0; i < n; ++i)
+    res[i] = w[i];
+
+  if(evec) {
+    evec->resize(n);
+    double* p = *evec;
+    for(long i = 0; i < (long)n * n; ++i)
+      p[i] = z[i];
+  }
+
+  return res;
 }
 
 Lapack::Vector Lapack::diagonalize (const HermitianMatrix& a0, const HermitianMatrix& b0, ComplexMatrix* evec) 
@@ -1424,6 +2372,30 @@ Lapack::Cholesky::Cholesky (const SymmetricMatrix& m)
     throw Error::Init();
   }
 
+#ifdef WITH_CUSOLVER
+
+  if(Cusolver::use(size())) {
+    //
+    // full storage, upper triangle
+    Matrix a(size());
+    double* p = *this;
+    for(int_t j = 0; j < size(); ++j)
+      for(int_t i = 0; i <= j; ++i, ++p)
+	a(i, j) = *p;
+
+    Cusolver::cholesky(size(), a);
+
+    // packed factor for the CPU solvers
+    p = *this;
+    for(int_t j = 0; j < size(); ++j)
+      for(int_t i = 0; i <= j; ++i, ++p)
+	*p = a(i, j);
+
+    return;
+  }
+
+#endif
+
   int_t info;
   dpptrf_('U', size(), *this, info);
 
@@ -1540,6 +2512,145 @@ Lapack::Matrix Lapack::Cholesky::invert(const Matrix& m) const
   }
 }
 
+void Lapack::cholesky_batch (int_t size, int_t rhs_size, int_t batch_size, double* mat, double* rhs)
+{
+  const char funame [] = "Lapack::cholesky_batch: ";
+
+  const int_t mat_size = size * (size + 1) / 2;
+  const int_t rhs_step = size * rhs_size;
+
+  int_t fail = 0;
+
+#pragma omp parallel for default(shared) schedule(static)
+
+  for(int_t k = 0; k < batch_size; ++k) {
+    //
+    int_t info;
+
+    dpptrf_('U', size, mat + k * mat_size, info);
+
+    if(!info)
+      dpptrs_('U', size, rhs_size, mat + k * mat_size, rhs + k * rhs_step, size, info);
+
+    if(info) {
+#pragma omp atomic write
+      fail = info;
+    }
+  }
+
+  if(fail < 0) {
+    std::cerr << funame << -fail << "-th argument had an illegal value\n";
+    throw Error::Range();
+  }
+  else if(fail) {
+    std::cerr << funame << "the leading minor of the " << fail << "-th order of one of the matrices is not\n"
+      "\tpositive definite, and the factorization could not be completed.\n";
+    throw Error::Math();
+  }
+}
+
+/****************************************************************
+ *************** Band Cholesky Factorization ********************
+ ****************************************************************/
+
+Lapack::BandCholesky::BandCholesky (const BandMatrix& m) 
+  : BandMatrix(m.copy())
+{
+  const char funame [] = "Lapack::BandCholesky::BandCholesky: ";
+
+  if(!m.isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  int_t info;
+  dpbtrf_('U', size(), band_size() - 1, *this, band_size(), info);
+
+  if(!info)
+    return;
+  else if(info < 0) {
+    std::cerr << funame << "dpbtrf: " << -info 
+	      << "-th argument had an illegal value\n";
+    throw Error::Range();
+  }
+  else {
+    std::cerr << funame << "dpbtrf: the leading minor of the " 
+	      << info <<  "-th order of  A is not\n"
+      "\tpositive definite, and the factorization could not be completed.\n";
+    throw Error::Math();
+  }
+}
+
+Lapack::Vector Lapack::BandCholesky::invert(const Vector& v) const 
+{
+  const char funame [] = "Lapack::BandCholesky::invert: ";
+
+  if(!v.isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(size() != v.size()) {
+    std::cerr << funame << "dimensions are different:"
+	      << " matrix size = " << size()
+	      << " vector size = " << v.size()
+	      << "\n";
+    throw Error::Range();
+  }
+
+  Vector res = v.copy();
+
+  int_t info;
+  dpbtrs_('U', size(), band_size() - 1, 1, *this, band_size(), res, size(), info);
+
+  if(!info)
+    return res;
+  else if(info < 0) {
+    std::cerr << funame << "dpbtrs: " << -info 
+	      << "-th argument had an illegal value\n";
+    throw Error::Range();
+  }
+  else {
+    std::cerr << funame << "dpbtrs: unknown error code "<< info << std::endl;
+    throw Error::Math();
+  }
+}
+
+Lapack::Matrix Lapack::BandCholesky::invert(const Lapack::Matrix& m) const 
+{
+  const char funame [] = "Lapack::BandCholesky::invert: ";
+
+  if(!m.isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(size() != m.size1()) {
+    std::cerr << funame << "dimensions are different:"
+	      << " matrix size = " << size()
+	      << " rigt-hand size = " << m.size1()
+	      << "\n";
+    throw Error::Range();
+  }
+
+  Lapack::Matrix res = m.copy();
+
+  int_t info;
+  dpbtrs_('U', size(), band_size() - 1, res.size2(), *this, band_size(), res, size(), info);
+
+  if(!info)
+    return res;
+  else if(info < 0) {
+    std::cerr << funame << "dpbtrs: " << -info 
+	      << "-th argument had an illegal value\n";
+    throw Error::Range();
+  }
+  else {
+    std::cerr << funame << "dpbtrs: unknown error code "<< info << std::endl;
+    throw Error::Math();
+  }
+}
+
 double Lapack::Cholesky::det_sqrt ()
 {
   if(!size())
@@ -1693,16 +2804,22 @@ Lapack::ComplexVector Lapack::fourier_transform (const Vector& fun, const MultiI
       continue;
 
     std::vector<int> gv = mi(g);
+    std::vector<double> term(mi.rank());
     double re = 0.;
     double im = 0.;
-    for(int h = 0; h < mi.size(); ++h) {
-      std::vector<int> hv = mi(h);
-      dtemp = 0.;
-      for(int i = 0; i < mi.rank(); ++i)
-	dtemp += double(gv[i] * hv[i]) / (double) mi.size(i);
-      dtemp *= 2. * M_PI;
-      re += std::cos(dtemp) * fun[h];
-      im += std::sin(dtemp) * fun[h];
+    // the innermost dimension spans are contiguous
+    for(MultiIndexConvert::Iterator hit(mi); !hit.end(); hit.next_span()) {
+      for(int i = 1; i < mi.rank(); ++i)
+	term[i] = double(gv[i] * hit[i]) / (double) mi.size(i);
+      const int_t h0 = hit.linear();
+      for(int k = 0; k < hit.span(); ++k) {
+	dtemp = double(gv[0] * k) / (double) mi.size(0);
+	for(int i = 1; i < mi.rank(); ++i)
+	  dtemp += term[i];
+	dtemp *= 2. * M_PI;
+	re += std::cos(dtemp) * fun[h0 + k];
+	im += std::sin(dtemp) * fun[h0 + k];
+      }
     }
     re /= nfac;
     im /= nfac;
@@ -1748,14 +2865,20 @@ Lapack::ComplexVector Lapack::fourier_transform (const ComplexVector& fun, const
     int itemp;
 
     std::vector<int> gv = mi(g);
+    std::vector<double> term(mi.rank());
     complex cval = 0.;
-    for(int h = 0; h < mi.size(); ++h) {
-      std::vector<int> hv = mi(h);
-      dtemp = 0.;
-      for(int i = 0; i < mi.rank(); ++i)
-	dtemp += double(gv[i] * hv[i]) / (double) mi.size(i);
-      dtemp *= 2. * M_PI;
-      cval += complex(std::cos(dtemp), std::sin(dtemp)) * fun[h];
+    // the innermost dimension spans are contiguous
+    for(MultiIndexConvert::Iterator hit(mi); !hit.end(); hit.next_span()) {
+      for(int i = 1; i < mi.rank(); ++i)
+	term[i] = double(gv[i] * hit[i]) / (double) mi.size(i);
+      const int_t h0 = hit.linear();
+      for(int k = 0; k < hit.span(); ++k) {
+	dtemp = double(gv[0] * k) / (double) mi.size(0);
+	for(int i = 1; i < mi.rank(); ++i)
+	  dtemp += term[i];
+	dtemp *= 2. * M_PI;
+	cval += complex(std::cos(dtemp), std::sin(dtemp)) * fun[h0 + k];
+      }
     }
     res[g] = cval;
   }
@@ -2083,6 +3206,103 @@ Lapack::Vector Lapack::svd_solve(Matrix a, Vector b, double* residue, double pre
   return b;
 }
 
+Lapack::Matrix Lapack::svd_solve(Matrix a, Matrix b, double prec)
+{
+  const char funame [] = "Lapack::svd_solve: ";
+
+  static const double default_prec = 1.e-12;
+
+  if(a.size1() < a.size2()) {
+    //
+    std::cerr << funame << "number of equations, " << a.size1() << ", should be no less than the number of variables, " << a.size2() << "\n";
+
+    throw Error::Range();
+  }
+  
+  if(b.size1() != a.size1()) {
+    //
+    std::cerr << funame << "right-hand side matrix size, " << b.size1()
+	      << ", differs from the number of equations, " << a.size1() << "\n";
+
+    throw Error::Range();
+  }
+
+  if(prec < 0.)
+    //
+    prec = default_prec;
+  
+  // make a copy
+  //
+  a = a.copy();
+  
+  b = b.copy();
+
+  Vector sv(a.size2());
+  int_t rank, lwork, info;
+
+  lwork = -1;
+  Array<double> work(1);
+  Array<int_t> iwork(1);
+
+  dgelsd_(a.size1(), a.size2(), b.size2(), a, a.size1(), b, b.size1(), sv, prec, rank, work, lwork, iwork, info);        
+
+  if(info) {
+    //
+    std::cerr << funame << "dgelsd(lwork=-1) failed with info = " << info;
+
+    throw Error::Run();
+  }
+  
+  int_t liwork = iwork[0];
+  
+  if(liwork <= 0) {
+    //
+    std::cerr << funame << "dgelsd(lwork=-1) failed: liwork = " << liwork << "\n";
+
+    throw Error::Run();
+  }
+  
+  lwork = (int_t)work[0];
+
+  if(lwork <= 0) {
+    //
+    std::cerr << funame << "dgelsd(lwork=-1) failed: new lwork = " << lwork << "\n";
+
+    throw Error::Run();
+  }
+  
+  work.resize(lwork);
+  iwork.resize(liwork);
+
+  dgelsd_(a.size1(), a.size2(), b.size2(), a, a.size1(), b, b.size1(), sv, prec, rank, work, lwork, iwork, info);        
+
+  if(info) {
+    //
+    std::cerr << funame << "dgelsd failed with info = " << info;
+
+    throw Error::Run();
+  }
+
+  if(rank < a.size2()) {
+    //
+    std::cerr << funame << "matrix rank, " << rank << ", is less than the number of coefficients, " << a.size2() << "\n";
+
+    throw Error::Run();
+  }
+
+  // the solutions are in the upper rows
+  //
+  Matrix res(a.size2(), b.size2());
+
+  for(int j = 0; j < b.size2(); ++j)
+    //
+    for(int i = 0; i < a.size2(); ++i)
+      //
+      res(i, j) = b(i, j);
+  
+  return res;
+}
+
 // null space of a non-degenerate matrix
 //
 Lapack::Matrix Lapack::Matrix::kernel () const
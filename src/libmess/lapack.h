@@ -24,6 +24,11 @@ extern "C" {
 	      double* work, const Lapack::int_t& lwork, Lapack::int_t* iwork, const Lapack::int_t& liwork, 
 	      Lapack::int_t& info);
 
+  int sspgvd_(const Lapack::int_t& itype, const char& job, const char& uplo, const Lapack::int_t& n, 
+	      float* a, float* b, float* w, float* z, const Lapack::int_t& ldz, 
+	      float* work, const Lapack::int_t& lwork, Lapack::int_t* iwork, const Lapack::int_t& liwork, 
+	      Lapack::int_t& info);
+
   // simultaneous diagonalization of two hermitian matrices, B should be positively defined
   //
   int zhpgvd_(const Lapack::int_t& itype, // calculation type: 1 - A * x = lamda * B * x; 2 - A * B * x = lamda * x; 3 - B * A * x = lamda * x
@@ -70,6 +75,20 @@ extern "C" {
   int dsyev_(const char& jobz, const char& uplo, const Lapack::int_t& n, double* a, const Lapack::int_t& lda, 
 	     double* w, double* work, const Lapack::int_t& lwork, Lapack::int_t& info);
 
+  // selected eigenvalues and eigenvectors (MRRR algorithm)
+  //
+  int dsyevr_(const char& jobz, const char& range, const char& uplo, const Lapack::int_t& n, double* a,
+	      const Lapack::int_t& lda, const double& vl, const double& vu, const Lapack::int_t& il,
+	      const Lapack::int_t& iu, const double& abstol, Lapack::int_t& m, double* w, double* z,
+	      const Lapack::int_t& ldz, Lapack::int_t* isuppz, double* work, const Lapack::int_t& lwork,
+	      Lapack::int_t* iwork, const Lapack::int_t& liwork, Lapack::int_t& info);
+
+  int dpbtrf_(const char& uplo, const Lapack::int_t& n, const Lapack::int_t& kd, double* ab,
+	      const Lapack::int_t& ldab, Lapack::int_t& info);
+
+  int dpbtrs_(const char& uplo, const Lapack::int_t& n, const Lapack::int_t& kd, const Lapack::int_t& nrhs,
+	      const double* ab, const Lapack::int_t& ldab, double* b, const Lapack::int_t& ldb, Lapack::int_t& info);
+
   int dspsv_(const char& uplo, const Lapack::int_t& n, const Lapack::int_t& nrhs, double* ap,
 	     Lapack::int_t* ipiv, double* b, const Lapack::int_t& ldb, Lapack::int_t& info);
 
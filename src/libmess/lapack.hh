@@ -21,6 +21,7 @@
 #include "multindex.hh"
 
 #include <complex>
+#include <cmath>
 #include <map>
 
 namespace Lapack {
@@ -32,6 +33,80 @@ namespace Lapack {
   class Matrix; // general matrix
   class SymmetricMatrix;// packed symmetric matrix
 
+  /****************************************************************
+   ******************** Unchecked Element Access ******************
+   ****************************************************************/
+
+  // raw element access for the inner loops: the container is checked once when
+  // the view is created, the element index only in the debug build; the view
+  // does not hold a reference and is invalidated by the container resize
+
+  // m(i, j) = begin[i * step1 + j * step2]
+  //
+  template <typename T>
+  class StridedView {
+    T*    _begin;
+    int_t _step1, _step2;
+
+    // storage range for the debug check
+    const T* _lo;
+    const T* _hi;
+
+  public:
+    StridedView () : _begin(0), _step1(0), _step2(0), _lo(0), _hi(0) {}
+
+    StridedView (T* b, int_t s1, int_t s2, const T* lo, const T* hi) 
+      : _begin(b), _step1(s1), _step2(s2), _lo(lo), _hi(hi) {}
+
+    T& operator() (int_t i, int_t j) const
+    {
+#ifdef DEBUG
+      const T* p = _begin + i * _step1 + j * _step2;
+      if(p < _lo || p >= _hi) {
+	std::cerr << "Lapack::StridedView::operator(): out of range: i = " << i << " j = " << j << std::endl;
+	throw Error::Range();
+      }
+#endif
+      return _begin[i * _step1 + j * _step2];
+    }
+
+    int_t step1 () const { return _step1; }
+    int_t step2 () const { return _step2; }
+
+    operator StridedView<const T> () const { return StridedView<const T>(_begin, _step1, _step2, _lo, _hi); }
+  };
+
+  // packed upper triangle, m(i, j) = begin[i + j * (j + 1) / 2], i <= j; the indices are not swapped
+  //
+  template <typename T>
+  class PackedView {
+    T*    _begin;
+    int_t _size;
+
+  public:
+    PackedView () : _begin(0), _size(0) {}
+
+    PackedView (T* b, int_t s) : _begin(b), _size(s) {}
+
+    T& operator() (int_t i, int_t j) const
+    {
+#ifdef DEBUG
+      if(i < 0 || i > j || j >= _size) {
+	std::cerr << "Lapack::PackedView::operator(): out of range: i = " << i << " j = " << j << std::endl;
+	throw Error::Range();
+      }
+#endif
+      return _begin[i + (long)j * (j + 1) / 2];
+    }
+
+    int_t size () const { return _size; }
+
+    // upper part of the j-th column, j + 1 elements
+    T* column (int_t j) const { return _begin + (long)j * (j + 1) / 2; }
+
+    operator PackedView<const T> () const { return PackedView<const T>(_begin, _size); }
+  };
+
   /****************************************************************
    ************************** Vector ******************************
    ****************************************************************/
@@ -159,9 +234,8 @@ namespace Lapack {
    ****************************************************************/
 
   // Fortran style indexing
+  // matrix dimensions are kept with the data and are shared by all references
   class Matrix : private RefArr<double> {
-    SharedPointer<int_t> _size1;
-    SharedPointer<int_t> _size2;
 
     void _check_dim   (const Matrix&) const ;
     void _check_index (int_t, int_t)  const ;
@@ -173,11 +247,12 @@ namespace Lapack {
     void resize (int_t, int_t) ;
     void resize (int_t s)       { resize(s, s); }
 
-    bool isinit () const { return _size1; }
+    bool isinit () const { return RefArr<double>::isinit(); }
 
     Matrix () {}
     explicit Matrix  (int_t s1)  { resize(s1);     }
     Matrix (int_t s1, int_t s2)  { resize(s1, s2); }
+    explicit Matrix (const SymmetricMatrix&) ; // full storage
 
     operator       double* ()       { return RefArr<double>::operator       double*(); }
     operator const double* () const { return RefArr<double>::operator const double*(); }
@@ -187,6 +262,10 @@ namespace Lapack {
     const double&  operator() (int_t, int_t) const ;
     double&        operator() (int_t, int_t)       ;
 
+    // unchecked element access for the inner loops
+    StridedView<double>       unchecked ()       ;
+    StridedView<const double> unchecked () const ;
+
     int_t size1 () const ;
     int_t size2 () const ;
     int_t size  () const ; // square matrix size
@@ -195,6 +274,16 @@ namespace Lapack {
     Matrix operator* (const Matrix&)          const ;
     Matrix operator* (const SymmetricMatrix&) const ;
 
+    // transpose() * m without the transposed copy
+    Matrix transpose_product (const Matrix&)  const ;
+
+    // upper triangle of transpose() * m for the symmetric product, computed
+    // by column panels without the full-size intermediate
+    SymmetricMatrix symmetric_transpose_product (const Matrix&) const ;
+
+    // *this += factor * a.transpose() * b in place
+    Matrix& add_transpose_product (const Matrix& a, const Matrix& b, double factor = 1.) ;
+
     // matrix-vector multiplication
     Vector operator* (const Vector&) const ;
     Vector operator* (const double*) const ;
@@ -220,6 +309,9 @@ namespace Lapack {
 
     Matrix transpose () const;
 
+    // in-place transposition, seen by all references
+    Matrix& transpose_in_place ();
+
     Matrix  invert ()              const;
     Vector  invert (const Vector&) const;
     Matrix  invert (const Matrix&) const;
@@ -239,8 +331,8 @@ namespace Lapack {
   { 
     const char funame [] = "Lapack::Matrix::size1: ";
 
-    if(_size1) 
-      return *_size1; 
+    if(isinit()) 
+      return extent(0); 
 
     std::cerr << funame << "not initialized\n";
     throw Error::Init();
@@ -251,8 +343,8 @@ namespace Lapack {
   { 
     const char funame [] = "Lapack::Matrix::size2: ";
 
-    if(_size2) 
-      return *_size2; 
+    if(isinit()) 
+      return extent(1); 
 
     std::cerr << funame << "not initialized\n";
     throw Error::Init();
@@ -282,25 +374,19 @@ namespace Lapack {
     if(!s1 || !s2)
       s1 = s2 = 0;
 
-    if(!isinit()) {
-      _size1.init(new int_t(s1));
-      _size2.init(new int_t(s2));
-    }
-    else {
-      *_size1 = s1; 
-      *_size2 = s2;
-    } 
-
     RefArr<double>::resize(s1 * s2);
+
+    set_extent(0, s1);
+    set_extent(1, s2);
   }
 
   // copy constructor by value
   inline Matrix::Matrix (const Matrix& m, int_t)
   {
     if(m.isinit()) {
-      _size1.init(new int_t(m.size1())); 
-      _size2.init(new int_t(m.size2()));
       RefArr<double>::operator=(m.RefArr<double>::copy());
+      set_extent(0, m.size1());
+      set_extent(1, m.size2());
     }
   }
 
@@ -331,6 +417,24 @@ namespace Lapack {
     return RefArr<double>::operator[](i1 + size1() * i2);
   }
 
+  inline StridedView<double> Matrix::unchecked () 
+  {
+    const char funame [] = "Lapack::Matrix::unchecked: ";
+
+    if(!isinit()) {
+      std::cerr << funame << "not initialized\n";
+      throw Error::Init();
+    }
+
+    double* p = *this;
+    return StridedView<double>(p, 1, size1(), p, p + size1() * size2());
+  }
+
+  inline StridedView<const double> Matrix::unchecked () const 
+  {
+    return const_cast<Matrix*>(this)->unchecked();
+  }
+
   inline void Matrix::_check_dim (const Matrix& m) const 
   {
     const char funame [] = "Lapack::Matrix::_check_dim: ";
@@ -456,13 +560,14 @@ namespace Lapack {
 
   // packed symmetric matrix with upper triangle reference
   class SymmetricMatrix : private RefArr<double> {
-    SharedPointer<int_t> _size;
     explicit SymmetricMatrix (const SymmetricMatrix&, int_t); // copy constructor by value
 
+    Vector _partial_eigenvalues (char, double, double, int_t, int_t, Matrix*) const ;
+
   public:
     void resize (int_t) ;
 
-    bool isinit () const { return _size; }
+    bool isinit () const { return RefArr<double>::isinit(); }
 
     SymmetricMatrix () {}
     explicit SymmetricMatrix (int_t s)  { resize(s); }
@@ -479,6 +584,10 @@ namespace Lapack {
     const double& operator() (int_t, int_t) const ;
     double&       operator() (int_t, int_t)       ;
 
+    // unchecked upper triangle access for the inner loops
+    PackedView<double>       unchecked ()       ;
+    PackedView<const double> unchecked () const ;
+
     Vector operator* (const Vector&)      const;
     Vector operator* (const double*)      const;
     Vector operator* (ConstSlice<double>) const;
@@ -492,6 +601,9 @@ namespace Lapack {
     SymmetricMatrix operator+= (const SymmetricMatrix&) ;
     SymmetricMatrix operator-= (const SymmetricMatrix&) ;
 
+    // *this += factor * upper triangle of a.transpose() * b, the product assumed to be symmetric
+    SymmetricMatrix& add_transpose_product (const Matrix& a, const Matrix& b, double factor = 1.) ;
+
     SymmetricMatrix operator-  ()      ;
     SymmetricMatrix operator=  (double);
     SymmetricMatrix operator+= (double);
@@ -501,6 +613,25 @@ namespace Lapack {
 
     Vector    eigenvalues (Matrix* =0) const ;
 
+    // eigenpairs in double precision refined by the iterations with the residuals
+    // accumulated in the double-double arithmetic (Ogita and Aishima)
+    Vector refined_eigenvalues (Matrix* =0) const ;
+
+    // partial spectrum on the full storage (dsyevr): the lowest eigenvalues or the ones in the interval
+    Vector lowest_eigenvalues   (int_t, Matrix* =0)          const ;
+    Vector interval_eigenvalues (double, double, Matrix* =0) const ;
+
+    // lowest eigenpairs by the shift-invert subspace iteration from the starting subspace (its
+    // columns), which should be close to the lowest eigenvectors subspace and may be wider than
+    // the number of the eigenpairs requested; the matrix shifted up by a positive constant
+    // should be positively defined; throws Error::Math if not converged
+    Vector subspace_eigenvalues (int_t, const Matrix& start, double shift, Matrix* =0) const ;
+
+    // lowest eigenpairs by the Rayleigh-Ritz projection onto the span of the basis columns, the
+    // nearly linearly dependent ones being dropped; not initialized if any residual norm relative
+    // to the largest requested Ritz value exceeds the tolerance
+    Vector projected_eigenvalues (int_t, const Matrix& basis, double tol, Matrix* =0) const ;
+
     SymmetricMatrix invert ()             const ;
     SymmetricMatrix positive_invert ()    const ;
   };
@@ -519,20 +650,17 @@ namespace Lapack {
       throw Error::Range();
     }
 
-    if(!_size)
-      _size.init(new int_t(s));
-    else
-      *_size = s;
-    
     RefArr<double>::resize(s*(s+1)/2);
+
+    set_extent(0, s);
   }
 
   inline int_t SymmetricMatrix::size () const 
   { 
     const char funame [] = "Lapack::SymmetricMatrix::size: ";
 
-    if(_size) 
-      return *_size; 
+    if(isinit()) 
+      return extent(0); 
 
     std::cerr << funame << "not initialized\n";
     throw Error::Init();
@@ -542,8 +670,8 @@ namespace Lapack {
   inline SymmetricMatrix::SymmetricMatrix (const SymmetricMatrix& m, int_t)
   {
     if(m.isinit()) {
-      _size.init(new int_t(m.size()));
       RefArr<double>::operator=(m.RefArr<double>::copy());
+      set_extent(0, m.size());
     }
   }
 
@@ -568,6 +696,23 @@ namespace Lapack {
     return RefArr<double>::operator[](i1 + i2 * (i2 + 1) / 2);
   }
 
+  inline PackedView<double> SymmetricMatrix::unchecked () 
+  {
+    const char funame [] = "Lapack::SymmetricMatrix::unchecked: ";
+
+    if(!isinit()) {
+      std::cerr << funame << "not initialized\n";
+      throw Error::Init();
+    }
+
+    return PackedView<double>(*this, size());
+  }
+
+  inline PackedView<const double> SymmetricMatrix::unchecked () const 
+  {
+    return const_cast<SymmetricMatrix*>(this)->unchecked();
+  }
+
   inline const double& SymmetricMatrix::operator() (int_t i1, int_t i2) const 
   {
     const char funame [] = "Lapack::SymmetricMatrix::operator(): ";
@@ -743,10 +888,20 @@ namespace Lapack {
   //
   Vector diagonalize(SymmetricMatrix, SymmetricMatrix, Matrix* = 0) ;
 
+  // Generalized eigenvalue problem solved in the working precision (float or double),
+  // the matrices and the results being stored in double precision
+  //
+  template <typename T> Vector diagonalize (const SymmetricMatrix&, const SymmetricMatrix&, Matrix* = 0) ;
+
+  template <> Vector diagonalize<double> (const SymmetricMatrix&, const SymmetricMatrix&, Matrix*) ;
+  template <> Vector diagonalize<float>  (const SymmetricMatrix&, const SymmetricMatrix&, Matrix*) ;
+
   /****************************************************************
    ******************* Band Symmetric Matrix **********************
    ****************************************************************/
 
+  class BandCholesky;
+
   class BandMatrix : private Matrix {
     void _check_size () const ;
 
@@ -767,11 +922,41 @@ namespace Lapack {
     double  operator() (int_t, int_t) const;
     double& operator() (int_t, int_t) ;
 
+    // unchecked access inside the upper band, i <= j < i + band_size()
+    StridedView<double>       unchecked ()       ;
+    StridedView<const double> unchecked () const ;
+
     BandMatrix& operator= (double d) { Matrix::operator=(d); return *this; }
 
+    // upper band storage
+    operator       double* ()       { return Matrix::operator       double*(); }
+    operator const double* () const { return Matrix::operator const double*(); }
+
+    Vector operator* (const Vector&) const ;
+
     Vector eigenvalues (Matrix* =0) const ;
+
+    // lowest eigenvalues by the shift-invert Lanczos method; the Cholesky
+    // factorization of the matrix shifted up by a positive constant is supplied;
+    // the optional starting vector should be close to the lowest eigenvectors subspace
+    Vector lowest_eigenvalues (int_t, const BandCholesky&, Matrix* =0, const double* =0) const ;
   };
 
+  // m(i, j) = s(band_size() - 1 + i - j, j)
+  //
+  inline StridedView<double> BandMatrix::unchecked () 
+  {
+    StridedView<double> s = Matrix::unchecked();
+    double* p = &s(0, 0);
+
+    return StridedView<double>(p + band_size() - 1, 1, band_size() - 1, p, p + band_size() * size());
+  }
+
+  inline StridedView<const double> BandMatrix::unchecked () const 
+  {
+    return const_cast<BandMatrix*>(this)->unchecked();
+  }
+
   inline void BandMatrix::_check_size () const 
   {
     const char funame [] = "Lapack::BandMatrix::_check_size(): ";
@@ -783,6 +968,71 @@ namespace Lapack {
     throw Error::Range();
   }
 
+  /****************************************************************
+   ********************* General Band Matrix **********************
+   ****************************************************************/
+
+  // nonsymmetric matrix with equal numbers of sub- and super-diagonals
+  // in the general band storage: m(i, j) = s(band_size() - 1 + i - j, j)
+  //
+  class GeneralBandMatrix : private Matrix {
+    void _check_size () const ;
+
+    GeneralBandMatrix (const GeneralBandMatrix& m, int_t) : Matrix(m, 0) { } // copy construction by value
+
+  public:
+    GeneralBandMatrix () {}
+    GeneralBandMatrix   (int_t s, int_t b)  : Matrix(2 * b - 1, s) { _check_size(); }
+    void  resize (int_t s, int_t b) { Matrix::resize(2 * b - 1, s); _check_size(); }
+
+    bool isinit () const { return Matrix::isinit(); }
+
+    GeneralBandMatrix copy () const { return GeneralBandMatrix(*this, 0); }
+
+    int_t size      () const  { return size2(); }
+    int_t band_size () const  { return (size1() + 1) / 2; }
+
+    double  operator() (int_t, int_t) const;
+    double& operator() (int_t, int_t) ;
+
+    // unchecked access inside the band, |i - j| < band_size()
+    StridedView<double>       unchecked ()       ;
+    StridedView<const double> unchecked () const ;
+
+    GeneralBandMatrix& operator=  (double d) { Matrix::operator=(d); return *this; }
+    GeneralBandMatrix& operator+= (const GeneralBandMatrix& m) { Matrix::operator+=(m); return *this; }
+
+    operator       double* ()       { return Matrix::operator       double*(); }
+    operator const double* () const { return Matrix::operator const double*(); }
+
+    Vector operator* (const Vector&) const ;
+    Matrix operator* (const Matrix&) const ;
+  };
+
+  inline StridedView<double> GeneralBandMatrix::unchecked () 
+  {
+    StridedView<double> s = Matrix::unchecked();
+    double* p = &s(0, 0);
+
+    return StridedView<double>(p + band_size() - 1, 1, size1() - 1, p, p + size1() * size());
+  }
+
+  inline StridedView<const double> GeneralBandMatrix::unchecked () const 
+  {
+    return const_cast<GeneralBandMatrix*>(this)->unchecked();
+  }
+
+  inline void GeneralBandMatrix::_check_size () const 
+  {
+    const char funame [] = "Lapack::GeneralBandMatrix::_check_size(): ";
+    
+    if(band_size() <= size())
+      return;
+
+    std::cerr << funame << "band size bigger than the matrix size\n";
+    throw Error::Range();
+  }
+
   /****************************************************************
    ********************** LU Factorization ************************
    ****************************************************************/
@@ -837,6 +1087,166 @@ namespace Lapack {
     double det_sqrt ();
   };
 
+  // Cholesky solution of a batch of positively defined systems of the same size: the
+  // packed (upper triangle) matrices and the right hand sides are stored one after another
+  // and are overwritten by the factors and the solutions; the batch is shared between threads
+  void cholesky_batch (int_t size, int_t rhs_size, int_t batch_size, double* mat, double* rhs) ;
+
+  // Cholesky factorization of the small positively defined matrix done inline in the local
+  // storage: the LAPACK call overhead dominates at these sizes; the packed upper triangle factor
+  //
+  class SmallCholesky {
+    //
+  public:
+    //
+    enum { DIM_MAX = 8 };
+
+  private:
+    //
+    int    _size;
+    double _fac [DIM_MAX * (DIM_MAX + 1) / 2];
+
+    double&       _u (int i, int j)       { return _fac[i + j * (j + 1) / 2]; }
+    const double& _u (int i, int j) const { return _fac[i + j * (j + 1) / 2]; }
+
+    void _factorize ();
+
+  public:
+    //
+    explicit SmallCholesky (const SymmetricMatrix&) ;
+
+    int size () const { return _size; }
+
+    double det_sqrt () const;
+
+    SymmetricMatrix invert () const;
+  };
+
+  inline SmallCholesky::SmallCholesky (const SymmetricMatrix& m) 
+  {
+    const char funame [] = "Lapack::SmallCholesky::SmallCholesky: ";
+
+    if(!m.isinit() || m.size() > DIM_MAX) {
+      std::cerr << funame << "not initialized or too large: " << (m.isinit() ? m.size() : 0) << "\n";
+      throw Error::Range();
+    }
+
+    _size = m.size();
+
+    const double* p = m;
+    for(int i = 0; i < _size * (_size + 1) / 2; ++i)
+      _fac[i] = p[i];
+
+    _factorize();
+  }
+
+  inline void SmallCholesky::_factorize ()
+  {
+    const char funame [] = "Lapack::SmallCholesky::_factorize: ";
+
+    double dtemp;
+
+    for(int j = 0; j < _size; ++j) {
+      //
+      for(int i = 0; i < j; ++i) {
+	//
+	dtemp = _u(i, j);
+
+	for(int k = 0; k < i; ++k)
+	  dtemp -= _u(k, i) * _u(k, j);
+
+	_u(i, j) = dtemp / _u(i, i);
+      }
+
+      dtemp = _u(j, j);
+
+      for(int k = 0; k < j; ++k)
+	dtemp -= _u(k, j) * _u(k, j);
+
+      if(dtemp <= 0.) {
+	std::cerr << funame << "the leading minor of order " << j + 1 << " is not positive definite\n";
+	throw Error::Math();
+      }
+
+      _u(j, j) = std::sqrt(dtemp);
+    }
+  }
+
+  inline double SmallCholesky::det_sqrt () const
+  {
+    double res = 1.;
+
+    for(int j = 0; j < _size; ++j)
+      res *= _u(j, j);
+
+    return res;
+  }
+
+  // A^-1 = U^-1 U^-T
+  //
+  inline SymmetricMatrix SmallCholesky::invert () const
+  {
+    double dtemp;
+
+    // inverse factor, packed upper triangle
+    double v [DIM_MAX * (DIM_MAX + 1) / 2];
+
+    for(int j = 0; j < _size; ++j) {
+      //
+      v[j + j * (j + 1) / 2] = 1. / _u(j, j);
+
+      for(int i = j - 1; i >= 0; --i) {
+	//
+	dtemp = 0.;
+
+	for(int k = i + 1; k <= j; ++k)
+	  dtemp += _u(i, k) * v[k + j * (j + 1) / 2];
+
+	v[i + j * (j + 1) / 2] = -dtemp / _u(i, i);
+      }
+    }
+
+    SymmetricMatrix res(_size);
+
+    for(int j = 0; j < _size; ++j)
+      for(int i = 0; i <= j; ++i) {
+	//
+	dtemp = 0.;
+
+	for(int k = j; k < _size; ++k)
+	  dtemp += v[i + k * (k + 1) / 2] * v[j + k * (k + 1) / 2];
+
+	res(i, j) = dtemp;
+      }
+
+    return res;
+  }
+
+  // square root of the positively defined matrix determinant
+  //
+  inline double det_sqrt (const SymmetricMatrix& m)
+  {
+    if(m.size() <= SmallCholesky::DIM_MAX)
+      return SmallCholesky(m).det_sqrt();
+
+    return Cholesky(m).det_sqrt();
+  }
+
+  /****************************************************************
+   *************** Band Cholesky Factorization ********************
+   ****************************************************************/
+
+  class BandCholesky : private BandMatrix {
+
+  public:
+    BandCholesky () {}
+    explicit BandCholesky (const BandMatrix&) ;
+    int_t size () const { return BandMatrix::size(); }
+
+    Vector invert (const Vector&) const ; // solve linear equations
+    Lapack::Matrix invert (const Lapack::Matrix&) const ; // solve linear equations
+  };
+
   /****************************************************************
    ************************ Complex Matrix ************************
    ****************************************************************/
@@ -1011,6 +1421,10 @@ namespace Lapack {
   //
   Vector svd_solve (Matrix a, Vector b, double* residue = 0,double pres = -1., double (*weight)(double) = 0);
 
+  // least squares solution for a batch of right-hand sides (columns of b) by one svd-decomposition
+  //
+  Matrix svd_solve (Matrix a, Matrix b, double pres = -1.);
+
   // singular value decomposition, A = U * S * V**T
   //
   void svd (Matrix a, Vector s, Matrix u, Matrix v);
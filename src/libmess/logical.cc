@@ -34,6 +34,34 @@ bool Logical::BinExpr::evaluate (const std::vector<bool>& l) const
   }
 }
 
+// the second operand is skipped if the first one decides the result
+void Logical::BinExpr::compile (std::vector<Instr>& code) const
+{
+  const char funame [] = "Logical::BinExpr::compile: ";
+
+  _x1->compile(code);
+
+  Instr jump;
+  switch(_op) {
+  case OR:
+    jump.op = Instr::JUMP_TRUE;
+    break;
+  case AND:
+    jump.op = Instr::JUMP_FALSE;
+    break;
+  default:
+    std::cerr << funame << "unknown operation " << _op << "\n";
+    throw Error::Range();
+  }
+
+  const int pos = code.size();
+  code.push_back(jump);
+
+  _x2->compile(code);
+
+  code[pos].arg = code.size();
+}
+
 void Logical::VarExpr::init (const std::map<std::string, int>& l) 
 {
   const char funame [] = "Logical::VarExpr::init: ";
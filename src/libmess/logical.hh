@@ -25,6 +25,13 @@
 
 namespace Logical 
 {
+  // instruction of the flat evaluation program
+  struct Instr {
+    enum Op {VAR, NOT, JUMP_FALSE, JUMP_TRUE};
+    Op  op;
+    int arg; // variable index or jump target
+  };
+
   class Expr 
   {
   public:
@@ -32,6 +39,9 @@ namespace Logical
        = 0;
     virtual void init (const std::map<std::string, int>&)
        = 0;
+    // append the expression evaluation instructions; should be called after init
+    virtual void compile (std::vector<Instr>&) const
+       = 0;
   };
 
   SharedPointer<Expr> read_expr (std::istream& from) ;
@@ -52,6 +62,9 @@ namespace Logical
     void init (const std::map<std::string, int>& l)
        { _x->init(l); }
 
+    void compile (std::vector<Instr>& code) const
+    { _x->compile(code); Instr i = {Instr::NOT, 0}; code.push_back(i); }
+
     friend SharedPointer<Expr> negate (SharedPointer<Expr>);
   };
 
@@ -78,6 +91,8 @@ namespace Logical
     void init (const std::map<std::string, int>& l)
        { _x1->init(l); _x2->init(l); }
 
+    void compile (std::vector<Instr>&) const;
+
     friend SharedPointer<Expr> operator& (SharedPointer<Expr>, SharedPointer<Expr>); 
     friend SharedPointer<Expr> operator| (SharedPointer<Expr>, SharedPointer<Expr>); 
   };
@@ -101,6 +116,9 @@ namespace Logical
       ;
     void init (const std::map<std::string, int>&)
       ;
+
+    void compile (std::vector<Instr>& code) const
+    { Instr i = {Instr::VAR, _var}; code.push_back(i); }
   };
 
   inline bool VarExpr::evaluate (const std::vector<bool>& l) const 
@@ -121,6 +139,65 @@ namespace Logical
     return l[_var]; 
   }
 
+  /*************************************************************************
+   * expression compiled into a flat program with short-circuit jumps      *
+   *************************************************************************/
+
+  class Program
+  {
+    std::vector<Instr> _code;
+
+    struct _List {
+      const std::vector<bool>& l;
+      bool operator() (int i) const { return l[i]; }
+    };
+
+  public:
+    Program () {}
+    explicit Program (const Expr& x) { x.compile(_code); }
+
+    // var(index) is called only for the variables the result depends on
+    template <typename V>
+    bool lazy_evaluate (V& var) const;
+
+    bool evaluate (const std::vector<bool>& l) const;
+  };
+
+  template <typename V>
+  bool Program::lazy_evaluate (V& var) const
+  {
+    bool acc = false;
+
+    for(int pc = 0; pc < _code.size(); ++pc) {
+      const Instr& i = _code[pc];
+
+      switch(i.op) {
+      case Instr::VAR:
+	acc = var(i.arg);
+	break;
+      case Instr::NOT:
+	acc = !acc;
+	break;
+      case Instr::JUMP_FALSE:
+	if(!acc)
+	  pc = i.arg - 1;
+	break;
+      case Instr::JUMP_TRUE:
+	if(acc)
+	  pc = i.arg - 1;
+	break;
+      }
+    }
+
+    return acc;
+  }
+
+  inline bool Program::evaluate (const std::vector<bool>& l) const
+  {
+    _List var = {l};
+    return lazy_evaluate(var);
+  }
+
 }// Logical
 
 #endif
@@ -17,10 +17,18 @@
 #include "multindex.hh"
 #include "read.hh"
 #include "slatec.hh"
+#include "random.hh"
 
 #include<map>
 #include<vector>
 #include<cmath>
+#include<algorithm>
+#include<exception>
+#include<functional>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace LongRange {
 
@@ -43,6 +51,33 @@ namespace LongRange {
   int  angular_grid_size () { return _angl_grid_size; }
   void set_angular_grid (int g) { _angl_grid_size = g; }
 
+  // quasi-random (Sobol) angular sampling size, the product grid being used if zero
+  int _angl_smp_size;
+  int  angular_sampling_size () { return _angl_smp_size; }
+  void set_angular_sampling (int s) { _angl_smp_size = s; }
+
+  // number of threads for the orientational integrals
+  int _angl_thread_num;
+  int angular_thread_number () { return _angl_thread_num; }
+
+  // adaptive cubature: relative tolerance, maximal number of nodes, and the last error estimate
+  double _angl_tol;
+  int    _angl_node_max;
+  double _angl_err = 0.;
+  double angular_tolerance () { return _angl_tol; }
+  void   set_angular_tolerance (double t) { _angl_tol = t; }
+  double angular_error () { return _angl_err; }
+
+  void adaptive_integral (const StatesNumberDensity&, const std::vector<double>& dist, const std::vector<double>& ener,
+			  Lapack::Matrix& res, std::vector<double>* mep);
+
+  // potential energies on the fixed orientational nodes keyed on the distance and the nodes
+  // set (grid size, or sampling size if negative), shared by the E, J, M, and K densities
+  typedef std::pair<double, int> GridKey;
+  std::map<GridKey, std::vector<double> > _grid_pot;
+  double _grid_pot_max;  // cache size limit, MB
+  std::vector<double>* grid_potential (double dist, int grid, int size, bool& iscached);
+
 
   // correspondence between <fragment index, angle type> and angle index
   enum ang_t { THETA, PHI, PSI };
@@ -245,6 +280,11 @@ void LongRange::init (std::istream& from)
   std::map<std::string, Read>::iterator idit;
 
   input["AngularGridSize"                 ] = Read(_angl_grid_size,    10);
+  input["AngularSamplingSize"             ] = Read(_angl_smp_size,      0);
+  input["ThreadNumber"                    ] = Read(_angl_thread_num,    1);
+  input["AngularTolerance"                ] = Read(_angl_tol,          0.);
+  input["AngularNodesMaximum"             ] = Read(_angl_node_max, 1000000);
+  input["PotentialCacheSize[MB]"          ] = Read(_grid_pot_max,    256.);
   input["J-IntegralStep[au]"              ] = Read(JIntegral::step,    1.);
   input["M-IntegralStep[au]"              ] = Read(MIntegral::step[0], 1.);
   input["K-IntegralStep[au]"              ] = Read(KIntegral::step,    1.);
@@ -295,6 +335,31 @@ void LongRange::init (std::istream& from)
       std::cout << "   " << std::setw(20) << idit->first << " = " << idit->second << "\n";
   std::cout << std::right << "\n";
 
+  if(_angl_smp_size < 0) {
+    std::cerr << funame << "AngularSamplingSize: should not be negative\n";
+    throw Error::Range();
+  }
+
+  if(_angl_thread_num <= 0) {
+    std::cerr << funame << "ThreadNumber: should be positive\n";
+    throw Error::Range();
+  }
+
+  if(_angl_tol < 0. || _angl_tol >= 1.) {
+    std::cerr << funame << "AngularTolerance: out of range\n";
+    throw Error::Range();
+  }
+
+  if(_angl_node_max <= 0) {
+    std::cerr << funame << "AngularNodesMaximum: should be positive\n";
+    throw Error::Range();
+  }
+
+  if(_grid_pot_max < 0.) {
+    std::cerr << funame << "PotentialCacheSize[MB]: should not be negative\n";
+    throw Error::Range();
+  }
+
   // default M-integral step
   MIntegral::step[1] = MIntegral::step[0];
 
@@ -648,8 +713,11 @@ double LongRange::StatesNumberDensity::_density (const Dynamic::Coordinates& dc,
   if(mep)
     *mep = poten;
 
-  double e = energy() - poten;
+  return _density(energy() - poten, dim);
+}
 
+double LongRange::StatesNumberDensity::_density (double e, int dim) const
+{
   if(e <= 0.)
     return -1.;
   
@@ -678,16 +746,19 @@ LongRange::KDensity::KDensity (double e, const std::vector<double>& m, double k)
 
 double LongRange::KDensity::operator() (const Dynamic::Coordinates& dc, double* mep) const
 {
-  static const char funame [] = "LongRange::KDensity::operator(): ";
-
-  int itemp;
-  double dtemp;
-
   double poten = pot(dc);
   if(mep)
     *mep = poten;
 
-  double e = energy() - poten;
+  return density(dc, energy() - poten);
+}
+
+double LongRange::KDensity::density (const Dynamic::Coordinates& dc, double e) const
+{
+  static const char funame [] = "LongRange::KDensity::density: ";
+
+  int itemp;
+  double dtemp;
 
   double imz = 0.;     // inertia moment projection on the interfragment axis
   double k = _k_proj;
@@ -899,101 +970,626 @@ void LongRange::ang2dc (const std::vector<double>& angle, Dynamic::Coordinates&
   }// fragment cycle
 }
 
+// cached grid potential: zero if it does not fit the cache, allocated and not set if it is
+// not cached yet
+std::vector<double>* LongRange::grid_potential (double dist, int grid, int size, bool& iscached)
+{
+  iscached = false;
+
+  if((double)size * sizeof(double) > _grid_pot_max * 1.e6)
+    return 0;
+
+  const GridKey key(dist, grid);
+
+  std::map<GridKey, std::vector<double> >::iterator cit = _grid_pot.find(key);
+
+  if(cit != _grid_pot.end() && cit->second.size() == size) {
+    iscached = true;
+    return &cit->second;
+  }
+
+  double total = (double)size;
+  for(cit = _grid_pot.begin(); cit != _grid_pot.end(); ++cit)
+    total += (double)cit->second.size();
+
+  if(total * sizeof(double) > _grid_pot_max * 1.e6)
+    _grid_pot.clear();
+
+  std::vector<double>& res = _grid_pot[key];
+  res.resize(size);
+
+  return &res;
+}
+
 // number of states integrator
 double LongRange::StatesNumberDensity::integral (double distance, double* mep) const 
+{
+  Lapack::Matrix res(1, 1);
+  std::vector<double> vmin;
+
+  integral(std::vector<double>(1, distance), std::vector<double>(1, energy()), res, mep ? &vmin : 0);
+
+  if(mep)
+    *mep = vmin[0];
+
+  return res(0, 0);
+}
+
+// number of states on the distance x energy grid: the potential is calculated once for
+// each orientation and distance, the orientation batches are distributed among threads,
+// and the per-thread sums are added in the thread order
+void LongRange::StatesNumberDensity::integral (const std::vector<double>& dist, const std::vector<double>& ener,
+					       Lapack::Matrix& res, std::vector<double>* mep) const 
 {
   static const char funame [] = "LongRange::StatesNumberDensity::integral: ";
 
+  if(angular_tolerance() > 0.) {
+    adaptive_integral(*this, dist, ener, res, mep);
+    return;
+  }
+
+  // the potential energies are calculated in batches of orientations
+  static const int batch_size = 256;
+
   const double theta_step = M_PI / double(angular_grid_size() + 1);
   const double   phi_step = 2. * M_PI / double(angular_grid_size());
 
-  int itemp;
-  double dtemp;
+  const int odim = orientational_dimension();
 
-  int   ang_index;
-  ang_t ang_type;
-  double weight;
-  double rho_val;
-  double poten;
+  // integration nodes: the product grid or the Sobol sequence
+  const bool qmc = angular_sampling_size() > 0;
 
-  std::vector<double> euler_angle(orientational_dimension());
+  MultiIndexConvert multi_grid(std::vector<int>(odim, qmc ? 1 : angular_grid_size()));
+  Random::Sobol sobol(odim > 0 ? odim : 1);
 
-  Dynamic::Coordinates dc;
-  for(int i = 0; i < 2; ++i)
-    dc.orb_pos(i) = 0.;
-  dc.orb_pos(2) = distance;
+  const int node_size   = qmc ? angular_sampling_size() : multi_grid.size();
+  const int batch_count = (node_size + batch_size - 1) / batch_size;
 
-  double res = -1.;
-  MultiIndexConvert multi_grid(std::vector<int>(orientational_dimension(), angular_grid_size()));
-  for(int grid_index = 0; grid_index < multi_grid.size(); ++grid_index) {
- 
-    // set Euler angles and weight
-    weight = 1.;
-    std::vector<int> grid_point = multi_grid(grid_index);
+  // Euler angles and the integration weight of the node
+  auto node = [&] (int index, std::vector<double>& euler_angle) -> double {
+    double weight = 1.;
+    double u [Random::Sobol::MAX_DIM];
+    std::vector<int> grid_point;
+
+    if(qmc)
+      sobol(index + 1, u);
+    else
+      grid_point = multi_grid(index);
 
     for(IndexMapIterator it = index_map.begin(); it != index_map.end(); ++it) {
-      ang_index = it->second;
-      ang_type  = it->first.second;
-      switch(ang_type) {
+      const int ang_index = it->second;
+
+      switch(it->first.second) {
       case THETA:
-	
-	itemp = grid_point[ang_index];
-	dtemp = theta_step * double(itemp + 1); 
 
-	euler_angle[ang_index] = dtemp;
-	weight *= std::sin(dtemp);
+	if(qmc) {
+	  euler_angle[ang_index] = std::acos(1. - 2. * u[ang_index]);
+	}
+	else {
+	  euler_angle[ang_index] = theta_step * double(grid_point[ang_index] + 1);
+	  weight *= std::sin(euler_angle[ang_index]);
+	}
 	break;
 
       default: // PHI and PSI
 
-	euler_angle[ang_index] = phi_step * double(grid_point[ang_index]) ; 
+	if(qmc)
+	  euler_angle[ang_index] = 2. * M_PI * u[ang_index];
+	else
+	  euler_angle[ang_index] = phi_step * double(grid_point[ang_index]);
 	break;
+      }
+    }
+
+    return weight;
+  };
+
+  // normalization
+  double norm = qmc ? 1. / double(node_size) : 1.;
+  for(IndexMapIterator it = index_map.begin(); it != index_map.end(); ++it)
+    switch(it->first.second) {
+    case THETA:
+
+      norm *= qmc ? 2. : theta_step;
+      break;
+
+    default:
+
+      norm *= qmc ? 2. * M_PI : phi_step; 
+      break;
+    }
+
+  norm *= this->norm_factor();
 
+  res.resize(dist.size(), ener.size());
+  if(mep)
+    mep->resize(dist.size());
+
+  const int thread_num = angular_thread_number();
+
+  for(int d = 0; d < dist.size(); ++d) {
+    Dynamic::Coordinates dc0;
+    for(int i = 0; i < 2; ++i)
+      dc0.orb_pos(i) = 0.;
+    dc0.orb_pos(2) = dist[d];
+
+    std::vector<std::vector<double> > sum(thread_num, std::vector<double>(ener.size(), 0.));
+    std::vector<double> vmin(thread_num);
+    std::vector<int>   vinit(thread_num, 0);
+
+    // the potential is calculated once per distance and nodes set
+    bool iscached;
+    std::vector<double>* grid_pot = grid_potential(dist[d], qmc ? -node_size : angular_grid_size(), node_size, iscached);
+
+    std::exception_ptr error;
+
+#pragma omp parallel default(shared) num_threads(thread_num)
+    {
+      int thread = 0;
+#ifdef _OPENMP
+      thread = omp_get_thread_num();
+#endif
+
+      std::vector<Dynamic::Coordinates> dc(batch_size, dc0);
+      std::vector<double> weight(batch_size);
+      std::vector<double> pot_buf(batch_size);
+      std::vector<double> euler_angle(odim);
+
+#pragma omp for schedule(static)
+      for(int batch = 0; batch < batch_count; ++batch) {
+	try {
+	  const int start = batch * batch_size;
+	  const int bsize = std::min(batch_size, node_size - start);
+
+	  for(int b = 0; b < bsize; ++b) {
+	    weight[b] = node(start + b, euler_angle);
+	    ang2dc(euler_angle, dc[b]);
+	  }
+
+	  double* poten = grid_pot ? &(*grid_pot)[start] : &pot_buf[0];
+
+	  if(!iscached)
+	    pot.batch(bsize, &dc[0], poten);
+
+	  for(int b = 0; b < bsize; ++b) {
+	    if(!vinit[thread] || poten[b] < vmin[thread]) {
+	      vinit[thread] = 1;
+	      vmin[thread] = poten[b];
+	    }
+
+	    for(int e = 0; e < ener.size(); ++e) {
+	      const double rho_val = density(dc[b], ener[e] - poten[b]);
+
+	      if(rho_val > 0.)
+		sum[thread][e] += rho_val * weight[b];
+	    }
+	  }
+	}
+	catch(...) {
+#pragma omp critical(lr_integral_error)
+	  if(!error)
+	    error = std::current_exception();
+	}
       }
     }
 
-    // conversion of Euler angles to dynamic coordinates
-    ang2dc(euler_angle, dc);
+    if(error) {
+      if(grid_pot && !iscached)
+	_grid_pot.erase(GridKey(dist[d], qmc ? -node_size : angular_grid_size()));
+
+      std::rethrow_exception(error);
+    }
+
+    for(int e = 0; e < ener.size(); ++e) {
+      double val = 0.;
+      for(int t = 0; t < thread_num; ++t)
+	val += sum[t][e];
+
+      if(val > 0.) {
+	val *= norm;
+	if(dynamic_cast<const EDensity*>(this))
+	  val *= dist[d] * dist[d];
+      }
+      else
+	val = -1.;
+
+      res(d, e) = val;
+    }
 
     if(mep) {
-      rho_val = (*this)(dc, &poten);
-      if(!grid_index || poten < *mep)
-	*mep = poten;
+      int t = 0;
+      for(int i = 1; i < thread_num; ++i)
+	if(vinit[i] && (!vinit[t] || vmin[i] < vmin[t]))
+	  t = i;
+      (*mep)[d] = vmin[t];
     }
-    else
-      rho_val = (*this)(dc);
+  }
+}
+
+/*******************************************************************************************
+ ********************************* Adaptive Orientational Cubature *************************
+ *******************************************************************************************/
+
+namespace LongRange {
+  //
+  // cell of the orientational box: the center, the half-widths, the integrals and their
+  // error estimates on the energy grid
+  //
+  struct AngularCell {
+    std::vector<double> center;
+    std::vector<double> width;
+    std::vector<double> value;
+    std::vector<double> error;
+    int                 split;  // splitting direction
+  };
+
+  // embedded cubature rule on [-1, 1]^n: nodes, higher and lower order weights; the
+  // Genz-Malik degree 7/5 pair for n > 1 and the Gauss-Kronrod 3/7 pair for n = 1
+  //
+  class AngularRule {
+    int _dim;
+
+  public:
+    std::vector<std::vector<double> > node;
+    std::vector<double> weight, lower;
+
+    // nodes on the axes used for the splitting direction: +/- l2 e_i and +/- l3 e_i
+    std::vector<int> axis_node;
+
+    explicit AngularRule (int);
+
+    int dim () const { return _dim; }
+
+    // the fourth difference base direction
+    int split (const std::vector<double>& fval) const;
+  };
+}
+
+LongRange::AngularRule::AngularRule (int n) : _dim(n)
+{
+  static const char funame [] = "LongRange::AngularRule::AngularRule: ";
 
-    // integration
-    if(rho_val > 0.)
-      increment(res, rho_val * weight);
+  if(n <= 0) {
+    std::cerr << funame << "wrong dimension: " << n << "\n";
+    throw Error::Range();
   }
 
-  // normalization
-  if(res > 0.) {
-    for(IndexMapIterator it = index_map.begin(); it != index_map.end(); ++it) {
-      ang_type = it->first.second;
-      switch(ang_type) {
-      case THETA:
-	
-	res *= theta_step;
-	break;
+  std::vector<double> x(n, 0.);
 
-      default:
+  if(n == 1) {
+    static const double knode [] = {0., 0.43424374934680255800, 0.77459666924148337704, 0.96049126870802028342};
+    static const double kwt   [] = {0.45091653865847414235, 0.40139741477596222291, 0.26848808986833344073,
+				    0.10465622602646726519};
+    static const double gwt   [] = {8. / 9., 0., 5. / 9., 0.};
 
-	res *= phi_step; 
-	break;
+    node.push_back(x);
+    weight.push_back(kwt[0] / 2.);
+    lower.push_back(gwt[0] / 2.);
 
+    for(int i = 1; i < 4; ++i)
+      for(int s = -1; s <= 1; s += 2) {
+	x[0] = s * knode[i];
+	node.push_back(x);
+	weight.push_back(kwt[i] / 2.);
+	lower.push_back(gwt[i] / 2.);
       }
+
+    return;
+  }
+
+  const double l2 = std::sqrt(9. / 70.);
+  const double l4 = std::sqrt(9. / 10.);
+  const double l5 = std::sqrt(9. / 19.);
+
+  const double dn = (double)n;
+
+  // center
+  node.push_back(x);
+  weight.push_back((12824. - 9120. * dn + 400. * dn * dn) / 19683.);
+  lower.push_back((729. - 950. * dn + 50. * dn * dn) / 729.);
+
+  // axes
+  for(int i = 0; i < n; ++i)
+    for(int s = -1; s <= 1; s += 2) {
+      x.assign(n, 0.);
+      x[i] = s * l2;
+      axis_node.push_back(node.size());
+      node.push_back(x);
+      weight.push_back(980. / 6561.);
+      lower.push_back(245. / 486.);
+
+      x[i] = s * l4;
+      axis_node.push_back(node.size());
+      node.push_back(x);
+      weight.push_back((1820. - 400. * dn) / 19683.);
+      lower.push_back((265. - 100. * dn) / 1458.);
     }
-    res *= this->norm_factor();
-    if(dynamic_cast<const EDensity*>(this)) {
-      res *= distance * distance;
+
+  // planes
+  for(int i = 0; i < n; ++i)
+    for(int j = i + 1; j < n; ++j)
+      for(int si = -1; si <= 1; si += 2)
+	for(int sj = -1; sj <= 1; sj += 2) {
+	  x.assign(n, 0.);
+	  x[i] = si * l4;
+	  x[j] = sj * l4;
+	  node.push_back(x);
+	  weight.push_back(200. / 19683.);
+	  lower.push_back(25. / 729.);
+	}
+
+  // corners
+  for(int c = 0; c < (1 << n); ++c) {
+    for(int i = 0; i < n; ++i)
+      x[i] = c & (1 << i) ? l5 : -l5;
+    node.push_back(x);
+    weight.push_back(6859. / 19683. / double(1 << n));
+    lower.push_back(0.);
+  }
+}
+
+int LongRange::AngularRule::split (const std::vector<double>& fval) const
+{
+  if(_dim == 1)
+    return 0;
+
+  // (l2 / l4)^2
+  static const double ratio = 1. / 7.;
+
+  int res = 0;
+  double dmax = -1.;
+  for(int i = 0; i < _dim; ++i) {
+    const double* f = &fval[axis_node[4 * i]];
+
+    const double d = std::fabs(f[0] + f[2] - 2. * fval[0] - ratio * (f[1] + f[3] - 2. * fval[0]));
+
+    if(d > dmax) {
+      dmax = d;
+      res  = i;
     }
   }
 
   return res;
 }
 
+// the box cells with the largest error estimates are bisected until the relative error
+// of each of the energy grid integrals is below the tolerance
+void LongRange::adaptive_integral (const StatesNumberDensity& density, const std::vector<double>& dist,
+				   const std::vector<double>& ener, Lapack::Matrix& res, std::vector<double>* mep)
+{
+  static const char funame [] = "LongRange::adaptive_integral: ";
+
+  // the potential energies are calculated in batches of nodes
+  static const int batch_size = 256;
+
+  const int odim = orientational_dimension();
+
+  const AngularRule rule(odim);
+
+  const int rule_size = rule.node.size();
+
+  const int thread_num = angular_thread_number();
+
+  // initial partition: two cells per angle
+  std::vector<double> lower(odim), upper(odim);
+  for(IndexMapIterator it = index_map.begin(); it != index_map.end(); ++it) {
+    lower[it->second] = 0.;
+    upper[it->second] = it->first.second == THETA ? M_PI : 2. * M_PI;
+  }
+
+  res.resize(dist.size(), ener.size());
+  if(mep)
+    mep->resize(dist.size());
+
+  _angl_err = 0.;
+
+  for(int d = 0; d < dist.size(); ++d) {
+    Dynamic::Coordinates dc0;
+    for(int i = 0; i < 2; ++i)
+      dc0.orb_pos(i) = 0.;
+    dc0.orb_pos(2) = dist[d];
+
+    std::vector<AngularCell> cell, fresh(1 << odim);
+
+    for(int c = 0; c < fresh.size(); ++c) {
+      fresh[c].center.resize(odim);
+      fresh[c].width.resize(odim);
+      for(int i = 0; i < odim; ++i) {
+	fresh[c].width[i]  = (upper[i] - lower[i]) / 4.;
+	fresh[c].center[i] = lower[i] + (c & (1 << i) ? 3. : 1.) * fresh[c].width[i];
+      }
+    }
+
+    std::vector<double> total(ener.size()), error(ener.size());
+
+    double vmin = 0.;
+    bool  vinit = false;
+    int node_count = 0;
+
+    while(1) {
+      // cells evaluation
+      const int node_size   = fresh.size() * rule_size;
+      const int batch_count = (node_size + batch_size - 1) / batch_size;
+
+      std::vector<double> fval(node_size * ener.size(), 0.);
+      std::vector<double> poten(node_size);
+
+      std::exception_ptr err;
+
+#pragma omp parallel default(shared) num_threads(thread_num)
+      {
+	std::vector<Dynamic::Coordinates> dc(batch_size, dc0);
+	std::vector<double> angle(odim);
+	std::vector<double> weight(batch_size);
+
+#pragma omp for schedule(dynamic)
+	for(int batch = 0; batch < batch_count; ++batch) {
+	  try {
+	    const int start = batch * batch_size;
+	    const int bsize = std::min(batch_size, node_size - start);
+
+	    for(int b = 0; b < bsize; ++b) {
+	      const AngularCell& cc = fresh[(start + b) / rule_size];
+	      const std::vector<double>& x = rule.node[(start + b) % rule_size];
+
+	      for(int i = 0; i < odim; ++i)
+		angle[i] = cc.center[i] + cc.width[i] * x[i];
+
+	      weight[b] = 1.;
+	      for(IndexMapIterator it = index_map.begin(); it != index_map.end(); ++it)
+		if(it->first.second == THETA)
+		  weight[b] *= std::sin(angle[it->second]);
+
+	      ang2dc(angle, dc[b]);
+	    }
+
+	    pot.batch(bsize, &dc[0], &poten[start]);
+
+	    for(int b = 0; b < bsize; ++b)
+	      for(int e = 0; e < ener.size(); ++e) {
+		const double rho_val = density.density(dc[b], ener[e] - poten[start + b]);
+
+		if(rho_val > 0.)
+		  fval[(start + b) * ener.size() + e] = rho_val * weight[b];
+	      }
+	  }
+	  catch(...) {
+#pragma omp critical(lr_integral_error)
+	    if(!err)
+	      err = std::current_exception();
+	  }
+	}
+      }
+
+      if(err)
+	std::rethrow_exception(err);
+
+      node_count += node_size;
+
+      for(int n = 0; n < node_size; ++n)
+	if(!vinit || poten[n] < vmin) {
+	  vinit = true;
+	  vmin = poten[n];
+	}
+
+      std::vector<double> dir_val(rule_size);
+      for(int c = 0; c < fresh.size(); ++c) {
+	AngularCell& cc = fresh[c];
+
+	double vol = 1.;
+	for(int i = 0; i < odim; ++i)
+	  vol *= 2. * cc.width[i];
+
+	cc.value.assign(ener.size(), 0.);
+	cc.error.assign(ener.size(), 0.);
+
+	dir_val.assign(rule_size, 0.);
+
+	for(int e = 0; e < ener.size(); ++e) {
+	  double hi = 0., lo = 0.;
+	  for(int n = 0; n < rule_size; ++n) {
+	    const double f = fval[(c * rule_size + n) * ener.size() + e];
+	    hi += rule.weight[n] * f;
+	    lo += rule.lower[n]  * f;
+	    dir_val[n] += f;
+	  }
+	  cc.value[e] = hi * vol;
+	  cc.error[e] = std::fabs(hi - lo) * vol;
+	}
+
+	cc.split = rule.split(dir_val);
+
+	cell.push_back(cc);
+      }
+
+      // global estimates
+      total.assign(ener.size(), 0.);
+      error.assign(ener.size(), 0.);
+      for(int c = 0; c < cell.size(); ++c)
+	for(int e = 0; e < ener.size(); ++e) {
+	  total[e] += cell[c].value[e];
+	  error[e] += cell[c].error[e];
+	}
+
+      // relative errors of the cells
+      std::vector<std::pair<double, int> > cell_err(cell.size());
+      double err_max = 0., err_sum = 0.;
+      for(int c = 0; c < cell.size(); ++c) {
+	double dtemp = 0.;
+	for(int e = 0; e < ener.size(); ++e)
+	  if(total[e] > 0.)
+	    dtemp = std::max(dtemp, cell[c].error[e] / total[e]);
+
+	cell_err[c] = std::make_pair(dtemp, c);
+	err_sum += dtemp;
+      }
+
+      for(int e = 0; e < ener.size(); ++e)
+	if(total[e] > 0.)
+	  err_max = std::max(err_max, error[e] / total[e]);
+
+      if(err_max <= angular_tolerance())
+	break;
+
+      if(node_count + 2 * rule_size > _angl_node_max) {
+	std::cerr << funame << "WARNING: the maximal number of nodes, " << _angl_node_max
+		  << ", is reached: relative error estimate = " << err_max << "\n";
+	break;
+      }
+
+      // the cells with the largest errors making half of the total error are bisected
+      std::sort(cell_err.begin(), cell_err.end(), std::greater<std::pair<double, int> >());
+
+      std::vector<char> isplit(cell.size(), 0);
+
+      fresh.clear();
+
+      double dtemp = 0.;
+      for(int i = 0; i < cell_err.size(); ++i) {
+	if(i && (dtemp >= err_sum / 2. || node_count + (fresh.size() + 2) * rule_size > _angl_node_max))
+	  break;
+
+	const AngularCell& cc = cell[cell_err[i].second];
+
+	isplit[cell_err[i].second] = 1;
+	dtemp += cell_err[i].first;
+
+	for(int s = -1; s <= 1; s += 2) {
+	  fresh.push_back(cc);
+	  fresh.back().width[cc.split] /= 2.;
+	  fresh.back().center[cc.split] += s * fresh.back().width[cc.split];
+	}
+      }
+
+      std::vector<AngularCell> next;
+      for(int c = 0; c < cell.size(); ++c)
+	if(!isplit[c])
+	  next.push_back(cell[c]);
+
+      cell.swap(next);
+    }
+
+    for(int e = 0; e < ener.size(); ++e) {
+      double val = total[e];
+
+      if(val > 0.) {
+	_angl_err = std::max(_angl_err, error[e] / val);
+
+	val *= density.norm_factor();
+	if(dynamic_cast<const EDensity*>(&density))
+	  val *= dist[d] * dist[d];
+      }
+      else
+	val = -1.;
+
+      res(d, e) = val;
+    }
+
+    if(mep)
+      (*mep)[d] = vmin;
+  }
+}
+
 /*******************************************************************************************
  *************************************** Minimum Energy Search *****************************
  *******************************************************************************************/
@@ -1041,10 +1637,11 @@ double LongRange::minimum_energy (double distance)
     }
   }
   MultiIndexConvert multi_grid(grid_size);
-  for(int grid_index = 0; grid_index < multi_grid.size(); ++grid_index) {
+  for(MultiIndexConvert::Iterator git(multi_grid); !git.end(); ++git) {
+    const int grid_index = git.linear();
  
     // set Euler angles
-    std::vector<int> grid_point = multi_grid(grid_index);
+    const std::vector<int>& grid_point = git.index();
 
     for(IndexMapIterator it = index_map.begin(); it != index_map.end(); ++it) {
       ang_index = it->second;
@@ -25,6 +25,12 @@ namespace LongRange {
 
   void init (std::istream&) ;
   void set_angular_grid (int g);
+  void set_angular_sampling (int s); // Sobol sampling size, zero for the product grid
+
+  // adaptive orientational cubature relative tolerance, zero for the fixed nodes, and
+  // the maximal relative error estimate of the last orientational integral
+  void   set_angular_tolerance (double);
+  double angular_error ();
 
   enum sym_t { 
     SPHERICAL,     // sperically symmetric molecule: atom or spherical top
@@ -53,6 +59,7 @@ namespace LongRange {
   protected:
 
     double _density (const Dynamic::Coordinates& dc, int dim, double* mep =0) const;
+    double _density (double e, int dim) const;
 
   public:
     double energy () const { return _ener; }
@@ -61,9 +68,14 @@ namespace LongRange {
     // number of states (orientational integral)
     double integral (double dist, double* mep =0) const ;
 
+    // number of states on the distance x energy grid and, optionally, the minimum energies
+    void integral (const std::vector<double>& dist, const std::vector<double>& ener, Lapack::Matrix& res,
+		   std::vector<double>* mep =0) const ;
+
     StatesNumberDensity (double e) : _ener(e) {}
 
     virtual double operator () (const Dynamic::Coordinates&, double* mep =0) const = 0;
+    virtual double density (const Dynamic::Coordinates&, double e) const = 0; // e = energy - potential
     virtual double norm_factor () const = 0;
     virtual ~StatesNumberDensity () {}
   };
@@ -123,6 +135,7 @@ namespace LongRange {
 
     EDensity (double e) : StatesNumberDensity(e) {}
     double operator() (const Dynamic::Coordinates& dc, double* mep =0) const;
+    double density (const Dynamic::Coordinates&, double e) const { return _density(e, _dim); }
     double norm_factor () const { return _nfac; }
     ~EDensity () {}
     
@@ -143,6 +156,7 @@ namespace LongRange {
 
     JDensity (double e) : StatesNumberDensity(e) {}
     double operator() (const Dynamic::Coordinates& dc, double* mep =0) const;
+    double density (const Dynamic::Coordinates&, double e) const { return _density(e, _dim); }
     double norm_factor () const { return _nfac; }
     ~JDensity () {}
     
@@ -164,6 +178,7 @@ namespace LongRange {
 
     MDensity (double e) : StatesNumberDensity(e) {}
     double operator() (const Dynamic::Coordinates& dc, double* mep =0) const;
+    double density (const Dynamic::Coordinates&, double e) const { return _density(e, _dim); }
     double norm_factor () const { return _nfac; }
 
     ~MDensity () {}
@@ -193,6 +208,7 @@ namespace LongRange {
 
     KDensity (double e, const std::vector<double>& m, double k) ;
     double operator() (const Dynamic::Coordinates&, double* mep =0) const;
+    double density (const Dynamic::Coordinates&, double e) const;
     double norm_factor () const { return _nfac; }
 
     ~KDensity () {}
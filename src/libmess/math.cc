@@ -17,6 +17,10 @@
 #include <vector>
 #include <set>
 #include <map>
+#include <cmath>
+#include <complex>
+#include <algorithm>
+#include <limits>
 
 void Math::NewtonRaphsonSearch::find (double& x) const
 {
@@ -349,3 +353,344 @@ double Math::MinimumSearch::find (double x1, double step, double* xp)
     }
   }// x2 < x0 < x1, y1 >= y0 <= y2 situation
 }
+
+/**************************************************************************
+ ******************************* CONVOLUTION ******************************
+ **************************************************************************/
+
+namespace {
+  //
+  typedef std::complex<double> complex;
+
+  // in-place radix-2 fast Fourier transform, sign = -1 forward, sign = 1 backward (not normalized)
+  //
+  void fft (std::vector<complex>& z, int sign)
+  {
+    const int n = z.size();
+
+    for(int i = 1, j = 0; i < n; ++i) {
+      int bit = n >> 1;
+      for(; j & bit; bit >>= 1)
+	j ^= bit;
+      j ^= bit;
+      if(i < j)
+	std::swap(z[i], z[j]);
+    }
+
+    std::vector<complex> w(n / 2);
+    for(int k = 0; k < n / 2; ++k)
+      w[k] = std::polar(1., sign * 2. * M_PI * (double)k / (double)n);
+
+    for(int len = 2; len <= n; len <<= 1) {
+      const int stride = n / len;
+      for(int i = 0; i < n; i += len)
+	for(int k = 0; k < len / 2; ++k) {
+	  const complex u = z[i + k];
+	  const complex v = z[i + k + len / 2] * w[k * stride];
+	  z[i + k]           = u + v;
+	  z[i + k + len / 2] = u - v;
+	}
+    }
+  }
+
+  // direct sum contribution of a[beg, end) to the result
+  //
+  void direct_convolute (const double* a, int beg, int end, int size, const double* kernel, int kernel_size, double* res)
+  {
+    const int jmax = end + kernel_size - 1 < size ? end + kernel_size - 1 : size;
+    
+#pragma omp parallel for default(shared) schedule(static)
+
+    for(int j = beg; j < jmax; ++j) {
+      double dtemp = 0.;
+      int imin = j - end + 1;
+      if(imin < 0)
+	imin = 0;
+      for(int i = imin; i <= j - beg && i < kernel_size; ++i)
+	dtemp += a[j - i] * kernel[i];
+      res[j] += dtemp;
+    }
+  }
+}
+
+void Math::convolute (const double* a, int size, const double* kernel, int kernel_size, double* res)
+{
+  // smallest block treated by FFT
+  static const int    block_min = 64;
+  // largest block
+  static const int    block_max = 8192;
+  // maximal deviation of the logarithm of the tilted block from zero
+  static const double tilt_tol  = 4.;
+  // maximal tilt of the kernel segment
+  static const double tilt_max  = 8.;
+  // relative round-off tolerance
+  static const double conv_tol  = 1.e-12;
+  // kernels with less than sparse_fac * log2(kernel_size) nonzero elements are summed directly
+  static const double sparse_fac = 64.;
+
+  if(size <= 0)
+    return;
+
+  if(kernel_size > size)
+    kernel_size = size;
+
+  for(int j = 0; j < size; ++j)
+    res[j] = 0.;
+
+  if(kernel_size <= 0)
+    return;
+
+  // short kernels: direct summation
+  if(kernel_size < block_min || (double)kernel_size * (double)size < 100000.) {
+    direct_convolute(a, 0, size, size, kernel, kernel_size, res);
+    return;
+  }
+
+  // sparse kernels (e.g., the rotor level ladder): direct summation over the nonzero elements
+  std::vector<int> nonzero;
+  for(int i = 0; i < kernel_size; ++i)
+    if(kernel[i] != 0.)
+      nonzero.push_back(i);
+
+  if(nonzero.size() < sparse_fac * std::log((double)kernel_size) / M_LN2) {
+    
+#pragma omp parallel for default(shared) schedule(static)
+
+    for(int j = 0; j < size; ++j) {
+      double dtemp = 0.;
+      for(int n = 0; n < nonzero.size() && nonzero[n] <= j; ++n)
+	dtemp += a[j - nonzero[n]] * kernel[nonzero[n]];
+      res[j] = dtemp;
+    }
+    return;
+  }
+
+  const double eps = std::numeric_limits<double>::epsilon();
+
+  double dtemp;
+
+  int beg = 0;
+  while(beg < size) {
+    // block a[beg, beg + len) with the small deviation of log a from the exponential through its ends
+    int len = block_max;
+    if(len > size - beg)
+      len = size - beg;
+
+    double la, tilt;
+    for(; len >= block_min; len /= 2) {
+      if(a[beg] <= 0. || a[beg + len - 1] <= 0.)
+	continue;
+
+      la   = std::log(a[beg]);
+      tilt = (std::log(a[beg + len - 1]) - la) / (double)(len - 1);
+      if(tilt < 0.)
+	tilt = 0.;
+
+      int n;
+      for(n = 0; n < len; ++n) {
+	if(a[beg + n] <= 0.)
+	  break;
+	dtemp = std::log(a[beg + n]) - la - tilt * (double)n;
+	if(dtemp > tilt_tol || dtemp < -tilt_tol)
+	  break;
+      }
+      if(n == len)
+	break;
+    }
+
+    // no suitable block: direct summation over a short one
+    if(len < block_min) {
+      len = size - beg < block_min ? size - beg : block_min;
+      direct_convolute(a, beg, beg + len, size, kernel, kernel_size, res);
+      beg += len;
+      continue;
+    }
+
+    // tilted block
+    std::vector<double> at(len);
+    double anorm = 0.;
+    for(int n = 0; n < len; ++n) {
+      at[n] = a[beg + n] * std::exp(-la - tilt * (double)n);
+      anorm += at[n] * at[n];
+    }
+    anorm = std::sqrt(anorm);
+
+    // kernel segments with the limited tilt
+    int seg = len;
+    if(tilt * (double)seg > tilt_max)
+      seg = (int)(tilt_max / tilt);
+    if(seg < block_min)
+      seg = block_min;
+
+    for(int i0 = 0; i0 < kernel_size && beg + i0 < size; i0 += seg) {
+      int klen = seg;
+      if(klen > kernel_size - i0)
+	klen = kernel_size - i0;
+      if(klen > size - beg - i0)
+	klen = size - beg - i0;
+
+      // result positions, beg + i0 + j, affected
+      int out = len + klen - 1;
+      if(out > size - beg - i0)
+	out = size - beg - i0;
+
+      // too large scaling factor: direct summation
+      if(la + tilt * (double)out > 600. || la < -600.) {
+	for(int j = 0; j < out; ++j) {
+	  dtemp = 0.;
+	  for(int n = j < klen ? 0 : j - klen + 1; n <= j && n < len; ++n)
+	    dtemp += a[beg + n] * kernel[i0 + j - n];
+	  res[beg + i0 + j] += dtemp;
+	}
+	continue;
+      }
+
+      int fft_size = 1;
+      while(fft_size < len + klen - 1)
+	fft_size <<= 1;
+
+      // tilted kernel segment
+      std::vector<double> kt(klen);
+      double knorm = 0.;
+      for(int i = 0; i < klen; ++i) {
+	kt[i] = kernel[i0 + i] * std::exp(-tilt * (double)i);
+	knorm += kt[i] * kt[i];
+      }
+      knorm = std::sqrt(knorm);
+
+      if(knorm == 0.)
+	continue;
+
+      // tilted block and kernel segment packed as the real and imaginary parts;
+      // both are normalized, since they are separated after the transform
+      std::vector<complex> z(fft_size, 0.);
+      for(int n = 0; n < len; ++n)
+	z[n].real(at[n] / anorm);
+      for(int i = 0; i < klen; ++i)
+	z[i].imag(kt[i] / knorm);
+
+      fft(z, -1);
+
+      // product of the transforms of the two real sequences
+      std::vector<complex> y(fft_size);
+      for(int k = 0; k < fft_size; ++k) {
+	const complex zc = std::conj(z[(fft_size - k) % fft_size]);
+	y[k] = (z[k] + zc) * (z[k] - zc) / complex(0., 4.);
+      }
+
+      fft(y, 1);
+
+      // round-off error estimate of the tilted convolution
+      const double fft_err = 4. * eps * std::log((double)fft_size) / M_LN2 * anorm * knorm;
+
+      // the elements dominated by the round-off are summed directly
+      for(int j = 0; j < out; ++j) {
+	const double fac = std::exp(la + tilt * (double)j);
+	const int    r   = beg + i0 + j;
+
+	dtemp = y[j].real() / (double)fft_size * anorm * knorm;
+      
+	if(dtemp < 0. || fft_err > conv_tol * (res[r] / fac + dtemp)) {
+	  dtemp = 0.;
+	  for(int n = j < klen ? 0 : j - klen + 1; n <= j && n < len; ++n)
+	    dtemp += a[beg + n] * kernel[i0 + j - n];
+	  res[r] += dtemp;
+	}
+	else
+	  res[r] += dtemp * fac;
+      }
+    }
+
+    beg += len;
+  }
+}
+
+/**************************************************************************
+ ************************** HARMONIC STATE COUNT **************************
+ **************************************************************************/
+
+void Math::state_count (double* grid, int size, int shift, int degen)
+{
+  const char funame [] = "Math::state_count: ";
+
+  if(shift < 0 || degen < 0) {
+    std::cerr << funame << "negative shift or degeneracy: " << shift << ", " << degen << "\n";
+    throw Error::Range();
+  }
+
+  if(!degen || shift >= size)
+    return;
+
+  // zero frequency doubles the states every pass
+  if(!shift) {
+    const double fac = std::pow(2., degen);
+    for(int e = 0; e < size; ++e)
+      grid[e] *= fac;
+    return;
+  }
+
+  // chunks of shift length do not depend on themselves and are vectorized
+  if(degen == 1) {
+    for(int b = shift; b < size; b += shift) {
+      const int len = b + shift < size ? shift : size - b;
+      double* g = grid + b;
+      const double* h = grid + b - shift;
+
+#pragma omp simd
+
+      for(int e = 0; e < len; ++e)
+	g[e] += h[e];
+    }
+    return;
+  }
+
+  // degenerate modes: all passes are applied to one chunk before the next one, each
+  // pass keeping its own copy of the previous chunk, so that the grid is swept once
+  std::vector<double> hist((std::size_t)degen * shift);
+  for(int p = 0; p < degen; ++p)
+    std::copy(grid, grid + shift, hist.begin() + (std::size_t)p * shift);
+
+  for(int b = shift; b < size; b += shift) {
+    const int len = b + shift < size ? shift : size - b;
+    double* g = grid + b;
+
+    for(int p = 0; p < degen; ++p) {
+      double* h = &hist[(std::size_t)p * shift];
+
+#pragma omp simd
+
+      for(int e = 0; e < len; ++e) {
+	g[e] += h[e];
+	h[e]  = g[e];
+      }
+    }
+  }
+}
+
+/*************************************************************************
+ ******************************* GRID MATH *******************************
+ *************************************************************************/
+
+void Math::exp_grid (double x, int begin, int end, double* res)
+{
+#pragma omp simd
+
+  for(int i = begin; i < end; ++i)
+    res[i] = std::exp(double(i) * x);
+}
+
+void Math::sqrt_grid (const double* a, int size, double* res)
+{
+#pragma omp simd
+
+  for(int i = 0; i < size; ++i)
+    res[i] = std::sqrt(a[i]);
+}
+
+void Math::inv_sqrt_grid (const double* a, int size, double* res)
+{
+#pragma omp simd
+
+  for(int i = 0; i < size; ++i)
+    res[i] = a[i] > 0. ? 1. / std::sqrt(a[i]) : 0.;
+}
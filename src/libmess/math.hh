@@ -89,6 +89,22 @@ namespace Math {
     MinimumSearch (double xt, double yt) : _xtol(xt), _ytol(yt) {}
   };
 
+  // truncated convolution of the nonnegative arrays, res[j] = sum_{i <= j, i < kernel_size} a[j - i] * kernel[i],
+  // j < size; long kernels are convoluted by FFT over the blocks of a, each block exponentially tilted
+  // to be nearly flat, so that the FFT round-off stays small relative to each element of the result
+  //
+  void convolute (const double* a, int size, const double* kernel, int kernel_size, double* res) ;
+
+  // Beyer-Swinehart count of the harmonic mode with the frequency of shift grid steps and given degeneracy:
+  // degen passes of grid[e] += grid[e - shift], e >= shift, done in one sweep over the grid
+  //
+  void state_count (double* grid, int size, int shift, int degen = 1) ;
+
+  // grid math over the contiguous arrays, the loops are vectorized
+  //
+  void exp_grid      (double x, int begin, int end, double* res) ; // res[i] = exp(i * x), begin <= i < end
+  void sqrt_grid     (const double* a, int size, double* res) ;
+  void inv_sqrt_grid (const double* a, int size, double* res) ; // zero for the zero argument
 }
 
 #endif
@@ -20,12 +20,24 @@
 #include <list>
 #include <map>
 #include <ctime>
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+#include <unistd.h>
+#include <exception>
 
 #include "mess.hh"
 #include "units.hh"
 #include "key.hh"
 #include "io.hh"
 #include "shared.hh"
+#include "threads.hh"
+
+#ifdef _OPENMP
+
+#include <omp.h>
+
+#endif
 
 #ifdef WITH_MPACK
 
@@ -33,6 +45,12 @@
 
 #endif
 
+#ifdef WITH_SCALAPACK
+
+#include "scalapack.hh"
+
+#endif
+
 namespace MasterEquation {
   /*********************************** AUXILIARY OUTPUT *************************************/
 
@@ -43,24 +61,39 @@ namespace MasterEquation {
   std::ofstream evec_out;
   int evec_out_num = 0;
 
+  bool     keep_spectrum = false;
+  Spectrum spectrum;
+
+  double eigenvalue_gap = -1.;
+
+  bool grid_warm_start = false;
+
+  // the lowest eigenvectors on the previous energy grid by temperature and pressure, divided
+  // by the Boltzmann factors square roots, i.e., smooth in energy
+  struct GridStart {
+    double           energy_reference;
+    double           energy_step;
+    std::vector<int> well_shift;
+    std::vector<int> well_size;
+    Lapack::Matrix   population; // global state index, eigenvector index
+  };
+
+  std::map<std::pair<double, double>, GridStart> grid_start;
+
+  // reduced basis snapshots, in the order they were solved
+  std::vector<GridStart> reduced_basis;
+
   std::ofstream arr_out; // arrhenius 
 
   /********************************* USER DEFINED PARAMETERS ********************************/
 
-  // temperature
-  double                                                     _temperature     = -1.;
-  // pressure
-  double                                                     _pressure        = -1.;
-  // energy grid step
-  double                                                     _energy_step     = -1.;
-  // zero energy (also upper limit)
-  double                                                     _energy_reference;
   // well depth cutoff parameter 
   double                                                     well_cutoff       = -1.;
   // highest chemecial eigenvalue
   double                                                     chemical_threshold     = 0.;
   // smallest chemical eigenvalue
   double                                                     min_chem_eval     = 1.e-7;
+  double                                                     separation_check  = -1.;
   // maximal chemical relaxation eigenvalue to collision frequency ratio
   double                                                     reduction_threshold    = 0.;
   // species reduction algorithm for low-eigenvalue method
@@ -85,10 +118,53 @@ namespace MasterEquation {
   // well partition threshold
   double                                                     well_projection_threshold = 0.2;
 
-  /********************************* INTERNAL PARAMETERS ************************************/
+  // maximal number of the well partition search nodes
+  long                                                       well_partition_node_max = 10000000;
+
+  // global relaxation matrix eigensolver
+  int                                                        eigensolver = FULL_SPECTRUM;
 
-  // inner setting check
-  bool  _isset = false;
+  // chemical eigenpairs precision
+#ifdef WITH_MPACK
+  int                                                        chemical_precision = MULTIPLE_PRECISION;
+#else
+  int                                                        chemical_precision = DOUBLE_PRECISION;
+#endif
+
+  // reuse the pressure independent global matrices over the pressure list
+  bool                                                       incremental_pressure = true;
+
+  // relaxation modes solver of the low-eigenvalue method
+  int                                                        crm_solver = CHOLESKY_SOLVER;
+
+  // generalized eigen-decomposition precision of the spectral relaxation modes solver
+  int                                                        crm_precision = DOUBLE_PRECISION;
+
+  // growth factor of the lumped energy bins toward the well bottom
+  double                                                     energy_grid_factor = 1.;
+
+  // energy offset of the well reservoir state below the fine energy grid
+  double                                                     reservoir_offset = -1.;
+
+  // thermal flux fraction below which the inner barrier is closed
+  double                                                     decoupling_threshold = 0.;
+
+  // state cache
+  std::string                                                state_cache_dir;
+  std::string                                                state_cache_model;
+
+  // resident model
+  bool                                                       resident_species = false;
+  std::set<std::string>                                      closed_barrier;
+
+  // eigenvectors scratch directory
+  std::string                                                eigen_scratch_dir;
+
+  // reduced basis surrogate
+  double                                                     reduced_basis_tolerance = -1.;
+  int                                                        reduced_basis_size      = 8;
+
+  /********************************* INTERNAL PARAMETERS ************************************/
 
   // collisional frequency
   //double _collision_frequency_factor;
@@ -100,86 +176,92 @@ namespace MasterEquation {
 
   /*******************************************************************************************/
 
-  std::vector<double> _thermal_factor;
+  // default context
+  Context _default_context;
+
+  // current context of the thread
+  thread_local Context* _current_context = 0;
 
-  std::vector<SharedPointer<Well> >  _well;
-  const Well& well (int w) { return *_well[w]; } 
+  Context& context () { return _current_context ? *_current_context : _default_context; }
 
-  std::vector<SharedPointer<Bimolecular> >  _bimolecular;
-  const Bimolecular& bimolecular (int p) { return *_bimolecular[p]; }
+  const Well& well (int w) { return *context()._well[w]; } 
 
-  std::vector<SharedPointer<Barrier> > _inner_barrier;
-  const Barrier& inner_barrier (int p) { return *_inner_barrier[p]; }
+  const Bimolecular& bimolecular (int p) { return *context()._bimolecular[p]; }
 
-  std::vector<SharedPointer<Barrier> > _outer_barrier;
-  const Barrier& outer_barrier (int p) { return *_outer_barrier[p]; }
+  const Barrier& inner_barrier (int p) { return *context()._inner_barrier[p]; }
+
+  const Barrier& outer_barrier (int p) { return *context()._outer_barrier[p]; }
   
   // Boltzmann factor: exp(-E/T)
   double        thermal_factor (int); 
   void   resize_thermal_factor (int);
   void    reset_thermal_factor (int = 0);
 
-  bool isset () { return _isset; }
+  // contiguous table of at least the given size for the vectorized loops
+  const double* thermal_factor_table (int);
+
+  // energy resolved table output
+  void energy_table_output (std::ostream&, const std::vector<std::string>&, const Lapack::Matrix&, int);
+
+  bool isset () { return context()._isset; }
   
-  double energy_reference () { return _energy_reference; }
+  double energy_reference () { return context()._energy_reference; }
 
   double temperature ()
   {
     const char funame [] = "MasterEquation::temperature: ";
     
-    if(_temperature <= 0.) {
+    if(context()._temperature <= 0.) {
       std::cerr << funame << "not initialized\n";
       throw Error::Init();
     }
     
-    return _temperature;
+    return context()._temperature;
   }
   
   double energy_step ()
   {
     const char funame [] = "MasterEquation::energy_step: ";
     
-    if(_energy_step <= 0.) {
+    if(context()._energy_step <= 0.) {
       std::cerr << funame << "not initialized\n";
       throw Error::Init();
     }
     
-    return _energy_step;
+    return context()._energy_step;
   }
   
   double pressure                ()
   {
     const char funame [] = "MasterEquation::pressure: ";
     
-    if(_pressure <= 0.) {
+    if(context()._pressure <= 0.) {
       std::cerr << funame << "not initialized\n";
       throw Error::Init();
     }
     
-    return _pressure;
+    return context()._pressure;
   }
   //double collision_frequency     () { return _collision_frequency;    }
   //double kernel_fraction    (int i) { return _kernel_fraction[i];     }
 
-  // cumulative number of states for each well
-  std::vector<Array<double> >  cum_stat_num;
-
   // capture probabilities
   std::map<std::string, std::vector<double> > hot_energy;
-  std::map<int, std::vector<int> >            hot_index;
-  int hot_energy_size;
 
   // product energy distributions
   std::ofstream  ped_out;// product energy distribution output stream
+  std::ofstream sens_out;// barrier energy sensitivities output stream
   std::vector<std::pair<int, int> > ped_pair; // product energy distribution reactants and products indices
+
+  double ped_tolerance = 0.;
 }
 
 void MasterEquation::set_temperature (double t) 
 { 
   double dtemp;
 
-  _isset  = false;
-  _temperature = t;
+  context()._isset  = false;
+  context()._temperature = t;
 
   reset_thermal_factor();
   /*
@@ -200,21 +282,96 @@ void MasterEquation::set_temperature (double t)
 
 void MasterEquation::set_energy_step (double e) 
 { 
-  _isset = false; 
-  _energy_step = e; 
+  context()._isset = false; 
+  context()._energy_step = e; 
   reset_thermal_factor(); 
 }
 
 void MasterEquation::set_energy_reference (double e) 
 {
-  _isset = false;
-  _energy_reference = e;
+  context()._isset = false;
+  context()._energy_reference = e;
 }
 
 void MasterEquation::set_pressure (double p) 
 {
-  _pressure = p;
-  //_collision_frequency = p * _collision_frequency_factor; 
+  context()._pressure = p;
+  //_collision_frequency = p * _collision_frequency_factor;
+}
+
+/********************************************************************************************
+ ************************************** SOLVE CONTEXT ***************************************
+ ********************************************************************************************/
+
+MasterEquation::ContextGuard::ContextGuard (Context& cx) : _prev(_current_context)
+{
+  _current_context = &cx;
+}
+
+MasterEquation::ContextGuard::~ContextGuard ()
+{
+  _current_context = _prev;
+}
+
+MasterEquation::ContextHandle MasterEquation::set (double t, double e, double r,
+						   std::map<std::pair<int, int>, double>& rate_data,
+						   std::map<int, double>& capture)
+{
+  ContextHandle res(new Context);
+
+  ContextGuard guard(*res);
+
+  set_temperature(t);
+  set_energy_step(e);
+  set_energy_reference(r);
+  set(rate_data, capture);
+
+  return res;
+}
+
+void MasterEquation::solve (Context& cx, double p, Method method, std::map<std::pair<int, int>, double>& rate_data,
+			    Partition& well_partition, int flags)
+{
+  const char funame [] = "MasterEquation::solve: ";
+
+  if(!cx._isset) {
+    std::cerr << funame << "context is not set\n";
+    throw Error::Init();
+  }
+
+  ContextGuard guard(cx);
+
+  set_pressure(p);
+  method(rate_data, well_partition, flags);
+}
+
+/********************************************************************************************
+ ************************************* TABLE OUTPUT *****************************************
+ ********************************************************************************************/
+
+// energy resolved table: the energy column followed by the data columns, size rows
+// from the reference energy down; text or binary records (IO::binary_record)
+//
+void MasterEquation::energy_table_output (std::ostream& to, const std::vector<std::string>& title,
+					  const Lapack::Matrix& data, int size)
+{
+  std::vector<std::string> header(1, "E, kcal/mol");
+  header.insert(header.end(), title.begin(), title.end());
+  IO::put_header(to, header);
+
+  const int cols = data.isinit() ? data.size2() : 0;
+
+  std::vector<double> buff((long)size * (cols + 1));
+
+  for(int e = 0; e < size; ++e) {
+    double* p = &buff[(long)e * (cols + 1)];
+    *p++ = (energy_reference() - (double)e * energy_step()) / Phys_const::kcal;
+    for(int i = 0; i < cols; ++i)
+      *p++ = data(e, i);
+  }
+
+  if(size)
+    IO::put_table(to, "", &buff[0], size, cols + 1);
 }
 
 /********************************************************************************************
@@ -223,33 +380,36 @@ void MasterEquation::set_pressure (double p)
 
 double MasterEquation::thermal_factor(int e)
 {
-  if(e >= _thermal_factor.size())
+  if(e >= context()._thermal_factor.size())
     resize_thermal_factor(e + 1);
-    return _thermal_factor[e];
+    return context()._thermal_factor[e];
 }
 
 void  MasterEquation::resize_thermal_factor(int s)
 {
-  if(s <= _thermal_factor.size())
+  if(s <= context()._thermal_factor.size())
     return;
 
-  int emin = _thermal_factor.size();
-  _thermal_factor.resize(s);
+  int emin = context()._thermal_factor.size();
+  context()._thermal_factor.resize(s);
 
-  double x = energy_step() / temperature();
-  for(int e = emin; e < _thermal_factor.size(); ++e)
-    _thermal_factor[e] = std::exp(double(e) * x);
+  Math::exp_grid(energy_step() / temperature(), emin, s, &context()._thermal_factor[0]);
+}
+
+const double* MasterEquation::thermal_factor_table (int s)
+{
+  resize_thermal_factor(s > 0 ? s : 1);
+
+  return &context()._thermal_factor[0];
 }
 
 void  MasterEquation::reset_thermal_factor(int s)
 {
-  _thermal_factor.resize(s);
+  context()._thermal_factor.resize(s);
   if(!s)
     return;
 
-  double x = energy_step() / temperature();
-  for(int e = 0; e < _thermal_factor.size(); ++e)
-    _thermal_factor[e] = std::exp(double(e) * x);
+  Math::exp_grid(energy_step() / temperature(), 0, s, &context()._thermal_factor[0]);
 }
 
 /************************************* PRODUCT ENERGY DISTRIBUTION PAIRS ********************************************/
@@ -378,3018 +538,5720 @@ void MasterEquation::set_default_chem_size (int s)
  ********************* SETTING WELLS, BARRIERS, AND BIMOLECULAR *****************************
  ********************************************************************************************/
 
-void MasterEquation::set (std::map<std::pair<int, int>, double>& rate_data, std::map<int, double>& capture)
-  
-{
-  const char funame [] = "MasterEquation::set: ";
+/********************************************************************************************
+ ************************************** STATE CACHE *****************************************
+ ********************************************************************************************/
 
-  const double bru = Phys_const::cm * Phys_const::cm * Phys_const::cm * Phys_const::herz;
+namespace MasterEquation {
+  //
+  void cache_put (std::ostream& to, int i)    { to.write((const char*)&i, sizeof(i)); }
+  void cache_put (std::ostream& to, double d) { to.write((const char*)&d, sizeof(d)); }
 
-  if(energy_reference() > Model::energy_limit()) {
-    std::cerr << funame << "model energy limit (" << Model::energy_limit() / Phys_const::kcal 
-	      << " kcal/mol) is lower than the energy reference (" << energy_reference() / Phys_const::kcal 
-	      << " kcal/mol)\n";
-    throw Error::Range();
+  void cache_put (std::ostream& to, const double* p, int n) 
+  { 
+    if(n) 
+      to.write((const char*)p, n * sizeof(double)); 
   }
 
-  IO::Marker funame_marker(funame);
-
-  rate_data.clear();
+  void cache_put (std::ostream& to, const std::vector<double>& v)
+  {
+    cache_put(to, (int)v.size());
 
+    if(v.size())
+      cache_put(to, &v[0], v.size());
+  }
 
-  _isset = true;
+  void cache_put (std::ostream& to, const Lapack::Vector& v)
+  {
+    const int n = v.isinit() ? v.size() : 0;
 
-  int    itemp;
-  double dtemp;
+    cache_put(to, n);
 
-  IO::log << IO::log_offset << "Temperature      = " << temperature()      / Phys_const::kelv << " K\n";
-  //IO::log << IO::log_offset << "Collision rate   = " << _collision_frequency_factor * temperature() / bru << "cm^3/sec\n";
-  IO::log << IO::log_offset << "Energy reference = " << energy_reference() / Phys_const::incm << " 1/cm\n";
-  IO::log << IO::log_offset << "Energy step      = " << energy_step()      / Phys_const::incm << " 1/cm\n";
+    if(n)
+      cache_put(to, (const double*)v, n);
+  }
 
+  void cache_put (std::ostream& to, const Lapack::Matrix& m)
   {
-    IO::Marker set_marker("setting wells, barriers, and bimolecular");
+    const int n1 = m.isinit() ? m.size1() : 0;
+    const int n2 = m.isinit() ? m.size2() : 0;
 
-    _well.resize(Model::well_size());
-    // wells
-    for(int w = 0; w < _well.size(); ++w)
-      _well[w] = SharedPointer<Well>(new Well(Model::well(w)));
+    cache_put(to, n1);
+    cache_put(to, n2);
 
-    // well-to-well barriers
-    _inner_barrier.resize(Model::inner_barrier_size());
-    for(int b = 0; b < _inner_barrier.size(); ++b)
-      _inner_barrier[b] = SharedPointer<Barrier>(new Barrier(Model::inner_barrier(b)));
+    if(n1)
+      cache_put(to, (const double*)m, n1 * n2);
+  }
 
-    // well-to-bimolecular barriers
-    _outer_barrier.resize(Model::outer_barrier_size());
-    for(int b = 0; b < _outer_barrier.size(); ++b)
-      _outer_barrier[b] = SharedPointer<Barrier>(new Barrier(Model::outer_barrier(b)));
+  void cache_put (std::ostream& to, const Lapack::SymmetricMatrix& m)
+  {
+    const int n = m.isinit() ? m.size() : 0;
 
-    // bimolecular products
-    _bimolecular.resize(Model::bimolecular_size());
-    for(int p = 0; p < _bimolecular.size(); ++p)
-      _bimolecular[p] = SharedPointer<Bimolecular>(new Bimolecular(Model::bimolecular(p)));
+    cache_put(to, n);
 
+    if(n)
+      cache_put(to, (const double*)m, n * (n + 1) / 2);
   }
 
-  // checking if wells are deeper than the barriers between them
-  
-  // inner barriers
-  //
-  for(int b = 0; b < Model::inner_barrier_size(); ++b) {
-    itemp = well(Model::inner_connect(b).first).size() <  well(Model::inner_connect(b).second).size() ?
-      well(Model::inner_connect(b).first).size() : well(Model::inner_connect(b).second).size();
-    if(itemp  < inner_barrier(b).size()) {
-      IO::log << IO::log_offset << Model::inner_barrier(b).name() 
-	      << " barrier top is lower than the bottom of one of the wells it connects => truncating\n"; 
-      _inner_barrier[b]->truncate(itemp);
-    }
+  void cache_put (std::ostream& to, const Lapack::GeneralBandMatrix& m)
+  {
+    const int n = m.isinit() ? m.size()      : 0;
+    const int b = m.isinit() ? m.band_size() : 0;
+
+    cache_put(to, n);
+    cache_put(to, b);
+
+    if(n)
+      cache_put(to, (const double*)m, n * (2 * b - 1));
   }
-  
-  // outer barriers
-  //
-  for(int b = 0; b < Model::outer_barrier_size(); ++b) {
-    itemp = well(Model::outer_connect(b).first).size(); 
-    if(itemp  < outer_barrier(b).size()) {
-      IO::log << IO::log_offset << Model::outer_barrier(b).name()
-	      << " barrier top is lower than the bottom of the well it connects => truncating\n"; 
-      _outer_barrier[b]->truncate(itemp);
+
+  void cache_get (std::istream& from, double* p, int n)
+  {
+    const char funame [] = "MasterEquation::cache_get: ";
+
+    if(n < 0 || n && !from.read((char*)p, n * sizeof(double))) {
+      std::cerr << funame << "corrupted state cache\n";
+      throw Error::Form();
     }
   }
 
-  // clipping the number of states with the maximum rate constant
-  
-  // inner barriers
-  //
-  if(rate_max > 0.) {
-    for(int b = 0; b < Model::inner_barrier_size(); ++b) {
-      int w1 = Model::inner_connect(b).first;
-      int w2 = Model::inner_connect(b).second;
-      for(int i = 0; i < _inner_barrier[b]->size(); ++i) {
-	dtemp = well(w1).state_density(i) < well(w2).state_density(i) ? 
-	  well(w1).state_density(i) : well(w2).state_density(i);
-	dtemp *= rate_max * 2. * M_PI;
-	
-	if(_inner_barrier[b]->state_number(i) > dtemp)
-	  _inner_barrier[b]->state_number(i) = dtemp;
-      }
-    }
-    
-    // outer barriers
-    //
-    for(int b = 0; b < Model::outer_barrier_size(); ++b) {
-      int w = Model::outer_connect(b).first;
-      for(int i = 0; i < _outer_barrier[b]->size(); ++i) {
-	dtemp = rate_max * 2. * M_PI * well(w).state_density(i);
+  void cache_get (std::istream& from, int& i)
+  {
+    const char funame [] = "MasterEquation::cache_get: ";
 
-	if(_outer_barrier[b]->state_number(i) > dtemp)
-	  _outer_barrier[b]->state_number(i) = dtemp;
-      }
+    if(!from.read((char*)&i, sizeof(i))) {
+      std::cerr << funame << "corrupted state cache\n";
+      throw Error::Form();
     }
   }
 
-  // cumulative number of states for each well
-  cum_stat_num.resize(Model::well_size());
-  for(int w = 0; w < Model::well_size(); ++w) {// well cycle
-    itemp = 0;
-    for(int b = 0; b < Model::inner_barrier_size(); ++b)
-      if(Model::inner_connect(b).first == w || Model::inner_connect(b).second == w)
-	itemp = inner_barrier(b).size() > itemp ? inner_barrier(b).size() : itemp;
-    for(int b = 0; b < Model::outer_barrier_size(); ++b)
-      if(Model::outer_connect(b).first == w)
-	itemp = outer_barrier(b).size() > itemp ? outer_barrier(b).size() : itemp;
-
-    cum_stat_num[w].resize(itemp);
-    
-    cum_stat_num[w] = 0.;
-    for(int b = 0; b < Model::inner_barrier_size(); ++b)
-      if(Model::inner_connect(b).first == w || Model::inner_connect(b).second == w) 
-	for(int i = 0; i < inner_barrier(b).size(); ++i)
-	  cum_stat_num[w][i] += inner_barrier(b).state_number(i);
-    for(int b = 0; b < Model::outer_barrier_size(); ++b)
-      if(Model::outer_connect(b).first == w) 
-	for(int i = 0; i < outer_barrier(b).size(); ++i)
-	  cum_stat_num[w][i] += outer_barrier(b).state_number(i);
-  }// well cycle
+  void cache_get (std::istream& from, double& d) { cache_get(from, &d, 1); }
 
+  void cache_get (std::istream& from, std::vector<double>& v)
+  {
+    int n;
+    cache_get(from, n);
 
-  /************************************** OUTPUT ***************************************/
+    v.resize(n);
 
-  if(evec_out.is_open()) {
-    for(int w = 0; w < Model::well_size(); ++w)
-      if(!w || well(w).size() > itemp)
-	itemp = well(w).size();
-    const int well_size_max = itemp;
-    
-    evec_out << "Temperature = " << temperature() / Phys_const::kelv << "K\n"
-	     <<"THERMAL DISTRIBUTIONS:\n"
-	     << std::setw(13) << "E, kcal/mol";
-    for(int w = 0; w < Model::well_size(); ++w)
-      evec_out << std::setw(13) << Model::well(w).name();
-    evec_out << "\n";
-    for(int i = 0; i < well_size_max; ++i) {
-      evec_out << std::setw(13) << (energy_reference() - (double)i * energy_step()) / Phys_const::kcal;
-      for(int w = 0; w < Model::well_size(); ++w)
-	if(i < well(w).size())
-	  evec_out << std::setw(13) << well(w).state_density(i) * thermal_factor(i) / well(w).weight_sqrt();
-	else
-	  evec_out << std::setw(13) << 0;
-      evec_out << "\n";
-    }
-    evec_out << "\n";    
+    if(n)
+      cache_get(from, &v[0], n);
   }
 
-  IO::log << std::setprecision(3);
-
-  if(Model::well_size()) {
-    IO::log << IO::log_offset << "Bound Species (D1/D2 - density of states at dissociation energy (DE)/reference energy):\n"
-	    << IO::log_offset 
-	    << std::setw(5)  << "Name"
-	    << std::setw(7)  << "Depth"
-	    << std::setw(7)  << "DE"
-	    << std::setw(9) << "*D1"
-	    << std::setw(9) << "*D2"
-	    << "\n"
-	    << IO::log_offset 
-	    << std::setw(5)  << ""
-	    << std::setw(7)  << "1/cm"
-	    << std::setw(7)  << "1/cm"
-	    << std::setw(9) << "cm"
-	    << std::setw(9) << "cm"
-	    << "\n";
+  void cache_get (std::istream& from, Lapack::Vector& v)
+  {
+    int n;
+    cache_get(from, n);
 
-    for(int w = 0; w < Model::well_size(); ++w) {
-      IO::log << IO::log_offset 
-	      << std::setw(5) << Model::well(w).name();
-      dtemp = energy_reference() - double(well(w).size()) * energy_step();
-      IO::log << std::setw(7) << (int)std::ceil(dtemp / Phys_const::incm);
-      dtemp = energy_reference() - double(cum_stat_num[w].size()) * energy_step();
-      IO::log << std::setw(7) << (int)std::ceil(dtemp  / Phys_const::incm);
+    if(n) {
+      v.resize(n);
+      cache_get(from, (double*)v, n);
+    }
+  }
 
-      if(cum_stat_num[w].size() != well(w).size())
-	itemp = cum_stat_num[w].size();
-      else
-	itemp = well(w).size() - 1;
+  void cache_get (std::istream& from, Lapack::Matrix& m)
+  {
+    int n1, n2;
+    cache_get(from, n1);
+    cache_get(from, n2);
 
-      IO::log << std::setw(9) << well(w).state_density(itemp) * Phys_const::incm
-	      << std::setw(9) << well(w).state_density(0) * Phys_const::incm
-	      << "\n";
+    if(n1) {
+      m.resize(n1, n2);
+      cache_get(from, (double*)m, n1 * n2);
     }
   }
 
-  if(Model::inner_barrier_size()) {
-    IO::log << IO::log_offset << "Well-to-Well Barriers (N - number of states at the reference energy):\n"
-	    << IO::log_offset 
-	    << std::setw(5)  << "Name"
-	    << std::setw(7)  << "Height"
-	    << std::setw(9) << "*N"
-	    << "\n"
-	    << IO::log_offset 
-	    << std::setw(5)  << ""
-	    << std::setw(7)  << "1/cm"
-	    << std::setw(9) << ""
-	    << "\n";
+  void cache_get (std::istream& from, Lapack::SymmetricMatrix& m)
+  {
+    int n;
+    cache_get(from, n);
 
-    for(int b = 0; b < Model::inner_barrier_size(); ++b) {
-      IO::log << IO::log_offset 
-	      << std::setw(5) << Model::inner_barrier(b).name();
-      dtemp = energy_reference() - double(inner_barrier(b).size()) * energy_step();
-      IO::log << std::setw(7) << (int)std::ceil(dtemp / Phys_const::incm)
-	      << std::setw(9) << inner_barrier(b).state_number(0)
-	      << "\n";
+    if(n) {
+      m.resize(n);
+      cache_get(from, (double*)m, n * (n + 1) / 2);
     }
   }
 
-  if(Model::outer_barrier_size()) {
-    IO::log << IO::log_offset 
-	    << "Well-to-Bimolecular Barriers (N - number of states at the reference energy):\n"
-	    << IO::log_offset 
-	    << std::setw(5)  << "Name"
-	    << std::setw(7)  << "Height"
-	    << std::setw(9) << "*N"
-	    << "\n"
-	    << IO::log_offset 
-	    << std::setw(5)  << ""
-	    << std::setw(7)  << "1/cm"
-	    << std::setw(9) << ""
-	    << "\n";
+  void cache_get (std::istream& from, Lapack::GeneralBandMatrix& m)
+  {
+    int n, b;
+    cache_get(from, n);
+    cache_get(from, b);
 
-    for(int b = 0; b < Model::outer_barrier_size(); ++b) {
-      IO::log << IO::log_offset 
-	      << std::setw(5) << Model::outer_barrier(b).name();
-      dtemp = energy_reference() - double(outer_barrier(b).size()) * energy_step();
-      IO::log << std::setw(7) <<  (int)std::ceil(dtemp / Phys_const::incm)
-	      << std::setw(9) << outer_barrier(b).state_number(0)
-	      << "\n";
+    if(n) {
+      m.resize(n, b);
+      cache_get(from, (double*)m, n * (2 * b - 1));
     }
   }
 
-  // bimolecular partition function units
-  const double bpu = Phys_const::cm * Phys_const::cm * Phys_const::cm;
+  // everything the wells, barriers, and bimolecular species depend on
+  //
+  std::string state_cache_key ()
+  {
+    // layout of the cached objects
+    static const int state_cache_format = 2;
 
-  IO::log << IO::log_offset << "Effective equilibrium constants(bimolecular units - cm^3):\n"
-	  << IO::log_offset << std::setw(5) << "Q/Q";
-  for(int w = 0; w < Model::well_size(); ++w)
-    IO::log << std::setw(10) << Model::well(w).name();
-  for(int p = 0; p < Model::bimolecular_size(); ++p)
-    if(!Model::bimolecular(p).dummy())
-      IO::log << std::setw(10) << Model::bimolecular(p).name();
-  IO::log << "\n";
+    std::ostringstream key;
 
-  for(int w = 0; w < Model::well_size(); ++w) {
-    IO::log << IO::log_offset << std::setw(5) << Model::well(w).name();
-    for(int w1 = 0; w1 < Model::well_size(); ++w1)
-      IO::log << std::setw(10) << well(w).weight() / well(w1).weight();
-    for(int p1 = 0; p1 < Model::bimolecular_size(); ++p1)
-      if(!Model::bimolecular(p1).dummy())
-	IO::log << std::setw(10) << well(w).weight() / bimolecular(p1).weight() / bpu;
-    IO::log << "\n";
-  }
-  for(int p = 0; p < Model::bimolecular_size(); ++p) {
-    if(Model::bimolecular(p).dummy())
-      continue;
-    IO::log << IO::log_offset << std::setw(5) << Model::bimolecular(p).name();
-    for(int w1 = 0; w1 < Model::well_size(); ++w1)
-      IO::log << std::setw(10) << bimolecular(p).weight() * bpu / well(w1).weight();
-    for(int p1 = 0; p1 < Model::bimolecular_size(); ++p1)
-      if(!Model::bimolecular(p1).dummy())
-	IO::log << std::setw(10) << bimolecular(p).weight() / bimolecular(p1).weight();
-    IO::log << "\n";
+    key << std::setprecision(17)
+	<< state_cache_format                     << " "
+	<< temperature()                          << " "
+	<< energy_step()                          << " "
+	<< energy_reference()                     << " "
+	<< well_cutoff                            << " "
+	<< is_global_cutoff                       << " "
+	<< (is_global_cutoff ? global_cutoff : 0.) << " "
+	<< Model::energy_limit()                  << " "
+	<< Model::atom_dist_min                   << " "
+	<< Model::Tunnel::action_max()            << "\n"
+	<< state_cache_model;
+
+    return key.str();
   }
-  IO::log << IO::log_offset << "Real equilibrium constants(bimolecular units - cm^3):\n"
-	  << IO::log_offset << std::setw(5) << "Q/Q";
-  for(int w = 0; w < Model::well_size(); ++w)
-    IO::log << std::setw(10) << Model::well(w).name();
-  for(int p = 0; p < Model::bimolecular_size(); ++p)
-    if(!Model::bimolecular(p).dummy())
-      IO::log << std::setw(10) << Model::bimolecular(p).name();
-  IO::log << "\n";
 
-  for(int w = 0; w < Model::well_size(); ++w) {
-    IO::log << IO::log_offset << std::setw(5) << Model::well(w).name();
-    for(int w1 = 0; w1 < Model::well_size(); ++w1)
-      IO::log << std::setw(10) << well(w).real_weight() / well(w1).real_weight();
-    for(int p1 = 0; p1 < Model::bimolecular_size(); ++p1)
-      if(!Model::bimolecular(p1).dummy())
-	IO::log << std::setw(10) << well(w).real_weight() / bimolecular(p1).weight() / bpu;
-    IO::log << "\n";
+  std::string state_cache_file (const std::string& key)
+  {
+    return state_cache_dir + "/" + IO::hash_name(key) + ".cache";
   }
-  for(int p = 0; p < Model::bimolecular_size(); ++p) {
-    if(Model::bimolecular(p).dummy())
-      continue;
-    IO::log << IO::log_offset << std::setw(5) << Model::bimolecular(p).name();
-    for(int w1 = 0; w1 < Model::well_size(); ++w1)
-      IO::log << std::setw(10) << bimolecular(p).weight() * bpu / well(w1).real_weight();
-    for(int p1 = 0; p1 < Model::bimolecular_size(); ++p1)
-      if(!Model::bimolecular(p1).dummy())
-	IO::log << std::setw(10) << bimolecular(p).weight() / bimolecular(p1).weight();
-    IO::log << "\n";
+
+  bool load_state_cache ()
+  {
+    const std::string key  = state_cache_key();
+    const std::string name = state_cache_file(key);
+
+    std::ifstream from(name.c_str(), std::ios::binary);
+
+    if(!from)
+      return false;
+
+    try {
+      int itemp;
+
+      cache_get(from, itemp);
+
+      std::string stemp(itemp == key.size() ? itemp : 0, ' ');
+
+      if(itemp != key.size() || !from.read(&stemp[0], itemp) || stemp != key) {
+	IO::log << IO::log_offset << "WARNING: state cache " << name << " does not match the model, ignoring\n";
+	return false;
+      }
+
+      std::vector<SharedPointer<Well> >        well_cache(Model::well_size());
+      std::vector<SharedPointer<Barrier> >     inner_cache(Model::inner_barrier_size());
+      std::vector<SharedPointer<Barrier> >     outer_cache(Model::outer_barrier_size());
+      std::vector<SharedPointer<Bimolecular> > bim_cache(Model::bimolecular_size());
+
+      for(int w = 0; w < well_cache.size(); ++w)
+	well_cache[w] = SharedPointer<Well>(new Well(from));
+
+      for(int b = 0; b < inner_cache.size(); ++b)
+	inner_cache[b] = SharedPointer<Barrier>(new Barrier(from));
+
+      for(int b = 0; b < outer_cache.size(); ++b)
+	outer_cache[b] = SharedPointer<Barrier>(new Barrier(from));
+
+      for(int p = 0; p < bim_cache.size(); ++p)
+	bim_cache[p] = SharedPointer<Bimolecular>(new Bimolecular(from));
+
+      context()._well          = well_cache;
+      context()._inner_barrier = inner_cache;
+      context()._outer_barrier = outer_cache;
+      context()._bimolecular   = bim_cache;
+    }
+    catch(Error::General) {
+      //
+      IO::log << IO::log_offset << "WARNING: cannot read state cache " << name << ", ignoring\n";
+      return false;
+    }
+
+    IO::log << IO::log_offset << "wells, barriers, and bimolecular are read from " << name << "\n";
+
+    return true;
   }
-  IO::log << std::setprecision(6);
 
-  // High pressure well-to-well rate coefficients
-  if(Model::well_size()) {
-    Lapack::Matrix ww_rate(Model::well_size());
-    ww_rate = 0.;
-    for(int b = 0; b < Model::inner_barrier_size(); ++b) {
-      int w1 = Model::inner_connect(b).first;
-      int w2 = Model::inner_connect(b).second;
-      rate_data[std::make_pair(w1, w2)] = temperature() / 2. / M_PI / Phys_const::herz
-	* inner_barrier(b).real_weight() / well(w1).real_weight();
+  void save_state_cache ()
+  {
+    if(IO::mpi_rank)
+      return;
+
+    const std::string key  = state_cache_key();
+    const std::string name = state_cache_file(key);
 
-      rate_data[std::make_pair(w2, w1)] = temperature() / 2. / M_PI / Phys_const::herz
-	* inner_barrier(b).real_weight() / well(w2).real_weight();
+    IO::AtomicFile to(name);
+
+    if(!to) {
+      IO::log << IO::log_offset << "WARNING: cannot open state cache file " << to.tmp_name() << "\n";
+      return;
     }
+
+    cache_put(to, (int)key.size());
+    to.write(key.data(), key.size());
+
+    for(int w = 0; w < Model::well_size(); ++w)
+      well(w).save(to);
+
+    for(int b = 0; b < Model::inner_barrier_size(); ++b)
+      inner_barrier(b).save(to);
+
+    for(int b = 0; b < Model::outer_barrier_size(); ++b)
+      outer_barrier(b).save(to);
+    
+    for(int p = 0; p < Model::bimolecular_size(); ++p)
+      bimolecular(p).save(to);
+
+    if(!to.commit())
+      IO::log << IO::log_offset << "WARNING: cannot write state cache file " << name << "\n";
   }
 
-  // High pressure well-to-bimolecular and bimolecular-to-well rate coefficients
-  if(Model::well_size() && Model::bimolecular_size()) {
-    // well-to-bimolecular
-    for(int b = 0; b < Model::outer_barrier_size(); ++b) {
-      int w = Model::outer_connect(b).first;
-      rate_data[std::make_pair(w, Model::outer_connect(b).second + Model::well_size())] = 
-	temperature() / 2. / M_PI / Phys_const::herz
-	* outer_barrier(b).real_weight() / well(w).real_weight();
+  // energy grid size of the well density of states
+  //
+  int well_state_size (const Model::Well& model)
+  {
+    int itemp;
+
+    int res = (int)std::ceil((energy_reference() - model.ground()) / energy_step());
+
+    // truncate, if necessary, the well
+    //
+    if(well_cutoff > 0.) {
+      //
+      itemp = (int)std::ceil((energy_reference() - model.dissociation_limit +
+			      well_cutoff * temperature()) / energy_step());
+
+      if(itemp < res)
+	//
+	res = itemp;
     }
 
-    // bimolecular-to-well
-    for(int b = 0; b < Model::outer_barrier_size(); ++b) {
-      int p = Model::outer_connect(b).second;
-      if(bimolecular(p).weight() > 0.)
-	rate_data[std::make_pair(p + Model::well_size(), Model::outer_connect(b).first)] =
-	  temperature() / 2. / M_PI / bru
-	  * outer_barrier(b).real_weight() / bimolecular(p).weight();
+    if(is_global_cutoff) {
+      itemp =(int)std::ceil((energy_reference() - global_cutoff) / energy_step());
+      res = itemp < res ? itemp : res;
     }
-  }
 
-  // capture
-  capture.clear();
-  for(int b = 0; b < Model::outer_barrier_size(); ++b) {
-    int w = Model::outer_connect(b).first;
-    int p = Model::outer_connect(b).second;
-    if(bimolecular(p).weight() > 0.)
-      capture[p + Model::well_size()] += temperature() / 2. / M_PI / bru
-	* outer_barrier(b).real_weight() / bimolecular(p).weight();
-    capture[w] += temperature() / 2. / M_PI / Phys_const::herz
-      * outer_barrier(b).real_weight() / well(w).real_weight();
+    return res;
   }
 
-  for(int b = 0; b < Model::inner_barrier_size(); ++b) {
-    int w1 = Model::inner_connect(b).first;
-    int w2 = Model::inner_connect(b).second;
-    capture[w1] += temperature() / 2. / M_PI / Phys_const::herz
-      * inner_barrier(b).real_weight() / well(w1).real_weight();
-    capture[w2] += temperature() / 2. / M_PI / Phys_const::herz
-      * inner_barrier(b).real_weight() / well(w2).real_weight();
+  // energy grid size of the barrier number of states
+  //
+  int barrier_state_size (const Model::Species& model)
+  {
+    int itemp;
+
+    int res = (int)std::ceil((energy_reference() - model.ground()) / energy_step());
+
+    if(is_global_cutoff) {
+      itemp =(int)std::ceil((energy_reference() - global_cutoff) / energy_step());
+      res = itemp < res ? itemp : res;
+    }
+
+    return res;
   }
 
-  // hot energies
-  if(hot_energy.size()) {
-    hot_index.clear();
-    hot_energy_size = 0;
-    std::map<std::string, std::vector<double> >::const_iterator hit;
+  // the species states on the energy grid are tabulated concurrently, one species per task,
+  // before the wells and barriers are set in the input order; the tables are
+  // kept in the species cache (see Model::Species::states_table), nothing is logged here
+  //
+  void tabulate_states ()
+  {
+    std::map<const Model::Species*, int> task_map;
+
     for(int w = 0; w < Model::well_size(); ++w) {
-      hit = hot_energy.find(Model::well(w).name());
-      if(hit != hot_energy.end()) {
-	for(int i = 0; i < hit->second.size(); ++i) {
-	  itemp = int((energy_reference() - hit->second[i]) / energy_step());
-	  if(itemp >= 0 && itemp < well(w).size()) {
-	    hot_index[w].push_back(itemp);
-	    ++hot_energy_size;
-	  }
-	}
-      }
+      const Model::Species* sp = &*Model::well(w).species();
+      int size = well_state_size(Model::well(w));
+      if(task_map[sp] < size)
+	task_map[sp] = size;
     }
-  }// hot energies
 
-}
+    for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+      const Model::Species* sp = &Model::inner_barrier(b);
+      int size = barrier_state_size(*sp);
+      if(task_map[sp] < size)
+	task_map[sp] = size;
+    }
 
-/********************************************************************************************
- ************************************** SETTING WELL ****************************************
- ********************************************************************************************/
+    for(int b = 0; b < Model::outer_barrier_size(); ++b) {
+      const Model::Species* sp = &Model::outer_barrier(b);
+      int size = barrier_state_size(*sp);
+      if(task_map[sp] < size)
+	task_map[sp] = size;
+    }
 
-// set state density, relaxation mode basis, collisional energy transfer kernal,
-// partition function, etc.
+    std::vector<std::pair<const Model::Species*, int> > task(task_map.begin(), task_map.end());
 
-void  MasterEquation::Well::_set_state_density (const Model::Well& model)
-{
-  const char funame [] = "MasterEquation::Well::_set_state_density: ";
+    if(task.size() < 2)
+      return;
 
-  int    itemp;
-  double dtemp;
-  bool   btemp;
+    std::exception_ptr error;
 
-  /***************************** SETTING DENSITY OF STATES ************************************/
+    // the species may use the dense eigensolvers
+    Threads::BlasScope blas_scope(1);
 
-  int new_size = (int)std::ceil((energy_reference() - model.ground()) / energy_step());
+    // the context is resolved outside of the parallel region
+    const double eref  = energy_reference();
+    const double estep = energy_step();
 
-  // truncate, if necessary, the well
-  //
-  if(well_cutoff > 0.) {
-    //
-    itemp = (int)std::ceil((energy_reference() - model.dissociation_limit + 
-			    well_cutoff * temperature()) / energy_step());
-    
-    if(itemp < new_size)
+#pragma omp parallel for default(shared) schedule(dynamic, 1)
+
+    for(int t = 0; t < task.size(); ++t) {
       //
-      new_size = itemp;
+      try {
+	task[t].first->states_table(eref, estep, task[t].second);
+      }
+      catch(...) {
+#pragma omp critical(tabulate_states)
+	if(!error)
+	  error = std::current_exception();
+      }
+    }
+
+    if(error)
+      std::rethrow_exception(error);
   }
 
-  if(is_global_cutoff) {
-    itemp =(int)std::ceil((energy_reference() - global_cutoff) / energy_step());
-    new_size = itemp < new_size ? itemp : new_size;      
+  // resident species as they are set from the model, before the truncation and the closure;
+  // the signature holds the model energies the species depend on
+  struct ResidentSpecies {
+    std::string signature;
+    std::string state;
+  };
+
+  // by the state cache key (energy grid), then by the species tag
+  std::map<std::string, std::map<std::string, ResidentSpecies> > resident_pool;
+
+  template <typename T>
+  bool resident_get (const std::map<std::string, ResidentSpecies>& pool, const std::string& tag,
+		     const std::string& signature, SharedPointer<T>& obj)
+  {
+    std::map<std::string, ResidentSpecies>::const_iterator it = pool.find(tag);
+
+    if(it == pool.end() || it->second.signature != signature)
+      return false;
+
+    std::istringstream from(it->second.state);
+    obj = SharedPointer<T>(new T(from));
+
+    return true;
   }
 
-  _state_density.resize(new_size);
-  resize_thermal_factor(new_size);
+  template <typename T>
+  void resident_put (std::map<std::string, ResidentSpecies>& pool, const std::string& tag,
+		     const std::string& signature, const T& obj)
+  {
+    std::ostringstream to;
+    obj.save(to);
 
-  // setting state density
-  //
-  double ener = energy_reference();
-  
-  for(int e = 0; e < size(); ++e, ener -= energy_step()) {
-    dtemp = model.states(ener);
-    if(dtemp <= 0.) {
-      IO::log << IO::log_offset << model.name()  << " Well: nonpositive density at " 
-	      << ener / Phys_const::incm << " 1/cm => truncating\n";
-      _state_density.resize(e);      
-      break;    
-    }
-    _state_density[e] = dtemp;
+    ResidentSpecies& res = pool[tag];
+    res.signature = signature;
+    res.state     = to.str();
   }
-}
 
-void MasterEquation::Well::_set_kernel (const Model::Well& model) 
-{
-  const char funame [] = "MasterEquation::Well::_set_kernel: ";
+  std::string resident_tag (char c, int i)
+  {
+    std::ostringstream tag;
+    tag << c << i;
+    return tag.str();
+  }
 
-  int    itemp;
-  double dtemp;
-  bool   btemp;
+  std::string resident_signature (double e1, double e2 = 0.)
+  {
+    std::ostringstream sig;
+    sig << std::setprecision(17) << e1 << " " << e2;
+    return sig.str();
+  }
 
-  // well extension
-  //
-  if(model.extension() > 0.) {
-    //
-    itemp = std::ceil((energy_reference() - model.dissociation_limit
-		       + model.extension() * temperature()) / energy_step());
-    
-    if(itemp > size()) {
-      //
-      dtemp = _state_density.back();
+  // only the species changed since the previous set are set again
+  void set_resident_species ()
+  {
+    std::map<std::string, ResidentSpecies>& pool = resident_pool[state_cache_key()];
 
-      int old_size = size();
+    std::vector<std::string> well_sig(Model::well_size());
+    for(int w = 0; w < well_sig.size(); ++w)
+      well_sig[w] = resident_signature(Model::well(w).ground(), Model::well(w).dissociation_limit);
 
-      _state_density.resize(itemp);
-      for(int e = old_size; e < size(); ++e)
-	_state_density[e] = dtemp;
+    std::vector<std::string> inner_sig(Model::inner_barrier_size());
+    for(int b = 0; b < inner_sig.size(); ++b)
+      inner_sig[b] = resident_signature(Model::inner_barrier(b).ground(), Model::inner_barrier(b).real_ground());
+
+    std::vector<std::string> outer_sig(Model::outer_barrier_size());
+    for(int b = 0; b < outer_sig.size(); ++b)
+      outer_sig[b] = resident_signature(Model::outer_barrier(b).ground(), Model::outer_barrier(b).real_ground());
+
+    std::vector<std::string> bim_sig(Model::bimolecular_size());
+    for(int p = 0; p < bim_sig.size(); ++p)
+      bim_sig[p] = resident_signature(Model::bimolecular(p).ground());
+
+    // the first set on the energy grid may come from the state cache
+    if(pool.empty() && state_cache_dir.size() && load_state_cache()) {
+      for(int w = 0; w < well_sig.size(); ++w) {
+	context()._well[w]->set_buffer_fraction();
+	resident_put(pool, resident_tag('W', w), well_sig[w], *context()._well[w]);
+      }
+      for(int b = 0; b < inner_sig.size(); ++b)
+	resident_put(pool, resident_tag('I', b), inner_sig[b], *context()._inner_barrier[b]);
+      for(int b = 0; b < outer_sig.size(); ++b)
+	resident_put(pool, resident_tag('O', b), outer_sig[b], *context()._outer_barrier[b]);
+      for(int p = 0; p < bim_sig.size(); ++p)
+	resident_put(pool, resident_tag('P', p), bim_sig[p], *context()._bimolecular[p]);
+
+      return;
     }
-  }
 
+    context()._well.resize(Model::well_size());
+    context()._inner_barrier.resize(Model::inner_barrier_size());
+    context()._outer_barrier.resize(Model::outer_barrier_size());
+    context()._bimolecular.resize(Model::bimolecular_size());
 
-  double a, c;
+    int reset_size = 0;
+    int total_size = well_sig.size() + inner_sig.size() + outer_sig.size() + bim_sig.size();
 
-  btemp = false;
+    std::vector<bool> well_reset(Model::well_size());
+    for(int w = 0; w < well_sig.size(); ++w)
+      if(!resident_get(pool, resident_tag('W', w), well_sig[w], context()._well[w])) {
+	well_reset[w] = true;
+	++reset_size;
+      }
+      // the buffer gas composition may have changed
+      else
+	context()._well[w]->set_buffer_fraction();
 
-  do {
-    //
-    _kernel.resize(size());
-    _kernel = 0.;
+    std::vector<bool> inner_reset(Model::inner_barrier_size());
+    for(int b = 0; b < inner_sig.size(); ++b)
+      if(!resident_get(pool, resident_tag('I', b), inner_sig[b], context()._inner_barrier[b])) {
+	inner_reset[b] = true;
+	++reset_size;
+      }
 
-    Lapack::Matrix tmp_kernel(size());
+    std::vector<bool> outer_reset(Model::outer_barrier_size());
+    for(int b = 0; b < outer_sig.size(); ++b)
+      if(!resident_get(pool, resident_tag('O', b), outer_sig[b], context()._outer_barrier[b])) {
+	outer_reset[b] = true;
+	++reset_size;
+      }
 
-    for(int b = 0; b < Model::buffer_size(); ++b) {
+    std::vector<bool> bim_reset(Model::bimolecular_size());
+    for(int p = 0; p < bim_sig.size(); ++p)
+      if(!resident_get(pool, resident_tag('P', p), bim_sig[p], context()._bimolecular[p])) {
+	bim_reset[p] = true;
+	++reset_size;
+      }
 
-      /********************* SETTING COLLISIONAL ENERGY TRANSFER KERNEL ****************************/
+    if(reset_size < total_size)
+      IO::log << IO::log_offset << total_size - reset_size << " resident species reused, "
+	      << reset_size << " set again\n";
 
-      tmp_kernel = 0.;
+    if(!reset_size)
+      return;
 
-      // collisional energy transfer down probability distribution on the grid
-      //
-      itemp = (int)std::ceil(model.kernel(b)->cutoff_energy(temperature()) / energy_step());
-      
-      std::vector<double> energy_transfer_form(itemp);
-      
-      for(int i = 0; i < energy_transfer_form.size(); ++i)
-	//
-	energy_transfer_form[i] = (*model.kernel(b))((double)i * energy_step(), temperature());
+    tabulate_states();
 
-      if(!b || kernel_bandwidth < energy_transfer_form.size())
-	//
-	kernel_bandwidth = energy_transfer_form.size();
+    for(int w = 0; w < well_sig.size(); ++w)
+      if(well_reset[w]) {
+	context()._well[w] = SharedPointer<Well>(new Well(Model::well(w)));
+	resident_put(pool, resident_tag('W', w), well_sig[w], *context()._well[w]);
+      }
 
-      // energy transfer UP probability functional form predefined
-      //
-      if(Model::Kernel::flags() & Model::Kernel::UP) {
-	//
-	for(int i = size() - 1; i >= 0; --i) {// energy grid cycle
+    for(int b = 0; b < inner_sig.size(); ++b)
+      if(inner_reset[b]) {
+	context()._inner_barrier[b] = SharedPointer<Barrier>(new Barrier(Model::inner_barrier(b)));
+	resident_put(pool, resident_tag('I', b), inner_sig[b], *context()._inner_barrier[b]);
+      }
 
-	  itemp = i + energy_transfer_form.size();
-	  const int jmax = itemp < size() ? itemp : size(); 
-	  itemp = i - energy_transfer_form.size() + 1;
-	  const int jmin = itemp  > 0 ? itemp : 0;
+    for(int b = 0; b < outer_sig.size(); ++b)
+      if(outer_reset[b]) {
+	context()._outer_barrier[b] = SharedPointer<Barrier>(new Barrier(Model::outer_barrier(b)));
+	resident_put(pool, resident_tag('O', b), outer_sig[b], *context()._outer_barrier[b]);
+      }
 
-	  // normalization constant
-	  //
-	  c = 0.;
-	  for(int j = jmin; j <= i; ++j) {
-	    dtemp = energy_transfer_form[i - j];
-	    if(Model::Kernel::flags() & Model::Kernel::DENSITY)
-	      dtemp *= state_density(j);
-	    tmp_kernel(i, j) = -dtemp;
-	    c += dtemp;
-	  }
+    for(int p = 0; p < bim_sig.size(); ++p)
+      if(bim_reset[p]) {
+	context()._bimolecular[p] = SharedPointer<Bimolecular>(new Bimolecular(Model::bimolecular(p)));
+	resident_put(pool, resident_tag('P', p), bim_sig[p], *context()._bimolecular[p]);
+      }
 
-	  // down-transitions contribution
-	  //
-	  a = kernel_fraction(b);
-	  for(int j = i + 1; j < jmax; ++j) {
-	    //
-	    a += tmp_kernel(i, j);
-	  }
-    
-	  if(a <= 0.) {
-	    //
-	    std::cerr << model.name() << " Well: cannot satisfy the constant collision rate at energy = "
-		      << (energy_reference() - (double)i * energy_step()) / Phys_const::incm
-		      << " 1/cm\n";
-	    
-	    throw Error::Logic();
-	  }
-	  else {
-	    //
-	    a /= c;
+    if(reset_size == total_size && state_cache_dir.size())
+      save_state_cache();
+  }
+}
 
-	    for(int j = jmin; j < i; ++j) {
-	      //
-	      tmp_kernel(i, j) *= a;
-	      
-	      tmp_kernel(j, i) = tmp_kernel(i, j) * state_density(i) / state_density(j) * thermal_factor(i - j);
-	    }
-      
-	    tmp_kernel(i, i) = tmp_kernel(i, i) * a + kernel_fraction(b);
-	  }
-	}// energy grid cycle
-      }
-      // energy transfer DOWN probability functional form predefined
-      //
-      else {
-	//
-	for(int i = 0; i < size(); ++i) {// energy grid cycle
+void MasterEquation::lower_energy_reference (double tol)
+{
+  const char funame [] = "MasterEquation::lower_energy_reference: ";
 
-	  itemp = i + energy_transfer_form.size();
-	  const int jmax = itemp < size() ? itemp : size(); 
-	  itemp = i - energy_transfer_form.size() + 1;
-	  const int jmin = itemp  > 0 ? itemp : 0;
+  if(tol <= 0. || tol >= 1.) {
+    std::cerr << funame << "tolerance out of range: " << tol << "\n";
+    throw Error::Range();
+  }
 
-	  // normalization constant
-	  //
-	  c = 0.;
-	  
-	  for(int j = i; j < jmax; ++j) {
-	    //
-	    dtemp = energy_transfer_form[j - i];
-	    
-	    if(Model::Kernel::flags() & Model::Kernel::DENSITY)
-	      //
-	      dtemp *= state_density(j);
-	    
-	    tmp_kernel(i, j) = -dtemp;
-	    
-	    c += dtemp;
-	  }
+  tabulate_states();
 
-	  // up-transitions contribution
-	  //
-	  a = kernel_fraction(b);
-	  
-	  for(int j = jmin; j < i; ++j)
-	    //
-	    a += tmp_kernel(i, j);
-	  
-    
-	  if(a < 0.) {
-	    //
-	    IO::log << IO::log_offset << model.name() 
-		    << " Well: cannot satisfy the constant collision frequency at energy = "
-		    << (energy_reference() - (double)i * energy_step()) / Phys_const::incm
-		    << " 1/cm";
-	    
-	    if(Model::Kernel::flags() & Model::Kernel::NOTRUN) {
-	      //
-	      dtemp = kernel_fraction(b) - a;
-	      
-	      IO::log << ", collision frequency = " << dtemp << "\n";
-	      tmp_kernel(i, i) = dtemp;
-	      for(int j = i + 1; j < jmax; ++j) {
-		tmp_kernel(i, j) = 0.;
-		tmp_kernel(j, i) = 0.;
-	      }
-	    }
-	    else {
-	      IO::log << ", truncating the well\n";
-	      _state_density.resize(i);
-	      break;
-	    }
-	  }
-	  else {
-	    //
-	    a /= c;
-	  
-	    for(int j = i + 1; j < jmax; ++j) {
-	      //
-	      tmp_kernel(i, j) *= a;
-	      
-	      tmp_kernel(j, i) = tmp_kernel(i, j) * state_density(i) / state_density(j) / thermal_factor(j - i);
-	    }
-	    
-	    tmp_kernel(i, i) = tmp_kernel(i, i) * a + kernel_fraction(b);
-	  }
-	}// energy grid cycle
-      }
-      
-      if(_kernel.size() != size())
-	break;
-      else
-	_kernel += tmp_kernel;
-    }
-  } while(_kernel.size() != size());
+  // species and their energy grid sizes
+  std::vector<std::pair<const Model::Species*, int> > grid;
 
-#ifdef DEBUG
-  
-  IO::log << IO::log_offset << model.name() << " well: kernel diagonal elements:\n";
-  
-  for(int i = 0; i < size(); ++i)
+  for(int w = 0; w < Model::well_size(); ++w)
+    grid.push_back(std::make_pair(&*Model::well(w).species(), well_state_size(Model::well(w))));
+
+  for(int b = 0; b < Model::inner_barrier_size(); ++b)
+    grid.push_back(std::make_pair((const Model::Species*)&Model::inner_barrier(b), barrier_state_size(Model::inner_barrier(b))));
+
+  for(int b = 0; b < Model::outer_barrier_size(); ++b)
+    grid.push_back(std::make_pair((const Model::Species*)&Model::outer_barrier(b), barrier_state_size(Model::outer_barrier(b))));
+
+  // number of the top energy bins carrying no more than the tolerance of the thermal
+  // population (wells) or of the thermal flux (barriers) of each species
+  int shift = -1;
+
+  for(int s = 0; s < grid.size(); ++s) {
     //
-    IO::log << IO::log_offset << std::setw(5) << i  << std::setw(15) << _kernel(i, i)  << "\n";
-  
-#endif
+    const int size = grid[s].second;
+
+    if(size <= 0)
+      continue;
+
+    const std::vector<double>& states = grid[s].first->states_table(energy_reference(), energy_step(), size);
+
+    // Boltzmann weights relative to the grid bottom
+    std::vector<double> weight(size);
+
+    double norm = 0.;
+    for(int i = 0; i < size; ++i) {
+      weight[i] = states[i] > 0. ? states[i] * std::exp(-double(size - 1 - i) * energy_step() / temperature()) : 0.;
+      norm += weight[i];
+    }
+
+    if(norm <= 0.)
+      continue;
+
+    int    cut  = 0;
+    double tail = weight[0];
+    while(cut < size - 1 && tail <= tol * norm)
+      tail += weight[++cut];
+
+    if(shift < 0 || cut < shift)
+      shift = cut;
+  }
 
+  if(shift <= 0)
+    return;
+
+  IO::log << IO::log_offset << "energy reference lowered by " << shift << " bins to "
+	  << (energy_reference() - (double)shift * energy_step()) / Phys_const::incm << " 1/cm (Boltzmann tail tolerance = "
+	  << tol << ")\n";
+
+  set_energy_reference(energy_reference() - (double)shift * energy_step());
 }
 
-void MasterEquation::Well::_set_crm_basis ()
+/********************************************************************************************
+ ************************************* MEMORY PRE-FLIGHT ************************************
+ ********************************************************************************************/
+
+bool MasterEquation::band_storage_available ()
 {
-  const char funame [] = "MasterEquation::Well::_set_crm_basis: ";
+  if(Model::time_evolution || ped_out.is_open() || hot_energy.size() || (Model::escape_size() && Model::bimolecular_size()))
+    return false;
 
-  int    itemp;
-  double dtemp;
-  bool   btemp;
+  for(int w = 0; w < Model::well_size(); ++w)
+    if(Model::well(w).oscillator_size())
+      return false;
 
-  /**************** SETTING RELAXATION MODE BASIS & PARTITION FUNCTION ****************/
+  return true;
+}
 
-  _boltzman.resize(size());
-  _boltzman_sqrt.resize(size());
-  _crm_basis.resize(size(), size() - 1);
-  _crm_basis = 0.;
-  _weight = 0.;
-  std::vector<double> nfac(crm_size());
-  for(int i = 0; i < size(); ++i) {
-    dtemp = state_density(i) * thermal_factor(i);
-    _boltzman[i] = dtemp;
-    _boltzman_sqrt[i] = std::sqrt(dtemp);
-    if(i) {
-      itemp = i - 1;
-      _crm_basis(i, itemp) = - _weight;
-      nfac[itemp] = std::sqrt((_weight / dtemp + 1.) * _weight);
-    }
-    for(int r = i; r < crm_size(); ++r)
-      _crm_basis(i, r) = dtemp;
-    _weight += dtemp;    
+MasterEquation::MemoryEstimate MasterEquation::memory_estimate ()
+{
+  const char funame [] = "MasterEquation::memory_estimate: ";
+
+  if(temperature() <= 0. || energy_step() <= 0.) {
+    std::cerr << funame << "temperature or energy step is not set\n";
+    throw Error::Init();
   }
 
-  for(int r = 0; r < crm_size(); ++r) {
-    itemp = r + 2;
-    for(int i = 0; i < itemp; ++i) {
-      _crm_basis(i, r) /= nfac[r];
+  MemoryEstimate res;
+
+  // the wells are stored in any case: kernel, relaxation modes basis and its bra
+  double well_mem = 0.;
+
+  long global_size = 0;
+  int  band_size   = 0;
+  for(int w = 0; w < Model::well_size(); ++w) {
+    const Model::Well& model = Model::well(w);
+
+    long size = well_state_size(model);
+
+    if(model.extension() > 0.) {
+      long itemp = std::ceil((energy_reference() - model.dissociation_limit + model.extension() * temperature()) / energy_step());
+      if(itemp > size)
+	size = itemp;
+    }
+
+    if(size < 0)
+      size = 0;
+
+    int bandwidth = 0;
+    for(int b = 0; b < Model::buffer_size(); ++b) {
+      int itemp = (int)std::ceil(model.kernel(b)->cutoff_energy(temperature()) / energy_step());
+      if(itemp > bandwidth)
+	bandwidth = itemp;
     }
+    if(bandwidth > size)
+      bandwidth = size;
+
+    if(bandwidth > band_size)
+      band_size = bandwidth;
+
+    well_mem    += (double)size * (double)bandwidth + 2. * (double)size * (double)size;
+
+    // per-buffer kernels of the mixture
+    if(Model::buffer_size() > 1)
+      well_mem += (double)Model::buffer_size() * (double)size * (double)bandwidth;
+    global_size += size;
   }
 
-  _weight_sqrt = std::sqrt(_weight);
+  // the band storage interleaves the wells grids
+  band_size *= Model::well_size();
+  if(band_size > global_size)
+    band_size = global_size;
+
+  const double n = (double)global_size;
+
+  // bimolecular, Boltzmann, and escape vectors
+  const double vec_mem = n * (double)(Model::bimolecular_size() + Model::well_size() + Model::escape_size());
+
+  // kinetic matrix, its copy in the eigensolver, and eigenvectors
+  double dense = n * (n + 1.) + n * n;
+  // pressure independent parts of the kinetic matrix
+  if(incremental_pressure)
+    dense += n * (n + 1.);
 
+  // band matrix, the shifted one, and its factorization; the lowest eigenpairs with the
+  // Lanczos iteration vectors
+  const double eval_size = Model::well_size() + (evec_out_num > 0 ? evec_out_num : 1);
+  const double banded = 3. * n * (double)band_size + 4. * n * eval_size;
+
+  res.global_size = global_size;
+  res.band_size   = band_size;
+  res.dense       = sizeof(double) * (well_mem + vec_mem + dense);
+  res.banded      = sizeof(double) * (well_mem + vec_mem + banded);
+
+  return res;
 }
 
-MasterEquation::Well::Well (const Model::Well& model)
-{
-  const char funame [] = "MasterEquation::Well: ";
+/********************************************************************************************
+ ********************************* HIGH PRESSURE LIMIT **************************************
+ ********************************************************************************************/
 
-  int                 itemp;
-  double              dtemp;
-  bool                btemp;
-  Lapack::Vector      vtemp;
-  
-  std::clock_t start_time;
+namespace MasterEquation {
+  //
+  // the temperature and the energy reference are passed in, so that the weights may be
+  // calculated outside of the caller's context
+  template <typename M>
+  double real_weight (const M& model, double t, double eref)
+  {
+    return model.weight(t) * std::exp((eref - model.ground()) / t);
+  }
 
-  _collision_factor = 0.;
-  _kernel_fraction.resize(Model::buffer_size());
-  for(int b = 0; b < Model::buffer_size(); ++b) {
-    dtemp = (*model.collision(b))(temperature()) * Model::buffer_fraction(b);
-    _kernel_fraction[b] = dtemp;
-    _collision_factor += dtemp;
+  double real_weight (const Model::Species& model, double t, double eref)
+  {
+    return model.cached_weight(t) * std::exp((eref - model.ground()) / t);
   }
 
-  for(int b = 0; b < Model::buffer_size(); ++b)
-    _kernel_fraction[b] /= _collision_factor;
+  // high pressure rate coefficients and capture/escape rates from the statistical weights
+  // of the wells, barriers, and bimolecular products, one pass over the barriers
+  //
+  void set_high_pressure_rates (const std::vector<double>& well_weight,  const std::vector<double>& inner_weight,
+				const std::vector<double>& outer_weight, const std::vector<double>& bim_weight,
+				std::map<std::pair<int, int>, double>& rate_data, std::map<int, double>& capture)
+  {
+    const double bru = Phys_const::cm * Phys_const::cm * Phys_const::cm * Phys_const::herz;
 
-  _real_weight = model.weight(temperature()) * 
-    std::exp((energy_reference() - model.ground()) / temperature());
+    const double uni_factor = temperature() / 2. / M_PI / Phys_const::herz;
+    const double bim_factor = temperature() / 2. / M_PI / bru;
 
-  // state density
-  start_time = std::clock();
+    double dtemp;
 
-  _set_state_density(model);
+    capture.clear();
 
-  IO::log << IO::log_offset << model.name() << " Well: density of states done, elapsed time[sec] = "
-	    << double(std::clock() - start_time) / CLOCKS_PER_SEC <<  std::endl;
+    // well-to-bimolecular and bimolecular-to-well
+    for(int b = 0; b < outer_weight.size(); ++b) {
+      const int w = Model::outer_connect(b).first;
+      const int p = Model::outer_connect(b).second;
 
-  // collisiona relaxation kernel
-  start_time = std::clock();
+      if(bim_weight[p] > 0.) {
+	dtemp = bim_factor * outer_weight[b] / bim_weight[p];
+	rate_data[std::make_pair(p + Model::well_size(), w)] = dtemp;
+	capture[p + Model::well_size()] += dtemp;
+      }
 
-  _set_kernel(model);
+      dtemp = uni_factor * outer_weight[b] / well_weight[w];
+      rate_data[std::make_pair(w, p + Model::well_size())] = dtemp;
+      capture[w] += dtemp;
+    }
 
-  IO::log << IO::log_offset << model.name() << " Well: collisional energy transfer kernel done, elapsed time[sec] = "
-	    << double(std::clock() - start_time) / CLOCKS_PER_SEC <<  std::endl;
+    // well-to-well
+    for(int b = 0; b < inner_weight.size(); ++b) {
+      const int w1 = Model::inner_connect(b).first;
+      const int w2 = Model::inner_connect(b).second;
 
-  // CRM basis
-  start_time = std::clock();
+      dtemp = uni_factor * inner_weight[b] / well_weight[w1];
+      rate_data[std::make_pair(w1, w2)] = dtemp;
+      capture[w1] += dtemp;
 
-  _set_crm_basis();
+      dtemp = uni_factor * inner_weight[b] / well_weight[w2];
+      rate_data[std::make_pair(w2, w1)] = dtemp;
+      capture[w2] += dtemp;
+    }
+  }
+}
 
-  IO::log << IO::log_offset << model.name() << " Well: relaxation modes basis done, elapsed time[sec] = "
-	    << double(std::clock() - start_time) / CLOCKS_PER_SEC <<  std::endl;
+void MasterEquation::high_pressure_rates (std::map<std::pair<int, int>, double>& rate_data, std::map<int, double>& capture)
+{
+  const char funame [] = "MasterEquation::high_pressure_rates: ";
 
-  // collisional relaxation kernel in CRM basis
-  //
-  start_time = std::clock();
+  IO::Marker funame_marker(funame);
 
-  _crm_bra = _crm_basis.copy();
-  for(int i = 0; i < size(); ++i)
-    _crm_bra.row(i) /= boltzman(i);
+  IO::log << IO::log_offset << "Temperature = " << temperature() / Phys_const::kelv << " K\n";
 
-  _crm_kernel = Lapack::SymmetricMatrix(_crm_basis.transpose() * _kernel * _crm_bra);
+  const int inner_start = Model::well_size();
+  const int outer_start = inner_start + Model::inner_barrier_size();
+  const int bim_start   = outer_start + Model::outer_barrier_size();
 
-  IO::log << IO::log_offset << model.name() 
-	  << " Well: kernel in relaxation modes basis done, elapsed time[sec] = "
-	  << double(std::clock() - start_time) / CLOCKS_PER_SEC <<  std::endl;  
+  std::vector<double> weight(bim_start + Model::bimolecular_size());
 
-  // minimal collisional relaxation eigenvalue
-  start_time = std::clock();
+  std::exception_ptr error;
 
-  vtemp = _crm_kernel.eigenvalues();
-  _min_relax_eval = vtemp.front();
-  _max_relax_eval = vtemp.back();
+  // the context is resolved outside of the parallel region
+  const double temp = temperature();
+  const double eref = energy_reference();
 
-  IO::log << IO::log_offset << model.name() << " Well: relaxation eigenvalues done, elapsed time[sec] = "
-	    << double(std::clock() - start_time) / CLOCKS_PER_SEC <<  std::endl;  
+  // the species may use the dense eigensolvers
+  Threads::BlasScope blas_scope(1);
 
-  IO::log << IO::log_offset << model.name() << " Well: minimal relaxation eigenvalue = "
-	  << _min_relax_eval << "\n";
-  IO::log << IO::log_offset << model.name() << " Well: maximal relaxation eigenvalue = " 
-	  << _max_relax_eval << "\n";
-
-  /*
-    #ifdef DEBUG
-    
-    start_time = std::clock();
-    
-    // symmetrized kernel eigenvalues
-    Lapack::Vector f_0(size());
-    for(int i = 0; i < size(); ++i)
-    f_0[i] = std::sqrt(state_density(i) * thermal_factor(i));
-    Lapack::SymmetricMatrix sym_kernel(size());
-    for(int i = 0; i < size(); ++i)
-    for(int j = i; j < size(); ++j)
-    sym_kernel(i, j) = kernel(i, j) * f_0[i] / f_0[j];
-    vtemp = sym_kernel.eigenvalues();
-    
-    IO::log << IO::log_offset << model.name() << " Well: symmetrized kernel eigenvalues done, elapsed time[sec] = "
-    << double(std::clock() - start_time) / CLOCKS_PER_SEC <<  std::endl;  
-    IO::log << IO::log_offset << model.name() << " Well: symmetrized kernel eigenvalues: "
-    << std::setw(13) << vtemp[0] << std::setw(13) << vtemp[1] << std::setw(13) << vtemp.back() << "\n";
-    
-    #endif
-  */
+#pragma omp parallel for default(shared) schedule(dynamic, 1)
 
-  // escape rate
-  //
-  if(model.escape()) {
+  for(int s = 0; s < weight.size(); ++s) {
     //
-    IO::log << IO::log_offset << model.name() << " Well: Escape rate:\n";
-    
-    _escape_rate.resize(size());
-    
-    double ener = energy_reference();
-
-    for(int i = 0; i < size(); ++i, ener -= energy_step()) {
-      //
-      dtemp = model.escape_rate(ener);
-
-      IO::log << IO::log_offset 
-	      << "    E[kcal/mol] = " << std::setw(13) << ener / Phys_const::kcal
-	      << "    rate[1/sec] = " << std::setw(13) << dtemp / Phys_const::herz << "\n";
-      
-      _escape_rate[i] = dtemp;
+    try {
+      if(s < inner_start)
+	weight[s] = real_weight(Model::well(s), temp, eref);
+      else if(s < outer_start)
+	weight[s] = real_weight(Model::inner_barrier(s - inner_start), temp, eref);
+      else if(s < bim_start)
+	weight[s] = real_weight(Model::outer_barrier(s - outer_start), temp, eref);
+      else
+	weight[s] = real_weight(Model::bimolecular(s - bim_start), temp, eref);
+    }
+    catch(...) {
+#pragma omp critical(high_pressure_rates)
+      if(!error)
+	error = std::current_exception();
     }
   }
 
-  // radiational transitions
-  //
-  if(model.oscillator_size()) {
-    //
-    _crm_radiation_rate.resize(crm_size());
-    
-    _radiation_rate.resize(size());
-    
-    _radiation_rate = 0.;
-    
-    _crm_radiation_rate = 0.;
+  if(error)
+    std::rethrow_exception(error);
 
-    for(int ue = 0; ue < size() - 1; ++ue) {
-      double ener = energy_reference() - (double)ue * energy_step();
-      for(int f = 0; f < model.oscillator_size(); ++f) {
+  rate_data.clear();
 
-	itemp = (int)round(model.oscillator_frequency(f) / energy_step());
-	if(!itemp)
-	  continue;
+  set_high_pressure_rates(std::vector<double>(weight.begin(),               weight.begin() + inner_start),
+			  std::vector<double>(weight.begin() + inner_start, weight.begin() + outer_start),
+			  std::vector<double>(weight.begin() + outer_start, weight.begin() + bim_start),
+			  std::vector<double>(weight.begin() + bim_start,   weight.end()),
+			  rate_data, capture);
+}
 
-	double rad_prob = model.transition_probability(ener, temperature(), f);
-	if(rad_prob <= 0.)
-	  continue;
+void MasterEquation::set (std::map<std::pair<int, int>, double>& rate_data, std::map<int, double>& capture)
+  
+{
+  const char funame [] = "MasterEquation::set: ";
 
-	int le = itemp + ue;
-	le = le < size() ? le : size() - 1; 
+  if(energy_reference() > Model::energy_limit()) {
+    std::cerr << funame << "model energy limit (" << Model::energy_limit() / Phys_const::kcal 
+	      << " kcal/mol) is lower than the energy reference (" << energy_reference() / Phys_const::kcal 
+	      << " kcal/mol)\n";
+    throw Error::Range();
+  }
 
-	dtemp = boltzman_sqrt(ue) / boltzman_sqrt(le);
-	_radiation_rate(ue, le) -= rad_prob * dtemp;
-	_radiation_rate(ue, ue) += rad_prob;
-	_radiation_rate(le, le) += rad_prob * dtemp * dtemp;
+  IO::Marker funame_marker(funame);
 
-#pragma omp parallel for default(shared) schedule(dynamic)
-	
-	for(int r1 = 0; r1 < crm_size(); ++r1) {
-	  for(int r2 = r1; r2 < crm_size(); ++r2)
-	    _crm_radiation_rate(r1, r2) += rad_prob * boltzman(ue)
-	      * (crm_bra(ue, r1) - crm_bra(le, r1))
-	      * (crm_bra(ue, r2) - crm_bra(le, r2));
-	}
-      }
-    }
-  }
-  
-  IO::log << IO::log_offset << model.name() 
-	  << " Well:       grid size = " << size() << "\n"
-	  << IO::log_offset << model.name() 
-	  << " Well:      real depth = " << int(model.ground() / Phys_const::incm) << " 1/cm\n"
-	  << IO::log_offset << model.name() 
-	  << " Well: effective depth = "
-	  << int((energy_reference() - (double)size() * energy_step()) / Phys_const::incm) << " 1/cm\n";
-}
+  rate_data.clear();
 
-/********************************************************************************************
- ************************************ SETTING BARRIER ***************************************
- ********************************************************************************************/
 
-MasterEquation::Barrier::Barrier (const Model::Species& model)
-{
-  const char funame [] = "MasterEquation::Barrier::Barrier: ";
+  context()._isset = true;
+
+  // pressure independent global matrices are set by the method at the first pressure
+  context().kin_reactive  = Lapack::SymmetricMatrix();
+  context().kin_collision = Lapack::SymmetricMatrix();
+  context().band_start    = Lapack::Vector();
+  context().crm_pressure  = -1.;
+  context().global_pop    = Lapack::Matrix();
 
   int    itemp;
   double dtemp;
 
-  int new_size = (int)std::ceil((energy_reference() - model.ground()) / energy_step());
+  IO::log << IO::log_offset << "Temperature      = " << temperature()      / Phys_const::kelv << " K\n";
+  //IO::log << IO::log_offset << "Collision rate   = " << _collision_frequency_factor * temperature() / bru << "cm^3/sec\n";
+  IO::log << IO::log_offset << "Energy reference = " << energy_reference() / Phys_const::incm << " 1/cm\n";
+  IO::log << IO::log_offset << "Energy step      = " << energy_step()      / Phys_const::incm << " 1/cm\n";
+
+  {
+    IO::Marker set_marker("setting wells, barriers, and bimolecular");
 
-  if(is_global_cutoff) {
-    itemp =(int)std::ceil((energy_reference() - global_cutoff) / energy_step());
-    new_size = itemp < new_size ? itemp : new_size;      
+    if(resident_species)
+      set_resident_species();
+    else if(!state_cache_dir.size() || !load_state_cache()) {
+      tabulate_states();
+
+      context()._well.resize(Model::well_size());
+      // wells
+      for(int w = 0; w < context()._well.size(); ++w)
+	context()._well[w] = SharedPointer<Well>(new Well(Model::well(w)));
+
+      // well-to-well barriers
+      context()._inner_barrier.resize(Model::inner_barrier_size());
+      for(int b = 0; b < context()._inner_barrier.size(); ++b)
+	context()._inner_barrier[b] = SharedPointer<Barrier>(new Barrier(Model::inner_barrier(b)));
+
+      // well-to-bimolecular barriers
+      context()._outer_barrier.resize(Model::outer_barrier_size());
+      for(int b = 0; b < context()._outer_barrier.size(); ++b)
+	context()._outer_barrier[b] = SharedPointer<Barrier>(new Barrier(Model::outer_barrier(b)));
+
+      // bimolecular products
+      context()._bimolecular.resize(Model::bimolecular_size());
+      for(int p = 0; p < context()._bimolecular.size(); ++p)
+	context()._bimolecular[p] = SharedPointer<Bimolecular>(new Bimolecular(Model::bimolecular(p)));
+
+      if(state_cache_dir.size())
+	save_state_cache();
+    }
+    // the buffer gas composition may differ from the cached one
+    else
+      for(int w = 0; w < context()._well.size(); ++w)
+	context()._well[w]->set_buffer_fraction();
   }
 
-  _state_number.resize(new_size);
-  resize_thermal_factor(new_size);
-
-  double ener = energy_reference();
-  _weight = 0.;
-  for(int e = 0; e < size(); ++e, ener -= energy_step()) {
-    dtemp = model.states(ener);
-    if(dtemp <= 0.) {
-      IO::log << IO::log_offset  << model.name() << " Barrier: nonpositive number of states at " 
-	      << ener / Phys_const::incm  << " 1/cm => truncating\n";
-      _state_number.resize(e);
-      break;
+  // checking if wells are deeper than the barriers between them
+  
+  // inner barriers
+  //
+  for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+    itemp = well(Model::inner_connect(b).first).size() <  well(Model::inner_connect(b).second).size() ?
+      well(Model::inner_connect(b).first).size() : well(Model::inner_connect(b).second).size();
+    if(itemp  < inner_barrier(b).size()) {
+      IO::log << IO::log_offset << Model::inner_barrier(b).name() 
+	      << " barrier top is lower than the bottom of one of the wells it connects => truncating\n"; 
+      context()._inner_barrier[b]->truncate(itemp);
+    }
+  }
+  
+  // outer barriers
+  //
+  for(int b = 0; b < Model::outer_barrier_size(); ++b) {
+    itemp = well(Model::outer_connect(b).first).size(); 
+    if(itemp  < outer_barrier(b).size()) {
+      IO::log << IO::log_offset << Model::outer_barrier(b).name()
+	      << " barrier top is lower than the bottom of the well it connects => truncating\n"; 
+      context()._outer_barrier[b]->truncate(itemp);
     }
-    _state_number[e] = dtemp;
-    _weight += dtemp * thermal_factor(e);
   }
-  _weight *= energy_step() / temperature();
 
-  _real_weight = model.weight(temperature()) * std::exp((energy_reference() - model.ground()) / temperature());  
+  // clipping the number of states with the maximum rate constant
+  
+  // inner barriers
+  //
+  if(rate_max > 0.) {
+    for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+      int w1 = Model::inner_connect(b).first;
+      int w2 = Model::inner_connect(b).second;
+      for(int i = 0; i < context()._inner_barrier[b]->size(); ++i) {
+	dtemp = well(w1).state_density(i) < well(w2).state_density(i) ? 
+	  well(w1).state_density(i) : well(w2).state_density(i);
+	dtemp *= rate_max * 2. * M_PI;
+	
+	if(context()._inner_barrier[b]->state_number(i) > dtemp)
+	  context()._inner_barrier[b]->state_number(i) = dtemp;
+      }
+    }
+    
+    // outer barriers
+    //
+    for(int b = 0; b < Model::outer_barrier_size(); ++b) {
+      int w = Model::outer_connect(b).first;
+      for(int i = 0; i < context()._outer_barrier[b]->size(); ++i) {
+	dtemp = rate_max * 2. * M_PI * well(w).state_density(i);
 
-  IO::log << IO::log_offset << model.name() 
-	  << " Barrier:        grid size = " << size() << "\n"
-	  << IO::log_offset << model.name() 
-	  << " Barrier:      real height = " << int(model.ground() / Phys_const::incm) << " 1/cm\n"
-	  << IO::log_offset << model.name() 
-	  << " Barrier: effective height = "
-	  << int((energy_reference() - (double)size() * energy_step()) / Phys_const::incm) << " 1/cm\n";
+	if(context()._outer_barrier[b]->state_number(i) > dtemp)
+	  context()._outer_barrier[b]->state_number(i) = dtemp;
+      }
+    }
+  }
 
-}
+  // inner barriers carrying a negligible fraction of the thermal flux out of both wells they
+  // connect are closed: the network falls apart into the sub-networks solved independently
+  //
+  if(decoupling_threshold > 0.) {
+    std::vector<double> well_flux(Model::well_size(), 0.);
+    for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+      well_flux[Model::inner_connect(b).first]  += inner_barrier(b).real_weight();
+      well_flux[Model::inner_connect(b).second] += inner_barrier(b).real_weight();
+    }
+    for(int b = 0; b < Model::outer_barrier_size(); ++b)
+      well_flux[Model::outer_connect(b).first] += outer_barrier(b).real_weight();
 
-void MasterEquation::Barrier::truncate (int new_size) 
-{
-  const char funame [] = "MasterEquation::Barrier::truncate: ";
+    for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+      if(!inner_barrier(b).size())
+	continue;
 
-  double dtemp;
-  if(new_size == size())
-    return;
+      dtemp = inner_barrier(b).real_weight();
+      if(dtemp < decoupling_threshold * well_flux[Model::inner_connect(b).first] &&
+	 dtemp < decoupling_threshold * well_flux[Model::inner_connect(b).second]) {
+	//
+	IO::log << IO::log_offset << Model::inner_barrier(b).name()
+		<< " barrier carries a negligible thermal flux => decoupling the wells it connects\n";
+	context()._inner_barrier[b]->close();
+      }
+    }
+  }
 
-  if(new_size <= 0 || new_size > size()) {
-    std::cerr << funame << "out of range\n";
-    throw Error::Range();
+  // barriers closed by the model edits
+  if(closed_barrier.size()) {
+    for(int b = 0; b < Model::inner_barrier_size(); ++b)
+      if(closed_barrier.find(Model::inner_barrier(b).name()) != closed_barrier.end())
+	context()._inner_barrier[b]->close();
+
+    for(int b = 0; b < Model::outer_barrier_size(); ++b)
+      if(closed_barrier.find(Model::outer_barrier(b).name()) != closed_barrier.end())
+	context()._outer_barrier[b]->close();
   }
 
-  dtemp = 0.;
-  for(int i = new_size; i < size(); ++i)
-    dtemp += _state_number[i] * thermal_factor(i);
-  dtemp *= energy_step() / temperature();
+  // cumulative number of states for each well, one pass over the barriers
+  context().cum_stat_num.resize(Model::well_size());
 
-  _state_number.resize(new_size);
-  _weight -= dtemp;
-  
-  IO::log << IO::log_offset << funame << "grid size = " << size() << "\n"
-	  << IO::log_offset << funame << "real weight = " << _real_weight << "\n"
-	  << IO::log_offset << funame << "effective weight = " << _weight * energy_step() << "\n";
-}
+  std::vector<int> cum_size(Model::well_size(), 0);
+  for(int b = 0; b < Model::inner_barrier_size(); ++b)
+    for(int i = 0; i < 2; ++i) {
+      const int w = i ? Model::inner_connect(b).second : Model::inner_connect(b).first;
+      if(inner_barrier(b).size() > cum_size[w])
+	cum_size[w] = inner_barrier(b).size();
+    }
+  for(int b = 0; b < Model::outer_barrier_size(); ++b) {
+    const int w = Model::outer_connect(b).first;
+    if(outer_barrier(b).size() > cum_size[w])
+      cum_size[w] = outer_barrier(b).size();
+  }
 
-/********************************************************************************************
- ********************************** SETTING BIMOLECULAR *************************************
- ********************************************************************************************/
+  for(int w = 0; w < Model::well_size(); ++w) {
+    context().cum_stat_num[w].resize(cum_size[w]);
+    context().cum_stat_num[w] = 0.;
+  }
 
-MasterEquation::Bimolecular::Bimolecular (const Model::Bimolecular& model)
-{ 
-  _weight   = model.weight(temperature()) * std::exp((energy_reference() - model.ground()) / temperature());
-}
+  for(int b = 0; b < Model::inner_barrier_size(); ++b)
+    for(int i = 0; i < 2; ++i) {
+      const int w = i ? Model::inner_connect(b).second : Model::inner_connect(b).first;
+      for(int e = 0; e < inner_barrier(b).size(); ++e)
+	context().cum_stat_num[w][e] += inner_barrier(b).state_number(e);
+    }
+  for(int b = 0; b < Model::outer_barrier_size(); ++b) {
+    const int w = Model::outer_connect(b).first;
+    for(int e = 0; e < outer_barrier(b).size(); ++e)
+      context().cum_stat_num[w][e] += outer_barrier(b).state_number(e);
+  }
 
-/********************************************************************************************
- ********************************** CALCULATION METHODS *************************************
- ********************************************************************************************/
+  /************************************** OUTPUT ***************************************/
 
-/********************************************************************************************
- ******************************* LOW CHEMICAL EIGENVALUE METHOD *****************************
- ********************************************************************************************/
+  if(evec_out.is_open()) {
+    for(int w = 0; w < Model::well_size(); ++w)
+      if(!w || well(w).size() > itemp)
+	itemp = well(w).size();
+    const int well_size_max = itemp;
+    
+    std::ostringstream title;
+    title << "Temperature = " << temperature() / Phys_const::kelv << "K\n"
+	  <<"THERMAL DISTRIBUTIONS:\n";
+    IO::put_text(evec_out, title.str());
 
-// the method based on the assumption that the chemical eigenvalues are small in comparison
-// to the relaxation eigenvalues
+    std::vector<std::string> name;
+    for(int w = 0; w < Model::well_size(); ++w)
+      name.push_back(Model::well(w).name());
 
-double triple_product ( const double* p1, const double* p2, const double* p3, int n)
-{
-  double res = 0.;
+    Lapack::Matrix dist(well_size_max, Model::well_size());
+    for(int i = 0; i < well_size_max; ++i)
+      for(int w = 0; w < Model::well_size(); ++w)
+	if(i < well(w).size())
+	  dist(i, w) = well(w).state_density(i) * thermal_factor(i) / well(w).weight_sqrt();
+	else
+	  dist(i, w) = 0.;
 
-#pragma omp parallel for default(shared) reduction(+: res) schedule(static)
-	
-  for(int i = 0; i < n; ++i) {
-    res += p1[i] * p2[i] * p3[i];
+    energy_table_output(evec_out, name, dist, well_size_max);
+    
+    IO::put_text(evec_out, "\n");
   }
 
-  return res;
-}
+  IO::log << std::setprecision(3);
 
-void MasterEquation::low_eigenvalue_matrix (Lapack::SymmetricMatrix& k_11, Lapack::SymmetricMatrix& k_33, 
-					    Lapack::Matrix& k_13, Lapack::Matrix& l_21) 
-{
-  const char funame [] = "MasterEquation::low_eigenvalue_matrix: ";
+  if(Model::well_size()) {
+    IO::log << IO::log_offset << "Bound Species (D1/D2 - density of states at dissociation energy (DE)/reference energy):\n"
+	    << IO::log_offset 
+	    << std::setw(5)  << "Name"
+	    << std::setw(7)  << "Depth"
+	    << std::setw(7)  << "DE"
+	    << std::setw(9) << "*D1"
+	    << std::setw(9) << "*D2"
+	    << "\n"
+	    << IO::log_offset 
+	    << std::setw(5)  << ""
+	    << std::setw(7)  << "1/cm"
+	    << std::setw(7)  << "1/cm"
+	    << std::setw(9) << "cm"
+	    << std::setw(9) << "cm"
+	    << "\n";
 
-  IO::Marker funame_marker(funame);
+    for(int w = 0; w < Model::well_size(); ++w) {
+      IO::log << IO::log_offset 
+	      << std::setw(5) << Model::well(w).name();
+      dtemp = energy_reference() - double(well(w).size()) * energy_step();
+      IO::log << std::setw(7) << (int)std::ceil(dtemp / Phys_const::incm);
+      dtemp = energy_reference() - double(context().cum_stat_num[w].size()) * energy_step();
+      IO::log << std::setw(7) << (int)std::ceil(dtemp  / Phys_const::incm);
 
-  if(!isset()) {
-    std::cerr << funame << "reactive complex is not set\n";
-    throw Error::Init();
+      if(context().cum_stat_num[w].size() != well(w).size())
+	itemp = context().cum_stat_num[w].size();
+      else
+	itemp = well(w).size() - 1;
+
+      IO::log << std::setw(9) << well(w).state_density(itemp) * Phys_const::incm
+	      << std::setw(9) << well(w).state_density(0) * Phys_const::incm
+	      << "\n";
+    }
   }
 
-  int            itemp;
-  double         dtemp;
-  bool           btemp;
-  std::string    stemp;
+  if(Model::inner_barrier_size()) {
+    IO::log << IO::log_offset << "Well-to-Well Barriers (N - number of states at the reference energy):\n"
+	    << IO::log_offset 
+	    << std::setw(5)  << "Name"
+	    << std::setw(7)  << "Height"
+	    << std::setw(9) << "*N"
+	    << "\n"
+	    << IO::log_offset 
+	    << std::setw(5)  << ""
+	    << std::setw(7)  << "1/cm"
+	    << std::setw(9) << ""
+	    << "\n";
 
-  Lapack::Vector vtemp;
-  Lapack::Matrix mtemp;  
+    for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+      IO::log << IO::log_offset 
+	      << std::setw(5) << Model::inner_barrier(b).name();
+      dtemp = energy_reference() - double(inner_barrier(b).size()) * energy_step();
+      IO::log << std::setw(7) << (int)std::ceil(dtemp / Phys_const::incm)
+	      << std::setw(9) << inner_barrier(b).state_number(0)
+	      << "\n";
+    }
+  }
 
-  // total collisional relaxation modes dimension and index shifts for individual wells 
-  std::vector<int> well_shift(Model::well_size());
-  itemp = 0;
-  for(int w = 0; w < Model::well_size(); itemp += well(w++).crm_size())
-    well_shift[w] = itemp;
-  
-  const int crm_size = itemp;
-  //IO::log << IO::log_offset << "global relaxation matrix size =  " << crm_size << "\n";
+  if(Model::outer_barrier_size()) {
+    IO::log << IO::log_offset 
+	    << "Well-to-Bimolecular Barriers (N - number of states at the reference energy):\n"
+	    << IO::log_offset 
+	    << std::setw(5)  << "Name"
+	    << std::setw(7)  << "Height"
+	    << std::setw(9) << "*N"
+	    << "\n"
+	    << IO::log_offset 
+	    << std::setw(5)  << ""
+	    << std::setw(7)  << "1/cm"
+	    << std::setw(9) << ""
+	    << "\n";
 
-  // kinetic relaxation matrices
-  k_11.resize(Model::well_size()); // chemical modes
-  k_13.resize(Model::well_size(),  Model::bimolecular_size()); // chemical basis
-  k_11 = 0.;
-  k_13 = 0.;
- 
-  Lapack::Matrix k_21(crm_size, Model::well_size()); // chemical-to-collision modes
-  k_21 = 0.;
-  Lapack::SymmetricMatrix k_22(crm_size); // collision modes
-  k_22 = 0.;
-  Lapack::Matrix k_23 (crm_size, Model::bimolecular_size()); // relaxational basis
-  k_23 = 0.;
-  
-  /*********************************** GLOBAL MATRICES **************************************/
+    for(int b = 0; b < Model::outer_barrier_size(); ++b) {
+      IO::log << IO::log_offset 
+	      << std::setw(5) << Model::outer_barrier(b).name();
+      dtemp = energy_reference() - double(outer_barrier(b).size()) * energy_step();
+      IO::log << std::setw(7) <<  (int)std::ceil(dtemp / Phys_const::incm)
+	      << std::setw(9) << outer_barrier(b).state_number(0)
+	      << "\n";
+    }
+  }
+
+  // bimolecular partition function units
+  const double bpu = Phys_const::cm * Phys_const::cm * Phys_const::cm;
+
+  IO::log << IO::log_offset << "Effective equilibrium constants(bimolecular units - cm^3):\n"
+	  << IO::log_offset << std::setw(5) << "Q/Q";
+  for(int w = 0; w < Model::well_size(); ++w)
+    IO::log << std::setw(10) << Model::well(w).name();
+  for(int p = 0; p < Model::bimolecular_size(); ++p)
+    if(!Model::bimolecular(p).dummy())
+      IO::log << std::setw(10) << Model::bimolecular(p).name();
+  IO::log << "\n";
+
+  for(int w = 0; w < Model::well_size(); ++w) {
+    IO::log << IO::log_offset << std::setw(5) << Model::well(w).name();
+    for(int w1 = 0; w1 < Model::well_size(); ++w1)
+      IO::log << std::setw(10) << well(w).weight() / well(w1).weight();
+    for(int p1 = 0; p1 < Model::bimolecular_size(); ++p1)
+      if(!Model::bimolecular(p1).dummy())
+	IO::log << std::setw(10) << well(w).weight() / bimolecular(p1).weight() / bpu;
+    IO::log << "\n";
+  }
+  for(int p = 0; p < Model::bimolecular_size(); ++p) {
+    if(Model::bimolecular(p).dummy())
+      continue;
+    IO::log << IO::log_offset << std::setw(5) << Model::bimolecular(p).name();
+    for(int w1 = 0; w1 < Model::well_size(); ++w1)
+      IO::log << std::setw(10) << bimolecular(p).weight() * bpu / well(w1).weight();
+    for(int p1 = 0; p1 < Model::bimolecular_size(); ++p1)
+      if(!Model::bimolecular(p1).dummy())
+	IO::log << std::setw(10) << bimolecular(p).weight() / bimolecular(p1).weight();
+    IO::log << "\n";
+  }
+  IO::log << IO::log_offset << "Real equilibrium constants(bimolecular units - cm^3):\n"
+	  << IO::log_offset << std::setw(5) << "Q/Q";
+  for(int w = 0; w < Model::well_size(); ++w)
+    IO::log << std::setw(10) << Model::well(w).name();
+  for(int p = 0; p < Model::bimolecular_size(); ++p)
+    if(!Model::bimolecular(p).dummy())
+      IO::log << std::setw(10) << Model::bimolecular(p).name();
+  IO::log << "\n";
+
+  for(int w = 0; w < Model::well_size(); ++w) {
+    IO::log << IO::log_offset << std::setw(5) << Model::well(w).name();
+    for(int w1 = 0; w1 < Model::well_size(); ++w1)
+      IO::log << std::setw(10) << well(w).real_weight() / well(w1).real_weight();
+    for(int p1 = 0; p1 < Model::bimolecular_size(); ++p1)
+      if(!Model::bimolecular(p1).dummy())
+	IO::log << std::setw(10) << well(w).real_weight() / bimolecular(p1).weight() / bpu;
+    IO::log << "\n";
+  }
+  for(int p = 0; p < Model::bimolecular_size(); ++p) {
+    if(Model::bimolecular(p).dummy())
+      continue;
+    IO::log << IO::log_offset << std::setw(5) << Model::bimolecular(p).name();
+    for(int w1 = 0; w1 < Model::well_size(); ++w1)
+      IO::log << std::setw(10) << bimolecular(p).weight() * bpu / well(w1).real_weight();
+    for(int p1 = 0; p1 < Model::bimolecular_size(); ++p1)
+      if(!Model::bimolecular(p1).dummy())
+	IO::log << std::setw(10) << bimolecular(p).weight() / bimolecular(p1).weight();
+    IO::log << "\n";
+  }
+  IO::log << std::setprecision(6);
 
+  // high pressure rate coefficients and capture/escape rates
   {
-    IO::Marker work_marker("setting up kinetic matrices", IO::Marker::ONE_LINE);
+    std::vector<double> well_weight(Model::well_size());
+    for(int w = 0; w < Model::well_size(); ++w)
+      well_weight[w] = well(w).real_weight();
 
-    // k_11 initialization
-    for(int b = 0; b < Model::inner_barrier_size(); ++b) {
-      int w1 = Model::inner_connect(b).first;
-      int w2 = Model::inner_connect(b).second;
-      dtemp = 0.;
-      for(int i = 0; i < inner_barrier(b).size(); ++i)
-	dtemp += inner_barrier(b).state_number(i) * thermal_factor(i);
-      k_11(w1, w2) = - dtemp / 2. / M_PI / well(w1).weight_sqrt() / well(w2).weight_sqrt();
-    }
-  
-    for(int w = 0; w < Model::well_size(); ++w) {
-      dtemp = 0.;
-      for(int i = 0; i < cum_stat_num[w].size(); ++i)
-	dtemp += cum_stat_num[w][i] * thermal_factor(i);
-      dtemp /= 2. * M_PI * well(w).weight();
-      k_11(w, w) = dtemp;
-      if(Model::well(w).escape()) {
-	dtemp = 0.;
-	for(int i = 0; i < well(w).size(); ++i)
-	  dtemp += well(w).escape_rate(i) * well(w).boltzman(i);
-	dtemp /= well(w).weight();
-	k_11(w, w) += dtemp;
-      }
-    }
+    std::vector<double> inner_weight(Model::inner_barrier_size());
+    for(int b = 0; b < Model::inner_barrier_size(); ++b)
+      inner_weight[b] = inner_barrier(b).real_weight();
 
-    // k_21 initialization
-    for(int b = 0; b < Model::inner_barrier_size(); ++b) {
-      int w1 = Model::inner_connect(b).first;
-      int w2 = Model::inner_connect(b).second;    
-      vtemp.resize(inner_barrier(b).size());
-      for(int dir = 0; dir < 2; ++dir) {
-	if(dir)
-	  std::swap(w1, w2);
+    std::vector<double> outer_weight(Model::outer_barrier_size());
+    for(int b = 0; b < Model::outer_barrier_size(); ++b)
+      outer_weight[b] = outer_barrier(b).real_weight();
 
-	for(int i = 0; i < inner_barrier(b).size(); ++i)
-	  vtemp[i] = inner_barrier(b).state_number(i) / 2. / M_PI / well(w1).state_density(i) 
-	    / well(w2).weight_sqrt();
+    std::vector<double> bim_weight(Model::bimolecular_size());
+    for(int p = 0; p < Model::bimolecular_size(); ++p)
+      bim_weight[p] = bimolecular(p).weight();
 
-	for(int r = 0; r < well(w1).crm_size(); ++r)
-	  k_21(r + well_shift[w1], w2) = -parallel_vdot(well(w1).crm_column(r), vtemp, vtemp.size()) ;
-      }
-    }
-    
+    set_high_pressure_rates(well_weight, inner_weight, outer_weight, bim_weight, rate_data, capture);
+  }
+
+  // hot energies
+  if(hot_energy.size()) {
+    context().hot_index.clear();
+    context().hot_energy_size = 0;
+    std::map<std::string, std::vector<double> >::const_iterator hit;
     for(int w = 0; w < Model::well_size(); ++w) {
-      if(Model::well(w).escape()) {
-	vtemp.resize(well(w).size());
-	for(int i = 0; i < well(w).size(); ++i)
-	  vtemp[i] = well(w).escape_rate(i) / well(w).weight_sqrt();
-      }
-      else {
-	vtemp.resize(cum_stat_num[w].size());
-	vtemp = 0.;
+      hit = hot_energy.find(Model::well(w).name());
+      if(hit != hot_energy.end()) {
+	for(int i = 0; i < hit->second.size(); ++i) {
+	  itemp = int((energy_reference() - hit->second[i]) / energy_step());
+	  if(itemp >= 0 && itemp < well(w).size()) {
+	    context().hot_index[w].push_back(itemp);
+	    ++context().hot_energy_size;
+	  }
+	}
       }
-      for(int i = 0; i < cum_stat_num[w].size(); ++i)
-	vtemp[i] += cum_stat_num[w][i] / 2. / M_PI / well(w).state_density(i) / well(w).weight_sqrt();
-      for(int r = 0; r < well(w).crm_size(); ++r)
-	k_21(r + well_shift[w], w) =  parallel_vdot(well(w).crm_column(r), vtemp, vtemp.size());
     }
+  }// hot energies
 
-    // k_22 initialization
-    // nondiagonal isomerization
-    for(int b = 0; b < Model::inner_barrier_size(); ++b) {
-      int w1 = Model::inner_connect(b).first;
-      int w2 = Model::inner_connect(b).second;    
+}
 
-      vtemp.resize(inner_barrier(b).size());
-      for(int i = 0; i < inner_barrier(b).size(); ++i)
-	vtemp[i] = inner_barrier(b).state_number(i) / 2. / M_PI / well(w1).state_density(i) 
-	  / well(w2).state_density(i) / thermal_factor(i);
+/********************************************************************************************
+ ************************************** SETTING WELL ****************************************
+ ********************************************************************************************/
 
-      for(int r1 = 0; r1 < well(w1).crm_size(); ++r1) 
-	for(int r2 = 0; r2 < well(w2).crm_size(); ++r2) {
-	  k_22(r1 + well_shift[w1], r2 + well_shift[w2]) =
-	    -triple_product(well(w1).crm_column(r1), well(w2).crm_column(r2), vtemp, vtemp.size());
-	}
-    }
+// set state density, relaxation mode basis, collisional energy transfer kernal,
+// partition function, etc.
 
-    // diagonal isomerization
-    for(int w = 0; w < Model::well_size(); ++w) {
-      if(Model::well(w).escape()) {
-	vtemp.resize(well(w).size());
-	for(int i = 0; i < well(w).size(); ++i)
-	  vtemp[i] = well(w).escape_rate(i) / well(w).boltzman(i);
-      }
-      else {
-	vtemp.resize(cum_stat_num[w].size());
-	vtemp = 0.;
-      }
-      for(int i = 0; i < cum_stat_num[w].size(); ++i) {
-	dtemp = well(w).state_density(i);
-	vtemp[i] += cum_stat_num[w][i] / 2. / M_PI / dtemp / dtemp / thermal_factor(i);
-      }
-
-      for(int r1 = 0; r1 < well(w).crm_size(); ++r1) 
-	for(int r2 = r1; r2 < well(w).crm_size(); ++r2) {
-	  k_22(r1 + well_shift[w], r2 + well_shift[w]) =  
-	    triple_product(well(w).crm_column(r1), well(w).crm_column(r2), vtemp, vtemp.size());
-	}
-    }
-
-    // collisional energy transfer 
-    for(int w = 0; w < Model::well_size(); ++w) {
+void  MasterEquation::Well::_set_state_density (const Model::Well& model)
+{
+  const char funame [] = "MasterEquation::Well::_set_state_density: ";
 
-#pragma omp parallel for default(shared) schedule(dynamic)
+  int    itemp;
+  double dtemp;
+  bool   btemp;
 
-      for(int r1 = 0; r1 < well(w).crm_size(); ++r1) {
-	for(int r2 = r1; r2 < well(w).crm_size(); ++r2)
-	  k_22(r1 + well_shift[w], r2 + well_shift[w]) +=  well(w).collision_frequency() * 
-	    well(w).crm_kernel(r1, r2);
-      }
-    }
+  /***************************** SETTING DENSITY OF STATES ************************************/
 
-    // radiational transitions contribution
-    for(int w = 0; w < Model::well_size(); ++w) 
-      if(well(w).radiation()) {
+  int new_size = well_state_size(model);
 
-#pragma omp parallel for default(shared) schedule(dynamic)
-	
-	for(int r1 = 0; r1 < well(w).crm_size(); ++r1) {
-	  for(int r2 = r1; r2 < well(w).crm_size(); ++r2)
-	    k_22(r1 + well_shift[w], r2 + well_shift[w]) +=  
-	    well(w).crm_radiation_rate(r1, r2);
-	}
-      }
+  _state_density.resize(new_size);
+  resize_thermal_factor(new_size);
 
-    // bimolecular number of states 
-    for(int b = 0; b < Model::outer_barrier_size(); ++b) {
-      const int w = Model::outer_connect(b).first;
-      const int p = Model::outer_connect(b).second;
+  // setting state density
+  //
+  const std::vector<double>& states = model.species()->states_table(energy_reference(), energy_step(), size());
 
-      // chemical modes
-      dtemp = 0.;
-      for(int i = 0; i < outer_barrier(b).size(); ++i)
-	dtemp += outer_barrier(b).state_number(i) * thermal_factor(i);
-      k_13(w, p) = dtemp / 2. / M_PI / well(w).weight_sqrt();
-    
-      // relaxation modes
-      vtemp.resize(outer_barrier(b).size());
-      for(int i = 0; i < outer_barrier(b).size(); ++i)
-	vtemp[i] = outer_barrier(b).state_number(i) / 2. / M_PI / well(w).state_density(i);
-    
-      for(int r = 0; r < well(w).crm_size(); ++r)
-	k_23(r + well_shift[w], p) = parallel_vdot(well(w).crm_column(r), vtemp, vtemp.size());
+  for(int e = 0; e < size(); ++e) {
+    dtemp = states[e];
+    if(dtemp <= 0.) {
+      IO::log << IO::log_offset << model.name()  << " Well: nonpositive density at " 
+	      << (energy_reference() - (double)e * energy_step()) / Phys_const::incm << " 1/cm => truncating\n";
+      _state_density.resize(e);      
+      break;    
     }
+    _state_density[e] = dtemp;
   }
+}
 
-  /****************************** SOLVING MASTER EQUATION *************************************/
+void MasterEquation::Well::_set_kernel (const Model::Well& model) 
+{
+  const char funame [] = "MasterEquation::Well::_set_kernel: ";
 
-  {
-    IO::Marker work_marker("inverting kinetic matrices", IO::Marker::ONE_LINE);
-    Lapack::Cholesky l_22(k_22);
-    l_21 = l_22.invert(k_21);
+  int    itemp;
+  double dtemp;
+  bool   btemp;
 
-    // well-to-well rate coefficients
-    k_11 -= Lapack::SymmetricMatrix(k_21.transpose() * l_21);
+  // well extension
+  //
+  if(model.extension() > 0.) {
+    //
+    itemp = std::ceil((energy_reference() - model.dissociation_limit
+		       + model.extension() * temperature()) / energy_step());
+    
+    if(itemp > size()) {
+      //
+      dtemp = _state_density.back();
 
-    if(Model::bimolecular_size()) {
-      // bimolecular-to-bimolecular rate coefficients
-      k_33 = Lapack::SymmetricMatrix(k_23.transpose() * l_22.invert(k_23)); 
+      int old_size = size();
 
-      // well-to-bimolecular rate coefficients
-      k_13 -= l_21.transpose() * k_23;
+      _state_density.resize(itemp);
+      for(int e = old_size; e < size(); ++e)
+	_state_density[e] = dtemp;
     }
   }
-}
-
-void MasterEquation::low_eigenvalue_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags) 
-  
-{
-  const char funame [] = "MasterEquation::low_eigenvalue_method: ";
 
-  IO::Marker funame_marker(funame);
 
-  int            itemp;
-  double         dtemp;
-  bool           btemp;
-  std::string    stemp;
+  double a, c;
 
-  Lapack::Vector vtemp;
-  Lapack::Matrix mtemp;  
+  // collisional energy transfer kernel only couples energies within the cutoff
+  //
+  for(int b = 0; b < Model::buffer_size(); ++b) {
+    //
+    itemp = (int)std::ceil(model.kernel(b)->cutoff_energy(temperature()) / energy_step());
 
-  IO::log << IO::log_offset << "Pressure = ";
-  switch(pressure_unit) {
-  case BAR:
-    IO::log << pressure() / Phys_const::bar << " bar";
-    break;
-  case TORR:
-    IO::log << pressure() / Phys_const::tor << " torr";
-    break;
-  case ATM:
-    IO::log << pressure() / Phys_const::atm << " atm";
-    break;
+    if(!b || kernel_bandwidth < itemp)
+      //
+      kernel_bandwidth = itemp;
   }
 
-  IO::log << "\t Temperature = "
-	  << temperature() / Phys_const::kelv << " K\n";
-  //<< IO::log_offset << "collision frequency = " 
-  //<< MasterEquation::collision_frequency() / Phys_const::herz
-  //<< " 1/sec\n";
-
-  rate_data.clear();
+  // predicting the truncation before the kernel is allocated
+  //
+  if(!(Model::Kernel::flags() & (Model::Kernel::UP | Model::Kernel::NOTRUN))) {
+    //
+    itemp = _truncation_size(model, kernel_bandwidth);
 
-  Lapack::SymmetricMatrix k_11;
-  Lapack::Matrix k_13;
-  Lapack::SymmetricMatrix k_33;
-  Lapack::Matrix l_21;
-  low_eigenvalue_matrix(k_11, k_33, k_13, l_21);
+    if(itemp < size())
+      //
+      _state_density.resize(itemp);
+  }
 
-  std::vector<int> well_shift(Model::well_size());
-  itemp = 0;
-  for(int w = 0; w < Model::well_size(); itemp += well(w++).crm_size())
-    well_shift[w] = itemp;
-  const int crm_size = itemp;
+  btemp = false;
 
-  // hot distribution
-  Lapack::Matrix hot_chem;
-  if(hot_energy_size) {
-    hot_chem.resize(hot_energy_size, Model::well_size());
-    hot_chem = 0.;
-    vtemp.resize(crm_size);
+  do {
+    //
+    if(kernel_bandwidth > size())
+      //
+      kernel_bandwidth = size();
     
-    std::map<int, std::vector<int> >::const_iterator hit;
-    int count = 0;
-    for(hit = hot_index.begin(); hit != hot_index.end(); ++hit)
-      for(int i = 0; i < hit->second.size(); ++i, ++count) {
-	hot_chem(count, hit->first) = 1. / well(hit->first).weight_sqrt();
-	
-	vtemp = 0.;
-	itemp = 0;
-	for(int r = 0; r < well(hit->first).crm_size(); ++r) 
-	  vtemp[r + well_shift[hit->first]] = well(hit->first).crm_bra(hit->second[i], r); 
-	hot_chem.row(count) -= vtemp * l_21;
-      }  
-  }
-  
-  // well escape 
-  Lapack::Matrix escape_chem;
-  if(Model::escape_size()) {
-    escape_chem.resize(Model::escape_size(), Model::well_size());
-    escape_chem = 0.;
-    vtemp.resize(crm_size);
-    for(int count = 0; count < Model::escape_size(); ++count) {
-      const int w = Model::escape_well_index(count);
+    _kernel.resize(size(), kernel_bandwidth);
+    _kernel = 0.;
 
-      dtemp = 0.;
-      for(int i = 0; i < well(w).size(); ++i)
-	dtemp += well(w).escape_rate(i) * well(w).boltzman(i);
-      dtemp /= well(w).weight_sqrt();
+    Lapack::GeneralBandMatrix tmp_kernel(size(), kernel_bandwidth);
 
-      escape_chem(count, w) = dtemp;
+    const Lapack::StridedView<double> tk = tmp_kernel.unchecked();
 
-      vtemp = 0.;
-      for(int r = 0; r < well(w).crm_size(); ++r) 
-	vtemp[r + well_shift[w]] = parallel_vdot(well(w).crm_column(r), well(w).escape_rate(), well(w).size());
- 
-      escape_chem.row(count) -= vtemp * l_21;
-    }
-  }// well escape
+    for(int b = 0; b < Model::buffer_size(); ++b) {
 
-  // minimal energy relaxation eigenvalue
-  double min_relax_eval, max_relax_eval;
-  int wmin, wmax;
-  for(int w = 0; w < Model::well_size(); ++w) {
-    double rmin, rmax;  
-    if(well(w).radiation()) {// radiational transitions contribution
-      Lapack::SymmetricMatrix erk(well(w).crm_size());
-      
-#pragma omp parallel for default(shared) schedule(dynamic)
-	
-      for(int r1 = 0; r1 < well(w).crm_size(); ++r1) {
-	  for(int r2 = r1; r2 < well(w).crm_size(); ++r2)
-	    erk(r1, r2) =  well(w).crm_radiation_rate(r1, r2)
-	      + well(w).collision_frequency() * well(w).crm_kernel(r1, r2);
-	}
-      vtemp = erk.eigenvalues();
-      rmin = vtemp.front();
-      rmax = vtemp.back();
-    }
-    else {
-      rmin = well(w).minimal_relaxation_eigenvalue() * well(w).collision_frequency();
-      rmax = well(w).maximal_relaxation_eigenvalue() * well(w).collision_frequency();
-    }
+      /********************* SETTING COLLISIONAL ENERGY TRANSFER KERNEL ****************************/
 
-    if(!w || rmin < min_relax_eval) {
-      min_relax_eval = rmin;
-      wmin = w;
-    }
-    if(!w || rmax > max_relax_eval) {
-      wmax = w;
-      max_relax_eval = rmax;
-    }
-  }
+      tmp_kernel = 0.;
 
-  IO::log << IO::log_offset 
-	  << "minimal relaxation eigenvalue / collisional frequency = "  
-	  << min_relax_eval / well(wmin).collision_frequency() << "\n";
-  //	  << IO::log_offset
-  //	  << "maximal relaxation eigenvalue / collisional frequency = "  
-  //	  << max_relax_eval / collision_frequency() << "\n";
+      // collisional energy transfer down probability distribution on the grid
+      //
+      itemp = (int)std::ceil(model.kernel(b)->cutoff_energy(temperature()) / energy_step());
+      
+      if(itemp > kernel_bandwidth)
+	//
+	itemp = kernel_bandwidth;
+      
+      std::vector<double> energy_transfer_form(itemp);
+      
+      model.kernel(b)->profile(energy_step(), temperature(), energy_transfer_form);
 
-  // chemical eigenvalues and eigenvectors
-  Lapack::Matrix chem_evec(Model::well_size());
+      // energy transfer UP probability functional form predefined
+      //
+      if(Model::Kernel::flags() & Model::Kernel::UP) {
+	//
+	for(int i = size() - 1; i >= 0; --i) {// energy grid cycle
 
-#ifdef WITH_MPACK
-  
-  Lapack::Vector chem_eval = Mpack::dd_eigenvalues(k_11, &chem_evec);
+	  itemp = i + energy_transfer_form.size();
+	  const int jmax = itemp < size() ? itemp : size(); 
+	  itemp = i - energy_transfer_form.size() + 1;
+	  const int jmin = itemp  > 0 ? itemp : 0;
 
-#else
-  
-  Lapack::Vector chem_eval = k_11.eigenvalues(&chem_evec);
+	  // normalization constant
+	  //
+	  c = 0.;
+	  for(int j = jmin; j <= i; ++j) {
+	    dtemp = energy_transfer_form[i - j];
+	    if(Model::Kernel::flags() & Model::Kernel::DENSITY)
+	      dtemp *= state_density(j);
+	    tk(i, j) = -dtemp;
+	    c += dtemp;
+	  }
 
-#endif
-  
-  // relaxational projection of the chemical eigenvector
-  l_21 = l_21 * chem_evec;
-  Lapack::Vector rel_proj(Model::well_size());
-  for(int l = 0; l < Model::well_size(); ++l)
-    rel_proj[l] = vdot(l_21.column(l));
-
-  // eigenvalues output
-  if(eval_out.is_open()) {
-    eval_out << std::setw(13) << temperature() / Phys_const::kelv;
-    switch(pressure_unit) {
-    case BAR:
-      eval_out << pressure() / Phys_const::bar;
-      break;
-    case TORR:
-      eval_out << pressure() / Phys_const::tor;
-      break;
-    case ATM:
-      eval_out << pressure() / Phys_const::atm;
-      break;
-    }
-    eval_out << std::setw(13) << well(wmin).collision_frequency() / Phys_const::herz
-	     << std::setw(13) << min_relax_eval / well(wmin).collision_frequency();
-    for(int l = 0; l < Model::well_size(); ++l)
-      eval_out << std::setw(13) << chem_eval[l] / well(wmin).collision_frequency() << std::setw(13) << rel_proj[l];
-    eval_out << "\n";
-  }
+	  // down-transitions contribution
+	  //
+	  a = kernel_fraction(b);
+	  for(int j = i + 1; j < jmax; ++j) {
+	    //
+	    a += tk(i, j);
+	  }
+    
+	  if(a <= 0.) {
+	    //
+	    std::cerr << model.name() << " Well: cannot satisfy the constant collision rate at energy = "
+		      << (energy_reference() - (double)i * energy_step()) / Phys_const::incm
+		      << " 1/cm\n";
+	    
+	    throw Error::Logic();
+	  }
+	  else {
+	    //
+	    a /= c;
 
-  /************************************* EIGENVECTOR OUTPUT *****************************************/
+	    for(int j = jmin; j < i; ++j) {
+	      //
+	      tk(i, j) *= a;
+	      
+	      tk(j, i) = tk(i, j) * state_density(i) / state_density(j) * thermal_factor(i - j);
+	    }
+      
+	    tk(i, i) = tk(i, i) * a + kernel_fraction(b);
+	  }
+	}// energy grid cycle
+      }
+      // energy transfer DOWN probability functional form predefined
+      //
+      else {
+	//
+	for(int i = 0; i < size(); ++i) {// energy grid cycle
 
-  IO::log << std::setprecision(3)
-	  << IO::log_offset << "eigenvector populations normalized:\n"
-	  << IO::log_offset 
-	  << std::setw(5)  << "L"
-	  << std::setw(10) << "*R"
-	  << std::setw(10) << "*P";
-  for(int w = 0; w < Model::well_size(); ++w)
-    IO::log << std::setw(10) << Model::well(w).name();  
-  IO::log << "\n";
+	  itemp = i + energy_transfer_form.size();
+	  const int jmax = itemp < size() ? itemp : size(); 
+	  itemp = i - energy_transfer_form.size() + 1;
+	  const int jmin = itemp  > 0 ? itemp : 0;
 
-  // maximal population
-  for(int l = 0; l < Model::well_size(); ++l) {
+	  // normalization constant
+	  //
+	  c = 0.;
+	  
+	  for(int j = i; j < jmax; ++j) {
+	    //
+	    dtemp = energy_transfer_form[j - i];
+	    
+	    if(Model::Kernel::flags() & Model::Kernel::DENSITY)
+	      //
+	      dtemp *= state_density(j);
+	    
+	    tk(i, j) = -dtemp;
+	    
+	    c += dtemp;
+	  }
 
-    double pos_pop = 0.;
-    double neg_pop = 0.;
-    for(int w = 0; w < Model::well_size(); ++w) {
-      dtemp = chem_evec(w, l) * well(w).weight_sqrt();
-      if(dtemp > 0.)
-	pos_pop += dtemp;
-      if(dtemp < 0.)
-	neg_pop += dtemp;
-    }
-    double max_pop = pos_pop > -neg_pop ? pos_pop : neg_pop;
+	  // up-transitions contribution
+	  //
+	  a = kernel_fraction(b);
+	  
+	  for(int j = jmin; j < i; ++j)
+	    //
+	    a += tk(i, j);
+	  
     
-    IO::log << IO::log_offset
-	    << std::setw(5)  << l
-	    << std::setw(10) << chem_eval[l] / min_relax_eval
-	    << std::setw(10) << rel_proj[l]; 
-    for(int w = 0; w < Model::well_size(); ++w) {
-      dtemp = chem_evec(w, l) * well(w).weight_sqrt() / max_pop;
-      IO::log << std::setw(10);
-      if(dtemp > .01 || dtemp < -.01)
-	IO::log << dtemp;
+	  if(a < 0.) {
+	    //
+	    IO::log << IO::log_offset << model.name() 
+		    << " Well: cannot satisfy the constant collision frequency at energy = "
+		    << (energy_reference() - (double)i * energy_step()) / Phys_const::incm
+		    << " 1/cm";
+	    
+	    if(Model::Kernel::flags() & Model::Kernel::NOTRUN) {
+	      //
+	      dtemp = kernel_fraction(b) - a;
+	      
+	      IO::log << ", collision frequency = " << dtemp << "\n";
+	      tk(i, i) = dtemp;
+	      for(int j = i + 1; j < jmax; ++j) {
+		tk(i, j) = 0.;
+		tk(j, i) = 0.;
+	      }
+	    }
+	    else {
+	      IO::log << ", truncating the well\n";
+	      _state_density.resize(i);
+	      break;
+	    }
+	  }
+	  else {
+	    //
+	    a /= c;
+	  
+	    for(int j = i + 1; j < jmax; ++j) {
+	      //
+	      tk(i, j) *= a;
+	      
+	      tk(j, i) = tk(i, j) * state_density(i) / state_density(j) / thermal_factor(j - i);
+	    }
+	    
+	    tk(i, i) = tk(i, i) * a + kernel_fraction(b);
+	  }
+	}// energy grid cycle
+      }
+      
+      if(_kernel.size() != size())
+	break;
       else
-	IO::log << 0;
-    }
-    IO::log << "\n";
-  }
+	_kernel += tmp_kernel;
 
-  IO::log << IO::log_offset << std::setw(5) << "*R" 
-	  << " - eigenvalue over the relaxation limit\n"
-	  << IO::log_offset << std::setw(5) << "*P" 
-	  << " - eigenvector projection squared on the relaxation subspace\n"
-	  << IO::log_offset << "eigenvector projections:\n"
-	  << IO::log_offset 
-	  << std::setw(5)  << "L"
-	  << std::setw(10) << "*Q"
-	  << std::setw(10) << "*P";
+      // buffer gas mixture
+      if(Model::buffer_size() > 1) {
+	//
+	_buffer_kernel.resize(Model::buffer_size());
+	_buffer_kernel[b] = tmp_kernel.copy();
 
-  for(int w = 0; w < Model::well_size(); ++w)
-    IO::log << std::setw(10) << Model::well(w).name();  
-  IO::log << "\n";
+	double* p = _buffer_kernel[b];
+	dtemp = 1. / kernel_fraction(b);
+	for(long i = 0; i < (long)tmp_kernel.size() * (2 * tmp_kernel.band_size() - 1); ++i)
+	  p[i] *= dtemp;
+      }
+    }
+  } while(_kernel.size() != size());
 
-  for(int l = 0; l < Model::well_size(); ++l) {
-    IO::log << IO::log_offset
-	    << std::setw(5)  << l
-	    << std::setw(10) << chem_eval[l] / well(wmin).collision_frequency()
-	    << std::setw(10) << rel_proj[l]; 
-    for(int w = 0; w < Model::well_size(); ++w)
-      IO::log << std::setw(10) << chem_evec(w, l);
-    IO::log << "\n";
-  }
+#ifdef DEBUG
   
-  IO::log << IO::log_offset 
-	  << std::setw(5) << "*Z"
-	  << std::setw(10) << "---"
-	  << std::setw(10) << "---";
-  for(int w = 0; w < Model::well_size(); ++w)
-    IO::log << std::setw(10) << well(w).weight_sqrt();
-  IO::log << "\n";
-
-  IO::log << IO::log_offset << std::setw(5) << "*Q" 
-	  << " - eigenvalue over the collision frequency\n"
-	  << IO::log_offset << std::setw(5) << "*P" 
-	  << " - eigenvector projection squared on the relaxation subspace\n"
-	  << IO::log_offset << std::setw(5) << "*Z" 
-	  << " - well partition function square root\n"
-	  << std::setprecision(6);
+  IO::log << IO::log_offset << model.name() << " well: kernel diagonal elements:\n";
   
-  // rate coefficients connecting eigenstates to bimolecular products
-  Lapack::Matrix chem_bim = chem_evec.transpose() * k_13;
-
-#ifdef DEBUG
-
-  IO::log << IO::log_offset << "eigenvector-to-bimolecular projections:\n";
-  IO::log << IO::log_offset << std::setw(5) << "L\\P";
-  for(int p = 0; p < Model::bimolecular_size(); ++p)
-    IO::log << std::setw(13) << Model::bimolecular(p).name();
-  IO::log << "\n";
+  for(int i = 0; i < size(); ++i)
+    //
+    IO::log << IO::log_offset << std::setw(5) << i  << std::setw(15) << _kernel(i, i)  << "\n";
   
-  for(int l = 0; l < Model::well_size(); ++l) {
-    IO::log << IO::log_offset << std::setw(5) << l;  
-    for(int p = 0; p < Model::bimolecular_size(); ++p)
-      IO::log << std::setw(13) << chem_bim(l, p);
-    IO::log << "\n";
-  }
-
 #endif
 
-  // bimolecular rate units
-  const double bru = Phys_const::cm * Phys_const::cm * Phys_const::cm * Phys_const::herz;
+}
 
-  // bimolecular-to-bimolecular rate coefficients
-  for(int i = 0; i < Model::bimolecular_size(); ++i) 
-    if(bimolecular(i).weight() > 0.)
-      for(int j = 0; j < Model::bimolecular_size(); ++j) {
-	dtemp = k_33(i, j) * energy_step();
-	// bimolecular reactant loss
-	if(i == j) {
-	  dtemp = -dtemp;
-	  for(int b = 0; b < Model::outer_barrier_size(); ++b)
-	    if(Model::outer_connect(b).second == i)
-	      dtemp += temperature() / 2. / M_PI * outer_barrier(b).weight();	  
-	}
-	dtemp /= bimolecular(i).weight() * bru;
-	rate_data[std::make_pair(Model::well_size() + i, Model::well_size() + j)] = dtemp; 	
-      }
-  
-  /********************************** CHEMICAL SUBSPACE DIMENSION ****************************************/
+// the well size at which the constant collision frequency condition for the DOWN-form kernel
+// holds everywhere; repeats the kernel setup recursion with only the up-transitions sums kept
+//
+int MasterEquation::Well::_truncation_size (const Model::Well& model, int bandwidth) const
+{
+  const char funame [] = "MasterEquation::Well::_truncation_size: ";
 
-  if(default_partition.size())
-    itemp = default_partition.size();
-  else if(chemical_threshold > 0.) {
-    dtemp = 1. / chemical_threshold;
-    for(itemp = 0; itemp < Model::well_size(); ++itemp)
-      if(chem_eval[itemp] / min_relax_eval  > dtemp)
-	break;
-  }
-  else if(chemical_threshold < 0. ) {
-    dtemp = -1. / chemical_threshold;
-    for(itemp = Model::well_size(); itemp > 0; --itemp)
-      if(chem_eval[itemp - 1] / min_relax_eval < dtemp && chem_eval[itemp - 1] / chem_eval[itemp] < dtemp)
-	break;
-  }
-  else
-    itemp = Model::well_size();
-	
-  const int chem_size = itemp;
+  int    itemp;
+  double dtemp;
 
-  if(chem_size != Model::well_size())
-    IO::log << IO::log_offset << "dimension of the chemical subspace = " << chem_size << "\n";
+  int new_size = size();
 
-  if(!chem_size)
-    return;
+  std::vector<double> up(new_size);
 
-  if(chem_size < Model::well_size()) {// reduction of species
-    // chemical eigenvectors
-    Lapack::Matrix pop_chem(Model::well_size(), chem_size);
+  bool btemp;
+
+  do {
+    //
+    btemp = false;
+
+    if(bandwidth > new_size)
+      //
+      bandwidth = new_size;
+
+    for(int b = 0; b < Model::buffer_size() && !btemp; ++b) {
+      //
+      itemp = (int)std::ceil(model.kernel(b)->cutoff_energy(temperature()) / energy_step());
+
+      if(itemp > bandwidth)
+	//
+	itemp = bandwidth;
+
+      std::vector<double> energy_transfer_form(itemp);
+
+      model.kernel(b)->profile(energy_step(), temperature(), energy_transfer_form);
+
+      for(int i = 0; i < new_size; ++i)
+	//
+	up[i] = kernel_fraction(b);
+
+      for(int i = 0; i < new_size; ++i) {// energy grid cycle
+
+	itemp = i + energy_transfer_form.size();
+	const int jmax = itemp < new_size ? itemp : new_size;
+
+	double c = 0.;
+
+	for(int j = i; j < jmax; ++j) {
+	  //
+	  dtemp = energy_transfer_form[j - i];
+
+	  if(Model::Kernel::flags() & Model::Kernel::DENSITY)
+	    //
+	    dtemp *= state_density(j);
+
+	  c += dtemp;
+	}
+
+	const double a = up[i];
+
+	if(a < 0.) {
+	  //
+	  IO::log << IO::log_offset << model.name()
+		  << " Well: cannot satisfy the constant collision frequency at energy = "
+		  << (energy_reference() - (double)i * energy_step()) / Phys_const::incm
+		  << " 1/cm, truncating the well\n";
+
+	  new_size = i;
+
+	  btemp = true;
+
+	  break;
+	}
+
+	dtemp = a / c;
+
+	for(int j = i + 1; j < jmax; ++j) {
+	  //
+	  double t = -energy_transfer_form[j - i];
+
+	  if(Model::Kernel::flags() & Model::Kernel::DENSITY)
+	    //
+	    t *= state_density(j);
+
+	  t *= dtemp;
+
+	  up[j] += t * state_density(i) / state_density(j) / thermal_factor(j - i);
+	}
+      }// energy grid cycle
+    }
+  } while(btemp);
+
+  return new_size;
+}
+
+void MasterEquation::Well::_set_crm_basis ()
+{
+  const char funame [] = "MasterEquation::Well::_set_crm_basis: ";
+
+  int    itemp;
+  double dtemp;
+  bool   btemp;
+
+  /**************** SETTING RELAXATION MODE BASIS & PARTITION FUNCTION ****************/
+
+  _boltzman.resize(size());
+  _crm_basis.resize(size(), size() - 1);
+  _crm_basis = 0.;
+  _weight = 0.;
+  std::vector<double> nfac(crm_size());
+  for(int i = 0; i < size(); ++i) {
+    dtemp = state_density(i) * thermal_factor(i);
+    _boltzman[i] = dtemp;
+    if(i) {
+      itemp = i - 1;
+      _crm_basis(i, itemp) = - _weight;
+      nfac[itemp] = std::sqrt((_weight / dtemp + 1.) * _weight);
+    }
+    for(int r = i; r < crm_size(); ++r)
+      _crm_basis(i, r) = dtemp;
+    _weight += dtemp;    
+  }
+
+  for(int r = 0; r < crm_size(); ++r) {
+    itemp = r + 2;
+    for(int i = 0; i < itemp; ++i) {
+      _crm_basis(i, r) /= nfac[r];
+    }
+  }
+
+  _weight_sqrt = std::sqrt(_weight);
+
+  _boltzman_sqrt.resize(size());
+  Math::sqrt_grid(_boltzman, size(), _boltzman_sqrt);
+
+  _boltzman_sqrt_inv.resize(size());
+  Math::inv_sqrt_grid(_boltzman, size(), _boltzman_sqrt_inv);
+}
+
+MasterEquation::Well::Well (const Model::Well& model)
+{
+  const char funame [] = "MasterEquation::Well: ";
+
+  int                 itemp;
+  double              dtemp;
+  bool                btemp;
+  Lapack::Vector      vtemp;
+  
+  std::clock_t start_time;
+
+  _collision_factor = 0.;
+  _kernel_fraction.resize(Model::buffer_size());
+  for(int b = 0; b < Model::buffer_size(); ++b) {
+    dtemp = (*model.collision(b))(temperature()) * Model::buffer_fraction(b);
+    _kernel_fraction[b] = dtemp;
+    _collision_factor += dtemp;
+  }
+
+  for(int b = 0; b < Model::buffer_size(); ++b)
+    _kernel_fraction[b] /= _collision_factor;
+
+  if(Model::buffer_size() > 1) {
+    _buffer_collision.resize(Model::buffer_size());
+    for(int b = 0; b < Model::buffer_size(); ++b)
+      _buffer_collision[b] = (*model.collision(b))(temperature());
+  }
+
+  _real_weight = model.weight(temperature()) * 
+    std::exp((energy_reference() - model.ground()) / temperature());
+
+  // state density
+  start_time = std::clock();
+
+  _set_state_density(model);
+
+  IO::log << IO::log_offset << model.name() << " Well: density of states done, elapsed time[sec] = "
+	    << double(std::clock() - start_time) / CLOCKS_PER_SEC <<  std::endl;
+
+  // collisiona relaxation kernel
+  start_time = std::clock();
+
+  _set_kernel(model);
+
+  IO::log << IO::log_offset << model.name() << " Well: collisional energy transfer kernel done, elapsed time[sec] = "
+	    << double(std::clock() - start_time) / CLOCKS_PER_SEC <<  std::endl;
+
+  // CRM basis
+  start_time = std::clock();
+
+  _set_crm_basis();
+
+  IO::log << IO::log_offset << model.name() << " Well: relaxation modes basis done, elapsed time[sec] = "
+	    << double(std::clock() - start_time) / CLOCKS_PER_SEC <<  std::endl;
+
+  // collisional relaxation kernel in CRM basis
+  //
+  start_time = std::clock();
+
+  _crm_bra = _crm_basis.copy();
+  for(int i = 0; i < size(); ++i)
+    _crm_bra.row(i) /= boltzman(i);
+
+  _crm_kernel = _crm_basis.symmetric_transpose_product(_kernel * _crm_bra);
+
+  IO::log << IO::log_offset << model.name() 
+	  << " Well: kernel in relaxation modes basis done, elapsed time[sec] = "
+	  << double(std::clock() - start_time) / CLOCKS_PER_SEC <<  std::endl;  
+
+  // minimal collisional relaxation eigenvalue
+  start_time = std::clock();
+
+  vtemp = _crm_kernel.eigenvalues();
+  _min_relax_eval = vtemp.front();
+  _max_relax_eval = vtemp.back();
+
+  IO::log << IO::log_offset << model.name() << " Well: relaxation eigenvalues done, elapsed time[sec] = "
+	    << double(std::clock() - start_time) / CLOCKS_PER_SEC <<  std::endl;  
+
+  IO::log << IO::log_offset << model.name() << " Well: minimal relaxation eigenvalue = "
+	  << _min_relax_eval << "\n";
+  IO::log << IO::log_offset << model.name() << " Well: maximal relaxation eigenvalue = " 
+	  << _max_relax_eval << "\n";
+
+  /*
+    #ifdef DEBUG
+    
+    start_time = std::clock();
+    
+    // symmetrized kernel eigenvalues
+    Lapack::Vector f_0(size());
+    for(int i = 0; i < size(); ++i)
+    f_0[i] = std::sqrt(state_density(i) * thermal_factor(i));
+    Lapack::SymmetricMatrix sym_kernel(size());
+    for(int i = 0; i < size(); ++i)
+    for(int j = i; j < size(); ++j)
+    sym_kernel(i, j) = kernel(i, j) * f_0[i] / f_0[j];
+    vtemp = sym_kernel.eigenvalues();
+    
+    IO::log << IO::log_offset << model.name() << " Well: symmetrized kernel eigenvalues done, elapsed time[sec] = "
+    << double(std::clock() - start_time) / CLOCKS_PER_SEC <<  std::endl;  
+    IO::log << IO::log_offset << model.name() << " Well: symmetrized kernel eigenvalues: "
+    << std::setw(13) << vtemp[0] << std::setw(13) << vtemp[1] << std::setw(13) << vtemp.back() << "\n";
+    
+    #endif
+  */
+
+  // escape rate
+  //
+  if(model.escape()) {
+    //
+    IO::log << IO::log_offset << model.name() << " Well: Escape rate:\n";
+    
+    _escape_rate.resize(size());
+    
+    const std::vector<double>& rate = model.escape_rate_table(energy_reference(), energy_step(), size());
+
+    double ener = energy_reference();
+
+    for(int i = 0; i < size(); ++i, ener -= energy_step()) {
+      //
+      dtemp = rate[i];
+
+      IO::log << IO::log_offset 
+	      << "    E[kcal/mol] = " << std::setw(13) << ener / Phys_const::kcal
+	      << "    rate[1/sec] = " << std::setw(13) << dtemp / Phys_const::herz << "\n";
+      
+      _escape_rate[i] = dtemp;
+    }
+  }
+
+  // radiational transitions
+  //
+  if(model.oscillator_size()) {
+    //
+    _crm_radiation_rate.resize(crm_size());
+    
+    _radiation_rate.resize(size());
+    
+    _radiation_rate = 0.;
+    
+    _crm_radiation_rate = 0.;
+
+    // the CRM rate matrix is D^T * D, the rows of D being the weighted differences of the upper and
+    // lower bins bras, one per radiational transition; the rows are accumulated in panels
+    const int diff_size = 256;
+
+    Lapack::Matrix diff(diff_size, crm_size());
+    diff = 0.;
+
+    int diff_row = 0;
+
+    for(int ue = 0; ue < size() - 1; ++ue) {
+      double ener = energy_reference() - (double)ue * energy_step();
+      for(int f = 0; f < model.oscillator_size(); ++f) {
+
+	itemp = (int)round(model.oscillator_frequency(f) / energy_step());
+	if(!itemp)
+	  continue;
+
+	double rad_prob = model.transition_probability(ener, temperature(), f);
+	if(rad_prob <= 0.)
+	  continue;
+
+	int le = itemp + ue;
+	le = le < size() ? le : size() - 1; 
+
+	dtemp = boltzman_sqrt(ue) / boltzman_sqrt(le);
+	_radiation_rate(ue, le) -= rad_prob * dtemp;
+	_radiation_rate(ue, ue) += rad_prob;
+	_radiation_rate(le, le) += rad_prob * dtemp * dtemp;
+
+	dtemp = std::sqrt(rad_prob * boltzman(ue));
+	for(int r = 0; r < crm_size(); ++r)
+	  diff(diff_row, r) = dtemp * (crm_bra(ue, r) - crm_bra(le, r));
+
+	if(++diff_row < diff_size)
+	  continue;
+
+	_crm_radiation_rate.add_transpose_product(diff, diff);
+	diff = 0.;
+	diff_row = 0;
+      }
+    }
+
+    // the rest of the rows are zero
+    if(diff_row)
+      _crm_radiation_rate.add_transpose_product(diff, diff);
+  }
+  
+  IO::log << IO::log_offset << model.name() 
+	  << " Well:       grid size = " << size() << "\n"
+	  << IO::log_offset << model.name() 
+	  << " Well:      real depth = " << int(model.ground() / Phys_const::incm) << " 1/cm\n"
+	  << IO::log_offset << model.name() 
+	  << " Well: effective depth = "
+	  << int((energy_reference() - (double)size() * energy_step()) / Phys_const::incm) << " 1/cm\n";
+}
+
+void MasterEquation::Well::set_buffer_fraction ()
+{
+  const char funame [] = "MasterEquation::Well::set_buffer_fraction: ";
+
+  double dtemp;
+
+  if(Model::buffer_size() == 1)
+    return;
+
+  if(_buffer_kernel.size() != Model::buffer_size() || _buffer_collision.size() != Model::buffer_size()) {
+    std::cerr << funame << "per-buffer kernels are not available\n";
+    throw Error::Logic();
+  }
+
+  std::vector<double> fraction(Model::buffer_size());
+
+  dtemp = 0.;
+  for(int b = 0; b < Model::buffer_size(); ++b) {
+    fraction[b] = _buffer_collision[b] * Model::buffer_fraction(b);
+    dtemp += fraction[b];
+  }
+
+  for(int b = 0; b < Model::buffer_size(); ++b)
+    fraction[b] /= dtemp;
+
+  if(fraction == _kernel_fraction)
+    return;
+
+  _collision_factor = dtemp;
+  _kernel_fraction  = fraction;
+
+  _kernel = 0.;
+
+  double* k = _kernel;
+  for(int b = 0; b < Model::buffer_size(); ++b) {
+    const double* p = _buffer_kernel[b];
+    for(long i = 0; i < (long)_kernel.size() * (2 * _kernel.band_size() - 1); ++i)
+      k[i] += kernel_fraction(b) * p[i];
+  }
+
+  _crm_kernel = _crm_basis.symmetric_transpose_product(_kernel * _crm_bra);
+
+  Lapack::Vector vtemp = _crm_kernel.eigenvalues();
+  _min_relax_eval = vtemp.front();
+  _max_relax_eval = vtemp.back();
+}
+
+/********************************************************************************************
+ ************************************ SETTING BARRIER ***************************************
+ ********************************************************************************************/
+
+MasterEquation::Barrier::Barrier (const Model::Species& model)
+{
+  const char funame [] = "MasterEquation::Barrier::Barrier: ";
+
+  int    itemp;
+  double dtemp;
+
+  int new_size = barrier_state_size(model);
+
+  _state_number.resize(new_size);
+  resize_thermal_factor(new_size);
+
+  const std::vector<double>& states = model.states_table(energy_reference(), energy_step(), size());
+
+  _weight = 0.;
+  for(int e = 0; e < size(); ++e) {
+    dtemp = states[e];
+    if(dtemp <= 0.) {
+      IO::log << IO::log_offset  << model.name() << " Barrier: nonpositive number of states at " 
+	      << (energy_reference() - (double)e * energy_step()) / Phys_const::incm  << " 1/cm => truncating\n";
+      _state_number.resize(e);
+      break;
+    }
+    _state_number[e] = dtemp;
+    _weight += dtemp * thermal_factor(e);
+  }
+  _weight *= energy_step() / temperature();
+
+  _real_weight = model.cached_weight(temperature()) * std::exp((energy_reference() - model.ground()) / temperature());  
+
+  IO::log << IO::log_offset << model.name() 
+	  << " Barrier:        grid size = " << size() << "\n"
+	  << IO::log_offset << model.name() 
+	  << " Barrier:      real height = " << int(model.ground() / Phys_const::incm) << " 1/cm\n"
+	  << IO::log_offset << model.name() 
+	  << " Barrier: effective height = "
+	  << int((energy_reference() - (double)size() * energy_step()) / Phys_const::incm) << " 1/cm\n";
+
+}
+
+void MasterEquation::Barrier::truncate (int new_size) 
+{
+  const char funame [] = "MasterEquation::Barrier::truncate: ";
+
+  double dtemp;
+  if(new_size == size())
+    return;
+
+  if(new_size <= 0 || new_size > size()) {
+    std::cerr << funame << "out of range\n";
+    throw Error::Range();
+  }
+
+  dtemp = 0.;
+  for(int i = new_size; i < size(); ++i)
+    dtemp += _state_number[i] * thermal_factor(i);
+  dtemp *= energy_step() / temperature();
+
+  _state_number.resize(new_size);
+  _weight -= dtemp;
+  
+  IO::log << IO::log_offset << funame << "grid size = " << size() << "\n"
+	  << IO::log_offset << funame << "real weight = " << _real_weight << "\n"
+	  << IO::log_offset << funame << "effective weight = " << _weight * energy_step() << "\n";
+}
+
+void MasterEquation::Barrier::close ()
+{
+  _state_number.resize(0);
+  _weight = 0.;
+}
+
+/********************************************************************************************
+ ********************************** SETTING BIMOLECULAR *************************************
+ ********************************************************************************************/
+
+MasterEquation::Bimolecular::Bimolecular (const Model::Bimolecular& model)
+{ 
+  _weight   = model.weight(temperature()) * std::exp((energy_reference() - model.ground()) / temperature());
+}
+
+/********************************************************************************************
+ ****************************** STATE CACHE INPUT/OUTPUT ************************************
+ ********************************************************************************************/
+
+MasterEquation::Well::Well (std::istream& from)
+{
+  cache_get(from, _weight);
+  cache_get(from, _weight_sqrt);
+  cache_get(from, _real_weight);
+  cache_get(from, _min_relax_eval);
+  cache_get(from, _max_relax_eval);
+  cache_get(from, _collision_factor);
+  cache_get(from, kernel_bandwidth);
+  cache_get(from, _kernel_fraction);
+  cache_get(from, _state_density);
+  cache_get(from, _boltzman);
+  cache_get(from, _boltzman_sqrt);
+  cache_get(from, _crm_basis);
+
+  _boltzman_sqrt_inv.resize(_boltzman.size());
+  Math::inv_sqrt_grid(_boltzman, _boltzman.size(), _boltzman_sqrt_inv);
+
+  cache_get(from, _crm_bra);
+  cache_get(from, _kernel);
+  cache_get(from, _crm_kernel);
+  cache_get(from, _escape_rate);
+  cache_get(from, _radiation_rate);
+  cache_get(from, _crm_radiation_rate);
+  cache_get(from, _buffer_collision);
+
+  int buff_size;
+  cache_get(from, buff_size);
+  _buffer_kernel.resize(buff_size);
+  for(int b = 0; b < buff_size; ++b)
+    cache_get(from, _buffer_kernel[b]);
+
+  resize_thermal_factor(size());
+}
+
+void MasterEquation::Well::save (std::ostream& to) const
+{
+  cache_put(to, _weight);
+  cache_put(to, _weight_sqrt);
+  cache_put(to, _real_weight);
+  cache_put(to, _min_relax_eval);
+  cache_put(to, _max_relax_eval);
+  cache_put(to, _collision_factor);
+  cache_put(to, kernel_bandwidth);
+  cache_put(to, _kernel_fraction);
+  cache_put(to, _state_density);
+  cache_put(to, _boltzman);
+  cache_put(to, _boltzman_sqrt);
+  cache_put(to, _crm_basis);
+  cache_put(to, _crm_bra);
+  cache_put(to, _kernel);
+  cache_put(to, _crm_kernel);
+  cache_put(to, _escape_rate);
+  cache_put(to, _radiation_rate);
+  cache_put(to, _crm_radiation_rate);
+  cache_put(to, _buffer_collision);
+  cache_put(to, (int)_buffer_kernel.size());
+  for(int b = 0; b < _buffer_kernel.size(); ++b)
+    cache_put(to, _buffer_kernel[b]);
+}
+
+MasterEquation::Barrier::Barrier (std::istream& from)
+{
+  cache_get(from, _weight);
+  cache_get(from, _real_weight);
+  cache_get(from, _state_number);
+
+  if(_state_number.isinit())
+    resize_thermal_factor(size());
+}
+
+void MasterEquation::Barrier::save (std::ostream& to) const
+{
+  cache_put(to, _weight);
+  cache_put(to, _real_weight);
+  cache_put(to, _state_number);
+}
+
+MasterEquation::Bimolecular::Bimolecular (std::istream& from)
+{
+  cache_get(from, _weight);
+}
+
+void MasterEquation::Bimolecular::save (std::ostream& to) const
+{
+  cache_put(to, _weight);
+}
+
+/********************************************************************************************
+ ********************************** CALCULATION METHODS *************************************
+ ********************************************************************************************/
+
+/********************************************************************************************
+ ******************************* LOW CHEMICAL EIGENVALUE METHOD *****************************
+ ********************************************************************************************/
+
+// the method based on the assumption that the chemical eigenvalues are small in comparison
+// to the relaxation eigenvalues
+
+double triple_product ( const double* p1, const double* p2, const double* p3, int n)
+{
+  double res = 0.;
+
+#pragma omp parallel for default(shared) reduction(+: res) schedule(static)
+	
+  for(int i = 0; i < n; ++i) {
+    res += p1[i] * p2[i] * p3[i];
+  }
+
+  return res;
+}
+
+namespace {
+  //
+  // relaxation modes kinetic matrix in the block form, K = D + U * U^T: D is block-diagonal
+  // (collisions, radiation, escape, and bimolecular channels of individual wells) and each
+  // inner barrier energy bin adds the rank one coupling of the two wells; the inverse is
+  // applied by the Woodbury identity, K^-1 = D^-1 - D^-1 * U * (1 + U^T * D^-1 * U)^-1 * U^T * D^-1,
+  // with the per-well Cholesky factors and the capacity matrix of the barriers dimension
+  //
+  class BlockCholesky {
+    //
+    std::vector<int>                 _shift; // well blocks shifts
+    std::vector<Lapack::Cholesky>    _diag;  // well blocks factors
+    std::vector<Lapack::Matrix>      _u;     // coupling vectors, well(crm_size) x coupling(size)
+    std::vector<Lapack::Matrix>      _y;     // D^-1 * U
+    std::vector<std::vector<int> >   _col;   // coupling vectors global indices
+    std::vector<Lapack::Cholesky>    _cap;   // capacity matrix factor, if any
+
+    int _size;
+
+  public:
+    BlockCholesky (const std::vector<Lapack::SymmetricMatrix>& d, const std::vector<Lapack::Matrix>& u,
+		   const std::vector<std::vector<int> >& col, int cap_size);
+
+    int size () const { return _size; }
+
+    Lapack::Matrix invert (const Lapack::Matrix&) const;
+  };
+
+  BlockCholesky::BlockCholesky (const std::vector<Lapack::SymmetricMatrix>& d, const std::vector<Lapack::Matrix>& u,
+				const std::vector<std::vector<int> >& col, int cap_size)
+    : _shift(d.size()), _u(u), _y(d.size()), _col(col), _size(0)
+  {
+    for(int w = 0; w < d.size(); ++w) {
+      //
+      _shift[w] = _size;
+      _size    += d[w].size();
+
+      _diag.push_back(Lapack::Cholesky(d[w]));
+
+      if(_col[w].size())
+	_y[w] = _diag[w].invert(_u[w]);
+    }
+
+    if(!cap_size)
+      return;
+
+    Lapack::SymmetricMatrix cap(cap_size);
+    cap = 0.;
+    for(int i = 0; i < cap_size; ++i)
+      cap(i, i) = 1.;
+
+    for(int w = 0; w < d.size(); ++w) {
+      if(!_col[w].size())
+	continue;
+
+      const Lapack::Matrix p = _u[w].transpose_product(_y[w]);
+
+      // the global indices are increasing within the well
+      for(int j2 = 0; j2 < _col[w].size(); ++j2)
+	for(int j1 = 0; j1 <= j2; ++j1)
+	  cap(_col[w][j1], _col[w][j2]) += p(j1, j2);
+    }
+
+    _cap.push_back(Lapack::Cholesky(cap));
+  }
+
+  Lapack::Matrix BlockCholesky::invert (const Lapack::Matrix& m) const
+  {
+    const char funame [] = "BlockCholesky::invert: ";
+
+    if(m.size1() != _size) {
+      std::cerr << funame << "dimensions mismatch\n";
+      throw Error::Range();
+    }
+
+    const int rhs = m.size2();
+
+    Lapack::Matrix res(_size, rhs);
+
+    // D^-1 * m
+    std::vector<Lapack::Matrix> z(_diag.size());
+    for(int w = 0; w < _diag.size(); ++w) {
+      Lapack::Matrix mw(_diag[w].size(), rhs);
+      for(int j = 0; j < rhs; ++j)
+	for(int r = 0; r < _diag[w].size(); ++r)
+	  mw(r, j) = m(r + _shift[w], j);
+
+      z[w] = _diag[w].invert(mw);
+    }
+
+    if(_cap.size()) {
+      //
+      // (1 + U^T * D^-1 * U)^-1 * U^T * D^-1 * m
+      Lapack::Matrix t(_cap[0].size(), rhs);
+      t = 0.;
+      for(int w = 0; w < _diag.size(); ++w) {
+	if(!_col[w].size())
+	  continue;
+
+	const Lapack::Matrix tw = _u[w].transpose_product(z[w]);
+	for(int j = 0; j < rhs; ++j)
+	  for(int i = 0; i < _col[w].size(); ++i)
+	    t(_col[w][i], j) += tw(i, j);
+      }
+
+      t = _cap[0].invert(t);
+
+      for(int w = 0; w < _diag.size(); ++w) {
+	if(!_col[w].size())
+	  continue;
+
+	Lapack::Matrix tw(_col[w].size(), rhs);
+	for(int j = 0; j < rhs; ++j)
+	  for(int i = 0; i < _col[w].size(); ++i)
+	    tw(i, j) = t(_col[w][i], j);
+
+	z[w] -= _y[w] * tw;
+      }
+    }
+
+    for(int w = 0; w < _diag.size(); ++w)
+      for(int j = 0; j < rhs; ++j)
+	for(int r = 0; r < _diag[w].size(); ++r)
+	  res(r + _shift[w], j) = z[w](r, j);
+
+    return res;
+  }
+
+  // spectral solution of the relaxation modes equations, K * X = B, with K = R + p * C,
+  // R * V = C * V * E, and V^T * C * V = 1: X = V * (E + p)^-1 * V^T * B, refined by the
+  // double precision residuals for the single precision eigenvectors
+  //
+  Lapack::Matrix spectral_solve (const MasterEquation::Context& cx, double pfac, const Lapack::Vector& crm_inv, const Lapack::Matrix& rhs)
+  {
+    const char funame [] = "MasterEquation::spectral_solve: ";
+
+    static const int    refine_max = 20;
+    static const double refine_tol = 1.e-13;
+
+    const int crm_size = crm_inv.size();
+
+    Lapack::Matrix res = cx.crm_basis.transpose_product(rhs);
+    for(int r = 0; r < crm_size; ++r)
+      res.row(r) *= crm_inv[r];
+
+    res = cx.crm_basis * res;
+
+    const double* bp = rhs;
+    const long rhs_size = (long)rhs.size1() * rhs.size2();
+
+    double rhs_norm = 0.;
+    for(long i = 0; i < rhs_size; ++i)
+      if(std::fabs(bp[i]) > rhs_norm)
+	rhs_norm = std::fabs(bp[i]);
+
+    if(rhs_norm == 0.)
+      return res;
+
+    double resid_norm_prev = -1.;
+
+    for(int iter = 0; iter < refine_max; ++iter) {
+      // residual, B - R * X - p * C * X
+      Lapack::Matrix resid = cx.crm_collision * res;
+      resid *= -pfac;
+      resid -= cx.crm_reactive * res;
+      resid += rhs;
+
+      const double* rp = resid;
+      double resid_norm = 0.;
+      for(long i = 0; i < rhs_size; ++i)
+	if(std::fabs(rp[i]) > resid_norm)
+	  resid_norm = std::fabs(rp[i]);
+
+      resid_norm /= rhs_norm;
+
+      if(resid_norm < refine_tol)
+	return res;
+
+      if(resid_norm_prev > 0. && resid_norm > resid_norm_prev / 2.) {
+	IO::log << IO::log_offset << funame << "WARNING: refinement stalled at the relative residual "
+		<< resid_norm << ": use the double precision\n";
+	return res;
+      }
+
+      resid_norm_prev = resid_norm;
+
+      Lapack::Matrix corr = cx.crm_basis.transpose_product(resid);
+      for(int r = 0; r < crm_size; ++r)
+	corr.row(r) *= crm_inv[r];
+
+      res += cx.crm_basis * corr;
+    }
+
+    IO::log << IO::log_offset << funame << "WARNING: refinement did not converge in "
+	    << refine_max << " iterations: use the double precision\n";
+    
+    return res;
+  }
+}
+
+// chemical eigenvalues and eigenvectors in the requested precision
+//
+Lapack::Vector MasterEquation::chemical_eigenvalues (const Lapack::SymmetricMatrix& k_11, Lapack::Matrix& chem_evec)
+{
+  const char funame [] = "MasterEquation::chemical_eigenvalues: ";
+
+  switch(chemical_precision) {
+    //
+  case DOUBLE_PRECISION:
+    //
+    return k_11.eigenvalues(&chem_evec);
+
+  case REFINED_PRECISION:
+    //
+    return k_11.refined_eigenvalues(&chem_evec);
+
+  case MULTIPLE_PRECISION:
+    //
+#ifdef WITH_MPACK
+
+    return Mpack::dd_eigenvalues(k_11, &chem_evec);
+
+#else
+
+    std::cerr << funame << "multiple precision diagonalization is not available: compile with MPACK\n";
+    throw Error::Init();
+
+#endif
+
+  default:
+    //
+    std::cerr << funame << "unknown precision: " << chemical_precision << "\n";
+    throw Error::Logic();
+  }
+}
+
+void MasterEquation::low_eigenvalue_matrix (Lapack::SymmetricMatrix& k_11, Lapack::SymmetricMatrix& k_33, 
+					    Lapack::Matrix& k_13, Lapack::Matrix& l_21) 
+{
+  const char funame [] = "MasterEquation::low_eigenvalue_matrix: ";
+
+  IO::Marker funame_marker(funame);
+
+  if(!isset()) {
+    std::cerr << funame << "reactive complex is not set\n";
+    throw Error::Init();
+  }
+
+  int            itemp;
+  double         dtemp;
+  bool           btemp;
+  std::string    stemp;
+
+  Lapack::Vector vtemp;
+  Lapack::Matrix mtemp;  
+
+  // total collisional relaxation modes dimension and index shifts for individual wells 
+  std::vector<int> well_shift(Model::well_size());
+  itemp = 0;
+  for(int w = 0; w < Model::well_size(); itemp += well(w++).crm_size())
+    well_shift[w] = itemp;
+  
+  const int crm_size = itemp;
+  //IO::log << IO::log_offset << "global relaxation matrix size =  " << crm_size << "\n";
+
+  // kinetic relaxation matrices
+  k_11.resize(Model::well_size()); // chemical modes
+  k_13.resize(Model::well_size(),  Model::bimolecular_size()); // chemical basis
+  k_11 = 0.;
+  k_13 = 0.;
+ 
+  // the relaxation modes matrices are pressure independent, except for the collisional part,
+  // and are set only once per temperature
+  Context& cx = context();
+
+  // the block solver does not form the global relaxation modes matrix
+  const bool block = crm_solver == BLOCK_SOLVER;
+
+  const bool cache = incremental_pressure && !block;
+
+  const bool cached = cache && cx.crm_pressure > 0. && cx.crm_reactive.size() == crm_size;
+
+  Lapack::Matrix k_21; // chemical-to-collision modes
+  Lapack::SymmetricMatrix k_22; // collision modes
+  Lapack::Matrix k_23; // relaxational basis
+  Lapack::SymmetricMatrix k_col; // collisional part of k_22
+
+  // block form of k_22: the well blocks without the inner barriers and the barriers coupling vectors
+  std::vector<Lapack::SymmetricMatrix> d_22;
+  std::vector<Lapack::Matrix>          u_22;
+  std::vector<std::vector<int> >       u_col;
+  int                                  cap_size = 0;
+
+  if(cached) {
+    //
+    k_21 = cx.crm_chem;
+    k_23 = cx.crm_bim;
+  }
+  else {
+    //
+    k_21.resize(crm_size, Model::well_size());
+    k_21 = 0.;
+    if(!block) {
+      k_22.resize(crm_size);
+      k_22 = 0.;
+    }
+    k_23.resize(crm_size, Model::bimolecular_size());
+    k_23 = 0.;
+
+    if(cache) {
+      k_col.resize(crm_size);
+      k_col = 0.;
+    }
+  }
+  
+  /*********************************** GLOBAL MATRICES **************************************/
+
+  {
+    IO::Marker work_marker("setting up kinetic matrices", IO::Marker::ONE_LINE);
+
+    // k_11 initialization
+    for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+      int w1 = Model::inner_connect(b).first;
+      int w2 = Model::inner_connect(b).second;
+      dtemp = 0.;
+      for(int i = 0; i < inner_barrier(b).size(); ++i)
+	dtemp += inner_barrier(b).state_number(i) * thermal_factor(i);
+      k_11(w1, w2) = - dtemp / 2. / M_PI / well(w1).weight_sqrt() / well(w2).weight_sqrt();
+    }
+  
+    for(int w = 0; w < Model::well_size(); ++w) {
+      dtemp = 0.;
+      for(int i = 0; i < context().cum_stat_num[w].size(); ++i)
+	dtemp += context().cum_stat_num[w][i] * thermal_factor(i);
+      dtemp /= 2. * M_PI * well(w).weight();
+      k_11(w, w) = dtemp;
+      if(Model::well(w).escape()) {
+	dtemp = 0.;
+	for(int i = 0; i < well(w).size(); ++i)
+	  dtemp += well(w).escape_rate(i) * well(w).boltzman(i);
+	dtemp /= well(w).weight();
+	k_11(w, w) += dtemp;
+      }
+    }
+
+    // k_21 initialization
+    for(int b = 0; b < Model::inner_barrier_size() && !cached; ++b) {
+      int w1 = Model::inner_connect(b).first;
+      int w2 = Model::inner_connect(b).second;    
+      vtemp.resize(inner_barrier(b).size());
+      for(int dir = 0; dir < 2; ++dir) {
+	if(dir)
+	  std::swap(w1, w2);
+
+	for(int i = 0; i < inner_barrier(b).size(); ++i)
+	  vtemp[i] = inner_barrier(b).state_number(i) / 2. / M_PI / well(w1).state_density(i) 
+	    / well(w2).weight_sqrt();
+
+	for(int r = 0; r < well(w1).crm_size(); ++r)
+	  k_21(r + well_shift[w1], w2) = -parallel_vdot(well(w1).crm_column(r), vtemp, vtemp.size()) ;
+      }
+    }
+    
+    for(int w = 0; w < Model::well_size() && !cached; ++w) {
+      if(Model::well(w).escape()) {
+	vtemp.resize(well(w).size());
+	for(int i = 0; i < well(w).size(); ++i)
+	  vtemp[i] = well(w).escape_rate(i) / well(w).weight_sqrt();
+      }
+      else {
+	vtemp.resize(context().cum_stat_num[w].size());
+	vtemp = 0.;
+      }
+      for(int i = 0; i < context().cum_stat_num[w].size(); ++i)
+	vtemp[i] += context().cum_stat_num[w][i] / 2. / M_PI / well(w).state_density(i) / well(w).weight_sqrt();
+      for(int r = 0; r < well(w).crm_size(); ++r)
+	k_21(r + well_shift[w], w) =  parallel_vdot(well(w).crm_column(r), vtemp, vtemp.size());
+    }
+
+    // k_22 initialization
+    // nondiagonal isomerization
+    for(int b = 0; b < Model::inner_barrier_size() && !cached && !block; ++b) {
+      int w1 = Model::inner_connect(b).first;
+      int w2 = Model::inner_connect(b).second;    
+
+      vtemp.resize(inner_barrier(b).size());
+      for(int i = 0; i < inner_barrier(b).size(); ++i)
+	vtemp[i] = inner_barrier(b).state_number(i) / 2. / M_PI / well(w1).state_density(i) 
+	  / well(w2).state_density(i) / thermal_factor(i);
+
+      for(int r1 = 0; r1 < well(w1).crm_size(); ++r1) 
+	for(int r2 = 0; r2 < well(w2).crm_size(); ++r2) {
+	  k_22(r1 + well_shift[w1], r2 + well_shift[w2]) =
+	    -triple_product(well(w1).crm_column(r1), well(w2).crm_column(r2), vtemp, vtemp.size());
+	}
+    }
+
+    // diagonal isomerization
+    for(int w = 0; w < Model::well_size() && !cached && !block; ++w) {
+      if(Model::well(w).escape()) {
+	vtemp.resize(well(w).size());
+	for(int i = 0; i < well(w).size(); ++i)
+	  vtemp[i] = well(w).escape_rate(i) / well(w).boltzman(i);
+      }
+      else {
+	vtemp.resize(context().cum_stat_num[w].size());
+	vtemp = 0.;
+      }
+      for(int i = 0; i < context().cum_stat_num[w].size(); ++i) {
+	dtemp = well(w).state_density(i);
+	vtemp[i] += context().cum_stat_num[w][i] / 2. / M_PI / dtemp / dtemp / thermal_factor(i);
+      }
+
+      for(int r1 = 0; r1 < well(w).crm_size(); ++r1) 
+	for(int r2 = r1; r2 < well(w).crm_size(); ++r2) {
+	  k_22(r1 + well_shift[w], r2 + well_shift[w]) =  
+	    triple_product(well(w).crm_column(r1), well(w).crm_column(r2), vtemp, vtemp.size());
+	}
+    }
+
+    // collisional energy transfer 
+    for(int w = 0; w < Model::well_size() && !cached && !block; ++w) {
+      // the context is resolved outside of the parallel region
+      const Well&  cw    = well(w);
+      const double cfreq = cw.collision_frequency();
+
+      const Lapack::PackedView<double>       km = cache ? k_col.unchecked() : k_22.unchecked();
+      const Lapack::PackedView<const double> ck = cw.crm_kernel().unchecked();
+      const int                              ws = well_shift[w];
+      
+#pragma omp parallel for default(shared) schedule(dynamic)
+
+      for(int r2 = 0; r2 < cw.crm_size(); ++r2) {
+	double*       kp = &km(ws, r2 + ws);
+	const double* cp = ck.column(r2);
+	
+	for(int r1 = 0; r1 <= r2; ++r1)
+	  kp[r1] +=  cfreq * cp[r1];
+      }
+    }
+
+    // radiational transitions contribution
+    for(int w = 0; w < Model::well_size() && !cached && !block; ++w) 
+      if(well(w).radiation()) {
+	const Well& cw = well(w);
+
+#pragma omp parallel for default(shared) schedule(dynamic)
+	
+	for(int r1 = 0; r1 < cw.crm_size(); ++r1) {
+	  for(int r2 = r1; r2 < cw.crm_size(); ++r2)
+	    k_22(r1 + well_shift[w], r2 + well_shift[w]) +=  
+	    cw.crm_radiation_rate(r1, r2);
+	}
+      }
+
+    // well blocks: escape, bimolecular channels, collisions, and radiation
+    for(int w = 0; w < Model::well_size() && block; ++w) {
+      //
+      const Well&  cw    = well(w);
+      const double cfreq = cw.collision_frequency();
+
+      itemp = Model::well(w).escape() ? cw.size() : 0;
+      for(int b = 0; b < Model::outer_barrier_size(); ++b)
+	if(Model::outer_connect(b).first == w && outer_barrier(b).size() > itemp)
+	  itemp = outer_barrier(b).size();
+
+      vtemp.resize(itemp);
+      vtemp = 0.;
+
+      if(Model::well(w).escape())
+	for(int i = 0; i < cw.size(); ++i)
+	  vtemp[i] = cw.escape_rate(i) / cw.boltzman(i);
+
+      for(int b = 0; b < Model::outer_barrier_size(); ++b)
+	if(Model::outer_connect(b).first == w)
+	  for(int i = 0; i < outer_barrier(b).size(); ++i) {
+	    dtemp = cw.state_density(i);
+	    vtemp[i] += outer_barrier(b).state_number(i) / 2. / M_PI / dtemp / dtemp / thermal_factor(i);
+	  }
+
+      Lapack::SymmetricMatrix dw(cw.crm_size());
+
+      for(int r1 = 0; r1 < cw.crm_size(); ++r1) 
+	for(int r2 = r1; r2 < cw.crm_size(); ++r2)
+	  dw(r1, r2) = (vtemp.size() ? triple_product(cw.crm_column(r1), cw.crm_column(r2), vtemp, vtemp.size()) : 0.)
+	    + cfreq * cw.crm_kernel(r1, r2);
+
+      if(cw.radiation())
+	for(int r1 = 0; r1 < cw.crm_size(); ++r1) 
+	  for(int r2 = r1; r2 < cw.crm_size(); ++r2)
+	    dw(r1, r2) += cw.crm_radiation_rate(r1, r2);
+
+      d_22.push_back(dw);
+    }
+
+    // inner barriers coupling vectors, one per barrier energy bin
+    if(block) {
+      //
+      u_col.resize(Model::well_size());
+      for(int b = 0; b < Model::inner_barrier_size(); ++b)
+	for(int i = 0; i < inner_barrier(b).size(); ++i, ++cap_size) {
+	  u_col[Model::inner_connect(b).first].push_back(cap_size);
+	  u_col[Model::inner_connect(b).second].push_back(cap_size);
+	}
+
+      u_22.resize(Model::well_size());
+      for(int w = 0; w < Model::well_size(); ++w)
+	if(u_col[w].size())
+	  u_22[w].resize(well(w).crm_size(), u_col[w].size());
+
+      std::vector<int> u_fill(Model::well_size());
+      for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+	vtemp.resize(inner_barrier(b).size());
+	for(int i = 0; i < inner_barrier(b).size(); ++i)
+	  vtemp[i] = std::sqrt(inner_barrier(b).state_number(i) / 2. / M_PI / thermal_factor(i));
+
+	for(int dir = 0; dir < 2; ++dir) {
+	  const int    w    = dir ? Model::inner_connect(b).second : Model::inner_connect(b).first;
+	  const double sign = dir ? -1. : 1.;
+
+	  for(int i = 0; i < inner_barrier(b).size(); ++i)
+	    for(int r = 0; r < well(w).crm_size(); ++r)
+	      u_22[w](r, u_fill[w] + i) = sign * well(w).crm_column(r)[i] * vtemp[i] / well(w).state_density(i);
+
+	  u_fill[w] += inner_barrier(b).size();
+	}
+      }
+    }
+
+    // bimolecular number of states 
+    for(int b = 0; b < Model::outer_barrier_size(); ++b) {
+      const int w = Model::outer_connect(b).first;
+      const int p = Model::outer_connect(b).second;
+
+      // chemical modes
+      dtemp = 0.;
+      for(int i = 0; i < outer_barrier(b).size(); ++i)
+	dtemp += outer_barrier(b).state_number(i) * thermal_factor(i);
+      k_13(w, p) = dtemp / 2. / M_PI / well(w).weight_sqrt();
+    
+      // relaxation modes
+      if(cached)
+	continue;
+      
+      vtemp.resize(outer_barrier(b).size());
+      for(int i = 0; i < outer_barrier(b).size(); ++i)
+	vtemp[i] = outer_barrier(b).state_number(i) / 2. / M_PI / well(w).state_density(i);
+    
+      for(int r = 0; r < well(w).crm_size(); ++r)
+	k_23(r + well_shift[w], p) = parallel_vdot(well(w).crm_column(r), vtemp, vtemp.size());
+    }
+  }
+
+  /****************************** SOLVING MASTER EQUATION *************************************/
+
+  if(cache && !cached) {
+    //
+    cx.crm_reactive  = k_22;
+    cx.crm_collision = k_col;
+    cx.crm_chem      = k_21;
+    cx.crm_bim       = k_23;
+    cx.crm_pressure  = pressure();
+
+    cx.crm_eval = Lapack::Vector();
+  }
+
+  const double pfac = cache ? pressure() / cx.crm_pressure : 1.;
+
+  if(cache && crm_solver == CHOLESKY_SOLVER) {
+    //
+    // new storage: the reactive part is shared with the context
+    k_22 = Lapack::SymmetricMatrix(crm_size);
+
+    double*       kp = k_22;
+    const double* rp = cx.crm_reactive;
+    const double* cp = cx.crm_collision;
+    
+    const long packed_size = (long)crm_size * (crm_size + 1) / 2;
+
+#pragma omp parallel for default(shared) schedule(static)
+
+    for(long i = 0; i < packed_size; ++i)
+      kp[i] = rp[i] + pfac * cp[i];
+  }
+
+  if(cache && crm_solver == SPECTRAL_SOLVER) {
+    //
+    // k_22 = crm_reactive + pressure / crm_pressure * crm_collision; with crm_reactive * V = crm_collision * V * eval
+    // and V^T * crm_collision * V = 1, the inverse of k_22 is V * (eval + pressure / crm_pressure)^-1 * V^T
+    //
+    IO::Marker work_marker("inverting kinetic matrices", IO::Marker::ONE_LINE);
+
+    if(!cx.crm_eval.isinit()) {
+      //
+      cx.crm_eval = crm_precision == SINGLE_PRECISION ?
+	Lapack::diagonalize<float>(cx.crm_reactive, cx.crm_collision, &cx.crm_basis) :
+	Lapack::diagonalize<double>(cx.crm_reactive, cx.crm_collision, &cx.crm_basis);
+
+      // the couplings in the pressure independent basis
+      if(crm_precision != SINGLE_PRECISION) {
+	cx.crm_basis_chem = cx.crm_basis.transpose_product(k_21);
+
+	if(Model::bimolecular_size())
+	  cx.crm_basis_bim = cx.crm_basis.transpose_product(k_23);
+      }
+    }
+
+    Lapack::Vector crm_inv(crm_size);
+    for(int r = 0; r < crm_size; ++r) {
+      dtemp = cx.crm_eval[r] + pfac;
+
+      if(dtemp <= 0.) {
+	std::cerr << funame << "relaxation modes kinetic matrix is not positive definite\n";
+	throw Error::Math();
+      }
+      crm_inv[r] = 1. / dtemp;
+    }
+
+    if(crm_precision == SINGLE_PRECISION) {
+      //
+      l_21 = spectral_solve(cx, pfac, crm_inv, k_21);
+
+      // well-to-well rate coefficients
+      k_11.add_transpose_product(k_21, l_21, -1.);
+
+      if(Model::bimolecular_size()) {
+	// bimolecular-to-bimolecular rate coefficients
+	k_33 = k_23.symmetric_transpose_product(spectral_solve(cx, pfac, crm_inv, k_23));
+
+	// well-to-bimolecular rate coefficients
+	k_13.add_transpose_product(l_21, k_23, -1.);
+      }
+
+      return;
+    }
+
+    const Lapack::Matrix crm_chem = cx.crm_basis_chem;
+
+    // (eval + pressure / crm_pressure)^-1 * V^T * k_21
+    Lapack::Matrix d_chem = crm_chem.copy();
+    for(int r = 0; r < crm_size; ++r)
+      d_chem.row(r) *= crm_inv[r];
+
+    l_21 = cx.crm_basis * d_chem;
+
+    // well-to-well rate coefficients
+    k_11.add_transpose_product(crm_chem, d_chem, -1.);
+
+    if(Model::bimolecular_size()) {
+      //
+      const Lapack::Matrix crm_bim = cx.crm_basis_bim;
+
+      Lapack::Matrix d_bim = crm_bim.copy();
+      for(int r = 0; r < crm_size; ++r)
+	d_bim.row(r) *= crm_inv[r];
+
+      // bimolecular-to-bimolecular rate coefficients
+      k_33 = crm_bim.symmetric_transpose_product(d_bim);
+
+      // well-to-bimolecular rate coefficients
+      k_13.add_transpose_product(d_chem, crm_bim, -1.);
+    }
+  }
+  else if(block) {
+    //
+    if(cap_size > crm_size)
+      IO::log << IO::log_offset << funame << "WARNING: barriers coupling dimension, " << cap_size
+	      << ", exceeds the relaxation modes dimension, " << crm_size << ": the cholesky solver is faster\n";
+
+    IO::Marker work_marker("inverting kinetic matrices", IO::Marker::ONE_LINE);
+    BlockCholesky l_22(d_22, u_22, u_col, cap_size);
+    l_21 = l_22.invert(k_21);
+
+    // well-to-well rate coefficients
+    k_11.add_transpose_product(k_21, l_21, -1.);
+
+    if(Model::bimolecular_size()) {
+      // bimolecular-to-bimolecular rate coefficients
+      k_33 = k_23.symmetric_transpose_product(l_22.invert(k_23));
+
+      // well-to-bimolecular rate coefficients
+      k_13.add_transpose_product(l_21, k_23, -1.);
+    }
+  }
+  else {
+    IO::Marker work_marker("inverting kinetic matrices", IO::Marker::ONE_LINE);
+    Lapack::Cholesky l_22(k_22);
+    l_21 = l_22.invert(k_21);
+
+    // well-to-well rate coefficients
+    k_11.add_transpose_product(k_21, l_21, -1.);
+
+    if(Model::bimolecular_size()) {
+      // bimolecular-to-bimolecular rate coefficients
+      k_33 = k_23.symmetric_transpose_product(l_22.invert(k_23));
+
+      // well-to-bimolecular rate coefficients
+      k_13.add_transpose_product(l_21, k_23, -1.);
+    }
+  }
+}
+
+void MasterEquation::low_eigenvalue_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags) 
+  
+{
+  const char funame [] = "MasterEquation::low_eigenvalue_method: ";
+
+  IO::Marker funame_marker(funame);
+
+  int            itemp;
+  double         dtemp;
+  bool           btemp;
+  std::string    stemp;
+
+  Lapack::Vector vtemp;
+  Lapack::Matrix mtemp;  
+
+  IO::log << IO::log_offset << "Pressure = ";
+  switch(pressure_unit) {
+  case BAR:
+    IO::log << pressure() / Phys_const::bar << " bar";
+    break;
+  case TORR:
+    IO::log << pressure() / Phys_const::tor << " torr";
+    break;
+  case ATM:
+    IO::log << pressure() / Phys_const::atm << " atm";
+    break;
+  }
+
+  IO::log << "\t Temperature = "
+	  << temperature() / Phys_const::kelv << " K\n";
+  //<< IO::log_offset << "collision frequency = " 
+  //<< MasterEquation::collision_frequency() / Phys_const::herz
+  //<< " 1/sec\n";
+
+  // the wells losing faster than they relax do not separate as the chemical species; the direct
+  // method finds the chemical subspace itself, unless the smallest chemical eigenvalue is too small for it
+  if(separation_check > 0.) {
+    std::vector<double> ratio = loss_ratio_estimate();
+
+    const double min_ratio = *std::min_element(ratio.begin(), ratio.end());
+    const double max_ratio = *std::max_element(ratio.begin(), ratio.end());
+
+    if(max_ratio > separation_check) {
+      IO::log << IO::log_offset << "estimated loss rate / minimal relaxation eigenvalue: min = " 
+	      << min_ratio << ", max = " << max_ratio << "\n";
+
+      if(min_ratio > min_chem_eval) {
+	IO::log << IO::log_offset << "WARNING: chemical and relaxation eigenvalues are not separated, "
+		<< "using direct diagonalization method\n";
+
+	direct_diagonalization_method(rate_data, well_partition, flags);
+	return;
+      }
+
+      IO::log << IO::log_offset << "WARNING: chemical and relaxation eigenvalues may not be separated\n";
+    }
+  }
+
+  rate_data.clear();
+
+  Lapack::SymmetricMatrix k_11;
+  Lapack::Matrix k_13;
+  Lapack::SymmetricMatrix k_33;
+  Lapack::Matrix l_21;
+  low_eigenvalue_matrix(k_11, k_33, k_13, l_21);
+
+  std::vector<int> well_shift(Model::well_size());
+  itemp = 0;
+  for(int w = 0; w < Model::well_size(); itemp += well(w++).crm_size())
+    well_shift[w] = itemp;
+  const int crm_size = itemp;
+
+  // hot distribution
+  Lapack::Matrix hot_chem;
+  if(context().hot_energy_size) {
+    hot_chem.resize(context().hot_energy_size, Model::well_size());
+    hot_chem = 0.;
+    vtemp.resize(crm_size);
+    
+    std::map<int, std::vector<int> >::const_iterator hit;
+    int count = 0;
+    for(hit = context().hot_index.begin(); hit != context().hot_index.end(); ++hit)
+      for(int i = 0; i < hit->second.size(); ++i, ++count) {
+	hot_chem(count, hit->first) = 1. / well(hit->first).weight_sqrt();
+	
+	vtemp = 0.;
+	itemp = 0;
+	for(int r = 0; r < well(hit->first).crm_size(); ++r) 
+	  vtemp[r + well_shift[hit->first]] = well(hit->first).crm_bra(hit->second[i], r); 
+	hot_chem.row(count) -= vtemp * l_21;
+      }  
+  }
+  
+  // well escape 
+  Lapack::Matrix escape_chem;
+  if(Model::escape_size()) {
+    escape_chem.resize(Model::escape_size(), Model::well_size());
+    escape_chem = 0.;
+    vtemp.resize(crm_size);
+    for(int count = 0; count < Model::escape_size(); ++count) {
+      const int w = Model::escape_well_index(count);
+
+      dtemp = 0.;
+      for(int i = 0; i < well(w).size(); ++i)
+	dtemp += well(w).escape_rate(i) * well(w).boltzman(i);
+      dtemp /= well(w).weight_sqrt();
+
+      escape_chem(count, w) = dtemp;
+
+      vtemp = 0.;
+      for(int r = 0; r < well(w).crm_size(); ++r) 
+	vtemp[r + well_shift[w]] = parallel_vdot(well(w).crm_column(r), well(w).escape_rate(), well(w).size());
+ 
+      escape_chem.row(count) -= vtemp * l_21;
+    }
+  }// well escape
+
+  // minimal energy relaxation eigenvalue
+  double min_relax_eval, max_relax_eval;
+  int wmin, wmax;
+  for(int w = 0; w < Model::well_size(); ++w) {
+    double rmin, rmax;  
+    if(well(w).radiation()) {// radiational transitions contribution
+      Lapack::SymmetricMatrix erk(well(w).crm_size());
+      const Well&  cw    = well(w);
+      const double cfreq = cw.collision_frequency();
+      
+#pragma omp parallel for default(shared) schedule(dynamic)
+	
+      for(int r1 = 0; r1 < cw.crm_size(); ++r1) {
+	  for(int r2 = r1; r2 < cw.crm_size(); ++r2)
+	    erk(r1, r2) =  cw.crm_radiation_rate(r1, r2)
+	      + cfreq * cw.crm_kernel(r1, r2);
+	}
+      vtemp = erk.eigenvalues();
+      rmin = vtemp.front();
+      rmax = vtemp.back();
+    }
+    else {
+      rmin = well(w).minimal_relaxation_eigenvalue() * well(w).collision_frequency();
+      rmax = well(w).maximal_relaxation_eigenvalue() * well(w).collision_frequency();
+    }
+
+    if(!w || rmin < min_relax_eval) {
+      min_relax_eval = rmin;
+      wmin = w;
+    }
+    if(!w || rmax > max_relax_eval) {
+      wmax = w;
+      max_relax_eval = rmax;
+    }
+  }
+
+  IO::log << IO::log_offset 
+	  << "minimal relaxation eigenvalue / collisional frequency = "  
+	  << min_relax_eval / well(wmin).collision_frequency() << "\n";
+  //	  << IO::log_offset
+  //	  << "maximal relaxation eigenvalue / collisional frequency = "  
+  //	  << max_relax_eval / collision_frequency() << "\n";
+
+  // chemical eigenvalues and eigenvectors
+  Lapack::Matrix chem_evec(Model::well_size());
+
+  Lapack::Vector chem_eval = chemical_eigenvalues(k_11, chem_evec);
+  
+  // relaxational projection of the chemical eigenvector
+  l_21 = l_21 * chem_evec;
+  Lapack::Vector rel_proj(Model::well_size());
+  for(int l = 0; l < Model::well_size(); ++l)
+    rel_proj[l] = vdot(l_21.column(l));
+
+  // eigenvalues output
+  if(eval_out.is_open()) {
+    std::ostringstream label;
+    label << std::setw(13) << temperature() / Phys_const::kelv;
+    switch(pressure_unit) {
+    case BAR:
+      label << pressure() / Phys_const::bar;
+      break;
+    case TORR:
+      label << pressure() / Phys_const::tor;
+      break;
+    case ATM:
+      label << pressure() / Phys_const::atm;
+      break;
+    }
+    std::vector<double> row;
+    row.push_back(well(wmin).collision_frequency() / Phys_const::herz);
+    row.push_back(min_relax_eval / well(wmin).collision_frequency());
+    for(int l = 0; l < Model::well_size(); ++l) {
+      row.push_back(chem_eval[l] / well(wmin).collision_frequency());
+      row.push_back(rel_proj[l]);
+    }
+    IO::put_table(eval_out, label.str(), &row[0], 1, row.size());
+  }
+
+  /************************************* EIGENVECTOR OUTPUT *****************************************/
+
+  IO::log << std::setprecision(3)
+	  << IO::log_offset << "eigenvector populations normalized:\n"
+	  << IO::log_offset 
+	  << std::setw(5)  << "L"
+	  << std::setw(10) << "*R"
+	  << std::setw(10) << "*P";
+  for(int w = 0; w < Model::well_size(); ++w)
+    IO::log << std::setw(10) << Model::well(w).name();  
+  IO::log << "\n";
+
+  // maximal population
+  for(int l = 0; l < Model::well_size(); ++l) {
+
+    double pos_pop = 0.;
+    double neg_pop = 0.;
+    for(int w = 0; w < Model::well_size(); ++w) {
+      dtemp = chem_evec(w, l) * well(w).weight_sqrt();
+      if(dtemp > 0.)
+	pos_pop += dtemp;
+      if(dtemp < 0.)
+	neg_pop += dtemp;
+    }
+    double max_pop = pos_pop > -neg_pop ? pos_pop : neg_pop;
+    
+    IO::log << IO::log_offset
+	    << std::setw(5)  << l
+	    << std::setw(10) << chem_eval[l] / min_relax_eval
+	    << std::setw(10) << rel_proj[l]; 
+    for(int w = 0; w < Model::well_size(); ++w) {
+      dtemp = chem_evec(w, l) * well(w).weight_sqrt() / max_pop;
+      IO::log << std::setw(10);
+      if(dtemp > .01 || dtemp < -.01)
+	IO::log << dtemp;
+      else
+	IO::log << 0;
+    }
+    IO::log << "\n";
+  }
+
+  IO::log << IO::log_offset << std::setw(5) << "*R" 
+	  << " - eigenvalue over the relaxation limit\n"
+	  << IO::log_offset << std::setw(5) << "*P" 
+	  << " - eigenvector projection squared on the relaxation subspace\n"
+	  << IO::log_offset << "eigenvector projections:\n"
+	  << IO::log_offset 
+	  << std::setw(5)  << "L"
+	  << std::setw(10) << "*Q"
+	  << std::setw(10) << "*P";
+
+  for(int w = 0; w < Model::well_size(); ++w)
+    IO::log << std::setw(10) << Model::well(w).name();  
+  IO::log << "\n";
+
+  for(int l = 0; l < Model::well_size(); ++l) {
+    IO::log << IO::log_offset
+	    << std::setw(5)  << l
+	    << std::setw(10) << chem_eval[l] / well(wmin).collision_frequency()
+	    << std::setw(10) << rel_proj[l]; 
+    for(int w = 0; w < Model::well_size(); ++w)
+      IO::log << std::setw(10) << chem_evec(w, l);
+    IO::log << "\n";
+  }
+  
+  IO::log << IO::log_offset 
+	  << std::setw(5) << "*Z"
+	  << std::setw(10) << "---"
+	  << std::setw(10) << "---";
+  for(int w = 0; w < Model::well_size(); ++w)
+    IO::log << std::setw(10) << well(w).weight_sqrt();
+  IO::log << "\n";
+
+  IO::log << IO::log_offset << std::setw(5) << "*Q" 
+	  << " - eigenvalue over the collision frequency\n"
+	  << IO::log_offset << std::setw(5) << "*P" 
+	  << " - eigenvector projection squared on the relaxation subspace\n"
+	  << IO::log_offset << std::setw(5) << "*Z" 
+	  << " - well partition function square root\n"
+	  << std::setprecision(6);
+  
+  // rate coefficients connecting eigenstates to bimolecular products
+  Lapack::Matrix chem_bim = chem_evec.transpose_product(k_13);
+
+#ifdef DEBUG
+
+  IO::log << IO::log_offset << "eigenvector-to-bimolecular projections:\n";
+  IO::log << IO::log_offset << std::setw(5) << "L\\P";
+  for(int p = 0; p < Model::bimolecular_size(); ++p)
+    IO::log << std::setw(13) << Model::bimolecular(p).name();
+  IO::log << "\n";
+  
+  for(int l = 0; l < Model::well_size(); ++l) {
+    IO::log << IO::log_offset << std::setw(5) << l;  
+    for(int p = 0; p < Model::bimolecular_size(); ++p)
+      IO::log << std::setw(13) << chem_bim(l, p);
+    IO::log << "\n";
+  }
+
+#endif
+
+  // bimolecular rate units
+  const double bru = Phys_const::cm * Phys_const::cm * Phys_const::cm * Phys_const::herz;
+
+  // bimolecular-to-bimolecular rate coefficients
+  for(int i = 0; i < Model::bimolecular_size(); ++i) 
+    if(bimolecular(i).weight() > 0.)
+      for(int j = 0; j < Model::bimolecular_size(); ++j) {
+	dtemp = k_33(i, j) * energy_step();
+	// bimolecular reactant loss
+	if(i == j) {
+	  dtemp = -dtemp;
+	  for(int b = 0; b < Model::outer_barrier_size(); ++b)
+	    if(Model::outer_connect(b).second == i)
+	      dtemp += temperature() / 2. / M_PI * outer_barrier(b).weight();	  
+	}
+	dtemp /= bimolecular(i).weight() * bru;
+	rate_data[std::make_pair(Model::well_size() + i, Model::well_size() + j)] = dtemp; 	
+      }
+  
+  /********************************** CHEMICAL SUBSPACE DIMENSION ****************************************/
+
+  if(default_partition.size())
+    itemp = default_partition.size();
+  else if(chemical_threshold > 0.) {
+    dtemp = 1. / chemical_threshold;
+    for(itemp = 0; itemp < Model::well_size(); ++itemp)
+      if(chem_eval[itemp] / min_relax_eval  > dtemp)
+	break;
+  }
+  else if(chemical_threshold < 0. ) {
+    dtemp = -1. / chemical_threshold;
+    for(itemp = Model::well_size(); itemp > 0; --itemp)
+      if(chem_eval[itemp - 1] / min_relax_eval < dtemp && chem_eval[itemp - 1] / chem_eval[itemp] < dtemp)
+	break;
+  }
+  else
+    itemp = Model::well_size();
+	
+  const int chem_size = itemp;
+
+  if(chem_size != Model::well_size())
+    IO::log << IO::log_offset << "dimension of the chemical subspace = " << chem_size << "\n";
+
+  eigenvalue_gap = chem_size ? min_relax_eval / chem_eval[chem_size - 1] : -1.;
+
+  if(!chem_size)
+    return;
+
+  if(chem_size < Model::well_size()) {// reduction of species
+    // chemical eigenvectors
+    Lapack::Matrix pop_chem(Model::well_size(), chem_size);
     for(int l = 0; l < chem_size; ++l)
       pop_chem.column(l) = chem_evec.column(l);
 
-    // partitioning wells
-    if(default_partition.size()) {
-      // default reduction scheme
-      well_partition = default_partition;
+    // partitioning wells
+    if(default_partition.size()) {
+      // default reduction scheme
+      well_partition = default_partition;
+
+      IO::log << IO::log_offset << "using default reduction scheme, projection error = "
+	      << (double)chem_size - well_partition.projection(pop_chem) << "\n";
+    }
+    else {
+      Group bimolecular_group;
+      dtemp = well_partition_method(pop_chem, well_partition, bimolecular_group, std::vector<double>());
+    }
+
+    // convert chemical eigenvectors in the new basis
+    pop_chem = well_partition.basis().transpose_product(pop_chem);
+
+    std::vector<int>    group_index = well_partition.group_index();
+    std::vector<double>      weight = well_partition.weight();
+    std::vector<double> real_weight = well_partition.real_weight();
+    Lapack::Matrix            basis = well_partition.basis();
+
+    Lapack::Matrix m_direct(pop_chem);
+    Lapack::Matrix m_inverse = m_direct.invert();
+
+    Lapack::Matrix one(m_direct * m_inverse);
+    one.diagonal() -= 1.;
+    double val_max = -1.;
+    for(int i = 0; i < one.size1(); ++i)
+      for(int j = 0; j < one.size2(); ++j) {
+	dtemp = one(i, j);
+	dtemp = dtemp < 0. ? -dtemp : dtemp;
+	if(dtemp > epsilon && dtemp > val_max)
+	  val_max = dtemp;
+      }
+    if(val_max > 0.)
+      IO::log << IO::log_offset << funame 
+	      << "WARNING: matrix inversion error = " << val_max 
+	      << " exceeds numerical accuracy = " << epsilon
+	      << "\n";
+
+    IO::log << IO::log_offset << "species:\n" 
+	    << IO::log_offset << std::setw(2) << "#"  << std::setw(15) 
+	    << "assigned name" << IO::first_offset
+	    << "group\n";
+    for(Pit g = well_partition.begin(); g != well_partition.end(); ++g) {
+      itemp = g - well_partition.begin();
+      IO::log << IO::log_offset << std::setw(2) << itemp << std::setw(15) 
+	      << Model::well(group_index[itemp]).name() << IO::first_offset;
+      for(Git w = g->begin(); w != g->end(); ++w) {
+	if(w != g->begin())
+	  IO::log << "+";
+	IO::log << Model::well(*w).name();
+      }
+      IO::log << "\n";
+    }
+  
+    // rate constant reduction
+    switch(reduction_method) {
+    case PROJECTION:
+      // isomerization
+      k_11 = basis.symmetric_transpose_product(k_11 * basis);
+      // dissociation
+      k_13 = basis.transpose_product(k_13);
+      // new chemcal eigenvalues
+      IO::log << IO::log_offset << "new chemical eigenvalues:";
+      vtemp = k_11.eigenvalues();
+      for(int l = 0; l < chem_size; ++l)
+	IO::log << std::setw(13) << vtemp[l] / well(wmin).collision_frequency();
+      IO::log << "\n";
+      // well-to-well rate coefficients
+      for(int i = 0; i < chem_size; ++i)
+	for(int j = 0; j < chem_size; ++j) {
+	  dtemp = k_11(i, j) * std::sqrt(weight[i] * weight[j])
+	    * energy_step() / real_weight[i] / Phys_const::herz;
+	  if(i != j)
+	    dtemp = -dtemp;
+	  rate_data[std::make_pair(group_index[i], group_index[j])] = dtemp;
+	}
+      // well-to-bimolecular rate coefficients
+      for(int w = 0; w < chem_size; ++w)
+	for(int p = 0; p < Model::bimolecular_size(); ++p)
+	  rate_data[std::make_pair(group_index[w], Model::well_size() + p)] = k_13(w, p) * std::sqrt(weight[w]) 
+	    * energy_step() / real_weight[w] / Phys_const::herz;
+      // bimolecular-to-well rate coefficients
+      for(int p = 0; p < Model::bimolecular_size(); ++p) 
+	if(bimolecular(p).weight() > 0.)
+	  for(int w = 0; w < chem_size; ++w)
+	    rate_data[std::make_pair(Model::well_size() + p, group_index[w])] = k_13(w, p) * std::sqrt(weight[w]) 
+	      * energy_step() / bimolecular(p).weight() / bru;
+      break;
+    case DIAGONALIZATION:
+      // well-to-well rate coefficients
+      for(int i = 0; i < chem_size; ++i)
+	for(int j = 0; j < chem_size; ++j) {
+	  dtemp = 0.;
+	  for(int l = 0; l < chem_size; ++l)
+	    dtemp += m_direct(j, l) * m_inverse(l, i) * chem_eval[l];
+	  dtemp *= std::sqrt(weight[i] * weight[j]) * energy_step() / real_weight[i] / Phys_const::herz;
+	  if(i != j)
+	    dtemp = -dtemp;
+	  rate_data[std::make_pair(group_index[i], group_index[j])] = dtemp;
+	}
+      // well-to-bimolecular rate coefficients
+      for(int w = 0; w < chem_size; ++w)
+	for(int p = 0; p < Model::bimolecular_size(); ++p) {
+	  dtemp = 0.;
+	  for(int l = 0; l < chem_size; ++l)
+	    dtemp += m_inverse(l, w) * chem_bim(l, p);
+	  dtemp *= std::sqrt(weight[w]) * energy_step() / real_weight[w] / Phys_const::herz;
+	  rate_data[std::make_pair(group_index[w], Model::well_size() + p)] = dtemp;
+	}
+      // bimolecular-to-well rate coefficients
+      for(int p = 0; p < Model::bimolecular_size(); ++p) 
+	if(bimolecular(p).weight() > 0.)
+	  for(int w = 0; w < chem_size; ++w) {
+	    dtemp = 0.;
+	    for(int l = 0; l < chem_size; ++l)
+	      dtemp += m_direct(w, l) * chem_bim(l, p);
+	    dtemp *= std::sqrt(weight[w]) * energy_step() / bimolecular(p).weight() 
+	      / bru;
+	    rate_data[std::make_pair(Model::well_size() + p, group_index[w])] = dtemp;
+	  }
+      break;
+    default:
+      std::cerr << funame << "unknown reduction method\n";
+      throw Error::Logic();
+    }
+  }// reduction of species
+  else {// no reduction
+    // well-to-well rate coefficients
+    for(int i = 0; i < Model::well_size(); ++i)
+      for(int j = 0; j < Model::well_size(); ++j) {
+	dtemp = k_11(i, j) * well(i).weight_sqrt() * well(j).weight_sqrt()
+	  * energy_step() / well(i).real_weight() / Phys_const::herz;
+	if(i != j)
+	  dtemp = -dtemp;
+	rate_data[std::make_pair(i, j)] = dtemp;
+      }
+    // well-to-bimolecular rate coefficients
+    for(int w = 0; w < Model::well_size(); ++w)
+      for(int p = 0; p < Model::bimolecular_size(); ++p)
+	rate_data[std::make_pair(w, Model::well_size() + p)] = k_13(w, p) * well(w).weight_sqrt() 
+	  * energy_step() / well(w).real_weight() / Phys_const::herz;
+    // bimolecular-to-well rate coefficients
+    for(int p = 0; p < Model::bimolecular_size(); ++p) 
+      if(bimolecular(p).weight() > 0.)
+	for(int w = 0; w < Model::well_size(); ++w)
+	  rate_data[std::make_pair(Model::well_size() + p, w)] = k_13(w, p) * well(w).weight_sqrt() 
+	    * energy_step() / bimolecular(p).weight() / bru;
+  }// no reduction
+}// Low chemical eigenvalue method
+
+/********************************************************************************************
+ ************************************* AUTOMATIC METHOD *************************************
+ ********************************************************************************************/
+
+// method selection before the diagonalization: the chemical eigenvalues are estimated by the
+// loss rates of the wells, the smaller of the high pressure (thermal barrier flux) and the low
+// pressure (collisional activation above the lowest barrier) limits, relative to the minimal
+// relaxation eigenvalue; the low-eigenvalue method if the slowest well is beyond the direct
+// diagonalization precision, the well-reduction method if the fastest well exchange outruns
+// the energy relaxation
+//
+std::vector<double> MasterEquation::loss_ratio_estimate ()
+{
+  double dtemp;
+
+  // minimal relaxation eigenvalue
+  double min_relax_eval = -1.;
+  for(int w = 0; w < Model::well_size(); ++w) {
+    dtemp = well(w).minimal_relaxation_eigenvalue() * well(w).collision_frequency();
+    if(min_relax_eval < 0. || dtemp < min_relax_eval)
+      min_relax_eval = dtemp;
+  }
+
+  // thermal barrier fluxes and the lowest barriers energy indices
+  std::vector<double> flux(Model::well_size());
+  std::vector<int>    thres(Model::well_size());
+
+  for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+    dtemp = 0.;
+    for(int e = 0; e < inner_barrier(b).size(); ++e)
+      dtemp += inner_barrier(b).state_number(e) * thermal_factor(e);
+
+    const int w1 = Model::inner_connect(b).first;
+    const int w2 = Model::inner_connect(b).second;
+
+    flux[w1] += dtemp;
+    flux[w2] += dtemp;
+
+    thres[w1] = std::max(thres[w1], inner_barrier(b).size());
+    thres[w2] = std::max(thres[w2], inner_barrier(b).size());
+  }
+
+  for(int b = 0; b < Model::outer_barrier_size(); ++b) {
+    dtemp = 0.;
+    for(int e = 0; e < outer_barrier(b).size(); ++e)
+      dtemp += outer_barrier(b).state_number(e) * thermal_factor(e);
+
+    const int w = Model::outer_connect(b).first;
+
+    flux[w] += dtemp;
+
+    thres[w] = std::max(thres[w], outer_barrier(b).size());
+  }
+
+  std::vector<double> res(Model::well_size());
+  for(int w = 0; w < Model::well_size(); ++w) {
+    double pop = 0., act = 0.;
+    for(int i = 0; i < well(w).size(); ++i) {
+      pop += well(w).boltzman(i);
+      if(i < thres[w])
+	act += well(w).boltzman(i);
+    }
+
+    // high and low pressure limits
+    dtemp = flux[w] / 2. / M_PI / pop;
+
+    res[w] = std::min(dtemp, well(w).collision_frequency() * act / pop) / min_relax_eval;
+  }
+
+  return res;
+}
+
+void MasterEquation::automatic_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags)
+{
+  const char funame [] = "MasterEquation::automatic_method: ";
+
+  IO::Marker funame_marker(funame);
+
+  // safety margin over the direct method low eigenvalue limit
+  static const double low_eval_margin = 100.;
+
+  // well exchange to relaxation ratio for the well reduction
+  static const double reduction_ratio = 100.;
+
+  std::vector<double> ratio = loss_ratio_estimate();
+
+  const double min_ratio = *std::min_element(ratio.begin(), ratio.end());
+  const double max_ratio = *std::max_element(ratio.begin(), ratio.end());
+
+  IO::log << IO::log_offset << "estimated loss rate / minimal relaxation eigenvalue: min = " 
+	  << min_ratio << ", max = " << max_ratio << "\n";
+
+  if(min_ratio < low_eval_margin * min_chem_eval) {
+    IO::log << IO::log_offset << "using low-eigenvalue method\n";
+    low_eigenvalue_method(rate_data, well_partition, flags);
+  }
+  else if(Model::well_size() > 1 && max_ratio > reduction_ratio) {
+    IO::log << IO::log_offset << "using well-reduction method\n";
+    well_reduction_method(rate_data, well_partition, flags);
+  }
+  else {
+    IO::log << IO::log_offset << "using direct diagonalization method\n";
+    direct_diagonalization_method(rate_data, well_partition, flags);
+  }
+}
+
+/********************************************************************************************
+ ************************************* SEQUENTIAL METHOD ************************************
+ ********************************************************************************************/
+
+// strong collision screening: at each energy the activated molecules are followed through
+// the wells, over the inner barriers, until they are stabilized, dissociate, or escape;
+// the wells are then merged into the groups one inner barrier at a time, from the lowest
+// barrier up, as long as the exchange between the groups is fast compared to their other losses
+
+void MasterEquation::sequential_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags)
+  
+{
+  const char funame [] = "MasterEquation::sequential_method: ";
+
+  IO::Marker funame_marker(funame);
+
+  // relaxation to exchange rates ratio below which the groups merge
+  static const double merge_ratio = 10.;
+
+  const int well_size = Model::well_size();
+  const int  bim_size = Model::bimolecular_size();
+
+  // destinations: the wells (stabilization), the bimolecular products, and the escape
+  const int dest_size = 2 * well_size + bim_size;
+
+  // energy range with the reactive transitions
+  int emax = 0;
+  for(int b = 0; b < Model::inner_barrier_size(); ++b)
+    emax = std::max(emax, inner_barrier(b).size());
+  for(int b = 0; b < Model::outer_barrier_size(); ++b)
+    emax = std::max(emax, outer_barrier(b).size());
+  for(int w = 0; w < well_size; ++w)
+    if(Model::well(w).escape())
+      emax = std::max(emax, well(w).size());
+
+  // thermal fluxes from the wells and from the bimolecular reactants
+  Lapack::Matrix flux(well_size + bim_size, dest_size);
+  flux = 0.;
+
+  // the context is resolved outside of the parallel region
+  std::vector<const Well*>    cw(well_size);
+  std::vector<const Barrier*> ib(Model::inner_barrier_size());
+  std::vector<const Barrier*> ob(Model::outer_barrier_size());
+
+  for(int w = 0; w < well_size; ++w)
+    cw[w] = &well(w);
+  for(int b = 0; b < ib.size(); ++b)
+    ib[b] = &inner_barrier(b);
+  for(int b = 0; b < ob.size(); ++b)
+    ob[b] = &outer_barrier(b);
+
+  const double  estep = energy_step();
+  const double* tf    = thermal_factor_table(emax);
+
+  std::exception_ptr eptr;
+
+  {
+    IO::Marker work_marker("microcanonical branching", IO::Marker::ONE_LINE);
+
+#pragma omp parallel for default(shared) schedule(dynamic)
+
+    for(int e = 0; e < emax; ++e) {
+      double dtemp;
+
+      try {
+	// wells open at this energy
+	std::vector<int> index(well_size, -1), active;
+	for(int w = 0; w < well_size; ++w)
+	  if(e < cw[w]->size() && cw[w]->state_density(e) > 0.) {
+	    index[w] = active.size();
+	    active.push_back(w);
+	  }
+
+	const int n = active.size();
+
+	if(!n)
+	  continue;
+
+	Lapack::Matrix transfer(n, n);
+	transfer = 0.;
+
+	Lapack::Matrix leave(dest_size, n);
+	leave = 0.;
+
+	// chemical activation by the bimolecular reactants
+	Lapack::Matrix source(n, bim_size);
+	source = 0.;
+
+	for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+	  const int i1 = index[Model::inner_connect(b).first];
+	  const int i2 = index[Model::inner_connect(b).second];
+
+	  if(e >= ib[b]->size() || i1 < 0 || i2 < 0)
+	    continue;
+
+	  dtemp = ib[b]->state_number(e) / 2. / M_PI;
+
+	  transfer(i2, i1) += dtemp / cw[active[i1]]->state_density(e);
+	  transfer(i1, i2) += dtemp / cw[active[i2]]->state_density(e);
+	}
+
+	for(int b = 0; b < Model::outer_barrier_size(); ++b) {
+	  const int i = index[Model::outer_connect(b).first];
+	  const int p = Model::outer_connect(b).second;
+
+	  if(e >= ob[b]->size() || i < 0)
+	    continue;
+
+	  dtemp = ob[b]->state_number(e) / 2. / M_PI;
+
+	  leave(well_size + p, i) += dtemp / cw[active[i]]->state_density(e);
+
+	  source(i, p) += dtemp * tf[e] * estep;
+	}
+
+	for(int i = 0; i < n; ++i) {
+	  const int w = active[i];
+
+	  leave(w, i) = cw[w]->collision_frequency();
+
+	  if(Model::well(w).escape())
+	    leave(well_size + bim_size + w, i) = cw[w]->escape_rate(e);
+	}
+
+	// branching fractions
+	for(int i = 0; i < n; ++i) {
+	  dtemp = 0.;
+	  for(int j = 0; j < n; ++j)
+	    dtemp += transfer(j, i);
+	  for(int d = 0; d < dest_size; ++d)
+	    dtemp += leave(d, i);
+
+	  for(int j = 0; j < n; ++j)
+	    transfer(j, i) /= dtemp;
+	  for(int d = 0; d < dest_size; ++d)
+	    leave(d, i) /= dtemp;
+	}
+
+	// final destinations of the molecules activated in each well
+	for(int i = 0; i < n; ++i) {
+	  for(int j = 0; j < n; ++j)
+	    transfer(j, i) = -transfer(j, i);
+	  transfer(i, i) += 1.;
+	}
+
+	const Lapack::Matrix fate = leave * Lapack::LU(transfer).invert();
+
+	const Lapack::Matrix bim_fate = fate * source;
+
+#pragma omp critical(sequential_flux)
+	{
+	  // collisional activation; the stabilization in the same well does not count
+	  for(int i = 0; i < n; ++i) {
+	    const int w = active[i];
+
+	    dtemp = cw[w]->collision_frequency() * cw[w]->boltzman(e) * estep;
+
+	    for(int d = 0; d < dest_size; ++d)
+	      if(d != w)
+		flux(w, d) += fate(d, i) * dtemp;
+	  }
+
+	  for(int p = 0; p < bim_size; ++p)
+	    for(int d = 0; d < dest_size; ++d)
+	      flux(well_size + p, d) += bim_fate(d, p);
+	}
+      }
+      catch(...) {
+#pragma omp critical(sequential_exception)
+	if(!eptr)
+	  eptr = std::current_exception();
+      }
+    }
+  }
+
+  if(eptr)
+    std::rethrow_exception(eptr);
+
+  double dtemp;
+
+  /************************************* WELL MERGING ***************************************/
+
+  std::multimap<double, int> barrier_map;
+  for(int b = 0; b < Model::inner_barrier_size(); ++b)
+    barrier_map.insert(std::make_pair(Model::inner_barrier(b).real_ground(), b));
+  
+  // group of each well
+  std::vector<int> well_group(well_size);
+
+  // minimal relaxation rate of each group
+  std::vector<double> group_relax(well_size);
+
+  well_partition.clear();
+  for(int w = 0; w < well_size; ++w) {
+    well_partition.push_back(Group().insert(w));
+    well_group[w] = w;
+    group_relax[w] = well(w).minimal_relaxation_eigenvalue() * well(w).collision_frequency();
+  }
+
+  // flux from one group to another
+  Lapack::Matrix group_flux = flux.copy();
+
+  for(std::multimap<double, int>::const_iterator bit = barrier_map.begin(); bit != barrier_map.end(); ++bit) {
+    //
+    const int g1 = well_group[Model::inner_connect(bit->second).first];
+    const int g2 = well_group[Model::inner_connect(bit->second).second];
+
+    if(g1 == g2)
+      continue;
+
+    // exchange eigenvalue
+    const double rate = group_flux(g1, g2) / well_partition[g1].real_weight()
+	+ group_flux(g2, g1) / well_partition[g2].real_weight();
+
+    const double relax = std::min(group_relax[g1], group_relax[g2]);
+
+    IO::log << IO::log_offset << std::setw(5) << Model::inner_barrier(bit->second).name()
+	    << ": relaxation/exchange ratio = " << relax / rate;
+
+    if(rate * merge_ratio < relax) {
+      IO::log << "\n";
+      continue;
+    }
+
+    IO::log << ": merging\n";
+
+    // the second group goes into the first one
+    well_partition[g1].insert(well_partition[g2]);
+    for(Git w = well_partition[g2].begin(); w != well_partition[g2].end(); ++w)
+      well_group[*w] = g1;
+    well_partition[g2].clear();
+
+    group_relax[g1] = relax;
+
+    for(int d = 0; d < dest_size; ++d)
+      group_flux(g1, d) += group_flux(g2, d);
+    for(int s = 0; s < well_size + bim_size; ++s)
+      group_flux(s, g1) += group_flux(s, g2);
+
+    group_flux.row(g2) = 0.;
+    group_flux.column(g2) = 0.;
+
+    group_flux(g1, g1) = 0.;
+  }
+
+  /*********************************** FAST GROUPS REMOVAL **********************************/
+
+  // the groups which decay faster than they relax are not species: the fluxes through them
+  // are redistributed in the quasi-steady-state approximation
+  if(chemical_threshold > 1.)
+    for(int g = 0; g < well_size; ++g) {
+      if(!well_partition[g].size())
+	continue;
+
+      double loss = 0.;
+      for(int d = 0; d < dest_size; ++d)
+	if(d != g)
+	  loss += group_flux(g, d);
+
+      if(loss <= 0.)
+	continue;
+
+      dtemp = group_relax[g] * well_partition[g].real_weight() / loss;
+
+      if(dtemp >= chemical_threshold)
+	continue;
+
+      IO::log << IO::log_offset << "group " << Model::well(well_partition[g].group_index()).name()
+	      << " is not a species: relaxation/loss ratio = " << dtemp << "\n";
+
+      for(int s = 0; s < well_size + bim_size; ++s)
+	if(s != g && group_flux(s, g) > 0.) {
+	  dtemp = group_flux(s, g) / loss;
+	  for(int d = 0; d < dest_size; ++d)
+	    if(d != g)
+	      group_flux(s, d) += dtemp * group_flux(g, d);
+	}
+
+      well_partition[g].clear();
+      group_flux.row(g) = 0.;
+      group_flux.column(g) = 0.;
+
+      for(int s = 0; s < well_size; ++s)
+	group_flux(s, s) = 0.;
+    }
+
+  /*************************************** OUTPUT *******************************************/
+
+  Partition species;
+  for(int g = 0; g < well_size; ++g)
+    if(well_partition[g].size())
+      species.push_back(well_partition[g]);
+
+  // species index of each group
+  std::vector<int> group_species(well_size, -1);
+  for(int g = 0, s = 0; g < well_size; ++g)
+    if(well_partition[g].size())
+      group_species[g] = s++;
+
+  rate_data.clear();
+
+  // bimolecular rate units
+  const double bru = Phys_const::cm * Phys_const::cm * Phys_const::cm * Phys_const::herz;
+
+  for(int g = 0; g < well_size; ++g) {
+    if(!well_partition[g].size())
+      continue;
+
+    const int    gi = well_partition[g].group_index();
+    const double rw = well_partition[g].real_weight() * Phys_const::herz;
+
+    // well-to-well rate coefficients
+    dtemp = 0.;
+    for(int d = 0; d < dest_size; ++d)
+      if(d != g)
+	dtemp += group_flux(g, d);
+    rate_data[std::make_pair(gi, gi)] = dtemp / rw;
+
+    for(int h = 0; h < well_size; ++h)
+      if(h != g && well_partition[h].size())
+	rate_data[std::make_pair(gi, well_partition[h].group_index())] = group_flux(g, h) / rw;
+
+    // well-to-bimolecular rate coefficients
+    for(int p = 0; p < bim_size; ++p)
+      rate_data[std::make_pair(gi, well_size + p)] = group_flux(g, well_size + p) / rw;
+
+    // well-to-escape rate coefficients
+    for(int w = 0; w < well_size; ++w)
+      if(Model::well(w).escape())
+	rate_data[std::make_pair(gi, well_size + bim_size + w)] = group_flux(g, well_size + bim_size + w) / rw;
+  }
+
+  for(int p = 0; p < bim_size; ++p) {
+    if(bimolecular(p).weight() <= 0.)
+      continue;
+
+    const int    s  = well_size + p;
+    const double bw = bimolecular(p).weight() * bru;
+
+    // bimolecular-to-bimolecular rate coefficients, the reactant loss excludes the backward dissociation
+    for(int q = 0; q < bim_size; ++q)
+      if(q != p)
+	rate_data[std::make_pair(s, well_size + q)] = group_flux(s, well_size + q) / bw;
+
+    dtemp = 0.;
+    for(int d = 0; d < dest_size; ++d)
+      if(d != s)
+	dtemp += group_flux(s, d);
+    rate_data[std::make_pair(s, s)] = dtemp / bw;
+
+    // bimolecular-to-well rate coefficients
+    for(int g = 0; g < well_size; ++g)
+      if(well_partition[g].size())
+	rate_data[std::make_pair(s, well_partition[g].group_index())] = group_flux(s, g) / bw;
+
+    // bimolecular-to-escape rate coefficients
+    for(int w = 0; w < well_size; ++w)
+      if(Model::well(w).escape())
+	rate_data[std::make_pair(s, well_size + bim_size + w)] = group_flux(s, well_size + bim_size + w) / bw;
+  }
+
+  well_partition = species;
+}
+
+/********************************************************************************************
+ ********************************** WELL REDUCTION METHOD ***********************************
+ ********************************************************************************************/
+
+// fast horizontal relaxation eigenvectors/eigenvalues are removed from ME
+// and used only for bimolecular-to-bimolecular contributions
+
+struct KineticBasis {
+  int active_size;
+  Lapack::Vector eigenvalue;
+  Lapack::Matrix eigenvector;
+  std::map<int, int> well_index_map;
+  std::vector<int>   index_well_map;
+};
+
+void MasterEquation::well_reduction_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags)
+  
+{
+  const char funame [] = "MasterEquation::well_reduction_method: ";
+
+  static const double machine_eps = 1.e-14;
+
+  if(!isset()) {
+    std::cerr << funame << "reactive complex is not set\n";
+    throw Error::Init();
+  }
+
+  rate_data.clear();
+
+  IO::Marker funame_marker(funame);
+  
+  IO::log << IO::log_offset << "Pressure = ";
+  switch(pressure_unit) {
+  case BAR:
+    IO::log << pressure() / Phys_const::bar << " bar";
+    break;
+  case TORR:
+    IO::log << pressure() / Phys_const::tor << " torr";
+    break;
+  case ATM:
+    IO::log << pressure() / Phys_const::atm << " atm";
+    break;
+  }
+  IO::log << "\t Temperature = "
+	  << temperature() / Phys_const::kelv << " K\n";
+  //<< IO::log_offset << "collision frequency = " 
+  //<< MasterEquation::collision_frequency() / Phys_const::herz
+  //<< " 1/sec\n";
+
+  int                 itemp;
+  double              dtemp;
+  bool                btemp;
+  std::string         stemp;
+  Lapack::Vector      vtemp;
+  Lapack::Matrix      mtemp;
+
+  for(int w = 0; w < Model::well_size(); ++w) {
+    //
+    if(!w || well(w).size() > itemp)
+      //
+      itemp = well(w).size();
+  }
+  
+  const int ener_index_max = itemp;
+
+  /******************************** PARTITIONING THE WELLS ************************************/
+
+  std::vector<KineticBasis> kinetic_basis(ener_index_max);
+
+  {// kinetically active basis
+
+    IO::Marker well_part_marker("kinetically active basis");
+
+    // the energy problems are independent, their sizes, the number of wells at the energy,
+    // do not increase with the energy, so that the dynamic schedule takes the largest first;
+    // the matrices are small, hence serial BLAS in each
+    std::exception_ptr error;
+
+    Threads::BlasScope blas_scope(1);
+
+    // the context is resolved outside of the parallel region
+    std::vector<const Well*>    cw(Model::well_size());
+    std::vector<const Barrier*> ib(Model::inner_barrier_size());
+
+    for(int w = 0; w < cw.size(); ++w)
+      cw[w] = &well(w);
+    for(int b = 0; b < ib.size(); ++b)
+      ib[b] = &inner_barrier(b);
+
+    const std::vector<Array<double> >& csn = context().cum_stat_num;
+
+    const double eref  = energy_reference();
+    const double estep = energy_step();
+
+#pragma omp parallel for default(shared) schedule(dynamic, 1)
+
+    for(int e = 0; e < ener_index_max; ++e) {// energy cycle
+      //
+      try {
+      // available energy bins
+      //
+      std::vector<int> well_array;
+     
+      std::map<int, int> well_index;
+      
+      for(int w = 0; w < Model::well_size(); ++w) {
+	//
+	if(cw[w]->size() > e) {
+	  //
+	  well_index[w] = well_array.size();
+	  
+	  well_array.push_back(w);
+	}
+      }
+
+      kinetic_basis[e].well_index_map = well_index;
+      
+      kinetic_basis[e].index_well_map = well_array;
+
+      // microcanonical kinetic matrix
+      //
+      Lapack::SymmetricMatrix km(well_array.size());
+      km = 0.;
+
+      // nondiagonal isomerization contribution
+      //
+      for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+	//
+	if(e < ib[b]->size()) {
+	  //
+	  int w1 = Model::inner_connect(b).first;
+	  
+	  int w2 = Model::inner_connect(b).second;
+      
+	  std::map<int, int>::const_iterator p1 = well_index.find(w1);
+	  
+	  std::map<int, int>::const_iterator p2 = well_index.find(w2);
+      
+	  if(p1 == well_index.end() || p2 == well_index.end()) {
+	    //
+	    std::cerr << funame << "no density of states for wells connected with " 
+		      << Model::inner_barrier(b).name() << " barrier at "
+		      <<  (eref  - (double)e * estep) / Phys_const::kcal 
+		      << " kcal/mol\n";
+	    
+	    throw Error::Logic();
+	  }
+
+	  km(p1->second, p2->second) -= ib[b]->state_number(e) / 2. / M_PI
+	    //
+	    / std::sqrt(cw[w1]->state_density(e) * cw[w2]->state_density(e));
+	}
+      }
+
+      // diagonal isomerization contribution
+      //
+      for(int i = 0; i < well_array.size(); ++i) {
+	//
+	int w = well_array[i];
+	
+	if(e < csn[w].size())
+	  //
+	  km(i, i) = csn[w][e] / 2. / M_PI / cw[w]->state_density(e);
+	
+	if(Model::well(w).escape())
+	  //
+	  km(i, i) += cw[w]->escape_rate(i);
+      }
+
+      // relaxation eigenvalues
+      //
+      Lapack::Matrix evec(well_array.size());
+      
+      Lapack::Vector eval = km.eigenvalues(&evec);
+
+      kinetic_basis[e].eigenvalue  = eval;
+      
+      kinetic_basis[e].eigenvector = evec;
+      
+      // kinetically active subspace
+      //
+      int active = 0;
+      for(; active < well_array.size(); ++active) {
+	//
+	int w = well_array[active];
+	
+	if(eval[active] > cw[w]->collision_frequency() * reduction_threshold)
+	  //
+	  break;
+      }
+      
+      kinetic_basis[e].active_size = active;
+      }
+      catch(...) {
+#pragma omp critical(kinetic_basis_error)
+	if(!error)
+	  error = std::current_exception();
+      }
+      //
+    }//energy cycle
+
+    if(error)
+      std::rethrow_exception(error);
+    //
+  }// kinetically active basis
+
+
+  // global united species indexing
+  //
+  std::vector<int> well_shift(ener_index_max);
+  
+  itemp = 0;
+  
+  for(int e = 0; e < ener_index_max; itemp += kinetic_basis[e++].active_size)
+    //
+    well_shift[e] = itemp;
+  
+  const int global_size = itemp;
+
+  // global kinetic matrix size without reduction
+  //
+  itemp = 0;
+  //
+  for(int w = 0; w < Model::well_size(); ++w)
+    //
+    itemp += well(w).size();
+
+  IO::log << IO::log_offset << "original kinetic matrix size = " << itemp << "\n";
+  
+  IO::log << IO::log_offset << "reduced  kinetic matrix size = " << global_size << "\n";
+
+  /************************************************************************************* 
+   ********************************* KINETIC MATRIX ************************************
+   *************************************************************************************/
+
+  // kinetic relaxation matrix
+  //
+  Lapack::SymmetricMatrix kin_mat(global_size);
+  
+  kin_mat = 0.;
+  
+  // diagonal chemical relaxation
+  //
+  itemp = 0;
+  
+  for(int e = 0; e < ener_index_max; ++e) {
+    //
+    for(int l = 0; l < kinetic_basis[e].active_size; ++l, ++itemp) {
+      //
+      kin_mat(itemp, itemp) = kinetic_basis[e].eigenvalue[l];
+    }
+  }
+    
+  // collisional energy relaxation
+  //
+  for(int e1 = 0; e1 < ener_index_max; ++e1) {
+    //
+    for(int e2 = e1; e2 < ener_index_max; ++e2) {
+      //
+      for(int l1 = 0; l1 < kinetic_basis[e1].active_size; ++l1) {
+	//
+	for(int l2 = 0; l2 < kinetic_basis[e2].active_size; ++l2) {
+	  //
+	  if(e1 == e2 && l2 < l1)
+	    //
+	    continue;
+
+	  dtemp = 0.;
+	  
+	  for(int w = 0; w < Model::well_size(); ++w) {
+	    //
+	    std::map<int, int>::const_iterator i1 = kinetic_basis[e1].well_index_map.find(w);
+
+	    std::map<int, int>::const_iterator i2 = kinetic_basis[e2].well_index_map.find(w);
+	    
+	    itemp = e2 - e1;
+	    
+	    if(i1 != kinetic_basis[e1].well_index_map.end() &&
+	       //
+	       i2 != kinetic_basis[e2].well_index_map.end() &&
+	       //
+	       itemp < well(w).kernel_bandwidth) {
+	      //
+	      dtemp +=  well(w).kernel(e1, e2) * well(w).collision_frequency()
+		//
+		* well(w).boltzman_sqrt(e1) / well(w).boltzman_sqrt(e2)
+		//
+		* kinetic_basis[e1].eigenvector(i1->second, l1)
+		//
+		* kinetic_basis[e2].eigenvector(i2->second, l2);
+	    }
+	  }
+	  
+	  kin_mat(well_shift[e1] + l1, well_shift[e2] + l2) = dtemp;
+	  //
+	}// l2 cycle
+	//
+      }// l1 cycle
+      //
+    }// e2 cycle
+    //
+  }// e1 cycle
+
+  /******************** DIAGONALIZING THE GLOBAL KINETIC RELAXATION MATRIX ********************/
+
+  Lapack::Vector eigenval;
+  
+  Lapack::Matrix global_eigen(global_size);
+
+  {
+    IO::Marker solve_marker("diagonalizing global relaxation matrix", IO::Marker::ONE_LINE);
+    //
+    eigenval = kin_mat.eigenvalues(&global_eigen);
+  }
+
+  /************************************* EIGENVECTOR WELL POPULATION ****************************/
+
+  
+  
+}
+
+void MasterEquation::well_reduction_method_old (std::map<std::pair<int, int>, double>& rate_data, Partition& thermal_well_partition, int flags)
+  
+{
+  const char funame [] = "MasterEquation::well_reduction_method_old: ";
+
+  static const double machine_eps = 1.e-14;
+
+  if(!isset()) {
+    std::cerr << funame << "reactive complex is not set\n";
+    throw Error::Init();
+  }
+
+  rate_data.clear();
+
+  IO::Marker funame_marker(funame);
+  
+  IO::log << IO::log_offset << "Pressure = ";
+  switch(pressure_unit) {
+  case BAR:
+    IO::log << pressure() / Phys_const::bar << " bar";
+    break;
+  case TORR:
+    IO::log << pressure() / Phys_const::tor << " torr";
+    break;
+  case ATM:
+    IO::log << pressure() / Phys_const::atm << " atm";
+    break;
+  }
+  IO::log << "\t Temperature = "
+	  << temperature() / Phys_const::kelv << " K\n";
+  //<< IO::log_offset << "collision frequency = " 
+  //<< MasterEquation::collision_frequency() / Phys_const::herz
+  //<< " 1/sec\n";
+
+  int                 itemp;
+  double              dtemp;
+  bool                btemp;
+  std::string         stemp;
+  Lapack::Vector      vtemp;
+  Lapack::Matrix      mtemp;
+
+  for(int w = 0; w < Model::well_size(); ++w)
+    if(!w || well(w).size() > itemp)
+      itemp = well(w).size();
+  const int well_size_max = itemp;
+
+  for(int w = 0; w < Model::well_size(); ++w)
+    if(!w || well(w).collision_frequency() < dtemp)
+      dtemp = well(w).collision_frequency();
+
+  const double collision_frequency_min = dtemp;
+    
+  /******************************** PARTITIONING THE WELLS ************************************/
+
+  std::vector<Partition> well_partition(well_size_max);
+  std::vector<Group>     bimolecular_group(well_size_max);
+
+  {// well partitioning
+
+    IO::Marker well_part_marker("energy-resolved well partitioning");
+
+    for(int e = 0; e < well_size_max; ++e) {// energy cycle
+
+      // available energy bins
+      std::vector<int> well_array;
+      std::map<int, int> well_index;
+      for(int w = 0; w < Model::well_size(); ++w)
+	if(well(w).size() > e) {
+	  well_index[w] = well_array.size();
+	  well_array.push_back(w);
+	}
+
+      // microcanonical kinetic matrix
+      Lapack::SymmetricMatrix km(well_array.size());
+      km = 0.;
+
+      // km initialization
+      // nondiagonal isomerization contribution
+      for(int b = 0; b < Model::inner_barrier_size(); ++b)
+	if(e < inner_barrier(b).size()) {
+	  int w1 = Model::inner_connect(b).first;
+	  int w2 = Model::inner_connect(b).second;
+      
+	  std::map<int, int>::const_iterator p1 = well_index.find(w1);
+	  std::map<int, int>::const_iterator p2 = well_index.find(w2);
+      
+	  if(p1 == well_index.end() || p2 == well_index.end()) {
+	    std::cerr << funame << "no density of states for wells connected with " 
+		      << Model::inner_barrier(b).name() << " barrier at "
+		      <<  (energy_reference()  - (double)e * energy_step()) / Phys_const::kcal 
+		      << " kcal/mol\n";
+	    throw Error::Logic();
+	  }
+
+	  km(p1->second, p2->second) =  - inner_barrier(b).state_number(e) / 2. / M_PI
+	    / std::sqrt(well(w1).state_density(e) * well(w2).state_density(e));
+	}
+
+      // diagonal isomerization contribution
+      for(int i = 0; i < well_array.size(); ++i) {
+	int w = well_array[i];
+	if(e < context().cum_stat_num[w].size())
+	  km(i, i) = context().cum_stat_num[w][e] / 2. / M_PI / well(w).state_density(e);
+      }
+
+      // relaxation eigenvalues
+      Lapack::Matrix evec(well_array.size());
+      Lapack::Vector eval = km.eigenvalues(&evec);
+
+      // kinetically active subspace
+      for(itemp = 0; itemp < well_array.size(); ++itemp) {
+	int w = well_array[itemp];
+	
+	if(reduction_threshold > 0.) {
+	  if(eval[itemp] > well(w).collision_frequency() * reduction_threshold)
+	    break;
+	}
+	else if(reduction_threshold < 0.) {
+	  if(eval[itemp] > - well(w).collision_frequency() * reduction_threshold 
+	     && (itemp && eval[itemp] /eval[itemp - 1] > - reduction_threshold || !itemp))
+	    break;
+	}
+	else {
+	  itemp = well_array.size();
+	  break;
+	}
+	const int chem_size = itemp;
+
+	Lapack::Matrix pop_chem(well_array.size(), chem_size);
+	for(int l = 0; l < chem_size; ++l)
+	  pop_chem.column(l) = evec.column(l);
+
+	// statistical weight
+	std::vector<double> weight(well_array.size());
+	for(int i = 0; i < weight.size(); ++i)
+	  weight[i] = well(well_array[i]).state_density(e);
+
+	Partition wp;
+	Group bg;
+
+	// well partitioning
+	if(chem_size == well_array.size()) {
+	  wp.resize(well_array.size());
+	  for(int w = 0; w < well_array.size(); ++w)
+	    wp[w].insert(w);
+	}
+	else if(!chem_size) {
+	  for(int w = 0; w < well_array.size(); ++w)
+	    bg.insert(w);
+	}
+	else {
+	  Group well_pool;
+	  dtemp = well_partition_method(pop_chem, wp, well_pool, weight);
+      
+	  for(int b = 0; b < Model::outer_barrier_size(); ++b)
+	    if(e < outer_barrier(b).size()) {
+	      const int w = well_index[Model::outer_connect(b).first];
+	      if(well_pool.find(w) != well_pool.end()) {
+		well_pool.erase(w);
+		bg.insert(w);
+	      }
+	    }
+
+	  if(bg.size()) {
+	    Group barrier_pool;
+	    for(int b = 0; b < Model::inner_barrier_size(); ++b)
+	      if(e < inner_barrier(b).size())
+		barrier_pool.insert(b);
+
+	    while(well_pool.size()) {
+	      btemp = true;
+	  
+	      for(Git b = barrier_pool.begin(); b != barrier_pool.end(); ++b) {
+		const int w1 = well_index[Model::inner_connect(*b).first];
+		const int w2 = well_index[Model::inner_connect(*b).second];
+
+		if(well_pool.find(w1) != well_pool.end() && bg.find(w2) != bg.end()) {
+		  well_pool.erase(w1);
+		  bg.insert(w1);
+		  barrier_pool.erase(*b);
+		  btemp = false;
+		  break;
+		}
+
+		if(well_pool.find(w2) != well_pool.end() && bg.find(w1) != bg.end()) {
+		  well_pool.erase(w2);
+		  bg.insert(w2);
+		  barrier_pool.erase(*b);
+		  btemp = false;
+		  break;
+		}
+	      }
+	      if(btemp)
+		break;
+	    }
+	  }
+
+	  if(well_pool.size()) {
+
+	    IO::log << IO::log_offset << "WARNING: e = " << e << "; bimolecular group = ";
+	    for(Git i = bg.begin(); i != bg.end(); ++i) {
+	      if(i != bg.begin())
+		IO::log << "+";
+	      IO::log << Model::well(well_array[*i]).name();
+	    }
+	    IO::log << "; unconnected part = ";
+	    for(Git i = well_pool.begin(); i != well_pool.end(); ++i) {
+	      if(i != well_pool.begin())
+		IO::log << "+";
+	      IO::log << Model::well(well_array[*i]).name();
+	    }
+	    IO::log << "\n";
+
+	    int smax; 
+	    double pmax;
+	    for(Git i = well_pool.begin(); i !=well_pool.end(); ++i) {
+	      for(int s = 0; s < chem_size; ++s) {
+		dtemp = Group(wp[s]).insert(*i).projection(pop_chem, weight); 
+		if(!s || dtemp > pmax) {
+		  pmax = dtemp;
+		  smax = s;
+		}
+	      }
+	      wp[smax].insert(*i);
+	    }
+	  }
+	}
+
+	well_partition[e].resize(wp.size());
+	for(int g = 0; g < wp.size(); ++g)
+	  for(Git w = wp[g].begin(); w != wp[g].end(); ++w)
+	    well_partition[e][g].insert(well_array[*w]);
+
+	for(Git w = bg.begin(); w != bg.end(); ++w)
+	  bimolecular_group[e].insert(well_array[*w]);
+
+      }//energy cycle
+    } // well partitioning
+
+    // checking
+    {
+      IO::Marker checking_marker("checking well partitioning");
+
+      for(int e = 1; e < well_size_max; ++e)
+	for(Git i = bimolecular_group[e].begin(); i != bimolecular_group[e].end(); ++i)
+	  if(bimolecular_group[e - 1].find(*i) == bimolecular_group[e - 1].end()) {
+	    IO::log << IO::log_offset << "WARNING: bimolecular group inconsistency:\n";
+
+	    itemp = e - 1;
+	    IO::log << IO::log_offset << "e = " << std::setw(5) << itemp << "; bimolecular group =";
+	    for(Git j = bimolecular_group[itemp].begin(); j != bimolecular_group[itemp].end(); ++j)
+	      IO::log << std::setw(5) << Model::well(*j).name();
+	    IO::log << "\n";
+	
+	    itemp = e;
+	    IO::log << IO::log_offset << "e = " << std::setw(5) << itemp << "; bimolecular group =";
+	    for(Git j = bimolecular_group[itemp].begin(); j != bimolecular_group[itemp].end(); ++j)
+	      IO::log << std::setw(5) << Model::well(*j).name();
+	    IO::log << "\n";
+	  }
+
+      // checking internal relaxation eigenvalues
+      for(int e = 0; e < well_size_max; ++e) {// energy cycle
+
+	if(bimolecular_group[e].size()) {// bimolecular group
+
+	  Lapack::SymmetricMatrix km(bimolecular_group[e].size());
+	  km = 0.;
+
+	  for(int b = 0; b < Model::inner_barrier_size(); ++b)
+	    if(inner_barrier(b).size() > e) {
+
+	      const int w1 = Model::inner_connect(b).first;
+	      const int w2 = Model::inner_connect(b).second;
+	      Git ww1 = bimolecular_group[e].find(w1);
+	      Git ww2 = bimolecular_group[e].find(w2);
+	  
+	      if(ww1 != bimolecular_group[e].end() && ww2 != bimolecular_group[e].end()) {
+		const int i1 = std::distance(bimolecular_group[e].begin(), ww1);
+		const int i2 = std::distance(bimolecular_group[e].begin(), ww2);
+		dtemp = inner_barrier(b).state_number(e) / 2. / M_PI;
+		km(i1, i1) += dtemp / well(w1).state_density(e);
+		km(i2, i2) += dtemp / well(w2).state_density(e);
+		km(i1, i2) -= dtemp / std::sqrt(well(w1).state_density(e) * well(w2).state_density(e));	   
+	      }
+	    }
 
-      IO::log << IO::log_offset << "using default reduction scheme, projection error = "
-	      << (double)chem_size - well_partition.projection(pop_chem) << "\n";
-    }
-    else {
-      Group bimolecular_group;
-      dtemp = well_partition_method(pop_chem, well_partition, bimolecular_group, std::vector<double>());
-    }
+	  for(int b = 0; b < Model::outer_barrier_size(); ++b)
+	    if(outer_barrier(b).size() > e) {
 
-    // convert chemical eigenvectors in the new basis
-    pop_chem = well_partition.basis().transpose() * pop_chem;
+	      const int w = Model::outer_connect(b).first;
+	      Git ww = bimolecular_group[e].find(w);
+	  
+	      if(ww != bimolecular_group[e].end()) {
+		const int i = std::distance(bimolecular_group[e].begin(), ww);
+		dtemp = outer_barrier(b).state_number(e) / 2. / M_PI;
+		km(i, i) += dtemp / well(w).state_density(e);
+	      }
+	    }
 
-    std::vector<int>    group_index = well_partition.group_index();
-    std::vector<double>      weight = well_partition.weight();
-    std::vector<double> real_weight = well_partition.real_weight();
-    Lapack::Matrix            basis = well_partition.basis();
+	  dtemp = km.eigenvalues()[0] / collision_frequency_min;
+	  if(reduction_threshold > 0. && dtemp < reduction_threshold || reduction_threshold < 0. && dtemp < - reduction_threshold) {
+	    IO::log << IO::log_offset << "WARNING: e = " << e << "; bimolecular group = ";
+	    for(Git i = bimolecular_group[e].begin(); i != bimolecular_group[e].end(); ++i) {
+	      if(i != bimolecular_group[e].begin())
+		IO::log << "+";
+	      IO::log << Model::well(*i).name();
+	    }
+	    IO::log << "; minimal eigenvalue / collision frequency = "
+		    << dtemp << "\n";
+	  }
+	}// bimolecular group
 
-    Lapack::Matrix m_direct(pop_chem);
-    Lapack::Matrix m_inverse = m_direct.invert();
+	for(int g = 0; g < well_partition[e].size(); ++g)
+	  if(well_partition[e][g].size() > 1) {// bound groups
 
-    Lapack::Matrix one(m_direct * m_inverse);
-    one.diagonal() -= 1.;
-    double val_max = -1.;
-    for(int i = 0; i < one.size1(); ++i)
-      for(int j = 0; j < one.size2(); ++j) {
-	dtemp = one(i, j);
-	dtemp = dtemp < 0. ? -dtemp : dtemp;
-	if(dtemp > epsilon && dtemp > val_max)
-	  val_max = dtemp;
-      }
-    if(val_max > 0.)
-      IO::log << IO::log_offset << funame 
-	      << "WARNING: matrix inversion error = " << val_max 
-	      << " exceeds numerical accuracy = " << epsilon
-	      << "\n";
+	    Lapack::SymmetricMatrix km(well_partition[e][g].size());
+	    km = 0.;
+	
+	    for(int b = 0; b < Model::inner_barrier_size(); ++b)
+	      if(inner_barrier(b).size() > e) {
 
-    IO::log << IO::log_offset << "species:\n" 
-	    << IO::log_offset << std::setw(2) << "#"  << std::setw(15) 
-	    << "assigned name" << IO::first_offset
-	    << "group\n";
-    for(Pit g = well_partition.begin(); g != well_partition.end(); ++g) {
-      itemp = g - well_partition.begin();
-      IO::log << IO::log_offset << std::setw(2) << itemp << std::setw(15) 
-	      << Model::well(group_index[itemp]).name() << IO::first_offset;
-      for(Git w = g->begin(); w != g->end(); ++w) {
-	if(w != g->begin())
-	  IO::log << "+";
-	IO::log << Model::well(*w).name();
-      }
-      IO::log << "\n";
+		const int w1 = Model::inner_connect(b).first;
+		const int w2 = Model::inner_connect(b).second;
+
+		Git ww1 = well_partition[e][g].find(w1);
+		Git ww2 = well_partition[e][g].find(w2);
+
+	  
+		if(ww1 != well_partition[e][g].end() && ww2 != well_partition[e][g].end()) {
+	    
+		  const int i1 = std::distance(well_partition[e][g].begin(), ww1);
+		  const int i2 = std::distance(well_partition[e][g].begin(), ww2);
+	    
+		  dtemp = inner_barrier(b).state_number(e) / 2. / M_PI;
+
+		  km(i1, i1) += dtemp / well(w1).state_density(e);
+		  km(i2, i2) += dtemp / well(w2).state_density(e);
+		  km(i1, i2) -= dtemp / std::sqrt(well(w1).state_density(e) * well(w2).state_density(e));
+		}
+	      }
+
+	    dtemp = km.eigenvalues()[1] / collision_frequency_min;
+	    if(reduction_threshold > 0. && dtemp < reduction_threshold ||
+	       reduction_threshold < 0. && dtemp < - reduction_threshold) {
+	      IO::log << IO::log_offset << "WARNING: e = " << e << "; bound group = ";
+	      for(Git i = well_partition[e][g].begin(); i != well_partition[e][g].end(); ++i) {
+		if(i != well_partition[e][g].begin())
+		  IO::log << "+";
+		IO::log << Model::well(*i).name();
+	      }
+	      IO::log << "; minimal eigenvalue / collision frequency = " << dtemp << "\n";
+	    }
+	  }// bound groups
+      }// energy cycle
     }
+
+    // global united species indexing
+    std::vector<int> well_shift(well_size_max);
+    itemp = 0;
+    for(int e = 0; e < well_size_max; itemp += well_partition[e++].size())
+      well_shift[e] = itemp;
+
+    const int global_size = itemp;
+
+    itemp = 0;
+    for(int w = 0; w < Model::well_size(); ++w)
+      itemp += well(w).size();
+    IO::log << IO::log_offset << "original kinetic matrix size = " << itemp << "\n";
+
+    IO::log << IO::log_offset << "reduced  kinetic matrix size = " << global_size << "\n";
+
+    /******************************** SETTING KINETIC MATRIX ************************************/
+
+    std::vector<double> group_state_density_sqrt(global_size);
+    std::vector<double> group_weight_sqrt(global_size);
+
+    Lapack::SymmetricMatrix kin_mat(global_size);
+    kin_mat = 0.;
   
-    // rate constant reduction
-    switch(reduction_method) {
-    case PROJECTION:
-      // isomerization
-      k_11 = Lapack::SymmetricMatrix(basis.transpose() * k_11 * basis);
-      // dissociation
-      k_13 = basis.transpose() * k_13;
-      // new chemcal eigenvalues
-      IO::log << IO::log_offset << "new chemical eigenvalues:";
-      vtemp = k_11.eigenvalues();
-      for(int l = 0; l < chem_size; ++l)
-	IO::log << std::setw(13) << vtemp[l] / well(wmin).collision_frequency();
-      IO::log << "\n";
-      // well-to-well rate coefficients
-      for(int i = 0; i < chem_size; ++i)
-	for(int j = 0; j < chem_size; ++j) {
-	  dtemp = k_11(i, j) * std::sqrt(weight[i] * weight[j])
-	    * energy_step() / real_weight[i] / Phys_const::herz;
-	  if(i != j)
-	    dtemp = -dtemp;
-	  rate_data[std::make_pair(group_index[i], group_index[j])] = dtemp;
-	}
-      // well-to-bimolecular rate coefficients
-      for(int w = 0; w < chem_size; ++w)
-	for(int p = 0; p < Model::bimolecular_size(); ++p)
-	  rate_data[std::make_pair(group_index[w], Model::well_size() + p)] = k_13(w, p) * std::sqrt(weight[w]) 
-	    * energy_step() / real_weight[w] / Phys_const::herz;
-      // bimolecular-to-well rate coefficients
-      for(int p = 0; p < Model::bimolecular_size(); ++p) 
-	if(bimolecular(p).weight() > 0.)
-	  for(int w = 0; w < chem_size; ++w)
-	    rate_data[std::make_pair(Model::well_size() + p, group_index[w])] = k_13(w, p) * std::sqrt(weight[w]) 
-	      * energy_step() / bimolecular(p).weight() / bru;
-      break;
-    case DIAGONALIZATION:
-      // well-to-well rate coefficients
-      for(int i = 0; i < chem_size; ++i)
-	for(int j = 0; j < chem_size; ++j) {
+    {// kinetic matrix setting
+      IO::Marker kin_mat_marker("setting kinetic matrix", IO::Marker::ONE_LINE);
+
+      for(int e = 0; e < well_size_max; ++e) {
+	double tf_sqrt = std::sqrt(thermal_factor(e));
+	for(int g = 0; g < well_partition[e].size(); ++g) {
 	  dtemp = 0.;
-	  for(int l = 0; l < chem_size; ++l)
-	    dtemp += m_direct(j, l) * m_inverse(l, i) * chem_eval[l];
-	  dtemp *= std::sqrt(weight[i] * weight[j]) * energy_step() / real_weight[i] / Phys_const::herz;
-	  if(i != j)
-	    dtemp = -dtemp;
-	  rate_data[std::make_pair(group_index[i], group_index[j])] = dtemp;
+	  for(Git w = well_partition[e][g].begin(); w != well_partition[e][g].end(); ++w)
+	    dtemp += well(*w).state_density(e);
+	  itemp = g + well_shift[e];
+	  dtemp = std::sqrt(dtemp);
+	  group_state_density_sqrt[itemp] = dtemp;
+	  group_weight_sqrt[itemp] = dtemp * tf_sqrt;
 	}
-      // well-to-bimolecular rate coefficients
-      for(int w = 0; w < chem_size; ++w)
-	for(int p = 0; p < Model::bimolecular_size(); ++p) {
-	  dtemp = 0.;
-	  for(int l = 0; l < chem_size; ++l)
-	    dtemp += m_inverse(l, w) * chem_bim(l, p);
-	  dtemp *= std::sqrt(weight[w]) * energy_step() / real_weight[w] / Phys_const::herz;
-	  rate_data[std::make_pair(group_index[w], Model::well_size() + p)] = dtemp;
+      }
+
+      // non-diagonal  collisional relaxation contribution
+      int kernel_bandwidth_max = 0;
+      for(int w = 0; w < Model::well_size(); ++w)
+	if(well(w).kernel_bandwidth > kernel_bandwidth_max)
+	  kernel_bandwidth_max = well(w).kernel_bandwidth;
+
+      for(int e1 = 0; e1 < well_size_max; ++e1)
+	for(int g1 = 0; g1 < well_partition[e1].size(); ++g1)
+	  for(int e2 = e1 + 1; e2 < well_size_max && e2 - e1 < kernel_bandwidth_max; ++e2)
+	    for(int g2 = 0; g2 < well_partition[e2].size(); ++g2) {
+	      dtemp = 0.;
+	      for(Git w = well_partition[e1][g1].begin(); w != well_partition[e1][g1].end(); ++w)
+		if(well_partition[e2][g2].find(*w) != well_partition[e2][g2].end())
+		  dtemp += well(*w).kernel(e1, e2) * well(*w).state_density(e1) * well(*w).collision_frequency();
+	      const int i1 = g1 + well_shift[e1];
+	      const int i2 = g2 + well_shift[e2];
+	      dtemp /= group_state_density_sqrt[i1] * group_state_density_sqrt[i2] 
+		* std::sqrt(thermal_factor(e2 - e1));
+	      kin_mat(i1, i2) = dtemp;
+	    }
+  
+      // diagonal  collisional relaxation contribution
+      for(int e = 0; e < well_size_max; ++e)
+	for(int g = 0; g < well_partition[e].size(); ++g) {
+	  double fac = 0.;
+	  double val = 0.;
+	  for(Git w = well_partition[e][g].begin(); w != well_partition[e][g].end(); ++w) {
+	    dtemp = well(*w).state_density(e);
+	    val += well(*w).kernel(e, e) * dtemp * well(*w).collision_frequency();
+	    fac += dtemp;
+	  }      
+	  const int i = g + well_shift[e];
+	  kin_mat(i, i) = val / fac;
 	}
-      // bimolecular-to-well rate coefficients
-      for(int p = 0; p < Model::bimolecular_size(); ++p) 
-	if(bimolecular(p).weight() > 0.)
-	  for(int w = 0; w < chem_size; ++w) {
-	    dtemp = 0.;
-	    for(int l = 0; l < chem_size; ++l)
-	      dtemp += m_direct(w, l) * chem_bim(l, p);
-	    dtemp *= std::sqrt(weight[w]) * energy_step() / bimolecular(p).weight() 
-	      / bru;
-	    rate_data[std::make_pair(Model::well_size() + p, group_index[w])] = dtemp;
+
+      // non-diagonal isomerization contribution
+      for(int e = 0; e < well_size_max; ++e)
+	for(int g1 = 0; g1 < well_partition[e].size(); ++g1)
+	  for(int g2 = g1 + 1; g2 < well_partition[e].size(); ++g2) {
+	    dtemp = 0.;
+	    for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+	      const int w1 = Model::inner_connect(b).first;
+	      const int w2 = Model::inner_connect(b).second;
+	      if(e < inner_barrier(b).size() &&
+		 (well_partition[e][g1].find(w1) != well_partition[e][g1].end() && 
+		  well_partition[e][g2].find(w2) != well_partition[e][g2].end() ||
+		  well_partition[e][g1].find(w2) != well_partition[e][g1].end() && 
+		  well_partition[e][g2].find(w1) != well_partition[e][g2].end()))
+	     
+		dtemp += inner_barrier(b).state_number(e);
+	    }
+	    const int i1 = g1 + well_shift[e];
+	    const int i2 = g2 + well_shift[e];
+	    kin_mat(i1, i2) = - dtemp / 2. / M_PI / group_state_density_sqrt[i1] / group_state_density_sqrt[i2];
 	  }
-      break;
-    default:
-      std::cerr << funame << "unknown reduction method\n";
-      throw Error::Logic();
-    }
-  }// reduction of species
-  else {// no reduction
-    // well-to-well rate coefficients
-    for(int i = 0; i < Model::well_size(); ++i)
-      for(int j = 0; j < Model::well_size(); ++j) {
-	dtemp = k_11(i, j) * well(i).weight_sqrt() * well(j).weight_sqrt()
-	  * energy_step() / well(i).real_weight() / Phys_const::herz;
-	if(i != j)
-	  dtemp = -dtemp;
-	rate_data[std::make_pair(i, j)] = dtemp;
-      }
-    // well-to-bimolecular rate coefficients
-    for(int w = 0; w < Model::well_size(); ++w)
-      for(int p = 0; p < Model::bimolecular_size(); ++p)
-	rate_data[std::make_pair(w, Model::well_size() + p)] = k_13(w, p) * well(w).weight_sqrt() 
-	  * energy_step() / well(w).real_weight() / Phys_const::herz;
-    // bimolecular-to-well rate coefficients
-    for(int p = 0; p < Model::bimolecular_size(); ++p) 
-      if(bimolecular(p).weight() > 0.)
-	for(int w = 0; w < Model::well_size(); ++w)
-	  rate_data[std::make_pair(Model::well_size() + p, w)] = k_13(w, p) * well(w).weight_sqrt() 
-	    * energy_step() / bimolecular(p).weight() / bru;
-  }// no reduction
-}// Low chemical eigenvalue method
 
-/********************************************************************************************
- ************************************* SEQUENTIAL METHOD ************************************
- ********************************************************************************************/
+      // diagonal isomerization contribution
+      for(int e = 0; e < well_size_max; ++e)
+	for(int g = 0; g < well_partition[e].size(); ++g) {
+	  dtemp = 0.;
+	  // inner barrier
+	  for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+	    const int w1 = Model::inner_connect(b).first;
+	    const int w2 = Model::inner_connect(b).second;
+	    if(e < inner_barrier(b).size() &&
+	       (well_partition[e][g].find(w1) != well_partition[e][g].end() && 
+		well_partition[e][g].find(w2) == well_partition[e][g].end() ||
+		well_partition[e][g].find(w2) != well_partition[e][g].end() && 
+		well_partition[e][g].find(w1) == well_partition[e][g].end()))
+	      dtemp += inner_barrier(b).state_number(e);
+	  }
 
-void MasterEquation::sequential_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags)
-  
-{
-  const char funame [] = "MasterEquation::sequential_method: ";
+	  // outer barrier
+	  for(int b = 0; b < Model::outer_barrier_size(); ++b) {
+	    const int w = Model::outer_connect(b).first;
+	    if(e < outer_barrier(b).size() && well_partition[e][g].find(w) != well_partition[e][g].end())
+	      dtemp += outer_barrier(b).state_number(e);
+	  } 
+	  const int i = g + well_shift[e];
+	  kin_mat(i, i) += dtemp / 2. / M_PI / group_state_density_sqrt[i] / group_state_density_sqrt[i];
+	}
+    }// kinetic matrix settinng
 
-  IO::Marker funame_marker(funame);
+    /******************************** BIMOLECULAR PRODUCT VECTORS ************************************/
 
-  std::multimap<double, int> barrier_map;
-  for(int b = 0; b < Model::inner_barrier_size(); ++b)
-    barrier_map.insert(std::make_pair(Model::inner_barrier(b).real_ground(), b));
-  for(int b = 0; b < Model::outer_barrier_size(); ++b)
-    barrier_map.insert(std::make_pair(Model::outer_barrier(b).real_ground(), b + Model::inner_barrier_size()));
-  
-  Group  bimolecular_group;
-		       
-  for(int w = 0; w < Model::well_size(); ++w)
-    well_partition.push_back(Group().insert(w));
+    // bimolecular group contribution
+    std::vector<Lapack::Matrix> bg_mat(well_size_max);
+    std::vector<Lapack::Vector> bg_state_density_sqrt(well_size_max);
 
+    // bimolecular-to-bimolecular rate
+    Lapack::SymmetricMatrix bb_rate(Model::bimolecular_size());
+    bb_rate = 0.;
 
-  std::multimap<double, int>::const_iterator bit = barrier_map.begin();
-  while(1) {
-    if(bit == barrier_map.end()) {
-      // ...
-      break;
-    }
+    // bimolecular product vectors
+    Lapack::Matrix global_bim(global_size, Model::bimolecular_size());
+    global_bim = 0.;
 
-    //...
-    ++bit;
-  }
-}
+    std::vector<double> capture_state_number(Model::bimolecular_size());
 
-/********************************************************************************************
- ********************************** WELL REDUCTION METHOD ***********************************
- ********************************************************************************************/
+    {// bimolecular product vectors setting
+      IO::Marker bim_marker("setting bimolecular product vectors", IO::Marker::ONE_LINE);
 
-// fast horizontal relaxation eigenvectors/eigenvalues are removed from ME
-// and used only for bimolecular-to-bimolecular contributions
+      // bimolecular group kinetic matrices and bimolecular channel vectors;
+      // the systems of the same size are solved as one batch
+      std::vector<Lapack::SymmetricMatrix> bg_km_set(well_size_max);
+      std::vector<Lapack::Matrix>          bg_bim_set(well_size_max);
+      std::map<int, std::vector<int> >     bg_batch;
 
-struct KineticBasis {
-  int active_size;
-  Lapack::Vector eigenvalue;
-  Lapack::Matrix eigenvector;
-  std::map<int, int> well_index_map;
-  std::vector<int>   index_well_map;
-};
+      for(int e = 0; e < well_size_max; ++e)
+	if(bimolecular_group[e].size()) {
 
-void MasterEquation::well_reduction_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags)
-  
-{
-  const char funame [] = "MasterEquation::well_reduction_method: ";
+	  bg_state_density_sqrt[e].resize(bimolecular_group[e].size());
+	  itemp = 0;
+	  for(Git w = bimolecular_group[e].begin(); w != bimolecular_group[e].end(); ++w, ++itemp)
+	    bg_state_density_sqrt[e][itemp] = std::sqrt(well(*w).state_density(e));
 
-  static const double machine_eps = 1.e-14;
+	  Lapack::SymmetricMatrix bg_km(bimolecular_group[e].size()); //bimolecular group kinetic matrix
+	  bg_km = 0.;
 
-  if(!isset()) {
-    std::cerr << funame << "reactive complex is not set\n";
-    throw Error::Init();
-  }
+	  Lapack::Matrix bg_bim(bimolecular_group[e].size(), Model::bimolecular_size());
+	  bg_bim = 0.;
 
-  rate_data.clear();
+	  // inner barrier contribution
+	  for(int b = 0; b < Model::inner_barrier_size(); ++b)
+	    if(e < inner_barrier(b).size()) {
 
-  IO::Marker funame_marker(funame);
-  
-  IO::log << IO::log_offset << "Pressure = ";
-  switch(pressure_unit) {
-  case BAR:
-    IO::log << pressure() / Phys_const::bar << " bar";
-    break;
-  case TORR:
-    IO::log << pressure() / Phys_const::tor << " torr";
-    break;
-  case ATM:
-    IO::log << pressure() / Phys_const::atm << " atm";
-    break;
-  }
-  IO::log << "\t Temperature = "
-	  << temperature() / Phys_const::kelv << " K\n";
-  //<< IO::log_offset << "collision frequency = " 
-  //<< MasterEquation::collision_frequency() / Phys_const::herz
-  //<< " 1/sec\n";
+	      const int w1 = Model::inner_connect(b).first;
+	      const int w2 = Model::inner_connect(b).second;
+	
+	      Git ww1 = bimolecular_group[e].find(w1);
+	      Git ww2 = bimolecular_group[e].find(w2);
 
-  int                 itemp;
-  double              dtemp;
-  bool                btemp;
-  std::string         stemp;
-  Lapack::Vector      vtemp;
-  Lapack::Matrix      mtemp;
+	      if(ww1 != bimolecular_group[e].end() && ww2 != bimolecular_group[e].end()) {
+	    
+		dtemp = inner_barrier(b).state_number(e);
 
-  for(int w = 0; w < Model::well_size(); ++w) {
-    //
-    if(!w || well(w).size() > itemp)
-      //
-      itemp = well(w).size();
-  }
-  
-  const int ener_index_max = itemp;
+		const int i1 = std::distance(bimolecular_group[e].begin(), ww1);
+		const int i2 = std::distance(bimolecular_group[e].begin(), ww2);
 
-  /******************************** PARTITIONING THE WELLS ************************************/
+		bg_km(i1, i1) += dtemp;
+		bg_km(i2, i2) += dtemp;
+		bg_km(i1, i2) -= dtemp;
+		//IO::log << " "<< i1 << "<-->" << i2;
+	      }
+	    }
+	  //IO::log << "\n";
 
-  std::vector<KineticBasis> kinetic_basis(ener_index_max);
+	  // outer barrier contribution
+	  for(int b = 0; b < Model::outer_barrier_size(); ++b)
+	    if(e < outer_barrier(b).size()){
 
-  {// kinetically active basis
+	      const int w = Model::outer_connect(b).first;
+	      const int p = Model::outer_connect(b).second;
 
-    IO::Marker well_part_marker("kinetically active basis");
+	      Git ww = bimolecular_group[e].find(w);
 
-    for(int e = 0; e < ener_index_max; ++e) {// energy cycle
-      //
-      // available energy bins
-      //
-      std::vector<int> well_array;
-     
-      std::map<int, int> well_index;
-      
-      for(int w = 0; w < Model::well_size(); ++w) {
-	//
-	if(well(w).size() > e) {
-	  //
-	  well_index[w] = well_array.size();
-	  
-	  well_array.push_back(w);
-	}
-      }
+	      if(ww != bimolecular_group[e].end()) {
 
-      kinetic_basis[e].well_index_map = well_index;
-      
-      kinetic_basis[e].index_well_map = well_array;
+		dtemp = outer_barrier(b).state_number(e);
 
-      // microcanonical kinetic matrix
-      //
-      Lapack::SymmetricMatrix km(well_array.size());
-      km = 0.;
+		const int i = std::distance(bimolecular_group[e].begin(), ww);
 
-      // nondiagonal isomerization contribution
-      //
-      for(int b = 0; b < Model::inner_barrier_size(); ++b) {
-	//
-	if(e < inner_barrier(b).size()) {
-	  //
-	  int w1 = Model::inner_connect(b).first;
-	  
-	  int w2 = Model::inner_connect(b).second;
-      
-	  std::map<int, int>::const_iterator p1 = well_index.find(w1);
-	  
-	  std::map<int, int>::const_iterator p2 = well_index.find(w2);
+		bg_bim(i, p) += dtemp;
+		bg_km(i, i) += dtemp;
+		capture_state_number[p] += dtemp * thermal_factor(e);
+	      }
+	    }
       
-	  if(p1 == well_index.end() || p2 == well_index.end()) {
-	    //
-	    std::cerr << funame << "no density of states for wells connected with " 
-		      << Model::inner_barrier(b).name() << " barrier at "
-		      <<  (energy_reference()  - (double)e * energy_step()) / Phys_const::kcal 
-		      << " kcal/mol\n";
-	    
-	    throw Error::Logic();
-	  }
+	  // kinetic matrix normalization
+	  for(int i1 = 0; i1 < bimolecular_group[e].size(); ++i1)
+	    for(int i2 = i1; i2 < bimolecular_group[e].size(); ++i2)
+	      bg_km(i1, i2) /= bg_state_density_sqrt[e][i1] * bg_state_density_sqrt[e][i2];
+
+	  // bimolecular channel normalization
+	  for(int i = 0; i < bimolecular_group[e].size(); ++i)
+	    bg_bim.row(i) /= bg_state_density_sqrt[e][i];
 
-	  km(p1->second, p2->second) -= inner_barrier(b).state_number(e) / 2. / M_PI
-	    //
-	    / std::sqrt(well(w1).state_density(e) * well(w2).state_density(e));
+	  bg_km_set[e]  = bg_km;
+	  bg_bim_set[e] = bg_bim;
+	  bg_batch[bimolecular_group[e].size()].push_back(e);
 	}
-      }
 
-      // diagonal isomerization contribution
-      //
-      for(int i = 0; i < well_array.size(); ++i) {
+      // batched Cholesky solution
+      for(std::map<int, std::vector<int> >::const_iterator bit = bg_batch.begin(); bit != bg_batch.end(); ++bit) {
 	//
-	int w = well_array[i];
-	
-	if(e < cum_stat_num[w].size())
-	  //
-	  km(i, i) = cum_stat_num[w][e] / 2. / M_PI / well(w).state_density(e);
-	
-	if(Model::well(w).escape())
-	  //
-	  km(i, i) += well(w).escape_rate(i);
-      }
+	const int n = bit->first;
+	const int mat_size = n * (n + 1) / 2;
+	const int rhs_step = n * Model::bimolecular_size();
+	const int batch_size = bit->second.size();
+
+	std::vector<double> mat_buff(mat_size * batch_size);
+	std::vector<double> rhs_buff(rhs_step * batch_size);
+
+	for(int k = 0; k < batch_size; ++k) {
+	  const int e = bit->second[k];
+	  const double* p = bg_km_set[e];
+	  std::copy(p, p + mat_size, &mat_buff[k * mat_size]);
+	  p = bg_bim_set[e];
+	  std::copy(p, p + rhs_step, &rhs_buff[k * rhs_step]);
+	}
 
-      // relaxation eigenvalues
-      //
-      Lapack::Matrix evec(well_array.size());
-      
-      Lapack::Vector eval = km.eigenvalues(&evec);
+	Lapack::cholesky_batch(n, Model::bimolecular_size(), batch_size, &mat_buff[0], &rhs_buff[0]);
 
-      kinetic_basis[e].eigenvalue  = eval;
-      
-      kinetic_basis[e].eigenvector = evec;
-      
-      // kinetically active subspace
-      //
-      for(itemp = 0; itemp < well_array.size(); ++itemp) {
-	//
-	int w = well_array[itemp];
-	
-	if(eval[itemp] > well(w).collision_frequency() * reduction_threshold)
-	  //
-	  break;
+	for(int k = 0; k < batch_size; ++k) {
+	  const int e = bit->second[k];
+	  bg_mat[e].resize(n, Model::bimolecular_size());
+	  std::copy(&rhs_buff[k * rhs_step], &rhs_buff[k * rhs_step] + rhs_step, (double*)bg_mat[e]);
+	}
       }
-      
-      kinetic_basis[e].active_size = itemp;
-      //
-    }//energy cycle
-    //
-  }// kinetically active basis
 
+      // bimolecular-to-bimolecular rate
+      for(int e = 0; e < well_size_max; ++e)
+	if(bimolecular_group[e].size()) {
+	  mtemp = bg_bim_set[e].transpose_product(bg_mat[e]);
 
-  // global united species indexing
-  //
-  std::vector<int> well_shift(ener_index_max);
-  
-  itemp = 0;
-  
-  for(int e = 0; e < ener_index_max; itemp += kinetic_basis[e++].active_size)
-    //
-    well_shift[e] = itemp;
-  
-  const int global_size = itemp;
+	  mtemp *= thermal_factor(e);
 
-  // global kinetic matrix size without reduction
-  //
-  itemp = 0;
-  //
-  for(int w = 0; w < Model::well_size(); ++w)
-    //
-    itemp += well(w).size();
+	  bb_rate += Lapack::SymmetricMatrix(mtemp);
+	}
 
-  IO::log << IO::log_offset << "original kinetic matrix size = " << itemp << "\n";
-  
-  IO::log << IO::log_offset << "reduced  kinetic matrix size = " << global_size << "\n";
+      bb_rate /= 2. * M_PI;
 
-  /************************************************************************************* 
-   ********************************* KINETIC MATRIX ************************************
-   *************************************************************************************/
+      for(int e = 0; e < well_size_max; ++e)
+	for(int g = 0; g < well_partition[e].size(); ++g) {
+	  const int gi = g + well_shift[e];
 
-  // kinetic relaxation matrix
-  //
-  Lapack::SymmetricMatrix kin_mat(global_size);
-  
-  kin_mat = 0.;
-  
-  // diagonal chemical relaxation
-  //
-  itemp = 0;
-  
-  for(int e = 0; e < ener_index_max; ++e) {
-    //
-    for(int l = 0; l < kinetic_basis[e].active_size; ++l, ++itemp) {
-      //
-      kin_mat(itemp, itemp) = kinetic_basis[e].eigenvalue[l];
-    }
-  }
-    
-  // collisional energy relaxation
-  //
-  for(int e1 = 0; e1 < ener_index_max; ++e1) {
-    //
-    for(int e2 = e1; e2 < ener_index_max; ++e2) {
-      //
-      for(int l1 = 0; l1 < kinetic_basis[e1].active_size; ++l1) {
-	//
-	for(int l2 = 0; l2 < kinetic_basis[e2].active_size; ++l2) {
-	  //
-	  if(e1 == e2 && l2 < l1)
-	    //
-	    continue;
+	  //direct bimolecular channel contribution
+	  for(int b = 0; b < Model::outer_barrier_size(); ++b)
+	    if(e < outer_barrier(b).size()) {
+	      const int w = Model::outer_connect(b).first;
+	      const int p = Model::outer_connect(b).second;
+	      if(well_partition[e][g].find(w) != well_partition[e][g].end())
+		global_bim(gi, p) += outer_barrier(b).state_number(e);
+	    }
 
-	  dtemp = 0.;
-	  
-	  for(int w = 0; w < Model::well_size(); ++w) {
-	    //
-	    std::map<int, int>::const_iterator i1 = kinetic_basis[e1].well_index_map.find(w);
+	  // isomerization-to-bimolecular group contribution
+	  if(bimolecular_group[e].size()) {
+	    vtemp.resize(bimolecular_group[e].size());
+	    vtemp = 0.;
+	    for(int b = 0; b < Model::inner_barrier_size(); ++b)
+	      if(e < inner_barrier(b).size()) {
 
-	    std::map<int, int>::const_iterator i2 = kinetic_basis[e2].well_index_map.find(w);
-	    
-	    itemp = e2 - e1;
-	    
-	    if(i1 != kinetic_basis[e1].well_index_map.end() &&
-	       //
-	       i2 != kinetic_basis[e2].well_index_map.end() &&
-	       //
-	       itemp < well(w).kernel_bandwidth) {
-	      //
-	      dtemp +=  well(w).kernel(e1, e2) * well(w).collision_frequency()
-		//
-		* well(w).boltzman_sqrt(e1) / well(w).boltzman_sqrt(e2)
-		//
-		* kinetic_basis[e1].eigenvector(i1->second, l1)
-		//
-		* kinetic_basis[e2].eigenvector(i2->second, l2);
-	    }
-	  }
+		const int w1 = Model::inner_connect(b).first;
+		const int w2 = Model::inner_connect(b).second;
 	  
-	  kin_mat(well_shift[e1] + l1, well_shift[e2] + l2) = dtemp;
-	  //
-	}// l2 cycle
-	//
-      }// l1 cycle
-      //
-    }// e2 cycle
-    //
-  }// e1 cycle
+		Git ww;
 
-  /******************** DIAGONALIZING THE GLOBAL KINETIC RELAXATION MATRIX ********************/
+		if(((ww = bimolecular_group[e].find(w1)) != bimolecular_group[e].end() && 
+		    well_partition[e][g].find(w2) != well_partition[e][g].end()) ||
+		   ((ww = bimolecular_group[e].find(w2)) != bimolecular_group[e].end() &&
+		    well_partition[e][g].find(w1) != well_partition[e][g].end())) {
+		  itemp = std::distance(bimolecular_group[e].begin(), ww);
+		  vtemp[itemp] += inner_barrier(b).state_number(e);	  
+		}
+	      }
 
-  Lapack::Vector eigenval;
-  
-  Lapack::Matrix global_eigen(global_size);
+	    // normalization
+	    for(int i = 0; i < bimolecular_group[e].size(); ++i)
+	      vtemp[i] /= bg_state_density_sqrt[e][i];
 
-  {
-    IO::Marker solve_marker("diagonalizing global relaxation matrix", IO::Marker::ONE_LINE);
-    //
-    eigenval = kin_mat.eigenvalues(&global_eigen);
-  }
+	    vtemp = vtemp * bg_mat[e];
 
-  /************************************* EIGENVECTOR WELL POPULATION ****************************/
+	    global_bim.row(gi) += vtemp;
+	  }
 
-  
-  
-}
+	  //collision-to-bimolecular-group contribution
+	  for(int e1 = 0; e1 < e; ++e1) // only higher energies are considered
+	    if(bimolecular_group[e1].size()) {
+	      vtemp.resize(bimolecular_group[e1].size());
+	      vtemp = 0.;
+	  
+	      itemp = 0;
+	      btemp = false;
+	      for(Git w = bimolecular_group[e1].begin(); w != bimolecular_group[e1].end(); ++w, ++itemp) 
+		if(well_partition[e][g].find(*w) != well_partition[e][g].end()) {
+		  dtemp = well(*w).kernel(e, e1);
+		  if(dtemp != 0.) {
+		    btemp = true;
+		    vtemp[itemp] -=  dtemp * well(*w).state_density(e) / bg_state_density_sqrt[e1][itemp] * well(*w).collision_frequency();
+		  }
+		}
+	     
+	      if(btemp) {
+		vtemp = vtemp * bg_mat[e1];
+		vtemp *= 2. * M_PI;
+		global_bim.row(gi) += vtemp;
+	      }
+	    }
+	  // capture number of states contribution
+	  for(int p = 0; p < Model::bimolecular_size(); ++p)
+	    capture_state_number[p] += global_bim(gi, p) * thermal_factor(e);
 
-void MasterEquation::well_reduction_method_old (std::map<std::pair<int, int>, double>& rate_data, Partition& thermal_well_partition, int flags)
-  
-{
-  const char funame [] = "MasterEquation::well_reduction_method_old: ";
+	  // normalization
+	  global_bim.row(gi) *= thermal_factor(e) / 2. / M_PI / group_weight_sqrt[gi];
+	}
 
-  static const double machine_eps = 1.e-14;
+    }// bimolecular product vectors setting
 
-  if(!isset()) {
-    std::cerr << funame << "reactive complex is not set\n";
-    throw Error::Init();
-  }
+    // checking kinetic matrix and bimolecular product vectors for consistency
+    {
+      IO::Marker check_marker("checking kinetic matrix and bimolecular product vectors");
 
-  rate_data.clear();
+      for(int e1 = 0; e1 < well_size_max; ++e1)
+	for(int g1 = 0; g1 < well_partition[e1].size(); ++g1) {
+	  const int i1 = g1 + well_shift[e1];
 
-  IO::Marker funame_marker(funame);
-  
-  IO::log << IO::log_offset << "Pressure = ";
-  switch(pressure_unit) {
-  case BAR:
-    IO::log << pressure() / Phys_const::bar << " bar";
-    break;
-  case TORR:
-    IO::log << pressure() / Phys_const::tor << " torr";
-    break;
-  case ATM:
-    IO::log << pressure() / Phys_const::atm << " atm";
-    break;
-  }
-  IO::log << "\t Temperature = "
-	  << temperature() / Phys_const::kelv << " K\n";
-  //<< IO::log_offset << "collision frequency = " 
-  //<< MasterEquation::collision_frequency() / Phys_const::herz
-  //<< " 1/sec\n";
+	  dtemp = 0.;
+	  for(int e2 = 0; e2 < well_size_max; ++e2)
+	    for(int g2 = 0; g2 < well_partition[e2].size(); ++g2) {
+	      const int i2 = g2 + well_shift[e2];
+	      dtemp += kin_mat(i1, i2)  * group_weight_sqrt[i2];
+	    }
+
+	  for(int p = 0; p < Model::bimolecular_size(); ++p)
+	    dtemp -= global_bim(i1, p);
+
+	  dtemp /= kin_mat(i1, i1) * group_weight_sqrt[i1];
 
-  int                 itemp;
-  double              dtemp;
-  bool                btemp;
-  std::string         stemp;
-  Lapack::Vector      vtemp;
-  Lapack::Matrix      mtemp;
+	  if(dtemp > machine_eps || dtemp < -machine_eps)
+	    IO::log << IO::log_offset << funame 
+		    << "WARNING: kinetic matrix and bimolecular product vectors are not consistent:"
+		    << " e = " << std::setw(5) << e1 
+		    << " g = " << std::setw(5) << g1 
+		    << " error = " << std::setw(13) << dtemp
+		    << "\n";
 
-  for(int w = 0; w < Model::well_size(); ++w)
-    if(!w || well(w).size() > itemp)
-      itemp = well(w).size();
-  const int well_size_max = itemp;
+	}
+    }
 
-  for(int w = 0; w < Model::well_size(); ++w)
-    if(!w || well(w).collision_frequency() < dtemp)
-      dtemp = well(w).collision_frequency();
+    /******************** DIAGONALIZING THE GLOBAL KINETIC RELAXATION MATRIX ********************/
 
-  const double collision_frequency_min = dtemp;
-    
-  /******************************** PARTITIONING THE WELLS ************************************/
+    Lapack::Vector eigenval;
+    Lapack::Matrix eigen_global(global_size);
 
-  std::vector<Partition> well_partition(well_size_max);
-  std::vector<Group>     bimolecular_group(well_size_max);
+    {
+      IO::Marker solve_marker("diagonalizing global relaxation matrix", IO::Marker::ONE_LINE);
 
-  {// well partitioning
+      Threads::BlasScope blas_scope;
 
-    IO::Marker well_part_marker("energy-resolved well partitioning");
+      eigenval = kin_mat.eigenvalues(&eigen_global);
+      eigen_global.transpose_in_place();
+    }
 
-    for(int e = 0; e < well_size_max; ++e) {// energy cycle
+    /*
+      for(int i = 0; i < global_size; ++i)
+      for(int j = 0; j < global_size; ++j) {
+      double* p = &eigen_global(i, j);
+      if(*p < machine_eps && *p > -machine_eps)
+      *p = 0.;
+      }
+    */
 
-      // available energy bins
-      std::vector<int> well_array;
-      std::map<int, int> well_index;
-      for(int w = 0; w < Model::well_size(); ++w)
-	if(well(w).size() > e) {
-	  well_index[w] = well_array.size();
-	  well_array.push_back(w);
-	}
+    // eigenvector to bimolecular vector projection
+    Lapack::Matrix eigen_bim = eigen_global * global_bim;
 
-      // microcanonical kinetic matrix
-      Lapack::SymmetricMatrix km(well_array.size());
-      km = 0.;
+    const double min_relax_eval = eigenval[Model::well_size()];
+    const double max_relax_eval = eigenval.back();
 
-      // km initialization
-      // nondiagonal isomerization contribution
-      for(int b = 0; b < Model::inner_barrier_size(); ++b)
-	if(e < inner_barrier(b).size()) {
-	  int w1 = Model::inner_connect(b).first;
-	  int w2 = Model::inner_connect(b).second;
-      
-	  std::map<int, int>::const_iterator p1 = well_index.find(w1);
-	  std::map<int, int>::const_iterator p2 = well_index.find(w2);
-      
-	  if(p1 == well_index.end() || p2 == well_index.end()) {
-	    std::cerr << funame << "no density of states for wells connected with " 
-		      << Model::inner_barrier(b).name() << " barrier at "
-		      <<  (energy_reference()  - (double)e * energy_step()) / Phys_const::kcal 
-		      << " kcal/mol\n";
-	    throw Error::Logic();
-	  }
+    //IO::log << IO::log_offset << "minimal relaxation eigenvalue / collision frequency = "
+    //<< min_relax_eval / collision_frequency() << "\n";
+    //IO::log << IO::log_offset << "maximal relaxation eigenvalue / collision frequency = "
+    //<< max_relax_eval / collision_frequency() << "\n";
 
-	  km(p1->second, p2->second) =  - inner_barrier(b).state_number(e) / 2. / M_PI
-	    / std::sqrt(well(w1).state_density(e) * well(w2).state_density(e));
-	}
+    itemp = 0;
+    while(eigenval[itemp] / max_relax_eval < machine_eps) {
+      IO::log << IO::log_offset << "WARNING: " << itemp << "-th eigenvalue is too small\n"; 
+      //<< eigenval[itemp] / collision_frequency() << " is too small\n";
+      eigenval[itemp] = 0.;
+      ++itemp;
+    }
 
-      // diagonal isomerization contribution
-      for(int i = 0; i < well_array.size(); ++i) {
-	int w = well_array[i];
-	if(e < cum_stat_num[w].size())
-	  km(i, i) = cum_stat_num[w][e] / 2. / M_PI / well(w).state_density(e);
+    // eigenvector projection on the chemical subspace
+    Lapack::Matrix eigen_pop(global_size, Model::well_size());
+    eigen_pop = 0.;
+  
+    for(int e = 0; e < well_size_max; ++e) {
+      const double tf_sqrt = std::sqrt(thermal_factor(e));
+      for(int g = 0; g < well_partition[e].size(); ++g) {
+	const int gi = g + well_shift[e];
+	for(Git i = well_partition[e][g].begin(); i != well_partition[e][g].end(); ++i) {
+	  dtemp = well(*i).state_density(e) * tf_sqrt / group_state_density_sqrt[gi];
+	  for(int l = 0; l < global_size; ++l)
+	    eigen_pop(l, *i) += eigen_global(l, gi) * dtemp;
+	}
       }
+    }
 
-      // relaxation eigenvalues
-      Lapack::Matrix evec(well_array.size());
-      Lapack::Vector eval = km.eigenvalues(&evec);
+    for(int w = 0; w < Model::well_size(); ++w)
+      eigen_pop.column(w) /= well(w).weight_sqrt();
+  
+    for(int w = 0; w < Model::well_size(); ++w)
+      for(int l = 0; l < global_size; ++l) {
+	dtemp = eigen_pop(l, w);
+	if(dtemp < 1.e-12 && dtemp > -1.e-12)
+	  eigen_pop(l, w) = 0.;
+      }
 
-      // kinetically active subspace
-      for(itemp = 0; itemp < well_array.size(); ++itemp) {
-	int w = well_array[itemp];
-	
-	if(reduction_threshold > 0.) {
-	  if(eval[itemp] > well(w).collision_frequency() * reduction_threshold)
-	    break;
-	}
-	else if(reduction_threshold < 0.) {
-	  if(eval[itemp] > - well(w).collision_frequency() * reduction_threshold 
-	     && (itemp && eval[itemp] /eval[itemp - 1] > - reduction_threshold || !itemp))
-	    break;
-	}
-	else {
-	  itemp = well_array.size();
-	  break;
-	}
-	const int chem_size = itemp;
+    // eigenvector projection on the relaxation subspace
+    std::vector<double> relaxation_projection(Model::well_size());
+    for(int l = 0; l < Model::well_size(); ++l)
+      relaxation_projection[l] = 1. - vdot(eigen_pop.row(l));
 
-	Lapack::Matrix pop_chem(well_array.size(), chem_size);
-	for(int l = 0; l < chem_size; ++l)
-	  pop_chem.column(l) = evec.column(l);
+    /************************************* EIGENVECTOR OUTPUT *****************************************/
 
-	// statistical weight
-	std::vector<double> weight(well_array.size());
-	for(int i = 0; i < weight.size(); ++i)
-	  weight[i] = well(well_array[i]).state_density(e);
+    IO::log << std::setprecision(3)
+	    << IO::log_offset << "eigenvector populations normalized:\n"
+	    << IO::log_offset 
+	    << std::setw(5)  << "L"
+	    << std::setw(10) << "*R"
+	    << std::setw(10) << "*P";
+    for(int w = 0; w < Model::well_size(); ++w)
+      IO::log << std::setw(10) << Model::well(w).name();  
+    IO::log << "\n";
 
-	Partition wp;
-	Group bg;
+    // maximal population
+    for(int l = 0; l < Model::well_size(); ++l) {
 
-	// well partitioning
-	if(chem_size == well_array.size()) {
-	  wp.resize(well_array.size());
-	  for(int w = 0; w < well_array.size(); ++w)
-	    wp[w].insert(w);
-	}
-	else if(!chem_size) {
-	  for(int w = 0; w < well_array.size(); ++w)
-	    bg.insert(w);
-	}
-	else {
-	  Group well_pool;
-	  dtemp = well_partition_method(pop_chem, wp, well_pool, weight);
-      
-	  for(int b = 0; b < Model::outer_barrier_size(); ++b)
-	    if(e < outer_barrier(b).size()) {
-	      const int w = well_index[Model::outer_connect(b).first];
-	      if(well_pool.find(w) != well_pool.end()) {
-		well_pool.erase(w);
-		bg.insert(w);
-	      }
-	    }
+      double pos_pop = 0.;
+      double neg_pop = 0.;
+      for(int w = 0; w < Model::well_size(); ++w) {
+	dtemp = eigen_pop(l, w) * well(w).weight_sqrt();
+	if(dtemp > 0.)
+	  pos_pop += dtemp;
+	if(dtemp < 0.)
+	  neg_pop += dtemp;
+      }
+      double max_pop = pos_pop > -neg_pop ? pos_pop : neg_pop;
+    
+      IO::log << IO::log_offset
+	      << std::setw(5)  << l
+	      << std::setw(10) << eigenval[l] / min_relax_eval
+	      << std::setw(10) << relaxation_projection[l]; 
+      for(int w = 0; w < Model::well_size(); ++w) {
+	dtemp = eigen_pop(l, w) * well(w).weight_sqrt() / max_pop;
+	IO::log << std::setw(10);
+	if(dtemp > .01 || dtemp < -.01)
+	  IO::log << dtemp;
+	else
+	  IO::log << 0;
+      }
+      IO::log << "\n";
+    }
 
-	  if(bg.size()) {
-	    Group barrier_pool;
-	    for(int b = 0; b < Model::inner_barrier_size(); ++b)
-	      if(e < inner_barrier(b).size())
-		barrier_pool.insert(b);
+    IO::log << IO::log_offset << std::setw(5) << "*R" 
+	    << " - eigenvalue over the relaxation limit\n"
+	    << IO::log_offset << std::setw(5) << "*P" 
+	    << " - eigenvector projection squared on the relaxation subspace\n"
+	    << IO::log_offset << "eigenvector projections:\n"
+	    << IO::log_offset 
+	    << std::setw(5)  << "L"
+	    << std::setw(10) << "*Q"
+	    << std::setw(10) << "*P";
 
-	    while(well_pool.size()) {
-	      btemp = true;
-	  
-	      for(Git b = barrier_pool.begin(); b != barrier_pool.end(); ++b) {
-		const int w1 = well_index[Model::inner_connect(*b).first];
-		const int w2 = well_index[Model::inner_connect(*b).second];
+    for(int w = 0; w < Model::well_size(); ++w)
+      IO::log << std::setw(10) << Model::well(w).name();  
+    IO::log << "\n";
 
-		if(well_pool.find(w1) != well_pool.end() && bg.find(w2) != bg.end()) {
-		  well_pool.erase(w1);
-		  bg.insert(w1);
-		  barrier_pool.erase(*b);
-		  btemp = false;
-		  break;
-		}
+    for(int l = 0; l < Model::well_size(); ++l) {
+      IO::log << IO::log_offset
+	      << std::setw(5)  << l
+	      << std::setw(10) << eigenval[l] / collision_frequency_min
+	      << std::setw(10) << relaxation_projection[l]; 
+      for(int w = 0; w < Model::well_size(); ++w)
+	IO::log << std::setw(10) << eigen_pop(l,w);
+      IO::log << "\n";
+    }
+  
+    IO::log << IO::log_offset 
+	    << std::setw(5) << "*Z"
+	    << std::setw(10) << "---"
+	    << std::setw(10) << "---";
+    for(int w = 0; w < Model::well_size(); ++w)
+      IO::log << std::setw(10) << well(w).weight_sqrt();
+    IO::log << "\n";
 
-		if(well_pool.find(w2) != well_pool.end() && bg.find(w1) != bg.end()) {
-		  well_pool.erase(w2);
-		  bg.insert(w2);
-		  barrier_pool.erase(*b);
-		  btemp = false;
-		  break;
-		}
-	      }
-	      if(btemp)
-		break;
-	    }
-	  }
+    IO::log << IO::log_offset << std::setw(5) << "*Q" 
+	    << " - eigenvalue over the collision frequency\n"
+	    << IO::log_offset << std::setw(5) << "*P" 
+	    << " - eigenvector projection squared on the relaxation subspace\n"
+	    << IO::log_offset << std::setw(5) << "*Z" 
+	    << " - well partition function square root\n"
+	    << std::setprecision(6);
+  
 
-	  if(well_pool.size()) {
+    /********************************** CHEMICAL SUBSPACE DIMENSION ****************************************/
 
-	    IO::log << IO::log_offset << "WARNING: e = " << e << "; bimolecular group = ";
-	    for(Git i = bg.begin(); i != bg.end(); ++i) {
-	      if(i != bg.begin())
-		IO::log << "+";
-	      IO::log << Model::well(well_array[*i]).name();
-	    }
-	    IO::log << "; unconnected part = ";
-	    for(Git i = well_pool.begin(); i != well_pool.end(); ++i) {
-	      if(i != well_pool.begin())
-		IO::log << "+";
-	      IO::log << Model::well(well_array[*i]).name();
-	    }
-	    IO::log << "\n";
+    if(_default_chem_size >= 0) 
+      itemp = _default_chem_size;
+    else if(default_partition.size())
+      itemp = default_partition.size();
+    else if(chemical_threshold > 1.) {   
+      for(itemp = 0; itemp < Model::well_size(); ++itemp)
+	if(eigenval[itemp] > 0. && min_relax_eval / eigenval[itemp]  < chemical_threshold)
+	  break;
+    }
+    else if(chemical_threshold < 1. && chemical_threshold > 0.) {
+      for(itemp = 0; itemp < Model::well_size(); ++itemp)
+	if(relaxation_projection[itemp] > chemical_threshold)
+	  break;
+    }   
+    else if(chemical_threshold < -1. ) {
+      for(itemp = Model::well_size(); itemp > 0; --itemp)
+	if(eigenval[itemp - 1] == 0. || eigenval[itemp] / eigenval[itemp - 1] > - chemical_threshold)
+	  break;
+    }
+    else
+      itemp = Model::well_size();
+	
+    const int chem_size = itemp;
 
-	    int smax; 
-	    double pmax;
-	    for(Git i = well_pool.begin(); i !=well_pool.end(); ++i) {
-	      for(int s = 0; s < chem_size; ++s) {
-		dtemp = Group(wp[s]).insert(*i).projection(pop_chem, weight); 
-		if(!s || dtemp > pmax) {
-		  pmax = dtemp;
-		  smax = s;
-		}
-	      }
-	      wp[smax].insert(*i);
-	    }
-	  }
-	}
+    if(chem_size != Model::well_size())
+      IO::log << IO::log_offset << "dimension of the chemical subspace = " << chem_size << "\n";
 
-	well_partition[e].resize(wp.size());
-	for(int g = 0; g < wp.size(); ++g)
-	  for(Git w = wp[g].begin(); w != wp[g].end(); ++w)
-	    well_partition[e][g].insert(well_array[*w]);
+    eigenvalue_gap = chem_size ? min_relax_eval / eigenval[chem_size - 1] : -1.;
 
-	for(Git w = bg.begin(); w != bg.end(); ++w)
-	  bimolecular_group[e].insert(well_array[*w]);
+    /*** COLLISIONAL RELAXATION EIGENVALUES AND EIGENVECTORS AND BIMOLECULAR-TO-BIMOLECULAR RATES ***/
 
-      }//energy cycle
-    } // well partitioning
+    const int relax_size = global_size - chem_size;
+    Lapack::Vector relax_lave(relax_size);
+    for(int r = 0; r < relax_size; ++r) {
+      itemp = r + chem_size;
+      relax_lave[r] = 1. / eigenval[itemp];
+    }
 
-    // checking
-    {
-      IO::Marker checking_marker("checking well partitioning");
+    for(int i = 0; i < Model::bimolecular_size(); ++i)
+      for(int j = i; j < Model::bimolecular_size(); ++j)
+	bb_rate(i, j) += triple_product(&eigen_bim(chem_size, i), &eigen_bim(chem_size, j), 
+					relax_lave, relax_size);
 
-      for(int e = 1; e < well_size_max; ++e)
-	for(Git i = bimolecular_group[e].begin(); i != bimolecular_group[e].end(); ++i)
-	  if(bimolecular_group[e - 1].find(*i) == bimolecular_group[e - 1].end()) {
-	    IO::log << IO::log_offset << "WARNING: bimolecular group inconsistency:\n";
+    // kappa-matrix
+    IO::log << std::setprecision(2)
+	    << IO::log_offset << "isomers-to-bimolecular equilibrium coefficients (kappa matrix):\n";
+    IO::log << IO::log_offset << std::setw(5) << "W\\P";
+    for(int p = 0; p < Model::bimolecular_size(); ++p)
+      IO::log << std::setw(9) << Model::bimolecular(p).name();
+    IO::log << "\n";
+   
+    for(int w = 0; w < Model::well_size(); ++w) {
+      IO::log << IO::log_offset << std::setw(5) << Model::well(w).name();  
+      for(int p = 0; p < Model::bimolecular_size(); ++p) {
+	dtemp = triple_product(&eigen_bim(chem_size, p), &eigen_pop(chem_size, w), relax_lave, relax_size) 
+	  / well(w).weight_sqrt();
+	IO::log << std::setw(9);
+	if(dtemp < 0.05 && dtemp > -0.05)
+	  IO::log << "0"; 
+	else
+	  IO::log << dtemp; 
+      }
+      IO::log << "\n";
+    }
+    IO::log << std::setprecision(6);
 
-	    itemp = e - 1;
-	    IO::log << IO::log_offset << "e = " << std::setw(5) << itemp << "; bimolecular group =";
-	    for(Git j = bimolecular_group[itemp].begin(); j != bimolecular_group[itemp].end(); ++j)
-	      IO::log << std::setw(5) << Model::well(*j).name();
-	    IO::log << "\n";
-	
-	    itemp = e;
-	    IO::log << IO::log_offset << "e = " << std::setw(5) << itemp << "; bimolecular group =";
-	    for(Git j = bimolecular_group[itemp].begin(); j != bimolecular_group[itemp].end(); ++j)
-	      IO::log << std::setw(5) << Model::well(*j).name();
-	    IO::log << "\n";
+    // bimolecular rate units
+    const double bru = Phys_const::cm * Phys_const::cm * Phys_const::cm * Phys_const::herz;
+
+    // bimolecular rate constants
+    for(int i = 0; i < Model::bimolecular_size(); ++i) 
+      if(bimolecular(i).weight() > 0.)
+	for(int j = 0; j < Model::bimolecular_size(); ++j) {
+	  dtemp = bb_rate(i, j) * energy_step();
+	  // bimolecular reactant loss
+	  if(i == j) {
+	    dtemp = -dtemp;
+	    dtemp += capture_state_number[i] / 2. / M_PI * energy_step();
+	    /*
+	      for(int b = 0; b < Model::outer_barrier_size(); ++b)
+	      if(Model::outer_connect(b).second == i)
+	      dtemp += temperature() / 2. / M_PI * outer_barrier(b).weight();
+	    */	  
 	  }
+	  dtemp /= bimolecular(i).weight() * bru;
+	  rate_data[std::make_pair(Model::well_size() + i, Model::well_size() + j)] = dtemp; 	
+	}
 
-      // checking internal relaxation eigenvalues
-      for(int e = 0; e < well_size_max; ++e) {// energy cycle
+    /*************************************** BOUND SPECIES *******************************************/
 
-	if(bimolecular_group[e].size()) {// bimolecular group
+    std::vector<int>  group_index;
+    Lapack::Matrix m_direct;
+    std::vector<double>      weight;
+    std::vector<double> real_weight;
 
-	  Lapack::SymmetricMatrix km(bimolecular_group[e].size());
-	  km = 0.;
+    if(chem_size) { // bound species
 
-	  for(int b = 0; b < Model::inner_barrier_size(); ++b)
-	    if(inner_barrier(b).size() > e) {
+      // projection of the chemical eigenvectors onto the thermal subspace
+      Lapack::Matrix pop_chem(Model::well_size(), chem_size);
+      for(int l = 0; l < chem_size; ++l)
+	pop_chem.column(l) = eigen_pop.row(l);
 
-	      const int w1 = Model::inner_connect(b).first;
-	      const int w2 = Model::inner_connect(b).second;
-	      Git ww1 = bimolecular_group[e].find(w1);
-	      Git ww2 = bimolecular_group[e].find(w2);
-	  
-	      if(ww1 != bimolecular_group[e].end() && ww2 != bimolecular_group[e].end()) {
-		const int i1 = std::distance(bimolecular_group[e].begin(), ww1);
-		const int i2 = std::distance(bimolecular_group[e].begin(), ww2);
-		dtemp = inner_barrier(b).state_number(e) / 2. / M_PI;
-		km(i1, i1) += dtemp / well(w1).state_density(e);
-		km(i2, i2) += dtemp / well(w2).state_density(e);
-		km(i1, i2) -= dtemp / std::sqrt(well(w1).state_density(e) * well(w2).state_density(e));	   
-	      }
-	    }
+      // partitioning wells into equilibrated groups
+      if(default_partition.size()) {
+	// default reduction scheme
+	thermal_well_partition = default_partition;
 
-	  for(int b = 0; b < Model::outer_barrier_size(); ++b)
-	    if(outer_barrier(b).size() > e) {
+	IO::log << IO::log_offset << "using default reduction scheme, projection error = "
+		<< (double)chem_size - thermal_well_partition.projection(pop_chem) << "\n";
+    
+	// convert chemical eigenvectors in the new basis
+	pop_chem = thermal_well_partition.basis().transpose_product(pop_chem);
+      }
+      else if(chem_size == Model::well_size()) {
+	// no partitioning
+	thermal_well_partition.resize(Model::well_size());
+	for(int w = 0; w < Model::well_size(); ++w)
+	  thermal_well_partition[w].insert(w);
 
-	      const int w = Model::outer_connect(b).first;
-	      Git ww = bimolecular_group[e].find(w);
-	  
-	      if(ww != bimolecular_group[e].end()) {
-		const int i = std::distance(bimolecular_group[e].begin(), ww);
-		dtemp = outer_barrier(b).state_number(e) / 2. / M_PI;
-		km(i, i) += dtemp / well(w).state_density(e);
-	      }
-	    }
+	IO::log << IO::log_offset << "projection error = "
+		<< (double)chem_size - thermal_well_partition.projection(pop_chem) << "\n";
+      }
+      else {
+	// well partitioning
+	Group bimolecular_group;
+	dtemp = well_partition_method(pop_chem, thermal_well_partition, bimolecular_group, std::vector<double>());
 
-	  dtemp = km.eigenvalues()[0] / collision_frequency_min;
-	  if(reduction_threshold > 0. && dtemp < reduction_threshold || reduction_threshold < 0. && dtemp < - reduction_threshold) {
-	    IO::log << IO::log_offset << "WARNING: e = " << e << "; bimolecular group = ";
-	    for(Git i = bimolecular_group[e].begin(); i != bimolecular_group[e].end(); ++i) {
-	      if(i != bimolecular_group[e].begin())
-		IO::log << "+";
-	      IO::log << Model::well(*i).name();
-	    }
-	    IO::log << "; minimal eigenvalue / collision frequency = "
-		    << dtemp << "\n";
-	  }
-	}// bimolecular group
+	// convert chemical eigenvectors in the new basis
+	pop_chem = thermal_well_partition.basis().transpose_product(pop_chem);
+      }
 
-	for(int g = 0; g < well_partition[e].size(); ++g)
-	  if(well_partition[e][g].size() > 1) {// bound groups
+      group_index = thermal_well_partition.group_index();
+      weight      = thermal_well_partition.weight();
+      real_weight = thermal_well_partition.real_weight();
+
+      // output
+      if(chem_size != Model::well_size()) {
+	IO::log << IO::log_offset << "species:\n" 
+		<< IO::log_offset << std::setw(2) << "#"  << std::setw(15) 
+		<< "assigned name" << IO::first_offset
+		<< "group\n";
+	for(Pit g = thermal_well_partition.begin(); g != thermal_well_partition.end(); ++g) {
+	  itemp = g - thermal_well_partition.begin();
+	  IO::log << IO::log_offset << std::setw(2) << itemp << std::setw(15) 
+		  << Model::well(group_index[itemp]).name() << IO::first_offset;
+	  for(Git w = g->begin(); w != g->end(); ++w) {
+	    if(w != g->begin())
+	      IO::log << "+";
+	    IO::log << Model::well(*w).name();
+	  }
+	  IO::log << "\n";
+	}
+      }
 
-	    Lapack::SymmetricMatrix km(well_partition[e][g].size());
-	    km = 0.;
-	
-	    for(int b = 0; b < Model::inner_barrier_size(); ++b)
-	      if(inner_barrier(b).size() > e) {
+      m_direct = pop_chem;
+      Lapack::Matrix m_inverse = m_direct.invert();
 
-		const int w1 = Model::inner_connect(b).first;
-		const int w2 = Model::inner_connect(b).second;
+      // well-to-well rate coefficients
+      for(int i = 0; i < chem_size; ++i)
+	for(int j = 0; j < chem_size; ++j) {
+	  dtemp = 0.;
+	  for(int l = 0; l < chem_size; ++l)
+	    dtemp += m_direct(j, l) * m_inverse(l, i) * eigenval[l]; 
+	  dtemp *= std::sqrt(weight[i] * weight[j]) * energy_step() / real_weight[i] / Phys_const::herz;
+	  if(i != j) 
+	    dtemp = -dtemp;
+	  rate_data[std::make_pair(group_index[i], group_index[j])] = dtemp; 	
+	}
 
-		Git ww1 = well_partition[e][g].find(w1);
-		Git ww2 = well_partition[e][g].find(w2);
+      // well-to-bimolecular rate coefficients
+      for(int w = 0; w < chem_size; ++w)
+	for(int p = 0; p < Model::bimolecular_size(); ++p) {
+	  dtemp = vdot(m_inverse.column(w), &eigen_bim(0, p))
+	    * std::sqrt(weight[w]) * energy_step() / real_weight[w] / Phys_const::herz;
+	  rate_data[std::make_pair(group_index[w], Model::well_size() + p)] = dtemp;
+	}
+  
+      // bimolecular-to-well rate coefficients
+      for(int p = 0; p < Model::bimolecular_size(); ++p) 
+	if(bimolecular(p).weight() > 0.)
+	  for(int w = 0; w < chem_size; ++w) {
+	    dtemp = vdot(m_direct.row(w), &eigen_bim(0, p))
+	      * std::sqrt(weight[w]) * energy_step() / bimolecular(p).weight() / bru;
+	    rate_data[std::make_pair(Model::well_size() + p, group_index[w])] = dtemp;
+	  }
+    }// bound species  
+  }
+}
 
-	  
-		if(ww1 != well_partition[e][g].end() && ww2 != well_partition[e][g].end()) {
-	    
-		  const int i1 = std::distance(well_partition[e][g].begin(), ww1);
-		  const int i2 = std::distance(well_partition[e][g].begin(), ww2);
-	    
-		  dtemp = inner_barrier(b).state_number(e) / 2. / M_PI;
+/********************************************************************************************
+ ************ THE DIRECT DIAGONALIZATION OF THE GLOBAL KINETIC RELAXATION MATRIX ************
+ ********************************************************************************************/
 
-		  km(i1, i1) += dtemp / well(w1).state_density(e);
-		  km(i2, i2) += dtemp / well(w2).state_density(e);
-		  km(i1, i2) -= dtemp / std::sqrt(well(w1).state_density(e) * well(w2).state_density(e));
-		}
-	      }
+namespace MasterEquation {
+  //
+  // global kinetic relaxation matrix either in the packed, in the band, or in the distributed
+  // storage; in the band storage the wells are interleaved on the energy grid so that the inner
+  // barrier couplings stay within the band
+  //
+  class GlobalMatrix {
+  public:
+    Lapack::SymmetricMatrix dense;
+    Lapack::BandMatrix       band;
+    std::vector<int>   band_index; // global index to the band storage index
 
-	    dtemp = km.eigenvalues()[1] / collision_frequency_min;
-	    if(reduction_threshold > 0. && dtemp < reduction_threshold ||
-	       reduction_threshold < 0. && dtemp < - reduction_threshold) {
-	      IO::log << IO::log_offset << "WARNING: e = " << e << "; bound group = ";
-	      for(Git i = well_partition[e][g].begin(); i != well_partition[e][g].end(); ++i) {
-		if(i != well_partition[e][g].begin())
-		  IO::log << "+";
-		IO::log << Model::well(*i).name();
-	      }
-	      IO::log << "; minimal eigenvalue / collision frequency = " << dtemp << "\n";
-	    }
-	  }// bound groups
-      }// energy cycle
-    }
+#ifdef WITH_SCALAPACK
+    
+    Scalapack::SymmetricMatrix dist;
 
-    // global united species indexing
-    std::vector<int> well_shift(well_size_max);
-    itemp = 0;
-    for(int e = 0; e < well_size_max; itemp += well_partition[e++].size())
-      well_shift[e] = itemp;
+    bool is_dist () const { return dist.isinit(); }
 
-    const int global_size = itemp;
+    // the element is stored on the current process
+    bool is_local (int i, int j) const { return !is_dist() || dist.is_local(i, j); }
 
-    itemp = 0;
-    for(int w = 0; w < Model::well_size(); ++w)
-      itemp += well(w).size();
-    IO::log << IO::log_offset << "original kinetic matrix size = " << itemp << "\n";
+#else
 
-    IO::log << IO::log_offset << "reduced  kinetic matrix size = " << global_size << "\n";
+    bool is_dist  ()             const { return false; }
+    bool is_local (int, int)     const { return true; }
 
-    /******************************** SETTING KINETIC MATRIX ************************************/
+#endif
 
-    std::vector<double> group_state_density_sqrt(global_size);
-    std::vector<double> group_weight_sqrt(global_size);
+    bool is_band () const { return band_index.size(); }
 
-    Lapack::SymmetricMatrix kin_mat(global_size);
-    kin_mat = 0.;
-  
-    {// kinetic matrix setting
-      IO::Marker kin_mat_marker("setting kinetic matrix", IO::Marker::ONE_LINE);
+    double& operator() (int i, int j) 
+    {
+      if(is_band())
+	return band(band_index[i], band_index[j]);
 
-      for(int e = 0; e < well_size_max; ++e) {
-	double tf_sqrt = std::sqrt(thermal_factor(e));
-	for(int g = 0; g < well_partition[e].size(); ++g) {
-	  dtemp = 0.;
-	  for(Git w = well_partition[e][g].begin(); w != well_partition[e][g].end(); ++w)
-	    dtemp += well(*w).state_density(e);
-	  itemp = g + well_shift[e];
-	  dtemp = std::sqrt(dtemp);
-	  group_state_density_sqrt[itemp] = dtemp;
-	  group_weight_sqrt[itemp] = dtemp * tf_sqrt;
-	}
-      }
+#ifdef WITH_SCALAPACK
 
-      // non-diagonal  collisional relaxation contribution
-      for(int e1 = 0; e1 < well_size_max; ++e1)
-	for(int g1 = 0; g1 < well_partition[e1].size(); ++g1)
-	  for(int e2 = e1 + 1; e2 < well_size_max; ++e2)
-	    for(int g2 = 0; g2 < well_partition[e2].size(); ++g2) {
-	      dtemp = 0.;
-	      for(Git w = well_partition[e1][g1].begin(); w != well_partition[e1][g1].end(); ++w)
-		if(well_partition[e2][g2].find(*w) != well_partition[e2][g2].end())
-		  dtemp += well(*w).kernel(e1, e2) * well(*w).state_density(e1) * well(*w).collision_frequency();
-	      const int i1 = g1 + well_shift[e1];
-	      const int i2 = g2 + well_shift[e2];
-	      dtemp /= group_state_density_sqrt[i1] * group_state_density_sqrt[i2] 
-		* std::sqrt(thermal_factor(e2 - e1));
-	      kin_mat(i1, i2) = dtemp;
-	    }
-  
-      // diagonal  collisional relaxation contribution
-      for(int e = 0; e < well_size_max; ++e)
-	for(int g = 0; g < well_partition[e].size(); ++g) {
-	  double fac = 0.;
-	  double val = 0.;
-	  for(Git w = well_partition[e][g].begin(); w != well_partition[e][g].end(); ++w) {
-	    dtemp = well(*w).state_density(e);
-	    val += well(*w).kernel(e, e) * dtemp * well(*w).collision_frequency();
-	    fac += dtemp;
-	  }      
-	  const int i = g + well_shift[e];
-	  kin_mat(i, i) = val / fac;
-	}
+      if(is_dist())
+	return dist(i, j);
 
-      // non-diagonal isomerization contribution
-      for(int e = 0; e < well_size_max; ++e)
-	for(int g1 = 0; g1 < well_partition[e].size(); ++g1)
-	  for(int g2 = g1 + 1; g2 < well_partition[e].size(); ++g2) {
-	    dtemp = 0.;
-	    for(int b = 0; b < Model::inner_barrier_size(); ++b) {
-	      const int w1 = Model::inner_connect(b).first;
-	      const int w2 = Model::inner_connect(b).second;
-	      if(e < inner_barrier(b).size() &&
-		 (well_partition[e][g1].find(w1) != well_partition[e][g1].end() && 
-		  well_partition[e][g2].find(w2) != well_partition[e][g2].end() ||
-		  well_partition[e][g1].find(w2) != well_partition[e][g1].end() && 
-		  well_partition[e][g2].find(w1) != well_partition[e][g2].end()))
-	     
-		dtemp += inner_barrier(b).state_number(e);
-	    }
-	    const int i1 = g1 + well_shift[e];
-	    const int i2 = g2 + well_shift[e];
-	    kin_mat(i1, i2) = - dtemp / 2. / M_PI / group_state_density_sqrt[i1] / group_state_density_sqrt[i2];
-	  }
+#endif
 
-      // diagonal isomerization contribution
-      for(int e = 0; e < well_size_max; ++e)
-	for(int g = 0; g < well_partition[e].size(); ++g) {
-	  dtemp = 0.;
-	  // inner barrier
-	  for(int b = 0; b < Model::inner_barrier_size(); ++b) {
-	    const int w1 = Model::inner_connect(b).first;
-	    const int w2 = Model::inner_connect(b).second;
-	    if(e < inner_barrier(b).size() &&
-	       (well_partition[e][g].find(w1) != well_partition[e][g].end() && 
-		well_partition[e][g].find(w2) == well_partition[e][g].end() ||
-		well_partition[e][g].find(w2) != well_partition[e][g].end() && 
-		well_partition[e][g].find(w1) == well_partition[e][g].end()))
-	      dtemp += inner_barrier(b).state_number(e);
-	  }
+      return dense(i, j);
+    }
+  };
 
-	  // outer barrier
-	  for(int b = 0; b < Model::outer_barrier_size(); ++b) {
-	    const int w = Model::outer_connect(b).first;
-	    if(e < outer_barrier(b).size() && well_partition[e][g].find(w) != well_partition[e][g].end())
-	      dtemp += outer_barrier(b).state_number(e);
-	  } 
-	  const int i = g + well_shift[e];
-	  kin_mat(i, i) += dtemp / 2. / M_PI / group_state_density_sqrt[i] / group_state_density_sqrt[i];
-	}
-    }// kinetic matrix settinng
+  // species populations on the time grid from the eigenmodes; coef[l] * eigen_pop(l, w) and
+  // coef[l] * eigen_bim(l, p) are the mode amplitudes; for the bimolecular initial reactant
+  // the populations are integrated over the source time; modes with lambda * t above the
+  // cutoff are saturated and enter through the precomputed constant and linear terms
+  //
+  void time_evolution_output (const Lapack::Vector& eigenval, int eval_size, const std::vector<double>& coef,
+			      const Lapack::Matrix& eigen_pop, const Lapack::Matrix& eigen_bim, bool source,
+			      const std::vector<double>& well_fac, double bim_fac)
+  {
+    const char funame [] = "MasterEquation::time_evolution_output: ";
 
-    /******************************** BIMOLECULAR PRODUCT VECTORS ************************************/
+    double dtemp;
+    
+    const Model::TimeEvolution& te = *Model::time_evolution;
 
-    // bimolecular group contribution
-    std::vector<Lapack::Matrix> bg_mat(well_size_max);
-    std::vector<Lapack::Vector> bg_state_density_sqrt(well_size_max);
+    const int well_size = Model::well_size();
+    const int bim_size  = Model::bimolecular_size();
+    const int spec_size = well_size + bim_size;
+    const int time_size = te.size();
 
-    // bimolecular-to-bimolecular rate
-    Lapack::SymmetricMatrix bb_rate(Model::bimolecular_size());
-    bb_rate = 0.;
+    // relaxation modes cutoff
+    const double xmax = te.tolerance() > 0. ? -std::log(te.tolerance()) : source ? 50. : 100.;
 
-    // bimolecular product vectors
-    Lapack::Matrix global_bim(global_size, Model::bimolecular_size());
-    global_bim = 0.;
+    // time grid
+    std::vector<double> time_val(time_size);
 
-    std::vector<double> capture_state_number(Model::bimolecular_size());
+    time_val[0] = te.start();
 
-    {// bimolecular product vectors setting
-      IO::Marker bim_marker("setting bimolecular product vectors", IO::Marker::ONE_LINE);
+    for(int t = 1; t < time_size; ++t)
+      time_val[t] = time_val[t - 1] * te.step();
 
-      for(int e = 0; e < well_size_max; ++e)
-	if(bimolecular_group[e].size()) {
+    // modes in the order of the decreasing eigenvalue, as they are saturated with time
+    std::multimap<double, int> mode_map;
 
-	  bg_state_density_sqrt[e].resize(bimolecular_group[e].size());
-	  itemp = 0;
-	  for(Git w = bimolecular_group[e].begin(); w != bimolecular_group[e].end(); ++w, ++itemp)
-	    bg_state_density_sqrt[e][itemp] = std::sqrt(well(*w).state_density(e));
+    for(int l = 0; l < eval_size; ++l)
+      mode_map.insert(std::make_pair(-eigenval[l], l));
 
-	  Lapack::SymmetricMatrix bg_km(bimolecular_group[e].size()); //bimolecular group kinetic matrix
-	  bg_km = 0.;
+    std::vector<int>    mode;
+    std::vector<double> lambda;
 
-	  Lapack::Matrix bg_bim(bimolecular_group[e].size(), Model::bimolecular_size());
-	  bg_bim = 0.;
+    for(std::multimap<double, int>::const_iterator i = mode_map.begin(); i != mode_map.end(); ++i) {
+      mode.push_back(i->second);
+      lambda.push_back(eigenval[i->second]);
+    }
 
-	  // inner barrier contribution
-	  for(int b = 0; b < Model::inner_barrier_size(); ++b)
-	    if(e < inner_barrier(b).size()) {
+    // mode amplitudes, the wells and the bimolecular products separately
+    Lapack::Matrix well_amp, bim_amp;
 
-	      const int w1 = Model::inner_connect(b).first;
-	      const int w2 = Model::inner_connect(b).second;
-	
-	      Git ww1 = bimolecular_group[e].find(w1);
-	      Git ww2 = bimolecular_group[e].find(w2);
+    if(well_size) {
+      well_amp.resize(eval_size, well_size);
 
-	      if(ww1 != bimolecular_group[e].end() && ww2 != bimolecular_group[e].end()) {
-	    
-		dtemp = inner_barrier(b).state_number(e);
+      for(int m = 0; m < eval_size; ++m)
+	for(int w = 0; w < well_size; ++w)
+	  well_amp(m, w) = coef[mode[m]] * eigen_pop(mode[m], w);
+    }
 
-		const int i1 = std::distance(bimolecular_group[e].begin(), ww1);
-		const int i2 = std::distance(bimolecular_group[e].begin(), ww2);
+    if(bim_size) {
+      bim_amp.resize(eval_size, bim_size);
 
-		bg_km(i1, i1) += dtemp;
-		bg_km(i2, i2) += dtemp;
-		bg_km(i1, i2) -= dtemp;
-		//IO::log << " "<< i1 << "<-->" << i2;
-	      }
-	    }
-	  //IO::log << "\n";
+      for(int m = 0; m < eval_size; ++m)
+	for(int p = 0; p < bim_size; ++p)
+	  bim_amp(m, p) = coef[mode[m]] * eigen_bim(mode[m], p);
+    }
 
-	  // outer barrier contribution
-	  for(int b = 0; b < Model::outer_barrier_size(); ++b)
-	    if(e < outer_barrier(b).size()){
+    // saturated modes contribution: cnst + lin * t, cumulative over the modes
+    Lapack::Matrix cnst(spec_size, eval_size + 1);
+    Lapack::Matrix  lin(spec_size, eval_size + 1);
 
-	      const int w = Model::outer_connect(b).first;
-	      const int p = Model::outer_connect(b).second;
+    cnst = 0.;
+    lin  = 0.;
 
-	      Git ww = bimolecular_group[e].find(w);
+    for(int m = 0; m < eval_size; ++m) {
+      for(int s = 0; s < spec_size; ++s) {
+	cnst(s, m + 1) = cnst(s, m);
+	lin(s, m + 1)  = lin(s, m);
+      }
 
-	      if(ww != bimolecular_group[e].end()) {
+      if(lambda[m] <= 0.)
+	continue;
 
-		dtemp = outer_barrier(b).state_number(e);
+      for(int w = 0; w < well_size; ++w)
+	if(source)
+	  cnst(w, m + 1) += well_amp(m, w) / lambda[m];
 
-		const int i = std::distance(bimolecular_group[e].begin(), ww);
+      for(int p = 0; p < bim_size; ++p)
+	if(source) {
+	  cnst(well_size + p, m + 1) -= bim_amp(m, p) / lambda[m] / lambda[m];
+	  lin(well_size + p, m + 1)  += bim_amp(m, p) / lambda[m];
+	}
+	else
+	  cnst(well_size + p, m + 1) += bim_amp(m, p) / lambda[m];
+    }
 
-		bg_bim(i, p) += dtemp;
-		bg_km(i, i) += dtemp;
-		capture_state_number[p] += dtemp * thermal_factor(e);
-	      }
-	    }
-      
-	  // kinetic matrix normalization
-	  for(int i1 = 0; i1 < bimolecular_group[e].size(); ++i1)
-	    for(int i2 = i1; i2 < bimolecular_group[e].size(); ++i2)
-	      bg_km(i1, i2) /= bg_state_density_sqrt[e][i1] * bg_state_density_sqrt[e][i2];
+    // first active mode at each time
+    std::vector<int> first_mode(time_size);
+
+    for(int t = 0; t < time_size; ++t) {
+      int ma = 0;
+      while(ma < eval_size && lambda[ma] * time_val[t] > xmax)
+	++ma;
 
-	  // bimolecular channel normalization
-	  for(int i = 0; i < bimolecular_group[e].size(); ++i)
-	    bg_bim.row(i) /= bg_state_density_sqrt[e][i];
+      first_mode[t] = ma;
+    }
 
-	  bg_mat[e] = Lapack::Cholesky(bg_km).invert(bg_bim);
+    // populations: the time grid is processed in blocks, for each block the decay factors of
+    // the modes active in it are formed once and contracted with the amplitudes
+    // in one matrix product per species group
+    //
+    static const int time_block = 64;
 
-	  mtemp = bg_bim.transpose() * bg_mat[e];
+    Lapack::Matrix pop(time_size, spec_size);
 
-	  mtemp *= thermal_factor(e);
+    for(int t0 = 0; t0 < time_size; t0 += time_block) {
+      //
+      const int t1 = t0 + time_block < time_size ? t0 + time_block : time_size;
 
-	  bb_rate += Lapack::SymmetricMatrix(mtemp);
-	}
+      int ma = eval_size;
+      for(int t = t0; t < t1; ++t)
+	if(first_mode[t] < ma)
+	  ma = first_mode[t];
 
-      bb_rate /= 2. * M_PI;
+      const int bt = t1 - t0;
 
-      for(int e = 0; e < well_size_max; ++e)
-	for(int g = 0; g < well_partition[e].size(); ++g) {
-	  const int gi = g + well_shift[e];
+      const int an = eval_size - ma;
 
-	  //direct bimolecular channel contribution
-	  for(int b = 0; b < Model::outer_barrier_size(); ++b)
-	    if(e < outer_barrier(b).size()) {
-	      const int w = Model::outer_connect(b).first;
-	      const int p = Model::outer_connect(b).second;
-	      if(well_partition[e][g].find(w) != well_partition[e][g].end())
-		global_bim(gi, p) += outer_barrier(b).state_number(e);
-	    }
+      for(int t = t0; t < t1; ++t)
+	for(int s = 0; s < spec_size; ++s)
+	  pop(t, s) = cnst(s, first_mode[t]) + lin(s, first_mode[t]) * time_val[t];
 
-	  // isomerization-to-bimolecular group contribution
-	  if(bimolecular_group[e].size()) {
-	    vtemp.resize(bimolecular_group[e].size());
-	    vtemp = 0.;
-	    for(int b = 0; b < Model::inner_barrier_size(); ++b)
-	      if(e < inner_barrier(b).size()) {
+      if(!an)
+	continue;
 
-		const int w1 = Model::inner_connect(b).first;
-		const int w2 = Model::inner_connect(b).second;
-	  
-		Git ww;
+      // decay factors; the modes saturated inside the block enter through the constant terms
+      Lapack::Matrix well_decay(bt, an), bim_decay(bt, an);
 
-		if(((ww = bimolecular_group[e].find(w1)) != bimolecular_group[e].end() && 
-		    well_partition[e][g].find(w2) != well_partition[e][g].end()) ||
-		   ((ww = bimolecular_group[e].find(w2)) != bimolecular_group[e].end() &&
-		    well_partition[e][g].find(w1) != well_partition[e][g].end())) {
-		  itemp = std::distance(bimolecular_group[e].begin(), ww);
-		  vtemp[itemp] += inner_barrier(b).state_number(e);	  
-		}
-	      }
+#pragma omp parallel for default(shared) schedule(static)
 
-	    // normalization
-	    for(int i = 0; i < bimolecular_group[e].size(); ++i)
-	      vtemp[i] /= bg_state_density_sqrt[e][i];
+      for(int t = t0; t < t1; ++t) {
+	//
+	double x, e, g;
 
-	    vtemp = vtemp * bg_mat[e];
+	const double tv = time_val[t];
 
-	    global_bim.row(gi) += vtemp;
+	for(int m = ma; m < eval_size; ++m) {
+	  if(m < first_mode[t]) {
+	    well_decay(t - t0, m - ma) = 0.;
+	    bim_decay(t - t0, m - ma)  = 0.;
+	    continue;
 	  }
 
-	  //collision-to-bimolecular-group contribution
-	  for(int e1 = 0; e1 < e; ++e1) // only higher energies are considered
-	    if(bimolecular_group[e1].size()) {
-	      vtemp.resize(bimolecular_group[e1].size());
-	      vtemp = 0.;
-	  
-	      itemp = 0;
-	      btemp = false;
-	      for(Git w = bimolecular_group[e1].begin(); w != bimolecular_group[e1].end(); ++w, ++itemp) 
-		if(well_partition[e][g].find(*w) != well_partition[e][g].end()) {
-		  dtemp = well(*w).kernel(e, e1);
-		  if(dtemp != 0.) {
-		    btemp = true;
-		    vtemp[itemp] -=  dtemp * well(*w).state_density(e) / bg_state_density_sqrt[e1][itemp] * well(*w).collision_frequency();
-		  }
-		}
-	     
-	      if(btemp) {
-		vtemp = vtemp * bg_mat[e1];
-		vtemp *= 2. * M_PI;
-		global_bim.row(gi) += vtemp;
-	      }
-	    }
-	  // capture number of states contribution
-	  for(int p = 0; p < Model::bimolecular_size(); ++p)
-	    capture_state_number[p] += global_bim(gi, p) * thermal_factor(e);
+	  x = lambda[m] * tv;
+	  e = std::exp(-x);
+	  g = (1. - e) / lambda[m];
 
-	  // normalization
-	  global_bim.row(gi) *= thermal_factor(e) / 2. / M_PI / group_weight_sqrt[gi];
+	  if(source) {
+	    well_decay(t - t0, m - ma) = g;
+	    bim_decay(t - t0, m - ma)  = (tv - g) / lambda[m];
+	  }
+	  else {
+	    well_decay(t - t0, m - ma) = e;
+	    bim_decay(t - t0, m - ma)  = g;
+	  }
 	}
+      }
 
-    }// bimolecular product vectors setting
+      if(well_size) {
+	Lapack::Matrix amp(an, well_size);
 
-    // checking kinetic matrix and bimolecular product vectors for consistency
-    {
-      IO::Marker check_marker("checking kinetic matrix and bimolecular product vectors");
+	for(int m = ma; m < eval_size; ++m)
+	  for(int w = 0; w < well_size; ++w)
+	    amp(m - ma, w) = well_amp(m, w);
 
-      for(int e1 = 0; e1 < well_size_max; ++e1)
-	for(int g1 = 0; g1 < well_partition[e1].size(); ++g1) {
-	  const int i1 = g1 + well_shift[e1];
+	Lapack::Matrix val = well_decay * amp;
 
-	  dtemp = 0.;
-	  for(int e2 = 0; e2 < well_size_max; ++e2)
-	    for(int g2 = 0; g2 < well_partition[e2].size(); ++g2) {
-	      const int i2 = g2 + well_shift[e2];
-	      dtemp += kin_mat(i1, i2)  * group_weight_sqrt[i2];
-	    }
+	for(int t = t0; t < t1; ++t)
+	  for(int w = 0; w < well_size; ++w)
+	    pop(t, w) += val(t - t0, w);
+      }
 
-	  for(int p = 0; p < Model::bimolecular_size(); ++p)
-	    dtemp -= global_bim(i1, p);
+      if(bim_size) {
+	Lapack::Matrix amp(an, bim_size);
 
-	  dtemp /= kin_mat(i1, i1) * group_weight_sqrt[i1];
+	for(int m = ma; m < eval_size; ++m)
+	  for(int p = 0; p < bim_size; ++p)
+	    amp(m - ma, p) = bim_amp(m, p);
 
-	  if(dtemp > machine_eps || dtemp < -machine_eps)
-	    IO::log << IO::log_offset << funame 
-		    << "WARNING: kinetic matrix and bimolecular product vectors are not consistent:"
-		    << " e = " << std::setw(5) << e1 
-		    << " g = " << std::setw(5) << g1 
-		    << " error = " << std::setw(13) << dtemp
-		    << "\n";
+	Lapack::Matrix val = bim_decay * amp;
 
-	}
+	for(int t = t0; t < t1; ++t)
+	  for(int p = 0; p < bim_size; ++p)
+	    pop(t, well_size + p) += val(t - t0, p);
+      }
     }
 
-    /******************** DIAGONALIZING THE GLOBAL KINETIC RELAXATION MATRIX ********************/
+    // normalization
+    for(int t = 0; t < time_size; ++t) {
+      for(int w = 0; w < well_size; ++w)
+	pop(t, w) *= well_fac[w];
 
-    Lapack::Vector eigenval;
-    Lapack::Matrix eigen_global(global_size);
+      for(int p = well_size; p < spec_size; ++p)
+	pop(t, p) *= bim_fac;
+    }
 
-    {
-      IO::Marker solve_marker("diagonalizing global relaxation matrix", IO::Marker::ONE_LINE);
+    std::ofstream& out = Model::time_evolution->out;
 
-      eigenval = kin_mat.eigenvalues(&eigen_global);
-      eigen_global = eigen_global.transpose();
-    }
+    // columnar binary output
+    //
+    if(te.binary()) {
+      //
+      if(!out.tellp()) {
+	out.write((const char*)&spec_size, sizeof(int));
 
-    /*
-      for(int i = 0; i < global_size; ++i)
-      for(int j = 0; j < global_size; ++j) {
-      double* p = &eigen_global(i, j);
-      if(*p < machine_eps && *p > -machine_eps)
-      *p = 0.;
+	for(int s = 0; s < spec_size; ++s) {
+	  const std::string& name = s < well_size ? Model::well(s).name() : Model::bimolecular(s - well_size).name();
+	  const int len = name.size();
+
+	  out.write((const char*)&len, sizeof(int));
+	  out.write(name.data(), len);
+	}
       }
-    */
 
-    // eigenvector to bimolecular vector projection
-    Lapack::Matrix eigen_bim = eigen_global * global_bim;
+      switch(pressure_unit) {
+      case BAR:
+	dtemp = pressure() / Phys_const::bar;
+	break;
+      case TORR:
+	dtemp = pressure() / Phys_const::tor;
+	break;
+      case ATM:
+	dtemp = pressure() / Phys_const::atm;
+	break;
+      }
+      out.write((const char*)&dtemp, sizeof(double));
 
-    const double min_relax_eval = eigenval[Model::well_size()];
-    const double max_relax_eval = eigenval.back();
+      dtemp = temperature() / Phys_const::kelv;
+      out.write((const char*)&dtemp, sizeof(double));
 
-    //IO::log << IO::log_offset << "minimal relaxation eigenvalue / collision frequency = "
-    //<< min_relax_eval / collision_frequency() << "\n";
-    //IO::log << IO::log_offset << "maximal relaxation eigenvalue / collision frequency = "
-    //<< max_relax_eval / collision_frequency() << "\n";
+      out.write((const char*)&time_size, sizeof(int));
 
-    itemp = 0;
-    while(eigenval[itemp] / max_relax_eval < machine_eps) {
-      IO::log << IO::log_offset << "WARNING: " << itemp << "-th eigenvalue is too small\n"; 
-      //<< eigenval[itemp] / collision_frequency() << " is too small\n";
-      eigenval[itemp] = 0.;
-      ++itemp;
-    }
+      for(int t = 0; t < time_size; ++t) {
+	dtemp = time_val[t] * Phys_const::herz;
+	out.write((const char*)&dtemp, sizeof(double));
+      }
 
-    // eigenvector projection on the chemical subspace
-    Lapack::Matrix eigen_pop(global_size, Model::well_size());
-    eigen_pop = 0.;
-  
-    for(int e = 0; e < well_size_max; ++e) {
-      const double tf_sqrt = std::sqrt(thermal_factor(e));
-      for(int g = 0; g < well_partition[e].size(); ++g) {
-	const int gi = g + well_shift[e];
-	for(Git i = well_partition[e][g].begin(); i != well_partition[e][g].end(); ++i) {
-	  dtemp = well(*i).state_density(e) * tf_sqrt / group_state_density_sqrt[gi];
-	  for(int l = 0; l < global_size; ++l)
-	    eigen_pop(l, *i) += eigen_global(l, gi) * dtemp;
-	}
+      out.write((const char*)(const double*)pop, sizeof(double) * time_size * spec_size);
+
+      if(!out) {
+	std::cerr << funame << "time evolution output failed\n";
+	throw Error::File();
       }
+
+      return;
     }
 
-    for(int w = 0; w < Model::well_size(); ++w)
-      eigen_pop.column(w) /= well(w).weight_sqrt();
-  
-    for(int w = 0; w < Model::well_size(); ++w)
-      for(int l = 0; l < global_size; ++l) {
-	dtemp = eigen_pop(l, w);
-	if(dtemp < 1.e-12 && dtemp > -1.e-12)
-	  eigen_pop(l, w) = 0.;
-      }
+    // text output
+    //
+    out << "Pressure = ";
+    switch(pressure_unit) {
+    case BAR:
+      out << pressure() / Phys_const::bar << " bar";
+      break;
+    case TORR:
+      out << pressure() / Phys_const::tor << " torr";
+      break;
+    case ATM:
+      out << pressure() / Phys_const::atm << " atm";
+      break;
+    }
+    out << "\t Temperature = " << temperature() / Phys_const::kelv << " K\n\n";
 
-    // eigenvector projection on the relaxation subspace
-    std::vector<double> relaxation_projection(Model::well_size());
-    for(int l = 0; l < Model::well_size(); ++l)
-      relaxation_projection[l] = 1. - vdot(eigen_pop.row(l));
+    out << std::setw(13) << "time, sec";
+    for(int w = 0; w < well_size; ++w)
+      out << std::setw(13) << Model::well(w).name();
+    
+    for(int p = 0; p < bim_size; ++p)
+      out << std::setw(13) << Model::bimolecular(p).name();
 
-    /************************************* EIGENVECTOR OUTPUT *****************************************/
+    out << "\n";
 
-    IO::log << std::setprecision(3)
-	    << IO::log_offset << "eigenvector populations normalized:\n"
-	    << IO::log_offset 
-	    << std::setw(5)  << "L"
-	    << std::setw(10) << "*R"
-	    << std::setw(10) << "*P";
-    for(int w = 0; w < Model::well_size(); ++w)
-      IO::log << std::setw(10) << Model::well(w).name();  
-    IO::log << "\n";
+    for(int t = 0; t < time_size; ++t) {
+      out << std::setw(13) << time_val[t] * Phys_const::herz;
 
-    // maximal population
-    for(int l = 0; l < Model::well_size(); ++l) {
+      for(int s = 0; s < spec_size; ++s)
+	out << std::setw(13) << pop(t, s);
 
-      double pos_pop = 0.;
-      double neg_pop = 0.;
-      for(int w = 0; w < Model::well_size(); ++w) {
-	dtemp = eigen_pop(l, w) * well(w).weight_sqrt();
-	if(dtemp > 0.)
-	  pos_pop += dtemp;
-	if(dtemp < 0.)
-	  neg_pop += dtemp;
-      }
-      double max_pop = pos_pop > -neg_pop ? pos_pop : neg_pop;
-    
-      IO::log << IO::log_offset
-	      << std::setw(5)  << l
-	      << std::setw(10) << eigenval[l] / min_relax_eval
-	      << std::setw(10) << relaxation_projection[l]; 
-      for(int w = 0; w < Model::well_size(); ++w) {
-	dtemp = eigen_pop(l, w) * well(w).weight_sqrt() / max_pop;
-	IO::log << std::setw(10);
-	if(dtemp > .01 || dtemp < -.01)
-	  IO::log << dtemp;
-	else
-	  IO::log << 0;
-      }
-      IO::log << "\n";
+      out << "\n";
     }
 
-    IO::log << IO::log_offset << std::setw(5) << "*R" 
-	    << " - eigenvalue over the relaxation limit\n"
-	    << IO::log_offset << std::setw(5) << "*P" 
-	    << " - eigenvector projection squared on the relaxation subspace\n"
-	    << IO::log_offset << "eigenvector projections:\n"
-	    << IO::log_offset 
-	    << std::setw(5)  << "L"
-	    << std::setw(10) << "*Q"
-	    << std::setw(10) << "*P";
+    out << "\n";
+  }
+}
 
-    for(int w = 0; w < Model::well_size(); ++w)
-      IO::log << std::setw(10) << Model::well(w).name();  
-    IO::log << "\n";
+void MasterEquation::banded_diagonalization_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags)
+  
+{
+  direct_diagonalization_method(rate_data, well_partition, flags | BAND_STORAGE);
+}
+
+namespace {
+  //
+  // relaxation modes part of the given columns of the eigenvector matrix, one row per kept mode,
+  // optionally weighted; the contractions over the relaxation modes for all the column pairs
+  // are then the transpose products
+  //
+  Lapack::Matrix relaxation_columns (const Lapack::Matrix& m, int chem_size, const std::vector<int>& mode,
+				     const std::vector<int>& col, const double* weight = 0)
+  {
+    Lapack::Matrix res(mode.size(), col.size());
+
+    for(int c = 0; c < col.size(); ++c)
+      for(int r = 0; r < mode.size(); ++r)
+	res(r, c) = m(chem_size + mode[r], col[c]) * (weight ? weight[mode[r]] : 1.);
+
+    return res;
+  }
+
+  // grid columns of the outer barrier energies
+  std::vector<int> barrier_columns (int b, const std::vector<int>& well_shift)
+  {
+    using namespace MasterEquation;
+    
+    std::vector<int> res(outer_barrier(b).size());
+    for(int e = 0; e < res.size(); ++e)
+      res[e] = e + well_shift[Model::outer_connect(b).first];
+
+    return res;
+  }
+}
+
+void MasterEquation::clear_grid_start () { grid_start.clear(); }
+
+void MasterEquation::clear_reduced_basis () { reduced_basis.clear(); }
+
+void MasterEquation::clear_resident_species () { resident_pool.clear(); }
+
+namespace MasterEquation {
+
+  void set_grid_start (GridStart& start, const Lapack::Matrix& eigen_global, int num, const std::vector<int>& well_shift)
+  {
+    start.energy_reference = energy_reference();
+    start.energy_step      = energy_step();
+    start.well_shift       = well_shift;
 
-    for(int l = 0; l < Model::well_size(); ++l) {
-      IO::log << IO::log_offset
-	      << std::setw(5)  << l
-	      << std::setw(10) << eigenval[l] / collision_frequency_min
-	      << std::setw(10) << relaxation_projection[l]; 
-      for(int w = 0; w < Model::well_size(); ++w)
-	IO::log << std::setw(10) << eigen_pop(l,w);
-      IO::log << "\n";
-    }
-  
-    IO::log << IO::log_offset 
-	    << std::setw(5) << "*Z"
-	    << std::setw(10) << "---"
-	    << std::setw(10) << "---";
+    start.well_size.resize(Model::well_size());
     for(int w = 0; w < Model::well_size(); ++w)
-      IO::log << std::setw(10) << well(w).weight_sqrt();
-    IO::log << "\n";
+      start.well_size[w] = well(w).size();
 
-    IO::log << IO::log_offset << std::setw(5) << "*Q" 
-	    << " - eigenvalue over the collision frequency\n"
-	    << IO::log_offset << std::setw(5) << "*P" 
-	    << " - eigenvector projection squared on the relaxation subspace\n"
-	    << IO::log_offset << std::setw(5) << "*Z" 
-	    << " - well partition function square root\n"
-	    << std::setprecision(6);
-  
+    start.population = Lapack::Matrix(eigen_global.size2(), num);
+    for(int w = 0; w < Model::well_size(); ++w)
+      for(int i = 0; i < well(w).size(); ++i)
+	for(int l = 0; l < num; ++l)
+	  start.population(i + well_shift[w], l) = eigen_global(l, i + well_shift[w]) * well(w).boltzman_sqrt_inv(i);
+  }
 
-    /********************************** CHEMICAL SUBSPACE DIMENSION ****************************************/
+  void save_grid_start (const Lapack::Matrix& eigen_global, int num, const std::vector<int>& well_shift)
+  {
+    set_grid_start(grid_start[std::make_pair(temperature(), pressure())], eigen_global, num, well_shift);
+  }
 
-    if(_default_chem_size >= 0) 
-      itemp = _default_chem_size;
-    else if(default_partition.size())
-      itemp = default_partition.size();
-    else if(chemical_threshold > 1.) {   
-      for(itemp = 0; itemp < Model::well_size(); ++itemp)
-	if(eigenval[itemp] > 0. && min_relax_eval / eigenval[itemp]  < chemical_threshold)
-	  break;
-    }
-    else if(chemical_threshold < 1. && chemical_threshold > 0.) {
-      for(itemp = 0; itemp < Model::well_size(); ++itemp)
-	if(relaxation_projection[itemp] > chemical_threshold)
-	  break;
-    }   
-    else if(chemical_threshold < -1. ) {
-      for(itemp = Model::well_size(); itemp > 0; --itemp)
-	if(eigenval[itemp - 1] == 0. || eigenval[itemp] / eigenval[itemp - 1] > - chemical_threshold)
-	  break;
-    }
-    else
-      itemp = Model::well_size();
-	
-    const int chem_size = itemp;
+  // the eigenvectors on the previous energy grid linearly interpolated onto the current
+  // grid, written to the columns starting from the offset
+  void interpolate_grid_start (const GridStart& prev, const std::vector<int>& well_shift, int num,
+			       Lapack::Matrix& res, int offset)
+  {
+    for(int w = 0; w < Model::well_size(); ++w) {
+      const int prev_size  = prev.well_size[w];
+      const int prev_shift = prev.well_shift[w];
 
-    if(chem_size != Model::well_size())
-      IO::log << IO::log_offset << "dimension of the chemical subspace = " << chem_size << "\n";
+      for(int i = 0; i < well(w).size(); ++i) {
+	// the energy on the previous grid
+	const double x = (prev.energy_reference - energy_reference() + (double)i * energy_step()) / prev.energy_step;
 
-    /*** COLLISIONAL RELAXATION EIGENVALUES AND EIGENVECTORS AND BIMOLECULAR-TO-BIMOLECULAR RATES ***/
+	int    i0 = (int)std::floor(x);
+	double f  = x - (double)i0;
 
-    const int relax_size = global_size - chem_size;
-    Lapack::Vector relax_lave(relax_size);
-    for(int r = 0; r < relax_size; ++r) {
-      itemp = r + chem_size;
-      relax_lave[r] = 1. / eigenval[itemp];
-    }
+	if(i0 < 0) {
+	  i0 = 0;
+	  f  = 0.;
+	}
+	if(i0 >= prev_size - 1) {
+	  i0 = prev_size - 1;
+	  f  = 0.;
+	}
 
-    for(int i = 0; i < Model::bimolecular_size(); ++i)
-      for(int j = i; j < Model::bimolecular_size(); ++j)
-	bb_rate(i, j) += triple_product(&eigen_bim(chem_size, i), &eigen_bim(chem_size, j), 
-					relax_lave, relax_size);
+	for(int l = 0; l < num; ++l) {
+	  double dtemp = prev.population(i0 + prev_shift, l);
+	  if(f > 0.)
+	    dtemp += f * (prev.population(i0 + 1 + prev_shift, l) - dtemp);
 
-    // kappa-matrix
-    IO::log << std::setprecision(2)
-	    << IO::log_offset << "isomers-to-bimolecular equilibrium coefficients (kappa matrix):\n";
-    IO::log << IO::log_offset << std::setw(5) << "W\\P";
-    for(int p = 0; p < Model::bimolecular_size(); ++p)
-      IO::log << std::setw(9) << Model::bimolecular(p).name();
-    IO::log << "\n";
-   
-    for(int w = 0; w < Model::well_size(); ++w) {
-      IO::log << IO::log_offset << std::setw(5) << Model::well(w).name();  
-      for(int p = 0; p < Model::bimolecular_size(); ++p) {
-	dtemp = triple_product(&eigen_bim(chem_size, p), &eigen_pop(chem_size, w), relax_lave, relax_size) 
-	  / well(w).weight_sqrt();
-	IO::log << std::setw(9);
-	if(dtemp < 0.05 && dtemp > -0.05)
-	  IO::log << "0"; 
-	else
-	  IO::log << dtemp; 
+	  res(i + well_shift[w], l + offset) = dtemp * well(w).boltzman_sqrt(i);
+	}
       }
-      IO::log << "\n";
     }
-    IO::log << std::setprecision(6);
+  }
 
-    // bimolecular rate units
-    const double bru = Phys_const::cm * Phys_const::cm * Phys_const::cm * Phys_const::herz;
+  // global index to the index of the wells grids interleaved by energy, in which the well kernels
+  // are banded and the barriers couple the neighbouring elements; returns the band size
+  int interleaved_band_index (const std::vector<int>& well_shift, int global_size, std::vector<int>& band_index)
+  {
+    int well_size_max = 0;
+    for(int w = 0; w < Model::well_size(); ++w)
+      if(well(w).size() > well_size_max)
+	well_size_max = well(w).size();
 
-    // bimolecular rate constants
-    for(int i = 0; i < Model::bimolecular_size(); ++i) 
-      if(bimolecular(i).weight() > 0.)
-	for(int j = 0; j < Model::bimolecular_size(); ++j) {
-	  dtemp = bb_rate(i, j) * energy_step();
-	  // bimolecular reactant loss
-	  if(i == j) {
-	    dtemp = -dtemp;
-	    dtemp += capture_state_number[i] / 2. / M_PI * energy_step();
-	    /*
-	      for(int b = 0; b < Model::outer_barrier_size(); ++b)
-	      if(Model::outer_connect(b).second == i)
-	      dtemp += temperature() / 2. / M_PI * outer_barrier(b).weight();
-	    */	  
-	  }
-	  dtemp /= bimolecular(i).weight() * bru;
-	  rate_data[std::make_pair(Model::well_size() + i, Model::well_size() + j)] = dtemp; 	
-	}
+    band_index.resize(global_size);
 
-    /*************************************** BOUND SPECIES *******************************************/
+    int itemp = 0;
+    for(int i = 0; i < well_size_max; ++i)
+      for(int w = 0; w < Model::well_size(); ++w)
+	if(i < well(w).size())
+	  band_index[i + well_shift[w]] = itemp++;
 
-    std::vector<int>  group_index;
-    Lapack::Matrix m_direct;
-    std::vector<double>      weight;
-    std::vector<double> real_weight;
+    int band_size = Model::well_size();
+    for(int w = 0; w < Model::well_size(); ++w)
+      for(int i = 0; i < well(w).size(); ++i) {
+	itemp = i + well(w).kernel_bandwidth - 1;
+	if(itemp >= well(w).size())
+	  itemp = well(w).size() - 1;
 
-    if(chem_size) { // bound species
+	itemp = band_index[itemp + well_shift[w]] - band_index[i + well_shift[w]] + 1;
+	if(itemp > band_size)
+	  band_size = itemp;
+      }
 
-      // projection of the chemical eigenvectors onto the thermal subspace
-      Lapack::Matrix pop_chem(Model::well_size(), chem_size);
-      for(int l = 0; l < chem_size; ++l)
-	pop_chem.column(l) = eigen_pop.row(l);
+    if(band_size > global_size)
+      band_size = global_size;
 
-      // partitioning wells into equilibrated groups
-      if(default_partition.size()) {
-	// default reduction scheme
-	thermal_well_partition = default_partition;
+    return band_size;
+  }
 
-	IO::log << IO::log_offset << "using default reduction scheme, projection error = "
-		<< (double)chem_size - thermal_well_partition.projection(pop_chem) << "\n";
-    
-	// convert chemical eigenvectors in the new basis
-	pop_chem = thermal_well_partition.basis().transpose() * pop_chem;
-      }
-      else if(chem_size == Model::well_size()) {
-	// no partitioning
-	thermal_well_partition.resize(Model::well_size());
-	for(int w = 0; w < Model::well_size(); ++w)
-	  thermal_well_partition[w].insert(w);
+  // the previous energy grid eigenvectors of the temperature and pressure linearly interpolated
+  // onto the current grid, the missing ones being the thermal-weighted pseudorandom vectors;
+  // not initialized if there are none
+  Lapack::Matrix grid_start_subspace (const std::vector<int>& well_shift, int global_size, int num)
+  {
+    Lapack::Matrix res;
 
-	IO::log << IO::log_offset << "projection error = "
-		<< (double)chem_size - thermal_well_partition.projection(pop_chem) << "\n";
-      }
-      else {
-	// well partitioning
-	Group bimolecular_group;
-	dtemp = well_partition_method(pop_chem, thermal_well_partition, bimolecular_group, std::vector<double>());
+    std::map<std::pair<double, double>, GridStart>::const_iterator it =
+      grid_start.find(std::make_pair(temperature(), pressure()));
 
-	// convert chemical eigenvectors in the new basis
-	pop_chem = thermal_well_partition.basis().transpose() * pop_chem;
-      }
+    if(it == grid_start.end() || it->second.well_size.size() != Model::well_size())
+      return res;
 
-      group_index = thermal_well_partition.group_index();
-      weight      = thermal_well_partition.weight();
-      real_weight = thermal_well_partition.real_weight();
+    const GridStart& prev = it->second;
 
-      // output
-      if(chem_size != Model::well_size()) {
-	IO::log << IO::log_offset << "species:\n" 
-		<< IO::log_offset << std::setw(2) << "#"  << std::setw(15) 
-		<< "assigned name" << IO::first_offset
-		<< "group\n";
-	for(Pit g = thermal_well_partition.begin(); g != thermal_well_partition.end(); ++g) {
-	  itemp = g - thermal_well_partition.begin();
-	  IO::log << IO::log_offset << std::setw(2) << itemp << std::setw(15) 
-		  << Model::well(group_index[itemp]).name() << IO::first_offset;
-	  for(Git w = g->begin(); w != g->end(); ++w) {
-	    if(w != g->begin())
-	      IO::log << "+";
-	    IO::log << Model::well(*w).name();
-	  }
-	  IO::log << "\n";
-	}
-      }
+    const int prev_num = prev.population.size2() < num ? prev.population.size2() : num;
 
-      m_direct = pop_chem;
-      Lapack::Matrix m_inverse = m_direct.invert();
+    res.resize(global_size, num);
 
-      // well-to-well rate coefficients
-      for(int i = 0; i < chem_size; ++i)
-	for(int j = 0; j < chem_size; ++j) {
-	  dtemp = 0.;
-	  for(int l = 0; l < chem_size; ++l)
-	    dtemp += m_direct(j, l) * m_inverse(l, i) * eigenval[l]; 
-	  dtemp *= std::sqrt(weight[i] * weight[j]) * energy_step() / real_weight[i] / Phys_const::herz;
-	  if(i != j) 
-	    dtemp = -dtemp;
-	  rate_data[std::make_pair(group_index[i], group_index[j])] = dtemp; 	
-	}
+    interpolate_grid_start(prev, well_shift, prev_num, res, 0);
 
-      // well-to-bimolecular rate coefficients
-      for(int w = 0; w < chem_size; ++w)
-	for(int p = 0; p < Model::bimolecular_size(); ++p) {
-	  dtemp = vdot(m_inverse.column(w), &eigen_bim(0, p))
-	    * std::sqrt(weight[w]) * energy_step() / real_weight[w] / Phys_const::herz;
-	  rate_data[std::make_pair(group_index[w], Model::well_size() + p)] = dtemp;
+    unsigned long seed = 12345;
+
+    for(int w = 0; w < Model::well_size(); ++w)
+      for(int i = 0; i < well(w).size(); ++i)
+	for(int l = prev_num; l < num; ++l) {
+	  seed = (seed * 1103515245UL + 12345UL) % 2147483648UL;
+	  res(i + well_shift[w], l) = ((double)seed / 2147483648. - 0.5) * well(w).boltzman_sqrt(i);
 	}
-  
-      // bimolecular-to-well rate coefficients
-      for(int p = 0; p < Model::bimolecular_size(); ++p) 
-	if(bimolecular(p).weight() > 0.)
-	  for(int w = 0; w < chem_size; ++w) {
-	    dtemp = vdot(m_direct.row(w), &eigen_bim(0, p))
-	      * std::sqrt(weight[w]) * energy_step() / bimolecular(p).weight() / bru;
-	    rate_data[std::make_pair(Model::well_size() + p, group_index[w])] = dtemp;
-	  }
-    }// bound species  
+
+    return res;
   }
-}
 
-/********************************************************************************************
- ************ THE DIRECT DIAGONALIZATION OF THE GLOBAL KINETIC RELAXATION MATRIX ************
- ********************************************************************************************/
+  // the snapshots eigenvectors interpolated onto the current energy grid; not initialized
+  // if there are none
+  Lapack::Matrix reduced_basis_span (const std::vector<int>& well_shift, int global_size)
+  {
+    Lapack::Matrix res;
+
+    int num = 0;
+    for(int s = 0; s < reduced_basis.size(); ++s)
+      if(reduced_basis[s].well_size.size() == Model::well_size())
+	num += reduced_basis[s].population.size2();
+
+    if(!num || num > global_size)
+      return res;
+
+    res.resize(global_size, num);
+
+    num = 0;
+    for(int s = 0; s < reduced_basis.size(); ++s)
+      if(reduced_basis[s].well_size.size() == Model::well_size()) {
+	interpolate_grid_start(reduced_basis[s], well_shift, reduced_basis[s].population.size2(), res, num);
+	num += reduced_basis[s].population.size2();
+      }
+
+    return res;
+  }
+}
 
 void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags)
   
@@ -3425,20 +6287,22 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
   //<< " 1/sec\n";
 
   if(evec_out.is_open()) {
-    evec_out << "Pressure = ";
+    std::ostringstream title;
+    title << "Pressure = ";
     switch(pressure_unit) {
     case BAR:
-      evec_out << pressure() / Phys_const::bar << " bar";
+      title << pressure() / Phys_const::bar << " bar";
       break;
     case TORR:
-      evec_out << pressure() / Phys_const::tor << " torr";
+      title << pressure() / Phys_const::tor << " torr";
       break;
     case ATM:
-      evec_out << pressure() / Phys_const::atm << " atm";
+      title << pressure() / Phys_const::atm << " atm";
       break;
     }
-    evec_out << "\t Temperature = "
-	     << temperature() / Phys_const::kelv << " K\n";
+    title << "\t Temperature = "
+	  << temperature() / Phys_const::kelv << " K\n";
+    IO::put_text(evec_out, title.str());
   }
 
   rate_data.clear();
@@ -3467,42 +6331,112 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
   //  if(global_size >= 
   IO::log << IO::log_offset << "global relaxation matrix dimension = " << global_size << "\n";
 
-  for(int w = 0; w < Model::well_size(); ++w)
-    if(!w || well(w).size() > itemp)
-      itemp = well(w).size();
-  
-  const int well_size_max = itemp;
-    
-  /********************************* SETTING GLOBAL MATRICES *********************************/
+  for(int w = 0; w < Model::well_size(); ++w)
+    if(!w || well(w).size() > itemp)
+      itemp = well(w).size();
+  
+  const int well_size_max = itemp;
+
+  const bool banded = flags & BAND_STORAGE;
+
+  if(banded) {
+    //
+    if(Model::time_evolution || ped_out.is_open() || context().hot_energy_size
+       || (Model::escape_size() && Model::bimolecular_size())) {
+      std::cerr << funame << "band storage: the full relaxation spectrum is needed for the time evolution, "
+	"product energy distributions, hot energies, and bimolecular-to-escape rates\n";
+      throw Error::Init();
+    }
+
+    for(int w = 0; w < Model::well_size(); ++w)
+      if(well(w).radiation()) {
+	std::cerr << funame << "band storage: radiational transitions are not supported\n";
+	throw Error::Init();
+      }
+  }
+    
+  /********************************* SETTING GLOBAL MATRICES *********************************/
+
+  // kinetic relaxation matrix
+  GlobalMatrix kin_mat;
+  if(banded) {
+    //
+    const int band_size = interleaved_band_index(well_shift, global_size, kin_mat.band_index);
+
+    IO::log << IO::log_offset << "relaxation matrix band size = " << band_size << "\n";
+
+    kin_mat.band.resize(global_size, band_size);
+    kin_mat.band = 0.;
+  }
+#ifdef WITH_SCALAPACK
+  else if(Scalapack::size() > 1) {
+    //
+    IO::log << IO::log_offset << "relaxation matrix distributed over " << Scalapack::size() << " processes\n";
+
+    kin_mat.dist.resize(global_size);
+    kin_mat.dist = 0.;
+  }
+#endif
+  else {
+    kin_mat.dense.resize(global_size);
+    kin_mat.dense = 0.;
+  }
+
+  Lapack::Matrix global_bim;    // bimolecular product vectors
+  Lapack::Matrix global_pop;    // Boltzmann distributions
+  Lapack::Matrix global_escape; // well escape vectors
 
-  // kinetic relaxation matrix
-  Lapack::SymmetricMatrix kin_mat(global_size); // kinetic relaxation matrix
-  kin_mat = 0.;
+  // the vectors depend only on the temperature and are reused over the pressure list
+  const bool vec_cached = incremental_pressure && context().global_pop.isinit()
+    && context().global_pop.size1() == global_size;
 
-  // bimolecular product vectors
-  Lapack::Matrix global_bim;
-  if(Model::bimolecular_size()) {
-    global_bim.resize(global_size,  Model::bimolecular_size());
-    global_bim = 0.;
+  if(vec_cached) {
+    //
+    global_bim    = context().global_bim;
+    global_pop    = context().global_pop;
+    global_escape = context().global_escape;
   }
+  else {
+    //
+    if(Model::bimolecular_size()) {
+      global_bim.resize(global_size,  Model::bimolecular_size());
+      global_bim = 0.;
+    }
 
-  // Boltzmann distributions
-  Lapack::Matrix global_pop(global_size, Model::well_size());
-  global_pop = 0.;
+    global_pop.resize(global_size, Model::well_size());
+    global_pop = 0.;
 
-  // well escape vectors
-  Lapack::Matrix global_escape;
-  if(Model::escape_size()) {
-    global_escape.resize(global_size, Model::escape_size());
-    global_escape = 0.;
+    if(Model::escape_size()) {
+      global_escape.resize(global_size, Model::escape_size());
+      global_escape = 0.;
+    }
   }
 
   {
     IO::Marker set_marker("setting global matrices", IO::Marker::ONE_LINE);
 
+    // the pressure independent parts of the kinetic matrix are reused over the pressure list:
+    // kin_mat = kin_reactive + pressure / kin_pressure * kin_collision
+    Context& cx = context();
+
+    const bool cache = incremental_pressure && !banded && !kin_mat.is_dist();
+
+    const bool cached = cache && cx.kin_reactive.isinit() && cx.kin_reactive.size() == global_size;
+
+    if(cached)
+      //
+      kin_mat.dense = cx.kin_reactive.copy();
+
+    if(cache && !cached) {
+      //
+      cx.kin_collision.resize(global_size);
+      cx.kin_collision = 0.;
+      cx.kin_pressure = pressure();
+    }
+    
     // kin_mat initialization
     // nondiagonal isomerization contribution
-    for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+    for(int b = 0; b < Model::inner_barrier_size() && !cached; ++b) {
       int w1 = Model::inner_connect(b).first;
       int w2 = Model::inner_connect(b).second;    
       for(int i = 0; i < inner_barrier(b).size(); ++i)
@@ -3511,9 +6445,9 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
     }
 
     // diagonal isomerization contribution
-    for(int w = 0; w < Model::well_size(); ++w) {
-      for(int i = 0; i < cum_stat_num[w].size(); ++i)
-	kin_mat(i + well_shift[w], i + well_shift[w]) = cum_stat_num[w][i] / 2. / M_PI
+    for(int w = 0; w < Model::well_size() && !cached; ++w) {
+      for(int i = 0; i < context().cum_stat_num[w].size(); ++i)
+	kin_mat(i + well_shift[w], i + well_shift[w]) = context().cum_stat_num[w][i] / 2. / M_PI
 	  / well(w).state_density(i);
       if(Model::well(w).escape())
 	for(int i = 0; i < well(w).size(); ++i) {
@@ -3526,42 +6460,104 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 	}
     }
 
-    // collision relaxation contribution 
-    for(int w = 0; w < Model::well_size(); ++w) {
-      for(int i = 0; i < well(w).size(); ++i) {
-	for(int j = i; j < well(w).size(); ++j) 
-	  kin_mat(i + well_shift[w], j + well_shift[w]) +=  well(w).collision_frequency() * well(w).kernel(i, j) 
-	    * well(w).boltzman_sqrt(i) / well(w).boltzman_sqrt(j);
+    // collision relaxation contribution: the rows inside the kernel band are
+    // independent and are written directly into the eigensolver storage
+    for(int w = 0; w < Model::well_size() && !cached; ++w) {
+      const Well&  cw    = well(w);
+      const int    ws    = well_shift[w];
+      const double cfreq = cw.collision_frequency();
+
+      const Lapack::StridedView<const double> kern = cw.kernel().unchecked();
+
+      const double* bs  = cw.boltzman_sqrt();
+      const double* bsi = cw.boltzman_sqrt_inv();
+
+      Lapack::PackedView<double> kc, kd;
+      if(cache)
+	kc = cx.kin_collision.unchecked();
+      else if(!kin_mat.is_band() && !kin_mat.is_dist())
+	kd = kin_mat.dense.unchecked();
+
+#pragma omp parallel for default(shared) schedule(dynamic, 16)
+
+      for(int i = 0; i < cw.size(); ++i) {
+	int jmax = cw.size();
+	if(i + cw.kernel_bandwidth < jmax)
+	  jmax = i + cw.kernel_bandwidth;
+
+	// dense storage is written through the unchecked views
+	if(cache || !kin_mat.is_band() && !kin_mat.is_dist()) {
+	  for(int j = i; j < jmax; ++j) {
+	    const double val = cfreq * kern(i, j) * bs[i] * bsi[j];
+
+	    if(cache)
+	      kc(i + ws, j + ws) = val;
+	    else
+	      kd(i + ws, j + ws) += val;
+	  }
+	  continue;
+	}
+
+	for(int j = i; j < jmax; ++j) {
+	  if(!kin_mat.is_local(i + ws, j + ws))
+	    continue;
+	  
+	  kin_mat(i + ws, j + ws) += cfreq * kern(i, j) * bs[i] * bsi[j];
+	}
       }
     }
 
     // radiational transitions contribution
     //
-    for(int w = 0; w < Model::well_size(); ++w)
+    for(int w = 0; w < Model::well_size() && !cached; ++w)
       if(well(w).radiation()) {
+	const Well& cw = well(w);
 
 #pragma omp parallel for default(shared) schedule(dynamic)
 	
-	for(int i = 0; i < well(w).size(); ++i) {
-	  for(int j = i; j < well(w).size(); ++j) 
-	    kin_mat(i + well_shift[w], j + well_shift[w]) +=  well(w).radiation_rate(i, j); 
+	for(int i = 0; i < cw.size(); ++i) {
+	  for(int j = i; j < cw.size(); ++j) 
+	    if(kin_mat.is_local(i + well_shift[w], j + well_shift[w]))
+	      kin_mat(i + well_shift[w], j + well_shift[w]) +=  cw.radiation_rate(i, j); 
 	}
       }
 
+    if(cache && !cached)
+      //
+      cx.kin_reactive = kin_mat.dense.copy();
+
+    if(cache) {
+      //
+      double*       kp = kin_mat.dense;
+      const double* cp = cx.kin_collision;
+
+      const double pfac = pressure() / cx.kin_pressure;
+
+      const long packed_size = (long)global_size * (global_size + 1) / 2;
+
+#pragma omp parallel for default(shared) schedule(static)
+      
+      for(long i = 0; i < packed_size; ++i)
+	kp[i] += pfac * cp[i];
+    }
+
     // bimolecular product vectors
     //
-    for(int b = 0; b < Model::outer_barrier_size(); ++b) {
+    for(int b = 0; b < Model::outer_barrier_size() && !vec_cached; ++b) {
       const int w = Model::outer_connect(b).first;
       const int p = Model::outer_connect(b).second;
 
+      const double* tf  = thermal_factor_table(outer_barrier(b).size());
+      const double* bsi = well(w).boltzman_sqrt_inv();
+
       for(int i = 0; i < outer_barrier(b).size(); ++i)
 	global_bim(i + well_shift[w], p) = outer_barrier(b).state_number(i) / 2. / M_PI
-	  * thermal_factor(i) / well(w).boltzman_sqrt(i);
+	  * tf[i] * bsi[i];
     }
   
     // thermal distributions
     //
-    for(int w = 0; w < Model::well_size(); ++w)
+    for(int w = 0; w < Model::well_size() && !vec_cached; ++w)
       //
       for(int i = 0; i < well(w).size(); ++i)
 	//
@@ -3569,7 +6565,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
     
     // well escape
     //
-    for(int count = 0; count < Model::escape_size(); ++count) {
+    for(int count = 0; count < Model::escape_size() && !vec_cached; ++count) {
       //
       const int w = Model::escape_well_index(count);
     
@@ -3579,20 +6575,412 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
       //
     }//
     //
+    if(incremental_pressure && !vec_cached) {
+      //
+      context().global_bim    = global_bim;
+      context().global_pop    = global_pop;
+      context().global_escape = global_escape;
+    }
   }// global matrices
 
+  /************************************ ADAPTIVE ENERGY GRID ***********************************/
+
+  // below the lowest energy coupled to the barriers, the hot energies, and the top of the well
+  // (plus the energy transfer range), the energy bins of each well are lumped into the coarse bins
+  // growing geometrically toward the well bottom; the populations inside the coarse bin are in
+  // the local equilibrium, and the relaxation matrix is projected onto the lumped basis; the bins
+  // deeper than the reservoir offset form one reservoir state in the thermal equilibrium
+  std::vector<int>    grid_index(global_size);// lumped basis index
+  std::vector<double> grid_weight(global_size, 1.);// lumped basis coefficient
+  
+  itemp = 0;
+  for(int w = 0; w < Model::well_size(); ++w) {
+    //
+    int fine_size = well(w).size();
+    
+    if(energy_grid_factor > 1. || reservoir_offset >= 0.) {
+      //
+      fine_size = context().cum_stat_num[w].size();
+
+      for(int b = 0; b < Model::inner_barrier_size(); ++b)
+	if((Model::inner_connect(b).first == w || Model::inner_connect(b).second == w) && inner_barrier(b).size() > fine_size)
+	  fine_size = inner_barrier(b).size();
+
+      for(int b = 0; b < Model::outer_barrier_size(); ++b)
+	if(Model::outer_connect(b).first == w && outer_barrier(b).size() > fine_size)
+	  fine_size = outer_barrier(b).size();
+
+      std::map<int, std::vector<int> >::const_iterator hit = context().hot_index.find(w);
+      if(hit != context().hot_index.end())
+	for(int i = 0; i < hit->second.size(); ++i)
+	  if(hit->second[i] >= fine_size)
+	    fine_size = hit->second[i] + 1;
+
+      fine_size += well(w).kernel_bandwidth;
+      
+      if(fine_size > well(w).size())
+	fine_size = well(w).size();
+    }
+	
+    for(int i = 0; i < fine_size; ++i)
+      grid_index[i + well_shift[w]] = itemp++;
+
+    // reservoir state boundary
+    int res_start = well(w).size();
+    if(reservoir_offset >= 0.) {
+      res_start = fine_size + (int)(reservoir_offset / energy_step());
+      if(res_start > well(w).size())
+	res_start = well(w).size();
+    }
+
+    // coarse bins
+    const int coarse_max = well(w).kernel_bandwidth / 2 > 1 ? well(w).kernel_bandwidth / 2 : 1;
+    
+    double coarse_length = 1.;
+    for(int i = fine_size; i < res_start; ++itemp) {
+      //
+      coarse_length *= energy_grid_factor;
+
+      int coarse_size = coarse_length < (double)coarse_max ? (int)coarse_length : coarse_max;
+      if(i + coarse_size > res_start)
+	coarse_size = res_start - i;
+
+      dtemp = 0.;
+      for(int j = i; j < i + coarse_size; ++j)
+	dtemp += well(w).boltzman_sqrt(j) * well(w).boltzman_sqrt(j);
+      dtemp = std::sqrt(dtemp);
+
+      for(int j = i; j < i + coarse_size; ++j) {
+	grid_index[j + well_shift[w]]  = itemp;
+	grid_weight[j + well_shift[w]] = well(w).boltzman_sqrt(j) / dtemp;
+      }
+      i += coarse_size;
+    }
+
+    // reservoir state
+    if(res_start < well(w).size()) {
+      //
+      dtemp = 0.;
+      for(int j = res_start; j < well(w).size(); ++j)
+	dtemp += well(w).boltzman_sqrt(j) * well(w).boltzman_sqrt(j);
+      dtemp = std::sqrt(dtemp);
+
+      for(int j = res_start; j < well(w).size(); ++j) {
+	grid_index[j + well_shift[w]]  = itemp;
+	grid_weight[j + well_shift[w]] = well(w).boltzman_sqrt(j) / dtemp;
+      }
+      ++itemp;
+
+      IO::log << IO::log_offset << Model::well(w).name() << " well: reservoir state of "
+	      << well(w).size() - res_start << " energy bins\n";
+    }
+  }
+  const int grid_size = itemp;
+
+  const bool lumped = grid_size < global_size;
+
+  Lapack::SymmetricMatrix grid_mat;
+  if(lumped) {
+    //
+    if(banded || kin_mat.is_dist()) {
+      std::cerr << funame << "adaptive energy grid: only the dense storage of the relaxation matrix is supported\n";
+      throw Error::Init();
+    }
+
+    IO::log << IO::log_offset << "adaptive energy grid: lumped relaxation matrix dimension = " << grid_size << "\n";
+
+    grid_mat.resize(grid_size);
+    grid_mat = 0.;
+
+    for(int i = 0; i < global_size; ++i)
+      for(int j = i; j < global_size; ++j) {
+	//
+	dtemp = kin_mat(i, j);
+	if(dtemp == 0.)
+	  continue;
+
+	dtemp *= grid_weight[i] * grid_weight[j];
+	
+	// both triangles contribute to the diagonal of the lumped matrix
+	if(i != j && grid_index[i] == grid_index[j])
+	  dtemp *= 2.;
+
+	grid_mat(grid_index[i], grid_index[j]) += dtemp;
+      }
+  }
+  
   /******************** DIAGONALIZING THE GLOBAL KINETIC RELAXATION MATRIX ********************/
 
+  // number of eigenpairs needed: the full spectrum is used by the time evolution,
+  // the product energy distributions, and the relaxational contributions to the escape and hot rates
+  int eval_size = grid_size;
+  if((banded || eigensolver != FULL_SPECTRUM) && !Model::time_evolution && !ped_out.is_open() && !context().hot_energy_size
+     && !sens_out.is_open() && !(Model::escape_size() && Model::bimolecular_size())) {
+    itemp = Model::well_size() + (evec_out_num > 0 ? evec_out_num : 1);
+    if(itemp < grid_size)
+      eval_size = itemp;
+  }
+
+  if(eval_size < grid_size)
+    IO::log << IO::log_offset << "number of the lowest eigenpairs calculated = " << eval_size << "\n";
+
   Lapack::Vector eigenval;
-  Lapack::Matrix eigen_global(global_size);
+  Lapack::Matrix eigen_global;
 
-  {
-    IO::Marker solve_marker("diagonalizing global relaxation matrix", IO::Marker::ONE_LINE);
+  // shifted band matrix factorization for the shift-invert iterations
+  const double band_shift = 1.e-6 * well(0).collision_frequency();
+  Lapack::BandCholesky band_fac;
+
+  if(banded) {
+    IO::Marker solve_marker("lowest eigenpairs of the global relaxation matrix", IO::Marker::ONE_LINE);
+
+    Lapack::BandMatrix shifted = kin_mat.band.copy();
+    for(int i = 0; i < global_size; ++i)
+      shifted(i, i) += band_shift;
+
+    band_fac = Lapack::BandCholesky(shifted);
+
+    // warm start from the previous pressure eigenvectors
+    Lapack::Vector& start = context().band_start;
+
+    // or from the previous energy grid ones
+    if(grid_warm_start && eval_size < grid_size && (!start.isinit() || start.size() != global_size)) {
+      //
+      mtemp = grid_start_subspace(well_shift, global_size, eval_size);
+
+      if(mtemp.isinit()) {
+	start.resize(global_size);
+	start = 0.;
+	for(int l = 0; l < eval_size; ++l)
+	  for(int i = 0; i < global_size; ++i)
+	    start[kin_mat.band_index[i]] += mtemp(i, l);
+      }
+    }
+    
+    if(start.isinit() && start.size() == global_size)
+      //
+      eigenval = kin_mat.band.lowest_eigenvalues(eval_size, band_fac, &mtemp, start);
+    else
+      //
+      eigenval = kin_mat.band.lowest_eigenvalues(eval_size, band_fac, &mtemp);
+
+    start.resize(global_size);
+    start = 0.;
+    for(int l = 0; l < eval_size; ++l)
+      for(int i = 0; i < global_size; ++i)
+	start[i] += mtemp(i, l);
+
+    eigen_global.resize(eval_size, global_size);
+    for(int l = 0; l < eval_size; ++l)
+      for(int i = 0; i < global_size; ++i)
+	eigen_global(l, i) = mtemp(kin_mat.band_index[i], l);
+  }
+#ifdef WITH_SCALAPACK
+  else if(kin_mat.is_dist()) {
+    IO::Marker solve_marker("diagonalizing distributed global relaxation matrix", IO::Marker::ONE_LINE);
+
+    // only the eigenvectors used downstream are gathered
+    eigenval = kin_mat.dist.eigenvalues(eval_size, &eigen_global);
+
+    eigen_global.transpose_in_place();
+  }
+#endif
+  else if(lumped) {
+    IO::Marker solve_marker("diagonalizing lumped relaxation matrix", IO::Marker::ONE_LINE);
+
+    if(eval_size < grid_size)
+      eigenval = grid_mat.lowest_eigenvalues(eval_size, &mtemp);
+    else
+      eigenval = grid_mat.eigenvalues(&mtemp);
+
+    // eigenvectors on the original energy grid
+    eigen_global.resize(eval_size, global_size);
+    for(int l = 0; l < eval_size; ++l)
+      for(int i = 0; i < global_size; ++i)
+	eigen_global(l, i) = mtemp(grid_index[i], l) * grid_weight[i];
+  }
+  else {
+    // sub-networks: the wells coupled through the inner barriers with nonzero number of states;
+    // the ones sharing only the bimolecular products give the independent blocks
+    std::vector<int> component(Model::well_size());
+    for(int w = 0; w < Model::well_size(); ++w)
+      component[w] = w;
+
+    bool relabel = true;
+    while(relabel) {
+      relabel = false;
+      for(int b = 0; b < Model::inner_barrier_size(); ++b) {
+	if(!inner_barrier(b).size())
+	  continue;
+
+	int& c1 = component[Model::inner_connect(b).first];
+	int& c2 = component[Model::inner_connect(b).second];
+	if(c1 != c2) {
+	  c1 = c2 = c1 < c2 ? c1 : c2;
+	  relabel = true;
+	}
+      }
+    }
+
+    std::map<int, std::vector<int> > block_map;
+    for(int w = 0; w < Model::well_size(); ++w)
+      for(int i = 0; i < well(w).size(); ++i)
+	block_map[component[w]].push_back(i + well_shift[w]);
+
+    if(block_map.size() > 1) {
+      //
+      std::vector<std::vector<int> > block_index;
+
+      IO::log << IO::log_offset << "weakly coupled sub-networks:";
+      for(std::map<int, std::vector<int> >::const_iterator bit = block_map.begin(); bit != block_map.end(); ++bit) {
+	//
+	block_index.push_back(bit->second);
+
+	IO::log << " {";
+	int count = 0;
+	for(int w = 0; w < Model::well_size(); ++w)
+	  if(component[w] == bit->first)
+	    IO::log << (count++ ? " " : "") << Model::well(w).name();
+	IO::log << "}";
+      }
+      IO::log << "\n";
+
+      IO::Marker solve_marker("diagonalizing global relaxation matrix by sub-networks", IO::Marker::ONE_LINE);
+
+      std::vector<Lapack::Vector> block_eval(block_index.size());
+      std::vector<Lapack::Matrix> block_evec(block_index.size());
+
+      std::exception_ptr error;
+
+      // the blocks are diagonalized concurrently with the serial BLAS
+      Threads::BlasScope blas_scope(1);
+
+#pragma omp parallel for default(shared) schedule(dynamic, 1)
+
+      for(int c = 0; c < block_index.size(); ++c) {
+	//
+	try {
+	  const std::vector<int>& index = block_index[c];
+	  const int block_size = index.size();
+
+	  Lapack::SymmetricMatrix block_mat(block_size);
+	  for(int i = 0; i < block_size; ++i)
+	    for(int j = i; j < block_size; ++j)
+	      block_mat(i, j) = kin_mat.dense(index[i], index[j]);
+
+	  if(eval_size < block_size)
+	    block_eval[c] = block_mat.lowest_eigenvalues(eval_size, &block_evec[c]);
+	  else
+	    block_eval[c] = block_mat.eigenvalues(&block_evec[c]);
+	}
+	catch(...) {
+#pragma omp critical(sub_network_eigenvalues)
+	  if(!error)
+	    error = std::current_exception();
+	}
+      }
+
+      if(error)
+	std::rethrow_exception(error);
+
+      // the lowest eigenpairs of all blocks
+      std::multimap<double, std::pair<int, int> > eval_order;
+      for(int c = 0; c < block_index.size(); ++c)
+	for(int l = 0; l < block_eval[c].size(); ++l)
+	  eval_order.insert(std::make_pair(block_eval[c][l], std::make_pair(c, l)));
+
+      eigenval.resize(eval_size);
+      eigen_global.resize(eval_size, global_size);
+      eigen_global = 0.;
+
+      std::multimap<double, std::pair<int, int> >::const_iterator eit = eval_order.begin();
+      for(int l = 0; l < eval_size; ++l, ++eit) {
+	//
+	const int c = eit->second.first;
+	const int k = eit->second.second;
+
+	eigenval[l] = eit->first;
+
+	for(int i = 0; i < block_index[c].size(); ++i)
+	  eigen_global(l, block_index[c][i]) = block_evec[c](i, k);
+      }
+    }
+    else {
+      Threads::BlasScope blas_scope;
+
+      // projection onto the reduced basis of the previous points eigenvectors
+      bool is_projected = false;
+      if(reduced_basis_tolerance > 0. && eval_size < global_size) {
+	//
+	mtemp = reduced_basis_span(well_shift, global_size);
 
-    eigenval = kin_mat.eigenvalues(&eigen_global);
-    eigen_global = eigen_global.transpose();
+	if(mtemp.isinit()) {
+	  try {
+	    IO::Marker solve_marker("projecting onto reduced basis", IO::Marker::ONE_LINE);
+
+	    eigenval = kin_mat.dense.projected_eigenvalues(eval_size, mtemp, reduced_basis_tolerance, &eigen_global);
+	  }
+	  catch(Error::General) {
+	    eigenval = Lapack::Vector();
+	  }
+
+	  if(eigenval.isinit())
+	    is_projected = true;
+	  else
+	    IO::log << IO::log_offset << "reduced basis residual is too large => solving in full\n";
+	}
+      }
+
+      // subspace iterations from the previous energy grid eigenvectors
+      if(!eigenval.isinit() && grid_warm_start && eval_size < global_size) {
+	//
+	// the guard vectors: the lowest relaxation eigenvalues are clustered
+	itemp = eval_size + 16;
+	if(itemp > global_size)
+	  itemp = global_size;
+
+	mtemp = grid_start_subspace(well_shift, global_size, itemp);
+
+	if(mtemp.isinit()) {
+	  try {
+	    IO::Marker solve_marker("refining previous energy grid eigenvectors", IO::Marker::ONE_LINE);
+
+	    eigenval = kin_mat.dense.subspace_eigenvalues(eval_size, mtemp, band_shift, &eigen_global);
+	  }
+	  catch(Error::General) {
+	    eigenval = Lapack::Vector();
+	  }
+
+	  if(!eigenval.isinit())
+	    IO::log << IO::log_offset << "WARNING: previous energy grid eigenvectors refinement failed\n";
+	}
+      }
+
+      if(!eigenval.isinit()) {
+	IO::Marker solve_marker("diagonalizing global relaxation matrix", IO::Marker::ONE_LINE);
+
+	if(eval_size < global_size)
+	  eigenval = kin_mat.dense.lowest_eigenvalues(eval_size, &eigen_global);
+	else
+	  eigenval = kin_mat.dense.eigenvalues(&eigen_global);
+      }
+
+      eigen_global.transpose_in_place();
+
+      // the fully solved point becomes the snapshot
+      if(reduced_basis_tolerance > 0. && eval_size < global_size && !is_projected) {
+	if(reduced_basis.size() >= reduced_basis_size)
+	  reduced_basis.erase(reduced_basis.begin());
+
+	reduced_basis.push_back(GridStart());
+	set_grid_start(reduced_basis.back(), eigen_global, eval_size, well_shift);
+      }
+    }
   }
 
+  if(grid_warm_start && eval_size < grid_size)
+    save_grid_start(eigen_global, eval_size, well_shift);
+
   const double min_relax_eval = eigenval[Model::well_size()];
   const double max_relax_eval = eigenval.back();
 
@@ -3617,6 +7005,10 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
     for(int b = 0; b < Model::inner_barrier_size(); ++b) {
       int w1 = Model::inner_connect(b).first;
       int w2 = Model::inner_connect(b).second;
+      if(!inner_barrier(b).size()) {
+	IO::log << std::setw(13) << 0.;
+	continue;
+      }
       dtemp = well(w1).state_density(0) < well(w2).state_density(0) ?
 					  well(w1).state_density(0) : well(w2).state_density(0);
       IO::log << std::setw(13) << inner_barrier(b).state_number(0) / 2. / M_PI / dtemp / well(w1).collision_frequency();
@@ -3643,7 +7035,9 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 
   // low eigenvalue method
   //
-  if(eigenval[0] / min_relax_eval < min_chem_eval) {
+  const bool low_eval_used = eigenval[0] / min_relax_eval < min_chem_eval;
+  
+  if(low_eval_used) {
     //
     IO::log << IO::log_offset << "some eigenvalues are too small: using low eigenvalue method\n";
     IO::Marker low_eval_marker("low eigenvalue method");
@@ -3657,21 +7051,15 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 
     Lapack::Matrix chem_evec(Model::well_size());
     
-#ifdef WITH_MPACK
-  
-    Lapack::Vector chem_eval = Mpack::dd_eigenvalues(k_11, &chem_evec);
-
-#else
-    
-    Lapack::Vector chem_eval = k_11.eigenvalues(&chem_evec);
-
-#endif
+    Lapack::Vector chem_eval = chemical_eigenvalues(k_11, chem_evec);
     
     // low-eigenvalue chemical subspace
     itemp = 1;
     while(eigenval[itemp] / min_relax_eval < min_chem_eval) { ++itemp; }
     const int chem_size = itemp < Model::well_size() ? itemp : Model::well_size();
 
+    eigenvalue_gap = min_relax_eval / eigenval[chem_size - 1];
+
     if(chem_size < Model::well_size()) {
       Lapack::Matrix pop_chem(Model::well_size(), chem_size);
       for(int l = 0; l < chem_size; ++l)
@@ -3822,10 +7210,39 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
     //
   }// low eigenvalue method
 
-  Lapack::Matrix eigen_well(global_size, Model::well_size());
-  for(int l = 0; l < global_size; ++l)
+  // the eigenvectors are moved to the scratch file mapping: the projections and the outputs
+  // below stream through them, and the idle pages are written out rather than kept with kin_mat
+  if(eigen_scratch_dir.size()) {
+    //
+    Workspace::set_scratch(eigen_scratch_dir);
+
+    Workspace::Spill spill;
+
+    eigen_global = eigen_global.copy();
+
+    IO::log << IO::log_offset << "eigenvectors spilled to the scratch directory " << eigen_scratch_dir << ": "
+	    << (double)eval_size * global_size * sizeof(double) / 1.e6 << " MB\n";
+  }
+
+  Lapack::Matrix eigen_well(eval_size, Model::well_size());
+  for(int l = 0; l < eval_size; ++l)
     for(int w = 0; w < Model::well_size(); ++w)
-      eigen_well(l, w) = vlength(&eigen_global(l, well_shift[w]), well(w).size(), global_size);
+      eigen_well(l, w) = vlength(&eigen_global(l, well_shift[w]), well(w).size(), eval_size);
+
+  // the chemical and the lowest relaxation eigenpairs, as many as the eigenvalues output has
+  if(keep_spectrum) {
+    itemp = std::min(eval_size, Model::well_size() + evec_out_num);
+
+    // new storage: the kept copies of the previous points share it
+    spectrum.eigenvalue.resize(itemp);
+    spectrum.eigenvector = Lapack::Matrix(global_size, itemp);
+    for(int l = 0; l < itemp; ++l) {
+      spectrum.eigenvalue[l] = eigenval[l] / Phys_const::herz;
+      for(int i = 0; i < global_size; ++i)
+	spectrum.eigenvector(i, l) = eigen_global(l, i);
+    }
+    spectrum.well_shift = well_shift;
+  }
   
   // projection of the  eigenvectors onto the thermal subspace
   //
@@ -3840,39 +7257,19 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
   // eigenvector to well escape projection
   //
   Lapack::Matrix eigen_escape;
-  if(Model::escape_size())
-    eigen_escape = eigen_global * global_escape;
-
-  /********************************* TIME EVOLUTION ********************************/
-
-  if(Model::time_evolution) {
-    
-    const int react = Model::time_evolution->reactant();
-
-    // output header
-    Model::time_evolution->out << "Pressure = ";
-    switch(pressure_unit) {
-    case BAR:
-      Model::time_evolution->out << pressure() / Phys_const::bar << " bar";
-      break;
-    case TORR:
-      Model::time_evolution->out << pressure() / Phys_const::tor << " torr";
-      break;
-    case ATM:
-      Model::time_evolution->out << pressure() / Phys_const::atm << " atm";
-      break;
-    }
-    Model::time_evolution->out << "\t Temperature = " << temperature() / Phys_const::kelv << " K\n\n";
+  if(Model::escape_size())
+    eigen_escape = eigen_global * global_escape;
 
-    Model::time_evolution->out << std::setw(13) << "time, sec";
-    for(int w = 0; w < Model::well_size(); ++w)
-      Model::time_evolution->out << std::setw(13) << Model::well(w).name();
-    
-    for(int p = 0; p < Model::bimolecular_size(); ++p)
-      Model::time_evolution->out << std::setw(13) << Model::bimolecular(p).name();
+  /********************************* TIME EVOLUTION ********************************/
 
-    Model::time_evolution->out << "\n";
+  // the profile mode is run by the driver from the rate coefficients
+  if(Model::time_evolution && !Model::time_evolution->profile().size()) {
     
+    const int react = Model::time_evolution->reactant();
+
+    std::vector<double> init_coef(eval_size);
+    std::vector<double> well_fac(Model::well_size());
+
     // bimolecular reactants
     if(Model::bimolecular_size() && Model::time_evolution->excess_reactant_concentration() > 0.) {
 
@@ -3885,43 +7282,13 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
       const double nfac = Model::time_evolution->excess_reactant_concentration() * energy_step() 
 	/ bimolecular(react).weight();
 
-      double time_val = Model::time_evolution->start();
-      for(int t = 0;  t < Model::time_evolution->size(); ++t, time_val *= Model::time_evolution->step()) {
-	std::vector<double> well_pop(Model::well_size());
-	std::vector<double> bim_pop(Model::bimolecular_size());
-
-	for(int l = 0; l < global_size; ++l) {
-	  dtemp = eigenval[l] * time_val;
-	  if(dtemp > 50.)
-	    dtemp = 1. / eigenval[l];
-	  else
-	    dtemp = (1. - std::exp(-dtemp)) /eigenval[l];
-	
-	  for(int w = 0; w < Model::well_size(); ++w)
-	    well_pop[w] += eigen_bim(l, react) * eigen_pop(l, w) * dtemp;
-
-	  dtemp = (time_val - dtemp) / eigenval[l]; 
-	  for(int p = 0; p < Model::bimolecular_size(); ++p)
-	    bim_pop[p] += eigen_bim(l, react) * eigen_bim(l, p) * dtemp;
-	}
+      for(int l = 0; l < eval_size; ++l)
+	init_coef[l] = eigen_bim(l, react);
 
-	// normalization
-	for(int w = 0; w < Model::well_size(); ++w)
-	  well_pop[w] *= well(w).weight_sqrt() * nfac;
-	for(int p = 0; p < Model::bimolecular_size(); ++p)
-	  bim_pop[p] *= nfac;
-	  
-	// output
-	Model::time_evolution->out << std::setw(13) << time_val * Phys_const::herz;
-	for(int w = 0; w < Model::well_size(); ++w)
-	  Model::time_evolution->out << std::setw(13) << well_pop[w];
+      for(int w = 0; w < Model::well_size(); ++w)
+	well_fac[w] = well(w).weight_sqrt() * nfac;
 
-	for(int p = 0; p < Model::bimolecular_size(); ++p)
-	  Model::time_evolution->out << std::setw(13) << bim_pop[p];
-	
-	Model::time_evolution->out << "\n";
-	//
-      }// time cycle
+      time_evolution_output(eigenval, eval_size, init_coef, eigen_pop, eigen_bim, true, well_fac, nfac);
       //
     }// bimolecular reactants
     //
@@ -3942,57 +7309,25 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
       for(Lapack::Vector::iterator i = init_dist.begin(); i != init_dist.end(); ++i)
 	*i /= norm_fac;
 
-      std::vector<double> init_coef(global_size);
-      for(int l = 0; l < global_size; ++l)
-	init_coef[l] = parallel_vdot(init_dist, &eigen_global(l, well_shift[react]), well(react).size(), 1, global_size);
-
-      double time_val = Model::time_evolution->start();
-      for(int t = 0;  t < Model::time_evolution->size(); ++t, time_val *= Model::time_evolution->step()) {
-	std::vector<double> well_pop(Model::well_size());
-	std::vector<double> bim_pop(Model::bimolecular_size());
-
-	for(int l = 0; l < global_size; ++l) {
-	  dtemp = eigenval[l] * time_val;
-	  if(dtemp > 100.)
-	    dtemp = 0.;
-	  else
-	    dtemp = std::exp(-dtemp);
-	
-	  for(int w = 0; w < Model::well_size(); ++w)
-	    well_pop[w] += init_coef[l] * eigen_pop(l, w) * dtemp;
-
-	  dtemp = (1. - dtemp) / eigenval[l]; 
-	  for(int p = 0; p < Model::bimolecular_size(); ++p)
-	    bim_pop[p] += init_coef[l] * eigen_bim(l, p) * dtemp;
-	}
+      for(int l = 0; l < eval_size; ++l)
+	init_coef[l] = parallel_vdot(init_dist, &eigen_global(l, well_shift[react]), well(react).size(), 1, eval_size);
 
-	// normalization
-	for(int w = 0; w < Model::well_size(); ++w)
-	  well_pop[w] *= well(w).weight_sqrt();
-	
-	// output
-	Model::time_evolution->out << std::setw(13) << time_val * Phys_const::herz;
-	for(int w = 0; w < Model::well_size(); ++w)
-	  Model::time_evolution->out << std::setw(13) << well_pop[w];
+      for(int w = 0; w < Model::well_size(); ++w)
+	well_fac[w] = well(w).weight_sqrt();
 
-	for(int p = 0; p < Model::bimolecular_size(); ++p)
-	  Model::time_evolution->out << std::setw(13) << bim_pop[p];
-	
-	Model::time_evolution->out << "\n";
-      }// time cycle
+      time_evolution_output(eigenval, eval_size, init_coef, eigen_pop, eigen_bim, false, well_fac, 1.);
     }// bound reactant
-    Model::time_evolution->out << "\n";
   }// time evolution
   
   // eigenvector distributions at hot energies
   Lapack::Matrix eigen_hot;
-  if(hot_energy_size) {
-    eigen_hot.resize(global_size, hot_energy_size);
+  if(context().hot_energy_size) {
+    eigen_hot.resize(eval_size, context().hot_energy_size);
     std::map<int, std::vector<int> >::const_iterator hit;
     int count = 0;
-    for(hit = hot_index.begin(); hit != hot_index.end(); ++hit)
+    for(hit = context().hot_index.begin(); hit != context().hot_index.end(); ++hit)
       for(int i = 0; i < hit->second.size(); ++i, ++count) {
-	for(int l = 0; l < global_size; ++l)
+	for(int l = 0; l < eval_size; ++l)
 	  eigen_hot(l, count) = eigen_global(l, well_shift[hit->first] + hit->second[i]) 
 	    / well(hit->first).boltzman_sqrt(hit->second[i]);
       }
@@ -4086,177 +7421,551 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
   
   // eigenvalues output
   if(eval_out.is_open()) {
-    eval_out << std::setw(13) << temperature() / Phys_const::kelv
-	     << std::setw(13);
+    std::vector<double> row;
+    row.push_back(temperature() / Phys_const::kelv);
     switch(pressure_unit) {
     case BAR:
-      eval_out << pressure() / Phys_const::bar;
+      row.push_back(pressure() / Phys_const::bar);
       break;
     case TORR:
-      eval_out << pressure() / Phys_const::tor;
+      row.push_back(pressure() / Phys_const::tor);
       break;
     case ATM:
-      eval_out << pressure() / Phys_const::atm;
+      row.push_back(pressure() / Phys_const::atm);
       break;
     }
-    eval_out << std::setw(13) << well(0).collision_frequency() / Phys_const::herz
-	     << std::setw(13) << min_relax_eval / well(0).collision_frequency();
-    int eval_max = Model::well_size() + evec_out_num;
-    for(int l = 0; l < eval_max; ++l)
-      eval_out << std::setw(13) << eigenval[l] / well(0).collision_frequency() 
-	       << std::setw(13) <<  1. - vdot(eigen_pop.row(l));
-    eval_out << "\n";
+    row.push_back(well(0).collision_frequency() / Phys_const::herz);
+    row.push_back(min_relax_eval / well(0).collision_frequency());
+    int eval_max = Model::well_size() + evec_out_num;
+    for(int l = 0; l < eval_max; ++l) {
+      row.push_back(eigenval[l] / well(0).collision_frequency());
+      row.push_back(1. - vdot(eigen_pop.row(l)));
+    }
+    IO::put_table(eval_out, "", &row[0], 1, row.size());
+  }
+
+  // eigenvector output
+  if(evec_out.is_open()) {
+    IO::put_text(evec_out, "EIGENVECTORS:\n");
+
+    std::vector<std::string> name;
+    for(int i = 0; i < 2; ++i)
+      for(int w = 0; w < Model::well_size(); ++w)
+	name.push_back(Model::well(w).name());
+
+    Lapack::Matrix dist(well_size_max, 2 * Model::well_size());
+    
+    int evec_max = Model::well_size() + evec_out_num;
+    for(int l = 0; l < evec_max; ++l) {
+      std::ostringstream title;
+      title << "l = " << l << "\n"
+	    << "eigenvalue / collision frequency = "
+	    << eigenval[l] / well(0).collision_frequency() 
+	    << "\n";
+      IO::put_text(evec_out, title.str());
+
+      std::vector<double> length(Model::well_size());
+      for(int w = 0; w < Model::well_size(); ++w)
+	length[w] = eigen_well(l, w);
+      IO::put_table(evec_out, "well length", &length[0], 1, length.size());
+
+      for(int i = 0; i < well_size_max; ++i)
+	for(int w = 0; w < Model::well_size(); ++w)
+	  if(i < well(w).size()) {
+	    // micropopulational distribution
+	    dist(i, w) = eigen_global(l, well_shift[w] + i) * well(w).boltzman_sqrt(i); 
+	    // ratio to the thermal distribution
+	    dist(i, w + Model::well_size()) = eigen_global(l, well_shift[w] + i) / well(w).boltzman_sqrt(i) 
+	      * well(w).weight_sqrt();
+	  }
+	  else {
+	    dist(i, w) = 0.;
+	    dist(i, w + Model::well_size()) = 0.;
+	  }
+
+      energy_table_output(evec_out, name, dist, well_size_max);
+    }
+    IO::put_text(evec_out, "\n");
+  }
+
+  /********************************** CHEMICAL SUBSPACE DIMENSION ****************************************/
+
+  //
+  // predefined chemical subspace dimension
+  //
+  if(_default_chem_size >= 0) {
+    //
+    itemp = _default_chem_size;
+  }
+  //
+  // default partitioning scheme
+  //
+  else if(default_partition.size()) {
+    //
+    itemp = default_partition.size();
+  }
+  //
+  // absolute eigenvalue threshold
+  //
+  else if(chemical_threshold > 1.) {
+    //
+    for(itemp = 0; itemp < Model::well_size(); ++itemp)
+      //
+      if(min_relax_eval / eigenval[itemp]  < chemical_threshold)
+	//
+	break;
+  }
+  //
+  // relaxation projection threshold
+  //
+  else if(chemical_threshold < 1. && chemical_threshold > 0.) {
+    //
+    for(itemp = 0; itemp < Model::well_size(); ++itemp)
+      //
+      if(relaxation_projection[itemp] > chemical_threshold)
+	//
+	break;
+  }
+  //
+  // relative eigenvalue threshold
+  //
+  else if(chemical_threshold < -1. ) {
+    //
+    for(itemp = Model::well_size(); itemp > 0; --itemp)
+      //
+      if(eigenval[itemp] / eigenval[itemp - 1] > - chemical_threshold)
+	//
+	break;
+  }
+  //
+  else
+    //
+    itemp = Model::well_size();
+	
+  const int chem_size = itemp;
+
+  if(chem_size != Model::well_size())
+    //
+    IO::log << IO::log_offset << "dimension of the chemical subspace = " << chem_size << "\n";
+
+  eigenvalue_gap = chem_size ? min_relax_eval / eigenval[chem_size - 1] : -1.;
+
+  /***** PARTITIONING THE GLOBAL PHASE SPACE INTO THE CHEMICAL AND COLLISIONAL SUBSPACES *****/
+
+  // collisional relaxation eigenvalues and eigenvectors
+  const int relax_size = eval_size - chem_size;
+  Lapack::Vector relax_lave(relax_size);
+  for(int r = 0; r < relax_size; ++r) {
+    itemp = r + chem_size;
+    relax_lave[r] = 1. / eigenval[itemp];
+  }
+
+  // kinetic matrix modified
+  const double cfreq = well(0).collision_frequency();
+
+  // with the full spectrum of the dense matrix the bimolecular source terms come from the
+  // relaxation modes expansion, so that neither the projector fill nor the factorization is needed
+  const bool spectral = !banded && !lumped && !kin_mat.is_dist() && eval_size == global_size;
+
+  // with the partial spectrum of the dense matrix the iterative eigensolver gets the bimolecular
+  // source terms from the preconditioned conjugate gradient iterations, so that the global
+  // relaxation matrix is neither modified nor factorized
+  const bool iterative = eigensolver == ITERATIVE_SPECTRUM && !banded && !lumped && !kin_mat.is_dist() && !spectral;
+
+  // otherwise the dense matrix in the energy interleaved order is banded up to the radiational
+  // transitions: its band Cholesky factors with the chemical eigenvectors projector added as the
+  // low-rank update precondition the conjugate gradient iterations on the dense matrix
+  const bool sparse = !banded && !lumped && !kin_mat.is_dist() && !spectral && !iterative;
+
+  // chemical eigenvectors as the contiguous panel (chemical mode, global index), so that the
+  // projections below are the matrix products
+  Lapack::Matrix chem_vec;
+  if(chem_size) {
+    //
+    chem_vec.resize(chem_size, global_size);
+    for(int i = 0; i < global_size; ++i)
+      for(int l = 0; l < chem_size; ++l)
+	chem_vec(l, i) = eigen_global(l, i);
+  }
+
+  // lumped basis coefficients of the chemical eigenvectors
+  Lapack::Matrix grid_chem;
+  if(lumped) {
+    //
+    grid_chem.resize(grid_size, chem_size);
+    grid_chem = 0.;
+    for(int l = 0; l < chem_size; ++l)
+      for(int i = 0; i < global_size; ++i)
+	grid_chem(grid_index[i], l) += eigen_global(l, i) * grid_weight[i];
+
+    for(int a = 0; a < grid_size; ++a)
+      for(int b = a; b < grid_size; ++b) {
+	dtemp = 0.;
+	for(int l = 0; l < chem_size; ++l)
+	  dtemp += grid_chem(a, l) * grid_chem(b, l);
+	grid_mat(a, b) += dtemp * cfreq;
+      }
+  }
+  else if(kin_mat.is_dist()) {
+    //
+#pragma omp parallel for default(shared) private(dtemp) schedule(dynamic)
+	
+    for(int i = 0; i < global_size; ++i) {
+      for(int j = i; j < global_size; ++j) {
+	if(!kin_mat.is_local(i, j))
+	  continue;
+	
+	dtemp = 0.;
+	for(int l = 0; l < chem_size; ++l)
+	  dtemp += eigen_global(l, i) * eigen_global(l, j);
+	kin_mat(i, j) += dtemp * cfreq;
+      }
+    }
+  }
+
+  // block Gram-Schmidt against the orthonormal chemical eigenvectors
+  Lapack::Matrix proj_bim = global_bim.copy();
+  if(Model::bimolecular_size() && chem_size) {
+    //
+    Threads::BlasScope blas_scope;
+
+    proj_bim.add_transpose_product(chem_vec, chem_vec * proj_bim, -1.);
+  }
+
+  Lapack::Matrix inv_proj_bim; 
+  if(Model::bimolecular_size() && banded) {
+    //
+    // the right hand side is orthogonal to the chemical subspace, where the modified kinetic
+    // matrix and the kinetic matrix are the same; the shift is removed by iterative refinement
+    //
+    inv_proj_bim.resize(global_size, Model::bimolecular_size());
+
+    Lapack::Vector rhs(global_size), sol(global_size);
+    
+    for(int p = 0; p < Model::bimolecular_size(); ++p) {
+      //
+      for(int i = 0; i < global_size; ++i)
+	rhs[kin_mat.band_index[i]] = proj_bim(i, p);
+
+      sol = 0.;
+      for(int iter = 0; ; ++iter) {
+	//
+	vtemp = rhs.copy();
+	for(int i = 0; i < global_size; ++i)
+	  vtemp[i] += band_shift * sol[i];
+
+	vtemp = band_fac.invert(vtemp);
+
+	for(int l = 0; l < chem_size; ++l) {
+	  dtemp = 0.;
+	  for(int i = 0; i < global_size; ++i)
+	    dtemp += eigen_global(l, i) * vtemp[kin_mat.band_index[i]];
+	  for(int i = 0; i < global_size; ++i)
+	    vtemp[kin_mat.band_index[i]] -= dtemp * eigen_global(l, i);
+	}
+
+	dtemp = vdistance(vtemp, sol, global_size) / vlength(vtemp, global_size);
+	sol = vtemp;
+	
+	if(dtemp < 1.e-12)
+	  break;
+
+	if(iter == 100) {
+	  std::cerr << funame << "band storage: iterative refinement did not converge\n";
+	  throw Error::Math();
+	}
+      }
+
+      for(int i = 0; i < global_size; ++i)
+	inv_proj_bim(i, p) = sol[kin_mat.band_index[i]];
+    }
+  }
+#ifdef WITH_SCALAPACK
+  else if(Model::bimolecular_size() && kin_mat.is_dist())
+    inv_proj_bim = kin_mat.dist.positive_invert(proj_bim);
+#endif
+  else if(Model::bimolecular_size() && lumped) {
+    //
+    mtemp.resize(grid_size, Model::bimolecular_size());
+    mtemp = 0.;
+    for(int p = 0; p < Model::bimolecular_size(); ++p)
+      for(int i = 0; i < global_size; ++i)
+	mtemp(grid_index[i], p) += proj_bim(i, p) * grid_weight[i];
+
+    mtemp = Lapack::Cholesky(grid_mat).invert(mtemp);
+
+    inv_proj_bim.resize(global_size, Model::bimolecular_size());
+    for(int p = 0; p < Model::bimolecular_size(); ++p)
+      for(int i = 0; i < global_size; ++i)
+	inv_proj_bim(i, p) = mtemp(grid_index[i], p) * grid_weight[i];
+  }
+  else if(Model::bimolecular_size() && spectral) {
+    //
+    // the right hand side is orthogonal to the chemical subspace
+    //
+    Threads::BlasScope blas_scope;
+
+    mtemp = eigen_global * proj_bim;
+
+    for(int l = 0; l < eval_size; ++l)
+      for(int p = 0; p < Model::bimolecular_size(); ++p)
+	mtemp(l, p) = l < chem_size ? 0. : mtemp(l, p) * relax_lave[l - chem_size];
+
+    inv_proj_bim = eigen_global.transpose_product(mtemp);
+  }
+  else if(Model::bimolecular_size() && iterative) {
+    //
+    // the modified kinetic matrix, kin_mat + cfreq * X * X^T, with X being the chemical eigenvectors,
+    // is positively defined and is applied without being formed; the Cholesky factors of its well
+    // blocks are the preconditioner; the right hand side is orthogonal to the chemical subspace
+    //
+    IO::Marker solve_marker("bimolecular source terms by preconditioned conjugate gradient");
+
+    Threads::BlasScope blas_scope;
+
+    std::vector<Lapack::Cholesky> block_fac;
+    for(int w = 0; w < Model::well_size(); ++w) {
+      //
+      const int ws = well_shift[w];
+      const int wsize = well(w).size();
+
+      Lapack::SymmetricMatrix block_mat(wsize);
+
+#pragma omp parallel for default(shared) private(dtemp) schedule(dynamic)
+
+      for(int i = 0; i < wsize; ++i)
+	for(int j = i; j < wsize; ++j) {
+	  dtemp = 0.;
+	  for(int l = 0; l < chem_size; ++l)
+	    dtemp += chem_vec(l, i + ws) * chem_vec(l, j + ws);
+	  block_mat(i, j) = kin_mat.dense(i + ws, j + ws) + dtemp * cfreq;
+	}
+
+      block_fac.push_back(Lapack::Cholesky(block_mat));
+    }
+
+    inv_proj_bim.resize(global_size, Model::bimolecular_size());
+    inv_proj_bim = 0.;
+
+    const double tolerance = 1.e-12;
+    const int    iter_max  = global_size > 100 ? global_size : 100;
+
+    Lapack::Vector res(global_size), pre(global_size), dir(global_size), prod;
+
+    for(int p = 0; p < Model::bimolecular_size(); ++p) {
+      //
+      double* sol = &inv_proj_bim(0, p);
+
+      for(int i = 0; i < global_size; ++i)
+	res[i] = proj_bim(i, p);
+
+      const double rhs_norm = vlength(res, global_size);
+      
+      if(rhs_norm == 0.)
+	continue;
+
+      double rho_old = 0.;
+      int iter = 0;
+      for(; ; ++iter) {
+	//
+	// block preconditioner
+	for(int w = 0; w < Model::well_size(); ++w) {
+	  //
+	  vtemp.resize(well(w).size());
+	  for(int i = 0; i < well(w).size(); ++i)
+	    vtemp[i] = res[i + well_shift[w]];
+
+	  vtemp = block_fac[w].invert(vtemp);
+
+	  for(int i = 0; i < well(w).size(); ++i)
+	    pre[i + well_shift[w]] = vtemp[i];
+	}
+
+	const double rho = res * pre;
+
+	if(iter)
+	  for(int i = 0; i < global_size; ++i)
+	    dir[i] = pre[i] + rho / rho_old * dir[i];
+	else
+	  dir = pre.copy();
+
+	rho_old = rho;
+
+	// modified kinetic matrix times the search direction
+	prod = kin_mat.dense * dir;
+	if(chem_size) {
+	  //
+	  vtemp = chem_vec * dir;
+	  vtemp *= cfreq;
+	  prod += vtemp * chem_vec;
+	}
+
+	const double step = rho / (dir * prod);
+
+	for(int i = 0; i < global_size; ++i) {
+	  sol[i] += step * dir[i];
+	  res[i] -= step * prod[i];
+	}
+
+	if(vlength(res, global_size) < tolerance * rhs_norm)
+	  break;
+
+	if(iter == iter_max) {
+	  std::cerr << funame << "iterative eigensolver: conjugate gradient did not converge\n";
+	  throw Error::Math();
+	}
+      }
+
+      IO::log << IO::log_offset << Model::bimolecular(p).name() << ": " << iter + 1 << " conjugate gradient iterations\n";
+    }
   }
+  else if(Model::bimolecular_size() && sparse) {
+    //
+    // the modified kinetic matrix, K + cfreq * X * X^T, is applied without being formed; the
+    // preconditioner is its band part inverted by the Woodbury formula,
+    // (B + cfreq * X * X^T)^-1 = B^-1 - Y * (I / cfreq + X^T * Y)^-1 * Y^T, Y = B^-1 * X,
+    // with B being the shifted band of K
+    //
+    IO::Marker solve_marker("bimolecular source terms by band preconditioned conjugate gradient");
 
-  // eigenvector output
-  if(evec_out.is_open()) {
-    evec_out << "EIGENVECTORS:\n";
-    int evec_max = Model::well_size() + evec_out_num;
-    for(int l = 0; l < evec_max; ++l) {
-      evec_out << "l = " << l << "\n"
-	       << "eigenvalue / collision frequency = "
-	       << eigenval[l] / well(0).collision_frequency() 
-	       << "\n";
+    Threads::BlasScope blas_scope;
 
-      evec_out << std::setw(13) << "well length";
-      for(int w = 0; w < Model::well_size(); ++w)
-	evec_out << std::setw(13) << eigen_well(l, w);
-      evec_out << "\n";
+    std::vector<int> band_index;
+    const int band_size = interleaved_band_index(well_shift, global_size, band_index);
 
-      evec_out << std::setw(13) << "E, kcal/mol";
-      for(int w = 0; w < Model::well_size(); ++w)
-	evec_out << std::setw(13) << Model::well(w).name();
-      for(int w = 0; w < Model::well_size(); ++w)
-	evec_out << std::setw(13) << Model::well(w).name();
-      evec_out << "\n";
+    IO::log << IO::log_offset << "relaxation matrix band size = " << band_size << "\n";
 
-      for(int i = 0; i < well_size_max; ++i) {
-	evec_out << std::setw(13) << (energy_reference() - (double)i * energy_step()) / Phys_const::kcal;
-	for(int w = 0; w < Model::well_size(); ++w)
-	  if(i < well(w).size()) {
-	    // micropopulational distribution
-	    dtemp = eigen_global(l, well_shift[w] + i) * well(w).boltzman_sqrt(i); 
-	    evec_out << std::setw(13) << dtemp;
-	  }
-	  else
-	    evec_out << std::setw(13) << 0;
-	for(int w = 0; w < Model::well_size(); ++w)
-	  if(i < well(w).size()) {
-	    // ratio to the thermal distribution
-	    dtemp = eigen_global(l, well_shift[w] + i) / well(w).boltzman_sqrt(i) 
-	      * well(w).weight_sqrt();
-	    evec_out << std::setw(13) << dtemp;
-	  }
-	  else
-	    evec_out << std::setw(13) << 0;
-	evec_out << "\n";
+    Lapack::BandMatrix band_mat(global_size, band_size);
+    band_mat = 0.;
+
+    for(int i = 0; i < global_size; ++i)
+      for(int j = 0; j < global_size; ++j) {
+	const int bi = band_index[i];
+	const int bj = band_index[j];
+	if(bi <= bj && bj < bi + band_size)
+	  band_mat(bi, bj) = kin_mat.dense(i, j);
       }
-    }
-    evec_out << "\n";
-  }
 
-  /********************************** CHEMICAL SUBSPACE DIMENSION ****************************************/
+    for(int i = 0; i < global_size; ++i)
+      band_mat(i, i) += band_shift;
 
-  //
-  // predefined chemical subspace dimension
-  //
-  if(_default_chem_size >= 0) {
-    //
-    itemp = _default_chem_size;
-  }
-  //
-  // default partitioning scheme
-  //
-  else if(default_partition.size()) {
-    //
-    itemp = default_partition.size();
-  }
-  //
-  // absolute eigenvalue threshold
-  //
-  else if(chemical_threshold > 1.) {
-    //
-    for(itemp = 0; itemp < Model::well_size(); ++itemp)
-      //
-      if(min_relax_eval / eigenval[itemp]  < chemical_threshold)
-	//
-	break;
-  }
-  //
-  // relaxation projection threshold
-  //
-  else if(chemical_threshold < 1. && chemical_threshold > 0.) {
-    //
-    for(itemp = 0; itemp < Model::well_size(); ++itemp)
+    const Lapack::BandCholesky sparse_fac(band_mat);
+
+    // chemical eigenvectors in the band order, Y, and the Cholesky factors of the capacitance matrix
+    Lapack::Matrix band_chem, upd_chem;
+    std::vector<Lapack::Cholesky> cap_fac;
+    if(chem_size) {
       //
-      if(relaxation_projection[itemp] > chemical_threshold)
-	//
-	break;
-  }
-  //
-  // relative eigenvalue threshold
-  //
-  else if(chemical_threshold < -1. ) {
-    //
-    for(itemp = Model::well_size(); itemp > 0; --itemp)
+      band_chem.resize(global_size, chem_size);
+      for(int i = 0; i < global_size; ++i)
+	for(int l = 0; l < chem_size; ++l)
+	  band_chem(band_index[i], l) = chem_vec(l, i);
+
+      upd_chem = sparse_fac.invert(band_chem);
+
+      Lapack::SymmetricMatrix cap_mat(chem_size);
+      for(int l = 0; l < chem_size; ++l)
+	for(int m = l; m < chem_size; ++m) {
+	  dtemp = 0.;
+	  for(int i = 0; i < global_size; ++i)
+	    dtemp += band_chem(i, l) * upd_chem(i, m);
+	  cap_mat(l, m) = l == m ? dtemp + 1. / cfreq : dtemp;
+	}
+
+      cap_fac.push_back(Lapack::Cholesky(cap_mat));
+    }
+
+    inv_proj_bim.resize(global_size, Model::bimolecular_size());
+    inv_proj_bim = 0.;
+
+    const double tolerance = 1.e-12;
+    const int    iter_max  = global_size > 100 ? global_size : 100;
+
+    Lapack::Vector res(global_size), pre(global_size), dir(global_size), prod, band_vec(global_size);
+
+    for(int p = 0; p < Model::bimolecular_size(); ++p) {
       //
-      if(eigenval[itemp] / eigenval[itemp - 1] > - chemical_threshold)
+      double* sol = &inv_proj_bim(0, p);
+
+      for(int i = 0; i < global_size; ++i)
+	res[i] = proj_bim(i, p);
+
+      const double rhs_norm = vlength(res, global_size);
+      
+      if(rhs_norm == 0.)
+	continue;
+
+      double rho_old = 0.;
+      int iter = 0;
+      for(; ; ++iter) {
 	//
-	break;
-  }
-  //
-  else
-    //
-    itemp = Model::well_size();
+	// band preconditioner with the low-rank update
+	for(int i = 0; i < global_size; ++i)
+	  band_vec[band_index[i]] = res[i];
+
+	band_vec = sparse_fac.invert(band_vec);
+
+	if(chem_size) {
+	  //
+	  vtemp = cap_fac[0].invert(band_vec * band_chem);
+	  band_vec -= upd_chem * vtemp;
+	}
 	
-  const int chem_size = itemp;
+	for(int i = 0; i < global_size; ++i)
+	  pre[i] = band_vec[band_index[i]];
 
-  if(chem_size != Model::well_size())
-    //
-    IO::log << IO::log_offset << "dimension of the chemical subspace = " << chem_size << "\n";
+	const double rho = res * pre;
 
-  /***** PARTITIONING THE GLOBAL PHASE SPACE INTO THE CHEMICAL AND COLLISIONAL SUBSPACES *****/
+	if(iter)
+	  for(int i = 0; i < global_size; ++i)
+	    dir[i] = pre[i] + rho / rho_old * dir[i];
+	else
+	  dir = pre.copy();
 
-  // collisional relaxation eigenvalues and eigenvectors
-  const int relax_size = global_size - chem_size;
-  Lapack::Vector relax_lave(relax_size);
-  for(int r = 0; r < relax_size; ++r) {
-    itemp = r + chem_size;
-    relax_lave[r] = 1. / eigenval[itemp];
-  }
+	rho_old = rho;
 
-  // kinetic matrix modified
+	// modified kinetic matrix times the search direction
+	prod = kin_mat.dense * dir;
+	if(chem_size) {
+	  //
+	  vtemp = chem_vec * dir;
+	  vtemp *= cfreq;
+	  prod += vtemp * chem_vec;
+	}
 
-#pragma omp parallel for default(shared) private(dtemp) schedule(dynamic)
-	
-  for(int i = 0; i < global_size; ++i) {
-    for(int j = i; j < global_size; ++j) {
-      dtemp = 0.;
-      for(int l = 0; l < chem_size; ++l)
-	dtemp += eigen_global(l, i) * eigen_global(l, j);
-      kin_mat(i, j) += dtemp * well(0).collision_frequency();
-    }
-  }
+	const double step = rho / (dir * prod);
 
-  Lapack::Matrix proj_bim = global_bim.copy();
-  for(int p = 0; p < Model::bimolecular_size(); ++p)
-    for(int l = 0; l < chem_size; ++l)
-      parallel_orthogonalize(&proj_bim(0, p), &eigen_global(l, 0), global_size, 1, global_size);
+	for(int i = 0; i < global_size; ++i) {
+	  sol[i] += step * dir[i];
+	  res[i] -= step * prod[i];
+	}
 
-  Lapack::Matrix inv_proj_bim; 
-  if(Model::bimolecular_size())
-    inv_proj_bim = Lapack::Cholesky(kin_mat).invert(proj_bim);
+	if(vlength(res, global_size) < tolerance * rhs_norm)
+	  break;
+
+	if(iter == iter_max) {
+	  std::cerr << funame << "band preconditioner: conjugate gradient did not converge\n";
+	  throw Error::Math();
+	}
+      }
+
+      IO::log << IO::log_offset << Model::bimolecular(p).name() << ": " << iter + 1 << " conjugate gradient iterations\n";
+    }
+  }
 
   Lapack::Matrix proj_pop = global_pop.copy();
-  for(int w = 0; w < Model::well_size(); ++w)
-    for(int l = 0; l < chem_size; ++l)
-      parallel_orthogonalize(&proj_pop(0, w), &eigen_global(l, 0), global_size, 1, global_size);
+  if(chem_size) {
+    //
+    Threads::BlasScope blas_scope;
+
+    proj_pop.add_transpose_product(chem_vec, chem_vec * proj_pop, -1.);
+  }
   
   // kappa matrix
   //
   if(Model::bimolecular_size()) {
     //
-    Lapack::Matrix kappa = proj_pop.transpose() * inv_proj_bim;
+    Lapack::Matrix kappa = proj_pop.transpose_product(inv_proj_bim);
 
     IO::log << std::setprecision(2)
 	    << IO::log_offset << "isomers-to-bimolecular equilibrium coefficients (kappa matrix):\n"
@@ -4287,7 +7996,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
   // bimolecular-to-bimolecular rate coefficients
   //
   if(Model::bimolecular_size()) {
-    Lapack::SymmetricMatrix bb_rate = Lapack::SymmetricMatrix(proj_bim.transpose() * inv_proj_bim);
+    Lapack::SymmetricMatrix bb_rate = Lapack::SymmetricMatrix(proj_bim.transpose_product(inv_proj_bim));
     //  Lapack::SymmetricMatrix bb_rate(Model::bimolecular_size());
     //  for(int i = 0; i < Model::bimolecular_size(); ++i)
     //    for(int j = i; j < Model::bimolecular_size(); ++j)
@@ -4323,9 +8032,9 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
       Lapack::Matrix proj_escape = global_escape.copy();
       for(int count = 0; count < Model::escape_size(); ++count)
 	for(int l = 0; l < chem_size; ++l)
-	  parallel_orthogonalize(&proj_escape(0, count), &eigen_global(l, 0), global_size, 1, global_size);
+	  parallel_orthogonalize(&proj_escape(0, count), &eigen_global(l, 0), global_size, 1, eval_size);
     
-      Lapack::Matrix escape_bim = proj_escape.transpose() * inv_proj_bim;
+      Lapack::Matrix escape_bim = proj_escape.transpose_product(inv_proj_bim);
       */
 	
       for(int p = 0; p < Model::bimolecular_size(); ++p)
@@ -4343,26 +8052,62 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 
   // product energy distributions
   if(ped_out.is_open()) {
+    std::ostringstream ped_title;
     switch(pressure_unit) {
     case BAR:
-      ped_out << "pressure[bar]        = " << pressure() / Phys_const::bar << "\n";
+      ped_title << "pressure[bar]        = " << pressure() / Phys_const::bar << "\n";
       break;
     case TORR:
-      ped_out << "pressure[torr]       = " << pressure() / Phys_const::tor << "\n";
+      ped_title << "pressure[torr]       = " << pressure() / Phys_const::tor << "\n";
       break;
     case ATM:
-      ped_out << "pressure[atm]        = " << pressure() / Phys_const::atm << "\n";
+      ped_title << "pressure[atm]        = " << pressure() / Phys_const::atm << "\n";
       break;
     }
-    ped_out << "temperature[K]       = " << temperature() / Phys_const::kelv << "\n"
-	    << "energy step[1/cm]    = " << energy_step() / Phys_const::incm << "\n"
-	    << "maximum energy[1/cm] = " << energy_reference() / Phys_const::incm << "\n\n";
+    ped_title << "temperature[K]       = " << temperature() / Phys_const::kelv << "\n"
+	      << "energy step[1/cm]    = " << energy_step() / Phys_const::incm << "\n"
+	      << "maximum energy[1/cm] = " << energy_reference() / Phys_const::incm << "\n\n";
+    IO::put_text(ped_out, ped_title.str());
 
     int ener_index_max;
 
+    // hot energies grid columns
+    std::vector<int> hot_col;
+    for(std::map<int, std::vector<int> >::const_iterator hit = context().hot_index.begin(); hit != context().hot_index.end(); ++hit)
+      for(int i = 0; i < hit->second.size(); ++i)
+	hot_col.push_back(hit->second[i] + well_shift[hit->first]);
+
+    // the relaxation modes weighted by the largest projection of the initial distributions
+    std::vector<int> relax_mode;
+    {
+      std::vector<double> relax_scale(relax_size);
+      for(int r = 0; r < relax_size; ++r) {
+	dtemp = 0.;
+	for(int p = 0; p < Model::bimolecular_size(); ++p)
+	  dtemp = std::max(dtemp, std::fabs(eigen_bim(chem_size + r, p)));
+	for(int h = 0; h < hot_col.size(); ++h)
+	  dtemp = std::max(dtemp, std::fabs(eigen_global(chem_size + r, hot_col[h])));
+	relax_scale[r] = dtemp * std::fabs(relax_lave[r]);
+      }
+
+      dtemp = relax_size ? *std::max_element(relax_scale.begin(), relax_scale.end()) : 0.;
+      for(int r = 0; r < relax_size; ++r)
+	if(relax_scale[r] >= ped_tolerance * dtemp)
+	  relax_mode.push_back(r);
+
+      if(relax_mode.size() < relax_size)
+	IO::log << IO::log_offset << "product energy distributions: " << relax_mode.size()
+		<< " relaxation modes out of " << relax_size << " used\n";
+    }
+
+    // relaxation modes contractions of the eigenvectors at the barriers energies
+    std::vector<Lapack::Matrix> relax_barrier(Model::outer_barrier_size());
+    for(int b = 0; b < Model::outer_barrier_size(); ++b)
+      relax_barrier[b] = relaxation_columns(eigen_global, chem_size, relax_mode, barrier_columns(b, well_shift));
+
     if(Model::bimolecular_size()) {
       // bimolecular-to-bimolecular product energy distributions
-      ped_out << "Bimolecular-to-bimolecular product energy distributions:\n";
+      IO::put_text(ped_out, "Bimolecular-to-bimolecular product energy distributions:\n");
 
       // dimensions
       itemp = 0;
@@ -4373,42 +8118,39 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 
       ener_index_max = itemp;
       mtemp.resize(itemp, ped_pair.size());
+      mtemp = 0.;
 
-      // distribution
-      for(int e = 0; e < ener_index_max; ++e)
-	for(int ped = 0; ped < ped_pair.size(); ++ ped) {
-	  dtemp = 0.;
-	  for(int b = 0; b < Model::outer_barrier_size(); ++b) {
-	    const int w = Model::outer_connect(b).first;
-	    const int p = Model::outer_connect(b).second;
-	    if(p == ped_pair[ped].second && e < outer_barrier(b).size())
-	      dtemp += global_bim(e + well_shift[w], p) *
-		triple_product(&eigen_bim(chem_size, ped_pair[ped].first), relax_lave, 
-			       &eigen_global(chem_size, e + well_shift[w]), relax_size);
-	  }
-	  mtemp(e, ped) = dtemp;
-	}
+      // distribution: all pairs at once
+      std::vector<int> ped_source(ped_pair.size());
+      for(int ped = 0; ped < ped_pair.size(); ++ ped)
+	ped_source[ped] = ped_pair[ped].first;
+
+      const Lapack::Matrix relax_source = relaxation_columns(eigen_bim, chem_size, relax_mode, ped_source, relax_lave);
+
+      for(int b = 0; b < Model::outer_barrier_size(); ++b) {
+	const int w = Model::outer_connect(b).first;
+	const int p = Model::outer_connect(b).second;
+
+	const Lapack::Matrix ped_val = relax_barrier[b].transpose_product(relax_source);
+
+	for(int ped = 0; ped < ped_pair.size(); ++ ped)
+	  if(p == ped_pair[ped].second)
+	    for(int e = 0; e < outer_barrier(b).size(); ++e)
+	      mtemp(e, ped) += global_bim(e + well_shift[w], p) * ped_val(e, ped);
+      }
     
       // normalization
       for(int i = 0; i < mtemp.size2(); ++i)
 	mtemp.column(i) /= max(mtemp.column(i));
 
       // output
-      ped_out << std::setw(13) << "E, kcal/mol";
+      std::vector<std::string> title;
       for(int ped = 0; ped < ped_pair.size(); ++ ped)
-	ped_out << std::setw(13) << Model::bimolecular(ped_pair[ped].first).name() + "->"
-	  + Model::bimolecular(ped_pair[ped].second).name();
-      ped_out << "\n";
-
-      for(int e = 0; e < ener_index_max; ++e) {
-	dtemp = (energy_reference() - e * energy_step()) / Phys_const::kcal;
-	ped_out << std::setw(13) << dtemp;
+	title.push_back(Model::bimolecular(ped_pair[ped].first).name() + "->"
+			+ Model::bimolecular(ped_pair[ped].second).name());
 
-	for(int i = 0; i < mtemp.size2(); ++i)
-	  ped_out << std::setw(13) << mtemp(e, i);
-	ped_out << "\n";
-      }
-      ped_out << "\n";
+      energy_table_output(ped_out, title, mtemp, ener_index_max);
+      IO::put_text(ped_out, "\n");
 
       // escape product energy distributions
       //
@@ -4416,40 +8158,50 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 	//
 	// Hot energies-to-escape channels distribution
 	//
-	if(hot_energy_size) {
+	if(context().hot_energy_size) {
 	  //
-	  ped_out << "Hot-to-escape product energy distributions:\n";
+	  IO::put_text(ped_out, "Hot-to-escape product energy distributions:\n");
 
 	  std::map<int, std::vector<int> >::const_iterator hit;
+
+	  const Lapack::Matrix relax_hot = relaxation_columns(eigen_global, chem_size, relax_mode, hot_col, relax_lave);
 	  
 	  for(int esin = 0; esin < Model::escape_size(); ++esin) {
 	    //
 	    const int ew = Model::escape_well_index(esin);
 
 	    vtemp.resize(well(ew).size());
+
+	    std::vector<int> escape_col(well(ew).size());
+	    for(int ee = 0; ee < well(ew).size(); ++ee)
+	      escape_col[ee] = ee + well_shift[ew];
+
+	    const Lapack::Matrix escape_val = relaxation_columns(eigen_global, chem_size, relax_mode, escape_col)
+	      .transpose_product(relax_hot);
+
+	    int count = 0;
 	    
-	    for(hit = hot_index.begin(); hit != hot_index.end(); ++hit) {
+	    for(hit = context().hot_index.begin(); hit != context().hot_index.end(); ++hit) {
 	      //
 	      const int& hw = hit->first;
 	      
-	      for(int hi = 0; hi < hit->second.size(); ++hi) {
+	      for(int hi = 0; hi < hit->second.size(); ++hi, ++count) {
 		//
 		const int& he = hit->second[hi];
 		
 		dtemp = (energy_reference() - (double)he * energy_step()) / Phys_const::kcal;
 		
-		ped_out << "Hot[" << Model::well(hw).name() << ", E = " << dtemp << " kcal/mol] ---> "
+		std::ostringstream initial;
+		initial << "Hot[" << Model::well(hw).name() << ", E = " << dtemp << " kcal/mol] ---> "
 		  //
 			<< "Escape[" << Model::well(ew).name() << "]\n\n";
+		IO::put_text(ped_out, initial.str());
 
 		double nfac;
 		
 		for(int ee = 0; ee < well(ew).size(); ++ee) {
 		  //
-		  dtemp = triple_product(&eigen_global(chem_size, he + well_shift[hw]), relax_lave, 
-					 &eigen_global(chem_size, ee + well_shift[ew]), relax_size)
-		    //
-		    * well(ew).escape_rate(ee) * well(ew).boltzman_sqrt(ee);
+		  dtemp = escape_val(ee, count) * well(ew).escape_rate(ee) * well(ew).boltzman_sqrt(ee);
 
 		  vtemp[ee] = dtemp;
 		  
@@ -4462,16 +8214,14 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 		
 		// output
 		//
-		ped_out << std::setw(13) << "E, kcal/mol" << std::setw(13) << "PED, a.u." << "\n";
-
-		for(int ee = 0; ee < well(ew).size(); ++ee) {
+		Lapack::Matrix ped(well(ew).size(), 1);
+		for(int ee = 0; ee < well(ew).size(); ++ee)
 		  //
-		  dtemp = (energy_reference() - ee * energy_step()) / Phys_const::kcal;
-		  
-		  ped_out << std::setw(13) << dtemp << std::setw(13) << vtemp[ee] << "\n";
-		}
+		  ped(ee, 0) = vtemp[ee];
+
+		energy_table_output(ped_out, std::vector<std::string>(1, "PED, a.u."), ped, well(ew).size());
 
-		ped_out << "\n";
+		IO::put_text(ped_out, "\n");
 	      }
 	    }
 	  }
@@ -4479,7 +8229,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 	//
 	// bimolecular-to-escape product energy distributions
 	//
-	ped_out << "Bimolecular-to-escape product energy distributions:\n";
+	IO::put_text(ped_out, "Bimolecular-to-escape product energy distributions:\n");
 
 	// dimensions
 	//
@@ -4503,20 +8253,31 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 	itemp *= Model::escape_size();
 
 	mtemp.resize(ener_index_max, itemp);
+	mtemp = 0.;
 
-	for(int e = 0; e < ener_index_max; ++e) {
-	  itemp = 0;
+	std::vector<int> bim_source(Model::bimolecular_size());
+	for(int p = 0; p < Model::bimolecular_size(); ++p)
+	  bim_source[p] = p;
+
+	const Lapack::Matrix relax_bim = relaxation_columns(eigen_bim, chem_size, relax_mode, bim_source, relax_lave);
+
+	for(int count = 0; count < Model::escape_size(); ++count) {
+	  const int w = Model::escape_well_index(count);
+
+	  std::vector<int> escape_col(well(w).size());
+	  for(int e = 0; e < well(w).size(); ++e)
+	    escape_col[e] = e + well_shift[w];
+
+	  const Lapack::Matrix escape_val = relaxation_columns(eigen_global, chem_size, relax_mode, escape_col)
+	    .transpose_product(relax_bim);
+
+	  itemp = count;
 	  for(int p = 0; p < Model::bimolecular_size(); ++p)
-	    if(!Model::bimolecular(p).dummy())
-	      for(int count = 0; count < Model::escape_size(); ++count, ++itemp) {
-		const int w = Model::escape_well_index(count);
-		if(e < well(w).size())
-		  mtemp(e, itemp) =  global_escape(e + well_shift[w], count) *
-		    triple_product(&eigen_bim(chem_size, p), relax_lave, 
-				   &eigen_global(chem_size, e + well_shift[w]), relax_size);
-		else
-		  mtemp(e, itemp) = 0.;
-	      }
+	    if(!Model::bimolecular(p).dummy()) {
+	      for(int e = 0; e < well(w).size(); ++e)
+		mtemp(e, itemp) = global_escape(e + well_shift[w], count) * escape_val(e, p);
+	      itemp += Model::escape_size();
+	    }
 	}
 
 	// normalization
@@ -4524,28 +8285,20 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 	  mtemp.column(i) /= max(mtemp.column(i));
 
 	// output
-	ped_out<< std::setw(13) << "E, kcal/mol";
+	title.clear();
 	for(int p = 0; p < Model::bimolecular_size(); ++p)
 	  if(!Model::bimolecular(p).dummy()) 
 	    for(int count = 0; count < Model::escape_size(); ++count)
-	      ped_out << std::setw(13) << Model::bimolecular(p).name() 
-		+ "->" + Model::well(Model::escape_well_index(count)).name();
-	ped_out << "\n";
-
-	for(int e = 0; e < ener_index_max; ++e) {
-	  dtemp = (energy_reference() - e * energy_step()) / Phys_const::kcal;
-	  ped_out << std::setw(13) << dtemp;
+	      title.push_back(Model::bimolecular(p).name() 
+			      + "->" + Model::well(Model::escape_well_index(count)).name());
 
-	  for(int i = 0; i < mtemp.size2(); ++i)
-	    ped_out << std::setw(13) << mtemp(e, i);
-	  ped_out << "\n";
-	}
-	ped_out << "\n";
+	energy_table_output(ped_out, title, mtemp, ener_index_max);
+	IO::put_text(ped_out, "\n");
       }// escape output
 
       // hot product energy distributions
-      if(hot_energy_size) {
-	ped_out << "Hot product energy distributions:\n\n";
+      if(context().hot_energy_size) {
+	IO::put_text(ped_out, "Hot product energy distributions:\n\n");
 
 	// dimension
 	itemp = 0;
@@ -4556,14 +8309,27 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 	ener_index_max = itemp;
 	mtemp.resize(itemp, Model::bimolecular_size());
 
+	// relaxation modes contractions for all the hot energies at once
+	std::vector<int> hot_source(hot_col.size());
+	for(int h = 0; h < hot_col.size(); ++h)
+	  hot_source[h] = h;
+
+	const Lapack::Matrix relax_hot = relaxation_columns(eigen_hot, chem_size, relax_mode, hot_source, relax_lave);
+
+	std::vector<Lapack::Matrix> hot_val(Model::outer_barrier_size());
+	for(int b = 0; b < Model::outer_barrier_size(); ++b)
+	  hot_val[b] = relax_barrier[b].transpose_product(relax_hot);
+
 	// hot energy cycle
 	int count = 0;
 	std::map<int, std::vector<int> >::const_iterator hit;
-	for(hit = hot_index.begin(); hit != hot_index.end(); ++hit)
+	for(hit = context().hot_index.begin(); hit != context().hot_index.end(); ++hit)
 	  for(int i = 0; i < hit->second.size(); ++i, ++count) {
 	    dtemp = (energy_reference() - (double)hit->second[i] * energy_step()) / Phys_const::kcal;
-	    ped_out << "Initial well: "<< Model::well(hit->first).name()
+	    std::ostringstream initial;
+	    initial << "Initial well: "<< Model::well(hit->first).name()
 		    << "Initial energy[kcal/mol] = " << dtemp << "\n";
+	    IO::put_text(ped_out, initial.str());
 
 	    // distribution
 	    for(int e = 0; e < ener_index_max; ++e)
@@ -4572,9 +8338,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 		for(int b = 0; b < Model::outer_barrier_size(); ++b) {
 		  const int w = Model::outer_connect(b).first;
 		  if(p == Model::outer_connect(b).second && e < outer_barrier(b).size())
-		    dtemp += global_bim(e + well_shift[w], p) *
-		      triple_product(&eigen_global(chem_size, e + well_shift[w]), relax_lave, 
-				     &eigen_hot(chem_size, count), relax_size);
+		    dtemp += global_bim(e + well_shift[w], p) * hot_val[b](e, count);
 		}
 		mtemp(e, p) = dtemp;
 	      }
@@ -4584,20 +8348,12 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 	      mtemp.column(i) /= max(mtemp.column(i));
 
 	    //output
-	    ped_out << std::setw(13) << "E, kcal/mol";
+	    title.clear();
 	    for(int p = 0; p < Model::bimolecular_size(); ++p)
-	      ped_out << std::setw(13) << Model::bimolecular(p).name();
-	    ped_out << "\n";
+	      title.push_back(Model::bimolecular(p).name());
 	
-	    for(int e = 0; e < ener_index_max; ++e) {
-	      dtemp = (energy_reference() - e * energy_step()) / Phys_const::kcal;
-	      ped_out << std::setw(13) << dtemp;
-
-	      for(int i = 0; i < mtemp.size2(); ++i)
-		ped_out << std::setw(13) << mtemp(e, i);
-	      ped_out << "\n";
-	    }
-	    ped_out << "\n";
+	    energy_table_output(ped_out, title, mtemp, ener_index_max);
+	    IO::put_text(ped_out, "\n");
 	  }// hot energy cycle
       }// hot distributions
     }
@@ -4670,7 +8426,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 	      << (double)chem_size - well_partition.projection(pop_chem) << "\n";
     
       // convert chemical eigenvectors in the new basis
-      pop_chem = well_partition.basis().transpose() * pop_chem;
+      pop_chem = well_partition.basis().transpose_product(pop_chem);
     }
     else if(chem_size == Model::well_size()) {
       // no partitioning
@@ -4687,7 +8443,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
       dtemp = well_partition_method(pop_chem, well_partition, bimolecular_group, std::vector<double>());
 
       // convert chemical eigenvectors in the new basis
-      pop_chem = well_partition.basis().transpose() * pop_chem;
+      pop_chem = well_partition.basis().transpose_product(pop_chem);
     }
 
     group_index = well_partition.group_index();
@@ -4817,21 +8573,205 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 	  rate_data[std::make_pair(group_index[w], Model::well_size() +  
 				   Model::bimolecular_size() + itemp)] = dtemp;
 	}
-  
-    // well-to-bimolecular rate coefficients
-    for(int w = 0; w < chem_size; ++w)
-      for(int p = 0; p < Model::bimolecular_size(); ++p) {
-	dtemp = wb_rate(w, p) * std::sqrt(weight[w]) * energy_step() / real_weight[w] / Phys_const::herz;
-	rate_data[std::make_pair(group_index[w], Model::well_size() + p)] = dtemp;
+  
+    // well-to-bimolecular rate coefficients
+    for(int w = 0; w < chem_size; ++w)
+      for(int p = 0; p < Model::bimolecular_size(); ++p) {
+	dtemp = wb_rate(w, p) * std::sqrt(weight[w]) * energy_step() / real_weight[w] / Phys_const::herz;
+	rate_data[std::make_pair(group_index[w], Model::well_size() + p)] = dtemp;
+      }
+    
+    // bimolecular-to-well rate coefficients
+    for(int p = 0; p < Model::bimolecular_size(); ++p)
+      if(bimolecular(p).weight() > 0.)
+	for(int w = 0; w < chem_size; ++w) {
+	  dtemp = bw_rate(p, w) * std::sqrt(weight[w]) * energy_step() / bimolecular(p).weight() / bru;
+	  rate_data[std::make_pair(Model::well_size() + p, group_index[w])] = dtemp;
+	}
+
+    // sensitivities of the rate coefficients to the barrier energies: the barrier shift
+    // changes the number of states by -dN/dE, the eigenpairs are perturbed in the first order,
+    // d(lambda_l) = <l|D|l>, d|l> = sum_m |m> <m|D|l> / (lambda_l - lambda_m)
+    if(sens_out.is_open()) {
+      //
+      sens_out << "Temperature = " << temperature() / Phys_const::kelv << " K    Pressure = ";
+      switch(pressure_unit) {
+      case BAR:
+	sens_out << pressure() / Phys_const::bar << " bar\n";
+	break;
+      case TORR:
+	sens_out << pressure() / Phys_const::tor << " torr\n";
+	break;
+      case ATM:
+	sens_out << pressure() / Phys_const::atm << " atm\n";
+	break;
+      }
+
+      if(banded || lumped || kin_mat.is_dist() || eval_size < global_size || low_eval_used
+	 || chem_size != Model::well_size() || default_partition.size()) {
+	sens_out << "sensitivities are available for the full spectrum of the dense relaxation matrix "
+	  "without the low eigenvalue method, lumping, and well partitioning\n\n";
+      }
+      else {
+	//
+	const int bsize = Model::bimolecular_size();
+
+	sens_out << "d(ln k)/dE_barrier, mol/kcal:\n" << std::left << std::setw(13) << "Reaction" << std::right;
+	for(int b = 0; b < Model::inner_barrier_size(); ++b)
+	  sens_out << std::setw(13) << Model::inner_barrier(b).name();
+	for(int b = 0; b < Model::outer_barrier_size(); ++b)
+	  sens_out << std::setw(13) << Model::outer_barrier(b).name();
+	sens_out << "\n";
+
+	const int bar_size = Model::inner_barrier_size() + Model::outer_barrier_size();
+
+	// rate coefficients derivatives: well-to-well, well-to-bimolecular, bimolecular-to-well
+	std::vector<Lapack::Matrix> dww(bar_size), dwb(bar_size), dbw(bar_size);
+	
+	for(int bb = 0; bb < bar_size; ++bb) {
+	  //
+	  const bool inner = bb < Model::inner_barrier_size();
+	  const int  b     = inner ? bb : bb - Model::inner_barrier_size();
+
+	  const Barrier& bar = inner ? inner_barrier(b) : outer_barrier(b);
+	  const int w1 = inner ? Model::inner_connect(b).first  : Model::outer_connect(b).first;
+	  const int w2 = inner ? Model::inner_connect(b).second : -1;
+
+	  const int size = bar.size();
+
+	  // number of states derivative over 2 Pi
+	  std::vector<double> dn(size);
+	  for(int i = 0; i < size; ++i) {
+	    const int    hi = i ? i - 1 : i;
+	    const double lo = i + 1 < size ? bar.state_number(i + 1) : 0.;
+	    
+	    dn[i] = (lo - bar.state_number(hi)) / double(i + 1 - hi) / energy_step() / 2. / M_PI;
+	  }
+
+	  // the perturbation is the sum of the rank one terms |a_i> dn_i <a_i|
+	  Lapack::Matrix a(eval_size, size);
+	  for(int i = 0; i < size; ++i) {
+	    const double f1 = 1. / std::sqrt(well(w1).state_density(i));
+	    const double f2 = inner ? 1. / std::sqrt(well(w2).state_density(i)) : 0.;
+
+	    for(int m = 0; m < eval_size; ++m) {
+	      dtemp = eigen_global(m, i + well_shift[w1]) * f1;
+	      if(inner)
+		dtemp -= eigen_global(m, i + well_shift[w2]) * f2;
+	      a(m, i) = dtemp;
+	    }
+	  }
+
+	  // <m|D|l> for the chemical l, converted into the eigenvector expansion coefficients
+	  Lapack::Matrix coef(eval_size, chem_size);
+	  Lapack::Vector deval(chem_size);
+	  for(int l = 0; l < chem_size; ++l)
+	    for(int m = 0; m < eval_size; ++m) {
+	      dtemp = 0.;
+	      for(int i = 0; i < size; ++i)
+		dtemp += a(m, i) * dn[i] * a(l, i);
+
+	      if(m == l) {
+		deval[l]   = dtemp;
+		coef(m, l) = 0.;
+	      }
+	      else
+		coef(m, l) = dtemp / (eigenval[l] - eigenval[m]);
+	    }
+
+	  // chemical eigenvectors projections derivatives
+	  Lapack::Matrix dm(Model::well_size(), chem_size);
+	  for(int w = 0; w < Model::well_size(); ++w)
+	    for(int l = 0; l < chem_size; ++l) {
+	      dtemp = 0.;
+	      for(int m = 0; m < eval_size; ++m)
+		dtemp += coef(m, l) * eigen_pop(m, w);
+	      dm(w, l) = dtemp;
+	    }
+
+	  Lapack::Matrix deb;
+	  if(bsize) {
+	    deb.resize(chem_size, bsize);
+	    for(int l = 0; l < chem_size; ++l)
+	      for(int p = 0; p < bsize; ++p) {
+		dtemp = 0.;
+		for(int m = 0; m < eval_size; ++m)
+		  dtemp += coef(m, l) * eigen_bim(m, p);
+
+		// bimolecular vector derivative
+		if(!inner && p == Model::outer_connect(b).second)
+		  for(int i = 0; i < size; ++i)
+		    dtemp += eigen_global(l, i + well_shift[w1]) * dn[i] * thermal_factor(i) / well(w1).boltzman_sqrt(i);
+
+		deb(l, p) = dtemp;
+	      }
+	  }
+
+	  const Lapack::Matrix dminv = m_inverse * dm * m_inverse;
+
+	  dww[bb].resize(chem_size, chem_size);
+	  for(int i = 0; i < chem_size; ++i)
+	    for(int j = 0; j < chem_size; ++j) {
+	      dtemp = 0.;
+	      for(int l = 0; l < chem_size; ++l)
+		dtemp += (dm(j, l) * m_inverse(l, i) - m_direct(j, l) * dminv(l, i)) * eigenval[l]
+		  + m_direct(j, l) * m_inverse(l, i) * deval[l];
+	      dww[bb](i, j) = dtemp;
+	    }
+
+	  if(bsize) {
+	    dwb[bb].resize(chem_size, bsize);
+	    dbw[bb].resize(bsize, chem_size);
+	    for(int w = 0; w < chem_size; ++w)
+	      for(int p = 0; p < bsize; ++p) {
+		double dwb_val = 0., dbw_val = 0.;
+		for(int l = 0; l < chem_size; ++l) {
+		  dwb_val += m_inverse(l, w) * deb(l, p) - dminv(l, w) * eigen_bim(l, p);
+		  dbw_val += m_direct(w, l)  * deb(l, p) + dm(w, l)    * eigen_bim(l, p);
+		}
+		dwb[bb](w, p) = dwb_val;
+		dbw[bb](p, w) = dbw_val;
+	      }
+	  }
+	}
+
+	// relative derivatives
+	for(int i = 0; i < chem_size; ++i)
+	  for(int j = 0; j < chem_size; ++j) {
+	    sens_out << std::left << std::setw(13) << Model::well(i).name() + "->" + Model::well(j).name() << std::right;
+	    for(int bb = 0; bb < bar_size; ++bb)
+	      if(ww_rate(i, j) != 0.)
+		sens_out << std::setw(13) << dww[bb](i, j) / ww_rate(i, j) * Phys_const::kcal;
+	      else
+		sens_out << std::setw(13) << "***";
+	    sens_out << "\n";
+	  }
+
+	for(int w = 0; w < chem_size; ++w)
+	  for(int p = 0; p < bsize; ++p) {
+	    sens_out << std::left << std::setw(13) << Model::well(w).name() + "->" + Model::bimolecular(p).name() << std::right;
+	    for(int bb = 0; bb < bar_size; ++bb)
+	      if(wb_rate(w, p) != 0.)
+		sens_out << std::setw(13) << dwb[bb](w, p) / wb_rate(w, p) * Phys_const::kcal;
+	      else
+		sens_out << std::setw(13) << "***";
+	    sens_out << "\n";
+	  }
+
+	for(int p = 0; p < bsize; ++p)
+	  if(bimolecular(p).weight() > 0.)
+	    for(int w = 0; w < chem_size; ++w) {
+	      sens_out << std::left << std::setw(13) << Model::bimolecular(p).name() + "->" + Model::well(w).name() << std::right;
+	      for(int bb = 0; bb < bar_size; ++bb)
+		if(bw_rate(p, w) != 0.)
+		  sens_out << std::setw(13) << dbw[bb](p, w) / bw_rate(p, w) * Phys_const::kcal;
+		else
+		  sens_out << std::setw(13) << "***";
+	      sens_out << "\n";
+	    }
+	sens_out << "\n";
       }
-    
-    // bimolecular-to-well rate coefficients
-    for(int p = 0; p < Model::bimolecular_size(); ++p)
-      if(bimolecular(p).weight() > 0.)
-	for(int w = 0; w < chem_size; ++w) {
-	  dtemp = bw_rate(p, w) * std::sqrt(weight[w]) * energy_step() / bimolecular(p).weight() / bru;
-	  rate_data[std::make_pair(Model::well_size() + p, group_index[w])] = dtemp;
-	}
+    }
 
     // product energy distribution
     if(ped_out.is_open()) {    
@@ -4845,7 +8785,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
       if(Model::bimolecular_size()) {
 	mtemp.resize(itemp, Model::bimolecular_size());
 
-	ped_out << "Well-to-bimolecular product energy distributions:\n";
+	IO::put_text(ped_out, "Well-to-bimolecular product energy distributions:\n");
 	for(int ww = 0; ww < chem_size; ++ww) {
 	  for(int e = 0; e < ener_index_max; ++e)
 	    for(int p = 0; p < Model::bimolecular_size(); ++p) {
@@ -4863,21 +8803,13 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 	  for(int i = 0; i < mtemp.size2(); ++i)
 	    mtemp.column(i) /= max(mtemp.column(i));
 
-	  ped_out << std::setw(13) << "E, kcal/mol";
+	  std::vector<std::string> title;
 	  for(int p = 0; p < Model::bimolecular_size(); ++p)
-	    ped_out << std::setw(13) << Model::well(group_index[ww]).name() + "->"
-	      + Model::bimolecular(p).name();
-	  ped_out << "\n";
+	    title.push_back(Model::well(group_index[ww]).name() + "->"
+			    + Model::bimolecular(p).name());
 
-	  for(int e = 0; e < ener_index_max; ++e) {
-	    dtemp = (energy_reference() - e * energy_step()) / Phys_const::kcal;
-	    ped_out << std::setw(13) << dtemp;
-
-	    for(int i = 0; i < mtemp.size2(); ++i)
-	      ped_out << std::setw(13) << mtemp(e, i);
-	    ped_out << "\n";
-	  }
-	  ped_out << "\n";
+	  energy_table_output(ped_out, title, mtemp, ener_index_max);
+	  IO::put_text(ped_out, "\n");
 	}//well-to-bimolecular
       }
 
@@ -4911,30 +8843,22 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
 	  mtemp.column(i) /= max(mtemp.column(i));
 
 	// output
-	ped_out << "Well-to-escape product energy distributions:\n";
-	ped_out << std::setw(13) << "E, kcal/mol";
+	IO::put_text(ped_out, "Well-to-escape product energy distributions:\n");
+	std::vector<std::string> title;
 	for(int w = 0; w < chem_size; ++w)
 	  for(int count = 0; count < Model::escape_size(); ++count)
-	    ped_out << std::setw(13) << Model::well(group_index[w]).name() + "->"
-	      + Model::well(Model::escape_well_index(count)).name() ;
-	ped_out << "\n";
+	    title.push_back(Model::well(group_index[w]).name() + "->"
+			    + Model::well(Model::escape_well_index(count)).name());
       
-	for(int e = 0; e < ener_index_max; ++e) {
-	  dtemp = (energy_reference() - e * energy_step()) / Phys_const::kcal;
-	  ped_out << std::setw(13) << dtemp;
-
-	  for(int i = 0; i < mtemp.size2(); ++i)
-	    ped_out << std::setw(13) << mtemp(e, i);
-	  ped_out << "\n";
-	}
-	ped_out << "\n";
+	energy_table_output(ped_out, title, mtemp, ener_index_max);
+	IO::put_text(ped_out, "\n");
       }// well-to-escape distributions
     }// product energy distributions
   }  
 
   // hot distribution branching ratios
   //
-  if(hot_energy_size) {
+  if(context().hot_energy_size) {
     //
     IO::log << IO::log_offset << "Hot distribution branching ratios:\n"
 	    << IO::log_offset //<< std::setprecision(6)
@@ -4949,7 +8873,7 @@ void MasterEquation::direct_diagonalization_method (std::map<std::pair<int, int>
     
     std::map<int, std::vector<int> >::const_iterator hit;
     int count = 0;
-    for(hit = hot_index.begin(); hit != hot_index.end(); ++hit)
+    for(hit = context().hot_index.begin(); hit != context().hot_index.end(); ++hit)
       for(int i = 0; i < hit->second.size(); ++i, ++count) {
 	dtemp = (energy_reference() - (double)hit->second[i] * energy_step()) / Phys_const::kcal;
 	IO::log << IO::log_offset
@@ -5005,6 +8929,381 @@ void MasterEquation::set_well_partition_method (const std::string& method)
   throw Error::Input();
 }
 
+/*********************************** Branch-and-Bound Search ****************************************/
+
+// The partition projection is the sum of the group projections |sum_w sqrt(W_w) p_w|^2 / sum_w W_w,
+// where p_w is the well row of the pop_chem matrix; by the Cauchy-Schwarz inequality adding a well
+// to a group increases its projection by no more than the single well projection |p_w|^2, which
+// bounds the projection of any completion of a partial partition.
+
+MasterEquation::PartitionSearch::PartitionSearch (const Lapack::Matrix& pop_chem, const std::vector<double>& weight,
+						  const std::vector<int>& well_map, int part_size, bool bim, int top_size)
+  : _part_size(part_size), _bim(bim), _top_size(top_size > 0 ? top_size : 1), _level(-1.), _open(-1.), _node(0), _stop(0)
+{
+  const char funame [] = "MasterEquation::PartitionSearch::PartitionSearch: ";
+
+  double dtemp;
+
+  if(part_size <= 0 || part_size > well_map.size()) {
+    std::cerr << funame << "partition size out of range\n";
+    throw Error::Range();
+  }
+
+  // search order: large projection wells first
+  //
+  std::multimap<double, int> proj_map;
+
+  for(int i = 0; i < well_map.size(); ++i)
+    //
+    proj_map.insert(std::make_pair(Group(well_map[i]).projection(pop_chem, weight), i));
+
+  for(std::multimap<double, int>::const_reverse_iterator i = proj_map.rbegin(); i != proj_map.rend(); ++i) {
+    //
+    const int w = well_map[i->second];
+
+    dtemp = weight.size() ? weight[w] : well(w).weight();
+
+    _well.push_back(w);
+    _order.push_back(i->second);
+    _weight.push_back(dtemp);
+
+    dtemp = std::sqrt(dtemp);
+
+    _pop.push_back(std::vector<double>(pop_chem.size2()));
+
+    for(int l = 0; l < pop_chem.size2(); ++l)
+      //
+      _pop.back()[l] = dtemp * pop_chem(w, l);
+  }
+
+  _rest.resize(_well.size() + 1);
+
+  _rest.back() = 0.;
+
+  for(int i = _well.size() - 1; i >= 0; --i)
+    //
+    _rest[i] = _rest[i + 1] + vdot(pop_chem.row(_well[i]));
+}
+
+MasterEquation::PartitionSearch::State::State (int part_size, int chem_size) 
+  : sum(part_size, std::vector<double>(chem_size, 0.)), weight(part_size, 0.), proj(part_size, 0.), group(0), value(0.)
+{}
+
+// group projection with the well added
+//
+double MasterEquation::PartitionSearch::_projection (const State& s, int i, int g) const
+{
+  double res = 0.;
+
+  for(int l = 0; l < _pop[i].size(); ++l) {
+    //
+    const double dtemp = s.sum[g][l] + _pop[i][l];
+
+    res += dtemp * dtemp;
+  }
+
+  return res / (s.weight[g] + _weight[i]);
+}
+
+// possible placements of the i-th well, better ones first; -1 stands for the bimolecular group
+//
+void MasterEquation::PartitionSearch::_moves (const State& s, int i, std::vector<std::pair<double, int> >& moves) const
+{
+  moves.clear();
+
+  const int need   = _part_size - s.group;
+  const int remain = _well.size() - i;
+
+  if(remain < need)
+    return;
+
+  if(remain > need)
+    for(int g = 0; g < s.group; ++g)
+      moves.push_back(std::make_pair(_projection(s, i, g) - s.proj[g], g));
+
+  if(s.group < _part_size)
+    moves.push_back(std::make_pair(_rest[i] - _rest[i + 1], s.group));
+
+  if(_bim && remain > need)
+    moves.push_back(std::make_pair(0., -1));
+
+  std::sort(moves.rbegin(), moves.rend());
+}
+
+MasterEquation::PartitionSearch::State MasterEquation::PartitionSearch::_move (const State& s, int i, int g) const
+{
+  State res = s;
+
+  res.label.push_back(g);
+
+  if(g < 0)
+    return res;
+
+  if(g == res.group)
+    ++res.group;
+
+  const double dtemp = _projection(s, i, g);
+
+  res.value += dtemp - res.proj[g];
+
+  res.proj[g] = dtemp;
+
+  res.weight[g] += _weight[i];
+
+  for(int l = 0; l < _pop[i].size(); ++l)
+    //
+    res.sum[g][l] += _pop[i][l];
+
+  return res;
+}
+
+void MasterEquation::PartitionSearch::_record (const State& s)
+{
+#pragma omp critical(partition_search)
+  {
+    if(_top.size() < _top_size || s.value > _top.begin()->first) {
+      //
+      _top.insert(std::make_pair(s.value, s.label));
+
+      if(_top.size() > _top_size)
+	//
+	_top.erase(_top.begin());
+
+      if(_top.size() == _top_size) {
+	//
+#pragma omp atomic write
+	_level = _top.begin()->first;
+      }
+    }
+  }
+}
+
+void MasterEquation::PartitionSearch::_search (const State& s, long& node)
+{
+  const int i = s.label.size();
+
+  const double bound = s.value + _rest[i];
+
+  double level;
+
+#pragma omp atomic read
+  level = _level;
+
+  if(bound <= level)
+    return;
+
+  // search limit
+  //
+  if(!(++node % 1024)) {
+    //
+    long itemp;
+
+#pragma omp atomic capture
+    itemp = _node += 1024;
+
+    if(itemp > well_partition_node_max) {
+      //
+#pragma omp atomic write
+      _stop = 1;
+    }
+  }
+
+  int stop;
+
+#pragma omp atomic read
+  stop = _stop;
+
+  if(stop) {
+    //
+#pragma omp critical(partition_search)
+    if(bound > _open)
+      _open = bound;
+
+    return;
+  }
+
+  if(i == _well.size()) {
+    //
+    if(s.group == _part_size)
+      _record(s);
+
+    return;
+  }
+
+  std::vector<std::pair<double, int> > moves;
+
+  _moves(s, i, moves);
+
+  for(int m = 0; m < moves.size(); ++m)
+    //
+    _search(_move(s, i, moves[m].second), node);
+}
+
+// the labels are given in the search order, the groups numbered by their first wells
+//
+bool MasterEquation::PartitionSearch::seed (const std::vector<std::set<int> >& start)
+{
+  if(start.size() != _part_size)
+    return false;
+
+  std::map<int, int> well_group;
+
+  for(int g = 0; g < start.size(); ++g)
+    for(std::set<int>::const_iterator w = start[g].begin(); w != start[g].end(); ++w)
+      well_group[*w] = g;
+
+  State s(_part_size, _pop.size() ? _pop[0].size() : 0);
+
+  std::map<int, int> label_map;
+
+  for(int i = 0; i < _well.size(); ++i) {
+    //
+    int g = -1;
+
+    std::map<int, int>::const_iterator wit = well_group.find(_well[i]);
+
+    if(wit != well_group.end()) {
+      //
+      std::map<int, int>::const_iterator lit = label_map.find(wit->second);
+
+      if(lit == label_map.end()) {
+	//
+	g = s.group;
+
+	label_map[wit->second] = g;
+      }
+      else
+	g = lit->second;
+    }
+    else if(!_bim)
+      return false;
+
+    s = _move(s, i, g);
+  }
+
+  if(s.group != _part_size)
+    return false;
+
+  _record(s);
+
+  return true;
+}
+
+void MasterEquation::PartitionSearch::run ()
+{
+  const char funame [] = "MasterEquation::PartitionSearch::run: ";
+
+  int itemp;
+
+  // partial partitions to be completed in parallel
+  //
+  itemp = 1;
+
+#ifdef _OPENMP
+  itemp = omp_get_max_threads();
+#endif
+
+  const int task_min = 16 * itemp;
+
+  std::vector<State> task(1, State(_part_size, _pop.size() ? _pop[0].size() : 0));
+
+  std::vector<std::pair<double, int> > moves;
+
+  for(int i = 0; i < _well.size() && task.size() < task_min; ++i) {
+    //
+    std::vector<State> next;
+
+    for(int t = 0; t < task.size(); ++t) {
+      //
+      _moves(task[t], i, moves);
+
+      for(int m = 0; m < moves.size(); ++m)
+	//
+	next.push_back(_move(task[t], i, moves[m].second));
+    }
+
+    task.swap(next);
+  }
+
+#pragma omp parallel for default(shared) schedule(dynamic)
+
+  for(int t = 0; t < task.size(); ++t) {
+    //
+    long node = 0;
+    
+    _search(task[t], node);
+
+    node %= 1024;
+
+#pragma omp atomic
+    _node += node;
+  }
+
+  if(!_top.size()) {
+    std::cerr << funame << "no partition found within the search limit\n";
+    throw Error::Run();
+  }
+}
+
+MasterEquation::Partition MasterEquation::PartitionSearch::partition (const std::vector<int>& label, Group& bim) const
+{
+  int itemp;
+
+  // groups in the order of their first wells in the well map
+  //
+  std::map<int, int> group_map;
+
+  for(int i = 0; i < label.size(); ++i)
+    //
+    if(label[i] >= 0) {
+      //
+      if(group_map.find(label[i]) == group_map.end() || _order[i] < group_map[label[i]])
+	//
+	group_map[label[i]] = _order[i];
+    }
+
+  std::map<int, int> group_order;
+
+  for(std::map<int, int>::const_iterator g = group_map.begin(); g != group_map.end(); ++g)
+    //
+    group_order[g->second] = g->first;
+
+  std::map<int, int> group_index;
+
+  for(std::map<int, int>::const_iterator g = group_order.begin(); g != group_order.end(); ++g) {
+    //
+    itemp = group_index.size();
+    
+    group_index[g->second] = itemp;
+  }
+  
+  Partition res(_part_size);
+
+  bim.clear();
+
+  for(int i = 0; i < label.size(); ++i)
+    //
+    if(label[i] < 0) {
+      //
+      bim.insert(_well[i]);
+    }
+    else
+      //
+      res[group_index[label[i]]].insert(_well[i]);
+
+  return res;
+}
+
+double MasterEquation::PartitionSearch::gap () const
+{
+  if(_open < 0. || !_top.size())
+    return 0.;
+
+  const double dtemp = _open - _top.rbegin()->first;
+
+  return dtemp > 0. ? dtemp : 0.;
+}
+
 double MasterEquation::threshold_well_partition (const Lapack::Matrix& pop_chem, Partition& well_partition,
 						 Group& bimolecular_group, const std::vector<double>& weight) 
 {
@@ -5068,25 +9367,18 @@ double MasterEquation::threshold_well_partition (const Lapack::Matrix& pop_chem,
     //
     IO::log << IO::log_offset << funame << "WARNING: large well projection is smaller than the well projection threshold\n";
   
-  double pmax = -1.;
+  double pmax;
   
-  for(PartitionGenerator pg(chem_size, well_map.size()); !pg.end(); ++pg) {
-    //
-    // initialize new partition
-    //
-    Partition p(pg, well_map);
+  PartitionSearch search(pop_chem, weight, well_map, chem_size, false);
 
-    // partition projection
-    //
-    dtemp = p.projection(pop_chem, weight);
+  // the previous point partition bounds the search
+  const bool warm = !weight.size() && search.seed(context().partition_start);
 
-    if(dtemp > pmax) {
-      //
-      pmax = dtemp;
-      
-      well_partition = p;
-    }
-  }
+  search.run();
+
+  Group gtemp;
+  
+  well_partition = search.partition(search.begin()->second, gtemp);
 
   while(bimolecular_group.size()) {
     //
@@ -5144,12 +9436,19 @@ double MasterEquation::threshold_well_partition (const Lapack::Matrix& pop_chem,
 
     IO::log << IO::log_offset << "well projection threshold  = " << well_projection_threshold << "\n";
     IO::log << IO::log_offset << "partition projection error = " << pmax << "\n";
+    IO::log << IO::log_offset << "partition search: nodes = " << search.node_size()
+	    << ", optimality gap = " << search.gap();
+    if(warm)
+      IO::log << ", started from the previous partition";
+    IO::log << "\n";
 
     IO::log_offset.decrease();
     IO::log << IO::log_offset << funame
 	    << "done, cpu time[sec] = " << double(std::clock() - start_cpu) / CLOCKS_PER_SEC 
 	    << ", elapsed time[sec] = "<< std::time(0) - start_time
 	    << std::endl;
+
+    context().partition_start.assign(well_partition.begin(), well_partition.end());
   }
 
   return pmax;
@@ -5186,43 +9485,20 @@ double MasterEquation::sort_well_partition (const Lapack::Matrix& pop_chem, Part
   std::clock_t start_cpu = std::clock();
   std::time_t  start_time = std::time(0);
 
-  // partitioning the wells into equilibrated groups
-  int part_size = chem_size;
-  for(PartitionGenerator pg(part_size, well_size); !pg.end(); ++pg) {
-    // initialize new partition
-    Partition part(pg);
+  // partitioning the wells into equilibrated groups; some of the wells
+  // may be equilibrated with the bimolecular products
+  std::vector<int> well_map(well_size);
+  for(int w = 0; w < well_size; ++w)
+    well_map[w] = w;
 
-    // partition projection
-    dtemp = part.projection(pop_chem, weight);
+  PartitionSearch search(pop_chem, weight, well_map, chem_size, true, red_out_num);
 
-    if(high_part.size() < red_out_num)
-      high_part.insert(std::make_pair(dtemp, std::make_pair(part, Group())));
-    else if(dtemp > high_part.begin()->first) {
-      high_part.erase(high_part.begin());
-      high_part.insert(std::make_pair(dtemp, std::make_pair(part, Group())));
-    }
-  }
+  search.run();
 
-  // the case when some of the wells equilibrate with bimolecular products
-  // is solved by allowing the bimolecular group and then removing it
-  part_size = chem_size + 1;
-  for(PartitionGenerator pg(part_size, well_size); !pg.end(); ++pg) {
-    // initialize new partition
-    Partition part(pg);
-    for(int g = 0; g < part_size; ++g) {
-      Partition q = part;
-      Group bg = q[g];
-      // removing the bimolecular group
-      q.erase(q.begin() + g);
-      // partition projection
-      dtemp = q.projection(pop_chem, weight);
-      if(high_part.size() < red_out_num)
-	high_part.insert(std::make_pair(dtemp, std::make_pair(q, bg)));
-      else if(dtemp > high_part.begin()->first) {
-	high_part.erase(high_part.begin());
-	high_part.insert(std::make_pair(dtemp, std::make_pair(q, bg)));
-      }
-    }
+  for(PartitionSearch::const_iterator i = search.begin(); i != search.end(); ++i) {
+    Group bg;
+    Partition part = search.partition(i->second, bg);
+    high_part.insert(std::make_pair(part.projection(pop_chem, weight), std::make_pair(part, bg)));
   }
 
   well_partition    = high_part.rbegin()->second.first;
@@ -5293,6 +9569,9 @@ double MasterEquation::sort_well_partition (const Lapack::Matrix& pop_chem, Part
       IO::log << "\n";
     }
 
+    IO::log << IO::log_offset << "partition search: nodes = " << search.node_size()
+	    << ", optimality gap = " << search.gap() << "\n";
+
     IO::log_offset.decrease();
     IO::log << IO::log_offset << funame
 	    << "done, cpu time[sec] = " << double(std::clock() - start_cpu) / CLOCKS_PER_SEC 
@@ -34,9 +34,98 @@ namespace MasterEquation {
   extern std::ofstream evec_out;// eigenvalues output
   extern int           evec_out_num;// number of relaxation eigenvalues to print
 
+  // relaxation spectrum of the last direct diagonalization, kept for the in-process interface
+  struct Spectrum {
+    std::vector<double> eigenvalue;  // 1/sec
+    Lapack::Matrix      eigenvector; // global state index, eigenvalue index: one column per eigenvector
+    std::vector<int>    well_shift;  // first global state of each well
+  };
+
+  extern bool     keep_spectrum;
+  extern Spectrum spectrum;
+
+  // energy grid convergence warm start (direct diagonalization method, lowest eigenpairs only): the
+  // lowest eigenvectors of each temperature and pressure are kept and, on the next finer energy grid,
+  // interpolated onto it to start the shift-invert subspace iterations with the dense storage, or
+  // the Lanczos iterations with the band storage, instead of the dense partial diagonalization
+  extern bool grid_warm_start;
+  void clear_grid_start ();
+
   enum {TORR, BAR, ATM};
   extern int pressure_unit;
+
+  // global relaxation matrix eigensolver: all eigenpairs or only the ones needed (direct diagonalization method);
+  // with the partial spectrum the bimolecular source terms come from the conjugate gradient iterations
+  // preconditioned by the band factorization of the energy interleaved matrix, the chemical projector being
+  // the low-rank update; the iterative one takes only the chemical eigenpairs and preconditions by the well blocks
+  enum {FULL_SPECTRUM, PARTIAL_SPECTRUM, ITERATIVE_SPECTRUM};
+  extern int eigensolver;
+
+  // chemical eigenpairs precision (low-eigenvalue method): double, double refined by the
+  // iterations with the double-double residuals, or the double-double diagonalization (MPACK);
+  // single precision is only for the relaxation modes
+  enum {DOUBLE_PRECISION, REFINED_PRECISION, MULTIPLE_PRECISION, SINGLE_PRECISION};
+  extern int chemical_precision;
+
+  // reuse the pressure independent parts of the global relaxation matrix over the pressure list
+  extern bool incremental_pressure;
+
+  // relaxation modes solver of the low-eigenvalue method: Cholesky factorization at each pressure,
+  // or the generalized eigen-decomposition of the reactive and collisional parts once per temperature,
+  // which turns the pressure into a diagonal shift (pays off for long pressure lists), or the per-well
+  // Cholesky factors with the Woodbury correction for the inner barriers coupling, which never forms
+  // the global matrix (pays off for many wells with the barriers high above the wells bottoms)
+  enum {CHOLESKY_SOLVER, SPECTRAL_SOLVER, BLOCK_SOLVER};
+  extern int crm_solver;
+
+  // generalized eigen-decomposition precision of the spectral solver: double, or single (half
+  // the memory traffic) with the relaxation modes solutions refined by the double precision residuals
+  extern int crm_precision;
+
+  // adaptive energy grid (direct diagonalization method): the energy bins below the barriers
+  // are lumped into the coarse bins growing by this factor toward the well bottom; no lumping if 1
+  extern double energy_grid_factor;
+
+  // reservoir state (direct diagonalization method): the energy bins of each well lying deeper
+  // than this offset below the adaptive grid fine part are collapsed into a single thermal state;
+  // no reservoir if negative
+  extern double reservoir_offset;
+
+  // network decomposition: the inner barrier carrying less than this fraction of the thermal
+  // flux out of each of the wells it connects is closed, the wells sub-networks linked only through
+  // the bimolecular products then being solved independently; no decoupling if not positive
+  extern double decoupling_threshold;
+
+  // on-disk cache of the wells, barriers, and bimolecular species set at each temperature;
+  // the cache entry is identified by the model input text and the energy grid parameters
+  extern std::string state_cache_dir;  // cache directory, no caching if empty
+  extern std::string state_cache_model;// model input text
+
+  // resident model (server mode): the wells, barriers, and bimolecular species set at each
+  // temperature are kept in memory and set again only if the model edits changed their energies;
+  // the edits the species energies do not show, e.g., of the kernels, need the explicit reset
+  extern bool resident_species;
+  void clear_resident_species ();
+
+  // barriers closed by the resident model edits, inner or outer
+  extern std::set<std::string> closed_barrier;
   
+  // scratch directory for the global eigenvectors of the direct diagonalization method: once
+  // found they are mapped onto an unlinked scratch file there, so that they need not stay in memory
+  // next to the global relaxation matrix; kept in memory if empty
+  extern std::string eigen_scratch_dir;
+
+  // reduced basis surrogate (direct diagonalization method, dense storage, lowest eigenpairs only):
+  // the lowest eigenvectors of the points solved in full, up to the given number of the most
+  // recent ones, are kept as the snapshots interpolated onto the energy grid of the next point;
+  // this point's relaxation matrix is projected onto their span and it is solved in full, and
+  // becomes the snapshot, only if a projected eigenpair residual norm relative to the highest
+  // eigenvalue calculated (the lowest relaxation one, unless more eigenvectors are printed)
+  // exceeds the tolerance; no surrogate if the tolerance is not positive
+  extern double reduced_basis_tolerance;
+  extern int    reduced_basis_size;
+  void clear_reduced_basis ();
+
   // reduction of species
   enum {DIAGONALIZATION, PROJECTION}; // possible reduction algorithms for low eigenvalue method
   extern int  red_out_num;// number of reduction schemes to print 
@@ -49,6 +138,14 @@ namespace MasterEquation {
 
   // product energy distributions
   extern std::ofstream ped_out;
+
+  // the relaxation modes with the contribution to the product energy distributions below
+  // this fraction of the largest one are skipped; all modes are used if zero
+  extern double ped_tolerance;
+
+  // analytic sensitivities of the rate coefficients to the barrier energies
+  // (direct diagonalization method, full spectrum, no well partitioning)
+  extern std::ofstream sens_out;
   void set_ped_pair(const std::vector<std::string>& ped_spec) ;
 
   extern double         well_cutoff;// well cutoff parameter
@@ -57,6 +154,10 @@ namespace MasterEquation {
   extern double            rate_max;// microcanonical rate maximum
   extern double reduction_threshold;// maximal chemical eigenvalue to collision frequency ratio
 
+  // the ratio of the smallest relaxational to the largest chemical eigenvalue found by
+  // the last rate calculation; negative if the method does not provide it
+  extern double eigenvalue_gap;
+
   void set_global_cutoff (double);
 
   double temperature            ();
@@ -70,6 +171,11 @@ namespace MasterEquation {
   void set_energy_step      (double);
   void set_energy_reference (double);
 
+  // lowers the energy reference of the current temperature to the smallest one on the current grid
+  // with the thermal populations of the wells and the thermal fluxes of the barriers above it not
+  // exceeding the given fraction (Boltzmann tail tolerance); the reference stays above the barriers
+  void lower_energy_reference (double);
+
   // set states densities, states numbers, etc. 
   void set (std::map<std::pair<int, int>, double>& rate_data, std::map<int, double>& capture) ;
 
@@ -88,14 +194,20 @@ namespace MasterEquation {
     Lapack::Vector          _state_density;      // density of states on the grid
     Lapack::Vector          _boltzman;           // Boltzmann distribution
     Lapack::Vector          _boltzman_sqrt;      // Boltzmann distribution
+    Lapack::Vector          _boltzman_sqrt_inv;  // reciprocal square root of Boltzmann distribution
     Lapack::Matrix          _crm_basis;          // CRM basis (ket)
     Lapack::Matrix          _crm_bra;            // CRM basis (bra)
-    Lapack::Matrix          _kernel;             // energy relaxation kernel
+    Lapack::GeneralBandMatrix _kernel;           // energy relaxation kernel, kernel_bandwidth wide
     Lapack::SymmetricMatrix _crm_kernel;         // kernel in CRM basis
     Lapack::Vector          _escape_rate;        // escape rate;
 
     double              _collision_factor;
     std::vector<double> _kernel_fraction;
+
+    // buffer gas mixture: per-buffer kernels at the unit kernel fraction and collision
+    // frequency factors at the unit mole fraction, combined by the mole fractions
+    std::vector<Lapack::GeneralBandMatrix> _buffer_kernel;
+    std::vector<double>                    _buffer_collision;
     
     // radiational transitions
     Lapack::SymmetricMatrix     _radiation_rate;
@@ -103,10 +215,13 @@ namespace MasterEquation {
 
     void _set_state_density (const Model::Well&);
     void _set_kernel (const Model::Well&) ;
+    int  _truncation_size (const Model::Well&, int bandwidth) const; // DOWN-form kernel truncation
     void _set_crm_basis ();
 
   public:
     explicit Well (const Model::Well&);
+    explicit Well (std::istream&); // state cache input
+    void save (std::ostream&) const; // state cache output
 
     int              size ()                const { return _state_density.size(); }
     double         weight ()                const { return               _weight; }
@@ -115,7 +230,11 @@ namespace MasterEquation {
     double  state_density (int i)           const { return     _state_density[i]; }
     double       boltzman (int i)           const { return          _boltzman[i]; }
     double  boltzman_sqrt (int i)           const { return     _boltzman_sqrt[i]; }
+    double  boltzman_sqrt_inv (int i)       const { return _boltzman_sqrt_inv[i]; }
+    const double* boltzman_sqrt ()          const { return        _boltzman_sqrt; }
+    const double* boltzman_sqrt_inv ()      const { return    _boltzman_sqrt_inv; }
     double         kernel (int i, int j)    const { return         _kernel(i, j); }
+    const Lapack::GeneralBandMatrix& kernel () const { return     _kernel; }
 
     double minimal_relaxation_eigenvalue () const { return       _min_relax_eval; }
     double maximal_relaxation_eigenvalue () const { return       _max_relax_eval; }
@@ -126,6 +245,7 @@ namespace MasterEquation {
     const double* crm_column (int i)        const { return     &_crm_basis(0, i);   }
     const double* crm_row    (int i)        const { return     &_crm_basis(i, 0);   }
     const double& crm_kernel (int i, int j) const { return      _crm_kernel(i, j);  }// kernel in CRM basis 
+    const Lapack::SymmetricMatrix& crm_kernel () const { return _crm_kernel;     }
 
     double escape_rate(int i)               const { return       _escape_rate[i]; }
     const double* escape_rate()             const { return       _escape_rate; }
@@ -138,6 +258,9 @@ namespace MasterEquation {
     double collision_frequency     () const { return _collision_factor * pressure();    }
     double kernel_fraction    (int i) const { return _kernel_fraction[i];     }
 
+    // recombines the per-buffer kernels with the current buffer gas mole fractions
+    void set_buffer_fraction ();
+
     int kernel_bandwidth;
   };
 
@@ -153,6 +276,8 @@ namespace MasterEquation {
 
   public:
     explicit Barrier  (const Model::Species&);
+    explicit Barrier  (std::istream&);
+    void save (std::ostream&) const;
     int             size ()      const { return _state_number.size(); }
     double  state_number (int i) const { return _state_number[i]; }
     double& state_number (int i)       { return _state_number[i]; }
@@ -160,6 +285,7 @@ namespace MasterEquation {
     double   real_weight ()      const { return _real_weight; }
 
     void      truncate (int) ;
+    void      close    ()    ; // no states, the wells are not coupled
   };
 
   /********************************************************************************************
@@ -171,6 +297,8 @@ namespace MasterEquation {
 
   public:
     Bimolecular(const Model::Bimolecular& p);
+    explicit Bimolecular (std::istream&);
+    void save (std::ostream&) const;
     double   weight () const { return   _weight; }
   };
 
@@ -181,30 +309,170 @@ namespace MasterEquation {
   const Barrier&                inner_barrier (int b);
   const Barrier&                outer_barrier (int b);
 
+  /********************************************************************************************
+   **************************************** SOLVE CONTEXT *************************************
+   ********************************************************************************************/
+
+  // per-solve state: thermodynamic conditions, energy grid, and the species set by set();
+  // the calculation methods work with the current context of the calling thread
+  class Context {
+  public:
+    double _temperature;
+    double _pressure;
+    double _energy_step;
+    double _energy_reference; // zero energy (also upper limit)
+    bool   _isset;            // inner setting check
+
+    std::vector<double> _thermal_factor; // Boltzmann factor: exp(-E/T)
+
+    std::vector<SharedPointer<Well> >        _well;
+    std::vector<SharedPointer<Bimolecular> > _bimolecular;
+    std::vector<SharedPointer<Barrier> >     _inner_barrier;
+    std::vector<SharedPointer<Barrier> >     _outer_barrier;
+
+    std::vector<Array<double> > cum_stat_num; // cumulative number of states for each well
+
+    // hot energies indices
+    std::map<int, std::vector<int> > hot_index;
+    int                              hot_energy_size;
+
+    // pressure independent parts of the global kinetic relaxation matrix at the current
+    // temperature: kinetic matrix = kin_reactive + pressure / kin_pressure * kin_collision
+    Lapack::SymmetricMatrix kin_reactive;
+    Lapack::SymmetricMatrix kin_collision;
+    double                  kin_pressure;
+
+    // the previous pressure lowest eigenvectors to start the band storage iterations
+    Lapack::Vector band_start;
+
+    // the previous point well partition to start the partition search
+    std::vector<std::set<int> > partition_start;
+
+    // pressure independent parts of the low-eigenvalue method relaxation modes matrices at the current
+    // temperature: relaxation modes kinetic matrix = crm_reactive + pressure / crm_pressure * crm_collision
+    Lapack::SymmetricMatrix crm_reactive;
+    Lapack::SymmetricMatrix crm_collision;
+    Lapack::Matrix          crm_chem; // chemical-to-relaxation modes coupling
+    Lapack::Matrix          crm_bim;  // bimolecular-to-relaxation modes coupling
+    double                  crm_pressure;
+
+    // spectral solver: crm_reactive * crm_basis = crm_collision * crm_basis * crm_eval
+    Lapack::Matrix crm_basis;
+    Lapack::Vector crm_eval;
+    Lapack::Matrix crm_basis_chem; // crm_basis^T * crm_chem
+    Lapack::Matrix crm_basis_bim;  // crm_basis^T * crm_bim
+
+    // direct diagonalization method bimolecular, Boltzmann, and escape vectors in the global
+    // basis at the current temperature
+    Lapack::Matrix global_bim;
+    Lapack::Matrix global_pop;
+    Lapack::Matrix global_escape;
+
+    Context () : _temperature(-1.), _pressure(-1.), _energy_step(-1.), _energy_reference(0.),
+		 _isset(false), hot_energy_size(0), kin_pressure(-1.), crm_pressure(-1.) {}
+  };
+
+  typedef SharedPointer<Context> ContextHandle;
+
+  // current context of the calling thread (the default one if none has been set)
+  Context& context ();
+
+  // makes the context current for the calling thread within the scope
+  class ContextGuard {
+    Context* _prev;
+
+    ContextGuard (const ContextGuard&);
+    ContextGuard& operator= (const ContextGuard&);
+
+  public:
+    explicit ContextGuard (Context&);
+    ~ContextGuard ();
+  };
+
   /************************** RATE COEFFICIENTS CALCULATION METHODS ******************************/
 
   void low_eigenvalue_matrix (Lapack::SymmetricMatrix& k_11, Lapack::SymmetricMatrix& k_33, 
 			      Lapack::Matrix& k_13, Lapack::Matrix& l_21) ;
 
+  Lapack::Vector chemical_eigenvalues (const Lapack::SymmetricMatrix& k_11, Lapack::Matrix& chem_evec) ;
+
   typedef void             (*Method) (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags);
+
+  // method flags
+  enum {
+    BAND_STORAGE = 1 // kinetic relaxation matrix in the band storage, lowest eigenpairs by shift-invert Lanczos
+  };
+
+  // re-entrant interface: each context is set and solved independently, so that different
+  // contexts can be used concurrently from different threads; the Model data are shared
+  // read-only, the auxiliary output streams (eval_out, ped_out, etc.) are not synchronized
+  ContextHandle set (double temperature, double energy_step, double energy_reference,
+		     std::map<std::pair<int, int>, double>& rate_data, std::map<int, double>& capture);
+
+  void solve (Context&, double pressure, Method, std::map<std::pair<int, int>, double>& rate_data,
+	      Partition& well_partition, int flags);
+
   void         low_eigenvalue_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags)
     ;
   void direct_diagonalization_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags)
     ;
+  void banded_diagonalization_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags)
+    ;
   void         well_reduction_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags)
     ;
   void         well_reduction_method_old (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags)
     ;
+  // strong collision screening, the wells merged one inner barrier at a time from the lowest one up
   void             sequential_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags)
     ;
 
+  // low-eigenvalue, well-reduction, or direct diagonalization method chosen by the estimated
+  // chemical to relaxation eigenvalues ratios
+  void              automatic_method (std::map<std::pair<int, int>, double>& rate_data, Partition& well_partition, int flags)
+    ;
+
+  // estimated well loss rates (the thermal barrier fluxes bounded by the collisional activation)
+  // over the smallest relaxation eigenvalue of the wells, from the per-well relaxation only
+  std::vector<double> loss_ratio_estimate ();
+
+  // early chemical/relaxation separation check of the low-eigenvalue method: if the largest
+  // estimated loss ratio exceeds this value, the point goes to the direct diagonalization
+  // method before the relaxation modes are solved; no check if not positive
+  extern double separation_check;
+
   void        high_pressure_analysis () ;
 
+  // high pressure rate coefficients and capture/escape rates at the current temperature and
+  // energy reference from the species statistical weights, evaluated concurrently; the wells,
+  // barriers, and bimolecular products are not set
+  //
+  void high_pressure_rates (std::map<std::pair<int, int>, double>& rate_data, std::map<int, double>& capture);
+
+  /************************** MEMORY PRE-FLIGHT ******************************/
+
+  // peak memory, in bytes, of the direct method with the dense and the band storage predicted
+  // from the wells energy grids at the current temperature, energy step, and reference energy,
+  // before the wells are set; the low-eigenvalue and well-reduction methods work with
+  // the matrices of the global relaxation matrix dimension, the dense estimate applies
+  //
+  struct MemoryEstimate {
+    int    global_size; // global relaxation matrix dimension
+    int    band_size;   // relaxation matrix band width
+    double dense;
+    double banded;
+  };
+
+  MemoryEstimate memory_estimate ();
+
+  // the band storage is compatible with the requested output
+  bool band_storage_available ();
+
   /************************** WELL PARTITION METHODS ******************************/
 
   void set_well_partition_method (const std::string&) ;
 
   extern double  well_projection_threshold;
+  extern long    well_partition_node_max; // search limit of the threshold and sort_out methods
 
   double   threshold_well_partition (const Lapack::Matrix&, Partition&, Group&, const std::vector<double>&)
     ;
@@ -295,6 +563,63 @@ namespace MasterEquation {
     int operator[]      (int i) const { return _group_index[i]; }
   };
 
+  // branch-and-bound search of the well partitions with the largest projection onto the chemical subspace
+  class PartitionSearch {
+    // wells in the search order
+    std::vector<int>                   _well;   // well index
+    std::vector<int>                   _order;  // position in the well map
+    std::vector<double>                _weight; // statistical weight
+    std::vector<std::vector<double> >  _pop;    // weighted pop_chem row
+    std::vector<double>                _rest;   // projection upper bound of the remaining wells
+
+    const int  _part_size;
+    const bool _bim;       // wells may be left out (equilibrated with bimolecular products)
+    const int  _top_size;
+
+    std::multimap<double, std::vector<int> > _top; // best partitions found
+    double _level;  // projection to beat
+    double _open;   // highest bound of the nodes left unexplored
+    long   _node;   // number of the nodes visited
+    int    _stop;   // search limit is reached
+
+    // partial partition
+    struct State {
+      std::vector<int>                  label; // well group, -1 for the bimolecular group
+      std::vector<std::vector<double> > sum;
+      std::vector<double>               weight;
+      std::vector<double>               proj;
+      int                               group; // number of nonempty groups
+      double                            value; // partition projection
+
+      State (int, int);
+    };
+
+    double _projection (const State&, int, int) const;
+    void   _moves      (const State&, int, std::vector<std::pair<double, int> >&) const;
+    State  _move       (const State&, int, int) const;
+    void   _record     (const State&);
+    void   _search     (const State&, long&);
+
+  public:
+    PartitionSearch (const Lapack::Matrix& pop_chem, const std::vector<double>& weight, 
+		     const std::vector<int>& well_map, int part_size, bool bim, int top_size = 1);
+
+    // the partition to beat, e.g. the previous point one; false if it does not fit the search
+    bool seed (const std::vector<std::set<int> >&);
+
+    void run ();
+
+    typedef std::multimap<double, std::vector<int> >::const_reverse_iterator const_iterator;
+
+    const_iterator begin () const { return _top.rbegin(); } // best first
+    const_iterator end   () const { return _top.rend();   }
+
+    Partition partition (const std::vector<int>&, Group&) const;
+
+    long   node_size () const { return _node; }
+    double gap       () const ; // optimality gap bound
+  };
+
   // description of the species as a group of equilibrated wells at high pressure
   struct HPWell : public Group {
     double weight; // statistical weight
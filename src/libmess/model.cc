@@ -24,6 +24,11 @@
 #include <ctime>
 #include <cstring>
 #include <cstdarg>
+#include <exception>
+#include <cstdio>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "atom.hh"
 #include "model.hh"
@@ -107,8 +112,141 @@ namespace Model {
   double  _maximum_barrier_height;
   double  maximum_barrier_height() { return _maximum_barrier_height; }
 
+  // well dissociation limits and the maximum barrier height from the barrier energies
+  void _set_barrier_limits ()
+  {
+    const char funame [] = "Model::_set_barrier_limits: ";
+
+    double dtemp;
+    bool   btemp;
+
+    for(int w = 0; w < well_size(); ++w) {
+      btemp = true;
+      for(int b = 0; b < outer_barrier_size(); ++b) {
+	dtemp =  outer_barrier(b).real_ground();
+	if(outer_connect(b).first == w && (btemp || dtemp < _well[w].dissociation_limit)) {
+	  btemp = false;
+	  _well[w].dissociation_limit = dtemp;
+	}
+      }
+
+      for(int b = 0; b < inner_barrier_size(); ++b) {
+	dtemp =  inner_barrier(b).real_ground();
+	if((inner_connect(b).first == w || inner_connect(b).second == w) && 
+	   (btemp || dtemp < _well[w].dissociation_limit)) {
+	  btemp = false;
+	  _well[w].dissociation_limit = dtemp;
+	}
+      }
+      if(btemp) {
+	std::cerr << funame << "no barrier associated with " << well(w).name() << " well found\n";
+	throw Error::Init();
+      }
+    }
+
+    btemp = true;
+    for(int b = 0; b < outer_barrier_size(); ++b) {
+      dtemp = outer_barrier(b).real_ground();
+      if(btemp || _maximum_barrier_height < dtemp) {
+	btemp = false;
+	_maximum_barrier_height = dtemp;
+      }
+    }
+    for(int b = 0; b < inner_barrier_size(); ++b) {
+      dtemp = inner_barrier(b).real_ground();
+      if(btemp || _maximum_barrier_height < dtemp) {
+	btemp = false;
+	_maximum_barrier_height = dtemp;
+      }
+    }
+  }
+
+  /********************************* RESIDENT MODEL EDITS ************************************/
+
+  void shift_barrier (const std::string& name, double e)
+  {
+    const char funame [] = "Model::shift_barrier: ";
+
+    bool isfound = false;
+    for(int b = 0; b < inner_barrier_size(); ++b)
+      if(inner_barrier(b).name() == name) {
+	isfound = true;
+	_inner_barrier[b]->shift_ground(e);
+      }
+
+    for(int b = 0; b < outer_barrier_size(); ++b)
+      if(outer_barrier(b).name() == name) {
+	isfound = true;
+	_outer_barrier[b]->shift_ground(e);
+      }
+
+    if(!isfound) {
+      std::cerr << funame << "barrier " << name << " not found\n";
+      throw Error::Find();
+    }
+
+    _set_barrier_limits();
+  }
+
+  void shift_well (const std::string& name, double e)
+  {
+    const char funame [] = "Model::shift_well: ";
+
+    for(int w = 0; w < well_size(); ++w)
+      if(_well[w].name() == name) {
+	_well[w].shift_ground(e);
+	_set_barrier_limits();
+	return;
+      }
+
+    std::cerr << funame << "well " << name << " not found\n";
+    throw Error::Find();
+  }
+
+  void scale_kernel (double factor)
+  {
+    // the kernels can be shared between the wells
+    std::set<Kernel*> pool;
+    for(int i = 0; i < _default_kernel.size(); ++i)
+      pool.insert((Kernel*)_default_kernel[i]);
+    for(int w = 0; w < well_size(); ++w)
+      for(int i = 0; i < buffer_size(); ++i)
+	pool.insert((Kernel*)_well[w].kernel(i));
+
+    for(std::set<Kernel*>::iterator k = pool.begin(); k != pool.end(); ++k)
+      (*k)->scale(factor);
+  }
+
+  void set_buffer_fraction (const std::vector<double>& fraction)
+  {
+    const char funame [] = "Model::set_buffer_fraction: ";
+
+    double dtemp;
+
+    if(fraction.size() != buffer_size()) {
+      std::cerr << funame << "number of the fractions, " << fraction.size()
+		<< ", differs from the number of the buffer gases, " << buffer_size() << "\n";
+      throw Error::Range();
+    }
+
+    dtemp = 0.;
+    for(int i = 0; i < fraction.size(); ++i) {
+      if(fraction[i] <= 0.) {
+	std::cerr << funame << "should be positive\n";
+	throw Error::Range();
+      }
+      dtemp += fraction[i];
+    }
+
+    for(int i = 0; i < fraction.size(); ++i)
+      _buffer_fraction[i] = fraction[i] / dtemp;
+  }
+
   // bimolecular product to be used as a reference
   std::string reactant;
+
+  std::string multirotor_cache_dir;
+  std::string rotor_cache_dir;
   double _energy_shift = 0.;
   double energy_shift () { return _energy_shift; }
 
@@ -141,7 +279,7 @@ namespace Model {
 }
 
 Model::TimeEvolution::TimeEvolution (IO::KeyBufferStream& from) 
-  : _start(-1.), _finish(-1.), _size(-1), _reactant(-1), _excess(-1.), _temperature(-1.)
+  : _start(-1.), _finish(-1.), _size(-1), _reactant(-1), _excess(-1.), _temperature(-1.), _tolerance(-1.), _binary(false)
 {
   const char funame [] = "Model::TimeEvolution::TimeEvolution: ";
 
@@ -158,8 +296,11 @@ Model::TimeEvolution::TimeEvolution (IO::KeyBufferStream& from)
   Key   exc_key("ExcessReactantConcentration[molecule/cm^3]");
   Key   ext_key("EffectiveTemperature[K]");
   Key   out_key("TimeOutput");
+  Key   tol_key("Tolerance" );
+  Key  form_key("OutputFormat");
+  Key  prof_key("Profile[s,K]");
   
-  std::string token, comment;
+  std::string token, comment, out_name;
 
   while(from >> token) {
     // end input 
@@ -263,20 +404,76 @@ Model::TimeEvolution::TimeEvolution (IO::KeyBufferStream& from)
     }
     // output stream
     else if(out_key == token) {
-      if(out.is_open()) {
+      if(out_name.size()) {
+	std::cerr << funame << token << ": already initialized\n";
+	throw Error::Init();
+      }
+      if(!(from >> out_name)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+    }
+    // relaxation modes cutoff
+    else if(tol_key == token) {
+      if(_tolerance > 0.) {
 	std::cerr << funame << token << ": already initialized\n";
 	throw Error::Init();
       }
+      if(!(from >> _tolerance)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      if(_tolerance <= 0. || _tolerance >= 1.) {
+	std::cerr << funame << token << ": out of range\n";
+	throw Error::Range();
+      }
+    }
+    // output format
+    else if(form_key == token) {
       if(!(from >> stemp)) {
 	std::cerr << funame << token << ": corrupted\n";
 	throw Error::Input();
       }
-      
-      out.open(stemp.c_str());
 
-      if(!out) {
-	std::cerr << funame << token << ": cannot open " << stemp << " file\n";
-	throw Error::Open();
+      if(stemp == "text")
+	_binary = false;
+      else if(stemp == "binary")
+	_binary = true;
+      else {
+	std::cerr << funame << token << ": unknown format: " << stemp << "; available formats: text, binary\n";
+	throw Error::Range();
+      }
+    }
+    // temperature and pressure profile: the number of segments followed by
+    // the duration, the temperature, and the pressure of each segment
+    else if(prof_key == token) {
+      if(_profile.size()) {
+	std::cerr << funame << token << ": already initialized\n";
+	throw Error::Init();
+      }
+      if(!(from >> itemp)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      if(itemp < 1) {
+	std::cerr << funame << token << ": out of range\n";
+	throw Error::Range();
+      }
+
+      _profile.resize(itemp);
+      for(int s = 0; s < _profile.size(); ++s) {
+	Segment& seg = _profile[s];
+	if(!(from >> seg.duration >> seg.temperature >> seg.pressure)) {
+	  std::cerr << funame << token << ": corrupted\n";
+	  throw Error::Input();
+	}
+	if(seg.duration <= 0. || seg.temperature <= 0. || seg.pressure <= 0.) {
+	  std::cerr << funame << token << ": " << s + 1 << "-th segment: out of range\n";
+	  throw Error::Range();
+	}
+
+	seg.duration    /= Phys_const::herz;
+	seg.temperature *= Phys_const::kelv;
       }
     }
     // unknown keyword
@@ -313,11 +510,21 @@ Model::TimeEvolution::TimeEvolution (IO::KeyBufferStream& from)
     std::cerr << funame << "time grid finish should be bigger than start\n";
     throw Error::Init();
   }
-  if(!out.is_open()) {
+  if(!out_name.size()) {
     std::cerr << funame << "output stream not initialized\n";
     throw Error::Init();
   }
 
+  if(_binary)
+    out.open(out_name.c_str(), std::ios::binary);
+  else
+    out.open(out_name.c_str());
+
+  if(!out) {
+    std::cerr << funame << "cannot open " << out_name << " file\n";
+    throw Error::Open();
+  }
+
   _step = std::pow(_finish / _start, 1. / double(_size - 1));
 
 }
@@ -347,6 +554,96 @@ void Model::TimeEvolution::set_reactant () const
  ******************************** MODEL INITIALIZATION **************************************
  ********************************************************************************************/
 
+/********************************************************************************************
+ *************************************** FRAGMENT POOL **************************************
+ ********************************************************************************************/
+
+namespace {
+  //
+  // fragment definitions already read: the same definition text under the same name and in
+  // the same mode gives the same species, hence the species, its states, and its weight
+  // caches are shared by all bimolecular species it is a fragment of
+  //
+  struct FragmentRecord {
+    //
+    std::string                   name;
+    int                           mode;
+    std::string                   text;
+    SharedPointer<Model::Species> species;
+    double                        ground; // before the bimolecular shifts it to zero
+  };
+
+  std::vector<FragmentRecord> fragment_pool;
+
+  SharedPointer<Model::Species> shared_fragment (IO::KeyBufferStream& from, const std::string& name, int mode, double& ground)
+  {
+    const std::streampos start = from.isbuffer() ? std::streampos(-1) : from.tellg();
+
+    if(start != std::streampos(-1))
+      //
+      for(std::vector<FragmentRecord>::const_iterator fit = fragment_pool.begin(); fit != fragment_pool.end(); ++fit) {
+	//
+	if(fit->name != name || fit->mode != mode)
+	  //
+	  continue;
+
+	std::string stemp(fit->text.size(), ' ');
+
+	if(from.read(&stemp[0], stemp.size()) && stemp == fit->text) {
+	  //
+	  IO::log << IO::log_offset << name << ": the same definition as before: the fragment is shared\n";
+
+	  ground = fit->ground;
+
+	  return fit->species;
+	}
+
+	from.clear();
+
+	from.seekg(start);
+      }
+
+    SharedPointer<Model::Species> res = Model::new_species(from, name, mode);
+
+    if(!res)
+      //
+      return res;
+
+    ground = res->ground();
+
+    const std::streampos end = start != std::streampos(-1) && from ? from.tellg() : std::streampos(-1);
+
+    if(end != std::streampos(-1)) {
+      //
+      FragmentRecord rec;
+
+      rec.name    = name;
+      rec.mode    = mode;
+      rec.species = res;
+      rec.ground  = ground;
+
+      rec.text.resize(end - start);
+
+      from.seekg(start);
+
+      from.read(&rec.text[0], rec.text.size());
+
+      from.seekg(end);
+
+      if(!from) {
+	//
+	std::cerr << "Model::shared_fragment: cannot reread the fragment definition\n";
+
+	throw Error::Input();
+      }
+
+      fragment_pool.push_back(rec);
+    }
+
+    return res;
+  }
+}
+
 void Model::init (IO::KeyBufferStream& from) 
 {
   const char funame [] = "Model::init: ";
@@ -619,6 +916,10 @@ void Model::init (IO::KeyBufferStream& from)
     }
   }
   
+  // the shared fragments are owned by the bimolecular species from now on
+  //
+  fragment_pool.clear();
+
   /************************************* CHECKING *********************************************/
 
   {
@@ -794,56 +1095,12 @@ void Model::init (IO::KeyBufferStream& from)
       _bimolecular[p]->shift_ground(_energy_shift);
   }
 
-  /****************************** DISSOCIATION LIMIT ***********************************/
-
-  {
-    IO::Marker diss_marker("setting dissociation limit", IO::Marker::ONE_LINE | IO::Marker::NOTIME);
-
-    for(int w = 0; w < well_size(); ++w) {
-      btemp = true;
-      for(int b = 0; b < outer_barrier_size(); ++b) {
-	dtemp =  outer_barrier(b).real_ground();
-	if(outer_connect(b).first == w && (btemp || dtemp < _well[w].dissociation_limit)) {
-	  btemp = false;
-	  _well[w].dissociation_limit = dtemp;
-	}
-      }
-
-      for(int b = 0; b < inner_barrier_size(); ++b) {
-	dtemp =  inner_barrier(b).real_ground();
-	if((inner_connect(b).first == w || inner_connect(b).second == w) && 
-	   (btemp || dtemp < _well[w].dissociation_limit)) {
-	  btemp = false;
-	  _well[w].dissociation_limit = dtemp;
-	}
-      }
-      if(btemp) {
-	std::cerr << funame << "no barrier associated with " << well(w).name() << " well found\n";
-	throw Error::Init();
-      }
-    }
-  }
-
-  /****************************** MAXIMUM BARIER HEIGHT ***********************************/
+  /****************** DISSOCIATION LIMIT AND MAXIMUM BARIER HEIGHT ***********************/
 
   {
-    IO::Marker height_marker("setting maximum barrier height", IO::Marker::ONE_LINE | IO::Marker::NOTIME);
+    IO::Marker diss_marker("setting dissociation limit and maximum barrier height", IO::Marker::ONE_LINE | IO::Marker::NOTIME);
 
-    btemp = true;
-    for(int b = 0; b < outer_barrier_size(); ++b) {
-      dtemp = outer_barrier(b).real_ground();
-      if(btemp || _maximum_barrier_height < dtemp) {
-	btemp = false;
-	_maximum_barrier_height = dtemp;
-      }
-    }
-    for(int b = 0; b < inner_barrier_size(); ++b) {
-      dtemp = inner_barrier(b).real_ground();
-      if(btemp || _maximum_barrier_height < dtemp) {
-	btemp = false;
-	_maximum_barrier_height = dtemp;
-      }
-    }
+    _set_barrier_limits();
   }
       
   /************************************** OUTPUT ***************************************/
@@ -1017,6 +1274,29 @@ void Model::init (IO::KeyBufferStream& from)
     }// temperature cycle
   }
 
+  // well and barrier weights on the output temperature grid
+  std::vector<double> weight_temperature(tsize);
+  for(int t = 0; t < tsize; ++t) {
+    if(tmin > 0)
+      itemp = tmin;
+    else
+      itemp = tstep;
+    itemp += t * tstep;
+    weight_temperature[t] = itemp * Phys_const::kelv;
+  }
+
+  std::vector<std::vector<double> > well_weight(well_size());
+  for(int w = 0; w < well_size(); ++w)
+    well_weight[w] = well(w).species()->weight(weight_temperature);
+
+  std::vector<std::vector<double> > inner_weight(inner_barrier_size());
+  for(int b = 0; b < inner_barrier_size(); ++b)
+    inner_weight[b] = inner_barrier(b).weight(weight_temperature);
+
+  std::vector<std::vector<double> > outer_weight(outer_barrier_size());
+  for(int b = 0; b < outer_barrier_size(); ++b)
+    outer_weight[b] = outer_barrier(b).weight(weight_temperature);
+
   IO::log << IO::log_offset << "partition functions (relative to the ground level, units - 1/cm3):\n"
 	  << IO::log_offset << std::setw(5) << "T\\Q";
 
@@ -1049,7 +1329,7 @@ void Model::init (IO::KeyBufferStream& from)
 
     // well partition functions and derivatives
     for(int w = 0; w < well_size(); ++w)
-      IO::log << std::setw(13) << well(w).weight(tval) * std::pow(well(w).mass() * tval / 2. / M_PI, 1.5) * bpu;
+      IO::log << std::setw(13) << well_weight[w][t] * std::pow(well(w).mass() * tval / 2. / M_PI, 1.5) * bpu;
     // bimolecular product partition functions
     for(int p = 0; p < bimolecular_size(); ++p) 
       if(!bimolecular(p).dummy())
@@ -1057,13 +1337,13 @@ void Model::init (IO::KeyBufferStream& from)
 	  IO::log << std::setw(13) << bimolecular(p).fragment_weight(f, tval) * bpu;
     // inner barrier partition functions
     for(int b = 0; b < inner_barrier_size(); ++b)
-      IO::log << std::setw(13) << inner_barrier(b).weight(tval) 
+      IO::log << std::setw(13) << inner_weight[b][t] 
 	* std::exp((inner_barrier(b).real_ground() - inner_barrier(b).ground())/ tval)
 	* std::pow(inner_barrier(b).mass() * tval / 2. / M_PI, 1.5) * bpu;
 
     // outer barrier partition functions
     for(int b = 0; b < outer_barrier_size(); ++b)
-      IO::log << std::setw(13) << outer_barrier(b).weight(tval) 
+      IO::log << std::setw(13) << outer_weight[b][t] 
 	* std::exp((outer_barrier(b).real_ground() - outer_barrier(b).ground())/ tval)
 	* std::pow(outer_barrier(b).mass() * tval / 2. / M_PI, 1.5) * bpu;
     IO::log << "\n";
@@ -1097,19 +1377,19 @@ void Model::init (IO::KeyBufferStream& from)
 
     // well partition functions
     for(int w = 0; w < well_size(); ++w)
-      IO::log << std::setw(13) << well(w).weight(tval) 
+      IO::log << std::setw(13) << well_weight[w][t] 
 	* std::exp((eref - well(w).ground()) / tval)
 	* std::pow(well(w).mass() * tval / 2. / M_PI, 1.5) * bpu;
 
     // inner barrier partition functions
     for(int b = 0; b < inner_barrier_size(); ++b)
-      IO::log << std::setw(13) << inner_barrier(b).weight(tval) 
+      IO::log << std::setw(13) << inner_weight[b][t] 
 	* std::exp((eref - inner_barrier(b).ground())/ tval)
 	* std::pow(inner_barrier(b).mass() * tval / 2. / M_PI, 1.5) * bpu;
 
     // outer barrier partition functions
     for(int b = 0; b < outer_barrier_size(); ++b)
-      IO::log << std::setw(13) << outer_barrier(b).weight(tval) 
+      IO::log << std::setw(13) << outer_weight[b][t] 
 	* std::exp((eref - outer_barrier(b).ground())/ tval)
 	* std::pow(outer_barrier(b).mass() * tval / 2. / M_PI, 1.5) * bpu;
     IO::log << "\n";
@@ -1142,7 +1422,7 @@ void Model::init (IO::KeyBufferStream& from)
 
     // inner barrier
     for(int b = 0; b < inner_barrier_size(); ++b) {
-      dtemp = std::log(inner_barrier(b).tunnel_weight(tval)) * tval 
+      dtemp = std::log(inner_barrier(b).cached_tunnel_weight(tval)) * tval 
 	+ inner_barrier(b).real_ground() - inner_barrier(b).ground();
 
       IO::log << std::setw(13) << std::exp(dtemp / tval)
@@ -1150,7 +1430,7 @@ void Model::init (IO::KeyBufferStream& from)
     }
     // outer barrier
     for(int b = 0; b < outer_barrier_size(); ++b) {
-      dtemp = std::log(outer_barrier(b).tunnel_weight(tval)) * tval 
+      dtemp = std::log(outer_barrier(b).cached_tunnel_weight(tval)) * tval 
 	+ outer_barrier(b).real_ground() - outer_barrier(b).ground();
       
       IO::log << std::setw(13) << std::exp(dtemp / tval)
@@ -1953,6 +2233,21 @@ Model::Kernel::~Kernel ()
   //std::cout << "Model::Kernel destroyed\n";
 }
 
+void Model::Kernel::scale (double)
+{
+  const char funame [] = "Model::Kernel::scale: ";
+
+  std::cerr << funame << "not implemented\n";
+  throw Error::Logic();
+}
+
+void Model::Kernel::profile (double step, double temperature, std::vector<double>& res) const
+{
+  for(int i = 0; i < res.size(); ++i)
+    //
+    res[i] = (*this)((double)i * step, temperature);
+}
+
 /********************************************************************************************
  *********************************** EXPONENTIAL KERNEL *************************************
  ********************************************************************************************/
@@ -2078,6 +2373,19 @@ Model::ExponentialKernel::~ExponentialKernel ()
   //std::cout << "Model::ExponentialKernel destroyed\n";
 }
 
+void Model::ExponentialKernel::scale (double factor)
+{
+  const char funame [] = "Model::ExponentialKernel::scale: ";
+
+  if(factor <= 0.) {
+    std::cerr << funame << "out of range\n";
+    throw Error::Range();
+  }
+
+  for(int f = 0; f < _factor.size(); ++f)
+    _factor[f] *= factor;
+}
+
 double Model::ExponentialKernel::_energy_down (int f, double temperature) const
 { 
   static const double normal_temperature = 300. * Phys_const::kelv;
@@ -2113,9 +2421,36 @@ double Model::ExponentialKernel::operator () (double energy, double temperature)
   return res;
 }
 
-double Model::ExponentialKernel::cutoff_energy (double temperature) const 
-{ 
-  double dtemp;
+// the temperature factors are evaluated once per term and the grid loop has no branches to
+// be vectorized; the terms are summed in the same order as in operator()
+//
+void Model::ExponentialKernel::profile (double step, double temperature, std::vector<double>& res) const
+{
+  const int n = res.size();
+
+  for(int i = 0; i < n; ++i)
+    res[i] = 0.;
+
+  double* const rp = n ? &res[0] : 0;
+
+  for(int f = 0; f < _fraction.size(); ++f) {
+    //
+    const double ed   = _energy_down(f, temperature);
+    const double frac = _fraction[f];
+    const double cut  = _cutoff;
+
+#pragma omp simd
+    
+    for(int i = 0; i < n; ++i) {
+      const double x = (double)i * step / ed + frac;
+      rp[i] += x < cut ? std::exp(-x) : 0.;
+    }
+  }
+}
+
+double Model::ExponentialKernel::cutoff_energy (double temperature) const 
+{ 
+  double dtemp;
 
   double res = 0.;
   for(int f = 0; f < _fraction.size(); ++f) {
@@ -2132,7 +2467,7 @@ double Model::ExponentialKernel::cutoff_energy (double temperature) const
  ********************************************************************************************/
 
 Model::Tunnel::Tunnel (IO::KeyBufferStream& from) 
-  : _cutoff(-1.), _wtol(1.e-2), _freq(-1.)
+  : _cutoff(-1.), _wtol(1.e-2), _freq(-1.), _table_step(-1.)
 {
   const char funame [] = "Model::Tunnel::Tunnel : ";
 
@@ -2223,16 +2558,61 @@ Model::Tunnel::~Tunnel ()
   //std::cout << "Model::Tunnel destroyed\n";
 }
 
-// convolution of the number of states with the tunneling density
-void Model::Tunnel::convolute(Array<double>& stat, double step) const
+// tunneling density table: the step resolves the density width, the imaginary frequency over 2 pi,
+// to the statistical weight tolerance
+void Model::Tunnel::_set_table () const
 {
-  const char funame [] = "Model::Tunnel::convolute: ";
+  const char funame [] = "Model::Tunnel::_set_table: ";
 
   if(cutoff() < 0.) {
     std::cerr << funame << "cutoff energy is not initialized\n";
     throw Error::Init();
   }
 
+#pragma omp critical(tunnel_table)
+  {
+    if(!_table.size()) {
+      //
+      static const int size_max = 1000000;
+
+      int n = (int)std::ceil(2. * cutoff() / (_freq / 2. / M_PI * _wtol / 10.));
+      
+      n = n < 2 ? 2 : n > size_max ? size_max : n;
+
+      std::vector<double> table(n + 1);
+
+      const double step = 2. * cutoff() / (double)n;
+
+      for(int i = 0; i <= n; ++i)
+	table[i] = density((double)i * step - cutoff());
+
+      _table_step = step;
+      _table.swap(table);
+    }
+  }
+}
+
+double Model::Tunnel::_table_density (double ener) const
+{
+  const double x = (ener + cutoff()) / _table_step;
+
+  if(x < 0. || x > (double)(_table.size() - 1))
+    return 0.;
+
+  int i = (int)x;
+  if(i == _table.size() - 1)
+    --i;
+
+  const double f = x - (double)i;
+
+  return _table[i] * (1. - f) + _table[i + 1] * f;
+}
+
+// convolution of the number of states with the tunneling density
+void Model::Tunnel::convolute(Array<double>& stat, double step) const
+{
+  _set_table();
+
   double dtemp;
 
   // tunneling density of states
@@ -2240,7 +2620,7 @@ void Model::Tunnel::convolute(Array<double>& stat, double step) const
   double ener = - cutoff();
   double fac = 0.;
   for(int i = 0; i < td.size(); ++i, ener += step) {
-    dtemp = density(ener);
+    dtemp = _table_density(ener);
     td[i] = dtemp;
     fac  += dtemp;
   }
@@ -2248,18 +2628,9 @@ void Model::Tunnel::convolute(Array<double>& stat, double step) const
   td /= fac;
 
   Array<double> new_stat(stat.size());
-  
-#pragma omp parallel for default(shared) private(dtemp) schedule(dynamic, 1)
 
-  for(int j = 0; j < stat.size(); ++j) {
-    dtemp = 0.;
-    for(int i = 0; i < td.size(); ++i) {
-      if(i > j)
-	break;
-      dtemp += stat[j - i] * td[i];
-    }
-    new_stat[j] = dtemp;
-  }
+  // direct summation for short kernels, block FFT otherwise
+  Math::convolute(stat, stat.size(), td, td.size(), new_stat);
   
   stat = new_stat;
 }
@@ -2267,32 +2638,47 @@ void Model::Tunnel::convolute(Array<double>& stat, double step) const
 // statistical weight relative to cutoff energy
 double Model::Tunnel::weight (double temperature) const
 {
-  const char funame [] = "Model::Tunnel::weight: ";
+  std::vector<double> res;
 
-  if(cutoff() < 0.) {
-    std::cerr << funame << "cutoff energy is not initialized\n";
-    throw Error::Init();
-  }
+  weight(std::vector<double>(1, temperature), res);
 
-  double dtemp;
-  int    itemp;
+  return res[0];
+}
+
+// the table is summed with the Boltzmann factors relative to the cutoff energy, which do not overflow
+void Model::Tunnel::weight (const std::vector<double>& temperature, std::vector<double>& res) const
+{
+  const char funame [] = "Model::Tunnel::weight: ";
 
-  double estep = temperature * _wtol; // discretization energy step
-  itemp = (int)std::floor(cutoff() / estep);
-  int imax = 2 * itemp + 1;
-  double ener = -double(itemp) * estep;
+  _set_table();
+
+  const int     n = _table.size();
+  const double* d = &_table[0];
 
   double fac = 0.;
-  double res = 0.;
-  for(int i = 0; i < imax; ++i, ener += estep) {
-    dtemp = density(ener);
-    res += dtemp * std::exp(-ener / temperature);
-    fac += dtemp;
-  }
+  for(int i = 0; i < n; ++i)
+    fac += d[i];
 
-  res /= fac * std::exp(cutoff() / temperature);
+  res.resize(temperature.size());
 
-  return res;
+  for(int t = 0; t < temperature.size(); ++t) {
+    //
+    if(temperature[t] <= 0.) {
+      std::cerr << funame << "temperature out of range\n";
+      throw Error::Range();
+    }
+
+    const double x = _table_step / temperature[t];
+
+    double sum = 0.;
+
+#pragma omp simd reduction(+: sum)
+
+    for(int i = 0; i < n; ++i)
+      sum += d[i] * std::exp(-(double)i * x);
+
+    res[t] = sum / fac;
+  }
 }
 
 double Model::Tunnel::density (double ener) const
@@ -2377,7 +2763,7 @@ Model::ReadTunnel::ReadTunnel (IO::KeyBufferStream& from)
 
   /************************************* ACTION INPUT **********************************/
 
-  std::ifstream fin(file_name.c_str());
+  IO::FileStream fin(file_name.c_str());
   if(!fin) {
     std::cerr << funame << "cannot open rotd input file " << file_name << "\n";
     throw Error::Open();
@@ -3349,8 +3735,6 @@ void Model::Rotor::convolute(Array<double>& stat_grid, double ener_quant) const
   int    itemp;
   double dtemp;
 
-  Array<double> new_stat_grid = stat_grid;
-
   std::map<int, int> shift;
   
   for(int n = 1; n < level_size(); ++n) {
@@ -3379,15 +3763,21 @@ void Model::Rotor::convolute(Array<double>& stat_grid, double ener_quant) const
     }
   }
 
-#pragma omp parallel for default(shared) schedule(static, 10)
+  // level degeneracies on the grid, the ground level included
+  //
+  Array<double> level_grid(shift.size() ? shift.rbegin()->first + 1 : 1, 0.);
 
-  for(int i = 0; i < stat_grid.size(); ++i)
+  level_grid[0] = 1.;
+  
+  for(std::map<int, int>::const_iterator it = shift.begin(); it != shift.end(); ++it)
     //
-    for(std::map<int, int>::const_iterator it = shift.begin(); it != shift.end(); ++it)
-      //
-      if(i >= it->first)
-	//
-	new_stat_grid[i] += (double)it->second * stat_grid[i - it->first];
+    level_grid[it->first] += (double)it->second;
+
+  Array<double> new_stat_grid(stat_grid.size());
+
+  // direct summation for short level ladders, block FFT otherwise
+  //
+  Math::convolute(stat_grid, stat_grid.size(), level_grid, level_grid.size(), new_stat_grid);
 
   stat_grid = new_stat_grid; 
 }
@@ -4204,6 +4594,108 @@ double Model::HinderedRotor::potential (double angle, int der) const
   return res;
 }
 
+/*************************************** 1D ROTOR SPECTRA CACHE ***************************************/
+
+namespace {
+  //
+  std::string cache_file_name (const std::string& dir, const std::string& key, const char* ext);
+
+  void cache_put (std::ostream&, int);
+  void cache_put (std::ostream&, const std::vector<double>&);
+
+  bool cache_get (std::istream&, int&);
+  bool cache_get (std::istream&, std::vector<double>&);
+
+  // Hamiltonian eigenvalues, keyed by the 1D rotor definition, shared by all species
+  //
+  std::map<std::string, std::vector<double> > rotor_spectrum_pool;
+
+  bool rotor_spectrum (const std::string& key, std::vector<double>& el)
+  {
+    bool res = false;
+
+#pragma omp critical(rotor_spectrum_pool)
+    {
+      std::map<std::string, std::vector<double> >::const_iterator it = rotor_spectrum_pool.find(key);
+
+      if(it != rotor_spectrum_pool.end()) {
+	//
+	el = it->second;
+
+	res = true;
+      }
+    }
+
+    if(res || !Model::rotor_cache_dir.size())
+      //
+      return res;
+
+    const std::string name = cache_file_name(Model::rotor_cache_dir, key, ".spec");
+
+    std::ifstream from(name.c_str(), std::ios::binary);
+
+    if(!from)
+      //
+      return false;
+
+    int itemp;
+
+    std::string stemp;
+
+    if(cache_get(from, itemp) && itemp == key.size()) {
+      //
+      stemp.resize(itemp);
+
+      from.read(&stemp[0], itemp);
+    }
+
+    if(!from || stemp != key || !cache_get(from, el) || !el.size()) {
+      //
+      IO::log << IO::log_offset << "WARNING: rotor spectrum cache " << name << " does not match the rotor, ignoring\n";
+
+      return false;
+    }
+
+#pragma omp critical(rotor_spectrum_pool)
+
+    rotor_spectrum_pool[key] = el;
+
+    return true;
+  }
+
+  void save_rotor_spectrum (const std::string& key, const std::vector<double>& el)
+  {
+#pragma omp critical(rotor_spectrum_pool)
+
+    rotor_spectrum_pool[key] = el;
+
+    if(!Model::rotor_cache_dir.size() || IO::mpi_rank)
+      //
+      return;
+
+    const std::string name = cache_file_name(Model::rotor_cache_dir, key, ".spec");
+
+    IO::AtomicFile to(name);
+
+    if(!to) {
+      //
+      IO::log << IO::log_offset << "WARNING: cannot open rotor spectrum cache file " << to.tmp_name() << "\n";
+
+      return;
+    }
+
+    cache_put(to, (int)key.size());
+
+    to.write(key.data(), key.size());
+
+    cache_put(to, el);
+
+    if(!to.commit())
+      //
+      IO::log << IO::log_offset << "WARNING: cannot write rotor spectrum cache file " << name << "\n";
+  }
+}
+
 void Model::HinderedRotor::_set_energy_levels (int hsize) 
 {
   const char funame [] = "Model::HinderedRotor::_set_energy_levels: ";
@@ -4211,58 +4703,80 @@ void Model::HinderedRotor::_set_energy_levels (int hsize)
   int    itemp;
   double dtemp;
 
+  // the spectrum is defined by the rotational constant, the symmetry, the potential, and the basis size
+  //
+  std::ostringstream key;
 
-  /************************************ setting Hamiltonian ************************************/
+  key << "HinderedRotor " << std::setprecision(17) << rotational_constant() << " " << symmetry() << " " << hsize;
 
-  Lapack::SymmetricMatrix ham(hsize);
-  ham = 0.;
+  for(std::map<int, double>::const_iterator pit = _pot_four.begin(); pit != _pot_four.end(); ++pit)
+    //
+    key << " " << pit->first << " " << pit->second;
 
-  /*
-  //kinetic energy contribution
-  for(int ml = 1; ml < hsize; ++ml) 
-    for(int nl = ml; nl < hsize; ++nl) {// ket state cycle
-
-      int ifac = ((ml + 1) / 2) * ((nl + 1) / 2) * symmetry() * symmetry();
-      int m = ml;
-      if(ml % 2)// sine
-	++m;
-      else {// cosine
-	--m;
-	ifac = -ifac;
-      }
-      int n = nl;
-      if(nl % 2)// sine
-	++n;
-      else {// cosine
-	--n;
-	ifac = -ifac;
-      }
-	
-      // fourier expansion cycle
-      for(std::map<int, double>::const_iterator  mit = _mobility.begin(); mit != _mobility.end(); ++mit) {
-	dtemp = mit->second * (double)ifac;
-	if(!rotation_matrix_element(m, n, mit->first, dtemp))
-	  ham(m, n) += dtemp;
-      }
-    }// ket state cycle
-  */
+  std::vector<double> el;
 
-  // kinetic energy contribution
-  for(int i = 0; i < hsize; ++i) {
-    dtemp = double((i + 1) / 2 * symmetry());
-    ham(i, i) = rotational_constant() * dtemp * dtemp;
-  }
+  if(!rotor_spectrum(key.str(), el)) {
+    //
+    /*********************************** setting Hamiltonian ***********************************/
 
-  // potential contribution
-  for(int m = 0; m < hsize; ++m)
-    for(int n = m; n < hsize; ++n)
-      for(std::map<int, double>::const_iterator pit = _pot_four.begin(); pit != _pot_four.end(); ++pit) {
-	dtemp = pit->second;
-	if(!rotation_matrix_element(m, n, pit->first, dtemp))
-	  ham(m, n) += dtemp;
-      }
+    // the potential harmonic p couples the basis functions m and n with |m - n| <= p only
+    //
+    itemp = _pot_four.size() ? _pot_four.rbegin()->first + 1 : 1;
+
+    Lapack::BandMatrix ham(hsize, itemp < hsize ? itemp : hsize);
+    ham = 0.;
+
+    /*
+    //kinetic energy contribution
+    for(int ml = 1; ml < hsize; ++ml) 
+      for(int nl = ml; nl < hsize; ++nl) {// ket state cycle
+
+	int ifac = ((ml + 1) / 2) * ((nl + 1) / 2) * symmetry() * symmetry();
+	int m = ml;
+	if(ml % 2)// sine
+	  ++m;
+	else {// cosine
+	  --m;
+	  ifac = -ifac;
+	}
+	int n = nl;
+	if(nl % 2)// sine
+	  ++n;
+	else {// cosine
+	  --n;
+	  ifac = -ifac;
+	}
+
+	// fourier expansion cycle
+	for(std::map<int, double>::const_iterator  mit = _mobility.begin(); mit != _mobility.end(); ++mit) {
+	  dtemp = mit->second * (double)ifac;
+	  if(!rotation_matrix_element(m, n, mit->first, dtemp))
+	    ham(m, n) += dtemp;
+	}
+      }// ket state cycle
+    */
+
+    // kinetic energy contribution
+    for(int i = 0; i < hsize; ++i) {
+      dtemp = double((i + 1) / 2 * symmetry());
+      ham(i, i) = rotational_constant() * dtemp * dtemp;
+    }
+
+    // potential contribution
+    for(int m = 0; m < hsize; ++m)
+      for(int n = m; n < hsize && n < m + ham.band_size(); ++n)
+	for(std::map<int, double>::const_iterator pit = _pot_four.begin(); pit != _pot_four.end(); ++pit) {
+	  dtemp = pit->second;
+	  if(!rotation_matrix_element(m, n, pit->first, dtemp))
+	    ham(m, n) += dtemp;
+	}
+
+    Lapack::Vector ev = ham.eigenvalues();
+
+    el.assign((const double*)ev, (const double*)ev + ev.size());
 
-  Lapack::Vector el = ham.eigenvalues();
+    save_rotor_spectrum(key.str(), el);
+  }
 
   // ground state energy
   _ground = el[0];
@@ -4865,32 +5379,75 @@ void Model::Umbrella::_set_energy_levels (int hsize)
   int    itemp;
   double dtemp;
 
-  // setting  hamiltonian
-  Lapack::SymmetricMatrix ham(hsize);
+  std::ostringstream key;
 
-  for(int m = 0; m < hsize; ++m)
-    for(int n = m; n < hsize; ++n) {
-      dtemp = 0.;
-      for(int p = 1; p < _pot_coef.size(); ++p)
-	dtemp += _pot_coef[p] * (_integral(p, n - m) - _integral(p, m + n + 2));
-      ham(m, n) = dtemp;
+  key << "Umbrella " << std::setprecision(17) << _mass << " " << hsize;
+
+  for(int p = 0; p < _pot_coef.size(); ++p)
+    //
+    key << " " << _pot_coef[p];
+
+  std::vector<double> el;
+
+  // the levels above the highest basis function kinetic energy are not converged
+  double ener_max = (double)hsize * M_PI;
+  ener_max = ener_max * ener_max / 2. / _mass + _pot_min;
+
+  if(!rotor_spectrum(key.str(), el)) {
+    //
+    const int psize = _pot_coef.size();
+    const int nsize = 2 * hsize + 1;
+
+    std::vector<double> integral;
+    _integral_table(psize, nsize, integral);
+
+    // setting  hamiltonian
+    Lapack::SymmetricMatrix ham(hsize);
+
+    for(int m = 0; m < hsize; ++m)
+      for(int n = m; n < hsize; ++n) {
+	dtemp = 0.;
+	for(int p = 1; p < psize; ++p)
+	  dtemp += _pot_coef[p] * (integral[p * nsize + n - m] - integral[p * nsize + m + n + 2]);
+	ham(m, n) = dtemp;
+      }
+
+    for(int m = 0; m < hsize; ++m) {
+      dtemp = M_PI * double(m + 1);
+      ham(m, m) += _pot_coef[0] + dtemp * dtemp / 2. / _mass;
     }
 
-  for(int m = 0; m < hsize; ++m) {
-    dtemp = M_PI * double(m + 1);
-    ham(m, m) += _pot_coef[0] + dtemp * dtemp / 2. / _mass;
-  }
+    // only the levels below the limit: the lower end of the interval is the Gershgorin bound
+    double ener_min = 0.;
+    for(int m = 0; m < hsize; ++m) {
+      dtemp = ham(m, m);
+      for(int n = 0; n < hsize; ++n)
+	if(n != m)
+	  dtemp -= std::fabs(ham(m, n));
+
+      if(!m || dtemp < ener_min)
+	ener_min = dtemp;
+    }
+
+    Lapack::Vector ev;
+    if(ener_min < ener_max)
+      ev = ham.interval_eigenvalues(ener_min - 1., ener_max);
+
+    // at least the ground level
+    if(!ev.isinit() || !ev.size())
+      ev = ham.lowest_eigenvalues(1);
+
+    el.assign((const double*)ev, (const double*)ev + ev.size());
 
-  Lapack::Vector el = ham.eigenvalues();
+    save_rotor_spectrum(key.str(), el);
+  }
 
   // updating energy levels
   _ground  = el.front();
   _energy_level.clear();
-  _energy_level.reserve(hsize);
-  dtemp = (double)hsize * M_PI;
-  dtemp = dtemp * dtemp / 2. / _mass + _pot_min;
-  for(int i = 0; i < hsize; ++i) {
-    if(el[i] > dtemp)
+  _energy_level.reserve(el.size());
+  for(int i = 0; i < el.size(); ++i) {
+    if(el[i] > ener_max)
       break;
     _energy_level.push_back(el[i] - _ground);
   }
@@ -4924,24 +5481,44 @@ double Model::Umbrella::potential(double x, int der) const
   return res;
 }
 
-double Model::Umbrella::_integral(int p, int n)
+void Model::Umbrella::_integral_table (int psize, int nsize, std::vector<double>& res)
 {
-  if(!n)
-    return 1. / (1. + (double)p);
+  // by the power, then by the harmonic
+  static std::vector<std::vector<double> > table;
 
-  if(!p)
-    return 0.;
+  res.resize(psize * nsize);
+
+#pragma omp critical(umbrella_integral)
+  {
+    if(table.size() < psize)
+      table.resize(psize);
+
+    for(int p = 0; p < psize; ++p)
+      for(int n = table[p].size(); n < nsize; ++n) {
+	double val;
 
-  n = n < 0 ? -n : n;
+	if(!n)
+	  val = 1. / (1. + (double)p);
+	else if(!p)
+	  val = 0.;
+	else {
+	  int v = n % 2 ? -1 : 1;
+	  double dtemp = M_PI * (double)n;
+	  dtemp *= dtemp;
 
-  int v = n % 2 ? -1 : 1;
-  double dtemp = M_PI * (double)n;
-  dtemp *= dtemp;
+	  if(p == 1)
+	    val = double(v - 1) / dtemp;
+	  else
+	    val = ((double)v - double(p - 1) * table[p - 2][n]) * double(p) / dtemp;
+	}
 
-  if(p == 1)
-    return double(v - 1) / dtemp;
+	table[p].push_back(val);
+      }
 
-  return ((double)v - double(p - 1) * _integral(p - 2, n)) * double(p) / dtemp;
+    for(int p = 0; p < psize; ++p)
+      for(int n = 0; n < nsize; ++n)
+	res[p * nsize + n] = table[p][n];
+  }
 }
 
 double Model::Umbrella::ground () const
@@ -5030,6 +5607,80 @@ Model::Core::~Core ()
   //std::cout << "Model::Core destroyed\n";
 }
 
+void Model::Core::weight (const double* temperature, int size, double* res) const
+{
+  for(int t = 0; t < size; ++t)
+    res[t] = weight(temperature[t]);
+}
+
+namespace {
+  //
+  // each temperature followed by its two differentiation neighbours
+  //
+  std::vector<double> difference_grid (const double* temperature, int size, double rel_incr)
+  {
+    std::vector<double> res(3 * size);
+
+    for(int t = 0; t < size; ++t) {
+      res[3 * t]     = temperature[t];
+      res[3 * t + 1] = temperature[t] - temperature[t] * rel_incr;
+      res[3 * t + 2] = temperature[t] + temperature[t] * rel_incr;
+    }
+
+    return res;
+  }
+
+  // log of the weights and its temperature derivatives from the weights on the difference grid
+  //
+  void difference_moments (const char* funame, const double* temperature, int size, double rel_incr,
+			   const double* weight, double* lw, double* d1, double* d2)
+  {
+    double z [3];
+
+    for(int t = 0; t < size; ++t) {
+      //
+      for(int i = 0; i < 3; ++i) {
+	//
+	if(weight[3 * t + i] <= 0.) {
+	  std::cerr << funame << "nonpositive weight: " << weight[3 * t + i] << "\n";
+	  throw Error::Range();
+	}
+
+	z[i] = std::log(weight[3 * t + i]);
+      }
+
+      const double incr = temperature[t] * rel_incr;
+
+      lw[t] = z[0];
+      d1[t] = (z[2] - z[1]) / 2. / incr;
+      d2[t] = (z[2] + z[1] - 2. * z[0]) / incr / incr;
+    }
+  }
+}
+
+void Model::Core::thermal_moments (const double* temperature, int size, double rel_incr,
+				   double* lw, double* d1, double* d2) const
+{
+  const char funame [] = "Model::Core::thermal_moments: ";
+
+  if(!size)
+    return;
+
+  const std::vector<double> tt = difference_grid(temperature, size, rel_incr);
+
+  std::vector<double> ww(tt.size());
+
+  weight(&tt[0], tt.size(), &ww[0]);
+
+  difference_moments(funame, temperature, size, rel_incr, &ww[0], lw, d1, d2);
+}
+
+void Model::Core::states (const double* ener, int size, double* res) const
+{
+  for(int i = 0; i < size; ++i)
+    res[i] = states(ener[i]);
+}
+
 /********************************************************************************************
  *************************** PHASE SPACE THEORY NUMBER OF STATES ****************************
  ********************************************************************************************/
@@ -5278,6 +5929,22 @@ double Model::PhaseSpaceTheory::states (double ener) const
   return _states_factor * std::pow(ener, _power);
 }
 
+// the number of states is a power of the energy, so that the grids are evaluated directly
+//
+void Model::PhaseSpaceTheory::weight (const double* temperature, int size, double* res) const
+{
+#pragma omp simd
+  for(int t = 0; t < size; ++t)
+    res[t] = _weight_factor * std::pow(temperature[t], _power);
+}
+
+void Model::PhaseSpaceTheory::states (const double* ener, int size, double* res) const
+{
+#pragma omp simd
+  for(int i = 0; i < size; ++i)
+    res[i] = _states_factor * std::pow(ener[i], _power);
+}
+
 /********************************************************************************************
  *********************************** RIGID ROTOR CORE MODEL *********************************
  ********************************************************************************************/
@@ -5843,13 +6510,14 @@ Model::RigidRotor::RigidRotor(IO::KeyBufferStream& from, const std::vector<Atom>
       ener_grid[0] = 0.;
       stat_grid[0] = 0.;
 
+      // energy grid
       dtemp = ener_quant;
-      for(int i = 1; i < ener_grid.size(); ++i, dtemp += ener_quant) {
-	// energy grid
+      for(int i = 1; i < ener_grid.size(); ++i, dtemp += ener_quant)
 	ener_grid[i] = dtemp;
-	// core density / number of states
-	stat_grid[i] = _core_states(dtemp);
-      }
+
+      // core density / number of states
+      if(ener_grid.size() > 1)
+	_core_states(&ener_grid[1], ener_grid.size() - 1, &stat_grid[1]);
 
       for(int f = 0; f < _frequency.size(); ++f) {
 	itemp = (int)round(_frequency[f] / ener_quant);
@@ -5857,9 +6525,7 @@ Model::RigidRotor::RigidRotor(IO::KeyBufferStream& from, const std::vector<Atom>
 	  std::cerr << funame << "negative frequency\n";
 	  throw Error::Range();
 	}
-	for(int i = 0; i < _fdegen[f]; ++i)
-	  for(int e = itemp + 1; e < ener_grid.size(); ++e)
-	    stat_grid[e] += stat_grid[e - itemp];
+	Math::state_count(stat_grid, ener_grid.size(), itemp, _fdegen[f]);
       }
 
       _states.init(ener_grid, stat_grid, ener_grid.size());
@@ -6265,13 +6931,99 @@ double Model::RigidRotor::states (double ener) const
   return _states(ener);
 }
 
-double Model::RigidRotor::_core_states (double ener) const
+void Model::RigidRotor::states (const double* ener, int size, double* res) const
 {
   const char funame [] = "Model::RigidRotor::states: ";
 
-  if(ener <= 0.)
-    return 0.;
-
+  if(mode() == NOSTATES) {
+    std::cerr << funame << "wrong case\n";
+    throw Error::Logic();
+  }
+  
+  if(!_frequency.size()) {
+    _core_states(ener, size, res);
+    return;
+  }
+
+  // interpolation on the sorted grid sections at once
+  int i = 0;
+  while(i < size) {
+    //
+    double e = ener[i] - ground();
+
+    if(e <= 0. || e >= _states.arg_max()) {
+      res[i] = states(ener[i]);
+      ++i;
+      continue;
+    }
+
+    std::vector<double> x(1, e);
+    for(int n = i + 1; n < size; ++n) {
+      e = ener[n] - ground();
+      if(e <= x.back() || e >= _states.arg_max())
+	break;
+      x.push_back(e);
+    }
+
+    _states.evaluate(&x[0], x.size(), res + i);
+
+    i += x.size();
+  }
+}
+
+void Model::RigidRotor::_core_states (const double* ener, int size, double* res) const
+{
+  const char funame [] = "Model::RigidRotor::_core_states: ";
+
+  double fac;
+  switch(mode()) {
+  case DENSITY:
+    fac = _rdim == 2 ? _factor : _factor * 2.;
+    break;
+  case NUMBER:
+    fac = _rdim == 2 ? _factor : _factor * 1.3333333333333;
+    break;
+  default:
+    std::cerr << funame << "wrong case\n";
+    throw Error::Logic();
+  }
+
+  // power of the energy: 0 or 1 for the linear, 1/2 or 3/2 for the nonlinear rotor
+  const int pow_case = (mode() == NUMBER) + 2 * (_rdim != 2);
+
+#pragma omp parallel for default(shared) schedule(static)
+
+  for(int i = 0; i < size; ++i) {
+    const double e = ener[i];
+
+    if(e <= 0.) {
+      res[i] = 0.;
+      continue;
+    }
+
+    switch(pow_case) {
+    case 0:
+      res[i] = fac;
+      break;
+    case 1:
+      res[i] = fac * e;
+      break;
+    case 2:
+      res[i] = fac * std::sqrt(e);
+      break;
+    default:
+      res[i] = fac * std::sqrt(e) * e;
+    }
+  }
+}
+
+double Model::RigidRotor::_core_states (double ener) const
+{
+  const char funame [] = "Model::RigidRotor::states: ";
+
+  if(ener <= 0.)
+    return 0.;
+
   switch(mode()) {
   case DENSITY:
     if(_rdim == 2)
@@ -6378,7 +7130,7 @@ Model::Rotd::Rotd(IO::KeyBufferStream& from, int m)
 
   /************************************* ROTD INPUT **********************************/
 
-  std::ifstream rotd_in(rotd_name.c_str());
+  IO::FileStream rotd_in(rotd_name.c_str());
   if(!rotd_in) {
     std::cerr << funame << "cannot open rotd input file " << rotd_name << "\n";
     throw Error::Open();
@@ -6454,6 +7206,31 @@ Model::Rotd::Rotd(IO::KeyBufferStream& from, int m)
 	  << _rotd_emax / Phys_const::kcal << " kcal/mol = " << _rotd_nmax << "\n"
 	  << IO::log_offset << "ground energy [kcal/mol] = " << _ground / Phys_const::kcal << "\n";
 
+  // the davint integral is linear in the integrand: the quadrature weights are
+  // the integrals of the unit vectors, set once for all temperatures
+  _rotd_quad.resize(_rotd_ener.size());
+
+  Array<double> unit(_rotd_ener.size());
+  unit = 0.;
+
+  for(int i = 0; i < _rotd_ener.size(); ++i) {
+    unit[i] = 1.;
+
+    int info;
+    davint_(_rotd_ener, unit, unit.size(), _rotd_ener.front(), _rotd_ener.back(), dtemp, info); 
+    if (info != 1) {
+      std::cerr << funame  << "davint integration error\n";
+      throw Error::Logic();
+    }
+
+    _rotd_quad[i] = dtemp * _rotd_nos[i];
+    unit[i] = 0.;
+  }
+
+  _rotd_quad[0] = 0.;
+
+  _rotd_tail = _rotd_amax * std::pow(_rotd_emax, _rotd_nmax);
+
 }// Rotd Core
 
 Model::Rotd::~Rotd ()
@@ -6497,7 +7274,54 @@ double Model::Rotd::states (double ener) const
   }
 }
 
+// the spline is evaluated on the sorted grid sections at once
+void Model::Rotd::states (const double* ener, int size, double* res) const
+{
+  int i = 0;
+  while(i < size) {
+    //
+    if(ener[i] <= _rotd_emin || ener[i] >= _rotd_emax) {
+      res[i] = states(ener[i]);
+      ++i;
+      continue;
+    }
+
+    int n = i + 1;
+    while(n < size && ener[n] > _rotd_emin && ener[n] < _rotd_emax && ener[n] > ener[n - 1])
+      ++n;
+    n -= i;
+
+    std::vector<double> x(n), y(n);
+    for(int k = 0; k < n; ++k)
+      x[k] = std::log(ener[i + k]);
+
+    _rotd_spline.evaluate(&x[0], n, &y[0]);
+
+    if(mode() == DENSITY) {
+      std::vector<double> z(n);
+      _rotd_spline.evaluate(&x[0], n, &z[0], 1);
+
+      for(int k = 0; k < n; ++k)
+	res[i + k] = std::exp(y[k]) * z[k] / ener[i + k];
+    }
+    else
+      for(int k = 0; k < n; ++k)
+	res[i + k] = std::exp(y[k]);
+
+    i += n;
+  }
+}
+
 double Model::Rotd::weight (double temperature) const
+{
+  double res;
+
+  weight(&temperature, 1, &res);
+
+  return res;
+}
+
+void Model::Rotd::weight (const double* temperature, int size, double* res) const
 {
   const char funame [] = "Model::Rotd::weight: ";
 
@@ -6505,33 +7329,91 @@ double Model::Rotd::weight (double temperature) const
 
   double dtemp;
 
-  Array<double> term(_rotd_nos.size());
-  term[0] = 0.;
-  for(int i = 1; i < _rotd_nos.size(); ++i)
-    term[i] = _rotd_nos[i] / std::exp(_rotd_ener[i] / temperature);
+  const int     n = _rotd_quad.size();
+  const double* q = _rotd_quad;
+  const double* e = _rotd_ener;
 
-  int info;
-  double res;
-  davint_(_rotd_ener, term, term.size(), _rotd_ener.front(), _rotd_ener.back(), res, info); 
-  if (info != 1) {
-    std::cerr << funame  << "davint integration error\n";
-    throw Error::Logic();
-  }
-  res /= temperature;
+  for(int t = 0; t < size; ++t) {
+    //
+    const double x = 1. / temperature[t];
 
-  dtemp = _rotd_emax / temperature;
-  if(dtemp <= _rotd_nmax) {
-    IO::log << IO::log_offset << funame << "WARNING: " 
-	    << "integration cutoff energy is less than weight maximum energy\n";
-    return res;
+    double sum = 0.;
+
+#pragma omp simd reduction(+: sum)
+
+    for(int i = 1; i < n; ++i)
+      sum += q[i] * std::exp(-e[i] * x);
+
+    res[t] = sum / temperature[t];
+
+    dtemp = _rotd_emax / temperature[t];
+    if(dtemp <= _rotd_nmax) {
+      IO::log << IO::log_offset << funame << "WARNING: " 
+	      << "integration cutoff energy is less than weight maximum energy\n";
+      continue;
+    }
+
+    dtemp = _rotd_tail / std::exp(dtemp) / (1. - _rotd_nmax / dtemp);
+    if(dtemp / res[t] > eps)
+      IO::log << IO::log_offset << funame << "WARNING: integration cutoff error = " << dtemp / res[t] << "\n";    
+    res[t] += dtemp;
   }
+}
+
+// the energy moments of the same quadrature
+//
+void Model::Rotd::thermal_moments (const double* temperature, int size, double, double* lw, double* d1, double* d2) const
+{
+  const char funame [] = "Model::Rotd::thermal_moments: ";
 
-  dtemp = _rotd_amax * std::pow(_rotd_emax, _rotd_nmax) / std::exp(dtemp) / (1. - _rotd_nmax / dtemp);
-  if(dtemp / res > eps)
-    IO::log << IO::log_offset << funame << "WARNING: integration cutoff error = " << dtemp / res << "\n";    
-  res += dtemp;
+  const int     n = _rotd_quad.size();
+  const double* q = _rotd_quad;
+  const double* e = _rotd_ener;
 
-  return res;
+  for(int t = 0; t < size; ++t) {
+    //
+    const double tval = temperature[t];
+    const double x    = 1. / tval;
+
+    double s0 = 0., s1 = 0., s2 = 0.;
+
+#pragma omp simd reduction(+: s0, s1, s2)
+
+    for(int i = 1; i < n; ++i) {
+      const double f = q[i] * std::exp(-e[i] * x);
+      s0 += f;
+      s1 += f * e[i];
+      s2 += f * e[i] * e[i];
+    }
+
+    // w = s0 / T and its derivatives
+    double w0 = s0 / tval;
+    double w1 = (s1 * x - s0) * x * x;
+    double w2 = (s2 * x * x - 4. * s1 * x + 2. * s0) * x * x * x;
+
+    // high energy tail: a * exp(-E/T) / (1 - n * T / E)
+    const double dtemp = _rotd_emax / tval;
+    if(dtemp > _rotd_nmax) {
+      //
+      const double u  = _rotd_nmax / _rotd_emax;
+      const double c0 = _rotd_tail / std::exp(dtemp) / (1. - _rotd_nmax / dtemp);
+      const double l1 = _rotd_emax * x * x + u / (1. - u * tval);
+      const double l2 = -2. * _rotd_emax * x * x * x + u * u / (1. - u * tval) / (1. - u * tval);
+
+      w0 += c0;
+      w1 += c0 * l1;
+      w2 += c0 * (l2 + l1 * l1);
+    }
+
+    if(w0 <= 0.) {
+      std::cerr << funame << "nonpositive weight: " << w0 << "\n";
+      throw Error::Range();
+    }
+
+    lw[t] = std::log(w0);
+    d1[t] = w1 / w0;
+    d2[t] = w2 / w0 - d1[t] * d1[t];
+  }
 }
 
 /********************************************************************************************
@@ -6774,6 +7656,87 @@ Model::InternalRotation::~InternalRotation ()
  ***************************** MULTIPLE COUPLED ROTORS MODEL ********************************
  ********************************************************************************************/
 
+namespace {
+  //
+  // real fourier transform of the data sampled on the multidimensional uniform grid,
+  //
+  //   res(h, c) = sum_g data(g, c) prod_r f(h_r, g_r),
+  //
+  // f(0, g) = 1, f(2k - 1, g) = sin(2 pi k g / n), f(2k, g) = cos(2 pi k g / n); the data
+  // component index is the fastest one; the transform is done one dimension at a time,
+  // i.e., with the cost of the grid size times the sum of the expansion dimensions
+  //
+  void real_fourier_transform (const MultiIndexConvert& grid, const MultiIndexConvert& four, int csize,
+			       const std::vector<double>& data, std::vector<double>& res)
+  {
+    const char funame [] = "real_fourier_transform: ";
+
+    if(grid.rank() != four.rank() || csize <= 0 || data.size() != grid.size() * csize) {
+      //
+      std::cerr << funame << "dimensions mismatch\n";
+
+      throw Error::Range();
+    }
+
+    std::vector<double> curr = data, next;
+
+    // the transformed dimensions are the fastest ones
+    //
+    long inner = csize;
+
+    for(int r = 0; r < grid.rank(); ++r) {
+      //
+      const int n = grid.size(r);
+      const int m = four.size(r);
+
+      const long outer = curr.size() / inner / n;
+
+      std::vector<double> basis(m * n);
+
+      for(int h = 0; h < m; ++h)
+	//
+	for(int g = 0; g < n; ++g)
+	  //
+	  if(!h) {
+	    //
+	    basis[h * n + g] = 1.;
+	  }
+	  else if(h % 2) {
+	    //
+	    basis[h * n + g] = std::sin(M_PI * double((h + 1) * g) / double(n));
+	  }
+	  else
+	    //
+	    basis[h * n + g] = std::cos(M_PI * double(h * g) / double(n));
+
+      next.assign(outer * m * inner, 0.);
+
+      for(long o = 0; o < outer; ++o)
+	//
+	for(int h = 0; h < m; ++h) {
+	  //
+	  double* y = &next[(o * m + h) * inner];
+
+	  for(int g = 0; g < n; ++g) {
+	    //
+	    const double  b = basis[h * n + g];
+	    const double* x = &curr[(o * n + g) * inner];
+
+	    for(long i = 0; i < inner; ++i)
+	      //
+	      y[i] += b * x[i];
+	  }
+	}
+
+      curr.swap(next);
+
+      inner *= m;
+    }
+
+    res.swap(curr);
+  }
+}
+
 Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>& atom, int mm)  
 
   : Core(mm), _extra_ener(-1.), _extra_step(0.1), _ener_quant(Phys_const::incm), _level_ener_max(-1.),
@@ -6786,6 +7749,12 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
 
   IO::Marker funame_marker(funame);
 
+  // the model definition text identifies the quantum states cache entry
+  //
+  std::streampos cache_start = from.tellg();
+
+  std::ostringstream cache_key;
+
   KeyGroup MultiRotorModel;
 
   Key      irot_key("InternalRotation"                );
@@ -6884,7 +7853,7 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
 	throw Error::Input();
       }
 
-      std::ifstream file_input(stemp.c_str());
+      IO::FileStream file_input(stemp.c_str());
 
       if(!file_input) {
 	//
@@ -6893,6 +7862,13 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
 	throw Error::Input();
       }
 
+      if(multirotor_cache_dir.size()) {
+	//
+	std::ifstream pes_text(stemp.c_str());
+
+	cache_key << pes_text.rdbuf() << "\n";
+      }
+
       // sampling dimensions      
       //
       ivec.clear();
@@ -7327,6 +8303,27 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
     throw Error::Input();
   }
 
+  // quantum states cache key: the model definition, the potential energy surface, and the geometry
+  //
+  if(multirotor_cache_dir.size()) {
+    //
+    std::streampos cache_end = from.tellg();
+
+    std::string text(cache_end - cache_start, ' ');
+
+    from.seekg(cache_start);
+
+    from.read(&text[0], text.size());
+
+    from.seekg(cache_end);
+
+    cache_key << text << "\n" << mode() << std::setprecision(17);
+
+    for(int a = 0; a < atom.size(); ++a)
+      //
+      cache_key << " " << atom[a].name() << " " << atom[a][0] << " " << atom[a][1] << " " << atom[a][2];
+  }
+
   // number of internal motions
   //
   if(!internal_size()) {
@@ -7421,6 +8418,14 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
       _ctf_real.resize(_mass_index.size());
     }
 
+    // sampled internal mobility matrix, its effective counterpart, and the rotation factors
+    //
+    const int tri_size = internal_size() * (internal_size() + 1) / 2;
+
+    const int mass_csize = _with_ctf ? 2 * tri_size + 4 : tri_size + 3;
+
+    std::vector<double> mass_data(_mass_index.size() * mass_csize);
+
     // sampling geometries
     //
     for(int g = 0; g < _mass_index.size(); ++g) {// grid cycle
@@ -7553,26 +8558,38 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
 	IO::log << "\n";
       }
 
-      // Cholesky representation
-      //
-      Lapack::Cholesky gmm_chol(gmm);
-
       // external rotation factor - sqrt(inertia moments product)
       //
-      const double  erf = Lapack::Cholesky(inertia_moment_matrix(atom_current)).det_sqrt();
+      const double  erf = Lapack::det_sqrt(inertia_moment_matrix(atom_current));
 
-      // internal rotation factor
+      // internal rotation factor and internal mobility matrix from the Cholesky
+      // representation, the small matrices being factorized inline
       //
-      const double irf = gmm_chol.det_sqrt();
+      double irf;
+
+      Lapack::SymmetricMatrix imm;
+
+      if(internal_size() <= Lapack::SmallCholesky::DIM_MAX) {
+	//
+	Lapack::SmallCholesky gmm_chol(gmm);
+
+	irf = gmm_chol.det_sqrt();
+
+	imm = gmm_chol.invert();
+      }
+      else {
+	//
+	Lapack::Cholesky gmm_chol(gmm);
+
+	irf = gmm_chol.det_sqrt();
+
+	imm = gmm_chol.invert();
+      }
 
       // curvlinear transformation factor
       //
       const double ctf = irf * erf;
 
-      // internal mobility matrix
-      //
-      Lapack::SymmetricMatrix imm = gmm_chol.invert();
-
       imm /= 2.;
 
       Lapack::SymmetricMatrix eff_imm;
@@ -7648,82 +8665,91 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
 	}
       }
 
-      for(int h = 0; h < _mass_index.size(); ++h) {// fourier expansion cycle
+      double* md = &mass_data[g * mass_csize];
+
+      for(int i = 0; i < internal_size(); ++i)
 	//
-	std::vector<int> hv = _mass_index(h);
-	
-	double dfac = 1.;
-       
-	for(int r = 0; r < internal_size(); ++r) {
+	for(int j = i; j < internal_size(); ++j)
 	  //
-	  if(!hv[r])
-	    //
-	    continue;
-	  
-	  if(hv[r] % 2) {
-	    //
-	    dfac *= std::sin(M_PI * double((hv[r] + 1) * gv[r])/ double(_mass_index.size(r)));
-	  }
-	  else
-	    //
-	    dfac *= std::cos(M_PI * double(hv[r] * gv[r])/ double(_mass_index.size(r)));
-	}
+	  *md++ = imm(i, j);
 
-	for(int i = 0; i < internal_size(); ++i) {
+      if(_with_ctf)
+	//
+	for(int i = 0; i < internal_size(); ++i)
 	  //
-	  for(int j = i; j < internal_size(); ++j) {
+	  for(int j = i; j < internal_size(); ++j)
 	    //
-	    //#pragma omp atomic
-	    //
-	    _imm_four[h](i, j) += imm(i, j) * dfac;
+	    *md++ = eff_imm(i, j);
 
-	    if(_with_ctf) {
-	      //
-	      _eff_imm_four[h](i, j) += eff_imm(i, j) * dfac;
-	      //
-	    }//
-	    //
-	  }//
-	  //
-	}//
+      *md++ = ctf;
 
-	
-	if(_with_ctf)
-	  //
-	  _eff_erf_four[h] += erf * ctf * dfac;
+      *md++ = irf;
 
-	_ctf_four[h] += ctf * dfac;
-	
-	_irf_four[h] += irf * dfac;
+      *md++ = erf;
 
-	_erf_four[h] += erf * dfac;
-	
+      if(_with_ctf)
 	//
-      }// fourier expansion cycle
+	*md++ = erf * ctf;
       //
     }// grid cycle    
   
-    // normalization
+    // fourier expansion
     //
-    for(int h = 0; h < _mass_index.size(); ++h) {// fourier expansion cycle
-      //
-      std::vector<int> hv = _mass_index(h);
+    std::vector<double> mass_four;
 
-      // normalization factor
+    real_fourier_transform(_mass_index, _mass_index, mass_csize, mass_data, mass_four);
+
+    for(int h = 0; h < _mass_index.size(); ++h) {// fourier expansion cycle
       //
-      double dfac = double(_mass_index.size());
+      const double* mf = &mass_four[h * mass_csize];
 
-      for(int r = 0; r < internal_size(); ++r)
+      for(int i = 0; i < internal_size(); ++i)
 	//
-	if(hv[r])
+	for(int j = i; j < internal_size(); ++j)
 	  //
-	  dfac /= 2.;
-    
-      _imm_four[h] /= dfac;	  
+	  _imm_four[h](i, j) = *mf++;
 
-      if(_with_ctf) {
+      if(_with_ctf)
 	//
-	_eff_imm_four[h] /= dfac;
+	for(int i = 0; i < internal_size(); ++i)
+	  //
+	  for(int j = i; j < internal_size(); ++j)
+	    //
+	    _eff_imm_four[h](i, j) = *mf++;
+
+      _ctf_four[h] = *mf++;
+
+      _irf_four[h] = *mf++;
+
+      _erf_four[h] = *mf++;
+
+      if(_with_ctf)
+	//
+	_eff_erf_four[h] = *mf++;
+      //
+    }// fourier expansion cycle
+
+    // normalization
+    //
+    for(int h = 0; h < _mass_index.size(); ++h) {// fourier expansion cycle
+      //
+      std::vector<int> hv = _mass_index(h);
+
+      // normalization factor
+      //
+      double dfac = double(_mass_index.size());
+
+      for(int r = 0; r < internal_size(); ++r)
+	//
+	if(hv[r])
+	  //
+	  dfac /= 2.;
+    
+      _imm_four[h] /= dfac;	  
+
+      if(_with_ctf) {
+	//
+	_eff_imm_four[h] /= dfac;
 
 	_eff_erf_four[h] /= dfac;
       }
@@ -8783,12 +9809,26 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
 
     IO::log << IO::log_offset << "potential fourier expansion size = " << _pot_four_index.size() << std::endl;
 
-    // potential fourier expansion
+    // sampled potential, vibrational frequencies, and their effective counterparts
     //
+    const int vib_size = _vib_four.size();
+
+    const int pot_csize = _with_ctf ? 2 * (vib_size + 1) : vib_size + 1;
+
+    std::vector<double> pot_data(_pot_index.size() * pot_csize);
+
     for(int g = 0; g < _pot_index.size(); ++g) {// grid cycle
       //
       std::vector<int> gv = _pot_index(g);
 
+      double* pd = &pot_data[g * pot_csize];
+
+      *pd++ = _pot_real[g];
+
+      for(int v = 0; v < vib_size; ++v)
+	//
+	*pd++ = vibration_sampling[g][v];
+
       if(_with_ctf) {
 	//
 	// sampling configuration
@@ -8799,61 +9839,43 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
 	  //
 	  angle[r] = 2. * M_PI * double(gv[r]) / double(symmetry(r) * _pot_index.size(r));
 
-	dtemp = curvlinear_factor(angle);
+	const double ctf = curvlinear_factor(angle);
+
+	*pd++ = _pot_real[g] * ctf;
+
+	for(int v = 0; v < vib_size; ++v)
+	  //
+	  *pd++ = vibration_sampling[g][v] * ctf;
       }
+      //
+    }// grid cycle
 
-      const double ctf = dtemp;
-      
-      for(int h = 0; h < _pot_four_index.size(); ++h) {// fourier expansion cycle
-	//
-	std::vector<int> hv = _pot_four_index(h);
+    // potential fourier expansion
+    //
+    std::vector<double> pot_four;
 
-	// fourier transform
-	//
-	double dfac = 1.;
+    real_fourier_transform(_pot_index, _pot_four_index, pot_csize, pot_data, pot_four);
 
-	for(int r = 0; r < internal_size(); ++r) {
-	  //
-	  if(!hv[r])
-	    //
-	    continue;
+    for(int h = 0; h < _pot_four_index.size(); ++h) {// fourier expansion cycle
+      //
+      const double* pf = &pot_four[h * pot_csize];
 
-	  if(hv[r] % 2) {
-	    //
-	    dfac *= std::sin(M_PI * double((hv[r] + 1)  * gv[r]) / double(_pot_index.size(r)));
-	  }
-	  else
-	    //
-	    dfac *= std::cos(M_PI * double(hv[r] * gv[r]) / double(_pot_index.size(r)));
-	}
+      _pot_four[h] = *pf++;
 
-	// potential
+      for(int v = 0; v < vib_size; ++v)
 	//
-	_pot_four[h] += dfac * _pot_real[g];
+	_vib_four[v][h] = *pf++;
 
-	// vibrational frequencies
+      if(_with_ctf) {
 	//
-	for(int v = 0; v < _vib_four.size(); ++v) {
-	  //
-	  _vib_four[v][h] += dfac * vibration_sampling[g][v];
-	}//
-
-	if(_with_ctf) {
-	  //
-	  _eff_pot_four[h] += dfac * _pot_real[g] * ctf;
+	_eff_pot_four[h] = *pf++;
 
-	  // vibrational frequencies
-	  //
-	  for(int v = 0; v < _vib_four.size(); ++v) {
-	    //
-	    _eff_vib_four[v][h] += dfac * vibration_sampling[g][v] * ctf;
-	  }//
+	for(int v = 0; v < vib_size; ++v)
 	  //
-	}//
-	//
-      }// fourier expansion cycle
+	  _eff_vib_four[v][h] = *pf++;
+      }
       //
-    }// grid cycle
+    }// fourier expansion cycle
 
     // normalization
     //
@@ -9919,9 +10941,7 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
     //
     _mobility_parameter.resize(internal_size());
 
-    _mobility_min = mass(angle_min).invert();
-
-    _mobility_min /= 2.;
+    _mobility_min = mobility(angle_min);
 
     if(internal_size() == 1) {
       //
@@ -10090,7 +11110,14 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
   //
   if(_level_ener_max > 0. && (mode() != NOSTATES || force_qfactor)) {
     //
-    _set_qfactor();
+    if(!multirotor_cache_dir.size() || !_load_quantum_cache(cache_key.str())) {
+      //
+      _set_qfactor();
+
+      if(multirotor_cache_dir.size())
+	//
+	_save_quantum_cache(cache_key.str());
+    }
   }
   else {
     //
@@ -10151,9 +11178,7 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
 	  //
 	  itemp = (int)round(_vib_grid[g][v] / _ener_quant);
 
-	  for(int i = itemp; i < ener_grid.size(); ++i)
-	    //
-	    stat_freq[i] += stat_freq[i - itemp];
+	  Math::state_count(stat_freq, ener_grid.size(), itemp);
 	}
 	
 	// potential energy shift and mass factor
@@ -10293,9 +11318,7 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
       //
       itemp = (int)round(_vib_four[v][0] / _ener_quant);
 
-      for(int i = itemp; i < ener_grid.size(); ++i)
-	//
-	stat_grid[i] += stat_grid[i - itemp];
+      Math::state_count(stat_grid, ener_grid.size(), itemp);
     }
 
     // effective one-dimensional rotors quantum density/number of states interpolation
@@ -10334,9 +11357,7 @@ Model::MultiRotor::MultiRotor(IO::KeyBufferStream& from, const std::vector<Atom>
       //
       itemp = (int)round(_vib_four[v][0] / _ener_quant);
 
-      for(int i = itemp; i < ener_grid.size(); ++i)
-	//
-	stat_grid[i] += stat_grid[i - itemp];
+      Math::state_count(stat_grid, ener_grid.size(), itemp);
     }
 
     // one-dimensional rotors classical density/number of states interpolation
@@ -10651,7 +11672,7 @@ void Model::MultiRotor::_set_qfactor ()
 
   // mass factor
   try {
-  pruned_irf_grid[g] =  Lapack::Cholesky(mass(angle)).det_sqrt();
+  pruned_irf_grid[g] =  Lapack::det_sqrt(mass(angle));
   } 
   catch(Error::General) {
   std::cerr << funame 
@@ -10744,9 +11765,11 @@ void Model::MultiRotor::_set_qfactor ()
       //
       const std::vector<int> mv = quantum_index(ml);
 
-      for(int nl = ml; nl < quantum_index.size(); ++nl) {// right quantum state cycle
+      for(MultiIndexConvert::Iterator nit(quantum_index, ml); !nit.end(); ++nit) {// right quantum state cycle
 	//
-	const std::vector<int> nv = quantum_index(nl);
+	const int nl = nit.linear();
+
+	const std::vector<int>& nv = nit.index();
 
 	// potential contribution
 	//
@@ -10882,9 +11905,11 @@ void Model::MultiRotor::_set_qfactor ()
       //
       std::vector<int> mv = quantum_index(ml);
 
-      for(int nl = ml; nl < quantum_index.size(); ++nl) {// ket cycle
+      for(MultiIndexConvert::Iterator nit(quantum_index, ml); !nit.end(); ++nit) {// ket cycle
 	//
-	std::vector<int> nv = quantum_index(nl);
+	const int nl = nit.linear();
+
+	const std::vector<int>& nv = nit.index();
 
 	for(pit_t pit = _ctf_four.begin(); pit != _ctf_four.end(); ++pit) {// fourier expansion cycle
 	  //
@@ -10941,9 +11966,11 @@ void Model::MultiRotor::_set_qfactor ()
       //
       std::vector<int> mv = quantum_index(ml);
 
-      for(int nl = ml; nl < quantum_index.size(); ++nl) {// ket cycle
+      for(MultiIndexConvert::Iterator nit(quantum_index, ml); !nit.end(); ++nit) {// ket cycle
 	//
-	std::vector<int> nv = quantum_index(nl);
+	const int nl = nit.linear();
+
+	const std::vector<int>& nv = nit.index();
 
 	for(pit_t pit = eff_erf->begin(); pit != eff_erf->end(); ++pit) {// fourier expansion cycle
 	  //
@@ -11308,9 +12335,7 @@ void Model::MultiRotor::_set_qfactor ()
     //
     itemp = (int)round(_vib_four[v][0] / _ener_quant);
 
-    for(int i = itemp; i < qstat_grid.size(); ++i)
-      //
-      qstat_grid[i] += qstat_grid[i - itemp];
+    Math::state_count(qstat_grid, qstat_grid.size(), itemp);
   }
 
   /*************** CLASSICAL DENSITY/NUMBER OF STATES *******************/
@@ -11360,9 +12385,7 @@ void Model::MultiRotor::_set_qfactor ()
     //
     itemp = (int)round(_vib_four[v][0] / _ener_quant);
 
-    for(int i = itemp; i < stat_grid.size(); ++i)
-      //
-      stat_grid[i] += stat_grid[i - itemp];
+    Math::state_count(stat_grid, stat_grid.size(), itemp);
   }
 
   // energy grid
@@ -11399,6 +12422,181 @@ void Model::MultiRotor::_set_qfactor ()
   // quantum correction factor interpolation
   //
   _qfactor.init(ener_grid, qstat_grid, qstat_grid.size());
+
+  _qfactor_value.resize(qstat_grid.size());
+
+  for(int i = 0; i < qstat_grid.size(); ++i)
+    //
+    _qfactor_value[i] = qstat_grid[i];
+}
+
+/*************************************** QUANTUM STATES CACHE ***************************************/
+
+namespace {
+  //
+  std::string cache_file_name (const std::string& dir, const std::string& key, const char* ext)
+  {
+    return dir + "/" + IO::hash_name(key) + ext;
+  }
+
+  std::string multirotor_cache_file (const std::string& key)
+  {
+    return cache_file_name(Model::multirotor_cache_dir, key, ".rotor");
+  }
+
+  void cache_put (std::ostream& to, int i) { to.write((const char*)&i, sizeof(i)); }
+
+  void cache_put (std::ostream& to, double d) { to.write((const char*)&d, sizeof(d)); }
+
+  void cache_put (std::ostream& to, const std::vector<double>& v)
+  {
+    cache_put(to, (int)v.size());
+
+    if(v.size())
+      //
+      to.write((const char*)&v[0], v.size() * sizeof(double));
+  }
+
+  bool cache_get (std::istream& from, int& i) { return (bool)from.read((char*)&i, sizeof(i)); }
+
+  bool cache_get (std::istream& from, double& d) { return (bool)from.read((char*)&d, sizeof(d)); }
+
+  bool cache_get (std::istream& from, std::vector<double>& v)
+  {
+    int n;
+
+    if(!cache_get(from, n) || n < 0)
+      //
+      return false;
+
+    v.resize(n);
+
+    return !n || from.read((char*)&v[0], n * sizeof(double));
+  }
+}
+
+bool Model::MultiRotor::_load_quantum_cache (const std::string& key)
+{
+  const std::string name = multirotor_cache_file(key);
+
+  std::ifstream from(name.c_str(), std::ios::binary);
+
+  if(!from)
+    //
+    return false;
+
+  int itemp;
+
+  std::string stemp;
+
+  if(cache_get(from, itemp) && itemp == key.size()) {
+    //
+    stemp.resize(itemp);
+
+    from.read(&stemp[0], itemp);
+  }
+
+  if(!from || stemp != key) {
+    //
+    IO::log << IO::log_offset << "WARNING: quantum states cache " << name << " does not match the model, ignoring\n";
+
+    return false;
+  }
+
+  double ground;
+
+  std::vector<std::vector<double> > energy_level, mean_erf;
+
+  std::vector<double> qfactor_value;
+
+  bool btemp = cache_get(from, ground) && cache_get(from, itemp) && itemp >= 0;
+
+  if(btemp) {
+    //
+    energy_level.resize(itemp);
+
+    mean_erf.resize(itemp);
+
+    for(int i = 0; i < itemp && btemp; ++i)
+      //
+      btemp = cache_get(from, energy_level[i]) && cache_get(from, mean_erf[i]);
+  }
+
+  if(!btemp || !cache_get(from, qfactor_value)) {
+    //
+    IO::log << IO::log_offset << "WARNING: cannot read quantum states cache " << name << ", ignoring\n";
+
+    return false;
+  }
+
+  _ground       = ground;
+  _energy_level = energy_level;
+  _mean_erf     = mean_erf;
+
+  // no quantum correction for too large zero-point energy
+  //
+  if(qfactor_value.size()) {
+    //
+    Array<double> ener_grid((int)qfactor_value.size());
+
+    double ener = 0.;
+
+    for(int i = 0; i < ener_grid.size(); ++i, ener += _ener_quant)
+      //
+      ener_grid[i] = ener;
+
+    _qfactor.init(ener_grid, &qfactor_value[0], qfactor_value.size());
+
+    _qfactor_value = qfactor_value;
+  }
+
+  IO::log << IO::log_offset << "ground energy, energy levels, and quantum correction factor are read from " << name << "\n";
+
+  return true;
+}
+
+void Model::MultiRotor::_save_quantum_cache (const std::string& key) const
+{
+  if(IO::mpi_rank)
+    //
+    return;
+
+  const std::string name = multirotor_cache_file(key);
+
+  IO::AtomicFile to(name);
+
+  if(!to) {
+    //
+    IO::log << IO::log_offset << "WARNING: cannot open quantum states cache file " << to.tmp_name() << "\n";
+
+    return;
+  }
+
+  cache_put(to, (int)key.size());
+
+  to.write(key.data(), key.size());
+
+  cache_put(to, _ground);
+
+  cache_put(to, (int)_energy_level.size());
+
+  for(int i = 0; i < _energy_level.size(); ++i) {
+    //
+    cache_put(to, _energy_level[i]);
+
+    cache_put(to, i < _mean_erf.size() ? _mean_erf[i] : std::vector<double>());
+  }
+
+  cache_put(to, _qfactor_value);
+
+  if(!to.commit()) {
+    //
+    IO::log << IO::log_offset << "WARNING: cannot write quantum states cache file " << name << "\n";
+
+    return;
+  }
+
+  IO::log << IO::log_offset << "ground energy, energy levels, and quantum correction factor are saved to " << name << "\n";
 }
 
 void Model::MultiRotor::_set_states_base (Array<double>& base, int flag) const
@@ -11471,11 +12669,11 @@ void Model::MultiRotor::_set_states_base (Array<double>& base, int flag) const
   }
 }
 
-// generalized mass matrix
+// internal mobility matrix from its fourier expansion
 //
-Lapack::SymmetricMatrix Model::MultiRotor::mass (const std::vector<double>& angle) const
+Lapack::SymmetricMatrix Model::MultiRotor::mobility (const std::vector<double>& angle) const
 {
-  const char funame [] = "Model::MultiRotor::mass: ";
+  const char funame [] = "Model::MultiRotor::mobility: ";
 
   typedef std::map<int, Lapack::SymmetricMatrix>::const_iterator mit_t;
 
@@ -11524,7 +12722,14 @@ Lapack::SymmetricMatrix Model::MultiRotor::mass (const std::vector<double>& angl
     //
   }//fourier expansion size
 
-  res = res.invert();
+  return res;
+}
+
+// generalized mass matrix: the mobility matrix is positive definite
+//
+Lapack::SymmetricMatrix Model::MultiRotor::mass (const std::vector<double>& angle) const
+{
+  Lapack::SymmetricMatrix res = Lapack::Cholesky(mobility(angle)).invert();
 
   res /= 2.;
 
@@ -11947,6 +13152,13 @@ double Model::MultiRotor::quantum_weight (double temperature) const
 }
 
 int Model::MultiRotor::get_semiclassical_weight (double temperature, double& classical_weight, double& quantum_weight) const
+{
+  return get_semiclassical_weight(&temperature, 1, &classical_weight, &quantum_weight);
+}
+
+// one pass over the angular grid for all temperatures
+//
+int Model::MultiRotor::get_semiclassical_weight (const double* temperature, int size, double* classical_weight, double* quantum_weight) const
 {
   static const double eps = 1.e-5;
   
@@ -11956,71 +13168,85 @@ int Model::MultiRotor::get_semiclassical_weight (double temperature, double& cla
   double dtemp;
 
   int res = 0;
-  double cw = 0.;
-  double qw = 0.;
 
-#pragma omp parallel for default(shared) private(itemp, dtemp) reduction(+: cw, qw) schedule(static)
+  if(!size)
+    //
+    return res;
+
+  std::vector<double> cw_vec(size, 0.), qw_vec(size, 0.);
+
+  double* cw = &cw_vec[0];
+  double* qw = &qw_vec[0];
+
+#pragma omp parallel for default(shared) private(itemp, dtemp) reduction(+: cw[:size], qw[:size]) schedule(static)
 
   for(int g = 0; g < _grid_index.size(); ++g) {// grid cycle
     //
-    // quantum correction factor
-    //
-    double qfac = 1.;
-    
-    for(int r = 0; r < internal_size(); ++r) {
+    for(int t = 0; t < size; ++t) {// temperature cycle
       //
-      dtemp = _freq_grid[g][r] / temperature / 2.;
-
-      if(dtemp > eps) {
-	//
-	qfac *= dtemp / std::sinh(dtemp);
-      }
-      else if(dtemp < eps - M_PI) {
+      // quantum correction factor
+      //
+      double qfac = 1.;
+    
+      for(int r = 0; r < internal_size(); ++r) {
 	//
-	qfac = -1.;
+	dtemp = _freq_grid[g][r] / temperature[t] / 2.;
 
-	res = 1;
+	if(dtemp > eps) {
+	  //
+	  qfac *= dtemp / std::sinh(dtemp);
+	}
+	else if(dtemp < eps - M_PI) {
+	  //
+	  qfac = -1.;
 
-	break;
+	  res = 1;
+
+	  break;
+	}
+	else if(dtemp < -eps)
+	  //
+	  qfac *= dtemp / std::sin(dtemp);
       }
-      else if(dtemp < -eps)
-	//
-	qfac *= dtemp / std::sin(dtemp);
-    }
 
-    // classical partition  function (internal rotations & vibrations part)
-    //
-    dtemp = std::exp(-_pot_grid[g] / temperature) * _irf_grid[g];
-    
-    if(_with_ext_rot)
+      // classical partition  function (internal rotations & vibrations part)
       //
-      dtemp *= _erf_grid[g];
+      dtemp = std::exp(-_pot_grid[g] / temperature[t]) * _irf_grid[g];
+    
+      if(_with_ext_rot)
+	//
+	dtemp *= _erf_grid[g];
 
-    for(int v = 0; v < _vib_four.size(); ++v)
-      //
-      dtemp /= 1. - std::exp(-_vib_grid[g][v] / temperature);
+      for(int v = 0; v < _vib_four.size(); ++v)
+	//
+	dtemp /= 1. - std::exp(-_vib_grid[g][v] / temperature[t]);
    
-    cw += dtemp;
+      cw[t] += dtemp;
     
-    if(qfac > 0.)
+      if(qfac > 0.)
+	//
+	qw[t] += qfac * dtemp;
       //
-      qw += qfac * dtemp;
+    }// temperature cycle
     //
   }// grid cycle
     
   // normalization
   //
-  dtemp = std::pow(temperature / 2. / M_PI, double(internal_size()) / 2.)
+  for(int t = 0; t < size; ++t) {
     //
-    * _angle_grid_cell * std::exp(_ground / temperature);
+    dtemp = std::pow(temperature[t] / 2. / M_PI, double(internal_size()) / 2.)
+      //
+      * _angle_grid_cell * std::exp(_ground / temperature[t]);
 
-  if(_with_ext_rot)
-    //
-    dtemp *= pi_fac * temperature * std::sqrt(temperature) / external_symmetry();
+    if(_with_ext_rot)
+      //
+      dtemp *= pi_fac * temperature[t] * std::sqrt(temperature[t]) / external_symmetry();
 
-  classical_weight = dtemp * cw;
+    classical_weight[t] = dtemp * cw[t];
   
-  quantum_weight   = dtemp * qw;
+    quantum_weight[t]   = dtemp * qw[t];
+  }
 
   return res;
 }
@@ -12031,6 +13257,11 @@ void Model::MultiRotor::quantum_states (Array<double>& stat_grid, double ener_st
 {
   const char funame [] = "Model::MultiRotor::quantum_states: ";
 
+  // external rotation: the levels contribute to the grid points within the distance
+  // directly, the rest is the convolution of the external rotation density with the level
+  // histograms, each level linearly shared between the two neighboring grid points
+  static const int near_size = 512;
+
   if(!_energy_level.size()) {
     //
     std::cerr << funame << "not initialized\n";
@@ -12045,17 +13276,40 @@ void Model::MultiRotor::quantum_states (Array<double>& stat_grid, double ener_st
 
   const int pmax = flag ? 1 : _energy_level.size();
 
+  const int size = stat_grid.size();
+
   if(_with_ext_rot) {
     //
+    // far part dimension
+    //
+    const int far_size = size > near_size ? size - near_size : 0;
+
+    std::vector<double> low_hist(far_size, 0.), high_hist(far_size, 0.);
+
     for(int p = 0; p < pmax; ++p) {
       //
       for(int l = 0; l < _energy_level[p].size(); ++l)  {
 	//
-	itemp = (int)std::ceil(_energy_level[p][l] / ener_step);
+	const double level = _energy_level[p][l];
 
-	for(int i = itemp; i < stat_grid.size(); ++i) {
-	  //
-	  double rot_ener = (double)i * ener_step - _energy_level[p][l];
+	itemp = (int)std::ceil(level / ener_step);
+
+	int near_end = size;
+
+	if(itemp >= 0 && itemp < far_size) {
+	  //
+	  near_end = itemp + near_size;
+
+	  dtemp = (double)itemp - level / ener_step;
+
+	  low_hist[itemp]  += (1. - dtemp) * _mean_erf[p][l];
+
+	  high_hist[itemp] +=       dtemp  * _mean_erf[p][l];
+	}
+
+	for(int i = itemp > 0 ? itemp : 0; i < near_end; ++i) {
+	  //
+	  double rot_ener = (double)i * ener_step - level;
 
 	  if(rot_ener <= 0.)
 	    //
@@ -12072,6 +13326,34 @@ void Model::MultiRotor::quantum_states (Array<double>& stat_grid, double ener_st
       }
     }
 
+    if(far_size) {
+      //
+      // external rotation density at the distances near_size + j and near_size + 1 + j
+      //
+      std::vector<double> low_kern(far_size), high_kern(far_size);
+
+      for(int j = 0; j < far_size; ++j) {
+	//
+	double rot_ener = (double)(near_size + j) * ener_step;
+
+	low_kern[j] = mode() == NUMBER ? rot_ener * std::sqrt(rot_ener) : std::sqrt(rot_ener);
+
+	rot_ener += ener_step;
+
+	high_kern[j] = mode() == NUMBER ? rot_ener * std::sqrt(rot_ener) : std::sqrt(rot_ener);
+      }
+
+      std::vector<double> low_far(far_size), high_far(far_size);
+
+      Math::convolute(&low_kern[0],  far_size, &low_hist[0],  far_size, &low_far[0]);
+
+      Math::convolute(&high_kern[0], far_size, &high_hist[0], far_size, &high_far[0]);
+
+      for(int j = 0; j < far_size; ++j)
+	//
+	stat_grid[near_size + j] += low_far[j] + high_far[j];
+    }
+
     // normalization
     //
     dtemp = 4. * M_SQRT2 / external_symmetry();
@@ -12093,33 +13375,30 @@ void Model::MultiRotor::quantum_states (Array<double>& stat_grid, double ener_st
 	//
 	itemp = (int)std::ceil(_energy_level[p][l] / ener_step);
 
-	if(itemp >= stat_grid.size())
+	if(itemp >= size)
 	  //
 	  continue;
 	
-	switch(mode()) {
-	  //
-	case NUMBER:
-	  //
-	  for(int i = itemp; i < stat_grid.size(); ++i)
-	    //
-	    stat_grid[i] += 1.;
-
-	  break;
-
-	default:
-	  //
-	  stat_grid[itemp] += 1.;
-	}
+	stat_grid[itemp] += 1.;
       }
     }
 
     // normalization
     //
-    if(mode() != NUMBER)
+    switch(mode()) {
       //
-      stat_grid /= ener_step;
+    case NUMBER:
+      //
+      for(int i = 1; i < size; ++i)
+	//
+	stat_grid[i] += stat_grid[i - 1];
+
+      break;
 
+    default:
+      //
+      stat_grid /= ener_step;
+    }
   }// without external rotation
 
 }
@@ -12157,486 +13436,667 @@ double Model::MultiRotor::weight (double temperature) const
   return qw;
 }
 
-void Model::MultiRotor::rotational_energy_levels () const
+void Model::MultiRotor::weight (const double* temperature, int size, double* res) const
 {
-  const char funame [] = "Model::MultiRotor::rotational_energy_levels: ";
+  std::vector<double> cw(size);
 
-  if(_level_ener_max <= 0.) 
-    //
-    return;
+  if(size)
+    get_semiclassical_weight(temperature, size, &cw[0], res);
+}
 
-  IO::Marker funame_marker(funame);
+// quantum weight log and its temperature derivatives in one pass over the angular grid: the
+// log derivatives of each grid term are summed over the quantum correction, the potential, and
+// the vibrational factors, and the terms are averaged with their weights
+//
+void Model::MultiRotor::thermal_moments (const double* temperature, int size, double,
+					 double* lw, double* d1, double* d2) const
+{
+  const char funame [] = "Model::MultiRotor::thermal_moments: ";
+
+  static const double eps = 1.e-5;
+
+  static const double pi_fac = 2. * std::sqrt(2. * M_PI);
 
   double dtemp;
-  int    itemp;
-  bool   btemp;
 
-  const Lapack::complex imaginary_unit(0., 1.);
+  if(!size)
+    //
+    return;
 
-  std::vector<int>    ivec(internal_size());
-  std::vector<double> dvec(internal_size());
+  std::vector<double> w0_vec(size, 0.), w1_vec(size, 0.), w2_vec(size, 0.);
 
-  IO::log << IO::log_offset << "(external) rotational constants for original geometry [1/cm]:";
+  double* w0 = &w0_vec[0];
+  double* w1 = &w1_vec[0];
+  double* w2 = &w2_vec[0];
 
-  for(int i = 0; i < _rotational_constant.size(); ++i)
+#pragma omp parallel for default(shared) private(dtemp) reduction(+: w0[:size], w1[:size], w2[:size]) schedule(static)
+
+  for(int g = 0; g < _grid_index.size(); ++g) {// grid cycle
     //
-    IO::log << "   " << _rotational_constant[i] / Phys_const::incm;
+    for(int t = 0; t < size; ++t) {// temperature cycle
+      //
+      const double tval = temperature[t];
 
-  IO::log << "\n";
+      // first and second temperature derivatives of the term log
+      double l1 = 0., l2 = 0.;
 
-  itemp = (int)std::sqrt(_level_ener_max / _rotational_constant.back());
+      // quantum correction factor: x / sinh(x) or x / sin(x), x = freq / 2 / T
+      double qfac = 1.;
+    
+      for(int r = 0; r < internal_size(); ++r) {
+	//
+	const double x = _freq_grid[g][r] / tval / 2.;
 
-  IO::log << IO::log_offset << "estimated maximum angular momentum needed  = " << itemp << "\n";
+	double f1, f2;// first and second derivatives of the factor log over x
 
-  int amom_max = itemp < _amom_max ? itemp : _amom_max;
+	if(x > eps) {
+	  //
+	  qfac *= x / std::sinh(x);
 
-  std::vector<Lapack::Vector> eigenvalue(amom_max);
+	  f1 = 1. / x - 1. / std::tanh(x);
+	  f2 = 1. / std::sinh(x) / std::sinh(x) - 1. / x / x;
+	}
+	else if(x < eps - M_PI) {
+	  //
+	  qfac = -1.;
 
-  // angular momentum cycle
-  //
-  for(int amom = 0; amom < amom_max; ++amom) {
-    //
-    IO::Marker work_marker("fixed angular momentum calculation");
+	  break;
+	}
+	else if(x < -eps) {
+	  //
+	  qfac *= x / std::sin(x);
 
-    const int multiplicity = 2 * amom + 1;
+	  f1 = 1. / x - 1. / std::tan(x);
+	  f2 = 1. / std::sin(x) / std::sin(x) - 1. / x / x;
+	}
+	else
+	  continue;
 
-    IO::log << IO::log_offset << "J = " << amom << "\n";
+	// dx/dT = -x/T, d^2x/dT^2 = 2x/T^2
+	l1 -= f1 * x / tval;
+	l2 += (f2 * x + 2. * f1) * x / tval / tval;
+      }
 
-    // internal rotation quantum  state dimensions
-    //
-    const double ener_max = _level_ener_max - double(amom * amom + amom) * _rotational_constant.back();
-    
-    for(int r = 0; r < internal_size(); ++r) {
-      //
-      itemp = int(std::sqrt(ener_max / _mobility_parameter[r])) / symmetry(r) * 2 + 1; 
+      if(qfac <= 0.)
+	continue;
+
+      // potential and classical rotational factors
+      dtemp = qfac * std::exp(-_pot_grid[g] / tval) * _irf_grid[g];
 
-      IO::log << IO::log_offset << r 
-	      << "-th internal rotation: suggested optimal internal state dimension = " 
-	      <<  itemp << "\n"; 
+      l1 += _pot_grid[g] / tval / tval;
+      l2 -= 2. * _pot_grid[g] / tval / tval / tval;
 
-      if(_internal_rotation[r].quantum_size_max() && itemp > _internal_rotation[r].quantum_size_max()) {
+      if(_with_ext_rot)
 	//
-	ivec[r] = _internal_rotation[r].quantum_size_max();
-      }
-      else if(itemp < _internal_rotation[r].quantum_size_min()) {
+	dtemp *= _erf_grid[g];
+
+      // vibrational factors
+      for(int v = 0; v < _vib_four.size(); ++v) {
 	//
-	ivec[r] = _internal_rotation[r].quantum_size_min();
+	const double freq = _vib_grid[g][v];
+	const double y    = std::exp(-freq / tval);
+
+	dtemp /= 1. - y;
+
+	const double z = y / (1. - y);
+
+	l1 += freq * z / tval / tval;
+	l2 += freq * z * (freq / (1. - y) / tval - 2.) / tval / tval / tval;
       }
-      else
-	//
-	ivec[r] = itemp;
+
+      w0[t] += dtemp;
+      w1[t] += dtemp * l1;
+      w2[t] += dtemp * (l2 + l1 * l1);
+      //
+    }// temperature cycle
+    //
+  }// grid cycle
+
+  // normalization: T^(n/2) exp(ground / T), times T^(3/2) with the external rotation
+  //
+  const double a = double(internal_size()) / 2. + (_with_ext_rot ? 1.5 : 0.);
+
+  for(int t = 0; t < size; ++t) {
+    //
+    const double tval = temperature[t];
+
+    if(w0[t] <= 0.) {
+      std::cerr << funame << "nonpositive weight: " << w0[t] << "\n";
+      throw Error::Range();
     }
 
-    IO::log << IO::log_offset << "internal phase space dimensions:";
+    dtemp = std::pow(tval / 2. / M_PI, double(internal_size()) / 2.) * _angle_grid_cell;
 
-    for(int r = 0; r < internal_size(); ++r)
+    if(_with_ext_rot)
       //
-      IO::log << "  " << ivec[r];
+      dtemp *= pi_fac * tval * std::sqrt(tval) / external_symmetry();
 
-    IO::log << "\n";
+    lw[t] = std::log(dtemp * w0[t]) + _ground / tval;
+    d1[t] = w1[t] / w0[t] + a / tval - _ground / tval / tval;
+    d2[t] = w2[t] / w0[t] - w1[t] * w1[t] / w0[t] / w0[t] - a / tval / tval + 2. * _ground / tval / tval / tval;
+  }
+}
+
+// fixed angular momentum hamiltonian eigenvalues; the log is written into the given stream,
+// since the angular momentum blocks are calculated in parallel
+//
+Lapack::Vector Model::MultiRotor::_fixed_amom_levels (int amom, std::ostream& log) const
+{
+  const char funame [] = "Model::MultiRotor::_fixed_amom_levels: ";
+
+  double dtemp;
+  int    itemp;
+  bool   btemp;
+
+  const Lapack::complex imaginary_unit(0., 1.);
 
-    MultiIndexConvert internal_state_index(ivec);
+  std::vector<int> ivec(internal_size());
 
-    itemp = multiplicity * internal_state_index.size();
+  const int multiplicity = 2 * amom + 1;
 
-    IO::log << IO::log_offset << "internal   size  = " << internal_state_index.size() << "\n"
-	    << IO::log_offset << "multiplicity     = " << multiplicity                << "\n"
-	    << IO::log_offset << "hamiltonian size = " << itemp                       << std::endl;
+  log << IO::log_offset << "J = " << amom << "\n";
 
-    Lapack::HermitianMatrix ham(itemp);
+  // internal rotation quantum  state dimensions
+  //
+  const double ener_max = _level_ener_max - double(amom * amom + amom) * _rotational_constant.back();
 
-    // setting hamiltonian
+  for(int r = 0; r < internal_size(); ++r) {
     //
-    if(1) {
+    itemp = int(std::sqrt(ener_max / _mobility_parameter[r])) / symmetry(r) * 2 + 1; 
+
+    log << IO::log_offset << r 
+	<< "-th internal rotation: suggested optimal internal state dimension = " 
+	<<  itemp << "\n"; 
+
+    if(_internal_rotation[r].quantum_size_max() && itemp > _internal_rotation[r].quantum_size_max()) {
+      //
+      ivec[r] = _internal_rotation[r].quantum_size_max();
+    }
+    else if(itemp < _internal_rotation[r].quantum_size_min()) {
       //
-      IO::Marker work_marker("setting hamiltonian", IO::Marker::ONE_LINE);
+      ivec[r] = _internal_rotation[r].quantum_size_min();
+    }
+    else
+      //
+      ivec[r] = itemp;
+  }
+
+  log << IO::log_offset << "internal phase space dimensions:";
 
-      ham = 0.;
+  for(int r = 0; r < internal_size(); ++r)
+    //
+    log << "  " << ivec[r];
+
+  log << "\n";
+
+  MultiIndexConvert internal_state_index(ivec);
+
+  itemp = multiplicity * internal_state_index.size();
+
+  log << IO::log_offset << "internal   size  = " << internal_state_index.size() << "\n"
+      << IO::log_offset << "multiplicity     = " << multiplicity                << "\n"
+      << IO::log_offset << "hamiltonian size = " << itemp                       << std::endl;
+
+  Lapack::HermitianMatrix ham(itemp);
+
+  // setting hamiltonian
+  //
+  if(1) {
+    ham = 0.;
 
 #pragma omp parallel for default(shared) private(itemp, dtemp, btemp) schedule(dynamic, 1)
 
-      for(int ml = 0; ml < internal_state_index.size(); ++ml) {
+    for(int ml = 0; ml < internal_state_index.size(); ++ml) {
+      //
+      const std::vector<int> mv = internal_state_index(ml);
+
+      std::vector<int> ivec(internal_size());
+
+      for(int i = 0; i < internal_size(); ++i)
 	//
-	const std::vector<int> mv = internal_state_index(ml);
+	ivec[i] = (mv[i] - internal_state_index.size(i) / 2) * symmetry(i);
+
+      const std::vector<int> mw = ivec;
+
+      for(int nl = 0; nl < internal_state_index.size(); ++nl) {
 
-	std::vector<int> ivec(internal_size());
+	const std::vector<int> nv = internal_state_index(nl);
 
 	for(int i = 0; i < internal_size(); ++i)
 	  //
-	  ivec[i] = (mv[i] - internal_state_index.size(i) / 2) * symmetry(i);
+	  ivec[i] = (nv[i] - internal_state_index.size(i) / 2) * symmetry(i);
 
-	const std::vector<int> mw = ivec;
+	const std::vector<int> nw = ivec;
 
-	for(int nl = 0; nl < internal_state_index.size(); ++nl) {
+	btemp = false;
 
-	  const std::vector<int> nv = internal_state_index(nl);
+	int ifac = 1;
 
-	  for(int i = 0; i < internal_size(); ++i)
+	for(int i = 0; i < internal_size(); ++i) {
+	  //
+	  itemp = nv[i] - mv[i];
+
+	  if(itemp > _mass_index.size(i) / 2 || -itemp > _mass_index.size(i) / 2) {
 	    //
-	    ivec[i] = (nv[i] - internal_state_index.size(i) / 2) * symmetry(i);
+	    btemp = true;
 
-	  const std::vector<int> nw = ivec;
+	    break;
+	  }
 
-	  btemp = false;
+	  if(itemp < 0)
+	    //
+	    itemp += _mass_index.size(i);
 
-	  int ifac = 1;
+	  ivec[i] = itemp;
 
-	  for(int i = 0; i < internal_size(); ++i) {
+	  if(_mass_index.size(i) == 2 * itemp)
 	    //
-	    itemp = nv[i] - mv[i];
-
-	    if(itemp > _mass_index.size(i) / 2 || -itemp > _mass_index.size(i) / 2) {
-	      //
-	      btemp = true;
+	    ifac *= 2;
+	}
 
-	      break;
-	    }
+	if(btemp)
+	  //
+	  continue;
 
-	    if(itemp < 0)
-	      //
-	      itemp += _mass_index.size(i);
+	itemp = _mass_index(ivec);	  
 
-	    ivec[i] = itemp;
+	std::map<int, Lapack::ComplexMatrix>::const_iterator imp = _internal_mobility_fourier.find(itemp);
+	std::map<int, Lapack::ComplexMatrix>::const_iterator emp = _external_mobility_fourier.find(itemp);
+	std::map<int, Lapack::ComplexMatrix>::const_iterator ccp = _coriolis_coupling_fourier.find(itemp);
 
-	    if(_mass_index.size(i) == 2 * itemp)
-	      //
-	      ifac *= 2;
-	  }
+	for(int mx = 0; mx < multiplicity; ++mx) {
+	  //
+	  itemp = mx + 3;
 
-	  if(btemp)
-	    //
-	    continue;
+	  const int nx_max = itemp < multiplicity ? itemp : multiplicity;
 
-	  itemp = _mass_index(ivec);	  
+	  const int mproj = mx - amom;
 
-	  std::map<int, Lapack::ComplexMatrix>::const_iterator imp = _internal_mobility_fourier.find(itemp);
-	  std::map<int, Lapack::ComplexMatrix>::const_iterator emp = _external_mobility_fourier.find(itemp);
-	  std::map<int, Lapack::ComplexMatrix>::const_iterator ccp = _coriolis_coupling_fourier.find(itemp);
-	  
-	  for(int mx = 0; mx < multiplicity; ++mx) {
+	  for(int nx = mx; nx < nx_max; ++nx) {
 	    //
-	    itemp = mx + 3;
+	    const int mtot = ml + mx * internal_state_index.size();
 
-	    const int nx_max = itemp < multiplicity ? itemp : multiplicity;
+	    const int ntot = nl + nx * internal_state_index.size();
 
-	    const int mproj = mx - amom;
-
-	    for(int nx = mx; nx < nx_max; ++nx) {
+	    if(ntot < mtot)
 	      //
-	      const int mtot = ml + mx * internal_state_index.size();
-
-	      const int ntot = nl + nx * internal_state_index.size();
-	
-	      if(ntot < mtot)
-		//
-		continue;
+	      continue;
 
-	      Lapack::complex matel = 0.;// matrix element
+	    Lapack::complex matel = 0.;// matrix element
 
-	      // internal mobility
+	    // internal mobility
+	    //
+	    if(imp != _internal_mobility_fourier.end() && nx == mx) {
 	      //
-	      if(imp != _internal_mobility_fourier.end() && nx == mx) {
-		//
-		// p_i * p_j term
+	      // p_i * p_j term
+	      //
+	      for(int i = 0; i < internal_size(); ++i)
 		//
-		for(int i = 0; i < internal_size(); ++i)
+		for(int j = 0; j < internal_size(); ++j)
 		  //
-		  for(int j = 0; j < internal_size(); ++j)
-		    //
-		    matel += double(mw[i] * nw[j]) * imp->second(i, j);
-	      }
+		  matel += double(mw[i] * nw[j]) * imp->second(i, j);
+	    }
 
-	      if(!amom) {
-		//
-		ham(mtot, ntot) = matel / (double)ifac;
+	    if(!amom) {
+	      //
+	      ham(mtot, ntot) = matel / (double)ifac;
 
-		continue;
-	      }
+	      continue;
+	    }
 
-	      // external mobility
+	    // external mobility
+	    //
+	    if(emp != _external_mobility_fourier.end()) {
 	      //
-	      if(emp != _external_mobility_fourier.end()) {
+	      switch(nx - mx) {
 		//
-		switch(nx - mx) {
-		  //
-		case 0:
-		  //
-		  dtemp = double(amom * amom + amom - mproj * mproj) / 2.;
-		  
-		  // M_z * M_z term
+	      case 0:
+		//
+		dtemp = double(amom * amom + amom - mproj * mproj) / 2.;
+
+		// M_z * M_z term
+		//
+		matel += double(mproj * mproj)
 		  //
-		  matel += double(mproj * mproj)
-		    //
-		    * emp->second(2, 2);
+		  * emp->second(2, 2);
 
-		  // M_x * M_x term
+		// M_x * M_x term
+		//
+		matel += dtemp 
 		  //
-		  matel += dtemp 
-		    //
-		    * emp->second(0, 0);
+		  * emp->second(0, 0);
 
-		  // M_y * M_y term
+		// M_y * M_y term
+		//
+		matel += dtemp 
 		  //
-		  matel += dtemp 
-		    //
-		    * emp->second(1, 1);
+		  * emp->second(1, 1);
 
-		  break;
+		break;
 
-		case 1:
-		  //
-		  dtemp = std::sqrt(double((amom + mproj + 1) * (amom - mproj))) / 2.;
+	      case 1:
+		//
+		dtemp = std::sqrt(double((amom + mproj + 1) * (amom - mproj))) / 2.;
 
-		  // M_x * M_z term
+		// M_x * M_z term
+		//
+		matel += dtemp * double(2 * mproj + 1) 
 		  //
-		  matel += dtemp * double(2 * mproj + 1) 
-		    //
-		    * emp->second(0, 2);
+		  * emp->second(0, 2);
 
-		  // M_y * M_z term
+		// M_y * M_z term
+		//
+		matel += imaginary_unit * dtemp * double(2 * mproj + 1)
 		  //
-		  matel += imaginary_unit * dtemp * double(2 * mproj + 1)
-		    //
-		    * emp->second(1, 2);
+		  * emp->second(1, 2);
 
-		  break;
+		break;
 
-		case 2:
-		  //
-		  dtemp = std::sqrt(double((amom + mproj + 1) * (amom - mproj) * (amom + mproj + 2) *
-					   //
-					   (amom - mproj - 1))) / 4.;
+	      case 2:
+		//
+		dtemp = std::sqrt(double((amom + mproj + 1) * (amom - mproj) * (amom + mproj + 2) *
+					 //
+					 (amom - mproj - 1))) / 4.;
 
-		  // M_x * M_x term
+		// M_x * M_x term
+		//
+		matel += dtemp 
 		  //
-		  matel += dtemp 
-		    //
-		    * emp->second(0, 0);
+		  * emp->second(0, 0);
 
-		  // M_y * M_y term
+		// M_y * M_y term
+		//
+		matel -= dtemp 
 		  //
-		  matel -= dtemp 
-		    //
-		    * emp->second(1,1);
+		  * emp->second(1,1);
 
-		  // M_x * M_y term
+		// M_x * M_y term
+		//
+		matel += imaginary_unit * 2. * dtemp 
 		  //
-		  matel += imaginary_unit * 2. * dtemp 
-		    //
-		    * emp->second(0, 1);
+		  * emp->second(0, 1);
 
-		  break;
-		    
-		}// external mobility
-		//
-	      }//
+		break;
 
-	      // coriolis coupling
+	      }// external mobility
 	      //
-	      if(ccp != _coriolis_coupling_fourier.end()) {
+	    }//
+
+	    // coriolis coupling
+	    //
+	    if(ccp != _coriolis_coupling_fourier.end()) {
+	      //
+	      for(int i = 0; i < internal_size(); ++i) {
 		//
-		for(int i = 0; i < internal_size(); ++i) {
+		switch(nx - mx) {
 		  //
-		  switch(nx - mx) {
-		    //
-		  case 0:
-		    //
-		    // M_z * p_i term
+		case 0:
+		  //
+		  // M_z * p_i term
+		  //
+		  matel -= double(mproj * (mw[i] + nw[i])) 
 		    //
-		    matel -= double(mproj * (mw[i] + nw[i])) 
-		      //
-		      * ccp->second(2, i);
-		    
-		    break;
+		    * ccp->second(2, i);
 
-		  case 1:
-		    //
-		    dtemp = std::sqrt(double((amom + mproj + 1) * (amom - mproj))) / 2.;
+		  break;
 
-		    // M_x * p_i term
-		    //
-		    matel -= dtemp * double(mw[i] + nw[i])
-		      //
-		      * ccp->second(0, i);
-		  
-		    // M_y * p_i term
+		case 1:
+		  //
+		  dtemp = std::sqrt(double((amom + mproj + 1) * (amom - mproj))) / 2.;
+
+		  // M_x * p_i term
+		  //
+		  matel -= dtemp * double(mw[i] + nw[i])
 		    //
-		    matel -= imaginary_unit * dtemp * double(mw[i] + nw[i])
-		      //
-		      * ccp->second(1, i);
+		    * ccp->second(0, i);
 
-		    break;
+		  // M_y * p_i term
+		  //
+		  matel -= imaginary_unit * dtemp * double(mw[i] + nw[i])
 		    //
-		  }// coriolis coupling
-		}
+		    * ccp->second(1, i);
+
+		  break;
+		  //
+		}// coriolis coupling
 	      }
+	    }
 
-	      ham(mtot, ntot) = matel / (double)ifac;
-	      //
-	    }// nx cycle
+	    ham(mtot, ntot) = matel / (double)ifac;
 	    //
-	  }// mx cycle
+	  }// nx cycle
 	  //
-	}// nl cycle
+	}// mx cycle
 	//
-      }// ml cycle
+      }// nl cycle
+      //
+    }// ml cycle
 
-      // potential contribution
+    // potential contribution
 
 #pragma omp parallel for default(shared) private(itemp, dtemp, btemp) schedule(dynamic, 1)
 
-      for(int ml = 0; ml < internal_state_index.size(); ++ml) {
-	//
-	const std::vector<int> mv = internal_state_index(ml);
+    for(int ml = 0; ml < internal_state_index.size(); ++ml) {
+      //
+      const std::vector<int> mv = internal_state_index(ml);
 
-	std::vector<int> ivec(internal_size());
+      std::vector<int> ivec(internal_size());
+      //
+      for(int nl = ml; nl < internal_state_index.size(); ++nl) {
 	//
-	for(int nl = ml; nl < internal_state_index.size(); ++nl) {
-	  //
-	  const std::vector<int> nv = internal_state_index(nl);
+	const std::vector<int> nv = internal_state_index(nl);
 
-	  int ifac = 1;
+	int ifac = 1;
 
-	  btemp = false;
+	btemp = false;
+	//
+	for(int i = 0; i < internal_size(); ++i) {
 	  //
-	  for(int i = 0; i < internal_size(); ++i) {
+	  itemp = nv[i] - mv[i];
+
+	  if(itemp > _pot_index.size(i) / 2 || -itemp > _pot_index.size(i) / 2) {
 	    //
-	    itemp = nv[i] - mv[i];
+	    btemp = true;
 
-	    if(itemp > _pot_index.size(i) / 2 || -itemp > _pot_index.size(i) / 2) {
-	      //
-	      btemp = true;
+	    break;
+	  }
+	  if(itemp < 0)
+	    //
+	    itemp += _pot_index.size(i);
 
-	      break;
-	    }
-	    if(itemp < 0)
-	      //
-	      itemp += _pot_index.size(i);
+	  if(_pot_index.size(i) == 2 * itemp)
+	    //
+	    ifac *= 2;
 
-	    if(_pot_index.size(i) == 2 * itemp)
-	      //
-	      ifac *= 2;
+	  ivec[i] = itemp;
+	}
 
-	    ivec[i] = itemp;
-	  }
+	if(btemp)
+	  continue;
 
-	  if(btemp)
-	    continue;
-	    
-	  itemp = _pot_index(ivec);
+	itemp = _pot_index(ivec);
 
-	  std::map<int, Lapack::complex>::const_iterator pp = _pot_complex_fourier.find(itemp);
+	std::map<int, Lapack::complex>::const_iterator pp = _pot_complex_fourier.find(itemp);
 
-	  if(pp != _pot_complex_fourier.end()) {
+	if(pp != _pot_complex_fourier.end()) {
+	  //
+	  for(int mx = 0; mx < multiplicity; ++mx) {
 	    //
-	    for(int mx = 0; mx < multiplicity; ++mx) {
-	      //
-	      const int mtot = ml + mx * internal_state_index.size();
+	    const int mtot = ml + mx * internal_state_index.size();
 
-	      const int ntot = nl + mx * internal_state_index.size();
+	    const int ntot = nl + mx * internal_state_index.size();
 
-	      ham(mtot, ntot) += pp->second / (double)ifac;
-	      //
-	    }// mx cycle
+	    ham(mtot, ntot) += pp->second / (double)ifac;
 	    //
-	  }//
+	  }// mx cycle
 	  //
-	}//nl cycle
+	}//
 	//
-      }//ml cycle
+      }//nl cycle
       //
-    }//
+    }//ml cycle
+    //
+  }//
 
-    Lapack::HermitianMatrix ctf_mat;
+  Lapack::HermitianMatrix ctf_mat;
 
-    if(_with_ctf) {// basis scalar product matrix
-      //
-      IO::Marker work_marker("setting orthogonality matrix for basis states", IO::Marker::ONE_LINE);
+  if(_with_ctf) {// basis scalar product matrix
+    //
 
-      ctf_mat.resize(multiplicity * internal_state_index.size());
+    ctf_mat.resize(multiplicity * internal_state_index.size());
 
-      ctf_mat = 0.;
+    ctf_mat = 0.;
 
-      // potential contribution
+    // potential contribution
 
 #pragma omp parallel for default(shared) private(itemp, dtemp, btemp) schedule(dynamic, 1)
 
-      for(int ml = 0; ml < internal_state_index.size(); ++ml) {
-	//
-	const std::vector<int> mv = internal_state_index(ml);
+    for(int ml = 0; ml < internal_state_index.size(); ++ml) {
+      //
+      const std::vector<int> mv = internal_state_index(ml);
 
-	std::vector<int> ivec(internal_size());
+      std::vector<int> ivec(internal_size());
+      //
+      for(int nl = ml; nl < internal_state_index.size(); ++nl) {
 	//
-	for(int nl = ml; nl < internal_state_index.size(); ++nl) {
-	  //
-	  const std::vector<int> nv = internal_state_index(nl);
+	const std::vector<int> nv = internal_state_index(nl);
 
-	  int ifac = 1;
+	int ifac = 1;
 
-	  btemp = false;
+	btemp = false;
+	//
+	for(int i = 0; i < internal_size(); ++i) {
 	  //
-	  for(int i = 0; i < internal_size(); ++i) {
+	  itemp = nv[i] - mv[i];
+
+	  if(itemp > _mass_index.size(i) / 2 || -itemp > _mass_index.size(i) / 2) {
 	    //
-	    itemp = nv[i] - mv[i];
+	    btemp = true;
 
-	    if(itemp > _mass_index.size(i) / 2 || -itemp > _mass_index.size(i) / 2) {
-	      //
-	      btemp = true;
+	    break;
+	  }
+	  if(itemp < 0)
+	    //
+	    itemp += _mass_index.size(i);
 
-	      break;
-	    }
-	    if(itemp < 0)
-	      //
-	      itemp += _mass_index.size(i);
+	  if(_mass_index.size(i) == 2 * itemp)
+	    //
+	    ifac *= 2;
 
-	    if(_mass_index.size(i) == 2 * itemp)
-	      //
-	      ifac *= 2;
+	  ivec[i] = itemp;
+	}
 
-	    ivec[i] = itemp;
-	  }
+	if(btemp)
+	  continue;
 
-	  if(btemp)
-	    continue;
-	    
-	  itemp = _mass_index(ivec);
+	itemp = _mass_index(ivec);
 
-	  std::map<int, Lapack::complex>::const_iterator pp = _ctf_complex_fourier.find(itemp);
+	std::map<int, Lapack::complex>::const_iterator pp = _ctf_complex_fourier.find(itemp);
 
-	  if(pp != _ctf_complex_fourier.end()) {
+	if(pp != _ctf_complex_fourier.end()) {
+	  //
+	  for(int mx = 0; mx < multiplicity; ++mx) {
 	    //
-	    for(int mx = 0; mx < multiplicity; ++mx) {
-	      //
-	      const int mtot = ml + mx * internal_state_index.size();
+	    const int mtot = ml + mx * internal_state_index.size();
 
-	      const int ntot = nl + mx * internal_state_index.size();
+	    const int ntot = nl + mx * internal_state_index.size();
 
-	      ctf_mat(mtot, ntot) += pp->second / (double)ifac;
-	      //
-	    }// mx cycle
+	    ctf_mat(mtot, ntot) += pp->second / (double)ifac;
 	    //
-	  }//
+	  }// mx cycle
 	  //
-	}// nl cycle
+	}//
 	//
-      }// ml cycle
+      }// nl cycle
       //
-    }// basis scalar product matrix
+    }// ml cycle
+    //
+  }// basis scalar product matrix
 
-    if(_with_ctf) {
+  if(_with_ctf) {
+    return Lapack::diagonalize(ham, ctf_mat);
+  }
+  else {
+    return ham.eigenvalues();
+  }//
+  //
+}
+
+void Model::MultiRotor::rotational_energy_levels () const
+{
+  const char funame [] = "Model::MultiRotor::rotational_energy_levels: ";
+
+  if(_level_ener_max <= 0.) 
+    //
+    return;
+
+  IO::Marker funame_marker(funame);
+
+  double dtemp;
+  int    itemp;
+  bool   btemp;
+
+  const Lapack::complex imaginary_unit(0., 1.);
+
+  std::vector<int>    ivec(internal_size());
+  std::vector<double> dvec(internal_size());
+
+  IO::log << IO::log_offset << "(external) rotational constants for original geometry [1/cm]:";
+
+  for(int i = 0; i < _rotational_constant.size(); ++i)
+    //
+    IO::log << "   " << _rotational_constant[i] / Phys_const::incm;
+
+  IO::log << "\n";
+
+  itemp = (int)std::sqrt(_level_ener_max / _rotational_constant.back());
+
+  IO::log << IO::log_offset << "estimated maximum angular momentum needed  = " << itemp << "\n";
+
+  int amom_max = itemp < _amom_max ? itemp : _amom_max;
+
+  std::vector<Lapack::Vector> eigenvalue(amom_max);
+
+  // angular momentum cycle: the blocks are independent and are calculated in parallel, largest first
+  //
+  std::vector<std::string> amom_log(amom_max);
+
+  std::exception_ptr amom_error;
+
+#pragma omp parallel for default(shared) schedule(dynamic, 1) if(amom_max > 1)
+
+  for(int j = 0; j < amom_max; ++j) {
+    //
+    const int amom = amom_max - 1 - j;
+
+    std::ostringstream log;
+
+    try {
       //
-      IO::Marker work_marker("diagonalizing hamiltonian and ctf matrix simultaneously", IO::Marker::ONE_LINE);
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
-      eigenvalue[amom] = Lapack::diagonalize(ham, ctf_mat);
+      eigenvalue[amom] = _fixed_amom_levels(amom, log);
+
+      log << IO::log_offset << "J = " << amom << " done, elapsed time[sec] = "
+	  << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "\n";
     }
-    else {
+    catch(...) {
       //
-      IO::Marker work_marker("diagonalizing hamiltonian", IO::Marker::ONE_LINE);
+#pragma omp critical(amom_error)
 
-      eigenvalue[amom] = ham.eigenvalues();
-    }//
+      amom_error = std::current_exception();
+    }
+
+    amom_log[amom] = log.str();
+  }
+
+  for(int amom = 0; amom < amom_max; ++amom)
+    //
+    IO::log << amom_log[amom];
+
+  if(amom_error)
     //
-  }//amom cycle
+    std::rethrow_exception(amom_error);
 
   // rotational energy levels
   //
@@ -12973,6 +14433,170 @@ Model::Species::~Species ()
   //std::cout << "Model::Species destroyed\n";
 }
 
+void Model::Species::states (const double* ener, int size, double* res) const
+{
+  for(int i = 0; i < size; ++i)
+    res[i] = states(ener[i]);
+}
+
+void Model::Species::weight (const double* temperature, int size, double* res) const
+{
+  for(int t = 0; t < size; ++t)
+    res[t] = weight(temperature[t]);
+}
+
+void Model::Species::thermal_moments (const double* temperature, int size, double rel_incr,
+				      double* lw, double* d1, double* d2) const
+{
+  const char funame [] = "Model::Species::thermal_moments: ";
+
+  if(!size)
+    return;
+
+  const std::vector<double> tt = difference_grid(temperature, size, rel_incr);
+
+  std::vector<double> ww(tt.size());
+
+  weight(&tt[0], tt.size(), &ww[0]);
+
+  difference_moments(funame, temperature, size, rel_incr, &ww[0], lw, d1, d2);
+}
+
+std::vector<double> Model::Species::weight (const std::vector<double>& temperature) const
+{
+  std::vector<double> res(temperature.size());
+
+  if(temperature.size())
+    weight(&temperature[0], temperature.size(), &res[0]);
+
+#pragma omp critical(species_weight_cache)
+  for(int t = 0; t < temperature.size(); ++t)
+    _weight_cache[temperature[t]] = std::make_pair(ground(), res[t]);
+
+  return res;
+}
+
+namespace {
+  //
+  // memoized species function of the temperature
+  //
+  typedef double (Model::Species::*species_value_t) (double) const;
+
+  double cached_value (std::map<double, std::pair<double, double> >& cache, const Model::Species& species,
+		       species_value_t value, double temperature)
+  {
+    const double ground = species.ground();
+
+    // maximal number of the cached temperatures
+    static const int cache_max = 1024;
+
+    bool isfound = false;
+    double res;
+
+#pragma omp critical(species_weight_cache)
+    {
+      std::map<double, std::pair<double, double> >::const_iterator cit = cache.find(temperature);
+
+      if(cit != cache.end() && cit->second.first == ground) {
+	isfound = true;
+	res = cit->second.second;
+      }
+    }
+
+    if(isfound)
+      return res;
+
+    res = (species.*value)(temperature);
+
+#pragma omp critical(species_weight_cache)
+    {
+      if(cache.size() >= cache_max)
+	cache.clear();
+
+      cache[temperature] = std::make_pair(ground, res);
+    }
+
+    return res;
+  }
+}
+
+double Model::Species::cached_weight (double temperature) const
+{
+  return cached_value(_weight_cache, *this, &Model::Species::weight, temperature);
+}
+
+double Model::Species::cached_tunnel_weight (double temperature) const
+{
+  return cached_value(_tunnel_cache, *this, &Model::Species::tunnel_weight, temperature);
+}
+
+const std::vector<double>& Model::Species::states_table (double energy_reference, double energy_step, int size) const
+{
+  // maximal number of the cached grids
+  static const int cache_max = 16;
+
+  std::pair<double, double> key(energy_reference, energy_step);
+
+  std::map<std::pair<double, double>, _StatesTable>::iterator cit = _states_cache.find(key);
+
+  if(cit != _states_cache.end() && cit->second.ground == ground() && cit->second.value.size() >= size)
+    //
+    return cit->second.value;
+
+  if(cit == _states_cache.end() && _states_cache.size() >= cache_max)
+    //
+    _states_cache.clear();
+
+  _StatesTable& table = _states_cache[key];
+
+  table.ground = ground();
+  table.value.resize(size);
+
+  // the states are evaluated pointwise, so the grid points which coincide with the points
+  // of the other cached grids (e.g., the coarse grid is the decimation of the fine one)
+  // are copied
+  std::vector<char> isset(size, 0);
+  for(std::map<std::pair<double, double>, _StatesTable>::const_iterator it = _states_cache.begin(); it != _states_cache.end(); ++it) {
+    //
+    if(&it->second == &table || it->second.ground != ground() || !it->second.value.size())
+      continue;
+
+    const double ref  = it->first.first;
+    const double step = it->first.second;
+
+    for(int i = 0; i < size; ++i) {
+      if(isset[i])
+	continue;
+
+      const double x = (ref - energy_reference + (double)i * energy_step) / step;
+      const double j = nearbyint(x);
+
+      if(j >= 0. && j < (double)it->second.value.size() && std::fabs(x - j) < 1.e-9 * (j + 1.)) {
+	table.value[i] = it->second.value[(int)j];
+	isset[i] = 1;
+      }
+    }
+  }
+
+  std::vector<double> ener;
+  std::vector<int>    index;
+  for(int i = 0; i < size; ++i)
+    if(!isset[i]) {
+      ener.push_back(energy_reference - (double)i * energy_step);
+      index.push_back(i);
+    }
+
+  if(ener.size()) {
+    std::vector<double> value(ener.size());
+    states(&ener[0], ener.size(), &value[0]);
+
+    for(int i = 0; i < index.size(); ++i)
+      table.value[index[i]] = value[i];
+  }
+
+  return table.value;
+}
+
 void Model::Species::_print () const
 {
   if(_print_step < 0. || mode() == NOSTATES)
@@ -13037,8 +14661,21 @@ int Model::Species::oscillator_size () const
  ************************* READ STATES FROM THE FILE AND INTERPOLATE ***********************
  *******************************************************************************************/
   
+namespace {
+
+  // binary states table of ReadSpecies, native byte order
+  const char states_table_magic [8] = {'M', 'E', 'S', 'S', 'D', 'O', 'S', '1'};
+
+  struct StatesTableHeader {
+    char    magic [8];
+    int64_t mode;   // density or number of states
+    int64_t size;   // table size, the zero states point included
+    double  ground; // zero states energy, the ground energy shift excluded
+  };
+}
+
 Model::ReadSpecies::ReadSpecies (std::istream& from, const std::string& n, int m) 
-  : Species(n, m), _etol(1.e-10), _dtol(1.)
+  : Species(n, m), _table_ener(0), _table_states(0), _table_size(0), _etol(1.e-10), _dtol(1.)
 {
   const char funame [] = "Model::ReadSpecies::ReadSpecies:";
 
@@ -13050,6 +14687,7 @@ Model::ReadSpecies::ReadSpecies (std::istream& from, const std::string& n, int m
   Key  mass_key("Mass[amu]"  );
   Key  unit_key("EnergyUnits");
   Key  file_key("File"       );
+  Key  save_key("BinaryOutput");
 
   Key  incm_ener_key("GroundEnergy[1/cm]");
   Key  kcal_ener_key("GroundEnergy[kcal/mol]");
@@ -13073,6 +14711,8 @@ Model::ReadSpecies::ReadSpecies (std::istream& from, const std::string& n, int m
 
   std::string token, comment, name, stemp;
 
+  std::string table_name, save_name;
+
   while(from >> token) {
     // end input
     if(IO::end_key() == token) {
@@ -13163,7 +14803,18 @@ Model::ReadSpecies::ReadSpecies (std::istream& from, const std::string& n, int m
 	throw Error::Input();
       }
       std::getline(from, comment);
-      std::ifstream file(name.c_str());
+
+      // binary table
+      {
+	IO::MappedFile table;
+	if(table.open(name.c_str()) && table.size() >= sizeof(StatesTableHeader)
+	   && !std::memcmp(table.data(), states_table_magic, sizeof(states_table_magic))) {
+	  table_name = name;
+	  continue;
+	}
+      }
+
+      IO::FileStream file(name.c_str());
       if(!file) {
 	std::cerr << funame << "cannot open file " << name << " for reading\n";
 	IO::log << std::flush;
@@ -13180,6 +14831,14 @@ Model::ReadSpecies::ReadSpecies (std::istream& from, const std::string& n, int m
 	read_states[eval] = dval;
       }
     }
+    // binary table output
+    else if(save_key == token) {
+      if(!(from >> save_name)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+    }
     // unknown keyword
     else if(IO::skip_comment(token, from)) {
       std::cerr << funame << "unknown keyword " << token << "\n";
@@ -13189,6 +14848,25 @@ Model::ReadSpecies::ReadSpecies (std::istream& from, const std::string& n, int m
     }
   }
 
+  if(table_name.size()) {
+    //
+    if(read_states.size()) {
+      std::cerr << funame << "both the binary and the text tables are given\n";
+      throw Error::Init();
+    }
+
+    _map_table(table_name);
+
+    _ground += ground_shift;
+
+    if(save_name.size())
+      _save_table(save_name, _ground - ground_shift);
+
+    _print();
+
+    return;
+  }
+
   if(mode() == DENSITY)
     for(std::map<double, double>::iterator i = read_states.begin(); i != read_states.end(); ++i)
       i->second /= energy_unit;
@@ -13251,9 +14929,102 @@ Model::ReadSpecies::ReadSpecies (std::istream& from, const std::string& n, int m
   _nmax = (y[l1] - y[l2]) / (x[l1] - x[l2]);
   _amax = std::exp(y[l1] - x[l1] * _nmax);
 
+  _table_ener   = _ener;
+  _table_states = _states;
+  _table_size   = _ener.size();
+
+  if(save_name.size())
+    _save_table(save_name, _ground - ground_shift);
+
   _print();
 }// Read Model
 
+// binary table: the header, the relative energies and the states (the text table processed,
+// atomic units), the spline knots and values (logarithms), and the spline coefficients
+//
+void Model::ReadSpecies::_save_table (const std::string& file, double ground) const
+{
+  const char funame [] = "Model::ReadSpecies::_save_table: ";
+
+  StatesTableHeader header;
+  std::memcpy(header.magic, states_table_magic, sizeof(states_table_magic));
+  header.mode   = mode();
+  header.size   = _table_size;
+  header.ground = ground;
+
+  std::vector<double> x(_table_size - 1), y(_table_size - 1);
+  for(int i = 1; i < _table_size; ++i) {
+    x[i - 1] = std::log(_table_ener[i]);
+    y[i - 1] = std::log(_table_states[i]);
+  }
+
+  std::ofstream to(file.c_str(), std::ios::binary);
+
+  to.write((const char*)&header,              sizeof(header));
+  to.write((const char*)_table_ener,          sizeof(double) * _table_size);
+  to.write((const char*)_table_states,        sizeof(double) * _table_size);
+  to.write((const char*)&x[0],                sizeof(double) * x.size());
+  to.write((const char*)&y[0],                sizeof(double) * y.size());
+  to.write((const char*)_spline.coefficients(), sizeof(double) * 4 * (x.size() - 1));
+
+  if(!to) {
+    std::cerr << funame << "cannot write " << file << "\n";
+    throw Error::File();
+  }
+
+  IO::log << IO::log_offset << name() << ": binary states table written to " << file << "\n";
+}
+
+void Model::ReadSpecies::_map_table (const std::string& name)
+{
+  const char funame [] = "Model::ReadSpecies::_map_table: ";
+
+  if(!_table_file.open(name.c_str())) {
+    std::cerr << funame << "cannot map " << name << "\n";
+    throw Error::File();
+  }
+
+  StatesTableHeader header;
+  std::memcpy(&header, _table_file.data(), sizeof(header));
+
+  if(header.mode != mode()) {
+    std::cerr << funame << name << ": the table is for the " << (header.mode == DENSITY ? "density" : "number")
+	      << " of states\n";
+    throw Error::Init();
+  }
+
+  const long n = header.size;
+
+  if(n < 3 || _table_file.size() != sizeof(header) + sizeof(double) * (2 * n + 2 * (n - 1) + 4 * (n - 2))) {
+    std::cerr << funame << name << ": corrupted\n";
+    throw Error::Input();
+  }
+
+  const double* p = (const double*)(_table_file.data() + sizeof(header));
+
+  _table_ener   = p;
+  _table_states = p + n;
+  _table_size   = n;
+
+  const double* x = p + 2 * n;
+  const double* y = x + n - 1;
+
+  _spline.map(x, y, y + n - 1, n - 1);
+
+  _ground = header.ground;
+
+  _emin = _table_ener[1] * (1. + _etol);
+  _emax = _table_ener[n - 1] * (1. - _etol);
+
+  _nmin = (y[1] - y[0]) / (x[1] - x[0]);
+  _amin = std::exp(y[0] - x[0] * _nmin);
+
+  const long l1 = n - 2;
+  const long l2 = n - 3;
+  _nmax = (y[l1] - y[l2]) / (x[l1] - x[l2]);
+  _amax = std::exp(y[l1] - x[l1] * _nmax);
+}
+
 Model::ReadSpecies::~ReadSpecies ()
 {
   //std::cout << "Model::ReadSpecies destroyed\n";
@@ -13275,18 +15046,44 @@ double Model::ReadSpecies::states (double en) const
   return std::exp(_spline(std::log(en)));
 }
 
+void Model::ReadSpecies::states (const double* ener, int size, double* res) const
+{
+  std::vector<double> x;
+  std::vector<int>    index;
+
+  for(int i = 0; i < size; ++i) {
+    const double e = ener[i] - _ground;
+
+    if(e > _emin && e < _emax) {
+      x.push_back(std::log(e));
+      index.push_back(i);
+    }
+    else
+      res[i] = ReadSpecies::states(ener[i]);
+  }
+
+  if(!x.size())
+    return;
+
+  std::vector<double> y(x.size());
+  _spline.evaluate(&x[0], x.size(), &y[0]);
+
+  for(int k = 0; k < index.size(); ++k)
+    res[index[k]] = std::exp(y[k]);
+}
+
 double Model::ReadSpecies::weight (double temperature) const
 {
   const char funame [] = "Model::ReadSpecies::weight: ";
 
-  Array<double> term(_states.size());
+  Array<double> term(_table_size);
   term[0] = 0.;
-  for(int i = 1; i < _states.size(); ++i)
-    term[i] = _states[i] / std::exp(_ener[i] / temperature);
+  for(int i = 1; i < _table_size; ++i)
+    term[i] = _table_states[i] / std::exp(_table_ener[i] / temperature);
 
   int info;
   double res;
-  davint_(_ener, term, term.size(), _ener.front(), _ener.back(), res, info); 
+  davint_(_table_ener, term, term.size(), _table_ener[0], _table_ener[_table_size - 1], res, info); 
   if (info != 1) {
     std::cerr << funame  << "davint integration error\n";
     throw Error::Logic();
@@ -13411,120 +15208,348 @@ double Model::IntMod::evaluate (Lapack::Vector          cart_pos, // atomic cart
     //
     std::vector<int> new_sign = sign;
 
-    new_sign.pop_back();
+    new_sign.pop_back();
+
+    Lapack::Vector new_pos = cart_pos.copy();
+
+    new_pos[sign.back()] -= increment;
+
+    dtemp = evaluate(new_pos, new_sign);
+
+    new_pos[sign.back()] += 2. * increment;
+
+    dtemp = evaluate(new_pos, new_sign) - dtemp;
+
+    // correct for 360 jump for dihedral angle
+    //
+    if(!new_sign.size() && type() == DIHEDRAL) {
+      //
+      if(dtemp > 180.)
+	//
+	dtemp -= 360.;
+
+      if(dtemp < -180.)
+	//
+	dtemp += 360.;
+    }
+    
+    return dtemp / 2. / increment;
+  }
+
+  std::vector<D3::Vector> atom_pos(_atoms.size());
+
+  for(int a = 0; a < _atoms.size(); ++a)
+    //
+    for(int ai = 0; ai < 3; ++ai)
+      //
+      atom_pos[a][ai] = cart_pos[_atoms[a] * 3 + ai];
+
+  D3::Vector v1, v2, n;
+  
+  switch(type()) {
+    //
+    // interatomic distance in angstrom
+    //
+  case DISTANCE:
+    //
+    return (atom_pos[1] - atom_pos[0]).vlength() / Phys_const::angstrom;
+
+    // plane angle in degrees
+    //
+  case ANGLE:
+    //
+    v1 = atom_pos[0] - atom_pos[1];
+    
+    v2 = atom_pos[2] - atom_pos[1];
+    
+    dtemp = vdot(v1, v2) / v1.vlength() / v2.vlength();
+    
+    if(dtemp < -1.)
+      //
+      dtemp = -1.;
+    
+    if(dtemp > 1.)
+      //
+      dtemp = 1.;
+
+    return std::acos(dtemp) * 180. / M_PI;
+
+    // dihedral angle in degrees
+    //
+  case DIHEDRAL:
+    //
+    n  = atom_pos[2] - atom_pos[1];
+    
+    v1 = atom_pos[0] - atom_pos[1];
+    
+    v2 = atom_pos[3] - atom_pos[2];
+
+    v1.orthogonalize(n);
+    
+    v2.orthogonalize(n);
+    
+    dtemp = v1.vlength() * v2.vlength();
+    
+    if(dtemp < 1.e-8)
+      //
+      return 0.;
+
+    dtemp = vdot(v1, v2) / dtemp;
+    
+    if(dtemp < -1.)
+      //
+      dtemp = -1.;
+  
+    if(dtemp > 1.)
+      //
+      dtemp = 1.;
+
+    dtemp = std::acos(dtemp) * 180. / M_PI;
+
+    if(volume(n, v1, v2) > 0.) {
+      //
+      return dtemp;
+    }
+    else
+      //
+      return 360. - dtemp;
+
+    // wrong case
+    //
+  default:
+
+    std::cerr << funame << "should not be here\n";
+
+    throw Error::Logic();
+  }
+}
+
+namespace {
+  //
+  // internal mode value and gradient over the mode atoms positions
+  //
+  double intmod_value (int type, const double* pos, double* grad)
+  {
+    const char funame [] = "Model::intmod_value: ";
+
+    static const double deg = 180. / M_PI;
+
+    double dtemp;
+
+    for(int i = 0; i < 3 * type; ++i)
+      //
+      grad[i] = 0.;
+
+    switch(type) {
+      //
+      // interatomic distance in angstrom
+      //
+    case Model::IntMod::DISTANCE: {
+      //
+      double v [3];
+
+      for(int i = 0; i < 3; ++i)
+	//
+	v[i] = pos[3 + i] - pos[i];
+
+      const double r = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+
+      if(r > 0.)
+	//
+	for(int i = 0; i < 3; ++i) {
+	  //
+	  grad[3 + i] =  v[i] / r / Phys_const::angstrom;
+
+	  grad[i]     = -grad[3 + i];
+	}
+
+      return r / Phys_const::angstrom;
+    }
+      // plane angle in degrees
+      //
+    case Model::IntMod::ANGLE: {
+      //
+      double u1 [3], u2 [3];
+
+      for(int i = 0; i < 3; ++i) {
+	//
+	u1[i] = pos[i]     - pos[3 + i];
+
+	u2[i] = pos[6 + i] - pos[3 + i];
+      }
+
+      const double l1 = std::sqrt(u1[0] * u1[0] + u1[1] * u1[1] + u1[2] * u1[2]);
+
+      const double l2 = std::sqrt(u2[0] * u2[0] + u2[1] * u2[1] + u2[2] * u2[2]);
+
+      for(int i = 0; i < 3; ++i) {
+	//
+	u1[i] /= l1;
+
+	u2[i] /= l2;
+      }
+
+      double c = u1[0] * u2[0] + u1[1] * u2[1] + u1[2] * u2[2];
+
+      if(c < -1.)
+	//
+	c = -1.;
+
+      if(c > 1.)
+	//
+	c = 1.;
+
+      const double sn = std::sqrt(1. - c * c);
+
+      if(sn > 1.e-12)
+	//
+	for(int i = 0; i < 3; ++i) {
+	  //
+	  grad[i]     = -(u2[i] - c * u1[i]) / l1 / sn * deg;
+
+	  grad[6 + i] = -(u1[i] - c * u2[i]) / l2 / sn * deg;
+
+	  grad[3 + i] = -grad[i] - grad[6 + i];
+	}
+
+      return std::acos(c) * deg;
+    }
+      // dihedral angle in degrees
+      //
+    case Model::IntMod::DIHEDRAL: {
+      //
+      D3::Vector p [4];
+
+      for(int a = 0; a < 4; ++a)
+	//
+	for(int i = 0; i < 3; ++i)
+	  //
+	  p[a][i] = pos[3 * a + i];
+
+      D3::Vector n  = p[2] - p[1];
+
+      D3::Vector v1 = p[0] - p[1];
+
+      D3::Vector v2 = p[3] - p[2];
+
+      v1.orthogonalize(n);
+
+      v2.orthogonalize(n);
+
+      dtemp = v1.vlength() * v2.vlength();
+
+      if(dtemp < 1.e-8)
+	//
+	return 0.;
+
+      dtemp = vdot(v1, v2) / dtemp;
+
+      if(dtemp < -1.)
+	//
+	dtemp = -1.;
+
+      if(dtemp > 1.)
+	//
+	dtemp = 1.;
+
+      dtemp = std::acos(dtemp) * deg;
 
-    Lapack::Vector new_pos = cart_pos.copy();
+      const double res = volume(n, v1, v2) > 0. ? dtemp : 360. - dtemp;
 
-    new_pos[sign.back()] -= increment;
+      // gradient (Blondel and Karplus), the angle increasing with the right-hand rotation
+      // of the last bond around the central one
+      //
+      const D3::Vector f = p[0] - p[1];
 
-    dtemp = evaluate(new_pos, new_sign);
+      const D3::Vector g = p[1] - p[2];
 
-    new_pos[sign.back()] += 2. * increment;
+      const D3::Vector h = p[3] - p[2];
 
-    dtemp = evaluate(new_pos, new_sign) - dtemp;
+      const D3::Vector a = vprod(f, g);
 
-    // correct for 360 jump for dihedral angle
-    //
-    if(!new_sign.size() && type() == DIHEDRAL) {
-      //
-      if(dtemp > 180.)
+      const D3::Vector b = vprod(h, g);
+
+      const double aa = vdot(a, a);
+
+      const double bb = vdot(b, b);
+
+      const double gl = g.vlength();
+
+      if(aa < 1.e-16 || bb < 1.e-16 || gl < 1.e-8)
 	//
-	dtemp -= 360.;
+	return res;
 
-      if(dtemp < -180.)
+      const double fg = vdot(f, g) / aa / gl;
+
+      const double hg = vdot(h, g) / bb / gl;
+
+      for(int i = 0; i < 3; ++i) {
 	//
-	dtemp += 360.;
-    }
-    
-    return dtemp / 2. / increment;
-  }
+	const double g0 = -gl / aa * a[i];
 
-  std::vector<D3::Vector> atom_pos(_atoms.size());
+	const double g3 =  gl / bb * b[i];
 
-  for(int a = 0; a < _atoms.size(); ++a)
-    //
-    for(int ai = 0; ai < 3; ++ai)
+	grad[i]     = g0                             * deg;
+	grad[3 + i] = (-g0 + fg * a[i] - hg * b[i]) * deg;
+	grad[6 + i] = (-g3 - fg * a[i] + hg * b[i]) * deg;
+	grad[9 + i] = g3                             * deg;
+      }
+
+      return res;
+    }
+      // wrong case
       //
-      atom_pos[a][ai] = cart_pos[_atoms[a] * 3 + ai];
+    default:
 
-  D3::Vector v1, v2, n;
-  
-  switch(type()) {
-    //
-    // interatomic distance in angstrom
-    //
-  case DISTANCE:
-    //
-    return (atom_pos[1] - atom_pos[0]).vlength() / Phys_const::angstrom;
+      std::cerr << funame << "should not be here\n";
 
-    // plane angle in degrees
-    //
-  case ANGLE:
+      throw Error::Logic();
+    }
+  }
+}
+
+double Model::IntMod::evaluate (const double* cart_pos, double* grad, double* hess) const
+{
+  const int size = 3 * type();
+
+  double pos [12], gp [12], gm [12];
+
+  for(int a = 0; a < type(); ++a)
     //
-    v1 = atom_pos[0] - atom_pos[1];
-    
-    v2 = atom_pos[2] - atom_pos[1];
-    
-    dtemp = vdot(v1, v2) / v1.vlength() / v2.vlength();
-    
-    if(dtemp < -1.)
-      //
-      dtemp = -1.;
-    
-    if(dtemp > 1.)
+    for(int i = 0; i < 3; ++i)
       //
-      dtemp = 1.;
+      pos[3 * a + i] = cart_pos[_atoms[a] * 3 + i];
 
-    return std::acos(dtemp) * 180. / M_PI;
+  const double res = intmod_value(type(), pos, grad);
 
-    // dihedral angle in degrees
+  if(!hess)
     //
-  case DIHEDRAL:
+    return res;
+
+  for(int k = 0; k < size; ++k) {
     //
-    n  = atom_pos[2] - atom_pos[1];
-    
-    v1 = atom_pos[0] - atom_pos[1];
-    
-    v2 = atom_pos[3] - atom_pos[2];
+    pos[k] += increment;
 
-    v1.orthogonalize(n);
-    
-    v2.orthogonalize(n);
-    
-    dtemp = v1.vlength() * v2.vlength();
-    
-    if(dtemp < 1.e-8)
-      //
-      return 0.;
+    intmod_value(type(), pos, gp);
 
-    dtemp = vdot(v1, v2) / dtemp;
-    
-    if(dtemp < -1.)
-      //
-      dtemp = -1.;
-  
-    if(dtemp > 1.)
-      //
-      dtemp = 1.;
+    pos[k] -= 2. * increment;
 
-    dtemp = std::acos(dtemp) * 180. / M_PI;
+    intmod_value(type(), pos, gm);
 
-    if(volume(n, v1, v2) > 0.) {
-      //
-      return dtemp;
-    }
-    else
+    pos[k] += increment;
+
+    for(int l = 0; l < size; ++l)
       //
-      return 360. - dtemp;
+      hess[k * size + l] = (gp[l] - gm[l]) / 2. / increment;
+  }
 
-    // wrong case
+  for(int k = 0; k < size; ++k)
     //
-  default:
-
-    std::cerr << funame << "should not be here\n";
+    for(int l = k + 1; l < size; ++l)
+      //
+      hess[k * size + l] = hess[l * size + k] = (hess[k * size + l] + hess[l * size + k]) / 2.;
 
-    throw Error::Logic();
-  }
+  return res;
 }
 
 Model::Fluxional::Fluxional (int molec_size, IO::KeyBufferStream& from) : IntMod(molec_size, from), _span(-1.)
@@ -13946,7 +15971,7 @@ void Model::MonteCarlo::_RefPot::init(std::istream& from)
 Model::MonteCarlo::~MonteCarlo() {}
 
 Model::MonteCarlo::MonteCarlo(IO::KeyBufferStream& from, const std::string& n, int m)
-  : Species(from, n, m), _symm_fac(1.), _noqf(false), _nohess(false), _nocurv(false),
+  : Species(from, n, m), _symm_fac(1.), _noqf(false), _nohess(false), _data_cache(false), _nocurv(false),
     _cmshift(false), _ists(false), _ref_tem(-1.)
 {
   const char funame [] = "Model::MonteCarlo::MonteCarlo: ";
@@ -13970,6 +15995,7 @@ Model::MonteCarlo::MonteCarlo(IO::KeyBufferStream& from, const std::string& n, i
   Key    rtem_key("ReferenceTemperature[K]"      );
   Key    noqf_key("NoQuantumCorrection"          );
   Key  nohess_key("NoHessian"                    );
+  Key  dcache_key("BinaryDataCache"              );
   Key  nocurv_key("NoCurvlinearCorrection"       );
   Key cmshift_key("UseCMShift"                   );
   Key    freq_key("NonFluxionalFrequencies[1/cm]");
@@ -14023,6 +16049,14 @@ Model::MonteCarlo::MonteCarlo(IO::KeyBufferStream& from, const std::string& n, i
 
       _nohess = true;
     }
+    // binary sampling data cache
+    //
+    else if(dcache_key == token) {
+      //
+      std::getline(from, comment);
+
+      _data_cache = true;
+    }
     // no curvlinear correction to hessian
     //
     else if(nocurv_key == token) {
@@ -14496,6 +16530,8 @@ Model::MonteCarlo::MonteCarlo(IO::KeyBufferStream& from, const std::string& n, i
     throw Error::Init();
   }
 
+  _read_data();
+
   if(!isrefen && isground) {
     //
     IO::log << IO::log_offset << "WARNING: the reference energy set to the ground state energy: " << _ground  / Phys_const::kcal << " kcal/mol\n";
@@ -14553,50 +16589,79 @@ double Model::MonteCarlo::weight_with_error (double temperature, double& werr) c
 
   IO::Marker funame_marker(funame);
   
-  std::ifstream from(_data_file.c_str());
+  const int cart_size = atom_size() * 3;
 
-  if(!from) {
+  // samplings per log flush
+  //
+  static const int block_size = 1024;
+
+  // the samplings are evaluated concurrently block by block, the sampling logs are buffered
+  // and flushed in the sampling order
+  //
+  std::vector<double> samp_weight(_samp_size());
+
+  for(int start = 0; start < _samp_size(); start += block_size) {
     //
-    std::cerr << funame << "cannot open data file " << _data_file << "\n";
+    const int end = start + block_size < _samp_size() ? start + block_size : _samp_size();
 
-    throw Error::File();
-  }
+    std::vector<std::string> samp_log(end - start);
 
-  std::string comment;
+    std::exception_ptr error;
 
-  std::getline(from, comment);
-  
-  double res = 0.;
+#pragma omp parallel for default(shared) schedule(dynamic)
 
-  double variance = 0.;
+    for(int samp = start; samp < end; ++samp) {
+      //
+      std::ostringstream log;
 
-  double ener;
+      try {
+	//
+	double ener;
 
-  // cartesian coordinates
-  //
-  Lapack::Vector          cart_pos(atom_size() * 3);
+	Lapack::Vector          cart_pos(cart_size);
+	Lapack::Vector          cart_grad(cart_size);
+	Lapack::SymmetricMatrix cart_fc(cart_size);
 
-  // cartesian gradient
-  //
-  Lapack::Vector          cart_grad(atom_size() * 3);
+	_sampling(samp, ener, cart_pos, cart_grad, cart_fc);
 
-  // cartesian force constant matrix
-  //
-  Lapack::SymmetricMatrix cart_fc(atom_size() * 3);
+	log << IO::log_offset << "Sampling " << samp + 1 << "\n";
+
+	samp_weight[samp] = _local_weight(ener, cart_pos, cart_grad, cart_fc, temperature, log);
+      }
+      catch(...) {
+	//
+#pragma omp critical(monte_carlo_error)
+
+	if(!error)
+	  //
+	  error = std::current_exception();
+      }
+
+      samp_log[samp - start] = log.str();
+    }
+
+    for(int i = 0; i < samp_log.size(); ++i)
+      //
+      IO::log << samp_log[i];
+
+    if(error)
+      //
+      std::rethrow_exception(error);
+  }
+
+  double res = 0.;
 
-  int count = 0, samp = 0;
+  double variance = 0.;
+
+  int count = 0;
   
-  while(_read(from, ener, cart_pos, cart_grad, cart_fc)) {
+  for(int samp = 0; samp < _samp_size(); ++samp) {
     //
-    ++samp;
-    
-    IO::log << IO::log_offset << "Sampling " << samp << "\n";
-    
-    dtemp = _local_weight(ener, cart_pos, cart_grad, cart_fc, temperature);
+    dtemp = samp_weight[samp];
 
     if(dtemp < 0.) {
       //
-      std::cerr << funame << samp << "-th sampling failed\n";
+      std::cerr << funame << samp + 1 << "-th sampling failed\n";
 
       continue;
     }
@@ -14861,47 +16926,224 @@ bool Model::MonteCarlo::_read (std::istream&           from,       // data strea
 	//
 	continue;
 
-      cart_fc(i, j) = dtemp;
-    }
-  
-  std::getline(from, comment);
-  
-  // empty line
-  //
-  std::getline(from, comment);
-    
+      cart_fc(i, j) = dtemp;
+    }
+  
+  std::getline(from, comment);
+  
+  // empty line
+  //
+  std::getline(from, comment);
+    
+  return true;
+}
+
+void Model::MonteCarlo::_read_data ()
+{
+  const char funame [] = "Model::MonteCarlo::_read_data: ";
+
+  if(!_data_file.size()) {
+    //
+    std::cerr << funame << "no data file\n";
+
+    throw Error::Init();
+  }
+  
+  const std::string cache_file = _data_file + ".bin";
+
+  if(_data_cache && _load_data_cache(cache_file)) {
+    //
+    IO::log << IO::log_offset << _samp_size() << " samplings read from " << cache_file << "\n";
+
+    return;
+  }
+  
+  IO::FileStream from(_data_file.c_str());
+
+  if(!from) {
+    //
+    std::cerr << funame << "cannot open data file " << _data_file << "\n";
+
+    throw Error::File();
+  }
+
+  std::string comment;
+
+  std::getline(from, comment);
+  
+  double ener;
+
+  const int cart_size = atom_size() * 3;
+
+  const int fc_size = cart_size * (cart_size + 1) / 2;
+  
+  Lapack::Vector          cart_pos(cart_size);
+  Lapack::Vector          cart_grad(cart_size);
+  Lapack::SymmetricMatrix cart_fc(cart_size);
+
+  _samp_ener.clear();
+  _samp_pos.clear();
+  _samp_grad.clear();
+  _samp_fc.clear();
+
+  while(_read(from, ener, cart_pos, cart_grad, cart_fc)) {
+    //
+    _samp_ener.push_back(ener);
+
+    _samp_pos.insert(_samp_pos.end(), (const double*)cart_pos, (const double*)cart_pos + cart_size);
+
+    if(_nohess)
+      //
+      continue;
+
+    _samp_grad.insert(_samp_grad.end(), (const double*)cart_grad, (const double*)cart_grad + cart_size);
+
+    _samp_fc.insert(_samp_fc.end(), (const double*)cart_fc, (const double*)cart_fc + fc_size);
+  }
+
+  IO::log << IO::log_offset << _samp_size() << " samplings read from " << _data_file << "\n";
+
+  if(_data_cache)
+    //
+    _save_data_cache(cache_file);
+}
+
+// binary cache layout: signature, atoms #, hessian flag, samplings #, and the sampling arrays;
+// the cache is used only if it is not older than the data file
+//
+namespace {
+  //
+  const char mc_cache_signature [] = "MESS_MC_DATA_1";
+}
+
+bool Model::MonteCarlo::_load_data_cache (const std::string& cache_file)
+{
+  struct stat data_stat, cache_stat;
+
+  if(stat(cache_file.c_str(), &cache_stat) || stat(_data_file.c_str(), &data_stat) 
+     || cache_stat.st_mtime < data_stat.st_mtime)
+    //
+    return false;
+
+  std::ifstream from(cache_file.c_str(), std::ios::binary);
+
+  char sig [sizeof(mc_cache_signature)];
+  
+  int  atoms, hess;
+
+  long samp_size;
+
+  if(!from.read(sig, sizeof(sig)) || std::strncmp(sig, mc_cache_signature, sizeof(sig))
+     || !from.read((char*)&atoms, sizeof(atoms)) || atoms != atom_size()
+     || !from.read((char*)&hess, sizeof(hess)) || hess != !_nohess
+     || !from.read((char*)&samp_size, sizeof(samp_size)) || samp_size <= 0)
+    //
+    return false;
+
+  const long cart_size = atom_size() * 3;
+
+  const long fc_size = cart_size * (cart_size + 1) / 2;
+  
+  _samp_ener.resize(samp_size);
+  _samp_pos.resize(samp_size * cart_size);
+
+  from.read((char*)&_samp_ener[0], _samp_ener.size() * sizeof(double));
+  from.read((char*)&_samp_pos[0],  _samp_pos.size()  * sizeof(double));
+
+  _samp_grad.clear();
+  _samp_fc.clear();
+
+  if(!_nohess) {
+    //
+    _samp_grad.resize(samp_size * cart_size);
+    _samp_fc.resize(samp_size * fc_size);
+
+    from.read((char*)&_samp_grad[0], _samp_grad.size() * sizeof(double));
+    from.read((char*)&_samp_fc[0],   _samp_fc.size()   * sizeof(double));
+  }
+
+  if(!from) {
+    //
+    IO::log << IO::log_offset << "WARNING: " << cache_file << " is truncated, reading the data file\n";
+
+    _samp_ener.clear();
+    _samp_pos.clear();
+    _samp_grad.clear();
+    _samp_fc.clear();
+
+    return false;
+  }
+
   return true;
 }
 
-void Model::MonteCarlo::_set_reference_energy ()
+void Model::MonteCarlo::_save_data_cache (const std::string& cache_file) const
 {
-  const char funame [] = "Model::MonteCarlo::_set_reference_energy: ";
-
-  int    itemp;
+  if(!_samp_size())
+    //
+    return;
   
-  double dtemp;
+  std::ofstream to(cache_file.c_str(), std::ios::binary);
 
-  if(!_data_file.size()) {
+  const int  atoms     = atom_size();
+  const int  hess      = !_nohess;
+  const long samp_size = _samp_size();
+
+  to.write(mc_cache_signature, sizeof(mc_cache_signature));
+  to.write((const char*)&atoms,     sizeof(atoms));
+  to.write((const char*)&hess,      sizeof(hess));
+  to.write((const char*)&samp_size, sizeof(samp_size));
+
+  to.write((const char*)&_samp_ener[0], _samp_ener.size() * sizeof(double));
+  to.write((const char*)&_samp_pos[0],  _samp_pos.size()  * sizeof(double));
+
+  if(!_nohess) {
     //
-    std::cerr << funame << "no data file\n";
+    to.write((const char*)&_samp_grad[0], _samp_grad.size() * sizeof(double));
+    to.write((const char*)&_samp_fc[0],   _samp_fc.size()   * sizeof(double));
+  }
 
-    throw Error::Init();
+  to.close();
+  
+  if(!to) {
+    //
+    IO::log << IO::log_offset << "WARNING: cannot write " << cache_file << "\n";
+
+    std::remove(cache_file.c_str());
   }
+}
+
+void Model::MonteCarlo::_sampling (int                      samp,
+				   double&                  ener,
+				   Lapack::Vector&          cart_pos,
+				   Lapack::Vector&          cart_grad,
+				   Lapack::SymmetricMatrix& cart_fc
+				   ) const
+{
+  const int cart_size = atom_size() * 3;
+
+  const int fc_size = cart_size * (cart_size + 1) / 2;
   
-  std::ifstream from(_data_file.c_str());
+  ener = _samp_ener[samp];
 
-  if(!from) {
+  std::copy(&_samp_pos[samp * cart_size], &_samp_pos[samp * cart_size] + cart_size, (double*)cart_pos);
+
+  if(_nohess)
     //
-    std::cerr << funame << "cannot open data file " << _data_file << "\n";
+    return;
 
-    throw Error::File();
-  }
+  std::copy(&_samp_grad[samp * cart_size], &_samp_grad[samp * cart_size] + cart_size, (double*)cart_grad);
 
-  std::string comment;
+  std::copy(&_samp_fc[(size_t)samp * fc_size], &_samp_fc[(size_t)samp * fc_size] + fc_size, (double*)cart_fc);
+}
 
-  std::getline(from, comment);
+void Model::MonteCarlo::_set_reference_energy ()
+{
+  const char funame [] = "Model::MonteCarlo::_set_reference_energy: ";
+
+  int    itemp;
   
-  double res = 0.;
+  double dtemp;
 
   double ener;
 
@@ -14921,7 +17163,10 @@ void Model::MonteCarlo::_set_reference_energy ()
 
   int count = 0;
   
-  while(_read(from, ener, cart_pos, cart_grad, cart_fc)) {
+  for(int samp = 0; samp < _samp_size(); ++samp) {
+    //
+    _sampling(samp, ener, cart_pos, cart_grad, cart_fc);
+
     //
     if(!_noqf && !_nohess) {
       //
@@ -15038,7 +17283,8 @@ double Model::MonteCarlo::_local_weight (double                  ener,       //
 					 Lapack::Vector          cart_pos,   // cartesian coordinates    
 					 Lapack::Vector          cart_grad,  // energy gradient in cartesian coordinates
 					 Lapack::SymmetricMatrix cart_fc,    // cartesian force constant matrix
-					 double                  temperature // temprature
+					 double                  temperature, // temprature
+					 std::ostream&           log          // sampling log
 					 ) const
 {
   const char funame [] = "Model::MonteCarlo::_local_weight: ";
@@ -15059,46 +17305,59 @@ double Model::MonteCarlo::_local_weight (double                  ener,       //
   
   double dtemp;
 
-  IO::Marker funame_marker(funame);
-  
   // center of mass shift
   //
   if(_cmshift)
     //
     _make_cm_shift(cart_pos);
   
+  const int cart_size = _mass_sqrt.size() * 3;
+
+  // fluxional modes values, first derivatives, and, for the force constant curvlinear
+  // correction, second derivatives over the mode atoms cartesian coordinates
+  //
+  const bool iscurv = !_nohess && !_nocurv && !_ists;
+  
+  std::vector<double> flux_val(_fluxional.size());
+
+  std::vector<double> flux_fd(_fluxional.size() * 12);
+
+  std::vector<double> flux_sd(iscurv ? _fluxional.size() * 144 : 0);
+
+  for(int f = 0; f < _fluxional.size(); ++f)
+    //
+    flux_val[f] = _fluxional[f].evaluate(cart_pos, &flux_fd[f * 12], iscurv ? &flux_sd[f * 144] : 0);
+  
   // fluxional modes values output
   //
-  IO::log << IO::log_offset << "fluxional modes values:";
+  log << IO::log_offset << "fluxional modes values:";
   
   for(int f = 0; f < _fluxional.size(); ++f)
     //
-    IO::log << std::setw(15) << _fluxional[f].evaluate(cart_pos);
+    log << std::setw(15) << flux_val[f];
 
-  IO::log << "\n";
+  log << "\n";
   
   // fluxional modes first derivatives
   //
-  const int cart_size = _mass_sqrt.size() * 3;
-
   Lapack::Matrix fmfd(cart_size, _fluxional.size());
 
-  for(int c = 0; c < cart_size; ++c) {
-    //
-    // first derivative signature
+  fmfd = 0.;
+  
+  for(int f = 0; f < _fluxional.size(); ++f) {
     //
-    std::vector<int> sign(1);
+    const std::vector<int>& atoms = _fluxional[f].atoms();
 
-    sign[0] = c;
-    
-    for(int f = 0; f < _fluxional.size(); ++f)
+    for(int a = 0; a < atoms.size(); ++a)
       //
-      fmfd(c, f) = _fluxional[f].evaluate(cart_pos, sign);
+      for(int i = 0; i < 3; ++i)
+	//
+	fmfd(atoms[a] * 3 + i, f) += flux_fd[f * 12 + a * 3 + i];
   }
-
+  
   // force constant curvlinear correction
   //
-  if(!_nohess && !_nocurv && !_ists) {
+  if(iscurv) {
     //
     // potential energy gradient over fluxional modes coordinates
     //
@@ -15106,18 +17365,18 @@ double Model::MonteCarlo::_local_weight (double                  ener,       //
   
     Lapack::Vector flux_grad = Lapack::svd_solve(fmfd, cart_grad, &residue);
 
-    IO::log << IO::log_offset << "energy, kcal/mol, over fluxional modes coordinates gradient:";
+    log << IO::log_offset << "energy, kcal/mol, over fluxional modes coordinates gradient:";
 
     for(int f = 0; f < _fluxional.size(); ++f)
       //
-      IO::log << std::setw(15) << flux_grad[f] / Phys_const::kcal;
+      log << std::setw(15) << flux_grad[f] / Phys_const::kcal;
 
-    IO::log << "\n";
+    log << "\n";
   
-    IO::log << IO::log_offset << "cartesian gradient length,  kcal/mol/Bohr: " << std::setw(15)
+    log << IO::log_offset << "cartesian gradient length,  kcal/mol/Bohr: " << std::setw(15)
 	    << std::sqrt(cart_grad.vdot()) / Phys_const::kcal << "\n";
   
-    IO::log << IO::log_offset << "cartesian gradient residue, kcal/mol/Bohr: " << std::setw(15)
+    log << IO::log_offset << "cartesian gradient residue, kcal/mol/Bohr: " << std::setw(15)
 	    << residue / Phys_const::kcal << "\n";
 
     // check residue: => OK
@@ -15127,22 +17386,30 @@ double Model::MonteCarlo::_local_weight (double                  ener,       //
 
       appr_grad -= cart_grad;
 
-      IO::log << IO::log_offset << "test residue,               kcal/mol/Bohr: " << std::setw(15)
+      log << IO::log_offset << "test residue,               kcal/mol/Bohr: " << std::setw(15)
       << std::sqrt(appr_grad.vdot()) / Phys_const::kcal << "\n";
     */
-    
-    for(int c = 0; c < cart_size; ++c) {
-      //
-      for(int d = c; d < cart_size; ++d) {
-	//
-	std::vector<int> sign(2);
 
-	sign[0] = c;
-	sign[1] = d;
+    // only the mode atoms pairs contribute
+    //
+    for(int f = 0; f < _fluxional.size(); ++f) {
+      //
+      const std::vector<int>& atoms = _fluxional[f].atoms();
 
-	for(int i = 0; i < _fluxional.size(); ++i)
+      const int size = atoms.size() * 3;
+      
+      for(int k = 0; k < size; ++k) {
+	//
+	const int c = atoms[k / 3] * 3 + k % 3;
+	
+	for(int l = 0; l < size; ++l) {
 	  //
-	  cart_fc(c, d) -= flux_grad[i] * _fluxional[i].evaluate(cart_pos, sign);
+	  const int d = atoms[l / 3] * 3 + l % 3;
+
+	  if(c <= d)
+	    //
+	    cart_fc(c, d) -= flux_grad[f] * flux_sd[f * 144 + k * size + l];
+	}
       }
     }
   }
@@ -15265,7 +17532,7 @@ double Model::MonteCarlo::_local_weight (double                  ener,       //
 	
 	  std::cerr << funame << "WARNING: the system is in the deep tunneling regime, check the log file\n";
 
-	  IO::log << IO::log_offset << "WARNING: the system is in the deep tunneling regime" << std::endl;
+	  log << IO::log_offset << "WARNING: the system is in the deep tunneling regime" << std::endl;
 	}
       }
       else if(eval[f] > 0.) {
@@ -15288,27 +17555,27 @@ double Model::MonteCarlo::_local_weight (double                  ener,       //
     //
     if(deep_tunnel) {
       //
-      IO::log << IO::log_offset << "Deep tunneling regime:\n";
+      log << IO::log_offset << "Deep tunneling regime:\n";
       
-      IO::log << IO::log_offset << "Energy (including zero-point energy correction) = "
+      log << IO::log_offset << "Energy (including zero-point energy correction) = "
 	      << (ener - _refen) / Phys_const::kcal << " kcal/mol" << std::endl;
 
-      IO::log << IO::log_offset << "Frequencies, 1/cm:";
+      log << IO::log_offset << "Frequencies, 1/cm:";
 
       for(int f = 0; f < in_size; ++f) {
 	//
-	IO::log << "   ";
+	log << "   ";
     
 	if(eval[f] < 0.) {
 	  //
-	  IO::log << -std::sqrt(-eval[f]) / Phys_const::incm;
+	  log << -std::sqrt(-eval[f]) / Phys_const::incm;
 	}
 	else
 	  //
-	  IO::log << std::sqrt(eval[f]) / Phys_const::incm;
+	  log << std::sqrt(eval[f]) / Phys_const::incm;
       }
 
-      IO::log << std::endl;
+      log << std::endl;
       //
     }// deep tunneling
 
@@ -15376,7 +17643,7 @@ double Model::MonteCarlo::_local_weight (double                  ener,       //
 	  //
 	  smtemp(f, g) += fspace(f, i) * fspace(g, i) / eval[i] / eval[i];
 
-    wfac *= Lapack::Cholesky(smtemp).det_sqrt();
+    wfac *= Lapack::det_sqrt(smtemp);
 
     smtemp = 0.;
     
@@ -15428,13 +17695,13 @@ double Model::MonteCarlo::_local_weight (double                  ener,       //
     
     eval = fc.eigenvalues(&evec);
 
-    IO::log << IO::log_offset << "projected frequencies, 1/cm:";
+    log << IO::log_offset << "projected frequencies, 1/cm:";
     
     for(int f = 0; f < nm_size; ++f) {
       //
       double freq = eval[f] >= 0. ? std::sqrt(eval[f]) : -std::sqrt(-eval[f]);
 
-      IO::log << "   " << freq / Phys_const::incm;
+      log << "   " << freq / Phys_const::incm;
       
       if(!f) {
 	//
@@ -15458,7 +17725,7 @@ double Model::MonteCarlo::_local_weight (double                  ener,       //
       wfac /= freq;
     }
 
-    IO::log << "\n";
+    log << "\n";
     
     // gradient in the eigenvector complimentary space
     //
@@ -15474,7 +17741,7 @@ double Model::MonteCarlo::_local_weight (double                  ener,       //
 
     dtemp /= 2.;
 
-    IO::log << IO::log_offset << "Energy correction = " << dtemp / Phys_const::kcal << " kcal/mol\n";
+    log << IO::log_offset << "Energy correction = " << dtemp / Phys_const::kcal << " kcal/mol\n";
 
     ener += dtemp;
     //
@@ -15519,22 +17786,22 @@ double Model::MonteCarlo::_local_weight (double                  ener,       //
       //
       // if(deep_tunnel) {
       //
-      IO::log << IO::log_offset << "non-fluxional modes (" << nm_size << ") frequencies, 1/cm:";
+      log << IO::log_offset << "non-fluxional modes (" << nm_size << ") frequencies, 1/cm:";
 
       for(int f = 0; f < nm_size; ++f) {
 	//
-	IO::log << "   ";
+	log << "   ";
     
 	if(eval[f] < 0.) {
 	  //
-	  IO::log << -std::sqrt(-eval[f]) / Phys_const::incm;
+	  log << -std::sqrt(-eval[f]) / Phys_const::incm;
 	}
 	else
 	  //
-	  IO::log << std::sqrt(eval[f]) / Phys_const::incm;
+	  log << std::sqrt(eval[f]) / Phys_const::incm;
       }
 
-      IO::log << std::endl;
+      log << std::endl;
       //
       // }
   
@@ -15596,9 +17863,15 @@ double Model::MonteCarlo::_local_weight (double                  ener,       //
 
     for(int f = 0; f < _fluxional.size(); ++f)
       //
-      flux_pos[f] = _fluxional[f].evaluate(cart_pos);
+      flux_pos[f] = flux_val[f];
   
-    bpow -= _ref_pot(flux_pos) / _ref_tem;
+    // the reference potential library is not assumed to be thread safe
+    //
+#pragma omp critical(monte_carlo_ref_pot)
+
+    dtemp = _ref_pot(flux_pos);
+
+    bpow -= dtemp / _ref_tem;
   }
 
   if(bpow > exp_arg_max)
@@ -15826,105 +18099,149 @@ Model::MonteCarloWithDummy::MonteCarloWithDummy(IO::KeyBufferStream& from, const
 
     throw Error::Init();
   }
-}
 
-void Model::MonteCarloWithDummy::_assert(ConstSlice<double> v) const
-{
-  const char funame [] = "Model::MonteCarloWithDummy::_assert: ";
+  // geometry independent projector parts
+  //
+  const int cart_size = _atom_array.size() * 3;
 
-  if(v.size() == _atom_array.size() * 3)
-    //
-    return;
+  _mass_sqrt.assign(cart_size, 0.);
 
-  std::cerr << funame << "vector size out of range: " << v.size();
+  _trans_con.resize(3, cart_size);
+
+  _trans_con = 0.;
   
-  throw Error::Range();
-}
+  for(int r = 0; r < _real_atom.size(); ++r) {
+    //
+    const int a = _real_atom[r];
 
-double Model::MonteCarloWithDummy::_vdot(ConstSlice<double> v1, ConstSlice<double> v2) const
-{
-  const char funame [] = "Model::MonteCarloWithDummy::_vdot: ";
+    for(int i = 0; i < 3; ++i) {
+      //
+      _mass_sqrt[a * 3 + i] = std::sqrt(_atom_array[a].mass());
 
-  double dtemp;
-  
-  int    itemp;
+      _trans_con(i, a * 3 + i) = _atom_array[a].mass();
+    }
+  }
 
-  _assert(v1);
+  _read_data();
+}
 
-  _assert(v2);
+void Model::MonteCarloWithDummy::_read_data ()
+{
+  const char funame [] = "Model::MonteCarloWithDummy::_read_data: ";
 
-  double res = 0.;
+  IO::FileStream from(_data_file.c_str());
 
-  for(int r = 0; r < _real_atom.size(); ++r) {
+  if(!from) {
     //
-    const int a = _real_atom[r];
+    std::cerr << funame << "cannot open data file " << _data_file << "\n";
 
-    dtemp = 0.;
+    throw Error::File();
+  }
+
+  const int cart_size = _atom_array.size() * 3;
 
-    itemp = a * 3;
+  const int real_size = _real_atom.size() * 3;
+
+  Lapack::Vector          cart_pos(cart_size);
     
-    for(int i = 0; i < 3; ++i)
+  Lapack::Vector          cart_grad(real_size);
+    
+  Lapack::SymmetricMatrix cart_fc  (real_size);
+
+  cart_pos  = 0.;
+  cart_grad = 0.;
+  cart_fc   = 0.;
+
+  double ener;
+
+  _samp_ener.clear();
+  _samp_pos.clear();
+  _samp_grad.clear();
+  _samp_fc.clear();
+
+  while(from >> ener) {
+    //
+    // read energies, atom cartesian positions, gradients, and force constants
+    // ...
+
+    if(!from) {
       //
-      dtemp += v1[itemp + i] * v2[itemp + i];
+      std::cerr << funame << "data file " << _data_file << " is corrupted\n";
+
+      throw Error::Input();
+    }
 
-    res += dtemp * _atom_array[a].mass();
+    _samp_ener.push_back(ener);
+
+    _samp_pos.insert(_samp_pos.end(), (const double*)cart_pos, (const double*)cart_pos + cart_size);
+
+    _samp_grad.insert(_samp_grad.end(), (const double*)cart_grad, (const double*)cart_grad + real_size);
+
+    _samp_fc.insert(_samp_fc.end(), (const double*)cart_fc, (const double*)cart_fc + real_size * (real_size + 1) / 2);
   }
 
-  return res;
+  if(!_samp_ener.size()) {
+    //
+    std::cerr << funame << "no data\n";
+
+    throw Error::Input();
+  }
+
+  IO::log << IO::log_offset << _samp_ener.size() << " samplings read from " << _data_file << "\n";
 }
 
-double Model::MonteCarloWithDummy::_normalize(Slice<double> a) const
+// the null space basis is orthonormalized with the mass-weighted (real atoms only) metric by the
+// symmetric (Lowdin) transformation: two matrix products and one small diagonalization
+//
+Lapack::Matrix Model::MonteCarloWithDummy::_mass_basis (const Lapack::Matrix& con) const
 {
-  const char funame [] = "Model::MonteCarloWithDummy::_normalize: ";
+  const char funame [] = "Model::MonteCarloWithDummy::_mass_basis: ";
 
   static const double eps = 1.e-20;
   
-  double aa = _vdot(a, a);
+  Lapack::Matrix basis = con.kernel();
+
+  Lapack::Matrix mw_basis = basis;
 
-  if(aa < eps) {
+  for(int i = 0; i < mw_basis.size1(); ++i)
     //
-    std::cerr << funame << "vector has zero length\n";
+    for(int j = 0; j < mw_basis.size2(); ++j)
+      //
+      mw_basis(i, j) *= _mass_sqrt[i];
 
-    throw Error::Range();
-  }
+  Lapack::SymmetricMatrix gram = mw_basis.symmetric_transpose_product(mw_basis);
 
-  aa = std::sqrt(aa);
+  Lapack::Matrix evec;
   
-  for(Slice<double>::iterator it = a.begin(); it != a.end(); ++it)
+  Lapack::Vector eval = gram.eigenvalues(&evec);
+
+  if(eval[0] < eps) {
     //
-    *it /= aa;
+    std::cerr << funame << "basis vector has zero length\n";
 
-  return aa;
-}
-    
-void Model::MonteCarloWithDummy::_orthogonalize (Slice<double> a, ConstSlice<double> b) const
-{
-  double ab = _vdot(a, b);
-  
-  double bb = -vdot(b, b);
+    throw Error::Range();
+  }
 
-  for(int i = 0; i < a.size(); ++i)
-    //
-    a[i] -= b[i] * ab / bb;
-}
-    
-void Model::MonteCarloWithDummy::_orthogonalize (Lapack::Matrix m) const
-{
-  for(int c = 0; c < m.size2(); ++c) {
+  basis = basis * evec;
+
+  for(int j = 0; j < basis.size2(); ++j) {
     //
-    for(int d  = 0; d < c; ++d)
-      //
-      _orthogonalize(m.column(c), m.column(d));
+    const double dtemp = 1. / std::sqrt(eval[j]);
 
-    _normalize(m.column(c));
+    for(int i = 0; i < basis.size1(); ++i)
+      //
+      basis(i, j) *= dtemp;
   }
+
+  return basis;
 }
     
 double Model::MonteCarloWithDummy::_local_weight (double                  ener,           // energy of the sampling 
 						  Lapack::Vector          cart_pos,       // cartesian coordinates of all atoms (real and dummy ones)   
 						  Lapack::Vector          real_cart_grad, // energy gradient in cartesian coordinates
 						  Lapack::SymmetricMatrix real_cart_fc,   // cartesian force constant matrix
-						  double                  temperature     // temprature
+						  double                  temperature,    // temprature
+						  std::ostream&           log             // sampling log
 						  ) const
 {
   const char funame [] = "Model::MonteCarloWithDummy::_local_weight: ";
@@ -15949,8 +18266,6 @@ double Model::MonteCarloWithDummy::_local_weight (double                  ener,
   
   double dtemp;
 
-  IO::Marker funame_marker(funame);
-
   // full cartesian size including dummy atoms
   //
   const int cart_size = _atom_array.size() * 3;
@@ -15963,21 +18278,25 @@ double Model::MonteCarloWithDummy::_local_weight (double                  ener,
   //
   Lapack::Matrix imfd(cart_size, curv_size);
 
-  for(int c = 0; c < cart_size; ++c) {
-    //
-    // first derivative signature
+  imfd = 0.;
+  
+  // internal modes second derivatives over the mode atoms cartesian coordinates
+  //
+  std::vector<double> curv_sd(curv_size * 144);
+
+  for(int i = 0; i < curv_size; ++i) {
     //
-    std::vector<int> sign(1, c);
+    const IntMod& mode = i < _constrain.size() ? (const IntMod&)_constrain[i] : (const IntMod&)_fluxional[i - _constrain.size()];
 
-    itemp = 0;
-    
-    for(int i = 0; i < _constrain.size(); ++i, ++itemp)
-      //
-      imfd(c, itemp) = _constrain[i].evaluate(cart_pos, sign);
+    double fd [12];
+
+    mode.evaluate(cart_pos, fd, &curv_sd[i * 144]);
 
-    for(int i = 0; i < _fluxional.size(); ++i, ++itemp)
+    for(int a = 0; a < mode.atoms().size(); ++a)
       //
-      imfd(c, itemp) = _fluxional[i].evaluate(cart_pos, sign);
+      for(int ai = 0; ai < 3; ++ai)
+	//
+	imfd(mode.atoms()[a] * 3 + ai, i) += fd[a * 3 + ai];
   }
 
   // potential energy gradient over all cartesian coordinates (real and dummy ones)
@@ -16024,26 +18343,26 @@ double Model::MonteCarloWithDummy::_local_weight (double                  ener,
 
   // modified cartesian force constant matrix
   //
-  for(int c = 0; c < cart_size; ++c)
+  for(int i = 0; i < curv_size; ++i) {
     //
-    for(int d = c; d < cart_size; ++d) {
-      //
-      std::vector<int> sign(2);
-
-      sign[0] = c;
-      
-      sign[1] = d;
+    const IntMod& mode = i < _constrain.size() ? (const IntMod&)_constrain[i] : (const IntMod&)_fluxional[i - _constrain.size()];
 
-      itemp = 0;
-      
-      for(int i = 0; i < _constrain.size(); ++i, ++itemp)
+    const int size = mode.atoms().size() * 3;
+    
+    for(int k = 0; k < size; ++k) {
+      //
+      const int c = mode.atoms()[k / 3] * 3 + k % 3;
+	
+      for(int l = 0; l < size; ++l) {
 	//
-	cart_fc(c, d) -= curv_grad[itemp] * _constrain[i].evaluate(cart_pos, sign);
+	const int d = mode.atoms()[l / 3] * 3 + l % 3;
 
-      for(int i = 0; i < _fluxional.size(); ++i, ++itemp)
-	//
-	cart_fc(c, d) -= curv_grad[itemp] * _fluxional[i].evaluate(cart_pos, sign);
+	if(c <= d)
+	  //
+	  cart_fc(c, d) -= curv_grad[i] * curv_sd[i * 144 + k * size + l];
+      }
     }
+  }
   
   /****************** FLUXIONAL MODES MASS FACTOR ************************/
   //
@@ -16111,15 +18430,11 @@ double Model::MonteCarloWithDummy::_local_weight (double                  ener,
 
   // translation
   //
-  for(int i = 0; i < 3; ++i) {
+  for(int i = 0; i < 3; ++i)
     //
-    for(int r = 0; r < _real_atom.size(); ++r) {
+    for(int c = 0; c < cart_size; ++c)
       //
-      const int a = _real_atom[r];
-      
-      dcm(i, a * 3 + i) = _atom_array[a].mass();
-    }
-  }
+      dcm(i, c) = _trans_con(i, c);
   
   // overall rotations
   //
@@ -16149,9 +18464,7 @@ double Model::MonteCarloWithDummy::_local_weight (double                  ener,
 
   // constrained subspace basis
   //
-  Lapack::Matrix basis = dcm.kernel();
-
-  _orthogonalize(basis);
+  Lapack::Matrix basis = _mass_basis(dcm);
 
   // internal (fluxional and non-fluxional) modes frequencies
   //
@@ -16159,11 +18472,9 @@ double Model::MonteCarloWithDummy::_local_weight (double                  ener,
   
   Lapack::SymmetricMatrix in_fc(in_size);
 
-  for(int i = 0; i < in_size; ++i)
-    //
-    for(int j = i; j < in_size; ++j)
-      //
-      in_fc(i, j) = cart_fc * basis.column(i) * basis.column(j);
+  in_fc = 0.;
+
+  in_fc.add_transpose_product(basis, cart_fc * basis);
   
   // eigenvalues
   //
@@ -16185,7 +18496,7 @@ double Model::MonteCarloWithDummy::_local_weight (double                  ener,
 	
 	std::cerr << funame << "WARNING: the system is in the deep tunneling regime, check the log file\n";
 
-	IO::log << IO::log_offset << "WARNING: the system is in the deep tunneling regime" << std::endl;
+	log << IO::log_offset << "WARNING: the system is in the deep tunneling regime" << std::endl;
       }
       else {
 	//
@@ -16214,22 +18525,22 @@ double Model::MonteCarloWithDummy::_local_weight (double                  ener,
   //
   // if(deep_tunnel) {
   //
-  IO::log << IO::log_offset << "internal modes (" << in_size << ") frequencies, 1/cm:";
+  log << IO::log_offset << "internal modes (" << in_size << ") frequencies, 1/cm:";
 
   for(int f = 0; f < in_size; ++f) {
     //
-    IO::log << "   ";
+    log << "   ";
     
     if(eval[f] < 0.) {
       //
-      IO::log << -std::sqrt(-eval[f]) / Phys_const::incm;
+      log << -std::sqrt(-eval[f]) / Phys_const::incm;
     }
     else
       //
-      IO::log << std::sqrt(eval[f]) / Phys_const::incm;
+      log << std::sqrt(eval[f]) / Phys_const::incm;
   }
 
-  IO::log << std::endl;
+  log << std::endl;
 
   // }
   
@@ -16252,19 +18563,15 @@ double Model::MonteCarloWithDummy::_local_weight (double                  ener,
       fcm(i + dcm.size1(), c) = imfd(c, i + _constrain.size());
   }
   
-  basis = fcm.kernel();
-
-  _orthogonalize(basis);
+  basis = _mass_basis(fcm);
   
   // non-fluxional modes force constant matrix
   //
   Lapack::SymmetricMatrix nm_fc(nm_size);
 
-  for(int i = 0; i < nm_size; ++i)
-    //
-    for(int j = i; j < nm_size; ++j)
-      //
-      nm_fc(i, j) = cart_fc * basis.column(i) * basis.column(j);
+  nm_fc = 0.;
+
+  nm_fc.add_transpose_product(basis, cart_fc * basis);
 
   // eigenvalues
   //
@@ -16274,22 +18581,22 @@ double Model::MonteCarloWithDummy::_local_weight (double                  ener,
   //
   // if(deep_tunnel) {
   //
-  IO::log << IO::log_offset << "non-fluxional modes (" << nm_size << ") frequencies, 1/cm:";
+  log << IO::log_offset << "non-fluxional modes (" << nm_size << ") frequencies, 1/cm:";
 
   for(int f = 0; f < nm_size; ++f) {
     //
-    IO::log << "   ";
+    log << "   ";
     
     if(eval[f] < 0.) {
       //
-      IO::log << -std::sqrt(-eval[f]) / Phys_const::incm;
+      log << -std::sqrt(-eval[f]) / Phys_const::incm;
     }
     else
       //
-      IO::log << std::sqrt(eval[f]) / Phys_const::incm;
+      log << std::sqrt(eval[f]) / Phys_const::incm;
   }
 
-  IO::log << std::endl;
+  log << std::endl;
   //
   // }
   
@@ -16322,7 +18629,7 @@ double Model::MonteCarloWithDummy::_local_weight (double                  ener,
   // deep tunneling regime energy output
   if(deep_tunnel) {
     //
-    IO::log << IO::log_offset << "energy (including zero-point energy correction), kcal/mol = "
+    log << IO::log_offset << "energy (including zero-point energy correction), kcal/mol = "
 	    << (ener - ground()) / Phys_const::kcal << std::endl;
   }
   
@@ -16364,57 +18671,102 @@ double Model::MonteCarloWithDummy::weight (double temperature) const
   int    itemp;
   
   double dtemp;
-  
-  std::ifstream from(_data_file.c_str());
 
-  if(!from) {
+  IO::Marker funame_marker(funame);
+
+  const int count = _samp_ener.size();
+
+  const int cart_size = _atom_array.size() * 3;
+
+  const int real_size = _real_atom.size() * 3;
+
+  const int   fc_size = real_size * (real_size + 1) / 2;
+
+  // samplings per log flush
+  //
+  static const int block_size = 1024;
+
+  // the samplings are evaluated concurrently block by block, the sampling logs are buffered
+  // and flushed in the sampling order
+  //
+  std::vector<double> samp_weight(count);
+
+  for(int start = 0; start < count; start += block_size) {
     //
-    std::cerr << funame << "cannot open data file " << _data_file << "\n";
+    const int end = start + block_size < count ? start + block_size : count;
 
-    throw Error::File();
-  }
+    std::vector<std::string> samp_log(end - start);
 
-  double res = 0.;
+    std::exception_ptr error;
 
-  Lapack::Vector          cart_pos(_atom_array.size() * 3);
-    
-  Lapack::Vector          cart_grad(_real_atom.size() * 3);
-    
-  Lapack::SymmetricMatrix cart_fc  (_real_atom.size() * 3);
+#pragma omp parallel for default(shared) schedule(dynamic)
+
+    for(int samp = start; samp < end; ++samp) {
+      //
+      std::ostringstream log;
+
+      try {
+	//
+	Lapack::Vector          cart_pos(cart_size);
+	Lapack::Vector          cart_grad(real_size);
+	Lapack::SymmetricMatrix cart_fc(real_size);
+
+	std::copy(&_samp_pos[(size_t)samp * cart_size], &_samp_pos[(size_t)samp * cart_size] + cart_size, (double*)cart_pos);
+
+	std::copy(&_samp_grad[(size_t)samp * real_size], &_samp_grad[(size_t)samp * real_size] + real_size, (double*)cart_grad);
+
+	std::copy(&_samp_fc[(size_t)samp * fc_size], &_samp_fc[(size_t)samp * fc_size] + fc_size, (double*)cart_fc);
+
+	samp_weight[samp] = _local_weight(_samp_ener[samp], cart_pos, cart_grad, cart_fc, temperature, log);
+      }
+      catch(...) {
+	//
+#pragma omp critical(monte_carlo_dummy_error)
+
+	if(!error)
+	  //
+	  error = std::current_exception();
+      }
+
+      samp_log[samp - start] = log.str();
+    }
+
+    for(int i = 0; i < samp_log.size(); ++i)
+      //
+      IO::log << samp_log[i];
+
+    if(error)
+      //
+      std::rethrow_exception(error);
+  }
 
-  double ener;
+  double res = 0.;
 
-  int count = 0;
+  for(int samp = 0; samp < count; ++samp)
+    //
+    res += samp_weight[samp];
 
   std::vector<std::pair<double, double> > flimits(_fluxional.size());
 
   std::vector<double> con_rms(_constrain.size());
-  
-  while(from >> ener) {
-    //
-    // read energies, atom cartesian positions, gradients, and force constants
-    // ...
 
-    if(!from) {
+  if(first_time) {
+    //
+    for(int samp = 0; samp < count; ++samp) {
       //
-      std::cerr << funame << "data file " << _data_file << " is corrupted\n";
+      Lapack::Vector cart_pos(cart_size);
 
-      throw Error::Input();
-    }
-    
-    res += _local_weight(ener, cart_pos, cart_grad, cart_fc, temperature);
+      std::copy(&_samp_pos[(size_t)samp * cart_size], &_samp_pos[(size_t)samp * cart_size] + cart_size, (double*)cart_pos);
 
-    if(first_time) {
-      //
       for(int f = 0; f < _fluxional.size(); ++f) {
 	//
 	dtemp = _fluxional[f].evaluate(cart_pos);
 
-	if(!count || dtemp < flimits[f].first)
+	if(!samp || dtemp < flimits[f].first)
 	  //
 	  flimits[f].first = dtemp;
 
-	if(!count || dtemp > flimits[f].second)
+	if(!samp || dtemp > flimits[f].second)
 	  //
 	  flimits[f].second = dtemp;
       }
@@ -16426,15 +18778,6 @@ double Model::MonteCarloWithDummy::weight (double temperature) const
 	con_rms[c] += dtemp * dtemp;
       }
     }
-    
-    ++count;
-  }
-
-  if(!count) {
-    //
-    std::cerr << funame << "no data\n";
-
-    throw Error::Input();
   }
 
   if(first_time) {
@@ -16491,7 +18834,7 @@ double Model::MonteCarloWithDummy::weight (double temperature) const
 /************************* RIGID ROTOR HARMONIC OSCILLATOR MODEL **************************/
 
 Model::RRHO::RRHO(IO::KeyBufferStream& from, const std::string& n, int m) 
-  :Species(from, n, m),  _emax(-1.), _sym_num(1.)
+  :Species(from, n, m),  _emax(-1.), _grid_max(0.), _isinit(0), _sym_num(1.)
 {
   const char funame [] = "Model::RRHO::RRHO: ";
 
@@ -17060,183 +19403,35 @@ Model::RRHO::RRHO(IO::KeyBufferStream& from, const std::string& n, int m)
     _ground -= _tunnel->cutoff();
   
 
-  // interpolating states density/number
+  // states density/number grid range and the hindered rotors levels, the grid itself
+  // is built on the first query
   //
   if(mode() != NOSTATES) {
     //
-    IO::Marker interpol_marker("interpolating states number/density");
-
     if(_emax > 0.) {
       //
-      dtemp = _emax;
+      _grid_max = _emax;
     }
     else
       //
-      dtemp = energy_limit() - ground();
-    
-    itemp = (int)std::ceil(dtemp / ener_quant);
-
-    // energy grid
-    //
-    Array<double> ener_grid(itemp);
-    
-    dtemp = 0.;
-    
-    for(int i = 0; i < ener_grid.size(); ++i, dtemp += ener_quant)
-      //
-      ener_grid[i] = dtemp;
-    
-    Array<double> stat_grid(itemp);
+      _grid_max = energy_limit() - ground();
 
-    // core states
-    //
-    if(_core) {
-      //
-      IO::Marker core_marker("core state contribution", IO::Marker::ONE_LINE);
+    _ener_quant = ener_quant;
 
-      stat_grid[0] = 0.;
-      
-      dtemp = ener_quant;
-      
-      for(int i = 1; i < ener_grid.size(); ++i, dtemp += ener_quant)
-	//
-	stat_grid[i] = _core->states(dtemp);
-    }
-    else {
+    _extra_step = extra_step;
+    
+    for(int f = 0; f < _frequency.size(); ++f)
       //
-      if(mode() == NUMBER) {
-	//
-	stat_grid = 1./ _sym_num;
-      }
-      else {
+      if(_frequency[f] < 0.) {
 	//
-	stat_grid = 0.;
-	stat_grid[0] = 1. / ener_quant / _sym_num;
-      }
-    }
-
-    Array<double> new_stat_grid(ener_grid.size());
-
-    // electronic states contribution
-    //
-    if(_elevel.size() != 1) {
-      //
-      IO::Marker elev_marker("electronic states contribution", IO::Marker::ONE_LINE);
+	std::cerr << funame << "negative frequency\n";
 
-      new_stat_grid = 0.;
-      for(int l = 0; l < _elevel.size(); ++l) {
-	itemp = (int)round(_elevel[l] / ener_quant);
-	for(int i = itemp; i < ener_grid.size(); ++i)
-	  new_stat_grid[i] += stat_grid[i - itemp] * double(_edegen[l]);
+	throw Error::Range();
       }
-      stat_grid = new_stat_grid;
-    }
-    //
-    else if(_edegen[0] != 1) {
-      //
-      IO::Marker elev_marker("electronic states contribution", IO::Marker::ONE_LINE);
-
-      dtemp = double(_edegen[0]);
-      for(int i = 1; i < ener_grid.size(); ++i)
-	stat_grid[i] *= dtemp;
-    }
-
-    // vibrational frequency iteration
-    //
-    if(_frequency.size()) {
-      //
-      IO::Marker vib_marker("vibrational modes contribution", IO::Marker::ONE_LINE);
-
-      for(int f = 0; f < _frequency.size(); ++f)
-	for(int d = 0; d < _fdegen[f]; ++d) {
-	  itemp = (int)round(_frequency[f] / ener_quant);
-	  if(itemp < 0) {
-	    std::cerr << funame << "negative frequency\n";
-	    throw Error::Range();
-	  }
-	  for(int e = itemp; e < ener_grid.size(); ++e)
-	    stat_grid[e] += stat_grid[e - itemp];
-	}
-    }
-  
-
-    // hindered rotor contribution
-    //
-    if(_rotor.size()) {
-      //
-      IO::Marker rotor_marker("hindered rotors contribution");
-      
-      for(int r = 0; r < _rotor.size(); ++r) {// 1D rotor cycle
-	//
-	_rotor[r]->set(energy_limit() - ground());
-	
-	_rotor[r]->convolute(stat_grid, ener_quant);
-      }// 1D rotor cycle
-    }
-
-
-    // tunneling
-    if(_tunnel) {
-      IO::Marker tunnel_marker("tunneling contribution", IO::Marker::ONE_LINE);
-
-      // convolute the number of states with the tunneling density
-      _tunnel->convolute(stat_grid, ener_quant);
-    }
-
-    // occupation numbers for radiative transitions
     
-    // ONLY WORK WITH NO DEGENERACIES
-    //
-    if(_osc_int.size()) {
-      _occ_num.resize(_osc_int.size());
-      _occ_num_der.resize(_osc_int.size());
-      for(int f = 0; f < _frequency.size(); ++f) {
-	new_stat_grid = stat_grid;
-	itemp = (int)round(_frequency[f] / ener_quant);
-
-	for(int e = itemp; e < ener_grid.size(); ++e)
-	  new_stat_grid[e] += new_stat_grid[e - itemp];
-
-	for(int e = itemp; e < ener_grid.size(); ++e)
-	  if(stat_grid[e] != 0.) {
-	    new_stat_grid[e] /= stat_grid[e];
-	    new_stat_grid[e] -= 1.;
-	  }
-	new_stat_grid[itemp] = 0.;
-	
-	_occ_num[f].init(&ener_grid[itemp], &new_stat_grid[itemp], ener_grid.size() - itemp);
-	dtemp = _occ_num[f].arg_max() * extra_step;
-	_occ_num_der[f] = (_occ_num[f].fun_max() - _occ_num[f](_occ_num[f].arg_max() - dtemp)) / dtemp;
-      }
-    }
-
-    // interpolation
-    _states.init(ener_grid, stat_grid, ener_grid.size());
-    dtemp = _states.fun_max() / _states(_states.arg_max() * (1. - extra_step));
-    _nmax = std::log(dtemp) / std::log(1. / (1. - extra_step));
-
-    IO::log << IO::log_offset << "effective power exponent at " 
-	    << _states.arg_max() / Phys_const::kcal << " kcal/mol = "<< _nmax << "\n";
-
-    // checking the number of states
-    /*
-      double tt = Phys_const::kelv * 2000.;
-      double ww = 0.;
-      for(int i = 1; i < ener_grid.size(); ++i) { 
-      dtemp = ener_grid[i] / tt;
-      if(dtemp > 100.)
-      break;
-      ww += stat_grid[i] * std::exp(-dtemp);      
-      }
-      ww *= ener_quant;
-      if(mode() == NUMBER)
-      ww /= tt;
-      IO::log << IO::log_offset << "statistical weight at 2000K: "
-      << std::setw(13) << ww 
-      << std::setw(13) << weight(tt)
-      << "\n";
-    */
-
+    for(int r = 0; r < _rotor.size(); ++r)
+      //
+      _rotor[r]->set(energy_limit() - ground());
   }// interpolating states number/density
 
   _print();
@@ -17262,6 +19457,8 @@ void Model::RRHO::_init_graphex (std::istream& from)
   Key      keep_key("KeepPermutedGraphs"              );
   Key      scut_key("FourierSumCutoff"                );
   Key      redt_key("ReductionThreshold"              );
+  Key      conv_key("ConvergenceThreshold"            );
+  Key      ptol_key("PotentialScreeningTolerance[1/cm]");
 
   // potential expansion
   //
@@ -17402,50 +19599,304 @@ void Model::RRHO::_init_graphex (std::istream& from)
 	err_out << funame << token << ": out of range: "<< itemp;
       }
 
-      Graph::FreqGraph::four_cut = itemp;
+      Graph::FreqGraph::four_cut = itemp;
+
+      std::getline(from, comment);
+    }	
+    // bond order relative contribution below which the expansion is stopped
+    //
+    else if(conv_key == token) {
+      //
+      if(!(from >> dtemp)) {
+	//
+	ErrOut err_out;
+
+	err_out << funame << token << ": corrupted";
+      }
+
+      if(dtemp <= 0.) {
+	//
+	ErrOut err_out;
+
+	err_out << funame << token << ": out of range: "<< dtemp;
+      }
+
+      Graph::Expansion::conv_thresh = dtemp;
+
+      std::getline(from, comment);
+    }	
+    // potential expansion screening tolerance
+    //
+    else if(ptol_key == token) {
+      //
+      if(!(from >> dtemp)) {
+	//
+	ErrOut err_out;
+
+	err_out << funame << token << ": corrupted";
+      }
+
+      if(dtemp <= 0.) {
+	//
+	ErrOut err_out;
+
+	err_out << funame << token << ": out of range: "<< dtemp;
+      }
+
+      Graph::Expansion::potex_tol = dtemp * Phys_const::incm;
+
+      std::getline(from, comment);
+    }	
+    // unknown keyword
+    //
+    else if(IO::skip_comment(token, from)) {
+      // 
+      ErrOut err_out;
+
+      err_out << funame << "unknown keyword: " << token << "\n" << Key::show_all() << "\n";
+    }
+  }
+
+  if(!potex.size()) {
+    //
+    ErrOut err_out;
+
+    err_out << funame << "potential expansion not initialized\n";
+  }
+  
+  itemp = 0;
+  //
+  for(potex_t::const_iterator pit = potex.begin(); pit != potex.end(); ++pit)
+    //
+    if(pit->first.size() > itemp)
+      //
+      itemp = pit->first.size();
+
+  Graph::potex_max = itemp;
+
+  Graph::init();
+
+  _graphex.init(_frequency, potex);
+}
+
+Model::RRHO::~RRHO ()
+{
+  //std::cout << "Model::RRHO destroyed\n";
+}
+
+// states density/number on the grid, built once, on the first query
+//
+void Model::RRHO::_init_states () const
+{
+  const char funame [] = "Model::RRHO::_init_states: ";
+
+  int isinit;
+
+#pragma omp atomic read
+
+  isinit = _isinit;
+
+  if(isinit || mode() == NOSTATES)
+    //
+    return;
+
+  std::exception_ptr eptr;
+  
+#pragma omp critical(rrho_init_states)
+  
+  if(!_isinit) {
+    //
+    try {
+      //
+      _build_states();
+
+#pragma omp atomic write
+
+      _isinit = 1;
+    }
+    catch(...) {
+      //
+      eptr = std::current_exception();
+    }
+  }
+
+  if(eptr)
+    //
+    std::rethrow_exception(eptr);
+}
+
+void Model::RRHO::_build_states () const
+{
+  const char funame [] = "Model::RRHO::_build_states: ";
+
+  int    itemp;
+  double dtemp;
+
+  const double ener_quant = _ener_quant;
+
+  const double extra_step = _extra_step;
+  
+  const std::string marker_name = name() + ": interpolating states number/density";
+  
+  IO::Marker interpol_marker(marker_name.c_str());
+
+  itemp = (int)std::ceil(_grid_max / ener_quant);
+
+  // energy grid
+  //
+  Array<double> ener_grid(itemp);
+
+  dtemp = 0.;
+
+  for(int i = 0; i < ener_grid.size(); ++i, dtemp += ener_quant)
+    //
+    ener_grid[i] = dtemp;
+
+  Array<double> stat_grid(itemp);
+
+  // core states
+  //
+  if(_core) {
+    //
+    IO::Marker core_marker("core state contribution", IO::Marker::ONE_LINE);
+
+    stat_grid[0] = 0.;
+
+    if(ener_grid.size() > 1)
+      //
+      _core->states(&ener_grid[1], ener_grid.size() - 1, &stat_grid[1]);
+  }
+  else {
+    //
+    if(mode() == NUMBER) {
+      //
+      stat_grid = 1./ _sym_num;
+    }
+    else {
+      //
+      stat_grid = 0.;
+      stat_grid[0] = 1. / ener_quant / _sym_num;
+    }
+  }
+
+  Array<double> new_stat_grid(ener_grid.size());
 
-      std::getline(from, comment);
-    }	
-    // unknown keyword
+  // electronic states contribution
+  //
+  if(_elevel.size() != 1) {
     //
-    else if(IO::skip_comment(token, from)) {
-      // 
-      ErrOut err_out;
+    IO::Marker elev_marker("electronic states contribution", IO::Marker::ONE_LINE);
 
-      err_out << funame << "unknown keyword: " << token << "\n" << Key::show_all() << "\n";
+    new_stat_grid = 0.;
+    for(int l = 0; l < _elevel.size(); ++l) {
+      itemp = (int)round(_elevel[l] / ener_quant);
+      for(int i = itemp; i < ener_grid.size(); ++i)
+	new_stat_grid[i] += stat_grid[i - itemp] * double(_edegen[l]);
     }
+    stat_grid = new_stat_grid;
+  }
+  //
+  else if(_edegen[0] != 1) {
+    //
+    IO::Marker elev_marker("electronic states contribution", IO::Marker::ONE_LINE);
+
+    dtemp = double(_edegen[0]);
+    for(int i = 1; i < ener_grid.size(); ++i)
+      stat_grid[i] *= dtemp;
   }
 
-  if(!potex.size()) {
+  // vibrational frequency iteration
+  //
+  if(_frequency.size()) {
     //
-    ErrOut err_out;
+    IO::Marker vib_marker("vibrational modes contribution", IO::Marker::ONE_LINE);
 
-    err_out << funame << "potential expansion not initialized\n";
+    for(int f = 0; f < _frequency.size(); ++f) {
+      itemp = (int)round(_frequency[f] / ener_quant);
+      Math::state_count(stat_grid, ener_grid.size(), itemp, _fdegen[f]);
+    }
   }
-  
-  itemp = 0;
+
+
+  // hindered rotor contribution
   //
-  for(potex_t::const_iterator pit = potex.begin(); pit != potex.end(); ++pit)
+  if(_rotor.size()) {
     //
-    if(pit->first.size() > itemp)
+    IO::Marker rotor_marker("hindered rotors contribution");
+
+    for(int r = 0; r < _rotor.size(); ++r)
       //
-      itemp = pit->first.size();
+      _rotor[r]->convolute(stat_grid, ener_quant);
+  }
 
-  Graph::potex_max = itemp;
 
-  Graph::init();
+  // tunneling
+  if(_tunnel) {
+    IO::Marker tunnel_marker("tunneling contribution", IO::Marker::ONE_LINE);
 
-  _graphex.init(_frequency, potex);
-}
+    // convolute the number of states with the tunneling density
+    _tunnel->convolute(stat_grid, ener_quant);
+  }
 
-Model::RRHO::~RRHO ()
-{
-  //std::cout << "Model::RRHO destroyed\n";
+  // occupation numbers for radiative transitions
+
+  // ONLY WORK WITH NO DEGENERACIES
+  //
+  if(_osc_int.size()) {
+    _occ_num.resize(_osc_int.size());
+    _occ_num_der.resize(_osc_int.size());
+    for(int f = 0; f < _frequency.size(); ++f) {
+      new_stat_grid = stat_grid;
+      itemp = (int)round(_frequency[f] / ener_quant);
+
+      Math::state_count(new_stat_grid, ener_grid.size(), itemp);
+
+      for(int e = itemp; e < ener_grid.size(); ++e)
+	if(stat_grid[e] != 0.) {
+	  new_stat_grid[e] /= stat_grid[e];
+	  new_stat_grid[e] -= 1.;
+	}
+      new_stat_grid[itemp] = 0.;
+
+      _occ_num[f].init(&ener_grid[itemp], &new_stat_grid[itemp], ener_grid.size() - itemp);
+      dtemp = _occ_num[f].arg_max() * extra_step;
+      _occ_num_der[f] = (_occ_num[f].fun_max() - _occ_num[f](_occ_num[f].arg_max() - dtemp)) / dtemp;
+    }
+  }
+
+  // interpolation
+  _states.init(ener_grid, stat_grid, ener_grid.size());
+  dtemp = _states.fun_max() / _states(_states.arg_max() * (1. - extra_step));
+  _nmax = std::log(dtemp) / std::log(1. / (1. - extra_step));
+
+  IO::log << IO::log_offset << "effective power exponent at " 
+	  << _states.arg_max() / Phys_const::kcal << " kcal/mol = "<< _nmax << "\n";
+
+  // checking the number of states
+  /*
+    double tt = Phys_const::kelv * 2000.;
+    double ww = 0.;
+    for(int i = 1; i < ener_grid.size(); ++i) { 
+    dtemp = ener_grid[i] / tt;
+    if(dtemp > 100.)
+    break;
+    ww += stat_grid[i] * std::exp(-dtemp);      
+    }
+    ww *= ener_quant;
+    if(mode() == NUMBER)
+    ww /= tt;
+    IO::log << IO::log_offset << "statistical weight at 2000K: "
+    << std::setw(13) << ww 
+    << std::setw(13) << weight(tt)
+    << "\n";
+  */
 }
 
 double Model::RRHO::states (double ener) const
 {
   const char funame [] = "Model::RRHO::states: ";
+
+  _init_states();
   
   ener -= ground();
 
@@ -17461,7 +19912,89 @@ double Model::RRHO::states (double ener) const
   return _states(ener);
 }
 
+// the energies inside the interpolation range are evaluated in one spline pass
+//
+void Model::RRHO::states (const double* ener, int size, double* res) const
+{
+  _init_states();
+
+  std::vector<double> x;
+  std::vector<int>    index;
+
+  for(int i = 0; i < size; ++i) {
+    const double e = ener[i] - ground();
+
+    if(e > 0. && e < _states.arg_max()) {
+      x.push_back(e);
+      index.push_back(i);
+    }
+    else
+      res[i] = RRHO::states(ener[i]);
+  }
+
+  if(!x.size())
+    return;
+
+  std::vector<double> y(x.size());
+  _states.evaluate(&x[0], x.size(), &y[0]);
+
+  for(int k = 0; k < index.size(); ++k)
+    res[index[k]] = y[k];
+}
+
 double Model::RRHO::weight (double temperature) const
+{
+  return _weight(temperature, _core ? _core->weight(temperature) : 1.);
+}
+
+// the core weights, which may need a pass over the core grid, are evaluated for all temperatures at once
+//
+void Model::RRHO::weight (const double* temperature, int size, double* res) const
+{
+  std::vector<double> core_weight(size, 1.);
+
+  if(_core && size)
+    _core->weight(temperature, size, &core_weight[0]);
+
+  for(int t = 0; t < size; ++t)
+    res[t] = _weight(temperature[t], core_weight[t]);
+}
+
+// the closed form factors by the differences, the core moments, which may need a pass
+// over the core grid, from the core
+//
+void Model::RRHO::thermal_moments (const double* temperature, int size, double rel_incr,
+				   double* lw, double* d1, double* d2) const
+{
+  const char funame [] = "Model::RRHO::thermal_moments: ";
+
+  if(!size)
+    return;
+
+  const std::vector<double> tt = difference_grid(temperature, size, rel_incr);
+
+  std::vector<double> ww(tt.size());
+
+  for(int i = 0; i < tt.size(); ++i)
+    ww[i] = _weight(tt[i], 1.);
+
+  difference_moments(funame, temperature, size, rel_incr, &ww[0], lw, d1, d2);
+
+  if(!_core)
+    return;
+
+  std::vector<double> cl(size), c1(size), c2(size);
+
+  _core->thermal_moments(temperature, size, rel_incr, &cl[0], &c1[0], &c2[0]);
+
+  for(int t = 0; t < size; ++t) {
+    lw[t] += cl[t];
+    d1[t] += c1[t];
+    d2[t] += c2[t];
+  }
+}
+
+double Model::RRHO::_weight (double temperature, double core_weight) const
 {
   double dtemp;
   int    itemp;
@@ -17473,7 +20006,7 @@ double Model::RRHO::weight (double temperature) const
 
   // core contribution
   if(_core)
-    res *= _core->weight(temperature);
+    res *= core_weight;
   else
     res /= _sym_num;
 
@@ -17666,6 +20199,8 @@ double Model::RRHO::infrared_intensity (double ener, int f) const
   if(_osc_int[f] == 0.)
     return 0.;
 
+  _init_states();
+
   ener -= ground();
 
   if(ener <= _occ_num[f].arg_min())
@@ -17733,6 +20268,43 @@ Model::UnionSpecies::UnionSpecies (IO::KeyBufferStream& from, const std::string&
 	_osc_spec_index.push_back(w);
     }
 
+  // merged states on the grid starting one step above the highest component ground, where
+  // all the components are smooth, up to the energy limit
+  if(mode() != NOSTATES && is_energy_limit()) {
+    //
+    const double step = Phys_const::incm;
+
+    double emin = _ground;
+    for(_Cit w = _species.begin(); w != _species.end(); ++w)
+      if((*w)->ground() > emin)
+	emin = (*w)->ground();
+
+    emin += step;
+
+    const int size = (int)std::ceil((energy_limit() - emin) / step) + 1;
+
+    if(size > 3) {
+      //
+      IO::Marker merge_marker("merging the components states", IO::Marker::ONE_LINE);
+
+      std::vector<double> ener(size), x(size), y(size), spec_states(size);
+
+      for(int i = 0; i < size; ++i) {
+	x[i]    = emin - _ground + (double)i * step;
+	ener[i] = _ground + x[i];
+	y[i]    = 0.;
+      }
+
+      for(_Cit w = _species.begin(); w != _species.end(); ++w) {
+	(*w)->states(&ener[0], size, &spec_states[0]);
+	for(int i = 0; i < size; ++i)
+	  y[i] += spec_states[i];
+      }
+
+      _states.init(&x[0], &y[0], size);
+    }
+  }
+
   _print();
 }// Union Species
 
@@ -17741,7 +20313,7 @@ Model::UnionSpecies::~UnionSpecies ()
   //std::cout << "Model::UnionSpecies destroyed\n";
 }
 
-double Model::UnionSpecies::states (double energy) const 
+double Model::UnionSpecies::_direct_states (double energy) const 
 {
   if(energy <= _ground)
     return 0.;
@@ -17752,6 +20324,45 @@ double Model::UnionSpecies::states (double energy) const
   return res;
 }
 
+double Model::UnionSpecies::states (double energy) const 
+{
+  const double e = energy - _ground;
+
+  if(_states.size() && e >= _states.arg_min() && e <= _states.arg_max())
+    //
+    return _states(e);
+
+  return _direct_states(energy);
+}
+
+// the energies inside the merged grid are evaluated in one spline pass
+//
+void Model::UnionSpecies::states (const double* ener, int size, double* res) const
+{
+  std::vector<double> x;
+  std::vector<int>    index;
+
+  for(int i = 0; i < size; ++i) {
+    const double e = ener[i] - _ground;
+
+    if(_states.size() && e >= _states.arg_min() && e <= _states.arg_max()) {
+      x.push_back(e);
+      index.push_back(i);
+    }
+    else
+      res[i] = _direct_states(ener[i]);
+  }
+
+  if(!x.size())
+    return;
+
+  std::vector<double> y(x.size());
+  _states.evaluate(&x[0], x.size(), &y[0]);
+
+  for(int k = 0; k < index.size(); ++k)
+    res[index[k]] = y[k];
+}
+
 double Model::UnionSpecies::weight (double temperature) const
 {
   double res = 0.;
@@ -17760,6 +20371,22 @@ double Model::UnionSpecies::weight (double temperature) const
   return res;
 }
 
+void Model::UnionSpecies::weight (const double* temperature, int size, double* res) const
+{
+  std::vector<double> member(size);
+
+  for(int t = 0; t < size; ++t)
+    res[t] = 0.;
+
+  for(_Cit w = _species.begin(); w != _species.end(); ++w) {
+    if(size)
+      (*w)->weight(temperature, size, &member[0]);
+
+    for(int t = 0; t < size; ++t)
+      res[t] += member[t] * std::exp((ground() - (*w)->ground()) / temperature[t]);
+  }
+}
+
 void Model::UnionSpecies::shift_ground (double e)
 {
   _ground += e;
@@ -17812,7 +20439,7 @@ int Model::UnionSpecies::oscillator_size () const
  ***********************************************************************************************/
 
 Model::VarBarrier::VarBarrier(IO::KeyBufferStream& from, const std::string& n) 
-  : Species(n, NUMBER), _tunnel(0), _ener_quant(Phys_const::incm), _emax(-1.), _tts_method(STATISTICAL)
+  : Species(n, NUMBER), _tunnel(0), _ener_quant(Phys_const::incm), _emax(-1.), _tts_method(STATISTICAL), _lazy(false)
 {
   const char funame [] = "Model::VarBarrier::VarBarrier: ";
 
@@ -17827,6 +20454,7 @@ Model::VarBarrier::VarBarrier(IO::KeyBufferStream& from, const std::string& n)
   Key  rrho_key("RRHO"                            );
   Key outer_key("OuterRRHO"                       );
   Key   tts_key("2TSMethod"                       );
+  Key  lazy_key("LazyMinimum"                     );
   Key  tmin_key("OutputTemperatureMin[K]"         );
   Key  tmax_key("OutputTemperatureMax[K]"         );
   Key tstep_key("OutputTemperatureStep[K]"        );
@@ -17887,6 +20515,11 @@ Model::VarBarrier::VarBarrier(IO::KeyBufferStream& from, const std::string& n)
 	throw Error::Input();
       }
     }
+    // skip the RRHOs which are never the minimum
+    else if(lazy_key == token) {
+      std::getline(from, comment);
+      _lazy = true;
+    }
     //  energy step
     else if(estep_key == token) {
       if(!(from >> _ener_quant)) {
@@ -18015,6 +20648,9 @@ Model::VarBarrier::VarBarrier(IO::KeyBufferStream& from, const std::string& n)
     if(!v || _rrho[v]->ground() > _ground)
       _ground = _rrho[v]->ground();
 
+  // number of the RRHOs skipped in the lazy mode
+  int lazy_skip = 0;
+
   // interpolating states density/number
   {
     IO::Marker interpol_marker("interpolating states number/density", IO::Marker::ONE_LINE);
@@ -18031,15 +20667,85 @@ Model::VarBarrier::VarBarrier(IO::KeyBufferStream& from, const std::string& n)
     _stat_grid[0] = 0.;
 
     double ener = _ener_quant;
-    for(int i = 1; i < ener_grid.size(); ++i, ener += _ener_quant) {
-      // energy grid
+    for(int i = 1; i < ener_grid.size(); ++i, ener += _ener_quant)
+      //
       ener_grid[i] = ener;
-      // density / number of states
-      for(int v = 0; v < _rrho.size(); ++v) {
-	dtemp = _rrho[v]->states(ener + _ground);
-	if(!v || dtemp < _stat_grid[i])
-	  _stat_grid[i] = dtemp;
+
+    // grid cells: in the lazy mode the RRHO is evaluated only in the cells where it may be the minimum
+    //
+    const int cell_size = _lazy ? 64 : ener_grid.size();
+    const int cell_num  = (ener_grid.size() + cell_size - 2) / cell_size;
+
+    // candidate RRHOs for each cell
+    std::vector<std::vector<int> > cell_rrho(cell_num);
+
+    if(_lazy) {
+      //
+      // the number of states is monotonic: the values at the cell ends bound it inside the cell
+      //
+      Lapack::Matrix lower(_rrho.size(), cell_num), upper(_rrho.size(), cell_num);
+
+#pragma omp parallel for default(shared) schedule(dynamic)
+
+      for(int v = 0; v < _rrho.size(); ++v)
+	for(int c = 0; c < cell_num; ++c) {
+	  const int cmax = 1 + (c + 1) * cell_size < ener_grid.size() ? 1 + (c + 1) * cell_size : ener_grid.size();
+	  lower(v, c) = _rrho[v]->states(ener_grid[1 + c * cell_size] + _ground);
+	  upper(v, c) = _rrho[v]->states(ener_grid[cmax - 1] + _ground);
+	}
+
+      // relative tolerance for the interpolation nonmonotonicity
+      static const double lazy_tol = 1.e-3;
+
+      std::set<int> used;
+      for(int c = 0; c < cell_num; ++c) {
+	double umin = upper(0, c);
+	for(int v = 1; v < _rrho.size(); ++v)
+	  if(upper(v, c) < umin)
+	    umin = upper(v, c);
+
+	for(int v = 0; v < _rrho.size(); ++v)
+	  if(lower(v, c) <= umin * (1. + lazy_tol)) {
+	    cell_rrho[c].push_back(v);
+	    used.insert(v);
+	  }
       }
+
+      lazy_skip = _rrho.size() - used.size();
+    }
+    else
+      for(int c = 0; c < cell_num; ++c)
+	for(int v = 0; v < _rrho.size(); ++v)
+	  cell_rrho[c].push_back(v);
+
+    // RRHOs states on the grid, in parallel over the RRHOs
+    //
+    std::vector<Array<double> > rrho_grid(_rrho.size());
+
+#pragma omp parallel for default(shared) schedule(dynamic)
+
+    for(int v = 0; v < _rrho.size(); ++v) {
+      rrho_grid[v].resize(ener_grid.size());
+
+      for(int c = 0; c < cell_num; ++c)
+	if(std::find(cell_rrho[c].begin(), cell_rrho[c].end(), v) != cell_rrho[c].end()) {
+	  const int cmax = 1 + (c + 1) * cell_size < ener_grid.size() ? 1 + (c + 1) * cell_size : ener_grid.size();
+	  for(int i = 1 + c * cell_size; i < cmax; ++i)
+	    rrho_grid[v][i] = _rrho[v]->states(ener_grid[i] + _ground);
+	}
+    }
+
+    // minimum over the RRHOs, in parallel over the energy grid
+    //
+#pragma omp parallel for default(shared) schedule(static)
+
+    for(int i = 1; i < ener_grid.size(); ++i) {
+      const std::vector<int>& cand = cell_rrho[(i - 1) / cell_size];
+      double smin = rrho_grid[cand[0]][i];
+      for(int n = 1; n < cand.size(); ++n)
+	if(rrho_grid[cand[n]][i] < smin)
+	  smin = rrho_grid[cand[n]][i];
+      _stat_grid[i] = smin;
     }
 
     _real_ground = _ground;
@@ -18111,6 +20817,10 @@ Model::VarBarrier::VarBarrier(IO::KeyBufferStream& from, const std::string& n)
     _nmax = std::log(dtemp) / std::log(1. / (1. - extra_step));
   }  
 
+  if(_lazy)
+    IO::log << IO::log_offset << "lazy minimum: " << lazy_skip << " of " << _rrho.size()
+	    << " RRHOs are never the minimum\n";
+
   IO::log << IO::log_offset << "effective power exponent at " 
 	  << _states.arg_max() / Phys_const::kcal << " kcal/mol = " << _nmax << "\n";
 
@@ -18170,7 +20880,44 @@ double Model::VarBarrier::states (double ener) const
   return _states(ener);
 }
 
+void Model::VarBarrier::states (const double* ener, int size, double* res) const
+{
+  std::vector<double> x;
+  std::vector<int>    index;
+
+  for(int i = 0; i < size; ++i) {
+    const double e = ener[i] - _ground;
+
+    if(e > 0. && e < _states.arg_max()) {
+      x.push_back(e);
+      index.push_back(i);
+    }
+    else
+      res[i] = VarBarrier::states(ener[i]);
+  }
+
+  if(!x.size())
+    return;
+
+  std::vector<double> y(x.size());
+  _states.evaluate(&x[0], x.size(), &y[0]);
+
+  for(int k = 0; k < index.size(); ++k)
+    res[index[k]] = y[k];
+}
+
 double Model::VarBarrier::weight (double temperature) const
+{
+  double res;
+
+  weight(&temperature, 1, &res);
+
+  return res;
+}
+
+// one pass over the states grid for all temperatures
+//
+void Model::VarBarrier::weight (const double* temperature, int size, double* res) const
 {
   const char funame [] = "Model::VarBarrier::weight: ";
 
@@ -18178,24 +20925,33 @@ double Model::VarBarrier::weight (double temperature) const
 
   double dtemp;
   
-  double res = 0.;
+  for(int t = 0; t < size; ++t)
+    res[t] = 0.;
+
   double ener = _ener_quant;
-  for(int i = 1; i < _stat_grid.size(); ++i, ener += _ener_quant)
-    res += _stat_grid[i] / std::exp(ener / temperature);
-  res *= _ener_quant / temperature;
+  for(int i = 1; i < _stat_grid.size(); ++i, ener += _ener_quant) {
+    dtemp = _stat_grid[i];
 
-  dtemp = _states.arg_max() / temperature;
-  if(dtemp <= _nmax) {
-    IO::log << IO::log_offset << funame 
-	    << "WARNING: integration cutoff energy is less than the distribution maximum energy\n";
-    return res;
+#pragma omp simd
+    for(int t = 0; t < size; ++t)
+      res[t] += dtemp / std::exp(ener / temperature[t]);
   }
 
-  dtemp = _states.fun_max() / std::exp(dtemp) / (1. - _nmax / dtemp);
-  if(dtemp / res > eps)
-    IO::log << IO::log_offset << funame << "WARNING: integration cutoff error = " << dtemp / res << "\n";
-  res += dtemp;
-  return res;
+  for(int t = 0; t < size; ++t) {
+    res[t] *= _ener_quant / temperature[t];
+
+    dtemp = _states.arg_max() / temperature[t];
+    if(dtemp <= _nmax) {
+      IO::log << IO::log_offset << funame 
+	      << "WARNING: integration cutoff energy is less than the distribution maximum energy\n";
+      continue;
+    }
+
+    dtemp = _states.fun_max() / std::exp(dtemp) / (1. - _nmax / dtemp);
+    if(dtemp / res[t] > eps)
+      IO::log << IO::log_offset << funame << "WARNING: integration cutoff error = " << dtemp / res[t] << "\n";
+    res[t] += dtemp;
+  }
 }
 
 double Model::VarBarrier::tunnel_weight (double temperature) const 
@@ -18404,6 +21160,9 @@ Model::Bimolecular::Bimolecular(IO::KeyBufferStream& from, const std::string& n)
   bool isener = false;
   bool isdensity = false;
 
+  // fragments ground energies
+  std::vector<double> fragment_ground;
+
   std::string token, comment, stemp;
   while(from >> token) {
     if(IO::end_key() == token) {
@@ -18448,10 +21207,11 @@ Model::Bimolecular::Bimolecular(IO::KeyBufferStream& from, const std::string& n)
 	throw Error::Input();
       }      
       std::getline(from, comment);
+      fragment_ground.push_back(0.);
       if(isdensity)
-	_fragment.push_back(new_species(from, stemp, DENSITY));
+	_fragment.push_back(shared_fragment(from, stemp, DENSITY, fragment_ground.back()));
       else
-	_fragment.push_back(new_species(from, stemp, NOSTATES));
+	_fragment.push_back(shared_fragment(from, stemp, NOSTATES, fragment_ground.back()));
     }
     // dummy
     else if(dummy_key == token) {
@@ -18495,7 +21255,7 @@ Model::Bimolecular::Bimolecular(IO::KeyBufferStream& from, const std::string& n)
   dtemp = 0.;
   for(int i = 0; i < 2; ++i) {
     dtemp += 1. / _fragment[i]->mass();
-    _ground += _fragment[i]->ground();
+    _ground += fragment_ground[i];
     _fragment[i]->shift_ground(-_fragment[i]->ground());
   }
   
@@ -18531,11 +21291,30 @@ double Model::Bimolecular::weight (double temperature) const
 
   double res = _weight_fac * temperature * std::sqrt(temperature);
   for(int i = 0; i < 2; ++i)
-    res *= _fragment[i]->weight(temperature);
+    res *= _fragment[i]->cached_weight(temperature);
 
   return res;
 }
 
+void Model::Bimolecular::weight (const double* temperature, int size, double* res) const
+{
+  if(_dummy) {
+    for(int t = 0; t < size; ++t)
+      res[t] = -1.;
+    return;
+  }
+
+  std::vector<double> fw(size);
+  for(int t = 0; t < size; ++t)
+    res[t] = _weight_fac * temperature[t] * std::sqrt(temperature[t]);
+
+  for(int i = 0; i < 2; ++i) {
+    _fragment[i]->weight(temperature, size, &fw[0]);
+    for(int t = 0; t < size; ++t)
+      res[t] *= fw[t];
+  }
+}
+
 void Model::Bimolecular::shift_ground (double e)
 {
   _ground += e;
@@ -18734,6 +21513,95 @@ double Model::FitEscape::rate (double ener) const
   return dtemp;
 }
 
+void Model::FitEscape::rate (const double* ener, int size, double* res) const
+{
+  // the points inside the fit range are evaluated in one pass over the spline
+  std::vector<double> x;
+  std::vector<int>    index;
+
+  for(int i = 0; i < size; ++i) {
+    //
+    const double e = ener[i] - _ground;
+
+    if(e >= _rate.arg_max()) {
+      //
+      res[i] = _rate.fun_max();
+    }
+    else if(e <= _rate.arg_min()) {
+      //
+      res[i] = _rate.fun_min();
+    }
+    else {
+      //
+      x.push_back(e);
+      index.push_back(i);
+    }
+  }
+
+  if(x.size()) {
+    //
+    std::vector<double> y(x.size());
+
+    _rate.evaluate(&x[0], x.size(), &y[0]);
+
+    for(int k = 0; k < index.size(); ++k)
+      res[index[k]] = y[k];
+  }
+
+  for(int i = 0; i < size; ++i)
+    if(res[i] < 0.)
+      res[i] = 0.;
+}
+
+void Model::Escape::rate (const double* ener, int size, double* res) const
+{
+  for(int i = 0; i < size; ++i)
+    res[i] = rate(ener[i]);
+}
+
+const std::vector<double>& Model::Escape::rate_table (double energy_reference, double energy_step, int size) const
+{
+  // maximal number of the cached grids
+  static const int cache_max = 16;
+
+  std::pair<double, double> key(energy_reference, energy_step);
+
+  std::map<std::pair<double, double>, std::vector<double> >::iterator cit = _rate_cache.find(key);
+
+  if(cit != _rate_cache.end() && cit->second.size() >= size)
+    //
+    return cit->second;
+
+  if(cit == _rate_cache.end() && _rate_cache.size() >= cache_max)
+    //
+    _rate_cache.clear();
+
+  std::vector<double>& table = _rate_cache[key];
+
+  table.resize(size);
+
+  std::vector<double> ener(size);
+  for(int i = 0; i < size; ++i)
+    ener[i] = energy_reference - (double)i * energy_step;
+
+  if(size)
+    rate(&ener[0], size, &table[0]);
+
+  return table;
+}
+
+const std::vector<double>& Model::Well::escape_rate_table (double energy_reference, double energy_step, int size) const
+{
+  const char funame [] = "Model::Well::escape_rate_table: ";
+
+  if(!_escape) {
+    std::cerr << funame << "no escape\n";
+    throw Error::Init();
+  }
+
+  return _escape->rate_table(energy_reference, energy_step, size);
+}
+
 /********************************************************************************************
  **************************************** WELL MODEL ****************************************
  ********************************************************************************************/
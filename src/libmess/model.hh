@@ -119,6 +119,12 @@ namespace Model {
 
     virtual double    operator() (double ener, double temperature) const =0;
     virtual double cutoff_energy              (double temperature) const =0;
+
+    // transfer profile on the energy grid, res[i] = (*this)(i * step, temperature)
+    virtual void profile (double step, double temperature, std::vector<double>& res) const;
+
+    // scales the average energy transferred in the deactivating collision
+    virtual void scale (double);
   };
 
   /********************************* EXPONENTIAL KERNEL MODEL **********************************/
@@ -138,6 +144,10 @@ namespace Model {
 
     double operator () (double, double) const;
     double cutoff_energy (double) const;
+
+    void profile (double, double, std::vector<double>&) const;
+
+    void scale (double);
   };
 
   /**************************************************************************************
@@ -148,6 +158,14 @@ namespace Model {
     double    _wtol;// statistical weight tolerance
     static double _action_max; // maximum 
 
+    // tunneling density on the fine grid from -cutoff to cutoff, set at the first use
+    // and shared by the convolution and the statistical weights
+    mutable std::vector<double> _table;
+    mutable double              _table_step;
+
+    void   _set_table     ()       const;
+    double _table_density (double) const; // linear interpolation
+
   protected:
     double _cutoff;// cutoff energy
     double   _freq;// imaginary frequency
@@ -165,6 +183,7 @@ namespace Model {
     double  factor (double) const; // tunneling factor
     double density (double) const; // energy derivative of tunneling factor
     double  weight (double) const; // statistical weight relative to cutoff energy
+    void    weight (const std::vector<double>& temperature, std::vector<double>& res) const; // all temperatures in one pass
     void convolute (Array<double>&, double) const;// convolute number of states with tunneling density
 
     virtual double action (double, int =0) const =0; // semiclassical action
@@ -399,7 +418,9 @@ namespace Model {
     double                  _astep; // discretization step
     double                _pot_min; // global potential energy minimum
     
-    static double _integral(int p, int n);// \int_0^1 dx x^p cos(n\pi x)
+    // \int_0^1 dx x^p cos(n\pi x), p < psize, n < nsize, at p * nsize + n; the table is
+    // shared by all the instances and extended as needed
+    static void _integral_table (int psize, int nsize, std::vector<double>&);
     void _set_energy_levels(int) ;
 
   public:
@@ -437,6 +458,18 @@ namespace Model {
     virtual double weight (double) const =0; // statistical weight relative to the ground
     virtual double states (double) const =0; // density or number of states relative to the ground
 
+    // statistical weights on the temperature grid
+    virtual void weight (const double* temperature, int size, double* res) const;
+
+    // log of the statistical weight and its first and second temperature derivatives on the
+    // temperature grid; by the three-point differences with the relative temperature increment,
+    // unless the core gets them in one pass over its data
+    virtual void thermal_moments (const double* temperature, int size, double rel_incr,
+				  double* lw, double* d1, double* d2) const;
+
+    // states on the energy grid
+    virtual void states (const double* ener, int size, double* res) const;
+
     int mode () const { return _mode; }
   };
 
@@ -466,6 +499,9 @@ namespace Model {
     double ground       () const;
     double weight (double) const;
     double states (double) const;
+
+    void weight (const double*, int, double*) const;
+    void states (const double*, int, double*) const;
   };
 
   
@@ -500,6 +536,9 @@ namespace Model {
 
     double _core_states (double) const;
     double _core_weight (double) const;
+
+    // core states on the energy grid, shared between threads
+    void _core_states (const double*, int, double*) const;
     
   public:
     RigidRotor (IO::KeyBufferStream&, const std::vector<Atom>&, int) ;
@@ -508,6 +547,8 @@ namespace Model {
     double ground ()       const;
     double weight (double) const;
     double states (double) const;
+
+    void states (const double* ener, int size, double* res) const;
   };
 
   /*****************************************************************************************
@@ -525,6 +566,9 @@ namespace Model {
     double              _rotd_nmin, _rotd_amin;
     double              _rotd_nmax, _rotd_amax;
 
+    Array<double>       _rotd_quad; // integration weights times the density of states
+    double              _rotd_tail; // high energy tail factor
+
   public:
     Rotd (IO::KeyBufferStream&, int) ;
     ~Rotd ();
@@ -532,6 +576,11 @@ namespace Model {
     double ground       () const;
     double states (double) const; // density or the number of states relative to the ground
     double weight (double) const; // statistical weight relative to the ground
+
+    void weight (const double* temperature, int size, double* res) const;
+    void states (const double* ener, int size, double* res) const;
+
+    void thermal_moments (const double*, int, double, double*, double*, double*) const;
   };
 
   /********************************************************************************************
@@ -683,6 +732,12 @@ namespace Model {
 
     Slatec::Spline _qfactor; // quantum correction factor for number/density of states relative to the ground level
 
+    std::vector<double> _qfactor_value; // quantum correction factor on the _ener_quant grid
+
+    // quantum correction factor and energy levels cache, keyed by the model definition
+    bool _load_quantum_cache (const std::string&) ;
+    void _save_quantum_cache (const std::string&) const;
+
     void _set_qfactor ();
 
     void _set_states_base (Array<double>&, int =0) const;
@@ -694,6 +749,8 @@ namespace Model {
     Lapack::SymmetricMatrix _mobility_min;
 
     std::vector<double> _rotational_constant;
+
+    Lapack::Vector _fixed_amom_levels (int, std::ostream&) const;
     
   public:
     
@@ -709,6 +766,7 @@ namespace Model {
 
     double                  potential                (const std::vector<double>&, 
 						      const std::map<int, int>& = std::map<int,int>()) const;
+    Lapack::SymmetricMatrix mobility                 (const std::vector<double>& angle)                const;
     Lapack::SymmetricMatrix mass                     (const std::vector<double>& angle)                const;
     Lapack::Vector          vibration                (const std::vector<double>& angle)                const;
     double                  external_rotation_factor (const std::vector<double>& angle)                const;
@@ -722,12 +780,17 @@ namespace Model {
     // statistical properties
     double quantum_weight           (double temperature)                         const;
     int    get_semiclassical_weight (double temperature, double& cw, double& pw) const;// classical & path integral
+    int    get_semiclassical_weight (const double* temperature, int size, double* cw, double* pw) const;
     void   quantum_states           (Array<double>&, double, int =0)             const;// relative to the ground
 
     // virtual functions
     double ground       () const;
     double states (double) const;// relative to the ground
     double weight (double) const;// relative to the ground
+    void   weight (const double*, int, double*) const;
+
+    // quantum weight moments
+    void   thermal_moments (const double*, int, double, double*, double*, double*) const;
   };
 
   /********************************************************************************************
@@ -739,6 +802,16 @@ namespace Model {
     std::string _name;
     int    _mode;
 
+    // tabulated states keyed on the energy reference and the energy step
+    struct _StatesTable {
+      double              ground;
+      std::vector<double> value;
+    };
+    mutable std::map<std::pair<double, double>, _StatesTable> _states_cache;
+
+    // weights keyed on the temperature, with the ground they were evaluated at
+    mutable std::map<double, std::pair<double, double> > _weight_cache, _tunnel_cache;
+
     Species ();
 
   protected:
@@ -766,6 +839,27 @@ namespace Model {
     virtual double states (double) const =0; // density or number of states of absolute energy
     virtual double weight (double) const =0; // weight relative to the ground
 
+    // density or number of states on the energy grid
+    virtual void states (const double* ener, int size, double* res) const;
+
+    // weights on the temperature grid, evaluated in one pass over the species data
+    virtual void weight (const double* temperature, int size, double* res) const;
+
+    std::vector<double> weight (const std::vector<double>& temperature) const;
+
+    // log of the weight and its first and second temperature derivatives on the temperature grid;
+    // by the three-point differences with the relative temperature increment, unless the species
+    // gets them in one pass over its states
+    virtual void thermal_moments (const double* temperature, int size, double rel_incr,
+				  double* lw, double* d1, double* d2) const;
+
+    // weight and tunnel_weight memoized between calls, the ground shift invalidates the values
+    double cached_weight        (double temperature) const;
+    double cached_tunnel_weight (double temperature) const;
+
+    // states on the grid, energy_reference - i * energy_step, i < size, cached between calls
+    const std::vector<double>& states_table (double energy_reference, double energy_step, int size) const;
+
     double ground () const { return _ground; }
     virtual void shift_ground (double e) { _ground += e; }
     virtual double real_ground () const { return _ground; }
@@ -830,6 +924,14 @@ namespace Model {
 		     const std::vector<int>& sign = std::vector<int>() // derivative signature
 		     ) const;
 
+    // value with the analytic gradient and, optionally, the hessian (central differences of
+    // the gradient) over the cartesian coordinates of the mode atoms, 3 * type() of them in
+    // the atoms() order
+    //
+    double evaluate (const double* cart_pos, double* grad, double* hess = 0) const;
+
+    const std::vector<int>& atoms () const { return _atoms; }
+
     int type () const { return _atoms.size(); }
     
     static double increment;      
@@ -899,6 +1001,10 @@ namespace Model {
     //
     bool _nohess;
 
+    // binary copy of the parsed sampling data next to the data file
+    //
+    bool _data_cache;
+
     // no hessian curvlinear correction
     //
     bool _nocurv;
@@ -921,11 +1027,12 @@ namespace Model {
     
     // statistical weight prefactor including mass factors and quantum prefactor in local harmonic approximation
     //
-    double _local_weight (double                  ener,       // energy
-			  Lapack::Vector          cart_pos,   // cartesian coordinates    
-			  Lapack::Vector          cart_grad,  // energy gradient in cartesian coordinates
-			  Lapack::SymmetricMatrix cart_fc,    // cartesian force constant matrix
-			  double                  temperature // temprature
+    double _local_weight (double                  ener,        // energy
+			  Lapack::Vector          cart_pos,    // cartesian coordinates    
+			  Lapack::Vector          cart_grad,   // energy gradient in cartesian coordinates
+			  Lapack::SymmetricMatrix cart_fc,     // cartesian force constant matrix
+			  double                  temperature, // temprature
+			  std::ostream&           log          // sampling log
 			  ) const;
 
     // read data from the file
@@ -937,6 +1044,30 @@ namespace Model {
 		Lapack::SymmetricMatrix cart_fc     // cartesian force constant matrix
 		) const;
 
+    // sampling data read from the data file once: energies, cartesian coordinates,
+    // energy gradients, and force constant matrices (SymmetricMatrix storage), sampling by sampling
+    //
+    std::vector<double> _samp_ener;
+    std::vector<double> _samp_pos;
+    std::vector<double> _samp_grad;
+    std::vector<double> _samp_fc;
+
+    void _read_data ();
+
+    bool _load_data_cache (const std::string&) ;
+    void _save_data_cache (const std::string&) const;
+
+    int _samp_size () const { return _samp_ener.size(); }
+
+    // copy of the sampling data
+    //
+    void _sampling (int                      samp,
+		    double&                  ener,
+		    Lapack::Vector&          cart_pos,
+		    Lapack::Vector&          cart_grad,
+		    Lapack::SymmetricMatrix& cart_fc
+		    ) const;
+
     // set reference energy to the minimal total energy including zero-point energy
     //
     void _set_reference_energy ();
@@ -1003,8 +1134,6 @@ namespace Model {
 
   class MonteCarloWithDummy : public Species {
 
-    void _assert(ConstSlice<double> v) const;
-
     // dummy atoms indices
     //
     std::vector<int> _dummy_atom;
@@ -1017,15 +1146,16 @@ namespace Model {
     //
     std::vector<Atom> _atom_array;
 
-    // vector operations with mass weighting
+    // geometry independent parts of the projectors: the square roots of the atomic masses
+    // (zero for the dummy atoms) on the cartesian coordinates and the translation constrains
     //
-    double _vdot(ConstSlice<double>, ConstSlice<double>) const;
+    std::vector<double> _mass_sqrt;
 
-    double _normalize(Slice<double>) const;
-    
-    void _orthogonalize (Slice<double>, ConstSlice<double>) const;
-    
-    void _orthogonalize (Lapack::Matrix m) const;
+    Lapack::Matrix      _trans_con;
+
+    // mass-orthonormal basis of the constrain matrix null space
+    //
+    Lapack::Matrix _mass_basis (const Lapack::Matrix& con) const;
 
     // explicitly sampled fluxional modes
     //
@@ -1035,14 +1165,24 @@ namespace Model {
     
     std::string _data_file;
 
-    
+    // samplings read from the data file: energies, cartesian coordinates of all atoms,
+    // gradients and packed force constant matrices over the real atoms coordinates
+    //
+    std::vector<double> _samp_ener;
+    std::vector<double> _samp_pos;
+    std::vector<double> _samp_grad;
+    std::vector<double> _samp_fc;
+
+    void _read_data ();
+
     // statistical weight prefactor including mass factors and quantum prefactor in local harmonic approximation
     //
-    double _local_weight (double                  ener,       // energy
-			  Lapack::Vector          cart_pos,   // cartesian coordinates    
-			  Lapack::Vector          cart_grad,  // energy gradient in cartesian coordinates
-			  Lapack::SymmetricMatrix cart_fc,    // cartesian force constant matrix
-			  double                  temperature // temprature
+    double _local_weight (double                  ener,        // energy
+			  Lapack::Vector          cart_pos,    // cartesian coordinates    
+			  Lapack::Vector          cart_grad,   // energy gradient in cartesian coordinates
+			  Lapack::SymmetricMatrix cart_fc,     // cartesian force constant matrix
+			  double                  temperature, // temprature
+			  std::ostream&           log          // sampling log
 			  ) const;
 
   public:
@@ -1080,14 +1220,24 @@ namespace Model {
     
     double _real_ground;
 
-    // interpolation
-    double           _emax; // interpolation energy maximum
-    double           _nmax; // extrapolation power value
-    Slatec::Spline _states;
+    // interpolation, built on the first query
+    double               _emax; // interpolation energy maximum
+    double           _grid_max; // interpolation energy range
+    double         _ener_quant; // energy discretization step
+    double         _extra_step; // extrapolation logarithmic step
+    mutable double       _nmax; // extrapolation power value
+    mutable Slatec::Spline _states;
+    mutable int        _isinit;
+
+    void  _init_states () const;
+    void _build_states () const;
+
+    // weight with the given core contribution
+    double _weight (double temperature, double core_weight) const;
 
     // radiative transitions
-    std::vector<Slatec::Spline> _occ_num; // average occupation numbers for vibrational modes
-    std::vector<double>     _occ_num_der; // occupation number derivatives (for extrapolation)
+    mutable std::vector<Slatec::Spline> _occ_num; // average occupation numbers for vibrational modes
+    mutable std::vector<double>     _occ_num_der; // occupation number derivatives (for extrapolation)
     std::vector<double>         _osc_int; // oscillator strength (infrared intensities)
     
     // graph perturbation theory
@@ -1099,7 +1249,11 @@ namespace Model {
     ~RRHO ();
 
     double states (double) const; // density or number of states of absolute energy
+    void   states (const double*, int, double*) const;
     double weight (double) const; // weight relative to the ground
+    void   weight (const double*, int, double*) const;
+
+    void   thermal_moments (const double*, int, double, double*, double*, double*) const;
 
     double real_ground () const { return _real_ground; }
     void shift_ground (double e) { _ground += e; _real_ground += e; }
@@ -1115,11 +1269,26 @@ namespace Model {
 
   /********************* READ DENSITY OF STATES FROM THE FILE AND INTERPOLATE ****************/
   
+  // the File is the text table (energy, density/number of states) or the binary one written
+  // by BinaryOutput, recognized by its header; the binary table is the text one processed,
+  // hence EnergyUnits and GroundStateThreshold do not apply to it
+  //
   class ReadSpecies : public Species {    
     Array<double>   _ener; // relative energy on the grid
     Array<double> _states; // density/number of states on the grid
     int _mode;
 
+    // the binary table (BinaryOutput) is mapped in place of the text one: the processed
+    // table and the spline coefficients are used from the file page cache, not copied
+    IO::MappedFile _table_file;
+
+    const double* _table_ener;   // _ener or the mapped table
+    const double* _table_states; // _states or the mapped table
+    int           _table_size;
+
+    void _map_table  (const std::string&) ;
+    void _save_table (const std::string&, double ground) const;
+
     Slatec::Spline _spline;
     double _emin, _emax;
     double _nmin, _amin;
@@ -1133,6 +1302,7 @@ namespace Model {
     ~ReadSpecies ();
 
     double states (double) const;
+    void   states (const double*, int, double*) const;
     double weight (double) const;
   };
   
@@ -1145,17 +1315,25 @@ namespace Model {
 
     double _real_ground;
 
+    // merged states of the components above the highest component ground, the energy
+    // relative to the ground, so that the ground shift does not change it
+    Slatec::Spline _states;
+
     // radiational transitions
     std::vector<int> _osc_shift;
     std::vector<int> _osc_spec_index;
 
+    double _direct_states (double) const;
+
   public:
 
     UnionSpecies  (IO::KeyBufferStream&, const std::string&, int) ;
     ~UnionSpecies ();
 
     double states (double) const;
+    void   states (const double*, int, double*) const;
     double weight (double) const;
+    void   weight (const double*, int, double*) const;
 
     void shift_ground (double);
     double real_ground () const { return _real_ground; }
@@ -1186,12 +1364,17 @@ namespace Model {
     enum {STATISTICAL, DYNAMICAL};
     int _tts_method;
 
+    // skip the RRHOs which cannot be the minimum
+    bool _lazy;
+
   public:
     VarBarrier (IO::KeyBufferStream& from, const std::string&) ;
     ~VarBarrier ();
 
     double states (double) const;
+    void   states (const double*, int, double*) const;
     double weight (double) const;
+    void   weight (const double*, int, double*) const;
 
     double real_ground () const { return _real_ground; }
     void shift_ground (double e) { _ground += e; _real_ground += e; }
@@ -1265,6 +1448,7 @@ namespace Model {
     bool     dummy       () const { return _dummy; }
     double  ground       () const;
     double  weight (double) const;
+    void    weight (const double* temperature, int size, double* res) const; // on the temperature grid
     void shift_ground (double);
 
     const std::string& fragment_name (int i) const { return _fragment[i]->name(); }
@@ -1280,8 +1464,23 @@ namespace Model {
 
   // abstract class for escape rate
   class Escape {
+    // tabulated rates keyed on the energy reference and the energy step
+    mutable std::map<std::pair<double, double>, std::vector<double> > _rate_cache;
+
+  protected:
+    void _clear_cache () { _rate_cache.clear(); }
+
   public:
+    virtual ~Escape () {}
+
     virtual double rate (double) const =0;
+
+    // rates on the energy grid
+    virtual void rate (const double* ener, int size, double* res) const;
+
+    // rates on the grid, energy_reference - i * energy_step, i < size, cached between calls
+    const std::vector<double>& rate_table (double energy_reference, double energy_step, int size) const;
+
     virtual void shift_ground (double) =0;
   };
 
@@ -1291,6 +1490,8 @@ namespace Model {
     ConstEscape(IO::KeyBufferStream&) ;
 
     double rate (double) const {return _rate; }
+    void   rate (const double*, int size, double* res) const { for(int i = 0; i < size; ++i) res[i] = _rate; }
+
     void shift_ground (double) {}
   };
 
@@ -1302,7 +1503,9 @@ namespace Model {
     FitEscape(IO::KeyBufferStream&) ;
 
     double rate (double) const;
-    void shift_ground(double e) { _ground += e; }
+    void   rate (const double*, int, double*) const;
+
+    void shift_ground(double e) { _ground += e; _clear_cache(); }
   };
 
   /********************************************************************************************
@@ -1329,6 +1532,7 @@ namespace Model {
     SharedPointer<Species>      species ()       { return _species; }
     ConstSharedPointer<Species> species () const { return _species; }
 
+    SharedPointer<Kernel>         kernel    (int i)        { return _kernel[i]; }
     ConstSharedPointer<Kernel>    kernel    (int i)  const { return _kernel[i]; }
     ConstSharedPointer<Collision> collision (int i)  const { return _collision[i]; }
 
@@ -1340,6 +1544,8 @@ namespace Model {
     double               mass () const             ;
 
     double        escape_rate (double ener) const { if(_escape) return _escape->rate(ener); else return 0.; }
+    // escape rates on the energy grid, see Escape::rate_table
+    const std::vector<double>& escape_rate_table (double energy_reference, double energy_step, int size) const;
     bool               escape () const { return (bool)_escape; } 
 
     void shift_ground (double) ;
@@ -1439,7 +1645,7 @@ namespace Model {
       throw Error::Init();
     }
 
-    return _species->weight(t);
+    return _species->cached_weight(t);
   }
 
   inline double Well::states (double e) const 
@@ -1481,8 +1687,22 @@ namespace Model {
 
   double  maximum_barrier_height ();
 
+  // edits of the initialized model; the barrier shift also resets the dissociation
+  // limits and the maximum barrier height, and so does the well shift
+  void shift_barrier (const std::string& name, double e);
+  void shift_well    (const std::string& name, double e);
+  void scale_kernel  (double factor); // all energy transfer kernels
+  void set_buffer_fraction (const std::vector<double>&); // buffer gas mole fractions, normalized
+
   // energy shift
   extern std::string reactant; // bimolecular species to use as an energy reference
+
+  // MultiRotor quantum states cache directory, no caching if empty
+  extern std::string multirotor_cache_dir;
+
+  // hindered rotor and umbrella mode spectra cache directory; within the run the
+  // spectra are always shared
+  extern std::string rotor_cache_dir;
   double energy_shift ();
 
   /********************************************************************************
@@ -1496,6 +1716,20 @@ namespace Model {
     double _step;
     int    _size;
     double _temperature;
+    double _tolerance;
+    bool   _binary;
+
+  public:
+    // piecewise constant conditions: segment duration (atomic units), temperature
+    // (atomic units), and pressure (in the pressure list units)
+    struct Segment {
+      double duration;
+      double temperature;
+      double pressure;
+    };
+
+  private:
+    std::vector<Segment> _profile;
 
     mutable int    _reactant;
     std::string    _reactant_name;
@@ -1514,6 +1748,21 @@ namespace Model {
     double excess_reactant_concentration () const { return _excess; }
     double temperature () const { return _temperature; }
 
+    // relaxation modes with exp(-lambda * t) below the tolerance are dropped (negative if not set)
+    double tolerance () const { return _tolerance; }
+
+    // columnar binary output: the header (int species number, then int name length and
+    // name characters for each well and bimolecular) is followed by the (T, P) blocks, each
+    // consisting of double pressure (input units) and temperature (K), int time grid size,
+    // and the time grid (sec) and species populations columns of doubles
+    bool binary () const { return _binary; }
+
+    // profile mode: the species populations are carried through the segments with the
+    // phenomenological rate coefficients of the segment conditions, which should be on the
+    // temperature and pressure grid; the last segment conditions hold after the profile end;
+    // the output has one (T, P) block per segment with the time grid points inside it
+    const std::vector<Segment>& profile () const { return _profile; }
+
     std::ofstream out;
   };
 
@@ -21,12 +21,19 @@
 
 #include <dlfcn.h>
 #include <cstdlib>
+#include <cmath>
 #include <cctype>
 #include <unistd.h>
 #include <cstdio>
 #include <cerrno>
 #include <cstring>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 
+#include <fstream>
 #include <iomanip>
 #include <vector>
 #include <sstream>
@@ -51,6 +58,34 @@ namespace Molpro {
   int fail_counter = 0;
 
   void backup (const std::string&) ;
+
+  // geometry-to-energies cache
+  std::string cache_file;
+  std::map<std::string, std::vector<double> > cache;
+
+  bool cache_find (const std::string& geom, Array<double>& ener_data);
+  void cache_add  (const std::string& geom, const Array<double>& ener_data);
+
+  // converged orbitals library, the most recently used last
+  struct Orbital {
+    std::vector<Atom> molec;
+    std::string       file;
+  };
+
+  std::string         orbital_dir;
+  int                 orbital_size     = 16;
+  double              orbital_dist_max = 1.;
+  int                 orbital_count    = 0;
+  std::deque<Orbital> orbital;
+
+  void restore_orbital (const std::vector<Atom>&, const std::string& scratch) ;
+  void store_orbital   (const std::vector<Atom>&, const std::string& scratch) ;
+
+  std::string geometry    (const std::vector<Atom>&);
+  void        write_input (const std::string& geom, const std::string& inp_name) ;
+  bool        scan_output (std::istream&, Array<double>& ener_data, std::string& mess);
+
+  void make_dir (const std::string&) ;
 }
 
 bool Molpro::isinit () 
@@ -120,6 +155,8 @@ void Molpro::init(std::istream& from)
   Key geom_key("GeometryPattern");
   Key ener_key("EnergyPattern"  );
   Key fail_key("FailurePattern" );
+  Key cach_key("CacheFile"      );
+  Key orbl_key("OrbitalLibrary" );
 
   std::string token, comment;
   while(from >> token) {
@@ -257,6 +294,28 @@ void Molpro::init(std::istream& from)
       for(int i = 0; i < fail_pattern.size(); ++i)
 	fail_pattern[i] = std::toupper(fail_pattern[i]);
     }
+    // geometry-to-energies cache
+    else if(cach_key == token) {
+      if(!(from >> stemp)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+
+      std::getline(from, comment);
+
+      set_cache(stemp);
+    }
+    // converged orbitals library: directory, number of the orbital files, distance
+    else if(orbl_key == token) {
+      if(!(from >> stemp >> itemp >> dtemp)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+
+      std::getline(from, comment);
+
+      set_orbital_library(stemp, itemp, dtemp);
+    }
     // unknown keyword
     else if(IO::skip_comment(token, from)) {
       std::cerr << funame << "unknown keyword: " << token << "\n";
@@ -291,17 +350,15 @@ void Molpro::init(std::istream& from)
   if(input_template.find(stemp) < input_template.size())
     wfu = true;
 
+  if(orbital_dir.size() && !wfu) {
+    std::cerr << funame << "orbital library: wfu not in template\n";
+    throw Error::Init();
+  }
+
 } // Molpro::init
 
-void Molpro::pot (const std::vector<Atom>& molec, Array<double>& ener_data, int flags) 
+std::string Molpro::geometry (const std::vector<Atom>& molec)
 {
-  const char funame [] = "Molpro::pot: ";
-
-  double      dtemp;
-  int         itemp;
-  std::string stemp;
-
-  // create a geometry string
   std::ostringstream geom;
   for(std::vector<Atom>::const_iterator at = molec.begin(); at != molec.end(); ++at) {
     if(at != molec.begin())
@@ -309,19 +366,100 @@ void Molpro::pot (const std::vector<Atom>& molec, Array<double>& ener_data, int
     geom << *at;
   }
 
-  // create input string
+  return geom.str();
+}
+
+void Molpro::write_input (const std::string& geom, const std::string& inp_name) 
+{
+  const char funame [] = "Molpro::write_input: ";
+
   std::string input = input_template;
-  input.insert(geom_start, geom.str());
+  input.insert(geom_start, geom);
 
-  // create an input file for molpro
-  const std::string inp_name = base_name + ".inp";
   std::ofstream to(inp_name.c_str());
   if(!to) {
     IO::log << funame << "cannot open " << inp_name << " file\n";
     throw Error::Open();
   }
   to << input;
-  to.close();
+}
+
+// reads the energies from molpro output; returns false and the reason on failure
+bool Molpro::scan_output (std::istream& from, Array<double>& ener_data, std::string& mess)
+{
+  const char funame [] = "Molpro::pot: ";
+
+  double      dtemp;
+  std::string stemp;
+
+  int ener_count = 0;
+  while(std::getline(from, stemp)) {
+    std::istringstream lin(stemp);
+    
+    // variable assignment
+    if(lin >> stemp && stemp == "SETTING") {
+
+      if(!(lin >> stemp)) {
+	mess = "cannot read output";
+	return false;
+      }
+
+      // read energy
+      if(ener_pattern == stemp) {
+
+	if(!(lin >> stemp) || stemp != "=" || !(lin >> dtemp)) {
+	  mess = "cannot read energy";
+	  return false;
+	}
+	
+	IO::log << funame << "molpro energy [kcal/mol] = " << dtemp / Phys_const::kcal << std::endl;
+
+	if(ener_count == ener_data.size()) {
+	  mess = "too many energies";
+	  return false;
+	}
+
+	ener_data[ener_count++] = dtemp;
+      }// read energy
+
+      // convergence failure
+      if(fail_pattern == stemp) {
+	mess = "convergence failure";
+	return false;
+      }
+
+    }// variables assignment
+  }// scan molpro output
+
+  if(ener_count != ener_data.size()) {
+    mess = "too few energies";
+    return false;
+  }
+
+  return true;
+}
+
+void Molpro::pot (const std::vector<Atom>& molec, Array<double>& ener_data, int flags) 
+{
+  const char funame [] = "Molpro::pot: ";
+
+  int         itemp;
+  std::string stemp;
+
+  // create a geometry string
+  const std::string geom = geometry(molec);
+
+  if(cache_find(geom, ener_data)) {
+    IO::log << funame << "energies are taken from the cache" << std::endl;
+    return;
+  }
+
+  // create an input file for molpro
+  const std::string inp_name = base_name + ".inp";
+  write_input(geom, inp_name);
+
+  if(orbital_dir.size())
+    restore_orbital(molec, scratch_dir);
 
   // run molpro executable
   const std::string out_name = base_name + ".out";
@@ -343,37 +481,459 @@ void Molpro::pot (const std::vector<Atom>& molec, Array<double>& ener_data, int
   }
 
   // scan molpro output
-  int ener_count = 0;
-  while(std::getline(from, stemp)) {
-    std::istringstream lin(stemp);
-    
-    // variable assignment
-    if(lin >> stemp && stemp == "SETTING") {
+  if(!scan_output(from, ener_data, stemp))
+    backup(stemp);
 
-      if(!(lin >> stemp))
-	  backup("cannot read output");
+  if(orbital_dir.size())
+    store_orbital(molec, scratch_dir);
 
-      // read energy
-      if(ener_pattern == stemp) {
+  cache_add(geom, ener_data);
+}
 
-	if(!(lin >> stemp) || stemp != "=" || !(lin >> dtemp))
-	  backup("cannot read energy");
-	
-	IO::log << funame << "molpro energy [kcal/mol] = " << dtemp / Phys_const::kcal << std::endl;
+/********************************************************************************************
+ ******************************** GEOMETRY-TO-ENERGIES CACHE ********************************
+ ********************************************************************************************/
 
-	if(ener_count == ener_data.size())
-	  backup("too many energies");
+// cache file record: the number of energies, the energies, the number of
+// geometry lines, and the geometry as it goes into the molpro input
+void Molpro::set_cache (const std::string& file) 
+{
+  const char funame [] = "Molpro::set_cache: ";
 
-	ener_data[ener_count++] = dtemp;
-      }// read energy
+  int         itemp;
+  double      dtemp;
+  std::string stemp;
 
-      // convergence failure
-      if(fail_pattern == stemp)
-	backup("convergence failure");
+  cache_file = file;
+  cache.clear();
+
+  std::ifstream from(file.c_str());
+  if(!from)
+    return;
+
+  int ener_size;
+  while(from >> ener_size) {
+    std::vector<double> ener(ener_size);
+    for(int e = 0; e < ener_size; ++e)
+      from >> ener[e];
+
+    int line_size;
+    from >> line_size;
+    std::getline(from, stemp);
+
+    std::string geom;
+    for(int l = 0; l < line_size; ++l) {
+      if(!std::getline(from, stemp))
+	break;
+      if(l)
+	geom += "\n";
+      geom += stemp;
+    }
 
-    }// variables assignment
-  }// scan molpro output
+    // incomplete last record
+    if(!from)
+      break;
+
+    cache[geom] = ener;
+  }
+
+  IO::log << funame << cache.size() << " cached geometries have been read from " << file << std::endl;
+}
+
+bool Molpro::cache_find (const std::string& geom, Array<double>& ener_data)
+{
+  std::map<std::string, std::vector<double> >::const_iterator cit = cache.find(geom);
+
+  if(cit == cache.end() || cit->second.size() != ener_data.size())
+    return false;
+
+  for(int e = 0; e < ener_data.size(); ++e)
+    ener_data[e] = cit->second[e];
+
+  return true;
+}
+
+void Molpro::cache_add (const std::string& geom, const Array<double>& ener_data)
+{
+  const char funame [] = "Molpro::cache_add: ";
+
+  if(!cache_file.size())
+    return;
+
+  std::vector<double>& ener = cache[geom];
+  ener.resize(ener_data.size());
+  for(int e = 0; e < ener_data.size(); ++e)
+    ener[e] = ener_data[e];
+
+  int line_size = 1;
+  for(int i = 0; i < geom.size(); ++i)
+    if(geom[i] == '\n')
+      ++line_size;
+
+  std::ofstream to(cache_file.c_str(), std::ios_base::app);
+  if(!to) {
+    IO::log << funame << "cannot open " << cache_file << " file" << std::endl;
+    return;
+  }
+
+  to << ener.size() << std::setprecision(17);
+  for(int e = 0; e < ener.size(); ++e)
+    to << " " << ener[e];
+  to << "\n" << line_size << "\n" << geom << "\n";
+  to.flush();
+}
+
+/********************************************************************************************
+ ********************************* CONVERGED ORBITALS LIBRARY *******************************
+ ********************************************************************************************/
 
-  if(ener_count != ener_data.size())
-    backup("too few energies");
+namespace Molpro {
+  //
+  bool copy_file (const std::string& source, const std::string& target)
+  {
+    std::ifstream from(source.c_str(), std::ios::binary);
+    if(!from)
+      return false;
+
+    // the target is never incomplete
+    IO::AtomicFile to(target);
+    to << from.rdbuf();
+
+    return to.commit();
+  }
+
+  // rms distance between the geometries, negative if the atoms differ
+  double geometry_distance (const std::vector<Atom>& m1, const std::vector<Atom>& m2)
+  {
+    if(m1.size() != m2.size() || !m1.size())
+      return -1.;
+
+    double res = 0.;
+    for(int a = 0; a < m1.size(); ++a) {
+      if(!(m1[a] == m2[a]))
+	return -1.;
+
+      const double dtemp = vdistance(m1[a], m2[a]);
+      res += dtemp * dtemp;
+    }
+
+    return std::sqrt(res / (double)m1.size());
+  }
+}
+
+void Molpro::set_orbital_library (const std::string& dir, int size, double dist_max) 
+{
+  const char funame [] = "Molpro::set_orbital_library: ";
+
+  if(size <= 0 || dist_max <= 0.) {
+    std::cerr << funame << "out of range\n";
+    throw Error::Range();
+  }
+
+  make_dir(dir);
+
+  orbital_dir      = dir;
+  orbital_size     = size;
+  orbital_dist_max = dist_max;
+}
+
+// the orbitals of the nearest geometry are put in place of the old ones, if any
+void Molpro::restore_orbital (const std::vector<Atom>& molec, const std::string& scratch) 
+{
+  const char funame [] = "Molpro::restore_orbital: ";
+
+  if(!scratch.size()) {
+    std::cerr << funame << "scratch directory is not initialized\n";
+    throw Error::Init();
+  }
+
+  const std::string wfu_file = scratch + "/" + base_name + ".wfu";
+
+  int    near = -1;
+  double dist_min;
+  for(int o = 0; o < orbital.size(); ++o) {
+    const double dtemp = geometry_distance(molec, orbital[o].molec);
+    if(dtemp >= 0. && dtemp <= orbital_dist_max && (near < 0 || dtemp < dist_min)) {
+      near     = o;
+      dist_min = dtemp;
+    }
+  }
+
+  if(near < 0 || !copy_file(orbital[near].file, wfu_file)) {
+    std::remove(wfu_file.c_str());
+    return;
+  }
+
+  IO::log << funame << "starting from the orbitals of the geometry at the distance " << dist_min << std::endl;
+
+  // the most recently used last
+  Orbital otemp = orbital[near];
+  orbital.erase(orbital.begin() + near);
+  orbital.push_back(otemp);
+}
+
+void Molpro::store_orbital (const std::vector<Atom>& molec, const std::string& scratch) 
+{
+  const char funame [] = "Molpro::store_orbital: ";
+
+  std::ostringstream file;
+  file << orbital_dir << "/" << base_name << "." << orbital_count++ << ".wfu";
+
+  if(!copy_file(scratch + "/" + base_name + ".wfu", file.str())) {
+    IO::log << funame << "cannot save the orbitals to " << file.str() << std::endl;
+    return;
+  }
+
+  Orbital otemp;
+  otemp.molec = molec;
+  otemp.file  = file.str();
+  orbital.push_back(otemp);
+
+  if(orbital.size() > orbital_size) {
+    std::remove(orbital.front().file.c_str());
+    orbital.pop_front();
+  }
+}
+
+/********************************************************************************************
+ ***************************************** JOB POOL *****************************************
+ ********************************************************************************************/
+
+void Molpro::make_dir (const std::string& dir) 
+{
+  const char funame [] = "Molpro::make_dir: ";
+
+  struct stat wstat;
+
+  if(!mkdir(dir.c_str(), S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH))
+    return;
+
+  if(errno == EEXIST && !stat(dir.c_str(), &wstat) && S_ISDIR(wstat.st_mode))
+    return;
+
+  std::cerr << funame << dir << ": " << strerror(errno) << "\n";
+  throw Error::Open();
+}
+
+Molpro::JobPool::JobPool (int size, const std::string& work_dir, const std::string& scratch_dir, int ener_size, int retry_max)
+  : _ener_size(ener_size), _retry_max(retry_max), _id_count(0)
+{
+  const char funame [] = "Molpro::JobPool::JobPool: ";
+
+  if(!isinit()) {
+    std::cerr << funame << "molpro environment is not initialized\n";
+    throw Error::Init();
+  }
+
+  if(size <= 0 || ener_size <= 0 || retry_max < 0) {
+    std::cerr << funame << "out of range\n";
+    throw Error::Range();
+  }
+
+  _exec = executable;
+  if(_exec.find('/') != std::string::npos && _exec[0] != '/') {
+    char* cwd = getcwd(0, 0);
+    if(cwd) {
+      _exec = std::string(cwd) + "/" + _exec;
+      std::free(cwd);
+    }
+  }
+
+  make_dir(work_dir);
+  if(scratch_dir.size())
+    make_dir(scratch_dir);
+
+  _work_dir.resize(size);
+  _scratch_dir.resize(size);
+  _pid.resize(size, 0);
+  _slot_job.resize(size);
+
+  for(int slot = 0; slot < size; ++slot) {
+    std::ostringstream slot_name;
+    slot_name << "/job" << slot;
+
+    _work_dir[slot] = work_dir + slot_name.str();
+    make_dir(_work_dir[slot]);
+
+    if(scratch_dir.size()) {
+      _scratch_dir[slot] = scratch_dir + slot_name.str();
+      make_dir(_scratch_dir[slot]);
+    }
+  }
+}
+
+Molpro::JobPool::~JobPool ()
+{
+  int status;
+
+  for(int slot = 0; slot < _pid.size(); ++slot)
+    if(_pid[slot]) {
+      kill(_pid[slot], SIGTERM);
+      waitpid(_pid[slot], &status, 0);
+    }
+}
+
+int Molpro::JobPool::running () const
+{
+  int res = 0;
+  for(int slot = 0; slot < _pid.size(); ++slot)
+    if(_pid[slot])
+      ++res;
+
+  return res;
+}
+
+int Molpro::JobPool::submit (const std::vector<Atom>& molec)
+{
+  _job_t job;
+  job.id        = _id_count++;
+  job.try_count = 0;
+  job.geom      = geometry(molec);
+  job.molec     = molec;
+
+  Result res;
+  res.ener.resize(_ener_size);
+
+  if(cache_find(job.geom, res.ener)) {
+    res.id   = job.id;
+    res.fail = false;
+    _done.push_back(res);
+  }
+  else
+    _queue.push_back(job);
+
+  return job.id;
+}
+
+void Molpro::JobPool::_start (int slot) 
+{
+  const char funame [] = "Molpro::JobPool::_start: ";
+
+  _slot_job[slot] = _queue.front();
+  _queue.pop_front();
+
+  ++_slot_job[slot].try_count;
+
+  const std::string inp_name = _work_dir[slot] + "/" + base_name + ".inp";
+  const std::string out_name = _work_dir[slot] + "/" + base_name + ".out";
+
+  write_input(_slot_job[slot].geom, inp_name);
+  std::remove(out_name.c_str());
+
+  if(orbital_dir.size())
+    restore_orbital(_slot_job[slot].molec, _scratch_dir[slot]);
+
+  std::cout.flush();
+
+  const pid_t pid = fork();
+
+  if(pid < 0) {
+    std::cerr << funame << "fork failed\n";
+    throw Error::Run();
+  }
+
+  if(!pid) {
+    // child: run in the slot directory
+    if(chdir(_work_dir[slot].c_str()))
+      _exit(1);
+
+    int fd = open("std.out", O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    dup2(fd, 1);
+    close(fd);
+
+    fd = open("std.err", O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    dup2(fd, 2);
+    close(fd);
+
+    const std::string inp = base_name + ".inp";
+
+    if(_scratch_dir[slot].size())
+      execlp(_exec.c_str(), _exec.c_str(), "--scratch", _scratch_dir[slot].c_str(), inp.c_str(), (char*) 0);
+    else
+      execlp(_exec.c_str(), _exec.c_str(), inp.c_str(), (char*) 0);
+
+    _exit(1);
+  }
+
+  _pid[slot] = pid;
+}
+
+void Molpro::JobPool::_finish (int slot, int status) 
+{
+  const char funame [] = "Molpro::JobPool: ";
+
+  _pid[slot] = 0;
+
+  _job_t& job = _slot_job[slot];
+
+  Result res;
+  res.id   = job.id;
+  res.fail = true;
+  res.ener.resize(_ener_size);
+
+  if(!WIFEXITED(status) || WEXITSTATUS(status))
+    res.mess = "run failure";
+  else {
+    std::ifstream from((_work_dir[slot] + "/" + base_name + ".out").c_str());
+
+    if(!from)
+      res.mess = "cannot open output file";
+    else if(scan_output(from, res.ener, res.mess))
+      res.fail = false;
+  }
+
+  if(!res.fail) {
+    if(orbital_dir.size())
+      store_orbital(job.molec, _scratch_dir[slot]);
+
+    cache_add(job.geom, res.ener);
+    _done.push_back(res);
+    return;
+  }
+
+  IO::log << funame << "job " << job.id << ", attempt " << job.try_count << ": " << res.mess << std::endl;
+
+  if(job.try_count <= _retry_max)
+    _queue.push_front(job);
+  else
+    _done.push_back(res);
+}
+
+bool Molpro::JobPool::next (Result& res)
+{
+  const char funame [] = "Molpro::JobPool::next: ";
+
+  int status;
+
+  while(1) {
+    // start the queued jobs in the free slots
+    for(int slot = 0; slot < _pid.size() && _queue.size(); ++slot)
+      if(!_pid[slot])
+	_start(slot);
+
+    if(_done.size()) {
+      res = _done.front();
+      _done.pop_front();
+      return true;
+    }
+
+    if(!running())
+      return false;
+
+    const pid_t pid = waitpid(-1, &status, 0);
+
+    if(pid < 0) {
+      if(errno == EINTR)
+	continue;
+
+      std::cerr << funame << "waitpid: " << strerror(errno) << "\n";
+      throw Error::Run();
+    }
+
+    for(int slot = 0; slot < _pid.size(); ++slot)
+      if(_pid[slot] == pid) {
+	_finish(slot, status);
+	break;
+      }
+  }
 }
@@ -21,6 +21,8 @@
 #include <string>
 #include <iostream>
 #include <vector>
+#include <deque>
+#include <map>
 
 namespace Molpro {
   // initialization
@@ -33,6 +35,69 @@ namespace Molpro {
   void set_scratch_dir (const std::string& s);
   void remove_wfu      ();
 
+  // persistent geometry-to-energies cache: the geometries found in the cache are not
+  // recalculated, and every new result is appended to the cache file
+  void set_cache (const std::string& file);
+
+  // library of the converged orbitals (the wfu file in the scratch directory) of the recent
+  // geometries: each run starts from the orbitals of the nearest stored geometry, if it is
+  // within the distance (rms over the atoms, in the geometry units), or from scratch otherwise
+  void set_orbital_library (const std::string& dir, int size, double dist_max);
+
+  // pool of concurrent molpro runs, each in its own working and scratch directories,
+  // fed from the queue of geometries; the failed runs are resubmitted retry_max times
+  class JobPool {
+  public:
+    // finished job
+    struct Result {
+      int           id;   // the number returned by submit
+      bool          fail;
+      std::string   mess; // failure message
+      Array<double> ener;
+    };
+
+  private:
+    struct _job_t {
+      int               id;
+      int               try_count;
+      std::string       geom;
+      std::vector<Atom> molec;
+    };
+
+    std::vector<std::string> _work_dir;    // working directory of the slot
+    std::vector<std::string> _scratch_dir; // scratch directory of the slot
+    std::vector<int>         _pid;         // process running in the slot, zero if the slot is free
+    std::vector<_job_t>      _slot_job;
+
+    std::deque<_job_t>       _queue;
+    std::deque<Result>       _done;
+
+    int _ener_size;
+    int _retry_max;
+    int _id_count;
+
+    std::string _exec; // executable path valid from the slot directories
+
+    void _start (int slot);
+    void _finish (int slot, int status);
+
+    JobPool (const JobPool&);
+    JobPool& operator= (const JobPool&);
+
+  public:
+    //
+    JobPool (int size, const std::string& work_dir, const std::string& scratch_dir, int ener_size, int retry_max = 2);
+    ~JobPool ();
+
+    // queues the geometry and returns the job number
+    int submit (const std::vector<Atom>&);
+
+    // waits for the next finished job; false if there are no jobs left
+    bool next (Result&);
+
+    int running () const;
+    int queued  () const { return _queue.size(); }
+  };
 }
 
 #endif
@@ -324,6 +324,87 @@ NumDer::cmap_t NumDer::convert (const der_t& der) const
   return res;
 }
 
+void NumDer::Stencil::add (const der_t& der)
+{
+  if(_term.find(der) != _term.end())
+    //
+    return;
+
+  cmap_t cmap = _numd.convert(der);
+
+  _term_t& term = _term[der];
+
+  for(cmap_t::const_iterator cmit = cmap.begin(); cmit != cmap.end(); ++cmit) {
+    //
+    std::map<std::vector<int>, int>::const_iterator it = _index.find(cmit->first);
+
+    int c;
+    
+    if(it == _index.end()) {
+      //
+      c = _conf.size();
+
+      _index[cmit->first] = c;
+
+      _conf.push_back(cmit->first);
+    }
+    else
+      //
+      c = it->second;
+
+    term.push_back(std::make_pair(c, cmit->second));
+  }
+}
+
+double NumDer::Stencil::operator() (const der_t& der, const std::vector<double>& fval, const std::vector<double>& step) const
+{
+  const char funame [] = "NumDer::Stencil::operator(): ";
+
+  std::map<der_t, _term_t>::const_iterator tit = _term.find(der);
+
+  if(tit == _term.end()) {
+    //
+    ErrOut err_out;
+
+    err_out << funame << "derivative signature has not been added to the stencil";
+  }
+
+  if(fval.size() != size()) {
+    //
+    ErrOut err_out;
+
+    err_out << funame << "wrong number of function values: " << fval.size() << ", expected " << size();
+  }
+
+  if(step.size() != dim()) {
+    //
+    ErrOut err_out;
+
+    err_out << funame << "wrong differentiation steps number: " << step.size();
+  }
+
+  double res = 0.;
+  //
+  for(_term_t::const_iterator it = tit->second.begin(); it != tit->second.end(); ++it)
+    //
+    res += (double)it->second * fval[it->first];
+
+  // normalization
+  //
+  for(der_t::const_iterator dit = der.begin(); dit != der.end(); ++dit) {
+    //
+    res /= std::pow(step[dit->first], (double)dit->second);
+    
+    // correction for odd derivatives
+    //
+    if(dit->second % 2)
+      //
+      res /= 2.;
+  }
+
+  return res;
+}
+
 /************************************************************************************************
  ********************************** MULTIDIMENSIONAL INDEX **************************************
  ************************************************************************************************/
@@ -436,17 +517,22 @@ void MultiIndexConvert::resize (const std::vector<int>& s)
 
   std::vector<int>::operator=(s);
 
+  _stride.resize(rank());
+
   if(!rank()) {
     _linear_size = 0;
     return;
   }
   
   _linear_size = 1;
-  for(const_iterator i = begin(); i != end(); _linear_size *= (long)*i++)
-    if(*i < 1) {
+  for(int i = 0; i < rank(); _linear_size *= (long)(*this)[i++]) {
+    if((*this)[i] < 1) {
       std::cerr << funame << "out of range\n";
       throw Error::Range();
     }  
+
+    _stride[i] = _linear_size;
+  }
 }
 
 std::vector<int> MultiIndexConvert::operator() (long lindex) const 
@@ -476,16 +562,14 @@ long MultiIndexConvert::operator() (const std::vector<int>& v) const
   }
 
   long res = 0;
-  long dim = 1;
 
-  const_iterator j = v.begin();
-  for(const_iterator i = begin(); i != end(); dim *= (long)*i++, ++j) {
-    if(*j < 0 || *j >= *i) {
+  for(int i = 0; i < rank(); ++i) {
+    if(v[i] < 0 || v[i] >= (*this)[i]) {
       std::cerr << funame << "out of range\n";
       throw Error::Range();
     }
 
-    res += (long)*j * dim;
+    res += (long)v[i] * _stride[i];
   }
 
   return res;
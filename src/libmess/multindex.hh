@@ -152,11 +152,69 @@ public:
 
   static int order (const der_t& der);
 
+  // union of the displaced configurations for a set of derivative signatures
+  //
+  class Stencil;
+
 private:
 
   void _assert (const der_t&) const;
 };
 
+// the function values are kept in a flat array indexed by the configuration number, and
+// each derivative signature is converted only once into (configuration, coefficient) terms,
+// the configurations shared by different signatures being stored once
+//
+class NumDer::Stencil {
+  //
+  NumDer _numd;
+
+  // configuration number
+  //
+  std::map<std::vector<int>, int> _index;
+
+  // displaced configurations
+  //
+  std::vector<std::vector<int> > _conf;
+
+  typedef std::vector<std::pair<int, int> > _term_t;
+
+  // derivative terms: configuration number and coefficient
+  //
+  std::map<der_t, _term_t> _term;
+
+public:
+  //
+  Stencil () {}
+
+  explicit Stencil (int s) : _numd(s) {}
+
+  // adds the derivative signature configurations
+  //
+  void add (const der_t&);
+
+  // configurational space dimensionality
+  //
+  int dim () const { return _numd.size(); }
+
+  // number of configurations
+  //
+  int size () const { return _conf.size(); }
+
+  // displacements of the configuration in steps
+  //
+  const std::vector<int>& conf (int c) const { return _conf[c]; }
+
+  // numerical derivative from the function values at the stencil configurations
+  //
+  double operator() (const der_t& der, const std::vector<double>& fval, const std::vector<double>& step) const;
+
+  double operator() (const der_t& der, const std::vector<double>& fval, double step) const
+  {
+    return (*this)(der, fval, std::vector<double>(dim(), step));
+  }
+};
+
 inline void NumDer::_check () const
 {
   const char funame [] = "Thermo::NumDer::_check: ";
@@ -302,6 +360,9 @@ int multi2one (const T& pr, int n)
 class MultiIndexConvert : private std::vector<int> {
   long _linear_size;
 
+  // linear index increment per unit step in the given dimension; the first index is the fastest
+  std::vector<long> _stride;
+
 public:
   void resize (const std::vector<int>&) ;
   void resize (int d, int s) { std::vector<int> m(d, s); resize(m); }
@@ -310,14 +371,64 @@ public:
   MultiIndexConvert          (int d, int s)             { resize(d, s); }
   explicit MultiIndexConvert (const std::vector<int> s) { resize(s); }
 
-  int  size (int i) const { return (*this)[i];     }
-  int  rank ()      const { return std::vector<int>::size(); }
-  long size ()      const { return _linear_size; }
+  int  size   (int i) const { return (*this)[i];     }
+  long stride (int i) const { return _stride[i];     }
+  int  rank   ()      const { return std::vector<int>::size(); }
+  long size   ()      const { return _linear_size; }
 
   std::vector<int> operator() (long)                     const ;
   long             operator() (const std::vector<int>&) const ;
   
   long  conjugate (long) const;
+
+  class Iterator;
+};
+
+// walks the linear index range keeping the multi-dimensional index along: the
+// increment carries over the dimensions without the division or the multiplication,
+// and the innermost dimension can be traversed as the contiguous span
+//
+class MultiIndexConvert::Iterator {
+  const MultiIndexConvert* _conv;
+
+  std::vector<int> _index;
+  long             _linear;
+
+public:
+  explicit Iterator (const MultiIndexConvert& c, long l = 0) 
+    : _conv(&c), _index(l < c.size() ? c(l) : std::vector<int>(c.rank())), _linear(l) {}
+
+  bool end () const { return _linear >= _conv->size(); }
+
+  long                  linear ()      const { return _linear; }
+  const std::vector<int>& index ()     const { return _index; }
+  int             operator[] (int i)   const { return _index[i]; }
+
+  // remaining number of the contiguous points in the innermost dimension, the current one included
+  int span () const { return _conv->size(0) - _index[0]; }
+
+  // moves along the innermost dimension by n < span() points
+  void advance (int n) { _index[0] += n; _linear += n; }
+
+  // moves to the beginning of the next span
+  void next_span () { _linear += span() - 1; _index[0] = _conv->size(0) - 1; operator++(); }
+
+  void operator++ ();
+  void operator++ (int) { operator++(); }
 };
 
+inline void MultiIndexConvert::Iterator::operator++ ()
+{
+  ++_linear;
+
+  for(int i = 0; i < _index.size(); ++i) {
+    //
+    if(++_index[i] < _conv->size(i))
+      //
+      return;
+
+    _index[i] = 0;
+  }
+}
+
 #endif
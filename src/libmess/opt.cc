@@ -3,6 +3,9 @@
 #include "key.hh"
 #include "random.hh"
 
+#include <exception>
+#include <list>
+
 #include <boost/numeric/odeint.hpp>
 
 namespace boost {
@@ -40,6 +43,24 @@ double Opt::HardPot::evaluate (const Cartesian& x) const
   return potential(x);
 }
 
+Opt::Cartesian Opt::HardPot::gradient (const Cartesian& x) const
+{
+  const char funame [] = "Opt::HardPot::gradient: ";
+
+  if(atom_size() != x.atom_size()) {
+    //
+    std::cerr << funame << "dimensions mismatch: " << atom_size() << " vs. " << x.atom_size() << "\n";
+
+    throw Error::Logic();
+  }
+
+  Cartesian res(x.size());
+
+  potential(x, res);
+
+  return res;
+}
+
 /**********************************************************************************************************
  ***************************** CONSTRAINED OPTIMIZATION IN CARTESIAN SPACE ********************************
  **********************************************************************************************************/
@@ -111,6 +132,13 @@ void Opt::CcOpt::execute (Coord::Cartesian& x) const
   
   try {
     //
+    if(_method == QUASI_NEWTON) {
+      //
+      _quasi_newton(x);
+
+      IO::log << IO::log_offset << "continuing with the gradient flow integration\n";
+    }
+    
     double time = 0.;
     
     while(1) {
@@ -176,71 +204,397 @@ void Opt::CcOpt::execute (Coord::Cartesian& x) const
   }
 }
 
-void Opt::CcOpt::operator() (const Cartesian& x, Cartesian& dx, double time) const
+// orthonormal basis of the constrain gradients subspace
+//
+void Opt::CcOpt::_constrain_space (const Cartesian& x, std::vector<Cartesian>& cspace) const
 {
-  const char funame [] = "Opt::CcOpt::operator(): ";
+  const char funame [] = "Opt::CcOpt::_constrain_space: ";
 
-  int    itemp;
   double dtemp;
 
-  ++_grad_count;
+  cspace.resize(_constrain.size(), x);
+
+  int cc = 0;
+
+  for(_con_t::const_iterator cit = _constrain.begin(); cit != _constrain.end(); ++cit, ++cc) {
+    //
+    const Cartesian con_grad = (*cit)->gradient(x);
+
+    for(int i = 0; i < x.size(); ++i)
+      //
+      cspace[cc][i] = con_grad[i];
+
+    dtemp = normalize(cspace[cc]);
+
+    if(dtemp == 0.) {
+      //
+      std::cerr << funame << "zero constrain vector\n";
+
+      throw Error::Range();
+    }
+    
+    for(int d = 0; d < cc; ++d)
+      //
+      orthogonalize(cspace[cc], cspace[d]);
+
+    if(cc) {
+      //
+      dtemp = normalize(cspace[cc]);
+    
+      if(dtemp < _ci_tol) {
+	//
+	std::cerr << funame << "constrains are linearly dependent: " << dtemp << " vs " << _ci_tol << "\n";
+
+	throw Error::Run();
+      }
+    }
+  }
+}
+
+// Newton iterations along the constrain gradients back to the constrain values; returns
+// false if they do not converge, in which case the configuration should be discarded
+//
+bool Opt::CcOpt::_restore_constrain (Cartesian& x, const std::vector<double>& cval) const
+{
+  double dtemp;
+
+  const double tol = 1.e-10;
   
-  if(!x.size()) {
+  const int csize = cval.size();
+  
+  if(!csize)
     //
-    std::cerr << funame << "zero configuration space vector dimension\n";
+    return true;
+  
+  for(int iter = 0; iter < 20; ++iter) {
+    //
+    Lapack::Vector res(csize);
 
-    throw Error::Init();
+    double res_max = 0.;
+    
+    int cc = 0;
+    
+    for(_con_t::const_iterator cit = _constrain.begin(); cit != _constrain.end(); ++cit, ++cc) {
+      //
+      dtemp = cval[cc] - (*cit)->evaluate(x);
+
+      if((*cit)->type() == Coord::DIHEDRAL) {
+	//
+	dtemp -= 2. * M_PI * std::floor(dtemp / 2. / M_PI + 0.5);
+      }
+
+      res[cc] = dtemp;
+
+      if(std::fabs(dtemp) > res_max)
+	//
+	res_max = std::fabs(dtemp);
+    }
+
+    if(res_max < tol)
+      //
+      return true;
+
+    std::vector<Cartesian> cgrad;
+
+    for(_con_t::const_iterator cit = _constrain.begin(); cit != _constrain.end(); ++cit)
+      //
+      cgrad.push_back((*cit)->gradient(x));
+
+    Lapack::SymmetricMatrix jj(csize);
+
+    for(int i = 0; i < csize; ++i)
+      //
+      for(int j = i; j < csize; ++j)
+	//
+	jj(i, j) = vdot(cgrad[i], cgrad[j]);
+
+    Lapack::Vector lambda;
+    
+    try {
+      //
+      lambda = Lapack::Cholesky(jj).invert(res);
+    }
+    catch(Error::General) {
+      //
+      return false;
+    }
+
+    for(int i = 0; i < x.size(); ++i)
+      //
+      for(int c = 0; c < csize; ++c)
+	//
+	x[i] += lambda[c] * cgrad[c][i];
   }
 
-  dx.resize(x.size());
+  return false;
+}
+
+// projected limited memory BFGS: the steps and the gradient differences are taken in the
+// tangent subspace of the constrain surface, and every trial configuration is returned onto
+// the surface before the energy is compared
+//
+void Opt::CcOpt::_quasi_newton (Cartesian& x) const
+{
+  const char funame [] = "Opt::CcOpt::_quasi_newton: ";
+
+  double dtemp;
   
-  for(int i = 0; i < dx.size(); ++i)
+  IO::Marker fumarker(funame);
+
+  // constrain values to be kept
+  //
+  std::vector<double> cval;
+
+  if(use_constrain)
     //
-    dx[i] = -pot()->grad(x, i);
+    for(_con_t::const_iterator cit = _constrain.begin(); cit != _constrain.end(); ++cit)
+      //
+      cval.push_back((*cit)->evaluate(x));
 
-  if(use_constrain && _constrain.size()) {
+  // stored steps and (negative) gradient differences
+  //
+  std::list<std::pair<Cartesian, Cartesian> > hist;
+
+  std::list<double> rho;
+  
+  Cartesian grad(x.size()), xnew(x.size()), gnew(x.size());
+  
+  (*this)(x, grad);
+
+  double ener = pot()->evaluate(x);
+
+  int ener_count = 1;
+  
+  IO::log << IO::log_offset
+	  << std::setw(13) << "iteration"
+	  << std::setw(13) << "energy"
+	  << std::setw(13) << "gradient"
+	  << std::setw(13) << "step"
+	  << std::setw(13) << "target"
+	  << "\n";
+
+  for(int iter = 0; iter < _max_iter; ++iter) {
     //
-    // constrain subspace
+    // quasi-Newton direction: the two-loop recursion on the (descent) gradient projection
     //
-    std::vector<Cartesian> cspace(_constrain.size(), x);
+    Cartesian dir = grad;
 
-    int cc = 0;
+    std::vector<double> alpha;
 
-    for(_con_t::const_iterator cit = _constrain.begin(); cit != _constrain.end(); ++cit, ++cc) {
+    std::list<double>::const_iterator rit = rho.begin();
+    
+    for(std::list<std::pair<Cartesian, Cartesian> >::const_iterator hit = hist.begin(); hit != hist.end(); ++hit, ++rit) {
       //
-      for(int i = 0; i < x.size(); ++i)
+      dtemp = *rit * vdot(hit->first, dir);
+
+      alpha.push_back(dtemp);
+
+      for(int i = 0; i < dir.size(); ++i)
 	//
-	cspace[cc][i] = (*cit)->grad(x, i);
+	dir[i] -= dtemp * hit->second[i];
+    }
 
-      dtemp = normalize(cspace[cc]);
+    if(hist.size()) {
+      //
+      dtemp = vdot(hist.front().first, hist.front().second) / vdot(hist.front().second);
 
-      if(dtemp == 0.) {
+      for(int i = 0; i < dir.size(); ++i)
 	//
-	std::cerr << funame << "zero constrain vector\n";
+	dir[i] *= dtemp;
+    }
+    
+    std::list<std::pair<Cartesian, Cartesian> >::const_reverse_iterator hit = hist.rbegin();
 
-	throw Error::Range();
-      }
+    std::list<double>::const_reverse_iterator rrit = rho.rbegin();
     
-      for(int d = 0; d < cc; ++d)
+    for(int h = alpha.size() - 1; h >= 0; --h, ++hit, ++rrit) {
+      //
+      dtemp = alpha[h] - *rrit * vdot(hit->second, dir);
+
+      for(int i = 0; i < dir.size(); ++i)
 	//
-	orthogonalize(cspace[cc], cspace[d]);
+	dir[i] += dtemp * hit->first[i];
+    }
+
+    std::vector<Cartesian> cspace;
+    
+    if(cval.size()) {
+      //
+      _constrain_space(x, cspace);
+
+      for(int cc = 0; cc < cspace.size(); ++cc)
+	//
+	orthogonalize(dir, cspace[cc]);
+    }
+
+    // not a descent direction: restart from the steepest descent
+    //
+    if(vdot(dir, grad) <= 0.) {
+      //
+      hist.clear();
+
+      rho.clear();
+
+      dir = grad;
+    }
 
-      if(cc) {
+    dtemp = vlength(dir);
+
+    if(dtemp > _max_step)
+      //
+      for(int i = 0; i < dir.size(); ++i)
 	//
-	dtemp = normalize(cspace[cc]);
+	dir[i] *= _max_step / dtemp;
+
+    // backtracking line search with the sufficient decrease condition
+    //
+    const double slope = vdot(dir, grad);
+
+    double ener_new;
     
-	if(dtemp < _ci_tol) {
-	  //
-	  std::cerr << funame << "constrains are linearly dependent: " << dtemp << " vs " << _ci_tol << "\n";
+    double fac = 1.;
 
-	  throw Error::Run();
-	}
+    bool isok = false;
+    
+    for(int ls = 0; ls < 30; ++ls, fac /= 2.) {
+      //
+      for(int i = 0; i < x.size(); ++i)
+	//
+	xnew[i] = x[i] + fac * dir[i];
+
+      if(!_restore_constrain(xnew, cval))
+	//
+	continue;
+
+      ener_new = pot()->evaluate(xnew);
+
+      ++ener_count;
+
+      if(ener_new <= ener - 1.e-4 * fac * slope) {
+	//
+	isok = true;
+
+	break;
       }
     }
 
+    if(!isok) {
+      //
+      if(hist.size()) {
+	//
+	hist.clear();
+
+	rho.clear();
+
+	continue;
+      }
+
+      IO::log << IO::log_offset << "line search failed\n";
+
+      break;
+    }
+
+    (*this)(xnew, gnew);
+
+    // step and gradient difference, tangent to the constrain surface at the new configuration
+    //
+    Cartesian step(x.size()), gdif(x.size());
+
+    for(int i = 0; i < x.size(); ++i) {
+      //
+      step[i] = xnew[i] - x[i];
+
+      gdif[i] = grad[i] - gnew[i];
+    }
+
+    if(cval.size()) {
+      //
+      _constrain_space(xnew, cspace);
+
+      for(int cc = 0; cc < cspace.size(); ++cc) {
+	//
+	orthogonalize(step, cspace[cc]);
+
+	orthogonalize(gdif, cspace[cc]);
+      }
+    }
+
+    dtemp = vdot(step, gdif);
+
+    // curvature condition
+    //
+    if(dtemp > 1.e-10 * vlength(step) * vlength(gdif)) {
+      //
+      hist.push_front(std::make_pair(step, gdif));
+
+      rho.push_front(1. / dtemp);
+
+      if(hist.size() > _qn_size) {
+	//
+	hist.pop_back();
+
+	rho.pop_back();
+      }
+    }
+    
+    x    = xnew;
+    grad = gnew;
+    ener = ener_new;
+
+    dtemp = vlength(grad);
+    
+    IO::log << IO::log_offset
+	    << std::setw(13) << iter + 1
+	    << std::setw(13) << ener
+	    << std::setw(13) << dtemp
+	    << std::setw(13) << fac * vlength(dir)
+	    << std::setw(13) << _grad_tol
+	    << std::endl;
+
+    if(dtemp < _grad_tol) {
+      //
+      IO::log << IO::log_offset << "energy calls #         = " << std::setw(13) << ener_count << "\n";
+
+      throw _Fin();
+    }
+  }
+
+  IO::log << IO::log_offset << "quasi-Newton minimization did not converge, energy calls # = " << ener_count << "\n";
+}
+
+void Opt::CcOpt::operator() (const Cartesian& x, Cartesian& dx, double time) const
+{
+  const char funame [] = "Opt::CcOpt::operator(): ";
+
+  int    itemp;
+  double dtemp;
+
+  ++_grad_count;
+  
+  if(!x.size()) {
+    //
+    std::cerr << funame << "zero configuration space vector dimension\n";
+
+    throw Error::Init();
+  }
+
+  dx.resize(x.size());
+  
+  const Cartesian pot_grad = pot()->gradient(x);
+
+  for(int i = 0; i < dx.size(); ++i)
+    //
+    dx[i] = -pot_grad[i];
+
+  if(use_constrain && _constrain.size()) {
+    //
+    std::vector<Cartesian> cspace;
+
+    _constrain_space(x, cspace);
+
     // potential gradient component, orthogonal to constrain subspace
     //
-    for(cc = 0; cc < cspace.size(); ++cc)
+    for(int cc = 0; cc < cspace.size(); ++cc)
       //
       orthogonalize(dx, cspace[cc]);
   }
@@ -276,6 +630,10 @@ void Opt::CcOpt::set (std::istream& from)
   Key  cit_key("ConstrainIndependenceTolerance");
   Key step_key("IntegrationStep"               );
   Key time_key("IntegrationTime"               );
+  Key  met_key("Method"                        );
+  Key  mem_key("QuasiNewtonMemory"             );
+  Key  mst_key("MaximalStep[bohr]"             );
+  Key  mit_key("MaximalIterations"             );
     
   std::string token, comment, stemp;
 
@@ -361,6 +719,86 @@ void Opt::CcOpt::set (std::istream& from)
 	throw Error::Range();
       }
     }
+    // optimization method
+    //
+    else if(token == met_key) {
+      //
+      if(!(from >> stemp)) {
+	//
+	std::cerr << funame << token << ": corrupted\n";
+
+	throw Error::Input();
+      }
+
+      if(stemp == "gradient-flow") {
+	//
+	_method = GRADIENT_FLOW;
+      }
+      else if(stemp == "quasi-newton") {
+	//
+	_method = QUASI_NEWTON;
+      }
+      else {
+	//
+	std::cerr << funame << token << ": unknown method: " << stemp << ": available methods: gradient-flow, quasi-newton\n";
+
+	throw Error::Range();
+      }
+    }
+    // number of the stored quasi-Newton steps
+    //
+    else if(token == mem_key) {
+      //
+      if(!(from >> _qn_size)) {
+	//
+	std::cerr << funame << token << ": corrupted\n";
+
+	throw Error::Input();
+      }
+
+      if(_qn_size <= 0) {
+	//
+	std::cerr << funame << token << ": out of range: " << _qn_size << "\n";
+
+	throw Error::Range();
+      }
+    }
+    // maximal quasi-Newton step length
+    //
+    else if(token == mst_key) {
+      //
+      if(!(from >> _max_step)) {
+	//
+	std::cerr << funame << token << ": corrupted\n";
+
+	throw Error::Input();
+      }
+
+      if(_max_step <= 0.) {
+	//
+	std::cerr << funame << token << ": out of range: " << _max_step << "\n";
+
+	throw Error::Range();
+      }
+    }
+    // maximal quasi-Newton iterations number
+    //
+    else if(token == mit_key) {
+      //
+      if(!(from >> _max_iter)) {
+	//
+	std::cerr << funame << token << ": corrupted\n";
+
+	throw Error::Input();
+      }
+
+      if(_max_iter <= 0) {
+	//
+	std::cerr << funame << token << ": out of range: " << _max_iter << "\n";
+
+	throw Error::Range();
+      }
+    }
     // unknown keyword
     //
     else if(IO::skip_comment(token, from)) {
@@ -403,6 +841,10 @@ int Opt::ZOpt::max_opt_count = 100;
 //
 double Opt::ZOpt::diff_step = .001;
 
+// anharmonic correction relative error at which the sampling stops, no stop if zero
+//
+double Opt::ZOpt::sampling_tol = 0.;
+
 // potential
 //
 ConstSharedPointer<Coord::CartFun> Opt::ZOpt::pot;
@@ -439,10 +881,11 @@ double Opt::ZOpt::_con_pot (const std::vector<double>& cpos) const
   return pot->evaluate((Cartesian)zpos);
 }
 
+// the displaced positions are evaluated concurrently
+//
 Lapack::Vector Opt::ZOpt::_con_grad () const
 {
   int    itemp;
-  double dtemp;
   
   std::vector<double> cpos(_con_modes.size());
 
@@ -454,30 +897,50 @@ Lapack::Vector Opt::ZOpt::_con_grad () const
 
   Lapack::Vector res(_con_modes.size());
 
+  std::exception_ptr error;
+
+#pragma omp parallel for default(shared) schedule(dynamic)
+
   for(int i  = 0; i < _con_modes.size(); ++i) {
     //
-    cpos[i] += diff_step;
+    try {
+      //
+      std::vector<double> pos = cpos;
 
-    res[i] = _con_pot(cpos);
+      pos[i] += diff_step;
 
-    cpos[i] -= 2. * diff_step;
+      double dtemp = _con_pot(pos);
 
-    res[i] -= _con_pot(cpos);
+      pos[i] -= 2. * diff_step;
 
-    cpos[i] += diff_step;
+      dtemp -= _con_pot(pos);
     
-    res[i] /= 2. * diff_step;
+      res[i] = dtemp / (2. * diff_step);
+    }
+    catch(...) {
+      //
+#pragma omp critical(con_grad_error)
+
+      if(!error)
+	//
+	error = std::current_exception();
+    }
   }
 
+  if(error)
+    //
+    std::rethrow_exception(error);
+
   return res;
 }
 
 Lapack::SymmetricMatrix Opt::ZOpt::_con_hess () const
 {
   int    itemp;
-  double dtemp;
   
-  std::vector<double> cpos(_con_modes.size());
+  const int csize = _con_modes.size();
+
+  std::vector<double> cpos(csize);
 
   itemp = 0;
   
@@ -487,52 +950,77 @@ Lapack::SymmetricMatrix Opt::ZOpt::_con_hess () const
 
   const double e0 = _con_pot(cpos);
 
-  Lapack::SymmetricMatrix res(_con_modes.size());
+  Lapack::SymmetricMatrix res(csize);
+
+  std::exception_ptr error;
+
+  // upper triangle elements, one per task
+  //
+#pragma omp parallel for default(shared) schedule(dynamic)
 
-  for(int i  = 0; i < _con_modes.size(); ++i)
+  for(int ij = 0; ij < csize * csize; ++ij) {
     //
-    for(int j  = i; j < _con_modes.size(); ++j)
+    const int i = ij / csize;
+    const int j = ij % csize;
+
+    if(j < i)
+      //
+      continue;
+
+    double dtemp;
+
+    try {
       //
+      std::vector<double> pos = cpos;
+
       if(i != j) {
 	//
-	cpos[i] += diff_step;
+	pos[i] += diff_step;
 
-	cpos[j] += diff_step;
+	pos[j] += diff_step;
 	
-	res(i, j) = _con_pot(cpos);
+	dtemp = _con_pot(pos);
 
-	cpos[i] -= 2. * diff_step;
+	pos[i] -= 2. * diff_step;
 
-	res(i, j) -= _con_pot(cpos);
+	dtemp -= _con_pot(pos);
 
-	cpos[j] -= 2. * diff_step;
+	pos[j] -= 2. * diff_step;
 
-	res(i, j) += _con_pot(cpos);
+	dtemp += _con_pot(pos);
 
-	cpos[i] += 2. * diff_step;
+	pos[i] += 2. * diff_step;
 
-	res(i, j) -= _con_pot(cpos);
+	dtemp -= _con_pot(pos);
 
-	cpos[i] -= diff_step;
-	
-	cpos[j] += diff_step;
-	
-	res(i, j) /= 4. * diff_step * diff_step;
+	res(i, j) = dtemp / (4. * diff_step * diff_step);
       }
       else {
 	//
-	cpos[i] += diff_step;
+	pos[i] += diff_step;
 	
-	res(i, i) = _con_pot(cpos) - 2. * e0;
+	dtemp = _con_pot(pos) - 2. * e0;
 
-	cpos[i] -= 2. * diff_step;
+	pos[i] -= 2. * diff_step;
 
-	res(i, i) += _con_pot(cpos);
+	dtemp += _con_pot(pos);
 
-	cpos[i] += diff_step;
-	
-	res(i, i) /= diff_step * diff_step;
+	res(i, i) = dtemp / (diff_step * diff_step);
       }
+    }
+    catch(...) {
+      //
+#pragma omp critical(con_hess_error)
+
+      if(!error)
+	//
+	error = std::current_exception();
+    }
+  }
+
+  if(error)
+    //
+    std::rethrow_exception(error);
 
   return res;
 }
@@ -653,122 +1141,315 @@ Opt::ZOpt::ZOpt (const ZData& zinit, const mode_t& cm) : _zmin(zinit), _con_mode
   _ener_min = pot->evaluate((Cartesian)_zmin);
 }
 
-double Opt::ZOpt::anharmonic_correction (double temperature, int count_max, double* rerr, int* fail) const
+// one importance sampling point drawn from the harmonic distribution at the reference
+// temperature; false if the point is out of the sampling limits
+//
+bool Opt::ZOpt::_sample (double temperature, Random::Stream& rng, _Point& res) const
 {
   const char funame [] = "Opt::ZOpt::anharmonic_correction: ";
 
-  static const double exp_pow_max = 100.;
-
   double dtemp;
   int    itemp;
-  bool   btemp;
-  
+
   const double tsqrt = std::sqrt(temperature);
 
   Lapack::Vector vtemp(_con_modes.size());
 
-  double res = 0., var =  0.;
+  double eref = 0.;
 
-  int skip = 0;
+  for(int i = 0; i < _con_modes.size(); ++i) {
+    //
+    dtemp = rng.norm();
 
-  // sampling cycle
-  //
-  for(int count = 0; count < count_max; ++count) {
+    eref += dtemp * dtemp;
+    
+    vtemp[i] = dtemp / _fc_eval_sqrt[i] * tsqrt;
+  }
+
+  eref *= temperature / 2.;
+
+  vtemp = _fc_evec * vtemp;
+
+  ZData ztemp = _zmin;
+
+  itemp = 0;
+
+  for(mode_t::const_iterator cit = _con_modes.begin(); cit != _con_modes.end(); ++cit, ++itemp) {
     //
-    double eref = 0.;
+    dtemp = ztemp[cit->first] + vtemp[itemp];
 
-    for(int i = 0; i < _con_modes.size(); ++i) {
+    // check that the non-fluxional coordinate is in the allowed window
+    //
+    if(dtemp < cit->second.first || dtemp > cit->second.second) {
       //
-      dtemp = Random::norm();
+      switch(ztemp.type(cit->first)) {
+	//
+      case DISTANCE:
+	//
+	dtemp /= Phys_const::angstrom;
 
-      eref += dtemp * dtemp;
-    
-      vtemp[i] = dtemp / _fc_eval_sqrt[i] * tsqrt;
+	break;
+	  
+      default:
+	//
+	dtemp *= 180. / M_PI;
+      }
+
+#pragma omp critical(zopt_log)
+      {
+	IO::log << funame << "WARNING: T = " << temperature / Phys_const::kelv
+		<< "K, z-matrix variable " << cit->first << " out of limits: " << dtemp << "\n";
+      }
+      
+      return false;
     }
 
-    eref *= temperature / 2.;
+    ztemp[cit->first] = dtemp;
+  }
 
-    vtemp = _fc_evec * vtemp;
+  res.harm = eref;
+  
+  res.pot = pot->evaluate((Cartesian)ztemp) - _ener_min;
 
-    ZData ztemp = _zmin;
+  res.jac = 1. / Lapack::Cholesky(ztemp.mobility_matrix()).det_sqrt()
+    * std::sqrt(product(ztemp.inertia_moments())) / mass_factor();
 
-    itemp = 0;
+  return true;
+}
+
+// the point statistical weight relative to the harmonic one at the temperature: the
+// harmonic density ratio to the reference temperature is folded into the exponent;
+// false if the point is too low in energy
+//
+bool Opt::ZOpt::_weight (const _Point& point, double tref, double temperature, double& res) const
+{
+  const char funame [] = "Opt::ZOpt::anharmonic_correction: ";
+
+  static const double exp_pow_max = 100.;
+
+  double dtemp = point.pot / temperature - point.harm / tref;
+
+  if(temperature != tref)
+    //
+    dtemp -= (double)_con_modes.size() / 2. * std::log(tref / temperature);
+
+  res = 0.;
+
+  if(dtemp > exp_pow_max)
+    //
+    return true;
+
+  if(dtemp < -exp_pow_max) {
+    //
+#pragma omp critical(zopt_log)
+    {
+      IO::log << funame << "WARNING: anharmonic correction too negative at T = " << temperature / Phys_const::kelv << "K: "
+	      << dtemp * temperature / Phys_const::kcal << " kcal/mol: skipping the point" << std::endl;
+    }
+    
+    return false;
+  }
+
+  res = std::exp(-dtemp) * point.jac;
 
-    btemp = false;
+  return true;
+}
+
+double Opt::ZOpt::anharmonic_correction (double temperature, int count_max, double* rerr, int* fail) const
+{
+  std::vector<double> err;
+
+  std::vector<int> skip;
   
-    for(mode_t::const_iterator cit = _con_modes.begin(); cit != _con_modes.end(); ++cit, ++itemp) {
+  const double res = anharmonic_correction(std::vector<double>(1, temperature), count_max, &err, &skip)[0];
+
+  if(rerr)
+    //
+    *rerr = err[0];
+
+  if(fail)
+    //
+    *fail = skip[0];
+
+  return res;
+}
+
+// the samplings are made in blocks, each drawing from its own random stream of the
+// seed taken from the calling thread stream, so that the result does not depend on
+// the number of threads; the error is checked after each round of blocks; the points
+// are drawn once at the highest temperature and reweighted for the others
+//
+std::vector<double> Opt::ZOpt::anharmonic_correction (const std::vector<double>& temperature, int count_max,
+						      std::vector<double>* rerr, std::vector<int>* fail) const
+{
+  const char funame [] = "Opt::ZOpt::anharmonic_correction: ";
+
+  static const int block_size = 64;
+
+  static const int round_size = 16; // blocks per round
+
+  const int tsize = temperature.size();
+  
+  if(!tsize) {
+    //
+    std::cerr << funame << "no temperatures\n";
+
+    throw Error::Init();
+  }
+
+  double tref = 0.;
+
+  for(int t = 0; t < tsize; ++t)
+    //
+    if(temperature[t] > tref)
       //
-      dtemp = ztemp[cit->first] + vtemp[itemp];
+      tref = temperature[t];
+
+  uint64_t seed = Random::stream().word();
+
+  seed = seed << 32 | Random::stream().word();
+
+  const int block_max = (count_max + block_size - 1) / block_size;
 
-      // check that the non-fluxional coordinate is in the allowed window
+  std::vector<double> res(tsize), var(tsize), err(tsize);
+
+  std::vector<int> skip(tsize), count(tsize);
+
+  // sampling rounds
+  //
+  for(int block_begin = 0; block_begin < block_max; block_begin += round_size) {
+    //
+    const int block_end = block_begin + round_size < block_max ? block_begin + round_size : block_max;
+
+    const int bsize = block_end - block_begin;
+    
+    // block, temperature index
+    //
+    std::vector<double> block_sum(bsize * tsize), block_var(bsize * tsize);
+
+    std::vector<int> block_skip(bsize * tsize), block_count(bsize);
+
+    std::exception_ptr error;
+
+#pragma omp parallel for default(shared) schedule(dynamic)
+    //
+    for(int b = block_begin; b < block_end; ++b) {
       //
-      if(dtemp < cit->second.first || dtemp > cit->second.second) {
+      try {
 	//
-	switch(ztemp.type(cit->first)) {
+	Random::Stream rng(seed, b);
+
+	const int bi = b - block_begin;
+
+	const int size = (b + 1) * block_size < count_max ? block_size : count_max - b * block_size;
+
+	// the potential is evaluated once per point
+	//
+	std::vector<_Point> point;
+
+	point.reserve(size);
+
+	int out = 0;
+	
+	_Point ptemp;
+	
+	for(int i = 0; i < size; ++i)
 	  //
-	case DISTANCE:
+	  if(_sample(tref, rng, ptemp)) {
+	    //
+	    point.push_back(ptemp);
+	  }
+	  else
+	    //
+	    ++out;
+
+	for(int t = 0; t < tsize; ++t) {
 	  //
-	  dtemp /= Phys_const::angstrom;
+	  double sum = 0., sum2 = 0., dtemp;
 
-	  break;
+	  int tskip = out;
 	  
-	default:
-	  //
-	  dtemp *= 180. / M_PI;
+	  for(int i = 0; i < point.size(); ++i)
+	    //
+	    if(_weight(point[i], tref, temperature[t], dtemp)) {
+	      //
+	      sum  += dtemp;
+
+	      sum2 += dtemp * dtemp;
+	    }
+	    else
+	      //
+	      ++tskip;
+
+	  block_sum [bi * tsize + t] = sum;
+	  block_var [bi * tsize + t] = sum2;
+	  block_skip[bi * tsize + t] = tskip;
 	}
 
-	IO::log << funame << "WARNING: T = " << temperature / Phys_const::kelv
-		<< "K, z-matrix variable " << cit->first << " out of limits: " << dtemp << "\n";
-
-	++skip;
-	
-	btemp = true;
-
-	break;
+	block_count[bi] = size;
+      }
+      catch(...) {
+	//
+#pragma omp critical(zopt_error)
+	//
+	error = std::current_exception();
       }
-
-      ztemp[cit->first] = dtemp;
     }
 
-    if(btemp)
+    if(error)
       //
-      continue;
+      std::rethrow_exception(error);
 
-    dtemp = (pot->evaluate((Cartesian)ztemp) - eref - _ener_min) / temperature;
+    double err_max = 0.;
 
-    if(dtemp > exp_pow_max)
+    bool isok = true;
+    
+    for(int t = 0; t < tsize; ++t) {
       //
-      continue;
+      for(int bi = 0; bi < bsize; ++bi) {
+	//
+	res[t]   += block_sum [bi * tsize + t];
+	var[t]   += block_var [bi * tsize + t];
+	skip[t]  += block_skip[bi * tsize + t];
+	count[t] += block_count[bi];
+      }
 
-    if(dtemp < -exp_pow_max) {
+      // running relative error
       //
-      IO::log << funame << "WARNING: anharmonic correction too negative at T = " << temperature / Phys_const::kelv << "K: "
-	      << dtemp * temperature / Phys_const::kcal << " kcal/mol: skipping the point" << std::endl;
+      const double mean = res[t] / (double)count[t];
 
-      ++skip;
-      
-      continue;
-    }
+      const double dtemp = var[t] / (double)count[t] - mean * mean;
 
-    dtemp = std::exp(-dtemp) / Lapack::Cholesky(ztemp.mobility_matrix()).det_sqrt()
-      * std::sqrt(product(ztemp.inertia_moments())) / mass_factor();
+      err[t] = mean > 0. && dtemp > 0. ? std::sqrt(dtemp / (double)count[t]) / mean : 0.;
 
-    res += dtemp;
+      if(mean <= 0.)
+	//
+	isok = false;
 
-    var += dtemp * dtemp;
-    //
-  }// sampling cycle
-  //
+      if(err[t] > err_max)
+	//
+	err_max = err[t];
+    }
 
-  res /= (double)count_max;
+    if(sampling_tol > 0. && isok && err_max < sampling_tol && block_end < block_max) {
+      //
+      IO::log << IO::log_offset << funame << "T = " << tref / Phys_const::kelv
+	      << "K: maximal relative error " << err_max << " reached after " << count[0] << " samplings\n";
 
-  var /= (double)count_max;
+      break;
+    }
+  }// sampling rounds
+  //
+
+  for(int t = 0; t < tsize; ++t)
+    //
+    res[t] /= (double)count[t];
 
-  // relative error
+  // relative errors
   //
   if(rerr)
     //
-    *rerr = std::sqrt(var - res * res) / res / std::sqrt((double)count_max);
+    *rerr = err;
 
   // failed points #
   //
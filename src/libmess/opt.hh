@@ -21,6 +21,7 @@
 #include "harding.hh"
 #include "linpack.hh"
 #include "lapack.hh"
+#include "random.hh"
 
 // molecular geometry optimization
 
@@ -40,6 +41,10 @@ namespace Opt {
     
     double evaluate (const Cartesian&) const;
 
+    // analytic gradient
+    //
+    Cartesian gradient (const Cartesian&) const;
+
     int atom_size () const { return Harding::atom_size(); }
   };
     
@@ -82,12 +87,37 @@ namespace Opt {
     // end of integration exception
     //
     class _Fin {};
+
+    // optimization method
+    //
+    int _method;
+
+    // quasi-Newton: number of the stored steps, maximal step length, and maximal iterations number
+    //
+    int    _qn_size;
+    double _max_step;
+    int    _max_iter;
+
+    // orthonormal basis of the constrain gradients subspace
+    //
+    void _constrain_space (const Cartesian&, std::vector<Cartesian>&) const;
+
+    // returns the configuration onto the constrain surface
+    //
+    bool _restore_constrain (Cartesian&, const std::vector<double>&) const;
+
+    // projected limited memory BFGS minimization; throws _Fin when converged
+    //
+    void _quasi_newton (Cartesian&) const;
     
   public:
     //
+    enum {GRADIENT_FLOW, QUASI_NEWTON};
+    
     mutable int use_constrain;
     
-    CcOpt () : _grad_tol(1.e-5), _time_step(0.1), _time_length(1.e5), _ci_tol(1.e-5), use_constrain(1) {}
+    CcOpt () : _grad_tol(1.e-5), _time_step(0.1), _time_length(1.e5), _ci_tol(1.e-5),
+	       _method(GRADIENT_FLOW), _qn_size(10), _max_step(0.3), _max_iter(1000), use_constrain(1) {}
 
     void set (std::istream&);
     
@@ -194,14 +224,38 @@ namespace Opt {
     //
     Lapack::SymmetricMatrix _con_hess () const;
 
+    // importance sampling point: the harmonic energy at the sampling temperature, the
+    // potential energy relative to the minimum, and the kinematic factor
+    //
+    struct _Point {
+      //
+      double harm;
+      double pot;
+      double jac;
+    };
+
+    bool _sample (double, Random::Stream&, _Point&) const;
+
+    // point statistical weight at the temperature for the reference sampling temperature
+    //
+    bool _weight (const _Point&, double, double, double&) const;
+
   public:
     //
     ZOpt (const ZData&, const mode_t&);
  
-    // partition function unharmonic correction by importance sampling 
+    // partition function unharmonic correction by importance sampling: the samplings
+    // number, the relative error, and the failed samplings number; the sampling stops
+    // before the samplings number is reached if the sampling tolerance is set
     //
     double anharmonic_correction (double, int, double* =0, int* =0) const;
 
+    // the same for the temperatures list: the points are sampled at the highest temperature
+    // and reweighted for each, with the relative errors and the failed samplings numbers
+    // per temperature; the sampling tolerance is applied to the largest relative error
+    //
+    std::vector<double> anharmonic_correction (const std::vector<double>&, int, std::vector<double>* =0, std::vector<int>* =0) const;
+
     double mass_factor () const { return _mass_factor; }
 
     // non-fluxional modes force constant factor
@@ -234,6 +288,10 @@ namespace Opt {
     //
     static double diff_step;
 
+    // relative error at which the importance sampling stops
+    //
+    static double sampling_tol;
+
     // no convergence exception
     //
     class NoConv {};
@@ -15,6 +15,7 @@
 
 #include <map>
 #include <cstdlib>
+#include <unordered_set>
 
 #include "permutation.hh"
 #include "io.hh"
@@ -47,8 +48,18 @@ int Permutation::factorial (int n)
   }
 }
   
+void Permutation::_resize (int n)
+{
+  _size = n;
+
+  if(n > CAPACITY)
+    _heap.resize(n);
+  else
+    _heap.clear();
+}
+
 Permutation::Permutation (int n)
-  : _end(false)
+  : _size(0), _end(false)
 {
   Exception::Base funame = "Permutation::Permutation: ";
 
@@ -60,13 +71,13 @@ Permutation::Permutation (int n)
     return;
   }
 
-  resize(n);
+  _resize(n);
   for(int i = 0; i < n; ++i)
-    std::vector<int>::operator[](i) = i;
+    _data()[i] = i;
 }
 
 Permutation::Permutation (const std::vector<int>& p, int flags)
-  : std::vector<int>(p), _end(false)
+  : _size(0), _end(false)
 {
   Exception::Base funame = "Permutation::Permutation: ";
 
@@ -75,6 +86,10 @@ Permutation::Permutation (const std::vector<int>& p, int flags)
     return;
   }
 
+  _resize(p.size());
+  for(int i = 0; i < _size; ++i)
+    _data()[i] = p[i];
+
   if(flags & NOCHECK) 
     return;
 
@@ -97,30 +112,31 @@ Permutation::Permutation (const std::vector<int>& p, int flags)
 
 // two elements permutation
 Permutation::Permutation (int i1, int i2, int s)
-  : std::vector<int>(s), _end(false)
+  : _size(0), _end(false)
 {
   if(s < 2 || i1 < 0 || i2 < 0 || i1 >= s || i2 >= s || i1 == i2)
     throw Exception::Base() << "Permutation::Permutation: indices out of range: " << i1 << ", " <<  i2 << ", " << s;
 
+  _resize(s);
   for(int i = 0; i < size(); ++i)
     if(i == i1)
-      std::vector<int>::operator[](i) = i2;
+      _data()[i] = i2;
     else if(i == i2)
-      std::vector<int>::operator[](i) = i1;
+      _data()[i] = i1;
     else
-      std::vector<int>::operator[](i) = i;
+      _data()[i] = i;
 }
 
 // permutation from orbit
 Permutation::Permutation (const std::set<std::vector<int> >& orbit, int s)
-  : _end(false)
+  : _size(0), _end(false)
 {
   Exception::Base funame = "Permutation::Permutation: ";
   
   if(s <= 0)
     throw funame << "non-positive size";
 
-  resize(s);
+  _resize(s);
 
   // elements pool
   std::set<int> pool;
@@ -128,7 +144,7 @@ Permutation::Permutation (const std::set<std::vector<int> >& orbit, int s)
     if(!ot->size())
       throw funame << "zero orbit";
 
-    for(const_iterator it = ot->begin(); it != ot->end(); ++it)
+    for(std::vector<int>::const_iterator it = ot->begin(); it != ot->end(); ++it)
       if(!pool.insert(*it).second)
 	throw funame << "duplicate elements";
   }
@@ -139,18 +155,18 @@ Permutation::Permutation (const std::set<std::vector<int> >& orbit, int s)
       throw funame << "orbit element(s) out of range";
 
     for(std::set<std::vector<int> >::const_iterator ot = orbit.begin(); ot != orbit.end(); ++ot)
-      for(const_iterator it = ot->begin(); it != ot->end(); ++it) {
-	const_iterator jt = it + 1;
+      for(std::vector<int>::const_iterator it = ot->begin(); it != ot->end(); ++it) {
+	std::vector<int>::const_iterator jt = it + 1;
 	if(jt == ot->end())
 	  jt = ot->begin();
-	std::vector<int>::operator[](*it) = *jt;
+	_data()[*it] = *jt;
       }
   }
 
   // update with identical permutations
   for(int i = 0; i < size(); ++i)
     if(pool.find(i) == pool.end())
-      std::vector<int>::operator[](i) = i;
+      _data()[i] = i;
 }
 
 Permutation Permutation::operator* (const Permutation& p) const
@@ -160,20 +176,64 @@ Permutation Permutation::operator* (const Permutation& p) const
   if(p.size() != size())
     throw funame << "dimensions mismatch";
     
-  std::vector<int> res(size());
+  // the product of permutations is a permutation: no checking
+  Permutation res;
+  res._end = false;
+  res._resize(size());
+
+  const int* pp = p._data();
+  const int* tp = _data();
+  int*       rp = res._data();
+
   for(int i = 0; i < size(); ++i)
-    res[i] = (*this)[p[i]];
+    rp[i] = tp[pp[i]];
 
-  return Permutation(res);
+  return res;
 }
 
 Permutation Permutation::invert () const 
 {
-  std::vector<int> res(size());
+  Permutation res;
+  res._end = !size();
+  res._resize(size());
+
+  const int* tp = _data();
+  int*       rp = res._data();
+
+  for(int i = 0; i < size(); ++i)
+    rp[tp[i]] = i;
+
+  return res;   
+}
+
+bool Permutation::operator== (const Permutation& p) const
+{
+  if(size() != p.size())
+    throw Exception::Base() << "Permutation::operator==: sizes mismatch";
+
+  const int* pp = p._data();
+  const int* tp = _data();
+
   for(int i = 0; i < size(); ++i)
-    res[(*this)[i]] = i;
+    if(tp[i] != pp[i])
+      return false;
 
-  return Permutation(res);   
+  return true;
+}
+
+std::size_t Permutation::hash () const
+{
+  // FNV-1a over the elements
+  std::size_t res = 2166136261U;
+
+  const int* tp = _data();
+
+  for(int i = 0; i < size(); ++i) {
+    res ^= (std::size_t)tp[i];
+    res *= 16777619U;
+  }
+
+  return res;
 }
 
 int Permutation::_compare (const Permutation& p) const
@@ -183,11 +243,13 @@ int Permutation::_compare (const Permutation& p) const
   if(size() != p.size())
     throw funame << "sizes mismatch";
 
-  std::vector<int>::const_iterator pit = p.begin();
-  for(std::vector<int>::const_iterator it = begin(); it != std::vector<int>::end(); ++it, ++pit)
-    if(*it < *pit)
+  const int* pp = p._data();
+  const int* tp = _data();
+
+  for(int i = 0; i < size(); ++i)
+    if(tp[i] < pp[i])
       return -1;
-    else if(*it > *pit)
+    else if(tp[i] > pp[i])
       return  1;
 
   return 0;
@@ -202,22 +264,24 @@ void Permutation::operator++ ()
   std::set<int> pool;
   std::set<int>::const_iterator p;
 
-  for(reverse_iterator i = rbegin(); i != rend(); ++i) {
-    p = pool.insert(*i).first;
+  int* tp = _data();
+
+  for(int i = size() - 1; i >= 0; --i) {
+    p = pool.insert(tp[i]).first;
 
     if(++p != pool.end()) {
-      *i = *p;
+      tp[i] = *p;
       pool.erase(p);
       std::set<int>::const_reverse_iterator  q = pool.rbegin();
-      for(reverse_iterator j = rbegin(); j != i; ++j, ++q)
-	*j = *q;
+      for(int j = size() - 1; j != i; --j, ++q)
+	tp[j] = *q;
       return;
     }
   }
 
   std::set<int>::const_reverse_iterator  q = pool.rbegin();
-  for(reverse_iterator j = rbegin(); j != rend(); ++j, ++q)
-    *j = *q;
+  for(int j = size() - 1; j >= 0; --j, ++q)
+    tp[j] = *q;
 
   _end = true;
 }
@@ -229,17 +293,17 @@ std::set<std::vector<int> > Permutation::orbit () const
   int          itemp;
   std::set<int> done;
 
-  for(const_iterator pit = begin();  pit != std::vector<int>::end(); ++pit)
-    if(done.find(*pit) == done.end()) {
+  for(int i = 0; i < size(); ++i)
+    if(done.find((*this)[i]) == done.end()) {
 
       std::vector<int> orb;
 
-      itemp = *pit;
+      itemp = (*this)[i];
       do {
 	orb.push_back(itemp);
 	done.insert(itemp);
 	itemp = (*this)[itemp];
-      } while(itemp != *pit);
+      } while(itemp != (*this)[i]);
 
       if(orb.size() > 1)
 	res.insert(orb);
@@ -332,8 +396,6 @@ std::set<Permutation> permutation_group (const std::set<Permutation>& base)
 
   std::set<Permutation> res = base;
 
-  bool btemp;
-
   if(!res.size() || !res.begin()->size())
     throw funame << "no permutation";
 
@@ -342,21 +404,21 @@ std::set<Permutation> permutation_group (const std::set<Permutation>& base)
     if(i->size() != res.begin()->size())
       throw funame << "sizes mismatch";
 
-  do {
-    btemp = false;
-    for(std::set<Permutation>::const_iterator i = res.begin(); i != res.end(); ++i) {
-      for(std::set<Permutation>::const_iterator j = res.begin(); j != res.end(); ++j) {
-	Permutation ij = *i * *j;
-	if(res.find(ij) == res.end()) {
-	  res.insert(ij);
-	  btemp = true;
-	  break;
-	}
-      }
-      if(btemp)
-	break;
+  // closure: every element is multiplied by the generators only once
+  typedef std::unordered_set<Permutation, Permutation::Hash> pool_t;
+
+  pool_t pool(res.begin(), res.end());
+
+  std::vector<Permutation> queue(res.begin(), res.end());
+
+  for(int i = 0; i < queue.size(); ++i)
+    for(std::set<Permutation>::const_iterator g = base.begin(); g != base.end(); ++g) {
+      Permutation p = queue[i] * *g;
+      if(pool.insert(p).second)
+	queue.push_back(p);
     }
-  } while(btemp);
+
+  res.insert(queue.begin(), queue.end());
 
   return res;
 }
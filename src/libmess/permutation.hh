@@ -26,14 +26,27 @@
  ************************************ INDEX PERMUTATION *****************************************
  ************************************************************************************************/
 
-class Permutation : private std::vector<int> {
-  bool _end;
+// small permutations are stored in place, the larger ones on the heap
+//
+class Permutation {
+  enum { CAPACITY = 32 };
+
+  int              _size;
+  int              _local [CAPACITY];
+  std::vector<int> _heap;
+  bool             _end;
+
+  int*       _data ()       { return _size > CAPACITY ? &_heap[0] : _local; }
+  const int* _data () const { return _size > CAPACITY ? &_heap[0] : _local; }
+
+  void _resize (int);
+
   int _compare (const Permutation&) const;
   
 public:
   enum { NOCHECK = 1 };
     
-  Permutation () : _end(true) {}
+  Permutation () : _size(0), _end(true) {}
 
   // identical permutation
   explicit Permutation (int);
@@ -44,9 +57,16 @@ public:
   // two elements permutation
   Permutation (int, int, int);
 
-  int                     size ()      const { return std::vector<int>::size(); }
-  int               operator[] (int i) const { return std::vector<int>::operator[](i); }
-  const std::vector<int>& base ()      const { return *this; }
+  int              size ()      const { return _size; }
+  int        operator[] (int i) const { return _data()[i]; }
+  std::vector<int> base ()      const { return std::vector<int>(_data(), _data() + _size); }
+
+  // hashing for the unordered containers
+  std::size_t hash () const;
+
+  struct Hash {
+    std::size_t operator() (const Permutation& p) const { return p.hash(); }
+  };
 
   operator bool () { return size(); }
 
@@ -62,8 +82,8 @@ public:
   Permutation invert () const;
 
   // index operations
-  bool operator== (const Permutation& p) const { return _compare(p) == 0; }
-  bool operator!= (const Permutation& p) const { return _compare(p) != 0; }
+  bool operator== (const Permutation& p) const;
+  bool operator!= (const Permutation& p) const { return !operator==(p); }
 
   bool operator<  (const Permutation& p) const { return _compare(p) < 0; }
   bool operator>  (const Permutation& p) const { return _compare(p) > 0; }
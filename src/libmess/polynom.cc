@@ -49,15 +49,11 @@ void Polynom::SymPol::init(int dim, int tax, int pax)
   std::vector<int> term_order_map;
   term_order_map.push_back(0);
 
+  _plan.clear();
+
   for(int d = 0; d < dimension(); ++d) {
 
     const int term_max = term_multi_map.size();
-    _term_max_map.push_back(term_max);
-
-    if(d == dimension() - 1) {
-      _term_new_map.resize(term_max);
-      _term_pow_map.resize(term_max);
-      }
 
     for(int term = 0; term < term_max; ++term) {
 
@@ -65,15 +61,16 @@ void Polynom::SymPol::init(int dim, int tax, int pax)
       itemp = itemp < term_order_max() ? itemp : term_order_max();
       const int pow_max = itemp;
 
-      if(d == dimension() - 1) {
-	_term_new_map[term] = term_multi_map.size() - term_max;
-	_term_pow_map[term]  = pow_max;
-      }
-
       for(int i = 0; i < pow_max; ++i) {
 	term_order_map.push_back(term_order_map[term] + i + 1);
 	term_multi_map.push_back(term_multi_map[term]);
 	term_multi_map.back()[d] = i + 1;
+
+	_Step step;
+	step.parent = term;
+	step.dim    = d;
+	step.pow    = i + 1;
+	_plan.push_back(step);
       }    
     }
   }
@@ -139,7 +136,6 @@ void Polynom::SymPol::update_map (const std::vector<double>& args, std::vector<d
 
   _isinit();
 
-  int    itemp;
   double dtemp;
 
   if(dimension() != args.size()) {
@@ -147,56 +143,115 @@ void Polynom::SymPol::update_map (const std::vector<double>& args, std::vector<d
     throw Error::Range();
   }
 
-  // updating term value map
+  // powers of the arguments, starting from zero
+  const int pstep = term_order_max() + 1;
+
+  std::vector<double> power(dimension() * pstep);
+
+  for(int d = 0; d < dimension(); ++d) {
+    power[d * pstep] = 1.;
+    for(int i = 1; i < pstep; ++i)
+      power[d * pstep + i] = power[d * pstep + i - 1] * args[d];
+  }
+
+  // monomials values
   std::vector<double> term_val_map(_term_val_map_size);
   term_val_map[0] = 1.;
 
-  std::vector<std::vector<double> > power_term(dimension(), std::vector<double>(term_order_max()));
+  for(int t = 0; t < _plan.size(); ++t) {
+    const _Step& step = _plan[t];
+    term_val_map[t + 1] = term_val_map[step.parent] * power[step.dim * pstep + step.pow];
+  }
+
+  // updating values of polynomials
+  poly_val_map.resize(_poly_term_map.size());
 
 #ifndef DEBUG
-#pragma omp parallel for default(shared) private(dtemp) schedule(static)
+#pragma omp parallel for default(shared) private(dtemp) schedule(dynamic, 10)
 #endif
 
-  for(int d = 0; d < dimension(); ++d) {
-    dtemp = args[d];
-    for(int i = 0; i < term_order_max(); ++i, dtemp *= args[d])
-      power_term[d][i] = dtemp;
+  for(int p = 0; p < _poly_term_map.size(); ++p) {
+    dtemp = 0.;
+    for(std::vector<int>::const_iterator vit = _poly_term_map[p].begin(); 
+	vit != _poly_term_map[p].end(); ++vit)
+      dtemp += term_val_map[*vit];
+    dtemp *= (double)_poly_factor[p];
+    poly_val_map[p] = dtemp;	
   }
+}
 
-  for(int d = 0; d < dimension(); ++d) {
+void Polynom::SymPol::update_map (const std::vector<double>& args, std::vector<double>& poly_val_map,
+				  std::vector<double>& poly_grad_map) const 
+{
+  const char funame [] = "Polynom::SymPol::update_map: ";
+
+  _isinit();
 
-    const int term_max = _term_max_map[d];
+  if(dimension() != args.size()) {
+    std::cerr << funame << "dimensions mismatch";
+    throw Error::Range();
+  }
 
-#ifndef DEBUG
-#pragma omp parallel for default(shared) private(dtemp) schedule(dynamic, 1)
-#endif
+  const int dim = dimension();
 
-    for(int term = 0; term < term_max; ++term) {
+  const int pstep = term_order_max() + 1;
 
-      // updating terms values for d-th dimension
-      const int pow_max = _term_pow_map[term];
-      const int base    = _term_new_map[term] + term_max;
+  std::vector<double> power(dim * pstep);
 
-      dtemp = term_val_map[term];
-      for(int i = 0; i < pow_max; ++i)
-	term_val_map[base + i] = dtemp * power_term[d][i];
-    }    
+  for(int d = 0; d < dim; ++d) {
+    power[d * pstep] = 1.;
+    for(int i = 1; i < pstep; ++i)
+      power[d * pstep + i] = power[d * pstep + i - 1] * args[d];
+  }
+
+  // monomials values and gradients: the parent monomial does not depend on the argument
+  // of the step, and only depends on the preceding ones
+  std::vector<double> term_val_map(_term_val_map_size);
+  std::vector<double> term_grad_map(_term_val_map_size * dim, 0.);
+  term_val_map[0] = 1.;
+
+  for(int t = 0; t < _plan.size(); ++t) {
+    const _Step& step = _plan[t];
+
+    const double  x = power[step.dim * pstep + step.pow];
+    const double* g = &term_grad_map[step.parent * dim];
+    double*       r = &term_grad_map[(t + 1) * dim];
+
+    term_val_map[t + 1] = term_val_map[step.parent] * x;
+
+    for(int d = 0; d < step.dim; ++d)
+      r[d] = g[d] * x;
+
+    r[step.dim] = term_val_map[step.parent] * (double)step.pow * power[step.dim * pstep + step.pow - 1];
   }
 
-  // updating values of polynomials
   poly_val_map.resize(_poly_term_map.size());
+  poly_grad_map.resize(_poly_term_map.size() * dim);
 
 #ifndef DEBUG
-#pragma omp parallel for default(shared) private(dtemp) schedule(dynamic, 10)
+#pragma omp parallel for default(shared) schedule(dynamic, 10)
 #endif
 
   for(int p = 0; p < _poly_term_map.size(); ++p) {
-    dtemp = 0.;
+    double val = 0.;
+    double* r = &poly_grad_map[p * dim];
+    for(int d = 0; d < dim; ++d)
+      r[d] = 0.;
+
     for(std::vector<int>::const_iterator vit = _poly_term_map[p].begin(); 
-	vit != _poly_term_map[p].end(); ++vit)
-      dtemp += term_val_map[*vit];
-    dtemp *= (double)_poly_factor[p];
-    poly_val_map[p] = dtemp;	
+	vit != _poly_term_map[p].end(); ++vit) {
+      val += term_val_map[*vit];
+
+      const double* g = &term_grad_map[*vit * dim];
+      for(int d = 0; d < dim; ++d)
+	r[d] += g[d];
+    }
+
+    const double factor = (double)_poly_factor[p];
+
+    poly_val_map[p] = val * factor;
+    for(int d = 0; d < dim; ++d)
+      r[d] *= factor;
   }
 }
 
@@ -40,10 +40,17 @@ namespace Polynom {
     int _term_order_max;
     int _poly_order_max;
 
+    // evaluation plan compiled once by init: each monomial but the first (unity) is
+    // its parent monomial times the power of one argument, the parents coming first,
+    // so that the powers are shared and every monomial costs one multiplication
+    struct _Step {
+      int parent;
+      int dim;
+      int pow; // power of the argument, one and up
+    };
+
     int _term_val_map_size;
-    std::vector<int>  _term_new_map;
-    std::vector<int>  _term_pow_map;
-    std::vector<int>  _term_max_map;
+    std::vector<_Step> _plan; // one step per monomial, the unity excluded
 
     std::vector<int>                _one_poly_map; // one-dimensional linear index to polynomial index map
     std::vector<std::vector<int> > _poly_term_map; // indices of single terms contributing to polinomial
@@ -60,6 +67,10 @@ namespace Polynom {
 
     void update_map (const std::vector<double>&, std::vector<double>&) const ;
 
+    // polynomial values and gradients, poly_grad_map[polynomial * dimension() + argument]
+    void update_map (const std::vector<double>& args, std::vector<double>& poly_val_map,
+		     std::vector<double>& poly_grad_map) const ;
+
     double operator() (const std::multiset<int>&, const std::vector<double>& ) const ;      
 
   }; // SymPol (symmetric polynomial)
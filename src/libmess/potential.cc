@@ -18,15 +18,77 @@
 #include "key.hh"
 
 #include <sstream>
+#include <vector>
 
 Potential::Wrap default_pot;
 
+void Potential::Base::batch (int size, const Dynamic::Coordinates* dc, double* ener, D3::Vector* force) const
+{
+  for(int i = 0; i < size; ++i)
+    ener[i] = (*this)(dc[i], force ? force + 3 * i : 0);
+}
+
+namespace {
+  // remembered geometries of the calling thread, the most recent first: the exact
+  // coordinates, the energy, and the force and torques if they were calculated
+  struct CacheEntry {
+    int                 id;
+    std::vector<double> pos;
+    double              ener;
+    bool                isforce;
+    D3::Vector          force [3];
+  };
+
+  thread_local std::vector<CacheEntry> thread_cache;
+
+  int cache_count = 0;
+}
+
+double Potential::Wrap::_cached (const Dynamic::Coordinates& dc, D3::Vector* force) const
+{
+  std::vector<double> pos(Dynamic::Coordinates::size());
+  dc.put(&pos[0]);
+
+  std::vector<CacheEntry>& cache = thread_cache;
+
+  std::vector<CacheEntry>::iterator cit;
+  for(cit = cache.begin(); cit != cache.end(); ++cit)
+    if(cit->id == _cache_id && cit->pos == pos)
+      break;
+
+  if(cit != cache.end() && (!force || cit->isforce)) {
+    if(force)
+      for(int i = 0; i < 3; ++i)
+	force[i] = cit->force[i];
+    return cit->ener;
+  }
+
+  CacheEntry entry;
+  entry.id      = _cache_id;
+  entry.ener    = (*_fun)(dc, force);
+  entry.isforce = force != 0;
+  if(force)
+    for(int i = 0; i < 3; ++i)
+      entry.force[i] = force[i];
+  entry.pos.swap(pos);
+
+  if(cit != cache.end())
+    cache.erase(cit);
+  else if(cache.size() >= _cache_size)
+    cache.pop_back();
+
+  cache.insert(cache.begin(), entry);
+
+  return entry.ener;
+}
+
 void Potential::Wrap::read (std::istream& from) 
 {
   const char funame [] = "Potential::Wrap::read: ";
 
   KeyGroup PotentialWrap;
 
+  Key cache_key("CacheSize"      );
   Key  anal_key("Analytic"       );
   //Key  harm_key("Harmonic"       );
   Key    cl_key("ChargeLinear"   );
@@ -41,7 +103,20 @@ void Potential::Wrap::read (std::istream& from)
 
   std::string token, comment;
   while(from >> token) {
-    if(anal_key == token) {// analytic
+    // remembered geometries number, before the potential type
+    if(cache_key == token) {
+      if(!(from >> _cache_size)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+      if(_cache_size < 0) {
+	std::cerr << funame << token << ": out of range: " << _cache_size << "\n";
+	throw Error::Range();
+      }
+      _cache_id = ++cache_count;
+    }
+    else if(anal_key == token) {// analytic
       std::getline(from, comment);
       _fun = ConstSharedPointer<Base>(new Analytic(from));
       return;
@@ -156,7 +231,8 @@ Potential::Harmonic::Harmonic (std::istream& from)
 */
 
 Potential::Analytic::Analytic (std::istream& from)  
-  :  _pot_ener(0), _pot_init(0), _corr_ener(0), _corr_init(0),
+  :  _pot_ener(0), _pot_grad(0), _pot_batch(0), _pot_bgrad(0), _pot_init(0), 
+     _corr_ener(0), _corr_grad(0), _corr_batch(0), _corr_bgrad(0), _corr_init(0),
      _dist_incr(1.e-4),  _angl_incr(1.e-4)
 {    
   const char funame [] = "Potential::Analytic::Analytic: ";
@@ -168,6 +244,9 @@ Potential::Analytic::Analytic (std::istream& from)
 
   Key  pot_libr_key("Library");
   Key  pot_ener_key("EnergyMethod");
+  Key  pot_grad_key("GradientMethod");
+  Key pot_batch_key("BatchMethod");
+  Key pot_bgrad_key("BatchGradientMethod");
   Key  pot_init_key("InitMethod");
   Key  pot_data_key("InitData");
   Key  pot_rpar_key("ParameterReal");
@@ -175,6 +254,9 @@ Potential::Analytic::Analytic (std::istream& from)
 
   Key corr_libr_key("CorrectionLibrary");
   Key corr_ener_key("CorrectionEnergyMethod");
+  Key corr_grad_key("CorrectionGradientMethod");
+  Key corr_batch_key("CorrectionBatchMethod");
+  Key corr_bgrad_key("CorrectionBatchGradientMethod");
   Key corr_init_key("CorrectionInitMethod");
   Key corr_data_key("CorrectionInitData");
   Key corr_rpar_key("CorrectionParameterReal");
@@ -185,7 +267,7 @@ Potential::Analytic::Analytic (std::istream& from)
 
   std::string token, line, comment, stemp;
 
-  std::string pot_data, corr_data;
+  std::string pot_data, corr_data, pot_ener, corr_ener;
   while(from >> token) {// read cycle
     // input end
     if(token == IO::end_key()) {
@@ -213,6 +295,40 @@ Potential::Analytic::Analytic (std::istream& from)
       std::getline(from, comment);
 
       _pot_ener = (ener_t)_pot_libr.member(stemp);
+      pot_ener  = stemp;
+    }
+    // potential energy and gradient method
+    else if(token == pot_grad_key) {
+
+      if(!(from >> stemp)) {
+	std::cerr << funame << token << ": is corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      _pot_grad = (grad_t)_pot_libr.member(stemp);
+    }
+    // potential batch energy method
+    else if(token == pot_batch_key) {
+
+      if(!(from >> stemp)) {
+	std::cerr << funame << token << ": is corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      _pot_batch = (batch_t)_pot_libr.member(stemp);
+    }
+    // potential batch energy and gradient method
+    else if(token == pot_bgrad_key) {
+
+      if(!(from >> stemp)) {
+	std::cerr << funame << token << ": is corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      _pot_bgrad = (bgrad_t)_pot_libr.member(stemp);
     }
     // potential initialization method
     else if(token == pot_init_key) {
@@ -277,6 +393,40 @@ Potential::Analytic::Analytic (std::istream& from)
       std::getline(from, comment);
 
       _corr_ener = (ener_t)_corr_libr.member(stemp);
+      corr_ener  = stemp;
+    }
+    // correction energy and gradient method
+    else if(token == corr_grad_key) {
+
+      if(!(from >> stemp)) {
+	std::cerr << funame << token << ": is corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      _corr_grad = (grad_t)_corr_libr.member(stemp);
+    }
+    // correction batch energy method
+    else if(token == corr_batch_key) {
+
+      if(!(from >> stemp)) {
+	std::cerr << funame << token << ": is corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      _corr_batch = (batch_t)_corr_libr.member(stemp);
+    }
+    // correction batch energy and gradient method
+    else if(token == corr_bgrad_key) {
+
+      if(!(from >> stemp)) {
+	std::cerr << funame << token << ": is corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      _corr_bgrad = (bgrad_t)_corr_libr.member(stemp);
     }
     // correction initialization method
     else if(token == corr_init_key) {
@@ -370,6 +520,34 @@ Potential::Analytic::Analytic (std::istream& from)
     throw Error::Init();
   }
 
+  // optional methods exported next to the energy method, <method>_grad, <method>_batch, and <method>_batch_grad
+  if(!_pot_grad && pot_ener.size())
+    _pot_grad = (grad_t)_pot_libr.find(pot_ener + "_grad");
+
+  if(!_pot_batch && pot_ener.size())
+    _pot_batch = (batch_t)_pot_libr.find(pot_ener + "_batch");
+
+  if(!_pot_bgrad && pot_ener.size())
+    _pot_bgrad = (bgrad_t)_pot_libr.find(pot_ener + "_batch_grad");
+
+  if(!_corr_grad && corr_ener.size())
+    _corr_grad = (grad_t)_corr_libr.find(corr_ener + "_grad");
+
+  if(!_corr_batch && corr_ener.size())
+    _corr_batch = (batch_t)_corr_libr.find(corr_ener + "_batch");
+
+  if(!_corr_bgrad && corr_ener.size())
+    _corr_bgrad = (bgrad_t)_corr_libr.find(corr_ener + "_batch_grad");
+
+  if(_pot_grad)
+    IO::log << IO::log_offset << "analytic potential gradient method is available\n";
+
+  if(_pot_batch)
+    IO::log << IO::log_offset << "analytic potential batch method is available\n";
+
+  if(_pot_bgrad)
+    IO::log << IO::log_offset << "analytic potential batch gradient method is available\n";
+
   if(_pot_init)
     _pot_init(pot_data.c_str());
 
@@ -411,62 +589,271 @@ double Potential::Analytic::_tot_ener (const double* coord) const
   return res;
 }
 
-double Potential::Analytic::operator() (const Dynamic::Coordinates& dc, D3::Vector* torque) const 
+double Potential::Analytic::_tot_grad (const double* coord, double* grad) const 
 {
-  static const char funame [] = "Potential::Analytic::operator(): ";
-  
-  int    itemp;
-  double dtemp;
+  const char funame [] = "Potential::Analytic::_tot_grad: ";
+
+  int ifail = 0;
+
+  double res = _pot_grad(coord, grad, _pot_rpar, _pot_ipar, ifail);
+  if(ifail)
+    throw Error::Run();
+
+  if(_corr_ener) {
+    Array<double> corr(3 * Structure::size());
+
+    res += _corr_grad(coord, corr, _corr_rpar, _corr_ipar, ifail);
+    if(ifail)
+      throw Error::Run();
+
+    for(int i = 0; i < corr.size(); ++i)
+      grad[i] += corr[i];
+  }
+
+  return res;
+}
+
+void Potential::Analytic::_tot_batch (int size, const double* coord, double* ener) const 
+{
+  const char funame [] = "Potential::Analytic::_tot_batch: ";
+
+  const int csize = 3 * Structure::size();
+
+  int ifail = 0;
+
+  if(_pot_batch) {
+    _pot_batch(size, coord, ener, _pot_rpar, _pot_ipar, ifail);
+    if(ifail)
+      throw Error::Run();
+  }
+  else
+    for(int g = 0; g < size; ++g) {
+      ener[g] = _pot_ener(coord + g * csize, _pot_rpar, _pot_ipar, ifail);
+      if(ifail)
+	throw Error::Run();
+    }
+
+  if(!_corr_ener)
+    return;
+
+  if(_corr_batch) {
+    Array<double> corr(size);
+
+    _corr_batch(size, coord, corr, _corr_rpar, _corr_ipar, ifail);
+    if(ifail)
+      throw Error::Run();
+
+    for(int g = 0; g < size; ++g)
+      ener[g] += corr[g];
+  }
+  else
+    for(int g = 0; g < size; ++g) {
+      ener[g] += _corr_ener(coord + g * csize, _corr_rpar, _corr_ipar, ifail);
+      if(ifail)
+	throw Error::Run();
+    }
+}
+
+void Potential::Analytic::_tot_bgrad (int size, const double* coord, double* ener, double* grad) const 
+{
+  const char funame [] = "Potential::Analytic::_tot_bgrad: ";
+
+  const int csize = 3 * Structure::size();
+
+  int ifail = 0;
+
+  _pot_bgrad(size, coord, ener, grad, _pot_rpar, _pot_ipar, ifail);
+  if(ifail)
+    throw Error::Run();
+
+  if(!_corr_ener)
+    return;
+
+  Array<double> corr_ener(size);
+  Array<double> corr_grad(size * csize);
 
+  _corr_bgrad(size, coord, corr_ener, corr_grad, _corr_rpar, _corr_ipar, ifail);
+  if(ifail)
+    throw Error::Run();
+
+  for(int g = 0; g < size; ++g)
+    ener[g] += corr_ener[g];
+
+  for(int i = 0; i < corr_grad.size(); ++i)
+    grad[i] += corr_grad[i];
+}
+
+double Potential::Analytic::operator() (const Dynamic::Coordinates& dc, D3::Vector* torque) const 
+{
   Array_2<double> coord(3, Structure::size());
   _dc2cart(dc, coord);
 
   if(!torque)
     return _tot_ener(coord);
 
+  double ener_val;
+
+  if(_has_grad()) {// analytic gradient
+    Array_2<double> grad(3, Structure::size());
+
+    ener_val = _tot_grad(coord, grad);
+
+    _grad2torque(dc, grad, torque);
+  }// analytic gradient
+  else {// numerical gradient
+    //
+    // all displaced configurations are evaluated in one batch: the reference one,
+    // the small fragment shifts, and the small fragment rotations
+    const int gsize = _disp_size();
+
+    Array<double> geom(gsize * 3 * Structure::size());
+    Array<double> ener(gsize);
+
+    _displace(dc, coord, geom);
+
+    _tot_batch(gsize, geom, ener);
+
+    ener_val = ener[0];
+
+    _diff2torque(dc, ener, torque);
+  }// numerical gradient
+
+  return ener_val;
+}
+
+void Potential::Analytic::_grad2torque (const Dynamic::Coordinates& dc, const double* grad, D3::Vector* torque)
+{
   D3::Vector& force = *torque;
   torque += 1;
 
   D3::Vector vtemp;
-  D3::Vector atom_force;
 
-  // initialization
   force = 0.;
   for(int frag = 0; frag < 2; ++frag)
     torque[frag] = 0.;
 	
-  // numerical gradient
+  const int sfrag = Structure::fragment(0).size() < Structure::fragment(1).size() ? 0 : 1; // small fragment
 
-  double ener_val = _tot_ener(coord);
+  const int at_shift = sfrag ? Structure::fragment(0).size() : 0;
 
-  const int sfrag = Structure::fragment(0).size() < Structure::fragment(1).size() ? 0 : 1;         // small fragment
-  const int lfrag = 1 - sfrag; // large fragment
+  const bool is_atom = Structure::fragment(sfrag).type() == Molecule::MONOATOMIC;
+
+  // force on the small fragment
+  for(int at = 0; at < Structure::fragment(sfrag).size(); ++at)
+    for(int i = 0; i < 3; ++i)
+      force[i] -= grad[i + 3 * (at + at_shift)];
+
+  // sign convention of the numerical gradient: the force acts on the second fragment
+  if(!sfrag)
+    for(int i = 0; i < 3; ++i)
+      force[i] = -force[i];
+
+  // torque on the small fragment
+  if(!is_atom)
+    for(int at = 0; at < Structure::fragment(sfrag).size(); ++at) {
+      D3::vprod(dc.rel_pos(sfrag)[at], grad + 3 * (at + at_shift), vtemp);
+      for(int i = 0; i < 3; ++i)
+	torque[sfrag][i] -= vtemp[i];
+    }
+
+  _frame_torque(dc, torque - 1);
+}
+
+int Potential::Analytic::_disp_size ()
+{
+  const int sfrag = Structure::fragment(0).size() < Structure::fragment(1).size() ? 0 : 1;
+
+  return Structure::fragment(sfrag).type() == Molecule::MONOATOMIC ? 7 : 13;
+}
+
+void Potential::Analytic::_displace (const Dynamic::Coordinates& dc, const double* coord, double* geom) const
+{
+  const int sfrag = Structure::fragment(0).size() < Structure::fragment(1).size() ? 0 : 1;
 
   const int at_shift = sfrag ? Structure::fragment(0).size() : 0;
 
-  // force calculation on small fragment
-  double incr2 = 2. * _dist_incr;
+  const bool is_atom = Structure::fragment(sfrag).type() == Molecule::MONOATOMIC;
 
-  for(int i = 0; i < 3; ++i) {
-    for(int at = 0; at < Structure::fragment(sfrag).size(); ++at)
-      coord(i, at + at_shift) -= _dist_incr;
-    force[i] += _tot_ener(coord);
+  const int csize = 3 * Structure::size();
+  const int gsize = _disp_size();
+
+  for(int g = 0; g < gsize; ++g)
+    for(int i = 0; i < csize; ++i)
+      geom[g * csize + i] = coord[i];
+
+  for(int i = 0; i < 3; ++i)
+    for(int at = 0; at < Structure::fragment(sfrag).size(); ++at) {
+      geom[(2 * i + 1) * csize + i + 3 * (at + at_shift)] -= _dist_incr;
+      geom[(2 * i + 2) * csize + i + 3 * (at + at_shift)] += _dist_incr;
+    }
 
-    for(int at = 0; at < Structure::fragment(sfrag).size(); ++at)
-      coord(i, at + at_shift) += incr2;
-    force[i] -= _tot_ener(coord);
+  const double cos_val = std::cos(_angl_incr) - 1.;
+  const double sin_val = std::sin(_angl_incr);
+
+  if(!is_atom)
+    for(int i = 0; i < 3; ++i) {
+      const int i1 = (i + 1) % 3;
+      const int i2 = (i + 2) % 3;
+
+      for(int at = 0; at < Structure::fragment(sfrag).size(); ++at) {
+	const double* r = dc.rel_pos(sfrag)[at];
+
+	double* p = &geom[(2 * i + 7) * csize + 3 * (at + at_shift)];
+	p[i1] += cos_val * r[i1] + sin_val * r[i2];
+	p[i2] += cos_val * r[i2] - sin_val * r[i1];
+
+	p = &geom[(2 * i + 8) * csize + 3 * (at + at_shift)];
+	p[i1] += cos_val * r[i1] - sin_val * r[i2];
+	p[i2] += cos_val * r[i2] + sin_val * r[i1];
+      }
+    }
+}
+
+void Potential::Analytic::_diff2torque (const Dynamic::Coordinates& dc, const double* ener, D3::Vector* torque) const
+{
+  D3::Vector& force = *torque;
 
-    for(int at = 0; at < Structure::fragment(sfrag).size(); ++at)
-      coord(i, at + at_shift) -= _dist_incr;
+  for(int frag = 0; frag < 2; ++frag)
+    torque[frag + 1] = 0.;
 	
+  const int sfrag = Structure::fragment(0).size() < Structure::fragment(1).size() ? 0 : 1;
+
+  const bool is_atom = Structure::fragment(sfrag).type() == Molecule::MONOATOMIC;
+
+  // force on the small fragment
+  const double dist_incr2 = 2. * _dist_incr;
+  for(int i = 0; i < 3; ++i) {
+    force[i] = ener[2 * i + 1] - ener[2 * i + 2];
+
     if(sfrag)
-      force[i] /=  incr2;
+      force[i] /=  dist_incr2;
     else
-      force[i] /= -incr2;
+      force[i] /= -dist_incr2;
   }
 
+  // torque on the small fragment
+  const double angl_incr2 = 2. * _angl_incr;
+  if(!is_atom)
+    for(int i = 0; i < 3; ++i)
+      torque[sfrag + 1][i] = (ener[2 * i + 7] - ener[2 * i + 8]) / angl_incr2;
+
+  _frame_torque(dc, torque);
+}
+
+void Potential::Analytic::_frame_torque (const Dynamic::Coordinates& dc, D3::Vector* torque)
+{
+  D3::Vector& force = *torque;
+  torque += 1;
+
+  D3::Vector vtemp;
+
+  const int sfrag = Structure::fragment(0).size() < Structure::fragment(1).size() ? 0 : 1; // small fragment
+  const int lfrag = 1 - sfrag; // large fragment
+
+  const bool is_atom = Structure::fragment(sfrag).type() == Molecule::MONOATOMIC;
+
   // torque calculation
-  if (Structure::fragment(sfrag).type() == Molecule::MONOATOMIC) {// small fragment is an atom
+  if (is_atom) {// small fragment is an atom
     switch(Structure::fragment(lfrag).type()) {
     case Molecule::LINEAR:
       D3::vprod(force, dc.orb_pos(), torque[lfrag]);
@@ -478,44 +865,9 @@ double Potential::Analytic::operator() (const Dynamic::Coordinates& dc, D3::Vect
       dc.lf2mf(lfrag, vtemp, torque[lfrag]);
       break;
     }
-    return ener_val;
+    return;
   }// atom
 
-  // torque on the small fragment
-  incr2 = 2. * _angl_incr;
-  double cos_val = std::cos(_angl_incr) - 1.;
-  double sin_val = std::sin(_angl_incr);
-
-  for(int i = 0; i < 3; ++i) {
-    const int i1 = (i + 1) % 3;
-    const int i2 = (i + 2) % 3;
-
-    for(int at = 0; at < Structure::fragment(sfrag).size(); ++at) {
-      coord(i1, at + at_shift) += cos_val * dc.rel_pos(sfrag)[at][i1] + sin_val * dc.rel_pos(sfrag)[at][i2];
-      coord(i2, at + at_shift) += cos_val * dc.rel_pos(sfrag)[at][i2] - sin_val * dc.rel_pos(sfrag)[at][i1];
-    }
-    torque[sfrag][i] += _tot_ener(coord);
-
-    for(int at = 0; at < Structure::fragment(sfrag).size(); ++at) {
-      coord(i1, at + at_shift) -= 2. * sin_val * dc.rel_pos(sfrag)[at][i2];
-      coord(i2, at + at_shift) += 2. * sin_val * dc.rel_pos(sfrag)[at][i1];
-    }
-    torque[sfrag][i] -= _tot_ener(coord);
-
-    if(!sfrag)
-      for(int at = 0; at < Structure::fragment(sfrag).size(); ++at) {
-	coord(i1, at + at_shift) = dc.rel_pos(sfrag)[at][i1];
-	coord(i2, at + at_shift) = dc.rel_pos(sfrag)[at][i2];
-      }
-    else
-      for(int at = 0; at < Structure::fragment(sfrag).size(); ++at) {
-	coord(i1, at + at_shift) = dc.rel_pos(sfrag)[at][i1] + dc.orb_pos(i1);
-	coord(i2, at + at_shift) = dc.rel_pos(sfrag)[at][i2] + dc.orb_pos(i2);
-      }
-
-    torque[sfrag][i] /= incr2;
-  }
-
   // torque on the large fragment
   D3::vprod(force, dc.orb_pos(), vtemp);
   for(int i = 0; i < 3; ++i)
@@ -533,8 +885,69 @@ double Potential::Analytic::operator() (const Dynamic::Coordinates& dc, D3::Vect
       torque[frag] = vtemp;
       break;
     }
+}
 
-  return ener_val;
+// the energies go to the batch method of the library in one call; with the forces, either
+// the gradients go to the batch gradient method in one call, or the displaced configurations
+// of all the members go to the batch method in one call
+//
+void Potential::Analytic::batch (int size, const Dynamic::Coordinates* dc, double* ener, D3::Vector* torque) const 
+{
+  if(size <= 0)
+    return;
+
+  if(torque && !_has_bgrad() && (_has_grad() || !_pot_batch)) {
+    Base::batch(size, dc, ener, torque);
+    return;
+  }
+
+  const int csize    = 3 * Structure::size();
+  const int at_shift = Structure::fragment(0).size();
+
+  Array<double> geom(size * csize);
+
+  for(int g = 0; g < size; ++g)
+    for(int frag = 0; frag < 2; ++frag)
+      for(int at = 0; at < Structure::fragment(frag).size(); ++at)
+	for(int i = 0; i < 3; ++i)
+	  if(!frag)
+	    geom[g * csize + 3 * at + i]              = dc[g].rel_pos(frag)[at][i];
+	  else
+	    geom[g * csize + 3 * (at + at_shift) + i] = dc[g].rel_pos(frag)[at][i] + dc[g].orb_pos(i);
+
+  if(!torque) {
+    _tot_batch(size, geom, ener);
+    return;
+  }
+
+  // analytic gradients
+  if(_has_bgrad()) {
+    Array<double> grad(size * csize);
+
+    _tot_bgrad(size, geom, ener, grad);
+
+    for(int g = 0; g < size; ++g)
+      _grad2torque(dc[g], &grad[g * csize], torque + 3 * g);
+
+    return;
+  }
+
+  // numerical gradients
+  const int gsize = _disp_size();
+
+  Array<double> disp(size * gsize * csize);
+  Array<double> disp_ener(size * gsize);
+
+  for(int g = 0; g < size; ++g)
+    _displace(dc[g], &geom[g * csize], &disp[g * gsize * csize]);
+
+  _tot_batch(size * gsize, disp, disp_ener);
+
+  for(int g = 0; g < size; ++g) {
+    ener[g] = disp_ener[g * gsize];
+
+    _diff2torque(dc[g], &disp_ener[g * gsize], torque + 3 * g);
+  }
 }
 
 /*************************************************************************
@@ -1349,7 +1762,7 @@ double Potential::Multipole::operator() (const Dynamic::Coordinates& dc, D3::Vec
 
       dc.dipole(other, d);
       d *= charge;
-      rd = vdot(r, d, 3);
+      rd = vdot(r, d);
       if(frag)
 	ener_val += rd * r3;
       else
@@ -1361,7 +1774,7 @@ double Potential::Multipole::operator() (const Dynamic::Coordinates& dc, D3::Vec
 
       dc.quadrupole_vector_product(other, r, qr);
       qr *= charge;
-      rqr = vdot(r, qr, 3);
+      rqr = vdot(r, qr);
       ener_val += rqr * r5 / 2.; 
 
     }
@@ -1371,7 +1784,7 @@ double Potential::Multipole::operator() (const Dynamic::Coordinates& dc, D3::Vec
 
       dc.polarizability_vector_product(other, r, pr);
       pr *= charge * charge;
-      rpr = vdot(r, pr, 3);
+      rpr = vdot(r, pr);
       ener_val -= rpr * r6 / 2.;
 
     }
@@ -1449,13 +1862,13 @@ double Potential::Multipole::operator() (const Dynamic::Coordinates& dc, D3::Vec
     if(Structure::fragment(frag).dipole().size()) {
       dc.dipole(frag, d[frag]);
       other = 1 - frag;
-      rd[frag] = vdot(r, d[frag], 3);
+      rd[frag] = vdot(r, d[frag]);
 
       if(Structure::fragment(other).quadrupole().size()) { // dipole-qudrupole interaction
 	 dc.quadrupole_vector_product(other, r,         qr[frag]);
 	 dc.quadrupole_vector_product(other, d[frag], qd[frag]);
-	 rqr[frag] = vdot(r, qr[frag], 3);
-	 rqd[frag] = vdot(r, qd[frag], 3);
+	 rqr[frag] = vdot(r, qr[frag]);
+	 rqd[frag] = vdot(r, qd[frag]);
 
 	 dtemp = 2.5 * rqr[frag] * rd[frag] * r7 - rqd[frag] * r5;
 	 if(frag) 
@@ -1467,9 +1880,9 @@ double Potential::Multipole::operator() (const Dynamic::Coordinates& dc, D3::Vec
       if(Structure::fragment(other).polarizability().size()) {// dipole - induced dipole interaction
 	dc.polarizability_vector_product(other, r,         pr[frag]);
 	dc.polarizability_vector_product(other, d[frag], pd[frag]);
-	rpr[frag] = vdot(r, pr[frag], 3);
-	rpd[frag] = vdot(r, pd[frag], 3);
-	dpd[frag] = vdot(d[frag], pd[frag], 3);
+	rpr[frag] = vdot(r, pr[frag]);
+	rpd[frag] = vdot(r, pd[frag]);
+	dpd[frag] = vdot(d[frag], pd[frag]);
 
 	ener_val -=  dpd[frag] * r6 / 2. + 4.5 * rpr[frag] * rd[frag] * rd[frag] * r10 - 3. * rpd[frag] * rd[frag] * r8;
       }
@@ -1480,7 +1893,7 @@ double Potential::Multipole::operator() (const Dynamic::Coordinates& dc, D3::Vec
 
   if(Structure::fragment(0).dipole().size() && Structure::fragment(1).dipole().size()) {// dipole-dipole interaction
 
-    dd = vdot(d[0], d[1], 3);
+    dd = vdot(d[0], d[1]);
     ener_val += dd * r3 - 3. * rd[0] * rd[1] * r5;
 
   }// dipole-dipole interaction
@@ -1587,6 +2000,242 @@ double Potential::Multipole::operator() (const Dynamic::Coordinates& dc, D3::Vec
   return ener_val;
 }
 
+// energies only: the laboratory frame multipole vectors are collected configuration
+// by configuration, and the interaction sums then run over the whole batch
+//
+void Potential::Multipole::batch (int size, const Dynamic::Coordinates* dc, double* ener, D3::Vector* torque) const 
+{
+  if(torque || size <= 0) {
+    Base::batch(size, dc, ener, torque);
+    return;
+  }
+
+  int b, frag, other;
+  D3::Vector vtemp, dv;
+
+  // structure-of-arrays storage: vec(field, component)[configuration]
+  enum {RV, DV, QR, QD, PR, PD, FIELD_SIZE = 5}; // DV to PD for each fragment
+
+  Array<double> buf(3 * (1 + 2 * FIELD_SIZE) * size);
+
+  auto vec = [&] (int field, int frag, int i) -> double* { 
+    if(field != RV)
+      field += frag * FIELD_SIZE;
+    return (double*)buf + (3 * field + i) * size; 
+  };
+
+  auto store = [&] (int field, int frag, int b, const double* v) {
+    for(int i = 0; i < 3; ++i)
+      vec(field, frag, i)[b] = v[i];
+  };
+
+  // inverse distance powers
+  enum {P3, P5, P6, P7, P8, P10, POWER_SIZE};
+
+  Array<double> power(POWER_SIZE * size);
+
+  double* const r3  = (double*)power + P3  * size;
+  double* const r5  = (double*)power + P5  * size;
+  double* const r6  = (double*)power + P6  * size;
+  double* const r7  = (double*)power + P7  * size;
+  double* const r8  = (double*)power + P8  * size;
+  double* const r10 = (double*)power + P10 * size;
+
+  for(b = 0; b < size; ++b) {
+    store(RV, 0, b, dc[b].orb_pos());
+
+    const double dist = vlength(dc[b].orb_pos(), 3);
+    const double r2   = 1. / dist / dist;
+
+    r3[b]  = r2 / dist;
+    r5[b]  = r3[b] * r2;
+    r6[b]  = r5[b] / dist;
+    r7[b]  = r6[b] / dist;
+    r8[b]  = r7[b] / dist;
+    r10[b] = r8[b] * r2;
+
+    ener[b] = 0.;
+  }
+
+  const double* const x = vec(RV, 0, 0);
+  const double* const y = vec(RV, 0, 1);
+  const double* const z = vec(RV, 0, 2);
+
+  for(frag = 0; frag < 2; ++frag)
+    if(Structure::fragment(frag).charge())
+      break;
+    
+  if(frag < 2) { // charge-multipole interaction
+    other = 1 - frag;
+
+    const double charge = (double)Structure::fragment(frag).charge();
+
+    // dipole
+    if(Structure::fragment(other).dipole().size()) {
+      for(b = 0; b < size; ++b) {
+	dc[b].dipole(other, dv);
+	store(DV, other, b, dv);
+      }
+
+      const double* const d0 = vec(DV, other, 0);
+      const double* const d1 = vec(DV, other, 1);
+      const double* const d2 = vec(DV, other, 2);
+      const double sign = frag ? 1. : -1.;
+
+#pragma omp simd
+      for(b = 0; b < size; ++b) {
+	const double rd = x[b] * (d0[b] * charge) + y[b] * (d1[b] * charge) + z[b] * (d2[b] * charge);
+	ener[b] += sign * rd * r3[b];
+      }
+    }
+
+    // quadrupole
+    if(Structure::fragment(other).quadrupole().size()) {
+      for(b = 0; b < size; ++b) {
+	dc[b].quadrupole_vector_product(other, dc[b].orb_pos(), vtemp);
+	store(QR, other, b, vtemp);
+      }
+
+      const double* const q0 = vec(QR, other, 0);
+      const double* const q1 = vec(QR, other, 1);
+      const double* const q2 = vec(QR, other, 2);
+
+#pragma omp simd
+      for(b = 0; b < size; ++b) {
+	const double rqr = x[b] * (q0[b] * charge) + y[b] * (q1[b] * charge) + z[b] * (q2[b] * charge);
+	ener[b] += rqr * r5[b] / 2.;
+      }
+    }
+
+    // polarizability
+    if(Structure::fragment(other).polarizability().size()) {
+      for(b = 0; b < size; ++b) {
+	dc[b].polarizability_vector_product(other, dc[b].orb_pos(), vtemp);
+	store(PR, other, b, vtemp);
+      }
+
+      const double* const p0 = vec(PR, other, 0);
+      const double* const p1 = vec(PR, other, 1);
+      const double* const p2 = vec(PR, other, 2);
+      const double cc = charge * charge;
+
+#pragma omp simd
+      for(b = 0; b < size; ++b) {
+	const double rpr = x[b] * (p0[b] * cc) + y[b] * (p1[b] * cc) + z[b] * (p2[b] * cc);
+	ener[b] -= rpr * r6[b] / 2.;
+      }
+    }
+
+    return;
+  }// charge-multipole potential
+
+  // laboratory frame vectors
+  for(frag = 0; frag < 2; ++frag) {
+    if(!Structure::fragment(frag).dipole().size())
+      continue;
+
+    other = 1 - frag;
+    for(b = 0; b < size; ++b) {
+      dc[b].dipole(frag, dv);
+      store(DV, frag, b, dv);
+
+      if(Structure::fragment(other).quadrupole().size()) {
+	dc[b].quadrupole_vector_product(other, dc[b].orb_pos(), vtemp);
+	store(QR, frag, b, vtemp);
+	dc[b].quadrupole_vector_product(other, dv, vtemp);
+	store(QD, frag, b, vtemp);
+      }
+
+      if(Structure::fragment(other).polarizability().size()) {
+	dc[b].polarizability_vector_product(other, dc[b].orb_pos(), vtemp);
+	store(PR, frag, b, vtemp);
+	dc[b].polarizability_vector_product(other, dv, vtemp);
+	store(PD, frag, b, vtemp);
+      }
+    }
+  }
+
+  // dipole projections on the interfragment vector
+  Array<double> rd_buf(2 * size);
+  double* const rd [2] = {(double*)rd_buf, (double*)rd_buf + size};
+
+  for(frag = 0; frag < 2; ++frag) {
+    if(!Structure::fragment(frag).dipole().size())
+      continue;
+
+    other = 1 - frag;
+
+    const double* const d0 = vec(DV, frag, 0);
+    const double* const d1 = vec(DV, frag, 1);
+    const double* const d2 = vec(DV, frag, 2);
+
+#pragma omp simd
+    for(b = 0; b < size; ++b)
+      rd[frag][b] = x[b] * d0[b] + y[b] * d1[b] + z[b] * d2[b];
+
+    const double* const rdf = rd[frag];
+
+    if(Structure::fragment(other).quadrupole().size()) { // dipole-qudrupole interaction
+      const double* const qr0 = vec(QR, frag, 0);
+      const double* const qr1 = vec(QR, frag, 1);
+      const double* const qr2 = vec(QR, frag, 2);
+      const double* const qd0 = vec(QD, frag, 0);
+      const double* const qd1 = vec(QD, frag, 1);
+      const double* const qd2 = vec(QD, frag, 2);
+      const double sign = frag ? -1. : 1.;
+
+#pragma omp simd
+      for(b = 0; b < size; ++b) {
+	const double rqr = x[b] * qr0[b] + y[b] * qr1[b] + z[b] * qr2[b];
+	const double rqd = x[b] * qd0[b] + y[b] * qd1[b] + z[b] * qd2[b];
+
+	ener[b] += sign * (2.5 * rqr * rdf[b] * r7[b] - rqd * r5[b]);
+      }
+    }// dipole-quadrupole interaction
+
+    if(Structure::fragment(other).polarizability().size()) {// dipole - induced dipole interaction
+      const double* const pr0 = vec(PR, frag, 0);
+      const double* const pr1 = vec(PR, frag, 1);
+      const double* const pr2 = vec(PR, frag, 2);
+      const double* const pd0 = vec(PD, frag, 0);
+      const double* const pd1 = vec(PD, frag, 1);
+      const double* const pd2 = vec(PD, frag, 2);
+
+#pragma omp simd
+      for(b = 0; b < size; ++b) {
+	const double rpr = x[b]  * pr0[b] + y[b]  * pr1[b] + z[b]  * pr2[b];
+	const double rpd = x[b]  * pd0[b] + y[b]  * pd1[b] + z[b]  * pd2[b];
+	const double dpd = d0[b] * pd0[b] + d1[b] * pd1[b] + d2[b] * pd2[b];
+
+	ener[b] -=  dpd * r6[b] / 2. + 4.5 * rpr * rdf[b] * rdf[b] * r10[b] - 3. * rpd * rdf[b] * r8[b];
+      }
+    }// dipole - induced dipole interaction
+  }
+
+  if(Structure::fragment(0).dipole().size() && Structure::fragment(1).dipole().size()) {// dipole-dipole interaction
+    const double* const a0 = vec(DV, 0, 0);
+    const double* const a1 = vec(DV, 0, 1);
+    const double* const a2 = vec(DV, 0, 2);
+    const double* const b0 = vec(DV, 1, 0);
+    const double* const b1 = vec(DV, 1, 1);
+    const double* const b2 = vec(DV, 1, 2);
+
+#pragma omp simd
+    for(b = 0; b < size; ++b) {
+      const double dd = a0[b] * b0[b] + a1[b] * b1[b] + a2[b] * b2[b];
+
+      ener[b] += dd * r3[b] - 3. * rd[0][b] * rd[1][b] * r5[b];
+    }
+  }// dipole-dipole interaction
+
+  // dispersion
+  if(_dispersion != 0.) {
+#pragma omp simd
+    for(b = 0; b < size; ++b)
+      ener[b] -= _dispersion * r6[b];
+  }
+}
+
 Potential::Multipole::Multipole (std::istream& from)  : _dispersion(0.)
 {
   static const char funame [] = "Potential::Multipole::Multipole: ";
@@ -40,6 +40,9 @@ namespace Potential {
     virtual double operator() (const Dynamic::Coordinates&, D3::Vector* force) const =0;
     virtual int    type       ()                                               const =0;
 
+    // energies (and forces/torques, three vectors per configuration) for an array of configurations
+    virtual void batch (int size, const Dynamic::Coordinates* dc, double* ener, D3::Vector* force =0) const;
+
     virtual ~Base () {}
   };
 
@@ -47,10 +50,17 @@ namespace Potential {
   class Wrap : public IO::Read 
   {
     ConstSharedPointer<Base> _fun;
+
+    // last geometries memoization: the number of geometries remembered by each thread
+    // (none if zero), and the identifier the remembered values are kept under
+    int _cache_size;
+    int _cache_id;
+
+    double _cached (const Dynamic::Coordinates&, D3::Vector*) const;
 	
   public:
-    Wrap () {}
-    Wrap (ConstSharedPointer<Base> pf) : _fun(pf) {}
+    Wrap () : _cache_size(0), _cache_id(0) {}
+    Wrap (ConstSharedPointer<Base> pf) : _fun(pf), _cache_size(0), _cache_id(0) {}
     ~Wrap () {}
 
     void read (std::istream&) ;
@@ -58,10 +68,15 @@ namespace Potential {
     operator  bool () const { return  _fun; }
     bool operator! () const { return !_fun; }
 
+    // the same potential object
+    bool operator== (const Wrap& w) const { return _fun == w._fun; }
+
     void   isinit () const ;
 
     double operator() (const Dynamic::Coordinates&, D3::Vector* =0) const ;
     int    type       ()                                            const ;
+
+    void batch (int size, const Dynamic::Coordinates*, double* ener, D3::Vector* =0) const ;
   };
 
   inline void Wrap::isinit () const 
@@ -77,9 +92,17 @@ namespace Potential {
   inline double Wrap::operator() (const Dynamic::Coordinates& dc, D3::Vector* force) const 
   {
     isinit();
+    if(_cache_size)
+      return _cached(dc, force);
     return (*_fun)(dc, force);
   }
 
+  inline void Wrap::batch (int size, const Dynamic::Coordinates* dc, double* ener, D3::Vector* force) const 
+  {
+    isinit();
+    _fun->batch(size, dc, ener, force);
+  }
+
   inline int Wrap::type () const 
   {
     isinit();
@@ -135,9 +158,18 @@ namespace Potential {
     int type () const { return HARMONIC; }
   };
 */
-  // Analytic potential
+  // Analytic potential: coord(0:2, atom) are the cartesian coordinates of the atoms
+  // of the first and then of the second fragment; the optional methods return the
+  // energy and its cartesian gradient, grad(0:2, atom), the energies of the
+  // coordinate sets coord(0:2, atom, 0:size-1) at once, or the energies and the
+  // gradients grad(0:2, atom, 0:size-1) of the coordinate sets at once
   extern "C" {
     typedef double (*ener_t) (const double* coord, const double* rpar, const int* ipar, int& ifail);
+    typedef double (*grad_t) (const double* coord, double* grad, const double* rpar, const int* ipar, int& ifail);
+    typedef void  (*batch_t) (const int& size, const double* coord, double* ener, const double* rpar, const int* ipar, 
+			      int& ifail);
+    typedef void  (*bgrad_t) (const int& size, const double* coord, double* ener, double* grad, const double* rpar,
+			      const int* ipar, int& ifail);
     typedef void   (*init_t) (const char* data_file_name);
   }
 
@@ -145,12 +177,18 @@ namespace Potential {
   {
     System::DynLib  _pot_libr;
     ener_t          _pot_ener;
+    grad_t          _pot_grad;
+    batch_t         _pot_batch;
+    bgrad_t         _pot_bgrad;
     init_t          _pot_init;
     Array<double>   _pot_rpar;
     Array<int>      _pot_ipar;
 
     System::DynLib _corr_libr;
     ener_t         _corr_ener;
+    grad_t         _corr_grad;
+    batch_t        _corr_batch;
+    bgrad_t        _corr_bgrad;
     init_t         _corr_init;
     Array<double>  _corr_rpar;
     Array<int>     _corr_ipar;
@@ -160,6 +198,24 @@ namespace Potential {
     static void _dc2cart (const Dynamic::Coordinates&, Array_2<double>&); // convert dc (my) to cartesian
 
     double _tot_ener (const double* coord) const ;
+    double _tot_grad (const double* coord, double* grad) const ;
+    void  _tot_batch (int size, const double* coord, double* ener) const ;
+    void  _tot_bgrad (int size, const double* coord, double* ener, double* grad) const ;
+
+    bool _has_grad  () const { return _pot_grad  && (!_corr_ener || _corr_grad); }
+    bool _has_bgrad () const { return _pot_bgrad && (!_corr_ener || _corr_bgrad); }
+
+    // force and torques from the cartesian gradient
+    static void _grad2torque (const Dynamic::Coordinates&, const double* grad, D3::Vector* torque);
+
+    // finite differences: the number of the displaced configurations, the displaced
+    // configurations (the reference one first), and the force and torques from their energies
+    static int _disp_size ();
+    void _displace    (const Dynamic::Coordinates&, const double* coord, double* geom) const ;
+    void _diff2torque (const Dynamic::Coordinates&, const double* ener, D3::Vector* torque) const ;
+
+    // the remaining torque from the force on the small fragment and the frame conversions
+    static void _frame_torque (const Dynamic::Coordinates&, D3::Vector* torque);
 
     // no copies
     Analytic (const Analytic&);
@@ -170,6 +226,7 @@ namespace Potential {
     ~Analytic () {}
 
     double operator() (const Dynamic::Coordinates&, D3::Vector*) const ;
+    void   batch      (int, const Dynamic::Coordinates*, double*, D3::Vector* =0) const ;
     int type () const { return ANALYTIC; }
   };
 
@@ -248,6 +305,7 @@ namespace Potential {
     ~Multipole () {}
 
     double operator() (const Dynamic::Coordinates& dc, D3::Vector*) const ;
+    void   batch      (int, const Dynamic::Coordinates*, double*, D3::Vector* =0) const ;
     int type () const { return MULTIPOLE; }
   };
 
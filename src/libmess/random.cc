@@ -19,42 +19,259 @@
 #include <ctime>
 #include <iostream>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/****************************************************************
+ ******************** Counter-Based Generator *******************
+ ****************************************************************/
+
+namespace {
+
+  // one Philox4x32 block: ten rounds on the counter (block, stream)
+  inline void philox (const uint32_t* key, uint64_t stream, uint64_t block, uint32_t* out)
+  {
+    static const uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+    static const uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+
+    uint32_t c0 = block, c1 = block >> 32, c2 = stream, c3 = stream >> 32;
+    uint32_t k0 = key[0], k1 = key[1];
+
+    for(int r = 0; r < 10; ++r) {
+      const uint64_t p0 = (uint64_t)M0 * c0;
+      const uint64_t p1 = (uint64_t)M1 * c2;
+
+      c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+      c1 = (uint32_t)p1;
+      c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+      c3 = (uint32_t)p0;
+
+      k0 += W0;
+      k1 += W1;
+    }
+
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+  }
+
+  // 53-bit uniform number in the open interval (0, 1)
+  inline double to_flat (uint32_t hi, uint32_t lo)
+  {
+    return ((double)((((uint64_t)hi << 32) | lo) >> 11) + 0.5) / 9007199254740992.;
+  }
+
+  uint64_t seed_value = 0;
+  int      seed_count = 0; // number of times the generator has been seeded
+}
+
+void Random::Stream::_generate (uint64_t block, uint32_t* out) const
+{
+  philox(_key, _stream, block, out);
+}
+
+void Random::Stream::set (uint64_t seed, uint64_t stream)
+{
+  _key[0] = seed;
+  _key[1] = seed >> 32;
+
+  _stream = stream;
+  _block  = 0;
+  _pos    = 4;
+
+  _has_spare = false;
+}
+
+uint32_t Random::Stream::word ()
+{
+  if(_pos == 4) {
+    _generate(_block++, _buf);
+    _pos = 0;
+  }
+
+  return _buf[_pos++];
+}
+
+double Random::Stream::flat ()
+{
+  const uint32_t hi = word();
+
+  return to_flat(hi, word());
+}
+
+// Box-Muller transformation: the variates come in pairs
+double Random::Stream::norm ()
+{
+  if(_has_spare) {
+    _has_spare = false;
+    return _spare;
+  }
+
+  const double r = std::sqrt(-2. * std::log(flat()));
+  const double t = 2. * M_PI * flat();
+
+  _spare     = r * std::sin(t);
+  _has_spare = true;
+
+  return r * std::cos(t);
+}
+
+// the same sequence as the one-by-one calls; the whole blocks
+// are generated in chunks of independent counters
+void Random::Stream::flat (double* v, int n)
+{
+  static const int chunk = 64;
+
+  if(_pos & 1) {
+    for(int i = 0; i < n; ++i)
+      v[i] = flat();
+    return;
+  }
+
+  // the rest of the current block
+  for(; n > 0 && _pos < 4; --n)
+    *v++ = flat();
+
+  uint32_t out [4 * chunk];
+
+  while(n >= 2) {
+    int size = n / 2 < chunk ? n / 2 : chunk;
+
+    for(int b = 0; b < size; ++b)
+      philox(_key, _stream, _block + b, out + 4 * b);
+
+    for(int b = 0; b < size; ++b) {
+      v[2 * b]     = to_flat(out[4 * b],     out[4 * b + 1]);
+      v[2 * b + 1] = to_flat(out[4 * b + 2], out[4 * b + 3]);
+    }
+
+    _block += size;
+    v      += 2 * size;
+    n      -= 2 * size;
+  }
+
+  if(n)
+    *v = flat();
+}
+
+void Random::Stream::norm (double* v, int n)
+{
+  if(n > 0 && _has_spare) {
+    *v++ = _spare;
+    --n;
+    _has_spare = false;
+  }
+
+  if(n <= 0)
+    return;
+
+  flat(v, n - n % 2);
+
+  for(int i = 0; i + 1 < n; i += 2) {
+    const double r = std::sqrt(-2. * std::log(v[i]));
+    const double t = 2. * M_PI * v[i + 1];
+
+    v[i]     = r * std::cos(t);
+    v[i + 1] = r * std::sin(t);
+  }
+
+  if(n % 2)
+    v[n - 1] = norm();
+}
+
+void Random::Stream::save (std::ostream& to) const
+{
+  to.write((const char*)_key,        sizeof(_key));
+  to.write((const char*)&_stream,    sizeof(_stream));
+  to.write((const char*)&_block,     sizeof(_block));
+  to.write((const char*)_buf,        sizeof(_buf));
+  to.write((const char*)&_pos,       sizeof(_pos));
+  to.write((const char*)&_spare,     sizeof(_spare));
+  to.write((const char*)&_has_spare, sizeof(_has_spare));
+}
+
+void Random::Stream::load (std::istream& from) 
+{
+  const char funame [] = "Random::Stream::load: ";
+
+  from.read((char*)_key,        sizeof(_key));
+  from.read((char*)&_stream,    sizeof(_stream));
+  from.read((char*)&_block,     sizeof(_block));
+  from.read((char*)_buf,        sizeof(_buf));
+  from.read((char*)&_pos,       sizeof(_pos));
+  from.read((char*)&_spare,     sizeof(_spare));
+  from.read((char*)&_has_spare, sizeof(_has_spare));
+
+  if(!from || _pos < 0 || _pos > 4) {
+    std::cerr << funame << "input stream is corrupted\n";
+    throw Error::Input();
+  }
+}
+
+namespace {
+
+  thread_local Random::Stream thread_stream;
+  thread_local int            thread_count    = -1; // seeding the stream was made at
+  thread_local bool           thread_selected = false;
+  thread_local uint64_t       thread_id;
+
+  uint64_t thread_num ()
+  {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+  }
+}
+
+Random::Stream& Random::stream ()
+{
+  if(thread_count != seed_count) {
+    thread_stream.set(seed_value, thread_selected ? thread_id : thread_num());
+    thread_count = seed_count;
+  }
+
+  return thread_stream;
+}
+
+void Random::select (uint64_t id)
+{
+  thread_selected = true;
+  thread_id       = id;
+
+  thread_stream.set(seed_value, id);
+  thread_count = seed_count;
+}
+
 /****************************************************************
  ******************* Random Number Generators *******************
  ****************************************************************/
 
 void Random::init ()
 {
-  srand48(std::time(0));
+  seed_value = std::time(0);
+  ++seed_count;
 }
 
 void Random::init (int i)
 {
-  srand48(i);
+  seed_value = (uint32_t)i;
+  ++seed_count;
 }
 
 double Random::flat ()
 {
-    return drand48 ();
+  return stream().flat();
 }
 
 // normal distribution RNG
 //
 double Random::norm ()
 {
-  double dtemp;
-
-  dtemp = Random::flat();
-
-  if(dtemp == 0.)
-    //
-    return 100.;
-
-  if(dtemp == 1.)
-    //
-    return 0.;
-  
-  return std::sqrt(-2. * std::log(dtemp)) * std::cos(2. * M_PI * Random::flat());
+  return stream().norm();
 }
 
 double Random::exp ()
@@ -122,3 +339,59 @@ void Random::spherical_layer (double* vec, int dim, double rmin, double rmax)
   } while (norm < rmin2 || norm > rmax2);
 }
 
+
+/****************************************************************
+ ************************* Sobol Sequence ***********************
+ ****************************************************************/
+
+Random::Sobol::Sobol (int dim) : _dim(dim)
+{
+  const char funame [] = "Random::Sobol::Sobol: ";
+
+  // degree, polynomial coefficients, and initial direction numbers for the dimensions 2 to 10
+  static const int      deg [MAX_DIM - 1]    = {1, 2, 3, 3, 4, 4, 5, 5, 5};
+  static const uint32_t pol [MAX_DIM - 1]    = {0, 1, 1, 2, 1, 4, 2, 4, 7};
+  static const uint32_t init [MAX_DIM - 1][5] = {
+    {1}, {1, 3}, {1, 3, 1}, {1, 1, 1}, {1, 1, 3, 3}, {1, 3, 5, 13}, {1, 1, 5, 5, 17}, {1, 1, 5, 5, 5}, {1, 1, 7, 11, 19}
+  };
+
+  if(dim <= 0 || dim > MAX_DIM) {
+    std::cerr << funame << "dimension, " << dim << ", out of range [1, " << MAX_DIM << "]\n";
+    throw Error::Range();
+  }
+
+  // first dimension: van der Corput sequence
+  for(int i = 0; i < 32; ++i)
+    _dir[0][i] = (uint32_t)1 << (31 - i);
+
+  for(int d = 1; d < dim; ++d) {
+    const int s = deg[d - 1];
+    const uint32_t a = pol[d - 1];
+
+    for(int i = 0; i < s; ++i)
+      _dir[d][i] = init[d - 1][i] << (31 - i);
+
+    for(int i = s; i < 32; ++i) {
+      _dir[d][i] = _dir[d][i - s] ^ (_dir[d][i - s] >> s);
+
+      for(int k = 1; k < s; ++k)
+	if((a >> (s - 1 - k)) & 1)
+	  _dir[d][i] ^= _dir[d][i - k];
+    }
+  }
+}
+
+void Random::Sobol::operator() (uint32_t index, double* x) const
+{
+  // Gray code ordering: the point is the XOR of the direction numbers of the set bits
+  const uint32_t gray = index ^ (index >> 1);
+
+  for(int d = 0; d < _dim; ++d) {
+    uint32_t v = 0;
+    for(int i = 0; i < 32; ++i)
+      if((gray >> i) & 1)
+	v ^= _dir[d][i];
+
+    x[d] = (double)v / 4294967296.;
+  }
+}
@@ -18,8 +18,54 @@
 
 #include "error.hh"
 
+#include <cstdint>
+#include <iostream>
+
 namespace Random {
 
+  /*******************************************************************************
+   * counter-based generator (Philox4x32-10): the seed is the key, and the stream *
+   * number and the block number make the counter, so that the streams derived   *
+   * from one seed are independent and can be used by different threads or tasks *
+   *******************************************************************************/
+
+  class Stream {
+    uint32_t _key [2];
+    uint64_t _stream;
+    uint64_t _block;
+
+    uint32_t _buf [4]; // current block output
+    int      _pos;     // next unused word in the buffer
+
+    double _spare;     // second normal variate of the pair
+    bool   _has_spare;
+
+    void _generate (uint64_t block, uint32_t* out) const;
+
+  public:
+    explicit Stream (uint64_t seed = 0, uint64_t stream = 0) { set(seed, stream); }
+
+    void set (uint64_t seed, uint64_t stream);
+
+    uint32_t word ();
+    double   flat (); // uniform in (0, 1)
+    double   norm (); // standard normal
+
+    // bulk generation
+    void flat (double*, int);
+    void norm (double*, int);
+
+    // binary state, for checkpoints
+    void save (std::ostream&) const;
+    void load (std::istream&) ;
+  };
+
+  // the stream used by the free functions in the calling thread: by default it is
+  // numbered by the thread number, and it restarts when the generator is seeded
+  Stream& stream ();
+  void    select (uint64_t); // switch the calling thread to the given stream
+
+  // the free functions draw from the calling thread stream
   void   init      ();
   void   init      (int);
   void   send_seed (int);
@@ -30,6 +76,26 @@ namespace Random {
   double vol       (double*, int); 
 
   void spherical_layer (double* vec, int dim, double rmin, double rmax) ;
+
+  /*******************************************************************************
+   * Sobol low-discrepancy sequence (Joe-Kuo direction numbers): any point can be *
+   * generated from its index, so that the sequence can be shared between threads *
+   *******************************************************************************/
+
+  class Sobol {
+    int      _dim;
+    uint32_t _dir [10][32]; // direction numbers
+
+  public:
+    enum {MAX_DIM = 10};
+
+    explicit Sobol (int dim) ;
+
+    int dim () const { return _dim; }
+
+    // point with the given index, the coordinates being in [0, 1)
+    void operator() (uint32_t index, double* x) const;
+  };
 }
 
 
@@ -0,0 +1,177 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#include "ratefit.hh"
+
+#include <cmath>
+#include <iostream>
+
+double RateFit::chebyshev (int n, double x)
+{
+  if(!n)
+    return 1.;
+
+  double t0 = 1., t1 = x, t2;
+  for(int i = 1; i < n; ++i) {
+    t2 = 2. * x * t1 - t0;
+    t0 = t1;
+    t1 = t2;
+  }
+  return t1;
+}
+
+/********************************************************************************************
+ ****************************************** CHEBYSHEV ***************************************
+ ********************************************************************************************/
+
+double RateFit::Chebyshev::_reduced_temperature (double t) const
+{
+  if(_tmin == _tmax)
+    return 0.;
+
+  return (2. / t - 1. / _tmin - 1. / _tmax) / (1. / _tmax - 1. / _tmin);
+}
+
+double RateFit::Chebyshev::_reduced_pressure (double p) const
+{
+  if(_pmin == _pmax)
+    return 0.;
+
+  return (2. * std::log(p) - std::log(_pmin) - std::log(_pmax)) / (std::log(_pmax) - std::log(_pmin));
+}
+
+RateFit::Chebyshev::Chebyshev (const std::vector<double>& temperature, const std::vector<double>& pressure,
+			       const Lapack::Matrix& log_rate, int tsize, int psize)
+{
+  const char funame [] = "RateFit::Chebyshev::Chebyshev: ";
+
+  if(!temperature.size() || !pressure.size() || log_rate.size1() != temperature.size() || log_rate.size2() != pressure.size()) {
+    std::cerr << funame << "inconsistent grid dimensions\n";
+    throw Error::Range();
+  }
+
+  if(tsize <= 0 || psize <= 0 || tsize > temperature.size() || psize > pressure.size()) {
+    std::cerr << funame << "expansion order, " << tsize << " x " << psize << ", is out of range for "
+	      << temperature.size() << " x " << pressure.size() << " grid\n";
+    throw Error::Range();
+  }
+
+  _tmin = _tmax = temperature[0];
+  for(int t = 1; t < temperature.size(); ++t) {
+    if(temperature[t] < _tmin)
+      _tmin = temperature[t];
+    if(temperature[t] > _tmax)
+      _tmax = temperature[t];
+  }
+
+  _pmin = _pmax = pressure[0];
+  for(int p = 1; p < pressure.size(); ++p) {
+    if(pressure[p] < _pmin)
+      _pmin = pressure[p];
+    if(pressure[p] > _pmax)
+      _pmax = pressure[p];
+  }
+
+  // least squares on the grid
+  Lapack::Matrix a(temperature.size() * pressure.size(), tsize * psize);
+  Lapack::Vector b(temperature.size() * pressure.size());
+
+  for(int t = 0; t < temperature.size(); ++t)
+    for(int p = 0; p < pressure.size(); ++p) {
+      const int r  = p + t * pressure.size();
+      const double x = _reduced_temperature(temperature[t]);
+      const double y = _reduced_pressure(pressure[p]);
+
+      for(int i = 0; i < tsize; ++i)
+	for(int j = 0; j < psize; ++j)
+	  a(r, j + i * psize) = chebyshev(i, x) * chebyshev(j, y);
+
+      b[r] = log_rate(t, p);
+    }
+
+  Lapack::Vector c = Lapack::svd_solve(a, b);
+
+  _coef.resize(tsize, psize);
+  for(int i = 0; i < tsize; ++i)
+    for(int j = 0; j < psize; ++j)
+      _coef(i, j) = c[j + i * psize];
+}
+
+double RateFit::Chebyshev::operator() (double t, double p) const
+{
+  const double x = _reduced_temperature(t);
+  const double y = _reduced_pressure(p);
+
+  double res = 0.;
+  for(int i = 0; i < _coef.size1(); ++i)
+    for(int j = 0; j < _coef.size2(); ++j)
+      res += _coef(i, j) * chebyshev(i, x) * chebyshev(j, y);
+
+  return res;
+}
+
+/********************************************************************************************
+ ****************************************** ARRHENIUS ***************************************
+ ********************************************************************************************/
+
+// three-parameter fit for three and more temperatures, the plain Arrhenius
+// expression for two, and a constant for one
+//
+RateFit::Arrhenius::Arrhenius (const std::vector<double>& temperature, const std::vector<double>& log_rate)
+  : _log_a(0.), _power(0.), _energy(0.)
+{
+  const char funame [] = "RateFit::Arrhenius::Arrhenius: ";
+
+  if(!temperature.size() || log_rate.size() != temperature.size()) {
+    std::cerr << funame << "inconsistent dimensions\n";
+    throw Error::Range();
+  }
+
+  const int size = temperature.size() < 3 ? temperature.size() : 3;
+
+  if(size == 1) {
+    _log_a = log_rate[0];
+    return;
+  }
+
+  Lapack::Matrix a(temperature.size(), size);
+  Lapack::Vector b(temperature.size());
+
+  for(int t = 0; t < temperature.size(); ++t) {
+    a(t, 0) = 1.;
+    a(t, 1) = -1. / temperature[t];
+    if(size == 3)
+      a(t, 2) = std::log(temperature[t]);
+
+    b[t] = log_rate[t];
+  }
+
+  Lapack::Vector c = Lapack::svd_solve(a, b);
+
+  _log_a  = c[0];
+  _energy = c[1];
+  if(size == 3)
+    _power = c[2];
+}
+
+double RateFit::Arrhenius::operator() (double t) const
+{
+  return _log_a + _power * std::log(t) - _energy / t;
+}
+
+double RateFit::Arrhenius::factor () const
+{
+  return std::exp(_log_a);
+}
@@ -0,0 +1,87 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#ifndef RATEFIT_HH
+#define RATEFIT_HH
+
+#include <vector>
+
+#include "error.hh"
+#include "lapack.hh"
+
+/********************************************************************************************
+ ********************** FITTING OF THE RATE COEFFICIENTS ON THE T-P GRID ********************
+ ********************************************************************************************/
+
+// the fits are done in any consistent units; the rate coefficients are given
+// and returned as natural logarithms
+
+namespace RateFit {
+  //
+  // Chebyshev polynomial of the first kind
+  //
+  double chebyshev (int n, double x);
+
+  // Chebyshev expansion of ln k in the reduced inverse temperature and the reduced
+  // logarithm of pressure (the functional form of the Chemkin CHEB expression)
+  //
+  class Chebyshev {
+    //
+    double _tmin, _tmax;
+    double _pmin, _pmax;
+
+    Lapack::Matrix _coef; // temperature order x pressure order
+
+    double _reduced_temperature (double) const;
+    double _reduced_pressure    (double) const;
+
+  public:
+    //
+    // log_rate(t, p) on the temperature x pressure grid
+    //
+    Chebyshev (const std::vector<double>& temperature, const std::vector<double>& pressure,
+	       const Lapack::Matrix& log_rate, int tsize, int psize) ;
+
+    double operator() (double t, double p) const; // ln k
+
+    double tmin () const { return _tmin; }
+    double tmax () const { return _tmax; }
+    double pmin () const { return _pmin; }
+    double pmax () const { return _pmax; }
+
+    const Lapack::Matrix& coef () const { return _coef; }
+  };
+
+  // modified Arrhenius expression, k = A * T^n * exp(-E/T)
+  //
+  class Arrhenius {
+    //
+    double _log_a; // ln A
+    double _power;
+    double _energy;
+
+  public:
+    //
+    Arrhenius (const std::vector<double>& temperature, const std::vector<double>& log_rate) ;
+
+    double operator() (double t) const; // ln k
+
+    double factor () const;
+    double power  () const { return _power;  }
+    double energy () const { return _energy; }
+  };
+}
+
+#endif
@@ -18,39 +18,109 @@
 #include "configuration.hh"
 #include "random.hh"
 #include "key.hh"
+#include "lapack.hh"
 
 #include <list>
+#include <map>
+#include <algorithm>
 #include <fstream>
 #include <csignal>
 #include <ctime>
+#include <cstdio>
+#include <sstream>
+#include <unistd.h>
 #include <omp.h>
 
 std::string state_data_file;
 std::list<Configuration::State> vertex;
 typedef std::list<Configuration::State>::const_iterator Vit;
 
+// checkpoint: the vertices, the miss count, and the random generator state; it is written
+// periodically and on the signals to the temporary file which then replaces the old one
+std::string checkpoint_file;
+int         checkpoint_interval = 600; // seconds, no periodic checkpoints if not positive
+
+// the signal is serviced by the sampling loop
+volatile std::sig_atomic_t signal_caught = 0;
+
 void save_state_data ()
 {
   if(!vertex.size())
     return;
 
-  std::ofstream to(state_data_file.c_str());
+  // the file is replaced only if the new one is complete
+  IO::AtomicFile to(state_data_file, std::ios_base::out);
   
   to << std::setprecision(17) << std::scientific;
   to << vertex.size() << "\n";
   for(Vit v = vertex.begin(); v != vertex.end(); ++v)
     to << *v;
+
+  if(!to.commit())
+    std::cerr << "sampling: cannot write " << state_data_file << " file, the old one is kept\n";
 }
 
-extern "C" void signal_handler (int sig)
+void save_checkpoint (int miss_count)
 {
-  //if(!omp_get_thread_num())
-  save_state_data();
+  IO::AtomicFile to(checkpoint_file);
 
-  if(sig == SIGUSR1 || sig == SIGUSR2)
-    return;
+  to << "SamplingCheckpoint " << miss_count << " " << vertex.size() << "\n";
+
+  Random::stream().save(to);
+
+  to << std::setprecision(17) << std::scientific;
+  for(Vit v = vertex.begin(); v != vertex.end(); ++v)
+    to << *v;
+
+  if(!to.commit())
+    std::cerr << "sampling: cannot write " << checkpoint_file << " file, the old one is kept\n";
+}
+
+// false if there is no checkpoint
+bool load_checkpoint (int& miss_count)
+{
+  const char funame [] = "load_checkpoint: ";
+
+  std::ifstream from(checkpoint_file.c_str(), std::ios::binary);
+  if(!from)
+    return false;
+
+  std::string header, tag;
+  std::getline(from, header);
+
+  std::istringstream lin(header);
+
+  int vertex_size;
+  if(!(lin >> tag >> miss_count >> vertex_size) || tag != "SamplingCheckpoint" || miss_count < 0 || vertex_size < 0) {
+    std::cerr << funame << checkpoint_file << ": corrupted header\n";
+    throw Error::Input();
+  }
+
+  Random::stream().load(from);
 
-  std::exit(1);
+  vertex.clear();
+
+  Configuration::State vtemp;
+  for(int v = 0; v < vertex_size; ++v) {
+    if(!(from >> vtemp)) {
+      std::cerr << funame << checkpoint_file << ": vertex data is corrupted\n";
+      throw Error::Input();
+    }
+    vertex.push_back(vtemp);
+  }
+
+  return true;
+}
+
+extern "C" void signal_handler (int sig)
+{
+  signal_caught = sig;
+}
+
+// the program state may be inconsistent: the last checkpoint is kept
+extern "C" void fatal_signal_handler (int sig)
+{
+  _exit(1);
 }
 
 double atom_dist_min = 1.5;
@@ -85,6 +155,257 @@ std::vector<Atom> state2geom (double r, const Configuration::State& ang)
   return res;
 }
 
+// energy surrogate: the Gaussian process regression over the vertices at each distance grid
+// point trained on the energies already calculated for the geometry output; the geometries
+// predicted within the tolerance need no ab initio calculation, the rest are ranked by the
+// prediction uncertainty, weighted by the predicted Boltzmann factor if the temperature is given
+//
+namespace Surrogate {
+  //
+  std::string energy_file;               // vertex index, distance index, energy [kcal/mol] lines
+  double      tolerance          = 0.1 * Phys_const::kcal;
+  double      correlation_length = -1.;  // in the vertex metric, fitted if not positive
+  double      temperature        = -1.;  // no weighting if not positive
+
+  struct Task {
+    int    vertex;
+    int    dist;
+    double energy;
+    double sigma;
+    double priority;
+
+    // the higher priority first, the unknown (negative) one before all
+    bool operator< (const Task& t) const
+    {
+      if((priority < 0.) != (t.priority < 0.))
+	return priority < 0.;
+      return priority > t.priority;
+    }
+  };
+
+  typedef std::map<std::pair<int, int>, double> EnergyMap;
+
+  EnergyMap read (const std::string& file)
+  {
+    const char funame [] = "Surrogate::read: ";
+
+    EnergyMap res;
+
+    std::ifstream from(file.c_str());
+    if(!from) {
+      std::cerr << funame << "cannot open " << file << " file\n";
+      throw Error::Input();
+    }
+
+    std::string line;
+    while(std::getline(from, line)) {
+      std::istringstream lin(line);
+
+      // blank and comment lines
+      int v, d;
+      double e;
+      if(!(lin >> v))
+	continue;
+
+      if(!(lin >> d >> e) || v < 0 || d < 0) {
+	std::cerr << funame << file << ": corrupted line: " << line << "\n";
+	throw Error::Input();
+      }
+
+      res[std::make_pair(v, d)] = e * Phys_const::kcal;
+    }
+
+    return res;
+  }
+
+  // the squared exponential correlation averaged over the vertex orbit: invariant under the
+  // symmetry group and still positively defined
+  double correlation (const std::vector<Configuration::State>& orbit, const Configuration::State& v, double length)
+  {
+    double res = 0.;
+    for(int g = 0; g < orbit.size(); ++g) {
+      const double dtemp = vdistance(orbit[g], v) / length;
+      res += std::exp(-0.5 * dtemp * dtemp);
+    }
+    return res / (double)orbit.size();
+  }
+
+  // geom_size: the number of the distance grid points with the valid geometry, for each vertex
+  void run (const std::vector<Configuration::State>& vtx, const std::vector<int>& geom_size,
+	    const Configuration::GroupBase& symm_group, double angle_spacing, const std::string& base_name)
+  {
+    const char funame [] = "Surrogate::run: ";
+
+    double dtemp;
+
+    const EnergyMap energy = read(energy_file);
+
+    std::vector<std::vector<Configuration::State> > orbit(vtx.size());
+    for(int v = 0; v < vtx.size(); ++v) {
+      orbit[v].resize(symm_group.size(), vtx[v]);
+      symm_group.orbit(vtx[v], orbit[v]);
+    }
+
+    int dist_size = 0;
+    for(int v = 0; v < geom_size.size(); ++v)
+      if(geom_size[v] > dist_size)
+	dist_size = geom_size[v];
+
+    double emin = 0.;
+    for(EnergyMap::const_iterator it = energy.begin(); it != energy.end(); ++it)
+      if(it == energy.begin() || it->second < emin)
+	emin = it->second;
+
+    std::vector<Task> task, pred;
+
+    for(int d = 0; d < dist_size; ++d) {
+      // training set
+      std::vector<int>    train;
+      std::vector<double> value;
+      for(int v = 0; v < vtx.size(); ++v) {
+	EnergyMap::const_iterator it = energy.find(std::make_pair(v, d));
+	if(it != energy.end() && d < geom_size[v]) {
+	  train.push_back(v);
+	  value.push_back(it->second);
+	}
+      }
+
+      // the prior mean and variance
+      double mean = 0., var = 0.;
+      for(int i = 0; i < value.size(); ++i)
+	mean += value[i];
+      if(value.size())
+	mean /= (double)value.size();
+      for(int i = 0; i < value.size(); ++i)
+	var += (value[i] - mean) * (value[i] - mean);
+      if(value.size() > 1)
+	var /= (double)(value.size() - 1);
+
+      // nothing is learned yet
+      if(value.size() < 2 || var <= 0.) {
+	for(int v = 0; v < vtx.size(); ++v)
+	  if(d < geom_size[v] && energy.find(std::make_pair(v, d)) == energy.end()) {
+	    Task t = {v, d, mean, -1., -1.};
+	    task.push_back(t);
+	  }
+	continue;
+      }
+
+      // the regularization keeps the correlation matrix positively defined
+      static const double nugget = 1.e-8;
+
+      Lapack::Vector rhs((int)train.size());
+      for(int i = 0; i < train.size(); ++i)
+	rhs[i] = value[i] - mean;
+
+      // the correlation length maximizes the likelihood, the variance being found
+      // analytically for each length
+      std::vector<double> length_list;
+      if(correlation_length > 0.)
+	length_list.push_back(correlation_length);
+      else
+	for(double f = 0.5; f < 5.; f *= 2.)
+	  length_list.push_back(f * angle_spacing);
+
+      double length = -1., like_max;
+      for(int l = 0; l < length_list.size(); ++l) {
+	Lapack::SymmetricMatrix cmat((int)train.size());
+	for(int i = 0; i < train.size(); ++i)
+	  for(int j = i; j < train.size(); ++j)
+	    cmat(i, j) = correlation(orbit[train[i]], vtx[train[j]], length_list[l]) + (i == j ? nugget : 0.);
+
+	double like;
+	try {
+	  Lapack::Cholesky cfac(cmat);
+
+	  dtemp = vdot(rhs, cfac.invert(rhs)) / (double)train.size();
+	  like  = -0.5 * (double)train.size() * std::log(dtemp) - std::log(cfac.det_sqrt());
+	}
+	catch(Error::General) {
+	  continue;
+	}
+
+	if(length < 0. || like > like_max) {
+	  length   = length_list[l];
+	  like_max = like;
+	}
+      }
+
+      if(length < 0.) {
+	std::cerr << funame << "correlation matrix is not positively defined at the distance " << d << "\n";
+	throw Error::Math();
+      }
+
+      Lapack::SymmetricMatrix cmat((int)train.size());
+      for(int i = 0; i < train.size(); ++i)
+	for(int j = i; j < train.size(); ++j)
+	  cmat(i, j) = correlation(orbit[train[i]], vtx[train[j]], length) + (i == j ? nugget : 0.);
+
+      const Lapack::Cholesky cfac(cmat);
+
+      const Lapack::Vector alpha = cfac.invert(rhs);
+
+      var = vdot(rhs, alpha) / (double)train.size();
+
+      IO::log << IO::log_offset << funame << "distance " << d << ": " << train.size()
+	      << " energies, correlation length = " << length
+	      << ", energy deviation [kcal/mol] = " << std::sqrt(var) / Phys_const::kcal << "\n";
+
+      for(int v = 0; v < vtx.size(); ++v) {
+	if(d >= geom_size[v] || energy.find(std::make_pair(v, d)) != energy.end())
+	  continue;
+
+	Lapack::Vector kvec((int)train.size());
+	for(int i = 0; i < train.size(); ++i)
+	  kvec[i] = correlation(orbit[train[i]], vtx[v], length);
+
+	Task t;
+	t.vertex = v;
+	t.dist   = d;
+	t.energy = mean + vdot(kvec, alpha);
+
+	dtemp = var * (1. + nugget - vdot(kvec, cfac.invert(kvec)));
+	t.sigma = dtemp > 0. ? std::sqrt(dtemp) : 0.;
+
+	t.priority = t.sigma;
+	if(temperature > 0.)
+	  t.priority *= std::exp((emin - t.energy) / temperature);
+
+	if(t.sigma <= tolerance)
+	  pred.push_back(t);
+	else
+	  task.push_back(t);
+      }
+    }
+
+    std::stable_sort(task.begin(), task.end());
+
+    IO::log << IO::log_offset << funame << energy.size() << " energies read, "
+	    << pred.size() << " geometries predicted within the tolerance, "
+	    << task.size() << " left to calculate\n";
+
+    // the geometries still to be calculated, most useful first; the uncertainty and the priority
+    // are negative if there is nothing to learn from at the distance
+    std::ofstream task_out((base_name + ".task").c_str());
+    task_out << task.size() << "\n"
+	     << "# vertex   distance   energy[kcal/mol]   uncertainty[kcal/mol]   priority\n";
+    for(int i = 0; i < task.size(); ++i)
+      task_out << std::setw(6) << task[i].vertex << std::setw(6) << task[i].dist
+	       << std::setw(15) << task[i].energy / Phys_const::kcal
+	       << std::setw(15) << (task[i].sigma < 0. ? -1. : task[i].sigma / Phys_const::kcal)
+	       << std::setw(15) << (task[i].priority < 0. ? -1. : task[i].priority / Phys_const::kcal) << "\n";
+
+    // the predicted energies
+    std::ofstream pred_out((base_name + ".pred").c_str());
+    pred_out << pred.size() << "\n"
+	     << "# vertex   distance   energy[kcal/mol]   uncertainty[kcal/mol]\n";
+    for(int i = 0; i < pred.size(); ++i)
+      pred_out << std::setw(6) << pred[i].vertex << std::setw(6) << pred[i].dist
+	       << std::setw(15) << pred[i].energy / Phys_const::kcal
+	       << std::setw(15) << pred[i].sigma  / Phys_const::kcal << "\n";
+  }
+}
+
 int main (int argc, char* argv [])
 {
   const char funame [] = "sampling: ";
@@ -143,6 +464,12 @@ int main (int argc, char* argv [])
   Key  stat_key("StateOutput"       );
   Key  geom_key("GeometryOutput"    );
   Key   adm_key("AtomDistanceMin[bohr]");
+  Key  chkf_key("CheckpointOutput"  );
+  Key  chki_key("CheckpointInterval[sec]");
+  Key  sen_key("SurrogateEnergyInput"   );
+  Key  stol_key("SurrogateTolerance[kcal/mol]");
+  Key  slen_key("SurrogateCorrelationLength");
+  Key  stem_key("SurrogateTemperature[K]");
 
   std::string token, comment;
   while(from >> token) {
@@ -177,6 +504,27 @@ int main (int argc, char* argv [])
       }
       std::getline(from, comment);
     }
+    // checkpoint file
+    else if(chkf_key == token) {
+      if(checkpoint_file.size()) {
+        std::cerr << funame << token << ": allready initialized\n";
+        throw Error::Init();
+      }      
+
+      if(!(from >> checkpoint_file)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+    }
+    // periodic checkpoints
+    else if(chki_key == token) {
+      if(!(from >> checkpoint_interval)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+    }
     // molecular geometry output
     else if(geom_key == token) {
       if(geom_out.is_open()) {
@@ -323,6 +671,54 @@ int main (int argc, char* argv [])
 	throw Error::Range();
       }
     }
+    // energies already calculated
+    else if(sen_key == token) {
+      if(!(from >> Surrogate::energy_file)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+    }
+    // surrogate tolerance
+    else if(stol_key == token) {
+      if(!(from >> dtemp)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+
+      if(dtemp <= 0.) {
+	std::cerr << funame << token << ": out of range\n";
+	throw Error::Range();
+      }
+
+      Surrogate::tolerance = dtemp * Phys_const::kcal;
+    }
+    // surrogate correlation length
+    else if(slen_key == token) {
+      if(!(from >> Surrogate::correlation_length)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+
+      if(Surrogate::correlation_length <= 0.) {
+	std::cerr << funame << token << ": out of range\n";
+	throw Error::Range();
+      }
+    }
+    // surrogate temperature
+    else if(stem_key == token) {
+      if(!(from >> dtemp)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+
+      if(dtemp <= 0.) {
+	std::cerr << funame << token << ": out of range\n";
+	throw Error::Range();
+      }
+
+      Surrogate::temperature = dtemp * Phys_const::kelv;
+    }
     // interatomic minimal distance
     else if(adm_key == token) {
       if(!(from >> atom_dist_min)) {
@@ -376,20 +772,8 @@ int main (int argc, char* argv [])
       dist_grid.push_back(dist);
   }
 
-  // recover vertex data
-  from.open(state_data_file.c_str());
-  if(from >> itemp) {
-    Configuration::State vtemp;
-    for(int v = 0; v < itemp; ++v) {
-      if(!(from >> vtemp)) {
-	std::cerr << funame << "vertex data file is corrupted\n";
-	throw Error::Input();
-      }
-      vertex.push_back(vtemp);
-    }
-  }
-  from.close();
-  from.clear();
+  if(!checkpoint_file.size())
+    checkpoint_file = base_name + ".chk";
 
   if(Structure::fragment(0).type() != Molecule::NONLINEAR) {
     std::cerr << funame << "first fragment should be nonlinear\n";
@@ -444,6 +828,30 @@ int main (int argc, char* argv [])
 
   Configuration::State::layout.set(layout);
 
+  // resume from the checkpoint, or recover the vertex data
+  int miss_count = 0;
+
+  if(load_checkpoint(miss_count)) {
+    //
+    IO::log << IO::log_offset << "resumed from " << checkpoint_file << ": number of vertices = " << vertex.size()
+	    << ";  miss count = " << miss_count << std::endl;
+  }
+  else {
+  from.open(state_data_file.c_str());
+  if(from >> itemp) {
+    Configuration::State vtemp;
+    for(int v = 0; v < itemp; ++v) {
+      if(!(from >> vtemp)) {
+	std::cerr << funame << "vertex data file is corrupted\n";
+	throw Error::Input();
+      }
+      vertex.push_back(vtemp);
+    }
+  }
+  from.close();
+  from.clear();
+  }
+
 
   IO::Marker funame_marker(funame);
 
@@ -462,22 +870,44 @@ int main (int argc, char* argv [])
   sigaction(SIGINT,  &sigact, 0);
   sigaction(SIGTERM, &sigact, 0);
   sigaction(SIGHUP,  &sigact, 0);
-  sigaction(SIGABRT, &sigact, 0);
   sigaction(SIGQUIT, &sigact, 0);
   sigaction(SIGTRAP, &sigact, 0);
   sigaction(SIGALRM, &sigact, 0);
+  sigaction(SIGPIPE, &sigact, 0);
+
+  sigact.sa_handler = fatal_signal_handler;
+
+  sigaction(SIGABRT, &sigact, 0);
   sigaction(SIGFPE,  &sigact, 0);
   sigaction(SIGILL,  &sigact, 0);
   sigaction(SIGBUS,  &sigact, 0);
   sigaction(SIGSEGV, &sigact, 0);
-  sigaction(SIGPIPE, &sigact, 0);
 
   // configuration states
   Configuration::State  guess;
   std::vector<Configuration::State> guess_orbit(symm_group->size(), guess);
 
-  int miss_count = 0;
+  std::time_t checkpoint_time = std::time(0);
+
   while(miss_count < miss_count_max) {
+    //
+    // checkpoint before the next guess: the state is consistent
+    if(signal_caught || (checkpoint_interval > 0 && std::time(0) - checkpoint_time >= checkpoint_interval)) {
+      //
+      const int sig = signal_caught;
+      signal_caught = 0;
+
+      sigprocmask(SIG_SETMASK, &block_sig, &old_sig);
+      save_checkpoint(miss_count);
+      if(sig)
+	save_state_data();
+      sigprocmask(SIG_SETMASK, &old_sig, 0);
+
+      checkpoint_time = std::time(0);
+
+      if(sig && sig != SIGUSR1 && sig != SIGUSR2)
+	std::exit(1);
+    }
 
     // randomly initialize
     Random::orient(guess.radius_vector(), 3);
@@ -489,12 +919,7 @@ int main (int argc, char* argv [])
     }
     
     // generate guess orbit
-    guess_orbit[0] = guess;
-
-    
-    //#pragma omp parallel for default(shared) schedule(static)      
-    for(int g = 1; g < symm_group->size(); ++g)
-      symm_group->apply(g, guess, guess_orbit[g]);
+    symm_group->orbit(guess, guess_orbit);
 
     // check the distances to other vertices
     bool miss = false;
@@ -528,13 +953,15 @@ int main (int argc, char* argv [])
     miss_count = 0;
   }
 
-  // state output
+  // state output; the finished run has nothing to resume
   sigprocmask(SIG_SETMASK, &block_sig, &old_sig);
   save_state_data();
+  std::remove(checkpoint_file.c_str());
   sigprocmask(SIG_SETMASK, &old_sig, 0);
 
   // geometry output
   geom_out << vertex.size() << "   " << Structure::size() << "\n";
+  std::vector<int> geom_size;
   itemp = 0;
   for(Vit v = vertex.begin(); v != vertex.end(); ++v, ++itemp) {
     std::vector<std::vector<Atom> > geom;
@@ -544,6 +971,8 @@ int main (int argc, char* argv [])
     } catch(Error::General) {}
     
 
+    geom_size.push_back(geom.size());
+
     geom_out << itemp << "   " << geom.size() << "\n";
     for(int g = 0; g < geom.size(); ++g) {
       for(std::vector<Atom>::const_iterator at = geom[g].begin(); at != geom[g].end(); ++at)
@@ -553,5 +982,9 @@ int main (int argc, char* argv [])
     }
   }
 
+  if(Surrogate::energy_file.size())
+    Surrogate::run(std::vector<Configuration::State>(vertex.begin(), vertex.end()), geom_size,
+		   *symm_group, angle_spacing, base_name);
+
   return 0;
 }
@@ -0,0 +1,293 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2016, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#include "scalapack.hh"
+#include "error.hh"
+
+#include <mpi.h>
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+extern "C" {
+
+  void Cblacs_pinfo (int* rank, int* nprocs);
+  void Cblacs_get (int context, int what, int* val);
+  void Cblacs_gridinit (int* context, const char* order, int nprow, int npcol);
+  void Cblacs_gridinfo (int context, int* nprow, int* npcol, int* myrow, int* mycol);
+  void Cblacs_gridexit (int context);
+
+  int numroc_(const int& n, const int& nb, const int& iproc, const int& isrcproc, const int& nprocs);
+
+  void descinit_(int* desc, const int& m, const int& n, const int& mb, const int& nb, const int& irsrc,
+		 const int& icsrc, const int& ictxt, const int& lld, int& info);
+
+  void pdsyevd_(const char& jobz, const char& uplo, const int& n, double* a, const int& ia, const int& ja,
+		const int* desca, double* w, double* z, const int& iz, const int& jz, const int* descz,
+		double* work, const int& lwork, int* iwork, const int& liwork, int& info);
+
+  void pdpotrf_(const char& uplo, const int& n, double* a, const int& ia, const int& ja, const int* desca,
+		int& info);
+
+  void pdpotrs_(const char& uplo, const int& n, const int& nrhs, const double* a, const int& ia, const int& ja,
+		const int* desca, double* b, const int& ib, const int& jb, const int* descb, int& info);
+}
+
+namespace Scalapack {
+  //
+  int block_size = 64;
+
+  // process grid
+  //
+  int _context = -1;
+  int _nprow, _npcol, _myrow, _mycol;
+
+  void _set_grid ();
+
+  // global index of the local one
+  //
+  inline int _global_index (int l, int iproc, int nprocs)
+  {
+    return (l / block_size * nprocs + iproc) * block_size + l % block_size;
+  }
+}
+
+void Scalapack::_set_grid ()
+{
+  if(_context >= 0)
+    return;
+  
+  int rank, nprocs;
+  Cblacs_pinfo(&rank, &nprocs);
+
+  // as square as possible
+  _nprow = (int)std::sqrt((double)nprocs);
+  while(nprocs % _nprow)
+    --_nprow;
+  _npcol = nprocs / _nprow;
+
+  Cblacs_get(-1, 0, &_context);
+  Cblacs_gridinit(&_context, "Row", _nprow, _npcol);
+  Cblacs_gridinfo(_context, &_nprow, &_npcol, &_myrow, &_mycol);
+}
+
+int Scalapack::size ()
+{
+  int res;
+  MPI_Comm_size(MPI_COMM_WORLD, &res);
+  return res;
+}
+
+void Scalapack::finalize ()
+{
+  if(_context < 0)
+    return;
+
+  Cblacs_gridexit(_context);
+  _context = -1;
+}
+
+void Scalapack::SymmetricMatrix::resize (int s)
+{
+  const char funame [] = "Scalapack::SymmetricMatrix::resize: ";
+
+  if(s <= 0) {
+    std::cerr << funame << "wrong size: " << s << "\n";
+    throw Error::Range();
+  }
+
+  _set_grid();
+
+  _size = s;
+  _local_size1 = numroc_(_size, block_size, _myrow, 0, _nprow);
+  _local_size2 = numroc_(_size, block_size, _mycol, 0, _npcol);
+
+  int info;
+  descinit_(_desc, _size, _size, block_size, block_size, 0, 0, _context, std::max(1, _local_size1), info);
+
+  if(info) {
+    std::cerr << funame << "descinit: " << -info << "-th argument has an illegal value\n";
+    throw Error::Range();
+  }
+
+  _local.assign(std::max(1, _local_size1 * _local_size2), 0.);
+}
+
+bool Scalapack::SymmetricMatrix::is_local (int i, int j) const
+{
+  if(i > j)
+    std::swap(i, j);
+
+  return i / block_size % _nprow == _myrow && j / block_size % _npcol == _mycol;
+}
+
+int Scalapack::SymmetricMatrix::_local_index (int i, int j) const
+{
+  const int li = i / (block_size * _nprow) * block_size + i % block_size;
+  const int lj = j / (block_size * _npcol) * block_size + j % block_size;
+
+  return li + lj * _local_size1;
+}
+
+double& Scalapack::SymmetricMatrix::operator() (int i, int j)
+{
+  const char funame [] = "Scalapack::SymmetricMatrix::operator(): ";
+
+  if(i > j)
+    std::swap(i, j);
+
+  if(i < 0 || j >= _size) {
+    std::cerr << funame << "out of range\n";
+    throw Error::Range();
+  }
+
+  if(is_local(i, j))
+    return _local[_local_index(i, j)];
+
+  return _sink;
+}
+
+Scalapack::SymmetricMatrix& Scalapack::SymmetricMatrix::operator= (double d)
+{
+  std::fill(_local.begin(), _local.end(), d);
+  return *this;
+}
+
+Lapack::Vector Scalapack::SymmetricMatrix::eigenvalues (int evec_num, Lapack::Matrix* evec) const
+{
+  const char funame [] = "Scalapack::SymmetricMatrix::eigenvalues: ";
+
+  if(!isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(evec && (evec_num <= 0 || evec_num > _size)) {
+    std::cerr << funame << "requested number of eigenvectors out of range: " << evec_num << "\n";
+    throw Error::Range();
+  }
+
+  std::vector<double> a = _local;
+  std::vector<double> z(_local.size());
+
+  Lapack::Vector res(_size);
+
+  // workspace query
+  int info, iwork_size;
+  double work_size;
+  pdsyevd_('V', 'U', _size, &a[0], 1, 1, _desc, res, &z[0], 1, 1, _desc, &work_size, -1, &iwork_size, 1, info);
+
+  if(!info) {
+    std::vector<double> work((int)work_size);
+    std::vector<int> iwork(iwork_size);
+    pdsyevd_('V', 'U', _size, &a[0], 1, 1, _desc, res, &z[0], 1, 1, _desc, &work[0], work.size(),
+	     &iwork[0], iwork.size(), info);
+  }
+
+  if(info < 0) {
+    std::cerr << funame << "pdsyevd: " << -info << "-th argument has an illegal value\n";
+    throw Error::Range();
+  }
+  else if(info) {
+    std::cerr << funame << "pdsyevd: failed to compute the eigenvalues: " << info << "\n";
+    throw Error::Math();
+  }
+
+  if(!evec)
+    return res;
+
+  // gather the lowest eigenvectors
+  evec->resize(_size, evec_num);
+  *evec = 0.;
+
+  for(int lj = 0; lj < _local_size2; ++lj) {
+    const int j = _global_index(lj, _mycol, _npcol);
+    if(j >= evec_num)
+      continue;
+
+    for(int li = 0; li < _local_size1; ++li)
+      (*evec)(_global_index(li, _myrow, _nprow), j) = z[li + lj * _local_size1];
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, (double*)*evec, _size * evec_num, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+  return res;
+}
+
+Lapack::Matrix Scalapack::SymmetricMatrix::positive_invert (const Lapack::Matrix& m) const
+{
+  const char funame [] = "Scalapack::SymmetricMatrix::positive_invert: ";
+
+  if(!isinit() || !m.isinit()) {
+    std::cerr << funame << "not initialized\n";
+    throw Error::Init();
+  }
+
+  if(m.size1() != _size) {
+    std::cerr << funame << "dimensions mismatch\n";
+    throw Error::Range();
+  }
+
+  int info;
+
+  std::vector<double> a = _local;
+  pdpotrf_('U', _size, &a[0], 1, 1, _desc, info);
+
+  if(info < 0) {
+    std::cerr << funame << "pdpotrf: " << -info << "-th argument has an illegal value\n";
+    throw Error::Range();
+  }
+  else if(info) {
+    std::cerr << funame << "pdpotrf: the leading minor of the " << info << "-th order is not positive definite\n";
+    throw Error::Math();
+  }
+
+  // distributed right hand side
+  const int nrhs = m.size2();
+  const int local_nrhs = numroc_(nrhs, block_size, _mycol, 0, _npcol);
+
+  int desc [9];
+  descinit_(desc, _size, nrhs, block_size, block_size, 0, 0, _context, std::max(1, _local_size1), info);
+
+  if(info) {
+    std::cerr << funame << "descinit: " << -info << "-th argument has an illegal value\n";
+    throw Error::Range();
+  }
+
+  std::vector<double> b(std::max(1, _local_size1 * local_nrhs));
+  for(int lj = 0; lj < local_nrhs; ++lj)
+    for(int li = 0; li < _local_size1; ++li)
+      b[li + lj * _local_size1] = m(_global_index(li, _myrow, _nprow), _global_index(lj, _mycol, _npcol));
+
+  pdpotrs_('U', _size, nrhs, &a[0], 1, 1, _desc, &b[0], 1, 1, desc, info);
+
+  if(info) {
+    std::cerr << funame << "pdpotrs: " << -info << "-th argument has an illegal value\n";
+    throw Error::Range();
+  }
+
+  // gather the solution
+  Lapack::Matrix res(_size, nrhs);
+  res = 0.;
+
+  for(int lj = 0; lj < local_nrhs; ++lj)
+    for(int li = 0; li < _local_size1; ++li)
+      res(_global_index(li, _myrow, _nprow), _global_index(lj, _mycol, _npcol)) = b[li + lj * _local_size1];
+
+  MPI_Allreduce(MPI_IN_PLACE, (double*)res, _size * nrhs, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+
+  return res;
+}
@@ -0,0 +1,71 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2016, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#ifndef SCALAPACK_HH
+#define SCALAPACK_HH
+
+#include "lapack.hh"
+
+#include <vector>
+
+// distributed memory linear algebra over the MPI_COMM_WORLD processes
+//
+namespace Scalapack {
+  //
+  extern int block_size; // block-cyclic distribution block size
+
+  int  size (); // number of processes
+  void finalize ();
+
+  // symmetric matrix distributed block-cyclically over the process grid,
+  // only the upper triangle is referenced
+  //
+  class SymmetricMatrix {
+    int _size;
+    int _local_size1;
+    int _local_size2;
+    int _desc [9];
+
+    std::vector<double> _local;
+
+    double _sink; // non-local elements
+
+    int _local_index (int, int) const ;
+
+  public:
+    SymmetricMatrix () : _size(0) {}
+    explicit SymmetricMatrix (int s) : _size(0) { resize(s); }
+    void resize (int) ;
+
+    bool isinit () const { return _size; }
+    int  size   () const { return _size; }
+
+    bool is_local (int, int) const ;
+
+    // element access by the global indices; non-local elements are discarded
+    double& operator() (int, int) ;
+
+    SymmetricMatrix& operator= (double) ;
+
+    // all eigenvalues (pdsyevd); the lowest evec_num eigenvectors are gathered on every process
+    Lapack::Vector eigenvalues (int evec_num, Lapack::Matrix* =0) const ;
+
+    // solve linear equations with the positive definite matrix (pdpotrf/pdpotrs);
+    // the right hand side and the solution are replicated on every process
+    Lapack::Matrix positive_invert (const Lapack::Matrix&) const ;
+  };
+}
+
+#endif
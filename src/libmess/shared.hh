@@ -23,6 +23,9 @@
  ********************************* Shared Pointer ***********************************
  ****************** creates a reference for a new dynamical object  *****************
  ***********************************************************************************/
+
+// the reference counts are updated atomically, so that the pointers to the same object
+// can be copied and destroyed in different threads
 template<typename T>
 class ConstSharedPointer;
 
@@ -68,9 +71,13 @@ void SharedPointer<T>::_delete_ref()
 {
   if(!_count)
     return;
-  if(*_count > 1)
-    --(*_count);
-  else {
+
+  int left;
+
+#pragma omp atomic capture
+  left = --(*_count);
+
+  if(!left) {
     delete _pnt;
     delete _count;
   }
@@ -82,6 +89,7 @@ void SharedPointer<T>::_create_ref(const SharedPointer& s)
   _pnt = s._pnt;
   _count = s._count;
   if(_count)
+#pragma omp atomic
     ++(*_count);
 }
 
@@ -186,9 +194,13 @@ void ConstSharedPointer<T>::_delete_ref()
 {
   if(!_count)
     return;
-  if(*_count > 1)
-    --(*_count);
-  else {
+
+  int left;
+
+#pragma omp atomic capture
+  left = --(*_count);
+
+  if(!left) {
     delete _pnt;
     delete _count;
   }
@@ -200,6 +212,7 @@ void ConstSharedPointer<T>::_create_ref(const ConstSharedPointer& s)
   _pnt = s._pnt;
   _count = s._count;
   if(_count)
+#pragma omp atomic
     ++(*_count);
 }
 
@@ -209,6 +222,7 @@ void ConstSharedPointer<T>::_create_ref(const SharedPointer<T>& s)
   _pnt = s._pnt;
   _count = s._count;
   if(_count)
+#pragma omp atomic
     ++(*_count);
 }
 
@@ -15,6 +15,8 @@
 
 #include "slatec.h"
 
+#include <cmath>
+
 /****************************************************************************************************
  *                   Differential equations solver by the Adams-Bashforth-Moulton                   *
  *                    Predictor-Corrector formulas of orders one through twelve                     *
@@ -133,10 +135,9 @@ void Slatec::AdamSolver::run(double& x, double* y, double xout,
  *                                  Spline fitting                                *
  *********************************************************************************/
 
-void Slatec::Spline::init (const double* x, const double* y, 
-		       int_t s) 
+void Slatec::Spline::_set_range (const double* x, const double* y, int_t s)
 {
-    const char funame [] = "Slatec::Spline::init: ";
+    const char funame [] = "Slatec::Spline::_set_range: ";
 
     if(_size) {
       std::cerr << funame << "already initialized\n";
@@ -149,10 +150,8 @@ void Slatec::Spline::init (const double* x, const double* y,
 	throw Error::Init();
     }
 
-    _size = s;
-
     // check order
-    const double* const end = x + _size;
+    const double* const end = x + s;
     for(const double* p = x; p != end; ++p) {
 	if(p != x && *p <= _xmax) {
 	    std::cerr << funame << "x values are not in increasing order at i = " 
@@ -162,24 +161,133 @@ void Slatec::Spline::init (const double* x, const double* y,
 	_xmax = *p;
     }
 
+    _size = s;
+
     _xmin = *x;
     _ymin = *y;
     _ymax = *(y + _size - 1);
 
-    // initialization
-    _inbv = 1;
-    _dim = _size + 2;
-    _kn.resize(_dim + 4);
-    _bc.resize(_dim);
-    Array<double> work(5 * _dim);
+    // uniform grid check
+    const double step = (_xmax - _xmin) / double(_size - 1);
+    
+    _step    = step;
+    _rstep   = 1. / step;
+    _uniform = true;
+    for(int_t i = 1; i < _size - 1 && _uniform; ++i)
+      if(std::fabs(x[i] - _xmin - double(i) * step) > 1.e-10 * step)
+	_uniform = false;
+}
 
-    int_t n, k;
-    dbint4_(x, y, _size, 2, 2, 0., 0., 1, 
-	     _kn, _bc, n, k, work);
+void Slatec::Spline::map (const double* x, const double* y, const double* coef, int_t s)
+{
+    _set_range(x, y, s);
 
-    if (n != _dim || k != 4) {
-	std::cerr << funame << "slatec dbint4 failed\n";
-	throw Error::Init();
+    _ext_kn   = x;
+    _ext_coef = coef;
+}
+
+void Slatec::Spline::init (const double* x, const double* y, 
+		       int_t s) 
+{
+    _set_range(x, y, s);
+
+    // the knots of a uniform grid are recomputed on the fly, so that the states grids of
+    // the species keep the coefficients only
+    if(!_uniform) {
+      _kn.resize(_size);
+      for(int_t i = 0; i < _size; ++i)
+	_kn[i] = x[i];
+    }
+
+    // second derivatives with zero values at the ends
+    Array<double> m(_size, 0.);
+    
+    if(_size > 2) {
+      //
+      Array<double> diag(_size), rhs(_size);
+      
+      // forward elimination of the tridiagonal system
+      double h0 = x[1] - x[0], h1;
+      for(int_t i = 1; i < _size - 1; ++i, h0 = h1) {
+	h1 = x[i + 1] - x[i];
+
+	diag[i] = 2. * (h0 + h1);
+	rhs[i]  = 6. * ((y[i + 1] - y[i]) / h1 - (y[i] - y[i - 1]) / h0);
+
+	if(i > 1) {
+	  const double f = h0 / diag[i - 1];
+	  diag[i] -= f * h0;
+	  rhs[i]  -= f * rhs[i - 1];
+	}
+      }
+
+      // back substitution
+      for(int_t i = _size - 2; i > 0; --i)
+	m[i] = (rhs[i] - (x[i + 1] - x[i]) * m[i + 1]) / diag[i];
+    }
+
+    // y = c0 + c1 * t + c2 * t^2 + c3 * t^3,  t = x - x_i
+    _coef.resize(4 * (_size - 1));
+    for(int_t i = 0; i < _size - 1; ++i) {
+      const double h = x[i + 1] - x[i];
+      double* c = &_coef[4 * i];
+
+      c[0] = y[i];
+      c[1] = (y[i + 1] - y[i]) / h - h * (2. * m[i] + m[i + 1]) / 6.;
+      c[2] = m[i] / 2.;
+      c[3] = (m[i + 1] - m[i]) / h / 6.;
+    }
+}
+
+Slatec::int_t Slatec::Spline::_locate (double x, int_t i) const 
+{
+    if(i < 0 || i >= _size - 1) {
+      //
+      if(_uniform) {
+	i = int_t((x - _xmin) * _rstep);
+      }
+      else {
+	// bisection
+	int_t lo = 0, hi = _size - 1;
+	while(hi - lo > 1) {
+	  const int_t mid = (lo + hi) / 2;
+	  if(x < _knot(mid))
+	    hi = mid;
+	  else
+	    lo = mid;
+	}
+	i = lo;
+      }
+
+      if(i < 0)
+	i = 0;
+      if(i > _size - 2)
+	i = _size - 2;
+    }
+
+    // the guess correction, x_i <= x < x_i+1
+    while(i > 0 && x < _knot(i))
+      --i;
+    while(i < _size - 2 && x >= _knot(i + 1))
+      ++i;
+
+    return i;
+}
+
+double Slatec::Spline::_value (int_t i, double x, int_t drv) const
+{
+    const double* c = coefficients() + 4 * i;
+    const double  t = x - _knot(i);
+
+    switch(drv) {
+    case 0:
+      return c[0] + t * (c[1] + t * (c[2] + t * c[3]));
+    case 1:
+      return c[1] + t * (2. * c[2] + 3. * t * c[3]);
+    case 2:
+      return 2. * c[2] + 6. * t * c[3];
+    default:
+      return 6. * c[3];
     }
 }
 
@@ -192,7 +300,11 @@ double Slatec::Spline::operator()(double x, int_t drv) const
       throw Error::Init();
     }
 
-    static double work[12];
+    if(drv < 0 || drv > 3) {
+      std::cerr << funame << "derivative order out of range: " << drv << "\n";
+      throw Error::Range();
+    }
+
     if(x < _xmin || x > _xmax) {
 	std::cerr << funame << " x is out of range: xmin = " 
 		  << _xmin   << ", x = " << x << ", xmax = " 
@@ -200,5 +312,38 @@ double Slatec::Spline::operator()(double x, int_t drv) const
 	throw Error::Range();
     }
 
-    return dbvalu_(_kn, _bc, _dim, 4, drv, x, _inbv, work);
+    return _value(_locate(x), x, drv);
+}
+
+void Slatec::Spline::evaluate (const double* x, int_t n, double* y, int_t drv) const 
+{
+    const char funame [] = "Slatec::Spline::evaluate: ";
+
+    if(!_size) {
+      std::cerr << funame << "not initialized\n";
+      throw Error::Init();
+    }
+
+    if(drv < 0 || drv > 3) {
+      std::cerr << funame << "derivative order out of range: " << drv << "\n";
+      throw Error::Range();
+    }
+
+    // the previous interval is the starting guess
+    int_t i = -1;
+    for(int_t k = 0; k < n; ++k) {
+      if(x[k] < _xmin || x[k] > _xmax) {
+	std::cerr << funame << " x is out of range: xmin = " 
+		  << _xmin   << ", x = " << x[k] << ", xmax = " 
+		  << _xmax << "\n";
+	throw Error::Range();
+      }
+
+      // jumps beyond the neighboring intervals are located from scratch
+      if(i >= 0 && (i > 0 && x[k] < _knot(i - 1) || i < _size - 2 && x[k] >= _knot(i + 2)))
+	i = -1;
+      
+      i = _locate(x[k], i);
+      y[k] = _value(i, x[k], drv);
+    }
 }
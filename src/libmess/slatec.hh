@@ -59,28 +59,48 @@ namespace Slatec {
    *                              Spline fitting                                  *
    *******************************************************************************/
 
+  // natural cubic spline interpolation (the boundary conditions of the former dbint4 fit)
+  // evaluated natively: the coefficients of each interval are stored contiguously and
+  // the interval is located in constant time on a uniform grid
+  //
   class Spline
   {
     int_t _size;
 
-    int_t         _dim;
-    Array<double> _kn;   // spline knots
-    Array<double> _bc;   // spline coefficients
-    mutable int_t _inbv; // slatec internal parameter
+    Array<double> _kn;   // spline knots, not stored on a uniform grid
+    Array<double> _coef; // polynomial coefficients, four per interval
+
+    // the knots and the coefficients in the external storage (mapped), none if owned
+    const double* _ext_kn;
+    const double* _ext_coef;
+
+    bool   _uniform; // equidistant knots
+    double _step;    // knot step
+    double _rstep;   // inverse knot step
+
+    double _knot (int_t i) const { return _uniform ? _xmin + double(i) * _step : _ext_kn ? _ext_kn[i] : _kn[i]; }
+
+    void _set_range (const double*, const double*, int_t) ;
 
     double _xmax;
     double _xmin;
     double _ymin;
     double _ymax;
 
-    //Spline (const Spline&);
-    //Spline& operator= (const Spline&);
+    int_t  _locate (double, int_t =-1) const; // interval index, optionally starting from a guess
+    double _value  (int_t, double, int_t) const;
 
   public:
 
-    Spline () : _size(0) {}
+    Spline () : _size(0), _ext_kn(0), _ext_coef(0) {}
     void init (const double*, const double*, int_t) ;
-    Spline (const double* x, const double* y, int_t n)  : _size(0) { init(x, y, n); }
+    Spline (const double* x, const double* y, int_t n)  : _size(0), _ext_kn(0), _ext_coef(0) { init(x, y, n); }
+
+    // the precomputed spline: the knots, the values, and the coefficients (coefficients())
+    // are used in place, e.g., from the mapped file, and should outlive the spline
+    void map (const double* x, const double* y, const double* coef, int_t) ;
+
+    const double* coefficients () const { return _ext_coef ? _ext_coef : (const double*)_coef; }
 
     int_t size () const { return _size; }
 
@@ -93,6 +113,9 @@ namespace Slatec {
 
     // evaluate i-th derivative at x
     double operator() (double, int_t =0) const ; 
+
+    // i-th derivative on the set of points, fastest for the monotonic ones
+    void evaluate (const double* x, int_t n, double* y, int_t =0) const ;
   };
 
 } // Slatec
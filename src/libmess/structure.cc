@@ -1332,6 +1332,12 @@ bool Molecule::is_equal (std::vector<Atom> mol, D3::Vector& shift, Quaternion& o
   for(int a = 0; a < size(); ++a)
     mol[a] -= shift;
 
+  // orientation independent pre-filter: the atoms and their distances to the center of mass
+  for(int a = 0; a < size(); ++a)
+    if((const AtomBase&)mol[a] != (const AtomBase&)(*this)[a]
+       || !are_equal(mol[a].vlength(), (*this)[a].vlength(), tolerance))
+      return false;
+
   D3::Matrix mol_orient(mol[ref_group[0]], mol[ref_group[1]]);
   
   mol_orient = ref_orient.transpose() * mol_orient;
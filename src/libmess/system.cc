@@ -330,3 +330,20 @@ void* System::DynLib::member (const std::string& sym)
     return res;
 }
 
+void* System::DynLib::find (const std::string& sym) 
+{
+    const char funame [] = "System::DynLib::find: ";
+
+    if(!_handle) {
+	std::cerr << funame << "library has not been opened\n";
+	throw Error::Init();
+    }
+
+    dlerror();
+    void* res = dlsym(_handle, sym.c_str());
+    if(dlerror())
+	return 0;
+
+    return res;
+}
+
@@ -117,6 +117,7 @@ namespace System {
 	
 	bool isopen () const;
 	void* member (const std::string&) ;
+	void* find   (const std::string&) ; // null if there is no such symbol
     };
 
     inline bool DynLib::isopen () const
@@ -1,4 +1,5 @@
 #include <list>
+#include <exception>
 
 #include "thermo.hh"
 #include "graph_omp.hh"
@@ -20,6 +21,10 @@ double  Thermo::Species::numd_step        = 0.01;
 //
 double  Thermo::Species::samp_step        = 0.1;
 
+// number of threads for the numerical derivatives potential evaluations
+//
+int     Thermo::CSpec::thread_num         = 1;
+
 // low  frequency threshold in qfactor
 //
 double  Thermo::QFactor::low_freq_thresh  = 1.e-3;
@@ -134,15 +139,14 @@ void Thermo::CSpec::init (const std::vector<Atom>& mol, ConstSharedPointer<Coord
 
   // configuration grid points for numerical derivatives
   //
-  for(SymIndex sin(_atom_size() * 3); sin.size() <= Graph::potex_max; ++sin) {
+  _stencil = NumDer::Stencil(_atom_size() * 3);
+  
+  for(SymIndex sin(_atom_size() * 3); sin.size() <= Graph::potex_max; ++sin)
     //
-    NumDer::cmap_t cmap = NumDer(_atom.size() * 3).convert(sin);
+    _stencil.add(sin);
 
-    for(NumDer::cmap_t::const_iterator cmit = cmap.begin(); cmit != cmap.end(); ++cmit) {
-      //
-      _conf_pool.insert(cmit->first);
-    }
-  }
+  IO::log << IO::log_offset << "number of displaced configurations for numerical derivatives = "
+	  << _stencil.size() << "\n";
 
   // individual mass square root
   //
@@ -380,9 +384,9 @@ void Thermo::CSpec::set_potex (const pos_t& pos) const
   
   // function-on-the-grid data for numerical derivatives
   //
-  NumDer::fdata_t fdata;
+  std::vector<double> fval;
 
-  _set_fdata(pos, fdata);
+  _set_fdata(pos, fval);
   
   const int cart_size = _atom.size() * 3;
   
@@ -392,7 +396,7 @@ void Thermo::CSpec::set_potex (const pos_t& pos) const
 
   for(SymIndex sin(cart_size); sin.size() <= Graph::potex_max; ++sin)
     //
-    pot_der[sin] = NumDer(cart_size)(sin, fdata, numd_step);
+    pot_der[sin] = _stencil(sin, fval, numd_step);
   
 
   // mass-waited hessian without cm motion
@@ -519,23 +523,42 @@ void Thermo::CSpec::set_potex (const pos_t& pos) const
 
 // potential-on-the-grid data for numerical derivative calculations
 //
-void Thermo::CSpec::_set_fdata(const pos_t& pos, NumDer::fdata_t& fdata) const
+void Thermo::CSpec::_set_fdata(const pos_t& pos, std::vector<double>& fval) const
 {
-  fdata.clear();
-  
-  Coord::Cartesian temp_pos(_atom_size * 3);
-    
-  for(std::set<std::vector<int> >::const_iterator cit = _conf_pool.begin(); cit != _conf_pool.end(); ++cit) {
+  fval.resize(_stencil.size());
+
+  std::exception_ptr error;
+
+#pragma omp parallel for default(shared) schedule(dynamic) num_threads(thread_num)
+
+  for(int c = 0; c < _stencil.size(); ++c) {
     //
-    temp_pos  = pos;
+    try {
+      //
+      Coord::Cartesian temp_pos(pos.size());
 
-    for(int i = 0; i < pos.size(); ++i) {
+      temp_pos = pos;
+
+      for(int i = 0; i < pos.size(); ++i) {
+	//
+	temp_pos[i] += (double)_stencil.conf(c)[i] * numd_step;
+      }
+    
+      fval[c] = _pot->evaluate(temp_pos);
+    }
+    catch(...) {
       //
-      temp_pos[i] += (double)(*cit)[i] * numd_step;
+#pragma omp critical(numd_error)
+      
+      if(!error)
+	//
+	error = std::current_exception();
     }
-    
-    fdata[*cit] = _pot->evaluate(temp_pos);
   }
+
+  if(error)
+    //
+    std::rethrow_exception(error);
 }
 
 double Thermo::SpecBase::anharmonic_correction (double temperature) const
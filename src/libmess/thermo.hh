@@ -245,9 +245,9 @@ namespace Thermo {
 
     void _isinit () const;
     
-    // configuration signatures set for numerical derivatives
+    // displaced configurations for numerical derivatives
     //
-    std::set<std::vector<int> > _conf_pool;
+    NumDer::Stencil _stencil;
 
     // basis orthogonal to cm motion
     //
@@ -255,7 +255,7 @@ namespace Thermo {
 
     // potential-on-the-grid for numerical derivatives
     //
-    void _set_fdata(const pos_t& pos, NumDer::fdata_t& fdata) const;
+    void _set_fdata(const pos_t& pos, std::vector<double>& fval) const;
     
     void _print_geom (const pos_t&) const;
 
@@ -283,6 +283,10 @@ namespace Thermo {
     //
     static double samp_step;
 
+    // number of threads for the potential evaluations on the stencil
+    //
+    static int thread_num;
+    
     //
     //
   };// CSpec
@@ -0,0 +1,352 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#include "threads.hh"
+#include "io.hh"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <dlfcn.h>
+#include <sched.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+  //
+  int total_size = 0;
+  int outer_size = 1;
+  int bind_policy = Threads::BIND_NONE;
+
+  // BLAS threads control entries
+  typedef void (*set_int_t)  (int);
+  typedef int  (*get_int_t)  ();
+  typedef void (*set_long_t) (long);
+  typedef long (*get_long_t) ();
+
+  bool        blas_isinit = false;
+  std::string blas_name;
+  set_int_t   blas_set_int  = 0;
+  get_int_t   blas_get_int  = 0;
+  set_long_t  blas_set_long = 0;
+  get_long_t  blas_get_long = 0;
+
+  void blas_init ()
+  {
+    if(blas_isinit)
+      return;
+
+    blas_isinit = true;
+
+    if((blas_set_int = (set_int_t)dlsym(RTLD_DEFAULT, "openblas_set_num_threads"))) {
+      blas_get_int = (get_int_t)dlsym(RTLD_DEFAULT, "openblas_get_num_threads");
+      blas_name = "OpenBLAS";
+    }
+    else if((blas_set_int = (set_int_t)dlsym(RTLD_DEFAULT, "MKL_Set_Num_Threads"))) {
+      blas_get_int = (get_int_t)dlsym(RTLD_DEFAULT, "MKL_Get_Max_Threads");
+      blas_name = "MKL";
+    }
+    else if((blas_set_long = (set_long_t)dlsym(RTLD_DEFAULT, "bli_thread_set_num_threads"))) {
+      blas_get_long = (get_long_t)dlsym(RTLD_DEFAULT, "bli_thread_get_num_threads");
+      blas_name = "BLIS";
+    }
+  }
+
+  bool in_parallel ()
+  {
+#ifdef _OPENMP
+    return omp_in_parallel();
+#else
+    return false;
+#endif
+  }
+
+  // cpu list in the kernel format, e.g. 0-3,8,10-11
+  std::vector<int> cpu_list (const std::string& s)
+  {
+    std::vector<int> res;
+
+    std::istringstream from(s);
+    std::string range;
+    while(std::getline(from, range, ',')) {
+      int a, b;
+      char c;
+      std::istringstream rfrom(range);
+      if(!(rfrom >> a))
+	continue;
+      if(rfrom >> c >> b)
+	for(int i = a; i <= b; ++i)
+	  res.push_back(i);
+      else
+	res.push_back(a);
+    }
+
+    return res;
+  }
+
+  // cores of the process affinity mask in the NUMA node order, one list per node
+  std::vector<std::vector<int> > node_cores ()
+  {
+    std::vector<std::vector<int> > res;
+
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if(sched_getaffinity(0, sizeof(mask), &mask))
+      return res;
+
+    std::vector<char> done(CPU_SETSIZE, 0);
+
+    for(int n = 0; ; ++n) {
+      std::ostringstream name;
+      name << "/sys/devices/system/node/node" << n << "/cpulist";
+
+      std::ifstream from(name.str().c_str());
+      if(!from)
+	break;
+
+      std::string line;
+      std::getline(from, line);
+
+      std::vector<int> node;
+      std::vector<int> cpu = cpu_list(line);
+      for(int i = 0; i < cpu.size(); ++i)
+	if(cpu[i] >= 0 && cpu[i] < CPU_SETSIZE && CPU_ISSET(cpu[i], &mask) && !done[cpu[i]]) {
+	  node.push_back(cpu[i]);
+	  done[cpu[i]] = 1;
+	}
+
+      if(node.size())
+	res.push_back(node);
+    }
+
+    // no NUMA information
+    std::vector<int> rest;
+    for(int i = 0; i < CPU_SETSIZE; ++i)
+      if(CPU_ISSET(i, &mask) && !done[i])
+	rest.push_back(i);
+
+    if(rest.size())
+      res.push_back(rest);
+
+    return res;
+  }
+}
+
+void Threads::init (int n)
+{
+  const char funame [] = "Threads::init: ";
+
+  if(n < 0) {
+    std::cerr << funame << "out of range\n";
+    throw Error::Range();
+  }
+
+#ifdef _OPENMP
+  if(!n)
+    n = omp_get_max_threads();
+  else
+    omp_set_num_threads(n);
+#else
+  n = 1;
+#endif
+
+  total_size = n;
+  outer_size = 1;
+
+  // the serial sections get all the cores
+  set_blas(n);
+}
+
+int Threads::total ()
+{
+  if(!total_size) {
+#ifdef _OPENMP
+    total_size = omp_get_max_threads();
+#else
+    total_size = 1;
+#endif
+  }
+
+  return total_size;
+}
+
+int Threads::blas ()
+{
+  blas_init();
+
+  if(blas_get_int)
+    return blas_get_int();
+
+  if(blas_get_long)
+    return (int)blas_get_long();
+
+  return -1;
+}
+
+void Threads::set_blas (int n)
+{
+  const char funame [] = "Threads::set_blas: ";
+
+  if(n <= 0) {
+    std::cerr << funame << "out of range\n";
+    throw Error::Range();
+  }
+
+  blas_init();
+
+  if(blas_set_int)
+    blas_set_int(n);
+  else if(blas_set_long)
+    blas_set_long(n);
+}
+
+void Threads::set_nested (int n)
+{
+  const char funame [] = "Threads::set_nested: ";
+
+  if(n <= 0 || n > total()) {
+    std::cerr << funame << "outer team size, " << n << ", is out of range\n";
+    throw Error::Range();
+  }
+
+  outer_size = n;
+
+#ifdef _OPENMP
+  omp_set_max_active_levels(n > 1 ? 2 : 1);
+#endif
+}
+
+int Threads::outer ()
+{
+  return outer_size;
+}
+
+int Threads::inner ()
+{
+  const int res = total() / outer_size;
+
+  return res > 0 ? res : 1;
+}
+
+void Threads::bind (int policy)
+{
+  const char funame [] = "Threads::bind: ";
+
+  bind_policy = policy;
+
+  if(policy == BIND_NONE)
+    return;
+
+  if(policy != BIND_CLOSE && policy != BIND_SPREAD) {
+    std::cerr << funame << "unknown policy\n";
+    throw Error::Range();
+  }
+
+  std::vector<std::vector<int> > node = node_cores();
+
+  std::vector<int> core;
+  if(policy == BIND_CLOSE) {
+    for(int n = 0; n < node.size(); ++n)
+      core.insert(core.end(), node[n].begin(), node[n].end());
+  }
+  else {
+    for(int i = 0; core.size() < CPU_SETSIZE; ++i) {
+      bool isadd = false;
+      for(int n = 0; n < node.size(); ++n)
+	if(i < node[n].size()) {
+	  core.push_back(node[n][i]);
+	  isadd = true;
+	}
+      if(!isadd)
+	break;
+    }
+  }
+
+  if(!core.size()) {
+    std::cerr << funame << "no cores in the affinity mask\n";
+    throw Error::Init();
+  }
+
+  int fail = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(total()) reduction(+: fail)
+  {
+    const int t = omp_get_thread_num();
+#else
+  {
+    const int t = 0;
+#endif
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(core[t % core.size()], &mask);
+
+    if(sched_setaffinity(0, sizeof(mask), &mask))
+      ++fail;
+  }
+
+  if(fail)
+    IO::log << IO::log_offset << funame << "WARNING: " << fail << " threads could not be bound\n";
+}
+
+void Threads::report (std::ostream& to)
+{
+  to << IO::log_offset << "threads: " << total();
+
+  if(outer_size > 1)
+    to << " (" << outer_size << " x " << inner() << " nested)";
+
+  blas_init();
+  if(blas_name.size())
+    to << ", " << blas_name << " threads: " << blas();
+  else
+    to << ", BLAS threads control is not available";
+
+  switch(bind_policy) {
+  case BIND_CLOSE:
+    to << ", close binding";
+    break;
+  case BIND_SPREAD:
+    to << ", spread binding";
+    break;
+  }
+
+  to << "\n";
+}
+
+Threads::BlasScope::BlasScope (int n) : _prev(-1)
+{
+  if(in_parallel())
+    return;
+
+  if(!n)
+    n = inner();
+
+  _prev = blas();
+
+  if(_prev > 0 && _prev != n)
+    set_blas(n);
+  else
+    _prev = -1;
+}
+
+Threads::BlasScope::~BlasScope ()
+{
+  if(_prev > 0)
+    set_blas(_prev);
+}
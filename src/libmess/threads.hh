@@ -0,0 +1,76 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#ifndef THREADS_HH
+#define THREADS_HH
+
+#include <iostream>
+
+#include "error.hh"
+
+/********************************************************************************************
+ ************************************ THREADING POLICY **************************************
+ ********************************************************************************************/
+
+// the cores of the process are shared between the OpenMP loops and the threaded BLAS
+// (OpenBLAS, MKL, or BLIS, found at run time): the dense linear algebra called from
+// the serial sections gets all the cores of the calling team, the OpenMP loops
+// which call BLAS run it serially
+
+namespace Threads {
+  //
+  // number of cores for the process, default is omp_get_max_threads()
+  //
+  void init (int total = 0);
+  int  total ();
+
+  // BLAS threads number, -1 if the BLAS library has no threads control
+  //
+  int  blas ();
+  void set_blas (int);
+
+  // nested parallelism: the outer team, e.g. the concurrent (T, P) points, and the inner
+  // teams of the loops inside, total / outer threads each
+  //
+  void set_nested (int outer);
+  int  outer ();
+  int  inner ();
+
+  // each OpenMP thread is bound to one core of the process affinity mask, the cores taken
+  // in the NUMA node order (close) or round-robin over the NUMA nodes (spread); the large
+  // matrices filled by the parallel loops are then placed by the first touch
+  //
+  enum { BIND_NONE, BIND_CLOSE, BIND_SPREAD };
+
+  void bind (int policy);
+
+  void report (std::ostream&);
+
+  // BLAS threads number within the scope, the calling team share by default; inside
+  // the parallel regions the (process-wide) setting is not changed
+  //
+  class BlasScope {
+    int _prev;
+
+    BlasScope (const BlasScope&);
+    BlasScope& operator= (const BlasScope&);
+
+  public:
+    explicit BlasScope (int threads = 0);
+    ~BlasScope ();
+  };
+}
+
+#endif
@@ -16,8 +16,14 @@
 #include "trajectory.hh"
 #include "units.hh"
 
+#include <cmath>
+#include <algorithm>
+
 namespace Trajectory {
   double Propagator::step = 100;
+  int    Propagator::solver = Propagator::ADAMS;
+  double Propagator::split_step = 10.;
+  int    RungeKutta::step_max = 100000;
   //Flags Propagator::flags;
   //Dynamic::CCP fail_condition;
 }
@@ -49,24 +55,723 @@ extern "C" void Trajectory::set_dvd (const double& time, const double* dv, doubl
   // ...
 }
 
-void Trajectory::Propagator::run (Dynamic::CCP stop, const Dynamic::Classifier& sort) 
+/************************************************************************************
+ ************************** DORMAND-PRINCE 5(4) INTEGRATOR **************************
+ ************************************************************************************/
+
+Trajectory::RungeKutta::RungeKutta (int s, deriv_t d) 
+  : _deriv(d), _size(s), _step(0.), _work(9 * s)
 {
-  const char funame [] = "Trajectory::Propagator::run: ";
+  const char funame [] = "Trajectory::RungeKutta::RungeKutta: ";
 
-  double dtemp;
-  int itemp;
-  D3::Vector vtemp;
-	
+  if(s <= 0) {
+    std::cerr << funame << "wrong dimension: " << s << "\n";
+    throw Error::Logic();
+  }
+
+  if(!_deriv) {
+    std::cerr << funame << "the function to calculate derivatives should be provided\n";
+    throw Error::Logic();
+  }
+}
+
+Trajectory::RungeKutta::Status Trajectory::RungeKutta::run (double& time, double* y, double tout, 
+							 const double* rel_tol, const double* abs_tol, 
+							 void* par, bool restart)
+{
+  // Butcher tableau
+  static const double c2 = 1./5., c3 = 3./10., c4 = 4./5., c5 = 8./9.;
+
+  static const double a21 =  1./5.;
+  static const double a31 =  3./40.,       a32 =  9./40.;
+  static const double a41 =  44./45.,      a42 = -56./15.,      a43 =  32./9.;
+  static const double a51 =  19372./6561., a52 = -25360./2187., a53 =  64448./6561., a54 = -212./729.;
+  static const double a61 =  9017./3168.,  a62 = -355./33.,     a63 =  46732./5247., a64 =  49./176., a65 = -5103./18656.;
+  static const double a71 =  35./384.,     a73 =  500./1113.,   a74 =  125./192.,    a75 = -2187./6784., a76 = 11./84.;
+
+  // error coefficients: fifth minus fourth order weights
+  static const double e1 =  71./57600., e3 = -71./16695., e4 = 71./1920., e5 = -17253./339200., e6 = 22./525., e7 = -1./40.;
+
+  const double span = tout - time;
+
+  if(span == 0.)
+    return OK;
+
+  const double dir = span > 0. ? 1. : -1.;
+
+  double* k1 = _work;
+  double* k2 = k1 + _size;
+  double* k3 = k2 + _size;
+  double* k4 = k3 + _size;
+  double* k5 = k4 + _size;
+  double* k6 = k5 + _size;
+  double* k7 = k6 + _size;
+  double* yt = k7 + _size;
+  double* yn = yt + _size;
+
+  if(!_deriv(time, y, k1, par))
+    return DERIV_FAIL;
+
+  double h = restart || _step == 0. ? span : _step;
+  if(h * dir <= 0. || h * dir > span * dir)
+    h = span;
+
+  for(int count = 0; count < step_max; ++count) {
+    bool last = false;
+    if((time + h - tout) * dir >= 0.) {
+      h = tout - time;
+      last = true;
+    }
+
+    for(int i = 0; i < _size; ++i)
+      yt[i] = y[i] + h * a21 * k1[i];
+    if(!_deriv(time + c2 * h, yt, k2, par))
+      return DERIV_FAIL;
+
+    for(int i = 0; i < _size; ++i)
+      yt[i] = y[i] + h * (a31 * k1[i] + a32 * k2[i]);
+    if(!_deriv(time + c3 * h, yt, k3, par))
+      return DERIV_FAIL;
+
+    for(int i = 0; i < _size; ++i)
+      yt[i] = y[i] + h * (a41 * k1[i] + a42 * k2[i] + a43 * k3[i]);
+    if(!_deriv(time + c4 * h, yt, k4, par))
+      return DERIV_FAIL;
+
+    for(int i = 0; i < _size; ++i)
+      yt[i] = y[i] + h * (a51 * k1[i] + a52 * k2[i] + a53 * k3[i] + a54 * k4[i]);
+    if(!_deriv(time + c5 * h, yt, k5, par))
+      return DERIV_FAIL;
+
+    for(int i = 0; i < _size; ++i)
+      yt[i] = y[i] + h * (a61 * k1[i] + a62 * k2[i] + a63 * k3[i] + a64 * k4[i] + a65 * k5[i]);
+    if(!_deriv(time + h, yt, k6, par))
+      return DERIV_FAIL;
+
+    for(int i = 0; i < _size; ++i)
+      yn[i] = y[i] + h * (a71 * k1[i] + a73 * k3[i] + a74 * k4[i] + a75 * k5[i] + a76 * k6[i]);
+    if(!_deriv(time + h, yn, k7, par))
+      return DERIV_FAIL;
+
+    // scaled error norm
+    double err = 0.;
+    for(int i = 0; i < _size; ++i) {
+      double scale = std::fabs(y[i]) > std::fabs(yn[i]) ? std::fabs(y[i]) : std::fabs(yn[i]);
+      scale = abs_tol[i] + rel_tol[i] * scale;
+
+      double dtemp = h * (e1 * k1[i] + e3 * k3[i] + e4 * k4[i] + e5 * k5[i] + e6 * k6[i] + e7 * k7[i]) / scale;
+      err += dtemp * dtemp;
+    }
+    err = std::sqrt(err / (double)_size);
+
+    // step size factor
+    double fac = err > 0. ? 0.9 * std::pow(err, -0.2) : 5.;
+    if(fac > 5.)
+      fac = 5.;
+    if(fac < 0.2)
+      fac = 0.2;
+
+    if(err <= 1.) {
+      time = last ? tout : time + h;
+      for(int i = 0; i < _size; ++i) {
+	y[i]  = yn[i];
+	k1[i] = k7[i]; // first same as last
+      }
+
+      if(!last)
+	_step = h;
+
+      if(last)
+	return OK;
+
+      h *= fac;
+    }
+    else {
+      h *= fac < 1. ? fac : 1.;
+      last = false;
+    }
+
+    if(std::fabs(h) <= 1.e-13 * (std::fabs(time) + std::fabs(span)))
+      return STEP_FAIL;
+  }
+
+  return STEP_FAIL;
+}
+
+/************************************************************************************
+ ******************************* BATCH RUNGE-KUTTA **********************************
+ ************************************************************************************/
+
+Trajectory::BatchRungeKutta::BatchRungeKutta (int s, deriv_t d, batch_deriv_t bd) 
+  : _deriv(d), _batch_deriv(bd), _size(s)
+{
+  const char funame [] = "Trajectory::BatchRungeKutta::BatchRungeKutta: ";
+
+  if(s <= 0) {
+    std::cerr << funame << "wrong dimension: " << s << "\n";
+    throw Error::Logic();
+  }
+
+  if(!_deriv) {
+    std::cerr << funame << "the function to calculate derivatives should be provided\n";
+    throw Error::Logic();
+  }
+}
+
+// the arrays are of the size x capacity layout, except the ones with size one
+void Trajectory::BatchRungeKutta::_retire (int slot, int last, int size, int capacity, double** soa, int soa_size)
+{
+  if(slot == last)
+    return;
+
+  for(int a = 0; a < soa_size; ++a)
+    for(int i = 0; i < size; ++i)
+      std::swap(soa[a][i * capacity + slot], soa[a][i * capacity + last]);
+}
+
+void Trajectory::BatchRungeKutta::run (int batch, double* time, double* y, const double* tout, 
+				       const double* rel_tol, const double* abs_tol,
+				       void** par, double* step, int* status) const
+{
+  static const double c2 = 1./5., c3 = 3./10., c4 = 4./5., c5 = 8./9.;
+
+  static const double a21 =  1./5.;
+  static const double a31 =  3./40.,       a32 =  9./40.;
+  static const double a41 =  44./45.,      a42 = -56./15.,      a43 =  32./9.;
+  static const double a51 =  19372./6561., a52 = -25360./2187., a53 =  64448./6561., a54 = -212./729.;
+  static const double a61 =  9017./3168.,  a62 = -355./33.,     a63 =  46732./5247., a64 =  49./176., a65 = -5103./18656.;
+  static const double a71 =  35./384.,     a73 =  500./1113.,   a74 =  125./192.,    a75 = -2187./6784., a76 = 11./84.;
+
+  static const double e1 =  71./57600., e3 = -71./16695., e4 = 71./1920., e5 = -17253./339200., e6 = 22./525., e7 = -1./40.;
+
+  if(batch <= 0)
+    return;
+
+  const int n = _size;
+
+  // working copies in the slot order: the active members occupy the first slots
+  std::vector<double> ys(y, y + n * batch), rts(rel_tol, rel_tol + n * batch), ats(abs_tol, abs_tol + n * batch);
+  std::vector<double> k(7 * n * batch), yt(n * batch), yn(n * batch);
+
+  std::vector<double> ts(time, time + batch), tos(tout, tout + batch), hs(batch), ps(batch);
+  std::vector<int>    member(batch), count(batch, 0);
+
+  double* soa [] = {&ys[0], &rts[0], &ats[0], &yt[0], &yn[0], 
+		    &k[0], &k[n * batch], &k[2 * n * batch], &k[3 * n * batch], &k[4 * n * batch], &k[5 * n * batch], &k[6 * n * batch]};
+  const int soa_size = sizeof(soa) / sizeof(double*);
+
+  double* k1 = soa[5];
+  double* k2 = soa[6];
+  double* k3 = soa[7];
+  double* k4 = soa[8];
+  double* k5 = soa[9];
+  double* k6 = soa[10];
+  double* k7 = soa[11];
+
+  // member state gather/scatter buffers
+  std::vector<double> yb(n), db(n);
+
+  int active = batch;
+
+  // retire the member in the slot: the last active slot takes its place
+  auto retire = [&] (int slot, int stat) {
+    const int b = member[slot];
+    status[b] = stat;
+    time[b]   = ts[slot];
+    step[b]   = ps[slot];
+    for(int i = 0; i < n; ++i)
+      y[i * batch + b] = ys[i * batch + slot];
+
+    --active;
+    _retire(slot, active, n, batch, soa, soa_size);
+    std::swap(member[slot], member[active]);
+    std::swap(ts[slot],     ts[active]);
+    std::swap(tos[slot],    tos[active]);
+    std::swap(hs[slot],     hs[active]);
+    std::swap(ps[slot],     ps[active]);
+    std::swap(count[slot],  count[active]);
+  };
+
+  // derivatives of the member in the slot
+  auto deriv = [&] (double* stage, const double* state, double t, int slot) -> bool {
+    for(int i = 0; i < n; ++i)
+      yb[i] = state[i * batch + slot];
+
+    if(!_deriv(t, &yb[0], &db[0], par[member[slot]]))
+      return false;
+
+    for(int i = 0; i < n; ++i)
+      stage[i * batch + slot] = db[i];
+
+    return true;
+  };
+
+  // derivatives of the active members which have not failed yet
+  std::vector<double> tb(batch);
+  std::vector<void*>  pb(batch);
+  std::vector<char>   fail(batch);
+
+  auto stage = [&] (double* res, const double* state, double c) {
+    if(!_batch_deriv) {
+      for(int s = 0; s < active; ++s)
+	if(!fail[s] && !deriv(res, state, ts[s] + c * hs[s], s))
+	  fail[s] = 1;
+      return;
+    }
+
+    for(int s = 0; s < active; ++s) {
+      tb[s] = ts[s] + c * hs[s];
+      pb[s] = par[member[s]];
+    }
+    _batch_deriv(active, batch, &tb[0], state, res, &pb[0], &fail[0]);
+  };
+
+  for(int s = 0; s < batch; ++s) {
+    member[s] = s;
+    ps[s] = step[s];
+    const double span = tos[s] - ts[s];
+    hs[s] = step[s] == 0. || step[s] * span <= 0. || std::fabs(step[s]) > std::fabs(span) ? span : step[s];
+  }
+
+  for(int s = 0; s < active;)
+    if(tos[s] == ts[s])
+      retire(s, RungeKutta::OK);
+    else
+      ++s;
+
+  for(int s = 0; s < active; ++s)
+    fail[s] = 0;
+
+  stage(k1, &ys[0], 0.);
+
+  for(int s = active - 1; s >= 0; --s)
+    if(fail[s])
+      retire(s, RungeKutta::DERIV_FAIL);
+
+  std::vector<char> last(batch);
+
+  while(active) {
+    // clip the steps at the end points
+    for(int s = 0; s < active; ++s) {
+      last[s] = (ts[s] + hs[s] - tos[s]) * hs[s] >= 0.;
+      if(last[s])
+	hs[s] = tos[s] - ts[s];
+      fail[s] = 0;
+    }
+
+    // stages: linear combinations over the batch with the unit stride
+    for(int i = 0; i < n; ++i) {
+      const int o = i * batch;
+      for(int s = 0; s < active; ++s)
+	yt[o + s] = ys[o + s] + hs[s] * a21 * k1[o + s];
+    }
+    stage(k2, &yt[0], c2);
+
+    for(int i = 0; i < n; ++i) {
+      const int o = i * batch;
+      for(int s = 0; s < active; ++s)
+	yt[o + s] = ys[o + s] + hs[s] * (a31 * k1[o + s] + a32 * k2[o + s]);
+    }
+    stage(k3, &yt[0], c3);
+
+    for(int i = 0; i < n; ++i) {
+      const int o = i * batch;
+      for(int s = 0; s < active; ++s)
+	yt[o + s] = ys[o + s] + hs[s] * (a41 * k1[o + s] + a42 * k2[o + s] + a43 * k3[o + s]);
+    }
+    stage(k4, &yt[0], c4);
+
+    for(int i = 0; i < n; ++i) {
+      const int o = i * batch;
+      for(int s = 0; s < active; ++s)
+	yt[o + s] = ys[o + s] + hs[s] * (a51 * k1[o + s] + a52 * k2[o + s] + a53 * k3[o + s] + a54 * k4[o + s]);
+    }
+    stage(k5, &yt[0], c5);
+
+    for(int i = 0; i < n; ++i) {
+      const int o = i * batch;
+      for(int s = 0; s < active; ++s)
+	yt[o + s] = ys[o + s] + hs[s] * (a61 * k1[o + s] + a62 * k2[o + s] + a63 * k3[o + s] + a64 * k4[o + s]
+					 + a65 * k5[o + s]);
+    }
+    stage(k6, &yt[0], 1.);
+
+    for(int i = 0; i < n; ++i) {
+      const int o = i * batch;
+      for(int s = 0; s < active; ++s)
+	yn[o + s] = ys[o + s] + hs[s] * (a71 * k1[o + s] + a73 * k3[o + s] + a74 * k4[o + s] + a75 * k5[o + s]
+					 + a76 * k6[o + s]);
+    }
+    stage(k7, &yn[0], 1.);
+
+    // scaled error norms
+    std::vector<double> err(active, 0.);
+    for(int i = 0; i < n; ++i) {
+      const int o = i * batch;
+      for(int s = 0; s < active; ++s) {
+	double scale = std::fabs(ys[o + s]) > std::fabs(yn[o + s]) ? std::fabs(ys[o + s]) : std::fabs(yn[o + s]);
+	scale = ats[o + s] + rts[o + s] * scale;
+
+	const double dtemp = hs[s] * (e1 * k1[o + s] + e3 * k3[o + s] + e4 * k4[o + s] + e5 * k5[o + s] 
+				      + e6 * k6[o + s] + e7 * k7[o + s]) / scale;
+	err[s] += dtemp * dtemp;
+      }
+    }
+
+    // accept or reject the steps, and retire the members which are done;
+    // the slots are walked backward so that the swaps do not skip any member
+    for(int s = active - 1; s >= 0; --s) {
+      if(fail[s]) {
+	retire(s, RungeKutta::DERIV_FAIL);
+	continue;
+      }
+
+      const double er = std::sqrt(err[s] / (double)n);
+
+      double fac = er > 0. ? 0.9 * std::pow(er, -0.2) : 5.;
+      if(fac > 5.)
+	fac = 5.;
+      if(fac < 0.2)
+	fac = 0.2;
+
+      if(er <= 1.) {
+	ts[s] = last[s] ? tos[s] : ts[s] + hs[s];
+	for(int i = 0; i < n; ++i) {
+	  ys[i * batch + s] = yn[i * batch + s];
+	  k1[i * batch + s] = k7[i * batch + s];
+	}
+
+	if(!last[s])
+	  ps[s] = hs[s];
+
+	if(last[s]) {
+	  retire(s, RungeKutta::OK);
+	  continue;
+	}
+
+	hs[s] *= fac;
+      }
+      else
+	hs[s] *= fac < 1. ? fac : 1.;
+
+      if(++count[s] >= RungeKutta::step_max || std::fabs(hs[s]) <= 1.e-13 * (std::fabs(ts[s]) + std::fabs(tos[s] - ts[s]))) {
+	retire(s, RungeKutta::STEP_FAIL);
+      }
+    }
+  }
+
+}
+
+/************************************************************************************
+ ************************************ PROPAGATOR ************************************
+ ************************************************************************************/
+
+// derivatives calculator for the Runge-Kutta integrator
+bool Trajectory::Propagator::_rk_dvd (double, const double* dv, double* dvd, void* par) 
+{
+  const Potential::Wrap& pot = *static_cast<const Potential::Wrap*>(par);
+
+  D3::Vector torque [3]; 
+  Dynamic::Coordinates dc(dv);
+
+  try {
+    pot(dc, torque);
+  }
+  catch (Error::General) {
+    return false;
+  }
+
+  Dynamic::set_dvd(torque, dv, dvd);
+
+  return true;
+}
+
+// the members are grouped by the potential, and every group goes to the potential batch
+// method; if the batch fails, its members are calculated one by one to find the failed ones
+void Trajectory::Propagator::_rk_batch_dvd (int active, int capacity, const double*, const double* y, double* dydt,
+					    void** par, char* fail) 
+{
+  if(active <= 0)
+    return;
+
+  const int n = Structure::dv_size();
+
+  std::vector<int> group;
+  std::vector<char> done(active, 0);
+
+  std::vector<double>               dv(n);
+  std::vector<Dynamic::Coordinates> dc;
+  std::vector<D3::Vector>           torque;
+  std::vector<double>               ener;
+
+  for(int s = 0; s < active; ++s) {
+    if(fail[s] || done[s])
+      continue;
+
+    const Potential::Wrap& pot = *static_cast<const Potential::Wrap*>(par[s]);
+
+    group.clear();
+    for(int t = s; t < active; ++t)
+      if(!fail[t] && !done[t] && (t == s || *static_cast<const Potential::Wrap*>(par[t]) == pot)) {
+	group.push_back(t);
+	done[t] = 1;
+      }
+
+    const int size = group.size();
+
+    dc.resize(size);
+    torque.resize(3 * size);
+    ener.resize(size);
+
+    for(int g = 0; g < size; ++g) {
+      for(int i = 0; i < n; ++i)
+	dv[i] = y[i * capacity + group[g]];
+      dc[g] = Dynamic::Coordinates(&dv[0]);
+    }
+
+    std::vector<char> gfail(size, 0);
+    try {
+      pot.batch(size, &dc[0], &ener[0], &torque[0]);
+    }
+    catch(Error::General) {
+      for(int g = 0; g < size; ++g)
+	try {
+	  pot(dc[g], &torque[3 * g]);
+	}
+	catch(Error::General) {
+	  gfail[g] = 1;
+	}
+    }
+
+    std::vector<double> dvd(n);
+    for(int g = 0; g < size; ++g) {
+      if(gfail[g]) {
+	fail[group[g]] = 1;
+	continue;
+      }
+
+      for(int i = 0; i < n; ++i)
+	dv[i] = y[i * capacity + group[g]];
+
+      Dynamic::set_dvd(&torque[3 * g], &dv[0], &dvd[0]);
+
+      for(int i = 0; i < n; ++i)
+	dydt[i * capacity + group[g]] = dvd[i];
+    }
+  }
+}
+
+bool Trajectory::Propagator::_adams_step (::Array<double>& dv, double timeout, Mode mode) 
+{
   // Long jump facility to transfer failure information 
   // between the dvd calculator and calling function
   DvdPar dvd_par;
   dvd_par.pot = _pot;
 
-  if(setjmp(dvd_par.jmp)) {
-    //std::cerr << funame << "potential calculation failed\n"; 
-    throw PotentialFailure();
+  if(setjmp(dvd_par.jmp))
+    return false;
+
+  try {
+    AdamSolver::run(_time, dv, timeout, static_cast<void*>(&dvd_par), mode);
+  }
+  catch(Error::General) {
+    throw RunFailure();
+  }
+
+  return true;
+}
+
+bool Trajectory::Propagator::_rk_step (::Array<double>& dv, double timeout, Mode mode) 
+{
+  if(!_rk)
+    _rk.init(new RungeKutta(size(), _rk_dvd));
+
+  switch(_rk->run(_time, dv, timeout, rel_tol, abs_tol, static_cast<void*>(&_pot), mode == RESTART)) {
+  case RungeKutta::OK:
+    return true;
+  case RungeKutta::DERIV_FAIL:
+    return false;
+  default:
+    throw RunFailure();
+  }
+}
+
+namespace {
+  //
+  // splitting integrator parts on the flat dynamic variables; the orbital force
+  // and the fragment torques are in their set_dvd frames
+  //
+  void split_kick (double* dv, const D3::Vector* torque, double h)
+  {
+    double* vel = dv + Structure::pos_size();
+
+    for(int i = 0; i < 3; ++i)
+      vel[Structure::orb_vel() + i] += h * torque[0][i] / Structure::mass();
+
+    for(int frag = 0; frag < 2; ++frag) {
+      const Molecule& mol = Structure::fragment(frag);
+
+      if(mol.type() == Molecule::MONOATOMIC)
+	continue;
+
+      double*       ang_vel = vel + Structure::ang_vel(frag);
+      const double* ang_pos = dv  + Structure::ang_pos(frag);
+
+      switch(mol.type()) {
+      case Molecule::LINEAR:
+	for(int i = 0; i < 3; ++i)
+	  ang_vel[i] += h * torque[frag + 1][i] / mol.imom(2);
+
+	orthogonalize(ang_vel, ang_pos, 3);
+	break;
+
+      case Molecule::NONLINEAR:
+	for(int i = 0; i < 3; ++i)
+	  ang_vel[i] += h * torque[frag + 1][i] / mol.imom(i);
+	break;
+      }
+    }
   }
 
+  // free rotation of the nonlinear fragment about the principal axis i
+  void axis_rotation (const Molecule& mol, int i, double* q, double* w, double h)
+  {
+    const int j = (i + 1) % 3;
+    const int k = (i + 2) % 3;
+
+    const double phi = w[i] * h;
+    const double c = std::cos(phi / 2.);
+    const double s = std::sin(phi / 2.);
+
+    // q -> q * (cos(phi/2), sin(phi/2) e_i)
+    const double q0 = q[0], qi = q[i + 1], qj = q[j + 1], qk = q[k + 1];
+
+    q[0]     = c * q0 - s * qi;
+    q[i + 1] = c * qi + s * q0;
+    q[j + 1] = c * qj + s * qk;
+    q[k + 1] = c * qk - s * qj;
+
+    // molecular frame angular momentum
+    const double lj = mol.imom(j) * w[j];
+    const double lk = mol.imom(k) * w[k];
+    const double cf = std::cos(phi);
+    const double sf = std::sin(phi);
+
+    w[j] = ( lj * cf + lk * sf) / mol.imom(j);
+    w[k] = (-lj * sf + lk * cf) / mol.imom(k);
+  }
+
+  void split_drift (double* dv, double h)
+  {
+    const double* vel = dv + Structure::pos_size();
+
+    for(int i = 0; i < 3; ++i)
+      dv[Structure::orb_pos() + i] += h * vel[Structure::orb_vel() + i];
+
+    for(int frag = 0; frag < 2; ++frag) {
+      const Molecule& mol = Structure::fragment(frag);
+
+      if(mol.type() == Molecule::MONOATOMIC)
+	continue;
+
+      double* ang_vel = dv + Structure::pos_size() + Structure::ang_vel(frag);
+      double* ang_pos = dv + Structure::ang_pos(frag);
+
+      double w, c, s;
+      D3::Vector vtemp;
+
+      switch(mol.type()) {
+      case Molecule::LINEAR:
+	// the angular vector rotates about the angular velocity
+	w = vlength(ang_vel, 3);
+	if(w == 0.)
+	  break;
+
+	c = std::cos(w * h);
+	s = std::sin(w * h) / w;
+
+	D3::vprod(ang_vel, ang_pos, vtemp);
+	for(int i = 0; i < 3; ++i)
+	  ang_pos[i] = c * ang_pos[i] + s * vtemp[i];
+	break;
+
+      case Molecule::NONLINEAR:
+	if(mol.top() == Molecule::SPHERICAL) {
+	  w = vlength(ang_vel, 3);
+	  if(w == 0.)
+	    break;
+
+	  c = std::cos(w * h / 2.);
+	  s = std::sin(w * h / 2.) / w;
+
+	  // q -> q * (cos(wh/2), sin(wh/2) w / |w|)
+	  D3::vprod(ang_pos + 1, ang_vel, vtemp);
+	  const double q0 = ang_pos[0];
+	  ang_pos[0] = c * q0 - s * vdot(ang_pos + 1, ang_vel, 3);
+	  for(int i = 0; i < 3; ++i)
+	    ang_pos[i + 1] = c * ang_pos[i + 1] + s * (q0 * ang_vel[i] + vtemp[i]);
+	  break;
+	}
+
+	// symmetric sequence of the principal axes rotations
+	axis_rotation(mol, 0, ang_pos, ang_vel, h / 2.);
+	axis_rotation(mol, 1, ang_pos, ang_vel, h / 2.);
+	axis_rotation(mol, 2, ang_pos, ang_vel, h);
+	axis_rotation(mol, 1, ang_pos, ang_vel, h / 2.);
+	axis_rotation(mol, 0, ang_pos, ang_vel, h / 2.);
+	break;
+      }
+    }
+  }
+}
+
+bool Trajectory::Propagator::_split_step (::Array<double>& dv, double timeout, Mode mode) 
+{
+  const double span = timeout - _time;
+
+  if(span == 0.)
+    return true;
+
+  // the forces of the previous step end are reused unless the variables were adjusted
+  if(mode == RESTART) {
+    Dynamic::Coordinates dc(dv);
+
+    try {
+      _pot(dc, _torque);
+    }
+    catch(Error::General) {
+      return false;
+    }
+  }
+
+  const int    n = (int)std::ceil(std::fabs(span) / split_step);
+  const double h = span / (double)n;
+
+  for(int s = 0; s < n; ++s) {
+    split_kick(dv, _torque, h / 2.);
+    split_drift(dv, h);
+
+    Dynamic::Coordinates dc(dv);
+
+    try {
+      _pot(dc, _torque);
+    }
+    catch(Error::General) {
+      return false;
+    }
+
+    split_kick(dv, _torque, h / 2.);
+  }
+
+  _time = timeout;
+
+  return true;
+}
+
+void Trajectory::Propagator::run (Dynamic::CCP stop, const Dynamic::Classifier& sort) 
+{
+  const char funame [] = "Trajectory::Propagator::run: ";
+
   // dynamic variables
   Array<double> dv(size());
 
@@ -74,6 +779,7 @@ void Trajectory::Propagator::run (Dynamic::CCP stop, const Dynamic::Classifier&
   Mode mode = RESTART;
 
   double timeout;
+  bool btemp;
   int adjust_count = 0;
   while(1) {// main cycle
 
@@ -89,79 +795,251 @@ void Trajectory::Propagator::run (Dynamic::CCP stop, const Dynamic::Classifier&
       throw Error::Logic();
     }
 
-    try {
-      AdamSolver::run(_time, dv, timeout, static_cast<void*>(&dvd_par), mode);
+    switch(solver) {
+    case RUNGE_KUTTA:
+      btemp = _rk_step(dv, timeout, mode);
+      break;
+    case SPLITTING:
+      btemp = _split_step(dv, timeout, mode);
+      break;
+    default:
+      btemp = _adams_step(dv, timeout, mode);
     }
-    catch(Error::General) {
-      throw RunFailure();
+
+    if(!btemp) {
+      //std::cerr << funame << "potential calculation failed\n"; 
+      throw PotentialFailure();
     }
 
-    // get dynamical variables data and normalize
-    get(dv);
+    switch(_step_end(dv, stop, sort, adjust_count, mode)) {
+    case STOP_RUN:
+      return;
+    case EXCLUDE_RUN:
+      throw ExcludeRegionHit();
+    }
+  }
+}
 
-    // checking orthogonality of angular velocity to the molecular axis 
-    // for linear fragments  and normalization of the angular vectors
-    // for all nonatomic fragments
+void Trajectory::Propagator::save (std::ostream& to) const
+{
+  ::Array<double> dv(Dynamic::Vars::size());
+  put(dv);
 
-    bool need_adjustment = false;
-    for(int frag = 0; frag < 2; ++frag) {// fragment cycle
-      if(Structure::fragment(frag).type() == Molecule::MONOATOMIC)
-	continue;
+  to.write((const char*)(const double*)dv, sizeof(double) * dv.size());
+  to.write((const char*)&_time, sizeof(_time));
+  to.write((const char*)&_ener, sizeof(_ener));
+  to.write((const char*)&_spec, sizeof(_spec));
+}
 
-      if(length(frag) > 2. || length(frag) < 0.5) {
-	std::cerr << funame << "WARNING: length of " << frag << "-th fragment is not normalized\n";
-	need_adjustment = true;
-      }
+void Trajectory::Propagator::load (std::istream& from) 
+{
+  const char funame [] = "Trajectory::Propagator::load: ";
 
-      if(Structure::fragment(frag).type() == Molecule::LINEAR) {
-	// velocity projection
-	dtemp = vdot(ang_pos(frag), ang_vel(frag), 3);
-	dtemp = dtemp > 0. ? dtemp : -dtemp;
-
-	// checking if velocity projection on the molecular axis does exceed the calculation error
-	itemp = Structure::pos_size() + Structure::ang_vel(frag);
-	double avl = vlength(ang_vel(frag), 3);
-	if(dtemp > abs_tol[itemp] + rel_tol[itemp] * avl) {
-	  std::cerr << funame << "WARNING: angular velocity of the " << frag 
-		    << "-th fragment is not orthogonal, angle = "
-		    << dtemp / avl / length(frag) << " rad, adjusting " << ++adjust_count << " time\n";
-
-	  orthogonalize(ang_vel(frag), ang_pos(frag), 3);
-	  need_adjustment = true;
-	}
-      }
-      // ...
-    }// fragment cycle
+  ::Array<double> dv(Dynamic::Vars::size());
+
+  from.read((char*)(double*)dv, sizeof(double) * dv.size());
+  from.read((char*)&_time, sizeof(_time));
+  from.read((char*)&_ener, sizeof(_ener));
+  from.read((char*)&_spec, sizeof(_spec));
+
+  if(!from) {
+    std::cerr << funame << "input stream is corrupted\n";
+    throw Error::Input();
+  }
+
+  get(dv);
+}
 
-    if(need_adjustment) { 
-      put(dv);
-      mode = RESTART;
+int Trajectory::Propagator::_step_end (::Array<double>& dv, Dynamic::CCP stop, const Dynamic::Classifier& sort, 
+				       int& adjust_count, Mode& mode) 
+{
+  const char funame [] = "Trajectory::Propagator::_step_end: ";
+
+  double dtemp;
+  int itemp;
+
+  // get dynamical variables data and normalize
+  get(dv);
+
+  // checking orthogonality of angular velocity to the molecular axis 
+  // for linear fragments  and normalization of the angular vectors
+  // for all nonatomic fragments
+
+  bool need_adjustment = false;
+  for(int frag = 0; frag < 2; ++frag) {// fragment cycle
+    if(Structure::fragment(frag).type() == Molecule::MONOATOMIC)
+      continue;
+
+    if(length(frag) > 2. || length(frag) < 0.5) {
+      std::cerr << funame << "WARNING: length of " << frag << "-th fragment is not normalized\n";
+      need_adjustment = true;
     }
-    else
-      mode = CONTINUE;
 
-    /*	
-    // do some output with the flags
+    if(Structure::fragment(frag).type() == Molecule::LINEAR) {
+      // velocity projection
+      dtemp = vdot(ang_pos(frag), ang_vel(frag), 3);
+      dtemp = dtemp > 0. ? dtemp : -dtemp;
+
+      // checking if velocity projection on the molecular axis does exceed the calculation error
+      itemp = Structure::pos_size() + Structure::ang_vel(frag);
+      double avl = vlength(ang_vel(frag), 3);
+      if(dtemp > abs_tol[itemp] + rel_tol[itemp] * avl) {
+	std::cerr << funame << "WARNING: angular velocity of the " << frag 
+		  << "-th fragment is not orthogonal, angle = "
+		  << dtemp / avl / length(frag) << " rad, adjusting " << ++adjust_count << " time\n";
+
+	orthogonalize(ang_vel(frag), ang_pos(frag), 3);
+	need_adjustment = true;
+      }
+    }
     // ...
+  }// fragment cycle
+
+  if(need_adjustment) { 
+    put(dv);
+    mode = RESTART;
+  }
+  else
+    mode = CONTINUE;
+
+  /*	
+  // do some output with the flags
+  // ...
 	
-    // run watch tests
-    for(int i = 0; i < watch.size(); ++i)
-    watch[i].test(*this);
-
-    // execute registered actions
-    for(int i = 0; i < act.size(); ++i)
-    act[i]->execute(*this);
-    */
-
-    // stop condition
-    if(stop->test(*this)) {
-      _spec = sort.classify(*this);
-      _ener = total_kinetic_energy() + _pot(*this);
-      return;
+  // run watch tests
+  for(int i = 0; i < watch.size(); ++i)
+  watch[i].test(*this);
+
+  // execute registered actions
+  for(int i = 0; i < act.size(); ++i)
+  act[i]->execute(*this);
+  */
+
+  // stop condition
+  if(stop->test(*this)) {
+    _spec = sort.classify(*this);
+    _ener = total_kinetic_energy() + _pot(*this);
+    return STOP_RUN;
+  }
+
+  // exclude region
+  if(Dynamic::exclude_region && Dynamic::exclude_region->test(*this))
+    return EXCLUDE_RUN;
+
+  return CONTINUE_RUN;
+}
+
+void Trajectory::Propagator::run (const std::vector<Propagator*>& prop, const std::vector<Dynamic::CCP>& stop, 
+				  const Dynamic::Classifier& sort, std::vector<int>& outcome) 
+{
+  const char funame [] = "Trajectory::Propagator::run: ";
+
+  if(solver != RUNGE_KUTTA) {
+    std::cerr << funame << "batch propagation needs the Runge-Kutta integrator\n";
+    throw Error::Logic();
+  }
+
+  if(stop.size() != prop.size()) {
+    std::cerr << funame << "inconsistent stop conditions array size\n";
+    throw Error::Range();
+  }
+
+  outcome.resize(prop.size());
+
+  if(!prop.size())
+    return;
+
+  const int n = prop[0]->size();
+
+  for(int b = 0; b < prop.size(); ++b)
+    if(prop[b]->size() != n || prop[b]->_dir != FORWARD && prop[b]->_dir != BACKWARD) {
+      std::cerr << funame << "wrong dimension or direction of " << b << "-th trajectory\n";
+      throw Error::Logic();
     }
 
-    // exclude region
-    if(Dynamic::exclude_region && Dynamic::exclude_region->test(*this))
-      throw ExcludeRegionHit();
+  BatchRungeKutta brk(n, _rk_dvd, _rk_batch_dvd);
+
+  // member dynamic variables
+  std::vector< ::Array<double> > dv(prop.size(), ::Array<double>(n));
+  std::vector<Mode>           mode(prop.size(), RESTART);
+  std::vector<int>            adjust_count(prop.size(), 0);
+  std::vector<double>         last_step(prop.size(), 0.);
+
+  // active members
+  std::vector<int> active;
+  for(int b = 0; b < prop.size(); ++b) {
+    prop[b]->put(dv[b]);
+    active.push_back(b);
+  }
+
+  std::vector<double> time, y, tout, rel_tol, abs_tol, step_size;
+  std::vector<void*>  par;
+  std::vector<int>    status;
+
+  while(active.size()) {// main cycle
+    const int batch = active.size();
+
+    time.resize(batch);
+    tout.resize(batch);
+    step_size.resize(batch);
+    par.resize(batch);
+    status.resize(batch);
+    y.resize(n * batch);
+    rel_tol.resize(n * batch);
+    abs_tol.resize(n * batch);
+
+    for(int s = 0; s < batch; ++s) {
+      Propagator& p = *prop[active[s]];
+
+      time[s]      = p._time;
+      tout[s]      = p._dir == FORWARD ? p._time + step : p._time - step;
+      step_size[s] = mode[active[s]] == RESTART ? 0. : last_step[active[s]];
+      par[s]       = static_cast<void*>(&p._pot);
+
+      for(int i = 0; i < n; ++i) {
+	y[i * batch + s]       = dv[active[s]][i];
+	rel_tol[i * batch + s] = p.rel_tol[i];
+	abs_tol[i * batch + s] = p.abs_tol[i];
+      }
+    }
+
+    brk.run(batch, &time[0], &y[0], &tout[0], &rel_tol[0], &abs_tol[0], &par[0], &step_size[0], &status[0]);
+
+    std::vector<int> next;
+    for(int s = 0; s < batch; ++s) {
+      const int b = active[s];
+      Propagator& p = *prop[b];
+
+      switch(status[s]) {
+      case RungeKutta::DERIV_FAIL:
+	outcome[b] = POT_FAIL;
+	continue;
+      case RungeKutta::STEP_FAIL:
+	outcome[b] = RUN_FAIL;
+	continue;
+      }
+
+      p._time      = time[s];
+      last_step[b] = step_size[s];
+      for(int i = 0; i < n; ++i)
+	dv[b][i] = y[i * batch + s];
+
+      try {
+	switch(p._step_end(dv[b], stop[b], sort, adjust_count[b], mode[b])) {
+	case STOP_RUN:
+	  outcome[b] = DONE;
+	  break;
+	case EXCLUDE_RUN:
+	  outcome[b] = EXCLUDE;
+	  break;
+	default:
+	  next.push_back(b);
+	}
+      }
+      catch(Error::General) {
+	outcome[b] = POT_FAIL;
+      }
+    }
+    active.swap(next);
   }
 }
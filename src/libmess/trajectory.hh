@@ -21,6 +21,7 @@
 #include "potential.hh"
 
 #include <setjmp.h>
+#include <vector>
 
 enum {BACKWARD = 0, FORWARD = 1};
 
@@ -42,6 +43,79 @@ struct DvdPar {
 };
 
 
+  /***********************************************************************************
+   * Dormand-Prince 5(4) adaptive Runge-Kutta integrator on a flat state vector: the *
+   * derivatives calculator reports failures by the return value, so that the       *
+   * integration can be abandoned without the long jumps                            *
+   ***********************************************************************************/
+
+  class RungeKutta
+  {
+  public:
+    // returns false if the derivatives cannot be calculated
+    typedef bool (*deriv_t) (double time, const double* y, double* dydt, void* par);
+
+    enum Status {OK, DERIV_FAIL, STEP_FAIL};
+
+  private:
+    deriv_t _deriv;
+    int     _size;
+    double  _step; // last accepted step
+
+    Array<double> _work; // stage derivatives and temporary states
+
+  public:
+    static int step_max; // maximal number of steps in one run
+
+    RungeKutta (int, deriv_t) ;
+
+    int size () const { return _size; }
+
+    // advances the state from time to tout: the error of every component is kept below
+    // rel_tol[i] * |y[i]| + abs_tol[i]; restart discards the last step size
+    Status run (double& time, double* y, double tout, const double* rel_tol, const double* abs_tol,
+		void* par, bool restart) ;
+  };
+
+  /***********************************************************************************
+   * the same integrator for a batch of trajectories advanced in lockstep: the states *
+   * are kept as structure of arrays, component by component, so that the Runge-Kutta*
+   * stages run over the batch with a unit stride; every member has its own step size *
+   * and time, and the members which are done are retired from the batch              *
+   ***********************************************************************************/
+
+  class BatchRungeKutta
+  {
+  public:
+    typedef RungeKutta::deriv_t deriv_t;
+
+    // derivatives of the first active slots at once: the state and the derivatives are in the
+    // slot order with the capacity stride; the slots flagged in fail are skipped, and the
+    // slots whose derivatives cannot be calculated are flagged
+    typedef void (*batch_deriv_t) (int active, int capacity, const double* time, const double* y, double* dydt,
+				   void** par, char* fail);
+
+  private:
+    deriv_t        _deriv;
+    batch_deriv_t  _batch_deriv;
+    int            _size;
+
+    // retires the member in the slot by moving the last active member into it
+    static void _retire (int slot, int active, int size, int capacity, double** soa, int soa_size);
+
+  public:
+    // the members' derivatives are calculated one by one, unless the batch calculator is given
+    BatchRungeKutta (int, deriv_t, batch_deriv_t =0) ;
+
+    int size () const { return _size; }
+
+    // member b of the state component i is y[i * batch + b], and the same for the tolerances;
+    // step[b] is the initial step size of the member (restart if zero) and the last accepted
+    // step size on exit; status[b] is the member's RungeKutta::Status
+    void run (int batch, double* time, double* y, const double* tout, const double* rel_tol, const double* abs_tol,
+	      void** par, double* step, int* status) const ;
+  };
+
   // Output Flags and streams
   struct Flags {
     std::pair<int, SharedPointer<std::ostream> > aux_out;
@@ -57,11 +131,40 @@ struct DvdPar {
     
     Potential::Wrap _pot;
 
+    SharedPointer<RungeKutta> _rk;
+
+    static bool _rk_dvd (double, const double*, double*, void*);
+
+    // the potential energies and forces of the batch members sharing the potential at once
+    static void _rk_batch_dvd (int, int, const double*, const double*, double*, void**, char*);
+
+    // forces and torques at the end of the last splitting integrator step
+    D3::Vector _torque [3];
+
+    // advance the dynamical variables to timeout; false on the potential failure
+    bool _adams_step (::Array<double>&, double timeout, Mode) ;
+    bool    _rk_step (::Array<double>&, double timeout, Mode) ;
+    bool _split_step (::Array<double>&, double timeout, Mode) ;
+
+    // normalization checks, stop and exclude region tests at the end of the time step
+    enum {CONTINUE_RUN, STOP_RUN, EXCLUDE_RUN};
+    int _step_end (::Array<double>&, Dynamic::CCP stop, const Dynamic::Classifier& sort, int& adjust_count, Mode&) ;
+
   public:
 
     static double step;
     //static Flags flags;
 
+    // integrator: the SLATEC Adams-Bashforth-Moulton solver, the Runge-Kutta integrator, or
+    // the symplectic splitting integrator: the kick-drift-kick steps of the fixed size, the
+    // free rotation of the nonlinear fragments split into the rotations about the principal
+    // axes (exact for the linear fragments and the spherical tops); one potential evaluation
+    // per step and the bounded energy error instead of the error control
+    enum {ADAMS, RUNGE_KUTTA, SPLITTING};
+    static int solver;
+
+    static double split_step; // largest splitting integrator step
+
     Propagator(Potential::Wrap pot, const Dynamic::Vars& dv, const Slatec::AdamSolver& as, int dir) 
       : _pot(pot), Dynamic::Vars(dv), Slatec::AdamSolver(as), _time(0.0), _dir(dir) {}
 
@@ -75,6 +178,16 @@ struct DvdPar {
 
     void run (Dynamic::CCP stop, const Dynamic::Classifier& sort) ;
 
+    // batch of trajectories propagated in lockstep by the Runge-Kutta integrator;
+    // the outcomes are returned instead of being thrown
+    enum Outcome {DONE, POT_FAIL, RUN_FAIL, EXCLUDE};
+    static void run (const std::vector<Propagator*>&, const std::vector<Dynamic::CCP>& stop, 
+		     const Dynamic::Classifier& sort, std::vector<int>& outcome) ;
+
+    // binary state: dynamical variables, time, total energy, and species
+    void save (std::ostream&) const;
+    void load (std::istream&) ;
+
     double time         () const { return _time; }
     int    direction    () const { return _dir; }
 
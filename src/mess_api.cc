@@ -0,0 +1,179 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2019, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#include <iostream>
+#include <limits>
+#include <exception>
+
+#include "mess_api.hh"
+#include "libmess/units.hh"
+#include "libmess/error.hh"
+
+namespace Api {
+
+  // the results of the run
+  bool                     isrun = false;
+  std::string              error;
+
+  std::vector<double>      temperature;
+  std::vector<double>      pressure;
+  std::vector<std::string> species_name;
+  int                      well_size = 0;
+
+  std::vector<double>      rate;
+  std::vector<double>      hp_rate;
+
+  // the eigenvectors storage is shared with the driver copies
+  std::vector<MasterEquation::Spectrum> spectrum;
+
+  void fill (const std::map<std::pair<int, int>, double>& rate_map, double* to)
+  {
+    const int ssize = species_name.size();
+
+    for(int i = 0; i < ssize * ssize; ++i)
+      to[i] = std::numeric_limits<double>::quiet_NaN();
+
+    for(std::map<std::pair<int, int>, double>::const_iterator it = rate_map.begin(); it != rate_map.end(); ++it)
+      if(it->first.first < ssize && it->first.second < ssize)
+	to[it->first.first * ssize + it->first.second] = it->second;
+  }
+
+  bool ispoint (int point) { return point >= 0 && point < spectrum.size(); }
+}
+
+void Api::keep (const std::vector<double>&                                 t,
+		const std::vector<double>&                                 p,
+		const std::vector<std::string>&                            name,
+		const std::vector<std::map<std::pair<int, int>, double> >& hp_rate_coef,
+		const std::vector<std::map<std::pair<int, int>, double> >& rate_coef,
+		const std::vector<MasterEquation::Spectrum>&               spec)
+{
+  temperature.resize(t.size());
+  for(int i = 0; i < t.size(); ++i)
+    temperature[i] = t[i] / Phys_const::kelv;
+
+  pressure.resize(p.size());
+  for(int i = 0; i < p.size(); ++i)
+    switch(MasterEquation::pressure_unit) {
+    case MasterEquation::BAR:
+      pressure[i] = p[i] / Phys_const::bar;
+      break;
+    case MasterEquation::TORR:
+      pressure[i] = p[i] / Phys_const::tor;
+      break;
+    case MasterEquation::ATM:
+      pressure[i] = p[i] / Phys_const::atm;
+      break;
+    }
+
+  species_name = name;
+  well_size    = Model::well_size();
+
+  const int msize = name.size() * name.size();
+
+  hp_rate.resize(hp_rate_coef.size() * msize);
+  for(int i = 0; i < hp_rate_coef.size(); ++i)
+    fill(hp_rate_coef[i], &hp_rate[i * msize]);
+
+  rate.resize(rate_coef.size() * msize);
+  for(int i = 0; i < rate_coef.size(); ++i)
+    fill(rate_coef[i], &rate[i * msize]);
+
+  spectrum = spec;
+}
+
+int mess_run (const char* input_file)
+{
+  const char funame [] = "mess_run: ";
+
+  if(Api::isrun) {
+    Api::error = std::string(funame) + "the model is already initialized: one run per process";
+    return 1;
+  }
+
+  Api::isrun = true;
+
+  MasterEquation::keep_spectrum = true;
+
+  std::string name = input_file;
+
+  char prog [] = "mess";
+  char* argv [] = {prog, &name[0], 0};
+
+  try {
+    if(Api::driver(2, argv))
+      throw Error::General();
+
+    // no rate calculation (e.g., server mode)
+    if(!Api::temperature.size())
+      throw Error::Init();
+  }
+  catch(Error::General) {
+    Api::error = std::string(funame) + "driver failed, see the error output and the log file";
+    return 1;
+  }
+  catch(std::exception& e) {
+    Api::error = std::string(funame) + e.what();
+    return 1;
+  }
+
+  return 0;
+}
+
+const char* mess_error () { return Api::error.c_str(); }
+
+int           mess_temperature_size () { return Api::temperature.size(); }
+const double* mess_temperature      () { return Api::temperature.size() ? &Api::temperature[0] : 0; }
+int           mess_pressure_size    () { return Api::pressure.size(); }
+const double* mess_pressure         () { return Api::pressure.size() ? &Api::pressure[0] : 0; }
+
+int mess_species_size () { return Api::species_name.size(); }
+int mess_well_size    () { return Api::well_size; }
+
+const char* mess_species_name (int i)
+{
+  if(i < 0 || i >= Api::species_name.size())
+    return 0;
+
+  return Api::species_name[i].c_str();
+}
+
+const double* mess_rate    () { return Api::rate.size()    ? &Api::rate[0]    : 0; }
+const double* mess_hp_rate () { return Api::hp_rate.size() ? &Api::hp_rate[0] : 0; }
+
+int mess_eigenvalue_size (int point)
+{
+  return Api::ispoint(point) ? Api::spectrum[point].eigenvalue.size() : 0;
+}
+
+const double* mess_eigenvalue (int point)
+{
+  return mess_eigenvalue_size(point) ? &Api::spectrum[point].eigenvalue[0] : 0;
+}
+
+int mess_global_size (int point)
+{
+  return mess_eigenvalue_size(point) ? Api::spectrum[point].eigenvector.size1() : 0;
+}
+
+const double* mess_eigenvector (int point)
+{
+  return mess_eigenvalue_size(point) ? (const double*)Api::spectrum[point].eigenvector : 0;
+}
+
+const int* mess_well_shift (int point)
+{
+  return mess_eigenvalue_size(point) ? &Api::spectrum[point].well_shift[0] : 0;
+}
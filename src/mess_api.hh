@@ -0,0 +1,83 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2019, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#ifndef MESS_API_HH
+#define MESS_API_HH
+
+#include <map>
+#include <vector>
+#include <string>
+
+#include "libmess/mess.hh"
+
+// in-process interface to the master equation driver (the messapi shared library): the driver
+// runs on the input file as the mess executable does, writes the same output, and keeps the results
+// in flat arrays which are owned by the library and handed out by pointers, so that the caller
+// (python/mess_api.py) maps them without copying
+namespace Api {
+
+  // the mess driver, the library built
+  int driver (int argc, char* argv []);
+
+  // called by the driver once the rate coefficients are calculated
+  void keep (const std::vector<double>&                                     temperature,
+	     const std::vector<double>&                                     pressure,
+	     const std::vector<std::string>&                                species_name,
+	     const std::vector<std::map<std::pair<int, int>, double> >&     hp_rate_coef,
+	     const std::vector<std::map<std::pair<int, int>, double> >&     rate_coef,
+	     const std::vector<MasterEquation::Spectrum>&                   spectrum);
+}
+
+extern "C" {
+
+  // runs the driver on the input file; returns 0 on success; the model is global, hence
+  // one run per process
+  int mess_run (const char* input_file);
+
+  // the error of the failed run
+  const char* mess_error ();
+
+  // temperatures[K]; pressures in the units of the input
+  int           mess_temperature_size ();
+  const double* mess_temperature      ();
+  int           mess_pressure_size    ();
+  const double* mess_pressure         ();
+
+  // wells first, then the bimolecular species
+  int         mess_species_size ();
+  int         mess_well_size    ();
+  const char* mess_species_name (int);
+
+  // rate coefficients: unimolecular in 1/sec, bimolecular in cm^3/sec, NaN if not available;
+  // temperature, pressure, reactant, product indices, the last one running fastest
+  const double* mess_rate    ();
+
+  // high pressure rate coefficients: temperature, reactant, product indices
+  const double* mess_hp_rate ();
+
+  // direct diagonalization spectrum of the point (pressure index running fastest); none
+  // (zero size) for the other methods and for the points evaluated by the worker processes
+  int           mess_eigenvalue_size (int point);
+  const double* mess_eigenvalue      (int point); // 1/sec
+
+  // eigenvectors in the global states basis: eigenvalue, global state indices
+  int           mess_global_size     (int point);
+  const double* mess_eigenvector     (int point);
+
+  // first global state of each well
+  const int*    mess_well_shift      (int point);
+}
+
+#endif
@@ -0,0 +1,642 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <map>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "libmess/mess.hh"
+#include "libmess/model.hh"
+#include "libmess/units.hh"
+#include "libmess/io.hh"
+#include "libmess/batch.hh"
+#include "libmess/graph_omp.hh"
+
+/********************************************************************************************
+ ******************************* SOLVER HOT PATHS BENCHMARK *********************************
+ ********************************************************************************************/
+
+// synthetic networks: the chain of RRHO wells W1 - W2 - ... - WN, the last well dissociating
+// to the dummy bimolecular product, the energy relaxation in the mixture of bath gases with
+// the exponential down model; every configuration is evaluated in its own forked process,
+// because the model is global, and the marked stages are timed by IO::stage_list;
+// the graph perturbation theory expansion is timed on the synthetic cubic and
+// quartic anharmonic potential; the results go to the standard output as JSON
+
+namespace Bench {
+  //
+  struct Setup {
+    std::vector<int>    well_size;
+    std::vector<double> energy_step; // energy step over temperature
+    std::vector<int>    bath_size;
+    double              temperature; // K
+    double              pressure;    // bar
+    int                 repeat;
+    int                 mode_size;   // graph expansion normal modes, no graph expansion if zero
+    int                 bond_max;    // graph expansion order
+    std::string         base_name;
+  };
+
+  // stage timing aggregated over the repeats
+  struct Timing {
+    int    count;
+    double wall;
+    double wall_min;
+    double cpu;
+
+    Timing () : count(0), wall(0.), wall_min(-1.), cpu(0.) {}
+
+    void add (double w, double c)
+    {
+      ++count;
+      wall += w;
+      cpu  += c;
+      if(wall_min < 0. || w < wall_min)
+	wall_min = w;
+    }
+  };
+
+  std::string model_input (int well_size, int bath_size);
+
+  void collect (std::map<std::string, Timing>&, std::vector<std::string>& order);
+
+  std::string stage_name (std::string);
+
+  void stage_json (std::ostream&, const std::map<std::string, Timing>&, const std::vector<std::string>& order);
+
+  // one configuration in the current process
+  void network (const Setup&, int well_size, double energy_step, int bath_size, std::ostream&);
+
+  void graph (const Setup&, std::ostream&);
+
+  // the configuration in the forked process; returns false if it failed
+  bool fork_run (const Setup&, int well_size, double energy_step, int bath_size, const std::string& name, std::ostream&);
+
+  std::vector<double> number_list (const std::string&);
+}
+
+std::vector<double> Bench::number_list (const std::string& s)
+{
+  const char funame [] = "Bench::number_list: ";
+
+  std::vector<double> res;
+
+  std::string t = s;
+  for(int i = 0; i < t.size(); ++i)
+    if(t[i] == ',')
+      t[i] = ' ';
+
+  std::istringstream from(t);
+  double dtemp;
+  while(from >> dtemp)
+    res.push_back(dtemp);
+
+  if(!from.eof() || !res.size()) {
+    std::cerr << funame << s << ": corrupted\n";
+    throw Error::Input();
+  }
+
+  return res;
+}
+
+std::string Bench::model_input (int well_size, int bath_size)
+{
+  // reference frequencies, 1/cm
+  static const double freq [] = {153.58, 567.19, 646.61, 1052.08, 1056.37, 1276.86,
+				 1427.95, 1623.45, 1797.80, 2975.67, 3608.24, 3752.24};
+
+  static const int freq_size = sizeof(freq) / sizeof(double);
+
+  std::ostringstream to;
+
+  to << std::setprecision(8);
+
+  // bath gases
+  for(int b = 0; b < bath_size; ++b)
+    to << "  EnergyRelaxation\n"
+       << "    Exponential\n"
+       << "      Factor[1/cm]  " << 200. + 50. * b << "\n"
+       << "      Power         0.85\n"
+       << "      ExponentCutoff 15\n"
+       << "    End\n"
+       << "  CollisionFrequency\n"
+       << "    LennardJones\n"
+       << "      Epsilons[1/cm]    200. " << 100. + 50. * b << "\n"
+       << "      Sigmas[angstrom]  4.0  " << 3.5 + 0.2 * b << "\n"
+       << "      Masses[amu]       45   " << 4 + 12 * b << "\n"
+       << "    End\n";
+
+  if(bath_size > 1) {
+    to << "  BufferFraction";
+    for(int b = 0; b < bath_size; ++b)
+      to << "  1";
+    to << "\n";
+  }
+
+  // the same geometry for all species
+  const char geometry [] =
+    "      Geometry[angstrom] 6\n"
+    "        N   -0.938656   -0.561431    0.000000\n"
+    "        C    0.000000    0.418760    0.000000\n"
+    "        O    1.197671    0.232440    0.000000\n"
+    "        H   -1.916868   -0.344663    0.000000\n"
+    "        H   -0.645208   -1.522329    0.000000\n"
+    "        H   -0.448702    1.424929    0.000000\n"
+    "      Core RigidRotor\n"
+    "        SymmetryFactor 1.\n"
+    "      End\n";
+
+  // well energies, kcal/mol
+  std::vector<double> well_ener(well_size);
+  for(int w = 0; w < well_size; ++w)
+    well_ener[w] = -60. + 5. * (w % 4);
+
+  for(int w = 0; w < well_size; ++w) {
+    const double scale = 1. + 0.03 * std::sin(double(w + 1));
+
+    to << "  Well W" << w + 1 << "\n"
+       << "    Species\n"
+       << "      RRHO\n"
+       << geometry
+       << "      Frequencies[1/cm] " << freq_size << "\n       ";
+    for(int f = 0; f < freq_size; ++f)
+      to << " " << freq[f] * scale;
+    to << "\n"
+       << "      ZeroEnergy[kcal/mol] " << well_ener[w] << "\n"
+       << "      ElectronicLevels[1/cm] 1\n"
+       << "        0 1\n"
+       << "    End\n"
+       << "  End\n";
+  }
+
+  to << "  Bimolecular P1\n"
+     << "    Dummy\n";
+
+  // barriers: the lowest frequency is the reaction coordinate
+  for(int b = 0; b < well_size; ++b) {
+    const double scale = 1. + 0.03 * std::cos(double(b + 1));
+
+    double ener;
+    to << "  Barrier B" << b + 1;
+    if(b < well_size - 1) {
+      to << " W" << b + 1 << " W" << b + 2 << "\n";
+      ener = (well_ener[b] > well_ener[b + 1] ? well_ener[b] : well_ener[b + 1]) + 35.;
+    }
+    else {
+      to << " W" << b + 1 << " P1\n";
+      ener = 0.;
+    }
+
+    to << "    RRHO\n"
+       << geometry
+       << "      Frequencies[1/cm] " << freq_size - 1 << "\n       ";
+    for(int f = 1; f < freq_size; ++f)
+      to << " " << freq[f] * scale;
+    to << "\n"
+       << "      ZeroEnergy[kcal/mol] " << ener << "\n"
+       << "      ElectronicLevels[1/cm] 1\n"
+       << "        0 1\n"
+       << "    End\n";
+  }
+
+  to << "End\n";
+
+  return to.str();
+}
+
+// adds IO::stage_list to the timing by the stage name
+//
+void Bench::collect (std::map<std::string, Timing>& timing, std::vector<std::string>& order)
+{
+  std::map<std::string, std::pair<double, double> > sum;
+
+  for(int i = 0; i < IO::stage_list.size(); ++i) {
+    const IO::Stage& s = IO::stage_list[i];
+
+    if(timing.find(s.name) == timing.end() && sum.find(s.name) == sum.end())
+      order.push_back(s.name);
+
+    sum[s.name].first  += s.wall_time;
+    sum[s.name].second += s.cpu_time;
+  }
+
+  for(std::map<std::string, std::pair<double, double> >::const_iterator it = sum.begin(); it != sum.end(); ++it)
+    timing[it->first].add(it->second.first, it->second.second);
+
+  IO::stage_list.clear();
+}
+
+// without the trailing separator of the function name headers
+//
+std::string Bench::stage_name (std::string s)
+{
+  while(s.size() && (s[s.size() - 1] == ' ' || s[s.size() - 1] == ':'))
+    s.erase(s.size() - 1);
+  return s;
+}
+
+void Bench::stage_json (std::ostream& to, const std::map<std::string, Timing>& timing, const std::vector<std::string>& order)
+{
+  to << "[";
+  for(int i = 0; i < order.size(); ++i) {
+    const Timing& t = timing.find(order[i])->second;
+
+    if(i)
+      to << ", ";
+    to << "{\"name\": "     << Batch::json_string(stage_name(order[i]))
+       << ", \"repeat\": "   << t.count
+       << ", \"wall\": "     << Batch::json_number(t.wall / t.count)
+       << ", \"wall_min\": " << Batch::json_number(t.wall_min)
+       << ", \"cpu\": "      << Batch::json_number(t.cpu / t.count)
+       << "}";
+  }
+  to << "]";
+}
+
+void Bench::network (const Setup& setup, int well_size, double energy_step, int bath_size, std::ostream& to)
+{
+  const char funame [] = "Bench::network: ";
+
+  std::string name = setup.base_name + ".model";
+  {
+    std::ofstream model_out(name.c_str());
+    model_out << model_input(well_size, bath_size);
+    if(!model_out) {
+      std::cerr << funame << "cannot write " << name << " file\n";
+      throw Error::Open();
+    }
+  }
+
+  IO::stage_record = true;
+
+  std::map<std::string, Timing> timing;
+  std::vector<std::string>      order;
+
+  // model initialization: the RRHO states counting
+  {
+    IO::KeyBufferStream from(name.c_str());
+    Model::init(from);
+  }
+  std::remove(name.c_str());
+
+  collect(timing, order);
+
+  const double temperature = setup.temperature * Phys_const::kelv;
+
+  MasterEquation::set_temperature(temperature);
+  MasterEquation::set_energy_step(nearbyint(temperature * energy_step / Phys_const::incm) * Phys_const::incm);
+  MasterEquation::set_energy_reference(nearbyint((30. * temperature + Model::maximum_barrier_height())
+						 / Phys_const::incm) * Phys_const::incm);
+
+  std::map<std::pair<int, int>, double> rate_data;
+  std::map<int, double>                 capture_data;
+  MasterEquation::Partition             well_partition;
+
+  // wells, barriers and kernels setup, global matrix assembly, diagonalization, well partitioning
+  double wall = 0.;
+  for(int r = 0; r < setup.repeat; ++r) {
+    std::chrono::steady_clock::time_point start_wall = std::chrono::steady_clock::now();
+
+    MasterEquation::set(rate_data, capture_data);
+
+    MasterEquation::set_pressure(setup.pressure * Phys_const::bar);
+
+    MasterEquation::direct_diagonalization_method(rate_data, well_partition, 0);
+
+    wall += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_wall).count();
+
+    collect(timing, order);
+  }
+
+  // global relaxation matrix dimension
+  int global_size = 0;
+  for(int w = 0; w < MasterEquation::context()._well.size(); ++w)
+    global_size += MasterEquation::context()._well[w]->size();
+
+  to << "{\"well_number\": " << well_size
+     << ", \"energy_step_over_temperature\": " << Batch::json_number(energy_step)
+     << ", \"bath_number\": " << bath_size
+     << ", \"temperature\": " << Batch::json_number(setup.temperature)
+     << ", \"pressure\": " << Batch::json_number(setup.pressure)
+     << ", \"repeat\": " << setup.repeat
+     << ", \"energy_step\": " << Batch::json_number(MasterEquation::energy_step() / Phys_const::incm)
+     << ", \"global_size\": " << global_size
+     << ", \"points_per_second\": " << Batch::json_number(wall > 0. ? setup.repeat / wall : -1.)
+     << ", \"stages\": ";
+
+  stage_json(to, timing, order);
+
+  to << "}";
+}
+
+void Bench::graph (const Setup& setup, std::ostream& to)
+{
+  // reference frequencies, 1/cm
+  static const double freq [] = {567.19, 646.61, 1052.08, 1056.37, 1276.86, 1427.95,
+				 1623.45, 1797.80, 2975.67, 3608.24, 3752.24, 153.58};
+
+  static const int freq_size = sizeof(freq) / sizeof(double);
+
+  std::vector<double> frequency(setup.mode_size);
+  for(int i = 0; i < setup.mode_size; ++i)
+    frequency[i] = freq[i % freq_size] * (1. + 0.01 * (i / freq_size)) * Phys_const::incm;
+
+  // diagonal and nearest neighbour cubic and quartic terms
+  Graph::potex_t potex;
+  std::multiset<int> term;
+  for(int i = 0; i < setup.mode_size; ++i) {
+    term.clear();
+    term.insert(i);
+    term.insert(i);
+    term.insert(i);
+    potex[term] = -0.05 * frequency[i];
+
+    term.insert(i);
+    potex[term] =  0.01 * frequency[i];
+
+    if(i + 1 < setup.mode_size) {
+      term.clear();
+      term.insert(i);
+      term.insert(i);
+      term.insert(i + 1);
+      potex[term] = 0.02 * frequency[i];
+    }
+  }
+
+  Graph::potex_max = 4;
+  Graph::bond_max  = setup.bond_max;
+
+  Graph::init();
+
+  IO::stage_record = true;
+
+  std::map<std::string, Timing> timing;
+  std::vector<std::string>      order;
+
+  double wall = 0.;
+  for(int r = 0; r < setup.repeat; ++r) {
+    std::clock_t                          start_cpu  = std::clock();
+    std::chrono::steady_clock::time_point start_wall = std::chrono::steady_clock::now();
+
+    Graph::Expansion graphex(frequency, potex);
+
+    graphex.correction(setup.temperature * Phys_const::kelv);
+
+    const double w = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_wall).count();
+    wall += w;
+
+    IO::Stage s;
+    s.name      = "graph expansion";
+    s.level     = 0;
+    s.cpu_time  = double(std::clock() - start_cpu) / CLOCKS_PER_SEC;
+    s.wall_time = w;
+    IO::stage_list.push_back(s);
+
+    collect(timing, order);
+  }
+
+  to << "{\"mode_number\": " << setup.mode_size
+     << ", \"bond_max\": " << setup.bond_max
+     << ", \"temperature\": " << Batch::json_number(setup.temperature)
+     << ", \"repeat\": " << setup.repeat
+     << ", \"expansions_per_second\": " << Batch::json_number(wall > 0. ? setup.repeat / wall : -1.)
+     << ", \"stages\": ";
+
+  stage_json(to, timing, order);
+
+  to << "}";
+}
+
+bool Bench::fork_run (const Setup& setup, int well_size, double energy_step, int bath_size,
+		      const std::string& name, std::ostream& to)
+{
+  const char funame [] = "Bench::fork_run: ";
+
+  IO::log.flush();
+  IO::out.flush();
+  std::cout.flush();
+
+  pid_t pid = fork();
+
+  if(pid < 0) {
+    std::cerr << funame << "fork failed\n";
+    throw Error::Run();
+  }
+
+  if(!pid) {
+    int status = 0;
+    try {
+      std::ofstream res(name.c_str());
+      if(well_size)
+	network(setup, well_size, energy_step, bath_size, res);
+      else
+	graph(setup, res);
+      res.close();
+      if(!res)
+	status = 1;
+    }
+    catch(...) {
+      status = 1;
+    }
+    IO::log.flush();
+    IO::out.flush();
+    _exit(status);
+  }
+
+  int status;
+  bool res = waitpid(pid, &status, 0) >= 0 && WIFEXITED(status) && !WEXITSTATUS(status);
+
+  std::ifstream from(name.c_str());
+  if(res && from)
+    to << from.rdbuf();
+  else
+    res = false;
+  from.close();
+  std::remove(name.c_str());
+
+  return res;
+}
+
+int main (int argc, char* argv [])
+{
+  const char funame [] = "mess_bench: ";
+
+  Bench::Setup setup;
+
+  setup.well_size   = std::vector<int>(1, 2);
+  setup.well_size.push_back(4);
+  setup.well_size.push_back(8);
+  setup.energy_step = std::vector<double>(1, 0.2);
+  setup.bath_size   = std::vector<int>(1, 1);
+  setup.temperature = 1000.;
+  setup.pressure    = 1.;
+  setup.repeat      = 3;
+  setup.mode_size   = 6;
+  setup.bond_max    = 4;
+  setup.base_name   = "mess_bench";
+
+  for(int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    std::string::size_type pos = arg.find('=');
+
+    if(arg == "-h" || arg == "--help" || pos == std::string::npos) {
+      std::cout << "usage: mess_bench [key=value ...] > result.json\n"
+		<< "  wells=2,4,8       wells numbers of the synthetic networks\n"
+		<< "  estep=0.2         energy steps over temperature (energy grid size)\n"
+		<< "  baths=1           bath gases numbers\n"
+		<< "  temperature=1000  K\n"
+		<< "  pressure=1        bar\n"
+		<< "  repeat=3          repetitions of each measurement\n"
+		<< "  modes=6           normal modes for the graph expansion, none if zero\n"
+		<< "  bonds=4           graph expansion order\n"
+		<< "  base=mess_bench   name of the log, output, and temporary files\n";
+      return pos == std::string::npos && arg != "-h" && arg != "--help";
+    }
+
+    const std::string key   = arg.substr(0, pos);
+    const std::string value = arg.substr(pos + 1);
+
+    try {
+      std::vector<double> v;
+      if(key != "base")
+	v = Bench::number_list(value);
+
+      if(key == "wells" || key == "baths") {
+	std::vector<int> n;
+	for(int j = 0; j < v.size(); ++j) {
+	  if(v[j] < 1. || v[j] != std::floor(v[j])) {
+	    std::cerr << funame << arg << ": should be positive integers\n";
+	    return 1;
+	  }
+	  n.push_back((int)v[j]);
+	}
+	if(key == "wells")
+	  setup.well_size = n;
+	else
+	  setup.bath_size = n;
+      }
+      else if(key == "estep") {
+	for(int j = 0; j < v.size(); ++j)
+	  if(v[j] <= 0.) {
+	    std::cerr << funame << arg << ": should be positive\n";
+	    return 1;
+	  }
+	setup.energy_step = v;
+      }
+      else if(key == "base") {
+	setup.base_name = value;
+      }
+      else if(v.size() != 1) {
+	std::cerr << funame << arg << ": one value expected\n";
+	return 1;
+      }
+      else if(key == "temperature" || key == "pressure") {
+	if(v[0] <= 0.) {
+	  std::cerr << funame << arg << ": should be positive\n";
+	  return 1;
+	}
+	if(key == "temperature")
+	  setup.temperature = v[0];
+	else
+	  setup.pressure = v[0];
+      }
+      else if(key == "repeat" || key == "modes" || key == "bonds") {
+	if(v[0] < (key == "modes" ? 0. : 1.)) {
+	  std::cerr << funame << arg << ": out of range\n";
+	  return 1;
+	}
+	if(key == "repeat")
+	  setup.repeat = (int)v[0];
+	else if(key == "modes")
+	  setup.mode_size = (int)v[0];
+	else
+	  setup.bond_max = (int)v[0];
+      }
+      else {
+	std::cerr << funame << key << ": unknown key\n";
+	return 1;
+      }
+    }
+    catch(Error::General) {
+      return 1;
+    }
+  }
+
+  IO::log.open((setup.base_name + ".log").c_str());
+  IO::out.open((setup.base_name + ".out").c_str());
+  if(!IO::log || !IO::out) {
+    std::cerr << funame << "cannot open " << setup.base_name << " log and output files\n";
+    return 1;
+  }
+
+  // default energy limit
+  Model::set_energy_limit(400. * Phys_const::kcal);
+
+  MasterEquation::well_cutoff        = 10.;
+  MasterEquation::chemical_threshold = 0.2;
+
+  int threads = 1;
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+#endif
+
+  const std::string res_name = setup.base_name + ".res";
+
+  bool isfail = false;
+
+  std::ostream& to = std::cout;
+
+  to << "{\"benchmark\": \"mess_bench\", \"threads\": " << threads << ",\n \"networks\": [";
+
+  int count = 0;
+  for(int w = 0; w < setup.well_size.size(); ++w)
+    for(int e = 0; e < setup.energy_step.size(); ++e)
+      for(int b = 0; b < setup.bath_size.size(); ++b) {
+	to << (count++ ? ",\n  " : "\n  ");
+	if(!Bench::fork_run(setup, setup.well_size[w], setup.energy_step[e], setup.bath_size[b], res_name, to)) {
+	  std::cerr << funame << setup.well_size[w] << " wells, " << setup.energy_step[e] << " energy step, "
+		    << setup.bath_size[b] << " bath gases: failed\n";
+	  to << "{\"well_number\": " << setup.well_size[w]
+	     << ", \"energy_step_over_temperature\": " << Batch::json_number(setup.energy_step[e])
+	     << ", \"bath_number\": " << setup.bath_size[b]
+	     << ", \"error\": \"evaluation failed\"}";
+	  isfail = true;
+	}
+      }
+
+  to << "\n ],\n \"graph\": ";
+
+  if(!setup.mode_size)
+    to << "null";
+  else if(!Bench::fork_run(setup, 0, 0., 0, res_name, to)) {
+    std::cerr << funame << "graph expansion: failed\n";
+    to << "{\"mode_number\": " << setup.mode_size << ", \"error\": \"evaluation failed\"}";
+    isfail = true;
+  }
+
+  to << "\n}\n";
+
+  return isfail;
+}
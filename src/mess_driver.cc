@@ -17,21 +17,2244 @@
 #include<fstream>
 #include<sstream>
 #include<cmath>
+#include<cstdio>
+#include<limits>
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef WITH_SCALAPACK
+#include <mpi.h>
+#include "libmess/scalapack.hh"
+#endif
+
+#ifdef WITH_CUSOLVER
+#include "libmess/cusolver.hh"
+#endif
 
 #include "libmess/mess.hh"
 #include "libmess/key.hh"
 #include "libmess/units.hh"
 #include "libmess/io.hh"
+#include "libmess/ratefit.hh"
+#include "libmess/threads.hh"
+#include "libmess/batch.hh"
+
+#ifdef MESS_LIBRARY
+#include "mess_api.hh"
+#endif
+
+/********************************************************************************************
+ ******************************* TEMPERATURE-PRESSURE SWEEP *********************************
+ ********************************************************************************************/
+
+// (T, P) points are enumerated temperature-major, point index = p + t * pressure size;
+// the sweep is split into contiguous blocks of points, each block is evaluated by
+// a forked worker process with its own copy of the master equation state,
+// the results and the auxiliary output are then collected in the block order
+
+namespace Sweep {
+
+  typedef std::map<std::pair<int, int>, double> RateMap;
+
+  struct Setup {
+    std::vector<double> temperature;
+    std::vector<double> pressure;
+    double estep; // energy step
+    double etot;  // energy step over temperature
+    double xtot;  // excess energy over temperature
+    double eref;  // reference energy
+    bool iseref;
+    double tail_tol; // Boltzmann tail tolerance of the energy reference, not lowered if not positive
+    MasterEquation::Method method;
+    std::string method_name;
+
+    // memory pre-flight adjustments by temperature index, none if empty
+    std::vector<double> estep_factor; // energy step scaling
+    std::vector<char>   band_storage; // direct method with the band storage
+
+    // explicit energy grids by temperature index (energy grid convergence), none if empty
+    std::vector<double> grid_step;
+    std::vector<double> grid_reference;
+  };
+
+  // the setup restricted to the temperatures subset
+  Setup subset (const Setup&, const std::vector<int>& temperature_index);
+
+  struct Result {
+    std::vector<RateMap>                   hp_rate_coef;   // temperature index
+    std::vector<std::map<int, double> >    capture;        // temperature index
+    std::vector<RateMap>                   rate_coef;      // point index
+    std::vector<MasterEquation::Partition> well_partition; // point index
+
+    // point index, with MasterEquation::keep_spectrum only; the worker processes do not return it
+    std::vector<MasterEquation::Spectrum>  spectrum;
+
+    Result (int tsize, int psize)
+      : hp_rate_coef(tsize), capture(tsize), rate_coef(tsize * psize), well_partition(tsize * psize),
+	spectrum(tsize * psize) {}
+  };
+
+  // sets the temperature, the energy step, and the reference energy of the temperature index
+  void set_grid (const Setup&, int t);
+
+  // evaluates points [pbeg, pend)
+  void run (const Setup&, int pbeg, int pend, Result&);
+
+  // evaluates all points with worker processes
+  void run (const Setup&, int worker_size, const std::string& base_name, Result&);
+
+  // binary transfer of the block results
+  void save (std::ostream&, const Setup&, int pbeg, int pend, const Result&);
+  void load (std::istream&, const Setup&, int pbeg, int pend, Result&);
+
+  // auxiliary output streams
+  std::vector<std::pair<std::ofstream*, std::string> > aux_stream ();
+
+  // structured rate output: one JSON object per line for each (T, P) point, written
+  // as soon as the point is done, with the rate coefficients, the well partition,
+  // the eigenvalue gap, and the timing of the marked stages
+  std::ofstream rate_json;
+
+  bool rate_json_hold = false; // the structured output is written by the caller
+
+  void json_output (std::ostream&, const Setup&, int point, const Result&, double cpu_time, double wall_time);
+
+  // rate cache: the results of each (T, P) point are stored in the directory under the hash
+  // of the model relevant input, the energy grid, and the point, and are reused by the runs
+  // with the same hash; the input is the settings section without the output, the temperature
+  // and pressure lists, and the run time options, followed by the model section
+  std::string rate_cache_dir;
+  std::string rate_cache_input;
+
+  // the settings section line is not a part of the rate cache input
+  bool rate_cache_ignore (const std::string& line);
+
+  // the point results from the cache, false if not there
+  bool load_point (const Setup&, int point, Result&);
+  void save_point (const Setup&, int point, const RateMap& hp_rate, const std::map<int, double>& capture, const Result&);
+
+  // memory pre-flight: the predicted peak memory of each temperature is checked against
+  // the memory limit of one worker process; the temperatures which exceed it are reported,
+  // stop the run, are switched to the band storage (direct method only), or have
+  // the energy step increased until the estimate fits, according to the policy
+  enum { MEMORY_WARN, MEMORY_ABORT, MEMORY_BAND, MEMORY_DOWNSIZE };
+
+  void preflight (Setup&, double memory_limit, int policy);
+
+  // physical memory size, bytes
+  double physical_memory ();
+
+  // energy grid convergence: each temperature is solved on the sequence of the energy grids,
+  // with the energy step halved and the excess energy increased by a quarter of its initial
+  // value at each level, until the largest relative change of the rate coefficients over
+  // the pressure grid is below the tolerance; the reference energies stay on the initial
+  // grid, so that each grid is the decimation of the next one and the states tables are
+  // reused between the levels (in the same process, i.e., without the sweep workers)
+  void converge (Setup&, double tolerance, int level_max, int worker_size, const std::string& base_name, Result&);
+
+  // time evolution profile: the species populations are carried through the profile segments
+  // by the phenomenological rate coefficients of the segment (T, P) points; the kinetic nodes
+  // are the wells, the merged ones represented by the group member with the rate coefficients,
+  // and the bimolecular reactant with the excess concentration; the other species are the sinks;
+  // the node rate matrix, symmetrized by the detailed balance, is diagonalized once per point
+  // and the eigen-decomposition is reused by the segments which return to the point
+  struct Kinetics {
+    std::vector<int>    node;   // species index of the node
+    std::vector<int>    group;  // species the population of the species is moved to
+    std::vector<double> dfac;   // square roots of the node weights
+    Lapack::Vector      lambda; // node rate matrix eigenvalues, 1/sec
+    Lapack::Matrix      mode;   // node index, eigenvalue index
+    Lapack::Matrix      rate;   // species index, node index: pseudo-first-order rate coefficients, 1/sec
+  };
+
+  Kinetics kinetics (const Result&, int point, int reactant, double excess);
+
+  // species populations after the time interval (sec)
+  void propagate (const Kinetics&, const std::vector<double>& start, double interval, std::vector<double>& pop);
+
+  void profile_evolution (const Setup&, const Result&);
+
+  std::string file_name (const std::string& base_name, int worker, const std::string& tag)
+  {
+    std::ostringstream to;
+    to << base_name << ".sweep." << worker << "." << tag;
+    return to.str();
+  }
+
+  template <typename T>
+  void write (std::ostream& to, const T& t) { to.write((const char*)&t, sizeof(T)); }
+
+  template <typename T>
+  void read (std::istream& from, T& t) { from.read((char*)&t, sizeof(T)); }
+
+  void write (std::ostream& to, const RateMap& rate)
+  {
+    write(to, (int)rate.size());
+    for(RateMap::const_iterator it = rate.begin(); it != rate.end(); ++it) {
+      write(to, it->first.first);
+      write(to, it->first.second);
+      write(to, it->second);
+    }
+  }
+
+  void read (std::istream& from, RateMap& rate)
+  {
+    int    size, i, j;
+    double dtemp;
+
+    rate.clear();
+    read(from, size);
+    for(int n = 0; n < size && from; ++n) {
+      read(from, i);
+      read(from, j);
+      read(from, dtemp);
+      rate[std::make_pair(i, j)] = dtemp;
+    }
+  }
+}
+
+std::vector<std::pair<std::ofstream*, std::string> > Sweep::aux_stream ()
+{
+  std::vector<std::pair<std::ofstream*, std::string> > res;
+
+  res.push_back(std::make_pair(&MasterEquation::eval_out,       std::string("eval")));
+  res.push_back(std::make_pair(&MasterEquation::evec_out,       std::string("evec")));
+  res.push_back(std::make_pair(&MasterEquation::ped_out,        std::string("ped")));
+  res.push_back(std::make_pair(&MasterEquation::sens_out,       std::string("sens")));
+  res.push_back(std::make_pair(&rate_json,                      std::string("json")));
+
+  if(Model::time_evolution)
+    res.push_back(std::make_pair(&Model::time_evolution->out, std::string("tev")));
+
+  return res;
+}
+
+void Sweep::set_grid (const Setup& setup, int t)
+{
+  const double temperature = setup.temperature[t];
+
+  const double factor = setup.estep_factor.size() ? setup.estep_factor[t] : 1.;
+
+  MasterEquation::set_temperature(temperature);
+
+  if(setup.grid_step.size()) {
+    MasterEquation::set_energy_step(setup.grid_step[t]);
+    MasterEquation::set_energy_reference(setup.grid_reference[t]);
+    return;
+  }
+
+  // energy step
+  if(setup.estep > 0.)
+    MasterEquation::set_energy_step(setup.estep * factor);
+  else
+    MasterEquation::set_energy_step(nearbyint(temperature * setup.etot * factor / Phys_const::incm) * Phys_const::incm);
+
+  // reference energy
+  if(setup.iseref)
+    MasterEquation::set_energy_reference(setup.eref);
+  else
+    MasterEquation::set_energy_reference(nearbyint((temperature * setup.xtot + Model::maximum_barrier_height())
+						   / Phys_const::incm) * Phys_const::incm);
+
+  // the smallest energy reference of the temperature
+  if(setup.tail_tol > 0.)
+    MasterEquation::lower_energy_reference(setup.tail_tol);
+}
+
+void Sweep::run (const Setup& setup, int pbeg, int pend, Result& res)
+{
+  const int psize = setup.pressure.size();
+
+  RateMap               rate_data;
+  std::map<int, double> capture_data;
+
+  // high pressure data of the current temperature
+  RateMap hp_data;
+
+  // solver temporaries are reused from one point to the next
+  Workspace::Scope workspace;
+
+  int tcur = -1, tgrid = -1;
+  for(int point = pbeg; point < pend; ++point) {
+    const int t = point / psize;
+    const int p = point % psize;
+
+    // the temperature setup is timed with its first point
+    IO::stage_list.clear();
+
+    std::clock_t                          start_cpu  = std::clock();
+    std::chrono::steady_clock::time_point start_wall = std::chrono::steady_clock::now();
+
+    if(t != tgrid) {
+      tgrid = t;
+      set_grid(setup, t);
+    }
+
+    // the states of the temperature are not needed for the cached points
+    if(rate_cache_dir.size() && load_point(setup, point, res)) {
+      if(rate_json.is_open() && !rate_json_hold)
+	json_output(rate_json, setup, point, res, 0., 0.);
+      continue;
+    }
+
+    if(t != tcur) {// temperature cycle
+      tcur = t;
+
+      // set barriers, wells, and bimolecular species
+      MasterEquation::set(rate_data, capture_data);
+
+      hp_data = rate_data;
+
+      // the block which starts the temperature owns the high pressure data
+      if(!p) {
+	res.hp_rate_coef[t] = rate_data;
+	res.capture[t]      = capture_data;
+      }
+    }
+
+    // pressure dependent rate coefficients
+    MasterEquation::set_pressure(setup.pressure[p]);
+
+    MasterEquation::eigenvalue_gap = -1.;
+
+    if(setup.band_storage.size() && setup.band_storage[t])
+      MasterEquation::banded_diagonalization_method(rate_data, res.well_partition[point], 0);
+    else if(setup.method)
+      setup.method(rate_data, res.well_partition[point], 0);
+
+    res.rate_coef[point] = rate_data;
+
+    if(MasterEquation::keep_spectrum) {
+      res.spectrum[point] = MasterEquation::spectrum;
+      MasterEquation::spectrum = MasterEquation::Spectrum();
+    }
+
+    if(rate_cache_dir.size())
+      save_point(setup, point, hp_data, capture_data, res);
+
+    if(rate_json.is_open() && !rate_json_hold)
+      json_output(rate_json, setup, point, res, double(std::clock() - start_cpu) / CLOCKS_PER_SEC,
+		  std::chrono::duration<double>(std::chrono::steady_clock::now() - start_wall).count());
+  }
+}
+
+bool Sweep::rate_cache_ignore (const std::string& line)
+{
+  static const char* ignore_key [] = {
+    "TemperatureList[K]", "PressureList[bar]", "PressureList[torr]", "PressureList[atm]",
+    "RateOutput", "LogOutput", "EigenvalueOutput", "EigenvectorNumber", "EigenvectorOutput",
+    "PEDSpecies", "PEDOutput", "PEDRelaxationTolerance", "SensitivityOutput", "SpectralOutputFormat",
+    "StructuredRateOutput", "ProfileOutput", "RateFitOutput", "ChebyshevOrder",
+    "MicroRateOutput", "MicroEnerMax[kcal/mol]", "MicroEnerMin[kcal/mol]", "MicroEnerStep[kcal/mol]",
+    "MemoryLimit[GB]", "MemoryPolicy", "ThreadNumber", "BlasThreadNumber", "ThreadBinding",
+    "SweepWorkerNumber", "StateCacheDirectory", "MultiRotorCacheDirectory", "RotorCacheDirectory",
+    "GraphCacheDirectory", "GraphDatabaseMemory[MB]", "GraphDatabaseSpillDirectory", "RateCacheDirectory"
+  };
+
+  std::istringstream lin(line);
+  std::string token;
+  if(!(lin >> token))
+    return true;
+
+  for(int i = 0; i < sizeof(ignore_key) / sizeof(ignore_key[0]); ++i)
+    if(token == ignore_key[i])
+      return true;
+
+  return false;
+}
+
+namespace Sweep {
+  //
+  std::string rate_cache_key (const Setup& setup, int point)
+  {
+    // layout of the cached results
+    static const int rate_cache_format = 1;
+
+    const int t = point / setup.pressure.size();
+    const int p = point % setup.pressure.size();
+
+    std::ostringstream key;
+
+    key << std::setprecision(17)
+	<< rate_cache_format                         << " "
+	<< setup.temperature[t]                      << " "
+	<< setup.pressure[p]                         << " "
+	<< MasterEquation::energy_step()             << " "
+	<< MasterEquation::energy_reference()        << " "
+	<< setup.method_name                         << " "
+	<< (setup.band_storage.size() && setup.band_storage[t]) << "\n"
+	<< rate_cache_input;
+
+    return key.str();
+  }
+
+  std::string rate_cache_file (const std::string& key)
+  {
+    return rate_cache_dir + "/" + IO::hash_name(key) + ".rate";
+  }
+}
+
+bool Sweep::load_point (const Setup& setup, int point, Result& res)
+{
+  const std::string key  = rate_cache_key(setup, point);
+  const std::string name = rate_cache_file(key);
+
+  std::ifstream from(name.c_str(), std::ios::binary);
+
+  if(!from)
+    return false;
+
+  int    itemp, size;
+  double dtemp;
+
+  read(from, size);
+
+  std::string stemp(size == key.size() ? size : 0, ' ');
+
+  if(!from || size != key.size() || !from.read(&stemp[0], size) || stemp != key) {
+    IO::log << IO::log_offset << "WARNING: rate cache " << name << " does not match the input, ignoring\n";
+    return false;
+  }
+
+  const int t = point / setup.pressure.size();
+
+  RateMap               hp_rate, rate;
+  std::map<int, double> capture;
+
+  MasterEquation::Partition part;
+
+  read(from, hp_rate);
+
+  read(from, size);
+  for(int n = 0; n < size && from; ++n) {
+    read(from, itemp);
+    read(from, dtemp);
+    capture[itemp] = dtemp;
+  }
+
+  read(from, rate);
+
+  read(from, size);
+  if(from)
+    part.resize(size);
+  for(int g = 0; g < part.size() && from; ++g) {
+    read(from, size);
+    for(int n = 0; n < size && from; ++n) {
+      read(from, itemp);
+      part[g].insert(itemp);
+    }
+  }
+
+  read(from, dtemp);
+
+  if(!from) {
+    IO::log << IO::log_offset << "WARNING: cannot read rate cache " << name << ", ignoring\n";
+    return false;
+  }
+
+  res.hp_rate_coef[t]       = hp_rate;
+  res.capture[t]            = capture;
+  res.rate_coef[point]      = rate;
+  res.well_partition[point] = part;
+
+  MasterEquation::eigenvalue_gap = dtemp;
+
+  IO::log << IO::log_offset << "temperature = " << setup.temperature[t] / Phys_const::kelv
+	  << " K, pressure point " << point % setup.pressure.size() + 1 << ": rate coefficients are read from " << name << "\n";
+
+  return true;
+}
+
+void Sweep::save_point (const Setup& setup, int point, const RateMap& hp_rate, const std::map<int, double>& capture,
+			const Result& res)
+{
+  if(IO::mpi_rank)
+    return;
+
+  const std::string key  = rate_cache_key(setup, point);
+  const std::string name = rate_cache_file(key);
+
+  IO::AtomicFile to(name);
+
+  if(!to) {
+    IO::log << IO::log_offset << "WARNING: cannot open rate cache file " << to.tmp_name() << "\n";
+    return;
+  }
+
+  write(to, (int)key.size());
+  to.write(key.data(), key.size());
+
+  write(to, hp_rate);
+
+  write(to, (int)capture.size());
+  for(std::map<int, double>::const_iterator it = capture.begin(); it != capture.end(); ++it) {
+    write(to, it->first);
+    write(to, it->second);
+  }
+
+  write(to, res.rate_coef[point]);
+
+  const MasterEquation::Partition& part = res.well_partition[point];
+  write(to, (int)part.size());
+  for(int g = 0; g < part.size(); ++g) {
+    write(to, (int)part[g].size());
+    for(MasterEquation::Git w = part[g].begin(); w != part[g].end(); ++w)
+      write(to, *w);
+  }
+
+  write(to, MasterEquation::eigenvalue_gap);
+
+  if(!to.commit())
+    IO::log << IO::log_offset << "WARNING: cannot write rate cache file " << name << "\n";
+}
+
+namespace Sweep {
+  //
+  std::string json_string (const std::string& s)
+  {
+    std::string res = "\"";
+    for(int i = 0; i < s.size(); ++i) {
+      if(s[i] == '"' || s[i] == '\\')
+	res += '\\';
+      res += s[i];
+    }
+    res += '"';
+    return res;
+  }
+
+  std::string json_number (double x)
+  {
+    if(x != x || x - x != 0.)
+      return "null";
+
+    std::ostringstream to;
+    to << std::setprecision(10) << x;
+    return to.str();
+  }
+
+  std::string species_name (int i)
+  {
+    if(i < Model::well_size())
+      return Model::well(i).name();
+
+    i -= Model::well_size();
+    if(i < Model::bimolecular_size())
+      return Model::bimolecular(i).name();
+
+    i -= Model::bimolecular_size();
+    return "Escape[" + Model::well(i).name() + "]";
+  }
+}
+
+void Sweep::json_output (std::ostream& to, const Setup& setup, int point, const Result& res, double cpu_time, double wall_time)
+{
+  const int t = point / setup.pressure.size();
+  const int p = point % setup.pressure.size();
+
+  to << "{\"temperature[K]\": " << json_number(setup.temperature[t] / Phys_const::kelv);
+
+  switch(MasterEquation::pressure_unit) {
+  case MasterEquation::BAR:
+    to << ", \"pressure[bar]\": "  << json_number(setup.pressure[p] / Phys_const::bar);
+    break;
+  case MasterEquation::TORR:
+    to << ", \"pressure[torr]\": " << json_number(setup.pressure[p] / Phys_const::tor);
+    break;
+  case MasterEquation::ATM:
+    to << ", \"pressure[atm]\": "  << json_number(setup.pressure[p] / Phys_const::atm);
+    break;
+  }
+
+  to << ", \"method\": " << json_string(setup.band_storage.size() && setup.band_storage[t] ? std::string("banded") : setup.method_name);
+
+  to << ", \"eigenvalue_gap\": "
+     << (MasterEquation::eigenvalue_gap < 0. ? std::string("null") : json_number(MasterEquation::eigenvalue_gap));
+
+  // well partition
+  const MasterEquation::Partition& part = res.well_partition[point];
+  to << ", \"well_partition\": [";
+  for(int g = 0; g < part.size(); ++g) {
+    to << (g ? ", [" : "[");
+    for(MasterEquation::Git w = part[g].begin(); w != part[g].end(); ++w)
+      to << (w != part[g].begin() ? ", " : "") << json_string(Model::well(*w).name());
+    to << "]";
+  }
+  to << "]";
+
+  // rate coefficients: unimolecular in 1/sec, bimolecular in cm^3/sec
+  const RateMap& rate = res.rate_coef[point];
+  to << ", \"rate_coefficients\": {";
+  for(RateMap::const_iterator it = rate.begin(); it != rate.end(); ++it)
+    to << (it != rate.begin() ? ", " : "")
+       << json_string(species_name(it->first.first) + "->" + species_name(it->first.second))
+       << ": " << json_number(it->second);
+  to << "}";
+
+  // timing
+  to << ", \"cpu_time[sec]\": " << json_number(cpu_time)
+     << ", \"wall_time[sec]\": " << json_number(wall_time)
+     << ", \"stages\": [";
+  for(int s = 0; s < IO::stage_list.size(); ++s)
+    to << (s ? ", " : "") 
+       << "{\"name\": "           << json_string(IO::stage_list[s].name)
+       << ", \"level\": "         << IO::stage_list[s].level
+       << ", \"cpu_time[sec]\": "  << json_number(IO::stage_list[s].cpu_time)
+       << ", \"wall_time[sec]\": " << json_number(IO::stage_list[s].wall_time)
+       << "}";
+  to << "]}" << std::endl;
+}
+
+void Sweep::save (std::ostream& to, const Setup& setup, int pbeg, int pend, const Result& res)
+{
+  const int psize = setup.pressure.size();
+
+  for(int point = pbeg; point < pend; ++point) {
+    const int t = point / psize;
+
+    if(!(point % psize)) {
+      write(to, res.hp_rate_coef[t]);
+      write(to, (int)res.capture[t].size());
+      for(std::map<int, double>::const_iterator it = res.capture[t].begin(); it != res.capture[t].end(); ++it) {
+	write(to, it->first);
+	write(to, it->second);
+      }
+    }
+
+    write(to, res.rate_coef[point]);
+
+    const MasterEquation::Partition& part = res.well_partition[point];
+    write(to, (int)part.size());
+    for(int g = 0; g < part.size(); ++g) {
+      write(to, (int)part[g].size());
+      for(MasterEquation::Git w = part[g].begin(); w != part[g].end(); ++w)
+	write(to, *w);
+    }
+  }
+}
+
+void Sweep::load (std::istream& from, const Setup& setup, int pbeg, int pend, Result& res)
+{
+  const char funame [] = "Sweep::load: ";
+
+  int    itemp, size;
+  double dtemp;
+
+  const int psize = setup.pressure.size();
+
+  for(int point = pbeg; point < pend; ++point) {
+    const int t = point / psize;
+
+    if(!(point % psize)) {
+      read(from, res.hp_rate_coef[t]);
+
+      res.capture[t].clear();
+      read(from, size);
+      for(int n = 0; n < size && from; ++n) {
+	read(from, itemp);
+	read(from, dtemp);
+	res.capture[t][itemp] = dtemp;
+      }
+    }
+
+    read(from, res.rate_coef[point]);
+
+    MasterEquation::Partition& part = res.well_partition[point];
+    read(from, size);
+    if(!from) {
+      std::cerr << funame << "corrupted\n";
+      throw Error::Input();
+    }
+    part.resize(size);
+    for(int g = 0; g < part.size(); ++g) {
+      part[g].clear();
+      read(from, size);
+      for(int n = 0; n < size && from; ++n) {
+	read(from, itemp);
+	part[g].insert(itemp);
+      }
+    }
+  }
+
+  if(!from) {
+    std::cerr << funame << "corrupted\n";
+    throw Error::Input();
+  }
+}
+
+void Sweep::run (const Setup& setup, int worker_size, const std::string& base_name, Result& res)
+{
+  const char funame [] = "Sweep::run: ";
+
+  const int point_size = setup.temperature.size() * setup.pressure.size();
+
+  if(worker_size > point_size)
+    worker_size = point_size;
+
+  std::vector<std::pair<std::ofstream*, std::string> > aux = aux_stream();
+
+  // the buffered output should not be duplicated in the child processes
+  for(int s = 0; s < aux.size(); ++s)
+    if(aux[s].first->is_open())
+      aux[s].first->flush();
+  IO::log.flush();
+  IO::out.flush();
+  std::cout.flush();
+
+  std::vector<pid_t> worker_pid(worker_size);
+
+  for(int k = 0; k < worker_size; ++k) {
+    const int pbeg = point_size *  k      / worker_size;
+    const int pend = point_size * (k + 1) / worker_size;
+
+    worker_pid[k] = fork();
+
+    if(worker_pid[k] < 0) {
+      std::cerr << funame << "fork failed\n";
+      throw Error::Run();
+    }
+
+    // worker
+    if(!worker_pid[k]) {
+      int status = 0;
+      try {
+	// share the cores, the OpenMP and the BLAS threads, between the workers
+	int itemp = Threads::total() / worker_size;
+	Threads::init(itemp > 0 ? itemp : 1);
+
+	// the log goes through its own buffer
+	if(IO::log.is_open()) {
+	  IO::log.close();
+	  IO::log.open(file_name(base_name, k, "log").c_str());
+	}
+
+	for(int s = 0; s < aux.size(); ++s)
+	  if(aux[s].first->is_open()) {
+	    aux[s].first->close();
+	    aux[s].first->open(file_name(base_name, k, aux[s].second).c_str());
+	  }
+
+	if(IO::profile_record)
+	  IO::profile_reset();
+
+	run(setup, pbeg, pend, res);
+
+	std::ofstream to(file_name(base_name, k, "res").c_str(), std::ios::binary);
+	save(to, setup, pbeg, pend, res);
+	to.close();
+
+	if(!to)
+	  status = 1;
+
+	if(IO::profile_record) {
+	  std::ofstream prof(file_name(base_name, k, "prof").c_str());
+	  IO::profile_save(prof);
+	}
+      }
+      catch(Error::General) {
+	status = 1;
+      }
+      catch(...) {
+	status = 1;
+      }
+
+      if(IO::log.is_open())
+	IO::log.close();
+
+      for(int s = 0; s < aux.size(); ++s)
+	if(aux[s].first->is_open())
+	  aux[s].first->close();
+
+      _exit(status);
+    }
+  }
+
+  // wait for the workers
+  bool isfail = false;
+  for(int k = 0; k < worker_size; ++k) {
+    int status;
+    if(waitpid(worker_pid[k], &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) {
+      std::cerr << funame << "worker " << k << " failed\n";
+      isfail = true;
+    }
+  }
+
+  // collect the results and the auxiliary output in the block order
+  for(int k = 0; k < worker_size; ++k) {
+    const int pbeg = point_size *  k      / worker_size;
+    const int pend = point_size * (k + 1) / worker_size;
+
+    std::string name = file_name(base_name, k, "res");
+    if(!isfail) {
+      std::ifstream from(name.c_str(), std::ios::binary);
+      load(from, setup, pbeg, pend, res);
+    }
+    std::remove(name.c_str());
+
+    // the worker profile goes to its own timeline track
+    if(IO::profile_record) {
+      name = file_name(base_name, k, "prof");
+      std::ifstream from(name.c_str());
+      if(from && !isfail)
+	IO::profile_merge(from, k + 1);
+      from.close();
+      std::remove(name.c_str());
+    }
+
+    if(IO::log.is_open()) {
+      name = file_name(base_name, k, "log");
+      std::ifstream from(name.c_str());
+      if(from && from.peek() != std::ifstream::traits_type::eof())
+	(std::ostream&)IO::log << from.rdbuf();
+      from.close();
+      std::remove(name.c_str());
+    }
+
+    for(int s = 0; s < aux.size(); ++s)
+      if(aux[s].first->is_open()) {
+	name = file_name(base_name, k, aux[s].second);
+	std::ifstream from(name.c_str());
+	if(from && from.peek() != std::ifstream::traits_type::eof())
+	  (std::ostream&)*aux[s].first << from.rdbuf();
+	from.close();
+	std::remove(name.c_str());
+      }
+  }
+
+  if(isfail) {
+    IO::log << std::flush;
+    throw Error::Run();
+  }
+}
+
+Sweep::Setup Sweep::subset (const Setup& setup, const std::vector<int>& index)
+{
+  Setup res = setup;
+
+  res.temperature.clear();
+  res.estep_factor.clear();
+  res.band_storage.clear();
+  res.grid_step.clear();
+  res.grid_reference.clear();
+
+  for(int i = 0; i < index.size(); ++i) {
+    const int t = index[i];
+
+    res.temperature.push_back(setup.temperature[t]);
+
+    if(setup.estep_factor.size())
+      res.estep_factor.push_back(setup.estep_factor[t]);
+    if(setup.band_storage.size())
+      res.band_storage.push_back(setup.band_storage[t]);
+    if(setup.grid_step.size()) {
+      res.grid_step.push_back(setup.grid_step[t]);
+      res.grid_reference.push_back(setup.grid_reference[t]);
+    }
+  }
+
+  return res;
+}
+
+void Sweep::converge (Setup& setup, double tolerance, int level_max, int worker_size, const std::string& base_name, Result& res)
+{
+  const char funame [] = "Sweep::converge: ";
+
+  IO::Marker funame_marker(funame);
+
+  const int tsize = setup.temperature.size();
+  const int psize = setup.pressure.size();
+
+  // initial grids
+  std::vector<double> step(tsize), reference(tsize), excess(tsize);
+  for(int t = 0; t < tsize; ++t) {
+    set_grid(setup, t);
+    step[t]      = MasterEquation::energy_step();
+    reference[t] = MasterEquation::energy_reference();
+    excess[t]    = reference[t] - Model::maximum_barrier_height();
+  }
+  setup.grid_step      = step;
+  setup.grid_reference = reference;
+
+  rate_json_hold = true;
+
+  std::vector<int> active;
+  for(int t = 0; t < tsize; ++t)
+    active.push_back(t);
+
+  IO::log << IO::log_offset << "tolerance = " << tolerance << "\n"
+	  << IO::log_offset
+	  << std::setw(6)  << "level"
+	  << std::setw(10) << "T, K"
+	  << std::setw(12) << "step, 1/cm"
+	  << std::setw(14) << "Eref, 1/cm"
+	  << std::setw(12) << "change"
+	  << "   reaction\n";
+
+  for(int level = 0; level <= level_max && active.size(); ++level) {
+    //
+    if(level)
+      for(int i = 0; i < active.size(); ++i) {
+	const int t = active[i];
+
+	setup.grid_step[t] = step[t] / std::pow(2., level);
+
+	if(!setup.iseref && excess[t] > 0.)
+	  setup.grid_reference[t] = reference[t] + std::ceil(0.25 * level * excess[t] / step[t]) * step[t];
+      }
+
+    Setup sub = subset(setup, active);
+
+    Result sub_res(sub.temperature.size(), psize);
+
+    if(worker_size > 1)
+      run(sub, worker_size, base_name, sub_res);
+    else
+      run(sub, 0, sub.temperature.size() * psize, sub_res);
+
+    std::vector<int> next;
+    for(int i = 0; i < active.size(); ++i) {
+      const int t = active[i];
+
+      // largest relative change of the positive rate coefficients
+      double change = -1.;
+      std::string reaction;
+      for(int p = 0; p < psize && level; ++p) {
+	const RateMap& prev = res.rate_coef[p + t * psize];
+	const RateMap& curr = sub_res.rate_coef[p + i * psize];
+
+	for(RateMap::const_iterator it = curr.begin(); it != curr.end(); ++it) {
+	  RateMap::const_iterator pit = prev.find(it->first);
+
+	  if(it->first.first == it->first.second || pit == prev.end() || it->second <= 0. || pit->second <= 0.)
+	    continue;
+
+	  const double dtemp = std::fabs(it->second - pit->second) / std::max(it->second, pit->second);
+
+	  if(dtemp > change) {
+	    change   = dtemp;
+	    reaction = species_name(it->first.first) + "->" + species_name(it->first.second);
+	  }
+	}
+      }
+
+      res.hp_rate_coef[t] = sub_res.hp_rate_coef[i];
+      res.capture[t]      = sub_res.capture[i];
+      for(int p = 0; p < psize; ++p) {
+	res.rate_coef[p + t * psize]      = sub_res.rate_coef[p + i * psize];
+	res.well_partition[p + t * psize] = sub_res.well_partition[p + i * psize];
+      }
+
+      IO::log << IO::log_offset
+	      << std::setw(6)  << level
+	      << std::setw(10) << setup.temperature[t] / Phys_const::kelv
+	      << std::setw(12) << setup.grid_step[t] / Phys_const::incm
+	      << std::setw(14) << setup.grid_reference[t] / Phys_const::incm;
+
+      if(level)
+	IO::log << std::setw(12) << change << "   " << reaction;
+      IO::log << "\n";
+
+      if(!level || change >= tolerance)
+	next.push_back(t);
+    }
+
+    active = next;
+  }
+
+  if(active.size()) {
+    IO::log << IO::log_offset << "WARNING: energy grid is not converged at T =";
+    for(int i = 0; i < active.size(); ++i)
+      IO::log << " " << setup.temperature[active[i]] / Phys_const::kelv;
+    IO::log << " K\n";
+  }
+
+  rate_json_hold = false;
+
+  if(rate_json.is_open()) {
+    MasterEquation::eigenvalue_gap = -1.;
+
+    for(int point = 0; point < tsize * psize; ++point)
+      json_output(rate_json, setup, point, res, std::numeric_limits<double>::quiet_NaN(),
+		  std::numeric_limits<double>::quiet_NaN());
+  }
+}
+
+double Sweep::physical_memory ()
+{
+  const long pages = sysconf(_SC_PHYS_PAGES);
+  const long bytes = sysconf(_SC_PAGE_SIZE);
+
+  if(pages <= 0 || bytes <= 0)
+    return -1.;
+
+  return (double)pages * (double)bytes;
+}
+
+void Sweep::preflight (Setup& setup, double memory_limit, int policy)
+{
+  const char funame [] = "Sweep::preflight: ";
+
+  IO::Marker funame_marker(funame, IO::Marker::NOTIME);
+
+  const double gb = 1024. * 1024. * 1024.;
+
+  IO::log << IO::log_offset << "memory limit per process = " << memory_limit / gb << " GB\n"
+	  << IO::log_offset
+	  << std::setw(10) << "T, K"
+	  << std::setw(10) << "step"
+	  << std::setw(10) << "dimension"
+	  << std::setw(10) << "band"
+	  << std::setw(13) << "dense, GB"
+	  << std::setw(13) << "banded, GB"
+	  << "\n";
+
+  const int tsize = setup.temperature.size();
+
+  setup.estep_factor.assign(tsize, 1.);
+  setup.band_storage.assign(tsize, 0);
+
+  // the band storage replaces the dense one of the direct method only
+  const bool band_switch = (setup.method == MasterEquation::direct_diagonalization_method
+			    || setup.method == MasterEquation::automatic_method)
+    && MasterEquation::band_storage_available();
+
+  const bool band_method = setup.method == MasterEquation::banded_diagonalization_method;
+
+  bool isfail = false;
+  bool isadjust = false;
+  for(int t = 0; t < tsize; ++t) {
+    //
+    MasterEquation::MemoryEstimate est;
+
+    bool fit;
+    while(1) {
+      set_grid(setup, t);
+
+      est = MasterEquation::memory_estimate();
+
+      fit = (band_method ? est.banded : est.dense) <= memory_limit;
+
+      if(fit || policy != MEMORY_DOWNSIZE || setup.estep_factor[t] > 10.)
+	break;
+
+      setup.estep_factor[t] *= 1.1;
+    }
+
+    IO::log << IO::log_offset
+	    << std::setw(10) << setup.temperature[t] / Phys_const::kelv
+	    << std::setw(10) << MasterEquation::energy_step() / Phys_const::incm
+	    << std::setw(10) << est.global_size
+	    << std::setw(10) << est.band_size
+	    << std::setw(13) << est.dense  / gb
+	    << std::setw(13) << est.banded / gb;
+
+    if(fit) {
+      if(setup.estep_factor[t] > 1.) {
+	IO::log << "   energy step increased";
+	isadjust = true;
+      }
+      IO::log << "\n";
+      continue;
+    }
+
+    if(policy == MEMORY_BAND && band_switch && est.banded <= memory_limit) {
+      IO::log << "   band storage\n";
+      setup.band_storage[t] = 1;
+      isadjust = true;
+      continue;
+    }
+
+    IO::log << "   WARNING: exceeds the limit\n";
+    isfail = true;
+  }
+
+  if(isadjust)
+    IO::log << IO::log_offset << "WARNING: the calculation setup has been adjusted to fit the memory limit\n";
+
+  if(isfail) {
+    if(policy == MEMORY_WARN) {
+      IO::log << IO::log_offset << "WARNING: the predicted memory exceeds the limit\n";
+      return;
+    }
+
+    std::cerr << funame << "the predicted memory exceeds the limit, see the log for details\n";
+    IO::log << std::flush;
+    throw Error::Range();
+  }
+}
+
+/********************************************************************************************
+ ***************************************** SERVER MODE **************************************
+ ********************************************************************************************/
+
+// the initialized model stays resident and the commands, one per line, are read from
+// the standard input; each command is answered by one or more JSON lines on the standard
+// output, the last one carrying the status:
+//
+//   TemperatureList[K]  t1 t2 ...      replaces the temperature grid
+//   PressureList[bar]   p1 p2 ...      replaces the pressure grid (also [torr] and [atm])
+//   AddPressure         p1 p2 ...      in the current pressure units
+//   ShiftBarrier        name de        barrier energy shift, kcal/mol
+//   ShiftWell           name de        well energy shift, kcal/mol
+//   CloseBarrier        name           removes the barrier from the network
+//   OpenBarrier         name           restores the closed barrier
+//   ScaleKernel         factor         scales the energy transferred down by all kernels
+//   BufferFraction      x1 x2 ...      buffer gases mole fractions; the wells read from the state
+//                                      cache are recombined from the per-buffer kernels
+//   Run                                one object per (T, P) point, see Sweep::json_output
+//   Quit
+//
+// the results are kept for the (T, P) points evaluated since the last model edit,
+// so that the grid extension evaluates only the new points; the wells, barriers, and
+// bimolecular species stay resident as well, so that after the energy shift only the shifted
+// species and the wells whose dissociation limits changed are set again, and, with no sweep
+// workers, the eigenvectors found before the edit start the eigensolver iterations (the
+// partial spectrum of the direct diagonalization method)
+
+Sweep::Kinetics Sweep::kinetics (const Result& res, int point, int reactant, double excess)
+{
+  const char funame [] = "Sweep::kinetics: ";
+
+  const int well_size = Model::well_size();
+  const int spec_size = well_size + Model::bimolecular_size();
+
+  const RateMap& rate = res.rate_coef[point];
+
+  if(!rate.size()) {
+    std::cerr << funame << "no pressure dependent rate coefficients\n";
+    throw Error::Init();
+  }
+
+  Kinetics kin;
+
+  // species with the outgoing rate coefficients
+  std::set<int> source;
+  for(RateMap::const_iterator it = rate.begin(); it != rate.end(); ++it)
+    if(it->first.first < spec_size)
+      source.insert(it->first.first);
+
+  // merged wells
+  kin.group.resize(spec_size);
+  for(int s = 0; s < spec_size; ++s)
+    kin.group[s] = s;
+
+  const MasterEquation::Partition& part = res.well_partition[point];
+  for(MasterEquation::Pit g = part.begin(); g != part.end(); ++g)
+    for(MasterEquation::Git w = g->begin(); w != g->end(); ++w)
+      if(source.count(*w)) {
+	for(MasterEquation::Git v = g->begin(); v != g->end(); ++v)
+	  kin.group[*v] = *w;
+	break;
+      }
+
+  // nodes
+  std::vector<int> node_index(spec_size, -1);
+  for(int w = 0; w < well_size; ++w)
+    if(kin.group[w] == w && source.count(w)) {
+      node_index[w] = kin.node.size();
+      kin.node.push_back(w);
+    }
+
+  if(excess > 0. && source.count(well_size + reactant)) {
+    node_index[well_size + reactant] = kin.node.size();
+    kin.node.push_back(well_size + reactant);
+  }
+
+  const int node_size = kin.node.size();
+
+  if(!node_size)
+    return kin;
+
+  // pseudo-first-order rate coefficients, the escape is a loss only
+  kin.rate.resize(spec_size, node_size);
+  kin.rate = 0.;
+
+  std::vector<double> loss(node_size, 0.);
+  for(RateMap::const_iterator it = rate.begin(); it != rate.end(); ++it) {
+    const int i = it->first.first;
+    const int j = it->first.second < spec_size ? kin.group[it->first.second] : it->first.second;
+
+    if(i == j || i >= spec_size || node_index[i] < 0 || it->second <= 0.)
+      continue;
+
+    const double k = i < well_size ? it->second : it->second * excess;
+
+    loss[node_index[i]] += k;
+
+    if(j < spec_size)
+      kin.rate(j, node_index[i]) += k;
+  }
+
+  // detailed balance weights over the connected nodes
+  kin.dfac.assign(node_size, -1.);
+  for(int r = 0; r < node_size; ++r) {
+    if(kin.dfac[r] > 0.)
+      continue;
+
+    kin.dfac[r] = 1.;
+
+    std::vector<int> queue(1, r);
+    for(int q = 0; q < queue.size(); ++q) {
+      const int i = queue[q];
+      for(int j = 0; j < node_size; ++j)
+	if(kin.dfac[j] < 0. && kin.rate(kin.node[j], i) > 0. && kin.rate(kin.node[i], j) > 0.) {
+	  kin.dfac[j] = kin.dfac[i] * std::sqrt(kin.rate(kin.node[j], i) / kin.rate(kin.node[i], j));
+	  queue.push_back(j);
+	}
+    }
+  }
+
+  // symmetrized node rate matrix
+  Lapack::SymmetricMatrix km(node_size);
+  km = 0.;
+
+  for(int i = 0; i < node_size; ++i) {
+    km(i, i) = -loss[i];
+
+    for(int j = 0; j < i; ++j)
+      if(kin.rate(kin.node[j], i) > 0. && kin.rate(kin.node[i], j) > 0.)
+	km(i, j) = std::sqrt(kin.rate(kin.node[j], i) * kin.rate(kin.node[i], j));
+  }
+
+  kin.lambda = km.eigenvalues(&kin.mode);
+
+  return kin;
+}
+
+void Sweep::propagate (const Kinetics& kin, const std::vector<double>& start, double interval, std::vector<double>& pop)
+{
+  const int node_size = kin.node.size();
+
+  pop = start;
+
+  if(!node_size)
+    return;
+
+  // mode amplitudes
+  std::vector<double> amp(node_size, 0.);
+  for(int l = 0; l < node_size; ++l)
+    for(int i = 0; i < node_size; ++i)
+      amp[l] += kin.mode(i, l) * start[kin.node[i]] / kin.dfac[i];
+
+  // node populations and their time integrals
+  std::vector<double> node_pop(node_size, 0.), node_int(node_size, 0.);
+  for(int l = 0; l < node_size; ++l) {
+    const double x = kin.lambda[l] * interval;
+    const double e = std::exp(x) * amp[l];
+    const double g = (x != 0. ? std::expm1(x) / kin.lambda[l] : interval) * amp[l];
+
+    for(int i = 0; i < node_size; ++i) {
+      node_pop[i] += kin.mode(i, l) * e;
+      node_int[i] += kin.mode(i, l) * g;
+    }
+  }
+
+  for(int i = 0; i < node_size; ++i) {
+    node_pop[i] *= kin.dfac[i];
+    node_int[i] *= kin.dfac[i];
+  }
+
+  std::vector<bool> is_node(pop.size(), false);
+  for(int i = 0; i < node_size; ++i) {
+    pop[kin.node[i]] = node_pop[i];
+    is_node[kin.node[i]] = true;
+  }
+
+  // sinks
+  for(int s = 0; s < pop.size(); ++s)
+    if(!is_node[s])
+      for(int i = 0; i < node_size; ++i)
+	pop[s] += kin.rate(s, i) * node_int[i];
+}
+
+void Sweep::profile_evolution (const Setup& setup, const Result& res)
+{
+  const char funame [] = "Sweep::profile_evolution: ";
+
+  IO::Marker funame_marker(funame);
+
+  double dtemp;
+
+  const Model::TimeEvolution& te = *Model::time_evolution;
+
+  const std::vector<Model::TimeEvolution::Segment>& profile = te.profile();
+
+  const int well_size = Model::well_size();
+  const int bim_size  = Model::bimolecular_size();
+  const int spec_size = well_size + bim_size;
+  const int psize     = setup.pressure.size();
+  const int time_size = te.size();
+
+  double pfac = 1.;
+  std::string punit;
+  switch(MasterEquation::pressure_unit) {
+  case MasterEquation::BAR:
+    pfac  = Phys_const::bar;
+    punit = " bar";
+    break;
+  case MasterEquation::TORR:
+    pfac  = Phys_const::tor;
+    punit = " torr";
+    break;
+  case MasterEquation::ATM:
+    pfac  = Phys_const::atm;
+    punit = " atm";
+    break;
+  }
+
+  // segment points
+  std::vector<int> seg_point(profile.size());
+  for(int s = 0; s < profile.size(); ++s) {
+    int t, p;
+    for(t = 0; t < setup.temperature.size(); ++t)
+      if(std::fabs(setup.temperature[t] / profile[s].temperature - 1.) < 1.e-6)
+	break;
+
+    for(p = 0; p < psize; ++p)
+      if(std::fabs(setup.pressure[p] / profile[s].pressure / pfac - 1.) < 1.e-6)
+	break;
+
+    if(t == setup.temperature.size() || p == psize) {
+      std::cerr << funame << s + 1 << "-th segment: the temperature and the pressure should be on the grid\n";
+      throw Error::Range();
+    }
+
+    seg_point[s] = p + t * psize;
+  }
+
+  // bimolecular reactant with the excess concentration, molecule/cm^3
+  double excess = -1.;
+  if(te.excess_reactant_concentration() > 0.)
+    excess = te.excess_reactant_concentration() * Phys_const::cm * Phys_const::cm * Phys_const::cm;
+
+  // initial populations
+  std::vector<double> pop(spec_size, 0.), curr;
+  pop[excess > 0. ? well_size + te.reactant() : te.reactant()] = 1.;
+
+  // time grid
+  std::vector<double> time_val(time_size);
+
+  time_val[0] = te.start() * Phys_const::herz;
+
+  for(int t = 1; t < time_size; ++t)
+    time_val[t] = time_val[t - 1] * te.step();
+
+  std::ofstream& out = Model::time_evolution->out;
+
+  if(te.binary() && !out.tellp()) {
+    out.write((const char*)&spec_size, sizeof(int));
+
+    for(int s = 0; s < spec_size; ++s) {
+      const std::string& name = s < well_size ? Model::well(s).name() : Model::bimolecular(s - well_size).name();
+      const int len = name.size();
+
+      out.write((const char*)&len, sizeof(int));
+      out.write(name.data(), len);
+    }
+  }
+
+  std::map<int, Kinetics> cache;
+
+  int reuse = 0;
+
+  double tbeg = 0.;
+  for(int s = 0, tv = 0; s < profile.size() && tv < time_size; ++s) {
+    //
+    const int point = seg_point[s];
+
+    std::map<int, Kinetics>::const_iterator kit = cache.find(point);
+    if(kit == cache.end())
+      kit = cache.insert(std::make_pair(point, kinetics(res, point, te.reactant(), excess))).first;
+    else
+      ++reuse;
+
+    const Kinetics& kin = kit->second;
+
+    // merged wells
+    for(int i = 0; i < spec_size; ++i)
+      if(kin.group[i] != i) {
+	pop[kin.group[i]] += pop[i];
+	pop[i] = 0.;
+      }
+
+    // the last segment conditions hold after the profile end
+    const double tend = s + 1 < profile.size() ? tbeg + profile[s].duration * Phys_const::herz : -1.;
+
+    // segment block: the time grid points in it
+    std::vector<double> block_time;
+    std::vector<std::vector<double> > block_pop;
+    for(; tv < time_size && (tend < 0. || time_val[tv] <= tend); ++tv) {
+      propagate(kin, pop, time_val[tv] - tbeg, curr);
+      block_time.push_back(time_val[tv]);
+      block_pop.push_back(curr);
+    }
+
+    if(tend > 0.) {
+      propagate(kin, pop, tend - tbeg, curr);
+      pop  = curr;
+      tbeg = tend;
+    }
+
+    if(!block_time.size())
+      continue;
+
+    const int block_size = block_time.size();
+
+    // columnar binary output
+    if(te.binary()) {
+      dtemp = profile[s].pressure;
+      out.write((const char*)&dtemp, sizeof(double));
+
+      dtemp = profile[s].temperature / Phys_const::kelv;
+      out.write((const char*)&dtemp, sizeof(double));
+
+      out.write((const char*)&block_size, sizeof(int));
+      out.write((const char*)&block_time[0], sizeof(double) * block_size);
+
+      for(int i = 0; i < spec_size; ++i)
+	for(int t = 0; t < block_size; ++t)
+	  out.write((const char*)&block_pop[t][i], sizeof(double));
+
+      if(!out) {
+	std::cerr << funame << "time evolution output failed\n";
+	throw Error::File();
+      }
+
+      continue;
+    }
+
+    // text output
+    out << "Pressure = " << profile[s].pressure << punit
+	<< "\t Temperature = " << profile[s].temperature / Phys_const::kelv << " K\n\n";
+
+    out << std::setw(13) << "time, sec";
+    for(int w = 0; w < well_size; ++w)
+      out << std::setw(13) << Model::well(w).name();
+
+    for(int p = 0; p < bim_size; ++p)
+      out << std::setw(13) << Model::bimolecular(p).name();
+    out << "\n";
+
+    for(int t = 0; t < block_size; ++t) {
+      out << std::setw(13) << block_time[t];
+
+      for(int i = 0; i < spec_size; ++i)
+	out << std::setw(13) << block_pop[t][i];
+
+      out << "\n";
+    }
+
+    out << "\n";
+  }
+
+  IO::log << IO::log_offset << "time evolution profile: " << profile.size() << " segments, "
+	  << cache.size() << " (T, P) points diagonalized, " << reuse << " reused\n";
+}
+
+namespace Server {
+  //
+  struct Point {
+    Sweep::RateMap             rate_coef;
+    Sweep::RateMap             hp_rate_coef;
+    MasterEquation::Partition  well_partition;
+  };
+
+  void run (Sweep::Setup& setup, int worker_size, const std::string& base_name, std::istream& from, std::ostream& to);
+
+  // evaluates the missing points
+  void evaluate (const Sweep::Setup& setup, int worker_size, const std::string& base_name,
+		 std::map<std::pair<double, double>, Point>& cache);
+
+  double pressure_factor ()
+  {
+    switch(MasterEquation::pressure_unit) {
+    case MasterEquation::BAR:
+      return Phys_const::bar;
+    case MasterEquation::TORR:
+      return Phys_const::tor;
+    case MasterEquation::ATM:
+      return Phys_const::atm;
+    }
+    return 1.;
+  }
+
+  // positive values until the end of the line
+  std::set<double> read_grid (std::istream& from, double factor)
+  {
+    const char funame [] = "Server::read_grid: ";
+
+    std::set<double> res;
+
+    double dtemp;
+    while(from >> dtemp) {
+      if(dtemp <= 0.) {
+	std::cerr << funame << "should be positive\n";
+	throw Error::Range();
+      }
+      res.insert(dtemp * factor);
+    }
+
+    if(!res.size()) {
+      std::cerr << funame << "no data\n";
+      throw Error::Input();
+    }
+
+    return res;
+  }
+
+  bool is_barrier (const std::string& name)
+  {
+    for(int b = 0; b < Model::inner_barrier_size(); ++b)
+      if(Model::inner_barrier(b).name() == name)
+	return true;
+
+    for(int b = 0; b < Model::outer_barrier_size(); ++b)
+      if(Model::outer_barrier(b).name() == name)
+	return true;
+
+    return false;
+  }
+}
+
+void Server::evaluate (const Sweep::Setup& setup, int worker_size, const std::string& base_name,
+		       std::map<std::pair<double, double>, Point>& cache)
+{
+  // the temperatures are grouped by the set of missing pressures and each group is one sweep
+  std::map<std::vector<double>, std::vector<double> > group;
+  for(int t = 0; t < setup.temperature.size(); ++t) {
+    std::vector<double> missing;
+    for(int p = 0; p < setup.pressure.size(); ++p)
+      if(cache.find(std::make_pair(setup.temperature[t], setup.pressure[p])) == cache.end())
+	missing.push_back(setup.pressure[p]);
+
+    if(missing.size())
+      group[missing].push_back(setup.temperature[t]);
+  }
+
+  for(std::map<std::vector<double>, std::vector<double> >::const_iterator g = group.begin(); g != group.end(); ++g) {
+    Sweep::Setup sub = setup;
+    sub.temperature = g->second;
+    sub.pressure    = g->first;
+
+    Sweep::Result res(sub.temperature.size(), sub.pressure.size());
+
+    if(worker_size > 1)
+      Sweep::run(sub, worker_size, base_name, res);
+    else
+      Sweep::run(sub, 0, sub.temperature.size() * sub.pressure.size(), res);
+
+    for(int t = 0; t < sub.temperature.size(); ++t)
+      for(int p = 0; p < sub.pressure.size(); ++p) {
+	const int point = p + t * sub.pressure.size();
+
+	Point& val = cache[std::make_pair(sub.temperature[t], sub.pressure[p])];
+	val.rate_coef      = res.rate_coef[point];
+	val.hp_rate_coef   = res.hp_rate_coef[t];
+	val.well_partition = res.well_partition[point];
+      }
+  }
+}
+
+void Server::run (Sweep::Setup& setup, int worker_size, const std::string& base_name, std::istream& from, std::ostream& to)
+{
+  const char funame [] = "Server::run: ";
+
+  KeyGroup ServerGroup;
+
+  Key     temp_key("TemperatureList[K]" );
+  Key bar_pres_key("PressureList[bar]"  );
+  Key tor_pres_key("PressureList[torr]" );
+  Key atm_pres_key("PressureList[atm]"  );
+  Key  add_pres_key("AddPressure"       );
+  Key    shift_key("ShiftBarrier"       );
+  Key     well_key("ShiftWell"          );
+  Key    close_key("CloseBarrier"       );
+  Key     open_key("OpenBarrier"        );
+  Key   kernel_key("ScaleKernel"        );
+  Key     buff_key("BufferFraction"     );
+  Key      run_key("Run"                );
+  Key     quit_key("Quit"               );
+
+  double      dtemp;
+  std::string stemp;
+
+  std::map<std::pair<double, double>, Point> cache;
+
+  std::set<double> data;
+
+  MasterEquation::resident_species = true;
+
+  // the eigenvectors are not passed between the sweep workers
+  MasterEquation::grid_warm_start = worker_size <= 1;
+
+  std::string line, token;
+  while(std::getline(from, line)) {
+    std::istringstream lin(line);
+    if(!(lin >> token) || token[0] == '!' || token[0] == '#')
+      continue;
+
+    try {
+      //
+      if(quit_key == token) {
+	to << "{\"status\": \"ok\"}" << std::endl;
+	break;
+      }
+      // temperature grid
+      else if(temp_key == token) {
+	data = read_grid(lin, Phys_const::kelv);
+	setup.temperature.assign(data.begin(), data.end());
+      }
+      // pressure grid
+      else if(bar_pres_key == token || tor_pres_key == token || atm_pres_key == token) {
+	if(bar_pres_key == token)
+	  MasterEquation::pressure_unit = MasterEquation::BAR;
+	if(tor_pres_key == token)
+	  MasterEquation::pressure_unit = MasterEquation::TORR;
+	if(atm_pres_key == token)
+	  MasterEquation::pressure_unit = MasterEquation::ATM;
+
+	data = read_grid(lin, pressure_factor());
+	setup.pressure.assign(data.begin(), data.end());
+      }
+      // pressure grid extension
+      else if(add_pres_key == token) {
+	data = read_grid(lin, pressure_factor());
+	data.insert(setup.pressure.begin(), setup.pressure.end());
+	setup.pressure.assign(data.begin(), data.end());
+      }
+      // barrier energy shift
+      else if(shift_key == token) {
+	if(!(lin >> stemp >> dtemp)) {
+	  std::cerr << funame << token << ": corrupted\n";
+	  throw Error::Input();
+	}
+
+	Model::shift_barrier(stemp, dtemp * Phys_const::kcal);
+	cache.clear();
+
+	// the cached states belong to the original model
+	MasterEquation::state_cache_dir.clear();
+	Sweep::rate_cache_dir.clear();
+      }
+      // well energy shift
+      else if(well_key == token) {
+	if(!(lin >> stemp >> dtemp)) {
+	  std::cerr << funame << token << ": corrupted\n";
+	  throw Error::Input();
+	}
+
+	Model::shift_well(stemp, dtemp * Phys_const::kcal);
+	cache.clear();
+
+	MasterEquation::state_cache_dir.clear();
+	Sweep::rate_cache_dir.clear();
+      }
+      // barrier closure
+      else if(close_key == token || open_key == token) {
+	if(!(lin >> stemp)) {
+	  std::cerr << funame << token << ": corrupted\n";
+	  throw Error::Input();
+	}
+
+	if(!is_barrier(stemp)) {
+	  std::cerr << funame << token << ": barrier " << stemp << " not found\n";
+	  throw Error::Input();
+	}
+
+	if(close_key == token)
+	  MasterEquation::closed_barrier.insert(stemp);
+	else
+	  MasterEquation::closed_barrier.erase(stemp);
+
+	cache.clear();
+	Sweep::rate_cache_dir.clear();
+      }
+      // energy transfer kernel
+      else if(kernel_key == token) {
+	if(!(lin >> dtemp)) {
+	  std::cerr << funame << token << ": corrupted\n";
+	  throw Error::Input();
+	}
+
+	Model::scale_kernel(dtemp);
+	cache.clear();
+
+	// the kernels do not show in the species energies
+	MasterEquation::clear_resident_species();
+      }
+      // buffer gas composition
+      else if(buff_key == token) {
+	std::vector<double> fraction;
+	while(lin >> dtemp)
+	  fraction.push_back(dtemp);
+
+	Model::set_buffer_fraction(fraction);
+	cache.clear();
+      }
+      // rate coefficients on the grid
+      else if(run_key == token) {
+	IO::Marker run_marker("server run");
+
+	const int old_size = cache.size();
+
+	evaluate(setup, worker_size, base_name, cache);
+
+	const int tsize = setup.temperature.size();
+	const int psize = setup.pressure.size();
+
+	Sweep::Result res(tsize, psize);
+	for(int t = 0; t < tsize; ++t)
+	  for(int p = 0; p < psize; ++p) {
+	    const Point& val = cache[std::make_pair(setup.temperature[t], setup.pressure[p])];
+
+	    res.rate_coef[p + t * psize]      = val.rate_coef;
+	    res.well_partition[p + t * psize] = val.well_partition;
+	    res.hp_rate_coef[t]               = val.hp_rate_coef;
+	  }
+
+	// the timing and the eigenvalue gap are not kept for the cached points
+	IO::stage_list.clear();
+	MasterEquation::eigenvalue_gap = -1.;
+	for(int point = 0; point < tsize * psize; ++point)
+	  Sweep::json_output(to, setup, point, res, std::numeric_limits<double>::quiet_NaN(),
+			     std::numeric_limits<double>::quiet_NaN());
+
+	to << "{\"status\": \"ok\", \"points\": " << tsize * psize
+	   << ", \"evaluated\": " << cache.size() - old_size << "}" << std::endl;
+	continue;
+      }
+      else {
+	std::cerr << funame << "unknown command: " << token << "\n";
+	throw Error::Input();
+      }
+
+      to << "{\"status\": \"ok\"}" << std::endl;
+    }
+    catch(Error::General) {
+      to << "{\"status\": \"error\", \"command\": " << Sweep::json_string(token) << "}" << std::endl;
+    }
+  }
+
+  IO::log << std::flush;
+}
+
+/********************************************************************************************
+ ************************************** ENSEMBLE MODE ***************************************
+ ********************************************************************************************/
+
+// uncertainty quantification ensemble: the members are the edits of the initialized model,
+// one member per line of the ensemble file (blank lines and # comments are skipped):
+//
+//   name  ShiftBarrier b1 de1  ShiftBarrier b2 de2  ScaleKernel factor  BufferFraction x1 x2 ...
+//
+// with the same meaning as in the server mode; the edits are relative to the nominal model,
+// which is restored after each member; the members are distributed over the worker processes
+// (SweepWorkerNumber), each member is evaluated on the (T, P) grid, and its result is one JSON
+// line {"member": name, "points": [...]} with the points objects of Sweep::json_output
+
+namespace Ensemble {
+  //
+  // model edits of one member
+  struct Member {
+    std::string                                   name;
+    std::vector<std::pair<std::string, double> >  shift;
+    double                                        kernel_factor;
+    std::vector<double>                           fraction;
+
+    Member () : kernel_factor(1.) {}
+
+    explicit Member (const std::string&);
+
+    void apply  () const;
+    void revert () const;
+  };
+
+  class MemberJob : public Batch::Job {
+    const Sweep::Setup& _setup;
+
+  public:
+    explicit MemberJob (const Sweep::Setup& s) : _setup(s) {}
+
+    void run (const std::string& input, std::ostream& to) const;
+  };
+
+  std::vector<std::string> read_members (const std::string& file);
+
+  void run (const Sweep::Setup&, int worker_size, const std::string& base_name, const std::string& file);
+}
+
+Ensemble::Member::Member (const std::string& line)
+  : kernel_factor(1.)
+{
+  const char funame [] = "Ensemble::Member::Member: ";
+
+  double      dtemp;
+  std::string stemp;
+
+  std::istringstream from(line);
+
+  if(!(from >> name)) {
+    std::cerr << funame << "no member name\n";
+    throw Error::Input();
+  }
+
+  std::string token;
+  while(from >> token) {
+    //
+    if(token == "ShiftBarrier") {
+      if(!(from >> stemp >> dtemp)) {
+	std::cerr << funame << name << ": " << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      shift.push_back(std::make_pair(stemp, dtemp * Phys_const::kcal));
+    }
+    else if(token == "ScaleKernel") {
+      if(!(from >> dtemp)) {
+	std::cerr << funame << name << ": " << token << ": corrupted\n";
+	throw Error::Input();
+      }
+
+      if(dtemp <= 0.) {
+	std::cerr << funame << name << ": " << token << ": should be positive\n";
+	throw Error::Range();
+      }
+      kernel_factor *= dtemp;
+    }
+    else if(token == "BufferFraction") {
+      fraction.resize(Model::buffer_size());
+      for(int i = 0; i < fraction.size(); ++i)
+	if(!(from >> fraction[i])) {
+	  std::cerr << funame << name << ": " << token << ": corrupted\n";
+	  throw Error::Input();
+	}
+    }
+    else {
+      std::cerr << funame << name << ": unknown edit: " << token << "\n";
+      throw Error::Input();
+    }
+  }
+}
+
+void Ensemble::Member::apply () const
+{
+  for(int i = 0; i < shift.size(); ++i)
+    Model::shift_barrier(shift[i].first, shift[i].second);
+
+  if(kernel_factor != 1.)
+    Model::scale_kernel(kernel_factor);
+
+  if(fraction.size())
+    Model::set_buffer_fraction(fraction);
+}
+
+void Ensemble::Member::revert () const
+{
+  for(int i = shift.size() - 1; i >= 0; --i)
+    Model::shift_barrier(shift[i].first, -shift[i].second);
+
+  if(kernel_factor != 1.)
+    Model::scale_kernel(1. / kernel_factor);
+}
+
+void Ensemble::MemberJob::run (const std::string& input, std::ostream& to) const
+{
+  const Member member(input);
+
+  // nominal buffer gas composition
+  std::vector<double> fraction(Model::buffer_size());
+  for(int i = 0; i < fraction.size(); ++i)
+    fraction[i] = Model::buffer_fraction(i);
+
+  IO::Marker member_marker(("ensemble member " + member.name).c_str());
+
+  const int point_size = _setup.temperature.size() * _setup.pressure.size();
+
+  Sweep::Result res(_setup.temperature.size(), _setup.pressure.size());
+
+  member.apply();
+
+  try {
+    Sweep::run(_setup, 0, point_size, res);
+  }
+  catch(...) {
+    member.revert();
+    Model::set_buffer_fraction(fraction);
+    throw;
+  }
+
+  member.revert();
+  Model::set_buffer_fraction(fraction);
+
+  // the timing and the eigenvalue gap are not kept for the points
+  IO::stage_list.clear();
+  MasterEquation::eigenvalue_gap = -1.;
+
+  to << "{\"member\": " << Sweep::json_string(member.name) << ", \"points\": [";
+  for(int point = 0; point < point_size; ++point) {
+    std::ostringstream obj;
+    Sweep::json_output(obj, _setup, point, res, std::numeric_limits<double>::quiet_NaN(),
+		       std::numeric_limits<double>::quiet_NaN());
+
+    std::string line = obj.str();
+    while(line.size() && line[line.size() - 1] == '\n')
+      line.resize(line.size() - 1);
+
+    to << (point ? ", " : "") << line;
+  }
+  to << "]}";
+}
+
+std::vector<std::string> Ensemble::read_members (const std::string& file)
+{
+  const char funame [] = "Ensemble::read_members: ";
+
+  std::ifstream from(file.c_str());
+  if(!from) {
+    std::cerr << funame << "cannot open " << file << " file\n";
+    throw Error::Input();
+  }
+
+  std::vector<std::string> res;
+  std::string line, name;
+  while(std::getline(from, line)) {
+    std::istringstream lin(line);
+    if(!(lin >> name) || name[0] == '#')
+      continue;
+
+    // the edits are checked before the run
+    Member test(line);
+    res.push_back(line);
+  }
+
+  if(!res.size()) {
+    std::cerr << funame << file << ": no members\n";
+    throw Error::Input();
+  }
+
+  return res;
+}
+
+void Ensemble::run (const Sweep::Setup& setup, int worker_size, const std::string& base_name, const std::string& file)
+{
+  const char funame [] = "Ensemble::run: ";
+
+  std::vector<std::string> member = read_members(file);
+
+  const std::string name = base_name + ".ensemble.json";
+
+  std::ofstream to(name.c_str());
+  if(!to) {
+    std::cerr << funame << "cannot open " << name << " file\n";
+    throw Error::Input();
+  }
+
+  IO::Marker ensemble_marker("ensemble run");
+
+  IO::log << IO::log_offset << "number of members = " << member.size() << "\n";
+
+  // the cached states and rates belong to the nominal model
+  MasterEquation::state_cache_dir.clear();
+  Sweep::rate_cache_dir.clear();
+
+  // the JSON lines are written by the members
+  Sweep::rate_json_hold = true;
+
+  Batch::run(MemberJob(setup), member, worker_size, base_name, to);
+
+  Sweep::rate_json_hold = false;
+}
+
+/********************************************************************************************
+ ************************************** RATE FITTING ****************************************
+ ********************************************************************************************/
+
+// Chebyshev and PLOG fits of the pressure dependent rate coefficients of each channel in the
+// Chemkin format: pressure in atm, activation energy in cal/mol, bimolecular rate coefficients
+// in cm^3/mol/sec; the largest deviations of the fits from the calculated rate coefficients
+// are reported to show where the temperature-pressure grid should be refined
+
+void rate_fit_output (std::ostream& to, const std::vector<double>& temperature, const std::vector<double>& pressure,
+		      const Sweep::Result& res, int cheb_tsize, int cheb_psize)
+{
+  const int spec_size = Model::well_size() + Model::bimolecular_size();
+  const int tsize     = temperature.size();
+  const int psize     = pressure.size();
+
+  std::vector<double> temp(tsize), pres(psize);
+  for(int t = 0; t < tsize; ++t)
+    temp[t] = temperature[t] / Phys_const::kelv;
+  for(int p = 0; p < psize; ++p)
+    pres[p] = pressure[p] / Phys_const::atm;
+
+  // default orders
+  if(cheb_tsize <= 0)
+    cheb_tsize = 6;
+  if(cheb_psize <= 0)
+    cheb_psize = 4;
+
+  if(cheb_tsize > tsize)
+    cheb_tsize = tsize;
+  if(cheb_psize > psize)
+    cheb_psize = psize;
+
+  // calories per temperature unit
+  const double cal = Phys_const::kelv / Phys_const::kcal * 1000.;
+
+  to << "! pressure dependent rate coefficients fits: pressure in atm, activation energy in cal/mol, "
+     << "bimolecular rate coefficients in cm^3/mol/sec\n"
+     << "! fit deviations are given as the maximal |log10(k_fit / k)| over the temperature-pressure grid\n\n";
+
+  std::ostringstream cheb_out, plog_out;
+  cheb_out << std::setprecision(8);
+  plog_out << std::setprecision(8);
+
+  for(int i = 0; i < spec_size; ++i)
+    for(int j = 0; j < spec_size + Model::well_size(); ++j) {
+      if(j == i || j >= spec_size && !Model::well(j - spec_size).escape())
+	continue;
+
+      const std::pair<int, int> proc(i, j);
+
+      std::string name = i < Model::well_size() ? Model::well(i).name() : Model::bimolecular(i - Model::well_size()).name();
+      name += "=>";
+      if(j < Model::well_size())
+	name += Model::well(j).name();
+      else if(j < spec_size)
+	name += Model::bimolecular(j - Model::well_size()).name();
+      else
+	name += "Escape[" + Model::well(j - spec_size).name() + "]";
+
+      const double factor = i < Model::well_size() ? 1. : Phys_const::avogadro;
+
+      // rate coefficients natural logarithms
+      Lapack::Matrix log_rate(tsize, psize);
+
+      bool isfit = true;
+      for(int t = 0; t < tsize && isfit; ++t)
+	for(int p = 0; p < psize; ++p) {
+	  const Sweep::RateMap& rate = res.rate_coef[p + t * psize];
+	  Sweep::RateMap::const_iterator it = rate.find(proc);
+	  if(it == rate.end() || it->second <= 0.) {
+	    isfit = false;
+	    break;
+	  }
+	  log_rate(t, p) = std::log(it->second * factor);
+	}
+
+      if(!isfit) {
+	cheb_out << "! " << name << ": not fitted: missing or non-positive rate coefficients\n\n";
+	plog_out << "! " << name << ": not fitted: missing or non-positive rate coefficients\n\n";
+	continue;
+      }
+
+      double dtemp;
+      int tmax = 0, pmax = 0;
+
+      // Chebyshev expansion
+      RateFit::Chebyshev cheb(temp, pres, log_rate, cheb_tsize, cheb_psize);
+
+      double dev = -1.;
+      for(int t = 0; t < tsize; ++t)
+	for(int p = 0; p < psize; ++p) {
+	  dtemp = std::fabs(cheb(temp[t], pres[p]) - log_rate(t, p)) / M_LN10;
+	  if(dtemp > dev) {
+	    dev  = dtemp;
+	    tmax = t;
+	    pmax = p;
+	  }
+	}
+
+      cheb_out << "! " << name << ": deviation = " << dev
+	       << " at T = " << temp[tmax] << " K, P = " << pres[pmax] << " atm\n"
+	       << name << "    1.0    0.0    0.0\n"
+	       << "    TCHEB / " << cheb.tmin() << " " << cheb.tmax() << " /\n"
+	       << "    PCHEB / " << cheb.pmin() << " " << cheb.pmax() << " /\n"
+	       << "    CHEB / " << cheb_tsize << " " << cheb_psize << " /\n";
+
+      // log10 coefficients
+      for(int n = 0; n < cheb_tsize; ++n) {
+	cheb_out << "    CHEB /";
+	for(int m = 0; m < cheb_psize; ++m)
+	  cheb_out << " " << std::setw(16) << cheb.coef()(n, m) / M_LN10;
+	cheb_out << " /\n";
+      }
+      cheb_out << "\n";
+
+      // PLOG: modified Arrhenius expression at each pressure
+      std::vector<RateFit::Arrhenius> arr;
+      dev  = -1.;
+      tmax = 0;
+      pmax = 0;
+      for(int p = 0; p < psize; ++p) {
+	std::vector<double> lr(tsize);
+	for(int t = 0; t < tsize; ++t)
+	  lr[t] = log_rate(t, p);
+
+	arr.push_back(RateFit::Arrhenius(temp, lr));
+
+	for(int t = 0; t < tsize; ++t) {
+	  dtemp = std::fabs(arr.back()(temp[t]) - lr[t]) / M_LN10;
+	  if(dtemp > dev) {
+	    dev  = dtemp;
+	    tmax = t;
+	    pmax = p;
+	  }
+	}
+      }
+
+      plog_out << "! " << name << ": deviation = " << dev
+	       << " at T = " << temp[tmax] << " K, P = " << pres[pmax] << " atm\n"
+	       << name
+	       << " " << std::setw(16) << arr.back().factor()
+	       << " " << std::setw(10) << arr.back().power()
+	       << " " << std::setw(12) << arr.back().energy() * cal << "\n";
+
+      for(int p = 0; p < psize; ++p)
+	plog_out << "    PLOG / " << std::setw(12) << pres[p]
+		 << " " << std::setw(16) << arr[p].factor()
+		 << " " << std::setw(10) << arr[p].power()
+		 << " " << std::setw(12) << arr[p].energy() * cal << " /\n";
+      plog_out << "\n";
+    }
+
+  to << "! CHEBYSHEV FITS\n\n" << cheb_out.str()
+     << "! PLOG FITS\n\n"      << plog_out.str();
+}
+
+// batch mode: many small independent inputs, listed in the Batch::read_manifest format, are run
+// by the pool of the worker processes forked from the master process after its start up; unlike
+// Batch::run, the model is initialized by the input itself, so each worker takes one input, with
+// one thread unless the input sets the thread number, and writes the usual output of the input
+//
+namespace InputPool {
+  //
+  std::vector<std::string> input;
+
+  // in the worker process returns the index of its input, in the master process -1
+  // after all inputs are done; fail is the number of the failed inputs
+  int run (int worker_size, int& fail);
+}
+
+int InputPool::run (int worker_size, int& fail)
+{
+  const char funame [] = "InputPool::run: ";
+
+  fail = 0;
+
+  std::map<pid_t, int> active;
+
+  for(int i = 0; i < input.size() || active.size(); ) {
+    // launch as many workers as allowed
+    if(i < input.size() && active.size() < worker_size) {
+      std::cout.flush();
+      std::cerr.flush();
+
+      pid_t pid = fork();
 
+      if(pid < 0) {
+	std::cerr << funame << "fork failed\n";
+	throw Error::Run();
+      }
+
+      // worker
+      if(!pid) {
+	Threads::init(1);
+	return i;
+      }
+
+      active[pid] = i++;
+      continue;
+    }
+
+    // wait for any worker
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if(pid < 0) {
+      std::cerr << funame << "waitpid failed\n";
+      throw Error::Run();
+    }
+
+    std::map<pid_t, int>::iterator it = active.find(pid);
+    if(it == active.end())
+      continue;
+
+    if(!WIFEXITED(status) || WEXITSTATUS(status)) {
+      std::cerr << funame << input[it->second] << ": failed\n";
+      ++fail;
+    }
+
+    active.erase(it);
+  }
+
+  return -1;
+}
+
+// output file name: in the distributed memory run only the master process writes the output
+//
+std::string output_name (const std::string& name)
+{
+  return IO::mpi_rank ? std::string("/dev/null") : name;
+}
+
+#ifdef MESS_LIBRARY
+int Api::driver (int argc, char* argv [])
+#else
 int main (int argc, char* argv [])
+#endif
 {
   const char funame [] = "master_equation: ";
 
   if (argc < 2) {
-    std::cout << "usage: mess input_file\n";
+    std::cout << "usage: mess input_file\n"
+	      << "       mess -batch worker_number batch_file\n";
     return 0;
   }
 
+  const char* input_name = argv[1];
+
+  // batch mode
+  if(std::string(argv[1]) == "-batch") {
+#if defined(WITH_SCALAPACK) || defined(MESS_LIBRARY)
+    std::cerr << funame << "batch mode is not available in this build\n";
+    return 1;
+#else
+    int worker_size;
+    if(argc < 4 || !(std::istringstream(argv[2]) >> worker_size) || worker_size < 1) {
+      std::cout << "usage: mess -batch worker_number batch_file\n";
+      return 1;
+    }
+
+    int i, fail;
+    try {
+      InputPool::input = Batch::read_manifest(argv[3]);
+
+      i = InputPool::run(worker_size, fail);
+    }
+    catch(Error::General) {
+      return 1;
+    }
+
+    // master
+    if(i < 0) {
+      std::cout << "batch: " << InputPool::input.size() << " inputs, " << fail << " failed\n";
+      return fail ? 1 : 0;
+    }
+
+    input_name = InputPool::input[i].c_str();
+#endif
+  }
+
+#ifdef WITH_SCALAPACK
+
+  MPI_Init(&argc, &argv);
+  MPI_Comm_rank(MPI_COMM_WORLD, &IO::mpi_rank);
+
+#endif
+
   int                 itemp;
   double              dtemp;
   bool                btemp;
@@ -55,6 +2278,7 @@ int main (int argc, char* argv [])
   Key ref_incm_key("ReferenceEnergy[1/cm]"      );
   Key ref_kcal_key("ReferenceEnergy[kcal/mol]"  );
   Key   ref_kj_key("ReferenceEnergy[kJ/mol]"    );
+  Key     tail_key("BoltzmannTailTolerance"     );
   Key cut_kcal_key("GlobalCutoff[kcal/mol]"     );
   Key cut_incm_key("GlobalCutoff[1/cm]"         );
   Key   cut_kj_key("GlobalCutoff[kJ/mol]"       );
@@ -65,6 +2289,7 @@ int main (int argc, char* argv [])
   Key well_cut_key("WellCutoff"                 );
   Key eval_max_key("ChemicalEigenvalueMax"      );
   Key eval_min_key("ChemicalEigenvalueMin"      );
+  Key  sep_chk_key("ChemicalSeparationCheck"    );
   Key well_red_key("WellReductionThreshold"     );
   Key     calc_key("CalculationMethod"          );
   Key  rat_red_key("ReductionMethod"            );
@@ -78,6 +2303,20 @@ int main (int argc, char* argv [])
   Key  red_out_key("ReductionNumber"            );
   Key ped_spec_key("PEDSpecies"                 );
   Key  ped_out_key("PEDOutput"                  );
+  Key  ped_tol_key("PEDRelaxationTolerance"     );
+  Key sens_out_key("SensitivityOutput"          );
+  Key spec_fmt_key("SpectralOutputFormat"       );
+  Key json_out_key("StructuredRateOutput"       );
+  Key  mem_lim_key("MemoryLimit[GB]"            );
+  Key  mem_pol_key("MemoryPolicy"               );
+  Key grid_cnv_key("EnergyGridConvergence"      );
+  Key grid_wst_key("EnergyGridWarmStart"        );
+  Key  thr_num_key("ThreadNumber"               );
+  Key blas_num_key("BlasThreadNumber"           );
+  Key thr_bind_key("ThreadBinding"              );
+  Key prof_out_key("ProfileOutput"              );
+  Key  fit_out_key("RateFitOutput"              );
+  Key cheb_ord_key("ChebyshevOrder"             );
   Key    react_key("Reactant"                   );
   Key  def_red_key("DefaultReductionScheme"     );
   Key def_chem_key("DefaultChemicalSize"        );
@@ -91,6 +2330,30 @@ int main (int argc, char* argv [])
   Key mic_step_key("MicroEnerStep[kcal/mol]"    );
   Key tim_evol_key("TimeEvolution"              );
   Key       sl_key("StateLandscape"             );
+  Key    sweep_key("SweepWorkerNumber"          );
+  Key  eig_sol_key("GlobalEigenSolver"          );
+  Key chem_pre_key("ChemicalEigenPrecision"     );
+  Key  crm_sol_key("RelaxationModesSolver"      );
+  Key  crm_pre_key("RelaxationModesPrecision"   );
+  Key      gpu_key("GpuMatrixSizeMin"           );
+  Key  inc_pre_key("IncrementalPressureSweep"   );
+  Key    cache_key("StateCacheDirectory"        );
+  Key   rcache_key("MultiRotorCacheDirectory"   );
+  Key escratch_key("EigenvectorScratchDirectory");
+  Key   scache_key("RotorCacheDirectory"        );
+  Key   gcache_key("GraphCacheDirectory"        );
+  Key  rtcache_key("RateCacheDirectory"         );
+  Key   gdbmem_key("GraphDatabaseMemory[MB]"    );
+  Key   gspill_key("GraphDatabaseSpillDirectory");
+  Key  wps_max_key("WellPartitionNodeMax"       );
+  Key grid_fac_key("AdaptiveEnergyGridFactor"   );
+  Key res_kcal_key("ReservoirStateOffset[kcal/mol]");
+  Key decouple_key("NetworkDecouplingThreshold" );
+  Key rb_tol_key("ReducedBasisTolerance"        );
+  Key rb_size_key("ReducedBasisSnapshots"       );
+  Key   server_key("ServerMode"                 );
+  Key ensemble_key("EnsembleInput"              );
+  Key  hp_only_key("HighPressureOnly"           );
 
   std::vector<std::string> ped_spec;// product energy distribution pairs verbal
   std::vector<std::string> reduction_scheme;
@@ -101,27 +2364,45 @@ int main (int argc, char* argv [])
   double xtot   = -1.; // exsess energy over temperature
   double eref;
   bool iseref = false;
+  double tail_tol = -1.; // Boltzmann tail tolerance of the energy reference
   MasterEquation::Method method = MasterEquation::direct_diagonalization_method;
+  std::string       method_name = "direct";
   std::string micro_rate_file;
   double micro_ener_max  = 0.;
   double micro_ener_min  = 0.;
   double micro_ener_step = -1.;
   std::string state_landscape;
 
+  std::ofstream fit_out; // Chebyshev and PLOG fits
+  int cheb_tsize = -1, cheb_psize = -1; // Chebyshev expansion orders
+  int sweep_worker_size = 1; // number of worker processes for the temperature-pressure sweep
+
+  double memory_limit  = -1.; // memory pre-flight limit, physical memory by default
+  int    memory_policy = Sweep::MEMORY_WARN;
+
+  double grid_tolerance = -1.; // energy grid convergence tolerance, no convergence if not positive
+  int    grid_level_max =  4;  // maximal number of the energy grid refinements
+  bool   grid_warm_start = false; // finer grid eigensolves start from the coarser grid eigenvectors
+
+  bool server_mode = false; // commands from the standard input after the model initialization
+  std::string ensemble_file; // uncertainty quantification ensemble members, one per line
+
+  bool high_pressure_only = false; // high pressure rate coefficients only, no master equation
+
   // base name
-  std::string base_name = argv[1];
+  std::string base_name = input_name;
   if(base_name.size() >= 4 && !base_name.compare(base_name.size() - 4, 4, ".inp", 4))
     base_name.resize(base_name.size() - 4);
 
-  IO::KeyBufferStream from(argv[1]);
-  if(!from && base_name == argv[1]) {
+  IO::KeyBufferStream from(input_name);
+  if(!from && base_name == input_name) {
     // try inp extension
     stemp = base_name + ".inp";
     from.open(stemp.c_str());
   }
 
   if(!from) {
-    std::cerr << funame << "input file " << argv[1] << " is not found\n";
+    std::cerr << funame << "input file " << input_name << " is not found\n";
     return 1;
   }
 
@@ -132,7 +2413,7 @@ int main (int argc, char* argv [])
       // default log output	
       if(!IO::log.is_open()) {
 	stemp = base_name + ".log";
-	IO::log.open(stemp.c_str());
+	IO::log.open(output_name(stemp).c_str());
 	if(!IO::log) {
 	  std::cerr << funame << token << ": cannot open " << stemp << " file\n";
 	  throw Error::Input();
@@ -142,7 +2423,7 @@ int main (int argc, char* argv [])
       // default rate output
       if(!IO::out.is_open()) {
 	stemp = base_name + ".out";
-	IO::out.open(stemp.c_str());
+	IO::out.open(output_name(stemp).c_str());
 	if(!IO::out) {
 	  std::cerr << funame << token << ": cannot open " << stemp << " file\n";
 	  throw Error::Input();
@@ -155,6 +2436,37 @@ int main (int argc, char* argv [])
 	throw Error::Init();
       }
 
+      // the rest of the input identifies the state cache entries
+      if(MasterEquation::state_cache_dir.size()) {
+	std::streampos model_pos = from.tellg();
+	std::ostringstream model_text;
+	model_text << from.rdbuf();
+	MasterEquation::state_cache_model = model_text.str();
+	from.clear();
+	from.seekg(model_pos);
+      }
+
+      // the settings read so far, the rate cache directory included, and the model identify the rate cache entries
+      if(Sweep::rate_cache_dir.size()) {
+	std::streampos model_pos = from.tellg();
+
+	from.seekg(0);
+	std::string settings((std::size_t)model_pos, ' ');
+	from.read(&settings[0], settings.size());
+
+	std::istringstream settings_in(settings);
+	while(std::getline(settings_in, line))
+	  if(!Sweep::rate_cache_ignore(line))
+	    Sweep::rate_cache_input += line + "\n";
+
+	std::ostringstream model_text;
+	model_text << from.rdbuf();
+	Sweep::rate_cache_input += model_text.str();
+
+	from.clear();
+	from.seekg(model_pos);
+      }
+
       // main initialization
       try {
 	Model::init(from);
@@ -177,12 +2489,72 @@ int main (int argc, char* argv [])
       }
       std::getline(from, comment);
 
-      IO::out.open(stemp.c_str());
+      IO::out.open(output_name(stemp).c_str());
       if(!IO::out) {
         std::cerr << funame << token << ": cannot open " << stemp << " file\n";
         throw Error::Input();
       }
     }
+    // rate coefficients fits output
+    else if(fit_out_key == token) {
+      if(fit_out.is_open()) {
+        std::cerr << funame << token << ": allready opened\n";
+        throw Error::Init();
+      }      
+      if(!(from >> stemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      fit_out.open(output_name(stemp).c_str());
+      if(!fit_out) {
+        std::cerr << funame << token << ": cannot open " << stemp << " file\n";
+        throw Error::Input();
+      }
+    }
+    // Chebyshev expansion orders in temperature and pressure
+    else if(cheb_ord_key == token) {
+      if(!(from >> cheb_tsize >> cheb_psize)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(cheb_tsize <= 0 || cheb_psize <= 0) {
+        std::cerr << funame << token << ": out of range\n";
+        throw Error::Range();
+      }
+    }
+    // structured rate output
+    else if(json_out_key == token) {
+      if(Sweep::rate_json.is_open()) {
+        std::cerr << funame << token << ": allready opened\n";
+        throw Error::Init();
+      }      
+      if(!(from >> stemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      Sweep::rate_json.open(output_name(stemp).c_str());
+      if(!Sweep::rate_json) {
+        std::cerr << funame << token << ": cannot open " << stemp << " file\n";
+        throw Error::Input();
+      }
+      IO::stage_record = true;
+    }
+    // profile of the marked stages
+    else if(prof_out_key == token) {
+      if(!(from >> stemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      IO::profile_open(output_name(stemp));
+    }
     // log output
     else if(log_out_key == token) {
       if(IO::log.is_open()) {
@@ -195,7 +2567,7 @@ int main (int argc, char* argv [])
       }
       std::getline(from, comment);
 
-      IO::log.open(stemp.c_str());
+      IO::log.open(output_name(stemp).c_str());
       if(!IO::log) {
         std::cerr << funame << token << ": cannot open " << stemp << " file\n";
         throw Error::Input();
@@ -213,12 +2585,30 @@ int main (int argc, char* argv [])
       }
       std::getline(from, comment);
 
-      MasterEquation::eval_out.open(stemp.c_str());
+      MasterEquation::eval_out.open(output_name(stemp).c_str());
       if(!MasterEquation::eval_out) {
         std::cerr << funame << token << ": cannot open " << stemp << " file\n";
         throw Error::Input();
       }
     }
+    // barrier energy sensitivities output
+    else if(sens_out_key == token) {
+      if(MasterEquation::sens_out.is_open()) {
+        std::cerr << funame << token << ": allready opened\n";
+        throw Error::Init();
+      }      
+      if(!(from >> stemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      MasterEquation::sens_out.open(output_name(stemp).c_str());
+      if(!MasterEquation::sens_out) {
+        std::cerr << funame << token << ": cannot open " << stemp << " file\n";
+        throw Error::Input();
+      }
+    }
     // eigenvector output
     else if(evec_out_key == token) {
       if(MasterEquation::evec_out.is_open()) {
@@ -231,7 +2621,7 @@ int main (int argc, char* argv [])
       }
       std::getline(from, comment);
 
-      MasterEquation::evec_out.open(stemp.c_str());
+      MasterEquation::evec_out.open(output_name(stemp).c_str());
       if(!MasterEquation::evec_out) {
         std::cerr << funame << token << ": cannot open " << stemp << " file\n";
         throw Error::Input();
@@ -247,12 +2637,25 @@ int main (int argc, char* argv [])
 	std::cerr << funame << token << ": corrupted\n";
 	throw Error::Input();
       }
-      MasterEquation::ped_out.open(stemp.c_str());
+      MasterEquation::ped_out.open(output_name(stemp).c_str());
       if(!MasterEquation::ped_out.is_open()) {
 	std::cerr << funame << token << ": cannot open the " << stemp << " file\n";
 	throw Error::Open();
       }
     }
+    // relaxation modes truncation of the product energy distributions
+    else if(ped_tol_key == token) {
+      if(!(from >> MasterEquation::ped_tolerance)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(MasterEquation::ped_tolerance < 0. || MasterEquation::ped_tolerance >= 1.) {
+	std::cerr << funame << token << ": out of range\n";
+	throw Error::Range();
+      }
+    }
     // reactants and products for product energy distribution output
     else if(ped_spec_key == token) {
       IO::LineInput ped_input(from);
@@ -433,6 +2836,19 @@ int main (int argc, char* argv [])
 
       MasterEquation::set_global_cutoff(dtemp);
     }
+    // Boltzmann tail tolerance of the energy reference
+    else if(tail_key == token) {
+      if(!(from >> tail_tol)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(tail_tol <= 0. || tail_tol >= 1.) {
+	std::cerr << funame << token << ": out of range: should be between 0 and 1\n";
+	throw Error::Range();
+      }
+    }
     // model energy limit
     else if(emax_key == token) {
       if(!(from >> dtemp)) {
@@ -470,7 +2886,7 @@ int main (int argc, char* argv [])
       std::getline(from, comment);
 
       if(dtemp <= 0.) {
-        std::cerr << funame << token << ": should be positive\n";
+        std::cerr << funame << token << ": out of range\n";
         throw Error::Range();
       }
 
@@ -484,14 +2900,22 @@ int main (int argc, char* argv [])
       }
       std::getline(from, comment);
 
+      method_name = stemp;
+
       if(stemp == "direct")
 	method = MasterEquation::direct_diagonalization_method;
+      else if(stemp == "banded")
+	method = MasterEquation::banded_diagonalization_method;
       else if(stemp == "low-eigenvalue")
 	method = MasterEquation::low_eigenvalue_method;
       else if(stemp == "well-reduction")
 	method = MasterEquation::well_reduction_method;
+      else if(stemp == "auto")
+	method = MasterEquation::automatic_method;
+      else if(stemp == "sequential")
+	method = MasterEquation::sequential_method;
       else {
-        std::cerr << funame << token << ": unknown method: " << stemp << ": available methods: direct, low-eigenvalue, well-reduction\n";
+        std::cerr << funame << token << ": unknown method: " << stemp << ": available methods: direct, banded, low-eigenvalue, well-reduction, auto, sequential\n";
 	throw Error::Input();
       }
     }
@@ -504,7 +2928,7 @@ int main (int argc, char* argv [])
       std::getline(from, comment);
 
       if(MasterEquation::rate_max <= 0.) {
-        std::cerr << funame << token << ": should be positive\n";
+        std::cerr << funame << token << ": out of range\n";
         throw Error::Range();
       }
 
@@ -519,7 +2943,7 @@ int main (int argc, char* argv [])
       std::getline(from, comment);
 
       if(MasterEquation::well_cutoff <= 0.) {
-        std::cerr << funame << token << ": should be positive\n";
+        std::cerr << funame << token << ": out of range\n";
         throw Error::Range();
       }
     }
@@ -552,6 +2976,19 @@ int main (int argc, char* argv [])
         throw Error::Range();
       }
     }
+    // early separation check of the low-eigenvalue method
+    else if(sep_chk_key == token) {
+      if(!(from >> MasterEquation::separation_check)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(MasterEquation::separation_check <= 0.) {
+        std::cerr << funame << token << ": should be positive\n";
+        throw Error::Range();
+      }
+    }
     // number of closest reductions to print
     else if(red_out_key == token) {
       if(!(from >> MasterEquation::red_out_num)) {
@@ -583,18 +3020,277 @@ int main (int argc, char* argv [])
         throw Error::Range();
       }
     }
-    // well partition method
-    else if(wpm_key == token) {
-      if(!(from >> stemp)) {
+    // global relaxation matrix eigensolver
+    else if(eig_sol_key == token) {
+      if(!(from >> stemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(stemp == "full")
+	MasterEquation::eigensolver = MasterEquation::FULL_SPECTRUM;
+      else if(stemp == "partial")
+	MasterEquation::eigensolver = MasterEquation::PARTIAL_SPECTRUM;
+      else if(stemp == "iterative")
+	MasterEquation::eigensolver = MasterEquation::ITERATIVE_SPECTRUM;
+      else {
+        std::cerr << funame << token << ": unknown eigensolver: " << stemp 
+		  << "; available eigensolvers: full, partial, iterative\n";
+        throw Error::Range();
+      }
+    }
+    // chemical eigenpairs precision
+    else if(chem_pre_key == token) {
+      if(!(from >> stemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(stemp == "double")
+	MasterEquation::chemical_precision = MasterEquation::DOUBLE_PRECISION;
+      else if(stemp == "refined")
+	MasterEquation::chemical_precision = MasterEquation::REFINED_PRECISION;
+#ifdef WITH_MPACK
+      else if(stemp == "mpack")
+	MasterEquation::chemical_precision = MasterEquation::MULTIPLE_PRECISION;
+#endif
+      else {
+        std::cerr << funame << token << ": unknown precision: " << stemp 
+#ifdef WITH_MPACK
+		  << "; available precisions: double, refined, mpack\n";
+#else
+		  << "; available precisions: double, refined (mpack requires the MPACK build)\n";
+#endif
+        throw Error::Range();
+      }
+    }
+    // eigenvalue, eigenvector, and product energy distribution output format
+    else if(spec_fmt_key == token) {
+      if(!(from >> stemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(stemp == "text")
+	IO::binary_record = false;
+      else if(stemp == "binary")
+	IO::binary_record = true;
+      else {
+        std::cerr << funame << token << ": unknown format: " << stemp 
+		  << "; available formats: text, binary\n";
+        throw Error::Range();
+      }
+    }
+    // low-eigenvalue method relaxation modes solver
+    else if(crm_sol_key == token) {
+      if(!(from >> stemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(stemp == "cholesky")
+	MasterEquation::crm_solver = MasterEquation::CHOLESKY_SOLVER;
+      else if(stemp == "spectral")
+	MasterEquation::crm_solver = MasterEquation::SPECTRAL_SOLVER;
+      else if(stemp == "block")
+	MasterEquation::crm_solver = MasterEquation::BLOCK_SOLVER;
+      else {
+        std::cerr << funame << token << ": unknown solver: " << stemp 
+		  << "; available solvers: cholesky, spectral, block\n";
+        throw Error::Range();
+      }
+    }
+    // spectral relaxation modes solver precision
+    else if(crm_pre_key == token) {
+      if(!(from >> stemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(stemp == "double")
+	MasterEquation::crm_precision = MasterEquation::DOUBLE_PRECISION;
+      else if(stemp == "single")
+	MasterEquation::crm_precision = MasterEquation::SINGLE_PRECISION;
+      else {
+        std::cerr << funame << token << ": unknown precision: " << stemp 
+		  << "; available precisions: double, single\n";
+        throw Error::Range();
+      }
+    }
+    // reuse of the pressure independent global matrices
+    else if(inc_pre_key == token) {
+      if(!(from >> stemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(stemp == "on")
+	MasterEquation::incremental_pressure = true;
+      else if(stemp == "off")
+	MasterEquation::incremental_pressure = false;
+      else {
+        std::cerr << funame << token << ": unknown value: " << stemp << "; available values: on, off\n";
+        throw Error::Range();
+      }
+    }
+    // wells, barriers, and bimolecular species cache directory
+    else if(cache_key == token) {
+      if(!(from >> MasterEquation::state_cache_dir)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+    }
+    // global eigenvectors scratch directory
+    else if(escratch_key == token) {
+      if(!(from >> MasterEquation::eigen_scratch_dir)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+    }
+    // MultiRotor quantum states cache directory
+    else if(rcache_key == token) {
+      if(!(from >> Model::multirotor_cache_dir)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+    }
+    // hindered rotor and umbrella mode spectra cache directory
+    else if(scache_key == token) {
+      if(!(from >> Model::rotor_cache_dir)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+    }
+    // generic graphs and graph integrals cache directory
+    else if(gcache_key == token) {
+      if(!(from >> Graph::cache_dir)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+    }
+    // (T, P) point results cache directory
+    else if(rtcache_key == token) {
+      if(!(from >> Sweep::rate_cache_dir)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+    }
+    // graph value databases memory budget
+    else if(gdbmem_key == token) {
+      if(!(from >> dtemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      if(dtemp <= 0.) {
+        std::cerr << funame << token << ": out of range\n";
+        throw Error::Range();
+      }
+      Graph::Expansion::db_mem_max = (long)(dtemp * 1024. * 1024.);
+      std::getline(from, comment);
+    }
+    // graph value databases spill directory
+    else if(gspill_key == token) {
+      if(!(from >> Graph::Expansion::spill_dir)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+    }
+    // well partition method
+    else if(wpm_key == token) {
+      if(!(from >> stemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      MasterEquation::set_well_partition_method(stemp);
+    }
+    // well partition threshold
+    else if(wpt_key == token) {
+      if(!(from >> dtemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(dtemp <= 0. || dtemp >= 1.) {
+        std::cerr << funame << token << ": out of range\n";
+        throw Error::Range();
+      }
+	
+      MasterEquation::well_projection_threshold = dtemp;
+    }
+    // well partition search limit
+    else if(wps_max_key == token) {
+      if(!(from >> MasterEquation::well_partition_node_max)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(MasterEquation::well_partition_node_max <= 0) {
+        std::cerr << funame << token << ": out of range\n";
+        throw Error::Range();
+      }
+    }
+    // adaptive energy grid
+    else if(grid_fac_key == token) {
+      if(!(from >> MasterEquation::energy_grid_factor)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(MasterEquation::energy_grid_factor < 1.) {
+        std::cerr << funame << token << ": should not be less than 1\n";
+        throw Error::Range();
+      }
+    }
+    // well reservoir state
+    else if(res_kcal_key == token) {
+      if(!(from >> dtemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(dtemp < 0.) {
+        std::cerr << funame << token << ": should not be negative\n";
+        throw Error::Range();
+      }
+
+      MasterEquation::reservoir_offset = dtemp * Phys_const::kcal;
+    }
+    // network decomposition
+    else if(decouple_key == token) {
+      if(!(from >> dtemp)) {
         std::cerr << funame << token << ": corrupted\n";
         throw Error::Input();
       }
       std::getline(from, comment);
 
-      MasterEquation::set_well_partition_method(stemp);
+      if(dtemp <= 0. || dtemp >= 1.) {
+        std::cerr << funame << token << ": out of range\n";
+        throw Error::Range();
+      }
+
+      MasterEquation::decoupling_threshold = dtemp;
     }
-    // well partition threshold
-    else if(wpt_key == token) {
+    // reduced basis surrogate
+    else if(rb_tol_key == token) {
       if(!(from >> dtemp)) {
         std::cerr << funame << token << ": corrupted\n";
         throw Error::Input();
@@ -605,8 +3301,23 @@ int main (int argc, char* argv [])
         std::cerr << funame << token << ": out of range\n";
         throw Error::Range();
       }
-	
-      MasterEquation::well_projection_threshold = dtemp;
+
+      MasterEquation::reduced_basis_tolerance = dtemp;
+    }
+    // maximal number of the reduced basis snapshots
+    else if(rb_size_key == token) {
+      if(!(from >> itemp)) {
+        std::cerr << funame << token << ": corrupted\n";
+        throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(itemp <= 0) {
+        std::cerr << funame << token << ": should be positive\n";
+        throw Error::Range();
+      }
+
+      MasterEquation::reduced_basis_size = itemp;
     }
     // default reduction scheme
     else if(def_red_key == token) {
@@ -717,6 +3428,197 @@ int main (int argc, char* argv [])
 	throw Error::Input();
       }
     }
+    // number of worker processes for the temperature-pressure sweep
+    else if(sweep_key == token) {
+      if(!(from >> sweep_worker_size)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(sweep_worker_size <= 0) {
+	std::cerr << funame << token << ": should be positive\n";
+	throw Error::Range();
+      }
+
+#ifdef WITH_SCALAPACK
+
+      if(sweep_worker_size > 1 && Scalapack::size() > 1) {
+	std::cerr << funame << token << ": worker processes cannot be used in the distributed memory run\n";
+	throw Error::Init();
+      }
+
+#endif
+    }
+    // memory pre-flight limit
+    else if(mem_lim_key == token) {
+      if(!(from >> memory_limit)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(memory_limit <= 0.) {
+	std::cerr << funame << token << ": should be positive\n";
+	throw Error::Range();
+      }
+
+      memory_limit *= 1024. * 1024. * 1024.;
+    }
+    // memory pre-flight policy
+    else if(mem_pol_key == token) {
+      if(!(from >> stemp)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(stemp == "warn")
+	memory_policy = Sweep::MEMORY_WARN;
+      else if(stemp == "abort")
+	memory_policy = Sweep::MEMORY_ABORT;
+      else if(stemp == "band")
+	memory_policy = Sweep::MEMORY_BAND;
+      else if(stemp == "downsize")
+	memory_policy = Sweep::MEMORY_DOWNSIZE;
+      else {
+	std::cerr << funame << token << ": unknown policy: " << stemp << ": available policies: warn, abort, band, downsize\n";
+	throw Error::Input();
+      }
+    }
+    // OpenMP threads number
+    else if(thr_num_key == token) {
+      if(!(from >> itemp)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(itemp <= 0) {
+	std::cerr << funame << token << ": should be positive\n";
+	throw Error::Range();
+      }
+
+      Threads::init(itemp);
+    }
+    // BLAS threads number in the serial sections
+    else if(blas_num_key == token) {
+      if(!(from >> itemp)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(itemp <= 0) {
+	std::cerr << funame << token << ": should be positive\n";
+	throw Error::Range();
+      }
+
+      Threads::set_blas(itemp);
+    }
+    // threads binding to the cores
+    else if(thr_bind_key == token) {
+      if(!(from >> stemp)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(stemp == "none")
+	Threads::bind(Threads::BIND_NONE);
+      else if(stemp == "close")
+	Threads::bind(Threads::BIND_CLOSE);
+      else if(stemp == "spread")
+	Threads::bind(Threads::BIND_SPREAD);
+      else {
+	std::cerr << funame << token << ": unknown binding: " << stemp << ": available bindings: none, close, spread\n";
+	throw Error::Input();
+      }
+    }
+    // energy grid convergence
+    else if(grid_cnv_key == token) {
+      IO::LineInput lin(from);
+
+      if(!(lin >> grid_tolerance)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+
+      if(!(lin >> grid_level_max))
+	grid_level_max = 4;
+
+      if(grid_tolerance <= 0. || grid_level_max <= 0) {
+	std::cerr << funame << token << ": out of range\n";
+	throw Error::Range();
+      }
+    }
+    // energy grid convergence warm start
+    else if(grid_wst_key == token) {
+      std::getline(from, comment);
+
+      grid_warm_start = true;
+    }
+    // persistent model with the commands from the standard input
+    else if(server_key == token) {
+      std::getline(from, comment);
+
+#ifdef WITH_SCALAPACK
+
+      if(Scalapack::size() > 1) {
+	std::cerr << funame << token << ": server mode cannot be used in the distributed memory run\n";
+	throw Error::Init();
+      }
+
+#endif
+
+      server_mode = true;
+    }
+    // uncertainty quantification ensemble of the model edits
+    else if(ensemble_key == token) {
+      if(!(from >> ensemble_file)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+#ifdef WITH_SCALAPACK
+
+      if(Scalapack::size() > 1) {
+	std::cerr << funame << token << ": ensemble mode cannot be used in the distributed memory run\n";
+	throw Error::Init();
+      }
+
+#endif
+    }
+    // high pressure screening run
+    else if(hp_only_key == token) {
+      std::getline(from, comment);
+
+      high_pressure_only = true;
+    }
+    // minimal matrix size for the GPU solvers
+    else if(gpu_key == token) {
+      if(!(from >> itemp)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(itemp <= 0) {
+	std::cerr << funame << token << ": should be positive\n";
+	throw Error::Range();
+      }
+
+#ifdef WITH_CUSOLVER
+
+      Cusolver::size_min = itemp;
+      
+#else
+
+      std::cerr << funame << "WARNING: " << token << ": compiled without the GPU support, ignored\n";
+
+#endif
+    }
     // unknown keyword
     else if(IO::skip_comment(token, from)) {
       std::cerr << funame << "unknown keyword " << token << "\n";
@@ -773,7 +3675,7 @@ int main (int argc, char* argv [])
       throw Error::Range();
     }
 
-    std::ofstream micro_out(micro_rate_file.c_str());
+    std::ofstream micro_out(output_name(micro_rate_file).c_str());
     if(!micro_out.is_open()) {
       std::cerr << funame << "microscopic rate output: cannot open " << micro_rate_file << " file\n";
       throw Error::Open();
@@ -843,175 +3745,213 @@ int main (int argc, char* argv [])
   }
 
   if(MasterEquation::eval_out.is_open()) {
-    MasterEquation::eval_out << "*F - collisional frequency\n"
-			     << "*Q - minimal relaxational eigenvalue\n"
-			     << "*E - eigenvalue\n"
-			     << "*P - eigenvector projection squared on the relaxational subspace\n"
-			     << std::setw(13) << "Temperature,"
-			     << std::setw(13) << "Pressure,"
-			     << std::setw(13) << "*F,"
-			     << std::setw(13) << "*Q/F";
+    IO::put_text(MasterEquation::eval_out, "*F - collisional frequency\n"
+		 "*Q - minimal relaxational eigenvalue\n"
+		 "*E - eigenvalue\n"
+		 "*P - eigenvector projection squared on the relaxational subspace\n");
+    
+    std::vector<std::string> header;
+    header.push_back("Temperature,");
+    header.push_back("Pressure,");
+    header.push_back("*F,");
+    header.push_back("*Q/F");
 
     int eval_max = Model::well_size() + MasterEquation::evec_out_num;
-    for(int l = 0; l < eval_max; ++l)
-      MasterEquation::eval_out << std::setw(13) << "*E/F"
-			       << std::setw(13) << "*P";
-
+    for(int l = 0; l < eval_max; ++l) {
+      header.push_back("*E/F");
+      header.push_back("*P");
+    }
+    IO::put_header(MasterEquation::eval_out, header);
     
     // units
-    MasterEquation::eval_out << "\n"
-			     << std::setw(13) << "K"
-			     << std::setw(13);
+    header.clear();
+    header.push_back("K");
 
     switch(MasterEquation::pressure_unit) {
     case MasterEquation::BAR:
-      MasterEquation::eval_out << "bar";
+      header.push_back("bar");
       break;
     case MasterEquation::TORR:
-      MasterEquation::eval_out << "torr";
+      header.push_back("torr");
       break;
     case MasterEquation::ATM:
-      MasterEquation::eval_out << "atm";
+      header.push_back("atm");
       break;
     }
 
-    MasterEquation::eval_out << std::setw(13) << "1/sec"
-			     << std::setw(13) << "  ";
-    for(int l = 0; l < eval_max; ++l)
-      MasterEquation::eval_out << std::setw(13) << l
-			       << std::setw(13) << l;
-
-    MasterEquation::eval_out << "\n";
-
+    header.push_back("1/sec");
+    header.push_back("  ");
+    for(int l = 0; l < eval_max; ++l) {
+      header.push_back(IO::String(l));
+      header.push_back(IO::String(l));
+    }
+    IO::put_header(MasterEquation::eval_out, header);
   }
 
-  typedef std::vector<double>::const_iterator It;
-
-  std::map<std::pair<int, int>, double> rate_data;
-  std::map<int, double> capture_data;
-  std::vector<MasterEquation::Partition> well_partition;
-  std::vector<std::map<std::pair<int, int>, double> > rate_coef;
-  std::vector<std::map<std::pair<int, int>, double> > hp_rate_coef;
-  std::vector<std::map<int, double> > capture;
-
   std::vector<std::string> spec_name;
   for(int w = 0; w < Model::well_size(); ++w)
     spec_name.push_back(Model::well(w).name());
   for(int p = 0; p < Model::bimolecular_size(); ++p)
     spec_name.push_back(Model::bimolecular(p).name());
 
-  IO::out << "Unimolecular Rate Units: 1/sec;  Bimolecular Rate Units: cm^3/sec\n\n"
-	  << "______________________________________________________________________________________\n\n"
-	  << "Species-Species Rate Tables:\n\n";
+  Sweep::Setup sweep_setup;
+  sweep_setup.temperature = temperature;
+  sweep_setup.pressure    = pressure;
+  sweep_setup.estep       = estep;
+  sweep_setup.etot        = etot;
+  sweep_setup.xtot        = xtot;
+  sweep_setup.eref        = eref;
+  sweep_setup.iseref      = iseref;
+  sweep_setup.tail_tol    = tail_tol;
+  sweep_setup.method      = method;
+  sweep_setup.method_name = method_name;
+
+  if(server_mode) {
+    Server::run(sweep_setup, sweep_worker_size, base_name, std::cin, std::cout);
+    return 0;
+  }
 
+  if(ensemble_file.size()) {
+    Threads::report(IO::log);
 
-  //  try {
-  {
+    Ensemble::run(sweep_setup, sweep_worker_size, base_name, ensemble_file);
+    return 0;
+  }
+
+  Threads::report(IO::log);
+
+  Sweep::Result sweep_result(temperature.size(), pressure.size());
+
+  if(high_pressure_only) {
+    IO::Marker rate_marker("high pressure rate calculation");
+
+    for(int t = 0; t < temperature.size(); ++t) {
+      Sweep::set_grid(sweep_setup, t);
+      MasterEquation::high_pressure_rates(sweep_result.hp_rate_coef[t], sweep_result.capture[t]);
+    }
+  }
+  else {
+    // the workers run concurrently
+    if(memory_limit <= 0.)
+      memory_limit = Sweep::physical_memory();
+
+    if(memory_limit > 0.)
+      Sweep::preflight(sweep_setup, memory_limit / (double)(sweep_worker_size > 1 ? sweep_worker_size : 1), memory_policy);
 
     IO::Marker rate_marker("rate calculation");
 
-    for(It t = temperature.begin(); t != temperature.end(); ++t) {// temperature cycle
-      MasterEquation::set_temperature(*t);
+    if(grid_warm_start && grid_tolerance <= 0.)
+      IO::log << IO::log_offset << "WARNING: " << grid_wst_key << ": no energy grid convergence, ignored\n";
 
-      // energy step
-      if(estep > 0.)
-	MasterEquation::set_energy_step(estep);
-      else
-	MasterEquation::set_energy_step(nearbyint(*t * etot / Phys_const::incm) * Phys_const::incm);
-      
-      // reference energy
-      if(iseref)
-	MasterEquation::set_energy_reference(eref);
-      else
-	MasterEquation::set_energy_reference(nearbyint((*t * xtot + Model::maximum_barrier_height())
-						       / Phys_const::incm) * Phys_const::incm);
+    if(grid_warm_start && sweep_worker_size > 1 && grid_tolerance > 0.)
+      IO::log << IO::log_offset << "WARNING: " << grid_wst_key << ": the eigenvectors are not passed between the sweep workers, ignored\n";
 
-      // set barriers, wells, and bimolecular species
-      MasterEquation::set(rate_data, capture_data);
-      hp_rate_coef.push_back(rate_data);
-      capture.push_back(capture_data);
+    if(grid_tolerance > 0.) {
+      MasterEquation::grid_warm_start = grid_warm_start && sweep_worker_size <= 1;
+
+      Sweep::converge(sweep_setup, grid_tolerance, grid_level_max, sweep_worker_size, base_name, sweep_result);
+
+      MasterEquation::grid_warm_start = false;
+      MasterEquation::clear_grid_start();
+    }
+    else if(sweep_worker_size > 1)
+      Sweep::run(sweep_setup, sweep_worker_size, base_name, sweep_result);
+    else
+      Sweep::run(sweep_setup, 0, temperature.size() * pressure.size(), sweep_result);
+  }
+
+  if(Model::time_evolution && Model::time_evolution->profile().size())
+    Sweep::profile_evolution(sweep_setup, sweep_result);
+
+#ifdef MESS_LIBRARY
+  Api::keep(sweep_setup.temperature, sweep_setup.pressure, spec_name, sweep_result.hp_rate_coef,
+	    sweep_result.rate_coef, sweep_result.spectrum);
+#endif
+
+  std::vector<MasterEquation::Partition>&                well_partition = sweep_result.well_partition;
+  std::vector<std::map<std::pair<int, int>, double> >&   rate_coef      = sweep_result.rate_coef;
+  std::vector<std::map<std::pair<int, int>, double> >&   hp_rate_coef   = sweep_result.hp_rate_coef;
+  std::vector<std::map<int, double> >&                   capture        = sweep_result.capture;
+
+  IO::out << "Unimolecular Rate Units: 1/sec;  Bimolecular Rate Units: cm^3/sec\n\n"
+	  << "______________________________________________________________________________________\n\n"
+	  << "Species-Species Rate Tables:\n\n";
+
+  for(int t = 0; t < temperature.size(); ++t) {// temperature cycle
+    
+    // output
+    IO::out << "Temperature = " << temperature[t] / Phys_const::kelv  << " K\n\n";
+    IO::out << "High Pressure Rate Coefficients:\n\n"
+	    << std::left << std::setw(8) << "From\\To" << std::right;
+    for(int j = 0; j < spec_name.size(); ++j)
+      IO::out << std::setw(13) << spec_name[j];
+    IO::out << "\n";
+    for(int i = 0; i < spec_name.size(); ++i) {
+      IO::out << std::left << std::setw(8) << spec_name[i] << std::right;
+      for(int j = 0; j < spec_name.size(); ++j) {
+	ptemp = std::make_pair(i, j);
+	if(hp_rate_coef[t].find(ptemp) != hp_rate_coef[t].end())
+	  IO::out << std::setw(13) << hp_rate_coef[t][ptemp];
+	else
+	  IO::out << std::setw(13) << "***";
+      }
+      IO::out << "\n";
+    }
+    IO::out << "\n";
+
+    if(high_pressure_only)
+      continue;
+
+    // pressure dependent rate coefficients
+    for(int p = 0; p < pressure.size(); ++p) {// pressure cycle
+      itemp = p + t * pressure.size();
 
       // output
-      IO::out << "Temperature = " << *t / Phys_const::kelv  << " K\n\n";
-      IO::out << "High Pressure Rate Coefficients:\n\n"
-	      << std::left << std::setw(8) << "From\\To" << std::right;
+      IO::out << "Temperature = " << temperature[t] / Phys_const::kelv <<  " K    Pressure = ";
+      switch(MasterEquation::pressure_unit) {
+      case MasterEquation::BAR:
+	IO::out << pressure[p] / Phys_const::bar << " bar";
+	break;
+      case MasterEquation::TORR:
+	IO::out << pressure[p] / Phys_const::tor << " torr";
+	break;
+      case MasterEquation::ATM:
+	IO::out << pressure[p] / Phys_const::atm << " atm";
+	break;
+      }
+      IO::out << "\n\n";
+      IO::out << std::left << std::setw(8) << "From\\To" << std::right;
       for(int j = 0; j < spec_name.size(); ++j)
 	IO::out << std::setw(13) << spec_name[j];
+	
+      for(int w = 0; w < Model::well_size(); ++w)
+	if(Model::well(w).escape())
+	  IO::out << std::setw(13) << Model::well(w).name(); 
       IO::out << "\n";
+
       for(int i = 0; i < spec_name.size(); ++i) {
 	IO::out << std::left << std::setw(8) << spec_name[i] << std::right;
 	for(int j = 0; j < spec_name.size(); ++j) {
 	  ptemp = std::make_pair(i, j);
-	  if(rate_data.find(ptemp) != rate_data.end())
-	    IO::out << std::setw(13) << rate_data[ptemp];
+	  if(rate_coef[itemp].find(ptemp) != rate_coef[itemp].end())
+	    IO::out << std::setw(13) << rate_coef[itemp][ptemp];
 	  else
 	    IO::out << std::setw(13) << "***";
 	}
-	IO::out << "\n";
-      }
-      IO::out << "\n";
-
-      // pressure dependent rate coefficients
-      for(It p = pressure.begin(); p != pressure.end(); ++p) {// pressure cycle
-	MasterEquation::set_pressure(*p);
-	// rate calculation
-	if(method) {
-	  well_partition.push_back(MasterEquation::Partition());
-	  method(rate_data, well_partition.back(), 0);
-	  rate_coef.push_back(rate_data);
-	}
-
-	// output
-	IO::out << "Temperature = " << *t / Phys_const::kelv <<  " K    Pressure = ";
-	switch(MasterEquation::pressure_unit) {
-	case MasterEquation::BAR:
-	  IO::out << *p / Phys_const::bar << " bar";
-	  break;
-	case MasterEquation::TORR:
-	  IO::out << *p / Phys_const::tor << " torr";
-	  break;
-	case MasterEquation::ATM:
-	  IO::out << *p / Phys_const::atm << " atm";
-	  break;
-	}
-	IO::out << "\n\n";
-	IO::out << std::left << std::setw(8) << "From\\To" << std::right;
-	for(int j = 0; j < spec_name.size(); ++j)
-	  IO::out << std::setw(13) << spec_name[j];
-	
+	// escape rates
 	for(int w = 0; w < Model::well_size(); ++w)
-	  if(Model::well(w).escape())
-	    IO::out << std::setw(13) << Model::well(w).name(); 
-	IO::out << "\n";
-
-	for(int i = 0; i < spec_name.size(); ++i) {
-	  IO::out << std::left << std::setw(8) << spec_name[i] << std::right;
-	  for(int j = 0; j < spec_name.size(); ++j) {
-	    ptemp = std::make_pair(i, j);
-	    if(rate_data.find(ptemp) != rate_data.end())
-	      IO::out << std::setw(13) << rate_data[ptemp];
+	  if(Model::well(w).escape()) {
+	    ptemp = std::make_pair(i, Model::well_size() + Model::bimolecular_size() + w);
+	    if(rate_coef[itemp].find(ptemp) != rate_coef[itemp].end())
+	      IO::out << std::setw(13) << rate_coef[itemp][ptemp];
 	    else
 	      IO::out << std::setw(13) << "***";
 	  }
-	  // escape rates
-	  for(int w = 0; w < Model::well_size(); ++w)
-	    if(Model::well(w).escape()) {
-	      ptemp = std::make_pair(i, Model::well_size() + Model::bimolecular_size() + w);
-	      if(rate_data.find(ptemp) != rate_data.end())
-		IO::out << std::setw(13) << rate_data[ptemp];
-	      else
-		IO::out << std::setw(13) << "***";
-	    }
-	  IO::out << "\n";
-	}
 	IO::out << "\n";
-      }// pressure cycle
-    }// temperature cycle
-  }
-  //catch(Error::General) {
-  // IO::log << std::flush;
-  //throw;
-  // }
+      }
+      IO::out << "\n";
+    }// pressure cycle
+  }// temperature cycle
 
   // Output
   IO::out << "______________________________________________________________________________________\n\n"
@@ -1052,6 +3992,19 @@ int main (int argc, char* argv [])
   }
   IO::out << "\n";
 
+  // no pressure dependent tables and fits
+  if(high_pressure_only) {
+
+#ifdef WITH_SCALAPACK
+
+    Scalapack::finalize();
+    MPI_Finalize();
+
+#endif
+
+    return 0;
+  }
+
   IO::out << "______________________________________________________________________________________\n\n"
 	  << "Pressure-Species Rate Tables:\n\n";
 
@@ -1314,9 +4267,20 @@ int main (int argc, char* argv [])
   }// species cycle
 
 
+  // Chebyshev and PLOG fits
+  if(fit_out.is_open()) {
+    if(cheb_tsize > (int)temperature.size() || cheb_psize > (int)pressure.size())
+      IO::log << IO::log_offset << "WARNING: Chebyshev expansion orders exceed the temperature-pressure grid dimensions:"
+	" the orders will be truncated\n";
+
+    IO::Marker fit_marker("fitting rate coefficients");
+
+    rate_fit_output(fit_out, temperature, pressure, sweep_result, cheb_tsize, cheb_psize);
+  }
+
   // state landscape output
   if(state_landscape.size()) {
-    std::ofstream slout((base_name + ".gpi").c_str());
+    std::ofstream slout(output_name(base_name + ".gpi").c_str());
 
     for(int p = 0; p < pressure.size(); ++p) {// pressure cycle
 
@@ -1434,5 +4398,12 @@ int main (int argc, char* argv [])
     }// pressure cycle
   }
 
+#ifdef WITH_SCALAPACK
+
+  Scalapack::finalize();
+  MPI_Finalize();
+
+#endif
+
   return 0;
 }
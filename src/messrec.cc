@@ -0,0 +1,52 @@
+/*
+        Chemical Kinetics and Dynamics Library
+        Copyright (C) 2008-2013, Yuri Georgievski <ygeorgi@anl.gov>
+
+        This library is free software; you can redistribute it and/or
+        modify it under the terms of the GNU Library General Public
+        License as published by the Free Software Foundation; either
+        version 2 of the License, or (at your option) any later version.
+
+        This library is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+        Library General Public License for more details.
+*/
+
+// converts binary eigenvalue, eigenvector, and product energy distribution
+// output (SpectralOutputFormat binary) into the text format
+
+#include <fstream>
+
+#include "libmess/io.hh"
+
+int main (int argc, char* argv [])
+{
+  const char funame [] = "main: ";
+
+  if (argc < 2 || argc > 3) {
+    std::cerr << "usage: messrec binary_file [text_file]\n";
+    return -1;
+  }
+
+  std::ifstream from(argv[1], std::ios::binary);
+  if(!from) {
+    std::cerr << funame << "binary file " << argv[1] << " is not found\n";
+    throw Error::Input();
+  }
+
+  std::ofstream text;
+  if(argc == 3) {
+    text.open(argv[2]);
+    if(!text) {
+      std::cerr << funame << "cannot open " << argv[2] << " file\n";
+      throw Error::Open();
+    }
+  }
+
+  std::ostream& to = argc == 3 ? text : std::cout;
+
+  while(IO::convert_record(from, to)) {}
+
+  return 0;
+}
@@ -22,6 +22,116 @@
 #include "libmess/key.hh"
 #include "libmess/units.hh"
 #include "libmess/io.hh"
+#include "libmess/batch.hh"
+
+namespace {
+  //
+  const double volume_unit = Phys_const::cm * Phys_const::cm * Phys_const::cm;
+
+  // log of the partition function per cm^3 and its first and second derivatives over the
+  // temperature in K, from the species weight moments
+  void log_partition (const Model::Species& spec, const std::vector<double>& temperature, double temp_rel_incr,
+		      std::vector<double>& lz, std::vector<double>& d1, std::vector<double>& d2)
+  {
+    const int size = temperature.size();
+
+    lz.resize(size);
+    d1.resize(size);
+    d2.resize(size);
+
+    if(!size)
+      return;
+
+    spec.thermal_moments(&temperature[0], size, temp_rel_incr, &lz[0], &d1[0], &d2[0]);
+
+    // translational factor
+    for(int t = 0; t < size; ++t) {
+      //
+      const double tval = temperature[t];
+
+      lz[t] += 1.5 * std::log(spec.mass() * tval / 2. / M_PI) + std::log(volume_unit);
+      d1[t]  = (d1[t] + 1.5 / tval) * Phys_const::kelv;
+      d2[t]  = (d2[t] - 1.5 / tval / tval) * Phys_const::kelv * Phys_const::kelv;
+    }
+  }
+
+  // batch input: the species blocks of one file
+  class SpeciesJob : public Batch::Job {
+    //
+    const std::vector<double>& _temperature;
+    double                     _temp_rel_incr;
+
+  public:
+    //
+    SpeciesJob (const std::vector<double>& t, double incr) : _temperature(t), _temp_rel_incr(incr) {}
+    
+    void run (const std::string& input, std::ostream& to) const;
+  };
+
+  void SpeciesJob::run (const std::string& input, std::ostream& to) const
+  {
+    const char funame [] = "SpeciesJob::run: ";
+
+    KeyGroup SpeciesJobGroup;
+
+    Key spec_key("Species");
+
+    IO::KeyBufferStream from(input.c_str());
+    if(!from) {
+      std::cerr << funame << "input file " << input << " is not found\n";
+      throw Error::Input();
+    }
+
+    std::vector<SharedPointer<Model::Species> > species;
+
+    std::string token, comment, name;
+    while(from >> token) {
+      if(spec_key == token) {
+	if(!(from >> name)) {
+	  std::cerr << funame << input << ": " << token << ": corrupted\n";
+	  throw Error::Input();
+	}
+	std::getline(from, comment);
+	species.push_back(Model::new_species(from, name, Model::NOSTATES));
+      }
+      else if(IO::skip_comment(token, from)) {
+	std::cerr << funame << input << ": unknown keyword: " << token << "\n";
+	throw Error::Init();
+      }
+    }
+
+    if(!species.size()) {
+      std::cerr << funame << input << ": no species\n";
+      throw Error::Init();
+    }
+
+    std::vector<double> zz, z1, z2;
+
+    to << "{\"input\": " << Batch::json_string(input) << ", \"temperature[K]\": [";
+    for(int t = 0; t < _temperature.size(); ++t)
+      to << (t ? ", " : "") << Batch::json_number(_temperature[t] / Phys_const::kelv);
+    to << "], \"species\": [";
+
+    for(int s = 0; s < species.size(); ++s) {
+      //
+      log_partition(*species[s], _temperature, _temp_rel_incr, zz, z1, z2);
+
+      // log z, d(log z)/dT, d^2(log z)/dT^2
+      std::ostringstream lz, d1, d2;
+      for(int t = 0; t < _temperature.size(); ++t) {
+	lz << (t ? ", " : "") << Batch::json_number(zz[t]);
+	d1 << (t ? ", " : "") << Batch::json_number(z1[t]);
+	d2 << (t ? ", " : "") << Batch::json_number(z2[t]);
+      }
+
+      to << (s ? ", " : "") << "{\"name\": " << Batch::json_string(species[s]->name())
+	 << ", \"ground[kcal/mol]\": " << Batch::json_number(species[s]->ground() / Phys_const::kcal)
+	 << ", \"log_z\": [" << lz.str() << "], \"dlog_z/dT\": [" << d1.str()
+	 << "], \"d2log_z/dT2\": [" << d2.str() << "]}";
+    }
+    to << "]}";
+  }
+}
 
 int main (int argc, char* argv [])
 {
@@ -49,13 +159,20 @@ int main (int argc, char* argv [])
   Key tincr_key("RelativeTemperatureIncrement");
   Key  adm_bor_key("AtomDistanceMin[bohr]"      );
   Key  adm_ang_key("AtomDistanceMin[angstrom]"  );
-
+  Key  bman_key("BatchManifest"               );
+  Key  bwork_key("BatchWorkerNumber"          );
+  Key  bout_key("BatchOutput"                 );
 
   std::vector<double> temperature;
   std::vector<SharedPointer<Model::Species> > species;
 
   double temp_rel_incr = 0.001;
 
+  // batch mode: species files listed in the manifest
+  std::vector<std::string> batch_input;
+  int batch_worker_size = 1;
+  std::string batch_output;
+
   // base name
   std::string base_name = argv[1];
   if(base_name.size() >= 4 && !base_name.compare(base_name.size() - 4, 4, ".inp", 4))
@@ -120,6 +237,41 @@ int main (int argc, char* argv [])
 
       Model::atom_dist_min = dtemp;
     }
+    // batch manifest
+    else if(bman_key == token) {
+      if(batch_input.size()) {
+	std::cerr << funame << token << ": already defined\n";
+	throw Error::Input();
+      }
+      if(!(from >> stemp)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      batch_input = Batch::read_manifest(stemp);
+    }
+    // number of worker processes for the batch
+    else if(bwork_key == token) {
+      if(!(from >> batch_worker_size)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+
+      if(batch_worker_size <= 0) {
+	std::cerr << funame << token << ": should be positive\n";
+	throw Error::Range();
+      }
+    }
+    // batch output
+    else if(bout_key == token) {
+      if(!(from >> batch_output)) {
+	std::cerr << funame << token << ": corrupted\n";
+	throw Error::Input();
+      }
+      std::getline(from, comment);
+    }
     // species
     else if(spec_key == token) {
       if(!(from >> name)) {
@@ -182,7 +334,7 @@ int main (int argc, char* argv [])
     throw Error::Init();
   }
 
-  if(!species.size()) {
+  if(!species.size() && !batch_input.size()) {
     std::cerr << funame << "no species\n";
     throw Error::Init();
   }
@@ -192,7 +344,23 @@ int main (int argc, char* argv [])
 
   /***************** PARTITION FUNCTION CALCULATION AND OUTPUT *******************/
 
-  const double volume_unit = Phys_const::cm * Phys_const::cm * Phys_const::cm;
+  // batch output: one JSON object per species file
+  if(batch_input.size()) {
+    //
+    if(!batch_output.size())
+      batch_output = base_name + ".json";
+
+    std::ofstream to(batch_output.c_str());
+    if(!to) {
+      std::cerr << funame << "cannot open " << batch_output << " file\n";
+      throw Error::Input();
+    }
+
+    Batch::run(SpeciesJob(temperature, temp_rel_incr), batch_input, batch_worker_size, base_name, to);
+
+    if(!species.size())
+      return 0;
+  }
 
   //  IO::out << "Partition function (relative to the ground,1/cm^3):\n"
   IO::out << "Partition function (log) and its derivatives:\n"
@@ -201,41 +369,19 @@ int main (int argc, char* argv [])
     IO::out << std::setw(13) << species[s]->name() << std::setw(26);
   IO::out << "\n";
   
-  for(int t = 0; t < temperature.size(); ++t) {
-
-    const double tval = temperature[t];
-
-    double temp_incr = tval * temp_rel_incr;
-
-    double tt[3];
-    tt[0] = tval;
-    tt[1] = tval - temp_incr;
-    tt[2] = tval + temp_incr;
-
-    temp_incr /= Phys_const::kelv;
+  // the partition functions and their derivatives at all temperatures are evaluated at once
+  std::vector<std::vector<double> > zz(species.size()), z1(species.size()), z2(species.size());
+  for(int s = 0; s < species.size(); ++s)
+    log_partition(*species[s], temperature, temp_rel_incr, zz[s], z1[s], z2[s]);
 
-    double zz[3];
+  for(int t = 0; t < temperature.size(); ++t) {
 
     IO::out << std::left << std::setw(5) << temperature[t] / Phys_const::kelv << std::right; 
     for(int s = 0; s < species.size(); ++s) {
       
-      for(int i = 0; i < 3; ++i) {
-	//
-	dtemp = species[s]->weight(tt[i]) * std::pow(species[s]->mass() * tt[i] / 2. / M_PI, 1.5) * volume_unit;
-
-	if(dtemp <= 0.) {
-	  //
-	  ErrOut err_out;
-
-	  err_out << funame << "negative weight: " << species[s]->weight(tt[i]);
-	}
-	
-	zz[i] = std::log(dtemp);
-      }
-      
-      IO::out << std::setw(13) << zz[0]
-	      << std::setw(13) << (zz[2] - zz[1]) / 2. / temp_incr
-	      << std::setw(13) << (zz[2] + zz[1] - 2. * zz[0]) / temp_incr / temp_incr;
+      IO::out << std::setw(13) << zz[s][t]
+	      << std::setw(13) << z1[s][t]
+	      << std::setw(13) << z2[s][t];
 
       //IO::out << std::setw(13) << species[s]->weight(temperature[t]) 
       //* std::exp((species[s]->real_ground() - species[s]->ground())/ temperature[t])
@@ -0,0 +1,130 @@
+"""In-process interface to the MESS master equation driver.
+
+The driver runs on the input file as the mess executable does and writes the
+same output files; the results stay in the messapi library memory and are
+returned as NumPy arrays mapped onto it, with no copying and no output parsing.
+The model is global in the library, hence one run per process:
+
+    import mess_api
+    res = mess_api.run("mess.inp")
+    res.rate[t, p, i, j]           # rate coefficient from species i to species j
+    res.eigenvalue(point)          # relaxation spectrum of the (t, p) point, 1/sec
+    res.eigenvector_blocks(point)  # per well blocks of the eigenvectors
+
+The library is located by the MESS_API_LIBRARY environment variable, or
+searched for as libmessapi.so next to this file and in the system paths.
+"""
+
+import ctypes
+import ctypes.util
+import os
+
+import numpy
+
+_dp = ctypes.POINTER(ctypes.c_double)
+_ip = ctypes.POINTER(ctypes.c_int)
+
+_signature = {
+    "mess_run":              (ctypes.c_int,    [ctypes.c_char_p]),
+    "mess_error":            (ctypes.c_char_p, []),
+    "mess_temperature_size": (ctypes.c_int,    []),
+    "mess_temperature":      (_dp,             []),
+    "mess_pressure_size":    (ctypes.c_int,    []),
+    "mess_pressure":         (_dp,             []),
+    "mess_species_size":     (ctypes.c_int,    []),
+    "mess_well_size":        (ctypes.c_int,    []),
+    "mess_species_name":     (ctypes.c_char_p, [ctypes.c_int]),
+    "mess_rate":             (_dp,             []),
+    "mess_hp_rate":          (_dp,             []),
+    "mess_eigenvalue_size":  (ctypes.c_int,    [ctypes.c_int]),
+    "mess_eigenvalue":       (_dp,             [ctypes.c_int]),
+    "mess_global_size":      (ctypes.c_int,    [ctypes.c_int]),
+    "mess_eigenvector":      (_dp,             [ctypes.c_int]),
+    "mess_well_shift":       (_ip,             [ctypes.c_int]),
+}
+
+_lib = None
+
+
+def _library():
+    global _lib
+
+    if _lib is not None:
+        return _lib
+
+    name = os.environ.get("MESS_API_LIBRARY")
+    if not name:
+        local = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "libmessapi.so")
+        name = local if os.path.exists(local) else ctypes.util.find_library("messapi")
+    if not name:
+        raise OSError("messapi library is not found, set MESS_API_LIBRARY")
+
+    lib = ctypes.CDLL(name)
+    for func, (res, args) in _signature.items():
+        getattr(lib, func).restype = res
+        getattr(lib, func).argtypes = args
+
+    _lib = lib
+    return lib
+
+
+def _view(pointer, shape):
+    """Read-only array over the library memory."""
+    if not pointer or not all(shape):
+        return numpy.empty(shape)
+    res = numpy.ctypeslib.as_array(pointer, shape=shape)
+    res.flags.writeable = False
+    return res
+
+
+class Result(object):
+    """Results of the run; the arrays are views of the library memory."""
+
+    def __init__(self, lib):
+        self._lib = lib
+
+        self.temperature = _view(lib.mess_temperature(), (lib.mess_temperature_size(),))
+        self.pressure = _view(lib.mess_pressure(), (lib.mess_pressure_size(),))
+
+        ssize = lib.mess_species_size()
+        self.species = [lib.mess_species_name(i).decode() for i in range(ssize)]
+        self.well_size = lib.mess_well_size()
+
+        tsize, psize = len(self.temperature), len(self.pressure)
+
+        # unimolecular in 1/sec, bimolecular in cm^3/sec, NaN if not available
+        self.rate = _view(lib.mess_rate(), (tsize, psize, ssize, ssize))
+        self.hp_rate = _view(lib.mess_hp_rate(), (tsize, ssize, ssize))
+
+    def point(self, t, p):
+        return t * len(self.pressure) + p
+
+    def eigenvalue(self, point):
+        """Chemical and lowest relaxation eigenvalues[1/sec] (direct method only)."""
+        return _view(self._lib.mess_eigenvalue(point), (self._lib.mess_eigenvalue_size(point),))
+
+    def eigenvector(self, point):
+        """Eigenvectors in the global states basis: eigenvalue, global state indices."""
+        return _view(self._lib.mess_eigenvector(point),
+                     (self._lib.mess_eigenvalue_size(point), self._lib.mess_global_size(point)))
+
+    def eigenvector_blocks(self, point):
+        """Well name to the eigenvectors block (eigenvalue, well state indices)."""
+        evec = self.eigenvector(point)
+        if not evec.size:
+            return {}
+
+        shift = _view(self._lib.mess_well_shift(point), (self.well_size,))
+        bound = list(shift) + [evec.shape[1]]
+
+        return dict((self.species[w], evec[:, bound[w]:bound[w + 1]]) for w in range(self.well_size))
+
+
+def run(input_file):
+    """Runs the driver on the input file in this process."""
+    lib = _library()
+
+    if lib.mess_run(input_file.encode()):
+        raise RuntimeError(lib.mess_error().decode())
+
+    return Result(lib)